@@ -17,12 +17,27 @@ contains(CONFIG, "multithreading") {
     }
 }
 
+# debug aid: report memory allocations and blocking locks in the audio callback
+contains(CONFIG, "rtcheck") {
+    message(The real-time safety checker is enabled.)
+    DEFINES += RT_SAFETY_CHECK
+}
+
 CONFIG += qt \
     thread \
     release
 
-QT += network \
-    xml
+# "make benchmarks" runs the benchmark suite of the built application, the
+# results are written to benchmarks.json, a result file of a previous run on
+# the same hardware can be given as baseline, e.g.
+# make benchmarks BENCHMARK_BASELINE=baseline.json BENCHMARK_OPTIONS="-T 4"
+unix:!macx {
+    benchmarks.commands = ./$(TARGET) --benchmarksuite benchmarks.json --benchmarkbaseline \"$(BENCHMARK_BASELINE)\" $(BENCHMARK_OPTIONS)
+    benchmarks.depends = $(TARGET)
+    QMAKE_EXTRA_TARGETS += benchmarks
+}
+
+QT += network
 
 contains(CONFIG, "headless") {
     message(Headless mode activated.)
@@ -43,7 +58,8 @@ TRANSLATIONS = src/res/translation/translation_de_DE.ts \
 
 INCLUDEPATH += src
 
-INCLUDEPATH_OPUS = libs/opus/include \
+INCLUDEPATH_OPUS = libs/opus \
+    libs/opus/include \
     libs/opus/celt \
     libs/opus/silk \
     libs/opus/silk/float \
@@ -72,14 +88,16 @@ win32 {
             -luser32 \
             -ladvapi32 \
             -lwinmm \
-            -lws2_32
+            -lws2_32 \
+            -lavrt
     } else {
         QMAKE_LFLAGS += /DYNAMICBASE:NO # fixes crash with libjack64.dll, see https://github.com/corrados/jamulus/issues/93
         LIBS += ole32.lib \
             user32.lib \
             advapi32.lib \
             winmm.lib \
-            ws2_32.lib
+            ws2_32.lib \
+            avrt.lib
     }
 
     # replace ASIO with jack if requested
@@ -349,23 +367,59 @@ FORMS_GUI = src/clientdlgbase.ui \
     src/connectdlgbase.ui \
     src/aboutdlgbase.ui
 
-HEADERS += src/buffer.h \
+# real-time core: the modules which run on the real-time threads (sound card
+# callback, server timer, socket threads) without QObject, signals, timers or
+# the event loop, the data is exchanged with the Qt side through preallocated
+# lock-free buffers (only Qt atomics and value types are used), the list can be
+# built on its own for the benchmarks and embeddings (e.g. the VST plugin)
+HEADERS_RTCORE = src/buffer.h \
+    src/encoderprofile.h \
+    src/mixkernel.h \
+    src/playout.h \
+    src/rtcheck.h \
+    src/telemetry.h
+
+SOURCES_RTCORE = src/buffer.cpp \
+    src/encoderprofile.cpp \
+    src/mixkernel.cpp \
+    src/playout.cpp \
+    src/rtcheck.cpp
+
+HEADERS += $$HEADERS_RTCORE
+
+HEADERS += src/benchmarksuite.h \
     src/channel.h \
     src/client.h \
+    src/flightrecorder.h \
     src/global.h \
+    src/loadgenerator.h \
+    src/microbenchmark.h \
     src/multicolorled.h \
+    src/packetcapture.h \
     src/protocol.h \
+    src/relay.h \
     src/server.h \
+    src/serverbenchmark.h \
+    src/servercascade.h \
+    src/serverfx.h \
     src/serverlist.h \
     src/serverlogging.h \
+    src/servermetrics.h \
+    src/streamoutput.h \
+    src/serverstatus.h \
     src/settings.h \
     src/socket.h \
+    src/sockettransport.h \
     src/soundbase.h \
     src/testbench.h \
+    src/threadsched.h \
+    src/timerwheel.h \
+    src/tracer.h \
     src/util.h \
     src/recorder/jamrecorder.h \
     src/recorder/creaperproject.h \
     src/recorder/cwavestream.h \
+    src/recorder/cflacstream.h \
     src/historygraph.h \
     src/signalhandler.h
 
@@ -376,6 +430,7 @@ HEADERS_GUI = src/audiomixerboard.h \
     src/clientdlg.h \
     src/serverdlg.h \
     src/multicolorledbar.h \
+    src/multitrack.h \
     src/analyzerconsole.h
 
 HEADERS_OPUS = libs/opus/celt/arch.h \
@@ -449,22 +504,40 @@ HEADERS_OPUS_X86 = libs/opus/celt/x86/celt_lpc_sse.h \
     libs/opus/celt/x86/vq_sse.h \
     libs/opus/celt/x86/x86cpu.h
 
-SOURCES += src/buffer.cpp \
+SOURCES += $$SOURCES_RTCORE
+
+SOURCES += src/benchmarksuite.cpp \
     src/channel.cpp \
     src/client.cpp \
+    src/flightrecorder.cpp \
+    src/loadgenerator.cpp \
     src/main.cpp \
+    src/microbenchmark.cpp \
+    src/packetcapture.cpp \
     src/protocol.cpp \
+    src/relay.cpp \
     src/server.cpp \
+    src/serverbenchmark.cpp \
+    src/servercascade.cpp \
+    src/serverfx.cpp \
     src/serverlist.cpp \
     src/serverlogging.cpp \
+    src/servermetrics.cpp \
+    src/streamoutput.cpp \
+    src/serverstatus.cpp \
     src/settings.cpp \
     src/signalhandler.cpp \
     src/socket.cpp \
+    src/sockettransport.cpp \
     src/soundbase.cpp \
+    src/threadsched.cpp \
+    src/timerwheel.cpp \
+    src/tracer.cpp \
     src/util.cpp \
     src/recorder/jamrecorder.cpp \
     src/recorder/creaperproject.cpp \
     src/recorder/cwavestream.cpp \
+    src/recorder/cflacstream.cpp \
     src/historygraph.cpp
 
 SOURCES_GUI = src/audiomixerboard.cpp \
@@ -475,6 +548,7 @@ SOURCES_GUI = src/audiomixerboard.cpp \
     src/serverdlg.cpp \
     src/multicolorled.cpp \
     src/multicolorledbar.cpp \
+    src/multitrack.cpp \
     src/analyzerconsole.cpp
 
 SOURCES_OPUS = libs/opus/celt/bands.c \
@@ -606,39 +680,87 @@ SOURCES_OPUS = libs/opus/celt/bands.c \
     libs/opus/src/opus_encoder.c \
     libs/opus/src/repacketizer.c
 
+# the SIMD optimized OPUS sources, the instruction set specific files are
+# compiled with the corresponding compiler flags and the kernels are selected
+# at runtime by the CPU detection of OPUS (run time CPU detection, RTCD)
 SOURCES_OPUS_ARM = libs/opus/celt/arm/armcpu.c \
     libs/opus/celt/arm/arm_celt_map.c \
     libs/opus/silk/arm/arm_silk_map.c
 
-SOURCES_OPUS_X86 = libs/opus/celt/x86/celt_lpc_sse4_1.c \
-    libs/opus/celt/x86/pitch_sse.c \
-    libs/opus/celt/x86/pitch_sse2.c \
+SOURCES_OPUS_ARM_NEON = libs/opus/celt/arm/celt_neon_intr.c \
+    libs/opus/celt/arm/pitch_neon_intr.c \
+    libs/opus/silk/arm/biquad_alt_neon_intr.c \
+    libs/opus/silk/arm/LPC_inv_pred_gain_neon_intr.c \
+    libs/opus/silk/arm/NSQ_del_dec_neon_intr.c \
+    libs/opus/silk/arm/NSQ_neon.c
+
+SOURCES_OPUS_X86 = libs/opus/celt/x86/x86_celt_map.c \
+    libs/opus/silk/x86/x86_silk_map.c
+
+SOURCES_OPUS_X86_SSE = libs/opus/celt/x86/x86cpu.c \
+    libs/opus/celt/x86/pitch_sse.c
+
+SOURCES_OPUS_X86_SSE2 = libs/opus/celt/x86/pitch_sse2.c \
+    libs/opus/celt/x86/vq_sse2.c
+
+SOURCES_OPUS_X86_SSE4_1 = libs/opus/celt/x86/celt_lpc_sse4_1.c \
     libs/opus/celt/x86/pitch_sse4_1.c \
-    libs/opus/celt/x86/vq_sse2.c \
-    libs/opus/celt/x86/x86_celt_map.c \
-    libs/opus/celt/x86/x86cpu.c
+    libs/opus/silk/x86/NSQ_sse4_1.c \
+    libs/opus/silk/x86/NSQ_del_dec_sse4_1.c \
+    libs/opus/silk/x86/VAD_sse4_1.c \
+    libs/opus/silk/x86/VQ_WMat_EC_sse4_1.c
 
-android {
-    contains(ANDROID_ARCHITECTURE, arm) | contains(ANDROID_ARCHITECTURE, arm64) {
-        HEADERS_OPUS += $$HEADERS_OPUS_ARM
-        SOURCE_OPUS += $$SOURCES_OPUS_ARM
-    } else:contains(ANDROID_ARCHITECTURE, x86) | contains(ANDROID_ARCHITECTURE, x86_64) {
-        HEADERS_OPUS += $$HEADERS_OPUS_X86
-        SOURCE_OPUS += $$SOURCES_OPUS_X86
+# the SIMD optimizations can be disabled with CONFIG+=noopussimd (e.g., to
+# compare the codec benchmark of both builds)
+!contains(CONFIG, "noopussimd") {
+    android {
+        OPUS_ARCH = $$ANDROID_ARCHITECTURE
+    } else {
+        OPUS_ARCH = $$QT_ARCH
     }
-} else:win32 | unix | macx {
-    contains(QT_ARCH, arm) | contains(QT_ARCH, arm64) {
+
+    contains(OPUS_ARCH, arm64) {
+        # NEON is mandatory on 64 bit ARM, no runtime detection is needed
         HEADERS_OPUS += $$HEADERS_OPUS_ARM
-        SOURCE_OPUS += $$SOURCES_OPUS_ARM
-    } else:contains(QT_ARCH, x86) | contains(QT_ARCH, x86_64) {
-        HEADERS_OPUS += $$HEADERS_OPUS_X86
-        SOURCE_OPUS += $$SOURCES_OPUS_X86
-    }
-    win32 {
-        HEADERS_OPUS += libs/opus/win32/config.h
+        SOURCES_OPUS += $$SOURCES_OPUS_ARM
+        SOURCES_OPUS_NEON = $$SOURCES_OPUS_ARM_NEON
+        DEFINES_OPUS += OPUS_ARM_MAY_HAVE_NEON_INTR \
+            OPUS_ARM_PRESUME_NEON_INTR
+    } else:contains(OPUS_ARCH, arm) {
+        # the runtime detection of NEON is only supported on Linux/Android
+        android | linux {
+            HEADERS_OPUS += $$HEADERS_OPUS_ARM
+            SOURCES_OPUS += $$SOURCES_OPUS_ARM
+            SOURCES_OPUS_NEON = $$SOURCES_OPUS_ARM_NEON
+            DEFINES_OPUS += OPUS_ARM_MAY_HAVE_NEON_INTR \
+                OPUS_HAVE_RTCD
+        }
+    } else:contains(OPUS_ARCH, x86) | contains(OPUS_ARCH, x86_64) {
+        HEADERS_OPUS += $$HEADERS_OPUS_X86 \
+            libs/opus/silk/x86/main_sse.h \
+            libs/opus/silk/x86/SigProc_FIX_sse.h
+        SOURCES_OPUS += $$SOURCES_OPUS_X86
+        DEFINES_OPUS += OPUS_X86_MAY_HAVE_SSE \
+            OPUS_X86_MAY_HAVE_SSE2 \
+            OPUS_X86_MAY_HAVE_SSE4_1 \
+            OPUS_HAVE_RTCD
+
+        # SSE and SSE2 are part of every 64 bit x86 CPU
+        contains(OPUS_ARCH, x86_64) {
+            DEFINES_OPUS += OPUS_X86_PRESUME_SSE \
+                OPUS_X86_PRESUME_SSE2
+        }
+
+        !msvc {
+            DEFINES_OPUS += CPU_INFO_BY_C
+        }
     }
 }
 
+win32 {
+    HEADERS_OPUS += libs/opus/win32/config.h
+}
+
 DISTFILES += ChangeLog \
     COPYING \
     INSTALL.md \
@@ -1032,4 +1154,57 @@ contains(CONFIG, "opus_shared_lib") {
     HEADERS += $$HEADERS_OPUS
     SOURCES += $$SOURCES_OPUS
     DISTFILES += $$DISTFILES_OPUS
+    DEFINES += $$DEFINES_OPUS
+
+    # qmake has no per-file compiler flags, therefore the instruction set
+    # specific OPUS sources are compiled by extra compilers (MSVC does not
+    # need special flags to use the intrinsics)
+    msvc {
+        contains(DEFINES_OPUS, OPUS_X86_MAY_HAVE_SSE) {
+            SOURCES += $$SOURCES_OPUS_X86_SSE \
+                $$SOURCES_OPUS_X86_SSE2 \
+                $$SOURCES_OPUS_X86_SSE4_1
+        }
+
+        SOURCES += $$SOURCES_OPUS_NEON
+    } else {
+        contains(DEFINES_OPUS, OPUS_X86_MAY_HAVE_SSE) {
+            opus_sse.input = SOURCES_OPUS_X86_SSE
+            opus_sse.output = ${QMAKE_VAR_OBJECTS_DIR}${QMAKE_FILE_IN_BASE}$${first(QMAKE_EXT_OBJ)}
+            opus_sse.commands = $${QMAKE_CC} $(CFLAGS) -msse $(INCPATH) -c ${QMAKE_FILE_IN} -o ${QMAKE_FILE_OUT}
+            opus_sse.dependency_type = TYPE_C
+            opus_sse.variable_out = OBJECTS
+
+            opus_sse2.input = SOURCES_OPUS_X86_SSE2
+            opus_sse2.output = ${QMAKE_VAR_OBJECTS_DIR}${QMAKE_FILE_IN_BASE}$${first(QMAKE_EXT_OBJ)}
+            opus_sse2.commands = $${QMAKE_CC} $(CFLAGS) -msse2 $(INCPATH) -c ${QMAKE_FILE_IN} -o ${QMAKE_FILE_OUT}
+            opus_sse2.dependency_type = TYPE_C
+            opus_sse2.variable_out = OBJECTS
+
+            opus_sse4_1.input = SOURCES_OPUS_X86_SSE4_1
+            opus_sse4_1.output = ${QMAKE_VAR_OBJECTS_DIR}${QMAKE_FILE_IN_BASE}$${first(QMAKE_EXT_OBJ)}
+            opus_sse4_1.commands = $${QMAKE_CC} $(CFLAGS) -msse4.1 $(INCPATH) -c ${QMAKE_FILE_IN} -o ${QMAKE_FILE_OUT}
+            opus_sse4_1.dependency_type = TYPE_C
+            opus_sse4_1.variable_out = OBJECTS
+
+            QMAKE_EXTRA_COMPILERS += opus_sse opus_sse2 opus_sse4_1
+        }
+
+        !isEmpty(SOURCES_OPUS_NEON) {
+            # 64 bit ARM compilers always support NEON
+            contains(DEFINES_OPUS, OPUS_ARM_PRESUME_NEON_INTR) {
+                OPUS_NEON_FLAGS =
+            } else {
+                OPUS_NEON_FLAGS = -mfpu=neon
+            }
+
+            opus_neon.input = SOURCES_OPUS_NEON
+            opus_neon.output = ${QMAKE_VAR_OBJECTS_DIR}${QMAKE_FILE_IN_BASE}$${first(QMAKE_EXT_OBJ)}
+            opus_neon.commands = $${QMAKE_CC} $(CFLAGS) $$OPUS_NEON_FLAGS $(INCPATH) -c ${QMAKE_FILE_IN} -o ${QMAKE_FILE_OUT}
+            opus_neon.dependency_type = TYPE_C
+            opus_neon.variable_out = OBJECTS
+
+            QMAKE_EXTRA_COMPILERS += opus_neon
+        }
+    }
 }
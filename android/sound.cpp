@@ -32,59 +32,85 @@ CSound::CSound ( void           (*fpNewProcessCallback) ( CVector<short>& psData
                  const int      iCtrlMIDIChannel,
                  const bool     ,
                  const QString& ) :
-    CSoundBase ( "OpenSL", true, fpNewProcessCallback, arg, iCtrlMIDIChannel )
-
+    CSoundBase ( "OpenSL", true, fpNewProcessCallback, arg, iCtrlMIDIChannel ),
+    iInputFifoMaxFill      ( 0 ),
+    iMaxCallbackFrames     ( 0 ),
+    iCountCallbacksToDrain ( NUM_INPUT_CALLBACKS_TO_DRAIN ),
+    iNumInputOverruns      ( 0 ),
+    iNumOutputUnderruns    ( 0 )
 {
-     pSound = this;
 #ifdef ANDROIDDEBUG
   qInstallMessageHandler(myMessageHandler);
 #endif
 }
 
-void CSound::setupCommonStreamParams(oboe::AudioStreamBuilder *builder)
+void CSound::setupCommonStreamParams(oboe::AudioStreamBuilder *builder, const oboe::SharingMode sharingMode)
 {
-    // We request EXCLUSIVE mode since this will give us the lowest possible
-    // latency. If EXCLUSIVE mode isn't available the builder will fall back to SHARED mode
+    // we always work on stereo float samples with the system sample rate, if
+    // the device uses a different format, Oboe converts the samples
     builder->setCallback(this)
             ->setFormat(oboe::AudioFormat::Float)
-            ->setSharingMode(oboe::SharingMode::Shared)
-            ->setChannelCount(oboe::ChannelCount::Mono)
-           // ->setSampleRate(48000)
-           // ->setSampleRateConversionQuality(oboe::SampleRateConversionQuality::Medium)
-            ->setPerformanceMode(oboe::PerformanceMode::None);
+            ->setFormatConversionAllowed(true)
+            ->setSharingMode(sharingMode)
+            ->setChannelCount(oboe::ChannelCount::Stereo)
+            ->setChannelConversionAllowed(true)
+            ->setSampleRate(SYSTEM_SAMPLE_RATE_HZ)
+            ->setSampleRateConversionQuality(oboe::SampleRateConversionQuality::Medium)
+            ->setPerformanceMode(oboe::PerformanceMode::LowLatency);
     return;
 }
 
+bool CSound::openStream(oboe::ManagedStream &stream, const oboe::Direction direction)
+{
+    // We request EXCLUSIVE mode since this will give us the lowest possible
+    // latency. If the stream cannot be opened in EXCLUSIVE mode, we try again
+    // in SHARED mode.
+    const oboe::SharingMode sharingModes[] = { oboe::SharingMode::Exclusive, oboe::SharingMode::Shared };
+
+    for ( const oboe::SharingMode sharingMode : sharingModes )
+    {
+        oboe::AudioStreamBuilder builder;
+        builder.setDirection(direction);
+        setupCommonStreamParams(&builder, sharingMode);
+
+        const oboe::Result result = builder.openManagedStream(stream);
+
+        if (result == oboe::Result::OK)
+        {
+            return true;
+        }
+
+        qWarning() << "Opening the stream failed:" << oboe::convertToText(result);
+    }
+
+    return false;
+}
+
 void CSound::openStreams()
 {
-    // Create callback
-    mCallback = this;
-
-    //Setup output stream
-     oboe::AudioStreamBuilder inBuilder, outBuilder;
-     outBuilder.setDirection(oboe::Direction::Output);
-     setupCommonStreamParams(&outBuilder);
-     oboe::Result result = outBuilder.openManagedStream(mPlayStream);
-     if (result != oboe::Result::OK) {
-         return;
-     }
-     mPlayStream->setBufferSizeInFrames(pSound->iOpenSLBufferSizeStereo);
+    // Setup output stream
+    if (!openStream(mPlayStream, oboe::Direction::Output))
+    {
+        throw CGenErr ( tr ( "The audio output stream could not be opened." ) );
+    }
+
+    // the output buffer starts with two bursts (double buffering), the
+    // latency tuner increases it on underruns
+    mPlayStream->setBufferSizeInFrames(2 * mPlayStream->getFramesPerBurst());
+    pLatencyTuner.reset(new oboe::LatencyTuner(*mPlayStream));
 
     warnIfNotLowLatency(mPlayStream, "PlayStream");
     printStreamDetails(mPlayStream);
 
-   //Setup input stream
-    inBuilder.setDirection(oboe::Direction::Input);
-    setupCommonStreamParams(&inBuilder);
-    result = inBuilder.openManagedStream(mRecordingStream);
-    if (result != oboe::Result::OK) {
-         closeStream(mPlayStream);
-         return;
+    // Setup input stream
+    if (!openStream(mRecordingStream, oboe::Direction::Input))
+    {
+        closeStream(mPlayStream);
+        throw CGenErr ( tr ( "The audio input stream could not be opened." ) );
     }
-    mRecordingStream->setBufferSizeInFrames(pSound->iOpenSLBufferSizeStereo);
 
-     warnIfNotLowLatency(mRecordingStream, "RecordStream");
-     printStreamDetails(mRecordingStream);
+    warnIfNotLowLatency(mRecordingStream, "RecordStream");
+    printStreamDetails(mRecordingStream);
 }
 
 void CSound::printStreamDetails(oboe::ManagedStream &stream)
@@ -121,21 +147,27 @@ void CSound::printStreamDetails(oboe::ManagedStream &stream)
 }
 
 void CSound::warnIfNotLowLatency(oboe::ManagedStream &stream, QString streamName) {
+    // the stream is still usable but the negotiated mode gives a higher latency
     if (stream->getPerformanceMode() != oboe::PerformanceMode::LowLatency) {
         QString latencyMode = (stream->getPerformanceMode()==oboe::PerformanceMode::None ? "None" : "Power Saving");
-       // throw CGenErr ( tr ( "Stream is NOT low latency."
-                         //    "Check your requested format, sample rate and channel count." ) );
+        qWarning() << streamName << "is NOT low latency (performance mode:" << latencyMode <<
+                      "), check the requested format, sample rate and channel count.";
+    }
+
+    if (stream->getSharingMode() != oboe::SharingMode::Exclusive) {
+        qWarning() << streamName << "is not in exclusive mode, the device is shared.";
     }
 }
 
 void CSound::closeStream(oboe::ManagedStream &stream)
 {
     if (stream) {
-        oboe::Result requestStopRes = stream->requestStop();
+        // the stream may already be closed after an error (e.g. the device was
+        // disconnected), therefore the errors are only reported here
+        stream->requestStop();
         oboe::Result result = stream->close();
         if (result != oboe::Result::OK) {
-            throw CGenErr ( tr ( "Error closing stream: $s",
-                                 oboe::convertToText(result) ) );
+            qWarning() << "Error closing stream:" << oboe::convertToText(result);
         }
         stream.reset();
     }
@@ -146,12 +178,32 @@ void CSound::closeStreams()
     // clean up
     closeStream(mRecordingStream);
     closeStream(mPlayStream);
+    pLatencyTuner.reset();
 }
 
 void CSound::Start()
 {
     openStreams();
 
+    // the callbacks may deliver up to the buffer capacity of the streams
+    iMaxCallbackFrames = std::max ( mRecordingStream->getBufferCapacityInFrames(),
+                                    mPlayStream->getBufferCapacityInFrames() );
+
+    // the input FIFO must take a complete input callback in addition to the
+    // samples which are not yet processed, if it holds more than twice a
+    // block and an input burst, the output callback drops the oldest samples
+    // not to increase the latency (e.g. if the clocks of the streams differ)
+    iInputFifoMaxFill = 4 * ( iOpenSLBufferSizeMono + mRecordingStream->getFramesPerBurst() );
+
+    InputFifo.Init ( std::max ( iInputFifoMaxFill, 2 * iOpenSLBufferSizeMono ) + 2 * iMaxCallbackFrames );
+    OutputFifo.Init ( 2 * ( iOpenSLBufferSizeMono + iMaxCallbackFrames ) );
+    vecfTmpInputStereo.Init ( 2 * iMaxCallbackFrames );
+    vecfTmpOutputStereo.Init ( 2 * iMaxCallbackFrames );
+
+    iCountCallbacksToDrain = NUM_INPUT_CALLBACKS_TO_DRAIN;
+    iNumInputOverruns.storeRelease ( 0 );
+    iNumOutputUnderruns.storeRelease ( 0 );
+
     // call base class
     CSoundBase::Start();
 
@@ -167,13 +219,16 @@ void CSound::Stop()
 
     // call base class
     CSoundBase::Stop();
+
+    qInfo() << "Audio engine stopped: input overruns:" << iNumInputOverruns.loadAcquire() <<
+               ", output underruns:" << iNumOutputUnderruns.loadAcquire();
 }
 
 int CSound::Init ( const int iNewPrefMonoBufferSize )
 {
-    // store buffer size
-    iOpenSLBufferSizeMono = 512 ;
-            //iNewPrefMonoBufferSize;
+    // the processing is decoupled from the bursts of the streams by the input
+    // FIFO, therefore we can use the preferred buffer size directly
+    iOpenSLBufferSizeMono = iNewPrefMonoBufferSize;
 
     // init base class
     CSoundBase::Init ( iOpenSLBufferSizeMono );
@@ -181,20 +236,9 @@ int CSound::Init ( const int iNewPrefMonoBufferSize )
     // set internal buffer size value and calculate stereo buffer size
     iOpenSLBufferSizeStereo = 2 * iOpenSLBufferSizeMono;
 
-    // create memory for intermediate audio buffer
+    // create memory for intermediate audio buffers
     vecsTmpAudioSndCrdStereo.Init ( iOpenSLBufferSizeStereo );
-
-// TEST
-#if ( SYSTEM_SAMPLE_RATE_HZ != 48000 )
-# error "Only a system sample rate of 48 kHz is supported by this module"
-#endif
-// audio interface number of channels is 1 and the sample rate
-// is 16 kHz -> just copy samples and perform no filtering as a
-// first simple solution
-// 48 kHz / 16 kHz = factor 3 (note that the buffer size mono might
-// be divisible by three, therefore we will get a lot of drop outs)
-iModifiedInBufSize = iOpenSLBufferSizeMono / 3;
-vecsTmpAudioInSndCrd.Init ( iModifiedInBufSize );
+    vecfTmpAudioSndCrdStereo.Init ( iOpenSLBufferSizeStereo );
 
     return iOpenSLBufferSizeMono;
 }
@@ -204,97 +248,177 @@ vecsTmpAudioInSndCrd.Init ( iModifiedInBufSize );
 // can cause delays such as sleeping, file processing, allocate memory, etc
 oboe::DataCallbackResult CSound::onAudioReady(oboe::AudioStream *oboeStream, void *audioData, int32_t numFrames)
 {
-     // only process if we are running
-     if ( ! pSound->bRun )
-     {
-         return oboe::DataCallbackResult::Continue;
-     }
-
-     // Need to modify the size of the buffer based on the numFrames requested in this callback.
-     // Buffer size can change regularly by android devices
-    int& iBufferSizeMono = pSound->iOpenSLBufferSizeMono;
-
-    // perform the processing for input and output
-//    QMutexLocker locker ( &pSound->Mutex );
- //   locker.mutex();
-
-    //This can be called from both input and output at different times
-    if (oboeStream == pSound->mPlayStream.get() && audioData)
+    if (audioData == nullptr)
     {
-        float *floatData = static_cast<float *>(audioData);
+        return oboe::DataCallbackResult::Continue;
+    }
 
-        // Zero out the incoming container array
-        memset(audioData, 0, sizeof(float) * numFrames * oboeStream->getChannelCount());
+    // the input and the output callback run on different threads, they only
+    // share the wait-free input FIFO
+    if (oboeStream == mPlayStream.get())
+    {
+        onOutputReady ( static_cast<float*> ( audioData ), numFrames, oboeStream->getChannelCount() );
+    }
+    else if (oboeStream == mRecordingStream.get())
+    {
+        onInputReady ( static_cast<const float*> ( audioData ), numFrames, oboeStream->getChannelCount() );
+    }
 
-        // Only copy data if we have data to copy, otherwise fill with silence
-        if (!pSound->vecsTmpAudioSndCrdStereo.empty())
-        {
-            for (int frmNum = 0; frmNum < numFrames; ++frmNum)
-            {
-                for (int channelNum = 0; channelNum < oboeStream->getChannelCount(); channelNum++)
-                {
-                    // copy sample received from server into output buffer
+    return oboe::DataCallbackResult::Continue;
+}
 
+void CSound::onInputReady ( const float* pfData,
+                            const int    iNumFrames,
+                            const int    iNumChannels )
+{
+    // only process if we are running
+    if ( !bRun )
+    {
+        return;
+    }
 
-                    // convert to 32 bit
-                    const int32_t iCurSam = static_cast<int32_t> (
-                        pSound->vecsTmpAudioSndCrdStereo [frmNum * oboeStream->getChannelCount() + channelNum] );
-                    floatData[frmNum * oboeStream->getChannelCount() + channelNum] = (float) iCurSam/ _MAXSHORT;
-                }
-            }
-        }
-        else
+    // discard the input queue for 500ms or so
+    if ( iCountCallbacksToDrain > 0 )
+    {
+        iCountCallbacksToDrain--;
+        return;
+    }
+
+    if ( iNumFrames > iMaxCallbackFrames )
+    {
+        iNumInputOverruns.fetchAndAddRelaxed ( 1 );
+        return;
+    }
+
+    const float* pfStereo = pfData;
+
+    if ( iNumChannels != 2 )
+    {
+        // use the first two channels (a mono input is used for both channels)
+        const int iRightChan = ( iNumChannels > 1 ) ? 1 : 0;
+
+        for ( int i = 0; i < iNumFrames; i++ )
         {
-            // prime output stream buffer with silence
-            memset(static_cast<float*>(audioData) + numFrames * oboeStream->getChannelCount(), 0,
-                       (numFrames) * oboeStream->getBytesPerFrame());
+            vecfTmpInputStereo[2 * i]     = pfData[i * iNumChannels];
+            vecfTmpInputStereo[2 * i + 1] = pfData[i * iNumChannels + iRightChan];
         }
+
+        pfStereo = &vecfTmpInputStereo[0];
+    }
+
+    // if the output callback does not keep up, the new samples are dropped
+    if ( !InputFifo.Put ( pfStereo, 2 * iNumFrames ) )
+    {
+        iNumInputOverruns.fetchAndAddRelaxed ( 1 );
+    }
+}
+
+void CSound::processBlock()
+{
+    // the block of the input FIFO is in the float buffer
+    if ( HasProcessCallbackFloat() )
+    {
+        ProcessCallbackFloat ( vecfTmpAudioSndCrdStereo );
     }
-    else if (oboeStream == pSound->mRecordingStream.get() && audioData)
+    else
+    {
+        CSndSampleConv::ToShort ( SF_FLOAT32, false,
+                                  &vecfTmpAudioSndCrdStereo[0], 1,
+                                  &vecsTmpAudioSndCrdStereo[0], 1,
+                                  iOpenSLBufferSizeStereo );
+
+        ProcessCallback ( vecsTmpAudioSndCrdStereo );
+
+        CSndSampleConv::FromShort ( SF_FLOAT32, false,
+                                    &vecsTmpAudioSndCrdStereo[0], 1,
+                                    &vecfTmpAudioSndCrdStereo[0], 1,
+                                    iOpenSLBufferSizeStereo );
+    }
+}
+
+void CSound::onOutputReady ( float*    pfData,
+                             const int iNumFrames,
+                             const int iNumChannels )
+{
+    const int iNumSamples = 2 * iNumFrames;
+
+    if ( !bRun || ( iNumFrames > iMaxCallbackFrames ) )
+    {
+        std::fill ( pfData, pfData + iNumFrames * iNumChannels, 0.0f );
+        return;
+    }
+
+    // adapt the buffer size of the output stream on underruns
+    pLatencyTuner->tune();
+
+    // process whole blocks of the input until the requested number of samples
+    // is available (the bursts of the streams may differ from the block size)
+    while ( OutputFifo.GetAvailData() < iNumSamples )
     {
-        // First things first, we need to discard the input queue a little for 500ms or so
-        if (pSound->mCountCallbacksToDrain > 0)
+        if ( !InputFifo.Get ( &vecfTmpAudioSndCrdStereo[0], iOpenSLBufferSizeStereo ) )
         {
-            // discard the input buffer
-            int32_t numBytes = numFrames * oboeStream->getBytesPerFrame();
-            memset(audioData, 0 /* value */, numBytes);
-            pSound->mCountCallbacksToDrain--;
+            break;
         }
 
-        // We're good to start recording now
-        // Take the data from the recording device ouput buffer and move
-        // it to the vector ready to send up to the server
+        processBlock();
 
-        float *floatData = static_cast<float *>(audioData);
+        OutputFifo.Put ( &vecfTmpAudioSndCrdStereo[0], iOpenSLBufferSizeStereo );
+    }
+
+    // limit the latency of the input FIFO (the number of samples is kept even
+    // so that the channels are not swapped)
+    const int iInputFifoFill = InputFifo.GetAvailData();
+
+    if ( iInputFifoFill > iInputFifoMaxFill )
+    {
+        InputFifo.Discard ( ( iInputFifoFill - iInputFifoMaxFill / 2 ) & ~1 );
+    }
+
+    // output the processed samples, the missing part is filled with silence
+    float*    pfStereo = ( iNumChannels == 2 ) ? pfData : &vecfTmpOutputStereo[0];
+    const int iNumAvail = std::min ( OutputFifo.GetAvailData(), iNumSamples );
 
-        // Copy recording data to internal vector
-        for (int frmNum = 0; frmNum < numFrames; ++frmNum)
+    OutputFifo.Get ( pfStereo, iNumAvail );
+
+    if ( iNumAvail < iNumSamples )
+    {
+        std::fill ( pfStereo + iNumAvail, pfStereo + iNumSamples, 0.0f );
+        iNumOutputUnderruns.fetchAndAddRelaxed ( 1 );
+    }
+
+    if ( iNumChannels != 2 )
+    {
+        for ( int i = 0; i < iNumFrames; i++ )
         {
-            for (int channelNum = 0; channelNum < oboeStream->getChannelCount(); channelNum++)
+            if ( iNumChannels == 1 )
             {
-               pSound->vecsTmpAudioSndCrdStereo [frmNum * oboeStream->getChannelCount() + channelNum] =
-                       (short) floatData[frmNum * oboeStream->getChannelCount() + channelNum] * _MAXSHORT;
+                pfData[i] = ( vecfTmpOutputStereo[2 * i] + vecfTmpOutputStereo[2 * i + 1] ) / 2;
             }
-        }
+            else
+            {
+                pfData[i * iNumChannels]     = vecfTmpOutputStereo[2 * i];
+                pfData[i * iNumChannels + 1] = vecfTmpOutputStereo[2 * i + 1];
 
-        // Tell parent class that we've put some data ready to send to the server
-        pSound->ProcessCallback ( pSound->vecsTmpAudioSndCrdStereo  );
+                std::fill ( pfData + i * iNumChannels + 2, pfData + ( i + 1 ) * iNumChannels, 0.0f );
+            }
+        }
     }
-  //  locker.unlock();
-    return oboe::DataCallbackResult::Continue;
 }
 
-//TODO better handling of stream closing errors
 void CSound::onErrorAfterClose(oboe::AudioStream *oboeStream, oboe::Result result)
 {
-    qDebug() << "CSound::onErrorAfterClose";
+    qDebug() << "CSound::onErrorAfterClose" << oboe::convertToText(result);
+
+    // the stream is closed by Oboe (e.g. if the device was disconnected), the
+    // streams are opened again by a restart of the sound interface
+    if (result == oboe::Result::ErrorDisconnected)
+    {
+        EmitReinitRequestSignal ( RS_ONLY_RESTART );
+    }
 }
 
 //TODO better handling of stream closing errors
 void CSound::onErrorBeforeClose(oboe::AudioStream *oboeStream, oboe::Result result)
 {
-     qDebug() << "CSound::onErrorBeforeClose";
+     qDebug() << "CSound::onErrorBeforeClose" << oboe::convertToText(result);
 }
-
-
-
@@ -28,14 +28,25 @@
  * #include <SLES/OpenSLES.h>
  * #include <SLES/OpenSLES_Android.h> */
 #include <oboe/Oboe.h>
-#include <QMutex>
+#include <memory>
 #include "soundbase.h"
+#include "buffer.h"
 #include "global.h"
 #include <QDebug>
 #include <android/log.h>
 
+/* Definitions ****************************************************************/
+// number of input callbacks which are discarded after the start (the input of
+// the first 500 ms or so contains garbage)
+#define NUM_INPUT_CALLBACKS_TO_DRAIN    10
+
+
 /* Classes ********************************************************************/
-class CSound : public CSoundBase, public oboe::AudioStreamCallback//, public IRenderableAudio, public IRestartable
+// Full-duplex engine on two Oboe streams: the input callback only writes the
+// recorded samples in a wait-free FIFO and the output callback processes
+// whole blocks of the input FIFO and outputs them, i.e. the processing block
+// size does not depend on the bursts of the streams.
+class CSound : public CSoundBase, public oboe::AudioStreamCallback
 {
 public:
     CSound ( void           (*fpNewProcessCallback) ( CVector<short>& psData, void* arg ),
@@ -54,10 +65,6 @@ public:
     virtual void onErrorAfterClose(oboe::AudioStream *oboeStream, oboe::Result result);
     virtual void onErrorBeforeClose(oboe::AudioStream *oboeStream, oboe::Result result);
 
-    // these variables should be protected but cannot since we want
-    // to access them from the callback function
-    CVector<short> vecsTmpAudioSndCrdStereo;
-
     static void android_message_handler(QtMsgType type,
                                       const QMessageLogContext &context,
                                       const QString &message)
@@ -73,33 +80,46 @@ public:
         __android_log_print(priority, "Qt", "%s", qPrintable(message));
     };
 
-// TEST
-CVector<short> vecsTmpAudioInSndCrd;
-int            iModifiedInBufSize;
-
     int            iOpenSLBufferSizeMono;
     int            iOpenSLBufferSizeStereo;
 
 private:
-    void setupCommonStreamParams(oboe::AudioStreamBuilder *builder);
+    void setupCommonStreamParams(oboe::AudioStreamBuilder *builder, const oboe::SharingMode sharingMode);
     void printStreamDetails(oboe::ManagedStream &stream);
+    bool openStream(oboe::ManagedStream &stream, const oboe::Direction direction);
     void openStreams();
     void closeStreams();
     void warnIfNotLowLatency(oboe::ManagedStream &stream, QString streamName);
     void closeStream(oboe::ManagedStream &stream);
 
+    void onInputReady  ( const float* pfData, const int iNumFrames, const int iNumChannels );
+    void onOutputReady ( float* pfData, const int iNumFrames, const int iNumChannels );
+    void processBlock();
+
     oboe::ManagedStream mRecordingStream;
     oboe::ManagedStream mPlayStream;
-    AudioStreamCallback *mCallback;
-
-    // used to reach a state where the input buffer is
-    // empty and the garbage in the first 500ms or so is discarded
-    static constexpr int32_t kNumCallbacksToDrain   = 10;
-    int32_t mCountCallbacksToDrain = kNumCallbacksToDrain;
-
-    // Used to reference this instance of class from within the static callback
-    CSound *pSound;
-
-    QMutex                        Mutex;
 
+    // adapts the buffer size of the output stream in multiples of the burst
+    // size on underruns (starts with a double buffered burst)
+    std::unique_ptr<oboe::LatencyTuner> pLatencyTuner;
+
+    // stereo samples of the input callback for the output callback and the
+    // processed samples which were not yet requested by the output stream
+    // (the latter is only accessed by the output callback)
+    CSampleFifoSPSC<float> InputFifo;
+    CSampleFifoSPSC<float> OutputFifo;
+    int                    iInputFifoMaxFill;
+    int                    iMaxCallbackFrames;
+
+    CVector<short>         vecsTmpAudioSndCrdStereo;
+    CVector<float>         vecfTmpAudioSndCrdStereo;
+    CVector<float>         vecfTmpInputStereo;
+    CVector<float>         vecfTmpOutputStereo;
+
+    // only accessed by the input callback after the start
+    int                    iCountCallbacksToDrain;
+
+    // statistics for the diagnostics output
+    QAtomicInt             iNumInputOverruns;
+    QAtomicInt             iNumOutputUnderruns;
 };
@@ -54,19 +54,6 @@ void CSound::OpenJack ( const bool  bNoAutoJackConnect,
     // register shutdown callback function
     jack_on_shutdown ( pJackClient, shutdownCallback, this );
 
-    // check sample rate, if not correct, just fire error
-    if ( jack_get_sample_rate ( pJackClient ) != SYSTEM_SAMPLE_RATE_HZ )
-    {
-        throw CGenErr ( tr ( "The Jack server sample rate is different from "
-            "the required one. The required sample rate is:" ) + " <b>" +
-            QString().setNum ( SYSTEM_SAMPLE_RATE_HZ ) + " Hz</b>. " + tr ( "You can "
-            "use a tool like <i><a href=""http://qjackctl.sourceforge.net"">QJackCtl</a></i> "
-            "to adjust the Jack server sample rate." ) + "<br>" + tr ( "Make sure to set the "
-            "Frames/Period to a low value like " ) +
-            QString().setNum ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES ) +
-            tr ( " to achieve a low delay." ) );
-    }
-
     // create four ports (two for input, two for output -> stereo)
     input_port_left = jack_port_register ( pJackClient, "input left",
         JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0 );
@@ -181,7 +168,7 @@ void CSound::Stop()
     CSoundBase::Stop();
 }
 
-int CSound::Init ( const int /* iNewPrefMonoBufferSize */ )
+int CSound::Init ( const int iNewPrefMonoBufferSize )
 {
 
 // try setting buffer size
@@ -202,16 +189,42 @@ int CSound::Init ( const int /* iNewPrefMonoBufferSize */ )
     // get actual buffer size
     iJACKBufferSizeMono = jack_get_buffer_size ( pJackClient );  	
 
+    // if the Jack server does not run at the system sample rate, the audio is
+    // converted and processed in blocks of the preferred size
+    int iMonoBlockSize = iJACKBufferSizeMono;
+
+    if ( jack_get_sample_rate ( pJackClient ) != SYSTEM_SAMPLE_RATE_HZ )
+    {
+        if ( !InitRateConv ( jack_get_sample_rate ( pJackClient ), iJACKBufferSizeMono, iNewPrefMonoBufferSize ) )
+        {
+            throw CGenErr ( tr ( "The Jack server sample rate is different from "
+                "the required one. The required sample rate is:" ) + " <b>" +
+                QString().setNum ( SYSTEM_SAMPLE_RATE_HZ ) + " Hz</b>. " + tr ( "You can "
+                "use a tool like <i><a href=""http://qjackctl.sourceforge.net"">QJackCtl</a></i> "
+                "to adjust the Jack server sample rate." ) + "<br>" + tr ( "Make sure to set the "
+                "Frames/Period to a low value like " ) +
+                QString().setNum ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES ) +
+                tr ( " to achieve a low delay." ) );
+        }
+
+        iMonoBlockSize = iNewPrefMonoBufferSize;
+    }
+    else
+    {
+        RateConv.Disable();
+    }
+
     // init base class
-    CSoundBase::Init ( iJACKBufferSizeMono );
+    CSoundBase::Init ( iMonoBlockSize );
 
     // set internal buffer size value and calculate stereo buffer size
     iJACKBufferSizeStero = 2 * iJACKBufferSizeMono;
 
-    // create memory for intermediate audio buffer
+    // create memory for intermediate audio buffers
     vecsTmpAudioSndCrdStereo.Init ( iJACKBufferSizeStero );
+    vecfTmpAudioSndCrdStereo.Init ( iJACKBufferSizeStero );
 
-    return iJACKBufferSizeMono;
+    return iMonoBlockSize;
 }
 
 
@@ -219,7 +232,6 @@ int CSound::Init ( const int /* iNewPrefMonoBufferSize */ )
 int CSound::process ( jack_nframes_t nframes, void* arg )
 {
     CSound* pSound = static_cast<CSound*> ( arg );
-    int     i;
 
     if ( pSound->IsRunning() && ( nframes == static_cast<jack_nframes_t> ( pSound->iJACKBufferSizeMono ) ) )
     {
@@ -232,22 +244,6 @@ int CSound::process ( jack_nframes_t nframes, void* arg )
             (jack_default_audio_sample_t*) jack_port_get_buffer (
             pSound->input_port_right, nframes );
 
-        // copy input audio data
-        if ( ( in_left != nullptr ) && ( in_right != nullptr ) )
-        {
-            for ( i = 0; i < pSound->iJACKBufferSizeMono; i++ )
-            {
-                pSound->vecsTmpAudioSndCrdStereo[2 * i] =
-                    (short) ( in_left[i] * _MAXSHORT );
-
-                pSound->vecsTmpAudioSndCrdStereo[2 * i + 1] =
-                    (short) ( in_right[i] * _MAXSHORT );
-            }
-        }
-
-        // call processing callback function
-        pSound->ProcessCallback ( pSound->vecsTmpAudioSndCrdStereo );
-
         // get output data pointer
         jack_default_audio_sample_t* out_left =
             (jack_default_audio_sample_t*) jack_port_get_buffer (
@@ -257,16 +253,73 @@ int CSound::process ( jack_nframes_t nframes, void* arg )
             (jack_default_audio_sample_t*) jack_port_get_buffer (
             pSound->output_port_right, nframes );
 
-        // copy output data
-        if ( ( out_left != nullptr ) && ( out_right != nullptr ) )
+        if ( pSound->RateConv.IsEnabled() )
+        {
+            // the Jack server runs at a different sample rate, the processing
+            // is called by the sample rate conversion in blocks of the system
+            // sample rate
+            if ( ( in_left != nullptr ) && ( in_right != nullptr ) )
+            {
+                CSndSampleConv::InterleaveFloatStereo ( in_left,
+                                                        in_right,
+                                                        &pSound->vecfTmpAudioSndCrdStereo[0],
+                                                        pSound->iJACKBufferSizeMono );
+            }
+
+            pSound->ProcessCallbackRateConv ( &pSound->vecfTmpAudioSndCrdStereo[0],
+                                              pSound->iJACKBufferSizeMono );
+
+            if ( ( out_left != nullptr ) && ( out_right != nullptr ) )
+            {
+                CSndSampleConv::DeinterleaveFloatStereo ( &pSound->vecfTmpAudioSndCrdStereo[0],
+                                                          out_left,
+                                                          out_right,
+                                                          pSound->iJACKBufferSizeMono );
+            }
+        }
+        else if ( pSound->HasProcessCallbackFloat() )
+        {
+            // native float path: the port buffers are only interleaved, the
+            // samples are processed without a conversion to int16
+            if ( ( in_left != nullptr ) && ( in_right != nullptr ) )
+            {
+                CSndSampleConv::InterleaveFloatStereo ( in_left,
+                                                        in_right,
+                                                        &pSound->vecfTmpAudioSndCrdStereo[0],
+                                                        pSound->iJACKBufferSizeMono );
+            }
+
+            pSound->ProcessCallbackFloat ( pSound->vecfTmpAudioSndCrdStereo );
+
+            if ( ( out_left != nullptr ) && ( out_right != nullptr ) )
+            {
+                CSndSampleConv::DeinterleaveFloatStereo ( &pSound->vecfTmpAudioSndCrdStereo[0],
+                                                          out_left,
+                                                          out_right,
+                                                          pSound->iJACKBufferSizeMono );
+            }
+        }
+        else
         {
-            for ( i = 0; i < pSound->iJACKBufferSizeMono; i++ )
+            // copy input audio data
+            if ( ( in_left != nullptr ) && ( in_right != nullptr ) )
             {
-                out_left[i] = (jack_default_audio_sample_t)
-                    pSound->vecsTmpAudioSndCrdStereo[2 * i] / _MAXSHORT;
+                CSndSampleConv::FloatStereoToShort ( in_left,
+                                                     in_right,
+                                                     &pSound->vecsTmpAudioSndCrdStereo[0],
+                                                     pSound->iJACKBufferSizeMono );
+            }
+
+            // call processing callback function
+            pSound->ProcessCallback ( pSound->vecsTmpAudioSndCrdStereo );
 
-                out_right[i] = (jack_default_audio_sample_t)
-                    pSound->vecsTmpAudioSndCrdStereo[2 * i + 1] / _MAXSHORT;
+            // copy output data
+            if ( ( out_left != nullptr ) && ( out_right != nullptr ) )
+            {
+                CSndSampleConv::ShortToFloatStereo ( &pSound->vecsTmpAudioSndCrdStereo[0],
+                                                     out_left,
+                                                     out_right,
+                                                     pSound->iJACKBufferSizeMono );
             }
         }
     }
@@ -309,15 +362,10 @@ int CSound::process ( jack_nframes_t nframes, void* arg )
 
                 jack_midi_event_get ( &in_event, in_midi, j );
 
-                // copy packet and send it to the MIDI parser
-// TODO do not call malloc in real-time callback
-                CVector<uint8_t> vMIDIPaketBytes ( in_event.size );
-
-                for ( i = 0; i < static_cast<int> ( in_event.size ); i++ )
-                {
-                    vMIDIPaketBytes[i] = static_cast<uint8_t> ( in_event.buffer[i] );
-                }
-                pSound->ParseMIDIMessage ( vMIDIPaketBytes );
+                // the message is parsed in the main thread (no memory
+                // allocation and no signal in the real-time callback)
+                pSound->PutMIDIMessage ( static_cast<const uint8_t*> ( in_event.buffer ),
+                                         static_cast<int> ( in_event.size ) );
             }
         }
     }
@@ -329,7 +377,9 @@ int CSound::bufferSizeCallback ( jack_nframes_t, void* arg )
 {
     CSound* pSound = static_cast<CSound*> ( arg );
 
-    pSound->EmitReinitRequestSignal ( RS_ONLY_RESTART_AND_INIT );
+    // the client keeps the network settings if it can, the processing is
+    // silent until the new buffer size is applied (see process())
+    pSound->EmitReinitRequestSignal ( RS_ONLY_BUFFER_SIZE_CHANGED );
 
     return 0; // zero on success, non-zero on error
 }
@@ -610,13 +610,9 @@ void CSound::UpdateChSelection()
     int iSelCHLeft,  iSelAddCHLeft;
     int iSelCHRight, iSelAddCHRight;
 
-    // initialize all buffer indexes with an invalid value
-    iSelInBufferLeft     = INVALID_INDEX;
-    iSelInBufferRight    = INVALID_INDEX;
-    iSelAddInBufferLeft  = INVALID_INDEX; // if no additional channel used, this will stay on the invalid value
-    iSelAddInBufferRight = INVALID_INDEX; // if no additional channel used, this will stay on the invalid value
-    iSelOutBufferLeft    = INVALID_INDEX;
-    iSelOutBufferRight   = INVALID_INDEX;
+    // all buffer indexes are initialized with an invalid value (if no
+    // additional channel is used, it will stay on the invalid value)
+    SChMapping NewChMapping;
 
     // input
     GetSelCHAndAddCH ( iSelInputLeftChannel,  iNumInChan, iSelCHLeft,  iSelAddCHLeft );
@@ -628,28 +624,32 @@ void CSound::UpdateChSelection()
     {
         iChCnt += vecNumInBufChan[iBuf];
 
-        if ( ( iSelInBufferLeft < 0 ) && ( iChCnt > iSelCHLeft ) )
+        if ( ( NewChMapping.iSelInBufferLeft < 0 ) && ( iChCnt > iSelCHLeft ) )
         {
-            iSelInBufferLeft   = iBuf;
-            iSelInInterlChLeft = iSelCHLeft - iChCnt + vecNumInBufChan[iBuf];
+            NewChMapping.iSelInBufferLeft       = iBuf;
+            NewChMapping.iSelInInterlChLeft     = iSelCHLeft - iChCnt + vecNumInBufChan[iBuf];
+            NewChMapping.iNumInChanPerFrameLeft = vecNumInBufChan[iBuf];
         }
 
-        if ( ( iSelInBufferRight < 0 ) && ( iChCnt > iSelCHRight ) )
+        if ( ( NewChMapping.iSelInBufferRight < 0 ) && ( iChCnt > iSelCHRight ) )
         {
-            iSelInBufferRight   = iBuf;
-            iSelInInterlChRight = iSelCHRight - iChCnt + vecNumInBufChan[iBuf];
+            NewChMapping.iSelInBufferRight       = iBuf;
+            NewChMapping.iSelInInterlChRight     = iSelCHRight - iChCnt + vecNumInBufChan[iBuf];
+            NewChMapping.iNumInChanPerFrameRight = vecNumInBufChan[iBuf];
         }
 
-        if ( ( iSelAddCHLeft >= 0 ) && ( iSelAddInBufferLeft < 0 ) && ( iChCnt > iSelAddCHLeft ) )
+        if ( ( iSelAddCHLeft >= 0 ) && ( NewChMapping.iSelAddInBufferLeft < 0 ) && ( iChCnt > iSelAddCHLeft ) )
         {
-            iSelAddInBufferLeft   = iBuf;
-            iSelAddInInterlChLeft = iSelAddCHLeft - iChCnt + vecNumInBufChan[iBuf];
+            NewChMapping.iSelAddInBufferLeft       = iBuf;
+            NewChMapping.iSelAddInInterlChLeft     = iSelAddCHLeft - iChCnt + vecNumInBufChan[iBuf];
+            NewChMapping.iNumAddInChanPerFrameLeft = vecNumInBufChan[iBuf];
         }
 
-        if ( ( iSelAddCHRight >= 0 ) && ( iSelAddInBufferRight < 0 ) && ( iChCnt > iSelAddCHRight ) )
+        if ( ( iSelAddCHRight >= 0 ) && ( NewChMapping.iSelAddInBufferRight < 0 ) && ( iChCnt > iSelAddCHRight ) )
         {
-            iSelAddInBufferRight   = iBuf;
-            iSelAddInInterlChRight = iSelAddCHRight - iChCnt + vecNumInBufChan[iBuf];
+            NewChMapping.iSelAddInBufferRight       = iBuf;
+            NewChMapping.iSelAddInInterlChRight     = iSelAddCHRight - iChCnt + vecNumInBufChan[iBuf];
+            NewChMapping.iNumAddInChanPerFrameRight = vecNumInBufChan[iBuf];
         }
     }
 
@@ -663,18 +663,51 @@ void CSound::UpdateChSelection()
     {
         iChCnt += vecNumOutBufChan[iBuf];
 
-        if ( ( iSelOutBufferLeft < 0 ) && ( iChCnt > iSelCHLeft ) )
+        if ( ( NewChMapping.iSelOutBufferLeft < 0 ) && ( iChCnt > iSelCHLeft ) )
         {
-            iSelOutBufferLeft   = iBuf;
-            iSelOutInterlChLeft = iSelCHLeft - iChCnt + vecNumOutBufChan[iBuf];
+            NewChMapping.iSelOutBufferLeft       = iBuf;
+            NewChMapping.iSelOutInterlChLeft     = iSelCHLeft - iChCnt + vecNumOutBufChan[iBuf];
+            NewChMapping.iNumOutChanPerFrameLeft = vecNumOutBufChan[iBuf];
         }
 
-        if ( ( iSelOutBufferRight < 0 ) && ( iChCnt > iSelCHRight ) )
+        if ( ( NewChMapping.iSelOutBufferRight < 0 ) && ( iChCnt > iSelCHRight ) )
         {
-            iSelOutBufferRight   = iBuf;
-            iSelOutInterlChRight = iSelCHRight - iChCnt + vecNumOutBufChan[iBuf];
+            NewChMapping.iSelOutBufferRight       = iBuf;
+            NewChMapping.iSelOutInterlChRight     = iSelCHRight - iChCnt + vecNumOutBufChan[iBuf];
+            NewChMapping.iNumOutChanPerFrameRight = vecNumOutBufChan[iBuf];
         }
     }
+
+    PublishChMapping ( NewChMapping );
+}
+
+void CSound::PublishChMapping ( const SChMapping& NewChMapping )
+{
+    // write the new mapping in the inactive buffer and make it the active one
+    // afterwards, then wait until no callback copies the old mapping anymore
+    // so that the next update can safely overwrite it (copying the mapping is
+    // very short compared to the audio block duration)
+    const int iInactiveIdx = 1 - ( iChMappingState.loadAcquire() & 1 );
+
+    ChMapping[iInactiveIdx] = NewChMapping;
+
+    iChMappingState.fetchAndXorOrdered ( 1 );
+
+    while ( ( iChMappingState.loadAcquire() >> 1 ) != 0 )
+    {
+        QThread::yieldCurrentThread();
+    }
+}
+
+void CSound::GetChMapping ( SChMapping& CurChMapping )
+{
+    // register as reader of the active mapping, copy it and unregister, this
+    // is lock-free and therefore safe to be called in the audio callback
+    const int iState = iChMappingState.fetchAndAddAcquire ( 2 );
+
+    CurChMapping = ChMapping[iState & 1];
+
+    iChMappingState.fetchAndAddRelease ( -2 );
 }
 
 void CSound::SetLeftInputChannel  ( const int iNewChan )
@@ -928,26 +961,28 @@ OSStatus CSound::callbackIO ( AudioDeviceID          inDevice,
                               const AudioTimeStamp*,
                               void*                  inRefCon )
 {
-    CSound* pSound = static_cast<CSound*> ( inRefCon );
-
-    // both, the input and output device use the same callback function
-    QMutexLocker locker ( &pSound->Mutex );
-
-    const int           iCoreAudioBufferSizeMono = pSound->iCoreAudioBufferSizeMono;
-    const int           iSelInBufferLeft         = pSound->iSelInBufferLeft;
-    const int           iSelInBufferRight        = pSound->iSelInBufferRight;
-    const int           iSelInInterlChLeft       = pSound->iSelInInterlChLeft;
-    const int           iSelInInterlChRight      = pSound->iSelInInterlChRight;
-    const int           iSelAddInBufferLeft      = pSound->iSelAddInBufferLeft;
-    const int           iSelAddInBufferRight     = pSound->iSelAddInBufferRight;
-    const int           iSelAddInInterlChLeft    = pSound->iSelAddInInterlChLeft;
-    const int           iSelAddInInterlChRight   = pSound->iSelAddInInterlChRight;
-    const int           iSelOutBufferLeft        = pSound->iSelOutBufferLeft;
-    const int           iSelOutBufferRight       = pSound->iSelOutBufferRight;
-    const int           iSelOutInterlChLeft      = pSound->iSelOutInterlChLeft;
-    const int           iSelOutInterlChRight     = pSound->iSelOutInterlChRight;
-    const CVector<int>& vecNumInBufChan          = pSound->vecNumInBufChan;
-    const CVector<int>& vecNumOutBufChan         = pSound->vecNumOutBufChan;
+    CSound*    pSound = static_cast<CSound*> ( inRefCon );
+    SChMapping ChMap;
+
+    // both, the input and output device use the same callback function, the
+    // channel mapping is copied lock-free since the GUI thread may change it
+    // at any time (the input and output callbacks of one device are called
+    // sequentially on the I/O thread of the device)
+    pSound->GetChMapping ( ChMap );
+
+    const int iCoreAudioBufferSizeMono = pSound->iCoreAudioBufferSizeMono;
+    const int iSelInBufferLeft         = ChMap.iSelInBufferLeft;
+    const int iSelInBufferRight        = ChMap.iSelInBufferRight;
+    const int iSelInInterlChLeft       = ChMap.iSelInInterlChLeft;
+    const int iSelInInterlChRight      = ChMap.iSelInInterlChRight;
+    const int iSelAddInBufferLeft      = ChMap.iSelAddInBufferLeft;
+    const int iSelAddInBufferRight     = ChMap.iSelAddInBufferRight;
+    const int iSelAddInInterlChLeft    = ChMap.iSelAddInInterlChLeft;
+    const int iSelAddInInterlChRight   = ChMap.iSelAddInInterlChRight;
+    const int iSelOutBufferLeft        = ChMap.iSelOutBufferLeft;
+    const int iSelOutBufferRight       = ChMap.iSelOutBufferRight;
+    const int iSelOutInterlChLeft      = ChMap.iSelOutInterlChLeft;
+    const int iSelOutInterlChRight     = ChMap.iSelOutInterlChRight;
 
     if ( ( inDevice == pSound->CurrentAudioInputDeviceID ) && inInputData )
     {
@@ -958,45 +993,47 @@ OSStatus CSound::callbackIO ( AudioDeviceID          inDevice,
              ( iSelInBufferRight < static_cast<int> ( inInputData->mNumberBuffers ) ) &&
              ( iSelAddInBufferLeft < static_cast<int> ( inInputData->mNumberBuffers ) ) &&
              ( iSelAddInBufferRight < static_cast<int> ( inInputData->mNumberBuffers ) ) &&
-             ( inInputData->mBuffers[iSelInBufferLeft].mDataByteSize  == static_cast<UInt32> ( vecNumInBufChan[iSelInBufferLeft] *  iCoreAudioBufferSizeMono * 4 ) ) &&
-             ( inInputData->mBuffers[iSelInBufferRight].mDataByteSize == static_cast<UInt32> ( vecNumInBufChan[iSelInBufferRight] * iCoreAudioBufferSizeMono * 4 ) ) )
+             ( inInputData->mBuffers[iSelInBufferLeft].mDataByteSize  == static_cast<UInt32> ( ChMap.iNumInChanPerFrameLeft *  iCoreAudioBufferSizeMono * 4 ) ) &&
+             ( inInputData->mBuffers[iSelInBufferRight].mDataByteSize == static_cast<UInt32> ( ChMap.iNumInChanPerFrameRight * iCoreAudioBufferSizeMono * 4 ) ) )
         {
             Float32* pLeftData             = static_cast<Float32*> ( inInputData->mBuffers[iSelInBufferLeft].mData );
             Float32* pRightData            = static_cast<Float32*> ( inInputData->mBuffers[iSelInBufferRight].mData );
-            int      iNumChanPerFrameLeft  = vecNumInBufChan[iSelInBufferLeft];
-            int      iNumChanPerFrameRight = vecNumInBufChan[iSelInBufferRight];
+            int      iNumChanPerFrameLeft  = ChMap.iNumInChanPerFrameLeft;
+            int      iNumChanPerFrameRight = ChMap.iNumInChanPerFrameRight;
 
-            // copy input data
-            for ( int i = 0; i < iCoreAudioBufferSizeMono; i++ )
-            {
-                // copy left and right channels separately
-                pSound->vecsTmpAudioSndCrdStereo[2 * i]     = (short) ( pLeftData[iNumChanPerFrameLeft * i + iSelInInterlChLeft] * _MAXSHORT );
-                pSound->vecsTmpAudioSndCrdStereo[2 * i + 1] = (short) ( pRightData[iNumChanPerFrameRight * i + iSelInInterlChRight] * _MAXSHORT );
-            }
+            // copy left and right channels separately (the sound card buffers
+            // are interleaved with iNumChanPerFrame channels)
+            CSndSampleConv::ToShort ( SF_FLOAT32, false,
+                                      &pLeftData[iSelInInterlChLeft], iNumChanPerFrameLeft,
+                                      &pSound->vecsTmpAudioSndCrdStereo[0], 2,
+                                      iCoreAudioBufferSizeMono );
+
+            CSndSampleConv::ToShort ( SF_FLOAT32, false,
+                                      &pRightData[iSelInInterlChRight], iNumChanPerFrameRight,
+                                      &pSound->vecsTmpAudioSndCrdStereo[1], 2,
+                                      iCoreAudioBufferSizeMono );
 
             // add an additional optional channel
             if ( iSelAddInBufferLeft >= 0 )
             {
                 pLeftData            = static_cast<Float32*> ( inInputData->mBuffers[iSelAddInBufferLeft].mData );
-                iNumChanPerFrameLeft = vecNumInBufChan[iSelAddInBufferLeft];
+                iNumChanPerFrameLeft = ChMap.iNumAddInChanPerFrameLeft;
 
-                for ( int i = 0; i < iCoreAudioBufferSizeMono; i++ )
-                {
-                    pSound->vecsTmpAudioSndCrdStereo[2 * i] = Double2Short (
-                        pSound->vecsTmpAudioSndCrdStereo[2 * i] + pLeftData[iNumChanPerFrameLeft * i + iSelAddInInterlChLeft] * _MAXSHORT );
-                }
+                CSndSampleConv::MixToShort ( SF_FLOAT32, false,
+                                             &pLeftData[iSelAddInInterlChLeft], iNumChanPerFrameLeft,
+                                             &pSound->vecsTmpAudioSndCrdStereo[0], 2,
+                                             iCoreAudioBufferSizeMono );
             }
 
             if ( iSelAddInBufferRight >= 0 )
             {
                 pRightData            = static_cast<Float32*> ( inInputData->mBuffers[iSelAddInBufferRight].mData );
-                iNumChanPerFrameRight = vecNumInBufChan[iSelAddInBufferRight];
+                iNumChanPerFrameRight = ChMap.iNumAddInChanPerFrameRight;
 
-                for ( int i = 0; i < iCoreAudioBufferSizeMono; i++ )
-                {
-                    pSound->vecsTmpAudioSndCrdStereo[2 * i + 1] = Double2Short (
-                        pSound->vecsTmpAudioSndCrdStereo[2 * i + 1] + pRightData[iNumChanPerFrameRight * i + iSelAddInInterlChRight] * _MAXSHORT );
-                }
+                CSndSampleConv::MixToShort ( SF_FLOAT32, false,
+                                             &pRightData[iSelAddInInterlChRight], iNumChanPerFrameRight,
+                                             &pSound->vecsTmpAudioSndCrdStereo[1], 2,
+                                             iCoreAudioBufferSizeMono );
             }
         }
         else
@@ -1016,21 +1053,24 @@ OSStatus CSound::callbackIO ( AudioDeviceID          inDevice,
             ( iSelOutBufferLeft < static_cast<int> ( outOutputData->mNumberBuffers ) ) &&
             ( iSelOutBufferRight >= 0 ) &&
             ( iSelOutBufferRight < static_cast<int> ( outOutputData->mNumberBuffers ) ) &&
-            ( outOutputData->mBuffers[iSelOutBufferLeft].mDataByteSize  == static_cast<UInt32> ( vecNumOutBufChan[iSelOutBufferLeft] *  iCoreAudioBufferSizeMono * 4 ) ) &&
-            ( outOutputData->mBuffers[iSelOutBufferRight].mDataByteSize == static_cast<UInt32> ( vecNumOutBufChan[iSelOutBufferRight] * iCoreAudioBufferSizeMono * 4 ) ) )
+            ( outOutputData->mBuffers[iSelOutBufferLeft].mDataByteSize  == static_cast<UInt32> ( ChMap.iNumOutChanPerFrameLeft *  iCoreAudioBufferSizeMono * 4 ) ) &&
+            ( outOutputData->mBuffers[iSelOutBufferRight].mDataByteSize == static_cast<UInt32> ( ChMap.iNumOutChanPerFrameRight * iCoreAudioBufferSizeMono * 4 ) ) )
        {
            Float32* pLeftData             = static_cast<Float32*> ( outOutputData->mBuffers[iSelOutBufferLeft].mData );
            Float32* pRightData            = static_cast<Float32*> ( outOutputData->mBuffers[iSelOutBufferRight].mData );
-           int      iNumChanPerFrameLeft  = vecNumOutBufChan[iSelOutBufferLeft];
-           int      iNumChanPerFrameRight = vecNumOutBufChan[iSelOutBufferRight];
-
-           // copy output data
-           for ( int i = 0; i < iCoreAudioBufferSizeMono; i++ )
-           {
-               // copy left and right channels separately
-               pLeftData[iNumChanPerFrameLeft * i + iSelOutInterlChLeft]    = (Float32) pSound->vecsTmpAudioSndCrdStereo[2 * i] / _MAXSHORT;
-               pRightData[iNumChanPerFrameRight * i + iSelOutInterlChRight] = (Float32) pSound->vecsTmpAudioSndCrdStereo[2 * i + 1] / _MAXSHORT;
-           }
+           int      iNumChanPerFrameLeft  = ChMap.iNumOutChanPerFrameLeft;
+           int      iNumChanPerFrameRight = ChMap.iNumOutChanPerFrameRight;
+
+           // copy left and right channels separately
+           CSndSampleConv::FromShort ( SF_FLOAT32, false,
+                                       &pSound->vecsTmpAudioSndCrdStereo[0], 2,
+                                       &pLeftData[iSelOutInterlChLeft], iNumChanPerFrameLeft,
+                                       iCoreAudioBufferSizeMono );
+
+           CSndSampleConv::FromShort ( SF_FLOAT32, false,
+                                       &pSound->vecsTmpAudioSndCrdStereo[1], 2,
+                                       &pRightData[iSelOutInterlChRight], iNumChanPerFrameRight,
+                                       iCoreAudioBufferSizeMono );
         }
     }
 
@@ -1049,13 +1089,9 @@ void CSound::callbackMIDI ( const MIDIPacketList* pktlist,
 
         for ( unsigned int j = 0; j < pktlist->numPackets; j++ )
         {
-            // copy packet and send it to the MIDI parser
-            CVector<uint8_t> vMIDIPaketBytes ( midiPacket->length );
-            for ( int i = 0; i < midiPacket->length; i++ )
-            {
-                vMIDIPaketBytes[i] = static_cast<uint8_t> ( midiPacket->data[i] );
-            }
-            pSound->ParseMIDIMessage ( vMIDIPaketBytes );
+            // the message is parsed in the main thread
+            pSound->PutMIDIMessage ( midiPacket->data,
+                                     static_cast<int> ( midiPacket->length ) );
 
             midiPacket = MIDIPacketNext ( midiPacket );
         }
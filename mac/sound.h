@@ -27,7 +27,8 @@
 #include <CoreAudio/CoreAudio.h>
 #include <AudioToolbox/AudioToolbox.h>
 #include <CoreMIDI/CoreMIDI.h>
-#include <QMutex>
+#include <QAtomicInt>
+#include <QThread>
 #include "soundbase.h"
 #include "global.h"
 
@@ -75,22 +76,49 @@ public:
     int            iSelInputRightChannel;
     int            iSelOutputLeftChannel;
     int            iSelOutputRightChannel;
-    int            iSelInBufferLeft;
-    int            iSelInBufferRight;
-    int            iSelInInterlChLeft;
-    int            iSelInInterlChRight;
-    int            iSelAddInBufferLeft;
-    int            iSelAddInBufferRight;
-    int            iSelAddInInterlChLeft;
-    int            iSelAddInInterlChRight;
-    int            iSelOutBufferLeft;
-    int            iSelOutBufferRight;
-    int            iSelOutInterlChLeft;
-    int            iSelOutInterlChRight;
     CVector<int>   vecNumInBufChan;
     CVector<int>   vecNumOutBufChan;
 
 protected:
+    // mapping of the selected channels on the CoreAudio buffers (buffer index,
+    // interleaved channel index in the buffer and number of interleaved
+    // channels of the buffer) which is used by the audio callback
+    struct SChMapping
+    {
+        SChMapping() :
+            iSelInBufferLeft ( INVALID_INDEX ), iSelInBufferRight ( INVALID_INDEX ),
+            iSelInInterlChLeft ( 0 ), iSelInInterlChRight ( 0 ),
+            iNumInChanPerFrameLeft ( 0 ), iNumInChanPerFrameRight ( 0 ),
+            iSelAddInBufferLeft ( INVALID_INDEX ), iSelAddInBufferRight ( INVALID_INDEX ),
+            iSelAddInInterlChLeft ( 0 ), iSelAddInInterlChRight ( 0 ),
+            iNumAddInChanPerFrameLeft ( 0 ), iNumAddInChanPerFrameRight ( 0 ),
+            iSelOutBufferLeft ( INVALID_INDEX ), iSelOutBufferRight ( INVALID_INDEX ),
+            iSelOutInterlChLeft ( 0 ), iSelOutInterlChRight ( 0 ),
+            iNumOutChanPerFrameLeft ( 0 ), iNumOutChanPerFrameRight ( 0 ) {}
+
+        int iSelInBufferLeft;
+        int iSelInBufferRight;
+        int iSelInInterlChLeft;
+        int iSelInInterlChRight;
+        int iNumInChanPerFrameLeft;
+        int iNumInChanPerFrameRight;
+        int iSelAddInBufferLeft;
+        int iSelAddInBufferRight;
+        int iSelAddInInterlChLeft;
+        int iSelAddInInterlChRight;
+        int iNumAddInChanPerFrameLeft;
+        int iNumAddInChanPerFrameRight;
+        int iSelOutBufferLeft;
+        int iSelOutBufferRight;
+        int iSelOutInterlChLeft;
+        int iSelOutInterlChRight;
+        int iNumOutChanPerFrameLeft;
+        int iNumOutChanPerFrameRight;
+    };
+
+    void PublishChMapping ( const SChMapping& NewChMapping );
+    void GetChMapping ( SChMapping& CurChMapping );
+
     virtual QString LoadAndInitializeDriver ( int iIdx, bool );
 
     QString CheckDeviceCapabilities ( const int iDriverIdx );
@@ -138,5 +166,10 @@ protected:
     QString             sChannelNamesInput[MAX_NUM_IN_OUT_CHANNELS];
     QString             sChannelNamesOutput[MAX_NUM_IN_OUT_CHANNELS];
 
-    QMutex              Mutex;
+    // the channel mapping is double buffered so that the audio callback never
+    // waits for a channel selection change of the GUI thread: bit 0 of the
+    // state is the index of the active mapping, the remaining bits count the
+    // callbacks which are currently copying the active mapping
+    SChMapping          ChMapping[2];
+    QAtomicInt          iChMappingState;
 };
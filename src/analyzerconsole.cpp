@@ -25,24 +25,187 @@
 #include "analyzerconsole.h"
 
 
+// Error rate graph implementation *********************************************
+CErrRateGraph::CErrRateGraph ( QWidget* parent ) :
+    QWidget              ( parent ),
+    dLimit               ( 0.0 ),
+    dMaxUpLimit          ( 0.0 ),
+    dMin                 ( 0.0 ),
+    dMax                 ( 0.0 ),
+    bStaticLayerValid    ( false ),
+    iGridFrameOffset     ( 10 ),
+    iLineWidth           ( 2 ),
+    iMarkerSize          ( 10 ),
+    iXAxisTextHeight     ( 22 ),
+    GraphBackgroundColor ( Qt::white ), // background
+    GraphFrameColor      ( Qt::black ), // frame
+    LineColor            ( Qt::blue ),
+    LineLimitColor       ( Qt::green ),
+    LineMaxUpLimitColor  ( Qt::red )
+{
+    setMinimumSize ( 300, 225 );
+
+    // the whole widget is painted by us
+    setAttribute ( Qt::WA_OpaquePaintEvent );
+}
+
+void CErrRateGraph::SetErrorRates ( const CVector<double>& vecdNewErrRates,
+                                    const double           dNewLimit,
+                                    const double           dNewMaxUpLimit )
+{
+    // the limits only change with the frame size, i.e. the static layer is
+    // almost never rendered again
+    if ( ( dNewLimit != dLimit ) || ( dNewMaxUpLimit != dMaxUpLimit ) )
+    {
+        dLimit            = dNewLimit;
+        dMaxUpLimit       = dNewMaxUpLimit;
+        bStaticLayerValid = false;
+    }
+
+    vecdErrRates = vecdNewErrRates;
+
+    update();
+}
+
+void CErrRateGraph::resizeEvent ( QResizeEvent* )
+{
+    bStaticLayerValid = false;
+}
+
+void CErrRateGraph::DrawStaticLayer()
+{
+    StaticLayer = QPixmap ( size() );
+
+    // generate plot grid frame rectangle
+    GraphGridFrame.setRect ( iGridFrameOffset,
+        iGridFrameOffset,
+        width() - 2 * iGridFrameOffset,
+        height() - 2 * iGridFrameOffset - iXAxisTextHeight );
+
+    StaticLayer.fill ( GraphBackgroundColor ); // fill background
+
+    QPainter GraphPainter ( &StaticLayer );
+
+    // create actual plot region (grid frame)
+    GraphPainter.setPen ( GraphFrameColor );
+    GraphPainter.drawRect ( GraphGridFrame );
+
+    // there are no limits before the jitter buffer has delivered the first
+    // block
+    if ( ( dLimit > 0 ) && ( dMaxUpLimit > 0 ) )
+    {
+        // convert the limits in the log domain
+        const double dLogLimit      = log10 ( dLimit );
+        const double dLogMaxUpLimit = log10 ( dMaxUpLimit );
+
+        // use fixed y-axis scale where the limit line is in the middle of the graph
+        dMax = 0;
+        dMin = dLogLimit * 2;
+
+        // plot the limit line as dashed line
+        const int iYValLimitInGraph = CalcYPosInGraph ( dLogLimit );
+
+        GraphPainter.setPen ( QPen ( QBrush ( LineLimitColor ),
+                                     iLineWidth,
+                                     Qt::DashLine ) );
+
+        GraphPainter.drawLine ( QPoint ( GraphGridFrame.x(), iYValLimitInGraph ),
+                                QPoint ( GraphGridFrame.x() +
+                                         GraphGridFrame.width(), iYValLimitInGraph ) );
+
+        // plot the maximum upper limit line as a dashed line
+        const int iYValMaxUpLimitInGraph = CalcYPosInGraph ( dLogMaxUpLimit );
+
+        GraphPainter.setPen ( QPen ( QBrush ( LineMaxUpLimitColor ),
+                                     iLineWidth,
+                                     Qt::DashLine ) );
+
+        GraphPainter.drawLine ( QPoint ( GraphGridFrame.x(), iYValMaxUpLimitInGraph ),
+                                QPoint ( GraphGridFrame.x() +
+                                         GraphGridFrame.width(), iYValMaxUpLimitInGraph ) );
+    }
+
+    bStaticLayerValid = true;
+}
+
+void CErrRateGraph::paintEvent ( QPaintEvent* )
+{
+    if ( !bStaticLayerValid )
+    {
+        DrawStaticLayer();
+    }
+
+    QPainter GraphPainter ( this );
+
+    GraphPainter.drawPixmap ( 0, 0, StaticLayer );
+
+    // get the number of data elements
+    const int iNumBuffers = vecdErrRates.Size();
+
+    if ( ( iNumBuffers < 2 ) || ( dLimit <= 0 ) || ( dMaxUpLimit <= 0 ) )
+    {
+        return;
+    }
+
+    // calculate space between points on the x-axis
+    const double dXSpace =
+        static_cast<double> ( GraphGridFrame.width() ) / ( iNumBuffers - 1 );
+
+    const QPen MarkerPen ( QBrush ( LineColor ),
+                           iMarkerSize,
+                           Qt::SolidLine,
+                           Qt::RoundCap );
+
+    const QPen StemPen ( QBrush ( LineColor ), iLineWidth );
+
+    // plot the data
+    for ( int i = 0; i < iNumBuffers; i++ )
+    {
+        // data convert in log domain
+        // check for special case if error rate is 0 (which would lead to -Inf
+        // after the log operation), definition: set it to lowest possible axis
+        // value
+        const double dLogErrRate =
+            ( vecdErrRates[i] > 0 ) ? log10 ( vecdErrRates[i] ) : dMin;
+
+        // calculate the actual point in the graph (in pixels)
+        const QPoint curPoint (
+            GraphGridFrame.x() + static_cast<int> ( dXSpace * i ),
+            CalcYPosInGraph ( dLogErrRate ) );
+
+        // draw a marker and a solid line which goes from the bottom to the
+        // marker (similar to Matlab stem() function)
+        GraphPainter.setPen ( MarkerPen );
+        GraphPainter.drawPoint ( curPoint );
+
+        GraphPainter.setPen ( StemPen );
+        GraphPainter.drawLine ( QPoint ( curPoint.x(),
+                                         GraphGridFrame.y() +
+                                         GraphGridFrame.height() ),
+                                curPoint );
+    }
+}
+
+int CErrRateGraph::CalcYPosInGraph ( const double dValue ) const
+{
+    // calculate value range
+    const double dValRange = dMax - dMin;
+
+    // calculate current normalized y-axis value
+    const double dYValNorm = ( dValue - dMin ) / dValRange;
+
+    // consider the graph grid size to calculate the final y-axis value
+    return GraphGridFrame.y() + static_cast<int> (
+        static_cast<double> ( GraphGridFrame.height() ) * ( 1 - dYValNorm ) );
+}
+
+
 // Analyzer console implementation *********************************************
 CAnalyzerConsole::CAnalyzerConsole ( CClient* pNCliP,
                                      QWidget* parent,
                                      Qt::WindowFlags ) :
     QDialog                ( parent ),
-    pClient                ( pNCliP ),
-    GraphImage             ( 1, 1, QImage::Format_RGB32 ),
-    GraphErrRateCanvasRect ( 0, 0, 600, 450 ), // defines total size of graph
-    iGridFrameOffset       ( 10 ),
-    iLineWidth             ( 2 ),
-    iMarkerSize            ( 10 ),
-    iXAxisTextHeight       ( 22 ),
-    GraphBackgroundColor   ( Qt::white ), // background
-    GraphFrameColor        ( Qt::black ), // frame
-    GraphGridColor         ( Qt::gray ), // grid
-    LineColor              ( Qt::blue ),
-    LineLimitColor         ( Qt::green ),
-    LineMaxUpLimitColor    ( Qt::red )
+    pClient                ( pNCliP )
 {
     // set the window icon and title text
     const QIcon icon = QIcon ( QString::fromUtf8 ( ":/png/main/res/fronticon.png" ) );
@@ -62,17 +225,43 @@ CAnalyzerConsole::CAnalyzerConsole ( CClient* pNCliP,
     pTabWidgetBufErrRate = new QWidget();
     QVBoxLayout* pTabErrRateLayout = new QVBoxLayout ( pTabWidgetBufErrRate );
 
-    pGraphErrRate = new QLabel ( this );
+    pGraphErrRate = new CErrRateGraph ( this );
     pTabErrRateLayout->addWidget ( pGraphErrRate );
 
     pMainTabWidget->addTab ( pTabWidgetBufErrRate,
                              tr ( "Error Rate of Each Buffer Size" ) );
 
+    // network statistics tab
+    pTabWidgetNetStats = new QWidget();
+    QVBoxLayout* pTabNetStatsLayout = new QVBoxLayout ( pTabWidgetNetStats );
+
+    pLabelNetStats = new QLabel ( this );
+    pLabelNetStats->setAlignment ( Qt::AlignLeft | Qt::AlignTop );
+    pTabNetStatsLayout->addWidget ( pLabelNetStats );
+
+    pMainTabWidget->addTab ( pTabWidgetNetStats,
+                             tr ( "Network Statistics" ) );
+
+    // sound card timing tab
+    pTabWidgetSndCrdTiming = new QWidget();
+    QVBoxLayout* pTabSndCrdTimingLayout = new QVBoxLayout ( pTabWidgetSndCrdTiming );
+
+    pLabelSndCrdTiming = new QLabel ( this );
+    pLabelSndCrdTiming->setAlignment ( Qt::AlignLeft | Qt::AlignTop );
+    pTabSndCrdTimingLayout->addWidget ( pLabelSndCrdTiming );
+
+    pMainTabWidget->addTab ( pTabWidgetSndCrdTiming,
+                             tr ( "Sound Card Timing" ) );
+
 
     // Connections -------------------------------------------------------------
     // timers
     QObject::connect ( &TimerErrRateUpdate, &QTimer::timeout,
         this, &CAnalyzerConsole::OnTimerErrRateUpdate );
+
+    // show the current values right away if the tab is changed
+    QObject::connect ( pMainTabWidget, &QTabWidget::currentChanged,
+        this, &CAnalyzerConsole::OnTimerErrRateUpdate );
 }
 
 void CAnalyzerConsole::showEvent ( QShowEvent* )
@@ -89,135 +278,124 @@ void CAnalyzerConsole::hideEvent ( QHideEvent* )
 
 void CAnalyzerConsole::OnTimerErrRateUpdate()
 {
-    // generate current graph image
-    DrawFrame();
-    DrawErrorRateTrace();
+    // only the visible tab is updated
+    QWidget* pCurTab = pMainTabWidget->currentWidget();
 
-    // set new image to the label
-    pGraphErrRate->setPixmap ( QPixmap().fromImage ( GraphImage ) );
-}
-
-void CAnalyzerConsole::DrawFrame()
-{
-    // scale image to correct size
-    GraphImage = GraphImage.scaled (
-        GraphErrRateCanvasRect.width(), GraphErrRateCanvasRect.height() );
-
-    // generate plot grid frame rectangle
-    GraphGridFrame.setRect ( GraphErrRateCanvasRect.x() + iGridFrameOffset,
-        GraphErrRateCanvasRect.y() + iGridFrameOffset,
-        GraphErrRateCanvasRect.width() - 2 * iGridFrameOffset,
-        GraphErrRateCanvasRect.height() - 2 * iGridFrameOffset - iXAxisTextHeight );
-
-    GraphImage.fill ( GraphBackgroundColor.rgb() ); // fill background
-
-    // create painter
-    QPainter GraphPainter ( &GraphImage );
-
-    // create actual plot region (grid frame)
-    GraphPainter.setPen ( GraphFrameColor );
-    GraphPainter.drawRect ( GraphGridFrame );
+    if ( pCurTab == pTabWidgetBufErrRate )
+    {
+        UpdateErrorRates();
+    }
+    else if ( pCurTab == pTabWidgetNetStats )
+    {
+        UpdateNetStats();
+    }
+    else if ( pCurTab == pTabWidgetSndCrdTiming )
+    {
+        UpdateSndCrdTiming();
+    }
 }
 
-void CAnalyzerConsole::DrawErrorRateTrace()
+void CAnalyzerConsole::UpdateErrorRates()
 {
-    // create painter
-    QPainter GraphPainter ( &GraphImage );
-
     // get the network buffer error rates to be displayed
-    CVector<double> vecButErrorRates;
+    CVector<double> vecErrorRates;
     double          dLimit;
     double          dMaxUpLimit;
 
-    pClient->GetBufErrorRates ( vecButErrorRates, dLimit, dMaxUpLimit );
-
-    // get the number of data elements
-    const int iNumBuffers = vecButErrorRates.Size();
+    pClient->GetBufErrorRates ( vecErrorRates, dLimit, dMaxUpLimit );
 
-    // convert the limits in the log domain
-    const double dLogLimit      = log10 ( dLimit );
-    const double dLogMaxUpLimit = log10 ( dMaxUpLimit );
-
-    // use fixed y-axis scale where the limit line is in the middle of the graph
-    const double dMax = 0;
-    const double dMin = dLogLimit * 2;
-
-    // calculate space between points on the x-axis
-    const double dXSpace =
-        static_cast<double> ( GraphGridFrame.width() ) / ( iNumBuffers - 1 );
-
-    // plot the limit line as dashed line
-    const double dYValLimitInGraph = CalcYPosInGraph ( dMin, dMax, dLogLimit );
+    pGraphErrRate->SetErrorRates ( vecErrorRates, dLimit, dMaxUpLimit );
+}
 
-    GraphPainter.setPen ( QPen ( QBrush ( LineLimitColor ),
-                                 iLineWidth,
-                                 Qt::DashLine ) );
+void CAnalyzerConsole::UpdateNetStats()
+{
+    CChannelNetStats NetStats;
+
+    pClient->GetNetStats ( NetStats );
+
+    // the lost frames are relative to all frames the decoder has processed
+    const int iNumFrames  = NetStats.iNumReceived + NetStats.iNumLost;
+    const double dLossPct = ( iNumFrames > 0 ) ?
+        100.0 * NetStats.iNumLost / iNumFrames : 0.0;
+
+    pLabelNetStats->setText (
+        tr ( "Received packets" ) + ": " + QString::number ( NetStats.iNumReceived ) + "\n" +
+        tr ( "Received bytes" ) + ": " + QString::number ( NetStats.iNumBytes ) + "\n" +
+        tr ( "Lost packets" ) + ": " + QString::number ( NetStats.iNumLost ) +
+            " (" + QString::number ( dLossPct, 'f', 2 ) + " %)\n" +
+        tr ( "Jitter buffer overruns" ) + ": " + QString::number ( NetStats.iNumOverruns ) + "\n" +
+        tr ( "Jitter buffer underruns" ) + ": " + QString::number ( NetStats.iNumUnderruns ) + "\n" +
+        tr ( "Late frames" ) + ": " + QString::number ( NetStats.iNumLate ) + "\n" +
+        tr ( "Packet jitter" ) + ": " + QString::number ( NetStats.iJitterUs / 1000.0, 'f', 2 ) + " ms" );
+}
 
-    GraphPainter.drawLine ( QPoint ( GraphGridFrame.x(), dYValLimitInGraph ),
-                            QPoint ( GraphGridFrame.x() +
-                                     GraphGridFrame.width(), dYValLimitInGraph ) );
+void CAnalyzerConsole::UpdateSndCrdTiming()
+{
+    CSndCrdTimingStats TimingStats;
 
-    // plot the maximum upper limit line as a dashed line
-    const double dYValMaxUpLimitInGraph = CalcYPosInGraph ( dMin, dMax, dLogMaxUpLimit );
+    pClient->GetSndCrdTimingStats ( TimingStats );
 
-    GraphPainter.setPen ( QPen ( QBrush ( LineMaxUpLimitColor ),
-                                 iLineWidth,
-                                 Qt::DashLine ) );
+    QString strHist;
+    int     iNumIntervals = 0;
 
-    GraphPainter.drawLine ( QPoint ( GraphGridFrame.x(), dYValMaxUpLimitInGraph ),
-                            QPoint ( GraphGridFrame.x() +
-                                     GraphGridFrame.width(), dYValMaxUpLimitInGraph ) );
+    for ( int i = 0; i < SND_CRD_TIMING_NUM_HIST_BINS; i++ )
+    {
+        iNumIntervals += TimingStats.veciIntervalHist[i];
+    }
 
-    // plot the data
-    for ( int i = 0; i < iNumBuffers; i++ )
+    // the bins are centred at multiples of half a period
+    for ( int i = 0; i < SND_CRD_TIMING_NUM_HIST_BINS; i++ )
     {
-        // data convert in log domain
-        // check for special case if error rate is 0 (which would lead to -Inf
-        // after the log operation)
-        if ( vecButErrorRates[i] > 0 )
+        QString strBin;
+
+        if ( i == 0 )
+        {
+            strBin = "< 0.25";
+        }
+        else if ( i == SND_CRD_TIMING_NUM_HIST_BINS - 1 )
         {
-            vecButErrorRates[i] = log10 ( vecButErrorRates[i] );
+            strBin = "> " + QString::number ( i * 0.5 - 0.25, 'f', 2 );
         }
         else
         {
-            // definition: set it to lowest possible axis value
-            vecButErrorRates[i] = dMin;
+            strBin = QString::number ( i * 0.5, 'f', 1 );
         }
 
-        // calculate the actual point in the graph (in pixels)
-        const QPoint curPoint (
-            GraphGridFrame.x() + static_cast<int> ( dXSpace * i ),
-            CalcYPosInGraph ( dMin, dMax, vecButErrorRates[i] ) );
-
-        // draw a marker and a solid line which goes from the bottom to the
-        // marker (similar to Matlab stem() function)
-        GraphPainter.setPen ( QPen ( QBrush ( LineColor ),
-                                     iMarkerSize,
-                                     Qt::SolidLine,
-                                     Qt::RoundCap ) );
-
-        GraphPainter.drawPoint ( curPoint );
-
-        GraphPainter.setPen ( QPen ( QBrush ( LineColor ), iLineWidth ) );
+        const double dPct = ( iNumIntervals > 0 ) ?
+            100.0 * TimingStats.veciIntervalHist[i] / iNumIntervals : 0.0;
 
-        GraphPainter.drawLine ( QPoint ( curPoint.x(),
-                                         GraphGridFrame.y() +
-                                         GraphGridFrame.height() ),
-                                curPoint );
+        strHist += "\n    " + strBin + ": " + QString::number ( TimingStats.veciIntervalHist[i] ) +
+            " (" + QString::number ( dPct, 'f', 2 ) + " %)";
     }
+
+    pLabelSndCrdTiming->setText (
+        tr ( "Callbacks" ) + ": " + QString::number ( TimingStats.iNumCallbacks ) + "\n" +
+        tr ( "Period" ) + ": " + QString::number ( TimingStats.iPeriodUs / 1000.0, 'f', 2 ) + " ms\n" +
+        tr ( "Processing time (average)" ) + ": " + QString::number ( TimingStats.iAvProcTimeUs / 1000.0, 'f', 2 ) + " ms\n" +
+        tr ( "Processing time (maximum)" ) + ": " + QString::number ( TimingStats.iMaxProcTimeUs / 1000.0, 'f', 2 ) + " ms\n" +
+        tr ( "Overruns (processing longer than the period)" ) + ": " + QString::number ( TimingStats.iNumOverruns ) + "\n" +
+        tr ( "Maximum callback interval" ) + ": " + QString::number ( TimingStats.iMaxIntervalUs / 1000.0, 'f', 2 ) + " ms\n" +
+        tr ( "Callback intervals (in periods)" ) + ":" + strHist + "\n" +
+        GetDspLoadText() );
 }
 
-int CAnalyzerConsole::CalcYPosInGraph ( const double dAxisMin,
-                                        const double dAxisMax,
-                                        const double dValue ) const
+QString CAnalyzerConsole::GetDspLoadText() const
 {
-    // calculate value range
-    const double dValRange = dAxisMax - dAxisMin;
+    const CClientDspLoad& DspLoad = pClient->GetDspLoad();
 
-    // calculate current normalized y-axis value
-    const double dYValNorm = ( dValue - dAxisMin ) / dValRange;
+    QString strText =
+        tr ( "DSP load" ) + ": " + QString::number ( DspLoad.GetLoad(), 'f', 1 ) + " %\n" +
+        tr ( "DSP load (peak)" ) + ": " + QString::number ( DspLoad.GetPeak(), 'f', 1 ) + " %\n" +
+        tr ( "DSP load (maximum peak)" ) + ": " + QString::number ( DspLoad.GetMaxPeak(), 'f', 1 ) + " %\n" +
+        tr ( "DSP load of the stages" ) + ":";
 
-    // consider the graph grid size to calculate the final y-axis value
-    return GraphGridFrame.y() + static_cast<int> (
-        static_cast<double> ( GraphGridFrame.height() ) * ( 1 - dYValNorm ) );
+    for ( int i = 0; i < NUM_CLIENT_DSP_STAGES; i++ )
+    {
+        const EClientDspStage eStage = static_cast<EClientDspStage> ( i );
+
+        strText += "\n    " + CClientDspLoad::GetStageName ( eStage ) + ": " +
+            QString::number ( DspLoad.GetStageLoad ( eStage ), 'f', 1 ) + " %";
+    }
+
+    return strText;
 }
@@ -28,7 +28,7 @@
 #include <QTabWidget>
 #include <QLabel>
 #include <QVBoxLayout>
-#include <QImage>
+#include <QPixmap>
 #include <QPainter>
 #include <QTimer>
 #include "client.h"
@@ -40,6 +40,55 @@
 
 
 /* Classes ********************************************************************/
+// Graph of the error rate of each simulated jitter buffer size. The static
+// layer (background, frame and limit lines) is rendered once in a pixmap and
+// is only rendered again if the size of the widget or the limits change, an
+// update only paints the cached layer and the traces.
+class CErrRateGraph : public QWidget
+{
+    Q_OBJECT
+
+public:
+    CErrRateGraph ( QWidget* parent = nullptr );
+
+    void SetErrorRates ( const CVector<double>& vecdNewErrRates,
+                         const double           dNewLimit,
+                         const double           dNewMaxUpLimit );
+
+    virtual QSize sizeHint() const { return QSize ( 600, 450 ); }
+
+protected:
+    virtual void resizeEvent ( QResizeEvent* );
+    virtual void paintEvent ( QPaintEvent* );
+
+    void DrawStaticLayer();
+    int  CalcYPosInGraph ( const double dValue ) const;
+
+    CVector<double> vecdErrRates;
+    double          dLimit;
+    double          dMaxUpLimit;
+
+    // y-axis range in the log domain, the limit line is in the middle
+    double          dMin;
+    double          dMax;
+
+    QPixmap         StaticLayer;
+    bool            bStaticLayerValid;
+    QRect           GraphGridFrame;
+
+    int             iGridFrameOffset;
+    int             iLineWidth;
+    int             iMarkerSize;
+    int             iXAxisTextHeight;
+
+    QColor          GraphBackgroundColor;
+    QColor          GraphFrameColor;
+    QColor          LineColor;
+    QColor          LineLimitColor;
+    QColor          LineMaxUpLimitColor;
+};
+
+
 class CAnalyzerConsole : public QDialog
 {
     Q_OBJECT
@@ -54,36 +103,24 @@ protected:
     virtual void showEvent ( QShowEvent* );
     virtual void hideEvent ( QHideEvent* );
 
-    void DrawFrame();
-    void DrawErrorRateTrace();
-    int  CalcYPosInGraph ( const double dAxisMin,
-                           const double dAxisMax,
-                           const double dValue ) const;
-
-    CClient*    pClient;
-
-    QTabWidget* pMainTabWidget;
-    QWidget*    pTabWidgetBufErrRate;
+    void UpdateErrorRates();
+    void UpdateNetStats();
+    void UpdateSndCrdTiming();
+    QString GetDspLoadText() const;
 
-    QLabel*     pGraphErrRate;
-    QImage      GraphImage;
+    CClient*       pClient;
 
-    QRect       GraphErrRateCanvasRect;
-    QRect       GraphGridFrame;
+    QTabWidget*    pMainTabWidget;
+    QWidget*       pTabWidgetBufErrRate;
 
-    int         iGridFrameOffset;
-    int         iLineWidth;
-    int         iMarkerSize;
-    int         iXAxisTextHeight;
+    QWidget*       pTabWidgetNetStats;
+    QWidget*       pTabWidgetSndCrdTiming;
 
-    QColor      GraphBackgroundColor;
-    QColor      GraphFrameColor;
-    QColor      GraphGridColor;
-    QColor      LineColor;
-    QColor      LineLimitColor;
-    QColor      LineMaxUpLimitColor;
+    CErrRateGraph* pGraphErrRate;
+    QLabel*        pLabelNetStats;
+    QLabel*        pLabelSndCrdTiming;
 
-    QTimer      TimerErrRateUpdate;
+    QTimer         TimerErrRateUpdate;
 
 
 public slots:
@@ -468,6 +468,20 @@ void CChannelFader::UpdateSoloState ( const bool bNewOtherSoloState )
     }
 }
 
+void CChannelFader::SetIsMixGroupFader ( const int iMixGroup )
+{
+    // a mix group fader only has a gain and a mute, the label shows the
+    // number of the mix group
+    pcbSolo->setVisible  ( false );
+    pcbGroup->setVisible ( false );
+    SetDisplayPans ( false );
+    SetDisplayChannelLevel ( false );
+
+    plblLabel->setText ( tr ( "Group %1" ).arg ( iMixGroup ) );
+    plblLabel->setToolTip ( tr ( "Sets the level of all channels of the mix "
+        "group %1 in your mix (in addition to the channel faders)" ).arg ( iMixGroup ) );
+}
+
 void CChannelFader::SetChannelLevel ( const uint16_t iLevel )
 {
     plbrChannelLevel->setValue ( iLevel );
@@ -498,13 +512,12 @@ void CChannelFader::SetChannelInfos ( const CChannelInfo& cChanInfo )
 
 
     // Instrument picture ------------------------------------------------------
-    // get the resource reference string for this instrument
-    const QString strCurResourceRef =
-        CInstPictures::GetResourceReference ( cChanInfo.iInstrument );
+    // the pictures are taken from the process wide cache (decoded only once)
+    const int     iDevicePixelRatio = CPixmapCache::GetDevicePixelRatio ( plblInstrument );
+    const QPixmap InstrumentPixmap  = CPixmapCache::GetInstrumentPixmap ( cChanInfo.iInstrument, iDevicePixelRatio );
 
     // first check if instrument picture is used or not and if it is valid
-    if ( CInstPictures::IsNotUsedInstrument ( cChanInfo.iInstrument ) ||
-         strCurResourceRef.isEmpty() )
+    if ( InstrumentPixmap.isNull() )
     {
         // disable instrument picture
         plblInstrument->setVisible ( false );
@@ -512,7 +525,7 @@ void CChannelFader::SetChannelInfos ( const CChannelInfo& cChanInfo )
     else
     {
         // set correct picture
-        plblInstrument->setPixmap ( QPixmap ( strCurResourceRef ) );
+        plblInstrument->setPixmap ( InstrumentPixmap );
         iTTInstrument = cChanInfo.iInstrument;
 
         // enable instrument picture
@@ -524,7 +537,7 @@ void CChannelFader::SetChannelInfos ( const CChannelInfo& cChanInfo )
     if ( cChanInfo.eCountry != QLocale::AnyCountry )
     {
         // try to load the country flag icon
-        QPixmap CountryFlagPixmap ( CLocale::GetCountryFlagIconsResourceReference ( cChanInfo.eCountry ) );
+        const QPixmap CountryFlagPixmap = CPixmapCache::GetCountryFlagPixmap ( cChanInfo.eCountry, iDevicePixelRatio );
 
         // first check if resource reference was valid
         if ( CountryFlagPixmap.isNull() )
@@ -645,19 +658,19 @@ double CChannelFader::CalcFaderGain ( const int value )
 * CAudioMixerBoard                                                             *
 \******************************************************************************/
 CAudioMixerBoard::CAudioMixerBoard ( QWidget* parent, Qt::WindowFlags ) :
-    QGroupBox            ( parent ),
-    vecStoredFaderTags   ( MAX_NUM_STORED_FADER_SETTINGS, "" ),
-    vecStoredFaderLevels ( MAX_NUM_STORED_FADER_SETTINGS, AUD_MIX_FADER_MAX ),
-    vecStoredPanValues   ( MAX_NUM_STORED_FADER_SETTINGS, AUD_MIX_PAN_MAX / 2 ),
-    vecStoredFaderIsSolo ( MAX_NUM_STORED_FADER_SETTINGS, false ),
-    vecStoredFaderIsMute ( MAX_NUM_STORED_FADER_SETTINGS, false ),
-    iNewClientFaderLevel ( 100 ),
-    bDisplayPans         ( false ),
-    bIsPanSupported      ( false ),
-    bNoFaderVisible      ( true ),
-    iMyChannelID         ( INVALID_INDEX ),
-    strServerName        ( "" ),
-    eRecorderState       ( RS_UNDEFINED )
+    QGroupBox                ( parent ),
+    iNewClientFaderLevel     ( 100 ),
+    eGUIDesign               ( GD_STANDARD ),
+    bDisplayChannelLevels    ( false ),
+    bDisplayPans             ( false ),
+    bIsPanSupported          ( false ),
+    bNoFaderVisible          ( true ),
+    iMyChannelID             ( INVALID_INDEX ),
+    strServerName            ( "" ),
+    eRecorderState           ( RS_UNDEFINED ),
+    vecpMixGroupFader        ( MAX_NUM_MIX_GROUPS + 1, nullptr ),
+    vecPendingChannelLevels  ( MAX_NUM_CHANNELS, 0 ),
+    iNumPendingChannelLevels ( 0 )
 {
     // add group box and hboxlayout
     QHBoxLayout* pGroupBoxLayout = new QHBoxLayout ( this );
@@ -674,19 +687,8 @@ CAudioMixerBoard::CAudioMixerBoard ( QWidget* parent, Qt::WindowFlags ) :
     // set title text (default: no server given)
     SetServerName ( "" );
 
-    // create all mixer controls and make them invisible
-    vecpChanFader.Init ( MAX_NUM_CHANNELS );
-
-    for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
-    {
-        vecpChanFader[i] = new CChannelFader ( this );
-        vecpChanFader[i]->Hide();
-
-        // add fader frame to audio mixer board layout
-        pMainLayout->addWidget ( vecpChanFader[i]->GetMainWidget() );
-    }
-
-    // insert horizontal spacer
+    // insert horizontal spacer (the mixer controls are created on demand and
+    // inserted in front of the spacer)
     pMainLayout->addItem ( new QSpacerItem ( 0, 0, QSizePolicy::Expanding ) );
 
     // set margins of the layout to zero to get maximum space for the controls
@@ -700,36 +702,47 @@ CAudioMixerBoard::CAudioMixerBoard ( QWidget* parent, Qt::WindowFlags ) :
     pGroupBoxLayout->addWidget ( pScrollArea );
 
 
+    // the timer is started by the first level update after a display update
+    TimerChannelLevels.setSingleShot ( true );
+    TimerChannelLevels.setInterval ( LEVEL_DISPLAY_UPDATE_TIME_MS );
+
+
     // Connections -------------------------------------------------------------
-    connectFaderSignalsToMixerBoardSlots<MAX_NUM_CHANNELS>();
+    QObject::connect ( &TimerChannelLevels, &QTimer::timeout,
+        this, &CAudioMixerBoard::OnTimerChannelLevels );
 }
 
-template<unsigned int slotId>
-inline void CAudioMixerBoard::connectFaderSignalsToMixerBoardSlots()
+void CAudioMixerBoard::CreateFaders ( const int iNewNumFaders )
 {
-    int iCurChanID = slotId - 1;
+    for ( int i = vecpChanFader.Size(); i < iNewNumFaders; i++ )
+    {
+        CChannelFader* pChanFader = new CChannelFader ( this );
+        pChanFader->Hide();
 
-    void ( CAudioMixerBoard::* pGainValueChanged )( double, bool, bool, int ) =
-        &CAudioMixerBoardSlots<slotId>::OnChGainValueChanged;
+        // apply the current settings of the mixer board
+        pChanFader->SetGUIDesign ( eGUIDesign );
+        pChanFader->SetDisplayChannelLevel ( false );
+        pChanFader->SetDisplayPans ( bDisplayPans && bIsPanSupported );
 
-    void ( CAudioMixerBoard::* pPanValueChanged )( double ) =
-        &CAudioMixerBoardSlots<slotId>::OnChPanValueChanged;
+        // add fader frame to audio mixer board layout (behind the other channel
+        // faders, the mix group faders and the spacer follow)
+        pMainLayout->insertWidget ( i, pChanFader->GetMainWidget() );
 
-    QObject::connect ( vecpChanFader[iCurChanID], &CChannelFader::soloStateChanged,
-        this, &CAudioMixerBoard::UpdateSoloStates );
+        vecpChanFader.Add ( pChanFader );
 
-    QObject::connect ( vecpChanFader[iCurChanID], &CChannelFader::gainValueChanged,
-        this, pGainValueChanged );
+        // the channel index is bound into the handlers of the fader signals
+        QObject::connect ( pChanFader, &CChannelFader::soloStateChanged,
+            this, &CAudioMixerBoard::UpdateSoloStates );
 
-    QObject::connect ( vecpChanFader[iCurChanID], &CChannelFader::panValueChanged,
-        this, pPanValueChanged );
+        QObject::connect ( pChanFader, &CChannelFader::gainValueChanged,
+            this, [this, i] ( double dValue, bool bIsMyOwnFader, bool bIsGroupUpdate, int iDiffLevel )
+            { UpdateGainValue ( i, dValue, bIsMyOwnFader, bIsGroupUpdate, iDiffLevel ); } );
 
-    connectFaderSignalsToMixerBoardSlots<slotId - 1>();
+        QObject::connect ( pChanFader, &CChannelFader::panValueChanged,
+            this, [this, i] ( double dValue ) { UpdatePanValue ( i, dValue ); } );
+    }
 }
 
-template<>
-inline void CAudioMixerBoard::connectFaderSignalsToMixerBoardSlots<0>() {}
-
 void CAudioMixerBoard::SetServerName ( const QString& strNewServerName )
 {
     // store the current server name
@@ -763,11 +776,21 @@ void CAudioMixerBoard::SetGUIDesign ( const EGUIDesign eNewDesign )
         pMainLayout->setSpacing ( 6 ); // Qt default spacing value
     }
 
+    eGUIDesign = eNewDesign;
+
     // apply GUI design to child GUI controls
-    for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+    for ( int i = 0; i < vecpChanFader.Size(); i++ )
     {
         vecpChanFader[i]->SetGUIDesign ( eNewDesign );
     }
+
+    for ( int i = 0; i < vecpMixGroupFader.Size(); i++ )
+    {
+        if ( vecpMixGroupFader[i] != nullptr )
+        {
+            vecpMixGroupFader[i]->SetGUIDesign ( eNewDesign );
+        }
+    }
 }
 
 void CAudioMixerBoard::SetDisplayChannelLevels ( const bool eNDCL )
@@ -779,7 +802,7 @@ void CAudioMixerBoard::SetDisplayChannelLevels ( const bool eNDCL )
     if ( !bDisplayChannelLevels )
     {
         // hide all level meters
-        for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+        for ( int i = 0; i < vecpChanFader.Size(); i++ )
         {
             vecpChanFader[i]->SetDisplayChannelLevel ( false );
         }
@@ -790,7 +813,7 @@ void CAudioMixerBoard::SetDisplayPans ( const bool eNDP )
 {
     bDisplayPans = eNDP;
 
-    for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+    for ( int i = 0; i < vecpChanFader.Size(); i++ )
     {
         vecpChanFader[i]->SetDisplayPans ( eNDP && bIsPanSupported );
     }
@@ -804,8 +827,12 @@ void CAudioMixerBoard::SetPanIsSupported()
 
 void CAudioMixerBoard::HideAll()
 {
+    // drop the levels which are not yet displayed
+    TimerChannelLevels.stop();
+    iNumPendingChannelLevels = 0;
+
     // make all controls invisible
-    for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+    for ( int i = 0; i < vecpChanFader.Size(); i++ )
     {
         // before hiding the fader, store its level (if some conditions are fullfilled)
         StoreFaderSettings ( vecpChanFader[i] );
@@ -816,6 +843,20 @@ void CAudioMixerBoard::HideAll()
         vecpChanFader[i]->Hide();
     }
 
+    // the mix group gains are reset by the server on a new connection, i.e.
+    // the reset of the faders is not sent to the server
+    for ( int i = 0; i < vecpMixGroupFader.Size(); i++ )
+    {
+        if ( vecpMixGroupFader[i] != nullptr )
+        {
+            vecpMixGroupFader[i]->Hide();
+            vecpMixGroupFader[i]->blockSignals ( true );
+            vecpMixGroupFader[i]->Reset();
+            vecpMixGroupFader[i]->blockSignals ( false );
+            vecpMixGroupFader[i]->SetIsMixGroupFader ( i );
+        }
+    }
+
     // set flags
     bIsPanSupported = false;
     bNoFaderVisible = true;
@@ -835,7 +876,7 @@ void CAudioMixerBoard::ChangeFaderOrder ( const bool        bDoSort,
     // create a pair list of lower strings and fader ID for each channel
     QList<QPair<QString, int> > PairList;
 
-    for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+    for ( int i = 0; i < vecpChanFader.Size(); i++ )
     {
         if ( eChSortType == ST_BY_NAME )
         {
@@ -853,12 +894,18 @@ void CAudioMixerBoard::ChangeFaderOrder ( const bool        bDoSort,
         qStableSort ( PairList.begin(), PairList.end() );
     }
 
-    // add channels to the layout in the new order (since we insert on the left, we
-    // have to use a backwards counting loop), note that it is not required to remove
-    // the widget from the layout first but it is moved to the new position automatically
-    for ( int i = MAX_NUM_CHANNELS - 1; i >= 0; i-- )
+    // add channels to the layout in the new order, note that it is not required
+    // to remove the widget from the layout first but it is moved to the new
+    // position automatically (only faders which are not yet at their new position
+    // are moved so that an unchanged order does not invalidate the layout)
+    for ( int i = 0; i < vecpChanFader.Size(); i++ )
     {
-        pMainLayout->insertWidget ( 0, vecpChanFader[PairList[i].second]->GetMainWidget() );
+        QWidget* pFaderWidget = vecpChanFader[PairList[i].second]->GetMainWidget();
+
+        if ( pMainLayout->indexOf ( pFaderWidget ) != i )
+        {
+            pMainLayout->insertWidget ( i, pFaderWidget );
+        }
     }
 }
 
@@ -881,6 +928,49 @@ void CAudioMixerBoard::SetRecorderState ( const ERecorderState newRecorderState
     UpdateTitle();
 }
 
+void CAudioMixerBoard::SetMixGroups ( const CVector<int>& vecMixGroups )
+{
+    CVector<int> vecMixGroupUsed ( MAX_NUM_MIX_GROUPS + 1, 0 );
+
+    for ( int i = 0; i < vecMixGroups.Size(); i++ )
+    {
+        if ( ( vecMixGroups[i] > NO_MIX_GROUP ) && ( vecMixGroups[i] <= MAX_NUM_MIX_GROUPS ) )
+        {
+            vecMixGroupUsed[vecMixGroups[i]] = 1;
+        }
+    }
+
+    for ( int iG = NO_MIX_GROUP + 1; iG <= MAX_NUM_MIX_GROUPS; iG++ )
+    {
+        if ( vecMixGroupUsed[iG] != 0 )
+        {
+            // the fader of a mix group is created on demand and placed behind
+            // the channel faders (in front of the spacer)
+            if ( vecpMixGroupFader[iG] == nullptr )
+            {
+                CChannelFader* pGroupFader = new CChannelFader ( this );
+
+                pGroupFader->SetGUIDesign ( eGUIDesign );
+                pGroupFader->SetIsMixGroupFader ( iG );
+
+                pMainLayout->insertWidget ( pMainLayout->count() - 1, pGroupFader->GetMainWidget() );
+
+                vecpMixGroupFader[iG] = pGroupFader;
+
+                QObject::connect ( pGroupFader, &CChannelFader::gainValueChanged,
+                    this, [this, iG] ( double dValue, bool, bool, int ) { emit ChangeMixGroupGain ( iG, dValue ); } );
+            }
+
+            vecpMixGroupFader[iG]->Show();
+        }
+        else if ( vecpMixGroupFader[iG] != nullptr )
+        {
+            // the gain of an empty mix group is kept by the server
+            vecpMixGroupFader[iG]->Hide();
+        }
+    }
+}
+
 void CAudioMixerBoard::ApplyNewConClientList ( CVector<CChannelInfo>& vecChanInfo )
 {
     // we want to set the server name only if the very first faders appear
@@ -893,82 +983,106 @@ void CAudioMixerBoard::ApplyNewConClientList ( CVector<CChannelInfo>& vecChanInf
     // get number of connected clients
     const int iNumConnectedClients = vecChanInfo.Size();
 
+    // index in the received list for each channel ID (the list is keyed by
+    // the channel ID, INVALID_INDEX if the channel is not connected)
+    CVector<int> vecChanInfoIdx ( MAX_NUM_CHANNELS, INVALID_INDEX );
+    int          iNumRequiredFaders = 0;
+
+    for ( int j = 0; j < iNumConnectedClients; j++ )
+    {
+        if ( ( vecChanInfo[j].iChanID >= 0 ) && ( vecChanInfo[j].iChanID < MAX_NUM_CHANNELS ) )
+        {
+            vecChanInfoIdx[vecChanInfo[j].iChanID] = j;
+            iNumRequiredFaders = std::max ( iNumRequiredFaders, vecChanInfo[j].iChanID + 1 );
+        }
+    }
+
+    CreateFaders ( iNumRequiredFaders );
+
+    // only the faders which were added, removed or changed are touched
+    bool bFadersChanged = false;
+
     // search for channels with are already present and preserve their gain
     // setting, for all other channels reset gain
-    for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+    for ( int i = 0; i < vecpChanFader.Size(); i++ )
     {
-        bool bFaderIsUsed = false;
+        const int j = vecChanInfoIdx[i];
 
-        for ( int j = 0; j < iNumConnectedClients; j++ )
+        // check if current fader is used
+        if ( j != INVALID_INDEX )
         {
-            // check if current fader is used
-            if ( vecChanInfo[j].iChanID == i )
+            // an already shown fader with unchanged channel infos stays as it is
+            if ( vecpChanFader[i]->IsVisible() &&
+                 !( vecChanInfo[j] != vecpChanFader[i]->GetReceivedChanInfo() ) )
             {
-                // check if fader was already in use -> preserve gain value
-                if ( !vecpChanFader[i]->IsVisible() )
+                continue;
+            }
+
+            bFadersChanged = true;
+
+            // check if fader was already in use -> preserve gain value
+            if ( !vecpChanFader[i]->IsVisible() )
+            {
+                // the fader was not in use, reset everything for new client
+                vecpChanFader[i]->Reset();
+
+                // check if this is my own fader and set fader property
+                if ( i == iMyChannelID )
                 {
-                    // the fader was not in use, reset everything for new client
-                    vecpChanFader[i]->Reset();
-
-                    // check if this is my own fader and set fader property
-                    if ( i == iMyChannelID )
-                    {
-                        vecpChanFader[i]->SetIsMyOwnFader();
-                    }
-
-                    // show fader
-                    vecpChanFader[i]->Show();
-
-                    // Set the default initial fader level. Check first that
-                    // this is not the initialization (i.e. previously there
-                    // were no faders visible) to avoid that our own level is
-                    // adjusted. If we have received our own channel ID, then
-                    // we can adjust the level even if no fader was visible.
-                    // The fader level of 100 % is the default in the
-                    // server, in that case we do not have to do anything here.
-                    if ( ( !bNoFaderVisible ||
-                           ( ( iMyChannelID != INVALID_INDEX ) && ( iMyChannelID != i ) ) ) &&
-                         ( iNewClientFaderLevel != 100 ) )
-                    {
-                        // the value is in percent -> convert range
-                        vecpChanFader[i]->SetFaderLevel ( static_cast<int> (
-                            iNewClientFaderLevel / 100.0 * AUD_MIX_FADER_MAX ) );
-                    }
+                    vecpChanFader[i]->SetIsMyOwnFader();
                 }
 
-                // restore gain (if new name is different from the current one)
-                if ( vecpChanFader[i]->GetReceivedName().compare ( vecChanInfo[j].strName ) )
+                // show fader
+                vecpChanFader[i]->Show();
+
+                // Set the default initial fader level. Check first that
+                // this is not the initialization (i.e. previously there
+                // were no faders visible) to avoid that our own level is
+                // adjusted. If we have received our own channel ID, then
+                // we can adjust the level even if no fader was visible.
+                // The fader level of 100 % is the default in the
+                // server, in that case we do not have to do anything here.
+                if ( ( !bNoFaderVisible ||
+                       ( ( iMyChannelID != INVALID_INDEX ) && ( iMyChannelID != i ) ) ) &&
+                     ( iNewClientFaderLevel != 100 ) )
                 {
-                    // the text has actually changed, search in the list of
-                    // stored settings if we have a matching entry
-                    int  iStoredFaderLevel;
-                    int  iStoredPanValue;
-                    bool bStoredFaderIsSolo;
-                    bool bStoredFaderIsMute;
-
-                    if ( GetStoredFaderSettings ( vecChanInfo[j],
-                                                  iStoredFaderLevel,
-                                                  iStoredPanValue,
-                                                  bStoredFaderIsSolo,
-                                                  bStoredFaderIsMute ) )
-                    {
-                        vecpChanFader[i]->SetFaderLevel  ( iStoredFaderLevel );
-                        vecpChanFader[i]->SetPanValue    ( iStoredPanValue );
-                        vecpChanFader[i]->SetFaderIsSolo ( bStoredFaderIsSolo );
-                        vecpChanFader[i]->SetFaderIsMute ( bStoredFaderIsMute );
-                    }
+                    // the value is in percent -> convert range
+                    vecpChanFader[i]->SetFaderLevel ( static_cast<int> (
+                        iNewClientFaderLevel / 100.0 * AUD_MIX_FADER_MAX ) );
                 }
+            }
 
-                // set the channel infos
-                vecpChanFader[i]->SetChannelInfos ( vecChanInfo[j] );
-
-                bFaderIsUsed = true;
+            // restore gain (if new name is different from the current one)
+            if ( vecpChanFader[i]->GetReceivedName().compare ( vecChanInfo[j].strName ) )
+            {
+                // the text has actually changed, search in the list of
+                // stored settings if we have a matching entry
+                int  iStoredFaderLevel;
+                int  iStoredPanValue;
+                bool bStoredFaderIsSolo;
+                bool bStoredFaderIsMute;
+
+                if ( GetStoredFaderSettings ( vecChanInfo[j],
+                                              iStoredFaderLevel,
+                                              iStoredPanValue,
+                                              bStoredFaderIsSolo,
+                                              bStoredFaderIsMute ) )
+                {
+                    vecpChanFader[i]->SetFaderLevel  ( iStoredFaderLevel );
+                    vecpChanFader[i]->SetPanValue    ( iStoredPanValue );
+                    vecpChanFader[i]->SetFaderIsSolo ( bStoredFaderIsSolo );
+                    vecpChanFader[i]->SetFaderIsMute ( bStoredFaderIsMute );
+                }
             }
-        }
 
-        // if current fader is not used, hide it
-        if ( !bFaderIsUsed )
+            // set the channel infos
+            vecpChanFader[i]->SetChannelInfos ( vecChanInfo[j] );
+        }
+        else if ( vecpChanFader[i]->IsVisible() )
         {
+            // the current fader is not used anymore, hide it
+            bFadersChanged = true;
+
             // before hiding the fader, store its level (if some conditions are fullfilled)
             StoreFaderSettings ( vecpChanFader[i] );
 
@@ -978,7 +1092,10 @@ void CAudioMixerBoard::ApplyNewConClientList ( CVector<CChannelInfo>& vecChanInf
 
     // update the solo states since if any channel was on solo and a new client
     // has just connected, the new channel must be muted
-    UpdateSoloStates();
+    if ( bFadersChanged )
+    {
+        UpdateSoloStates();
+    }
 
     // update flag for "all faders are invisible"
     bNoFaderVisible = ( iNumConnectedClients == 0 );
@@ -991,7 +1108,7 @@ void CAudioMixerBoard::SetFaderLevel ( const int iChannelIdx,
                                        const int iValue )
 {
     // only apply new fader level if channel index is valid and the fader is visible
-    if ( ( iChannelIdx >= 0 ) && ( iChannelIdx < MAX_NUM_CHANNELS ) )
+    if ( ( iChannelIdx >= 0 ) && ( iChannelIdx < vecpChanFader.Size() ) )
     {
         if ( vecpChanFader[iChannelIdx]->IsVisible() )
         {
@@ -1004,7 +1121,7 @@ void CAudioMixerBoard::SetRemoteFaderIsMute ( const int  iChannelIdx,
                                               const bool bIsMute )
 {
     // only apply remote mute state if channel index is valid and the fader is visible
-    if ( ( iChannelIdx >= 0 ) && ( iChannelIdx < MAX_NUM_CHANNELS ) )
+    if ( ( iChannelIdx >= 0 ) && ( iChannelIdx < vecpChanFader.Size() ) )
     {
         if ( vecpChanFader[iChannelIdx]->IsVisible() )
         {
@@ -1018,7 +1135,7 @@ void CAudioMixerBoard::UpdateSoloStates()
     // first check if any channel has a solo state active
     bool bAnyChannelIsSolo = false;
 
-    for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+    for ( int i = 0; i < vecpChanFader.Size(); i++ )
     {
         // check if fader is in use and has solo state active
         if ( vecpChanFader[i]->IsVisible() && vecpChanFader[i]->IsSolo() )
@@ -1029,7 +1146,7 @@ void CAudioMixerBoard::UpdateSoloStates()
     }
 
     // now update the solo state of all active faders
-    for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+    for ( int i = 0; i < vecpChanFader.Size(); i++ )
     {
         if ( vecpChanFader[i]->IsVisible() )
         {
@@ -1052,7 +1169,7 @@ void CAudioMixerBoard::UpdateGainValue ( const int    iChannelIdx,
     // to avoid an infinite loop)
     if ( vecpChanFader[iChannelIdx]->IsSelect() && !bIsGroupUpdate )
     {
-        for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+        for ( int i = 0; i < vecpChanFader.Size(); i++ )
         {
             // update rest of faders selected
             if ( vecpChanFader[i]->IsVisible() && vecpChanFader[i]->IsSelect() && ( i != iChannelIdx ) )
@@ -1077,45 +1194,16 @@ void CAudioMixerBoard::StoreFaderSettings ( CChannelFader* pChanFader )
     if ( pChanFader->IsVisible() &&
          !pChanFader->GetReceivedName().isEmpty() )
     {
-        CVector<int> viOldStoredFaderLevels ( vecStoredFaderLevels );
-        CVector<int> viOldStoredPanValues   ( vecStoredPanValues );
-        CVector<int> vbOldStoredFaderIsSolo ( vecStoredFaderIsSolo );
-        CVector<int> vbOldStoredFaderIsMute ( vecStoredFaderIsMute );
-
-        // init temporary list count (may be overwritten later on)
-        int iTempListCnt = 0;
-
-        // put new value on the top of the list
-        const int iOldIdx =
-            vecStoredFaderTags.StringFiFoWithCompare ( pChanFader->GetReceivedName(),
-                                                       true );
-
-        // current fader level and solo state is at the top of the list
-        vecStoredFaderLevels[0] = pChanFader->GetFaderLevel();
-        vecStoredPanValues[0]   = pChanFader->GetPanValue();
-        vecStoredFaderIsSolo[0] = pChanFader->IsSolo();
-        vecStoredFaderIsMute[0] = pChanFader->IsMute();
-        iTempListCnt            = 1;
-
-        for ( int iIdx = 0; iIdx < MAX_NUM_STORED_FADER_SETTINGS; iIdx++ )
-        {
-            // first check if we still have space in our data storage
-            if ( iTempListCnt < MAX_NUM_STORED_FADER_SETTINGS )
-            {
-                // check for the old index of the current entry (this has to be
-                // skipped), note that per definition: the old index is an illegal
-                // index in case the entry was not present in the vector before
-                if ( iIdx != iOldIdx )
-                {
-                    vecStoredFaderLevels[iTempListCnt] = viOldStoredFaderLevels[iIdx];
-                    vecStoredPanValues[iTempListCnt]   = viOldStoredPanValues[iIdx];
-                    vecStoredFaderIsSolo[iTempListCnt] = vbOldStoredFaderIsSolo[iIdx];
-                    vecStoredFaderIsMute[iTempListCnt] = vbOldStoredFaderIsMute[iIdx];
+        CStoredFaderSettings::CEntry NewEntry;
 
-                    iTempListCnt++;
-                }
-            }
-        }
+        NewEntry.strTag  = pChanFader->GetReceivedName();
+        NewEntry.iLevel  = pChanFader->GetFaderLevel();
+        NewEntry.iPan    = pChanFader->GetPanValue();
+        NewEntry.bIsSolo = pChanFader->IsSolo();
+        NewEntry.bIsMute = pChanFader->IsMute();
+
+        // the entry is moved to the top of the list
+        StoredFaderSettings.Store ( NewEntry );
     }
 }
 
@@ -1125,24 +1213,20 @@ bool CAudioMixerBoard::GetStoredFaderSettings ( const CChannelInfo& ChanInfo,
                                                 bool&               bStoredFaderIsSolo,
                                                 bool&               bStoredFaderIsMute )
 {
-    // only do the check if the name string is not empty
-    if ( !ChanInfo.strName.isEmpty() )
+    CStoredFaderSettings::CEntry StoredEntry;
+
+    // check if fader text is already known in the list (an empty name string
+    // is never found)
+    if ( StoredFaderSettings.Get ( ChanInfo.strName, StoredEntry ) )
     {
-        for ( int iIdx = 0; iIdx < MAX_NUM_STORED_FADER_SETTINGS; iIdx++ )
-        {
-            // check if fader text is already known in the list
-            if ( !vecStoredFaderTags[iIdx].compare ( ChanInfo.strName ) )
-            {
-                // copy stored settings values
-                iStoredFaderLevel  = vecStoredFaderLevels[iIdx];
-                iStoredPanValue    = vecStoredPanValues[iIdx];
-                bStoredFaderIsSolo = vecStoredFaderIsSolo[iIdx] != 0;
-                bStoredFaderIsMute = vecStoredFaderIsMute[iIdx] != 0;
-
-                // values found and copied, return OK
-                return true;
-            }
-        }
+        // copy stored settings values
+        iStoredFaderLevel  = StoredEntry.iLevel;
+        iStoredPanValue    = StoredEntry.iPan;
+        bStoredFaderIsSolo = StoredEntry.bIsSolo;
+        bStoredFaderIsMute = StoredEntry.bIsMute;
+
+        // values found and copied, return OK
+        return true;
     }
 
     // return "not OK" since we did not find matching fader settings
@@ -1151,14 +1235,32 @@ bool CAudioMixerBoard::GetStoredFaderSettings ( const CChannelInfo& ChanInfo,
 
 void CAudioMixerBoard::SetChannelLevels ( const CVector<uint16_t>& vecChannelLevel )
 {
-    const int iNumChannelLevels = vecChannelLevel.Size();
-    int       i                 = 0;
+    // only the last levels are stored, they are shown with the next display
+    // update (so that all level messages between two display updates cost
+    // only one repaint)
+    iNumPendingChannelLevels = std::min ( vecChannelLevel.Size(), static_cast<int> ( MAX_NUM_CHANNELS ) );
+
+    std::copy ( vecChannelLevel.begin(),
+                vecChannelLevel.begin() + iNumPendingChannelLevels,
+                vecPendingChannelLevels.begin() );
+
+    if ( !TimerChannelLevels.isActive() )
+    {
+        TimerChannelLevels.start();
+    }
+}
+
+void CAudioMixerBoard::OnTimerChannelLevels()
+{
+    int i = 0;
 
-    for ( int iChId = 0; iChId < MAX_NUM_CHANNELS; iChId++ )
+    // all meters are updated in one pass, Qt merges the resulting update
+    // requests in a single repaint of the window
+    for ( int iChId = 0; iChId < vecpChanFader.Size(); iChId++ )
     {
-        if ( vecpChanFader[iChId]->IsVisible() && i < iNumChannelLevels )
+        if ( vecpChanFader[iChId]->IsVisible() && i < iNumPendingChannelLevels )
         {
-            vecpChanFader[iChId]->SetChannelLevel ( vecChannelLevel[i++] );
+            vecpChanFader[iChId]->SetChannelLevel ( vecPendingChannelLevels[i++] );
 
             // show level only if we successfully received levels from the
             // server (if server does not support levels, do not show levels)
@@ -36,11 +36,18 @@
 #include <QSizePolicy>
 #include <QHostAddress>
 #include <QListWidget>
+#include <QTimer>
 #include "global.h"
 #include "util.h"
 #include "multicolorledbar.h"
 
 
+/* Definitions ****************************************************************/
+// the received channel levels are collected and shown at most with this
+// interval (the server may send the levels much more often)
+#define LEVEL_DISPLAY_UPDATE_TIME_MS     33 // ms
+
+
 /* Classes ********************************************************************/
 class CChannelFader : public QObject
 {
@@ -51,6 +58,7 @@ public:
 
     QString GetReceivedName() { return cReceivedChanInfo.strName; }
     int GetReceivedInstrument() { return cReceivedChanInfo.iInstrument; }
+    const CChannelInfo& GetReceivedChanInfo() const { return cReceivedChanInfo; }
     void SetChannelInfos ( const CChannelInfo& cChanInfo );
     void Show() { pFrame->show(); }
     void Hide() { pFrame->hide(); }
@@ -77,6 +85,7 @@ public:
     void Reset();
     void SetChannelLevel ( const uint16_t iLevel );
     void SetIsMyOwnFader() { bIsMyOwnFader = true; }
+    void SetIsMixGroupFader ( const int iMixGroup );
     void UpdateSoloState ( const bool bNewOtherSoloState );
 
 protected:
@@ -129,39 +138,7 @@ signals:
     void soloStateChanged ( int value );
 };
 
-template<unsigned int slotId>
-class CAudioMixerBoardSlots : public CAudioMixerBoardSlots<slotId - 1>
-{
-public:
-    void OnChGainValueChanged ( double dValue,
-                                bool   bIsMyOwnFader,
-                                bool   bIsGroupUpdate,
-                                int    iDiffLevel ) { UpdateGainValue ( slotId - 1,
-                                                                        dValue,
-                                                                        bIsMyOwnFader,
-                                                                        bIsGroupUpdate,
-                                                                        iDiffLevel ); }
-
-    void OnChPanValueChanged ( double dValue ) { UpdatePanValue ( slotId - 1, dValue ); }
-
-protected:
-    virtual void UpdateGainValue ( const int    iChannelIdx,
-                                   const double dValue,
-                                   const bool   bIsMyOwnFader,
-                                   const bool   bIsGroupUpdate,
-                                   const int    iDiffLevel ) = 0;
-
-    virtual void UpdatePanValue ( const int    iChannelIdx,
-                                  const double dValue ) = 0;
-};
-
-template<>
-class CAudioMixerBoardSlots<0> {};
-
-
-class CAudioMixerBoard :
-    public QGroupBox,
-    public CAudioMixerBoardSlots<MAX_NUM_CHANNELS>
+class CAudioMixerBoard : public QGroupBox
 {
     Q_OBJECT
 
@@ -189,14 +166,13 @@ public:
 
     void SetRecorderState ( const ERecorderState newRecorderState );
 
+    // shows a fader for each mix group which has at least one channel, the
+    // fader sets the gain of the mix group bus at the server
+    void SetMixGroups ( const CVector<int>& vecMixGroups );
 
     // settings
-    CVector<QString> vecStoredFaderTags;
-    CVector<int>     vecStoredFaderLevels;
-    CVector<int>     vecStoredPanValues;
-    CVector<int>     vecStoredFaderIsSolo;
-    CVector<int>     vecStoredFaderIsMute;
-    int              iNewClientFaderLevel;
+    CStoredFaderSettings StoredFaderSettings;
+    int                  iNewClientFaderLevel;
 
 protected:
     class CMixerBoardScrollArea : public QScrollArea
@@ -224,12 +200,18 @@ protected:
     void UpdateSoloStates();
     void UpdateTitle();
 
+    // the faders are created on demand for the highest channel ID of the
+    // received client lists
+    void CreateFaders ( const int iNewNumFaders );
+
     void OnGainValueChanged ( const int    iChannelIdx,
                               const double dValue );
 
     CVector<CChannelFader*> vecpChanFader;
+    CVector<CChannelFader*> vecpMixGroupFader; // index: mix group
     CMixerBoardScrollArea*  pScrollArea;
     QHBoxLayout*            pMainLayout;
+    EGUIDesign              eGUIDesign;
     bool                    bDisplayChannelLevels;
     bool                    bDisplayPans;
     bool                    bIsPanSupported;
@@ -238,20 +220,26 @@ protected:
     QString                 strServerName;
     ERecorderState          eRecorderState;
 
-    virtual void UpdateGainValue ( const int    iChannelIdx,
-                                   const double dValue,
-                                   const bool   bIsMyOwnFader,
-                                   const bool   bIsGroupUpdate,
-                                   const int    iDiffLevel );
+    void UpdateGainValue ( const int    iChannelIdx,
+                           const double dValue,
+                           const bool   bIsMyOwnFader,
+                           const bool   bIsGroupUpdate,
+                           const int    iDiffLevel );
+
+    void UpdatePanValue ( const int    iChannelIdx,
+                          const double dValue );
 
-    virtual void UpdatePanValue ( const int    iChannelIdx,
-                                  const double dValue );
+    // the last received levels which are not yet displayed
+    CVector<uint16_t>       vecPendingChannelLevels;
+    int                     iNumPendingChannelLevels;
+    QTimer                  TimerChannelLevels;
 
-    template<unsigned int slotId>
-    inline void connectFaderSignalsToMixerBoardSlots();
+protected slots:
+    void OnTimerChannelLevels();
 
 signals:
     void ChangeChanGain ( int iId, double dGain, bool bIsMyOwnFader );
     void ChangeChanPan ( int iId, double dPan );
+    void ChangeMixGroupGain ( int iMixGroup, double dGain );
     void NumClientsChanged ( int iNewNumClients );
 };
@@ -0,0 +1,196 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "benchmarksuite.h"
+#include "microbenchmark.h"
+#include "serverbenchmark.h"
+#include <QFile>
+#include <QThread>
+#include <QSysInfo>
+#include <QDateTime>
+#include <QJsonDocument>
+
+
+/* Implementation *************************************************************/
+int CBenchmarkSuite::Run ( QTextStream&   tsConsole,
+                           const QString& strResultFileName,
+                           const QString& strBaselineFileName )
+{
+    // read the baseline first so that a wrong file name is reported before
+    // the benchmarks run
+    QJsonObject jsonBaseline;
+
+    if ( !strBaselineFileName.isEmpty() )
+    {
+        jsonBaseline = ReadFile ( strBaselineFileName );
+    }
+
+    CMicroBenchmark MicroBenchmark ( "all" );
+    MicroBenchmark.Run ( tsConsole );
+
+    tsConsole << endl;
+
+    CServerBenchmark ServerBenchmark ( iNumServerThreads );
+    ServerBenchmark.Run ( tsConsole );
+
+    // the description of the hardware and the build is stored with the
+    // results since a baseline is only meaningful for the same hardware
+    QJsonObject jsonResult;
+    jsonResult["version"]          = APP_VERSION;
+    jsonResult["date"]             = QDateTime::currentDateTimeUtc().toString ( Qt::ISODate );
+    jsonResult["host"]             = QSysInfo::machineHostName();
+    jsonResult["cpu_architecture"] = QSysInfo::currentCpuArchitecture();
+    jsonResult["cpu_cores"]        = QThread::idealThreadCount();
+    jsonResult["mix_kernel"]       = QString ( CMixKernel::GetImplementationName() );
+    jsonResult["opus"]             = QString ( opus_get_version_string() );
+    jsonResult["server_threads"]   = ServerBenchmark.GetNumThreads();
+    jsonResult["micro"]            = MicroBenchmark.GetResults();
+    jsonResult["server"]           = ServerBenchmark.GetResults();
+
+    WriteFile ( strResultFileName, jsonResult );
+
+    tsConsole << endl << "Results written to " << strResultFileName << endl;
+
+    if ( strBaselineFileName.isEmpty() )
+    {
+        return 0;
+    }
+
+    tsConsole << endl << QString ( "Comparison with the baseline %1 (tolerance %2 %)" ).
+        arg ( strBaselineFileName ).arg ( dTolerancePercent ) << endl;
+
+    const QStringList slHardwareKeys = { "cpu_architecture", "cpu_cores", "mix_kernel", "server_threads" };
+
+    for ( const QString& strKey : slHardwareKeys )
+    {
+        if ( jsonBaseline.value ( strKey ) != jsonResult.value ( strKey ) )
+        {
+            tsConsole << "Warning: the baseline differs in " << strKey << ", the results are not comparable" << endl;
+        }
+    }
+
+    tsConsole << QString ( "%1 %2 %3 %4" ).
+        arg ( "Benchmark", -50 ).
+        arg ( "Baseline", 12 ).
+        arg ( "Current", 12 ).
+        arg ( "Change", 9 ) << endl;
+
+    const int iNumRegressions =
+        Compare ( tsConsole, MicroBenchmark.GetResults(),  jsonBaseline.value ( "micro" ).toArray(),  "ns_per_op", false ) +
+        Compare ( tsConsole, ServerBenchmark.GetResults(), jsonBaseline.value ( "server" ).toArray(), "channels",  true );
+
+    tsConsole << iNumRegressions << " regressions" << endl;
+
+    return iNumRegressions;
+}
+
+int CBenchmarkSuite::Compare ( QTextStream&      tsConsole,
+                               const QJsonArray& jsonResults,
+                               const QJsonArray& jsonBaseResults,
+                               const QString&    strKey,
+                               const bool        bHigherIsBetter )
+{
+    int iNumRegressions = 0;
+
+    for ( int i = 0; i < jsonResults.size(); i++ )
+    {
+        const QJsonObject jsonCur    = jsonResults[i].toObject();
+        const QString     strName    = jsonCur["name"].toString();
+        const double      dCurValue  = jsonCur[strKey].toDouble();
+        double            dBaseValue = 0;
+
+        for ( int j = 0; j < jsonBaseResults.size(); j++ )
+        {
+            if ( jsonBaseResults[j].toObject()["name"].toString() == strName )
+            {
+                dBaseValue = jsonBaseResults[j].toObject()[strKey].toDouble();
+                break;
+            }
+        }
+
+        if ( dBaseValue <= 0 )
+        {
+            tsConsole << QString ( "%1 %2 %3" ).
+                arg ( strName, -50 ).
+                arg ( "-", 12 ).
+                arg ( dCurValue, 12, 'f', 1 ) << endl;
+
+            continue;
+        }
+
+        // positive changes are improvements
+        const double dChangePercent = bHigherIsBetter ?
+            100 * ( dCurValue - dBaseValue ) / dBaseValue :
+            100 * ( dBaseValue - dCurValue ) / dBaseValue;
+
+        const bool bRegression = ( dChangePercent < -dTolerancePercent );
+
+        if ( bRegression )
+        {
+            iNumRegressions++;
+        }
+
+        tsConsole << QString ( "%1 %2 %3 %4 %%5" ).
+            arg ( strName, -50 ).
+            arg ( dBaseValue, 12, 'f', 1 ).
+            arg ( dCurValue, 12, 'f', 1 ).
+            arg ( dChangePercent, 7, 'f', 1 ).
+            arg ( bRegression ? "  REGRESSION" : "" ) << endl;
+    }
+
+    return iNumRegressions;
+}
+
+QJsonObject CBenchmarkSuite::ReadFile ( const QString& strFileName )
+{
+    QFile File ( strFileName );
+
+    if ( !File.open ( QIODevice::ReadOnly ) )
+    {
+        throw CGenErr ( "Cannot open the benchmark baseline file " + strFileName );
+    }
+
+    const QJsonDocument jsonDoc = QJsonDocument::fromJson ( File.readAll() );
+
+    if ( !jsonDoc.isObject() )
+    {
+        throw CGenErr ( "The benchmark baseline file " + strFileName + " is no valid result file" );
+    }
+
+    return jsonDoc.object();
+}
+
+void CBenchmarkSuite::WriteFile ( const QString&     strFileName,
+                                  const QJsonObject& jsonDoc )
+{
+    QFile File ( strFileName );
+
+    if ( !File.open ( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        throw CGenErr ( "Cannot write the benchmark result file " + strFileName );
+    }
+
+    File.write ( QJsonDocument ( jsonDoc ).toJson() );
+}
@@ -0,0 +1,77 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QString>
+#include <QTextStream>
+#include <QJsonArray>
+#include <QJsonObject>
+#include "global.h"
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// a result which is worse than the baseline by more than this is a regression
+#define BENCHMARK_DEFAULT_TOLERANCE_PERCENT  10
+
+
+/* Classes ********************************************************************/
+// Runs all micro-benchmarks (mix kernels, buffers, CRC, protocol and codec)
+// and the server benchmark ("--benchmarksuite", "make benchmarks") and writes
+// the results in a JSON file. A result file of a previous run on the same
+// hardware can be given as baseline, then each result is compared with the
+// baseline and the results which are worse by more than the tolerance are
+// reported as regressions.
+class CBenchmarkSuite
+{
+public:
+    CBenchmarkSuite ( const int    iNNumServerThreads,
+                      const double dNTolerancePercent ) :
+        iNumServerThreads ( iNNumServerThreads ),
+        dTolerancePercent ( dNTolerancePercent ) {}
+
+    // returns the number of regressions (an empty baseline file name disables
+    // the comparison), throws an error if a file cannot be read or written
+    int Run ( QTextStream&   tsConsole,
+              const QString& strResultFileName,
+              const QString& strBaselineFileName );
+
+protected:
+    // compares the value of each result with the entry of the same name in
+    // the baseline, a larger value is better if bHigherIsBetter is set
+    int Compare ( QTextStream&      tsConsole,
+                  const QJsonArray& jsonResults,
+                  const QJsonArray& jsonBaseResults,
+                  const QString&    strKey,
+                  const bool        bHigherIsBetter );
+
+    static QJsonObject ReadFile ( const QString& strFileName );
+    static void        WriteFile ( const QString&     strFileName,
+                                   const QJsonObject& jsonDoc );
+
+    int    iNumServerThreads;
+    double dTolerancePercent;
+};
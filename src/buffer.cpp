@@ -88,10 +88,145 @@ bool CNetBuf::Get ( CVector<uint8_t>& vecbyData,
     return bGetOK;
 }
 
+uint8_t* CNetBuf::GetQueuedBlock ( const int iBlocksBack )
+{
+    if ( bIsSimulation || ( iBlocksBack < 1 ) || ( iBlocksBack * iBlockSize > GetAvailData() ) )
+    {
+        return nullptr;
+    }
+
+    // the blocks never wrap around in the memory since the put position is
+    // always a multiple of the block size
+    return &vecMemory[( iPutPos - iBlocksBack * iBlockSize + iMemSize ) % iMemSize];
+}
+
+
+/* Lock-free network buffer implementation ************************************/
+CNetBufSPSC::CNetBufSPSC() :
+    iBlockSize ( 0 ),
+    iNumBlocks ( 0 ),
+    iPutPos    ( 0 ),
+    iGetPos    ( 0 )
+{
+}
+
+void CNetBufSPSC::Init ( const int  iNewBlockSize,
+                         const int  iNewNumBlocks,
+                         const bool bPreserve )
+{
+    // get the number of blocks which shall be kept (only possible if the block
+    // size does not change)
+    int iNumPreserve = 0;
+
+    if ( bPreserve && ( iNewBlockSize == iBlockSize ) && ( iNumBlocks > 0 ) )
+    {
+        iNumPreserve = std::min ( GetAvailData() / iBlockSize, iNewNumBlocks );
+    }
+
+    CVector<uint8_t> vecNewMemory ( iNewBlockSize * iNewNumBlocks );
+
+    // copy the oldest blocks in the new memory (the get position is zero then)
+    const int iOldGetPos = iGetPos.loadAcquire();
+
+    for ( int iB = 0; iB < iNumPreserve; iB++ )
+    {
+        const int iOldOffs = ( NextPos ( iOldGetPos, iB ) % iNumBlocks ) * iBlockSize;
+
+        std::copy ( vecMemory.begin() + iOldOffs,
+                    vecMemory.begin() + iOldOffs + iBlockSize,
+                    vecNewMemory.begin() + iB * iBlockSize );
+    }
+
+    vecMemory  = vecNewMemory;
+    iBlockSize = iNewBlockSize;
+    iNumBlocks = iNewNumBlocks;
+
+    iGetPos.storeRelease ( 0 );
+    iPutPos.storeRelease ( iNumPreserve );
+}
+
+int CNetBufSPSC::GetAvailData() const
+{
+    if ( iNumBlocks == 0 )
+    {
+        return 0;
+    }
+
+    return NumBlocksAvail ( iPutPos.loadAcquire(), iGetPos.loadAcquire() ) * iBlockSize;
+}
+
+bool CNetBufSPSC::Put ( const CVector<uint8_t>& vecbyData,
+                        const int               iInSize )
+{
+    // check size
+    if ( ( iBlockSize == 0 ) || ( iInSize == 0 ) || ( iInSize % iBlockSize != 0 ) )
+    {
+        return false;
+    }
+
+    // the get position must be acquired since the consumer must have finished
+    // reading the memory of the blocks it has released
+    const int iCurPutPos   = iPutPos.loadAcquire();
+    const int iNumBlocksIn = iInSize / iBlockSize;
+
+    // check if there is not enough space available
+    if ( NumBlocksAvail ( iCurPutPos, iGetPos.loadAcquire() ) + iNumBlocksIn > iNumBlocks )
+    {
+        return false;
+    }
+
+    for ( int iB = 0; iB < iNumBlocksIn; iB++ )
+    {
+        const int iOffs = ( NextPos ( iCurPutPos, iB ) % iNumBlocks ) * iBlockSize;
+
+        std::copy ( vecbyData.begin() + iB * iBlockSize,
+                    vecbyData.begin() + ( iB + 1 ) * iBlockSize,
+                    vecMemory.begin() + iOffs );
+    }
+
+    // publish the new blocks to the consumer
+    iPutPos.storeRelease ( NextPos ( iCurPutPos, iNumBlocksIn ) );
+
+    return true;
+}
+
+bool CNetBufSPSC::Get ( CVector<uint8_t>& vecbyData,
+                        const int         iOutSize )
+{
+    // check size
+    if ( ( iOutSize == 0 ) || ( iOutSize != iBlockSize ) )
+    {
+        return false;
+    }
+
+    const int iCurGetPos = iGetPos.loadAcquire();
+
+    // check if there is not enough data available
+    if ( iPutPos.loadAcquire() == iCurGetPos )
+    {
+        return false;
+    }
+
+    const int iOffs = ( iCurGetPos % iNumBlocks ) * iBlockSize;
+
+    std::copy ( vecMemory.begin() + iOffs,
+                vecMemory.begin() + iOffs + iBlockSize,
+                vecbyData.begin() );
+
+    // release the block to the producer
+    iGetPos.storeRelease ( NextPos ( iCurGetPos, 1 ) );
+
+    return true;
+}
+
 
 /* Network buffer with statistic calculations implementation ******************/
 CNetBufWithStats::CNetBufWithStats() :
     CNetBuf                   ( false ), // base class init: no simulation mode
+    dAvFillBlocks             ( 0 ),
+    iAvFillMilliBlocks        ( 0 ),
+    iWarmupCounter            ( 0 ),
+    iAutoStartSetting         ( 0 ),
     iMaxStatisticCount        ( MAX_STATISTIC_COUNT ),
     bUseDoubleSystemFrameSize ( false ),
     dAutoFilt_WightUpNormal   ( IIR_WEIGTH_UP_NORMAL ),
@@ -99,46 +234,64 @@ CNetBufWithStats::CNetBufWithStats() :
     dAutoFilt_WightUpFast     ( IIR_WEIGTH_UP_FAST ),
     dAutoFilt_WightDownFast   ( IIR_WEIGTH_DOWN_FAST ),
     dErrorRateBound           ( ERROR_RATE_BOUND ),
-    dUpMaxErrorBound          ( UP_MAX_ERROR_BOUND )
+    dUpMaxErrorBound          ( UP_MAX_ERROR_BOUND ),
+    iLastGetTimeNs            ( 0 ),
+    iPutRecDelayNs            ( 0 )
 {
     // Define the sizes of the simulation buffers,
     // must be NUM_STAT_SIMULATION_BUFFERS elements!
     // Avoid the buffer length 1 because we do not have a solution for a
     // sample rate offset correction. Caused by the jitter we usually get bad
     // performance with just one buffer.
-    viBufSizesForSim[0] = 2;
-    viBufSizesForSim[1] = 3;
-    viBufSizesForSim[2] = 4;
-    viBufSizesForSim[3] = 5;
-    viBufSizesForSim[4] = 6;
-    viBufSizesForSim[5] = 7;
-    viBufSizesForSim[6] = 8;
-    viBufSizesForSim[7] = 9;
-    viBufSizesForSim[8] = 10;
-    viBufSizesForSim[9] = 11;
-
-    // set all simulation buffers in simulation mode
+    // The large sizes (up to MAX_AUTO_NET_BUF_SIZE_NUM_BL) are only chosen on
+    // links with a very high jitter (e.g. intercontinental connections).
+    viBufSizesForSim[0]  = 2;
+    viBufSizesForSim[1]  = 3;
+    viBufSizesForSim[2]  = 4;
+    viBufSizesForSim[3]  = 5;
+    viBufSizesForSim[4]  = 6;
+    viBufSizesForSim[5]  = 7;
+    viBufSizesForSim[6]  = 8;
+    viBufSizesForSim[7]  = 9;
+    viBufSizesForSim[8]  = 10;
+    viBufSizesForSim[9]  = 11;
+    viBufSizesForSim[10] = 13;
+    viBufSizesForSim[11] = 16;
+    viBufSizesForSim[12] = 20;
+    viBufSizesForSim[13] = 25;
+    viBufSizesForSim[14] = MAX_AUTO_NET_BUF_SIZE_NUM_BL;
+
+    // the statistic is initialized with the Init() call
     for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
     {
-        SimulationBuffer[i].SetIsSimulation ( true );
+        viSimBufFill[i]     = 0;
+        viSimBufMemSize[i]  = 0;
+        vdErrorRate[i]       = 1.0;
+        viErrorRateCnt[i]    = 0;
+        vbPrevErrorState[i]  = true;
+        vbLastGetUnderrun[i] = false;
     }
+
+    StatTimer.start();
 }
 
 void CNetBufWithStats::GetErrorRates ( CVector<double>& vecErrRates,
                                        double&          dLimit,
-                                       double&          dMaxUpLimit )
+                                       double&          dMaxUpLimit ) const
 {
+    const SErrorRates ErrorRates = ErrorRatesSnapshot.Read();
+
     // get all the averages of the error statistic
     vecErrRates.Init ( NUM_STAT_SIMULATION_BUFFERS );
 
     for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
     {
-        vecErrRates[i] = ErrorRateStatistic[i].GetAverage();
+        vecErrRates[i] = ErrorRates.vdErrorRate[i];
     }
 
     // get the limits for the decisions
-    dLimit      = dErrorRateBound;
-    dMaxUpLimit = dUpMaxErrorBound;
+    dLimit      = ErrorRates.dLimit;
+    dMaxUpLimit = ErrorRates.dMaxUpLimit;
 }
 
 void CNetBufWithStats::Init ( const int  iNewBlockSize,
@@ -175,22 +328,38 @@ void CNetBufWithStats::Init ( const int  iNewBlockSize,
 
         for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
         {
-            // init simulation buffers with the correct size
-            SimulationBuffer[i].Init ( iNewBlockSize, viBufSizesForSim[i] );
-
-            // init statistics
-            ErrorRateStatistic[i].Init ( iMaxStatisticCount, true );
+            // init simulation buffers with the correct size (empty buffer)
+            viSimBufMemSize[i] = iNewBlockSize * viBufSizesForSim[i];
+            viSimBufFill[i]    = 0;
+
+            // init statistics (use "no data result" of 1.0 which stands for
+            // the worst error rate possible)
+            vdErrorRate[i]       = 1.0;
+            viErrorRateCnt[i]    = 0;
+            vbPrevErrorState[i]  = true;
+            vbLastGetUnderrun[i] = false;
         }
 
+        iLastGetTimeNs = 0;
+
         // reset the initialization counter which controls the initialization
-        // phase length
+        // phase length, the initialization phase follows the warmup which
+        // takes half of its length
         ResetInitCounter();
+        iWarmupCounter = iMaxStatisticCount / 8;
+
+        // init auto buffer setting with a meaningful value (the start value
+        // if one was set), also init the IIR parameter with this value
+        iCurAutoBufferSizeSetting = ( iAutoStartSetting > 0 )
+            ? std::min ( std::max ( iAutoStartSetting, viBufSizesForSim[0] ), MAX_AUTO_NET_BUF_SIZE_NUM_BL )
+            : DEF_AUTO_NET_BUF_START_NUM_BL;
+
+        dCurIIRFilterResult = iCurAutoBufferSizeSetting;
+        iCurDecidedResult   = iCurAutoBufferSizeSetting;
 
-        // init auto buffer setting with a meaningful value, also init the
-        // IIR parameter with this value
-        iCurAutoBufferSizeSetting = 6;
-        dCurIIRFilterResult       = iCurAutoBufferSizeSetting;
-        iCurDecidedResult         = iCurAutoBufferSizeSetting;
+        // the measured fill level starts with an empty buffer
+        dAvFillBlocks = 0;
+        iAvFillMilliBlocks.storeRelease ( 0 );
     }
 }
 
@@ -209,11 +378,36 @@ bool CNetBufWithStats::Put ( const CVector<uint8_t>& vecbyData,
     // call base class Put
     const bool bPutOK = CNetBuf::Put ( vecbyData, iInSize );
 
-    // update statistics calculations
+    // the kernel has received the block before the last get
+    const bool bRecBeforeLastGet = ( iPutRecDelayNs > 0 ) &&
+                                   ( iLastGetTimeNs > 0 ) &&
+                                   ( StatTimer.nsecsElapsed() - iPutRecDelayNs < iLastGetTimeNs );
+
+    // update statistics calculations (same behaviour as CNetBuf::Put but only
+    // on the fill level)
     for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
     {
-        ErrorRateStatistic[i].Update (
-            !SimulationBuffer[i].Put ( vecbyData, iInSize ) );
+        int iSimInSize = iInSize;
+
+        if ( bRecBeforeLastGet && vbLastGetUnderrun[i] && ( iInSize >= iBlockSize ) )
+        {
+            // the last get takes the first block of this put, i.e. its
+            // underrun was caused by the local scheduling and not by the
+            // network
+            RevokeError ( i );
+            iSimInSize -= iBlockSize;
+        }
+
+        vbLastGetUnderrun[i] = false;
+
+        const bool bSimPutOK = ( viSimBufFill[i] + iSimInSize <= viSimBufMemSize[i] );
+
+        if ( bSimPutOK )
+        {
+            viSimBufFill[i] += iSimInSize;
+        }
+
+        UpdateErrorRate ( i, !bSimPutOK );
     }
 
     return bPutOK;
@@ -225,19 +419,128 @@ bool CNetBufWithStats::Get ( CVector<uint8_t>& vecbyData,
     // call base class Get
     const bool bGetOK = CNetBuf::Get ( vecbyData, iOutSize );
 
-    // update statistics calculations
+    // update statistics calculations (same behaviour as CNetBuf::Get but only
+    // on the fill level)
     for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
     {
-        ErrorRateStatistic[i].Update (
-            !SimulationBuffer[i].Get ( vecbyData, iOutSize ) );
+        const bool bSimGetOK = ( iOutSize != 0 ) &&
+                               ( iOutSize == iBlockSize ) &&
+                               ( viSimBufFill[i] >= iOutSize );
+
+        if ( bSimGetOK )
+        {
+            viSimBufFill[i] -= iOutSize;
+        }
+
+        // an underrun which is counted may be revoked by the next put
+        vbLastGetUnderrun[i] = UpdateErrorRate ( i, !bSimGetOK ) && !bSimGetOK;
+    }
+
+    iLastGetTimeNs = StatTimer.nsecsElapsed();
+
+    // measured fill level: the blocks which are still in the buffer are the
+    // ones the next received block has to wait for
+    if ( bGetOK && ( iBlockSize > 0 ) )
+    {
+        dAvFillBlocks = IIR_WEIGTH_FILL_LEVEL * dAvFillBlocks +
+            ( 1.0 - IIR_WEIGTH_FILL_LEVEL ) * GetAvailData() / iBlockSize;
+
+        iAvFillMilliBlocks.storeRelease ( static_cast<int> ( dAvFillBlocks * 1000 ) );
     }
 
     // update auto setting
     UpdateAutoSetting();
 
+    // publish the statistic of this block for the readers on other threads
+    SErrorRates ErrorRates;
+
+    for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
+    {
+        ErrorRates.vdErrorRate[i] = vdErrorRate[i];
+    }
+
+    ErrorRates.dLimit      = dErrorRateBound;
+    ErrorRates.dMaxUpLimit = dUpMaxErrorBound;
+
+    ErrorRatesSnapshot.Publish ( ErrorRates );
+
     return bGetOK;
 }
 
+bool CNetBufWithStats::UpdateErrorRate ( const int  iSimIdx,
+                                         const bool bIsError )
+{
+    // if two states were false, do not use the new value (same as the
+    // "block on double errors" mode of CErrorRate)
+    if ( vbPrevErrorState[iSimIdx] && bIsError )
+    {
+        return false;
+    }
+
+    vbPrevErrorState[iSimIdx] = bIsError;
+
+    // Running average of the errors as values 0 and 1: until the statistic
+    // count is reached, this is the exact mean of all values so far, after
+    // that it is an exponential average with the same effective length as
+    // the former moving average. So we have O(1) work without a history.
+    if ( viErrorRateCnt[iSimIdx] < iMaxStatisticCount )
+    {
+        viErrorRateCnt[iSimIdx]++;
+    }
+
+    vdErrorRate[iSimIdx] += ( ( bIsError ? 1.0 : 0.0 ) - vdErrorRate[iSimIdx] ) / viErrorRateCnt[iSimIdx];
+
+    return true;
+}
+
+void CNetBufWithStats::RevokeError ( const int iSimIdx )
+{
+    // the last update of the running average was an error, it is replaced by
+    // a value without error (the counter is not changed)
+    const double dCnt = viErrorRateCnt[iSimIdx];
+
+    if ( dCnt > 1 )
+    {
+        const double dPrevRate = ( vdErrorRate[iSimIdx] * dCnt - 1.0 ) / ( dCnt - 1 );
+
+        vdErrorRate[iSimIdx] = std::max ( 0.0, dPrevRate - dPrevRate / dCnt );
+    }
+    else
+    {
+        vdErrorRate[iSimIdx] = 0.0;
+    }
+
+    vbPrevErrorState[iSimIdx] = false;
+}
+
+void CNetBufWithStats::UpdateWarmupSetting()
+{
+    // Warmup after a new connection: the filtered estimation would need
+    // seconds to get from the start value to a larger required size, during
+    // this time the buffer underruns. Therefore the setting directly jumps to
+    // the smallest simulation buffer with an error rate below the maximum
+    // upper bound. Since the error rates are the exact means of the few values
+    // so far, a simulation buffer is only judged after enough values for this
+    // bound (i.e. a single error in the first values does not count). The
+    // setting only grows during the warmup, a too large start value is reduced
+    // by the regular estimation afterwards.
+    for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
+    {
+        if ( ( viErrorRateCnt[i] * dUpMaxErrorBound >= 1.0 ) &&
+             ( vdErrorRate[i] <= dUpMaxErrorBound ) )
+        {
+            if ( viBufSizesForSim[i] > iCurAutoBufferSizeSetting )
+            {
+                iCurAutoBufferSizeSetting = viBufSizesForSim[i];
+                dCurIIRFilterResult       = iCurAutoBufferSizeSetting;
+                iCurDecidedResult         = iCurAutoBufferSizeSetting;
+            }
+
+            return;
+        }
+    }
+}
+
 void CNetBufWithStats::UpdateAutoSetting()
 {
     int  iCurDecision      = 0; // dummy initialization
@@ -245,6 +548,16 @@ void CNetBufWithStats::UpdateAutoSetting()
     bool bDecisionFound;
 
 
+    // Warmup ------------------------------------------------------------------
+    // the regular estimation starts with the result of the warmup
+    if ( iWarmupCounter > 0 )
+    {
+        iWarmupCounter--;
+        UpdateWarmupSetting();
+        return;
+    }
+
+
     // Get regular error rate decision -----------------------------------------
     // Use a specified error bound to identify the best buffer size for the
     // current network situation. Start with the smallest buffer and
@@ -254,7 +567,7 @@ void CNetBufWithStats::UpdateAutoSetting()
     for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS - 1; i++ )
     {
         if ( ( !bDecisionFound ) &&
-             ( ErrorRateStatistic[i].GetAverage() <= dErrorRateBound ) )
+             ( vdErrorRate[i] <= dErrorRateBound ) )
         {
             iCurDecision   = viBufSizesForSim[i];
             bDecisionFound = true;
@@ -278,7 +591,7 @@ void CNetBufWithStats::UpdateAutoSetting()
     for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS - 1; i++ )
     {
         if ( ( !bDecisionFound ) &&
-             ( ErrorRateStatistic[i].GetAverage() <= dUpMaxErrorBound ) )
+             ( vdErrorRate[i] <= dUpMaxErrorBound ) )
         {
             iCurMaxUpDecision = viBufSizesForSim[i];
             bDecisionFound    = true;
@@ -374,12 +687,13 @@ else
     if ( iInitCounter == iMaxStatisticCount / 8 )
     {
         // check error rate of the largest buffer as the indicator
-        if ( ErrorRateStatistic[NUM_STAT_SIMULATION_BUFFERS - 1].
-             GetAverage() > dErrorRateBound )
+        if ( vdErrorRate[NUM_STAT_SIMULATION_BUFFERS - 1] > dErrorRateBound )
         {
             for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
             {
-                ErrorRateStatistic[i].Reset();
+                vdErrorRate[i]      = 1.0;
+                viErrorRateCnt[i]   = 0;
+                vbPrevErrorState[i] = true;
             }
         }
     }
@@ -24,14 +24,21 @@
 
 #pragma once
 
+#include <QAtomicInt>
+#include <QElapsedTimer>
 #include "util.h"
 #include "global.h"
+#include "telemetry.h"
 
 
 /* Definitions ****************************************************************/
 // number of simulation network jitter buffers for evaluating the statistic
 // NOTE If you want to change this number, the code has to modified, too!
-#define NUM_STAT_SIMULATION_BUFFERS                 10
+#define NUM_STAT_SIMULATION_BUFFERS                 15
+
+// assumed cache line size for separating data which is written by different
+// threads (avoids false sharing)
+#define CACHE_LINE_SIZE_BYTES                       64
 
 // hysteresis for buffer size decision to avoid fast changes if close to the bound
 #define FILTER_DECISION_HYSTERESIS                  0.1
@@ -69,6 +76,14 @@
 #define IIR_WEIGTH_UP_FAST                          0.9997499687422
 #define IIR_WEIGTH_DOWN_FAST                        0.999499875
 
+// default start value of the auto setting (if no start value is set)
+#define DEF_AUTO_NET_BUF_START_NUM_BL               6
+
+// weight of the IIR filter of the measured jitter buffer fill level, one
+// update per block gives a time constant of 1000 blocks (approx. 1.3 s with
+// 64 samples blocks)
+#define IIR_WEIGTH_FILL_LEVEL                       0.999
+
 
 /* Classes ********************************************************************/
 // Buffer base class -----------------------------------------------------------
@@ -80,6 +95,34 @@ public:
 
     void SetIsSimulation ( const bool bNIsSim ) { bIsSimulation = bNIsSim; }
 
+    // reserve the memory for the largest buffer size which will be used so
+    // that a later re-initialization (which may be done in the real-time
+    // audio thread) does not allocate memory
+    void Reserve ( const int iMaxMemSize )
+    {
+        vecMemory.reserve ( iMaxMemSize );
+        vecTempMemory.reserve ( iMaxMemSize );
+    }
+
+    // releases the memory, the buffer must be initialized again before it is
+    // used
+    void Release()
+    {
+        vecMemory.Free();
+        vecTempMemory.Free();
+
+        iMemSize       = 0;
+        iGetPos        = 0;
+        iPutPos        = 0;
+        eBufState      = CBufferBase<TData>::BS_EMPTY;
+        bIsInitialized = false;
+    }
+
+    int GetMemUsage() const { return vecMemory.GetMemUsage() + vecTempMemory.GetMemUsage(); }
+
+    // the memory size which can be used without allocating memory
+    int GetReservedSize() const { return static_cast<int> ( std::min ( vecMemory.capacity(), vecTempMemory.capacity() ) ); }
+
     void Init ( const int  iNewMemSize,
                 const bool bPreserve = false )
     {
@@ -92,8 +135,10 @@ public:
             // definition
             int iCurPos;
 
-            // copy current data in temporary vector
-            CVector<TData> vecTempMemory ( vecMemory );
+            // copy current data in temporary vector (the temporary vector is
+            // a member so that no memory is allocated if the size was reserved)
+            vecTempMemory.Init ( vecMemory.Size() );
+            vecTempMemory = vecMemory;
 
             // resize actual buffer memory
             vecMemory.Init ( iNewMemSize );
@@ -390,6 +435,7 @@ protected:
     }
 
     CVector<TData> vecMemory;
+    CVector<TData> vecTempMemory;
     int            iMemSize;
     int            iGetPos;
     int            iPutPos;
@@ -411,15 +457,67 @@ public:
                 const bool bPreserve = false );
 
     int GetSize() { return iMemSize / iBlockSize; }
+    int GetReservedNumBlocks() const { return GetReservedSize() / iBlockSize; }
 
     virtual bool Put ( const CVector<uint8_t>& vecbyData, const int iInSize );
     virtual bool Get ( CVector<uint8_t>& vecbyData, const int iOutSize );
 
+    // direct access to a block which was put but not yet read, iBlocksBack
+    // counts from the last put block (1) towards the get position, nullptr
+    // is returned if the block is not in the buffer (anymore)
+    uint8_t* GetQueuedBlock ( const int iBlocksBack );
+
 protected:
     int iBlockSize;
 };
 
 
+// Lock-free network buffer (jitter buffer) ------------------------------------
+// Wait-free single producer/single consumer variant of CNetBuf, i.e. one thread
+// may call Put() while another thread calls Get() at the same time without any
+// mutex. The put and get block counters are only written by their own thread
+// and are placed on separate cache lines. Init() must not be called while one
+// of the threads accesses the buffer.
+class CNetBufSPSC
+{
+public:
+    CNetBufSPSC();
+
+    void Init ( const int  iNewBlockSize,
+                const int  iNewNumBlocks,
+                const bool bPreserve = false );
+
+    int GetSize() const { return iNumBlocks; }
+    int GetBlockSize() const { return iBlockSize; }
+
+    // same semantics as in CNetBuf: the put fails if the buffer is full or the
+    // size is not a multiple of the block size, the get fails if the buffer is
+    // empty or the size does not match the block size
+    bool Put ( const CVector<uint8_t>& vecbyData, const int iInSize );
+    bool Get ( CVector<uint8_t>& vecbyData, const int iOutSize );
+
+    int GetAvailData() const;
+    int GetAvailSpace() const { return iNumBlocks * iBlockSize - GetAvailData(); }
+
+protected:
+    CVector<uint8_t> vecMemory;
+    int              iBlockSize;
+    int              iNumBlocks;
+
+    // The put and get block positions run from 0 to 2 * iNumBlocks - 1, i.e.
+    // a full and an empty buffer can be distinguished without an additional
+    // state variable which would be written by both threads.
+    int NextPos ( const int iPos, const int iNumBl ) const { return ( iPos + iNumBl ) % ( 2 * iNumBlocks ); }
+    int NumBlocksAvail ( const int iPut, const int iGet ) const { return ( iPut - iGet + 2 * iNumBlocks ) % ( 2 * iNumBlocks ); }
+
+    char             cPadPut[CACHE_LINE_SIZE_BYTES];
+    QAtomicInt       iPutPos;
+    char             cPadGet[CACHE_LINE_SIZE_BYTES];
+    QAtomicInt       iGetPos;
+    char             cPadEnd[CACHE_LINE_SIZE_BYTES];
+};
+
+
 // Network buffer (jitter buffer) with statistic calculations ------------------
 class CNetBufWithStats : public CNetBuf
 {
@@ -436,23 +534,67 @@ public:
     virtual bool Get ( CVector<uint8_t>& vecbyData, const int iOutSize );
 
     int GetAutoSetting() { return iCurAutoBufferSizeSetting; }
+
+    // the auto setting starts with this number of blocks after the next init
+    // (e.g. the last good setting for the server), zero for the default, see
+    // UpdateWarmupSetting() for the warmup which follows
+    void SetAutoStartSetting ( const int iNumBlocks ) { iAutoStartSetting = iNumBlocks; }
+
+    // time since the kernel has received the blocks of the following puts
+    // (zero if unknown): a block which was received before the last get but
+    // is put after it (i.e. the receive thread was late) was available for
+    // that get, the statistic does not count this as an underrun
+    void SetPutRecDelay ( const int iNPutRecDelayNs ) { iPutRecDelayNs = iNPutRecDelayNs; }
+
+    // measured average number of blocks which are waiting in the buffer after
+    // a block was taken, i.e. the queueing delay in blocks (in 1/1000 blocks,
+    // can be read by any thread)
+    int GetAvFillMilliBlocks() const { return iAvFillMilliBlocks.loadAcquire(); }
+
+    // the error rates are read from the snapshot of the last get, i.e. they can
+    // be read by any thread
     void GetErrorRates ( CVector<double>& vecErrRates,
                          double&          dLimit,
-                         double&          dMaxUpLimit );
+                         double&          dMaxUpLimit ) const;
 
 protected:
+    struct SErrorRates
+    {
+        double vdErrorRate[NUM_STAT_SIMULATION_BUFFERS];
+        double dLimit;
+        double dMaxUpLimit;
+    };
+
     void UpdateAutoSetting();
+    void UpdateWarmupSetting();
     void ResetInitCounter();
 
-    // statistic (do not use the vector class since the classes do not have
-    // appropriate copy constructor/operator)
-    CErrorRate ErrorRateStatistic[NUM_STAT_SIMULATION_BUFFERS];
-    CNetBuf    SimulationBuffer[NUM_STAT_SIMULATION_BUFFERS];
+    // returns false if the error was not counted (double error)
+    bool UpdateErrorRate ( const int iSimIdx, const bool bIsError );
+    void RevokeError ( const int iSimIdx );
+
+    // statistic: the simulation buffers are only represented by their fill
+    // level in bytes (no data is stored) and the error rates are running
+    // averages which do not need any history memory
     int        viBufSizesForSim[NUM_STAT_SIMULATION_BUFFERS];
+    int        viSimBufFill[NUM_STAT_SIMULATION_BUFFERS];
+    int        viSimBufMemSize[NUM_STAT_SIMULATION_BUFFERS];
+    double     vdErrorRate[NUM_STAT_SIMULATION_BUFFERS];
+    int        viErrorRateCnt[NUM_STAT_SIMULATION_BUFFERS];
+    bool       vbPrevErrorState[NUM_STAT_SIMULATION_BUFFERS];
+    bool       vbLastGetUnderrun[NUM_STAT_SIMULATION_BUFFERS];
+
+    QElapsedTimer StatTimer;
+    qint64     iLastGetTimeNs;
+    int        iPutRecDelayNs;
 
     double     dCurIIRFilterResult;
+    double     dAvFillBlocks;
+    QAtomicInt iAvFillMilliBlocks;
     int        iCurDecidedResult;
     int        iInitCounter;
+    int        iWarmupCounter;
+    int        iAutoStartSetting;
     int        iCurAutoBufferSizeSetting;
     int        iMaxStatisticCount;
 
@@ -463,6 +605,8 @@ protected:
     double     dAutoFilt_WightDownFast;
     double     dErrorRateBound;
     double     dUpMaxErrorBound;
+
+    CTelemetrySnapshot<SErrorRates> ErrorRatesSnapshot;
 };
 
 
@@ -484,6 +628,17 @@ public:
         Reset();
     }
 
+    // releases the memory (same state as Init ( 0 ))
+    void Release()
+    {
+        vecMemory.Free();
+        iMemSize    = 0;
+        iBufferSize = 0;
+        Reset();
+    }
+
+    int GetMemUsage() const { return vecMemory.GetMemUsage(); }
+
     void Reset()
     {
         iPutPos = 0;
@@ -500,17 +655,24 @@ public:
         }
     }
 
-    void PutAll ( const CVector<TData>& vecsData )
+    // the pointer versions are used for buffers which are not stored in a
+    // vector (e.g. the rows of the server frame arena)
+    void PutAll ( const CVector<TData>& vecsData ) { PutAll ( vecsData.data() ); }
+
+    void PutAll ( const TData* pData )
     {
         iGetPos = 0;
 
-        std::copy ( vecsData.begin(),
-                    vecsData.begin() + iBufferSize, // note that input vector might be larger then memory size
+        std::copy ( pData,
+                    pData + iBufferSize, // note that input vector might be larger then memory size
                     vecMemory.begin() );
     }
 
     bool Put ( const CVector<TData>& vecsData,
-               const int             iVecSize )
+               const int             iVecSize ) { return Put ( vecsData.data(), iVecSize ); }
+
+    bool Put ( const TData* pData,
+               const int    iVecSize )
     {
         // calculate the input size and the end position after copying
         const int iEnd = iPutPos + iVecSize;
@@ -519,8 +681,8 @@ public:
         if ( iEnd <= iBufferSize )
         {
             // copy new data in internal buffer
-            std::copy ( vecsData.begin(),
-                        vecsData.begin() + iVecSize,
+            std::copy ( pData,
+                        pData + iVecSize,
                         vecMemory.begin() + iPutPos );
 
             // set buffer pointer one block further
@@ -541,18 +703,24 @@ public:
     }
 
     void GetAll ( CVector<TData>& vecsData,
-                  const int       iVecSize )
+                  const int       iVecSize ) { GetAll ( vecsData.data(), iVecSize ); }
+
+    void GetAll ( TData*    pData,
+                  const int iVecSize )
     {
         iPutPos = 0;
 
         // copy data from internal buffer in given buffer
         std::copy ( vecMemory.begin(),
                     vecMemory.begin() + iVecSize,
-                    vecsData.begin() );
+                    pData );
     }
 
     bool Get ( CVector<TData>& vecsData,
-               const int       iVecSize )
+               const int       iVecSize ) { return Get ( vecsData.data(), iVecSize ); }
+
+    bool Get ( TData*    pData,
+               const int iVecSize )
     {
         // calculate the input size and the end position after copying
         const int iEnd = iGetPos + iVecSize;
@@ -563,7 +731,7 @@ public:
             // copy new data from internal buffer
             std::copy ( vecMemory.begin() + iGetPos,
                         vecMemory.begin() + iGetPos + iVecSize,
-                        vecsData.begin() );
+                        pData );
 
             // set buffer pointer one block further
             iGetPos = iEnd;
@@ -582,3 +750,195 @@ protected:
     int            iBufferSize;
     int            iPutPos, iGetPos;
 };
+
+
+// In-place conversion buffer --------------------------------------------------
+// Single ring buffer for converting between the sound card block size and the
+// internal block size if one is not an integer multiple of the other. The
+// blocks are processed in place in the ring buffer memory, i.e. every sample is
+// copied once in and once out, and the output is delayed by exactly one inner
+// block. Since the memory size is an integer multiple of the inner block size,
+// the inner blocks never wrap around.
+template<class TData> class CInPlaceConvBuf
+{
+public:
+    CInPlaceConvBuf() { Init ( 0, 0 ); }
+
+    void Init ( const int iNewBlockSize,
+                const int iNewOuterSize )
+    {
+        iBlockSize = iNewBlockSize;
+
+        // the worst case fill level is one inner block (the delay) plus one
+        // outer block, rounded up to an integer multiple of the inner block
+        if ( iBlockSize > 0 )
+        {
+            iMemSize = ( ( iNewOuterSize + iBlockSize - 1 ) / iBlockSize + 1 ) * iBlockSize;
+        }
+        else
+        {
+            iMemSize = 0;
+        }
+
+        // the first inner block is the initial delay which is output as zeros
+        vecMemory.Init ( iMemSize, 0 );
+        iGetPos     = 0;
+        iPutPos     = iBlockSize;
+        iProcessPos = iBlockSize;
+    }
+
+    void Put ( const TData* pData,
+               const int    iSize )
+    {
+        const int iFirstPart = std::min ( iSize, iMemSize - iPutPos );
+
+        std::copy ( pData, pData + iFirstPart, vecMemory.begin() + iPutPos );
+        std::copy ( pData + iFirstPart, pData + iSize, vecMemory.begin() );
+
+        iPutPos = ( iPutPos + iSize ) % iMemSize;
+    }
+
+    // returns the next complete inner block which has to be processed in place
+    // or a null pointer if no complete block is available
+    TData* GetNextBlock()
+    {
+        int iAvail = iPutPos - iProcessPos;
+
+        if ( iAvail < 0 )
+        {
+            iAvail += iMemSize;
+        }
+
+        if ( iAvail < iBlockSize )
+        {
+            return nullptr;
+        }
+
+        TData* pBlock = &vecMemory[iProcessPos];
+        iProcessPos   = ( iProcessPos + iBlockSize ) % iMemSize;
+
+        return pBlock;
+    }
+
+    void Get ( TData*    pData,
+               const int iSize )
+    {
+        const int iFirstPart = std::min ( iSize, iMemSize - iGetPos );
+
+        std::copy ( vecMemory.begin() + iGetPos, vecMemory.begin() + iGetPos + iFirstPart, pData );
+        std::copy ( vecMemory.begin(), vecMemory.begin() + iSize - iFirstPart, pData + iFirstPart );
+
+        iGetPos = ( iGetPos + iSize ) % iMemSize;
+    }
+
+protected:
+    CVector<TData> vecMemory;
+    int            iMemSize;
+    int            iBlockSize;
+    int            iPutPos, iProcessPos, iGetPos;
+};
+
+
+// Lock-free sample FIFO -------------------------------------------------------
+// Wait-free single producer/single consumer FIFO for audio samples with
+// arbitrary put and get sizes, used by sound card backends with separate input
+// and output callback threads. It uses the same scheme as CNetBufSPSC, i.e. the
+// positions run from 0 to 2 * iMemSize - 1 and each one is only written by its
+// own thread. Init() must not be called while one of the threads accesses the
+// FIFO.
+template<class TData> class CSampleFifoSPSC
+{
+public:
+    CSampleFifoSPSC() : iMemSize ( 0 ), iPutPos ( 0 ), iGetPos ( 0 ) {}
+
+    void Init ( const int iNewMemSize )
+    {
+        vecMemory.Init ( iNewMemSize, 0 );
+        iMemSize = iNewMemSize;
+
+        iGetPos.storeRelease ( 0 );
+        iPutPos.storeRelease ( 0 );
+    }
+
+    int GetSize() const { return iMemSize; }
+
+    int GetAvailData() const
+    {
+        if ( iMemSize == 0 )
+        {
+            return 0;
+        }
+
+        return NumAvail ( iPutPos.loadAcquire(), iGetPos.loadAcquire() );
+    }
+
+    int GetAvailSpace() const { return iMemSize - GetAvailData(); }
+
+    // the put fails if there is not enough space and the get fails if there
+    // is not enough data, nothing is copied in these cases
+    bool Put ( const TData* pData,
+               const int    iSize )
+    {
+        if ( ( iSize <= 0 ) || ( iSize > GetAvailSpace() ) )
+        {
+            return false;
+        }
+
+        const int iCurPutPos = iPutPos.loadAcquire();
+        const int iOffs      = iCurPutPos % iMemSize;
+        const int iFirstPart = std::min ( iSize, iMemSize - iOffs );
+
+        std::copy ( pData, pData + iFirstPart, vecMemory.begin() + iOffs );
+        std::copy ( pData + iFirstPart, pData + iSize, vecMemory.begin() );
+
+        // publish the new samples to the consumer
+        iPutPos.storeRelease ( NextPos ( iCurPutPos, iSize ) );
+
+        return true;
+    }
+
+    bool Get ( TData*    pData,
+               const int iSize )
+    {
+        if ( ( iSize <= 0 ) || ( iSize > GetAvailData() ) )
+        {
+            return false;
+        }
+
+        const int iCurGetPos = iGetPos.loadAcquire();
+        const int iOffs      = iCurGetPos % iMemSize;
+        const int iFirstPart = std::min ( iSize, iMemSize - iOffs );
+
+        std::copy ( vecMemory.begin() + iOffs, vecMemory.begin() + iOffs + iFirstPart, pData );
+        std::copy ( vecMemory.begin(), vecMemory.begin() + iSize - iFirstPart, pData + iFirstPart );
+
+        // release the memory to the producer
+        iGetPos.storeRelease ( NextPos ( iCurGetPos, iSize ) );
+
+        return true;
+    }
+
+    // drops the oldest samples, must be called by the consumer
+    void Discard ( const int iSize )
+    {
+        const int iNumDiscard = std::min ( iSize, GetAvailData() );
+
+        if ( iNumDiscard > 0 )
+        {
+            iGetPos.storeRelease ( NextPos ( iGetPos.loadAcquire(), iNumDiscard ) );
+        }
+    }
+
+protected:
+    int NextPos ( const int iPos, const int iNum ) const { return ( iPos + iNum ) % ( 2 * iMemSize ); }
+    int NumAvail ( const int iPut, const int iGet ) const { return ( iPut - iGet + 2 * iMemSize ) % ( 2 * iMemSize ); }
+
+    CVector<TData> vecMemory;
+    int            iMemSize;
+
+    char           cPadPut[CACHE_LINE_SIZE_BYTES];
+    QAtomicInt     iPutPos;
+    char           cPadGet[CACHE_LINE_SIZE_BYTES];
+    QAtomicInt     iGetPos;
+    char           cPadEnd[CACHE_LINE_SIZE_BYTES];
+};
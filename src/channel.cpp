@@ -27,18 +27,55 @@
 
 // CChannel implementation *****************************************************
 CChannel::CChannel ( const bool bNIsServer ) :
+    pEventQueue            ( nullptr ),
+    iEventChanID           ( 0 ),
+    pFlightRecorder        ( nullptr ),
+    iFlightRecChanID       ( 0 ),
     vecdGains              ( MAX_NUM_CHANNELS, 1.0 ),
     vecdPannings           ( MAX_NUM_CHANNELS, 0.5 ),
+    vecdMixGroupGains      ( MAX_NUM_MIX_GROUPS + 1, 1.0 ),
+    iGainPanChanged        ( 1 ),
+    iMixGroup              ( NO_MIX_GROUP ),
+    iMulticastStream       ( NO_MULTICAST_STREAM ),
+    iSockBufStartDelayMs   ( 0 ),
     bDoAutoSockBufSize     ( true ),
     iFadeInCnt             ( 0 ),
     iFadeInCntMax          ( FADE_IN_NUM_FRAMES_DBLE_FRAMESIZE ),
     bIsEnabled             ( false ),
     bIsServer              ( bNIsServer ),
-    iAudioFrameSizeSamples ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES )
+    iAudioFrameSizeSamples ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES ),
+    iSessionSetupPending   ( 0 )
 {
+    // init the cached socket address
+    CSocket::HostAddrToSockAddr ( InetAddr, SockAddr );
+
     // reset network transport properties
     ResetNetworkTransportProperties();
 
+    // the redundancy mode is only used after it was negotiated
+    bSendRedundancy     = false;
+    iRedFrameSize       = CalcRedFrameSize ( iNetwFrameSize );
+    bRedPrevPacketValid = false;
+    bRedCurPacketValid  = true;
+    byRedSeqNum         = 0;
+    iSockBufBlockSize   = iNetwFrameSize;
+    iRedLastSeqNum      = -1;
+
+    // the sequence mode is only used after it was negotiated, the send time
+    // stamps and the arrival times are taken from the channel clock
+    bSendSeqNum      = false;
+    iSeqNextFrame    = -1;
+    iSeqSendNum      = 0;
+    iSeqLastTransit  = 0;
+    bSeqTransitValid = false;
+    dSeqJitter       = 0.0;
+    SeqTimer.start();
+
+    // the sub-streams are only sent after they were negotiated
+    iNumSendSubStreams = 0;
+    veciSubStreamChanIDs.Init ( CHANNEL_MAX_NUM_SUB_STREAMS );
+    ResetSubStreams();
+
     // initial value for connection time out counter, we calculate the total
     // number of samples here and subtract the number of samples of the block
     // which we take out of the buffer to be independent of block sizes
@@ -53,11 +90,49 @@ CChannel::CChannel ( const bool bNIsServer ) :
     // initialize channel info
     ResetInfo();
 
+    // initialize the connected clients list state (only the client keeps the
+    // list)
+    if ( !bIsServer )
+    {
+        vecChanListInfo.Init ( MAX_NUM_CHANNELS );
+        vecbyChanListPresent.Init ( MAX_NUM_CHANNELS, 0 );
+    }
+    iChanListVersion         = 0;
+    bChanListValid           = false;
+    bChanListResyncRequested = false;
+
+    // initialize the compact channel level message state
+    vecLevelDeltaLast.Init ( MAX_NUM_CHANNELS );
+    vecbyLevelChanged.Init ( MAX_NUM_CHANNELS );
+    ResetChannelLevelDelta();
+
+    bIsListener       = false;
+    bIsForcedListener = false;
+
+    ResetRtt();
+
+    ResetNetStats();
+
+    // the buffers of the server channels are allocated when a client connects
+    bBuffersAllocated = true;
+    iBuffersReleasable.storeRelease ( 0 );
+    iSockBufCapacityReq.storeRelease ( 0 );
+
+    if ( bIsServer )
+    {
+        ReleaseBuffers();
+    }
+    else
+    {
+        UpdateMemUsage();
+    }
+
 
     // Connections -------------------------------------------------------------
 
 // TODO if we later do not fire vectors in the emits, we can remove this again
 qRegisterMetaType<CVector<uint8_t> > ( "CVector<uint8_t>" );
+qRegisterMetaType<CProtMessage> ( "CProtMessage" );
 qRegisterMetaType<CHostAddress> ( "CHostAddress" );
 
     QObject::connect ( &Protocol, &CProtocol::MessReadyForSending,
@@ -73,10 +148,13 @@ qRegisterMetaType<CHostAddress> ( "CHostAddress" );
         this, &CChannel::ReqChanInfo );
 
     QObject::connect ( &Protocol, &CProtocol::ReqConnClientsList,
-        this, &CChannel::ReqConnClientsList );
+        this, [this]() { PostEvent ( CE_REQ_CONN_CLIENTS_LIST ); } );
 
     QObject::connect ( &Protocol, &CProtocol::ConClientListMesReceived,
-        this, &CChannel::ConClientListMesReceived );
+        this, &CChannel::OnConClientListMesReceived );
+
+    QObject::connect ( &Protocol, &CProtocol::ConClientListDeltaMesReceived,
+        this, &CChannel::OnConClientListDeltaMesReceived );
 
     QObject::connect ( &Protocol, &CProtocol::ChangeChanGain,
         this, &CChannel::OnChangeChanGain );
@@ -113,6 +191,36 @@ qRegisterMetaType<CHostAddress> ( "CHostAddress" );
 
     QObject::connect ( &Protocol, &CProtocol::ReqChannelLevelList,
         this, &CChannel::OnReqChannelLevelList );
+
+    QObject::connect ( &Protocol, &CProtocol::ReqChannelLevelDelta,
+        this, &CChannel::OnReqChannelLevelDelta );
+
+    QObject::connect ( &Protocol, &CProtocol::ListenerModeReceived,
+        this, &CChannel::OnListenerModeReceived );
+
+    QObject::connect ( &Protocol, &CProtocol::MixGroupReceived,
+        this, &CChannel::OnMixGroupReceived );
+
+    QObject::connect ( &Protocol, &CProtocol::ChangeMixGroupGain,
+        this, &CChannel::OnChangeMixGroupGain );
+
+    QObject::connect ( &Protocol, &CProtocol::MixGroupListReceived,
+        this, &CChannel::MixGroupListReceived );
+
+    QObject::connect ( &Protocol, &CProtocol::MulticastGroupReceived,
+        this, &CChannel::MulticastGroupReceived );
+
+    QObject::connect ( &Protocol, &CProtocol::MulticastJoinedReceived,
+        this, &CChannel::OnMulticastJoinedReceived );
+
+    QObject::connect ( &Protocol, &CProtocol::ReqNetStats,
+        this, &CChannel::OnReqNetStats );
+
+    QObject::connect ( &Protocol, &CProtocol::NetStatsReceived,
+        this, &CChannel::NetStatsReceived );
+
+    QObject::connect ( &Protocol, &CProtocol::SessionSetupMissing,
+        this, [this]() { PostEvent ( CE_SESSION_SETUP_MISSING ); } );
 }
 
 bool CChannel::ProtocolIsEnabled()
@@ -121,9 +229,10 @@ bool CChannel::ProtocolIsEnabled()
     // successfully audio packets are received from a client
     // for the client, enable protocol if the channel is enabled, i.e., the
     // connection button was hit by the user
+    // (a sub-stream channel has no own protocol, its messages are discarded)
     if ( bIsServer )
     {
-        return IsConnected();
+        return IsConnected() && !IsSubStreamChannel();
     }
     else
     {
@@ -138,18 +247,30 @@ void CChannel::SetEnable ( const bool bNEnStat )
     // set internal parameter
     bIsEnabled = bNEnStat;
 
+    // a client sends the session setup after its first audio packet of the
+    // connection
+    iSessionSetupPending.storeRelease ( ( bNEnStat && !bIsServer ) ? 1 : 0 );
+
     // if channel is not enabled, reset time out count and protocol
     if ( !bNEnStat )
     {
         iConTimeOut = 0;
         Protocol.Reset();
+
+        // the next connection starts with a complete clients list
+        bChanListValid           = false;
+        bChanListResyncRequested = false;
     }
 }
 
 void CChannel::SetAudioStreamProperties ( const EAudComprType eNewAudComprType,
                                           const int           iNewNetwFrameSize,
                                           const int           iNewNetwFrameSizeFact,
-                                          const int           iNewNumAudioChannels )
+                                          const int           iNewNumAudioChannels,
+                                          const bool          bNewUseRedundancy,
+                                          const int           iNewNumSubStreams,
+                                          const bool          bNewUseSeqNum,
+                                          const bool          bNewUseMultitrack )
 {
 /*
     this function is intended for the client (not the server)
@@ -163,6 +284,8 @@ void CChannel::SetAudioStreamProperties ( const EAudComprType eNewAudComprType,
         iNumAudioChannels     = iNewNumAudioChannels;
         iNetwFrameSize        = iNewNetwFrameSize;
         iNetwFrameSizeFact    = iNewNetwFrameSizeFact;
+        iRedFrameSize         = CalcRedFrameSize ( iNetwFrameSize );
+        iNumSubStreams        = iNewNumSubStreams;
 
         // update audio frame size
         if ( eAudioCompressionType == CT_OPUS )
@@ -176,19 +299,36 @@ void CChannel::SetAudioStreamProperties ( const EAudComprType eNewAudComprType,
 
         MutexSocketBuf.lock();
         {
-            // init socket buffer
-            SockBuf.SetUseDoubleSystemFrameSize ( eAudioCompressionType == CT_OPUS ); // NOTE must be set BEFORE the init()
-            SockBuf.Init ( iNetwFrameSize, iCurSockBufNumFrames );
+            // init socket buffer (if we request the redundancy, the sequence
+            // or the multitrack mode, the server may send the packets of that
+            // mode as soon as it has received the new properties)
+            bUseRedundancy = bNewUseRedundancy;
+            bUseMultitrack = bNewUseMultitrack && !bNewUseRedundancy;
+            bUseSeqNum     = bNewUseSeqNum && !bNewUseRedundancy && !bUseMultitrack && ( iNewNumSubStreams == 0 );
+            InitSockBuf();
+
+            // the client receives the packets through the hand-off buffer
+            if ( !bIsServer )
+            {
+                InitHandOffBuf();
+            }
         }
         MutexSocketBuf.unlock();
 
         MutexConvBuf.lock();
         {
-            // init conversion buffer
-            ConvBuf.Init ( iNetwFrameSize * iNetwFrameSizeFact );
+            // init conversion buffer, we only send redundant packets,
+            // sequence numbers and sub-streams after the server has confirmed
+            // them
+            bSendRedundancy    = false;
+            bSendSeqNum        = false;
+            iNumSendSubStreams = 0;
+            InitConvBuf();
         }
         MutexConvBuf.unlock();
 
+        PublishAudioStreamProps();
+
         // fill network transport properties struct
         NetworkTransportProps = GetNetworkTransportPropsFromCurrentSettings();
     }
@@ -198,6 +338,41 @@ void CChannel::SetAudioStreamProperties ( const EAudComprType eNewAudComprType,
     Protocol.CreateNetwTranspPropsMes ( NetworkTransportProps );
 }
 
+void CChannel::ResetSubStreams()
+{
+    iSubStreamParentChanID = INVALID_INDEX;
+    iSubStreamIdx          = 0;
+
+    veciSubStreamChanIDs.Reset ( INVALID_INDEX );
+}
+
+void CChannel::SetSubStreamParent ( const int iNewParentChanID,
+                                    const int iNewSubStreamIdx )
+{
+    iSubStreamParentChanID = iNewParentChanID;
+    iSubStreamIdx          = iNewSubStreamIdx;
+}
+
+void CChannel::SetSubStreamProperties ( const CChannel& ParentChannel )
+{
+    // a sub-stream uses the codec settings of the parent channel but it has
+    // neither redundancy nor sub-streams of its own
+    CNetworkTransportProps NetworkTransportProps =
+        ParentChannel.GetNetworkTransportPropsFromCurrentSettings();
+
+    NetworkTransportProps.iAudioCodingArg = 0;
+
+    ApplyNetworkTransportProps ( NetworkTransportProps );
+}
+
+bool CChannel::HasSubStreamProperties ( const CChannel& ParentChannel ) const
+{
+    return ( eAudioCompressionType == ParentChannel.eAudioCompressionType ) &&
+           ( iNetwFrameSize        == ParentChannel.iNetwFrameSize ) &&
+           ( iNetwFrameSizeFact    == ParentChannel.iNetwFrameSizeFact ) &&
+           ( iNumAudioChannels     == ParentChannel.iNumAudioChannels );
+}
+
 bool CChannel::SetSockBufNumFrames ( const int  iNewNumFrames,
                                      const bool bPreserve )
 {
@@ -211,14 +386,10 @@ bool CChannel::SetSockBufNumFrames ( const int  iNewNumFrames,
         // only apply parameter if new parameter is different from current one
         if ( iCurSockBufNumFrames != iNewNumFrames )
         {
+            RT_SAFETY_CHECK_LOCK ( MutexSocketBuf );
             MutexSocketBuf.lock();
             {
-                // store new value
-                iCurSockBufNumFrames = iNewNumFrames;
-
-                // the network block size is a multiple of the minimum network
-                // block size
-                SockBuf.Init ( iNetwFrameSize, iNewNumFrames, bPreserve );
+                ApplySockBufNumFrames ( iNewNumFrames, bPreserve );
 
                 // store current auto socket buffer size setting in the mutex
                 // region since if we use the current parameter below in the
@@ -239,9 +410,9 @@ bool CChannel::SetSockBufNumFrames ( const int  iNewNumFrames,
     {
         // we cannot call the "CreateJitBufMes" function directly since
         // this would give us problems with different threads (e.g. the
-        // timer thread) and the protocol mechanism (problem with
-        // qRegisterMetaType(), etc.)
-        emit ServerAutoSockBufSizeChange ( iNewNumFrames );
+        // timer thread), the message is created by the main thread of the
+        // server
+        PostEvent ( CE_AUTO_SOCK_BUF_SIZE, iNewNumFrames );
     }
 
     return ReturnValue; // set error flag
@@ -252,8 +423,9 @@ void CChannel::SetGain ( const int    iChanID,
 {
     QMutexLocker locker ( &Mutex );
 
-    // set value (make sure channel ID is in range)
-    if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) )
+    // set value (make sure channel ID is in range, the gains of an idle
+    // server channel are not allocated)
+    if ( ( iChanID >= 0 ) && ( iChanID < vecdGains.Size() ) )
     {
         // signal mute change
         if ( ( vecdGains[iChanID] == 0 ) && ( dNewGain > 0 ) )
@@ -266,6 +438,7 @@ void CChannel::SetGain ( const int    iChanID,
         }
 
         vecdGains[iChanID] = dNewGain;
+        iGainPanChanged.storeRelease ( 1 );
     }
 }
 
@@ -274,7 +447,7 @@ double CChannel::GetGain ( const int iChanID )
     QMutexLocker locker ( &Mutex );
 
     // get value (make sure channel ID is in range)
-    if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) )
+    if ( ( iChanID >= 0 ) && ( iChanID < vecdGains.Size() ) )
     {
         return vecdGains[iChanID];
     }
@@ -290,9 +463,10 @@ void CChannel::SetPan ( const int    iChanID,
     QMutexLocker locker ( &Mutex );
 
     // set value (make sure channel ID is in range)
-    if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) )
+    if ( ( iChanID >= 0 ) && ( iChanID < vecdPannings.Size() ) )
     {
         vecdPannings[iChanID] = dNewPan;
+        iGainPanChanged.storeRelease ( 1 );
     }
 }
 
@@ -301,7 +475,7 @@ double CChannel::GetPan ( const int iChanID )
     QMutexLocker locker ( &Mutex );
 
     // get value (make sure channel ID is in range)
-    if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) )
+    if ( ( iChanID >= 0 ) && ( iChanID < vecdPannings.Size() ) )
     {
         return vecdPannings[iChanID];
     }
@@ -311,18 +485,103 @@ double CChannel::GetPan ( const int iChanID )
     }
 }
 
+void CChannel::SetMixGroupGain ( const int    iMixGroup,
+                                 const double dNewGain )
+{
+    QMutexLocker locker ( &Mutex );
+
+    // the gain of "no mix group" stays at unity
+    if ( ( iMixGroup > NO_MIX_GROUP ) && ( iMixGroup < vecdMixGroupGains.Size() ) )
+    {
+        vecdMixGroupGains[iMixGroup] = dNewGain;
+        iGainPanChanged.storeRelease ( 1 );
+    }
+}
+
+void CChannel::SetMixGroup ( const int iNewMixGroup )
+{
+    // the server informs all clients about the changed mix group
+    if ( iMixGroup.fetchAndStoreOrdered ( iNewMixGroup ) != iNewMixGroup )
+    {
+        PostEvent ( CE_MIX_GROUP_CHANGED );
+    }
+}
+
+void CChannel::ResetMixGroup()
+{
+    SetMixGroup ( NO_MIX_GROUP );
+
+    QMutexLocker locker ( &Mutex );
+
+    vecdMixGroupGains.Reset ( 1.0 );
+    iGainPanChanged.storeRelease ( 1 );
+}
+
+bool CChannel::SendsPlainPackets ( const int iNumCodedBlocks )
+{
+    QMutexLocker locker ( &MutexConvBuf );
+
+    // each coded block is sent in a packet of its own without sequence number
+    // and redundancy and no sub-stream is added
+    return !bSendSeqNum && !bSendRedundancy && ( iNumSendSubStreams == 0 ) &&
+           ( iNetwFrameSizeFact == iNumCodedBlocks );
+}
+
+bool CChannel::GetGainsAndPanningsIfChanged ( CVector<double>& vecdOutGains,
+                                              CVector<double>& vecdOutPannings,
+                                              CVector<double>& vecdOutMixGroupGains )
+{
+    // the flag is reset before the values are copied, a change which happens
+    // in between is therefore not lost but only causes an additional copy
+    if ( !iGainPanChanged.testAndSetOrdered ( 1, 0 ) )
+    {
+        return false;
+    }
+
+    QMutexLocker locker ( &Mutex );
+
+    // the output vectors may be smaller (size of the channel table of the server)
+    const int iNumGains = std::min ( vecdGains.Size(), vecdOutGains.Size() );
+    const int iNumPans  = std::min ( vecdPannings.Size(), vecdOutPannings.Size() );
+
+    std::copy ( vecdGains.begin(),    vecdGains.begin() + iNumGains,   vecdOutGains.begin() );
+    std::copy ( vecdPannings.begin(), vecdPannings.begin() + iNumPans, vecdOutPannings.begin() );
+
+    std::copy ( vecdMixGroupGains.begin(), vecdMixGroupGains.end(), vecdOutMixGroupGains.begin() );
+
+    return true;
+}
+
 void CChannel::SetChanInfo ( const CChannelCoreInfo& NChanInf )
 {
-    // apply value (if different from previous one)
-    if ( ChannelInfo != NChanInf )
+    bool bChanInfoChanged = false;
+
+    Mutex.lock();
     {
-        ChannelInfo = NChanInf;
+        // apply value (if different from previous one)
+        if ( ChannelInfo != NChanInf )
+        {
+            ChannelInfo      = NChanInf;
+            bChanInfoChanged = true;
+        }
+    }
+    Mutex.unlock();
 
-        // fire message that the channel info has changed
-        emit ChanInfoHasChanged();
+    // fire message that the channel info has changed (outside the mutex region
+    // since the server reads the info of all channels in response)
+    if ( bChanInfoChanged )
+    {
+        PostEvent ( CE_CHAN_INFO_CHANGED );
     }
 }
 
+CChannelCoreInfo CChannel::GetChanInfo()
+{
+    QMutexLocker locker ( &Mutex );
+
+    return ChannelInfo;
+}
+
 QString CChannel::GetName()
 {
     // make sure the string is not written at the same time when it is
@@ -332,14 +591,14 @@ QString CChannel::GetName()
     return ChannelInfo.strName;
 }
 
-void CChannel::OnSendProtMessage ( CVector<uint8_t> vecMessage )
+void CChannel::OnSendProtMessage ( CProtMessage Message )
 {
     // only send messages if protocol is enabled, otherwise delete complete
     // queue
     if ( ProtocolIsEnabled() )
     {
         // emit message to actually send the data
-        emit MessReadyForSending ( vecMessage );
+        emit MessReadyForSending ( Message );
     }
     else
     {
@@ -388,6 +647,196 @@ void CChannel::OnChangeChanInfo ( CChannelCoreInfo ChanInfo )
     SetChanInfo ( ChanInfo );
 }
 
+void CChannel::OnConClientListMesReceived ( CVector<CChannelInfo> vecChanInfo )
+{
+    // a complete list of the old message type, the next change message needs a
+    // complete list first
+    bChanListValid = false;
+
+    emit ConClientListMesReceived ( vecChanInfo );
+}
+
+void CChannel::OnConClientListDeltaMesReceived ( int                   iListVersion,
+                                                 int                   iFlags,
+                                                 CVector<CChannelInfo> vecChanInfo,
+                                                 CVector<int>          veciLeftChanIDs )
+{
+    // only the client keeps the connected clients list
+    if ( bIsServer )
+    {
+        return;
+    }
+
+    // a further part of a split list belongs to the current list version
+    const bool bContinued      = ( iFlags & CONN_CLIENTS_LIST_FLAG_CONTINUED ) != 0;
+    const int  iExpListVersion = bContinued ? iChanListVersion : ( ( iChanListVersion + 1 ) & 0xFFFF );
+
+    if ( ( iFlags & CONN_CLIENTS_LIST_FLAG_FULL_LIST ) != 0 )
+    {
+        vecbyChanListPresent.Reset ( 0 );
+
+        bChanListValid           = true;
+        bChanListResyncRequested = false;
+    }
+    else if ( !bChanListValid || ( iListVersion != iExpListVersion ) )
+    {
+        // we missed a change, request the complete list (only once)
+        bChanListValid = false;
+
+        if ( !bChanListResyncRequested )
+        {
+            bChanListResyncRequested = true;
+            Protocol.CreateReqConnClientsList();
+        }
+
+        return;
+    }
+
+    iChanListVersion = iListVersion;
+
+    // apply the changes
+    for ( int i = 0; i < veciLeftChanIDs.Size(); i++ )
+    {
+        if ( ( veciLeftChanIDs[i] >= 0 ) && ( veciLeftChanIDs[i] < MAX_NUM_CHANNELS ) )
+        {
+            vecbyChanListPresent[veciLeftChanIDs[i]] = 0;
+        }
+    }
+
+    for ( int i = 0; i < vecChanInfo.Size(); i++ )
+    {
+        const int iChanID = vecChanInfo[i].iChanID;
+
+        if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) )
+        {
+            vecChanListInfo[iChanID]      = vecChanInfo[i];
+            vecbyChanListPresent[iChanID] = 1;
+        }
+    }
+
+    // the list is shown when all parts were received
+    if ( ( iFlags & CONN_CLIENTS_LIST_FLAG_MORE_PARTS ) != 0 )
+    {
+        return;
+    }
+
+    // the list is sorted by the channel ID like the list created by the server
+    CVector<CChannelInfo> vecCurChanInfo ( 0 );
+
+    for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+    {
+        if ( vecbyChanListPresent[i] )
+        {
+            vecCurChanInfo.Add ( vecChanListInfo[i] );
+        }
+    }
+
+    emit ConClientListMesReceived ( vecCurChanInfo );
+}
+
+void CChannel::ResetChannelLevelDelta()
+{
+    // a new client has to opt in again, the first message is a full list
+    iLevelDeltaInterval     = 0;
+    iLevelDeltaCurInterval  = 0;
+    iLevelDeltaCounter      = 0;
+    iLevelDeltaSeqNum       = 0;
+    iLevelDeltaNumSinceFull = 0;
+    iLevelDeltaNumClients   = INVALID_INDEX;
+}
+
+void CChannel::ResetRtt()
+{
+    QMutexLocker locker ( &Mutex );
+
+    dSmoothedRttMs = 0.0;
+    dRttVarMs      = 0.0;
+    bRttValid      = false;
+
+    iRttMsPublished.storeRelease ( -1 );
+    iRttJitterMsPublished.storeRelease ( -1 );
+}
+
+void CChannel::UpdateRtt ( const int iRttMs )
+{
+    QMutexLocker locker ( &Mutex );
+
+    // estimator of the TCP retransmission timer (RFC 6298): the smoothed
+    // round trip time with gain 1/8 and the mean deviation (our jitter
+    // measure) with gain 1/4
+    if ( !bRttValid )
+    {
+        dSmoothedRttMs = iRttMs;
+        dRttVarMs      = iRttMs / 2.0;
+        bRttValid      = true;
+    }
+    else
+    {
+        dRttVarMs      = 0.75 * dRttVarMs + 0.25 * fabs ( dSmoothedRttMs - iRttMs );
+        dSmoothedRttMs = 0.875 * dSmoothedRttMs + 0.125 * iRttMs;
+    }
+
+    // the rounded results can be read without locking
+    iRttMsPublished.storeRelease ( static_cast<int> ( dSmoothedRttMs + 0.5 ) );
+    iRttJitterMsPublished.storeRelease ( static_cast<int> ( dRttVarMs + 0.5 ) );
+}
+
+bool CChannel::UpdateChannelLevelDelta ( const CVector<uint16_t>& vecLevelList,
+                                         const int                iNumClients,
+                                         bool&                    bFullList,
+                                         int&                     iSeqNum )
+{
+    // the interval is set by the protocol thread, take a copy which is used
+    // for this update
+    const int iInterval = iLevelDeltaInterval;
+
+    if ( iInterval != iLevelDeltaCurInterval )
+    {
+        // a changed interval starts with a full list
+        iLevelDeltaCurInterval = iInterval;
+        iLevelDeltaCounter     = 0;
+        iLevelDeltaNumClients  = INVALID_INDEX;
+    }
+
+    // rate limit: only every n-th level update is considered
+    if ( ++iLevelDeltaCounter < iInterval )
+    {
+        return false;
+    }
+
+    iLevelDeltaCounter = 0;
+
+    // a changed number of clients invalidates the order of the levels
+    bFullList = ( iNumClients != iLevelDeltaNumClients ) ||
+                ( ++iLevelDeltaNumSinceFull >= CHANNEL_LEVEL_DELTA_FULL_INTERVAL );
+
+    bool bAnyChanged = false;
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        vecbyLevelChanged[i] = ( vecLevelList[i] != vecLevelDeltaLast[i] );
+        bAnyChanged          = bAnyChanged || vecbyLevelChanged[i];
+        vecLevelDeltaLast[i] = vecLevelList[i];
+    }
+
+    // nothing to transmit if no level has changed
+    if ( !bFullList && !bAnyChanged )
+    {
+        return false;
+    }
+
+    if ( bFullList )
+    {
+        iLevelDeltaNumSinceFull = 0;
+        iLevelDeltaNumClients   = iNumClients;
+    }
+
+    iSeqNum           = iLevelDeltaSeqNum;
+    iLevelDeltaSeqNum = ( iLevelDeltaSeqNum + 1 ) & 0xFF;
+
+    return true;
+}
+
 bool CChannel::GetAddress ( CHostAddress& RetAddr )
 {
     QMutexLocker locker ( &Mutex );
@@ -406,7 +855,9 @@ bool CChannel::GetAddress ( CHostAddress& RetAddr )
 
 void CChannel::OnNetTranspPropsReceived ( CNetworkTransportProps NetworkTransportProps )
 {
-    // only the server shall act on network transport properties message
+    // the server applies the received network transport properties, the
+    // client only evaluates the confirmation of the redundancy mode and of
+    // the sub-streams
     if ( bIsServer )
     {
         // OPUS and OPUS64 codecs are the only supported codecs right now
@@ -417,87 +868,431 @@ void CChannel::OnNetTranspPropsReceived ( CNetworkTransportProps NetworkTranspor
             return;
         }
 
-        Mutex.lock();
-        {
-            // store received parameters
-            eAudioCompressionType = NetworkTransportProps.eAudioCodingType;
-            iNumAudioChannels     = static_cast<int> ( NetworkTransportProps.iNumAudioChannels );
-            iNetwFrameSizeFact    = NetworkTransportProps.iBlockSizeFact;
-            iNetwFrameSize        = static_cast<int> ( NetworkTransportProps.iBaseNetworkPacketSize );
+        ApplyNetworkTransportProps ( NetworkTransportProps );
 
-            // update maximum number of frames for fade in counter (only needed for server)
-            // and audio frame size
-            if ( eAudioCompressionType == CT_OPUS )
-            {
-                iFadeInCntMax          = FADE_IN_NUM_FRAMES_DBLE_FRAMESIZE / iNetwFrameSizeFact;
-                iAudioFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
-            }
-            else
-            {
-                iFadeInCntMax          = FADE_IN_NUM_FRAMES / iNetwFrameSizeFact;
-                iAudioFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
-            }
+        // the buffer sizes depend on the transport properties
+        UpdateMemUsage();
 
-            // the fade-in counter maximum value may have changed, make sure the fade-in counter
-            // is not larger than the allowed maximum value
-            iFadeInCnt = std::min ( iFadeInCnt, iFadeInCntMax );
+        // confirm the redundancy mode, the sequence mode and the
+        // sub-streams, the client only sends these packet formats if it knows
+        // that we understand them
+        if ( bUseRedundancy || bUseSeqNum || ( iNumSubStreams > 0 ) )
+        {
+            OnReqNetTranspProps();
+        }
+    }
+    else
+    {
+        QMutexLocker locker ( &MutexConvBuf );
 
-            MutexSocketBuf.lock();
+        // the server has confirmed our request for the redundancy mode
+        if ( ( NetworkTransportProps.iAudioCodingArg & NETW_TRANSP_PROPS_ARG_REDUNDANCY ) != 0 )
+        {
+            if ( bUseRedundancy && !bSendRedundancy )
             {
-                // update socket buffer (the network block size is a multiple of the
-                // minimum network frame size)
-                SockBuf.SetUseDoubleSystemFrameSize ( eAudioCompressionType == CT_OPUS ); // NOTE must be set BEFORE the init()
-                SockBuf.Init ( iNetwFrameSize, iCurSockBufNumFrames );
+                // the redundant frames must belong to the frames of the
+                // packet, therefore we start with a new packet
+                bSendRedundancy = true;
+                InitConvBuf();
             }
-            MutexSocketBuf.unlock();
+        }
 
-            MutexConvBuf.lock();
+        // the server has confirmed our request for the sequence mode
+        if ( ( NetworkTransportProps.iAudioCodingArg & NETW_TRANSP_PROPS_ARG_SEQ_NUM ) != 0 )
+        {
+            if ( bUseSeqNum && !bSendSeqNum )
             {
-                // init conversion buffer
-                ConvBuf.Init ( iNetwFrameSize * iNetwFrameSizeFact );
+                bSendSeqNum = true;
+                InitConvBuf();
             }
-            MutexConvBuf.unlock();
         }
-        Mutex.unlock();
+
+        // the server has confirmed the number of our sub-streams
+        const int iConfNumSubStreams =
+            ( NetworkTransportProps.iAudioCodingArg & NETW_TRANSP_PROPS_ARG_SUB_STREAMS ) >>
+            NETW_TRANSP_PROPS_ARG_SUB_STREAMS_POS;
+
+        if ( ( iNumSubStreams > 0 ) &&
+             ( iConfNumSubStreams == iNumSubStreams ) &&
+             ( iNumSendSubStreams == 0 ) )
+        {
+            // the packet size changes, therefore we start with a new packet
+            iNumSendSubStreams = iNumSubStreams;
+            InitConvBuf();
+        }
     }
 }
 
-void CChannel::OnReqNetTranspProps()
+void CChannel::SetNetwFrameSizeFact ( const int iNewNetwFrameSizeFact )
 {
-    // fill network transport properties struct from current settings and send it
-    Protocol.CreateNetwTranspPropsMes ( GetNetworkTransportPropsFromCurrentSettings() );
-}
+/*
+    this function is intended for the client (not the server)
+*/
+    CNetworkTransportProps NetworkTransportProps;
 
-CNetworkTransportProps CChannel::GetNetworkTransportPropsFromCurrentSettings()
-{
-    // use current stored settings of the channel to fill the network transport
-    // properties structure
-    return CNetworkTransportProps ( static_cast<uint32_t> ( iNetwFrameSize ),
-                                    static_cast<uint16_t> ( iNetwFrameSizeFact ),
-                                    static_cast<uint32_t> ( iNumAudioChannels ),
-                                    SYSTEM_SAMPLE_RATE_HZ,
-                                    eAudioCompressionType,
-                                    0, // version of the codec
-                                    0 );
+    Mutex.lock();
+    {
+        iNetwFrameSizeFact = iNewNetwFrameSizeFact;
+
+        MutexSocketBuf.lock();
+        {
+            InitSockBuf ( true );
+            InitHandOffBuf();
+        }
+        MutexSocketBuf.unlock();
+
+        // the negotiated packet formats are kept, the frames of the current
+        // packet are dropped
+        MutexConvBuf.lock();
+        {
+            InitConvBuf();
+        }
+        MutexConvBuf.unlock();
+
+        NetworkTransportProps = GetNetworkTransportPropsFromCurrentSettings();
+    }
+    Mutex.unlock();
+
+    // tell the server about the new network settings
+    Protocol.CreateNetwTranspPropsMes ( NetworkTransportProps );
 }
 
-void CChannel::Disconnect()
+void CChannel::ApplyNetworkTransportProps ( const CNetworkTransportProps& NetworkTransportProps )
 {
-    // we only have to disconnect the channel if it is actually connected
-    if ( IsConnected() )
+    const bool bNewUseRedundancy =
+        ( ( NetworkTransportProps.iAudioCodingArg & NETW_TRANSP_PROPS_ARG_REDUNDANCY ) != 0 );
+
+    // the sub-streams cannot be combined with the redundancy mode
+    int iNewNumSubStreams =
+        ( NetworkTransportProps.iAudioCodingArg & NETW_TRANSP_PROPS_ARG_SUB_STREAMS ) >>
+        NETW_TRANSP_PROPS_ARG_SUB_STREAMS_POS;
+
+    if ( bNewUseRedundancy || ( iNewNumSubStreams > CHANNEL_MAX_NUM_SUB_STREAMS ) )
     {
-        // set time out counter to a small value > 0 so that the next time a
-        // received audio block is queried, the disconnection is performed
-        // (assuming that no audio packet is received in the meantime)
-        iConTimeOut = 1; // a small number > 0
+        iNewNumSubStreams = 0;
     }
-}
 
-void CChannel::PutProtcolData ( const int               iRecCounter,
-                                const int               iRecID,
-                                const CVector<uint8_t>& vecbyMesBodyData,
-                                const CHostAddress&     RecHostAddr )
-{
+    // the sequence mode is only used for plain packets
+    const bool bNewUseSeqNum =
+        ( ( NetworkTransportProps.iAudioCodingArg & NETW_TRANSP_PROPS_ARG_SEQ_NUM ) != 0 ) &&
+        !bNewUseRedundancy && ( iNewNumSubStreams == 0 );
+
+    // the multitrack frames are sent as plain packets
+    const bool bNewUseMultitrack =
+        ( ( NetworkTransportProps.iAudioCodingArg & NETW_TRANSP_PROPS_ARG_MULTITRACK ) != 0 ) &&
+        !bNewUseRedundancy && !bNewUseSeqNum;
+
+    Mutex.lock();
+    {
+        // a connected client which adapts the number of frames per packet only
+        // changes the frame size factor, then the jitter buffer is kept
+        const bool bOnlyFactChanged =
+            IsConnected() && bBuffersAllocated &&
+            ( iNetwFrameSizeFact    != NetworkTransportProps.iBlockSizeFact ) &&
+            ( eAudioCompressionType == NetworkTransportProps.eAudioCodingType ) &&
+            ( iNumAudioChannels     == static_cast<int> ( NetworkTransportProps.iNumAudioChannels ) ) &&
+            ( iNetwFrameSize        == static_cast<int> ( NetworkTransportProps.iBaseNetworkPacketSize ) ) &&
+            ( iNumSubStreams        == iNewNumSubStreams ) &&
+            ( bUseRedundancy        == bNewUseRedundancy ) &&
+            ( bUseSeqNum            == bNewUseSeqNum ) &&
+            ( bUseMultitrack        == bNewUseMultitrack );
+
+        // store received parameters
+        eAudioCompressionType = NetworkTransportProps.eAudioCodingType;
+        iNumAudioChannels     = static_cast<int> ( NetworkTransportProps.iNumAudioChannels );
+        iNetwFrameSizeFact    = NetworkTransportProps.iBlockSizeFact;
+        iNetwFrameSize        = static_cast<int> ( NetworkTransportProps.iBaseNetworkPacketSize );
+        iRedFrameSize         = CalcRedFrameSize ( iNetwFrameSize );
+        iNumSubStreams        = iNewNumSubStreams;
+
+        // update maximum number of frames for fade in counter (only needed for server)
+        // and audio frame size
+        if ( eAudioCompressionType == CT_OPUS )
+        {
+            iFadeInCntMax          = FADE_IN_NUM_FRAMES_DBLE_FRAMESIZE / iNetwFrameSizeFact;
+            iAudioFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+        }
+        else
+        {
+            iFadeInCntMax          = FADE_IN_NUM_FRAMES / iNetwFrameSizeFact;
+            iAudioFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
+        }
+
+        // the fade-in counter maximum value may have changed, make sure the fade-in counter
+        // is not larger than the allowed maximum value
+        iFadeInCnt = std::min ( iFadeInCnt, iFadeInCntMax );
+
+        PublishAudioStreamProps();
+
+        MutexSocketBuf.lock();
+        {
+            // update socket buffer (the network block size is a multiple of the
+            // minimum network frame size)
+            bUseRedundancy = bNewUseRedundancy;
+            bUseSeqNum     = bNewUseSeqNum;
+            bUseMultitrack = bNewUseMultitrack;
+            InitSockBuf ( bOnlyFactChanged );
+        }
+        MutexSocketBuf.unlock();
+
+        MutexConvBuf.lock();
+        {
+            // init conversion buffer (a client which requests the
+            // redundancy or the sequence mode accepts these packets right away)
+            bSendRedundancy = bNewUseRedundancy;
+            bSendSeqNum     = bNewUseSeqNum;
+            InitConvBuf();
+        }
+        MutexConvBuf.unlock();
+    }
+    Mutex.unlock();
+}
+
+void CChannel::PublishAudioStreamProps()
+{
+    // the values are checked by the protocol: the network frame size is not
+    // larger than MAX_SIZE_BYTES_NETW_BUF and there are one or two channels
+    iAudioStreamProps.storeRelease ( ( static_cast<int> ( eAudioCompressionType ) << 24 ) |
+                                     ( ( iNumAudioChannels & 0xFF ) << 16 ) |
+                                     ( iNetwFrameSize & 0xFFFF ) );
+}
+
+void CChannel::GetAudioStreamProps ( EAudComprType& eOutAudComprType,
+                                     int&           iOutNumAudioChannels,
+                                     int&           iOutNetwFrameSize ) const
+{
+    const int iProps = iAudioStreamProps.loadAcquire();
+
+    eOutAudComprType     = static_cast<EAudComprType> ( ( iProps >> 24 ) & 0xFF );
+    iOutNumAudioChannels = ( iProps >> 16 ) & 0xFF;
+    iOutNetwFrameSize    = iProps & 0xFFFF;
+}
+
+void CChannel::InitSockBuf ( const bool bKeepFrames )
+{
+    // in the redundancy and the sequence mode the jitter buffer blocks have an
+    // additional byte which marks the frames which were recovered from the
+    // redundant copy and the slots of the missing frames
+    iSockBufBlockSize = iNetwFrameSize + ( HasSockBufBlockType() ? 1 : 0 );
+
+    if ( HasMultitrackBlocks() )
+    {
+        iSockBufBlockSize = MULTITRACK_MAX_FRAME_SIZE + 2;
+    }
+
+    // the frame positions of the sequence numbers depend on the number of
+    // frames per packet, therefore they always start again
+    iRedLastSeqNum    = -1; // no sequence number received yet
+    iSeqNextFrame     = -1;
+
+    vecbySeqMissingBlock.Init ( iSockBufBlockSize, CHANNEL_BLOCK_MISSING );
+
+    // the jitter buffer stores single frames, i.e. if only the number of
+    // frames per packet was changed, the queued frames stay valid
+    if ( !bKeepFrames )
+    {
+        SockBuf.SetUseDoubleSystemFrameSize ( eAudioCompressionType == CT_OPUS ); // NOTE must be set BEFORE the init()
+
+        // the start delay is converted with the frame size of the codec
+        const int iFrameSizeSamples = GetCodecFrameSizeSamples ( eAudioCompressionType );
+
+        SockBuf.SetAutoStartSetting ( ( iSockBufStartDelayMs * SYSTEM_SAMPLE_RATE_HZ / 1000 + iFrameSizeSamples - 1 ) /
+                                      iFrameSizeSamples );
+
+        // the auto jitter buffer re-initializes in the audio thread, the memory
+        // for some larger sizes is reserved (see UpdateSockBufCapacity())
+        SockBuf.Reserve ( iSockBufBlockSize * ( iCurSockBufNumFrames + NET_BUF_SIZE_HEADROOM_NUM_BL ) );
+        SockBuf.Init ( iSockBufBlockSize, iCurSockBufNumFrames );
+    }
+
+    vecbySockBufBlocks.Init ( iNetwFrameSizeFact * iSockBufBlockSize );
+}
+
+void CChannel::InitConvBuf()
+{
+    // with sub-streams each frame contains the frames of all streams
+    ConvBuf.Init ( ( iNumSendSubStreams + 1 ) * iNetwFrameSize * iNetwFrameSizeFact );
+
+    // the first packet has no predecessor, it is sent without redundancy
+    RedConvBuf.Init ( iRedFrameSize * iNetwFrameSizeFact );
+    vecbyRedPrevPacket.Init ( iRedFrameSize * iNetwFrameSizeFact );
+    vecbyRedSendPacket.Init ( GetRedPacketSize() );
+    vecbySeqSendPacket.Init ( GetSeqPacketSize() );
+    bRedPrevPacketValid = false;
+    bRedCurPacketValid  = true;
+}
+
+void CChannel::AllocateBuffers()
+{
+    // a new client cancels a pending release
+    iBuffersReleasable.storeRelease ( 0 );
+
+    if ( bBuffersAllocated )
+    {
+        return;
+    }
+
+    Mutex.lock();
+    {
+        vecdGains.Init    ( MAX_NUM_CHANNELS, 1.0 );
+        vecdPannings.Init ( MAX_NUM_CHANNELS, 0.5 );
+        iGainPanChanged.storeRelease ( 1 );
+
+        vecLevelDeltaLast.Init ( MAX_NUM_CHANNELS );
+        vecbyLevelChanged.Init ( MAX_NUM_CHANNELS );
+    }
+    Mutex.unlock();
+
+    MutexSocketBuf.lock();
+    {
+        InitSockBuf();
+    }
+    MutexSocketBuf.unlock();
+
+    MutexConvBuf.lock();
+    {
+        InitConvBuf();
+    }
+    MutexConvBuf.unlock();
+
+    bBuffersAllocated = true;
+
+    UpdateMemUsage();
+}
+
+void CChannel::ReleaseBuffersIfIdle()
+{
+    // the buffers are only released if the timer has finished with the
+    // disconnected channel (and no new client has connected in the meantime)
+    if ( !IsConnected() && iBuffersReleasable.testAndSetOrdered ( 1, 0 ) && bBuffersAllocated )
+    {
+        ReleaseBuffers();
+    }
+}
+
+void CChannel::ReleaseBuffers()
+{
+    Mutex.lock();
+    {
+        vecdGains.Free();
+        vecdPannings.Free();
+        vecLevelDeltaLast.Free();
+        vecbyLevelChanged.Free();
+    }
+    Mutex.unlock();
+
+    MutexSocketBuf.lock();
+    {
+        SockBuf.Release();
+        vecbySockBufBlocks.Free();
+        vecbySeqMissingBlock.Free();
+    }
+    MutexSocketBuf.unlock();
+
+    MutexConvBuf.lock();
+    {
+        ConvBuf.Release();
+        RedConvBuf.Release();
+        vecbyRedPrevPacket.Free();
+        vecbyRedSendPacket.Free();
+        vecbySeqSendPacket.Free();
+    }
+    MutexConvBuf.unlock();
+
+    bBuffersAllocated = false;
+
+    UpdateMemUsage();
+}
+
+void CChannel::UpdateMemUsage()
+{
+    // the fixed part of the channel (including the protocol) and the memory of
+    // the vectors and buffers
+    int iMemUsage = static_cast<int> ( sizeof ( CChannel ) ) +
+                    vecChanListInfo.GetMemUsage() +
+                    vecbyChanListPresent.GetMemUsage() +
+                    veciSubStreamChanIDs.GetMemUsage();
+
+    Mutex.lock();
+    {
+        iMemUsage += vecdGains.GetMemUsage() +
+                     vecdPannings.GetMemUsage() +
+                     vecLevelDeltaLast.GetMemUsage() +
+                     vecbyLevelChanged.GetMemUsage();
+    }
+    Mutex.unlock();
+
+    MutexSocketBuf.lock();
+    {
+        iMemUsage += SockBuf.GetMemUsage() +
+                     vecbySockBufBlocks.GetMemUsage() +
+                     vecbySeqMissingBlock.GetMemUsage() +
+                     vecbyHandOffData.GetMemUsage() +
+                     vecbyHandOffPutData.GetMemUsage();
+    }
+    MutexSocketBuf.unlock();
+
+    MutexConvBuf.lock();
+    {
+        iMemUsage += ConvBuf.GetMemUsage() +
+                     RedConvBuf.GetMemUsage() +
+                     vecbyRedPrevPacket.GetMemUsage() +
+                     vecbyRedSendPacket.GetMemUsage() +
+                     vecbySeqSendPacket.GetMemUsage();
+    }
+    MutexConvBuf.unlock();
+
+    iMemUsageBytes.storeRelease ( iMemUsage );
+}
+
+void CChannel::OnReqNetTranspProps()
+{
+    // fill network transport properties struct from current settings and send it
+    Protocol.CreateNetwTranspPropsMes ( GetNetworkTransportPropsFromCurrentSettings() );
+}
+
+void CChannel::OnReqNetStats()
+{
+    // the other side evaluates the loss of its audio packets on this channel
+    CChannelNetStats NetStats;
+    GetNetStats ( NetStats );
+
+    Protocol.CreateNetStatsMes ( NetStats.iNumReceived, NetStats.iNumLost );
+}
+
+CNetworkTransportProps CChannel::GetNetworkTransportPropsFromCurrentSettings() const
+{
+    // use current stored settings of the channel to fill the network transport
+    // properties structure
+    return CNetworkTransportProps ( static_cast<uint32_t> ( iNetwFrameSize ),
+                                    static_cast<uint16_t> ( iNetwFrameSizeFact ),
+                                    static_cast<uint32_t> ( iNumAudioChannels ),
+                                    SYSTEM_SAMPLE_RATE_HZ,
+                                    eAudioCompressionType,
+                                    0, // version of the codec
+                                    ( bUseRedundancy ? NETW_TRANSP_PROPS_ARG_REDUNDANCY : 0 ) |
+                                    ( bUseSeqNum ? NETW_TRANSP_PROPS_ARG_SEQ_NUM : 0 ) |
+                                    ( bUseMultitrack ? NETW_TRANSP_PROPS_ARG_MULTITRACK : 0 ) |
+                                    ( iNumSubStreams << NETW_TRANSP_PROPS_ARG_SUB_STREAMS_POS ) );
+}
+
+void CChannel::Disconnect()
+{
+    // we only have to disconnect the channel if it is actually connected
+    if ( IsConnected() )
+    {
+        // set time out counter to a small value > 0 so that the next time a
+        // received audio block is queried, the disconnection is performed
+        // (assuming that no audio packet is received in the meantime)
+        iConTimeOut = 1; // a small number > 0
+    }
+}
+
+void CChannel::PutProtcolData ( const int               iRecCounter,
+                                const int               iRecID,
+                                const CVector<uint8_t>& vecbyMesBodyData,
+                                const CHostAddress&     RecHostAddr )
+{
     // Only process protocol message if:
     // - for client only: the packet comes from the server we want to talk to
     // - the channel is enabled
@@ -513,7 +1308,8 @@ void CChannel::PutProtcolData ( const int               iRecCounter,
 
 EPutDataStat CChannel::PutAudioData ( const CVector<uint8_t>& vecbyData,
                                       const int               iNumBytes,
-                                      CHostAddress            RecHostAddr )
+                                      CHostAddress            RecHostAddr,
+                                      const int               iRecDelayNs )
 {
     // init return state
     EPutDataStat eRet = PS_GEN_ERROR;
@@ -524,19 +1320,39 @@ EPutDataStat CChannel::PutAudioData ( const CVector<uint8_t>& vecbyData,
     if ( ( bIsServer || ( GetAddress() == RecHostAddr ) ) &&
          IsEnabled() )
     {
+        // the client does not lock the socket buffer here
+        if ( !bIsServer )
+        {
+            return PutAudioDataHandOff ( vecbyData, iNumBytes, iRecDelayNs );
+        }
+
         MutexSocketBuf.lock();
         {
             // only process audio if packet has correct size
-            if ( iNumBytes == ( iNetwFrameSize * iNetwFrameSizeFact ) )
+            if ( IsValidAudioPacketSize ( iNumBytes ) )
             {
-                // store new packet in jitter buffer
-                if ( SockBuf.Put ( vecbyData, iNumBytes ) )
+                iNumPacketsReceived.fetchAndAddRelaxed ( 1 );
+                iNumBytesReceived.fetchAndAddRelaxed ( iNumBytes );
+
+                if ( bUseSeqNum && ( iNumBytes == GetSeqPacketSize() ) )
+                {
+                    UpdateSeqJitter ( vecbyData, iRecDelayNs );
+                }
+
+                // store new packet in jitter buffer (the statistics of the
+                // automatic buffer size use the kernel receive time)
+                SockBuf.SetPutRecDelay ( iRecDelayNs );
+
+                if ( PutPacketInSockBuf ( vecbyData, iNumBytes ) )
                 {
                     eRet = PS_AUDIO_OK;
+                    RecordFlightEvent ( FR_PACKET, SockBuf.GetAvailData() / iSockBufBlockSize );
                 }
                 else
                 {
+                    iNumBufOverruns.fetchAndAddRelaxed ( 1 );
                     eRet = PS_AUDIO_ERR;
+                    RecordFlightEvent ( FR_OVERRUN );
                 }
 
                 // manage audio fade-in counter
@@ -567,6 +1383,9 @@ EPutDataStat CChannel::PutAudioData ( const CVector<uint8_t>& vecbyData,
 
                 // init audio fade-in counter
                 iFadeInCnt = 0;
+
+                // the counters of the previous connection are not of interest
+                ResetNetStats();
             }
 
             // reset time-out counter (note that this must be done after the
@@ -583,15 +1402,509 @@ EPutDataStat CChannel::PutAudioData ( const CVector<uint8_t>& vecbyData,
     return eRet;
 }
 
+EPutDataStat CChannel::PutAudioDataHandOff ( const CVector<uint8_t>& vecbyData,
+                                             const int               iNumBytes,
+                                             const int               iRecDelayNs )
+{
+    EPutDataStat eRet;
+
+    // announce the access before the enabled state is checked so that the
+    // re-initialization can wait for us
+    iHandOffNumProducers.fetchAndAddOrdered ( 1 );
+    {
+        // only process audio if packet has correct size
+        if ( ( iHandOffEnabled.loadAcquire() != 0 ) &&
+             IsValidAudioPacketSize ( iNumBytes ) &&
+             ( iNumBytes + ( HasMultitrackBlocks() ? 2 : HasSockBufBlockType() ? 1 : 0 ) <= HandOffBuf.GetBlockSize() ) )
+        {
+            iNumPacketsReceived.fetchAndAddRelaxed ( 1 );
+            iNumBytesReceived.fetchAndAddRelaxed ( iNumBytes );
+
+            bool bPutOK;
+
+            if ( bUseSeqNum && ( iNumBytes == GetSeqPacketSize() ) )
+            {
+                // the arrival time must be taken in the socket thread
+                UpdateSeqJitter ( vecbyData, iRecDelayNs );
+            }
+
+            if ( HasMultitrackBlocks() )
+            {
+                // the last two bytes of the block are the packet size
+                const int iBlockSize = HandOffBuf.GetBlockSize();
+
+                std::copy ( vecbyData.begin(),
+                            vecbyData.begin() + iNumBytes,
+                            vecbyHandOffPutData.begin() );
+
+                vecbyHandOffPutData[iBlockSize - 2] = static_cast<uint8_t> ( iNumBytes & 0xFF );
+                vecbyHandOffPutData[iBlockSize - 1] = static_cast<uint8_t> ( iNumBytes >> 8 );
+
+                bPutOK = HandOffBuf.Put ( vecbyHandOffPutData, iBlockSize );
+            }
+            else if ( HasSockBufBlockType() )
+            {
+                // both packet formats are stored in blocks of the larger
+                // packet size, the last byte tells which format it is
+                std::copy ( vecbyData.begin(),
+                            vecbyData.begin() + iNumBytes,
+                            vecbyHandOffPutData.begin() );
+
+                vecbyHandOffPutData[HandOffBuf.GetBlockSize() - 1] =
+                    ( iNumBytes != iNetwFrameSize * iNetwFrameSizeFact ) ? 1 : 0;
+
+                bPutOK = HandOffBuf.Put ( vecbyHandOffPutData, HandOffBuf.GetBlockSize() );
+            }
+            else
+            {
+                bPutOK = HandOffBuf.Put ( vecbyData, iNumBytes );
+            }
+
+            // the jitter buffer depth is recorded by the audio callback
+            if ( bPutOK )
+            {
+                eRet = PS_AUDIO_OK;
+                RecordFlightEvent ( FR_PACKET );
+            }
+            else
+            {
+                // the audio callback did not take the packets in time
+                iNumBufOverruns.fetchAndAddRelaxed ( 1 );
+                eRet = PS_AUDIO_ERR;
+                RecordFlightEvent ( FR_OVERRUN );
+            }
+        }
+        else
+        {
+            // we treat this as protocol error (unkown packet)
+            eRet = PS_PROT_ERR;
+        }
+    }
+    iHandOffNumProducers.fetchAndAddOrdered ( -1 );
+
+    // As for the server, all packets lead to a connected channel. The time-out
+    // counter is only written here if the channel is not connected (then the
+    // audio callback does not touch it), otherwise the audio callback resets
+    // it when it takes the packets.
+    if ( !IsConnected() )
+    {
+        eRet = PS_NEW_CONNECTION;
+
+        // the counters of the previous connection are not of interest
+        ResetNetStats();
+
+        ResetTimeOutCounter();
+    }
+    else
+    {
+        iHandOffPacketReceived.storeRelease ( 1 );
+    }
+
+    return eRet;
+}
+
+bool CChannel::IsValidAudioPacketSize ( const int iNumBytes ) const
+{
+    // in the redundancy and the sequence mode we accept both packet formats
+    // since the packets of these modes are only sent after the negotiation
+    return ( iNumBytes == ( iNetwFrameSize * iNetwFrameSizeFact ) ) ||
+           ( bUseRedundancy && ( iNumBytes == GetRedPacketSize() ) ) ||
+           ( bUseSeqNum && ( iNumBytes == GetSeqPacketSize() ) ) ||
+           ( HasMultitrackBlocks() && ( iNumBytes >= MULTITRACK_HEADER_SIZE ) && ( iNumBytes <= MULTITRACK_MAX_FRAME_SIZE ) );
+}
+
+bool CChannel::PutPacketInSockBuf ( const CVector<uint8_t>& vecbyData,
+                                    const int               iNumBytes )
+{
+    if ( HasMultitrackBlocks() )
+    {
+        // a multitrack frame is one block, a plain packet has a block per frame
+        if ( iNumBytes != iNetwFrameSize * iNetwFrameSizeFact )
+        {
+            return PutMultitrackBlock ( &vecbyData[0], iNumBytes );
+        }
+
+        bool bPutOK = true;
+
+        for ( int i = 0; i < iNetwFrameSizeFact; i++ )
+        {
+            bPutOK = PutMultitrackBlock ( &vecbyData[i * iNetwFrameSize], iNetwFrameSize ) && bPutOK;
+        }
+
+        return bPutOK;
+    }
+
+    if ( bUseSeqNum )
+    {
+        if ( iNumBytes == GetSeqPacketSize() )
+        {
+            return PutSeqPacketInSockBuf ( vecbyData );
+        }
+
+        // a packet without sequence number interrupts the sequence
+        iSeqNextFrame = -1;
+
+        return PutFramesInSockBuf ( &vecbyData[0], iNetwFrameSize, CHANNEL_BLOCK_FRAME );
+    }
+
+    if ( !bUseRedundancy )
+    {
+        return SockBuf.Put ( vecbyData, iNumBytes );
+    }
+
+    bool bPutOK = true;
+
+    if ( iNumBytes == GetRedPacketSize() )
+    {
+        const int iSeqNum = vecbyData[iNumBytes - 1];
+
+        if ( iRedLastSeqNum >= 0 )
+        {
+            const int iSeqDiff = ( iSeqNum - iRedLastSeqNum + 256 ) % 256;
+
+            // a late or duplicated packet is dropped, it was either already
+            // played or recovered from the redundant copy
+            if ( ( iSeqDiff == 0 ) || ( iSeqDiff >= 128 ) )
+            {
+                return true;
+            }
+
+            // exactly one packet is missing: the redundant copy of the missing
+            // frames is stored before the frames of the current packet
+            if ( iSeqDiff == 2 )
+            {
+                bPutOK = PutFramesInSockBuf ( &vecbyData[iNetwFrameSize * iNetwFrameSizeFact], iRedFrameSize, CHANNEL_BLOCK_RED_FRAME );
+            }
+        }
+
+        iRedLastSeqNum = iSeqNum;
+    }
+    else
+    {
+        // a packet without sequence number interrupts the redundant stream
+        iRedLastSeqNum = -1;
+    }
+
+    return PutFramesInSockBuf ( &vecbyData[0], iNetwFrameSize, CHANNEL_BLOCK_FRAME ) && bPutOK;
+}
+
+bool CChannel::PutSeqPacketInSockBuf ( const CVector<uint8_t>& vecbyData )
+{
+    const int iPayloadSize = iNetwFrameSize * iNetwFrameSizeFact;
+    const int iSeqNum      = vecbyData[iPayloadSize] | ( vecbyData[iPayloadSize + 1] << 8 );
+
+    // the frames are counted modulo the number of frames of the sequence
+    // number range
+    const int iNumFramesMod = 65536 * iNetwFrameSizeFact;
+    const int iFrame        = iSeqNum * iNetwFrameSizeFact;
+    const int iNumQueued    = SockBuf.GetAvailData() / iSockBufBlockSize;
+
+    // position of the first frame of the packet relative to the put position
+    // (negative: the slot of the frame is already in the buffer)
+    int iFrameDiff = 0;
+
+    if ( iSeqNextFrame >= 0 )
+    {
+        iFrameDiff = ( iFrame - iSeqNextFrame + iNumFramesMod ) % iNumFramesMod;
+
+        if ( iFrameDiff >= iNumFramesMod / 2 )
+        {
+            iFrameDiff -= iNumFramesMod;
+        }
+    }
+
+    // The stream restarts with this packet if it is late but the jitter
+    // buffer ran empty (dropping it would only give more concealed frames, the
+    // buffer grows as without sequence numbers) or if there are more missing
+    // frames than we can keep slots for (e.g. after a long interruption).
+    if ( ( ( iFrameDiff < 0 ) && ( iNumQueued == 0 ) ) ||
+         ( ( iFrameDiff > 0 ) && ( ( iFrameDiff + iNetwFrameSizeFact ) * iSockBufBlockSize > SockBuf.GetAvailSpace() ) ) )
+    {
+        iFrameDiff = 0;
+    }
+
+    bool bPutOK = true;
+
+    // keep the slots of the missing frames before the packet free
+    for ( int i = 0; i < iFrameDiff; i++ )
+    {
+        bPutOK = SockBuf.Put ( vecbySeqMissingBlock, iSockBufBlockSize ) && bPutOK;
+    }
+
+    int iNumNewFrames = 0;
+
+    for ( int i = 0; i < iNetwFrameSizeFact; i++ )
+    {
+        const uint8_t* pbyFrame = &vecbyData[i * iNetwFrameSize];
+        const int      iPos     = iFrameDiff + i;
+
+        if ( iPos >= 0 )
+        {
+            // a new frame, it is put at the put position
+            std::copy ( pbyFrame,
+                        pbyFrame + iNetwFrameSize,
+                        vecbySockBufBlocks.begin() + iNumNewFrames * iSockBufBlockSize );
+
+            vecbySockBufBlocks[( iNumNewFrames + 1 ) * iSockBufBlockSize - 1] = CHANNEL_BLOCK_FRAME;
+            iNumNewFrames++;
+        }
+        else
+        {
+            // a reordered frame is put in its free slot, a duplicated frame
+            // is ignored and a frame whose slot was already played is late
+            uint8_t* pbySlot = SockBuf.GetQueuedBlock ( -iPos );
+
+            if ( pbySlot == nullptr )
+            {
+                iNumFramesLate.fetchAndAddRelaxed ( 1 );
+            }
+            else if ( pbySlot[iSockBufBlockSize - 1] == CHANNEL_BLOCK_MISSING )
+            {
+                std::copy ( pbyFrame, pbyFrame + iNetwFrameSize, pbySlot );
+                pbySlot[iSockBufBlockSize - 1] = CHANNEL_BLOCK_FRAME;
+            }
+        }
+    }
+
+    if ( iNumNewFrames > 0 )
+    {
+        bPutOK = SockBuf.Put ( vecbySockBufBlocks, iNumNewFrames * iSockBufBlockSize ) && bPutOK;
+    }
+
+    // the put position follows the newest frame
+    if ( ( iSeqNextFrame < 0 ) || ( iFrameDiff + iNetwFrameSizeFact > 0 ) )
+    {
+        iSeqNextFrame = ( iFrame + iNetwFrameSizeFact ) % iNumFramesMod;
+    }
+
+    return bPutOK;
+}
+
+void CChannel::UpdateSeqJitter ( const CVector<uint8_t>& vecbyData,
+                                 const int               iRecDelayNs )
+{
+    // the arrival time is the receive time of the kernel if it is known, i.e.
+    // the wake-up delay of the socket thread is not counted as jitter
+    const int iPayloadSize = iNetwFrameSize * iNetwFrameSizeFact;
+    const int iSendTime    = vecbyData[iPayloadSize + 2] | ( vecbyData[iPayloadSize + 3] << 8 );
+    const int iArrivalTime = static_cast<int> ( ( ( SeqTimer.nsecsElapsed() - iRecDelayNs ) / 1000 / CHANNEL_SEQ_TIME_STAMP_RES_US ) & 0xFFFF );
+
+    // interarrival jitter as in RFC 3550: the mean deviation of the change of
+    // the transit time (the unknown clock offset of the sender cancels out)
+    const int iTransit = ( iArrivalTime - iSendTime ) & 0xFFFF;
+
+    if ( bSeqTransitValid )
+    {
+        int iTransitDiff = ( iTransit - iSeqLastTransit ) & 0xFFFF;
+
+        if ( iTransitDiff >= 32768 )
+        {
+            iTransitDiff -= 65536;
+        }
+
+        dSeqJitter += ( qAbs ( iTransitDiff ) - dSeqJitter ) / 16;
+
+        iSeqJitterUs.storeRelease ( static_cast<int> ( dSeqJitter * CHANNEL_SEQ_TIME_STAMP_RES_US ) );
+    }
+
+    iSeqLastTransit  = iTransit;
+    bSeqTransitValid = true;
+}
+
+bool CChannel::PutMultitrackBlock ( const uint8_t* pbyData,
+                                    const int      iNumBytes )
+{
+    std::copy ( pbyData, pbyData + iNumBytes, vecbySockBufBlocks.begin() );
+
+    vecbySockBufBlocks[iSockBufBlockSize - 2] = static_cast<uint8_t> ( iNumBytes & 0xFF );
+    vecbySockBufBlocks[iSockBufBlockSize - 1] = static_cast<uint8_t> ( iNumBytes >> 8 );
+
+    return SockBuf.Put ( vecbySockBufBlocks, iSockBufBlockSize );
+}
+
+bool CChannel::PutFramesInSockBuf ( const uint8_t* pbyFrames,
+                                    const int      iFrameSize,
+                                    const uint8_t  byIsRedundant )
+{
+    for ( int i = 0; i < iNetwFrameSizeFact; i++ )
+    {
+        std::copy ( pbyFrames + i * iFrameSize,
+                    pbyFrames + ( i + 1 ) * iFrameSize,
+                    vecbySockBufBlocks.begin() + i * iSockBufBlockSize );
+
+        vecbySockBufBlocks[( i + 1 ) * iSockBufBlockSize - 1] = byIsRedundant;
+    }
+
+    return SockBuf.Put ( vecbySockBufBlocks, iNetwFrameSizeFact * iSockBufBlockSize );
+}
+
+void CChannel::InitHandOffBuf()
+{
+    // stop the producer and wait until it has left the ring buffer (the
+    // consumer is excluded by the socket buffer mutex)
+    iHandOffEnabled.fetchAndStoreOrdered ( 0 );
+
+    while ( iHandOffNumProducers.loadAcquire() != 0 )
+    {
+        QThread::yieldCurrentThread();
+    }
+
+    int iBlockSize = iNetwFrameSize * iNetwFrameSizeFact;
+
+    if ( HasMultitrackBlocks() )
+    {
+        iBlockSize = MULTITRACK_MAX_FRAME_SIZE + 2;
+    }
+    else if ( bUseRedundancy )
+    {
+        iBlockSize = GetRedPacketSize() + 1;
+    }
+    else if ( bUseSeqNum )
+    {
+        iBlockSize = GetSeqPacketSize() + 1;
+    }
+
+    HandOffBuf.Init ( iBlockSize, CHANNEL_HAND_OFF_NUM_PACKETS );
+    vecbyHandOffData.Init ( iBlockSize );
+    vecbyHandOffPutData.Init ( iBlockSize );
+
+    iHandOffEnabled.fetchAndStoreOrdered ( 1 );
+}
+
+void CChannel::MoveHandOffToSockBuf()
+{
+    const int iBlockSize = HandOffBuf.GetBlockSize();
+
+    while ( HandOffBuf.Get ( vecbyHandOffData, iBlockSize ) )
+    {
+        int iPacketSize = iBlockSize;
+
+        if ( HasMultitrackBlocks() )
+        {
+            iPacketSize = vecbyHandOffData[iBlockSize - 2] | ( vecbyHandOffData[iBlockSize - 1] << 8 );
+        }
+        else if ( HasSockBufBlockType() )
+        {
+            iPacketSize = ( vecbyHandOffData[iBlockSize - 1] != 0 ) ?
+                iBlockSize - 1 : iNetwFrameSize * iNetwFrameSizeFact;
+        }
+
+        if ( !PutPacketInSockBuf ( vecbyHandOffData, iPacketSize ) )
+        {
+            iNumBufOverruns.fetchAndAddRelaxed ( 1 );
+        }
+    }
+
+    // packets which were received while being connected extend the connection
+    if ( ( iHandOffPacketReceived.fetchAndStoreOrdered ( 0 ) != 0 ) && ( iConTimeOut > 0 ) )
+    {
+        ResetTimeOutCounter();
+    }
+}
+
 EGetDataStat CChannel::GetData ( CVector<uint8_t>& vecbyData,
-                                 const int         iNumBytes )
+                                 const int         iNumBytes,
+                                 int&              iNumCodedBytes )
 {
     EGetDataStat eGetStatus;
+    bool         bSockBufState;
+    bool         bFrameMissing       = false;
+    bool         bSockBufCapacityReq = false;
+    int          iNewAutoSockBufSize = 0;
+
+    iNumCodedBytes = iNumBytes;
 
+    RT_SAFETY_CHECK_LOCK ( MutexSocketBuf );
     MutexSocketBuf.lock();
     {
+        // client: take the newly received packets first
+        if ( !bIsServer )
+        {
+            MoveHandOffToSockBuf();
+        }
+
         // the socket access must be inside a mutex
-        const bool bSockBufState = SockBuf.Get ( vecbyData, iNumBytes );
+        if ( HasMultitrackBlocks() )
+        {
+            // the last two bytes of the block are the size of the frame
+            bSockBufState = SockBuf.Get ( vecbySockBufBlocks, iSockBufBlockSize );
+
+            if ( bSockBufState )
+            {
+                iNumCodedBytes = vecbySockBufBlocks[iSockBufBlockSize - 2] |
+                                 ( vecbySockBufBlocks[iSockBufBlockSize - 1] << 8 );
+
+                if ( iNumCodedBytes <= vecbyData.Size() )
+                {
+                    std::copy ( vecbySockBufBlocks.begin(),
+                                vecbySockBufBlocks.begin() + iNumCodedBytes,
+                                vecbyData.begin() );
+                }
+                else
+                {
+                    iNumCodedBytes = iNumBytes;
+                    bSockBufState  = false;
+                }
+            }
+        }
+        else if ( HasSockBufBlockType() )
+        {
+            // the last byte of the block marks a recovered or a missing frame
+            bSockBufState = ( iNumBytes + 1 == iSockBufBlockSize ) &&
+                            SockBuf.Get ( vecbySockBufBlocks, iSockBufBlockSize );
+
+            if ( bSockBufState )
+            {
+                const uint8_t byBlockType = vecbySockBufBlocks[iSockBufBlockSize - 1];
+
+                if ( byBlockType == CHANNEL_BLOCK_MISSING )
+                {
+                    // the frame was lost (or is late), it is concealed here
+                    bSockBufState = false;
+                    bFrameMissing = true;
+                }
+                else
+                {
+                    std::copy ( vecbySockBufBlocks.begin(),
+                                vecbySockBufBlocks.begin() + iNumBytes,
+                                vecbyData.begin() );
+
+                    if ( byBlockType == CHANNEL_BLOCK_RED_FRAME )
+                    {
+                        iNumCodedBytes = iRedFrameSize;
+                    }
+                }
+            }
+            else if ( bUseSeqNum && ( iSeqNextFrame >= 0 ) )
+            {
+                // the jitter buffer ran empty, the concealed frame takes the
+                // slot of the next frame (which is late if it arrives now)
+                iSeqNextFrame = ( iSeqNextFrame + 1 ) % ( 65536 * iNetwFrameSizeFact );
+            }
+        }
+        else
+        {
+            bSockBufState = SockBuf.Get ( vecbyData, iNumBytes );
+        }
+
+        // The auto setting of the jitter buffer size is only evaluated by the
+        // get of the jitter buffer, therefore the buffer size is only adjusted
+        // here if the decision differs from the current size (the buffer memory
+        // is preserved and reserved, no allocation takes place). A size which
+        // does not fit in the reserved memory is applied after the memory was
+        // grown by UpdateSockBufCapacity().
+        if ( bDoAutoSockBufSize && ( SockBuf.GetAutoSetting() != iCurSockBufNumFrames ) )
+        {
+            if ( SockBuf.GetAutoSetting() <= SockBuf.GetReservedNumBlocks() )
+            {
+                iNewAutoSockBufSize = SockBuf.GetAutoSetting();
+                ApplySockBufNumFrames ( iNewAutoSockBufSize, true );
+            }
+            else if ( iSockBufCapacityReq.testAndSetOrdered ( 0, 1 ) )
+            {
+                bSockBufCapacityReq = true;
+            }
+        }
 
         // decrease time-out counter
         if ( iConTimeOut > 0 )
@@ -616,12 +1929,32 @@ EGetDataStat CChannel::GetData ( CVector<uint8_t>& vecbyData,
                 if ( bSockBufState )
                 {
                     // everything is ok
-                    eGetStatus = GS_BUFFER_OK;
+                    eGetStatus     = GS_BUFFER_OK;
+                    bLastGetFailed = false;
+
+                    RecordFlightEvent ( FR_GET, SockBuf.GetAvailData() / iSockBufBlockSize );
                 }
                 else
                 {
                     // channel is not yet disconnected but no data in buffer
                     eGetStatus = GS_BUFFER_UNDERRUN;
+
+                    // each missing frame is concealed by the decoder, a
+                    // sequence of missing frames counts as one underrun (a
+                    // free slot of the sequence mode is no underrun)
+                    iNumPacketsLost.fetchAndAddRelaxed ( 1 );
+
+                    if ( !bFrameMissing && !bLastGetFailed )
+                    {
+                        iNumBufUnderruns.fetchAndAddRelaxed ( 1 );
+                        bLastGetFailed = true;
+
+                        RecordFlightEvent ( FR_UNDERRUN );
+                    }
+                    else
+                    {
+                        RecordFlightEvent ( FR_CONCEALED );
+                    }
                 }
             }
         }
@@ -633,6 +1966,18 @@ EGetDataStat CChannel::GetData ( CVector<uint8_t>& vecbyData,
     }
     MutexSocketBuf.unlock();
 
+    // the server reports the new auto setting to the client (the protocol
+    // message is created in the main thread, see SetSockBufNumFrames())
+    if ( ( iNewAutoSockBufSize > 0 ) && bIsServer )
+    {
+        PostEvent ( CE_AUTO_SOCK_BUF_SIZE, iNewAutoSockBufSize );
+    }
+
+    if ( bSockBufCapacityReq && bIsServer )
+    {
+        PostEvent ( CE_SOCK_BUF_CAPACITY );
+    }
+
     // in case we are just disconnected, we have to fire a message
     if ( eGetStatus == GS_CHAN_NOW_DISCONNECTED )
     {
@@ -643,17 +1988,178 @@ EGetDataStat CChannel::GetData ( CVector<uint8_t>& vecbyData,
     return eGetStatus;
 }
 
+int CChannel::GetNumBufferedFrames()
+{
+    int iNumFrames;
+
+    RT_SAFETY_CHECK_LOCK ( MutexSocketBuf );
+    MutexSocketBuf.lock();
+    {
+        // one frame is taken by each GetData() call
+        iNumFrames = ( iSockBufBlockSize > 0 ) ? SockBuf.GetAvailData() / iSockBufBlockSize : 0;
+
+        // the packets which are not yet moved from the hand-off buffer are
+        // waiting in the jitter buffer, too
+        if ( !bIsServer && ( HandOffBuf.GetBlockSize() > 0 ) )
+        {
+            iNumFrames += HandOffBuf.GetAvailData() / HandOffBuf.GetBlockSize() *
+                ( HasMultitrackBlocks() ? 1 : iNetwFrameSizeFact );
+        }
+    }
+    MutexSocketBuf.unlock();
+
+    return iNumFrames;
+}
+
+void CChannel::ResetNetStats()
+{
+    iNumPacketsReceived.storeRelease ( 0 );
+    iNumPacketsLost.storeRelease ( 0 );
+    iNumBufOverruns.storeRelease ( 0 );
+    iNumBufUnderruns.storeRelease ( 0 );
+    iNumFramesLate.storeRelease ( 0 );
+    iSeqJitterUs.storeRelease ( 0 );
+    iNumBytesReceived.storeRelease ( 0 );
+    bLastGetFailed   = false;
+    bSeqTransitValid = false;
+    dSeqJitter       = 0.0;
+}
+
+void CChannel::GetNetStats ( CChannelNetStats& NetStats ) const
+{
+    NetStats.iNumReceived  = iNumPacketsReceived.loadAcquire();
+    NetStats.iNumLost      = iNumPacketsLost.loadAcquire();
+    NetStats.iNumOverruns  = iNumBufOverruns.loadAcquire();
+    NetStats.iNumUnderruns = iNumBufUnderruns.loadAcquire();
+    NetStats.iNumLate      = iNumFramesLate.loadAcquire();
+    NetStats.iJitterUs     = iSeqJitterUs.loadAcquire();
+    NetStats.iQueueDelayUs = GetJitBufDelayUs();
+    NetStats.iNumBytes     = iNumBytesReceived.loadAcquire();
+}
+
 void CChannel::PrepAndSendPacket ( CHighPrioSocket*        pSocket,
                                    const CVector<uint8_t>& vecbyNPacket,
-                                   const int               iNPacketLen )
+                                   const int               iNPacketLen,
+                                   const CVector<uint8_t>& vecbyRedPacket,
+                                   const int               iRedPacketLen,
+                                   const bool              bUseSendQueue )
 {
+    RT_SAFETY_CHECK_LOCK ( MutexConvBuf );
     QMutexLocker locker ( &MutexConvBuf );
 
+    if ( bSendRedundancy )
+    {
+        // the redundant frames are collected in parallel to the frames of
+        // the packet, a missing redundant frame (e.g. if the redundancy mode
+        // was just enabled) invalidates the redundant copy of the packet
+        if ( iRedPacketLen == iRedFrameSize )
+        {
+            RedConvBuf.Put ( vecbyRedPacket, iRedPacketLen );
+        }
+        else
+        {
+            RedConvBuf.Put ( vecbyNPacket, iRedFrameSize );
+            bRedCurPacketValid = false;
+        }
+    }
+
     // use conversion buffer to convert sound card block size in network
     // block size
     if ( ConvBuf.Put ( vecbyNPacket, iNPacketLen ) )
     {
-        pSocket->SendPacket ( ConvBuf.GetAll(), GetAddress() );
+        const CVector<uint8_t>& vecbyPacket = ConvBuf.GetAll();
+        const uint8_t*          pbySendData = &vecbyPacket[0];
+        int                     iSendSize   = vecbyPacket.Size();
+
+        if ( bSendRedundancy )
+        {
+            // append the redundant copy of the previous packet and the
+            // sequence number
+            if ( bRedPrevPacketValid )
+            {
+                std::copy ( vecbyPacket.begin(),
+                            vecbyPacket.end(),
+                            vecbyRedSendPacket.begin() );
+
+                std::copy ( vecbyRedPrevPacket.begin(),
+                            vecbyRedPrevPacket.end(),
+                            vecbyRedSendPacket.begin() + vecbyPacket.Size() );
+
+                vecbyRedSendPacket[vecbyRedSendPacket.Size() - 1] = byRedSeqNum;
+
+                pbySendData = &vecbyRedSendPacket[0];
+                iSendSize   = vecbyRedSendPacket.Size();
+            }
+
+            byRedSeqNum++;
+
+            // the redundant frames of this packet are sent with the next one
+            vecbyRedPrevPacket  = RedConvBuf.GetAll();
+            bRedPrevPacketValid = bRedCurPacketValid;
+            bRedCurPacketValid  = true;
+        }
+        else if ( bSendSeqNum )
+        {
+            // append the sequence number and the send time stamp (little
+            // endian)
+            const int iSendTime = static_cast<int> ( ( SeqTimer.nsecsElapsed() / 1000 / CHANNEL_SEQ_TIME_STAMP_RES_US ) & 0xFFFF );
+
+            std::copy ( vecbyPacket.begin(),
+                        vecbyPacket.end(),
+                        vecbySeqSendPacket.begin() );
+
+            vecbySeqSendPacket[vecbyPacket.Size()]     = static_cast<uint8_t> ( iSeqSendNum & 0xFF );
+            vecbySeqSendPacket[vecbyPacket.Size() + 1] = static_cast<uint8_t> ( iSeqSendNum >> 8 );
+            vecbySeqSendPacket[vecbyPacket.Size() + 2] = static_cast<uint8_t> ( iSendTime & 0xFF );
+            vecbySeqSendPacket[vecbyPacket.Size() + 3] = static_cast<uint8_t> ( iSendTime >> 8 );
+
+            iSeqSendNum++;
+
+            pbySendData = &vecbySeqSendPacket[0];
+            iSendSize   = vecbySeqSendPacket.Size();
+        }
+
+        if ( bUseSendQueue )
+        {
+            // the packet is sent when the socket send queue is flushed
+            pSocket->QueuePacket ( pbySendData, iSendSize, SockAddr );
+        }
+        else
+        {
+            pSocket->SendPacket ( pbySendData, iSendSize, SockAddr );
+        }
+
+        // the protocol runs in the main thread
+        if ( ( iSessionSetupPending.loadAcquire() != 0 ) &&
+             iSessionSetupPending.testAndSetOrdered ( 1, 0 ) )
+        {
+            QMetaObject::invokeMethod ( this, "OnFirstPacketSent", Qt::QueuedConnection );
+        }
+    }
+}
+
+void CChannel::PrepAndSendMultitrackFrame ( CHighPrioSocket*  pSocket,
+                                            CVector<uint8_t>& vecbyFrame,
+                                            const int         iFrameLen,
+                                            const bool        bUseSendQueue )
+{
+    // the client tells a multitrack frame from a plain packet by its size,
+    // therefore a frame which has the size of a plain packet or of a frame of
+    // a plain packet is padded (the padding is ignored by the client)
+    int iSendSize = iFrameLen;
+
+    while ( ( iSendSize == iNetwFrameSize ) || ( iSendSize == iNetwFrameSize * iNetwFrameSizeFact ) )
+    {
+        vecbyFrame[iSendSize++] = 0;
+    }
+
+    if ( bUseSendQueue )
+    {
+        pSocket->QueuePacket ( &vecbyFrame[0], iSendSize, SockAddr );
+    }
+    else
+    {
+        pSocket->SendPacket ( &vecbyFrame[0], iSendSize, SockAddr );
     }
 }
 
@@ -667,19 +2173,123 @@ int CChannel::GetUploadRateKbps()
     // 8 (UDP) + 20 (IP without optional fields) = 28 bytes
     // 2 (PPP) + 6 (PPPoE) + 18 (MAC)            = 26 bytes
     // 5 (RFC1483B) + 8 (AAL) + 10 (ATM)         = 23 bytes
-    return ( iNetwFrameSize * iNetwFrameSizeFact + 28 + 26 + 23 /* header */ ) *
+    // the redundant packets contain the low bit rate copy of the previous frames
+    int iPacketSize = ( iNumSendSubStreams + 1 ) * iNetwFrameSize * iNetwFrameSizeFact;
+
+    if ( bSendRedundancy )
+    {
+        iPacketSize = GetRedPacketSize();
+    }
+    else if ( bSendSeqNum )
+    {
+        iPacketSize = GetSeqPacketSize();
+    }
+
+    return ( iPacketSize + 28 + 26 + 23 /* header */ ) *
         8 /* bits per byte */ *
         SYSTEM_SAMPLE_RATE_HZ / iAudioSizeOut / 1000;
 }
 
-void CChannel::UpdateSocketBufferSize()
+void CChannel::UpdateSockBufCapacity()
 {
-    // just update the socket buffer size if auto setting is enabled, otherwise
-    // do nothing
-    if ( bDoAutoSockBufSize )
+    if ( iSockBufCapacityReq.loadAcquire() == 0 )
+    {
+        return;
+    }
+
+    MutexSocketBuf.lock();
     {
-        // use auto setting result from channel, make sure we preserve the
-        // buffer memory since we just adjust the size here
-        SetSockBufNumFrames ( SockBuf.GetAutoSetting(), true );
+        // with some headroom so that the memory does not grow on each step of
+        // the auto setting (the data of the buffer is kept)
+        SockBuf.Reserve ( iSockBufBlockSize * std::min ( SockBuf.GetAutoSetting() + NET_BUF_SIZE_HEADROOM_NUM_BL,
+                                                         MAX_AUTO_NET_BUF_SIZE_NUM_BL ) );
+
+        iSockBufCapacityReq.storeRelease ( 0 );
+    }
+    MutexSocketBuf.unlock();
+
+    UpdateMemUsage();
+}
+
+void CChannel::ApplySockBufNumFrames ( const int  iNewNumFrames,
+                                      const bool bPreserve )
+{
+    // note that the socket buffer mutex must be locked by the caller
+    iCurSockBufNumFrames = iNewNumFrames;
+
+    // the network block size is a multiple of the minimum network
+    // block size
+    SockBuf.Init ( iSockBufBlockSize, iNewNumFrames, bPreserve );
+
+    // the newest frames may have been dropped, the sequence mode
+    // restarts with the next packet
+    iSeqNextFrame = -1;
+}
+
+
+// CChannelEventQueue implementation *******************************************
+void CChannelEventQueue::Post ( const int        iChanID,
+                                const EChanEvent eEvent,
+                                const int        iValue )
+{
+    iEventValues[iChanID][eEvent].storeRelease ( iValue );
+
+    // only the first event of the channel marks the channel and only the first
+    // marked channel after a drain requests the next drain
+    if ( iChanEvents[iChanID].fetchAndOrOrdered ( 1 << eEvent ) == 0 )
+    {
+        iPendingChans[iChanID / 32].fetchAndOrOrdered ( 1 << ( iChanID % 32 ) );
+
+        if ( ( pReceiver != nullptr ) && iDrainRequested.testAndSetOrdered ( 0, 1 ) )
+        {
+            QMetaObject::invokeMethod ( pReceiver, "OnChannelEvents", Qt::QueuedConnection );
+        }
+    }
+}
+
+void CChannelEventQueue::BeginDrain()
+{
+    // a channel which is marked after this point requests a new drain
+    iDrainRequested.storeRelease ( 0 );
+
+    iDrainWordIdx = 0;
+    iDrainBits    = 0;
+}
+
+bool CChannelEventQueue::GetNext ( int& iChanID,
+                                   int& iEvents )
+{
+    while ( true )
+    {
+        // take the next word of marked channels
+        while ( iDrainBits == 0 )
+        {
+            if ( iDrainWordIdx >= NUM_CHAN_WORDS )
+            {
+                return false;
+            }
+
+            iDrainBits = static_cast<unsigned> ( iPendingChans[iDrainWordIdx].fetchAndStoreOrdered ( 0 ) );
+            iDrainWordIdx++;
+        }
+
+        int iBit = 0;
+
+        while ( ( iDrainBits & ( 1u << iBit ) ) == 0 )
+        {
+            iBit++;
+        }
+
+        iDrainBits &= ~( 1u << iBit );
+
+        // a channel is only marked after its event mask was set, i.e. the
+        // mask is never empty here (the check is only defensive)
+        iChanID = ( iDrainWordIdx - 1 ) * 32 + iBit;
+        iEvents = iChanEvents[iChanID].fetchAndStoreOrdered ( 0 );
+
+        if ( iEvents != 0 )
+        {
+            return true;
+        }
     }
 }
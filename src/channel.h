@@ -26,13 +26,18 @@
 
 #include <QThread>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QTextStream>
+#include <QAtomicInt>
 #include "global.h"
 #include "buffer.h"
 #include "util.h"
 #include "protocol.h"
 #include "socket.h"
+#include "rtcheck.h"
+#include "multitrack.h"
+#include "flightrecorder.h"
 
 
 /* Definitions ****************************************************************/
@@ -45,6 +50,44 @@
 #define FADE_IN_NUM_FRAMES                   2250
 #define FADE_IN_NUM_FRAMES_DBLE_FRAMESIZE    1125
 
+// number of received audio packets which can be queued between the socket
+// thread and the audio callback of the client
+#define CHANNEL_HAND_OFF_NUM_PACKETS         16
+
+// size of the low bit rate copy of a frame which is transmitted with the
+// redundancy mode in relation to the size of the frame
+#define CHANNEL_RED_FRAME_SIZE_DIV           3
+
+// maximum number of additional sub-streams which a client can send in its
+// audio packets (each sub-stream is a separate channel at the server)
+#define CHANNEL_MAX_NUM_SUB_STREAMS          3
+
+// size of the sequence header which is appended to the audio packets in the
+// sequence mode (16 bit sequence number and 16 bit send time stamp) and the
+// resolution of the send time stamp
+#define CHANNEL_SEQ_HEADER_SIZE              4
+#define CHANNEL_SEQ_TIME_STAMP_RES_US        125
+
+// type of a jitter buffer block (stored in the additional last byte of the
+// block in the redundancy and the sequence mode)
+#define CHANNEL_BLOCK_FRAME                  0 // frame of the received packet
+#define CHANNEL_BLOCK_RED_FRAME              1 // frame recovered from the redundant copy
+#define CHANNEL_BLOCK_MISSING                2 // slot of a frame which was not received (yet)
+
+
+// events of the server channels which are handled by the main thread of the
+// server (see CChannelEventQueue), the events are bits of a mask
+enum EChanEvent
+{
+    CE_REQ_CONN_CLIENTS_LIST = 0, // the client requests the connected clients list
+    CE_CHAN_INFO_CHANGED     = 1, // the channel info (name, country, etc.) has changed
+    CE_AUTO_SOCK_BUF_SIZE    = 2, // the auto jitter buffer size has changed (value: new size)
+    CE_SESSION_SETUP_MISSING = 3, // the client did not send a session setup
+    CE_MIX_GROUP_CHANGED     = 4, // the client has changed its mix group
+    CE_MULTICAST_OFFER       = 5, // the multicast stream of the client has changed (value: stream)
+    CE_SOCK_BUF_CAPACITY     = 6, // the auto jitter buffer size needs more memory
+    NUM_CHAN_EVENTS
+};
 
 enum EPutDataStat
 {
@@ -60,6 +103,75 @@ enum EPutDataStat
 
 
 /* Classes ********************************************************************/
+// snapshot of the audio packet counters of a channel (all values are counted
+// since the channel was connected)
+class CChannelNetStats
+{
+public:
+    CChannelNetStats() :
+        iNumReceived  ( 0 ),
+        iNumLost      ( 0 ),
+        iNumOverruns  ( 0 ),
+        iNumUnderruns ( 0 ),
+        iNumLate      ( 0 ),
+        iJitterUs     ( 0 ),
+        iQueueDelayUs ( 0 ),
+        iNumBytes     ( 0 ) {}
+
+    int    iNumReceived;  // audio packets with a correct size
+    int    iNumLost;      // frames without data (decoded with a null pointer)
+    int    iNumOverruns;  // packets dropped because the jitter buffer was full
+    int    iNumUnderruns; // number of times the jitter buffer ran empty
+    int    iNumLate;      // frames received after they were concealed (sequence mode)
+    int    iJitterUs;     // packet arrival jitter (sequence mode, zero otherwise)
+    int    iQueueDelayUs; // measured average queueing delay of the jitter buffer in us
+    qint64 iNumBytes;     // audio bytes received
+};
+
+// Lock-free event queue of the server channels. An event is posted by any
+// thread (e.g. the timer thread) into the event mask of the channel, the
+// channel is marked in a bit set of the channels with pending events and the
+// drain of the queue is requested at the receiver once per batch, i.e. the
+// events of one channel are combined and the value of an event is the last
+// posted one. The receiver drains the queue in its main thread in the slot
+// OnChannelEvents() by BeginDrain() and GetNext().
+class CChannelEventQueue
+{
+public:
+    CChannelEventQueue() : pReceiver ( nullptr ), iDrainWordIdx ( 0 ), iDrainBits ( 0 ) {}
+
+    void SetReceiver ( QObject* pNReceiver ) { pReceiver = pNReceiver; }
+
+    void Post ( const int        iChanID,
+                const EChanEvent eEvent,
+                const int        iValue = 0 );
+
+    void BeginDrain();
+
+    // returns false if no further channel has pending events, iEvents is the
+    // mask of the pending events of the channel
+    bool GetNext ( int& iChanID,
+                   int& iEvents );
+
+    int GetValue ( const int        iChanID,
+                   const EChanEvent eEvent ) const
+        { return iEventValues[iChanID][eEvent].loadAcquire(); }
+
+protected:
+    static const int NUM_CHAN_WORDS = ( MAX_NUM_CHANNELS + 31 ) / 32;
+
+    QObject*   pReceiver;
+    QAtomicInt iChanEvents[MAX_NUM_CHANNELS];
+    QAtomicInt iEventValues[MAX_NUM_CHANNELS][NUM_CHAN_EVENTS];
+    QAtomicInt iPendingChans[NUM_CHAN_WORDS];
+    QAtomicInt iDrainRequested;
+
+    // state of the drain (only used by the receiver thread)
+    int        iDrainWordIdx;
+    unsigned   iDrainBits;
+};
+
+
 class CChannel : public QObject
 {
     Q_OBJECT
@@ -69,21 +181,72 @@ public:
     // use constructor initialization in the server for a vector of channels
     CChannel ( const bool bNIsServer = true );
 
+    // the server channels post their events in the event queue of the server
+    void SetEventQueue ( CChannelEventQueue* pNEventQueue,
+                         const int           iNEventChanID )
+        { pEventQueue = pNEventQueue; iEventChanID = iNEventChanID; }
+
+    void PostEvent ( const EChanEvent eEvent,
+                     const int        iValue = 0 )
+        { if ( pEventQueue != nullptr ) pEventQueue->Post ( iEventChanID, eEvent, iValue ); }
+
+    // the packets and the jitter buffer state are recorded in the flight
+    // recorder of the server or client
+    void SetFlightRecorder ( CFlightRecorder* pNFlightRecorder,
+                             const int        iNFlightRecChanID )
+        { pFlightRecorder = pNFlightRecorder; iFlightRecChanID = iNFlightRecChanID; }
+
     void PutProtcolData ( const int               iRecCounter,
                           const int               iRecID,
                           const CVector<uint8_t>& vecbyMesBodyData,
                           const CHostAddress&     RecHostAddr );
 
+    // the receive delay is the time since the kernel has received the packet
+    // (zero if unknown), it is subtracted from the arrival time of the packet
     EPutDataStat PutAudioData ( const CVector<uint8_t>& vecbyData,
                                 const int               iNumBytes,
-                                CHostAddress            RecHostAddr );
+                                CHostAddress            RecHostAddr,
+                                const int               iRecDelayNs = 0 );
 
+    // iNumCodedBytes returns the size of the coded frame which is smaller than
+    // iNumBytes if the frame was recovered from a redundant copy (in the
+    // multitrack mode it is the size of the multitrack frame, the data vector
+    // must then have the size MULTITRACK_MAX_FRAME_SIZE)
     EGetDataStat GetData ( CVector<uint8_t>& vecbyData,
-                           const int         iNumBytes );
+                           const int         iNumBytes,
+                           int&              iNumCodedBytes );
 
+    // the low bit rate copy of the frame (vecbyRedPacket) is only used if
+    // iRedPacketLen equals GetRedFrameSize(), otherwise it may be empty
     void PrepAndSendPacket ( CHighPrioSocket*        pSocket,
                              const CVector<uint8_t>& vecbyNPacket,
-                             const int               iNPacketLen );
+                             const int               iNPacketLen,
+                             const CVector<uint8_t>& vecbyRedPacket,
+                             const int               iRedPacketLen,
+                             const bool              bUseSendQueue = false );
+
+    // server: a multitrack frame is sent as a packet of its own (the vector
+    // must have the size MULTITRACK_MAX_FRAME_SIZE + MULTITRACK_FRAME_SIZE_RESERVE)
+    void PrepAndSendMultitrackFrame ( CHighPrioSocket*  pSocket,
+                                      CVector<uint8_t>& vecbyFrame,
+                                      const int         iFrameLen,
+                                      const bool        bUseSendQueue = false );
+
+    // multitrack mode: the client receives the coded frames of the other
+    // clients instead of a mix
+    bool IsMultitrackMode() const { return bUseMultitrack; }
+
+    // size of the low bit rate copy of a frame which has to be encoded for
+    // PrepAndSendPacket(), zero if no redundancy is sent
+    int GetRedFrameSize() const { return bSendRedundancy ? iRedFrameSize : 0; }
+
+    // number of additional sub-streams whose frames have to be appended to
+    // each frame of PrepAndSendPacket() (client), zero if the server has not
+    // confirmed the sub-streams yet
+    int GetNumSendSubStreams() const { return iNumSendSubStreams; }
+
+    static int CalcRedFrameSize ( const int iNewNetwFrameSize )
+        { return std::max ( CELT_MINIMUM_NUM_BYTES, iNewNetwFrameSize / CHANNEL_RED_FRAME_SIZE_DIV ); }
 
     void ResetTimeOutCounter() { iConTimeOut = iConTimeOutStartVal; }
     bool IsConnected() const { return iConTimeOut > 0; }
@@ -92,18 +255,45 @@ public:
     void SetEnable ( const bool bNEnStat );
     bool IsEnabled() { return bIsEnabled; }
 
-    void SetAddress ( const CHostAddress NAddr ) { InetAddr = NAddr; }
+    // server: the buffers of a channel only exist while a client is connected,
+    // the server allocates them before the first audio packet of a new client
+    // is put and releases them in the main thread after the timer has marked
+    // the channel as disconnected (the timer does not use the channel anymore)
+    void AllocateBuffers();
+    void MarkBuffersReleasable() { iBuffersReleasable.storeRelease ( 1 ); }
+    void ReleaseBuffersIfIdle();
+
+    // allocated memory of the channel in bytes (can be read by any thread)
+    int GetMemUsage() const { return iMemUsageBytes.loadAcquire(); }
+
+    void SetAddress ( const CHostAddress NAddr )
+    {
+        InetAddr = NAddr;
+
+        // cache the socket address so that it is not converted on every packet
+        CSocket::HostAddrToSockAddr ( InetAddr, SockAddr );
+    }
+
     bool GetAddress ( CHostAddress& RetAddr );
     const CHostAddress& GetAddress() const { return InetAddr; }
 
+    // the socket address which is converted once in SetAddress()
+    const USockAddr& GetSockAddr() const { return SockAddr; }
+
     void ResetInfo() { ChannelInfo = CChannelCoreInfo(); } // reset does not emit a message
     QString GetName();
     void SetChanInfo ( const CChannelCoreInfo& NChanInf );
-    CChannelCoreInfo& GetChanInfo() { return ChannelInfo; }
+    CChannelCoreInfo GetChanInfo();
 
     void SetRemoteInfo ( const CChannelCoreInfo ChInfo )
         { Protocol.CreateChanInfoMes ( ChInfo ); }
 
+    // session setup (see CProtocol): the client collects the properties of the
+    // connection in the protocol version message, the server waits for them
+    void BeginSessionSetup() { Protocol.BeginSessionSetup(); }
+    void EndSessionSetup() { Protocol.EndSessionSetup(); }
+    void WaitForSessionSetup() { Protocol.WaitForSessionSetup ( PROT_SESSION_SETUP_WAIT_MS ); }
+
     void CreateReqChanInfoMes() { Protocol.CreateReqChanInfoMes(); }
     void CreateVersionAndOSMes() { Protocol.CreateVersionAndOSMes(); }
     void CreateMuteStateHasChangedMes ( const int iChanID, const bool bIsMuted ) { Protocol.CreateMuteStateHasChangedMes ( iChanID, bIsMuted ); }
@@ -115,17 +305,54 @@ public:
     void SetPan ( const int iChanID, const double dNewPan );
     double GetPan ( const int iChanID );
 
+    // the gains of the mix groups are applied in addition to the gains of the
+    // channels (index: mix group, NO_MIX_GROUP always has unity gain)
+    void SetMixGroupGain ( const int iMixGroup, const double dNewGain );
+
+    // copies all gains, pannings and mix group gains if they were changed
+    // since the last call
+    bool GetGainsAndPanningsIfChanged ( CVector<double>& vecdOutGains,
+                                        CVector<double>& vecdOutPannings,
+                                        CVector<double>& vecdOutMixGroupGains );
+
     void SetRemoteChanGain ( const int iId, const double dGain )
         { Protocol.CreateChanGainMes ( iId, dGain ); }
 
     void SetRemoteChanPan ( const int iId, const double dPan )
         { Protocol.CreateChanPanMes ( iId, dPan ); }
 
+    // negative values are not sent
+    void SetRemoteChanGainPanList ( const CVector<double>& vecdGains,
+                                    const CVector<double>& vecdPans )
+        { Protocol.CreateChanGainPanListMes ( vecdGains, vecdPans ); }
+
     bool SetSockBufNumFrames ( const int  iNewNumFrames,
                                const bool bPreserve = false );
     int GetSockBufNumFrames() const { return iCurSockBufNumFrames; }
 
-    void UpdateSocketBufferSize();
+    // the jitter buffer delay in ms (independent of the codec frame size), the
+    // auto setting starts with the start delay after the next init of the
+    // audio stream properties (zero for the default start setting)
+    int GetSockBufDelayMs() const
+        { return iCurSockBufNumFrames * GetCodecFrameSizeSamples ( eAudioCompressionType ) * 1000 / SYSTEM_SAMPLE_RATE_HZ; }
+
+    void SetSockBufStartDelayMs ( const int iNDelayMs ) { iSockBufStartDelayMs = iNDelayMs; }
+
+    // number of frames which are currently waiting in the jitter buffer
+    int GetNumBufferedFrames();
+
+    // the jitter buffer memory only grows on demand: if the auto setting needs
+    // a larger buffer than the reserved memory, the size is only applied after
+    // this function (which allocates memory and must not be called by the
+    // real-time thread) has grown the memory (the server gets the event
+    // CE_SOCK_BUF_CAPACITY, the client calls it periodically)
+    void UpdateSockBufCapacity();
+
+    // measured average time a received frame waits in the jitter buffer in us
+    // (lock free, can be called by any thread)
+    int GetJitBufDelayUs() const
+        { return static_cast<int> ( static_cast<qint64> ( SockBuf.GetAvFillMilliBlocks() ) *
+                                    iAudioFrameSizeSamples * 1000 / SYSTEM_SAMPLE_RATE_HZ ); }
 
     int GetUploadRateKbps();
 
@@ -133,7 +360,33 @@ public:
     void SetAudioStreamProperties ( const EAudComprType eNewAudComprType,
                                     const int iNewNetwFrameSize,
                                     const int iNewNetwFrameSizeFact,
-                                    const int iNewNumAudioChannels );
+                                    const int iNewNumAudioChannels,
+                                    const bool bNewUseRedundancy,
+                                    const int iNewNumSubStreams = 0,
+                                    const bool bNewUseSeqNum = false,
+                                    const bool bNewUseMultitrack = false );
+
+    // changes only the number of frames per network packet (client), the
+    // frames in the jitter buffer are kept and the new value is sent to the
+    // server (the packets in flight of the old size are lost)
+    void SetNetwFrameSizeFact ( const int iNewNetwFrameSizeFact );
+
+    // sub-stream channels (server): the additional sub-streams of a client are
+    // put in separate channels which have no own protocol, they carry the
+    // stream properties of the parent channel and are never sent a mix
+    void ResetSubStreams();
+    void SetSubStreamParent ( const int iNewParentChanID,
+                              const int iNewSubStreamIdx );
+    void SetSubStreamProperties ( const CChannel& ParentChannel );
+    bool HasSubStreamProperties ( const CChannel& ParentChannel ) const;
+
+    bool IsSubStreamChannel() const { return iSubStreamParentChanID != INVALID_INDEX; }
+    int  GetSubStreamParent() const { return iSubStreamParentChanID; }
+    int  GetSubStreamIdx() const { return iSubStreamIdx; }
+    int  GetNumSubStreams() const { return iNumSubStreams; }
+
+    void SetSubStreamChanID ( const int iIdx, const int iChanID ) { veciSubStreamChanIDs[iIdx] = iChanID; }
+    int  GetSubStreamChanID ( const int iIdx ) const { return veciSubStreamChanIDs[iIdx]; }
 
     void SetDoAutoSockBufSize ( const bool bValue )
         { bDoAutoSockBufSize = bValue; }
@@ -146,9 +399,18 @@ public:
     void GetBufErrorRates ( CVector<double>& vecErrRates, double& dLimit, double& dMaxUpLimit )
         { SockBuf.GetErrorRates ( vecErrRates, dLimit, dMaxUpLimit ); }
 
+    // the packet counters can be read from any thread without locking
+    void GetNetStats ( CChannelNetStats& NetStats ) const;
+
     EAudComprType GetAudioCompressionType() { return eAudioCompressionType; }
     int GetNumAudioChannels() const { return iNumAudioChannels; }
 
+    // consistent set of the audio stream properties which can be read without
+    // any lock while the protocol changes them (server timer)
+    void GetAudioStreamProps ( EAudComprType& eOutAudComprType,
+                               int&           iOutNumAudioChannels,
+                               int&           iOutNetwFrameSize ) const;
+
     // network protocol interface
     void CreateJitBufMes ( const int iJitBufSize )
     { 
@@ -159,22 +421,82 @@ public:
     }
     void CreateClientIDMes ( const int iChanID )             { Protocol.CreateClientIDMes ( iChanID ); }
     void CreateReqNetwTranspPropsMes()                       { Protocol.CreateReqNetwTranspPropsMes(); }
+    void CreateNetwTranspPropsMes()                          { OnReqNetTranspProps(); }
     void CreateReqJitBufMes()                                { Protocol.CreateReqJitBufMes(); }
     void CreateReqConnClientsList()                          { Protocol.CreateReqConnClientsList(); }
     void CreateChatTextMes ( const QString& strChatText )    { Protocol.CreateChatTextMes ( strChatText ); }
     void CreateLicReqMes ( const ELicenceType eLicenceType ) { Protocol.CreateLicenceRequiredMes ( eLicenceType ); }
     void CreateReqChannelLevelListMes ( bool bOptIn )        { Protocol.CreateReqChannelLevelListMes ( bOptIn ); }
+    void CreateReqChannelLevelDeltaMes ( const int iInterval ) { Protocol.CreateReqChannelLevelDeltaMes ( iInterval ); }
+    void CreateListenerModeMes ( const bool bIsListener )    { Protocol.CreateListenerModeMes ( bIsListener ); }
+    void CreateMixGroupMes ( const int iMixGroup )           { Protocol.CreateMixGroupMes ( iMixGroup ); }
+    void CreateMixGroupGainMes ( const int iMixGroup, const double dGain ) { Protocol.CreateMixGroupGainMes ( iMixGroup, dGain ); }
+    void CreateMulticastGroupMes ( const int iStream, const CHostAddress& GroupAddr ) { Protocol.CreateMulticastGroupMes ( iStream, GroupAddr ); }
+    void CreateMulticastJoinedMes ( const int iStream )     { Protocol.CreateMulticastJoinedMes ( iStream ); }
+    void CreateReqNetStatsMes()                              { Protocol.CreateReqNetStatsMes(); }
 
     void CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInfo )
         { Protocol.CreateConClientListMes ( vecChanInfo ); }
 
+    void CreateConClientListDeltaMes ( const int                    iListVersion,
+                                       const bool                   bFullList,
+                                       const CVector<CChannelInfo>& vecChanInfo,
+                                       const CVector<int>&          veciLeftChanIDs )
+        { Protocol.CreateConClientListDeltaMes ( iListVersion, bFullList, vecChanInfo, veciLeftChanIDs ); }
+
+    int GetPeerProtVersion() { return Protocol.GetPeerProtVersion(); }
+
     void CreateRecorderStateMes ( const ERecorderState eRecorderState )
         { Protocol.CreateRecorderStateMes ( eRecorderState ); }
 
-    CNetworkTransportProps GetNetworkTransportPropsFromCurrentSettings();
+    // a message body which is sent to all clients is only created once
+    void SendBroadcastMes ( const CProtBroadcastMes& Mes ) { Protocol.SendBroadcastMes ( Mes ); }
+
+    CNetworkTransportProps GetNetworkTransportPropsFromCurrentSettings() const;
 
     bool ChannelLevelsRequired() const                { return bChannelLevelsRequired; }
 
+    // a listener only receives audio, its (silent) audio is not decoded and
+    // not mixed by the server (the admission control of the server may force
+    // the listener mode for the complete connection)
+    bool IsListener() const                           { return bIsListener || bIsForcedListener; }
+    bool IsForcedListener() const                     { return bIsForcedListener; }
+    void SetForcedListenerMode()                      { bIsForcedListener = true; }
+    void ResetListenerMode()                          { bIsListener = false; bIsForcedListener = false; }
+
+    // the mix group (section) of the client, its channel is summed in the mix
+    // group bus of the server (lock free, can be called by any thread)
+    int  GetMixGroup() const                          { return iMixGroup.loadAcquire(); }
+    void SetMixGroup ( const int iNewMixGroup );
+    void ResetMixGroup();
+
+    // the multicast stream the client has joined (server side, lock free),
+    // NO_MULTICAST_STREAM if the client receives its mix by unicast
+    int  GetMulticastStream() const                   { return iMulticastStream.loadAcquire(); }
+    void ResetMulticastStream()                       { iMulticastStream.storeRelease ( NO_MULTICAST_STREAM ); }
+
+    // true if the packets of the channel are the plain coded blocks of a frame,
+    // i.e. the packets of a shared stream can be sent to the client unchanged
+    bool SendsPlainPackets ( const int iNumCodedBlocks );
+
+    // compact channel level message (server side): the rate limit and the
+    // changed levels are managed per channel, UpdateChannelLevelDelta() returns
+    // true if a message shall be sent for this level update
+    int  GetChannelLevelDeltaInterval() const         { return iLevelDeltaInterval; }
+    void ResetChannelLevelDelta();
+    bool UpdateChannelLevelDelta ( const CVector<uint16_t>& vecLevelList,
+                                   const int                iNumClients,
+                                   bool&                    bFullList,
+                                   int&                     iSeqNum );
+    const CVector<uint8_t>& GetChannelLevelChanged() const { return vecbyLevelChanged; }
+
+    // round trip time to the client (server side), measured with the
+    // PROTMESSID_CLM_RTT_PROBE messages, -1 if no measurement is available
+    void ResetRtt();
+    void UpdateRtt ( const int iRttMs );
+    int  GetRttMs() const       { return iRttMsPublished.loadAcquire(); }
+    int  GetRttJitterMs() const { return iRttJitterMsPublished.loadAcquire(); }
+
     double GetPrevLevel() const              { return dPrevLevel; }
     void   SetPrevLevel ( const double nPL ) { dPrevLevel = nPL; }
 
@@ -190,12 +512,55 @@ protected:
         iNetwFrameSizeFact    = FRAME_SIZE_FACTOR_PREFERRED;
         iNetwFrameSize        = CELT_MINIMUM_NUM_BYTES;
         iNumAudioChannels     = 1; // mono
+        bUseRedundancy        = false;
+        bUseSeqNum            = false;
+        bUseMultitrack        = false;
+        iNumSubStreams        = 0;
 
         dPrevLevel            = 0.0;
+
+        PublishAudioStreamProps();
     }
 
+    void PublishAudioStreamProps();
+
+    void ApplyNetworkTransportProps ( const CNetworkTransportProps& NetworkTransportProps );
+
+    int  GetRedPacketSize() const { return iNetwFrameSizeFact * ( iNetwFrameSize + iRedFrameSize ) + 1; }
+    int  GetSeqPacketSize() const { return iNetwFrameSizeFact * iNetwFrameSize + CHANNEL_SEQ_HEADER_SIZE; }
+    bool HasSockBufBlockType() const { return bUseRedundancy || bUseSeqNum; }
+    bool HasMultitrackBlocks() const { return bUseMultitrack && !bIsServer; }
+    bool PutMultitrackBlock ( const uint8_t* pbyData,
+                              const int      iNumBytes );
+    bool IsValidAudioPacketSize ( const int iNumBytes ) const;
+    void InitSockBuf ( const bool bKeepFrames = false );
+    void ApplySockBufNumFrames ( const int  iNewNumFrames,
+                                 const bool bPreserve );
+    void InitConvBuf();
+    void ReleaseBuffers();
+    void UpdateMemUsage();
+    bool PutPacketInSockBuf ( const CVector<uint8_t>& vecbyData,
+                              const int               iNumBytes );
+    bool PutSeqPacketInSockBuf ( const CVector<uint8_t>& vecbyData );
+    void UpdateSeqJitter ( const CVector<uint8_t>& vecbyData,
+                           const int               iRecDelayNs );
+    bool PutFramesInSockBuf ( const uint8_t* pbyFrames,
+                              const int      iFrameSize,
+                              const uint8_t  byIsRedundant );
+
+    CChannelEventQueue* pEventQueue;
+    int                 iEventChanID;
+
+    void RecordFlightEvent ( const EFlightRecEvent eEvent,
+                             const int             iValue = 0 )
+        { if ( pFlightRecorder != nullptr ) pFlightRecorder->Record ( eEvent, iFlightRecChanID, iValue ); }
+
+    CFlightRecorder*    pFlightRecorder;
+    int                 iFlightRecChanID;
+
     // connection parameters
     CHostAddress      InetAddr;
+    USockAddr         SockAddr;
 
     // channel info
     CChannelCoreInfo  ChannelInfo;
@@ -203,10 +568,19 @@ protected:
     // mixer and effect settings
     CVector<double>   vecdGains;
     CVector<double>   vecdPannings;
+    CVector<double>   vecdMixGroupGains;
+    QAtomicInt        iGainPanChanged;
+    QAtomicInt        iMixGroup;
+    QAtomicInt        iMulticastStream;
+
+    // compression type, number of audio channels and network frame size packed
+    // in one word (see PublishAudioStreamProps())
+    QAtomicInt        iAudioStreamProps;
 
     // network jitter-buffer
     CNetBufWithStats  SockBuf;
     int               iCurSockBufNumFrames;
+    int               iSockBufStartDelayMs;
     bool              bDoAutoSockBufSize;
 
     // network output conversion buffer
@@ -234,11 +608,137 @@ protected:
     QMutex            MutexSocketBuf;
     QMutex            MutexConvBuf;
 
+    // redundancy mode: each packet additionally carries the low bit rate
+    // copies of the frames of the previous packet and a sequence number so
+    // that a single lost packet is replaced when the next packet arrives, the
+    // jitter buffer blocks then have an additional byte which marks the
+    // recovered frames (bUseRedundancy is protected by the socket buffer
+    // mutex, bSendRedundancy and the send state by the conversion buffer mutex)
+    bool              bUseRedundancy;
+    bool              bSendRedundancy;
+    int               iRedFrameSize;
+    int               iSockBufBlockSize;
+    int               iRedLastSeqNum;
+    CVector<uint8_t>  vecbySockBufBlocks;
+    CConvBuf<uint8_t> RedConvBuf;
+    CVector<uint8_t>  vecbyRedPrevPacket;
+    CVector<uint8_t>  vecbyRedSendPacket;
+    bool              bRedPrevPacketValid;
+    bool              bRedCurPacketValid;
+    uint8_t           byRedSeqNum;
+
+    // sequence mode: each packet carries a sequence number and its send time,
+    // the frames are put in the jitter buffer slots of their sequence number,
+    // i.e. the slots of missing frames are kept free so that a reordered
+    // packet is still played at its position and a lost frame is concealed
+    // at the right position (cannot be combined with the redundancy mode and
+    // the sub-streams, bUseSeqNum and the receive state are protected by the
+    // socket buffer mutex, bSendSeqNum and the send state by the conversion
+    // buffer mutex, the jitter state is written by the socket thread only)
+    bool              bUseSeqNum;
+    bool              bSendSeqNum;
+    int               iSeqNextFrame; // next frame at the put position, -1 if unknown
+    CVector<uint8_t>  vecbySeqMissingBlock;
+    CVector<uint8_t>  vecbySeqSendPacket;
+    uint16_t          iSeqSendNum;
+    QElapsedTimer     SeqTimer;
+    int               iSeqLastTransit;
+    bool              bSeqTransitValid;
+    double            dSeqJitter;
+
+    // multi-stream mode: each frame of a packet is followed by the frames of
+    // the additional sub-streams which use the same codec settings (the
+    // client only sends them after the server has confirmed the number of
+    // sub-streams, iNumSendSubStreams is protected by the conversion buffer
+    // mutex), the server puts each sub-stream in a sub-stream channel
+    int               iNumSubStreams;
+    int               iNumSendSubStreams;
+    int               iSubStreamParentChanID;
+    int               iSubStreamIdx;
+    CVector<int>      veciSubStreamChanIDs;
+
+    // multitrack mode: the server sends multitrack frames (see multitrack.h)
+    // as packets of their own, the client stores the packets in jitter buffer
+    // blocks of the maximum frame size with the length in the last two bytes
+    // so that a plain packet (a frame per block) and a multitrack frame can be
+    // received at any time (cannot be combined with the redundancy and the
+    // sequence mode, protected by the socket buffer mutex)
+    bool              bUseMultitrack;
+
     bool              bChannelLevelsRequired;
+    bool              bIsListener;
+    bool              bIsForcedListener;
     double            dPrevLevel;
 
+    // connected clients list of the client which is updated by the changes
+    // sent by the server
+    int                   iChanListVersion;
+    bool                  bChanListValid;
+    bool                  bChanListResyncRequested;
+    CVector<CChannelInfo> vecChanListInfo;
+    CVector<uint8_t>      vecbyChanListPresent;
+
+    int               iLevelDeltaInterval;
+    int               iLevelDeltaCurInterval;
+    int               iLevelDeltaCounter;
+    int               iLevelDeltaSeqNum;
+    int               iLevelDeltaNumSinceFull;
+    int               iLevelDeltaNumClients;
+    CVector<uint16_t> vecLevelDeltaLast;
+    CVector<uint8_t>  vecbyLevelChanged;
+
+    // smoothed round trip time and its mean deviation (as in RFC 6298)
+    double            dSmoothedRttMs;
+    double            dRttVarMs;
+    bool              bRttValid;
+    QAtomicInt        iRttMsPublished;
+    QAtomicInt        iRttJitterMsPublished;
+
+    // audio packet counters (written by the audio threads only)
+    void ResetNetStats();
+
+    QAtomicInt             iNumPacketsReceived;
+    QAtomicInt             iNumPacketsLost;
+    QAtomicInt             iNumBufOverruns;
+    QAtomicInt             iNumBufUnderruns;
+    QAtomicInt             iNumFramesLate;
+    QAtomicInt             iSeqJitterUs;
+    QAtomicInteger<qint64> iNumBytesReceived;
+    bool                   bLastGetFailed;
+
+    // client: the socket thread hands the received audio packets to the audio
+    // callback through a wait-free ring buffer, the audio callback moves them
+    // into the jitter buffer (so that the socket thread never holds a lock the
+    // audio callback waits for), the ring is only re-initialized with the
+    // socket buffer mutex locked after the producer has left it
+    EPutDataStat PutAudioDataHandOff ( const CVector<uint8_t>& vecbyData,
+                                       const int               iNumBytes,
+                                       const int               iRecDelayNs );
+    void InitHandOffBuf();
+    void MoveHandOffToSockBuf();
+
+    CNetBufSPSC            HandOffBuf;
+    CVector<uint8_t>       vecbyHandOffData;
+    CVector<uint8_t>       vecbyHandOffPutData;
+    QAtomicInt             iHandOffEnabled;
+    QAtomicInt             iHandOffNumProducers;
+    QAtomicInt             iHandOffPacketReceived;
+
+    // the client sends its session setup after the first audio packet (the
+    // server creates the channel on the first audio packet)
+    QAtomicInt             iSessionSetupPending;
+
+    // lazy buffer allocation of the server (bBuffersAllocated is protected by
+    // the channel table mutex of the server)
+    bool                   bBuffersAllocated;
+    QAtomicInt             iBuffersReleasable;
+
+    // the auto jitter buffer size needs more memory than reserved
+    QAtomicInt             iSockBufCapacityReq;
+    QAtomicInt             iMemUsageBytes;
+
 public slots:
-    void OnSendProtMessage ( CVector<uint8_t> vecMessage );
+    void OnSendProtMessage ( CProtMessage Message );
     void OnJittBufSizeChange ( int iNewJitBufSize );
     void OnChangeChanGain ( int iChanID, double dNewGain );
     void OnChangeChanPan ( int iChanID, double dNewPan );
@@ -246,42 +746,52 @@ public slots:
     void OnNetTranspPropsReceived ( CNetworkTransportProps NetworkTransportProps );
     void OnReqNetTranspProps();
 
-    void OnParseMessageBody ( CVector<uint8_t> vecbyMesBodyData,
-                              int              iRecCounter,
-                              int              iRecID )
+    void OnParseMessageBody ( CProtMessage MesBody,
+                              int          iRecCounter,
+                              int          iRecID )
     {
         // note that the return value is ignored here
-        Protocol.ParseMessageBody ( vecbyMesBodyData, iRecCounter, iRecID );
+        Protocol.ParseMessageBody ( MesBody, iRecCounter, iRecID );
     }
 
-    void OnProtcolMessageReceived ( int              iRecCounter,
-                                    int              iRecID,
-                                    CVector<uint8_t> vecbyMesBodyData,
-                                    CHostAddress     RecHostAddr )
+    void OnProtcolMessageReceived ( int          iRecCounter,
+                                    int          iRecID,
+                                    CProtMessage MesBody,
+                                    CHostAddress RecHostAddr )
     {
-        PutProtcolData ( iRecCounter, iRecID, vecbyMesBodyData, RecHostAddr );
+        PutProtcolData ( iRecCounter, iRecID, MesBody, RecHostAddr );
     }
 
-    void OnProtcolCLMessageReceived ( int              iRecID,
-                                      CVector<uint8_t> vecbyMesBodyData,
-                                      CHostAddress     RecHostAddr )
+    void OnProtcolCLMessageReceived ( int          iRecID,
+                                      CProtMessage MesBody,
+                                      CHostAddress RecHostAddr )
     {
-        emit DetectedCLMessage ( vecbyMesBodyData, iRecID, RecHostAddr );
+        emit DetectedCLMessage ( MesBody, iRecID, RecHostAddr );
     }
 
     void OnNewConnection() { emit NewConnection(); }
+    void OnFirstPacketSent() { emit SessionSetupRequired(); }
 
     void OnReqChannelLevelList ( bool bOptIn ) { bChannelLevelsRequired = bOptIn; }
+    void OnReqChannelLevelDelta ( int iInterval ) { iLevelDeltaInterval = iInterval; }
+    void OnListenerModeReceived ( bool bState ) { bIsListener = bState; }
+    void OnMixGroupReceived ( int iNewMixGroup ) { SetMixGroup ( iNewMixGroup ); }
+    void OnChangeMixGroupGain ( int iMixGroup, double dNewGain ) { SetMixGroupGain ( iMixGroup, dNewGain ); }
+    void OnMulticastJoinedReceived ( int iStream ) { iMulticastStream.storeRelease ( iStream ); }
+    void OnReqNetStats();
+
+    void OnConClientListMesReceived ( CVector<CChannelInfo> vecChanInfo );
+    void OnConClientListDeltaMesReceived ( int                   iListVersion,
+                                           int                   iFlags,
+                                           CVector<CChannelInfo> vecChanInfo,
+                                           CVector<int>          veciLeftChanIDs );
 
 signals:
-    void MessReadyForSending ( CVector<uint8_t> vecMessage );
+    void MessReadyForSending ( CProtMessage Message );
     void NewConnection();
     void ReqJittBufSize();
     void JittBufSizeChanged ( int iNewJitBufSize );
-    void ServerAutoSockBufSizeChange ( int iNNumFra );
-    void ReqConnClientsList();
     void ConClientListMesReceived ( CVector<CChannelInfo> vecChanInfo );
-    void ChanInfoHasChanged();
     void ClientIDReceived ( int iChanID );
     void MuteStateHasChanged ( int iChanID, bool bIsMuted );
     void MuteStateHasChangedReceived ( int iChanID, bool bIsMuted );
@@ -291,13 +801,17 @@ signals:
     void LicenceRequired ( ELicenceType eLicenceType );
     void VersionAndOSReceived ( COSUtil::EOpSystemType eOSType, QString strVersion );
     void RecorderStateReceived ( ERecorderState eRecorderState );
+    void MixGroupListReceived ( CVector<int> vecMixGroups );
+    void MulticastGroupReceived ( int iStream, CHostAddress GroupAddr );
+    void NetStatsReceived ( int iNumReceived, int iNumLost );
     void Disconnected();
+    void SessionSetupRequired();
 
-    void DetectedCLMessage ( CVector<uint8_t> vecbyMesBodyData,
-                             int              iRecID,
-                             CHostAddress     RecHostAddr );
+    void DetectedCLMessage ( CProtMessage MesBody,
+                             int          iRecID,
+                             CHostAddress RecHostAddr );
 
-    void ParseMessageBody ( CVector<uint8_t> vecbyMesBodyData,
-                            int              iRecCounter,
-                            int              iRecID );
+    void ParseMessageBody ( CProtMessage MesBody,
+                            int          iRecCounter,
+                            int          iRecID );
 };
@@ -52,6 +52,10 @@ CChatDlg::CChatDlg ( QWidget* parent, Qt::WindowFlags f ) :
     txvChatWindow->clear();
     edtLocalInputText->clear();
 
+    // bounded history, the chat window is read only so no undo stack is needed
+    txvChatWindow->document()->setMaximumBlockCount ( MAX_NUM_CHAT_HISTORY_BLOCKS );
+    txvChatWindow->document()->setUndoRedoEnabled ( false );
+
 
     // Connections -------------------------------------------------------------
     QObject::connect ( edtLocalInputText, &QLineEdit::textChanged,
@@ -89,9 +93,15 @@ void CChatDlg::OnClearPressed()
 
 void CChatDlg::AddChatText ( QString strChatText )
 {
-    // add new text in chat window
+    // add new text in chat window (appends a new block at the end of the
+    // document, the oldest block is removed if the history is full)
     txvChatWindow->append ( strChatText );
 
-    // notify accessibility plugin that text has changed
-    QAccessible::updateAccessibility ( new QAccessibleValueChangeEvent ( txvChatWindow, strChatText ) );
+    // notify accessibility plugin that text has changed (the event is not
+    // taken over by Qt, i.e. it must not be allocated on the heap)
+    if ( QAccessible::isActive() )
+    {
+        QAccessibleValueChangeEvent AccessibleEvent ( txvChatWindow, strChatText );
+        QAccessible::updateAccessibility ( &AccessibleEvent );
+    }
 }
@@ -33,6 +33,13 @@
 #include "ui_chatdlgbase.h"
 
 
+/* Definitions ****************************************************************/
+// maximum number of chat messages in the chat window, the oldest messages are
+// removed from the document (each message is one text block), this keeps the
+// layout cost of the chat window bounded in long sessions
+#define MAX_NUM_CHAT_HISTORY_BLOCKS      1000
+
+
 /* Classes ********************************************************************/
 class CChatDlg : public QDialog, private Ui_CChatDlgBase
 {
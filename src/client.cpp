@@ -23,9 +23,430 @@
 \******************************************************************************/
 
 #include "client.h"
+#include "tracer.h"
 
 
 /* Implementation *************************************************************/
+// CClientDspLoad implementation ***********************************************
+void CClientDspLoad::Reset()
+{
+    iLastMarkNs         = 0;
+    iIntervalProcNs     = 0;
+    iIntervalPeriodNs   = 0;
+    iIntervalPeakPerMil = 0;
+
+    iLoadPerMil.storeRelease    ( 0 );
+    iPeakPerMil.storeRelease    ( 0 );
+    iMaxPeakPerMil.storeRelease ( 0 );
+
+    for ( int i = 0; i < NUM_CLIENT_DSP_STAGES; i++ )
+    {
+        iStageNs[i] = 0;
+        iStageLoadPerMil[i].storeRelease ( 0 );
+    }
+}
+
+void CClientDspLoad::EndCallback ( const int    iNumSamples,
+                                   const qint64 iProcTimeNs )
+{
+    const qint64 iPeriodNs = static_cast<qint64> ( iNumSamples ) * 1000000000 / SYSTEM_SAMPLE_RATE_HZ;
+
+    if ( iPeriodNs <= 0 )
+    {
+        return;
+    }
+
+    iIntervalProcNs     += iProcTimeNs;
+    iIntervalPeriodNs   += iPeriodNs;
+    iIntervalPeakPerMil  = std::max ( iIntervalPeakPerMil, static_cast<int> ( 1000 * iProcTimeNs / iPeriodNs ) );
+
+    // publish the values of the interval
+    if ( iIntervalPeriodNs >= CLIENT_DSP_LOAD_INTERVAL_MS * 1000000LL )
+    {
+        iLoadPerMil.storeRelease ( static_cast<int> ( 1000 * iIntervalProcNs / iIntervalPeriodNs ) );
+        iPeakPerMil.storeRelease ( iIntervalPeakPerMil );
+
+        if ( iIntervalPeakPerMil > iMaxPeakPerMil.loadAcquire() )
+        {
+            iMaxPeakPerMil.storeRelease ( iIntervalPeakPerMil );
+        }
+
+        for ( int i = 0; i < NUM_CLIENT_DSP_STAGES; i++ )
+        {
+            iStageLoadPerMil[i].storeRelease ( static_cast<int> ( 1000 * iStageNs[i] / iIntervalPeriodNs ) );
+            iStageNs[i] = 0;
+        }
+
+        iIntervalProcNs     = 0;
+        iIntervalPeriodNs   = 0;
+        iIntervalPeakPerMil = 0;
+    }
+}
+
+QString CClientDspLoad::GetStageName ( const EClientDspStage eStage )
+{
+    switch ( eStage )
+    {
+    case DS_LEVELS:
+        return "levels";
+
+    case DS_EFFECTS:
+        return "effects";
+
+    case DS_PAN:
+        return "pan";
+
+    case DS_ENCODE:
+        return "encode";
+
+    case DS_DECODE:
+        return "decode";
+
+    default:
+        return "mix";
+    }
+}
+
+QString CClientDspLoad::GetReport() const
+{
+    QString strReport = QString ( "DSP load %1 % (peak %2 %, maximum peak %3 %)" ).
+        arg ( GetLoad(), 0, 'f', 1 ).
+        arg ( GetPeak(), 0, 'f', 1 ).
+        arg ( GetMaxPeak(), 0, 'f', 1 );
+
+    for ( int i = 0; i < NUM_CLIENT_DSP_STAGES; i++ )
+    {
+        const EClientDspStage eStage = static_cast<EClientDspStage> ( i );
+
+        strReport += QString ( ", %1 %2 %" ).
+            arg ( GetStageName ( eStage ) ).
+            arg ( GetStageLoad ( eStage ), 0, 'f', 1 );
+    }
+
+    return strReport;
+}
+
+
+// CNetwFrameSizeFactControl implementation ************************************
+void CNetwFrameSizeFactControl::Reset ( const int iNBaseFact,
+                                        const int iNMaxFact )
+{
+    iBaseFact          = iNBaseFact;
+    iMaxFact           = std::max ( iNBaseFact, iNMaxFact );
+    iCurFact           = iNBaseFact;
+    bCountersValid     = false;
+    iLastNumReceived   = 0;
+    iLastNumLost       = 0;
+    iNumCleanIntervals = 0;
+}
+
+int CNetwFrameSizeFactControl::Update ( const int iNumReceived,
+                                        const int iNumLost )
+{
+    // the received counter counts packets, the lost counter frames
+    const int iNumNewFrames = ( iNumReceived - iLastNumReceived ) * iCurFact;
+    const int iNumNewLost   = iNumLost - iLastNumLost;
+    const bool bValid       = bCountersValid && ( iNumNewFrames >= 0 ) && ( iNumNewLost >= 0 );
+
+    iLastNumReceived = iNumReceived;
+    iLastNumLost     = iNumLost;
+    bCountersValid   = true;
+
+    // intervals with too few frames (e.g. the connection was just started or
+    // the counters were reset) are not evaluated
+    if ( !bValid || ( iNumNewFrames + iNumNewLost < NETW_AGGR_MIN_NUM_FRAMES ) )
+    {
+        return iCurFact;
+    }
+
+    const double dLossRate = static_cast<double> ( iNumNewLost ) / ( iNumNewFrames + iNumNewLost );
+
+    if ( dLossRate > NETW_AGGR_LOSS_RATE_HIGH )
+    {
+        iNumCleanIntervals = 0;
+
+        if ( 2 * iCurFact <= iMaxFact )
+        {
+            iCurFact      *= 2;
+            bCountersValid = false; // the change causes a short gap
+        }
+    }
+    else if ( dLossRate < NETW_AGGR_LOSS_RATE_LOW )
+    {
+        iNumCleanIntervals++;
+
+        if ( ( iNumCleanIntervals >= NETW_AGGR_NUM_CLEAN_INTERVALS ) && ( iCurFact > iBaseFact ) )
+        {
+            iCurFact           = std::max ( iBaseFact, iCurFact / 2 );
+            iNumCleanIntervals = 0;
+            bCountersValid     = false;
+        }
+    }
+    else
+    {
+        iNumCleanIntervals = 0;
+    }
+
+    return iCurFact;
+}
+
+
+// CNetwLossRateMeter implementation *******************************************
+bool CNetwLossRateMeter::Update ( const int iNumReceived,
+                                  const int iNumLost,
+                                  const int iNumFramesPerPacket,
+                                  double&   dLossRate )
+{
+    const int  iNumNewFrames = ( iNumReceived - iLastNumReceived ) * iNumFramesPerPacket;
+    const int  iNumNewLost   = iNumLost - iLastNumLost;
+    const bool bValid        = bCountersValid && ( iNumNewFrames >= 0 ) && ( iNumNewLost >= 0 );
+
+    iLastNumReceived = iNumReceived;
+    iLastNumLost     = iNumLost;
+    bCountersValid   = true;
+
+    if ( !bValid || ( iNumNewFrames + iNumNewLost < NETW_QUALITY_MIN_NUM_FRAMES ) )
+    {
+        return false;
+    }
+
+    dLossRate = static_cast<double> ( iNumNewLost ) / ( iNumNewFrames + iNumNewLost );
+    return true;
+}
+
+
+// CAudioQualityControl implementation *****************************************
+void CAudioQualityControl::Reset ( const EAudioQuality eNMaxQuality )
+{
+    eMaxQuality        = eNMaxQuality;
+    eCurQuality        = eNMaxQuality;
+    dRemoteLossRate    = 0.0;
+    bRemoteLossValid   = false;
+    iMinRttMs          = -1;
+    iIntervalMinRttMs  = -1;
+    iNumCleanIntervals = 0;
+
+    LocalLossMeter.Reset();
+    RemoteLossMeter.Reset();
+}
+
+void CAudioQualityControl::PutRemoteStats ( const int iNumReceived,
+                                            const int iNumLost,
+                                            const int iNumFramesPerPacket )
+{
+    double dLossRate;
+
+    if ( RemoteLossMeter.Update ( iNumReceived, iNumLost, iNumFramesPerPacket, dLossRate ) )
+    {
+        dRemoteLossRate  = dLossRate;
+        bRemoteLossValid = true;
+    }
+}
+
+void CAudioQualityControl::PutRtt ( const int iRttMs )
+{
+    // the minimum of the connection is the delay without queueing, the
+    // minimum of the interval ignores single delayed pings
+    if ( ( iMinRttMs < 0 ) || ( iRttMs < iMinRttMs ) )
+    {
+        iMinRttMs = iRttMs;
+    }
+
+    if ( ( iIntervalMinRttMs < 0 ) || ( iRttMs < iIntervalMinRttMs ) )
+    {
+        iIntervalMinRttMs = iRttMs;
+    }
+}
+
+EAudioQuality CAudioQualityControl::Update ( const int iNumReceived,
+                                             const int iNumLost,
+                                             const int iNumFramesPerPacket )
+{
+    double dLossRate = 0.0;
+
+    const bool bLocalLossValid = LocalLossMeter.Update ( iNumReceived, iNumLost, iNumFramesPerPacket, dLossRate );
+
+    // the loss rate of the link is the one of the worse direction (the server
+    // may not report the loss of our packets)
+    if ( bRemoteLossValid )
+    {
+        dLossRate = std::max ( dLossRate, dRemoteLossRate );
+    }
+
+    const bool bLossValid    = bLocalLossValid || bRemoteLossValid;
+    const int  iQueueDelayMs = ( iIntervalMinRttMs >= 0 ) ? iIntervalMinRttMs - iMinRttMs : 0;
+
+    bRemoteLossValid  = false;
+    iIntervalMinRttMs = -1;
+
+    // intervals without loss statistics (e.g. the connection was just started
+    // or the quality was just changed) are not evaluated
+    if ( !bLossValid )
+    {
+        return eCurQuality;
+    }
+
+    if ( ( dLossRate > NETW_QUALITY_LOSS_RATE_HIGH ) || ( iQueueDelayMs > NETW_QUALITY_QUEUE_DELAY_HIGH_MS ) )
+    {
+        iNumCleanIntervals = 0;
+
+        if ( eCurQuality > AQ_LOW )
+        {
+            eCurQuality = static_cast<EAudioQuality> ( eCurQuality - 1 );
+
+            // the change causes a short gap
+            LocalLossMeter.Reset();
+            RemoteLossMeter.Reset();
+        }
+    }
+    else if ( ( dLossRate < NETW_QUALITY_LOSS_RATE_LOW ) && ( iQueueDelayMs < NETW_QUALITY_QUEUE_DELAY_LOW_MS ) )
+    {
+        iNumCleanIntervals++;
+
+        if ( ( iNumCleanIntervals >= NETW_QUALITY_NUM_CLEAN_INTERVALS ) && ( eCurQuality < eMaxQuality ) )
+        {
+            eCurQuality        = static_cast<EAudioQuality> ( eCurQuality + 1 );
+            iNumCleanIntervals = 0;
+
+            LocalLossMeter.Reset();
+            RemoteLossMeter.Reset();
+        }
+    }
+    else
+    {
+        iNumCleanIntervals = 0;
+    }
+
+    return eCurQuality;
+}
+
+
+// CClientSendThread implementation ********************************************
+CClientSendThread::CClientSendThread ( CChannel*        pNChannel,
+                                       CHighPrioSocket* pNSocket ) :
+    pChannel         ( pNChannel ),
+    pSocket          ( pNSocket ),
+    iMaxPacketLen    ( 0 ),
+    iMaxRedPacketLen ( 0 ),
+    bRun             ( false )
+{
+    Init ( 1, 1 );
+}
+
+void CClientSendThread::Init ( const int iNMaxPacketLen,
+                               const int iNMaxRedPacketLen )
+{
+    // the queue must not be accessed by the send thread
+    const bool bWasRunning = isRunning();
+
+    Stop();
+
+    iMaxPacketLen    = iNMaxPacketLen;
+    iMaxRedPacketLen = iNMaxRedPacketLen;
+
+    const int iBlockSize = 4 + iMaxPacketLen + iMaxRedPacketLen;
+
+    Queue.Init ( iBlockSize, CLIENT_SEND_QUEUE_NUM_FRAMES );
+    vecbyPutBlock.Init ( iBlockSize );
+    vecbyGetBlock.Init ( iBlockSize );
+    vecbyPacket.Init ( iMaxPacketLen );
+    vecbyRedPacket.Init ( iMaxRedPacketLen );
+
+    if ( bWasRunning )
+    {
+        Start();
+    }
+}
+
+void CClientSendThread::Start()
+{
+    if ( !isRunning() )
+    {
+        // frames of a previous session are not sent
+        while ( Queue.Get ( vecbyGetBlock, vecbyGetBlock.Size() ) ) {}
+
+        WakeSem.tryAcquire ( WakeSem.available() );
+
+        bRun = true;
+        QThread::start ( QThread::TimeCriticalPriority );
+    }
+}
+
+void CClientSendThread::Stop()
+{
+    // set flag so that thread can leave the main loop (a waiting thread is
+    // woken up for that)
+    bRun = false;
+    WakeSem.release();
+
+    // give thread some time to terminate
+    wait ( 5000 );
+}
+
+bool CClientSendThread::PutFrame ( const CVector<uint8_t>& vecbyNPacket,
+                                   const int               iNPacketLen,
+                                   const CVector<uint8_t>& vecbyRedPacket,
+                                   const int               iRedPacketLen )
+{
+    if ( ( iNPacketLen > iMaxPacketLen ) || ( iRedPacketLen > iMaxRedPacketLen ) )
+    {
+        return false;
+    }
+
+    vecbyPutBlock[0] = static_cast<uint8_t> ( iNPacketLen & 0xFF );
+    vecbyPutBlock[1] = static_cast<uint8_t> ( iNPacketLen >> 8 );
+    vecbyPutBlock[2] = static_cast<uint8_t> ( iRedPacketLen & 0xFF );
+    vecbyPutBlock[3] = static_cast<uint8_t> ( iRedPacketLen >> 8 );
+
+    std::copy ( vecbyNPacket.begin(),
+                vecbyNPacket.begin() + iNPacketLen,
+                vecbyPutBlock.begin() + 4 );
+
+    std::copy ( vecbyRedPacket.begin(),
+                vecbyRedPacket.begin() + iRedPacketLen,
+                vecbyPutBlock.begin() + 4 + iMaxPacketLen );
+
+    if ( !Queue.Put ( vecbyPutBlock, vecbyPutBlock.Size() ) )
+    {
+        return false;
+    }
+
+    WakeSem.release();
+    return true;
+}
+
+void CClientSendThread::run()
+{
+    while ( bRun )
+    {
+        WakeSem.acquire();
+
+        // send all queued frames (the semaphore may count fewer wake-ups than
+        // frames if a frame was taken with the frames of a previous wake-up)
+        while ( bRun && Queue.Get ( vecbyGetBlock, vecbyGetBlock.Size() ) )
+        {
+            const int iPacketLen    = vecbyGetBlock[0] | ( vecbyGetBlock[1] << 8 );
+            const int iRedPacketLen = vecbyGetBlock[2] | ( vecbyGetBlock[3] << 8 );
+
+            std::copy ( vecbyGetBlock.begin() + 4,
+                        vecbyGetBlock.begin() + 4 + iPacketLen,
+                        vecbyPacket.begin() );
+
+            std::copy ( vecbyGetBlock.begin() + 4 + iMaxPacketLen,
+                        vecbyGetBlock.begin() + 4 + iMaxPacketLen + iRedPacketLen,
+                        vecbyRedPacket.begin() );
+
+            pChannel->PrepAndSendPacket ( pSocket,
+                                          vecbyPacket,
+                                          iPacketLen,
+                                          vecbyRedPacket,
+                                          iRedPacketLen );
+        }
+    }
+}
+
+
+// CClient implementation ******************************************************
 CClient::CClient ( const quint16  iPortNumber,
                    const QString& strConnOnStartupAddress,
                    const int      iCtrlMIDIChannel,
@@ -33,11 +454,8 @@ CClient::CClient ( const quint16  iPortNumber,
                    const QString& strNClientName ) :
     vstrIPAddress                    ( MAX_NUM_SERVER_ADDR_ITEMS, "" ),
     ChannelInfo                      (),
-    vecStoredFaderTags               ( MAX_NUM_STORED_FADER_SETTINGS, "" ),
-    vecStoredFaderLevels             ( MAX_NUM_STORED_FADER_SETTINGS, AUD_MIX_FADER_MAX ),
-    vecStoredPanValues               ( MAX_NUM_STORED_FADER_SETTINGS, AUD_MIX_PAN_MAX / 2 ),
-    vecStoredFaderIsSolo             ( MAX_NUM_STORED_FADER_SETTINGS, false ),
-    vecStoredFaderIsMute             ( MAX_NUM_STORED_FADER_SETTINGS, false ),
+    StoredFaderSettings              (),
+    StoredJitBufDelays               (),
     iNewClientFaderLevel             ( 100 ),
     bConnectDlgShowAllMusicians      ( true ),
     strClientName                    ( strNClientName ),
@@ -50,41 +468,80 @@ CClient::CClient ( const quint16  iPortNumber,
     bWindowWasShownChat              ( false ),
     bWindowWasShownProfile           ( false ),
     bWindowWasShownConnect           ( false ),
+    FlightRecorder                   ( "client", FLIGHT_REC_CLIENT_NUM_RECORDS ),
     Channel                          ( false ), /* we need a client channel -> "false" */
     CurOpusEncoder                   ( nullptr ),
     CurOpusDecoder                   ( nullptr ),
+    CurOpusRedEncoder                ( nullptr ),
+    CurOpusSubEncoder                ( nullptr ),
     eAudioCompressionType            ( CT_OPUS ),
     iCeltNumCodedBytes               ( OPUS_NUM_BYTES_MONO_LOW_QUALITY ),
     iOPUSFrameSizeSamples            ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES ),
     eAudioQuality                    ( AQ_NORMAL ),
     eAudioChannelConf                ( CC_MONO ),
+    eReverbAudioChannelConf          ( CC_MONO ),
     iNumAudioChannels                ( 1 ),
     bIsInitializationPhase           ( true ),
     bMuteOutStream                   ( false ),
+    bListenerMode                    ( false ),
+    iListenerKeepAliveCnt            ( 0 ),
+    iMixGroup                        ( NO_MIX_GROUP ),
     dMuteOutStreamGain               ( 1.0 ),
     Socket                           ( &Channel, iPortNumber ),
+    SendThread                       ( &Channel, &Socket ),
     Sound                            ( AudioCallback, this, iCtrlMIDIChannel, bNoAutoJackConnect, strNClientName ),
+    SndCrdBridge                     ( AudioCallbackFloat, this ),
+    bFadeInSndCrd                    ( false ),
+    iCodecSwitchState                ( CS_NONE ),
     iAudioInFader                    ( AUD_FADER_IN_MIDDLE ),
     bReverbOnLeftChan                ( false ),
     iReverbLevel                     ( 0 ),
     iSndCrdPrefFrameSizeFactor       ( FRAME_SIZE_FACTOR_DEFAULT ),
     iSndCrdFrameSizeFactor           ( FRAME_SIZE_FACTOR_DEFAULT ),
     bSndCrdConversionBufferRequired  ( false ),
+    iSndCrdNumSubBlocks              ( 1 ),
     iSndCardMonoBlockSizeSamConvBuff ( 0 ),
     bFraSiFactPrefSupported          ( false ),
     bFraSiFactDefSupported           ( false ),
     bFraSiFactSafeSupported          ( false ),
+    iMonoBlockSizeSam                ( 0 ),
+    iStereoBlockSizeSam              ( 0 ),
     eGUIDesign                       ( GD_ORIGINAL ),
     bDisplayChannelLevels            ( true ),
+    bChannelLevelsPaused             ( false ),
+    bChannelLevelDeltaValid          ( false ),
+    bSessionSetupSent                ( false ),
+    iChannelLevelDeltaSeqNum         ( 0 ),
     bEnableOPUS64                    ( false ),
-    bJitterBufferOK                  ( true ),
+    bEnableTimeStretch               ( false ),
+    bEnableRedundancy                ( false ),
+    bEnableSeqNum                    ( true ),
+    bEnableMultiStream               ( false ),
+    iNumSubStreams                   ( 0 ),
+    bEnableMultitrack                ( false ),
+    bEnableDirectMonitor             ( false ),
+    bInitBatch                       ( false ),
+    bInitPending                     ( false ),
+    bEnableAdaptiveEncoder           ( true ),
+    bEnableAdaptiveAggregation       ( true ),
+    bEnableAdaptiveQuality           ( true ),
+    iEncoderBitRate                  ( 0 ),
+    iOwnChanID                       ( INVALID_INDEX ),
+    iNumJitBufGetErrors              ( 0 ),
+    iLastNumJitBufGetErrors          ( 0 ),
+    iLastNumJitBufPutErrors          ( 0 ),
+    iLastNumBufOverruns              ( 0 ),
     strCentralServerAddress          ( "" ),
     eCentralServerAddressType        ( AT_DEFAULT ),
     iServerSockBufNumFrames          ( DEF_NET_BUF_SIZE_NUM_BL ),
+    strServerAddr                    ( "" ),
+    iConnectPingJitterMs             ( -1 ),
     pSignalHandler                   ( CSignalHandler::getSingletonP() )
 {
     int iOpusError;
 
+    Channel.SetFlightRecorder ( &FlightRecorder, 0 );
+
     OpusMode = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
                                          DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES,
                                          &iOpusError );
@@ -103,25 +560,75 @@ CClient::CClient ( const quint16  iPortNumber,
     Opus64EncoderStereo = opus_custom_encoder_create ( Opus64Mode, 2, &iOpusError ); // stereo encoder OPUS64
     Opus64DecoderStereo = opus_custom_decoder_create ( Opus64Mode, 2, &iOpusError ); // stereo decoder OPUS64
 
+    // the redundant frames have their own encoders since the encoder state
+    // depends on the bit rate
+    OpusRedEncoderMono     = opus_custom_encoder_create ( OpusMode,   1, &iOpusError ); // mono redundancy encoder legacy
+    OpusRedEncoderStereo   = opus_custom_encoder_create ( OpusMode,   2, &iOpusError ); // stereo redundancy encoder legacy
+    Opus64RedEncoderMono   = opus_custom_encoder_create ( Opus64Mode, 1, &iOpusError ); // mono redundancy encoder OPUS64
+    Opus64RedEncoderStereo = opus_custom_encoder_create ( Opus64Mode, 2, &iOpusError ); // stereo redundancy encoder OPUS64
+
+    // the sub-stream of the multi-stream mode has its own encoders
+    OpusSubEncoderMono     = opus_custom_encoder_create ( OpusMode,   1, &iOpusError ); // mono sub-stream encoder legacy
+    OpusSubEncoderStereo   = opus_custom_encoder_create ( OpusMode,   2, &iOpusError ); // stereo sub-stream encoder legacy
+    Opus64SubEncoderMono   = opus_custom_encoder_create ( Opus64Mode, 1, &iOpusError ); // mono sub-stream encoder OPUS64
+    Opus64SubEncoderStereo = opus_custom_encoder_create ( Opus64Mode, 2, &iOpusError ); // stereo sub-stream encoder OPUS64
+
     // we require a constant bit rate
     opus_custom_encoder_ctl ( OpusEncoderMono,     OPUS_SET_VBR ( 0 ) );
     opus_custom_encoder_ctl ( OpusEncoderStereo,   OPUS_SET_VBR ( 0 ) );
     opus_custom_encoder_ctl ( Opus64EncoderMono,   OPUS_SET_VBR ( 0 ) );
     opus_custom_encoder_ctl ( Opus64EncoderStereo, OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( OpusRedEncoderMono,     OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( OpusRedEncoderStereo,   OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( Opus64RedEncoderMono,   OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( Opus64RedEncoderStereo, OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( OpusSubEncoderMono,     OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( OpusSubEncoderStereo,   OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( Opus64SubEncoderMono,   OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( Opus64SubEncoderStereo, OPUS_SET_VBR ( 0 ) );
 
     // for 64 samples frame size we have to adjust the PLC behavior to avoid loud artifacts
     opus_custom_encoder_ctl ( Opus64EncoderMono,   OPUS_SET_PACKET_LOSS_PERC ( 35 ) );
     opus_custom_encoder_ctl ( Opus64EncoderStereo, OPUS_SET_PACKET_LOSS_PERC ( 35 ) );
+    opus_custom_encoder_ctl ( Opus64SubEncoderMono,   OPUS_SET_PACKET_LOSS_PERC ( 35 ) );
+    opus_custom_encoder_ctl ( Opus64SubEncoderStereo, OPUS_SET_PACKET_LOSS_PERC ( 35 ) );
+
+    // a redundant frame is only decoded after a packet loss, i.e. the decoder
+    // state does not match the encoder state (reduces the inter frame
+    // prediction)
+    opus_custom_encoder_ctl ( OpusRedEncoderMono,     OPUS_SET_PACKET_LOSS_PERC ( 35 ) );
+    opus_custom_encoder_ctl ( OpusRedEncoderStereo,   OPUS_SET_PACKET_LOSS_PERC ( 35 ) );
+    opus_custom_encoder_ctl ( Opus64RedEncoderMono,   OPUS_SET_PACKET_LOSS_PERC ( 35 ) );
+    opus_custom_encoder_ctl ( Opus64RedEncoderStereo, OPUS_SET_PACKET_LOSS_PERC ( 35 ) );
 
     // we want as low delay as possible
     opus_custom_encoder_ctl ( OpusEncoderMono,     OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
     opus_custom_encoder_ctl ( OpusEncoderStereo,   OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
     opus_custom_encoder_ctl ( Opus64EncoderMono,   OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
     opus_custom_encoder_ctl ( Opus64EncoderStereo, OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+    opus_custom_encoder_ctl ( OpusRedEncoderMono,     OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+    opus_custom_encoder_ctl ( OpusRedEncoderStereo,   OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+    opus_custom_encoder_ctl ( Opus64RedEncoderMono,   OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+    opus_custom_encoder_ctl ( Opus64RedEncoderStereo, OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+    opus_custom_encoder_ctl ( OpusSubEncoderMono,     OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+    opus_custom_encoder_ctl ( OpusSubEncoderStereo,   OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+    opus_custom_encoder_ctl ( Opus64SubEncoderMono,   OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+    opus_custom_encoder_ctl ( Opus64SubEncoderStereo, OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
 
     // set encoder low complexity for legacy 128 samples frame size
     opus_custom_encoder_ctl ( OpusEncoderMono,   OPUS_SET_COMPLEXITY ( 1 ) );
     opus_custom_encoder_ctl ( OpusEncoderStereo, OPUS_SET_COMPLEXITY ( 1 ) );
+    opus_custom_encoder_ctl ( OpusSubEncoderMono,   OPUS_SET_COMPLEXITY ( 1 ) );
+    opus_custom_encoder_ctl ( OpusSubEncoderStereo, OPUS_SET_COMPLEXITY ( 1 ) );
+
+    // the redundant frames always use a low complexity
+    opus_custom_encoder_ctl ( OpusRedEncoderMono,     OPUS_SET_COMPLEXITY ( 1 ) );
+    opus_custom_encoder_ctl ( OpusRedEncoderStereo,   OPUS_SET_COMPLEXITY ( 1 ) );
+    opus_custom_encoder_ctl ( Opus64RedEncoderMono,   OPUS_SET_COMPLEXITY ( 1 ) );
+    opus_custom_encoder_ctl ( Opus64RedEncoderStereo, OPUS_SET_COMPLEXITY ( 1 ) );
+
+    // select the mixing kernel implementation supported by the CPU
+    CMixKernel::Init();
 
 
     // Connections -------------------------------------------------------------
@@ -150,6 +657,9 @@ CClient::CClient ( const quint16  iPortNumber,
     QObject::connect ( &Channel, &CChannel::NewConnection,
         this, &CClient::OnNewConnection );
 
+    QObject::connect ( &Channel, &CChannel::SessionSetupRequired,
+        this, &CClient::OnSessionSetupRequired );
+
     QObject::connect ( &Channel, &CChannel::ChatTextReceived,
         this, &CClient::ChatTextReceived );
 
@@ -168,18 +678,39 @@ CClient::CClient ( const quint16  iPortNumber,
     QObject::connect ( &Channel, &CChannel::RecorderStateReceived,
         this, &CClient::RecorderStateReceived );
 
+    QObject::connect ( &Channel, &CChannel::MixGroupListReceived,
+        this, &CClient::OnMixGroupListReceived );
+
+    QObject::connect ( &Channel, &CChannel::NetStatsReceived,
+        this, &CClient::OnNetStatsReceived );
+
+    QObject::connect ( &Channel, &CChannel::MulticastGroupReceived,
+        this, &CClient::OnMulticastGroupReceived );
+
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLMessReadyForSending,
         this, &CClient::OnSendCLProtMessage );
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLServerListReceived,
         this, &CClient::CLServerListReceived );
 
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLServerListPageReceived,
+        this, &CClient::CLServerListPageReceived );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLServerListIPv6Received,
+        this, &CClient::CLServerListIPv6Received );
+
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLConnClientsListMesReceived,
         this, &CClient::CLConnClientsListMesReceived );
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLPingReceived,
         this, &CClient::OnCLPingReceived );
 
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLRttProbeReceived,
+        this, &CClient::OnCLRttProbeReceived );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLLatencyProbeReceived,
+        this, &CClient::OnCLLatencyProbeReceived );
+
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLPingWithNumClientsReceived,
         this, &CClient::OnCLPingWithNumClientsReceived );
 
@@ -194,6 +725,12 @@ CClient::CClient ( const quint16  iPortNumber,
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLChannelLevelListReceived,
         this, &CClient::CLChannelLevelListReceived );
 
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLChannelLevelDeltaReceived,
+        this, &CClient::OnCLChannelLevelDeltaReceived );
+
+    // sound card backends with native float buffers call our float callback
+    Sound.SetProcessCallbackFloat ( AudioCallbackFloat );
+
     // other
     QObject::connect ( &Sound, &CSound::ReinitRequest,
         this, &CClient::OnSndCrdReinitRequest );
@@ -207,6 +744,28 @@ CClient::CClient ( const quint16  iPortNumber,
     QObject::connect ( pSignalHandler, &CSignalHandler::HandledSignal,
         this, &CClient::OnHandledSignal );
 
+    vecdPendingRemoteGains.Init ( MAX_NUM_CHANNELS, -1.0 );
+    vecdPendingRemotePans.Init  ( MAX_NUM_CHANNELS, -1.0 );
+    vecdPendingRemoteMixGroupGains.Init ( MAX_NUM_MIX_GROUPS + 1, -1.0 );
+
+    QObject::connect ( &TimerRemoteMixUpdate, &QTimer::timeout,
+        this, &CClient::OnTimerRemoteMixUpdate );
+
+    QObject::connect ( &TimerNetwAggregation, &QTimer::timeout,
+        this, &CClient::OnTimerNetwAggregation );
+
+    QObject::connect ( &TimerAudioQuality, &QTimer::timeout,
+        this, &CClient::OnTimerAudioQuality );
+
+    TimerRemoteMixUpdate.setInterval ( CLIENT_REMOTE_MIX_UPDATE_INTERVAL_MS );
+
+#ifdef RT_SAFETY_CHECK
+    QObject::connect ( &TimerRtSafetyReport, &QTimer::timeout,
+        &CRtSafetyChecker::PrintViolations );
+
+    TimerRtSafetyReport.start ( RT_SAFETY_REPORT_INTERVAL_MS );
+#endif
+
 
     // start the socket (it is important to start the socket after all
     // initializations and connections)
@@ -220,19 +779,23 @@ CClient::CClient ( const quint16  iPortNumber,
     }
 }
 
-void CClient::OnSendProtMessage ( CVector<uint8_t> vecMessage )
+void CClient::OnSendProtMessage ( CProtMessage Message )
 {
     // the protocol queries me to call the function to send the message
-    // send it through the network
-    Socket.SendPacket ( vecMessage, Channel.GetAddress() );
+    // send it through the network (the channel has the converted socket
+    // address of the server)
+    if ( Message.Size() > 0 )
+    {
+        Socket.SendProtPacket ( Message.Data().data(), Message.Size(), Channel.GetSockAddr() );
+    }
 }
 
-void CClient::OnSendCLProtMessage ( CHostAddress     InetAddr,
-                                    CVector<uint8_t> vecMessage )
+void CClient::OnSendCLProtMessage ( CHostAddress InetAddr,
+                                    CProtMessage Message )
 {
     // the protocol queries me to call the function to send the message
     // send it through the network
-    Socket.SendPacket ( vecMessage, InetAddr );
+    Socket.SendProtPacket ( Message, InetAddr );
 }
 
 void CClient::OnInvalidPacketReceived ( CHostAddress RecHostAddr )
@@ -247,12 +810,12 @@ void CClient::OnInvalidPacketReceived ( CHostAddress RecHostAddr )
     }
 }
 
-void CClient::OnDetectedCLMessage ( CVector<uint8_t> vecbyMesBodyData,
-                                    int              iRecID,
-                                    CHostAddress     RecHostAddr )
+void CClient::OnDetectedCLMessage ( CProtMessage MesBody,
+                                    int          iRecID,
+                                    CHostAddress RecHostAddr )
 {
     // connection less messages are always processed
-    ConnLessProtocol.ParseConnectionLessMessageBody ( vecbyMesBodyData,
+    ConnLessProtocol.ParseConnectionLessMessageBody ( MesBody,
                                                       iRecID,
                                                       RecHostAddr );
 }
@@ -270,7 +833,35 @@ void CClient::OnJittBufSizeChanged ( int iNewJitBufSize )
     }
 }
 
+void CClient::OnSessionSetupRequired()
+{
+    // our first audio packet was sent, the properties of the connection are
+    // sent in the session setup together with our protocol version message so
+    // that the server does not have to request them (a server which does not
+    // support the session setup ignores it, the properties are sent again on
+    // the new connection then)
+    Channel.BeginSessionSetup();
+    Channel.CreateNetwTranspPropsMes();
+    SendConnectionProperties();
+    Channel.EndSessionSetup();
+
+    bSessionSetupSent = true;
+}
+
 void CClient::OnNewConnection()
+{
+    // the properties were already sent if the server supports the session
+    // setup (note that the server might only have sent audio yet, in this case
+    // the properties are sent again which does no harm)
+    if ( bSessionSetupSent && ( Channel.GetPeerProtVersion() >= PROT_VERSION_SESSION_SETUP ) )
+    {
+        return;
+    }
+
+    SendConnectionProperties();
+}
+
+void CClient::SendConnectionProperties()
 {
     // a new connection was successfully initiated, send infos and request
     // connected clients list
@@ -285,8 +876,51 @@ void CClient::OnNewConnection()
     Channel.CreateReqConnClientsList();
     CreateServerJitterBufferMessage();
 
-    // send opt-in / out for Channel Level updates
-    Channel.CreateReqChannelLevelListMes ( bDisplayChannelLevels );
+    // send opt-in / out for Channel Level updates (we support the compact
+    // message, old servers ignore this request and send the full list)
+    bChannelLevelDeltaValid = false;
+    Channel.CreateReqChannelLevelDeltaMes ( 1 );
+    Channel.CreateReqChannelLevelListMes ( bDisplayChannelLevels && !bChannelLevelsPaused );
+
+    // a listener tells the server that its audio shall not be mixed
+    if ( bListenerMode )
+    {
+        Channel.CreateListenerModeMes ( true );
+    }
+
+    // the server sums our signal in the bus of our mix group
+    if ( iMixGroup != NO_MIX_GROUP )
+    {
+        Channel.CreateMixGroupMes ( iMixGroup );
+    }
+}
+
+void CClient::OnMixGroupListReceived ( CVector<int> vecMixGroups )
+{
+    // the multitrack mixer applies the mix group gains as the server does
+    for ( int i = 0; i < vecMixGroups.Size(); i++ )
+    {
+        Multitrack.SetMixGroup ( i, vecMixGroups[i] );
+    }
+
+    emit MixGroupListReceived ( vecMixGroups );
+}
+
+void CClient::OnMulticastGroupReceived ( int          iStream,
+                                         CHostAddress GroupAddr )
+{
+    // the server sends our mix to the group as soon as we have confirmed the
+    // stream, until then (or if we cannot join) we receive it by unicast
+    if ( iStream == NO_MULTICAST_STREAM )
+    {
+        Socket.LeaveMulticastGroup();
+    }
+    else if ( !Socket.JoinMulticastGroup ( GroupAddr ) )
+    {
+        iStream = NO_MULTICAST_STREAM;
+    }
+
+    Channel.CreateMulticastJoinedMes ( iStream );
 }
 
 void CClient::CreateServerJitterBufferMessage()
@@ -315,38 +949,117 @@ void CClient::OnCLPingReceived ( CHostAddress InetAddr,
         const int iCurDiff = EvaluatePingMessage ( iMs );
         if ( iCurDiff >= 0 )
         {
+            AudioQualityControl.PutRtt ( iCurDiff );
+
             emit PingTimeReceived ( iCurDiff );
         }
     }
 }
 
-void CClient::OnCLPingWithNumClientsReceived ( CHostAddress InetAddr,
-                                               int          iMs,
-                                               int          iNumClients )
+void CClient::OnCLRttProbeReceived ( CHostAddress InetAddr,
+                                     int          iMs )
 {
-    // take care of wrap arounds (if wrapping, do not use result)
-    const int iCurDiff = EvaluatePingMessage ( iMs );
-    if ( iCurDiff >= 0 )
+    // the server we are connected to measures its round trip time to us, we
+    // just send the time stamp back
+    if ( IsRunning() && ( InetAddr == Channel.GetAddress() ) )
     {
-        emit CLPingTimeWithNumClientsReceived ( InetAddr,
-                                                iCurDiff,
-                                                iNumClients );
+        ConnLessProtocol.CreateCLRttProbeEchoMes ( InetAddr, iMs );
     }
 }
 
-int CClient::PreparePingMessage()
+void CClient::OnCLLatencyProbeReceived ( CHostAddress       InetAddr,
+                                         CServerLatencyInfo LatencyInfo )
 {
-    // transmit the current precise time (in ms)
-    return PreciseTime.elapsed();
-}
+    // make sure we are running and the server address is correct
+    if ( !IsRunning() || !( InetAddr == Channel.GetAddress() ) )
+    {
+        return;
+    }
 
-int CClient::EvaluatePingMessage ( const int iMs )
-{
-    // calculate difference between received time in ms and current time in ms
-    return PreciseTime.elapsed() - iMs;
-}
+    // take care of wrap arounds (if wrapping, do not use result)
+    const int iRttMs = EvaluatePingMessage ( LatencyInfo.iTransmitTimeMs );
 
-void CClient::SetCentralServerAddressType ( const ECSAddType eNCSAT )
+    if ( iRttMs < 0 )
+    {
+        return;
+    }
+
+    CLatencyBreakdown Breakdown;
+
+    // the probe is not queued in the jitter buffers, its round trip time is
+    // the pure network delay (we assume the same delay for both directions)
+    Breakdown.dNetworkUpMs   = iRttMs / 2.0;
+    Breakdown.dNetworkDownMs = iRttMs / 2.0;
+
+    // the server stages are measured by the server
+    Breakdown.dServerQueueMs = LatencyInfo.iQueueDelayUs / 1000.0;
+    Breakdown.dMixMs         = LatencyInfo.iMixTimeUs / 1000.0;
+
+    // the audio interface only reports the sum of the input and the output
+    // latency, we assume equal parts (otherwise the same estimate as in
+    // EstimatedOverallDelay() is used: two periods for the input and one for
+    // the output)
+    const double dSoundCardInputOutputLatencyMs = Sound.GetInOutLatencyMs();
+    const double dSndCrdBlockDurationMs         =
+        static_cast<double> ( GetSndCrdActualMonoBlSize() ) * 1000 / SYSTEM_SAMPLE_RATE_HZ;
+
+    Breakdown.bSoundCardMeasured = ( dSoundCardInputOutputLatencyMs != 0.0 );
+
+    if ( Breakdown.bSoundCardMeasured )
+    {
+        Breakdown.dCaptureMs = dSoundCardInputOutputLatencyMs / 2;
+        Breakdown.dPlayoutMs = dSoundCardInputOutputLatencyMs / 2;
+    }
+    else
+    {
+        Breakdown.dCaptureMs = 2 * dSndCrdBlockDurationMs;
+        Breakdown.dPlayoutMs = dSndCrdBlockDurationMs;
+    }
+
+    // the sample rate conversion is done in both directions
+    Breakdown.dCaptureMs += Sound.GetSampleRateConvDelayMs() / 2;
+    Breakdown.dPlayoutMs += Sound.GetSampleRateConvDelayMs() / 2;
+
+    // conversion buffer, filling of the network packets and the additional
+    // delay of OPUS at small frame sizes (half a frame size)
+    Breakdown.dClientBufferMs =
+        static_cast<double> ( GetSndCrdConvBufAdditionalDelayMonoBlSize() ) * 1000 / SYSTEM_SAMPLE_RATE_HZ +
+        static_cast<double> ( GetSystemMonoBlSize() ) * 1000 / SYSTEM_SAMPLE_RATE_HZ +
+        static_cast<double> ( iOPUSFrameSizeSamples ) * 1000 / SYSTEM_SAMPLE_RATE_HZ / 2;
+
+    // measured queueing delay of our jitter buffer
+    Breakdown.dPlayoutMs += Channel.GetJitBufDelayUs() / 1000.0;
+
+    emit LatencyBreakdownReceived ( Breakdown );
+}
+
+void CClient::OnCLPingWithNumClientsReceived ( CHostAddress InetAddr,
+                                               int          iMs,
+                                               int          iNumClients )
+{
+    // take care of wrap arounds (if wrapping, do not use result)
+    const int iCurDiff = EvaluatePingMessage ( iMs );
+    if ( iCurDiff >= 0 )
+    {
+        emit CLPingTimeWithNumClientsReceived ( InetAddr,
+                                                iCurDiff,
+                                                iNumClients );
+    }
+}
+
+int CClient::PreparePingMessage()
+{
+    // transmit the current precise time (in ms)
+    return PreciseTime.elapsed();
+}
+
+int CClient::EvaluatePingMessage ( const int iMs )
+{
+    // calculate difference between received time in ms and current time in ms
+    return PreciseTime.elapsed() - iMs;
+}
+
+void CClient::SetCentralServerAddressType ( const ECSAddType eNCSAT )
 {
     if ( eCentralServerAddressType != eNCSAT )
     {
@@ -373,9 +1086,127 @@ void CClient::SetRemoteChanGain ( const int    iId,
     if ( bIsMyOwnFader )
     {
         dMuteOutStreamGain = dGain;
+        iOwnChanID         = iId;
+
+        // with direct monitoring our own signal is removed from the server mix
+        // and the fader only controls the local monitoring level
+        if ( bEnableDirectMonitor )
+        {
+            QueueRemoteChanGain ( iId, 0.0 );
+            Multitrack.SetGain ( iId, 0.0 );
+            return;
+        }
+    }
+
+    QueueRemoteChanGain ( iId, dGain );
+    Multitrack.SetGain ( iId, dGain );
+}
+
+void CClient::SetRemoteChanPan ( const int    iId,
+                                 const double dPan )
+{
+    QueueRemoteChanPan ( iId, dPan );
+    Multitrack.SetPan ( iId, dPan );
+}
+
+void CClient::SetRemoteMixGroupGain ( const int    iMixGroup,
+                                      const double dGain )
+{
+    if ( ( iMixGroup <= NO_MIX_GROUP ) || ( iMixGroup > MAX_NUM_MIX_GROUPS ) )
+    {
+        return;
+    }
+
+    // the mix group gains go through the same queue as the channel gains
+    if ( TimerRemoteMixUpdate.isActive() )
+    {
+        vecdPendingRemoteMixGroupGains[iMixGroup] = dGain;
+    }
+    else
+    {
+        Channel.CreateMixGroupGainMes ( iMixGroup, dGain );
+        TimerRemoteMixUpdate.start();
+    }
+
+    Multitrack.SetMixGroupGain ( iMixGroup, dGain );
+}
+
+void CClient::QueueRemoteChanGain ( const int    iId,
+                                    const double dGain )
+{
+    // a fader sends a new value per slider step, only the latest value of an
+    // interval is sent to the server (all gains go through this queue so that
+    // a pending value cannot overwrite a newer one)
+    if ( TimerRemoteMixUpdate.isActive() && ( iId >= 0 ) && ( iId < MAX_NUM_CHANNELS ) )
+    {
+        vecdPendingRemoteGains[iId] = dGain;
+    }
+    else
+    {
+        Channel.SetRemoteChanGain ( iId, dGain );
+        TimerRemoteMixUpdate.start();
+    }
+}
+
+void CClient::QueueRemoteChanPan ( const int    iId,
+                                   const double dPan )
+{
+    if ( TimerRemoteMixUpdate.isActive() && ( iId >= 0 ) && ( iId < MAX_NUM_CHANNELS ) )
+    {
+        vecdPendingRemotePans[iId] = dPan;
+    }
+    else
+    {
+        Channel.SetRemoteChanPan ( iId, dPan );
+        TimerRemoteMixUpdate.start();
+    }
+}
+
+void CClient::OnTimerRemoteMixUpdate()
+{
+    bool bSent = false;
+
+    for ( int i = 0; ( i < MAX_NUM_CHANNELS ) && !bSent; i++ )
+    {
+        bSent = ( vecdPendingRemoteGains[i] >= 0.0 ) || ( vecdPendingRemotePans[i] >= 0.0 );
+    }
+
+    // the pending gains and pans of all channels are sent in one message (if
+    // the server supports it)
+    if ( bSent )
+    {
+        Channel.SetRemoteChanGainPanList ( vecdPendingRemoteGains, vecdPendingRemotePans );
+        vecdPendingRemoteGains.Reset ( -1.0 );
+        vecdPendingRemotePans.Reset ( -1.0 );
+    }
+
+    for ( int i = NO_MIX_GROUP + 1; i <= MAX_NUM_MIX_GROUPS; i++ )
+    {
+        if ( vecdPendingRemoteMixGroupGains[i] >= 0.0 )
+        {
+            Channel.CreateMixGroupGainMes ( i, vecdPendingRemoteMixGroupGains[i] );
+            vecdPendingRemoteMixGroupGains[i] = -1.0;
+            bSent                             = true;
+        }
     }
 
-    Channel.SetRemoteChanGain ( iId, dGain );
+    // the timer runs as long as the faders are moved
+    if ( !bSent )
+    {
+        TimerRemoteMixUpdate.stop();
+    }
+}
+
+void CClient::SetEnableDirectMonitor ( const bool bNEnableDirectMonitor )
+{
+    bEnableDirectMonitor = bNEnableDirectMonitor;
+
+    // update our own channel gain in the server mix
+    if ( Channel.IsConnected() && ( iOwnChanID != INVALID_INDEX ) )
+    {
+        QueueRemoteChanGain ( iOwnChanID, bEnableDirectMonitor ? 0.0 : dMuteOutStreamGain );
+        Multitrack.SetGain ( iOwnChanID, bEnableDirectMonitor ? 0.0 : dMuteOutStreamGain );
+    }
 }
 
 bool CClient::SetServerAddr ( QString strNAddr )
@@ -384,8 +1215,15 @@ bool CClient::SetServerAddr ( QString strNAddr )
     if ( NetworkUtil().ParseNetworkAddress ( strNAddr,
                                              HostAddress ) )
     {
+        // the delay of the current connection belongs to the old server
+        if ( IsRunning() && ( strNAddr != strServerAddr ) )
+        {
+            StoreJitBufDelay();
+        }
+
         // apply address to the channel
         Channel.SetAddress ( HostAddress );
+        strServerAddr = strNAddr;
 
         return true;
     }
@@ -397,33 +1235,91 @@ bool CClient::SetServerAddr ( QString strNAddr )
 
 bool CClient::GetAndResetbJitterBufferOKFlag()
 {
-    // get the socket buffer put status flag and reset it
-    const bool bSocketJitBufOKFlag = Socket.GetAndResetbJitterBufferOKFlag();
+    // the audio thread and the socket thread count the errors, the status is
+    // not OK if one of the counters has changed since the last call
+    const int iNumGetErrors = Telemetry.Read().iNumJitBufGetErrors;
+    const int iNumPutErrors = Socket.GetNumJitBufPutErrors();
+
+    // the received packets are moved from the hand-off buffer to the jitter
+    // buffer in the audio callback, overruns there do not show up in the socket
+    // counter and are detected by the overrun counter of the channel
+    CChannelNetStats NetStats;
+    Channel.GetNetStats ( NetStats );
+
+    const bool bJitBufOK = ( iNumGetErrors == iLastNumJitBufGetErrors ) &&
+                           ( iNumPutErrors == iLastNumJitBufPutErrors ) &&
+                           ( NetStats.iNumOverruns == iLastNumBufOverruns );
+
+    iLastNumJitBufGetErrors = iNumGetErrors;
+    iLastNumJitBufPutErrors = iNumPutErrors;
+    iLastNumBufOverruns     = NetStats.iNumOverruns;
+
+    return bJitBufOK;
+}
+
+void CClient::SetDisplayChannelLevels ( const bool bNDCL )
+{
+    bDisplayChannelLevels = bNDCL;
 
-    if ( !bJitterBufferOK )
+    // tell any connected server about the change
+    Channel.CreateReqChannelLevelListMes ( bDisplayChannelLevels && !bChannelLevelsPaused );
+}
+
+void CClient::SetChannelLevelsPaused ( const bool bNCLP )
+{
+    if ( bChannelLevelsPaused != bNCLP )
     {
-        // our jitter buffer get status is not OK so the overall status of the
-        // jitter buffer is also not OK (we do not have to consider the status
-        // of the socket buffer put status flag)
+        bChannelLevelsPaused = bNCLP;
 
-        // reset flag before returning the function
-        bJitterBufferOK = true;
-        return false;
-    }
+        // the levels of the first messages after the pause are not valid
+        // anymore, they are shown again after the next full list
+        if ( !bChannelLevelsPaused )
+        {
+            bChannelLevelDeltaValid = false;
+        }
 
-    // the jitter buffer get (our own status flag) is OK, the final status
-    // now depends on the jitter buffer put status flag from the socket
-    // since per definition the jitter buffer status is OK if both the
-    // put and get status are OK
-    return bSocketJitBufOKFlag;
+        Channel.CreateReqChannelLevelListMes ( bDisplayChannelLevels && !bChannelLevelsPaused );
+    }
 }
 
-void CClient::SetDisplayChannelLevels ( const bool bNDCL )
+void CClient::OnCLChannelLevelDeltaReceived ( CHostAddress      InetAddr,
+                                              int               iSeqNum,
+                                              bool              bFullList,
+                                              CVector<uint16_t> vecLevelList )
 {
-    bDisplayChannelLevels = bNDCL;
+    const int iNumClients = vecLevelList.Size();
 
-    // tell any connected server about the change
-    Channel.CreateReqChannelLevelListMes ( bDisplayChannelLevels );
+    if ( bFullList )
+    {
+        bChannelLevelDeltaValid = true;
+        vecChannelLevelDelta.Init ( iNumClients );
+        vecChannelLevelDelta = vecLevelList;
+    }
+    else
+    {
+        // a lost message makes the levels invalid until the next full list
+        if ( !bChannelLevelDeltaValid ||
+             ( iSeqNum != ( ( iChannelLevelDeltaSeqNum + 1 ) & 0xFF ) ) ||
+             ( iNumClients != vecChannelLevelDelta.Size() ) )
+        {
+            bChannelLevelDeltaValid  = false;
+            iChannelLevelDeltaSeqNum = iSeqNum;
+            return;
+        }
+
+        for ( int i = 0; i < iNumClients; i++ )
+        {
+            if ( vecLevelList[i] != CHANNEL_LEVEL_UNCHANGED )
+            {
+                vecChannelLevelDelta[i] = vecLevelList[i];
+            }
+        }
+    }
+
+    iChannelLevelDeltaSeqNum = iSeqNum;
+
+    // the GUI always gets the complete list
+    emit CLChannelLevelListReceived ( InetAddr, vecChannelLevelDelta );
 }
 
 void CClient::SetSndCrdPrefFrameSizeFactor ( const int iNewFactor )
@@ -457,6 +1353,14 @@ void CClient::SetSndCrdPrefFrameSizeFactor ( const int iNewFactor )
 
 void CClient::SetEnableOPUS64 ( const bool eNEnableOPUS64 )
 {
+    // the OPUS64 codec is only used for sound card buffers below the double
+    // system frame size, for larger buffers the running stream is not changed
+    if ( Sound.IsRunning() && ( GetSndCrdActualMonoBlSize() >= DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES ) )
+    {
+        bEnableOPUS64 = eNEnableOPUS64;
+        return;
+    }
+
     // init with new parameter, if client was running then first
     // stop it and restart again after new initialization
     const bool bWasRunning = Sound.IsRunning();
@@ -475,7 +1379,7 @@ void CClient::SetEnableOPUS64 ( const bool eNEnableOPUS64 )
     }
 }
 
-void CClient::SetAudioQuality ( const EAudioQuality eNAudioQuality )
+void CClient::SetEnableRedundancy ( const bool bNEnableRedundancy )
 {
     // init with new parameter, if client was running then first
     // stop it and restart again after new initialization
@@ -486,7 +1390,7 @@ void CClient::SetAudioQuality ( const EAudioQuality eNAudioQuality )
     }
 
     // set new parameter
-    eAudioQuality = eNAudioQuality;
+    bEnableRedundancy = bNEnableRedundancy;
     Init();
 
     if ( bWasRunning )
@@ -495,7 +1399,7 @@ void CClient::SetAudioQuality ( const EAudioQuality eNAudioQuality )
     }
 }
 
-void CClient::SetAudioChannels ( const EAudChanConf eNAudChanConf )
+void CClient::SetEnableSeqNum ( const bool bNEnableSeqNum )
 {
     // init with new parameter, if client was running then first
     // stop it and restart again after new initialization
@@ -506,7 +1410,67 @@ void CClient::SetAudioChannels ( const EAudChanConf eNAudChanConf )
     }
 
     // set new parameter
-    eAudioChannelConf = eNAudChanConf;
+    bEnableSeqNum = bNEnableSeqNum;
+    Init();
+
+    if ( bWasRunning )
+    {
+        Sound.Start();
+    }
+}
+
+void CClient::SetEnableMultiStream ( const bool bNEnableMultiStream )
+{
+    // init with new parameter, if client was running then first
+    // stop it and restart again after new initialization
+    const bool bWasRunning = Sound.IsRunning();
+    if ( bWasRunning )
+    {
+        Sound.Stop();
+    }
+
+    // set new parameter
+    bEnableMultiStream = bNEnableMultiStream;
+    Init();
+
+    if ( bWasRunning )
+    {
+        Sound.Start();
+    }
+}
+
+void CClient::SetEnableMultitrack ( const bool bNEnableMultitrack )
+{
+    // init with new parameter, if client was running then first
+    // stop it and restart again after new initialization
+    const bool bWasRunning = Sound.IsRunning();
+    if ( bWasRunning )
+    {
+        Sound.Stop();
+    }
+
+    // set new parameter
+    bEnableMultitrack = bNEnableMultitrack;
+    Init();
+
+    if ( bWasRunning )
+    {
+        Sound.Start();
+    }
+}
+
+void CClient::SetEnableTimeStretch ( const bool bNEnableTimeStretch )
+{
+    // init with new parameter, if client was running then first
+    // stop it and restart again after new initialization
+    const bool bWasRunning = Sound.IsRunning();
+    if ( bWasRunning )
+    {
+        Sound.Stop();
+    }
+
+    // set new parameter
+    bEnableTimeStretch = bNEnableTimeStretch;
     Init();
 
     if ( bWasRunning )
@@ -515,6 +1479,65 @@ void CClient::SetAudioChannels ( const EAudChanConf eNAudChanConf )
     }
 }
 
+void CClient::SetAudioQuality ( const EAudioQuality eNAudioQuality )
+{
+    // set new parameter (the adaptive quality starts with the new setting),
+    // the codecs are switched while the sound card keeps running
+    eAudioQuality = eNAudioQuality;
+    AudioQualityControl.Reset ( eAudioQuality );
+    SwitchCodec();
+}
+
+void CClient::SetAudioChannels ( const EAudChanConf eNAudChanConf )
+{
+    // set new parameter, the codecs are switched while the sound card keeps
+    // running
+    eAudioChannelConf = eNAudChanConf;
+    SwitchCodec();
+}
+
+void CClient::SwitchCodec()
+{
+    // without a running sound card (or during an init batch) we simply do a
+    // complete init
+    if ( !Sound.IsRunning() || bInitBatch )
+    {
+        Init();
+        return;
+    }
+
+    // the audio thread fades out its current block and does not touch the
+    // codecs anymore after it (it outputs silence until we are done)
+    iCodecSwitchState.storeRelease ( CS_REQUESTED );
+
+    QElapsedTimer SwitchTimer;
+    SwitchTimer.start();
+
+    while ( ( iCodecSwitchState.loadAcquire() == CS_REQUESTED ) &&
+            ( SwitchTimer.elapsed() < CLIENT_CODEC_SWITCH_TIMEOUT_MS ) )
+    {
+        QThread::usleep ( 500 );
+    }
+
+    if ( iCodecSwitchState.testAndSetOrdered ( CS_REQUESTED, CS_NONE ) )
+    {
+        // the sound card does not call us (e.g. the device hangs), the switch
+        // is done with the sound card stopped
+        Sound.Stop();
+        Init();
+        bFadeInSndCrd = true;
+        Sound.Start();
+        return;
+    }
+
+    // the sound card block layout is not changed, only the codecs, the
+    // buffers of the coded frames and the network properties are updated,
+    // then the audio thread continues with a fade-in
+    InitCodec ( true );
+
+    iCodecSwitchState.storeRelease ( CS_RESUME );
+}
+
 QString CClient::SetSndCrdDev ( const int iNewDev )
 {
     // if client was running then first
@@ -523,17 +1546,28 @@ QString CClient::SetSndCrdDev ( const int iNewDev )
     if ( bWasRunning )
     {
         Sound.Stop();
+
+        // the loading of the new driver may take some seconds, in the
+        // meantime the bridge keeps the audio stream to the server alive
+        SndCrdBridge.Start ( GetSndCrdActualMonoBlSize() );
     }
 
     const QString strReturn = Sound.SetDev ( iNewDev );
 
-    // init again because the sound card actual buffer size might
-    // be changed on new device
-    Init();
+    SndCrdBridge.Stop();
+
+    // init again because the sound card actual buffer size might be changed
+    // on new device (the network settings are kept if the new buffer size
+    // allows it, see UpdateSndCrdBufferSize())
+    if ( !UpdateSndCrdBufferSize() )
+    {
+        Init();
+    }
 
     if ( bWasRunning )
     {
         // restart client
+        bFadeInSndCrd = true;
         Sound.Start();
     }
 
@@ -638,21 +1672,32 @@ void CClient::OnSndCrdReinitRequest ( int iSndCrdResetType )
     // perform reinit request as indicated by the request type parameter
     if ( eSndCrdResetType != RS_ONLY_RESTART )
     {
-        if ( eSndCrdResetType != RS_ONLY_RESTART_AND_INIT )
+        if ( eSndCrdResetType == RS_RELOAD_RESTART_AND_INIT )
         {
-            // reinit the driver if requested
-            // (we use the currently selected driver)
+            // reinit the driver (we use the currently selected driver), the
+            // bridge keeps the audio stream alive in the meantime
+            if ( bWasRunning )
+            {
+                SndCrdBridge.Start ( GetSndCrdActualMonoBlSize() );
+            }
+
             Sound.SetDev ( Sound.GetDev() );
+
+            SndCrdBridge.Stop();
         }
 
-        // init client object (must always be performed if the driver
-        // was changed)
-        Init();
+        // keep the network settings if possible so that the audio stream is
+        // not interrupted, otherwise a complete init is required
+        if ( !UpdateSndCrdBufferSize() )
+        {
+            Init();
+        }
     }
 
     if ( bWasRunning )
     {
         // restart client
+        bFadeInSndCrd = true;
         Sound.Start();
     }
 }
@@ -666,6 +1711,21 @@ void CClient::OnHandledSignal ( int sigNum )
 #else
     switch ( sigNum )
     {
+    case SIGQUIT:
+        // like the thread dump of other runtimes, the quit signal writes the
+        // flight recorder
+        FlightRecorder.Dump ( "requested" );
+        break;
+
+    case SIGHUP:
+        // with a trace file the hangup signal starts/stops the tracing
+        if ( CTracer::IsInitialized() )
+        {
+            CTracer::Toggle();
+            break;
+        }
+        // fall through
+
     case SIGINT:
     case SIGTERM:
         // if connected, terminate connection (needed for headless mode)
@@ -684,22 +1744,140 @@ void CClient::OnHandledSignal ( int sigNum )
 #endif
 }
 
-void CClient::Start()
+void CClient::SetEnableAdaptiveAggregation ( const bool bNEnableAdaptiveAggregation )
 {
-    // init object
-    Init();
+    bEnableAdaptiveAggregation = bNEnableAdaptiveAggregation;
 
-    // enable channel
-    Channel.SetEnable ( true );
+    // go back to the number of frames of the buffer size setting
+    if ( !bEnableAdaptiveAggregation && Channel.IsConnected() &&
+         ( Channel.GetNetwFrameSizeFact() != iSndCrdFrameSizeFactor ) )
+    {
+        Channel.SetNetwFrameSizeFact ( iSndCrdFrameSizeFactor );
+    }
 
-    // start audio interface
-    Sound.Start();
+    NetwFrameSizeFactControl.Reset ( iSndCrdFrameSizeFactor,
+                                     FRAME_SIZE_FACTOR_SAFE * SYSTEM_FRAME_SIZE_SAMPLES / iOPUSFrameSizeSamples );
 }
 
-void CClient::Stop()
+void CClient::OnTimerNetwAggregation()
 {
-    // stop audio interface
+    // the memory of the jitter buffer is grown outside the audio thread
+    Channel.UpdateSockBufCapacity();
+
+    // the multitrack mode sends one frame per packet
+    if ( !bEnableAdaptiveAggregation || bEnableMultitrack || !Channel.IsConnected() )
+    {
+        return;
+    }
+
+    CChannelNetStats NetStats;
+    Channel.GetNetStats ( NetStats );
+
+    const int iNewFact = NetwFrameSizeFactControl.Update ( NetStats.iNumReceived,
+                                                           NetStats.iNumLost );
+
+    if ( iNewFact != Channel.GetNetwFrameSizeFact() )
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+        // TODO we should use the ConsoleWriterFactory() instead of qInfo()
+        qInfo() << qUtf8Printable ( QString ( "- network packets with %1 frames" ).arg ( iNewFact ) );
+#endif
+        Channel.SetNetwFrameSizeFact ( iNewFact );
+    }
+}
+
+void CClient::SetEnableAdaptiveQuality ( const bool bNEnableAdaptiveQuality )
+{
+    const bool bWasReduced = ( GetCurAudioQuality() != eAudioQuality );
+
+    bEnableAdaptiveQuality = bNEnableAdaptiveQuality;
+
+    // go back to the quality setting
+    if ( bWasReduced )
+    {
+        SetAudioQuality ( eAudioQuality );
+    }
+    else
+    {
+        AudioQualityControl.Reset ( eAudioQuality );
+    }
+}
+
+void CClient::OnTimerAudioQuality()
+{
+    if ( !bEnableAdaptiveQuality || !Channel.IsConnected() )
+    {
+        return;
+    }
+
+    // the answer of the server is evaluated in the next interval
+    Channel.CreateReqNetStatsMes();
+
+    CChannelNetStats NetStats;
+    Channel.GetNetStats ( NetStats );
+
+    const EAudioQuality eOldQuality = GetCurAudioQuality();
+    const EAudioQuality eNewQuality = AudioQualityControl.Update ( NetStats.iNumReceived,
+                                                                   NetStats.iNumLost,
+                                                                   Channel.GetNetwFrameSizeFact() );
+
+    if ( eNewQuality != eOldQuality )
+    {
+        // the new number of coded bytes is sent to the server with the
+        // network transport properties by the codec switch
+        SwitchCodec();
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+        // TODO we should use the ConsoleWriterFactory() instead of qInfo()
+        qInfo() << qUtf8Printable ( QString ( "- audio quality %1 of %2 (%3 bytes per frame)" )
+            .arg ( eNewQuality ).arg ( eAudioQuality ).arg ( iCeltNumCodedBytes ) );
+#endif
+    }
+}
+
+void CClient::OnNetStatsReceived ( int iNumReceived,
+                                   int iNumLost )
+{
+    // the server channel receives our packets with our frame size factor
+    AudioQualityControl.PutRemoteStats ( iNumReceived,
+                                         iNumLost,
+                                         Channel.GetNetwFrameSizeFact() );
+}
+
+void CClient::Start()
+{
+    // a new connection starts with the quality setting
+    AudioQualityControl.Reset ( eAudioQuality );
+
+    // the auto jitter buffer starts with the last good delay of this server
+    // (applied by the init of the audio stream properties)
+    Channel.SetSockBufStartDelayMs ( GetJitBufStartDelayMs() );
+
+    // init object
+    Init();
+
+    // enable channel (the session setup is sent after the first audio packet)
+    bSessionSetupSent = false;
+    Channel.SetEnable ( true );
+
+    // start the send thread before the audio interface
+    SendThread.Start();
+
+    // start audio interface
+    Sound.Start();
+
+    TimerNetwAggregation.start ( NETW_AGGR_EVAL_INTERVAL_MS );
+    TimerAudioQuality.start ( NETW_QUALITY_EVAL_INTERVAL_MS );
+}
+
+void CClient::Stop()
+{
+    // the current delay is the start value of the next connection
+    StoreJitBufDelay();
+
+    // stop audio interface
     Sound.Stop();
+    SendThread.Stop();
 
     // disable channel
     Channel.SetEnable ( false );
@@ -726,12 +1904,58 @@ void CClient::Stop()
     // disconnects the connection anyway).
     ConnLessProtocol.CreateCLDisconnection ( Channel.GetAddress() );
 
-    // reset current signal level and LEDs
-    bJitterBufferOK = true;
+    // the multicast group of the server is not needed anymore
+    Socket.LeaveMulticastGroup();
+
+    // the pending mix changes belong to the old session
+    TimerRemoteMixUpdate.stop();
+    TimerNetwAggregation.stop();
+    TimerAudioQuality.stop();
+    vecdPendingRemoteGains.Reset ( -1.0 );
+    vecdPendingRemotePans.Reset ( -1.0 );
+
+    // reset current signal level and LEDs (the audio is stopped, i.e. we can
+    // publish the snapshot here)
     SignalLevelMeter.Reset();
+    PublishTelemetry();
+
+    // the DSP load of the session is logged for support requests
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+// TODO we should use the ConsoleWriterFactory() instead of qInfo()
+    qInfo() << qUtf8Printable ( DspLoad.GetReport() );
+#endif
 }
 
-void CClient::Init()
+int CClient::GetJitBufStartDelayMs() const
+{
+    const int iStoredDelayMs = StoredJitBufDelays.Get ( strServerAddr );
+
+    if ( iStoredDelayMs > 0 )
+    {
+        return iStoredDelayMs;
+    }
+
+    // the jitter of one direction is approx. half of the spread of the round
+    // trip times (the warmup of the jitter buffer corrects a too small value)
+    if ( iConnectPingJitterMs >= 0 )
+    {
+        return std::max ( 1, iConnectPingJitterMs / 2 );
+    }
+
+    return 0; // default start setting
+}
+
+void CClient::StoreJitBufDelay()
+{
+    // only the delay of an established connection with the auto jitter buffer
+    // is a good delay for the server
+    if ( IsRunning() && Channel.IsConnected() && GetDoAutoSockBufSize() )
+    {
+        StoredJitBufDelays.Store ( strServerAddr, Channel.GetSockBufDelayMs() );
+    }
+}
+
+void CClient::UpdateSndCrdFrameSizeSupport()
 {
     // check if possible frame size factors are supported
     const int iFraSizePreffered = SYSTEM_FRAME_SIZE_SAMPLES * FRAME_SIZE_FACTOR_PREFERRED;
@@ -741,6 +1965,59 @@ void CClient::Init()
     bFraSiFactPrefSupported = ( Sound.Init ( iFraSizePreffered ) == iFraSizePreffered );
     bFraSiFactDefSupported  = ( Sound.Init ( iFraSizeDefault )   == iFraSizeDefault );
     bFraSiFactSafeSupported = ( Sound.Init ( iFraSizeSafe )      == iFraSizeSafe );
+}
+
+bool CClient::UpdateSndCrdBufferSize()
+{
+    // The sound card buffer size was changed (e.g. the JACK period size or a
+    // new device). If the new size is an integer multiple of the current
+    // internal block size, it is processed in slices of the internal block
+    // size and the coders, the network settings and the jitter buffer are
+    // kept. Since the server is not involved, there is no gap in the stream.
+    if ( bSndCrdConversionBufferRequired || ( iMonoBlockSizeSam <= 0 ) )
+    {
+        return false;
+    }
+
+    UpdateSndCrdFrameSizeSupport();
+
+    const int iNewSndCrdMonoBlockSize =
+        Sound.Init ( iSndCrdPrefFrameSizeFactor * SYSTEM_FRAME_SIZE_SAMPLES );
+
+    if ( ( iNewSndCrdMonoBlockSize < iMonoBlockSizeSam ) ||
+         ( iNewSndCrdMonoBlockSize % iMonoBlockSizeSam != 0 ) )
+    {
+        return false;
+    }
+
+    iSndCrdNumSubBlocks = iNewSndCrdMonoBlockSize / iMonoBlockSizeSam;
+
+    vecfStereoSndCrdConv.Init ( 2 * iNewSndCrdMonoBlockSize );
+    EncoderCpuLoad.Init ( GetSndCrdActualMonoBlSize() );
+
+    return true;
+}
+
+void CClient::EndInitBatch()
+{
+    bInitBatch = false;
+
+    if ( bInitPending )
+    {
+        bInitPending = false;
+        Init();
+    }
+}
+
+void CClient::Init()
+{
+    if ( bInitBatch )
+    {
+        bInitPending = true;
+        return;
+    }
+
+    UpdateSndCrdFrameSizeSupport();
 
     // translate block size index in actual block size
     const int iPrefMonoFrameSize = iSndCrdPrefFrameSizeFactor * SYSTEM_FRAME_SIZE_SAMPLES;
@@ -760,6 +2037,7 @@ void CClient::Init()
 
         // no sound card conversion buffer required
         bSndCrdConversionBufferRequired = false;
+        iSndCrdNumSubBlocks             = 1;
     }
     else
     {
@@ -788,6 +2066,21 @@ void CClient::Init()
             iMonoBlockSizeSam     = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
             eAudioCompressionType = CT_OPUS;
         }
+
+        // if the sound card block size is an integer multiple of the internal
+        // block size, the sound card buffer is processed in place in slices of
+        // the internal block size and no conversion buffer (and no additional
+        // delay) is required
+        if ( ( iSndCardMonoBlockSizeSamConvBuff > iMonoBlockSizeSam ) &&
+             ( iSndCardMonoBlockSizeSamConvBuff % iMonoBlockSizeSam == 0 ) )
+        {
+            iSndCrdNumSubBlocks             = iSndCardMonoBlockSizeSamConvBuff / iMonoBlockSizeSam;
+            bSndCrdConversionBufferRequired = false;
+        }
+        else
+        {
+            iSndCrdNumSubBlocks = 1;
+        }
     }
     else
     {
@@ -804,7 +2097,41 @@ void CClient::Init()
         }
     }
 
-    // inits for audio coding
+    // calculate stereo (two channels) buffer size
+    iStereoBlockSizeSam = 2 * iMonoBlockSizeSam;
+
+    InitCodec ( false );
+
+    // init the sound card conversion buffer (the initial delay of one inner
+    // block is the latency which is introduced by the conversion buffer, it
+    // avoids buffer underruns)
+    if ( bSndCrdConversionBufferRequired )
+    {
+        SndCrdConversionBuffer.Init ( iStereoBlockSizeSam, 2 * iSndCardMonoBlockSizeSamConvBuff );
+    }
+
+    vecfStereoSndCrdConv.Init ( 2 * GetSndCrdActualMonoBlSize() );
+
+    // reset initialization phase flag and mute flag
+    bIsInitializationPhase = true;
+}
+
+void CClient::InitCodec ( const bool bLive )
+{
+    // The codecs, the buffers of the coded frames and the network properties
+    // for the current sound card block layout. On a live switch the audio
+    // thread does not use the codecs (see SwitchCodec()), the sound card
+    // conversion buffer and the output keep running.
+    OpusCustomEncoder* const PrevOpusEncoder    = CurOpusEncoder;
+    OpusCustomEncoder* const PrevOpusRedEncoder = CurOpusRedEncoder;
+    OpusCustomEncoder* const PrevOpusSubEncoder = CurOpusSubEncoder;
+    OpusCustomDecoder* const PrevOpusDecoder    = CurOpusDecoder;
+    const EAudChanConf       ePrevAudioChanConf = eReverbAudioChannelConf;
+
+    // inits for audio coding (on a congested link the audio quality can be
+    // below the quality setting)
+    const EAudioQuality eCurAudioQuality = GetCurAudioQuality();
+
     if ( eAudioCompressionType == CT_OPUS )
     {
         iOPUSFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
@@ -812,10 +2139,12 @@ void CClient::Init()
         if ( eAudioChannelConf == CC_MONO )
         {
             CurOpusEncoder    = OpusEncoderMono;
+            CurOpusRedEncoder = OpusRedEncoderMono;
+            CurOpusSubEncoder = OpusSubEncoderMono;
             CurOpusDecoder    = OpusDecoderMono;
             iNumAudioChannels = 1;
 
-            switch ( eAudioQuality )
+            switch ( eCurAudioQuality )
             {
             case AQ_LOW:    iCeltNumCodedBytes = OPUS_NUM_BYTES_MONO_LOW_QUALITY_DBLE_FRAMESIZE;    break;
             case AQ_NORMAL: iCeltNumCodedBytes = OPUS_NUM_BYTES_MONO_NORMAL_QUALITY_DBLE_FRAMESIZE; break;
@@ -825,10 +2154,12 @@ void CClient::Init()
         else
         {
             CurOpusEncoder    = OpusEncoderStereo;
+            CurOpusRedEncoder = OpusRedEncoderStereo;
+            CurOpusSubEncoder = OpusSubEncoderStereo;
             CurOpusDecoder    = OpusDecoderStereo;
             iNumAudioChannels = 2;
 
-            switch ( eAudioQuality )
+            switch ( eCurAudioQuality )
             {
             case AQ_LOW:    iCeltNumCodedBytes = OPUS_NUM_BYTES_STEREO_LOW_QUALITY_DBLE_FRAMESIZE;    break;
             case AQ_NORMAL: iCeltNumCodedBytes = OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY_DBLE_FRAMESIZE; break;
@@ -843,10 +2174,12 @@ void CClient::Init()
         if ( eAudioChannelConf == CC_MONO )
         {
             CurOpusEncoder    = Opus64EncoderMono;
+            CurOpusRedEncoder = Opus64RedEncoderMono;
+            CurOpusSubEncoder = Opus64SubEncoderMono;
             CurOpusDecoder    = Opus64DecoderMono;
             iNumAudioChannels = 1;
 
-            switch ( eAudioQuality )
+            switch ( eCurAudioQuality )
             {
             case AQ_LOW:    iCeltNumCodedBytes = OPUS_NUM_BYTES_MONO_LOW_QUALITY;    break;
             case AQ_NORMAL: iCeltNumCodedBytes = OPUS_NUM_BYTES_MONO_NORMAL_QUALITY; break;
@@ -856,10 +2189,12 @@ void CClient::Init()
         else
         {
             CurOpusEncoder    = Opus64EncoderStereo;
+            CurOpusRedEncoder = Opus64RedEncoderStereo;
+            CurOpusSubEncoder = Opus64SubEncoderStereo;
             CurOpusDecoder    = Opus64DecoderStereo;
             iNumAudioChannels = 2;
 
-            switch ( eAudioQuality )
+            switch ( eCurAudioQuality )
             {
             case AQ_LOW:    iCeltNumCodedBytes = OPUS_NUM_BYTES_STEREO_LOW_QUALITY;    break;
             case AQ_NORMAL: iCeltNumCodedBytes = OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY; break;
@@ -868,54 +2203,117 @@ void CClient::Init()
         }
     }
 
-    // calculate stereo (two channels) buffer size
-    iStereoBlockSizeSam = 2 * iMonoBlockSizeSam;
+    // a codec which was used before has an outdated state, it starts from
+    // silence like a new codec (the audio thread fades in after a live switch,
+    // a codec which stays in use keeps its state, only the bit rate changes)
+    if ( bLive )
+    {
+        if ( CurOpusEncoder != PrevOpusEncoder )
+        {
+            opus_custom_encoder_ctl ( CurOpusEncoder, OPUS_RESET_STATE );
+        }
 
-    vecCeltData.Init ( iCeltNumCodedBytes );
-    vecZeros.Init ( iStereoBlockSizeSam, 0 );
-    vecsStereoSndCrdMuteStream.Init ( iStereoBlockSizeSam );
+        if ( CurOpusRedEncoder != PrevOpusRedEncoder )
+        {
+            opus_custom_encoder_ctl ( CurOpusRedEncoder, OPUS_RESET_STATE );
+        }
+
+        if ( CurOpusSubEncoder != PrevOpusSubEncoder )
+        {
+            opus_custom_encoder_ctl ( CurOpusSubEncoder, OPUS_RESET_STATE );
+        }
+
+        if ( CurOpusDecoder != PrevOpusDecoder )
+        {
+            opus_custom_decoder_ctl ( CurOpusDecoder, OPUS_RESET_STATE );
+        }
+    }
+
+    // the multi-stream mode sends the right input as a sub-stream, this is
+    // not possible if both inputs belong to one stereo signal
+    iNumSubStreams = ( bEnableMultiStream && ( eAudioChannelConf != CC_STEREO ) ) ? 1 : 0;
+
+    // the frames of the sub-streams are appended to the frame of our stream
+    vecCeltData.Init ( ( iNumSubStreams + 1 ) * iCeltNumCodedBytes );
+    vecfSubStreamSndCrd.Init ( iStereoBlockSizeSam );
+    vecRedCeltData.Init ( iCeltNumCodedBytes );
+    SendThread.Init ( vecCeltData.Size(), vecRedCeltData.Size() );
+    vecfZeros.Init ( iStereoBlockSizeSam, 0 );
+    vecfStereoSndCrd.Init ( iStereoBlockSizeSam );
+    vecfStereoSndCrdMuteStream.Init ( iStereoBlockSizeSam );
+
+    // the playout buffer works on the decoded frames
+    Playout.Init ( iNumAudioChannels, iOPUSFrameSizeSamples, iMonoBlockSizeSam );
+    vecfDecodedFrame.Init ( iNumAudioChannels * iOPUSFrameSizeSamples );
 
     dMuteOutStreamGain = 1.0;
 
+    iEncoderBitRate = CalcBitRateBitsPerSecFromCodedBytes ( iCeltNumCodedBytes, iOPUSFrameSizeSamples );
+
     opus_custom_encoder_ctl ( CurOpusEncoder,
+                              OPUS_SET_BITRATE ( iEncoderBitRate ) );
+
+    opus_custom_encoder_ctl ( CurOpusSubEncoder,
+                              OPUS_SET_BITRATE ( iEncoderBitRate ) );
+
+    // the complexity and the expected packet loss of the current encoder are
+    // configured by the encoder profile in the audio callback
+    EncoderProfile.Reset();
+    SubEncoderProfile.Reset();
+    EncoderCpuLoad.Init ( GetSndCrdActualMonoBlSize() );
+    DspLoad.Reset();
+
+    opus_custom_encoder_ctl ( CurOpusRedEncoder,
                               OPUS_SET_BITRATE (
                                   CalcBitRateBitsPerSecFromCodedBytes (
-                                      iCeltNumCodedBytes, iOPUSFrameSizeSamples ) ) );
+                                      CChannel::CalcRedFrameSize ( iCeltNumCodedBytes ), iOPUSFrameSizeSamples ) ) );
 
-    // inits for network and channel
-    vecbyNetwData.Init ( iCeltNumCodedBytes );
+    // the auto jitter buffer continues with its current size after a live
+    // switch (the new frame size requires a new buffer, but not a new estimate)
+    if ( bLive && Channel.GetDoAutoSockBufSize() )
+    {
+        Channel.SetSockBufStartDelayMs ( Channel.GetSockBufDelayMs() );
+    }
 
-    // set the channel network properties
+    // inits for network and channel (a multitrack frame is larger than an
+    // audio packet)
+    vecbyNetwData.Init ( bEnableMultitrack ? MULTITRACK_MAX_FRAME_SIZE : iCeltNumCodedBytes );
+
+    // the decoders of the tracks are only created if the multitrack mode is
+    // used
+    if ( bEnableMultitrack )
+    {
+        Multitrack.Init ( OpusMode, Opus64Mode );
+    }
+    Multitrack.Reset();
+
+    // set the channel network properties (the redundancy mode and the
+    // sequence mode cannot be combined with the sub-streams, the multitrack
+    // mode cannot be combined with the redundancy mode and the sequence mode)
     Channel.SetAudioStreamProperties ( eAudioCompressionType,
                                        iCeltNumCodedBytes,
                                        iSndCrdFrameSizeFactor,
-                                       iNumAudioChannels );
-
-    // init reverberation
-    AudioReverb.Init ( eAudioChannelConf,
-                       iStereoBlockSizeSam,
-                       SYSTEM_SAMPLE_RATE_HZ );
-
-    // init the sound card conversion buffers
-    if ( bSndCrdConversionBufferRequired )
+                                       iNumAudioChannels,
+                                       bEnableRedundancy && ( iNumSubStreams == 0 ),
+                                       iNumSubStreams,
+                                       bEnableSeqNum && !bEnableRedundancy && !bEnableMultitrack && ( iNumSubStreams == 0 ),
+                                       bEnableMultitrack && !bEnableRedundancy );
+
+    // on a lossy link up to the duration of the safe buffer size is combined
+    // in one network packet
+    NetwFrameSizeFactControl.Reset ( iSndCrdFrameSizeFactor,
+                                     FRAME_SIZE_FACTOR_SAFE * SYSTEM_FRAME_SIZE_SAMPLES / iOPUSFrameSizeSamples );
+
+    // init reverberation (a live switch keeps the reverberation tail if the
+    // channel configuration is not changed)
+    if ( !bLive || ( eAudioChannelConf != ePrevAudioChanConf ) )
     {
-        // inits for conversion buffer (the size of the conversion buffer must
-        // be the sum of input/output sizes which is the worst case fill level)
-        const int iSndCardStereoBlockSizeSamConvBuff = 2 * iSndCardMonoBlockSizeSamConvBuff;
-        const int iConBufSize                        = iStereoBlockSizeSam + iSndCardStereoBlockSizeSamConvBuff;
-
-        SndCrdConversionBufferIn.Init  ( iConBufSize );
-        SndCrdConversionBufferOut.Init ( iConBufSize );
-        vecDataConvBuf.Init            ( iStereoBlockSizeSam );
+        AudioReverb.Init ( eAudioChannelConf,
+                           iStereoBlockSizeSam,
+                           SYSTEM_SAMPLE_RATE_HZ );
 
-        // the output conversion buffer must be filled with the inner
-        // block size for initialization (this is the latency which is
-        // introduced by the conversion buffer) to avoid buffer underruns
-        SndCrdConversionBufferOut.Put ( vecZeros, iStereoBlockSizeSam );
+        eReverbAudioChannelConf = eAudioChannelConf;
     }
-
-    // reset initialization phase flag and mute flag
-    bIsInitializationPhase = true;
 }
 
 void CClient::AudioCallback ( CVector<int16_t>& psData, void* arg )
@@ -923,48 +2321,177 @@ void CClient::AudioCallback ( CVector<int16_t>& psData, void* arg )
     // get the pointer to the object
     CClient* pMyClientObj = static_cast<CClient*> ( arg );
 
+    // all memory allocations and blocking locks in this scope are reported by
+    // the real-time safety checker (if enabled)
+    RT_SAFETY_SCOPE();
+
+    // the sound card thread is not ours, it is named on each call
+    CTracer::SetThreadName ( "sound" );
+    TRACE_SCOPE ( TP_SOUND_CALLBACK );
+    CFlightRecScope FlightRecScope ( pMyClientObj->FlightRecorder, FR_CALLBACK );
+
     // process audio data
     pMyClientObj->ProcessSndCrdAudioData ( psData );
+}
 
-/*
-// TEST do a soundcard jitter measurement
-static CTimingMeas JitterMeas ( 1000, "test2.dat" );
-JitterMeas.Measure();
-*/
+void CClient::AudioCallbackFloat ( CVector<float>& vecfData, void* arg )
+{
+    // get the pointer to the object
+    CClient* pMyClientObj = static_cast<CClient*> ( arg );
+
+    RT_SAFETY_SCOPE();
+
+    CTracer::SetThreadName ( "sound" );
+    TRACE_SCOPE ( TP_SOUND_CALLBACK );
+    CFlightRecScope FlightRecScope ( pMyClientObj->FlightRecorder, FR_CALLBACK );
+
+    // process audio data (the sound card buffer is used directly)
+    pMyClientObj->ProcessSndCrdAudioDataFloat ( &vecfData[0], vecfData.Size() );
 }
 
 void CClient::ProcessSndCrdAudioData ( CVector<int16_t>& vecsStereoSndCrd )
 {
+    // the int16 samples are converted once for the complete sound card block
+    // (the conversion back to int16 saturates the processed signal)
+    const int iNumSamples = std::min ( vecsStereoSndCrd.Size(), vecfStereoSndCrdConv.Size() );
+
+    CMixKernel::ShortToFloatNorm ( &vecsStereoSndCrd[0], &vecfStereoSndCrdConv[0], iNumSamples );
+
+    ProcessSndCrdAudioDataFloat ( &vecfStereoSndCrdConv[0], iNumSamples );
+
+    CMixKernel::FloatNormToShort ( &vecfStereoSndCrdConv[0], &vecsStereoSndCrd[0], iNumSamples );
+}
+
+void CClient::ProcessSndCrdAudioDataFloat ( float*    pfStereoSndCrd,
+                                            const int iNumSamples )
+{
+    // live codec switch: while the GUI thread switches the codecs, we do not
+    // touch them and output silence, the new codecs start with a fade-in
+    const int iCodecSwitch = iCodecSwitchState.loadAcquire();
+
+    if ( iCodecSwitch == CS_HOLD )
+    {
+        std::fill ( pfStereoSndCrd, pfStereoSndCrd + iNumSamples, 0.0f );
+        return;
+    }
+
+    if ( iCodecSwitch == CS_RESUME )
+    {
+        bFadeInSndCrd = true;
+        iCodecSwitchState.storeRelease ( CS_NONE );
+    }
+
+    // the processing time is measured for the encoder profile and the DSP
+    // load
+    AudioProcTimer.start();
+    DspLoad.StartCallback();
+
     // check if a conversion buffer is required or not
     if ( bSndCrdConversionBufferRequired )
     {
+        float* pfBlock;
+
         // add new sound card block in conversion buffer
-        SndCrdConversionBufferIn.Put ( vecsStereoSndCrd, vecsStereoSndCrd.Size() );
+        SndCrdConversionBuffer.Put ( pfStereoSndCrd, iNumSamples );
+
+        // process all available blocks of data in place
+        while ( ( pfBlock = SndCrdConversionBuffer.GetNextBlock() ) != nullptr )
+        {
+            ProcessAudioDataIntern ( pfBlock );
+        }
 
-        // process all available blocks of data
-        while ( SndCrdConversionBufferIn.GetAvailData() >= iStereoBlockSizeSam )
+        // get processed sound card block out of the conversion buffer
+        SndCrdConversionBuffer.Get ( pfStereoSndCrd, iNumSamples );
+    }
+    else
+    {
+        // regular case: no conversion buffer required, the sound card buffer
+        // is processed directly (in slices if it is an integer multiple of the
+        // internal block size)
+        for ( int i = 0; i < iSndCrdNumSubBlocks; i++ )
         {
-            // get one block of data for processing
-            SndCrdConversionBufferIn.Get ( vecDataConvBuf, iStereoBlockSizeSam );
+            ProcessAudioDataIntern ( &pfStereoSndCrd[i * iStereoBlockSizeSam] );
+        }
+    }
+
+    const qint64 iProcTimeNs = AudioProcTimer.nsecsElapsed();
+
+    UpdateEncoderProfile ( iNumSamples / 2, iProcTimeNs );
+    DspLoad.EndCallback ( iNumSamples / 2, iProcTimeNs );
+
+    // the last block with the old codecs is faded out, then the codecs are
+    // handed over to the GUI thread
+    if ( iCodecSwitch == CS_REQUESTED )
+    {
+        const int iNumFrames = iNumSamples / 2;
 
-            // process audio data
-            ProcessAudioDataIntern ( vecDataConvBuf );
+        for ( int i = 0; i < iNumFrames; i++ )
+        {
+            const float fGain = static_cast<float> ( iNumFrames - 1 - i ) / iNumFrames;
 
-            SndCrdConversionBufferOut.Put ( vecDataConvBuf, iStereoBlockSizeSam );
+            pfStereoSndCrd[2 * i]     *= fGain;
+            pfStereoSndCrd[2 * i + 1] *= fGain;
         }
 
-        // get processed sound card block out of the conversion buffer
-        SndCrdConversionBufferOut.Get ( vecsStereoSndCrd, vecsStereoSndCrd.Size() );
+        iCodecSwitchState.storeRelease ( CS_HOLD );
+    }
+}
+
+void CClient::UpdateEncoderProfile ( const int    iNumSamples,
+                                     const qint64 iProcTimeNs )
+{
+    EEncoderCpuLoad eCpuLoad = EL_NORMAL;
+
+    if ( bEnableAdaptiveEncoder )
+    {
+        // usage of the sound card block duration by our processing
+        EncoderCpuLoad.Update ( static_cast<double> ( iProcTimeNs ) * SYSTEM_SAMPLE_RATE_HZ /
+                                1000000000 / std::max ( 1, iNumSamples ) );
+
+        CChannelNetStats NetStats;
+        Channel.GetNetStats ( NetStats );
+        EncoderProfile.UpdateNetStats ( NetStats.iNumReceived, NetStats.iNumLost );
+        SubEncoderProfile.UpdateNetStats ( NetStats.iNumReceived, NetStats.iNumLost );
+
+        eCpuLoad = EncoderCpuLoad.GetLoad();
     }
     else
     {
-        // regular case: no conversion buffer required
-        // process audio data
-        ProcessAudioDataIntern ( vecsStereoSndCrd );
+        // the fixed settings of the compression type are used
+        EncoderProfile.ResetNetStats();
+        SubEncoderProfile.ResetNetStats();
+    }
+
+    // the encoder is only re-configured if the profile was changed
+    EncoderProfile.Apply ( CurOpusEncoder,
+                           eAudioCompressionType,
+                           iNumAudioChannels,
+                           iEncoderBitRate,
+                           eCpuLoad );
+
+    if ( iNumSubStreams > 0 )
+    {
+        SubEncoderProfile.Apply ( CurOpusSubEncoder,
+                                  eAudioCompressionType,
+                                  iNumAudioChannels,
+                                  iEncoderBitRate,
+                                  eCpuLoad );
     }
 }
 
-void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
+void CClient::ApplyFadeIn ( float* pfStereo ) const
+{
+    // linear ramp over one internal block
+    for ( int i = 0; i < iMonoBlockSizeSam; i++ )
+    {
+        const float fGain = static_cast<float> ( i + 1 ) / iMonoBlockSizeSam;
+
+        pfStereo[2 * i]     *= fGain;
+        pfStereo[2 * i + 1] *= fGain;
+    }
+}
+
+void CClient::ProcessAudioDataIntern ( float* pfStereoSndCrd )
 {
     int            i, j, iUnused;
     unsigned char* pCurCodedData;
@@ -972,49 +2499,85 @@ void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
 
     // Transmit signal ---------------------------------------------------------
     // update stereo signal level meter
-    SignalLevelMeter.Update ( vecsStereoSndCrd );
+    SignalLevelMeter.Update ( pfStereoSndCrd, iStereoBlockSizeSam );
+
+    DspLoad.EndStage ( DS_LEVELS, AudioProcTimer.nsecsElapsed() );
+
+    // the complete processing up to the OPUS encoder and from the OPUS decoder
+    // is done in our own float buffer, the sound card block is only copied
+    std::copy ( pfStereoSndCrd, pfStereoSndCrd + iStereoBlockSizeSam, vecfStereoSndCrd.begin() );
+
+    // after a restart of the sound card the stream continues from silence,
+    // therefore the first block is faded in (on the input and the output)
+    const bool bFadeIn = bFadeInSndCrd;
+    bFadeInSndCrd      = false;
+
+    if ( bFadeIn )
+    {
+        ApplyFadeIn ( &vecfStereoSndCrd[0] );
+    }
 
     // add reverberation effect if activated
     if ( iReverbLevel != 0 )
     {
-        AudioReverb.Process ( vecsStereoSndCrd,
+        AudioReverb.Process ( vecfStereoSndCrd,
                               bReverbOnLeftChan,
                               static_cast<double> ( iReverbLevel ) / AUD_REVERB_MAX / 4 );
     }
 
-    // apply pan (audio fader) and mix mono signals
-    if ( !( ( iAudioInFader == AUD_FADER_IN_MIDDLE ) && ( eAudioChannelConf == CC_STEREO ) ) )
+    DspLoad.EndStage ( DS_EFFECTS, AudioProcTimer.nsecsElapsed() );
+
+    // in the multi-stream mode the right input is sent as a sub-stream if the
+    // server has confirmed it
+    const int iNumSendSubStreams = Channel.GetNumSendSubStreams();
+
+    if ( iNumSendSubStreams > 0 )
+    {
+        // both streams carry one input without pan (the pan is done by the
+        // faders of the server), for mono-in/stereo-out the input is put on
+        // both stereo channels of the stream (note that the mono signal is
+        // written in place in front of the stereo input values)
+        for ( i = 0, j = 0; i < iMonoBlockSizeSam; i++, j += 2 )
+        {
+            const float fLeft  = vecfStereoSndCrd[j];
+            const float fRight = vecfStereoSndCrd[j + 1];
+
+            if ( iNumAudioChannels == 1 )
+            {
+                vecfStereoSndCrd[i]    = fLeft;
+                vecfSubStreamSndCrd[i] = fRight;
+            }
+            else
+            {
+                vecfStereoSndCrd[j + 1]    = fLeft;
+                vecfSubStreamSndCrd[j]     = fRight;
+                vecfSubStreamSndCrd[j + 1] = fRight;
+            }
+        }
+    }
+    else if ( !( ( iAudioInFader == AUD_FADER_IN_MIDDLE ) && ( eAudioChannelConf == CC_STEREO ) ) )
     {
+        // apply pan (audio fader) and mix mono signals
         // calculate pan gain in the range 0 to 1, where 0.5 is the middle position
         const double dPan = static_cast<double> ( iAudioInFader ) / AUD_FADER_IN_MAX;
 
         if ( eAudioChannelConf == CC_STEREO )
         {
             // for stereo only apply pan attenuation on one channel (same as pan in the server)
-            const double dGainL = MathUtils::GetLeftPan ( dPan, false );
-            const double dGainR = MathUtils::GetRightPan ( dPan, false );
-
-            for ( i = 0, j = 0; i < iMonoBlockSizeSam; i++, j += 2 )
-            {
-                // note that the gain is always <= 1, therefore a simple cast is
-                // ok since we never can get an overload
-                vecsStereoSndCrd[j + 1] = static_cast<int16_t> ( dGainR * vecsStereoSndCrd[j + 1] );
-                vecsStereoSndCrd[j]     = static_cast<int16_t> ( dGainL * vecsStereoSndCrd[j] );
-            }
+            CMixKernel::GainStereo ( &vecfStereoSndCrd[0],
+                                     static_cast<float> ( MathUtils::GetLeftPan ( dPan, false ) ),
+                                     static_cast<float> ( MathUtils::GetRightPan ( dPan, false ) ),
+                                     iMonoBlockSizeSam );
         }
         else
         {
             // for mono implement a cross-fade between channels and mix them, for
             // mono-in/stereo-out use no attenuation in pan center
-            const double dGainL = MathUtils::GetLeftPan ( dPan, eAudioChannelConf != CC_MONO_IN_STEREO_OUT );
-            const double dGainR = MathUtils::GetRightPan ( dPan, eAudioChannelConf != CC_MONO_IN_STEREO_OUT );
-
-            for ( i = 0, j = 0; i < iMonoBlockSizeSam; i++, j += 2 )
-            {
-                // note that we need the Double2Short for stereo pan mode
-                vecsStereoSndCrd[i] = Double2Short (
-                    dGainL * vecsStereoSndCrd[j] + dGainR * vecsStereoSndCrd[j + 1] );
-            }
+            CMixKernel::MixDownStereo ( &vecfStereoSndCrd[0],
+                                        &vecfStereoSndCrd[0],
+                                        static_cast<float> ( MathUtils::GetLeftPan ( dPan, eAudioChannelConf != CC_MONO_IN_STEREO_OUT ) ),
+                                        static_cast<float> ( MathUtils::GetRightPan ( dPan, eAudioChannelConf != CC_MONO_IN_STEREO_OUT ) ),
+                                        iMonoBlockSizeSam );
         }
     }
 
@@ -1022,62 +2585,221 @@ void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
     // full stereo mode at the transmission level. The only thing which is done
     // is to mix both sound card inputs together and then put this signal on
     // both stereo channels to be transmitted to the server.
-    if ( eAudioChannelConf == CC_MONO_IN_STEREO_OUT )
+    if ( ( eAudioChannelConf == CC_MONO_IN_STEREO_OUT ) && ( iNumSendSubStreams == 0 ) )
     {
         // copy mono data in stereo sound card buffer (note that since the input
         // and output is the same buffer, we have to start from the end not to
         // overwrite input values)
         for ( i = iMonoBlockSizeSam - 1, j = iStereoBlockSizeSam - 2; i >= 0; i--, j -= 2 )
         {
-            vecsStereoSndCrd[j] = vecsStereoSndCrd[j + 1] = vecsStereoSndCrd[i];
+            vecfStereoSndCrd[j] = vecfStereoSndCrd[j + 1] = vecfStereoSndCrd[i];
         }
     }
 
-    for ( i = 0; i < iSndCrdFrameSizeFactor; i++ )
+    DspLoad.EndStage ( DS_PAN, AudioProcTimer.nsecsElapsed() );
+
+    // the redundant copy is only encoded if the server has confirmed it
+    const int iRedNumCodedBytes = Channel.GetRedFrameSize();
+
+    // a listener only sends one (silent) packet per keep-alive interval which
+    // keeps the channel of the server from timing out
+    int iNumSendFrames = iSndCrdFrameSizeFactor;
+
+    if ( bListenerMode )
     {
+        iListenerKeepAliveCnt += iMonoBlockSizeSam;
+
+        if ( iListenerKeepAliveCnt >= SYSTEM_SAMPLE_RATE_HZ * CLIENT_LISTENER_KEEP_ALIVE_MS / 1000 )
+        {
+            iListenerKeepAliveCnt = 0;
+            iNumSendFrames        = 1;
+        }
+        else
+        {
+            iNumSendFrames = 0;
+        }
+    }
+
+    for ( i = 0; i < iNumSendFrames; i++ )
+    {
+        const float* pfEncoderIn = ( bMuteOutStream || bListenerMode ) ?
+            &vecfZeros[i * iNumAudioChannels * iOPUSFrameSizeSamples] :
+            &vecfStereoSndCrd[i * iNumAudioChannels * iOPUSFrameSizeSamples];
+
         // OPUS encoding
         if ( CurOpusEncoder != nullptr )
         {
-            if ( bMuteOutStream )
+            iUnused = opus_custom_encode_float ( CurOpusEncoder,
+                                                 pfEncoderIn,
+                                                 iOPUSFrameSizeSamples,
+                                                 &vecCeltData[0],
+                                                 iCeltNumCodedBytes );
+        }
+
+        if ( ( iRedNumCodedBytes > 0 ) && ( CurOpusRedEncoder != nullptr ) )
+        {
+            iUnused = opus_custom_encode_float ( CurOpusRedEncoder,
+                                                 pfEncoderIn,
+                                                 iOPUSFrameSizeSamples,
+                                                 &vecRedCeltData[0],
+                                                 iRedNumCodedBytes );
+        }
+
+        // the frame of the sub-stream follows the frame of our stream
+        if ( ( iNumSendSubStreams > 0 ) && ( CurOpusSubEncoder != nullptr ) )
+        {
+            const float* pfSubEncoderIn = ( bMuteOutStream || bListenerMode ) ?
+                &vecfZeros[i * iNumAudioChannels * iOPUSFrameSizeSamples] :
+                &vecfSubStreamSndCrd[i * iNumAudioChannels * iOPUSFrameSizeSamples];
+
+            iUnused = opus_custom_encode_float ( CurOpusSubEncoder,
+                                                 pfSubEncoderIn,
+                                                 iOPUSFrameSizeSamples,
+                                                 &vecCeltData[iCeltNumCodedBytes],
+                                                 iCeltNumCodedBytes );
+        }
+
+        // send coded audio through the network (by the send thread, if the
+        // queue is full the frame is lost)
+        SendThread.PutFrame ( vecCeltData,
+                              ( iNumSendSubStreams + 1 ) * iCeltNumCodedBytes,
+                              vecRedCeltData,
+                              iRedNumCodedBytes );
+    }
+
+    DspLoad.EndStage ( DS_ENCODE, AudioProcTimer.nsecsElapsed() );
+
+
+    // Receive signal ----------------------------------------------------------
+    // in case of mute stream or direct monitoring, store local data
+    const bool bAddLocalSignal = bMuteOutStream || bEnableDirectMonitor;
+
+    if ( bAddLocalSignal )
+    {
+        vecfStereoSndCrdMuteStream = vecfStereoSndCrd;
+
+        // both inputs belong to our local signal
+        if ( iNumSendSubStreams > 0 )
+        {
+            CMixKernel::MixAdd ( &vecfStereoSndCrdMuteStream[0],
+                                 &vecfSubStreamSndCrd[0],
+                                 1.0f,
+                                 iStereoBlockSizeSam );
+        }
+    }
+
+    if ( bEnableTimeStretch )
+    {
+        // the playout buffer decides how many frames are taken from the
+        // jitter buffer (it conceals underruns by time-scale modification)
+        ReceiveAndDecodeTimeStretch();
+    }
+    else
+    {
+        for ( i = 0; i < iSndCrdFrameSizeFactor; i++ )
+        {
+            int iNumCodedBytes;
+
+            // receive a new block
+            const bool bReceiveDataOk =
+                ( Channel.GetData ( vecbyNetwData, iCeltNumCodedBytes, iNumCodedBytes ) == GS_BUFFER_OK );
+
+            // get pointer to coded data and manage the flags
+            if ( bReceiveDataOk )
             {
-                iUnused = opus_custom_encode ( CurOpusEncoder,
-                                               &vecZeros[i * iNumAudioChannels * iOPUSFrameSizeSamples],
-                                               iOPUSFrameSizeSamples,
-                                               &vecCeltData[0],
-                                               iCeltNumCodedBytes );
+                pCurCodedData = &vecbyNetwData[0];
+
+                // on any valid received packet, we clear the initialization phase flag
+                bIsInitializationPhase = false;
             }
             else
             {
-                iUnused = opus_custom_encode ( CurOpusEncoder,
-                                               &vecsStereoSndCrd[i * iNumAudioChannels * iOPUSFrameSizeSamples],
-                                               iOPUSFrameSizeSamples,
-                                               &vecCeltData[0],
-                                               iCeltNumCodedBytes );
+                // for lost packets use null pointer as coded input data
+                pCurCodedData = nullptr;
+
+                // count the error for the buffer status LED
+                iNumJitBufGetErrors++;
             }
+
+            // OPUS decoding
+            DecodeReceivedFrame ( pCurCodedData,
+                                  iNumCodedBytes,
+                                  &vecfStereoSndCrd[i * iNumAudioChannels * iOPUSFrameSizeSamples] );
         }
+    }
+
+    DspLoad.EndStage ( DS_DECODE, AudioProcTimer.nsecsElapsed() );
 
-        // send coded audio through the network
-        Channel.PrepAndSendPacket ( &Socket,
-                                    vecCeltData,
-                                    iCeltNumCodedBytes );
+    // for muted stream we have to add our local data here, the same is done
+    // for the direct monitoring in which case the server mix does not contain
+    // our signal (our own gain is zero at the server), i.e. we hear ourself
+    // without the network round trip delay
+    if ( bAddLocalSignal )
+    {
+        CMixKernel::MixAdd ( &vecfStereoSndCrd[0],
+                             &vecfStereoSndCrdMuteStream[0],
+                             static_cast<float> ( dMuteOutStreamGain ),
+                             iStereoBlockSizeSam );
     }
 
+    // check if channel is connected and if we do not have the initialization phase
+    if ( Channel.IsConnected() && ( !bIsInitializationPhase ) )
+    {
+        if ( eAudioChannelConf == CC_MONO )
+        {
+            // copy mono data in stereo sound card buffer (note that since the input
+            // and output is the same buffer, we have to start from the end not to
+            // overwrite input values)
+            for ( i = iMonoBlockSizeSam - 1, j = iStereoBlockSizeSam - 2; i >= 0; i--, j -= 2 )
+            {
+                vecfStereoSndCrd[j] = vecfStereoSndCrd[j + 1] = vecfStereoSndCrd[i];
+            }
+        }
+
+        // copy back to the sound card block
+        std::copy ( vecfStereoSndCrd.begin(), vecfStereoSndCrd.begin() + iStereoBlockSizeSam, pfStereoSndCrd );
 
-    // Receive signal ----------------------------------------------------------
-    // in case of mute stream, store local data
-    if ( bMuteOutStream )
+        if ( bFadeIn )
+        {
+            ApplyFadeIn ( pfStereoSndCrd );
+        }
+    }
+    else
     {
-        vecsStereoSndCrdMuteStream = vecsStereoSndCrd;
+        // if not connected, clear data
+        std::fill ( pfStereoSndCrd, pfStereoSndCrd + iStereoBlockSizeSam, 0.0f );
     }
 
-    for ( i = 0; i < iSndCrdFrameSizeFactor; i++ )
+    DspLoad.EndStage ( DS_MIX, AudioProcTimer.nsecsElapsed() );
+
+    PublishTelemetry();
+
+    Q_UNUSED ( iUnused )
+}
+
+void CClient::PublishTelemetry()
+{
+    SClientTelemetry CurTelemetry;
+
+    CurTelemetry.dMicLeveldBLeft     = SignalLevelMeter.MicLeveldBLeft();
+    CurTelemetry.dMicLeveldBRight    = SignalLevelMeter.MicLeveldBRight();
+    CurTelemetry.iNumJitBufGetErrors = iNumJitBufGetErrors;
+
+    Telemetry.Publish ( CurTelemetry );
+}
+
+void CClient::ReceiveAndDecodeTimeStretch()
+{
+    // the buffer level includes the frames which are waiting in the jitter buffer
+    const int iNumRequired = Playout.GetNumRequired (
+        Channel.GetNumBufferedFrames() * iOPUSFrameSizeSamples + Playout.GetNumPending() );
+
+    while ( Playout.GetNumPending() < iNumRequired )
     {
-        // receive a new block
-        const bool bReceiveDataOk =
-            ( Channel.GetData ( vecbyNetwData, iCeltNumCodedBytes ) == GS_BUFFER_OK );
+        unsigned char* pCurCodedData = nullptr;
+        int            iNumCodedBytes;
 
-        // get pointer to coded data and manage the flags
-        if ( bReceiveDataOk )
+        if ( Channel.GetData ( vecbyNetwData, iCeltNumCodedBytes, iNumCodedBytes ) == GS_BUFFER_OK )
         {
             pCurCodedData = &vecbyNetwData[0];
 
@@ -1086,57 +2808,76 @@ void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
         }
         else
         {
-            // for lost packets use null pointer as coded input data
-            pCurCodedData = nullptr;
+            // count the error for the buffer status LED
+            iNumJitBufGetErrors++;
 
-            // invalidate the buffer OK status flag
-            bJitterBufferOK = false;
+            // first try to conceal the underrun by repeating a period of the
+            // decoded signal, the late packet can then still be played
+            if ( Playout.Expand() )
+            {
+                continue;
+            }
         }
 
-        // OPUS decoding
-        if ( CurOpusDecoder != nullptr )
-        {
-            iUnused = opus_custom_decode ( CurOpusDecoder,
-                                           pCurCodedData,
-                                           iCeltNumCodedBytes,
-                                           &vecsStereoSndCrd[i * iNumAudioChannels * iOPUSFrameSizeSamples],
-                                           iOPUSFrameSizeSamples );
-        }
+        // OPUS decoding (for lost packets the null pointer invokes the OPUS
+        // packet loss concealment)
+        DecodeReceivedFrame ( pCurCodedData, iNumCodedBytes, &vecfDecodedFrame[0] );
+
+        Playout.PutFrame ( &vecfDecodedFrame[0], pCurCodedData == nullptr );
     }
 
-    // for muted stream we have to add our local data here
-    if ( bMuteOutStream )
+    Playout.Get ( &vecfStereoSndCrd[0] );
+}
+
+void CClient::DecodeReceivedFrame ( const uint8_t* pCodedData,
+                                    const int      iNumCodedBytes,
+                                    float*         pfOut )
+{
+    int iUnused;
+
+    // in the multitrack mode the server sends multitrack frames (their size
+    // differs from the size of an audio packet) and plain audio packets if it
+    // cannot forward the frames of the other clients
+    if ( Channel.IsMultitrackMode() )
     {
-        for ( i = 0; i < iStereoBlockSizeSam; i++ )
+        if ( pCodedData == nullptr )
         {
-            vecsStereoSndCrd[i] = Double2Short (
-                vecsStereoSndCrd[i] + vecsStereoSndCrdMuteStream[i] * dMuteOutStreamGain );
+            if ( Multitrack.Conceal ( CurOpusDecoder, pfOut, iNumAudioChannels, iOPUSFrameSizeSamples ) )
+            {
+                return;
+            }
         }
-    }
-
-    // check if channel is connected and if we do not have the initialization phase
-    if ( Channel.IsConnected() && ( !bIsInitializationPhase ) )
-    {
-        if ( eAudioChannelConf == CC_MONO )
+        else if ( iNumCodedBytes != iCeltNumCodedBytes )
         {
-            // copy mono data in stereo sound card buffer (note that since the input
-            // and output is the same buffer, we have to start from the end not to
-            // overwrite input values)
-            for ( i = iMonoBlockSizeSam - 1, j = iStereoBlockSizeSam - 2; i >= 0; i--, j -= 2 )
+            if ( Multitrack.Process ( pCodedData, iNumCodedBytes, CurOpusDecoder,
+                                      pfOut, iNumAudioChannels, iOPUSFrameSizeSamples ) ||
+                 Multitrack.Conceal ( CurOpusDecoder, pfOut, iNumAudioChannels, iOPUSFrameSizeSamples ) )
             {
-                vecsStereoSndCrd[j] = vecsStereoSndCrd[j + 1] = vecsStereoSndCrd[i];
+                return;
             }
+
+            // an invalid frame is concealed by the OPUS packet loss concealment
+            pCodedData = nullptr;
         }
+        else
+        {
+            Multitrack.PutPlainFrame();
+        }
+    }
+
+    if ( CurOpusDecoder != nullptr )
+    {
+        iUnused = opus_custom_decode_float ( CurOpusDecoder,
+                                             pCodedData,
+                                             ( pCodedData != nullptr ) ? iNumCodedBytes : 0,
+                                             pfOut,
+                                             iOPUSFrameSizeSamples );
     }
     else
     {
-        // if not connected, clear data
-        vecsStereoSndCrd.Reset ( 0 );
+        std::fill ( pfOut, pfOut + iNumAudioChannels * iOPUSFrameSizeSamples, 0.0f );
     }
 
-    // update socket buffer size
-    Channel.UpdateSocketBufferSize();
-
     Q_UNUSED ( iUnused )
 }
 
@@ -1159,6 +2900,10 @@ int CClient::EstimatedOverallDelay ( const int iPingTimeMs )
     double dTotalSoundCardDelayMs = GetSndCrdConvBufAdditionalDelayMonoBlSize() *
         1000 / SYSTEM_SAMPLE_RATE_HZ;
 
+    // delay of the sample rate conversion if the sound card does not run at
+    // the system sample rate
+    dTotalSoundCardDelayMs += Sound.GetSampleRateConvDelayMs();
+
     // try to get the actual input/output sound card delay from the audio
     // interface, per definition it is not available if a 0 is returned
     const double dSoundCardInputOutputLatencyMs = Sound.GetInOutLatencyMs();
@@ -28,6 +28,9 @@
 #include <QHostInfo>
 #include <QString>
 #include <QDateTime>
+#include <QTimer>
+#include <QThread>
+#include <QSemaphore>
 #ifdef USE_OPUS_SHARED_LIB
 # include "opus/opus_custom.h"
 #else
@@ -38,6 +41,10 @@
 #include "channel.h"
 #include "util.h"
 #include "buffer.h"
+#include "mixkernel.h"
+#include "playout.h"
+#include "telemetry.h"
+#include "encoderprofile.h"
 #include "signalhandler.h"
 #ifdef LLCON_VST_PLUGIN
 # include "vstsound.h"
@@ -97,8 +104,287 @@
 #define OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY_DBLE_FRAMESIZE 71
 #define OPUS_NUM_BYTES_STEREO_HIGH_QUALITY_DBLE_FRAMESIZE   142
 
+// interval of the silent keep-alive packets in the listener mode (must be much
+// shorter than the channel time-out of the server)
+#define CLIENT_LISTENER_KEEP_ALIVE_MS                       1000
+
+// minimum interval of the gain and pan messages of a moving fader (the server
+// smoothes the gain changes)
+#define CLIENT_REMOTE_MIX_UPDATE_INTERVAL_MS                50
+
+// interval in which the DSP load is evaluated
+#define CLIENT_DSP_LOAD_INTERVAL_MS                         500
+
+// adaptive number of frames per network packet: the loss rate of the received
+// frames is evaluated in the given interval, on a lossy link the number of
+// frames is doubled (up to the duration of the safe buffer size), after a
+// number of clean intervals it is halved again (a change is not evaluated in
+// the interval in which it takes effect)
+#define NETW_AGGR_EVAL_INTERVAL_MS                          2000
+#define NETW_AGGR_LOSS_RATE_HIGH                            0.02
+#define NETW_AGGR_LOSS_RATE_LOW                             0.002
+#define NETW_AGGR_NUM_CLEAN_INTERVALS                       15
+#define NETW_AGGR_MIN_NUM_FRAMES                            100
+
+// adaptive audio quality (congestion control of the bit rate): the loss rates
+// of both directions and the rise of the round trip time above its minimum
+// (queueing in a congested link) are evaluated in the given interval, on a
+// congested link the audio quality is reduced by one step (down to the low
+// quality), after a number of clean intervals it is raised again by one step
+// (up to the quality setting)
+#define NETW_QUALITY_EVAL_INTERVAL_MS                       2000
+#define NETW_QUALITY_LOSS_RATE_HIGH                         0.05
+#define NETW_QUALITY_LOSS_RATE_LOW                          0.005
+#define NETW_QUALITY_QUEUE_DELAY_HIGH_MS                    40
+#define NETW_QUALITY_QUEUE_DELAY_LOW_MS                     10
+#define NETW_QUALITY_NUM_CLEAN_INTERVALS                    30
+#define NETW_QUALITY_MIN_NUM_FRAMES                         100
+
+// number of coded frames the send queue of the sound card callback can hold
+#define CLIENT_SEND_QUEUE_NUM_FRAMES                        16
+
+// maximum time the audio thread may take to hand over the codecs for a live
+// codec switch (otherwise the sound card is stopped for the switch)
+#define CLIENT_CODEC_SWITCH_TIMEOUT_MS                      200
+
 
 /* Classes ********************************************************************/
+// delays of the stages of the audio path in ms as the result of a latency
+// probe: the network and the server stages are measured, the sound card
+// stages are only measured if the audio interface reports its latency
+class CLatencyBreakdown
+{
+public:
+    CLatencyBreakdown() :
+        dCaptureMs         ( 0 ),
+        dClientBufferMs    ( 0 ),
+        dNetworkUpMs       ( 0 ),
+        dServerQueueMs     ( 0 ),
+        dMixMs             ( 0 ),
+        dNetworkDownMs     ( 0 ),
+        dPlayoutMs         ( 0 ),
+        bSoundCardMeasured ( false ) {}
+
+    double GetOverallMs() const
+    {
+        return dCaptureMs + dClientBufferMs + dNetworkUpMs + dServerQueueMs +
+               dMixMs + dNetworkDownMs + dPlayoutMs;
+    }
+
+    double dCaptureMs;         // sound card input
+    double dClientBufferMs;    // conversion buffer, packetization and coding
+    double dNetworkUpMs;       // half of the round trip time of the probe
+    double dServerQueueMs;     // server jitter buffer and frame period
+    double dMixMs;             // server frame processing
+    double dNetworkDownMs;     // half of the round trip time of the probe
+    double dPlayoutMs;         // client jitter buffer and sound card output
+    bool   bSoundCardMeasured; // false: the sound card stages are estimated
+};
+
+// DSP load of the client: the processing time of the sound card callback
+// relative to the duration of the sound card block (100 % means that the
+// computer does not keep up) and the shares of the processing stages. The
+// audio thread measures and publishes the values of each evaluation interval,
+// the GUI reads them.
+enum EClientDspStage
+{
+    DS_LEVELS,  // input level meter
+    DS_EFFECTS, // fade-in and reverb
+    DS_PAN,     // pan and audio channel configuration
+    DS_ENCODE,  // encode and send
+    DS_DECODE,  // receive and decode
+    DS_MIX,     // local signal and output
+    NUM_CLIENT_DSP_STAGES
+};
+
+class CClientDspLoad
+{
+public:
+    CClientDspLoad() { Reset(); }
+
+    // must not be called while the audio callback runs
+    void Reset();
+
+    // audio thread: the times are relative to the start of the callback
+    void StartCallback() { iLastMarkNs = 0; }
+
+    // marks the end of the given stage (the stage starts at the previous mark)
+    void EndStage ( const EClientDspStage eStage,
+                    const qint64          iCurTimeNs )
+    {
+        iStageNs[eStage] += iCurTimeNs - iLastMarkNs;
+        iLastMarkNs       = iCurTimeNs;
+    }
+
+    void EndCallback ( const int    iNumSamples,
+                       const qint64 iProcTimeNs );
+
+    // load of the last evaluation interval, the peak is the load of the
+    // longest callback of the interval, the maximum peak is the peak since the
+    // reset (all in percent)
+    double GetLoad() const { return iLoadPerMil.loadAcquire() / 10.0; }
+    double GetPeak() const { return iPeakPerMil.loadAcquire() / 10.0; }
+    double GetMaxPeak() const { return iMaxPeakPerMil.loadAcquire() / 10.0; }
+    double GetStageLoad ( const EClientDspStage eStage ) const
+        { return iStageLoadPerMil[eStage].loadAcquire() / 10.0; }
+
+    static QString GetStageName ( const EClientDspStage eStage );
+
+    // one line summary for the log
+    QString GetReport() const;
+
+protected:
+    qint64     iLastMarkNs;
+    qint64     iStageNs[NUM_CLIENT_DSP_STAGES];
+    qint64     iIntervalProcNs;
+    qint64     iIntervalPeriodNs;
+    int        iIntervalPeakPerMil;
+
+    QAtomicInt iLoadPerMil;
+    QAtomicInt iPeakPerMil;
+    QAtomicInt iMaxPeakPerMil;
+    QAtomicInt iStageLoadPerMil[NUM_CLIENT_DSP_STAGES];
+};
+
+// Selects the number of frames per network packet of a link: on a link with
+// packet loss (e.g. Wi-Fi or cellular networks lose packets at high packet
+// rates) more frames are combined in one packet, on a clean link the number
+// of frames of the buffer size setting is used again.
+class CNetwFrameSizeFactControl
+{
+public:
+    CNetwFrameSizeFactControl() { Reset ( FRAME_SIZE_FACTOR_PREFERRED, FRAME_SIZE_FACTOR_PREFERRED ); }
+
+    // the base factor is the one of the buffer size setting
+    void Reset ( const int iNBaseFact,
+                 const int iNMaxFact );
+
+    // the counters are the totals of the channel, must be called once per
+    // evaluation interval, returns the new factor
+    int Update ( const int iNumReceived,
+                 const int iNumLost );
+
+    int GetFact() const { return iCurFact; }
+
+protected:
+    int  iBaseFact;
+    int  iMaxFact;
+    int  iCurFact;
+    bool bCountersValid;
+    int  iLastNumReceived;
+    int  iLastNumLost;
+    int  iNumCleanIntervals;
+};
+
+// Loss rate of the audio frames of one direction of a link from the totals of
+// the packet counters.
+class CNetwLossRateMeter
+{
+public:
+    CNetwLossRateMeter() { Reset(); }
+
+    void Reset() { bCountersValid = false; iLastNumReceived = 0; iLastNumLost = 0; }
+
+    // the received counter counts packets with the given number of frames, the
+    // lost counter counts frames, returns false if the interval cannot be
+    // evaluated (too few frames or the counters were reset)
+    bool Update ( const int iNumReceived,
+                  const int iNumLost,
+                  const int iNumFramesPerPacket,
+                  double&   dLossRate );
+
+protected:
+    bool bCountersValid;
+    int  iLastNumReceived;
+    int  iLastNumLost;
+};
+
+// Selects the audio quality (i.e. the number of coded bytes per frame) of a
+// link: if the link is congested (audio packets are lost in one of the
+// directions or the round trip time rises) the quality is reduced below the
+// quality setting, on a clean link it is raised again. The loss of our own
+// audio packets is reported by the server.
+class CAudioQualityControl
+{
+public:
+    CAudioQualityControl() { Reset ( AQ_NORMAL ); }
+
+    // the maximum quality is the one of the quality setting
+    void Reset ( const EAudioQuality eNMaxQuality );
+
+    // the totals of the counters of the server channel
+    void PutRemoteStats ( const int iNumReceived,
+                          const int iNumLost,
+                          const int iNumFramesPerPacket );
+
+    void PutRtt ( const int iRttMs );
+
+    // the totals of the counters of our channel, must be called once per
+    // evaluation interval, returns the new quality
+    EAudioQuality Update ( const int iNumReceived,
+                           const int iNumLost,
+                           const int iNumFramesPerPacket );
+
+    EAudioQuality GetQuality() const { return eCurQuality; }
+
+protected:
+    EAudioQuality      eMaxQuality;
+    EAudioQuality      eCurQuality;
+    CNetwLossRateMeter LocalLossMeter;
+    CNetwLossRateMeter RemoteLossMeter;
+    double             dRemoteLossRate;
+    bool               bRemoteLossValid;
+    int                iMinRttMs;
+    int                iIntervalMinRttMs;
+    int                iNumCleanIntervals;
+};
+
+// Sends the coded audio frames of the sound card callback: the callback puts
+// the frames in a wait-free queue and wakes the send thread, i.e. the locks of
+// the channel and of the socket and the send system call are not in the
+// real-time audio thread.
+class CClientSendThread : public QThread
+{
+public:
+    CClientSendThread ( CChannel*        pNChannel,
+                        CHighPrioSocket* pNSocket );
+
+    virtual ~CClientSendThread() { Stop(); }
+
+    // must not be called while the thread is running
+    void Init ( const int iNMaxPacketLen,
+                const int iNMaxRedPacketLen );
+
+    void Start();
+    void Stop();
+
+    // called by the audio thread, returns false if the queue is full (the
+    // frame is dropped)
+    bool PutFrame ( const CVector<uint8_t>& vecbyNPacket,
+                    const int               iNPacketLen,
+                    const CVector<uint8_t>& vecbyRedPacket,
+                    const int               iRedPacketLen );
+
+protected:
+    virtual void run();
+
+    CChannel*        pChannel;
+    CHighPrioSocket* pSocket;
+
+    // a queue block holds the lengths (two bytes each, little endian), the
+    // packet and the redundant packet
+    CNetBufSPSC      Queue;
+    int              iMaxPacketLen;
+    int              iMaxRedPacketLen;
+    CVector<uint8_t> vecbyPutBlock; // audio thread
+    CVector<uint8_t> vecbyGetBlock; // send thread
+    CVector<uint8_t> vecbyPacket;
+    CVector<uint8_t> vecbyRedPacket;
+
+    QSemaphore       WakeSem;
+    volatile bool    bRun;
+};
+
 class CClient : public QObject
 {
     Q_OBJECT
@@ -113,10 +399,23 @@ public:
     void   Start();
     void   Stop();
     bool   IsRunning() { return Sound.IsRunning(); }
+
+    // each setter which changes the audio processing re-initializes the sound
+    // card and the coders, while the settings are loaded these initializations
+    // are combined to one at the end of the batch
+    void   BeginInitBatch() { bInitBatch = true; bInitPending = false; }
+    void   EndInitBatch();
     bool   SetServerAddr ( QString strNAddr );
 
-    double MicLeveldB_L() { return SignalLevelMeter.MicLeveldBLeft(); }
-    double MicLeveldB_R() { return SignalLevelMeter.MicLeveldBRight(); }
+    // spread of the ping times of the server which were measured in the connect
+    // dialog (-1 if unknown), used for the start of the auto jitter buffer if
+    // no good delay is stored for the server
+    void   SetConnectPingJitter ( const int iPingJitterMs ) { iConnectPingJitterMs = iPingJitterMs; }
+
+    // the GUI reads the state of the audio processing from the snapshot of the
+    // last block
+    double MicLeveldB_L() const { return Telemetry.Read().dMicLeveldBLeft; }
+    double MicLeveldB_R() const { return Telemetry.Read().dMicLeveldBRight; }
 
     bool   GetAndResetbJitterBufferOKFlag();
 
@@ -128,6 +427,10 @@ public:
     bool GetDisplayChannelLevels() const { return bDisplayChannelLevels; }
     void SetDisplayChannelLevels ( const bool bNDCL );
 
+    // the server does not send the channel levels while they cannot be seen
+    // (the display setting of the user is not changed)
+    void SetChannelLevelsPaused ( const bool bNCLP );
+
     EAudioQuality GetAudioQuality() const { return eAudioQuality; }
     void SetAudioQuality ( const EAudioQuality eNAudioQuality );
 
@@ -207,6 +510,39 @@ public:
     void SetEnableOPUS64 ( const bool eNEnableOPUS64 );
     bool GetEnableOPUS64() { return bEnableOPUS64; }
 
+    void SetEnableTimeStretch ( const bool bNEnableTimeStretch );
+    bool GetEnableTimeStretch() { return bEnableTimeStretch; }
+
+    void SetEnableRedundancy ( const bool bNEnableRedundancy );
+    bool GetEnableRedundancy() { return bEnableRedundancy; }
+
+    void SetEnableSeqNum ( const bool bNEnableSeqNum );
+    bool GetEnableSeqNum() { return bEnableSeqNum; }
+
+    void SetEnableMultiStream ( const bool bNEnableMultiStream );
+    bool GetEnableMultiStream() { return bEnableMultiStream; }
+
+    void SetEnableMultitrack ( const bool bNEnableMultitrack );
+    bool GetEnableMultitrack() { return bEnableMultitrack; }
+
+    void SetEnableDirectMonitor ( const bool bNEnableDirectMonitor );
+    bool GetEnableDirectMonitor() { return bEnableDirectMonitor; }
+
+    void SetEnableAdaptiveEncoder ( const bool bNEnableAdaptiveEncoder ) { bEnableAdaptiveEncoder = bNEnableAdaptiveEncoder; }
+    bool GetEnableAdaptiveEncoder() { return bEnableAdaptiveEncoder; }
+
+    void SetEnableAdaptiveAggregation ( const bool bNEnableAdaptiveAggregation );
+    bool GetEnableAdaptiveAggregation() { return bEnableAdaptiveAggregation; }
+    int  GetNetwFrameSizeFact() const { return Channel.GetNetwFrameSizeFact(); }
+
+    void SetEnableAdaptiveQuality ( const bool bNEnableAdaptiveQuality );
+    bool GetEnableAdaptiveQuality() { return bEnableAdaptiveQuality; }
+
+    // the audio quality which is used, it can be below the quality setting on
+    // a congested link
+    EAudioQuality GetCurAudioQuality() const
+        { return bEnableAdaptiveQuality ? AudioQualityControl.GetQuality() : eAudioQuality; }
+
     int GetSndCrdActualMonoBlSize()
     {
         // the actual sound card mono block size depends on whether a
@@ -217,7 +553,7 @@ public:
         }
         else
         {
-            return iMonoBlockSizeSam;
+            return iSndCrdNumSubBlocks * iMonoBlockSizeSam;
         }
     }
     int GetSystemMonoBlSize() { return iMonoBlockSizeSam; }
@@ -241,10 +577,23 @@ public:
 
     void SetMuteOutStream ( const bool bDoMute ) { bMuteOutStream = bDoMute; }
 
+    // in the listener mode only a silent keep-alive packet is sent and the
+    // server does not mix our signal (must be set before the connection)
+    void SetListenerMode ( const bool bNListenerMode ) { bListenerMode = bNListenerMode; }
+    bool GetListenerMode() const { return bListenerMode; }
+
+    // the mix group (e.g. the section of a choir) of our own signal which the
+    // server sums in a mix group bus (must be set before the connection)
+    void SetMixGroup ( const int iNMixGroup ) { iMixGroup = iNMixGroup; }
+    int  GetMixGroup() const { return iMixGroup; }
+
+    // the gain of a mix group is applied on all channels of the group in our
+    // mix (in addition to the channel gains)
+    void SetRemoteMixGroupGain ( const int iMixGroup, const double dGain );
+
     void SetRemoteChanGain ( const int iId, const double dGain, const bool bIsMyOwnFader );
 
-	void SetRemoteChanPan ( const int iId, const double dPan )
-        { Channel.SetRemoteChanPan ( iId, dPan ); }
+    void SetRemoteChanPan ( const int iId, const double dPan );
 
     void SetRemoteInfo() { Channel.SetRemoteInfo ( ChannelInfo ); }
 
@@ -254,6 +603,11 @@ public:
     void CreateCLPingMes()
         { ConnLessProtocol.CreateCLPingMes ( Channel.GetAddress(), PreparePingMessage() ); }
 
+    // the server answers with its timing of our audio, the result is reported
+    // by the LatencyBreakdownReceived() signal (old servers do not answer)
+    void CreateCLLatencyProbeMes()
+        { ConnLessProtocol.CreateCLReqLatencyProbeMes ( Channel.GetAddress(), PreparePingMessage() ); }
+
     void CreateCLServerListPingMes ( const CHostAddress& InetAddr )
     {
         ConnLessProtocol.CreateCLPingWithNumClientsMes ( InetAddr,
@@ -270,19 +624,42 @@ public:
     void CreateCLReqServerListMes ( const CHostAddress& InetAddr )
         { ConnLessProtocol.CreateCLReqServerListMes ( InetAddr ); }
 
+    void CreateCLReqServerListPageMes ( const CHostAddress& InetAddr,
+                                        const int           iPage )
+        { ConnLessProtocol.CreateCLReqServerListPageMes ( InetAddr, ServerListFilter, iPage ); }
+
+    // the IPv6 servers are only requested if our socket can reach them
+    void CreateCLReqServerListIPv6Mes ( const CHostAddress& InetAddr )
+    {
+        if ( CSocket::IsDualStack() )
+        {
+            ConnLessProtocol.CreateCLReqServerListIPv6Mes ( InetAddr, ServerListFilter );
+        }
+    }
+
+    void SetServerListFilter ( const CServerListFilter& NewFilter ) { ServerListFilter = NewFilter; }
+    CServerListFilter GetServerListFilter() const { return ServerListFilter; }
+
     int EstimatedOverallDelay ( const int iPingTimeMs );
 
     void GetBufErrorRates ( CVector<double>& vecErrRates, double& dLimit, double& dMaxUpLimit )
         { Channel.GetBufErrorRates ( vecErrRates, dLimit, dMaxUpLimit ); }
 
+    void GetNetStats ( CChannelNetStats& NetStats ) const
+        { Channel.GetNetStats ( NetStats ); }
+
+    // timing of the sound card callbacks (measured by the sound interface)
+    void GetSndCrdTimingStats ( CSndCrdTimingStats& TimingStats ) const
+        { Sound.GetTimingStats ( TimingStats ); }
+
+    // load of our audio processing (measured in the audio callback)
+    const CClientDspLoad& GetDspLoad() const { return DspLoad; }
+
     // settings
     CVector<QString> vstrIPAddress;
     CChannelCoreInfo ChannelInfo;
-    CVector<QString> vecStoredFaderTags;
-    CVector<int>     vecStoredFaderLevels;
-    CVector<int>     vecStoredPanValues;
-    CVector<int>     vecStoredFaderIsSolo;
-    CVector<int>     vecStoredFaderIsMute;
+    CStoredFaderSettings StoredFaderSettings;
+    CStoredJitBufDelays StoredJitBufDelays;
     int              iNewClientFaderLevel;
     bool             bConnectDlgShowAllMusicians;
     QString          strClientName;
@@ -306,19 +683,51 @@ public:
 protected:
     // callback function must be static, otherwise it does not work
     static void AudioCallback ( CVector<short>& psData, void* arg );
+    static void AudioCallbackFloat ( CVector<float>& vecfData, void* arg );
 
     void        Init();
+    void        InitCodec ( const bool bLive );
+    void        SwitchCodec();
+    void        UpdateSndCrdFrameSizeSupport();
+
+    // the auto jitter buffer of a new connection starts with the last good
+    // delay of the server, the delay of the connection is stored on disconnect
+    int         GetJitBufStartDelayMs() const;
+    void        StoreJitBufDelay();
+    bool        UpdateSndCrdBufferSize();
+    void        ApplyFadeIn ( float* pfStereo ) const;
     void        ProcessSndCrdAudioData ( CVector<short>& vecsStereoSndCrd );
-    void        ProcessAudioDataIntern ( CVector<short>& vecsStereoSndCrd );
+    void        ProcessSndCrdAudioDataFloat ( float*    pfStereoSndCrd,
+                                              const int iNumSamples );
+    void        ProcessAudioDataIntern ( float* pfStereoSndCrd );
+    void        ReceiveAndDecodeTimeStretch();
+    void        PublishTelemetry();
+    void        DecodeReceivedFrame ( const uint8_t* pCodedData,
+                                      const int      iNumCodedBytes,
+                                      float*         pfOut );
+    void        UpdateEncoderProfile ( const int    iNumSamples,
+                                       const qint64 iProcTimeNs );
 
     int         PreparePingMessage();
     int         EvaluatePingMessage ( const int iMs );
     void        CreateServerJitterBufferMessage();
+    void        SendConnectionProperties();
+    void        QueueRemoteChanGain ( const int    iId,
+                                      const double dGain );
+    void        QueueRemoteChanPan ( const int    iId,
+                                     const double dPan );
+
+    // timing records of the last seconds for the analysis of underruns (must
+    // be declared before the channel which records in it)
+    CFlightRecorder         FlightRecorder;
 
     // only one channel is needed for client application
     CChannel                Channel;
     CProtocol               ConnLessProtocol;
 
+    // filter of the paged server list queries
+    CServerListFilter       ServerListFilter;
+
     // audio encoder/decoder
     OpusCustomMode*         Opus64Mode;
     OpusCustomEncoder*      Opus64EncoderMono;
@@ -332,19 +741,54 @@ protected:
     OpusCustomDecoder*      OpusDecoderStereo;
     OpusCustomEncoder*      CurOpusEncoder;
     OpusCustomDecoder*      CurOpusDecoder;
+
+    // low bit rate encoders for the redundant copy of the frames
+    OpusCustomEncoder*      Opus64RedEncoderMono;
+    OpusCustomEncoder*      Opus64RedEncoderStereo;
+    OpusCustomEncoder*      OpusRedEncoderMono;
+    OpusCustomEncoder*      OpusRedEncoderStereo;
+    OpusCustomEncoder*      CurOpusRedEncoder;
+    CVector<unsigned char>  vecRedCeltData;
+
+    // encoders of the sub-stream of the multi-stream mode
+    OpusCustomEncoder*      Opus64SubEncoderMono;
+    OpusCustomEncoder*      Opus64SubEncoderStereo;
+    OpusCustomEncoder*      OpusSubEncoderMono;
+    OpusCustomEncoder*      OpusSubEncoderStereo;
+    OpusCustomEncoder*      CurOpusSubEncoder;
     EAudComprType           eAudioCompressionType;
     int                     iCeltNumCodedBytes;
     int                     iOPUSFrameSizeSamples;
     EAudioQuality           eAudioQuality;
     EAudChanConf            eAudioChannelConf;
+    EAudChanConf            eReverbAudioChannelConf; // configuration of the reverberation init
     int                     iNumAudioChannels;
     bool                    bIsInitializationPhase;
     bool                    bMuteOutStream;
+    bool                    bListenerMode;
+    int                     iListenerKeepAliveCnt;
+    int                     iMixGroup;
     double                  dMuteOutStreamGain;
     CVector<unsigned char>  vecCeltData;
 
     CHighPrioSocket         Socket;
+    CClientSendThread       SendThread;
     CSound                  Sound;
+    CSndCrdBridge           SndCrdBridge;
+    bool                    bFadeInSndCrd;
+
+    // live codec switch: the audio thread fades out and hands the codecs over
+    // at a block boundary (CS_HOLD), then the GUI thread switches them and the
+    // audio thread fades in with the new codecs (see SwitchCodec())
+    enum ECodecSwitchState
+    {
+        CS_NONE,
+        CS_REQUESTED,
+        CS_HOLD,
+        CS_RESUME
+    };
+
+    QAtomicInt              iCodecSwitchState;
     CStereoSignalLevelMeter SignalLevelMeter;
 
     CVector<uint8_t>        vecbyNetwData;
@@ -359,11 +803,16 @@ protected:
 
     bool                    bSndCrdConversionBufferRequired;
     int                     iSndCardMonoBlockSizeSamConvBuff;
-    CBufferBase<int16_t>    SndCrdConversionBufferIn;
-    CBufferBase<int16_t>    SndCrdConversionBufferOut;
-    CVector<int16_t>        vecDataConvBuf;
-    CVector<int16_t>        vecsStereoSndCrdMuteStream;
-    CVector<int16_t>        vecZeros;
+    int                     iSndCrdNumSubBlocks;
+    CInPlaceConvBuf<float>  SndCrdConversionBuffer;
+
+    // the audio processing works on float samples with the scale of the OPUS
+    // float API, the samples of an int16 sound card interface are converted
+    // once in the sound card buffer size
+    CVector<float>          vecfStereoSndCrdConv;
+    CVector<float>          vecfStereoSndCrd;
+    CVector<float>          vecfStereoSndCrdMuteStream;
+    CVector<float>          vecfZeros;
 
     bool                    bFraSiFactPrefSupported;
     bool                    bFraSiFactDefSupported;
@@ -374,9 +823,71 @@ protected:
 
     EGUIDesign              eGUIDesign;
     bool                    bDisplayChannelLevels;
+    bool                    bChannelLevelsPaused;
+    bool                    bChannelLevelDeltaValid;
+    bool                    bSessionSetupSent;
+    int                     iChannelLevelDeltaSeqNum;
+    CVector<uint16_t>       vecChannelLevelDelta;
     bool                    bEnableOPUS64;
 
-    bool                    bJitterBufferOK;
+    // jitter-aware playout with time-scale modification
+    bool                    bEnableTimeStretch;
+    CPlayoutBuffer          Playout;
+    CVector<float>          vecfDecodedFrame;
+
+    // redundant copy of the previous packet (if the server supports it)
+    bool                    bEnableRedundancy;
+
+    // sequence numbers and send times in the audio packets (if the server
+    // supports it, not used with the redundancy and the multi-stream mode)
+    bool                    bEnableSeqNum;
+
+    // multi-stream mode: the left and right sound card inputs are sent as
+    // separate streams which get separate faders at the server (if the
+    // server supports it, not available for the stereo mode)
+    bool                    bEnableMultiStream;
+    int                     iNumSubStreams;
+    CVector<float>          vecfSubStreamSndCrd;
+    CEncoderProfile         SubEncoderProfile;
+
+    // multitrack mode: the server forwards the coded frames of the other
+    // clients which are mixed locally with the gains of our faders (if the
+    // server supports it, not used with the redundancy)
+    bool                    bEnableMultitrack;
+    CMultitrackMixer        Multitrack;
+
+    // local monitoring of our own signal instead of the server mix
+    bool                    bEnableDirectMonitor;
+    int                     iOwnChanID;
+
+    bool                    bInitBatch;
+    bool                    bInitPending;
+
+    // encoder settings selected from the CPU headroom and the network quality
+    bool                    bEnableAdaptiveEncoder;
+    int                     iEncoderBitRate;
+    CEncoderProfile         EncoderProfile;
+    CEncoderCpuLoadMeter    EncoderCpuLoad;
+    QElapsedTimer           AudioProcTimer;
+    CClientDspLoad          DspLoad;
+
+    // number of frames per network packet adapted to the packet loss
+    bool                      bEnableAdaptiveAggregation;
+    CNetwFrameSizeFactControl NetwFrameSizeFactControl;
+    QTimer                    TimerNetwAggregation;
+
+    // audio quality adapted to the congestion of the link
+    bool                      bEnableAdaptiveQuality;
+    CAudioQualityControl      AudioQualityControl;
+    QTimer                    TimerAudioQuality;
+
+    // state of the audio processing published once per block (the error
+    // counter is only used by the audio thread, the last values by the GUI)
+    CTelemetrySnapshot<SClientTelemetry> Telemetry;
+    int                     iNumJitBufGetErrors;
+    int                     iLastNumJitBufGetErrors;
+    int                     iLastNumJitBufPutErrors;
+    int                     iLastNumBufOverruns;
 
     QString                 strCentralServerAddress;
     ECSAddType              eCentralServerAddressType;
@@ -384,30 +895,62 @@ protected:
     // server settings
     int                     iServerSockBufNumFrames;
 
+    // the server address as it was set and the ping jitter of the server
+    QString                 strServerAddr;
+    int                     iConnectPingJitterMs;
+
     // for ping measurement
     CPreciseTime            PreciseTime;
 
     CSignalHandler*         pSignalHandler;
 
+    // the gain and pan messages are coalesced: the first change is sent
+    // immediately, the following changes of the interval only store the
+    // latest value (negative: nothing pending) which is sent by the timer
+    QTimer                  TimerRemoteMixUpdate;
+    CVector<double>         vecdPendingRemoteGains;
+    CVector<double>         vecdPendingRemotePans;
+    CVector<double>         vecdPendingRemoteMixGroupGains;
+
+#ifdef RT_SAFETY_CHECK
+    // the violations of the audio callback are reported periodically
+    QTimer                  TimerRtSafetyReport;
+#endif
+
 public slots:
+    void OnTimerRemoteMixUpdate();
+    void OnTimerNetwAggregation();
+    void OnTimerAudioQuality();
+    void OnNetStatsReceived ( int iNumReceived,
+                              int iNumLost );
     void OnHandledSignal ( int sigNum );
-    void OnSendProtMessage ( CVector<uint8_t> vecMessage );
+    void OnSendProtMessage ( CProtMessage Message );
     void OnInvalidPacketReceived ( CHostAddress RecHostAddr );
 
-    void OnDetectedCLMessage ( CVector<uint8_t> vecbyMesBodyData,
-                               int              iRecID,
-                               CHostAddress     RecHostAddr );
+    void OnDetectedCLMessage ( CProtMessage MesBody,
+                               int          iRecID,
+                               CHostAddress RecHostAddr );
 
     void OnReqJittBufSize() { CreateServerJitterBufferMessage(); }
     void OnJittBufSizeChanged ( int iNewJitBufSize );
     void OnReqChanInfo() { Channel.SetRemoteInfo ( ChannelInfo ); }
     void OnNewConnection();
+    void OnSessionSetupRequired();
+    void OnMixGroupListReceived ( CVector<int> vecMixGroups );
+    void OnMulticastGroupReceived ( int          iStream,
+                                    CHostAddress GroupAddr );
     void OnCLDisconnection ( CHostAddress InetAddr ) { if ( InetAddr == Channel.GetAddress() ) { emit Disconnected(); } }
     void OnCLPingReceived ( CHostAddress InetAddr,
                             int          iMs );
 
-    void OnSendCLProtMessage ( CHostAddress     InetAddr,
-                               CVector<uint8_t> vecMessage );
+    void OnCLRttProbeReceived ( CHostAddress InetAddr,
+                                int          iMs );
+
+    void OnCLLatencyProbeReceived ( CHostAddress       InetAddr,
+                                    CServerLatencyInfo LatencyInfo );
+
+    void OnSendCLProtMessage ( CHostAddress InetAddr,
+                               CProtMessage Message );
 
     void OnCLPingWithNumClientsReceived ( CHostAddress InetAddr,
                                           int          iMs,
@@ -415,6 +958,11 @@ public slots:
 
     void OnSndCrdReinitRequest ( int iSndCrdResetType );
 
+    void OnCLChannelLevelDeltaReceived ( CHostAddress      InetAddr,
+                                         int               iSeqNum,
+                                         bool              bFullList,
+                                         CVector<uint16_t> vecLevelList );
+
 signals:
     void ConClientListMesReceived ( CVector<CChannelInfo> vecChanInfo );
     void ChatTextReceived ( QString strChatText );
@@ -423,11 +971,21 @@ signals:
     void LicenceRequired ( ELicenceType eLicenceType );
     void VersionAndOSReceived ( COSUtil::EOpSystemType eOSType, QString strVersion );
     void PingTimeReceived ( int iPingTime );
+    void LatencyBreakdownReceived ( CLatencyBreakdown Breakdown );
     void RecorderStateReceived ( ERecorderState eRecorderState );
+    void MixGroupListReceived ( CVector<int> vecMixGroups );
 
     void CLServerListReceived ( CHostAddress         InetAddr,
                                 CVector<CServerInfo> vecServerInfo );
 
+    void CLServerListPageReceived ( CHostAddress         InetAddr,
+                                    int                  iPage,
+                                    int                  iNumPages,
+                                    CVector<CServerInfo> vecServerInfo );
+
+    void CLServerListIPv6Received ( CHostAddress         InetAddr,
+                                    CVector<CServerInfo> vecServerInfo );
+
     void CLConnClientsListMesReceived ( CHostAddress          InetAddr,
                                         CVector<CChannelInfo> vecChanInfo );
 
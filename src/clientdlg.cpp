@@ -39,11 +39,9 @@ CClientDlg::CClientDlg ( CClient*        pNCliP,
     pSettings           ( pNSetP ),
     bConnectDlgWasShown ( false ),
     bMIDICtrlUsed       ( iCtrlMIDIChannel != INVALID_MIDI_CH ),
-    ClientSettingsDlg   ( pNCliP, parent, Qt::Window ),
-    ChatDlg             ( parent, Qt::Window ),
-    ConnectDlg          ( pNCliP, bNewShowComplRegConnList, parent, Qt::Dialog ),
-    AnalyzerConsole     ( pNCliP, parent, Qt::Window ),
-    MusicianProfileDlg  ( pNCliP, parent )
+    pDlgParent            ( parent ),
+    bShowComplRegConnList ( bNewShowComplRegConnList ),
+    AnalyzerConsole       ( pNCliP, parent, Qt::Window )
 {
     setupUi ( this );
 
@@ -179,6 +177,26 @@ CClientDlg::CClientDlg ( CClient*        pNCliP,
 
     ledBuffers->setAccessibleName ( tr ( "Buffers status LED indicator" ) );
 
+    // DSP load LED
+    QString strLEDDspLoad = "<b>" + tr ( "DSP Load" ) + ":</b> " +
+        tr ( "Shows how much of the time of the sound card buffer is needed "
+        "for the audio processing of this computer (average of the last half "
+        "second, the peak is the longest sound card buffer):" ) +
+        "<ul>"
+        "<li>" "<b>" + tr ( "Green" ) + ":</b> " + tr ( "The computer keeps up "
+        "easily." ) + "</li>"
+        "<li>" "<b>" + tr ( "Yellow" ) + ":</b> " + tr ( "The peak load is high, "
+        "other programs may cause interruptions." ) + "</li>"
+        "<li>" "<b>" + tr ( "Red" ) + ":</b> " + tr ( "The processing took "
+        "longer than the sound card buffer, the audio is interrupted. Use a "
+        "larger buffer size or close other programs." ) + "</li>"
+        "</ul>";
+
+    lblDspLoad->setWhatsThis ( strLEDDspLoad );
+    ledDspLoad->setWhatsThis ( strLEDDspLoad );
+
+    ledDspLoad->setAccessibleName ( tr ( "DSP load LED indicator" ) );
+
     // init GUI design
     SetGUIDesign ( pClient->GetGUIDesign() );
 
@@ -189,15 +207,11 @@ CClientDlg::CClientDlg ( CClient*        pNCliP,
     MainMixerBoard->SetDisplayChannelLevels ( pClient->GetDisplayChannelLevels() );
 
     // restore fader settings
-    MainMixerBoard->vecStoredFaderTags   = pClient->vecStoredFaderTags;
-    MainMixerBoard->vecStoredFaderLevels = pClient->vecStoredFaderLevels;
-    MainMixerBoard->vecStoredPanValues   = pClient->vecStoredPanValues;
-    MainMixerBoard->vecStoredFaderIsSolo = pClient->vecStoredFaderIsSolo;
-    MainMixerBoard->vecStoredFaderIsMute = pClient->vecStoredFaderIsMute;
+    MainMixerBoard->StoredFaderSettings  = pClient->StoredFaderSettings;
     MainMixerBoard->iNewClientFaderLevel = pClient->iNewClientFaderLevel;
 
     // init status label
-    OnTimerStatus();
+    UpdateDisplay();
 
     // init connection button text
     butConnect->setText ( tr ( "C&onnect" ) );
@@ -209,6 +223,7 @@ CClientDlg::CClientDlg ( CClient*        pNCliP,
     // init status LEDs
     ledBuffers->Reset();
     ledDelay->Reset();
+    ledDspLoad->Reset();
 
     // init audio in fader
     sldAudioPan->setRange ( AUD_FADER_IN_MIN, AUD_FADER_IN_MAX );
@@ -224,9 +239,6 @@ CClientDlg::CClientDlg ( CClient*        pNCliP,
     // init reverb channel
     UpdateRevSelection();
 
-    // init connect dialog
-    ConnectDlg.SetShowAllMusicians ( pClient->bConnectDlgShowAllMusicians );
-
     // set window title (with no clients connected -> "0")
     SetMyWindowTitle ( 0 );
 
@@ -371,45 +383,22 @@ CClientDlg::CClientDlg ( CClient*        pNCliP,
         restoreGeometry ( pClient->vecWindowPosMain );
     }
 
-    // settings window
-    if ( !pClient->vecWindowPosSettings.isEmpty() && !pClient->vecWindowPosSettings.isNull() )
-    {
-        ClientSettingsDlg.restoreGeometry ( pClient->vecWindowPosSettings );
-    }
-
+    // the positions of the other windows are restored when they are created
     if ( pClient->bWindowWasShownSettings )
     {
         ShowGeneralSettings();
     }
 
-    // chat window
-    if ( !pClient->vecWindowPosChat.isEmpty() && !pClient->vecWindowPosChat.isNull() )
-    {
-        ChatDlg.restoreGeometry ( pClient->vecWindowPosChat );
-    }
-
     if ( pClient->bWindowWasShownChat )
     {
         ShowChatWindow();
     }
 
-    // musician profile window
-    if ( !pClient->vecWindowPosProfile.isEmpty() && !pClient->vecWindowPosProfile.isNull() )
-    {
-        MusicianProfileDlg.restoreGeometry ( pClient->vecWindowPosProfile );
-    }
-
     if ( pClient->bWindowWasShownProfile )
     {
         ShowMusicianProfileDialog();
     }
 
-    // connection setup window
-    if ( !pClient->vecWindowPosConnect.isEmpty() && !pClient->vecWindowPosConnect.isNull() )
-    {
-        ConnectDlg.restoreGeometry ( pClient->vecWindowPosConnect );
-    }
-
 
     // Connections -------------------------------------------------------------
     // push buttons
@@ -433,9 +422,6 @@ CClientDlg::CClientDlg ( CClient*        pNCliP,
     QObject::connect ( &TimerBuffersLED, &QTimer::timeout,
         this, &CClientDlg::OnTimerBuffersLED );
 
-    QObject::connect ( &TimerStatus, &QTimer::timeout,
-        this, &CClientDlg::OnTimerStatus );
-
     QObject::connect ( &TimerPing, &QTimer::timeout,
         this, &CClientDlg::OnTimerPing );
 
@@ -475,6 +461,9 @@ CClientDlg::CClientDlg ( CClient*        pNCliP,
     QObject::connect ( pClient, &CClient::RecorderStateReceived,
         this, &CClientDlg::OnRecorderStateReceived );
 
+    QObject::connect ( pClient, &CClient::MixGroupListReceived,
+        this, &CClientDlg::OnMixGroupListReceived );
+
     // This connection is a special case. On receiving a licence required message via the
     // protocol, a modal licence dialog is opened. Since this blocks the thread, we need
     // a queued connection to make sure the core protocol mechanism is not blocked, too.
@@ -485,9 +474,18 @@ CClientDlg::CClientDlg ( CClient*        pNCliP,
     QObject::connect ( pClient, &CClient::PingTimeReceived,
         this, &CClientDlg::OnPingTimeResult );
 
+    QObject::connect ( pClient, &CClient::LatencyBreakdownReceived,
+        this, &CClientDlg::OnLatencyBreakdown );
+
     QObject::connect ( pClient, &CClient::CLServerListReceived,
         this, &CClientDlg::OnCLServerListReceived );
 
+    QObject::connect ( pClient, &CClient::CLServerListPageReceived,
+        this, &CClientDlg::OnCLServerListPageReceived );
+
+    QObject::connect ( pClient, &CClient::CLServerListIPv6Received,
+        this, &CClientDlg::OnCLServerListIPv6Received );
+
     QObject::connect ( pClient, &CClient::CLConnClientsListMesReceived,
         this, &CClientDlg::OnCLConnClientsListMesReceived );
 
@@ -511,54 +509,23 @@ CClientDlg::CClientDlg ( CClient*        pNCliP,
     QObject::connect ( QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
         this, &CClientDlg::OnAboutToQuit );
 
-    QObject::connect ( &ClientSettingsDlg, &CClientSettingsDlg::GUIDesignChanged,
-        this, &CClientDlg::OnGUIDesignChanged );
-
-    QObject::connect ( &ClientSettingsDlg, &CClientSettingsDlg::DisplayChannelLevelsChanged,
-        this, &CClientDlg::OnDisplayChannelLevelsChanged );
-
-    QObject::connect ( &ClientSettingsDlg, &CClientSettingsDlg::AudioChannelsChanged,
-        this, &CClientDlg::OnAudioChannelsChanged );
-
-    QObject::connect ( &ClientSettingsDlg, &CClientSettingsDlg::NewClientLevelChanged,
-        this, &CClientDlg::OnNewClientLevelChanged );
-
     QObject::connect ( MainMixerBoard, &CAudioMixerBoard::ChangeChanGain,
         this, &CClientDlg::OnChangeChanGain );
 
     QObject::connect ( MainMixerBoard, &CAudioMixerBoard::ChangeChanPan,
         this, &CClientDlg::OnChangeChanPan );
 
+    QObject::connect ( MainMixerBoard, &CAudioMixerBoard::ChangeMixGroupGain,
+        this, &CClientDlg::OnChangeMixGroupGain );
+
     QObject::connect ( MainMixerBoard, &CAudioMixerBoard::NumClientsChanged,
         this, &CClientDlg::OnNumClientsChanged );
 
-    QObject::connect ( &ChatDlg, &CChatDlg::NewLocalInputText,
-        this, &CClientDlg::OnNewLocalInputText );
-
-    QObject::connect ( &ConnectDlg, &CConnectDlg::ReqServerListQuery,
-        this, &CClientDlg::OnReqServerListQuery );
-
-    // note that this connection must be a queued connection, otherwise the server list ping
-    // times are not accurate and the client list may not be retrieved for all servers listed
-    // (it seems the sendto() function needs to be called from different threads to fire the
-    // packet immediately and do not collect packets before transmitting)
-    QObject::connect ( &ConnectDlg, &CConnectDlg::CreateCLServerListPingMes,
-        this, &CClientDlg::OnCreateCLServerListPingMes, Qt::QueuedConnection );
-
-    QObject::connect ( &ConnectDlg, &CConnectDlg::CreateCLServerListReqVerAndOSMes,
-        this, &CClientDlg::OnCreateCLServerListReqVerAndOSMes );
-
-    QObject::connect ( &ConnectDlg, &CConnectDlg::CreateCLServerListReqConnClientsListMes,
-        this, &CClientDlg::OnCreateCLServerListReqConnClientsListMes );
-
-    QObject::connect ( &ConnectDlg, &CConnectDlg::accepted,
-        this, &CClientDlg::OnConnectDlgAccepted );
+    QObject::connect ( &CHostNameResolver::Instance(), &CHostNameResolver::HostNameResolved,
+        this, &CClientDlg::OnHostNameResolved );
 
 
     // Initializations which have to be done after the signals are connected ---
-    // start timer for status bar
-    TimerStatus.start ( LED_BAR_UPDATE_TIME_MS );
-
     // restore connect dialog
     if ( pClient->bWindowWasShownConnect )
     {
@@ -568,23 +535,57 @@ CClientDlg::CClientDlg ( CClient*        pNCliP,
 
 void CClientDlg::closeEvent ( QCloseEvent* Event )
 {
-    // store window positions
-    pClient->vecWindowPosMain     = saveGeometry();
-    pClient->vecWindowPosSettings = ClientSettingsDlg.saveGeometry();
-    pClient->vecWindowPosChat     = ChatDlg.saveGeometry();
-    pClient->vecWindowPosProfile  = MusicianProfileDlg.saveGeometry();
-    pClient->vecWindowPosConnect  = ConnectDlg.saveGeometry();
-
-    pClient->bWindowWasShownSettings = ClientSettingsDlg.isVisible();
-    pClient->bWindowWasShownChat     = ChatDlg.isVisible();
-    pClient->bWindowWasShownProfile  = MusicianProfileDlg.isVisible();
-    pClient->bWindowWasShownConnect  = ConnectDlg.isVisible();
+    // store window positions (the stored positions of the windows which were
+    // not created are kept)
+    pClient->vecWindowPosMain = saveGeometry();
+
+    if ( pClientSettingsDlg )
+    {
+        pClient->vecWindowPosSettings = pClientSettingsDlg->saveGeometry();
+    }
+
+    if ( pChatDlg )
+    {
+        pClient->vecWindowPosChat = pChatDlg->saveGeometry();
+    }
+
+    if ( pMusicianProfileDlg )
+    {
+        pClient->vecWindowPosProfile = pMusicianProfileDlg->saveGeometry();
+    }
+
+    if ( pConnectDlg )
+    {
+        pClient->vecWindowPosConnect         = pConnectDlg->saveGeometry();
+        pClient->bConnectDlgShowAllMusicians = pConnectDlg->GetShowAllMusicians();
+    }
+
+    pClient->bWindowWasShownSettings = IsDlgVisible ( pClientSettingsDlg.get() );
+    pClient->bWindowWasShownChat     = IsDlgVisible ( pChatDlg.get() );
+    pClient->bWindowWasShownProfile  = IsDlgVisible ( pMusicianProfileDlg.get() );
+    pClient->bWindowWasShownConnect  = IsDlgVisible ( pConnectDlg.get() );
 
     // if settings/connect dialog or chat dialog is open, close it
-    ClientSettingsDlg.close();
-    ChatDlg.close();
-    MusicianProfileDlg.close();
-    ConnectDlg.close();
+    if ( pClientSettingsDlg )
+    {
+        pClientSettingsDlg->close();
+    }
+
+    if ( pChatDlg )
+    {
+        pChatDlg->close();
+    }
+
+    if ( pMusicianProfileDlg )
+    {
+        pMusicianProfileDlg->close();
+    }
+
+    if ( pConnectDlg )
+    {
+        pConnectDlg->close();
+    }
+
     AnalyzerConsole.close();
 
     // if connected, terminate connection
@@ -597,13 +598,8 @@ void CClientDlg::closeEvent ( QCloseEvent* Event )
     // initiate a storage of the current mixer fader levels in case we are
     // just in a connected state) and other settings
     MainMixerBoard->HideAll();
-    pClient->vecStoredFaderTags          = MainMixerBoard->vecStoredFaderTags;
-    pClient->vecStoredFaderLevels        = MainMixerBoard->vecStoredFaderLevels;
-    pClient->vecStoredPanValues          = MainMixerBoard->vecStoredPanValues;
-    pClient->vecStoredFaderIsSolo        = MainMixerBoard->vecStoredFaderIsSolo;
-    pClient->vecStoredFaderIsMute        = MainMixerBoard->vecStoredFaderIsMute;
-    pClient->iNewClientFaderLevel        = MainMixerBoard->iNewClientFaderLevel;
-    pClient->bConnectDlgShowAllMusicians = ConnectDlg.GetShowAllMusicians();
+    pClient->StoredFaderSettings  = MainMixerBoard->StoredFaderSettings;
+    pClient->iNewClientFaderLevel = MainMixerBoard->iNewClientFaderLevel;
 
     // default implementation of this event handler routine
     Event->accept();
@@ -681,6 +677,8 @@ void CClientDlg::OnConnectDlgAccepted()
     // we process the accepted signal only once after the dialog was initially shown.
     if ( bConnectDlgWasShown )
     {
+        CConnectDlg& ConnectDlg = GetConnectDlg();
+
         // get the address from the connect dialog
         QString strSelectedAddress = ConnectDlg.GetSelectedAddress();
 
@@ -729,6 +727,10 @@ void CClientDlg::OnConnectDlgAccepted()
             Disconnect();
         }
 
+        // the jitter buffer of the new connection starts with the measured
+        // ping jitter if no good delay is stored for the server
+        pClient->SetConnectPingJitter ( ConnectDlg.GetSelectedPingJitter() );
+
         // initiate connection
         Connect ( strSelectedAddress, strMixerBoardLabel );
 
@@ -753,12 +755,12 @@ void CClientDlg::OnConnectDisconBut()
 void CClientDlg::OnCentralServerAddressTypeChanged()
 {
     // if the server list is shown and the server type was changed, update the list
-    if ( ConnectDlg.isVisible() )
+    if ( IsDlgVisible ( pConnectDlg.get() ) )
     {
-        ConnectDlg.SetCentralServerAddress ( NetworkUtil::GetCentralServerAddress ( pClient->GetCentralServerAddressType(),
-                                                                                    pClient->GetServerListCentralServerAddress() ) );
+        pConnectDlg->SetCentralServerAddress ( NetworkUtil::GetCentralServerAddress ( pClient->GetCentralServerAddressType(),
+                                                                                      pClient->GetServerListCentralServerAddress() ) );
 
-        ConnectDlg.RequestServerList();
+        pConnectDlg->RequestServerList();
     }
 }
 
@@ -776,7 +778,7 @@ void CClientDlg::OnVersionAndOSReceived ( COSUtil::EOpSystemType ,
 
 void CClientDlg::OnChatTextReceived ( QString strChatText )
 {
-    ChatDlg.AddChatText ( strChatText );
+    GetChatDlg().AddChatText ( strChatText );
 
     // open window (note that we do not want to force the dialog to be upfront
     // always when a new message arrives since this is annoying)
@@ -873,8 +875,122 @@ void CClientDlg::SetMyWindowTitle ( const int iNumClients )
 #endif
 }
 
+CClientSettingsDlg& CClientDlg::GetClientSettingsDlg()
+{
+    if ( !pClientSettingsDlg )
+    {
+        pClientSettingsDlg.reset ( new CClientSettingsDlg ( pClient, pDlgParent, Qt::Window ) );
+
+        if ( !pClient->vecWindowPosSettings.isEmpty() && !pClient->vecWindowPosSettings.isNull() )
+        {
+            pClientSettingsDlg->restoreGeometry ( pClient->vecWindowPosSettings );
+        }
+
+        QObject::connect ( pClientSettingsDlg.get(), &CClientSettingsDlg::GUIDesignChanged,
+            this, &CClientDlg::OnGUIDesignChanged );
+
+        QObject::connect ( pClientSettingsDlg.get(), &CClientSettingsDlg::DisplayChannelLevelsChanged,
+            this, &CClientDlg::OnDisplayChannelLevelsChanged );
+
+        QObject::connect ( pClientSettingsDlg.get(), &CClientSettingsDlg::AudioChannelsChanged,
+            this, &CClientDlg::OnAudioChannelsChanged );
+
+        QObject::connect ( pClientSettingsDlg.get(), &CClientSettingsDlg::NewClientLevelChanged,
+            this, &CClientDlg::OnNewClientLevelChanged );
+
+        // the settings check box follows the visibility of the dialog
+        pClientSettingsDlg->installEventFilter ( this );
+    }
+
+    return *pClientSettingsDlg;
+}
+
+CChatDlg& CClientDlg::GetChatDlg()
+{
+    if ( !pChatDlg )
+    {
+        pChatDlg.reset ( new CChatDlg ( pDlgParent, Qt::Window ) );
+
+        if ( !pClient->vecWindowPosChat.isEmpty() && !pClient->vecWindowPosChat.isNull() )
+        {
+            pChatDlg->restoreGeometry ( pClient->vecWindowPosChat );
+        }
+
+        QObject::connect ( pChatDlg.get(), &CChatDlg::NewLocalInputText,
+            this, &CClientDlg::OnNewLocalInputText );
+
+        // the chat check box follows the visibility of the dialog
+        pChatDlg->installEventFilter ( this );
+    }
+
+    return *pChatDlg;
+}
+
+CConnectDlg& CClientDlg::GetConnectDlg()
+{
+    if ( !pConnectDlg )
+    {
+        pConnectDlg.reset ( new CConnectDlg ( pClient, bShowComplRegConnList, pDlgParent, Qt::Dialog ) );
+
+        if ( !pClient->vecWindowPosConnect.isEmpty() && !pClient->vecWindowPosConnect.isNull() )
+        {
+            pConnectDlg->restoreGeometry ( pClient->vecWindowPosConnect );
+        }
+
+        // the server list cache is stored next to the ini-file
+        pConnectDlg->SetShowAllMusicians ( pClient->bConnectDlgShowAllMusicians );
+
+        pConnectDlg->SetServerListCacheFileName (
+            QFileInfo ( pSettings->GetFileName() ).absolutePath() + "/" + DEFAULT_SERV_LIST_CACHE_FILE );
+
+        QObject::connect ( pConnectDlg.get(), &CConnectDlg::ReqServerListQuery,
+            this, &CClientDlg::OnReqServerListQuery );
+
+        QObject::connect ( pConnectDlg.get(), &CConnectDlg::ReqServerListPageQuery,
+            this, &CClientDlg::OnReqServerListPageQuery );
+
+        QObject::connect ( pConnectDlg.get(), &CConnectDlg::ReqServerListIPv6Query,
+            this, &CClientDlg::OnReqServerListIPv6Query );
+
+        // note that this connection must be a queued connection, otherwise the server list ping
+        // times are not accurate and the client list may not be retrieved for all servers listed
+        // (it seems the sendto() function needs to be called from different threads to fire the
+        // packet immediately and do not collect packets before transmitting)
+        QObject::connect ( pConnectDlg.get(), &CConnectDlg::CreateCLServerListPingMes,
+            this, &CClientDlg::OnCreateCLServerListPingMes, Qt::QueuedConnection );
+
+        QObject::connect ( pConnectDlg.get(), &CConnectDlg::CreateCLServerListReqVerAndOSMes,
+            this, &CClientDlg::OnCreateCLServerListReqVerAndOSMes );
+
+        QObject::connect ( pConnectDlg.get(), &CConnectDlg::CreateCLServerListReqConnClientsListMes,
+            this, &CClientDlg::OnCreateCLServerListReqConnClientsListMes );
+
+        QObject::connect ( pConnectDlg.get(), &CConnectDlg::accepted,
+            this, &CClientDlg::OnConnectDlgAccepted );
+    }
+
+    return *pConnectDlg;
+}
+
+CMusProfDlg& CClientDlg::GetMusicianProfileDlg()
+{
+    if ( !pMusicianProfileDlg )
+    {
+        pMusicianProfileDlg.reset ( new CMusProfDlg ( pClient, pDlgParent ) );
+
+        if ( !pClient->vecWindowPosProfile.isEmpty() && !pClient->vecWindowPosProfile.isNull() )
+        {
+            pMusicianProfileDlg->restoreGeometry ( pClient->vecWindowPosProfile );
+        }
+    }
+
+    return *pMusicianProfileDlg;
+}
+
 void CClientDlg::ShowConnectionSetupDialog()
 {
+    CConnectDlg& ConnectDlg = GetConnectDlg();
+
     // init the connect dialog
     ConnectDlg.Init ( pClient->vstrIPAddress );
     ConnectDlg.SetCentralServerAddress ( NetworkUtil::GetCentralServerAddress ( pClient->GetCentralServerAddressType(),
@@ -891,6 +1007,8 @@ void CClientDlg::ShowConnectionSetupDialog()
 
 void CClientDlg::ShowMusicianProfileDialog()
 {
+    CMusProfDlg& MusicianProfileDlg = GetMusicianProfileDlg();
+
     // show musician profile dialog
     MusicianProfileDlg.show();
 
@@ -901,6 +1019,8 @@ void CClientDlg::ShowMusicianProfileDialog()
 
 void CClientDlg::ShowGeneralSettings()
 {
+    CClientSettingsDlg& ClientSettingsDlg = GetClientSettingsDlg();
+
     // open general settings dialog
     ClientSettingsDlg.show();
 
@@ -911,6 +1031,8 @@ void CClientDlg::ShowGeneralSettings()
 
 void CClientDlg::ShowChatWindow ( const bool bForceRaise )
 {
+    CChatDlg& ChatDlg = GetChatDlg();
+
     // open chat dialog if it is not visible
     if ( bForceRaise || !ChatDlg.isVisible() )
     {
@@ -940,9 +1062,9 @@ void CClientDlg::OnSettingsStateChanged ( int value )
     {
         ShowGeneralSettings();
     }
-    else
+    else if ( pClientSettingsDlg )
     {
-        ClientSettingsDlg.hide();
+        pClientSettingsDlg->hide();
     }
 }
 
@@ -952,9 +1074,9 @@ void CClientDlg::OnChatStateChanged ( int value )
     {
         ShowChatWindow();
     }
-    else
+    else if ( pChatDlg )
     {
-        ChatDlg.hide();
+        pChatDlg->hide();
     }
 }
 
@@ -1006,13 +1128,50 @@ void CClientDlg::OnTimerBuffersLED()
 
     // update the buffer LED and the general settings dialog, too
     ledBuffers->SetLight ( eCurStatus );
-    ClientSettingsDlg.SetStatus ( eCurStatus );
+
+    if ( pClientSettingsDlg )
+    {
+        pClientSettingsDlg->SetStatus ( eCurStatus );
+    }
+
+    UpdateDspLoad();
+}
+
+void CClientDlg::UpdateDspLoad()
+{
+    const CClientDspLoad& DspLoad = pClient->GetDspLoad();
+    const double          dLoad   = DspLoad.GetLoad();
+    const double          dPeak   = DspLoad.GetPeak();
+
+    if ( dPeak >= 100 )
+    {
+        ledDspLoad->SetLight ( CMultiColorLED::RL_RED );
+    }
+    else if ( dPeak >= DSP_LOAD_WARNING_PERCENT )
+    {
+        ledDspLoad->SetLight ( CMultiColorLED::RL_YELLOW );
+    }
+    else
+    {
+        ledDspLoad->SetLight ( CMultiColorLED::RL_GREEN );
+    }
+
+    lblDspLoad->setText ( tr ( "DSP" ) + QString ( " %1 %" ).arg ( qRound ( dLoad ) ) );
+
+    ledDspLoad->setToolTip ( tr ( "DSP load %1 %, peak %2 %" ).
+        arg ( qRound ( dLoad ) ).arg ( qRound ( dPeak ) ) );
 }
 
 void CClientDlg::OnTimerPing()
 {
     // send ping message to the server
     pClient->CreateCLPingMes();
+
+    // the delay breakdown is only shown on the settings dialog
+    if ( IsDlgVisible ( pClientSettingsDlg.get() ) )
+    {
+        pClient->CreateCLLatencyProbeMes();
+    }
 }
 
 void CClientDlg::OnPingTimeResult ( int iPingTime )
@@ -1041,31 +1200,55 @@ void CClientDlg::OnPingTimeResult ( int iPingTime )
 
     // only update delay information on settings dialog if it is visible to
     // avoid CPU load on working thread if not necessary
-    if ( ClientSettingsDlg.isVisible() )
+    if ( IsDlgVisible ( pClientSettingsDlg.get() ) )
     {
         // set ping time result to general settings dialog
-        ClientSettingsDlg.SetPingTimeResult ( iPingTime,
-                                              iOverallDelayMs,
-                                              eOverallDelayLEDColor );
+        pClientSettingsDlg->SetPingTimeResult ( iPingTime,
+                                                iOverallDelayMs,
+                                                eOverallDelayLEDColor );
     }
 
     // update delay LED on the main window
     ledDelay->SetLight ( eOverallDelayLEDColor );
 }
 
+void CClientDlg::OnLatencyBreakdown ( CLatencyBreakdown Breakdown )
+{
+    if ( IsDlgVisible ( pClientSettingsDlg.get() ) )
+    {
+        pClientSettingsDlg->SetLatencyBreakdown ( Breakdown );
+    }
+}
+
 void CClientDlg::OnCLPingTimeWithNumClientsReceived ( CHostAddress InetAddr,
                                                       int          iPingTime,
                                                       int          iNumClients )
 {
     // update connection dialog server list
-    ConnectDlg.SetPingTimeAndNumClientsResult ( InetAddr,
-                                                iPingTime,
-                                                iNumClients );
+    if ( pConnectDlg )
+    {
+        pConnectDlg->SetPingTimeAndNumClientsResult ( InetAddr,
+                                                      iPingTime,
+                                                      iNumClients );
+    }
 }
 
 void CClientDlg::Connect ( const QString& strSelectedAddress,
                            const QString& strMixerBoardLabel )
 {
+    // the host name is looked up without blocking the GUI, the connection is
+    // started when its address is known
+    CHostAddress HostAddress;
+
+    if ( NetworkUtil::ParseNetworkAddressNonBlocking ( strSelectedAddress, HostAddress ) == NA_PENDING )
+    {
+        strPendingConnectAddress  = strSelectedAddress;
+        strPendingMixerBoardLabel = strMixerBoardLabel;
+        return;
+    }
+
+    strPendingConnectAddress.clear();
+
     // set address and check if address is valid
     if ( pClient->SetServerAddr ( strSelectedAddress ) )
     {
@@ -1093,14 +1276,23 @@ void CClientDlg::Connect ( const QString& strSelectedAddress,
         MainMixerBoard->SetServerName ( strMixerBoardLabel );
 
         // start timer for level meter bar and ping time measurement
-        TimerSigMet.start ( LEVELMETER_UPDATE_TIME_MS );
-        TimerBuffersLED.start ( BUFFER_LED_UPDATE_TIME_MS );
-        TimerPing.start ( PING_UPDATE_TIME_MS );
+        UpdateMeterTimers();
+    }
+}
+
+void CClientDlg::OnHostNameResolved ( QString )
+{
+    // the address of a pending connection may be in the cache now
+    if ( !strPendingConnectAddress.isEmpty() )
+    {
+        Connect ( strPendingConnectAddress, strPendingMixerBoardLabel );
     }
 }
 
 void CClientDlg::Disconnect()
 {
+    strPendingConnectAddress.clear();
+
     // only stop client if currently running, in case we received
     // the stopped message, the client is already stopped but the
     // connect/disconnect button and other GUI controls must be
@@ -1116,53 +1308,129 @@ void CClientDlg::Disconnect()
     // reset server name in audio mixer group box title
     MainMixerBoard->SetServerName ( "" );
 
-    // stop timer for level meter bars and reset them
-    TimerSigMet.stop();
+    // stop timers for level meter bars and reset them
+    UpdateMeterTimers();
     lbrInputLevelL->setValue ( 0 );
     lbrInputLevelR->setValue ( 0 );
 
-    // stop other timers
-    TimerBuffersLED.stop();
-    TimerPing.stop();
-
-
-// TODO is this still required???
-// immediately update status bar
-OnTimerStatus();
-
 
     // reset LEDs
     ledBuffers->Reset();
     ledDelay->Reset();
-    ClientSettingsDlg.ResetStatusAndPingLED();
+    ledDspLoad->Reset();
+    lblDspLoad->setText ( tr ( "DSP" ) );
+    if ( pClientSettingsDlg )
+    {
+        pClientSettingsDlg->ResetStatusAndPingLED();
+    }
 
     // clear mixer board (remove all faders)
     MainMixerBoard->HideAll();
 }
 
+void CClientDlg::showEvent ( QShowEvent* )
+{
+    // the visibility is evaluated after the event was processed
+    QMetaObject::invokeMethod ( this, "OnVisibilityChanged", Qt::QueuedConnection );
+}
+
+void CClientDlg::hideEvent ( QHideEvent* )
+{
+    QMetaObject::invokeMethod ( this, "OnVisibilityChanged", Qt::QueuedConnection );
+}
+
+void CClientDlg::changeEvent ( QEvent* Event )
+{
+    // the main window was minimized or restored
+    if ( Event->type() == QEvent::WindowStateChange )
+    {
+        QMetaObject::invokeMethod ( this, "OnVisibilityChanged", Qt::QueuedConnection );
+    }
+
+    QDialog::changeEvent ( Event );
+}
+
+bool CClientDlg::eventFilter ( QObject* pObject, QEvent* Event )
+{
+    // the settings or chat dialog was shown or hidden
+    if ( ( ( pObject == pClientSettingsDlg.get() ) || ( pObject == pChatDlg.get() ) ) &&
+         ( ( Event->type() == QEvent::Show ) || ( Event->type() == QEvent::Hide ) ) )
+    {
+        QMetaObject::invokeMethod ( this, "OnVisibilityChanged", Qt::QueuedConnection );
+    }
+
+    return QDialog::eventFilter ( pObject, Event );
+}
+
+void CClientDlg::UpdateMeterTimers()
+{
+    // The level meters, LEDs and the ping measurement are only updated if they
+    // can be seen (the status LED and the ping time are shown on the main window
+    // and on the settings dialog). This avoids that the GUI thread is woken up
+    // periodically while the main window is minimized or hidden.
+    const bool bMainWindowVisible = isVisible() && !isMinimized();
+    const bool bStatusVisible     = bMainWindowVisible || IsDlgVisible ( pClientSettingsDlg.get() );
+    const bool bIsRunning         = pClient->IsRunning();
+
+    if ( bIsRunning && bMainWindowVisible )
+    {
+        if ( !TimerSigMet.isActive() )
+        {
+            TimerSigMet.start ( LEVELMETER_UPDATE_TIME_MS );
+            OnTimerSigMet();
+        }
+    }
+    else
+    {
+        TimerSigMet.stop();
+    }
+
+    if ( bIsRunning && bStatusVisible )
+    {
+        if ( !TimerPing.isActive() )
+        {
+            TimerBuffersLED.start ( BUFFER_LED_UPDATE_TIME_MS );
+            TimerPing.start ( PING_UPDATE_TIME_MS );
+            OnTimerPing();
+        }
+    }
+    else
+    {
+        TimerBuffersLED.stop();
+        TimerPing.stop();
+    }
+
+    // the server does not need to send the channel levels if the mixer board
+    // is not visible
+    pClient->SetChannelLevelsPaused ( !bMainWindowVisible );
+}
+
 void CClientDlg::UpdateDisplay()
 {
     // update settings/chat buttons (do not fire signals since it is an update)
-    if ( chbSettings->isChecked() && !ClientSettingsDlg.isVisible() )
+    const bool bSettingsVisible = IsDlgVisible ( pClientSettingsDlg.get() );
+    const bool bChatVisible     = IsDlgVisible ( pChatDlg.get() );
+
+    if ( chbSettings->isChecked() && !bSettingsVisible )
     {
         chbSettings->blockSignals ( true );
         chbSettings->setChecked   ( false );
         chbSettings->blockSignals ( false );
     }
-    if ( !chbSettings->isChecked() && ClientSettingsDlg.isVisible() )
+    if ( !chbSettings->isChecked() && bSettingsVisible )
     {
         chbSettings->blockSignals ( true );
         chbSettings->setChecked   ( true );
         chbSettings->blockSignals ( false );
     }
 
-    if ( chbChat->isChecked() && !ChatDlg.isVisible() )
+    if ( chbChat->isChecked() && !bChatVisible )
     {
         chbChat->blockSignals ( true );
         chbChat->setChecked   ( false );
         chbChat->blockSignals ( false );
     }
-    if ( !chbChat->isChecked() && ChatDlg.isVisible() )
+    if ( !chbChat->isChecked() && bChatVisible )
     {
         chbChat->blockSignals ( true );
         chbChat->setChecked   ( true );
@@ -34,6 +34,7 @@
 #include <QMenuBar>
 #include <QLayout>
 #include <QMessageBox>
+#include <memory>
 #if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
 # include <QVersionNumber>
 #endif
@@ -55,10 +56,14 @@
 
 
 /* Definitions ****************************************************************/
-// update time for GUI controls
+// update time for GUI controls (the timers only run while the controls can
+// be seen)
 #define LEVELMETER_UPDATE_TIME_MS   100   // ms
 #define BUFFER_LED_UPDATE_TIME_MS   300   // ms
-#define LED_BAR_UPDATE_TIME_MS      1000  // ms
+
+// the DSP load LED is yellow if the peak load of a callback reaches this value
+// and red if a callback takes longer than the sound card block
+#define DSP_LOAD_WARNING_PERCENT    70    // %
 
 // number of ping times > upper bound until error message is shown
 #define NUM_HIGH_PINGS_UNTIL_ERROR  5
@@ -98,14 +103,23 @@ protected:
 
     bool               bConnected;
     bool               bConnectDlgWasShown;
+
+    // the connection waits for the asynchronous lookup of the host name
+    QString            strPendingConnectAddress;
+    QString            strPendingMixerBoardLabel;
     bool               bMIDICtrlUsed;
     QTimer             TimerSigMet;
     QTimer             TimerBuffersLED;
-    QTimer             TimerStatus;
     QTimer             TimerPing;
 
     virtual void       closeEvent ( QCloseEvent* Event );
+    virtual void       showEvent ( QShowEvent* Event );
+    virtual void       hideEvent ( QHideEvent* Event );
+    virtual void       changeEvent ( QEvent* Event );
+    virtual bool       eventFilter ( QObject* pObject, QEvent* Event );
     void               UpdateDisplay();
+    void               UpdateMeterTimers();
+    void               UpdateDspLoad();
 
     QMenu*             pViewMenu;
     QMenu*             pEditMenu;
@@ -113,11 +127,23 @@ protected:
     QMenu*             pInstrPictPopupMenu;
     QMenu*             pCountryFlagPopupMenu;
 
-    CClientSettingsDlg ClientSettingsDlg;
-    CChatDlg           ChatDlg;
-    CConnectDlg        ConnectDlg;
-    CAnalyzerConsole   AnalyzerConsole;
-    CMusProfDlg        MusicianProfileDlg;
+    // the secondary dialogs are created when they are needed for the first
+    // time (this shortens the startup), their settings are kept in the client
+    // object
+    CClientSettingsDlg& GetClientSettingsDlg();
+    CChatDlg&           GetChatDlg();
+    CConnectDlg&        GetConnectDlg();
+    CMusProfDlg&        GetMusicianProfileDlg();
+
+    static bool IsDlgVisible ( const QWidget* pDlg ) { return ( pDlg != nullptr ) && pDlg->isVisible(); }
+
+    QWidget*                            pDlgParent;
+    bool                                bShowComplRegConnList;
+    std::unique_ptr<CClientSettingsDlg> pClientSettingsDlg;
+    std::unique_ptr<CChatDlg>           pChatDlg;
+    std::unique_ptr<CConnectDlg>        pConnectDlg;
+    std::unique_ptr<CMusProfDlg>        pMusicianProfileDlg;
+    CAnalyzerConsole                    AnalyzerConsole;
 
 public slots:
     void OnAboutToQuit() { pSettings->Save(); }
@@ -126,10 +152,11 @@ public slots:
     void OnTimerSigMet();
     void OnTimerBuffersLED();
 
-    void OnTimerStatus() { UpdateDisplay(); }
+    void OnVisibilityChanged() { UpdateDisplay(); UpdateMeterTimers(); }
 
     void OnTimerPing();
     void OnPingTimeResult ( int iPingTime );
+    void OnLatencyBreakdown ( CLatencyBreakdown Breakdown );
     void OnCLPingTimeWithNumClientsReceived ( CHostAddress InetAddr,
                                               int          iPingTime,
                                               int          iNumClients );
@@ -145,7 +172,7 @@ public slots:
     void OnCLVersionAndOSReceived ( CHostAddress           InetAddr,
                                     COSUtil::EOpSystemType eOSType,
                                     QString                strVersion )
-        { ConnectDlg.SetVersionAndOSType ( InetAddr, eOSType, strVersion ); }
+        { if ( pConnectDlg ) { pConnectDlg->SetVersionAndOSType ( InetAddr, eOSType, strVersion ); } }
 #endif
 
     void OnOpenConnectionSetupDialog() { ShowConnectionSetupDialog(); }
@@ -181,12 +208,22 @@ public slots:
 	void OnChangeChanPan ( int iId, double dPan )
         { pClient->SetRemoteChanPan ( iId, dPan ); }
 
+    void OnChangeMixGroupGain ( int iMixGroup, double dGain )
+        { pClient->SetRemoteMixGroupGain ( iMixGroup, dGain ); }
+
     void OnNewLocalInputText ( QString strChatText )
         { pClient->CreateChatTextMes ( strChatText ); }
 
     void OnReqServerListQuery ( CHostAddress InetAddr )
         { pClient->CreateCLReqServerListMes ( InetAddr ); }
 
+    void OnReqServerListPageQuery ( CHostAddress InetAddr,
+                                    int          iPage )
+        { pClient->CreateCLReqServerListPageMes ( InetAddr, iPage ); }
+
+    void OnReqServerListIPv6Query ( CHostAddress InetAddr )
+        { pClient->CreateCLReqServerListIPv6Mes ( InetAddr ); }
+
     void OnCreateCLServerListPingMes ( CHostAddress InetAddr )
         { pClient->CreateCLServerListPingMes ( InetAddr ); }
 
@@ -198,11 +235,21 @@ public slots:
 
     void OnCLServerListReceived ( CHostAddress         InetAddr,
                                   CVector<CServerInfo> vecServerInfo )
-        { ConnectDlg.SetServerList ( InetAddr, vecServerInfo ); }
+        { if ( pConnectDlg ) { pConnectDlg->SetServerList ( InetAddr, vecServerInfo ); } }
+
+    void OnCLServerListPageReceived ( CHostAddress         InetAddr,
+                                      int                  iPage,
+                                      int                  iNumPages,
+                                      CVector<CServerInfo> vecServerInfo )
+        { if ( pConnectDlg ) { pConnectDlg->SetServerListPage ( InetAddr, iPage, iNumPages, vecServerInfo ); } }
+
+    void OnCLServerListIPv6Received ( CHostAddress         InetAddr,
+                                      CVector<CServerInfo> vecServerInfo )
+        { if ( pConnectDlg ) { pConnectDlg->SetServerListIPv6 ( InetAddr, vecServerInfo ); } }
 
     void OnCLConnClientsListMesReceived ( CHostAddress          InetAddr,
                                           CVector<CChannelInfo> vecChanInfo )
-        { ConnectDlg.SetConnClientsList ( InetAddr, vecChanInfo ); }
+        { if ( pConnectDlg ) { pConnectDlg->SetConnClientsList ( InetAddr, vecChanInfo ); } }
 
     void OnClientIDReceived ( int iChanID )
         { MainMixerBoard->SetMyChannelID ( iChanID ); }
@@ -215,6 +262,7 @@ public slots:
         { MainMixerBoard->SetChannelLevels ( vecLevelList ); }
 
     void OnConnectDlgAccepted();
+    void OnHostNameResolved ( QString );
     void OnDisconnected() { Disconnect(); }
     void OnCentralServerAddressTypeChanged();
     void OnGUIDesignChanged() { SetGUIDesign ( pClient->GetGUIDesign() ); }
@@ -225,6 +273,9 @@ public slots:
     void OnRecorderStateReceived ( ERecorderState eRecorderState )
         { MainMixerBoard->SetRecorderState ( eRecorderState ); }
 
+    void OnMixGroupListReceived ( CVector<int> vecMixGroups )
+        { MainMixerBoard->SetMixGroups ( vecMixGroups ); }
+
     void OnAudioChannelsChanged() { UpdateRevSelection(); }
     void OnNumClientsChanged ( int iNewNumClients );
     void OnNewClientLevelChanged() { MainMixerBoard->iNewClientFaderLevel = pClient->iNewClientFaderLevel; }
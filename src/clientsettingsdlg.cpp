@@ -75,6 +75,18 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
     sldNetBufServer->setToolTip        ( strJitterBufferSizeTT );
     chbAutoJitBuf->setAccessibleName   ( tr ( "Auto jitter buffer switch" ) );
     chbAutoJitBuf->setToolTip          ( strJitterBufferSizeTT );
+
+    // time stretching
+    chbTimeStretch->setWhatsThis ( "<b>" + tr ( "Time Stretching" ) + ":</b> " + tr (
+        "If enabled, short jitter buffer underruns are concealed by stretching the "
+        "received audio signal and the additional delay is removed again by slightly "
+        "compressing the signal as soon as the network allows it. This way the delay "
+        "is adapted in small steps instead of whole audio blocks, which results in less "
+        "audible dropouts and allows smaller jitter buffer sizes." ) + " " + tr (
+        "Additionally, the clock drift between the server and the sound card is "
+        "compensated by slightly resampling the received audio signal." ) );
+
+    chbTimeStretch->setAccessibleName ( tr ( "Time stretching check box" ) );
     ledNetw->setAccessibleName         ( tr ( "Jitter buffer status LED indicator" ) );
     ledNetw->setToolTip                ( strJitterBufferSizeTT );
 
@@ -130,6 +142,73 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
 
     chbEnableOPUS64->setAccessibleName ( tr ( "Enable small network buffers check box" ) );
 
+    // packet loss redundancy
+    chbRedundancy->setWhatsThis ( "<b>" + tr ( "Packet Loss Redundancy" ) + ":</b> " + tr (
+        "If enabled and supported by the server, each network packet additionally "
+        "carries a copy of the previous packet with a reduced audio quality. A single "
+        "lost packet is then replaced by this copy without increasing the jitter "
+        "buffer size. The network load increases by about one third." ) );
+
+    chbRedundancy->setAccessibleName ( tr ( "Packet loss redundancy check box" ) );
+
+    // direct monitoring
+    chbDirectMonitor->setWhatsThis ( "<b>" + tr ( "Direct Monitoring" ) + ":</b> " + tr (
+        "If enabled, your own signal is mixed directly into the sound card output "
+        "instead of being returned by the server. You hear yourself without the "
+        "network delay while the other musicians still hear you through the server. "
+        "Your fader in the mixer then controls the level of the local monitoring." ) );
+
+    chbDirectMonitor->setAccessibleName ( tr ( "Direct monitoring check box" ) );
+
+    // adaptive encoder settings
+    chbAdaptiveEncoder->setWhatsThis ( "<b>" + tr ( "Adaptive Encoder" ) + ":</b> " + tr (
+        "If enabled, the audio encoder settings are adjusted to the conditions: "
+        "if your computer has enough processing power left, a low audio quality "
+        "is encoded with more effort, if it is overloaded the effort is reduced, "
+        "and on a connection with packet loss the encoder is made more robust "
+        "against lost packets. The network load is not changed." ) );
+
+    chbAdaptiveEncoder->setAccessibleName ( tr ( "Adaptive encoder check box" ) );
+
+    // adaptive network packet size
+    chbAdaptiveAggregation->setWhatsThis ( "<b>" + tr ( "Adaptive Packet Size" ) + ":</b> " + tr (
+        "If enabled, more audio frames are combined in one network packet if "
+        "packets are lost on the connection (e.g. on a wireless network which "
+        "cannot handle the high packet rate). This increases the latency a bit. "
+        "If the connection is clean again, the packet size of the buffer size "
+        "setting is used again." ) );
+
+    chbAdaptiveAggregation->setAccessibleName ( tr ( "Adaptive packet size check box" ) );
+
+    // adaptive audio quality
+    chbAdaptiveQuality->setWhatsThis ( "<b>" + tr ( "Adaptive Audio Quality" ) + ":</b> " + tr (
+        "If enabled, the audio quality is reduced below the audio quality setting "
+        "if the connection is congested (audio packets are lost or the ping time "
+        "rises), so that the audio degrades gracefully instead of dropping out. "
+        "If the connection is clean again, the audio quality is raised step by "
+        "step up to the audio quality setting." ) );
+
+    chbAdaptiveQuality->setAccessibleName ( tr ( "Adaptive audio quality check box" ) );
+
+    // separate input streams
+    chbMultiStream->setWhatsThis ( "<b>" + tr ( "Separate Input Streams" ) + ":</b> " + tr (
+        "If enabled and supported by the server, the left and right input channels "
+        "are sent as two separate streams, e.g. for two microphones on one audio "
+        "interface. Each stream gets its own fader in the mixer of all musicians. "
+        "This is not possible in the stereo mode. The network load is doubled." ) );
+
+    chbMultiStream->setAccessibleName ( tr ( "Separate input streams check box" ) );
+
+    // local mixing
+    chbMultitrack->setWhatsThis ( "<b>" + tr ( "Local Mixing" ) + ":</b> " + tr (
+        "If enabled and supported by the server, the server forwards the audio "
+        "streams of the other musicians instead of one mix and the mix is done "
+        "locally with the faders of the mixer board. This saves the encoding at "
+        "the server but the download network load is increased for each "
+        "musician. Cannot be combined with the redundancy." ) );
+
+    chbMultitrack->setAccessibleName ( tr ( "Local mixing check box" ) );
+
     // sound card buffer delay
     QString strSndCrdBufDelay = "<b>" + tr ( "Sound Card Buffer Delay" ) + ":</b> " +
         tr ( "The buffer delay setting is a fundamental setting of this "
@@ -273,6 +352,19 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
     lblUpstream->setWhatsThis          ( strConnStats );
     lblUpstreamValue->setWhatsThis     ( strConnStats );
     ledOverallDelay->setWhatsThis      ( strConnStats );
+
+    // sound card timing
+    QString strSndCrdTiming = "<b>" + tr ( "Sound Card Timing" ) + ":</b> " + tr (
+        "The average time of the audio processing relative to the period of "
+        "the sound card buffer and the number of overruns (the processing took "
+        "longer than the period) and late callbacks (the sound card called "
+        "the processing at least one and a half periods after the previous "
+        "block). If overruns or late callbacks are counted, the dropouts are "
+        "caused by the sound card driver or the computer and not by the "
+        "network. The Analyzer Console shows the details." );
+
+    lblSndCrdTiming->setWhatsThis      ( strSndCrdTiming );
+    lblSndCrdTimingValue->setWhatsThis ( strSndCrdTiming );
     ledOverallDelay->setToolTip ( tr ( "If this LED indicator turns red, "
         "you will not have much fun using the " ) + APP_NAME +
         tr ( " software." ) + TOOLTIP_COM_END_TEXT );
@@ -292,6 +384,7 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
     lblPingTimeValue->setText     ( "---" );
     lblOverallDelayValue->setText ( "---" );
     lblUpstreamValue->setText     ( "---" );
+    lblSndCrdTimingValue->setText ( "---" );
     edtNewClientLevel->setValidator ( new QIntValidator ( 0, 100, this ) ); // % range from 0-100
 
 
@@ -345,6 +438,26 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
     // update enable small network buffers check box
     chbEnableOPUS64->setCheckState ( pClient->GetEnableOPUS64() ? Qt::Checked : Qt::Unchecked );
 
+    // time stretching check box
+    chbTimeStretch->setCheckState ( pClient->GetEnableTimeStretch() ? Qt::Checked : Qt::Unchecked );
+
+    // packet loss redundancy check box
+    chbRedundancy->setCheckState ( pClient->GetEnableRedundancy() ? Qt::Checked : Qt::Unchecked );
+
+    // direct monitoring check box
+    chbDirectMonitor->setCheckState ( pClient->GetEnableDirectMonitor() ? Qt::Checked : Qt::Unchecked );
+
+    // adaptive encoder check box
+    chbAdaptiveEncoder->setCheckState ( pClient->GetEnableAdaptiveEncoder() ? Qt::Checked : Qt::Unchecked );
+    chbAdaptiveAggregation->setCheckState ( pClient->GetEnableAdaptiveAggregation() ? Qt::Checked : Qt::Unchecked );
+    chbAdaptiveQuality->setCheckState ( pClient->GetEnableAdaptiveQuality() ? Qt::Checked : Qt::Unchecked );
+
+    // separate input streams check box
+    chbMultiStream->setCheckState ( pClient->GetEnableMultiStream() ? Qt::Checked : Qt::Unchecked );
+
+    // local mixing check box
+    chbMultitrack->setCheckState ( pClient->GetEnableMultitrack() ? Qt::Checked : Qt::Unchecked );
+
     // set text for sound card buffer delay radio buttons
     rbtBufferDelayPreferred->setText ( GenSndCrdBufferDelayString (
         FRAME_SIZE_FACTOR_PREFERRED * SYSTEM_FRAME_SIZE_SAMPLES ) );
@@ -386,6 +499,30 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
     QObject::connect ( chbEnableOPUS64, &QCheckBox::stateChanged,
         this, &CClientSettingsDlg::OnEnableOPUS64StateChanged );
 
+    QObject::connect ( chbTimeStretch, &QCheckBox::stateChanged,
+        this, &CClientSettingsDlg::OnTimeStretchStateChanged );
+
+    QObject::connect ( chbRedundancy, &QCheckBox::stateChanged,
+        this, &CClientSettingsDlg::OnRedundancyStateChanged );
+
+    QObject::connect ( chbDirectMonitor, &QCheckBox::stateChanged,
+        this, &CClientSettingsDlg::OnDirectMonitorStateChanged );
+
+    QObject::connect ( chbAdaptiveEncoder, &QCheckBox::stateChanged,
+        this, &CClientSettingsDlg::OnAdaptiveEncoderStateChanged );
+
+    QObject::connect ( chbAdaptiveAggregation, &QCheckBox::stateChanged,
+        this, &CClientSettingsDlg::OnAdaptiveAggregationStateChanged );
+
+    QObject::connect ( chbAdaptiveQuality, &QCheckBox::stateChanged,
+        this, &CClientSettingsDlg::OnAdaptiveQualityStateChanged );
+
+    QObject::connect ( chbMultiStream, &QCheckBox::stateChanged,
+        this, &CClientSettingsDlg::OnMultiStreamStateChanged );
+
+    QObject::connect ( chbMultitrack, &QCheckBox::stateChanged,
+        this, &CClientSettingsDlg::OnMultitrackStateChanged );
+
     // line edits
     QObject::connect ( edtCentralServerAddress, &QLineEdit::editingFinished,
         this, &CClientSettingsDlg::OnCentralServerAddressEditingFinished );
@@ -427,10 +564,7 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
         static_cast<void (QButtonGroup::*) ( QAbstractButton* )> ( &QButtonGroup::buttonClicked ),
         this, &CClientSettingsDlg::OnSndCrdBufferDelayButtonGroupClicked );
 
-
-    // Timers ------------------------------------------------------------------
-    // start timer for status bar
-    TimerStatus.start ( DISPLAY_UPDATE_TIME );
+    // note that the status timer is started when the dialog is shown
 }
 
 void CClientSettingsDlg::UpdateJitterBufferFrame()
@@ -655,6 +789,49 @@ void CClientSettingsDlg::OnEnableOPUS64StateChanged ( int value )
     UpdateDisplay();
 }
 
+void CClientSettingsDlg::OnTimeStretchStateChanged ( int value )
+{
+    pClient->SetEnableTimeStretch ( value == Qt::Checked );
+}
+
+void CClientSettingsDlg::OnRedundancyStateChanged ( int value )
+{
+    pClient->SetEnableRedundancy ( value == Qt::Checked );
+    UpdateDisplay();
+}
+
+void CClientSettingsDlg::OnDirectMonitorStateChanged ( int value )
+{
+    pClient->SetEnableDirectMonitor ( value == Qt::Checked );
+}
+
+void CClientSettingsDlg::OnAdaptiveEncoderStateChanged ( int value )
+{
+    pClient->SetEnableAdaptiveEncoder ( value == Qt::Checked );
+}
+
+void CClientSettingsDlg::OnAdaptiveAggregationStateChanged ( int value )
+{
+    pClient->SetEnableAdaptiveAggregation ( value == Qt::Checked );
+}
+
+void CClientSettingsDlg::OnAdaptiveQualityStateChanged ( int value )
+{
+    pClient->SetEnableAdaptiveQuality ( value == Qt::Checked );
+}
+
+void CClientSettingsDlg::OnMultiStreamStateChanged ( int value )
+{
+    pClient->SetEnableMultiStream ( value == Qt::Checked );
+    UpdateDisplay();
+}
+
+void CClientSettingsDlg::OnMultitrackStateChanged ( int value )
+{
+    pClient->SetEnableMultitrack ( value == Qt::Checked );
+    UpdateDisplay();
+}
+
 void CClientSettingsDlg::OnDisplayChannelLevelsStateChanged ( int value )
 {
     pClient->SetDisplayChannelLevels ( value != Qt::Unchecked );
@@ -724,6 +901,23 @@ void CClientSettingsDlg::SetPingTimeResult ( const int                         i
     ledOverallDelay->SetLight ( eOverallDelayLEDColor );
 }
 
+void CClientSettingsDlg::SetLatencyBreakdown ( const CLatencyBreakdown& Breakdown )
+{
+    // the measured delays of the stages are shown as the tool tip of the
+    // overall delay
+    const QString strEstimated = Breakdown.bSoundCardMeasured ? "" : " " + tr ( "(estimated)" );
+
+    lblOverallDelayValue->setToolTip (
+        tr ( "Capture" ) + QString ( ": %1 ms" ).arg ( Breakdown.dCaptureMs, 0, 'f', 1 ) + strEstimated + "<br>" +
+        tr ( "Client buffer" ) + QString ( ": %1 ms" ).arg ( Breakdown.dClientBufferMs, 0, 'f', 1 ) + "<br>" +
+        tr ( "Network up" ) + QString ( ": %1 ms" ).arg ( Breakdown.dNetworkUpMs, 0, 'f', 1 ) + "<br>" +
+        tr ( "Server queue" ) + QString ( ": %1 ms" ).arg ( Breakdown.dServerQueueMs, 0, 'f', 1 ) + "<br>" +
+        tr ( "Mix" ) + QString ( ": %1 ms" ).arg ( Breakdown.dMixMs, 0, 'f', 1 ) + "<br>" +
+        tr ( "Network down" ) + QString ( ": %1 ms" ).arg ( Breakdown.dNetworkDownMs, 0, 'f', 1 ) + "<br>" +
+        tr ( "Playout" ) + QString ( ": %1 ms" ).arg ( Breakdown.dPlayoutMs, 0, 'f', 1 ) + strEstimated + "<br>" +
+        "<b>" + tr ( "Total" ) + QString ( ": %1 ms" ).arg ( Breakdown.GetOverallMs(), 0, 'f', 1 ) + "</b>" );
+}
+
 void CClientSettingsDlg::UpdateDisplay()
 {
     // update slider controls (settings might have been changed)
@@ -736,11 +930,28 @@ void CClientSettingsDlg::UpdateDisplay()
         lblPingTimeValue->setText     ( "---" );
         lblOverallDelayValue->setText ( "---" );
         lblUpstreamValue->setText     ( "---" );
+        lblSndCrdTimingValue->setText ( "---" );
     }
     else
     {
         // update upstream rate information label (only if client is running)
         lblUpstreamValue->setText (
             QString().setNum ( pClient->GetUploadRateKbps() ) + " kbps" );
+
+        // the late callbacks are in the histogram bins of 1.5 periods and more
+        CSndCrdTimingStats TimingStats;
+        pClient->GetSndCrdTimingStats ( TimingStats );
+
+        int iNumLate = 0;
+
+        for ( int i = 3; i < SND_CRD_TIMING_NUM_HIST_BINS; i++ )
+        {
+            iNumLate += TimingStats.veciIntervalHist[i];
+        }
+
+        lblSndCrdTimingValue->setText (
+            QString::number ( TimingStats.iAvProcTimeUs / 1000.0, 'f', 2 ) + " / " +
+            QString::number ( TimingStats.iPeriodUs / 1000.0, 'f', 2 ) + " ms, " +
+            tr ( "%1 overruns, %2 late" ).arg ( TimingStats.iNumOverruns ).arg ( iNumLate ) );
     }
 }
@@ -68,6 +68,8 @@ public:
                              const int                         iOverallDelayMs,
                              const CMultiColorLED::ELightColor eOverallDelayLEDColor );
 
+    void SetLatencyBreakdown ( const CLatencyBreakdown& Breakdown );
+
     void UpdateDisplay();
 
 protected:
@@ -77,7 +79,9 @@ protected:
     QString GenSndCrdBufferDelayString ( const int iFrameSize,
                                          const QString strAddText = "" );
 
-    virtual void showEvent ( QShowEvent* ) { UpdateDisplay(); }
+    // the status is only updated while the dialog is visible
+    virtual void showEvent ( QShowEvent* ) { UpdateDisplay(); TimerStatus.start ( DISPLAY_UPDATE_TIME ); }
+    virtual void hideEvent ( QHideEvent* ) { TimerStatus.stop(); }
 
     CClient*     pClient;
     QTimer       TimerStatus;
@@ -90,6 +94,14 @@ protected:
     void OnAutoJitBufStateChanged ( int value );
     void OnDisplayChannelLevelsStateChanged ( int value );
     void OnEnableOPUS64StateChanged ( int value );
+    void OnTimeStretchStateChanged ( int value );
+    void OnRedundancyStateChanged ( int value );
+    void OnDirectMonitorStateChanged ( int value );
+    void OnAdaptiveEncoderStateChanged ( int value );
+    void OnAdaptiveAggregationStateChanged ( int value );
+    void OnAdaptiveQualityStateChanged ( int value );
+    void OnMultiStreamStateChanged ( int value );
+    void OnMultitrackStateChanged ( int value );
     void OnCentralServerAddressEditingFinished();
     void OnNewClientLevelEditingFinished();
     void OnSndCrdBufferDelayButtonGroupClicked ( QAbstractButton* button );
@@ -26,6 +26,175 @@
 
 
 /* Implementation *************************************************************/
+bool CServerListCache::GetServerList ( const QString&   strCentralServerAddress,
+                                       QVector<CEntry>& vecEntries )
+{
+    if ( !bIsLoaded )
+    {
+        Load();
+    }
+
+    QMap<QString, CList>::const_iterator it = Lists.constFind ( strCentralServerAddress );
+
+    // an outdated list is not shown anymore
+    if ( ( it == Lists.constEnd() ) ||
+         ( QDateTime::currentMSecsSinceEpoch() - it->iTimeStampMs >
+           static_cast<qint64> ( SERV_LIST_CACHE_MAX_AGE_DAYS ) * 24 * 60 * 60 * 1000 ) )
+    {
+        return false;
+    }
+
+    vecEntries = it->vecEntries;
+    return true;
+}
+
+void CServerListCache::SetServerList ( const QString&         strCentralServerAddress,
+                                       const QVector<CEntry>& vecEntries )
+{
+    if ( !bIsLoaded )
+    {
+        Load();
+    }
+
+    CList& CurList       = Lists[strCentralServerAddress];
+    CurList.iTimeStampMs = QDateTime::currentMSecsSinceEpoch();
+    CurList.vecEntries   = vecEntries;
+
+    // remove the oldest list if we have too many lists
+    while ( Lists.size() > SERV_LIST_CACHE_MAX_NUM_LISTS )
+    {
+        QMap<QString, CList>::iterator itOldest = Lists.begin();
+
+        for ( QMap<QString, CList>::iterator it = Lists.begin(); it != Lists.end(); ++it )
+        {
+            if ( it->iTimeStampMs < itOldest->iTimeStampMs )
+            {
+                itOldest = it;
+            }
+        }
+
+        Lists.erase ( itOldest );
+    }
+}
+
+void CServerListCache::Load()
+{
+    bIsLoaded = true;
+    Lists.clear();
+
+    QFile file ( strFileName );
+
+    if ( strFileName.isEmpty() || !file.open ( QIODevice::ReadOnly ) )
+    {
+        return;
+    }
+
+    QDataStream in ( &file );
+    in.setVersion ( QDataStream::Qt_4_6 );
+
+    quint32 iMagic, iVersion, iNumLists;
+    in >> iMagic >> iVersion >> iNumLists;
+
+    // a file with an unknown format is ignored (it is overwritten on the next
+    // save)
+    if ( ( in.status() != QDataStream::Ok ) ||
+         ( iMagic != SERV_LIST_CACHE_MAGIC ) ||
+         ( iVersion != SERV_LIST_CACHE_VERSION ) ||
+         ( iNumLists > SERV_LIST_CACHE_MAX_NUM_LISTS ) )
+    {
+        return;
+    }
+
+    for ( quint32 iList = 0; iList < iNumLists; iList++ )
+    {
+        QString strCentralServerAddress;
+        CList   NewList;
+        quint32 iNumEntries;
+
+        in >> strCentralServerAddress >> NewList.iTimeStampMs >> iNumEntries;
+
+        if ( ( in.status() != QDataStream::Ok ) ||
+             ( iNumEntries > static_cast<quint32> ( 100 * MAX_NUM_SERVERS_IN_SERVER_LIST ) ) )
+        {
+            Lists.clear();
+            return;
+        }
+
+        for ( quint32 iEntry = 0; iEntry < iNumEntries; iEntry++ )
+        {
+            CEntry  NewEntry;
+            QString strHostAddress;
+            qint32  iCountry, iMaxNumClients, iPingTime, iNumClients;
+            bool    bPermanentOnline;
+
+            in >> strHostAddress >> NewEntry.ServerInfo.strName >> NewEntry.ServerInfo.strCity >>
+                iCountry >> iMaxNumClients >> bPermanentOnline >> iPingTime >> iNumClients;
+
+            if ( in.status() != QDataStream::Ok )
+            {
+                Lists.clear();
+                return;
+            }
+
+            // the host addresses are stored as IP numbers, i.e. no name
+            // resolution is required here
+            if ( NetworkUtil::ParseNetworkAddress ( strHostAddress, NewEntry.ServerInfo.HostAddr ) )
+            {
+                NewEntry.ServerInfo.eCountry         = static_cast<QLocale::Country> ( iCountry );
+                NewEntry.ServerInfo.iMaxNumClients   = iMaxNumClients;
+                NewEntry.ServerInfo.bPermanentOnline = bPermanentOnline;
+                NewEntry.iPingTime                   = iPingTime;
+                NewEntry.iNumClients                 = iNumClients;
+
+                NewList.vecEntries.append ( NewEntry );
+            }
+        }
+
+        Lists.insert ( strCentralServerAddress, NewList );
+    }
+}
+
+void CServerListCache::Save()
+{
+    // nothing to do if the cache was never used
+    if ( !bIsLoaded || strFileName.isEmpty() )
+    {
+        return;
+    }
+
+    QFile file ( strFileName );
+
+    if ( !file.open ( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        return;
+    }
+
+    QDataStream out ( &file );
+    out.setVersion ( QDataStream::Qt_4_6 );
+
+    out << static_cast<quint32> ( SERV_LIST_CACHE_MAGIC ) <<
+           static_cast<quint32> ( SERV_LIST_CACHE_VERSION ) <<
+           static_cast<quint32> ( Lists.size() );
+
+    for ( QMap<QString, CList>::const_iterator it = Lists.constBegin(); it != Lists.constEnd(); ++it )
+    {
+        out << it.key() << it->iTimeStampMs << static_cast<quint32> ( it->vecEntries.size() );
+
+        foreach ( const CEntry& CurEntry, it->vecEntries )
+        {
+            out << CurEntry.ServerInfo.HostAddr.toString() <<
+                   CurEntry.ServerInfo.strName <<
+                   CurEntry.ServerInfo.strCity <<
+                   static_cast<qint32> ( CurEntry.ServerInfo.eCountry ) <<
+                   static_cast<qint32> ( CurEntry.ServerInfo.iMaxNumClients ) <<
+                   CurEntry.ServerInfo.bPermanentOnline <<
+                   static_cast<qint32> ( CurEntry.iPingTime ) <<
+                   static_cast<qint32> ( CurEntry.iNumClients );
+        }
+    }
+}
+
+
 CConnectDlg::CConnectDlg ( CClient*        pNCliP,
                            const bool      bNewShowCompleteRegList,
                            QWidget*        parent,
@@ -35,9 +204,19 @@ CConnectDlg::CConnectDlg ( CClient*        pNCliP,
       strCentralServerAddress  ( "" ),
       strSelectedAddress       ( "" ),
       strSelectedServerName    ( "" ),
+      iSelectedPingJitterMs    ( -1 ),
       bShowCompleteRegList     ( bNewShowCompleteRegList ),
       bServerListReceived      ( false ),
+      bIPv6ServerListReceived  ( false ),
+      bUsePagedServerList      ( true ),
+      iNextServerListPage      ( 0 ),
+      iNumServerListPages      ( 0 ),
+      bServerListFromCache     ( false ),
+      iNumReceivedServers      ( 0 ),
+      dPingTokens              ( PING_SCHED_BURST ),
+      iLastPingTokenRefillMs   ( 0 ),
       bServerListItemWasChosen ( false ),
+      bListSortPending         ( false ),
       bListFilterWasActive     ( false ),
       bShowAllMusicians        ( true )
 {
@@ -184,11 +363,21 @@ CConnectDlg::CConnectDlg ( CClient*        pNCliP,
         this, &CConnectDlg::OnConnectClicked );
 
     // timers
+    PingSchedClock.start();
+
     QObject::connect ( &TimerPing, &QTimer::timeout,
         this, &CConnectDlg::OnTimerPing );
 
     QObject::connect ( &TimerReRequestServList, &QTimer::timeout,
         this, &CConnectDlg::OnTimerReRequestServList );
+
+    QObject::connect ( &CHostNameResolver::Instance(), &CHostNameResolver::HostNameResolved,
+        this, &CConnectDlg::OnHostNameResolved );
+
+    TimerListUpdate.setSingleShot ( true );
+
+    QObject::connect ( &TimerListUpdate, &QTimer::timeout,
+        this, &CConnectDlg::OnTimerListUpdate );
 }
 
 void CConnectDlg::Init ( const CVector<QString>& vstrIPAddresses )
@@ -215,17 +404,32 @@ void CConnectDlg::showEvent ( QShowEvent* )
 
 void CConnectDlg::RequestServerList()
 {
+    // the current list (and its ping results) is kept in the server list
+    // cache before the list view is cleared
+    StoreServerListInCache();
+
     // reset flags
     bServerListReceived      = false;
+    bIPv6ServerListReceived  = false;
     bServerListItemWasChosen = false;
     bListFilterWasActive     = false;
 
+    // we first try the paged query, if the central server does not answer it
+    // (old central server) we fall back to the complete list
+    bUsePagedServerList = true;
+    iNextServerListPage = 0;
+    iNumServerListPages = 0;
+
     // clear current address and name
     strSelectedAddress    = "";
     strSelectedServerName = "";
 
     // clear server list view
-    lvwServers->clear();
+    ClearServerList();
+
+    strServerListCentralServerAddress = strCentralServerAddress;
+    bServerListFromCache              = false;
+    iNumReceivedServers               = 0;
 
     // clear filter edit box
     edtFilter->setText ( "" );
@@ -235,14 +439,24 @@ void CConnectDlg::RequestServerList()
     cbxCentServAddrType->setCurrentIndex ( static_cast<int> ( pClient->GetCentralServerAddressType() ) );
     cbxCentServAddrType->blockSignals ( false );
 
-    // get the IP address of the central server (using the ParseNetworAddress
-    // function) when the connect dialog is opened, this seems to be the correct
-    // time to do it
-    if ( NetworkUtil().ParseNetworkAddress ( strCentralServerAddress,
-                                             CentralServerAddress ) )
+    // show the cached server list of this central server until the new list
+    // is received
+    ShowCachedServerList();
+
+    // get the IP address of the central server when the connect dialog is
+    // opened, this seems to be the correct time to do it
+    RequestServerList();
+}
+
+void CConnectDlg::RequestServerList()
+{
+    // the host name of the central server is looked up without blocking the
+    // GUI, the request is sent when the address is known
+    if ( NetworkUtil::ParseNetworkAddressNonBlocking ( strCentralServerAddress,
+                                                       CentralServerAddress ) == NA_OK )
     {
         // send the request for the server list
-        emit ReqServerListQuery ( CentralServerAddress );
+        emit ReqServerListPageQuery ( CentralServerAddress, 0 );
 
         // start timer, if this message did not get any respond to retransmit
         // the server list request message
@@ -255,6 +469,21 @@ void CConnectDlg::hideEvent ( QHideEvent* )
     // if window is closed, stop timers
     TimerPing.stop();
     TimerReRequestServList.stop();
+    TimerListUpdate.stop();
+
+    // store the current server list for the next time the dialog is opened
+    StoreServerListInCache();
+    ServerListCache.Save();
+}
+
+void CConnectDlg::OnHostNameResolved ( QString )
+{
+    // the request timer is started as soon as the address of the central
+    // server is known
+    if ( isVisible() && !bServerListReceived && !TimerReRequestServList.isActive() )
+    {
+        RequestServerList();
+    }
 }
 
 void CConnectDlg::OnTimerReRequestServList()
@@ -265,7 +494,19 @@ void CConnectDlg::OnTimerReRequestServList()
     {
         // note that this is a connection less message which may get lost
         // and therefore it makes sense to re-transmit it
-        emit ReqServerListQuery ( CentralServerAddress );
+        if ( bUsePagedServerList && ( iNextServerListPage > 0 ) )
+        {
+            // request the missing page again
+            emit ReqServerListPageQuery ( CentralServerAddress, iNextServerListPage );
+        }
+        else
+        {
+            // the first page did not arrive, maybe the central server does
+            // not support the paged query: request the complete list (which
+            // is also answered by a new central server)
+            bUsePagedServerList = false;
+            emit ReqServerListQuery ( CentralServerAddress );
+        }
     }
 }
 
@@ -276,12 +517,101 @@ void CConnectDlg::SetServerList ( const CHostAddress&         InetAddr,
     bServerListReceived = true;
     TimerReRequestServList.stop();
 
-    // first clear list
-    lvwServers->clear();
+    // update the list: servers which are not in the new list are removed
+    MarkServerListItemsStale();
 
     // add list item for each server in the server list
+    AddServerListItems ( InetAddr, vecServerInfo, true );
+
+    RemoveStaleServerListItems();
+
+    // the IPv6 servers are not part of the list (an old central server does
+    // not answer this request)
+    emit ReqServerListIPv6Query ( CentralServerAddress );
+
+    // immediately issue the ping measurements and start the ping timer since
+    // the server list is filled now
+    OnTimerPing();
+    TimerPing.start ( PING_SCHED_TICK_MS );
+}
+
+void CConnectDlg::SetServerListPage ( const CHostAddress&         InetAddr,
+                                      const int                   iPage,
+                                      const int                   iNumPages,
+                                      const CVector<CServerInfo>& vecServerInfo )
+{
+    // ignore pages which we did not request (e.g., a duplicate page or the
+    // answer to a query which was re-transmitted)
+    if ( bServerListReceived || !bUsePagedServerList || ( iPage != iNextServerListPage ) )
+    {
+        return;
+    }
+
+    if ( iPage == 0 )
+    {
+        // the servers which are not part of any page are removed after the
+        // last page was received
+        MarkServerListItemsStale();
+        iNumServerListPages = iNumPages;
+    }
+
+    AddServerListItems ( InetAddr, vecServerInfo, iPage == 0 );
+    iNextServerListPage++;
+
+    if ( iNextServerListPage < iNumServerListPages )
+    {
+        // request the next page and restart the re-request timer
+        emit ReqServerListPageQuery ( CentralServerAddress, iNextServerListPage );
+        TimerReRequestServList.start ( SERV_LIST_REQ_UPDATE_TIME_MS );
+    }
+    else
+    {
+        bServerListReceived = true;
+        TimerReRequestServList.stop();
+
+        RemoveStaleServerListItems();
+
+        // the IPv6 servers are not part of the pages
+        emit ReqServerListIPv6Query ( CentralServerAddress );
+    }
+
+    // immediately ping the servers of this page (the scheduler pings the
+    // new servers first)
+    OnTimerPing();
+
+    if ( iPage == 0 )
+    {
+        TimerPing.start ( PING_SCHED_TICK_MS );
+    }
+}
+
+void CConnectDlg::SetServerListIPv6 ( const CHostAddress&         InetAddr,
+                                      const CVector<CServerInfo>& vecServerInfo )
+{
+    // the IPv6 servers are only added once after the complete server list was
+    // received (a duplicate answer is ignored)
+    if ( !bServerListReceived || bIPv6ServerListReceived )
+    {
+        return;
+    }
+
+    bIPv6ServerListReceived = true;
+
+    AddServerListItems ( InetAddr, vecServerInfo, false );
+
+    // immediately ping the new servers
+    OnTimerPing();
+}
+
+void CConnectDlg::AddServerListItems ( const CHostAddress&         InetAddr,
+                                       const CVector<CServerInfo>& vecServerInfo,
+                                       const bool                  bFirstIsCentralServer )
+{
     const int iServerInfoLen = vecServerInfo.Size();
 
+    // do not repaint the list for each new item
+    lvwServers->setUpdatesEnabled ( false );
+
     for ( int iIdx = 0; iIdx < iServerInfoLen; iIdx++ )
     {
         // get the host address, note that for the very first entry which is
@@ -289,7 +619,7 @@ void CConnectDlg::SetServerList ( const CHostAddress&         InetAddr,
         // instead
         CHostAddress CurHostAddress;
 
-        if ( iIdx > 0 )
+        if ( ( iIdx > 0 ) || !bFirstIsCentralServer )
         {
             CurHostAddress = vecServerInfo[iIdx].HostAddr;
         }
@@ -299,20 +629,50 @@ void CConnectDlg::SetServerList ( const CHostAddress&         InetAddr,
             CurHostAddress = InetAddr;
         }
 
-        // create new list view item
-        QTreeWidgetItem* pNewListViewItem = new QTreeWidgetItem ( lvwServers );
+        // a server which is already in the list (e.g., from the server list
+        // cache) is updated and keeps its ping results
+        QTreeWidgetItem* pCurListViewItem = FindListViewItem ( CurHostAddress );
 
-        // make the entry invisible (will be set to visible on successful ping
-        // result) if the complete list of registered servers shall not be shown
-        if ( !bShowCompleteRegList )
+        if ( pCurListViewItem )
         {
-            pNewListViewItem->setHidden ( true );
+            StaleListViewItems.remove ( CurHostAddress.toString() );
+        }
+        else
+        {
+            // create new list view item
+            pCurListViewItem = new QTreeWidgetItem ( lvwServers );
+
+            // make the entry invisible (will be set to visible on successful ping
+            // result) if the complete list of registered servers shall not be shown
+            if ( !bShowCompleteRegList )
+            {
+                pCurListViewItem->setHidden ( true );
+            }
+
+            // the ping time shall be shown in bold font
+            QFont CurPingTimeFont = pCurListViewItem->font ( 1 );
+            CurPingTimeFont.setBold ( true );
+            pCurListViewItem->setFont ( 1, CurPingTimeFont );
+
+            // init the minimum ping time with a large number (note that this number
+            // must fit in an integer type)
+            pCurListViewItem->setText ( 4, "99999999" );
+
+            // store host address
+            pCurListViewItem->setData ( 0, Qt::UserRole, CurHostAddress.toString() );
+            ListViewItemIndex.insert ( CurHostAddress.toString(), pCurListViewItem );
+
+            // per default expand the list item (if not "show all servers")
+            if ( bShowAllMusicians )
+            {
+                lvwServers->expandItem ( pCurListViewItem );
+            }
         }
 
         // server name (if empty, show host address instead)
         if ( !vecServerInfo[iIdx].strName.isEmpty() )
         {
-            pNewListViewItem->setText ( 0, vecServerInfo[iIdx].strName );
+            pCurListViewItem->setText ( 0, vecServerInfo[iIdx].strName );
         }
         else
         {
@@ -322,30 +682,27 @@ void CConnectDlg::SetServerList ( const CHostAddress&         InetAddr,
             if ( vecServerInfo[iIdx].HostAddr.iPort == DEFAULT_PORT_NUMBER )
             {
                 // only show IP number, no port number
-                pNewListViewItem->setText ( 0, CurHostAddress.toString ( CHostAddress::SM_IP_NO_LAST_BYTE ) );
+                pCurListViewItem->setText ( 0, CurHostAddress.toString ( CHostAddress::SM_IP_NO_LAST_BYTE ) );
             }
             else
             {
                 // show IP number and port
-                pNewListViewItem->setText ( 0, CurHostAddress.toString ( CHostAddress::SM_IP_NO_LAST_BYTE_PORT ) );
+                pCurListViewItem->setText ( 0, CurHostAddress.toString ( CHostAddress::SM_IP_NO_LAST_BYTE_PORT ) );
             }
         }
 
         // in case of all servers shown, add the registration number at the beginning
+        iNumReceivedServers++;
+
         if ( bShowCompleteRegList )
         {
-            pNewListViewItem->setText ( 0, QString ( "%1: " ).arg ( 1 + iIdx, 3 ) + pNewListViewItem->text ( 0 ) );
+            pCurListViewItem->setText ( 0, QString ( "%1: " ).arg ( iNumReceivedServers, 3 ) + pCurListViewItem->text ( 0 ) );
         }
 
         // show server name in bold font if it is a permanent server
-        QFont CurServerNameFont = pNewListViewItem->font ( 0 );
+        QFont CurServerNameFont = pCurListViewItem->font ( 0 );
         CurServerNameFont.setBold ( vecServerInfo[iIdx].bPermanentOnline );
-        pNewListViewItem->setFont ( 0, CurServerNameFont );
-
-        // the ping time shall be shown in bold font
-        QFont CurPingTimeFont = pNewListViewItem->font ( 1 );
-        CurPingTimeFont.setBold ( true );
-        pNewListViewItem->setFont ( 1, CurPingTimeFont );
+        pCurListViewItem->setFont ( 0, CurServerNameFont );
 
         // server location (city and country)
         QString strLocation = vecServerInfo[iIdx].strCity;
@@ -379,29 +736,146 @@ void CConnectDlg::SetServerList ( const CHostAddress&         InetAddr,
             strLocation += strCountryToString;
         }
 
-        pNewListViewItem->setText ( 3, strLocation );
-
-        // init the minimum ping time with a large number (note that this number
-        // must fit in an integer type)
-        pNewListViewItem->setText ( 4, "99999999" );
+        pCurListViewItem->setText ( 3, strLocation );
 
         // store the maximum number of clients
-        pNewListViewItem->setText ( 5, QString().setNum ( vecServerInfo[iIdx].iMaxNumClients ) );
+        pCurListViewItem->setText ( 5, QString().setNum ( vecServerInfo[iIdx].iMaxNumClients ) );
+
+        // keep the server info for the server list cache
+        CServerInfo CurServerInfo = vecServerInfo[iIdx];
+        CurServerInfo.HostAddr    = CurHostAddress;
+        ServerInfoIndex.insert ( CurHostAddress.toString(), CurServerInfo );
+    }
+
+    lvwServers->setUpdatesEnabled ( true );
+}
+
+void CConnectDlg::ClearServerList()
+{
+    lvwServers->clear();
+    ListViewItemIndex.clear();
+    ServerInfoIndex.clear();
+    StaleListViewItems.clear();
+    ClearPingSchedule();
+
+    bListSortPending = false;
+    TimerListUpdate.stop();
+}
+
+void CConnectDlg::MarkServerListItemsStale()
+{
+    // all current items are stale until they are part of the received list
+    StaleListViewItems.clear();
+
+    foreach ( const QString& strAddress, ListViewItemIndex.keys() )
+    {
+        StaleListViewItems.insert ( strAddress );
+    }
+
+    iNumReceivedServers = 0;
+}
+
+void CConnectDlg::RemoveStaleServerListItems()
+{
+    foreach ( const QString& strAddress, StaleListViewItems )
+    {
+        delete ListViewItemIndex.take ( strAddress );
+        ServerInfoIndex.remove ( strAddress );
+        PingSchedule.remove ( strAddress );
+    }
+
+    StaleListViewItems.clear();
+}
+
+void CConnectDlg::ShowCachedServerList()
+{
+    QVector<CServerListCache::CEntry> vecEntries;
+
+    // the complete list of registered servers is not cached since it shall
+    // show the registrations of the central server only
+    if ( bShowCompleteRegList ||
+         !ServerListCache.GetServerList ( strServerListCentralServerAddress, vecEntries ) )
+    {
+        return;
+    }
+
+    CVector<CServerInfo> vecServerInfo ( vecEntries.size() );
+
+    for ( int iIdx = 0; iIdx < vecEntries.size(); iIdx++ )
+    {
+        vecServerInfo[iIdx] = vecEntries[iIdx].ServerInfo;
+    }
 
-        // store host address
-        pNewListViewItem->setData ( 0, Qt::UserRole, CurHostAddress.toString() );
+    AddServerListItems ( CHostAddress(), vecServerInfo, false );
 
-        // per default expand the list item (if not "show all servers")
-        if ( bShowAllMusicians )
+    // the servers which answered the last time are shown immediately with their
+    // last ping time (in gray) until the first new ping result is received
+    for ( int iIdx = 0; iIdx < vecEntries.size(); iIdx++ )
+    {
+        QTreeWidgetItem* pCurListViewItem = FindListViewItem ( vecEntries[iIdx].ServerInfo.HostAddr );
+        const int        iPingTime        = vecEntries[iIdx].iPingTime;
+        const int        iNumClients      = vecEntries[iIdx].iNumClients;
+
+        if ( pCurListViewItem && ( iPingTime >= 0 ) )
         {
-            lvwServers->expandItem ( pNewListViewItem );
+            pCurListViewItem->setData ( 1, Qt::UserRole, true );
+            pCurListViewItem->setForeground ( 1, Qt::gray );
+            pCurListViewItem->setText ( 1, iPingTime > 500 ? QString ( ">500 ms" ) : QString().setNum ( iPingTime ) + " ms" );
+            pCurListViewItem->setText ( 4, QString ( "%1" ).arg ( iPingTime, 8, 10, QLatin1Char ( '0' ) ) );
+
+            pCurListViewItem->setData ( 2, Qt::UserRole, iNumClients );
+            pCurListViewItem->setText ( 2, QString().setNum ( iNumClients ) );
+
+            pCurListViewItem->setHidden ( false );
         }
     }
 
-    // immediately issue the ping measurements and start the ping timer since
-    // the server list is filled now
+    lvwServers->sortByColumn ( 4, Qt::AscendingOrder );
+    bServerListFromCache = true;
+
+    // the cached servers are pinged while the new list is requested
     OnTimerPing();
-    TimerPing.start ( PING_UPDATE_TIME_SERVER_LIST_MS );
+    TimerPing.start ( PING_SCHED_TICK_MS );
+}
+
+void CConnectDlg::StoreServerListInCache()
+{
+    // only a received list (or the list which was shown from the cache) is
+    // stored, a partially received list would replace the cached list
+    if ( bShowCompleteRegList || strServerListCentralServerAddress.isEmpty() ||
+         !( bServerListReceived || bServerListFromCache ) )
+    {
+        return;
+    }
+
+    QVector<CServerListCache::CEntry> vecEntries;
+    const int                         iServerListLen = lvwServers->topLevelItemCount();
+
+    for ( int iIdx = 0; iIdx < iServerListLen; iIdx++ )
+    {
+        QTreeWidgetItem* pCurListViewItem = lvwServers->topLevelItem ( iIdx );
+        const QString    strAddress       = pCurListViewItem->data ( 0, Qt::UserRole ).toString();
+
+        if ( ServerInfoIndex.contains ( strAddress ) )
+        {
+            CServerListCache::CEntry NewEntry;
+
+            NewEntry.ServerInfo = ServerInfoIndex.value ( strAddress );
+
+            // only the ping results of this session are stored, a server which
+            // does not answer anymore is not shown from the cache
+            if ( !pCurListViewItem->text ( 1 ).isEmpty() &&
+                 !pCurListViewItem->data ( 1, Qt::UserRole ).toBool() )
+            {
+                NewEntry.iPingTime   = pCurListViewItem->text ( 4 ).toInt();
+                NewEntry.iNumClients = pCurListViewItem->data ( 2, Qt::UserRole ).toInt();
+            }
+
+            vecEntries.append ( NewEntry );
+        }
+    }
+
+    ServerListCache.SetServerList ( strServerListCentralServerAddress, vecEntries );
 }
 
 void CConnectDlg::SetConnClientsList ( const CHostAddress&          InetAddr,
@@ -416,16 +890,13 @@ void CConnectDlg::SetConnClientsList ( const CHostAddress&          InetAddr,
         DeleteAllListViewItemChilds ( pCurListViewItem );
 
         // get number of connected clients
-        const int iNumConnectedClients = vecChanInfo.Size();
+        const int               iNumConnectedClients = vecChanInfo.Size();
+        QList<QTreeWidgetItem*> NewChildListViewItems;
 
         for ( int i = 0; i < iNumConnectedClients; i++ )
         {
-            // create new list view item
-            QTreeWidgetItem* pNewChildListViewItem =
-                new QTreeWidgetItem ( pCurListViewItem );
-
-            // child items shall use only one column
-            pNewChildListViewItem->setFirstColumnSpanned ( true );
+            // create new list view item (all childs are added at once below)
+            QTreeWidgetItem* pNewChildListViewItem = new QTreeWidgetItem();
 
             // set the clients name
             QString sClientText = vecChanInfo[i].strName;
@@ -436,8 +907,8 @@ void CConnectDlg::SetConnClientsList ( const CHostAddress&          InetAddr,
             if ( vecChanInfo[i].eCountry != QLocale::AnyCountry )
             {
                 // try to load the country flag icon
-                QPixmap CountryFlagPixmap (
-                    CLocale::GetCountryFlagIconsResourceReference ( vecChanInfo[i].eCountry ) );
+                const QPixmap CountryFlagPixmap =
+                    CPixmapCache::GetCountryFlagPixmap ( vecChanInfo[i].eCountry );
 
                 // first check if resource reference was valid
                 if ( !CountryFlagPixmap.isNull() )
@@ -458,25 +929,35 @@ void CConnectDlg::SetConnClientsList ( const CHostAddress&          InetAddr,
 
             if ( !bCountryFlagIsUsed )
             {
-                // get the resource reference string for this instrument
-                const QString strCurResourceRef =
-                    CInstPictures::GetResourceReference ( vecChanInfo[i].iInstrument );
+                const QPixmap InstrumentPixmap =
+                    CPixmapCache::GetInstrumentPixmap ( vecChanInfo[i].iInstrument );
 
                 // first check if instrument picture is used or not and if it is valid
-                if ( !( CInstPictures::IsNotUsedInstrument ( vecChanInfo[i].iInstrument ) ||
-                        strCurResourceRef.isEmpty() ) )
+                if ( !InstrumentPixmap.isNull() )
                 {
                     // set correct picture
-                    pNewChildListViewItem->setIcon ( 0, QIcon ( QPixmap ( strCurResourceRef ) ) );
+                    pNewChildListViewItem->setIcon ( 0, QIcon ( InstrumentPixmap ) );
                 }
             }
 
             // apply the client text to the list view item
             pNewChildListViewItem->setText ( 0, sClientText );
 
-            // add the new child to the corresponding server item
-            pCurListViewItem->addChild ( pNewChildListViewItem );
+            NewChildListViewItems.append ( pNewChildListViewItem );
+        }
+
+        // add the new childs to the corresponding server item
+        pCurListViewItem->addChildren ( NewChildListViewItems );
 
+        // child items shall use only one column (must be set after the item
+        // was added to the tree)
+        foreach ( QTreeWidgetItem* pChildItem, NewChildListViewItems )
+        {
+            pChildItem->setFirstColumnSpanned ( true );
+        }
+
+        if ( iNumConnectedClients > 0 )
+        {
             // at least one server has childs now, show decoration to be able
             // to show the childs
             lvwServers->setRootIsDecorated ( true );
@@ -653,33 +1134,142 @@ void CConnectDlg::OnConnectClicked()
         strSelectedAddress = cbxServerAddr->currentText();
     }
 
+    // the ping jitter is only known if the server was pinged at least twice
+    const CPingScheduleEntry PingEntry = PingSchedule.value ( strSelectedAddress );
+
+    iSelectedPingJitterMs = ( PingEntry.iNumPings >= 2 ) ? PingEntry.iMaxPingTime - PingEntry.iMinPingTime : -1;
+
     // tell the parent window that the connection shall be initiated
     done ( QDialog::Accepted );
 }
 
 void CConnectDlg::OnTimerPing()
 {
-    // send ping messages to the servers in the list
-    const int iServerListLen = lvwServers->topLevelItemCount();
+    // Ping scheduler: Instead of pinging all servers at the same time (which
+    // is a large UDP burst on a weak uplink and falsifies the ping times), the
+    // pings are limited by a token bucket. The servers which were not yet
+    // answered come first (they are not shown before), then the servers which
+    // are visible in the list view and then all others, each group in the
+    // order of the list (lowest ping time on top).
+    const qint64 iCurTimeMs = PingSchedClock.elapsed();
+
+    dPingTokens = std::min ( static_cast<double> ( PING_SCHED_BURST ),
+                             dPingTokens + ( iCurTimeMs - iLastPingTokenRefillMs ) *
+                                           PING_SCHED_RATE_PER_SEC / 1000.0 );
+
+    iLastPingTokenRefillMs = iCurTimeMs;
+
+    if ( dPingTokens < 1 )
+    {
+        return;
+    }
+
+    const int                          iServerListLen = lvwServers->topLevelItemCount();
+    const QRect                        ViewportRect   = lvwServers->viewport()->rect();
+    std::vector<std::pair<int, int> >  vecDueItems; // (priority, list index)
 
     for ( int iIdx = 0; iIdx < iServerListLen; iIdx++ )
     {
-        CHostAddress CurServerAddress;
+        QTreeWidgetItem*          pItem = lvwServers->topLevelItem ( iIdx );
+        const CPingScheduleEntry& Entry = PingSchedule[pItem->data ( 0, Qt::UserRole ).toString()];
 
-        // try to parse host address string which is stored as user data
-        // in the server list item GUI control element
-        if ( NetworkUtil().ParseNetworkAddress (
-                lvwServers->topLevelItem ( iIdx )->
-                data ( 0, Qt::UserRole ).toString(),
-                CurServerAddress ) )
+        if ( Entry.iNextPingMs <= iCurTimeMs )
         {
-            // if address is valid, send ping or the version and OS request
+            int iPriority = 2;
+
+            if ( Entry.iLastPingTime < 0 )
+            {
+                iPriority = 0;
+            }
+            else if ( lvwServers->visualItemRect ( pItem ).intersects ( ViewportRect ) )
+            {
+                iPriority = 1;
+            }
+
+            vecDueItems.push_back ( std::make_pair ( iPriority, iIdx ) );
+        }
+    }
+
+    std::sort ( vecDueItems.begin(), vecDueItems.end() );
+
+    for ( size_t i = 0; ( i < vecDueItems.size() ) && ( dPingTokens >= 1 ); i++ )
+    {
+        QTreeWidgetItem*    pItem = lvwServers->topLevelItem ( vecDueItems[i].second );
+        CPingScheduleEntry& Entry = PingSchedule[pItem->data ( 0, Qt::UserRole ).toString()];
+
+        Entry.iNextPingMs = iCurTimeMs + Entry.iIntervalMs;
+        dPingTokens      -= 1;
+
+        SendPing ( pItem );
+    }
+}
+
+void CConnectDlg::SendPing ( QTreeWidgetItem* pItem )
+{
+    CHostAddress CurServerAddress;
+
+    // try to parse host address string which is stored as user data
+    // in the server list item GUI control element
+    if ( NetworkUtil().ParseNetworkAddress ( pItem->data ( 0, Qt::UserRole ).toString(),
+                                             CurServerAddress ) )
+    {
+        // if address is valid, send ping or the version and OS request
 #ifdef ENABLE_CLIENT_VERSION_AND_OS_DEBUGGING
-            emit CreateCLServerListReqVerAndOSMes ( CurServerAddress );
+        emit CreateCLServerListReqVerAndOSMes ( CurServerAddress );
 #else
-            emit CreateCLServerListPingMes ( CurServerAddress );
+        emit CreateCLServerListPingMes ( CurServerAddress );
 #endif
-        }
+    }
+}
+
+void CConnectDlg::ClearPingSchedule()
+{
+    PingSchedule.clear();
+
+    // the first pings may use the complete burst
+    PingSchedClock.start();
+    dPingTokens            = PING_SCHED_BURST;
+    iLastPingTokenRefillMs = 0;
+}
+
+void CConnectDlg::UpdatePingSchedule ( const CHostAddress& InetAddr,
+                                       const int           iPingTime )
+{
+    QHash<QString, CPingScheduleEntry>::iterator it = PingSchedule.find ( InetAddr.toString() );
+
+    if ( it == PingSchedule.end() )
+    {
+        return;
+    }
+
+    // a server with stable ping times is pinged less often, a changed ping
+    // time resets the interval
+    if ( ( it->iLastPingTime >= 0 ) &&
+         ( std::abs ( iPingTime - it->iLastPingTime ) <= PING_SCHED_STABLE_DIFF_MS ) )
+    {
+        it->iIntervalMs = std::min ( PING_SCHED_MAX_INTERVAL_MS, it->iIntervalMs + it->iIntervalMs / 2 );
+    }
+    else
+    {
+        it->iIntervalMs = PING_UPDATE_TIME_SERVER_LIST_MS;
+    }
+
+    it->iLastPingTime = iPingTime;
+    it->iNextPingMs   = PingSchedClock.elapsed() + it->iIntervalMs;
+
+    // the spread of the ping times is a first estimate of the jitter of the
+    // network path for the jitter buffer of a new connection
+    it->iNumPings++;
+
+    if ( it->iMinPingTime < 0 )
+    {
+        it->iMinPingTime = iPingTime;
+        it->iMaxPingTime = iPingTime;
+    }
+    else
+    {
+        it->iMinPingTime = std::min ( it->iMinPingTime, iPingTime );
+        it->iMaxPingTime = std::max ( it->iMaxPingTime, iPingTime );
     }
 }
 
@@ -692,6 +1282,16 @@ void CConnectDlg::SetPingTimeAndNumClientsResult ( const CHostAddress& InetAddr,
 
     if ( pCurListViewItem )
     {
+        // adapt the ping interval of this server
+        UpdatePingSchedule ( InetAddr, iPingTime );
+
+        // the first ping result replaces the ping time of the server list cache
+        if ( pCurListViewItem->data ( 1, Qt::UserRole ).toBool() )
+        {
+            pCurListViewItem->setData ( 1, Qt::UserRole, false );
+            pCurListViewItem->setText ( 4, "99999999" );
+        }
+
         // check if this is the first time a ping time is set
         const bool bIsFirstPing = pCurListViewItem->text ( 1 ).isEmpty();
         bool       bDoSorting   = false;
@@ -753,6 +1353,8 @@ void CConnectDlg::SetPingTimeAndNumClientsResult ( const CHostAddress& InetAddr,
         }
 
         // update number of clients text
+        pCurListViewItem->setData ( 2, Qt::UserRole, iNumClients );
+
         if ( iNumClients >= pCurListViewItem->text ( 5 ).toInt() )
         {
             pCurListViewItem->
@@ -777,19 +1379,33 @@ void CConnectDlg::SetPingTimeAndNumClientsResult ( const CHostAddress& InetAddr,
             pCurListViewItem->setHidden ( false );
         }
 
-        // Update sorting. Note that the sorting must be the last action for the
-        // current item since the topLevelItem ( iIdx ) is then no longer valid.
+        // Update sorting. Many ping results arrive in a short time, therefore
+        // the list is only re-sorted by the list update timer.
         if ( bDoSorting && !bShowCompleteRegList ) // do not sort if "show all servers"
         {
-            lvwServers->sortByColumn ( 4, Qt::AscendingOrder );
+            bListSortPending = true;
         }
     }
 
+    if ( !TimerListUpdate.isActive() )
+    {
+        TimerListUpdate.start ( SERV_LIST_UPDATE_TIME_MS );
+    }
+}
+
+void CConnectDlg::OnTimerListUpdate()
+{
+    if ( bListSortPending )
+    {
+        lvwServers->sortByColumn ( 4, Qt::AscendingOrder );
+        bListSortPending = false;
+    }
+
     // if no server item has childs, do not show decoration
     bool bAnyListItemHasChilds = false;
     const int iServerListLen   = lvwServers->topLevelItemCount();
 
-    for ( int iIdx = 0; iIdx < iServerListLen; iIdx++ )
+    for ( int iIdx = 0; ( iIdx < iServerListLen ) && !bAnyListItemHasChilds; iIdx++ )
     {
         // check if the current list item has childs
         if ( lvwServers->topLevelItem ( iIdx )->childCount() > 0 )
@@ -810,21 +1426,8 @@ void CConnectDlg::SetPingTimeAndNumClientsResult ( const CHostAddress& InetAddr,
 
 QTreeWidgetItem* CConnectDlg::FindListViewItem ( const CHostAddress& InetAddr )
 {
-    const int iServerListLen = lvwServers->topLevelItemCount();
-
-    for ( int iIdx = 0; iIdx < iServerListLen; iIdx++ )
-    {
-        // compare the received address with the user data string of the
-        // host address by a string compare
-        if ( !lvwServers->topLevelItem ( iIdx )->
-                data ( 0, Qt::UserRole ).toString().
-                compare ( InetAddr.toString() ) )
-        {
-            return lvwServers->topLevelItem ( iIdx );
-        }
-    }
-
-    return nullptr;
+    // the items are indexed by the user data string of the host address
+    return ListViewItemIndex.value ( InetAddr.toString(), nullptr );
 }
 
 QTreeWidgetItem* CConnectDlg::GetParentListViewItem ( QTreeWidgetItem* pItem )
@@ -846,18 +1449,9 @@ QTreeWidgetItem* CConnectDlg::GetParentListViewItem ( QTreeWidgetItem* pItem )
 
 void CConnectDlg::DeleteAllListViewItemChilds ( QTreeWidgetItem* pItem )
 {
-    // loop over all childs
-    while ( pItem->childCount() > 0 )
-    {
-        // get the first child in the list
-        QTreeWidgetItem* pCurChildItem = pItem->child ( 0 );
-
-        // remove it from the item (note that the object is not deleted)
-        pItem->removeChild ( pCurChildItem );
-
-        // delete the object to avoid a memory leak
-        delete pCurChildItem;
-    }
+    // remove all childs at once (note that the objects are not deleted by
+    // takeChildren) and delete the objects to avoid a memory leak
+    qDeleteAll ( pItem->takeChildren() );
 }
 
 #ifdef ENABLE_CLIENT_VERSION_AND_OS_DEBUGGING
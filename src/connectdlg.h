@@ -28,7 +28,16 @@
 #include <QWhatsThis>
 #include <QTimer>
 #include <QMutex>
+#include <QHash>
+#include <QElapsedTimer>
 #include <QLocale>
+#include <QMap>
+#include <QSet>
+#include <QFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <algorithm>
+#include <vector>
 #include "global.h"
 #include "client.h"
 #include "multicolorled.h"
@@ -40,8 +49,77 @@
 // transmitted until it is received
 #define SERV_LIST_REQ_UPDATE_TIME_MS       2000 // ms
 
+// ping scheduler: the pings are limited by a token bucket (rate and burst
+// size), the ping interval of a server grows up to the maximum interval as
+// long as its ping results are stable
+#define PING_SCHED_TICK_MS                 50 // ms
+#define PING_SCHED_RATE_PER_SEC            40 // pings per second
+#define PING_SCHED_BURST                   10 // pings
+#define PING_SCHED_MAX_INTERVAL_MS         20000 // ms
+#define PING_SCHED_STABLE_DIFF_MS          3 // ms
+
+// the server list is re-sorted (and the list filter is re-applied) at most
+// once in this time interval while the ping results come in
+#define SERV_LIST_UPDATE_TIME_MS           250 // ms
+
+// server list cache: maximum number of stored lists (one per central server
+// address) and maximum age of a list which is still shown
+#define SERV_LIST_CACHE_MAX_NUM_LISTS      16
+#define SERV_LIST_CACHE_MAX_AGE_DAYS       30 // days
+
+// identification and version of the server list cache file
+#define SERV_LIST_CACHE_MAGIC              0x4A534C43 // "JSLC"
+#define SERV_LIST_CACHE_VERSION            1
+
 
 /* Classes ********************************************************************/
+// Server list cache: the last received server list of each central server is
+// stored on disk together with the last ping time and number of clients of each
+// server. On opening the connect dialog, the cached list is shown immediately
+// and is then updated by the newly received list and ping results.
+class CServerListCache
+{
+public:
+    class CEntry
+    {
+    public:
+        CEntry() : iPingTime ( -1 ), iNumClients ( 0 ) {}
+
+        CServerInfo ServerInfo;
+        int         iPingTime; // -1 if the server did not answer a ping
+        int         iNumClients;
+    };
+
+    CServerListCache() : bIsLoaded ( false ) {}
+
+    void SetFileName ( const QString& strNFileName ) { strFileName = strNFileName; }
+
+    // the file is read on the first access
+    bool GetServerList ( const QString&   strCentralServerAddress,
+                         QVector<CEntry>& vecEntries );
+
+    void SetServerList ( const QString&         strCentralServerAddress,
+                         const QVector<CEntry>& vecEntries );
+
+    void Save();
+
+protected:
+    class CList
+    {
+    public:
+        CList() : iTimeStampMs ( 0 ) {}
+
+        qint64          iTimeStampMs; // ms since epoch (UTC)
+        QVector<CEntry> vecEntries;
+    };
+
+    void Load();
+
+    QString              strFileName;
+    QMap<QString, CList> Lists;
+    bool                 bIsLoaded;
+};
+
 class CConnectDlg : public QDialog, private Ui_CConnectDlgBase
 {
     Q_OBJECT
@@ -54,6 +132,7 @@ public:
 
     void Init ( const CVector<QString>& vstrIPAddresses );
     void SetCentralServerAddress ( const QString strNewCentralServerAddr ) { strCentralServerAddress = strNewCentralServerAddr; }
+    void SetServerListCacheFileName ( const QString& strFileName ) { ServerListCache.SetFileName ( strFileName ); }
 
     void SetShowAllMusicians ( const bool bState ) { ShowAllMusicians ( bState ); }
     bool GetShowAllMusicians() { return bShowAllMusicians; }
@@ -61,6 +140,15 @@ public:
     void SetServerList ( const CHostAddress&         InetAddr,
                          const CVector<CServerInfo>& vecServerInfo );
 
+    void SetServerListPage ( const CHostAddress&         InetAddr,
+                             const int                   iPage,
+                             const int                   iNumPages,
+                             const CVector<CServerInfo>& vecServerInfo );
+
+    // the IPv6 servers are appended to the received server list
+    void SetServerListIPv6 ( const CHostAddress&         InetAddr,
+                             const CVector<CServerInfo>& vecServerInfo );
+
     void SetConnClientsList ( const CHostAddress&          InetAddr,
                               const CVector<CChannelInfo>& vecChanInfo );
 
@@ -77,28 +165,86 @@ public:
     bool    GetServerListItemWasChosen() const { return bServerListItemWasChosen; }
     QString GetSelectedAddress() const { return strSelectedAddress; }
     QString GetSelectedServerName() const { return strSelectedServerName; }
+
+    // spread of the measured ping times of the selected server in ms (-1 if
+    // less than two ping results were received)
+    int     GetSelectedPingJitter() const { return iSelectedPingJitterMs; }
     void    RequestServerList();
 
 protected:
     virtual void showEvent ( QShowEvent* );
     virtual void hideEvent ( QHideEvent* );
 
+    void             RequestServerList();
+
     QTreeWidgetItem* FindListViewItem ( const CHostAddress& InetAddr );
     QTreeWidgetItem* GetParentListViewItem ( QTreeWidgetItem* pItem );
     void             DeleteAllListViewItemChilds ( QTreeWidgetItem* pItem );
     void             UpdateListFilter();
     void             ShowAllMusicians ( const bool bState );
+    void             AddServerListItems ( const CHostAddress&         InetAddr,
+                                          const CVector<CServerInfo>& vecServerInfo,
+                                          const bool                  bFirstIsCentralServer );
+    void             ClearServerList();
+    void             MarkServerListItemsStale();
+    void             RemoveStaleServerListItems();
+    void             ShowCachedServerList();
+    void             StoreServerListInCache();
+    void             ClearPingSchedule();
+    void             UpdatePingSchedule ( const CHostAddress& InetAddr,
+                                          const int           iPingTime );
+    void             SendPing ( QTreeWidgetItem* pItem );
+
+    // ping schedule state of a server of the list
+    class CPingScheduleEntry
+    {
+    public:
+        CPingScheduleEntry() :
+            iNextPingMs ( 0 ),
+            iIntervalMs ( PING_UPDATE_TIME_SERVER_LIST_MS ),
+            iLastPingTime ( -1 ),
+            iMinPingTime ( -1 ),
+            iMaxPingTime ( -1 ),
+            iNumPings ( 0 ) {}
+
+        qint64 iNextPingMs;
+        int    iIntervalMs;
+        int    iLastPingTime; // -1 if no ping result was received yet
+
+        // spread of the ping times (the jitter of the network path)
+        int    iMinPingTime;
+        int    iMaxPingTime;
+        int    iNumPings;
+    };
 
     CClient*     pClient;
 
     QTimer       TimerPing;
+    QElapsedTimer PingSchedClock;
+    QHash<QString, CPingScheduleEntry> PingSchedule;
+    double       dPingTokens;
+    qint64       iLastPingTokenRefillMs;
     QTimer       TimerReRequestServList;
+    QTimer       TimerListUpdate;
+    bool         bListSortPending;
+    QHash<QString, QTreeWidgetItem*> ListViewItemIndex;
+    QHash<QString, CServerInfo> ServerInfoIndex;
+    QSet<QString> StaleListViewItems;
+    CServerListCache ServerListCache;
+    QString      strServerListCentralServerAddress;
+    bool         bServerListFromCache;
+    int          iNumReceivedServers;
     QString      strCentralServerAddress;
     CHostAddress CentralServerAddress;
     QString      strSelectedAddress;
     QString      strSelectedServerName;
+    int          iSelectedPingJitterMs;
     bool         bShowCompleteRegList;
     bool         bServerListReceived;
+    bool         bIPv6ServerListReceived;
+    bool         bUsePagedServerList;
+    int          iNextServerListPage;
+    int          iNumServerListPages;
     bool         bServerListItemWasChosen;
     bool         bListFilterWasActive;
     bool         bShowAllMusicians;
@@ -113,9 +259,13 @@ public slots:
     void OnConnectClicked();
     void OnTimerPing();
     void OnTimerReRequestServList();
+    void OnTimerListUpdate();
+    void OnHostNameResolved ( QString );
 
 signals:
     void ReqServerListQuery ( CHostAddress InetAddr );
+    void ReqServerListPageQuery ( CHostAddress InetAddr, int iPage );
+    void ReqServerListIPv6Query ( CHostAddress InetAddr );
     void CreateCLServerListPingMes ( CHostAddress InetAddr );
     void CreateCLServerListReqVerAndOSMes ( CHostAddress InetAddr );
     void CreateCLServerListReqConnClientsListMes ( CHostAddress InetAddr );
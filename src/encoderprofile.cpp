@@ -0,0 +1,184 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "encoderprofile.h"
+
+
+// CEncoderCpuLoadMeter implementation *****************************************
+void CEncoderCpuLoadMeter::Init ( const int iFrameSizeSamples )
+{
+    iEvalNumFrames = std::max ( 1, ENC_PROFILE_CPU_EVAL_TIME_MS * SYSTEM_SAMPLE_RATE_HZ / 1000 / iFrameSizeSamples );
+    eLoad          = EL_NORMAL;
+    iNumFrames     = 0;
+    dUsageSum      = 0;
+}
+
+void CEncoderCpuLoadMeter::Update ( const double dUsage )
+{
+    dUsageSum += dUsage;
+    iNumFrames++;
+
+    if ( iNumFrames >= iEvalNumFrames )
+    {
+        const double dUsageAv = dUsageSum / iNumFrames;
+
+        // the load class changes by one step per evaluation (hysteresis)
+        switch ( eLoad )
+        {
+        case EL_OVERLOAD:
+            if ( dUsageAv < ENC_PROFILE_CPU_USAGE_RECOVER )
+            {
+                eLoad = EL_NORMAL;
+            }
+            break;
+
+        case EL_NORMAL:
+            if ( dUsageAv > ENC_PROFILE_CPU_USAGE_OVERLOAD )
+            {
+                eLoad = EL_OVERLOAD;
+            }
+            else if ( dUsageAv < ENC_PROFILE_CPU_USAGE_HEADROOM_ON )
+            {
+                eLoad = EL_HEADROOM;
+            }
+            break;
+
+        case EL_HEADROOM:
+            if ( dUsageAv > ENC_PROFILE_CPU_USAGE_HEADROOM_OFF )
+            {
+                eLoad = EL_NORMAL;
+            }
+            break;
+        }
+
+        iNumFrames = 0;
+        dUsageSum  = 0;
+    }
+}
+
+
+// CEncoderProfile implementation **********************************************
+void CEncoderProfile::ResetNetStats()
+{
+    bLossy           = false;
+    iLastNumReceived = -1; // no counters yet
+    iLastNumLost     = 0;
+    iNumFrames       = 0;
+}
+
+void CEncoderProfile::UpdateNetStats ( const int iNumReceived,
+                                       const int iNumLost )
+{
+    // the counters of the channel are reset on a new connection
+    if ( ( iLastNumReceived < 0 ) || ( iNumReceived < iLastNumReceived ) || ( iNumLost < iLastNumLost ) )
+    {
+        iLastNumReceived = iNumReceived;
+        iLastNumLost     = iNumLost;
+        iNumFrames       = 0;
+        return;
+    }
+
+    iNumFrames++;
+
+    if ( iNumFrames >= ENC_PROFILE_LOSS_NUM_FRAMES )
+    {
+        const int iCurNumLost  = iNumLost - iLastNumLost;
+        const int iCurNumTotal = iNumReceived - iLastNumReceived + iCurNumLost;
+
+        if ( iCurNumTotal > 0 )
+        {
+            const double dLossRate = static_cast<double> ( iCurNumLost ) / iCurNumTotal;
+
+            if ( dLossRate > ENC_PROFILE_LOSS_RATE_HIGH )
+            {
+                bLossy = true;
+            }
+            else if ( dLossRate < ENC_PROFILE_LOSS_RATE_LOW )
+            {
+                bLossy = false;
+            }
+        }
+
+        iLastNumReceived = iNumReceived;
+        iLastNumLost     = iNumLost;
+        iNumFrames       = 0;
+    }
+}
+
+void CEncoderProfile::Apply ( OpusCustomEncoder*    pEncoder,
+                              const EAudComprType   eAudComprType,
+                              const int             iNumAudioChannels,
+                              const int             iBitRate,
+                              const EEncoderCpuLoad eCpuLoad )
+{
+    if ( pEncoder == nullptr )
+    {
+        return;
+    }
+
+    // complexity: only the channels with a low bit rate get the higher
+    // complexity since it gives the largest quality improvement there
+    const bool bIsLegacy = ( eAudComprType != CT_OPUS64 );
+    int        iComplexity;
+
+    if ( eCpuLoad == EL_OVERLOAD )
+    {
+        iComplexity = ENC_PROFILE_COMPLEXITY_OVERLOAD;
+    }
+    else if ( ( eCpuLoad == EL_HEADROOM ) &&
+              ( iBitRate / std::max ( 1, iNumAudioChannels ) < ENC_PROFILE_LOW_BIT_RATE_BPS ) )
+    {
+        iComplexity = bIsLegacy ? ENC_PROFILE_COMPLEXITY_LEGACY_HIGH : ENC_PROFILE_COMPLEXITY_DEFAULT_HIGH;
+    }
+    else
+    {
+        iComplexity = bIsLegacy ? ENC_PROFILE_COMPLEXITY_LEGACY : ENC_PROFILE_COMPLEXITY_DEFAULT;
+    }
+
+    // expected packet loss: reduces the inter frame prediction of the encoder
+    int iLossPerc;
+
+    if ( !bIsLegacy )
+    {
+        iLossPerc = ENC_PROFILE_LOSS_PERC_OPUS64;
+    }
+    else
+    {
+        iLossPerc = bLossy ? ENC_PROFILE_LOSS_PERC_LOSSY : 0;
+    }
+
+    // only changed settings are applied on the encoder
+    if ( iComplexity != iAppliedComplexity )
+    {
+        opus_custom_encoder_ctl ( pEncoder, OPUS_SET_COMPLEXITY ( iComplexity ) );
+        iAppliedComplexity = iComplexity;
+    }
+
+    if ( iLossPerc != iAppliedLossPerc )
+    {
+        opus_custom_encoder_ctl ( pEncoder, OPUS_SET_PACKET_LOSS_PERC ( iLossPerc ) );
+        iAppliedLossPerc = iLossPerc;
+    }
+}
@@ -0,0 +1,148 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <algorithm>
+#ifdef USE_OPUS_SHARED_LIB
+# include "opus/opus_custom.h"
+#else
+# include "opus_custom.h"
+#endif
+#include "global.h"
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// encoder complexities: the legacy 128 samples frame size uses a low complexity
+// and the 64 samples frame size uses the default of the encoder, the higher
+// complexities are only used on channels with a low bit rate if the CPU has
+// enough headroom
+#define ENC_PROFILE_COMPLEXITY_OVERLOAD     0
+#define ENC_PROFILE_COMPLEXITY_LEGACY       1
+#define ENC_PROFILE_COMPLEXITY_LEGACY_HIGH  4
+#define ENC_PROFILE_COMPLEXITY_DEFAULT      5
+#define ENC_PROFILE_COMPLEXITY_DEFAULT_HIGH 8
+
+// channels below this bit rate per audio channel benefit from a higher
+// complexity (covers the "low" audio quality setting)
+#define ENC_PROFILE_LOW_BIT_RATE_BPS        100000 // bits per second
+
+// expected packet loss which is set on the encoder: the 64 samples frame size
+// always needs it to avoid loud artifacts on packet loss, the legacy frame
+// size only on lossy connections
+#define ENC_PROFILE_LOSS_PERC_OPUS64        35 // %
+#define ENC_PROFILE_LOSS_PERC_LOSSY         10 // %
+
+// the packet loss rate is evaluated over this number of frames, a connection
+// is lossy if the rate is above the high limit and is clean again if it is
+// below the low limit (hysteresis)
+#define ENC_PROFILE_LOSS_NUM_FRAMES         1000
+#define ENC_PROFILE_LOSS_RATE_HIGH          0.02
+#define ENC_PROFILE_LOSS_RATE_LOW           0.005
+
+// the CPU usage (ratio of the frame duration used for processing) is averaged
+// over the evaluation time, the thresholds have a hysteresis
+#define ENC_PROFILE_CPU_EVAL_TIME_MS        1000 // ms
+#define ENC_PROFILE_CPU_USAGE_OVERLOAD      0.8
+#define ENC_PROFILE_CPU_USAGE_RECOVER       0.6
+#define ENC_PROFILE_CPU_USAGE_HEADROOM_ON   0.3
+#define ENC_PROFILE_CPU_USAGE_HEADROOM_OFF  0.5
+
+
+/* Classes ********************************************************************/
+// CPU load classes for the encoder profile selection
+enum EEncoderCpuLoad
+{
+    EL_OVERLOAD = 0, // lowest complexity on all channels
+    EL_NORMAL   = 1, // default complexity of the compression type
+    EL_HEADROOM = 2  // higher complexity on channels with a low bit rate
+};
+
+// Averages the CPU usage of the audio processing and classifies it.
+class CEncoderCpuLoadMeter
+{
+public:
+    CEncoderCpuLoadMeter() { Init ( SYSTEM_FRAME_SIZE_SAMPLES ); }
+
+    void Init ( const int iFrameSizeSamples );
+
+    // must be called after the processing of each frame with the used ratio
+    // of the frame duration
+    void Update ( const double dUsage );
+
+    EEncoderCpuLoad GetLoad() const { return eLoad; }
+
+protected:
+    EEncoderCpuLoad eLoad;
+    int             iEvalNumFrames;
+    int             iNumFrames;
+    double          dUsageSum;
+};
+
+// Encoder profile of one audio stream: the bit rate and frame size are defined
+// by the audio stream properties and a constant bit rate is required since the
+// audio packet size identifies the stream, therefore the profile selects the
+// complexity and the expected packet loss of the encoder. The network quality
+// is estimated from the loss rate of the received audio packets of the same
+// connection.
+class CEncoderProfile
+{
+public:
+    CEncoderProfile() { Reset(); }
+
+    // must be called for a new connection
+    void Reset() { ResetNetStats(); ResetApplied(); }
+
+    // the next loss rate evaluation starts with the current counters
+    void ResetNetStats();
+
+    // must be called if the encoder was (re-)created, the next Apply() call
+    // configures all settings
+    void ResetApplied() { iAppliedComplexity = -1; iAppliedLossPerc = -1; }
+
+    // the counters are the totals of the channel, must be called once per frame
+    void UpdateNetStats ( const int iNumReceived,
+                          const int iNumLost );
+
+    // selects the profile and applies changed settings on the encoder
+    void Apply ( OpusCustomEncoder*    pEncoder,
+                 const EAudComprType   eAudComprType,
+                 const int             iNumAudioChannels,
+                 const int             iBitRate,
+                 const EEncoderCpuLoad eCpuLoad );
+
+    bool IsLossy() const       { return bLossy; }
+    int  GetComplexity() const { return iAppliedComplexity; }
+    int  GetLossPerc() const   { return iAppliedLossPerc; }
+
+protected:
+    bool bLossy;
+    int  iLastNumReceived;
+    int  iLastNumLost;
+    int  iNumFrames;
+    int  iAppliedComplexity;
+    int  iAppliedLossPerc;
+};
@@ -0,0 +1,147 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "flightrecorder.h"
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
+#include <QDateTime>
+#include <QDebug>
+
+
+// Flight recorder implementation **********************************************
+QString CFlightRecorder::strDirectory;
+
+// the event names in the dump (same order as EFlightRecEvent)
+static const char* pcFlightRecEventNames[NUM_FLIGHT_REC_EVENTS] = {
+    "tick",
+    "callback",
+    "packet",
+    "get",
+    "concealed",
+    "underrun",
+    "overrun" };
+
+CFlightRecorder::CFlightRecorder ( const QString& strNName,
+                                   const int      iNNumRecords ) :
+    strName         ( strNName ),
+    iPosMask        ( iNNumRecords - 1 ),
+    iNextPos        ( 0 ),
+    iNumBurstEvents ( 0 ),
+    iLastAutoDumpMs ( -FLIGHT_REC_MIN_AUTO_DUMP_INTERVAL_MS ),
+    iNumDumps       ( 0 )
+{
+    // the ring is allocated once, the records are zero which marks them as
+    // older than the dump duration until they are written
+    vecRecords.Init ( iNNumRecords );
+
+    Clock.start();
+
+    QObject::connect ( &TimerCheck, &QTimer::timeout,
+        this, &CFlightRecorder::OnTimerCheck );
+
+    TimerCheck.start ( FLIGHT_REC_CHECK_INTERVAL_MS );
+}
+
+void CFlightRecorder::OnTimerCheck()
+{
+    const int    iNumEvents = iNumBurstEvents.fetchAndStoreRelaxed ( 0 );
+    const qint64 iNowMs     = Clock.elapsed();
+
+    if ( ( iNumEvents >= FLIGHT_REC_BURST_NUM_EVENTS ) &&
+         ( iNowMs - iLastAutoDumpMs >= FLIGHT_REC_MIN_AUTO_DUMP_INTERVAL_MS ) )
+    {
+        iLastAutoDumpMs = iNowMs;
+
+        Dump ( QString ( "burst of %1 jitter buffer underruns/overruns in %2 ms" ).
+            arg ( iNumEvents ).arg ( FLIGHT_REC_CHECK_INTERVAL_MS ) );
+    }
+}
+
+void CFlightRecorder::Dump ( const QString& strReason )
+{
+    // the ring is copied first so that the recording goes on while the file
+    // is written (a record which is just written by another thread may be
+    // incomplete, this only affects the newest records)
+    const int        iNumRecords = vecRecords.Size();
+    const int        iEndPos     = iNextPos.loadAcquire();
+    const quint32    iNowUs      = GetTimeUs();
+    CVector<SRecord> vecCopy ( iNumRecords );
+
+    for ( int i = 0; i < iNumRecords; i++ )
+    {
+        vecCopy[i] = vecRecords[( static_cast<unsigned int> ( iEndPos ) + i ) & iPosMask];
+    }
+
+    const QString strDir = strDirectory.isEmpty() ? QDir::tempPath() : strDirectory;
+    const QString strFileName = QString ( "%1/Jamulus_flightrec_%2_%3.csv" ).
+        arg ( strDir ).arg ( strName ).arg ( iNumDumps % FLIGHT_REC_MAX_NUM_FILES + 1 );
+
+    QFile File ( strFileName );
+
+    if ( !File.open ( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) )
+    {
+        qWarning() << qUtf8Printable ( QString ( "Cannot write the flight recorder file %1" ).arg ( strFileName ) );
+        return;
+    }
+
+    iNumDumps++;
+
+    QTextStream Stream ( &File );
+    int         iNumWritten = 0;
+
+    Stream << "# Jamulus flight recorder " << strName << ": " << strReason << "\n" <<
+        "# " << QDateTime::currentDateTime().toString ( Qt::ISODate ) <<
+        ", time in ms relative to the dump, tick/callback: value is the duration in us, " <<
+        "packet/get: value is the jitter buffer depth in blocks\n" <<
+        "time_ms,event,channel,value\n";
+
+    for ( int i = 0; i < iNumRecords; i++ )
+    {
+        const SRecord& Record = vecCopy[i];
+        const quint32  iAgeUs = iNowUs - Record.iTimeUs;
+
+        // unused and outdated records are skipped (a duration record is
+        // stored with its start time, i.e. it may be slightly newer)
+        if ( ( Record.iTimeUs == 0 ) || ( iAgeUs > FLIGHT_REC_DURATION_MS * 1000 ) ||
+             ( Record.iEvent >= NUM_FLIGHT_REC_EVENTS ) )
+        {
+            continue;
+        }
+
+        Stream << QString ( "%1,%2,%3,%4\n" ).
+            arg ( -static_cast<double> ( iAgeUs ) / 1000, 0, 'f', 3 ).
+            arg ( pcFlightRecEventNames[Record.iEvent] ).
+            arg ( Record.iChanID ).arg ( Record.iValue );
+
+        iNumWritten++;
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+// TODO we should use the ConsoleWriterFactory() instead of qInfo()
+    qInfo() << qUtf8Printable ( QString ( "Flight recorder (%1): %2 records written to %3" ).
+        arg ( strReason ).arg ( iNumWritten ).arg ( strFileName ) );
+#endif
+}
@@ -0,0 +1,165 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QString>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <algorithm>
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// The flight recorder keeps compact timing records of the last seconds in a
+// fixed-size ring (always on, recording a record does not lock or allocate)
+// and writes them as CSV file if a burst of jitter buffer underruns/overruns
+// happened or on request (SIGQUIT), so that a reported crackle can be analyzed
+// afterwards.
+#define FLIGHT_REC_DURATION_MS               10000 // the dump covers the last 10 s
+#define FLIGHT_REC_SERVER_NUM_RECORDS        524288 // power of two (8 bytes per record)
+#define FLIGHT_REC_CLIENT_NUM_RECORDS        65536
+
+// a dump is written if at least this number of underruns/overruns happened
+// in one check interval (at most one automatic dump per minimum interval, the
+// dump files of a recorder are rotated)
+#define FLIGHT_REC_CHECK_INTERVAL_MS         1000
+#define FLIGHT_REC_BURST_NUM_EVENTS          10
+#define FLIGHT_REC_MIN_AUTO_DUMP_INTERVAL_MS 60000
+#define FLIGHT_REC_MAX_NUM_FILES             5
+
+// the recorded events
+enum EFlightRecEvent
+{
+    FR_TICK      = 0, // frame of the server timer (value: duration in us)
+    FR_CALLBACK  = 1, // sound card callback of the client (value: duration in us)
+    FR_PACKET    = 2, // audio packet received (value: jitter buffer depth in blocks after the put, server only)
+    FR_GET       = 3, // frame taken from the jitter buffer (value: depth in blocks after the get)
+    FR_CONCEALED = 4, // no frame in the jitter buffer, concealed (continued underrun or missing frame)
+    FR_UNDERRUN  = 5, // start of a jitter buffer underrun
+    FR_OVERRUN   = 6, // jitter buffer full on a put
+    NUM_FLIGHT_REC_EVENTS
+};
+
+
+/* Classes ********************************************************************/
+class CFlightRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    // the name is part of the dump file names, the number of records must be
+    // a power of two
+    CFlightRecorder ( const QString& strNName,
+                      const int      iNNumRecords );
+
+    // directory of the dump files (the temporary directory by default), must
+    // be set before the recorders are created
+    static void SetDirectory ( const QString& strNDirectory ) { strDirectory = strNDirectory; }
+
+    // can be called concurrently by all threads
+    void Record ( const EFlightRecEvent eEvent,
+                  const int             iChanID = 0,
+                  const int             iValue  = 0 )
+    {
+        Put ( GetTimeUs(), eEvent, iChanID, iValue );
+    }
+
+    // records an event which started at the given time with its duration
+    void RecordDuration ( const EFlightRecEvent eEvent,
+                          const quint32         iStartTimeUs )
+    {
+        Put ( iStartTimeUs, eEvent, 0, static_cast<int> ( GetTimeUs() - iStartTimeUs ) );
+    }
+
+    quint32 GetTimeUs() const { return static_cast<quint32> ( Clock.nsecsElapsed() / 1000 ); }
+
+    // writes the records of the last FLIGHT_REC_DURATION_MS (main thread only)
+    void Dump ( const QString& strReason );
+
+protected:
+    // the time wraps after 71 minutes, only the age of a record relative to
+    // the dump is of interest
+    struct SRecord
+    {
+        quint32 iTimeUs;
+        quint8  iEvent;
+        quint8  iChanID;
+        quint16 iValue;
+    };
+
+    void Put ( const quint32         iTimeUs,
+               const EFlightRecEvent eEvent,
+               const int             iChanID,
+               const int             iValue )
+    {
+        SRecord& Record = vecRecords[iNextPos.fetchAndAddRelaxed ( 1 ) & iPosMask];
+
+        Record.iTimeUs = iTimeUs;
+        Record.iEvent  = static_cast<quint8> ( eEvent );
+        Record.iChanID = static_cast<quint8> ( iChanID );
+        Record.iValue  = static_cast<quint16> ( std::min ( std::max ( iValue, 0 ), 65535 ) );
+
+        if ( ( eEvent == FR_UNDERRUN ) || ( eEvent == FR_OVERRUN ) )
+        {
+            iNumBurstEvents.fetchAndAddRelaxed ( 1 );
+        }
+    }
+
+    static QString   strDirectory;
+
+    QString          strName;
+    CVector<SRecord> vecRecords;
+    int              iPosMask;
+    QAtomicInt       iNextPos;
+    QAtomicInt       iNumBurstEvents;
+    QElapsedTimer    Clock;
+    QTimer           TimerCheck;
+    qint64           iLastAutoDumpMs;
+    int              iNumDumps;
+
+protected slots:
+    void OnTimerCheck();
+};
+
+// records the duration of the enclosing scope
+class CFlightRecScope
+{
+public:
+    CFlightRecScope ( CFlightRecorder&      NRecorder,
+                      const EFlightRecEvent eNEvent ) :
+        Recorder ( NRecorder ),
+        eEvent ( eNEvent ),
+        iStartTimeUs ( NRecorder.GetTimeUs() ) {}
+
+    ~CFlightRecScope() { Recorder.RecordDuration ( eEvent, iStartTimeUs ); }
+
+protected:
+    CFlightRecorder&      Recorder;
+    const EFlightRecEvent eEvent;
+    const quint32         iStartTimeUs;
+};
@@ -89,6 +89,9 @@ LED bar:      lbr
 #define DEFAULT_INI_FILE_NAME            "Jamulus.ini"
 #define DEFAULT_INI_FILE_NAME_SERVER     "Jamulusserver.ini"
 
+// name of the server list cache file of the client (stored next to the ini-file)
+#define DEFAULT_SERV_LIST_CACHE_FILE     "Jamulusserverlist.cache"
+
 // file name for logging file
 #define DEFAULT_LOG_FILE_NAME            "Jamulussrvlog.txt"
 
@@ -145,6 +148,12 @@ LED bar:      lbr
 #define MAX_NET_BUF_SIZE_NUM_BL          20 // number of blocks
 #define AUTO_NET_BUF_SIZE_FOR_PROTOCOL   ( MAX_NET_BUF_SIZE_NUM_BL + 1 ) // auto set parameter (only used for protocol)
 
+// the auto setting may use larger network buffers than the slider (e.g. for
+// intercontinental connections), the memory of the network buffer only grows
+// up to the used size plus some headroom
+#define MAX_AUTO_NET_BUF_SIZE_NUM_BL     32 // number of blocks
+#define NET_BUF_SIZE_HEADROOM_NUM_BL     4  // number of blocks
+
 // default network buffer size
 #define DEF_NET_BUF_SIZE_NUM_BL          10 // number of blocks
 
@@ -165,7 +174,11 @@ LED bar:      lbr
 #define MAX_NUM_SERVER_ADDR_ITEMS        12
 
 // maximum number of fader settings to be stored (together with the fader tags)
-#define MAX_NUM_STORED_FADER_SETTINGS    250
+#define MAX_NUM_STORED_FADER_SETTINGS    1000
+
+// maximum number of servers for which the last good jitter buffer delay is
+// stored
+#define MAX_NUM_STORED_JIT_BUF_DELAYS    32
 
 // range for signal level meter
 #define LOW_BOUND_SIG_METER              ( -50.0 ) // dB
@@ -176,14 +189,28 @@ LED bar:      lbr
 #define RED_BOUND_LED_BAR                7
 #define YELLOW_BOUND_LED_BAR             5
 
-// maximum number of connected clients at the server (must not be larger than 256)
-#define MAX_NUM_CHANNELS                 50 // max number channels for server
+// maximum number of connected clients at the server (must not be larger than 256
+// since the channel ID is transmitted as one byte), the server allocates its
+// channel table for the number of channels which is set on the command line
+#define MAX_NUM_CHANNELS                 200 // max number channels for server
 
 // actual number of used channels in the server
 // this parameter can safely be changed from 1 to MAX_NUM_CHANNELS
 // without any other changes in the code
 #define DEFAULT_USED_NUM_CHANNELS        10 // default used number channels for server
 
+// number of the mix groups (sections, e.g. the sopranos of a choir) which are
+// summed once per frame by the server, the groups are numbered from 1 to
+// MAX_NUM_MIX_GROUPS (NO_MIX_GROUP: the channel is not in a group)
+#define MAX_NUM_MIX_GROUPS               8
+#define NO_MIX_GROUP                     0
+
+// a shared stream of the server can be sent to the clients in the LAN of the
+// server as multicast, the stream n uses the multicast group with the address
+// of the first group plus n (NO_MULTICAST_STREAM: unicast)
+#define MAX_NUM_MULTICAST_STREAMS        64
+#define NO_MULTICAST_STREAM              0xFF
+
 // Maximum number of servers registered in the server list. If you want to
 // change this parameter, you most probably have to adjust MAX_SIZE_BYTES_NETW_BUF.
 #define MAX_NUM_SERVERS_IN_SERVER_LIST   150 // reduced to 150 because we now have genre-based server lists
@@ -194,9 +221,40 @@ LED bar:      lbr
 // defines the time interval at which the ping time is updated for the server list
 #define PING_UPDATE_TIME_SERVER_LIST_MS  2500 // ms
 
+// defines the time interval at which the server measures the round trip time
+// to the connected clients
+#define SERVER_RTT_PROBE_INTERVAL_MS     2000 // ms
+
+// the server answers the connection less requests and the audio packets of
+// rejected clients with rate limits per source address and for all sources
+// (in messages per second and the number of messages of a burst), the size of
+// the table of the sources must be a power of two
+#define CONNLESS_RATE_LIMIT_TABLE_SIZE   512
+#define CONNLESS_REQ_SOURCE_RATE         20
+#define CONNLESS_REQ_SOURCE_BURST        40
+#define CONNLESS_REQ_GLOBAL_RATE         2000
+#define CONNLESS_REQ_GLOBAL_BURST        4000
+#define CONNLESS_FULL_SOURCE_RATE        1
+#define CONNLESS_FULL_SOURCE_BURST       2
+#define CONNLESS_FULL_GLOBAL_RATE        200
+#define CONNLESS_FULL_GLOBAL_BURST       400
+
+// the connected clients list and the number of clients which are sent as
+// answers to connection less requests are cached for this time
+#define CONNLESS_RESPONSE_CACHE_TIME_MS  1000 // ms
+
 // defines the interval between Channel Level updates from the server
 #define CHANNEL_LEVEL_UPDATE_INTERVAL    200  // number of frames at 64 samples frame size
 
+// maximum rate limit of the compact channel level message (in level updates)
+#define MAX_CHANNEL_LEVEL_DELTA_INTERVAL 16
+
+// number of compact channel level messages after which the full list is sent
+#define CHANNEL_LEVEL_DELTA_FULL_INTERVAL 10
+
+// marks a channel level which was not contained in a compact level message
+#define CHANNEL_LEVEL_UNCHANGED          0xFFFF
+
 // time-out until a registered server is deleted from the server list if no
 // new registering was made in minutes
 #define SERVLIST_TIME_OUT_MINUTES        33 // minutes (should include 3 UDP registration messages)
@@ -207,13 +265,46 @@ LED bar:      lbr
 // time interval for sending ping messages to servers in the server list
 #define SERVLIST_UPDATE_PING_SERVERS_MS  59000 // ms
 
+// time the central server collects the clients which requested the server list
+// before the "send empty message" requests are sent to the servers
+#define SERVLIST_SEND_EMPTY_MES_FLUSH_MS 20 // ms
+
+// number of servers in one page of a paged server list query
+#define SERVLIST_PAGE_NUM_SERVERS        30
+
 // time until a slave server registers in the server list
 #define SERVLIST_REGIST_INTERV_MINUTES   15 // minutes
 
+// the registration and keepalive intervals of the slave server are shortened
+// by a random amount of up to this percentage each time the timer is started
+// so that the servers do not send their messages in sync (e.g. after a restart
+// of the central server or a network outage)
+#define SERVLIST_TIMER_JITTER_PCT        10 // %
+
+// a slave server without registration response retries after this time which
+// is doubled with each further time out (up to SERVLIST_REGIST_INTERV_MINUTES),
+// the retry after hint of the central server is limited to the same range
+#define SERVLIST_REGIST_RETRY_MIN_S      60 // s
+
+// the central server pings one of this number of groups of the servers in the
+// list at a time so that the pings are spread over
+// SERVLIST_UPDATE_PING_SERVERS_MS
+#define SERVLIST_PING_SERVERS_NUM_SLICES 59
+
+// server pool: the members report their load in this interval, a member
+// without a load report for the time out is only chosen if no other member
+// is available, a member is chosen if its load is below the maximum load, the
+// chosen member is only changed if another member has a lower load by the
+// hysteresis
+#define SERVLIST_POOL_LOAD_INTERVAL_S    10 // s
+#define SERVLIST_POOL_LOAD_TIME_OUT_S    35 // s
+#define SERVLIST_POOL_MAX_LOAD_PCT       80 // %
+#define SERVLIST_POOL_HYSTERESIS_PCT     10 // %
+
 // defines the minimum time a server must run to be a permanent server
 #define SERVLIST_TIME_PERMSERV_MINUTES   2880 // minutes, 2880 = 60 min * 24 h * 2 d
 
-// registration response timeout
+// registration response timeout (doubled with each retry)
 #define REGISTER_SERVER_TIME_OUT_MS      500 // ms
 
 // defines the maximum number of times to retry server registration
@@ -111,20 +111,22 @@ void AHistoryGraph::Add ( const QDateTime& newDateTime, const QHostAddress Clien
 {
     if ( bDoHistory )
     {
-        // add element to history, distinguish between a local connection
-        // and a remote connection
-        if ( ( ClientInetAddr == QHostAddress ( "127.0.0.1" ) ) ||
-             ( ClientInetAddr.toString().left ( 7 ).compare ( "192.168" ) == 0 ) )
-        {
-            // local connection
-            Add ( newDateTime, HIT_LOCAL_CONNECTION );
-        }
-        else
-        {
-            // remote connection
-            Add ( newDateTime, HIT_REMOTE_CONNECTION );
-        }
+        // add element to history
+        Add ( newDateTime, GetConnectionType ( ClientInetAddr ) );
+    }
+}
+
+AHistoryGraph::EHistoryItemType AHistoryGraph::GetConnectionType ( const QHostAddress& ClientInetAddr )
+{
+    if ( ( ClientInetAddr == QHostAddress ( "127.0.0.1" ) ) ||
+         ( ClientInetAddr.toString().left ( 7 ).compare ( "192.168" ) == 0 ) )
+    {
+        // local connection
+        return HIT_LOCAL_CONNECTION;
     }
+
+    // remote connection
+    return HIT_REMOTE_CONNECTION;
 }
 
 void AHistoryGraph::Update ( )
@@ -68,6 +68,9 @@ public:
     void Add ( const QDateTime& newDateTime, const QHostAddress ClientInetAddr );
     virtual void Update ( );
 
+    // distinguish between a local connection and a remote connection
+    static EHistoryItemType GetConnectionType ( const QHostAddress& ClientInetAddr );
+
 protected:
     struct SHistoryData
     {
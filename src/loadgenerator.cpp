@@ -0,0 +1,399 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "loadgenerator.h"
+
+
+/* Implementation *************************************************************/
+// CLoadGenSettings implementation ---------------------------------------------
+bool CLoadGenSettings::Parse ( const QString& strSettings )
+{
+    const QStringList slItems = strSettings.split ( ",", QString::SkipEmptyParts );
+    bool              bOK     = !slItems.isEmpty();
+
+    *this = CLoadGenSettings();
+
+    if ( bOK )
+    {
+        iNumClients = slItems[0].trimmed().toInt ( &bOK );
+        bOK         = bOK && ( iNumClients >= 1 ) && ( iNumClients <= LOADGEN_MAX_NUM_CLIENTS );
+    }
+
+    for ( int i = 1; bOK && ( i < slItems.size() ); i++ )
+    {
+        const QStringList slKeyValue = slItems[i].trimmed().split ( "=" );
+        const QString     strKey     = slKeyValue[0].trimmed().toLower();
+        double            dValue     = 0.0;
+
+        if ( slKeyValue.size() == 2 )
+        {
+            dValue = slKeyValue[1].trimmed().toDouble ( &bOK );
+        }
+
+        if ( !bOK || ( slKeyValue.size() > 2 ) )
+        {
+            return false;
+        }
+
+        if ( ( strKey == "opus64" ) && ( slKeyValue.size() == 1 ) )
+        {
+            eAudComprType = CT_OPUS64;
+        }
+        else if ( ( strKey == "mono" ) && ( slKeyValue.size() == 1 ) )
+        {
+            iNumAudioChannels = 1;
+        }
+        else if ( ( strKey == "jitter" ) && ( slKeyValue.size() == 2 ) && ( dValue >= 0.0 ) )
+        {
+            dJitterMs = dValue;
+        }
+        else if ( ( strKey == "loss" ) && ( slKeyValue.size() == 2 ) &&
+                  ( dValue >= 0.0 ) && ( dValue <= 100.0 ) )
+        {
+            dLossRate = dValue / 100;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return bOK;
+}
+
+
+// CLoadGenClient implementation -----------------------------------------------
+CLoadGenClient::CLoadGenClient ( const int               iNClientIdx,
+                                 const CHostAddress&     NServerAddr,
+                                 const CLoadGenSettings& NSettings,
+                                 OpusCustomMode*         pOpusMode ) :
+    iClientIdx         ( iNClientIdx ),
+    Settings           ( NSettings ),
+    Channel            ( false ), // client
+    Socket             ( &Channel, 0 ), // random port
+    dPhase             ( 0.0 ),
+    iNextFrame         ( 0 ),
+    iNextFrameSendTick ( 0 ),
+    iNumSent           ( 0 ),
+    iNumDropped        ( 0 ),
+    iPingMs            ( 0 )
+{
+    int iOpusError;
+
+    const bool bMono = ( Settings.iNumAudioChannels == 1 );
+
+    // the same frame sizes and coded bytes as a real client with normal
+    // audio quality and the smallest buffer size of the codec
+    if ( Settings.eAudComprType == CT_OPUS64 )
+    {
+        iFrameSizeSamples  = SYSTEM_FRAME_SIZE_SAMPLES;
+        iCeltNumCodedBytes = bMono ? OPUS_NUM_BYTES_MONO_NORMAL_QUALITY : OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY;
+    }
+    else
+    {
+        iFrameSizeSamples  = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+        iCeltNumCodedBytes = bMono ? OPUS_NUM_BYTES_MONO_NORMAL_QUALITY_DBLE_FRAMESIZE :
+                                     OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY_DBLE_FRAMESIZE;
+    }
+
+    iTicksPerFrame = iFrameSizeSamples / SYSTEM_FRAME_SIZE_SAMPLES;
+
+    OpusEncoder = opus_custom_encoder_create ( pOpusMode, Settings.iNumAudioChannels, &iOpusError );
+    OpusDecoder = opus_custom_decoder_create ( pOpusMode, Settings.iNumAudioChannels, &iOpusError );
+
+    opus_custom_encoder_ctl ( OpusEncoder, OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( OpusEncoder,
+                              OPUS_SET_BITRATE ( CalcBitRateBitsPerSecFromCodedBytes ( iCeltNumCodedBytes, iFrameSizeSamples ) ) );
+
+    // each client sends a test tone with its own frequency
+    dPhaseInc = 2 * LOADGEN_PI * ( 220.0 + 20.0 * iClientIdx ) / SYSTEM_SAMPLE_RATE_HZ;
+
+    vecfAudio.Init      ( Settings.iNumAudioChannels * iFrameSizeSamples );
+    vecCeltData.Init    ( iCeltNumCodedBytes );
+    vecRedCeltData.Init ( 0 );
+    vecbyNetwData.Init  ( iCeltNumCodedBytes );
+
+    // connections for the protocol mechanism
+    QObject::connect ( &Channel, &CChannel::MessReadyForSending,
+        this, &CLoadGenClient::OnSendProtMessage );
+
+    QObject::connect ( &Channel, &CChannel::DetectedCLMessage,
+        this, &CLoadGenClient::OnDetectedCLMessage );
+
+    QObject::connect ( &Channel, &CChannel::ReqJittBufSize,
+        this, &CLoadGenClient::OnReqJittBufSize );
+
+    QObject::connect ( &Channel, &CChannel::ReqChanInfo,
+        this, &CLoadGenClient::OnReqChanInfo );
+
+    QObject::connect ( &Channel, &CChannel::NewConnection,
+        this, &CLoadGenClient::OnNewConnection );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLMessReadyForSending,
+        this, &CLoadGenClient::OnSendCLProtMessage );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLPingReceived,
+        this, &CLoadGenClient::OnCLPingReceived );
+
+    // a simulated client always uses the auto jitter buffer
+    Channel.SetDoAutoSockBufSize ( true );
+    Channel.SetAudioStreamProperties ( Settings.eAudComprType,
+                                       iCeltNumCodedBytes,
+                                       1, // frame size factor
+                                       Settings.iNumAudioChannels,
+                                       false ); // no redundancy
+
+    Channel.SetAddress ( NServerAddr );
+    Channel.SetEnable ( true );
+    Channel.GetNetStats ( LastNetStats );
+    Socket.Start();
+}
+
+CLoadGenClient::~CLoadGenClient()
+{
+    ConnLessProtocol.CreateCLDisconnection ( Channel.GetAddress() );
+
+    opus_custom_encoder_destroy ( OpusEncoder );
+    opus_custom_decoder_destroy ( OpusDecoder );
+}
+
+void CLoadGenClient::OnReqChanInfo()
+{
+    CChannelCoreInfo ChannelInfo;
+
+    ChannelInfo.strName = QString ( "LoadGen %1" ).arg ( iClientIdx + 1 );
+    Channel.SetRemoteInfo ( ChannelInfo );
+}
+
+void CLoadGenClient::OnNewConnection()
+{
+    OnReqChanInfo();
+    OnReqJittBufSize();
+}
+
+int CLoadGenClient::GetRandomJitterTicks() const
+{
+    const double dTickDurMs = 1000.0 * SYSTEM_FRAME_SIZE_SAMPLES / SYSTEM_SAMPLE_RATE_HZ;
+
+    return static_cast<int> ( GetRandomUniform() * Settings.dJitterMs / dTickDurMs );
+}
+
+void CLoadGenClient::OnTick ( const qint64 iTick )
+{
+    // the frames are sent in order, a frame which is delayed by the jitter
+    // also delays the following frames (which are then sent in a burst)
+    while ( iTick >= iNextFrameSendTick )
+    {
+        SendFrame();
+
+        iNextFrame++;
+        iNextFrameSendTick = std::max ( iNextFrameSendTick,
+                                        iNextFrame * iTicksPerFrame + GetRandomJitterTicks() );
+    }
+
+    // the mix is received at the nominal frame rate
+    if ( iTick % iTicksPerFrame == 0 )
+    {
+        ReceiveFrame();
+    }
+}
+
+void CLoadGenClient::SendFrame()
+{
+    // generate the test tone (the same signal on both channels)
+    for ( int i = 0; i < iFrameSizeSamples; i++ )
+    {
+        const float fValue = static_cast<float> ( LOADGEN_TONE_AMPLITUDE * sin ( dPhase ) );
+
+        for ( int c = 0; c < Settings.iNumAudioChannels; c++ )
+        {
+            vecfAudio[i * Settings.iNumAudioChannels + c] = fValue;
+        }
+
+        dPhase = fmod ( dPhase + dPhaseInc, 2 * LOADGEN_PI );
+    }
+
+    // the frame is always encoded (so that the encoder load is realistic)
+    // but lost packets are not sent
+    opus_custom_encode_float ( OpusEncoder,
+                               &vecfAudio[0],
+                               iFrameSizeSamples,
+                               &vecCeltData[0],
+                               iCeltNumCodedBytes );
+
+    if ( GetRandomUniform() < Settings.dLossRate )
+    {
+        iNumDropped++;
+        return;
+    }
+
+    Channel.PrepAndSendPacket ( &Socket, vecCeltData, iCeltNumCodedBytes, vecRedCeltData, 0 );
+    iNumSent++;
+}
+
+void CLoadGenClient::ReceiveFrame()
+{
+    unsigned char* pCurCodedData = nullptr;
+    int            iNumCodedBytes;
+
+    if ( Channel.GetData ( vecbyNetwData, iCeltNumCodedBytes, iNumCodedBytes ) == GS_BUFFER_OK )
+    {
+        pCurCodedData = &vecbyNetwData[0];
+    }
+    else
+    {
+        iNumCodedBytes = iCeltNumCodedBytes;
+    }
+
+    // for lost packets the null pointer invokes the packet loss concealment
+    opus_custom_decode_float ( OpusDecoder,
+                               pCurCodedData,
+                               iNumCodedBytes,
+                               &vecfAudio[0],
+                               iFrameSizeSamples );
+}
+
+QString CLoadGenClient::GetReport()
+{
+    CChannelNetStats NetStats;
+    Channel.GetNetStats ( NetStats );
+
+    const int iNumReceived  = NetStats.iNumReceived - LastNetStats.iNumReceived;
+    const int iNumLost      = NetStats.iNumLost - LastNetStats.iNumLost;
+    const int iNumUnderruns = NetStats.iNumUnderruns - LastNetStats.iNumUnderruns;
+    const int iNumExpected  = iNumReceived + iNumLost;
+
+    // the latency is the round trip time and the delay of the jitter buffers
+    // at the client and the server (the server uses the same auto jitter
+    // buffer size)
+    const double dFrameDurMs = 1000.0 * iFrameSizeSamples / SYSTEM_SAMPLE_RATE_HZ;
+    const int    iJitBufMs   = MathUtils::round ( 2 * Channel.GetSockBufNumFrames() * dFrameDurMs );
+
+    const QString strReport = QString ( "Client %1: %2, ping %3 ms, latency %4 ms, sent %5 (%6 dropped), "
+                                        "received %7, lost %8 (%9 %), %10 underruns" ).
+        arg ( iClientIdx + 1 ).
+        arg ( Channel.IsConnected() ? "connected" : "not connected" ).
+        arg ( iPingMs ).
+        arg ( iPingMs + iJitBufMs ).
+        arg ( iNumSent ).
+        arg ( iNumDropped ).
+        arg ( iNumReceived ).
+        arg ( iNumLost ).
+        arg ( iNumExpected > 0 ? 100.0 * iNumLost / iNumExpected : 0.0, 0, 'f', 1 ).
+        arg ( iNumUnderruns );
+
+    // the statistics are reset for the next interval
+    LastNetStats = NetStats;
+    iNumSent     = 0;
+    iNumDropped  = 0;
+
+    return strReport;
+}
+
+
+// CLoadGenerator implementation -----------------------------------------------
+CLoadGenerator::CLoadGenerator ( const QString& strServerAddr,
+                                 const QString& strSettings ) :
+    HighPrecisionTimer ( false ), // tick of SYSTEM_FRAME_SIZE_SAMPLES
+    iTick              ( 0 ),
+    iPingCnt           ( 0 )
+{
+    int          iOpusError;
+    CHostAddress ServerAddr;
+
+    if ( !Settings.Parse ( strSettings ) )
+    {
+        throw CGenErr ( "Invalid load generator settings: " + strSettings );
+    }
+
+    if ( !NetworkUtil().ParseNetworkAddress ( strServerAddr, ServerAddr ) )
+    {
+        throw CGenErr ( "Invalid server address of the load generator: " + strServerAddr );
+    }
+
+    OpusMode = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                         Settings.eAudComprType == CT_OPUS64 ?
+                                             SYSTEM_FRAME_SIZE_SAMPLES : DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES,
+                                         &iOpusError );
+
+    vecpClients.Init ( Settings.iNumClients );
+
+    for ( int i = 0; i < Settings.iNumClients; i++ )
+    {
+        vecpClients[i] = new CLoadGenClient ( i, ServerAddr, Settings, OpusMode );
+    }
+
+    QObject::connect ( &HighPrecisionTimer, &CHighPrecisionTimer::timeout,
+        this, &CLoadGenerator::OnTimer );
+
+    QObject::connect ( &TimerPing, &QTimer::timeout,
+        this, &CLoadGenerator::OnTimerPing );
+
+    HighPrecisionTimer.Start();
+    TimerPing.start ( LOADGEN_PING_INTERVAL_MS );
+}
+
+CLoadGenerator::~CLoadGenerator()
+{
+    HighPrecisionTimer.Stop();
+
+    for ( int i = 0; i < vecpClients.Size(); i++ )
+    {
+        delete vecpClients[i];
+    }
+
+    opus_custom_mode_destroy ( OpusMode );
+}
+
+void CLoadGenerator::OnTimer()
+{
+    for ( int i = 0; i < vecpClients.Size(); i++ )
+    {
+        vecpClients[i]->OnTick ( iTick );
+    }
+
+    iTick++;
+}
+
+void CLoadGenerator::OnTimerPing()
+{
+    for ( int i = 0; i < vecpClients.Size(); i++ )
+    {
+        vecpClients[i]->SendPing();
+    }
+
+    // report the statistics of all clients
+    if ( ++iPingCnt >= LOADGEN_REPORT_INTERVAL_S * 1000 / LOADGEN_PING_INTERVAL_MS )
+    {
+        iPingCnt = 0;
+
+        for ( int i = 0; i < vecpClients.Size(); i++ )
+        {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+            qInfo() << qUtf8Printable ( vecpClients[i]->GetReport() );
+#endif
+        }
+    }
+}
@@ -0,0 +1,177 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QString>
+#include <QStringList>
+#include "global.h"
+#include "util.h"
+#include "protocol.h"
+#include "socket.h"
+#include "channel.h"
+#include "client.h"
+#include "server.h"
+
+
+/* Definitions ****************************************************************/
+// maximum number of simulated clients of the load generator
+#define LOADGEN_MAX_NUM_CLIENTS          MAX_NUM_CHANNELS
+
+// interval of the statistics report and the ping measurement
+#define LOADGEN_REPORT_INTERVAL_S        5
+#define LOADGEN_PING_INTERVAL_MS         1000
+
+// test tone of the simulated clients (full scale is +-1)
+#define LOADGEN_TONE_AMPLITUDE           0.1
+#define LOADGEN_PI                       3.14159265358979323846
+
+
+/* Classes ********************************************************************/
+// Settings of the load generator, given as a comma separated list, e.g.
+// "20,opus64,mono,jitter=5,loss=1" (number of clients, 64 samples frames
+// instead of 128, mono instead of stereo, send jitter in ms and packet loss
+// in percent).
+class CLoadGenSettings
+{
+public:
+    CLoadGenSettings() : iNumClients ( 0 ), eAudComprType ( CT_OPUS ),
+        iNumAudioChannels ( 2 ), dJitterMs ( 0.0 ), dLossRate ( 0.0 ) {}
+
+    // returns false if the settings string is invalid
+    bool Parse ( const QString& strSettings );
+
+    int           iNumClients;
+    EAudComprType eAudComprType;
+    int           iNumAudioChannels;
+    double        dJitterMs;
+    double        dLossRate; // 0..1
+};
+
+
+// One simulated client: it has its own socket and channel (i.e. it looks
+// like a real client to the server), sends a test tone encoded with OPUS at
+// the real frame rate and receives and decodes its mix.
+class CLoadGenClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    CLoadGenClient ( const int               iNClientIdx,
+                     const CHostAddress&     NServerAddr,
+                     const CLoadGenSettings& NSettings,
+                     OpusCustomMode*         pOpusMode );
+
+    virtual ~CLoadGenClient();
+
+    // called on each timer tick of SYSTEM_FRAME_SIZE_SAMPLES
+    void OnTick ( const qint64 iTick );
+
+    void    SendPing() { ConnLessProtocol.CreateCLPingMes ( Channel.GetAddress(), PreciseTime.elapsed() ); }
+    QString GetReport();
+
+protected:
+    void SendFrame();
+    void ReceiveFrame();
+    int  GetRandomJitterTicks() const;
+
+    static double GetRandomUniform() { return static_cast<double> ( rand() ) / RAND_MAX; }
+
+    int                 iClientIdx;
+    CLoadGenSettings    Settings;
+    CChannel            Channel;
+    CHighPrioSocket     Socket;
+    CProtocol           ConnLessProtocol;
+    CPreciseTime        PreciseTime;
+    OpusCustomEncoder*  OpusEncoder;
+    OpusCustomDecoder*  OpusDecoder;
+
+    int                 iFrameSizeSamples;
+    int                 iTicksPerFrame;
+    int                 iCeltNumCodedBytes;
+    CVector<float>      vecfAudio;
+    CVector<uint8_t>    vecCeltData;
+    CVector<uint8_t>    vecRedCeltData;
+    CVector<uint8_t>    vecbyNetwData;
+    double              dPhase;
+    double              dPhaseInc;
+
+    // the frames are sent in order at their nominal time plus a random delay
+    qint64              iNextFrame;
+    qint64              iNextFrameSendTick;
+
+    // statistics of the current report interval
+    int                 iNumSent;
+    int                 iNumDropped;
+    int                 iPingMs;
+    CChannelNetStats    LastNetStats;
+
+public slots:
+    void OnSendProtMessage ( CProtMessage Message )
+        { Socket.SendPacket ( Message, Channel.GetAddress() ); }
+
+    void OnSendCLProtMessage ( CHostAddress InetAddr, CProtMessage Message )
+        { Socket.SendPacket ( Message, InetAddr ); }
+
+    void OnDetectedCLMessage ( CProtMessage MesBody,
+                               int          iRecID,
+                               CHostAddress RecHostAddr )
+        { ConnLessProtocol.ParseConnectionLessMessageBody ( MesBody, iRecID, RecHostAddr ); }
+
+    void OnReqJittBufSize() { Channel.CreateJitBufMes ( AUTO_NET_BUF_SIZE_FOR_PROTOCOL ); }
+    void OnReqChanInfo();
+    void OnNewConnection();
+    void OnCLPingReceived ( CHostAddress, int iMs ) { iPingMs = PreciseTime.elapsed() - iMs; }
+};
+
+
+// Headless load generator which simulates a number of clients from one
+// process so that the capacity of a server can be measured without real
+// musicians. All clients are driven by the same high precision timer.
+class CLoadGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    CLoadGenerator ( const QString& strServerAddr,
+                     const QString& strSettings );
+
+    virtual ~CLoadGenerator();
+
+protected:
+    CLoadGenSettings         Settings;
+    OpusCustomMode*          OpusMode;
+    CVector<CLoadGenClient*> vecpClients;
+    CHighPrecisionTimer      HighPrecisionTimer;
+    QTimer                   TimerPing;
+    qint64                   iTick;
+    int                      iPingCnt;
+
+public slots:
+    void OnTimer();
+    void OnTimerPing();
+};
@@ -27,6 +27,8 @@
 #include <QTextStream>
 #include <QTranslator>
 #include <QLibraryInfo>
+#include <QElapsedTimer>
+#include <QTimer>
 #include "global.h"
 #ifndef HEADLESS
 # include <QApplication>
@@ -36,6 +38,14 @@
 #endif
 #include "settings.h"
 #include "testbench.h"
+#include "loadgenerator.h"
+#include "relay.h"
+#include "serverbenchmark.h"
+#include "microbenchmark.h"
+#include "benchmarksuite.h"
+#include "threadsched.h"
+#include "tracer.h"
+#include "flightrecorder.h"
 #include "util.h"
 #ifdef ANDROID
 # include <QtAndroidExtras/QtAndroid>
@@ -49,8 +59,27 @@
 
 int main ( int argc, char** argv )
 {
+    // the time from the launch to the first window is logged, with --timing
+    // also the time of each startup phase
+    QElapsedTimer StartupTimer;
+    StartupTimer.start();
 
     QTextStream& tsConsole = *( ( new ConsoleWriterFactory() )->get() );
+    bool         bStartupTiming = false;
+    qint64       iLastPhaseMs   = 0;
+
+    auto StartupPhaseDone = [&] ( const char* strPhase )
+    {
+        if ( bStartupTiming )
+        {
+            const qint64 iNowMs = StartupTimer.elapsed();
+
+            tsConsole << "- startup phase " << strPhase << ": " << ( iNowMs - iLastPhaseMs ) <<
+                " ms (total " << iNowMs << " ms)" << endl;
+
+            iLastPhaseMs = iNowMs;
+        }
+    };
     QString      strArgument;
     double       rDbleArgument;
 
@@ -70,13 +99,32 @@ int main ( int argc, char** argv )
     bool         bShowAnalyzerConsole        = false;
     bool         bCentServPingServerInList   = false;
     bool         bNoAutoJackConnect          = false;
+    bool         bListenerMode               = false;
     bool         bUseTranslation             = true;
     bool         bCustomPortNumberGiven      = false;
+    bool         bEnableFrameProfiling       = false;
+    bool         bRecordFlac                 = false;
+    bool         bRecordMix                  = false;
+    bool         bRunBenchmark               = false;
+    bool         bReplayFast                 = false;
+    bool         bConnectedSockets           = false;
+    bool         bAdmissionControl           = false;
+    bool         bPacing                     = false;
+    bool         bLockMemory                 = false;
+    bool         bUseIoUring                 = false;
     int          iNumServerChannels          = DEFAULT_USED_NUM_CHANNELS;
+    int          iNumServerThreads           = 0; // no worker threads per default
+    int          iNumServerRecvThreads       = 1; // one receive socket per default
+    int          iNumServerRooms             = 0; // no multi-room mode per default
     int          iMaxDaysHistory             = DEFAULT_DAYS_HISTORY;
+    int          iLogFlushIntervalMs         = LOG_DEFAULT_FLUSH_INTERVAL_MS;
+    int          iLogMaxFileSizeMB           = 0; // no log rotation per default
+    int          iStreamBitRateKbps          = STREAM_DEFAULT_BITRATE_KBPS;
     int          iCtrlMIDIChannel            = INVALID_MIDI_CH;
+    int          iMixGroup                   = NO_MIX_GROUP;
     quint16      iPortNumber                 = DEFAULT_PORT_NUMBER;
     ELicenceType eLicenceType                = LT_NO_LICENCE;
+    recorder::ERecorderOverflowPolicy eRecorderOverflowPolicy = recorder::ROP_DROP_FRAMES;
     QString      strConnOnStartupAddress     = "";
     QString      strIniFileName              = "";
     QString      strHTMLStatusFileName       = "";
@@ -86,6 +134,25 @@ int main ( int argc, char** argv )
     QString      strRecordingDirName         = "";
     QString      strCentralServer            = "";
     QString      strServerInfo               = "";
+    QString      strFederationPeers          = "";
+    QString      strServerPool               = "";
+    QString      strMetricsBindAddress       = "";
+    QString      strStreamBindAddress        = "";
+    QString      strServerFx                 = "";
+    QString      strCaptureFileName          = "";
+    QString      strReplayFileName           = "";
+    QString      strCascadeAddress           = "";
+    QString      strAllowedRelays            = "";
+    QString      strRelayServerAddress       = "";
+    QString      strMulticastGroup           = "";
+    QString      strMicroBenchmark           = "";
+    QString      strTraceFileName            = "";
+    QString      strFlightRecDirName         = "";
+    QString      strBenchmarkResultFileName  = "";
+    QString      strExportRecordingsDirName  = "";
+    QString      strBenchmarkBaseFileName    = "";
+    double       dBenchmarkTolerancePercent  = BENCHMARK_DEFAULT_TOLERANCE_PERCENT;
+    QString      strLoadGenerator            = "";
     QString      strWelcomeMessage           = "";
     QString      strClientName               = APP_NAME;
 
@@ -163,6 +230,186 @@ int main ( int argc, char** argv )
         }
 
 
+        // Number of threads for the server audio processing -------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "-T",
+                                  "--numthreads",
+                                  0,
+                                  MAX_NUM_SERVER_THREADS,
+                                  rDbleArgument ) )
+        {
+            iNumServerThreads = static_cast<int> ( rDbleArgument );
+
+            tsConsole << "- number of server processing threads: "
+                << iNumServerThreads << endl;
+
+            continue;
+        }
+
+
+        // Number of receive threads for the server ----------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "--recvthreads", // no short form
+                                  "--recvthreads",
+                                  1,
+                                  MAX_NUM_SERVER_RECV_SHARDS,
+                                  rDbleArgument ) )
+        {
+            iNumServerRecvThreads = static_cast<int> ( rDbleArgument );
+
+            tsConsole << "- number of server receive threads: "
+                << iNumServerRecvThreads << endl;
+
+            continue;
+        }
+
+
+        // Connected socket per client -----------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--connectedsockets", // no short form
+                               "--connectedsockets" ) )
+        {
+            bConnectedSockets = true;
+            tsConsole << "- use a connected socket per client" << endl;
+            continue;
+        }
+
+
+        // Admission control ---------------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--admissioncontrol", // no short form
+                               "--admissioncontrol" ) )
+        {
+            bAdmissionControl = true;
+            tsConsole << "- accept new clients depending on the processing time" << endl;
+            continue;
+        }
+
+
+        // Pacing of the audio packets -----------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--pacing", // no short form
+                               "--pacing" ) )
+        {
+            bPacing = true;
+            tsConsole << "- pace the audio packets of a frame" << endl;
+            continue;
+        }
+
+
+        // Scheduling of the timer thread --------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--timersched", // no short form
+                                 "--timersched",
+                                 strArgument ) )
+        {
+            if ( !CThreadScheduling::SetConfig ( TR_TIMER, strArgument ) )
+            {
+                tsConsole << argv[0] << ": invalid scheduling '" << strArgument <<
+                    "' -- use '--help' for help" << endl;
+                exit ( 1 );
+            }
+
+            tsConsole << "- " << CThreadScheduling::GetConfigDescription ( TR_TIMER ) << endl;
+            continue;
+        }
+
+        // Scheduling of the socket threads ------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--socketsched", // no short form
+                                 "--socketsched",
+                                 strArgument ) )
+        {
+            if ( !CThreadScheduling::SetConfig ( TR_SOCKET, strArgument ) )
+            {
+                tsConsole << argv[0] << ": invalid scheduling '" << strArgument <<
+                    "' -- use '--help' for help" << endl;
+                exit ( 1 );
+            }
+
+            tsConsole << "- " << CThreadScheduling::GetConfigDescription ( TR_SOCKET ) << endl;
+            continue;
+        }
+
+        // Scheduling of the worker threads ------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--workersched", // no short form
+                                 "--workersched",
+                                 strArgument ) )
+        {
+            if ( !CThreadScheduling::SetConfig ( TR_WORKER, strArgument ) )
+            {
+                tsConsole << argv[0] << ": invalid scheduling '" << strArgument <<
+                    "' -- use '--help' for help" << endl;
+                exit ( 1 );
+            }
+
+            tsConsole << "- " << CThreadScheduling::GetConfigDescription ( TR_WORKER ) << endl;
+            continue;
+        }
+
+
+        // Lock the memory -----------------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--mlock", // no short form
+                               "--mlock" ) )
+        {
+            bLockMemory = true;
+            continue;
+        }
+
+
+        // io_uring socket transport -------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--iouring", // no short form
+                               "--iouring" ) )
+        {
+            bUseIoUring = true;
+            tsConsole << "- use the io_uring socket transport" << endl;
+            continue;
+        }
+
+
+        // Number of additional rooms of the server ----------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "--rooms", // no short form
+                                  "--rooms",
+                                  0,
+                                  MAX_NUM_SERVER_ROOMS,
+                                  rDbleArgument ) )
+        {
+            iNumServerRooms = static_cast<int> ( rDbleArgument );
+
+            tsConsole << "- number of additional server rooms: "
+                << iNumServerRooms << endl;
+
+            continue;
+        }
+
+
         // Maximum days in history display -------------------------------------
         if ( GetNumericArgument ( tsConsole,
                                   argc,
@@ -219,6 +466,30 @@ int main ( int argc, char** argv )
         }
 
 
+        // Frame stage profiling of the server ---------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--profile", // no short form
+                               "--profile" ) )
+        {
+            bEnableFrameProfiling = true;
+            tsConsole << "- frame stage profiling enabled" << endl;
+            continue;
+        }
+
+
+        // Replay as fast as possible ------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--replayfast", // no short form
+                               "--replayfast" ) )
+        {
+            bReplayFast = true;
+            tsConsole << "- replay the packets as fast as possible" << endl;
+            continue;
+        }
+
+
         // Disabling auto Jack connections -------------------------------------
         if ( GetFlagArgument ( argv,
                                i,
@@ -231,6 +502,35 @@ int main ( int argc, char** argv )
         }
 
 
+        // Listener mode -------------------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--listener", // no short form
+                               "--listener" ) )
+        {
+            bListenerMode = true;
+            tsConsole << "- listener mode (own audio is not sent)" << endl;
+            continue;
+        }
+
+
+        // Mix group -----------------------------------------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "--mixgroup", // no short form
+                                  "--mixgroup",
+                                  NO_MIX_GROUP,
+                                  MAX_NUM_MIX_GROUPS,
+                                  rDbleArgument ) )
+        {
+            iMixGroup = static_cast<int> ( rDbleArgument );
+            tsConsole << "- mix group (section) of the own audio: " << iMixGroup << endl;
+            continue;
+        }
+
+
         // Disable translations ------------------------------------------------
         if ( GetFlagArgument ( argv,
                                i,
@@ -243,6 +543,18 @@ int main ( int argc, char** argv )
         }
 
 
+        // Startup phase timing ------------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--timing",
+                               "--timing" ) )
+        {
+            bStartupTiming = true;
+            tsConsole << "- startup phase timing enabled" << endl;
+            continue;
+        }
+
+
         // Show all registered servers in the server list ----------------------
         // Undocumented debugging command line argument: Show all registered
         // servers in the server list regardless if a ping to the server is
@@ -304,6 +616,40 @@ int main ( int argc, char** argv )
         }
 
 
+        // Logging flush interval ----------------------------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "--logflush", // no short form
+                                  "--logflush",
+                                  0,
+                                  60000,
+                                  rDbleArgument ) )
+        {
+            iLogFlushIntervalMs = static_cast<int> ( rDbleArgument );
+            tsConsole << "- logging flush interval: " << iLogFlushIntervalMs << " ms" << endl;
+            continue;
+        }
+
+
+        // Logging file rotation -----------------------------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "--logrotate", // no short form
+                                  "--logrotate",
+                                  0,
+                                  10000,
+                                  rDbleArgument ) )
+        {
+            iLogMaxFileSizeMB = static_cast<int> ( rDbleArgument );
+            tsConsole << "- logging file rotation at: " << iLogMaxFileSizeMB << " MB" << endl;
+            continue;
+        }
+
+
         // Port number ---------------------------------------------------------
         if ( GetNumericArgument ( tsConsole,
                                   argc,
@@ -395,6 +741,182 @@ int main ( int argc, char** argv )
         }
 
 
+        // Recording format ----------------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--flac", // no short form
+                               "--flac" ) )
+        {
+            bRecordFlac = true;
+            tsConsole << "- record in FLAC format" << endl;
+            continue;
+        }
+
+
+        // Record the mix only -------------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--recordmix", // no short form
+                               "--recordmix" ) )
+        {
+            bRecordMix = true;
+            tsConsole << "- record the mix of all clients only" << endl;
+            continue;
+        }
+
+
+        // Recorder overflow policy --------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--recordoverflow", // no short form
+                                 "--recordoverflow",
+                                 strArgument ) )
+        {
+            if ( strArgument == "drop" )
+            {
+                eRecorderOverflowPolicy = recorder::ROP_DROP_FRAMES;
+            }
+            else if ( strArgument == "pause" )
+            {
+                eRecorderOverflowPolicy = recorder::ROP_PAUSE_TRACKS;
+            }
+            else if ( strArgument == "stop" )
+            {
+                eRecorderOverflowPolicy = recorder::ROP_STOP_RECORDING;
+            }
+            else
+            {
+                tsConsole << argv[0] << ": invalid recorder overflow policy '" << strArgument <<
+                    "' -- use '--help' for help" << endl;
+                exit ( 1 );
+            }
+
+            tsConsole << "- recorder overflow policy: " << strArgument << endl;
+            continue;
+        }
+
+
+        // Export the recorded sessions ----------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--exportrecordings", // no short form
+                                 "--exportrecordings",
+                                 strArgument ) )
+        {
+            strExportRecordingsDirName = strArgument;
+            tsConsole << "- export the recorded sessions in: " << strExportRecordingsDirName << endl;
+            continue;
+        }
+
+
+        // Server benchmark ----------------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--benchmark", // no short form
+                               "--benchmark" ) )
+        {
+            bRunBenchmark = true;
+            tsConsole << "- run the server benchmark" << endl;
+            continue;
+        }
+
+
+        // Micro-benchmarks ----------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--microbenchmark", // no short form
+                                 "--microbenchmark",
+                                 strArgument ) )
+        {
+            strMicroBenchmark = strArgument;
+            tsConsole << "- run the micro-benchmarks: " << strMicroBenchmark << endl;
+            continue;
+        }
+
+
+        // Benchmark suite -----------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--benchmarksuite", // no short form
+                                 "--benchmarksuite",
+                                 strArgument ) )
+        {
+            strBenchmarkResultFileName = strArgument;
+            tsConsole << "- run the benchmark suite, result file: " << strBenchmarkResultFileName << endl;
+            continue;
+        }
+
+
+        // Baseline of the benchmark suite -------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--benchmarkbaseline", // no short form
+                                 "--benchmarkbaseline",
+                                 strArgument ) )
+        {
+            strBenchmarkBaseFileName = strArgument;
+            tsConsole << "- benchmark baseline file: " << strBenchmarkBaseFileName << endl;
+            continue;
+        }
+
+
+        // Tolerance of the benchmark suite ------------------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "--benchmarktolerance", // no short form
+                                  "--benchmarktolerance",
+                                  0,
+                                  1000,
+                                  rDbleArgument ) )
+        {
+            dBenchmarkTolerancePercent = rDbleArgument;
+            tsConsole << "- benchmark tolerance: " << dBenchmarkTolerancePercent << " %" << endl;
+            continue;
+        }
+
+
+        // Trace of the real-time threads --------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--trace", // no short form
+                                 "--trace",
+                                 strArgument ) )
+        {
+            strTraceFileName = strArgument;
+            tsConsole << "- trace file: " << strTraceFileName << endl;
+            continue;
+        }
+
+
+        // Directory of the flight recorder dumps ------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--flightrecdir", // no short form
+                                 "--flightrecdir",
+                                 strArgument ) )
+        {
+            strFlightRecDirName = strArgument;
+            tsConsole << "- flight recorder directory: " << strFlightRecDirName << endl;
+            continue;
+        }
+
+
         // Central server ------------------------------------------------------
         if ( GetStringArgument ( tsConsole,
                                  argc,
@@ -425,6 +947,188 @@ int main ( int argc, char** argv )
         }
 
 
+        // Federation of central servers --------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--federation", // no short form
+                                 "--federation",
+                                 strArgument ) )
+        {
+            strFederationPeers = strArgument;
+            tsConsole << "- federation central servers: " << strFederationPeers << endl;
+            continue;
+        }
+
+
+        // Server pool ---------------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--serverpool", // no short form
+                                 "--serverpool",
+                                 strArgument ) )
+        {
+            strServerPool = strArgument;
+            tsConsole << "- server pool: " << strServerPool << endl;
+            continue;
+        }
+
+
+        // Metrics exporter ----------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--metrics", // no short form
+                                 "--metrics",
+                                 strArgument ) )
+        {
+            strMetricsBindAddress = strArgument;
+            tsConsole << "- metrics exporter: " << strMetricsBindAddress << endl;
+            continue;
+        }
+
+
+        // Live stream ---------------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--stream", // no short form
+                                 "--stream",
+                                 strArgument ) )
+        {
+            strStreamBindAddress = strArgument;
+            tsConsole << "- live stream: " << strStreamBindAddress << endl;
+            continue;
+        }
+
+
+        // Bit rate of the live stream -----------------------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "--streambitrate", // no short form
+                                  "--streambitrate",
+                                  STREAM_MIN_BITRATE_KBPS,
+                                  STREAM_MAX_BITRATE_KBPS,
+                                  rDbleArgument ) )
+        {
+            iStreamBitRateKbps = static_cast<int> ( rDbleArgument );
+            tsConsole << "- live stream bit rate: " << iStreamBitRateKbps << " kbps" << endl;
+            continue;
+        }
+
+
+        // Server effects ------------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--serverfx", // no short form
+                                 "--serverfx",
+                                 strArgument ) )
+        {
+            strServerFx = strArgument;
+            tsConsole << "- server effects: " << strServerFx << endl;
+            continue;
+        }
+
+
+        // Packet capture ------------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--capture", // no short form
+                                 "--capture",
+                                 strArgument ) )
+        {
+            strCaptureFileName = strArgument;
+            tsConsole << "- packet capture file: " << strCaptureFileName << endl;
+            continue;
+        }
+
+
+        // Packet replay -------------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--replay", // no short form
+                                 "--replay",
+                                 strArgument ) )
+        {
+            strReplayFileName = strArgument;
+            tsConsole << "- packet replay file: " << strReplayFileName << endl;
+            continue;
+        }
+
+
+        // Cascade (parent server address) -------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--cascade", // no short form
+                                 "--cascade",
+                                 strArgument ) )
+        {
+            strCascadeAddress = strArgument;
+            tsConsole << "- cascade to parent server: " << strCascadeAddress << endl;
+            continue;
+        }
+
+
+        // Allowed relays ------------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--allowrelay", // no short form
+                                 "--allowrelay",
+                                 strArgument ) )
+        {
+            strAllowedRelays = strArgument;
+            tsConsole << "- allowed relays: " << strAllowedRelays << endl;
+            continue;
+        }
+
+
+        // Multicast group of the shared streams --------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--multicast", // no short form
+                                 "--multicast",
+                                 strArgument ) )
+        {
+            strMulticastGroup = strArgument;
+            tsConsole << "- multicast group: " << strMulticastGroup << endl;
+            continue;
+        }
+
+
+        // Relay mode (server address) -----------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--relay", // no short form
+                                 "--relay",
+                                 strArgument ) )
+        {
+            strRelayServerAddress = strArgument;
+            tsConsole << "- relay to server: " << strRelayServerAddress << endl;
+            continue;
+        }
+
+
         // Server welcome message ----------------------------------------------
         if ( GetStringArgument ( tsConsole,
                                  argc,
@@ -470,6 +1174,21 @@ int main ( int argc, char** argv )
         }
 
 
+        // Load generator ------------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--loadgen", // no short form
+                                 "--loadgen",
+                                 strArgument ) )
+        {
+            strLoadGenerator = strArgument;
+            tsConsole << "- load generator: " << strLoadGenerator << endl;
+            continue;
+        }
+
+
         // Version number ------------------------------------------------------
         if ( ( !strcmp ( argv[i], "--version" ) ) ||
              ( !strcmp ( argv[i], "-v" ) ) )
@@ -502,6 +1221,12 @@ int main ( int argc, char** argv )
 #endif
     }
 
+    // the memory is locked before the threads are started
+    if ( bLockMemory )
+    {
+        tsConsole << "- " << CThreadScheduling::LockMemory() << endl;
+    }
+
 #ifdef HEADLESS
     if ( bUseGUI )
     {
@@ -515,6 +1240,80 @@ int main ( int argc, char** argv )
 
 
     // Dependencies ------------------------------------------------------------
+    // the server benchmark does not need the application object, it only
+    // writes the results
+    if ( bRunBenchmark )
+    {
+        CServerBenchmark Benchmark ( iNumServerThreads );
+        Benchmark.Run ( tsConsole );
+        exit ( 0 );
+    }
+
+    // the export of the recorded sessions (e.g. by a nightly job) quits when
+    // all sessions are exported, the sessions are exported in parallel
+    if ( !strExportRecordingsDirName.isEmpty() )
+    {
+        const int iNumFailed = recorder::CJamRecorder::SessionDirsToProjects (
+            strExportRecordingsDirName,
+            bUseDoubleSystemFrameSize ? DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES : SYSTEM_FRAME_SIZE_SAMPLES,
+            iNumServerThreads,
+            tsConsole );
+
+        exit ( iNumFailed > 0 ? 1 : 0 );
+    }
+
+    if ( !strMicroBenchmark.isEmpty() )
+    {
+        // the protocol uses timers which need the application object
+        QCoreApplication App ( argc, argv );
+
+        CMicroBenchmark MicroBenchmark ( strMicroBenchmark );
+        MicroBenchmark.Run ( tsConsole );
+        exit ( 0 );
+    }
+
+    // the benchmark suite fails if there are regressions compared to the
+    // baseline so that it can be used in scripts
+    if ( !strBenchmarkResultFileName.isEmpty() )
+    {
+        QCoreApplication App ( argc, argv );
+
+        try
+        {
+            CBenchmarkSuite BenchmarkSuite ( iNumServerThreads, dBenchmarkTolerancePercent );
+
+            exit ( BenchmarkSuite.Run ( tsConsole,
+                                        strBenchmarkResultFileName,
+                                        strBenchmarkBaseFileName ) > 0 ? 1 : 0 );
+        }
+
+        catch ( CGenErr generr )
+        {
+            tsConsole << generr.GetErrorText() << endl;
+            exit ( 1 );
+        }
+    }
+
+    // the load generator is a headless client mode which needs the server
+    // address
+    if ( !strLoadGenerator.isEmpty() )
+    {
+        if ( !bIsClient || strConnOnStartupAddress.isEmpty() )
+        {
+            tsConsole << "The load generator requires a server address (--connect)." << endl;
+            exit ( 1 );
+        }
+
+        bUseGUI = false;
+    }
+
+    // the relay is a headless mode which uses the server port
+    if ( !strRelayServerAddress.isEmpty() )
+    {
+        bIsClient = false;
+        bUseGUI   = false;
+    }
+
     // per definition: if we are in "GUI" server mode and no central server
     // address is given, we use the default central server address
     if ( !bIsClient && bUseGUI && strCentralServer.isEmpty() )
@@ -535,6 +1334,8 @@ int main ( int argc, char** argv )
         tsConsole << "Qt5 requires a windowing system to paint a JPEG image; image will use SVG" << endl;
     }
     
+    StartupPhaseDone ( "arguments" );
+
     // Application/GUI setup ---------------------------------------------------
     // Application object
 #ifdef HEADLESS
@@ -579,13 +1380,16 @@ int main ( int argc, char** argv )
     activity.BeginActivity();
 #endif
 
+    StartupPhaseDone ( "application" );
+
     // init resources
     Q_INIT_RESOURCE(resources);
 
-    // load translations
+    // load translations (the texts of the sources are English, i.e. for an
+    // English locale no translation files are searched)
     QTranslator myappTranslator, myqtTranslator;
 
-    if ( bUseGUI && bUseTranslation )
+    if ( bUseGUI && bUseTranslation && ( QLocale().language() != QLocale::English ) )
     {
         if ( myappTranslator.load ( QLocale(), "translation", "_", ":/translations" ) )
         {
@@ -599,6 +1403,8 @@ int main ( int argc, char** argv )
         }
     }
 
+    StartupPhaseDone ( "translations" );
+
 
 // TEST -> activate the following line to activate the test bench,
 //CTestbench Testbench ( "127.0.0.1", DEFAULT_PORT_NUMBER );
@@ -606,7 +1412,37 @@ int main ( int argc, char** argv )
 
     try
     {
-        if ( bIsClient )
+        // the tracing must be initialized before the traced threads start
+        if ( !strTraceFileName.isEmpty() )
+        {
+            CTracer::Init ( strTraceFileName );
+        }
+
+        // the flight recorders of the server and client are always on, only
+        // the directory of the dumps can be set
+        CFlightRecorder::SetDirectory ( strFlightRecDirName );
+
+        if ( !strRelayServerAddress.isEmpty() )
+        {
+            // Relay: forwards the clients on our port to the server
+            CRelay Relay ( iPortNumber,
+                           strRelayServerAddress );
+
+            tsConsole << GetVersionAndNameStr ( false ) << endl;
+
+            pApp->exec();
+        }
+        else if ( !strLoadGenerator.isEmpty() )
+        {
+            // Load generator: simulated clients without sound card
+            CLoadGenerator LoadGenerator ( strConnOnStartupAddress,
+                                           strLoadGenerator );
+
+            tsConsole << GetVersionAndNameStr ( false ) << endl;
+
+            pApp->exec();
+        }
+        else if ( bIsClient )
         {
             // Client:
             // actual client object
@@ -616,10 +1452,18 @@ int main ( int argc, char** argv )
                              bNoAutoJackConnect,
                              strClientName );
 
-            // load settings from init-file
+            StartupPhaseDone ( "client (sound interface, codecs)" );
+
+            // load settings from init-file (the client is initialized once
+            // with all settings)
             CSettings Settings ( &Client, strIniFileName );
             Settings.Load();
 
+            StartupPhaseDone ( "settings (sound device)" );
+
+            Client.SetListenerMode ( bListenerMode );
+            Client.SetMixGroup ( iMixGroup );
+
 #ifndef HEADLESS
             if ( bUseGUI )
             {
@@ -633,8 +1477,19 @@ int main ( int argc, char** argv )
                                        nullptr,
                                        Qt::Window );
 
+                StartupPhaseDone ( "main window" );
+
                 // show dialog
                 ClientDlg.show();
+
+                // the first event of the event loop is processed after the
+                // window is shown
+                QTimer::singleShot ( 0, [&]()
+                {
+                    StartupPhaseDone ( "first window" );
+                    tsConsole << "- time to first window: " << StartupTimer.elapsed() << " ms" << endl;
+                } );
+
                 pApp->exec();
             }
             else
@@ -649,6 +1504,13 @@ int main ( int argc, char** argv )
         else
         {
             // Server:
+            // the transport is used by all sockets of the server (and of the
+            // additional rooms)
+            if ( bUseIoUring )
+            {
+                CSocketTransport::SetBackend ( TB_IO_URING );
+            }
+
             // actual server object
             CServer Server ( iNumServerChannels,
                              iMaxDaysHistory,
@@ -659,12 +1521,113 @@ int main ( int argc, char** argv )
                              strServerName,
                              strCentralServer,
                              strServerInfo,
+                             strFederationPeers,
                              strWelcomeMessage,
                              strRecordingDirName,
                              bCentServPingServerInList,
                              bDisconnectAllClientsOnQuit,
                              bUseDoubleSystemFrameSize,
-                             eLicenceType );
+                             eLicenceType,
+                             iNumServerThreads,
+                             iNumServerRecvThreads,
+                             bEnableFrameProfiling,
+                             bRecordFlac,
+                             bRecordMix,
+                             strMetricsBindAddress,
+                             strServerFx,
+                             strCaptureFileName,
+                             strReplayFileName,
+                             bReplayFast,
+                             iLogFlushIntervalMs,
+                             iLogMaxFileSizeMB,
+                             strCascadeAddress,
+                             bConnectedSockets );
+
+            StartupPhaseDone ( "server" );
+
+            Server.SetEnableAdmissionControl ( bAdmissionControl );
+
+            // only the main room is a member of the server pool
+            if ( !strServerPool.isEmpty() )
+            {
+                Server.SetServerListPool ( strServerPool );
+            }
+
+            if ( !strAllowedRelays.isEmpty() && !Server.SetAllowedRelays ( strAllowedRelays ) )
+            {
+                throw CGenErr ( "Invalid relay address: " + strAllowedRelays );
+            }
+
+            // only the main room uses the multicast groups (the clients of
+            // the rooms may use the same ports)
+            if ( !strMulticastGroup.isEmpty() && !Server.SetMulticastGroup ( strMulticastGroup ) )
+            {
+                throw CGenErr ( "Invalid multicast group address: " + strMulticastGroup );
+            }
+
+            Server.SetRecorderOverflowPolicy ( eRecorderOverflowPolicy );
+
+            // the live stream is only provided by the main room
+            if ( !strStreamBindAddress.isEmpty() )
+            {
+                Server.StartStreamOutput ( strStreamBindAddress, iStreamBitRateKbps );
+            }
+
+            if ( bPacing && !Server.SetEnablePacing() )
+            {
+                tsConsole << "Pacing is not supported on this system (SO_TXTIME)" << endl;
+            }
+
+            // the additional rooms of the multi-room mode use the following
+            // port numbers and share the timer and the worker pool of the main
+            // room (the logging, history, status file, recording and the other
+            // options with files are only used by the main room, a room only
+            // registers at a central server which is not this server)
+            const QString strRoomCentralServer =
+                Server.GetServerListIsCentralServer() ? QString() : strCentralServer;
+
+            std::vector<std::unique_ptr<CServer> > vecpRooms;
+
+            for ( int iRoom = 0; iRoom < iNumServerRooms; iRoom++ )
+            {
+                vecpRooms.emplace_back ( new CServer ( iNumServerChannels,
+                                                       iMaxDaysHistory,
+                                                       "", // no logging
+                                                       static_cast<quint16> ( iPortNumber + iRoom + 1 ),
+                                                       "", // no status file
+                                                       "", // no history
+                                                       strServerName,
+                                                       strRoomCentralServer,
+                                                       strServerInfo,
+                                                       "", // no federation
+                                                       strWelcomeMessage,
+                                                       "", // no recording
+                                                       bCentServPingServerInList,
+                                                       bDisconnectAllClientsOnQuit,
+                                                       bUseDoubleSystemFrameSize,
+                                                       eLicenceType,
+                                                       0, // worker pool of the main room
+                                                       iNumServerRecvThreads,
+                                                       bEnableFrameProfiling,
+                                                       bRecordFlac,
+                                                       bRecordMix,
+                                                       "", // no metrics
+                                                       strServerFx ) );
+
+                vecpRooms.back()->SetEnableAdmissionControl ( bAdmissionControl );
+
+                if ( !strAllowedRelays.isEmpty() )
+                {
+                    vecpRooms.back()->SetAllowedRelays ( strAllowedRelays );
+                }
+
+                if ( bPacing )
+                {
+                    vecpRooms.back()->SetEnablePacing();
+                }
+                Server.AddRoom ( vecpRooms.back().get() );
+                vecpRooms.back()->UpdateServerList();
+            }
 
 #ifndef HEADLESS
             if ( bUseGUI )
@@ -743,22 +1706,55 @@ QString UsageArguments ( char **argv )
         "\nRecognized options:\n"
         "  -h, -?, --help        display this help text and exit\n"
         "  -i, --inifile         initialization file name\n"
+        "  --benchmarksuite      run all benchmarks, write the results to the given\n"
+        "                        JSON file and exit\n"
+        "  --benchmarkbaseline   compare the benchmark suite results with the given\n"
+        "                        result file of a previous run, regressions give\n"
+        "                        the exit code 1\n"
+        "  --benchmarktolerance  tolerance of the baseline comparison in %\n"
+        "                        (default 10)\n"
+        "  --microbenchmark      run the micro-benchmarks which contain the given\n"
+        "                        name (all: run all) and exit\n"
         "  -n, --nogui           disable GUI\n"
         "  -p, --port            set your local port number\n"
         "  -t, --notranslation   disable translation (use englisch language)\n"
+        "  --timing              output the duration of the startup phases\n"
+        "  --trace               record the processing steps of the real-time\n"
+        "                        threads and write them to the given Chrome JSON\n"
+        "                        trace file on quit (SIGHUP stops/restarts)\n"
+        "  --flightrecdir        directory of the flight recorder files which are\n"
+        "                        written on underrun bursts or SIGQUIT (default:\n"
+        "                        the temporary directory)\n"
         "  -v, --version         output version information and exit\n"
         "\nServer only:\n"
         "  -a, --servername      server name, required for HTML status\n"
+        "  --allowrelay          addresses of the relays which may forward their\n"
+        "                        clients, separated by comma\n"
+        "  --benchmark           measure the maximum number of channels of the\n"
+        "                        server audio processing (uses --numthreads)\n"
+        "  --cascade             connect to the given parent server and exchange\n"
+        "                        the mix of the local clients with its mix\n"
         "  -d, --discononquit    disconnect all clients on quit\n"
         "  -D, --histdays        number of days of history to display\n"
         "  -e, --centralserver   address of the central server\n"
         "  -F, --fastupdate      use 64 samples frame size mode\n"
+        "  --federation          addresses of the other central servers which\n"
+        "                        share the server list, separated by ;\n"
+        "                        (central server only)\n"
         "  -g, --pingservers     ping servers in list to keep NAT port open\n"
         "                        (central server only)\n"
         "  -l, --log             enable logging, set file name\n"
+        "  --logflush            interval in ms in which the log lines are written\n"
+        "                        (0 writes each line immediately)\n"
+        "  --logrotate           rotate the log file at the given size in MB\n"
+        "                        (0 disables the rotation)\n"
         "  -L, --licence         a licence must be accepted on a new\n"
         "                        connection\n"
-        "  -m, --htmlstatus      enable HTML status file, set file name\n"
+        "  -m, --htmlstatus      enable HTML status file, set file name (a file\n"
+        "                        name with the extension .json selects JSON)\n"
+        "  --metrics             export metrics in the Prometheus format on\n"
+        "                        http://[address:]port/metrics (only the local\n"
+        "                        host is served if no address is given)\n"
         "  -o, --serverinfo      infos of the server(s) in the format:\n"
         "                        [name];[city];[country as QLocale ID]; ...\n"
         "                        [server1 address];[server1 name]; ...\n"
@@ -767,7 +1763,56 @@ QString UsageArguments ( char **argv )
         "                        [server2 address]; ...\n"
         "  -R, --recording       enables recording and sets directory to contain\n"
         "                        recorded jams\n"
+        "  --flac                record the jams in FLAC format instead of WAV\n"
+        "  --recordmix           record one stereo mix of all clients instead of\n"
+        "                        one file per client\n"
+        "  --recordoverflow      what happens if the recording cannot keep up:\n"
+        "                        drop (frames, default), pause (the tracks, a new\n"
+        "                        file is started when it caught up) or stop\n"
+        "  --exportrecordings    write the missing or outdated project files of all\n"
+        "                        sessions in the given recording directory and quit\n"
+        "                        (uses -F and --numthreads)\n"
         "  -s, --server          start server\n"
+        "  --serverfx            effects of all channels at the server in the\n"
+        "                        format [gain=dB],[comp],[reverb=send %]\n"
+        "  --serverpool          name of the server pool, the central server shows\n"
+        "                        the servers of a pool as one entry with the\n"
+        "                        address of the server with the lowest load\n"
+        "  --stream              live stream of the mix as Ogg/Opus on\n"
+        "                        http://[address:]port/stream.opus\n"
+        "  --streambitrate       bit rate of the live stream in kbps (default: 128)\n"
+        "  -T, --numthreads      number of threads for the audio processing\n"
+        "                        (0 disables the multithreaded processing)\n"
+        "  --profile             report the processing time of the frame stages\n"
+        "  --capture             write all received packets in a capture file\n"
+        "  --replay              process the packets of a capture file instead of\n"
+        "                        the network (nothing is sent) and quit\n"
+        "  --replayfast          replay as fast as possible instead of with the\n"
+        "                        original timing\n"
+        "  --relay               run a relay (headless) which forwards the clients\n"
+        "                        on the --port to the given server in aggregated\n"
+        "                        frames (the server needs --allowrelay)\n"
+        "  --recvthreads         number of receive sockets/threads on the same\n"
+        "                        port (Linux only; 1 disables it)\n"
+        "  --connectedsockets    receive each client on its own connected socket\n"
+        "                        on the server port (Linux only)\n"
+        "  --admissioncontrol    accept new clients (or only as listeners) depending\n"
+        "                        on the measured processing time of the server\n"
+        "  --pacing              spread the audio packets of a frame over the frame\n"
+        "                        interval (Linux only, needs the fq qdisc)\n"
+        "  --timersched          scheduling of the timer thread in the format\n"
+        "                        [policy][:priority][@cpus], e.g. fifo:80@2\n"
+        "                        (policy: other, fifo or rr, cpus: e.g. 4-7,10)\n"
+        "  --socketsched         scheduling of the socket threads (format as above)\n"
+        "  --workersched         scheduling of the worker threads (format as above)\n"
+        "  --multicast           send the shared mixes to the clients in the local\n"
+        "                        network by multicast, the mix n uses the given\n"
+        "                        group address + n\n"
+        "  --mlock               lock the memory of the process (Linux only)\n"
+        "  --iouring             use io_uring for the network packets (Linux only,\n"
+        "                        not combined with --connectedsockets)\n"
+        "  --rooms               number of additional rooms on the following port\n"
+        "                        numbers which are hosted by the same process\n"
         "  -u, --numchannels     maximum number of channels\n"
         "  -w, --welcomemessage  welcome message on connect\n"
         "  -y, --history         enable connection history and set file name\n"
@@ -777,6 +1822,13 @@ QString UsageArguments ( char **argv )
         "  -j, --nojackconnect   disable auto Jack connections\n"
         "  --ctrlmidich          MIDI controller channel to listen\n"
         "  --clientname          client name (window title and jack client name)\n"
+        "  --listener            only listen, the own audio is not sent to the server\n"
+        "  --mixgroup            mix group (section) of the own audio at the server,\n"
+        "                        e.g. the voice of a choir (1..8, 0: no group)\n"
+        "  --loadgen             simulate clients without sound card connected to\n"
+        "                        the --connect server (headless) in the format:\n"
+        "                        [number of clients],[opus64],[mono], ...\n"
+        "                        [jitter=ms],[loss=%]\n"
         "\nExample: " + QString ( argv[0] ) + " -s --inifile myinifile.ini\n";
 }
 
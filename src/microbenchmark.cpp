@@ -0,0 +1,727 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "microbenchmark.h"
+#include "client.h"
+#include <QJsonObject>
+
+
+/* Implementation *************************************************************/
+void CMicroBenchmark::Run ( QTextStream& tsConsole )
+{
+    tsConsole << QString ( "%1 %2 %3" ).
+        arg ( "Benchmark", -40 ).
+        arg ( "Time/iteration", 16 ).
+        arg ( "Iterations", 12 ) << endl;
+
+    RunMixCases ( tsConsole );
+    RunBufferCases ( tsConsole );
+    RunCrcCases ( tsConsole );
+    RunProtocolCases ( tsConsole );
+    RunCodecCases ( tsConsole );
+
+    // use the sink so that it is not optimized away
+    if ( iSink == 0x7FFFFFFF )
+    {
+        tsConsole << endl;
+    }
+}
+
+void CMicroBenchmark::RunCase ( QTextStream&   tsConsole,
+                                const QString& strName,
+                                TCaseFct       CaseFct )
+{
+    if ( ( strFilter.compare ( "all", Qt::CaseInsensitive ) != 0 ) &&
+         !strName.contains ( strFilter, Qt::CaseInsensitive ) )
+    {
+        return;
+    }
+
+    QElapsedTimer Timer;
+    qint64        iElapsedNs = 0;
+    int           iNumIter   = 1;
+
+    // warm up the caches
+    CaseFct ( 1 );
+
+    while ( true )
+    {
+        Timer.start();
+        CaseFct ( iNumIter );
+        iElapsedNs = Timer.nsecsElapsed();
+
+        if ( ( iElapsedNs >= MICROBENCHMARK_MIN_TIME_MS * 1000000LL ) || ( iNumIter >= ( 1 << 30 ) ) )
+        {
+            break;
+        }
+
+        iNumIter *= 2;
+    }
+
+    const double dNsPerIter = static_cast<double> ( iElapsedNs ) / iNumIter;
+
+    tsConsole << QString ( "%1 %2 ns %3" ).
+        arg ( strName, -40 ).
+        arg ( dNsPerIter, 13, 'f', 1 ).
+        arg ( iNumIter, 12 ) << endl;
+
+    QJsonObject jsonCase;
+    jsonCase["name"]       = strName;
+    jsonCase["ns_per_op"]  = dNsPerIter;
+    jsonCase["ops_per_s"]  = 1e9 / dNsPerIter;
+    jsonCase["iterations"] = iNumIter;
+    jsonResults.append ( jsonCase );
+}
+
+void CMicroBenchmark::RunMixCases ( QTextStream& tsConsole )
+{
+    // the kernels of the server mix on one stereo frame of the double system
+    // frame size (the kernel implementation is selected by the CPU features)
+    const int iNumSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+
+    CMixKernel::Init();
+
+    CVector<float>   vecfLeft ( iNumSamples );
+    CVector<float>   vecfRight ( iNumSamples );
+    CVector<float>   vecfMono ( iNumSamples );
+    CVector<float>   vecfMix ( iNumSamples, 0 );
+    CVector<int16_t> vecsStereo ( 2 * iNumSamples );
+
+    for ( int i = 0; i < vecsStereo.Size(); i++ )
+    {
+        vecsStereo[i] = static_cast<int16_t> ( ( rand() % 20000 ) - 10000 );
+    }
+
+    CMixKernel::ShortToFloatStereo ( &vecsStereo[0], &vecfLeft[0], &vecfRight[0], &vecfMono[0], iNumSamples );
+
+    RunCase ( tsConsole, "Mix/MixAdd", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            CMixKernel::MixAdd ( &vecfMix[0], &vecfLeft[0], 0.5f, iNumSamples );
+        }
+
+        iSink += static_cast<int> ( vecfMix[0] );
+    } );
+
+    RunCase ( tsConsole, "Mix/MaxAbs", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            iSink += static_cast<int> ( CMixKernel::MaxAbs ( &vecfLeft[0], iNumSamples ) );
+        }
+    } );
+
+    RunCase ( tsConsole, "Mix/MaxAbsStereoShort", [&] ( const int iNumIter )
+    {
+        int16_t sMaxL;
+        int16_t sMaxR;
+
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            CMixKernel::MaxAbsStereoShort ( &vecsStereo[0], sMaxL, sMaxR, iNumSamples );
+            iSink += sMaxL + sMaxR;
+        }
+    } );
+
+    RunCase ( tsConsole, "Mix/ShortToFloatStereo", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            CMixKernel::ShortToFloatStereo ( &vecsStereo[0], &vecfLeft[0], &vecfRight[0], &vecfMono[0], iNumSamples );
+        }
+
+        iSink += static_cast<int> ( vecfMono[0] );
+    } );
+
+    RunCase ( tsConsole, "Mix/FloatToShortStereo", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            CMixKernel::FloatToShortStereo ( &vecfLeft[0], &vecfRight[0], &vecsStereo[0], iNumSamples );
+        }
+
+        iSink += vecsStereo[0];
+    } );
+}
+
+void CMicroBenchmark::RunBufferCases ( QTextStream& tsConsole )
+{
+    const int        iBlockSize = MICROBENCHMARK_BLOCK_SIZE_BYTES;
+    CVector<uint8_t> vecbyData ( iBlockSize, 1 );
+
+    // jitter buffer with a constant fill level (the positions run over the
+    // end of the memory in every MICROBENCHMARK_NUM_BLOCKS iteration)
+    CNetBuf NetBuf;
+    NetBuf.Init ( iBlockSize, MICROBENCHMARK_NUM_BLOCKS );
+    NetBuf.Put ( vecbyData, iBlockSize );
+
+    RunCase ( tsConsole, "NetBuf/PutGet", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            NetBuf.Put ( vecbyData, iBlockSize );
+            iSink += NetBuf.Get ( vecbyData, iBlockSize );
+        }
+    } );
+
+    // the base buffer with a memory size which is no multiple of the block
+    // size, i.e. every other put and get is split at the end of the memory
+    CBufferBase<uint8_t> BaseBuf;
+    BaseBuf.Init ( 3 * iBlockSize / 2 );
+
+    RunCase ( tsConsole, "BufferBase/PutGet/wraparound", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            BaseBuf.Put ( vecbyData, iBlockSize );
+            iSink += BaseBuf.Get ( vecbyData, iBlockSize );
+        }
+    } );
+
+    // jitter buffer with the statistics of the auto setting which updates
+    // the NUM_STAT_SIMULATION_BUFFERS simulation buffers on each put and get
+    CNetBufWithStats NetBufWithStats;
+    NetBufWithStats.Init ( iBlockSize, MICROBENCHMARK_NUM_BLOCKS );
+    NetBufWithStats.Put ( vecbyData, iBlockSize );
+
+    RunCase ( tsConsole, "NetBufWithStats/PutGet", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            NetBufWithStats.Put ( vecbyData, iBlockSize );
+            iSink += NetBufWithStats.Get ( vecbyData, iBlockSize );
+        }
+    } );
+
+    // resize of a half filled jitter buffer with wrapped positions which keeps
+    // the data, as done by the auto jitter buffer setting (the memory is
+    // reserved so that no memory is allocated, the time includes the filling
+    // of the buffer)
+    CNetBuf ResizeBuf;
+    ResizeBuf.Reserve ( iBlockSize * 2 * MICROBENCHMARK_NUM_BLOCKS );
+
+    RunCase ( tsConsole, "NetBuf/Init/preserve", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            ResizeBuf.Init ( iBlockSize, MICROBENCHMARK_NUM_BLOCKS );
+
+            for ( int j = 0; j < MICROBENCHMARK_NUM_BLOCKS - 2; j++ )
+            {
+                ResizeBuf.Put ( vecbyData, iBlockSize );
+                ResizeBuf.Get ( vecbyData, iBlockSize );
+            }
+
+            for ( int j = 0; j < MICROBENCHMARK_NUM_BLOCKS / 2; j++ )
+            {
+                ResizeBuf.Put ( vecbyData, iBlockSize );
+            }
+
+            ResizeBuf.Init ( iBlockSize, 2 * MICROBENCHMARK_NUM_BLOCKS, true );
+            iSink += ResizeBuf.GetAvailData();
+        }
+    } );
+
+    // conversion buffer as used between the codec and the server frame size
+    const int         iConvBufSize  = 2 * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+    const int         iConvPartSize = 2 * SYSTEM_FRAME_SIZE_SAMPLES;
+    CConvBuf<int16_t> ConvBuf;
+    CVector<int16_t>  vecsConvData ( iConvBufSize, 1 );
+
+    ConvBuf.Init ( iConvBufSize );
+
+    RunCase ( tsConsole, "ConvBuf/PutGetAll", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            for ( int j = 0; j < iConvBufSize / iConvPartSize; j++ )
+            {
+                ConvBuf.Put ( vecsConvData, iConvPartSize );
+            }
+
+            ConvBuf.GetAll ( vecsConvData, iConvBufSize );
+            iSink += vecsConvData[0];
+        }
+    } );
+
+    // moving average as used for the ping time and the levels
+    CMovingAv<double> MovingAv;
+    MovingAv.Init ( 1000 );
+
+    RunCase ( tsConsole, "MovingAv/Add", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            MovingAv.Add ( i );
+        }
+
+        iSink += static_cast<int> ( MovingAv.GetAverage() );
+    } );
+}
+
+// the bit-wise shift register implementation of the protocol CRC which was
+// replaced by the table, it is kept as the reference of the CRC cases
+static uint32_t CrcBitwise ( const CVector<uint8_t>& vecbyData )
+{
+    const uint32_t iPoly       = ( 1 << 5 ) | ( 1 << 12 );
+    const uint32_t iBitOutMask = 1 << 16;
+    uint32_t       iStateShiftReg = ~uint32_t ( 0 );
+
+    for ( int j = 0; j < vecbyData.Size(); j++ )
+    {
+        for ( int i = 0; i < 8; i++ )
+        {
+            iStateShiftReg <<= 1;
+
+            if ( ( iStateShiftReg & iBitOutMask ) > 0 )
+            {
+                iStateShiftReg |= 1;
+            }
+
+            if ( ( vecbyData[j] & ( 1 << ( 8 - i - 1 ) ) ) > 0 )
+            {
+                iStateShiftReg ^= 1;
+            }
+
+            if ( iStateShiftReg & 1 )
+            {
+                iStateShiftReg ^= iPoly;
+            }
+        }
+    }
+
+    return ~iStateShiftReg & ( iBitOutMask - 1 );
+}
+
+void CMicroBenchmark::RunCrcCases ( QTextStream& tsConsole )
+{
+    CVector<uint8_t> vecbyData ( MICROBENCHMARK_CRC_SIZE_BYTES );
+
+    for ( int i = 0; i < vecbyData.Size(); i++ )
+    {
+        vecbyData[i] = static_cast<uint8_t> ( rand() );
+    }
+
+    RunCase ( tsConsole, "CRC/1KB/bitwise", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            iSink += CrcBitwise ( vecbyData );
+        }
+    } );
+
+    CCRC CRCObj;
+
+    RunCase ( tsConsole, "CRC/1KB/table", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            CRCObj.Reset();
+
+            for ( int j = 0; j < vecbyData.Size(); j++ )
+            {
+                CRCObj.AddByte ( vecbyData[j] );
+            }
+
+            iSink += CRCObj.GetCRC();
+        }
+    } );
+
+    // both implementations must give the same result
+    CRCObj.Reset();
+
+    for ( int j = 0; j < vecbyData.Size(); j++ )
+    {
+        CRCObj.AddByte ( vecbyData[j] );
+    }
+
+    if ( CRCObj.GetCRC() != CrcBitwise ( vecbyData ) )
+    {
+        tsConsole << "Error: the CRC implementations give different results" << endl;
+    }
+}
+
+bool CMicroBenchmark::DeliverMessage ( CProtocol&              Protocol,
+                                       const CVector<uint8_t>& vecbyMessage,
+                                       const CHostAddress&     HostAddr )
+{
+    int iRecCounter;
+    int iRecID;
+
+    if ( CProtocol::ParseMessageFrame ( vecbyMessage, vecbyMessage.Size(), vecbyMesBody, iRecCounter, iRecID ) )
+    {
+        return true; // return error code
+    }
+
+    if ( CProtocol::IsConnectionLessMessageID ( iRecID ) )
+    {
+        return Protocol.ParseConnectionLessMessageBody ( vecbyMesBody, iRecID, HostAddr );
+    }
+
+    return Protocol.ParseMessageBody ( vecbyMesBody, iRecCounter, iRecID );
+}
+
+void CMicroBenchmark::RunProtocolCases ( QTextStream& tsConsole )
+{
+    const CHostAddress HostAddr ( QHostAddress ( QHostAddress::LocalHost ), DEFAULT_PORT_NUMBER );
+
+    // the sending and the receiving side of a session, the last sent messages
+    // are stored
+    CProtocol        Protocol;
+    CProtocol        RecProtocol;
+    CVector<uint8_t> vecbySent;
+    CVector<uint8_t> vecbyAckn;
+
+    QObject::connect ( &Protocol, &CProtocol::MessReadyForSending,
+        [&] ( CProtMessage Message ) { vecbySent = Message.Data(); } );
+
+    QObject::connect ( &Protocol, &CProtocol::CLMessReadyForSending,
+        [&] ( CHostAddress, CProtMessage Message ) { vecbySent = Message.Data(); } );
+
+    QObject::connect ( &RecProtocol, &CProtocol::MessReadyForSending,
+        [&] ( CProtMessage Message ) { vecbyAckn = Message.Data(); } );
+
+    // test data of the list messages
+    CVector<CChannelInfo> vecChanInfo ( MICROBENCHMARK_NUM_CHANNELS );
+    CVector<uint16_t>     vecLevels ( MICROBENCHMARK_NUM_CHANNELS, 5 );
+    CVector<CServerInfo>  vecServerInfo ( MICROBENCHMARK_NUM_SERVERS );
+
+    for ( int i = 0; i < MICROBENCHMARK_NUM_CHANNELS; i++ )
+    {
+        vecChanInfo[i] = CChannelInfo ( i,
+                                        HostAddr.GetIPv4Addr() + i,
+                                        QString ( "Musician %1" ).arg ( i ),
+                                        QLocale::Germany,
+                                        "Munich",
+                                        1,
+                                        SL_NOT_SET );
+    }
+
+    for ( int i = 0; i < MICROBENCHMARK_NUM_SERVERS; i++ )
+    {
+        vecServerInfo[i] = CServerInfo ( CHostAddress ( HostAddr.GetIPv4Addr() + i, DEFAULT_PORT_NUMBER ),
+                                         CHostAddress(),
+                                         QString ( "Server %1" ).arg ( i ),
+                                         QLocale::Germany,
+                                         "Munich",
+                                         10,
+                                         false );
+    }
+
+    // encode: the connection based messages are queued behind the message in
+    // flight, the queue is cleared from time to time
+    RunCase ( tsConsole, "Protocol/ChanGain/encode", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            Protocol.CreateChanGainMes ( i % MICROBENCHMARK_NUM_CHANNELS, 0.5 );
+
+            if ( ( i % 64 ) == 63 )
+            {
+                Protocol.Reset();
+            }
+        }
+
+        Protocol.Reset();
+    } );
+
+    RunCase ( tsConsole, "Protocol/ConClientList/encode", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            Protocol.CreateConClientListMes ( vecChanInfo );
+
+            if ( ( i % 64 ) == 63 )
+            {
+                Protocol.Reset();
+            }
+        }
+
+        Protocol.Reset();
+    } );
+
+    RunCase ( tsConsole, "Protocol/CLChannelLevelList/encode", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            Protocol.CreateCLChannelLevelListMes ( HostAddr, vecLevels, MICROBENCHMARK_NUM_CHANNELS );
+        }
+
+        iSink += vecbySent.Size();
+    } );
+
+    RunCase ( tsConsole, "Protocol/CLServerList/encode", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            Protocol.GenCLServerListMes ( vecServerInfo, vecbySent );
+        }
+
+        iSink += vecbySent.Size();
+    } );
+
+    // the frames of the connection based messages are taken from a session:
+    // the new message is sent when the receiver acknowledged the message in
+    // flight (which is the protocol version message for the first message)
+    auto GetConnMessage = [&] ( std::function<void()> CreateMes )
+    {
+        CreateMes();
+        DeliverMessage ( RecProtocol, vecbySent, HostAddr );
+        DeliverMessage ( Protocol, vecbyAckn, HostAddr );
+        return vecbySent;
+    };
+
+    CVector<CVector<uint8_t> > vecvecbyGainMes ( 2 );
+    CVector<CVector<uint8_t> > vecvecbyListMes ( 2 );
+
+    Protocol.Reset();
+    RecProtocol.Reset();
+
+    for ( int i = 0; i < 2; i++ )
+    {
+        vecvecbyGainMes[i] = GetConnMessage ( [&]() { Protocol.CreateChanGainMes ( i, 0.5 ); } );
+        vecvecbyListMes[i] = GetConnMessage ( [&]() { Protocol.CreateConClientListMes ( vecChanInfo ); } );
+    }
+
+    Protocol.CreateCLChannelLevelListMes ( HostAddr, vecLevels, MICROBENCHMARK_NUM_CHANNELS );
+    const CVector<uint8_t> vecbyLevelsMes = vecbySent;
+
+    Protocol.CreateCLServerListMes ( HostAddr, vecServerInfo );
+    const CVector<uint8_t> vecbyServerListMes = vecbySent;
+
+    // decode: a receiver which is not in the in-order receive mode processes
+    // all messages with a different counter than the previous message, i.e.
+    // the two messages with different counters are alternated
+    RecProtocol.Reset();
+
+    RunCase ( tsConsole, "Protocol/ChanGain/decode", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            iSink += DeliverMessage ( RecProtocol, vecvecbyGainMes[i & 1], HostAddr );
+        }
+    } );
+
+    RunCase ( tsConsole, "Protocol/ConClientList/decode", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            iSink += DeliverMessage ( RecProtocol, vecvecbyListMes[i & 1], HostAddr );
+        }
+    } );
+
+    RunCase ( tsConsole, "Protocol/CLChannelLevelList/decode", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            iSink += DeliverMessage ( RecProtocol, vecbyLevelsMes, HostAddr );
+        }
+    } );
+
+    RunCase ( tsConsole, "Protocol/CLServerList/decode", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            iSink += DeliverMessage ( RecProtocol, vecbyServerListMes, HostAddr );
+        }
+    } );
+
+    // a received audio packet is also checked if it is a protocol message
+    CVector<uint8_t> vecbyAudio ( MICROBENCHMARK_BLOCK_SIZE_BYTES );
+
+    for ( int i = 0; i < vecbyAudio.Size(); i++ )
+    {
+        vecbyAudio[i] = static_cast<uint8_t> ( rand() );
+    }
+
+    vecbyAudio[0] |= 1; // no valid protocol tag
+
+    RunCase ( tsConsole, "Protocol/ParseMessageFrame/audio", [&] ( const int iNumIter )
+    {
+        int iRecCounter;
+        int iRecID;
+
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            iSink += CProtocol::ParseMessageFrame ( vecbyAudio, vecbyAudio.Size(), vecbyMesBody, iRecCounter, iRecID );
+        }
+    } );
+}
+
+QString CMicroBenchmark::GetOpusSimdConfig()
+{
+#ifdef USE_OPUS_SHARED_LIB
+    return "shared library";
+#else
+    QStringList slExt;
+
+# ifdef OPUS_X86_MAY_HAVE_SSE
+    slExt << "SSE";
+# endif
+# ifdef OPUS_X86_MAY_HAVE_SSE2
+    slExt << "SSE2";
+# endif
+# ifdef OPUS_X86_MAY_HAVE_SSE4_1
+    slExt << "SSE4.1";
+# endif
+# ifdef OPUS_ARM_MAY_HAVE_NEON_INTR
+    slExt << "NEON";
+# endif
+
+    if ( slExt.isEmpty() )
+    {
+        return "no SIMD";
+    }
+
+# ifdef OPUS_HAVE_RTCD
+    return slExt.join ( ", " ) + " (runtime detection)";
+# else
+    return slExt.join ( ", " );
+# endif
+#endif
+}
+
+void CMicroBenchmark::RunCodecCases ( QTextStream& tsConsole )
+{
+    const QString strPrefix = "Codec/";
+
+    // the SIMD configuration is shown so that the results of different builds
+    // can be compared
+    tsConsole << QString ( "%1 (%2)" ).
+        arg ( opus_get_version_string() ).
+        arg ( GetOpusSimdConfig() ) << endl;
+
+    int iOpusError;
+
+    // the same OPUS modes as in the client and server
+    OpusCustomMode* OpusMode = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                                         DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES,
+                                                         &iOpusError );
+
+    OpusCustomMode* Opus64Mode = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                                           SYSTEM_FRAME_SIZE_SAMPLES,
+                                                           &iOpusError );
+
+    // the normal audio quality of the client
+    RunCodecCase ( tsConsole, strPrefix + "OPUS64/mono", Opus64Mode, SYSTEM_FRAME_SIZE_SAMPLES,
+                   1, OPUS_NUM_BYTES_MONO_NORMAL_QUALITY );
+
+    RunCodecCase ( tsConsole, strPrefix + "OPUS64/stereo", Opus64Mode, SYSTEM_FRAME_SIZE_SAMPLES,
+                   2, OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY );
+
+    RunCodecCase ( tsConsole, strPrefix + "OPUS/mono", OpusMode, DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES,
+                   1, OPUS_NUM_BYTES_MONO_NORMAL_QUALITY_DBLE_FRAMESIZE );
+
+    RunCodecCase ( tsConsole, strPrefix + "OPUS/stereo", OpusMode, DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES,
+                   2, OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY_DBLE_FRAMESIZE );
+
+    opus_custom_mode_destroy ( OpusMode );
+    opus_custom_mode_destroy ( Opus64Mode );
+}
+
+void CMicroBenchmark::RunCodecCase ( QTextStream&    tsConsole,
+                                     const QString&  strName,
+                                     OpusCustomMode* pMode,
+                                     const int       iFrameSizeSamples,
+                                     const int       iNumAudioChannels,
+                                     const int       iNumCodedBytes )
+{
+    int iOpusError;
+
+    // the encoder and decoder are configured like in the server
+    OpusCustomEncoder* pEncoder = opus_custom_encoder_create ( pMode, iNumAudioChannels, &iOpusError );
+    OpusCustomDecoder* pDecoder = opus_custom_decoder_create ( pMode, iNumAudioChannels, &iOpusError );
+
+    opus_custom_encoder_ctl ( pEncoder, OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( pEncoder,
+                              OPUS_SET_BITRATE ( CalcBitRateBitsPerSecFromCodedBytes ( iNumCodedBytes, iFrameSizeSamples ) ) );
+
+    // a tone with noise as test signal (digital silence would bypass most of
+    // the codec)
+    const int iFrameSize = iNumAudioChannels * iFrameSizeSamples;
+
+    CVector<int16_t>          vecsSignal ( MICROBENCHMARK_NUM_CODED_FRAMES * iFrameSize );
+    CVector<int16_t>          vecsDecoded ( iFrameSize );
+    CVector<CVector<uint8_t>> vecvecbyCoded ( MICROBENCHMARK_NUM_CODED_FRAMES );
+
+    for ( int i = 0; i < vecsSignal.Size(); i++ )
+    {
+        vecsSignal[i] = static_cast<int16_t> ( 3000 * sin ( 0.05 * ( i / iNumAudioChannels ) ) + ( rand() % 1000 ) - 500 );
+    }
+
+    for ( int iF = 0; iF < MICROBENCHMARK_NUM_CODED_FRAMES; iF++ )
+    {
+        vecvecbyCoded[iF].Init ( iNumCodedBytes );
+
+        opus_custom_encode ( pEncoder,
+                             &vecsSignal[iF * iFrameSize],
+                             iFrameSizeSamples,
+                             &vecvecbyCoded[iF][0],
+                             iNumCodedBytes );
+    }
+
+    RunCase ( tsConsole, strName + "/encode", [&] ( const int iNumIter )
+    {
+        CVector<uint8_t> vecbyCoded ( iNumCodedBytes );
+
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            iSink += opus_custom_encode ( pEncoder,
+                                          &vecsSignal[( i % MICROBENCHMARK_NUM_CODED_FRAMES ) * iFrameSize],
+                                          iFrameSizeSamples,
+                                          &vecbyCoded[0],
+                                          iNumCodedBytes );
+        }
+    } );
+
+    RunCase ( tsConsole, strName + "/decode", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            iSink += opus_custom_decode ( pDecoder,
+                                          &vecvecbyCoded[i % MICROBENCHMARK_NUM_CODED_FRAMES][0],
+                                          iNumCodedBytes,
+                                          &vecsDecoded[0],
+                                          iFrameSizeSamples );
+        }
+    } );
+
+    // the packet loss concealment which is used for lost packets
+    RunCase ( tsConsole, strName + "/conceal", [&] ( const int iNumIter )
+    {
+        for ( int i = 0; i < iNumIter; i++ )
+        {
+            iSink += opus_custom_decode ( pDecoder,
+                                          nullptr,
+                                          iNumCodedBytes,
+                                          &vecsDecoded[0],
+                                          iFrameSizeSamples );
+        }
+    } );
+
+    opus_custom_encoder_destroy ( pEncoder );
+    opus_custom_decoder_destroy ( pDecoder );
+}
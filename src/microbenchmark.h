@@ -0,0 +1,121 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QString>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QJsonArray>
+#include <functional>
+#include "global.h"
+#include "util.h"
+#include "buffer.h"
+#include "protocol.h"
+#include "mixkernel.h"
+#ifdef USE_OPUS_SHARED_LIB
+# include "opus/opus_custom.h"
+#else
+# include "opus_custom.h"
+#endif
+
+
+/* Definitions ****************************************************************/
+// each case is repeated with a doubled number of iterations until it runs at
+// least this time
+#define MICROBENCHMARK_MIN_TIME_MS       100
+
+// size of the blocks in the network buffer cases (a typical coded audio packet)
+#define MICROBENCHMARK_BLOCK_SIZE_BYTES  166
+
+// number of blocks of the network buffer cases
+#define MICROBENCHMARK_NUM_BLOCKS        16
+
+// size of the data of the CRC cases
+#define MICROBENCHMARK_CRC_SIZE_BYTES    1024
+
+// number of channels and servers of the protocol list messages
+#define MICROBENCHMARK_NUM_CHANNELS      16
+#define MICROBENCHMARK_NUM_SERVERS       50
+
+// number of different coded frames of the codec cases
+#define MICROBENCHMARK_NUM_CODED_FRAMES  64
+
+
+/* Classes ********************************************************************/
+// Micro-benchmarks of the basic data structures which are used on the audio
+// paths and of the protocol message handling. Every case measures the average time of one iteration, so that the
+// numbers of an optimization can be compared with the previous version.
+class CMicroBenchmark
+{
+public:
+    // only the cases which contain the filter are run ("all" runs all cases)
+    CMicroBenchmark ( const QString& strNFilter ) :
+        strFilter ( strNFilter ), iSink ( 0 ) {}
+
+    void Run ( QTextStream& tsConsole );
+
+    // the results of the cases which were run, each entry has the name, the
+    // time per iteration in ns, the iterations per second and the number of
+    // iterations of the measurement
+    const QJsonArray& GetResults() const { return jsonResults; }
+
+protected:
+    // the case function runs the given number of iterations
+    typedef std::function<void ( const int iNumIter )> TCaseFct;
+
+    void RunCase ( QTextStream&   tsConsole,
+                   const QString& strName,
+                   TCaseFct       CaseFct );
+
+    void RunMixCases ( QTextStream& tsConsole );
+    void RunBufferCases ( QTextStream& tsConsole );
+    void RunCrcCases ( QTextStream& tsConsole );
+    void RunProtocolCases ( QTextStream& tsConsole );
+    void RunCodecCases ( QTextStream& tsConsole );
+
+    void RunCodecCase ( QTextStream&     tsConsole,
+                        const QString&   strName,
+                        OpusCustomMode*  pMode,
+                        const int        iFrameSizeSamples,
+                        const int        iNumAudioChannels,
+                        const int        iNumCodedBytes );
+
+    // the SIMD configuration of the bundled OPUS library
+    static QString GetOpusSimdConfig();
+
+    // parses the message frame and body as done for a received message
+    bool DeliverMessage ( CProtocol&              Protocol,
+                          const CVector<uint8_t>& vecbyMessage,
+                          const CHostAddress&     HostAddr );
+
+    QString          strFilter;
+    CVector<uint8_t> vecbyMesBody;
+    QJsonArray       jsonResults;
+
+    // the results of the cases are accumulated so that the compiler cannot
+    // remove the benchmarked code
+    int              iSink;
+};
@@ -0,0 +1,1102 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "mixkernel.h"
+#include <algorithm>
+#include <cmath>
+
+// select the available instruction sets (on x86 the SSE2/AVX2 code is always
+// compiled and the usage is decided at runtime based on the CPU features)
+#if defined ( __x86_64__ ) || defined ( __i386__ ) || defined ( _M_X64 ) || defined ( _M_IX86 )
+# if defined ( __GNUC__ ) || defined ( __clang__ )
+#  define MIXKERNEL_X86
+#  define MIXKERNEL_TARGET(x) __attribute__ ( ( target ( x ) ) )
+# elif defined ( _MSC_VER )
+#  define MIXKERNEL_X86
+#  define MIXKERNEL_TARGET(x)
+#  include <intrin.h>
+# endif
+#endif
+
+#if defined ( __ARM_NEON ) || defined ( __ARM_NEON__ )
+# define MIXKERNEL_NEON
+#endif
+
+#ifdef MIXKERNEL_X86
+# include <immintrin.h>
+#endif
+
+#ifdef MIXKERNEL_NEON
+# include <arm_neon.h>
+#endif
+
+// scale of the float samples of the OPUS float API with respect to int16
+#define MIXKERNEL_NORM_SCALE             32768.0f
+
+
+/* Implementation *************************************************************/
+// Scalar implementation -------------------------------------------------------
+static inline int16_t Float2Short ( const float fInput )
+{
+    // lower bound
+    if ( fInput < -32768.0f )
+    {
+        return -32768;
+    }
+
+    // upper bound
+    if ( fInput > 32767.0f )
+    {
+        return 32767;
+    }
+
+    return static_cast<int16_t> ( fInput );
+}
+
+static void MixAddScalar ( float*       pfOut,
+                           const float* pfIn,
+                           const float  fGain,
+                           const int    iNumSamples )
+{
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        pfOut[i] += fGain * pfIn[i];
+    }
+}
+
+static float MaxAbsScalar ( const float* pfIn,
+                           const int    iNumSamples )
+{
+    float fMax = 0.0f;
+
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        fMax = std::max ( fMax, std::fabs ( pfIn[i] ) );
+    }
+
+    return fMax;
+}
+
+static void MaxAbsStereoScalar ( const float* pfIn,
+                                 float&       fMaxL,
+                                 float&       fMaxR,
+                                 const int    iNumFrames )
+{
+    fMaxL = 0.0f;
+    fMaxR = 0.0f;
+
+    for ( int i = 0, k = 0; i < iNumFrames; i++, k += 2 )
+    {
+        fMaxL = std::max ( fMaxL, std::fabs ( pfIn[k] ) );
+        fMaxR = std::max ( fMaxR, std::fabs ( pfIn[k + 1] ) );
+    }
+}
+
+static inline int16_t AbsShort ( const int16_t sInput )
+{
+    // |-32768| does not fit in int16
+    return static_cast<int16_t> ( std::min ( std::abs ( static_cast<int> ( sInput ) ), 32767 ) );
+}
+
+static void MaxAbsStereoShortScalar ( const int16_t* psIn,
+                                      int16_t&       sMaxL,
+                                      int16_t&       sMaxR,
+                                      const int      iNumFrames )
+{
+    sMaxL = 0;
+    sMaxR = 0;
+
+    for ( int i = 0, k = 0; i < iNumFrames; i++, k += 2 )
+    {
+        sMaxL = std::max ( sMaxL, AbsShort ( psIn[k] ) );
+        sMaxR = std::max ( sMaxR, AbsShort ( psIn[k + 1] ) );
+    }
+}
+
+static void FloatToShortMonoScalar ( const float* pfIn,
+                                     int16_t*     psOut,
+                                     const int    iNumSamples )
+{
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        psOut[i] = Float2Short ( pfIn[i] );
+    }
+}
+
+static void FloatNormToShortScalar ( const float* pfIn,
+                                     int16_t*     psOut,
+                                     const int    iNumSamples )
+{
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        psOut[i] = Float2Short ( MIXKERNEL_NORM_SCALE * pfIn[i] );
+    }
+}
+
+static void FloatToShortStereoScalar ( const float* pfInLeft,
+                                       const float* pfInRight,
+                                       int16_t*     psOut,
+                                       const int    iNumSamples )
+{
+    for ( int i = 0, k = 0; i < iNumSamples; i++, k += 2 )
+    {
+        psOut[k]     = Float2Short ( pfInLeft[i] );
+        psOut[k + 1] = Float2Short ( pfInRight[i] );
+    }
+}
+
+static void FloatNormToShortStereoScalar ( const float* pfInLeft,
+                                           const float* pfInRight,
+                                           int16_t*     psOut,
+                                           const int    iNumSamples )
+{
+    for ( int i = 0, k = 0; i < iNumSamples; i++, k += 2 )
+    {
+        psOut[k]     = Float2Short ( MIXKERNEL_NORM_SCALE * pfInLeft[i] );
+        psOut[k + 1] = Float2Short ( MIXKERNEL_NORM_SCALE * pfInRight[i] );
+    }
+}
+
+static void ShortToFloatNormStereoScalar ( const int16_t* psIn,
+                                           float*         pfOutLeft,
+                                           float*         pfOutRight,
+                                           const int      iNumSamples )
+{
+    for ( int i = 0, k = 0; i < iNumSamples; i++, k += 2 )
+    {
+        pfOutLeft[i]  = static_cast<float> ( psIn[k] ) * ( 1.0f / MIXKERNEL_NORM_SCALE );
+        pfOutRight[i] = static_cast<float> ( psIn[k + 1] ) * ( 1.0f / MIXKERNEL_NORM_SCALE );
+    }
+}
+
+
+static void AllpassScalar ( float*      pfDelay,
+                           float*      pfInOut,
+                           const float fCoeff,
+                           const int   iNumSamples )
+{
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        const float fNew = pfInOut[i] + fCoeff * pfDelay[i];
+
+        pfInOut[i] = pfDelay[i] - fCoeff * fNew;
+        pfDelay[i] = fNew;
+    }
+}
+
+static void CombFilterScalar ( float*       pfDelay,
+                               const float* pfIn,
+                               float*       pfSum,
+                               float&       fState,
+                               const float  fFeedback,
+                               const float  fPole,
+                               const int    iNumSamples )
+{
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        fState     = fFeedback * pfDelay[i] + fPole * fState;
+        pfDelay[i] = pfIn[i] + fState;
+        pfSum[i]  += pfDelay[i];
+    }
+}
+
+static void DotProductStereoScalar ( const float* pfIn,
+                                     const float* pfCoeff,
+                                     float&       fOutL,
+                                     float&       fOutR,
+                                     const int    iNumFrames )
+{
+    float fSumL = 0.0f;
+    float fSumR = 0.0f;
+
+    for ( int i = 0; i < 2 * iNumFrames; i += 2 )
+    {
+        fSumL += pfCoeff[i]     * pfIn[i];
+        fSumR += pfCoeff[i + 1] * pfIn[i + 1];
+    }
+
+    fOutL = fSumL;
+    fOutR = fSumR;
+}
+
+#ifdef MIXKERNEL_X86
+// SSE2 implementation ---------------------------------------------------------
+MIXKERNEL_TARGET ( "sse2" )
+static void MixAddSse2 ( float*       pfOut,
+                         const float* pfIn,
+                         const float  fGain,
+                         const int    iNumSamples )
+{
+    const __m128 vGain = _mm_set1_ps ( fGain );
+    int          i     = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        _mm_storeu_ps ( &pfOut[i], _mm_add_ps ( _mm_loadu_ps ( &pfOut[i] ),
+                                                _mm_mul_ps ( vGain, _mm_loadu_ps ( &pfIn[i] ) ) ) );
+    }
+
+    // remaining samples
+    MixAddScalar ( &pfOut[i], &pfIn[i], fGain, iNumSamples - i );
+}
+
+MIXKERNEL_TARGET ( "sse2" )
+static float MaxAbsSse2 ( const float* pfIn,
+                          const int    iNumSamples )
+{
+    // the absolute value is obtained by clearing the sign bit
+    const __m128 vAbsMask = _mm_castsi128_ps ( _mm_set1_epi32 ( 0x7FFFFFFF ) );
+    __m128       vMax     = _mm_setzero_ps();
+    int          i        = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        vMax = _mm_max_ps ( vMax, _mm_and_ps ( _mm_loadu_ps ( &pfIn[i] ), vAbsMask ) );
+    }
+
+    // horizontal maximum of the four lanes
+    vMax = _mm_max_ps ( vMax, _mm_shuffle_ps ( vMax, vMax, _MM_SHUFFLE ( 1, 0, 3, 2 ) ) );
+    vMax = _mm_max_ps ( vMax, _mm_shuffle_ps ( vMax, vMax, _MM_SHUFFLE ( 2, 3, 0, 1 ) ) );
+
+    // remaining samples
+    return std::max ( _mm_cvtss_f32 ( vMax ), MaxAbsScalar ( &pfIn[i], iNumSamples - i ) );
+}
+
+MIXKERNEL_TARGET ( "sse2" )
+static void MaxAbsStereoSse2 ( const float* pfIn,
+                               float&       fMaxL,
+                               float&       fMaxR,
+                               const int    iNumFrames )
+{
+    // the lanes 0 and 2 hold the left, the lanes 1 and 3 the right channel
+    const __m128 vAbsMask = _mm_castsi128_ps ( _mm_set1_epi32 ( 0x7FFFFFFF ) );
+    __m128       vMax     = _mm_setzero_ps();
+    int          i        = 0;
+
+    for ( ; i + 2 <= iNumFrames; i += 2 )
+    {
+        vMax = _mm_max_ps ( vMax, _mm_and_ps ( _mm_loadu_ps ( &pfIn[2 * i] ), vAbsMask ) );
+    }
+
+    vMax = _mm_max_ps ( vMax, _mm_shuffle_ps ( vMax, vMax, _MM_SHUFFLE ( 1, 0, 3, 2 ) ) );
+
+    // remaining frame
+    MaxAbsStereoScalar ( &pfIn[2 * i], fMaxL, fMaxR, iNumFrames - i );
+
+    fMaxL = std::max ( fMaxL, _mm_cvtss_f32 ( vMax ) );
+    fMaxR = std::max ( fMaxR, _mm_cvtss_f32 ( _mm_shuffle_ps ( vMax, vMax, _MM_SHUFFLE ( 1, 1, 1, 1 ) ) ) );
+}
+
+MIXKERNEL_TARGET ( "sse2" )
+static void MaxAbsStereoShortSse2 ( const int16_t* psIn,
+                                    int16_t&       sMaxL,
+                                    int16_t&       sMaxR,
+                                    const int      iNumFrames )
+{
+    // the even lanes hold the left, the odd lanes the right channel, the
+    // absolute value is max ( x, 0 - x ) with a saturating subtraction
+    const __m128i vZero = _mm_setzero_si128();
+    __m128i       vMax  = vZero;
+    int           i     = 0;
+
+    for ( ; i + 4 <= iNumFrames; i += 4 )
+    {
+        const __m128i vIn = _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( &psIn[2 * i] ) );
+
+        vMax = _mm_max_epi16 ( vMax, _mm_max_epi16 ( vIn, _mm_subs_epi16 ( vZero, vIn ) ) );
+    }
+
+    // horizontal maximum of the lanes of each channel
+    vMax = _mm_max_epi16 ( vMax, _mm_srli_si128 ( vMax, 8 ) );
+    vMax = _mm_max_epi16 ( vMax, _mm_srli_si128 ( vMax, 4 ) );
+
+    // remaining frames
+    MaxAbsStereoShortScalar ( &psIn[2 * i], sMaxL, sMaxR, iNumFrames - i );
+
+    sMaxL = std::max ( sMaxL, static_cast<int16_t> ( _mm_extract_epi16 ( vMax, 0 ) ) );
+    sMaxR = std::max ( sMaxR, static_cast<int16_t> ( _mm_extract_epi16 ( vMax, 1 ) ) );
+}
+
+MIXKERNEL_TARGET ( "sse2" )
+static void FloatToShortMonoSse2 ( const float* pfIn,
+                                   int16_t*     psOut,
+                                   const int    iNumSamples )
+{
+    int i = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        // convert to int32 and pack to int16 with signed saturation
+        const __m128i v0 = _mm_cvtps_epi32 ( _mm_loadu_ps ( &pfIn[i] ) );
+        const __m128i v1 = _mm_cvtps_epi32 ( _mm_loadu_ps ( &pfIn[i + 4] ) );
+
+        _mm_storeu_si128 ( reinterpret_cast<__m128i*> ( &psOut[i] ), _mm_packs_epi32 ( v0, v1 ) );
+    }
+
+    // remaining samples
+    FloatToShortMonoScalar ( &pfIn[i], &psOut[i], iNumSamples - i );
+}
+
+MIXKERNEL_TARGET ( "sse2" )
+static void FloatToShortStereoSse2 ( const float* pfInLeft,
+                                     const float* pfInRight,
+                                     int16_t*     psOut,
+                                     const int    iNumSamples )
+{
+    int i = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        const __m128i vLeft  = _mm_packs_epi32 ( _mm_cvtps_epi32 ( _mm_loadu_ps ( &pfInLeft[i] ) ),
+                                                 _mm_cvtps_epi32 ( _mm_loadu_ps ( &pfInLeft[i + 4] ) ) );
+
+        const __m128i vRight = _mm_packs_epi32 ( _mm_cvtps_epi32 ( _mm_loadu_ps ( &pfInRight[i] ) ),
+                                                 _mm_cvtps_epi32 ( _mm_loadu_ps ( &pfInRight[i + 4] ) ) );
+
+        // interleave left and right channel
+        _mm_storeu_si128 ( reinterpret_cast<__m128i*> ( &psOut[2 * i] ),     _mm_unpacklo_epi16 ( vLeft, vRight ) );
+        _mm_storeu_si128 ( reinterpret_cast<__m128i*> ( &psOut[2 * i + 8] ), _mm_unpackhi_epi16 ( vLeft, vRight ) );
+    }
+
+    // remaining samples
+    FloatToShortStereoScalar ( &pfInLeft[i], &pfInRight[i], &psOut[2 * i], iNumSamples - i );
+}
+
+MIXKERNEL_TARGET ( "sse2" )
+static void FloatNormToShortSse2 ( const float* pfIn,
+                                   int16_t*     psOut,
+                                   const int    iNumSamples )
+{
+    const __m128 vScale = _mm_set1_ps ( MIXKERNEL_NORM_SCALE );
+    int          i      = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        const __m128i v0 = _mm_cvtps_epi32 ( _mm_mul_ps ( vScale, _mm_loadu_ps ( &pfIn[i] ) ) );
+        const __m128i v1 = _mm_cvtps_epi32 ( _mm_mul_ps ( vScale, _mm_loadu_ps ( &pfIn[i + 4] ) ) );
+
+        _mm_storeu_si128 ( reinterpret_cast<__m128i*> ( &psOut[i] ), _mm_packs_epi32 ( v0, v1 ) );
+    }
+
+    // remaining samples
+    FloatNormToShortScalar ( &pfIn[i], &psOut[i], iNumSamples - i );
+}
+
+MIXKERNEL_TARGET ( "sse2" )
+static void FloatNormToShortStereoSse2 ( const float* pfInLeft,
+                                         const float* pfInRight,
+                                         int16_t*     psOut,
+                                         const int    iNumSamples )
+{
+    const __m128 vScale = _mm_set1_ps ( MIXKERNEL_NORM_SCALE );
+    int          i      = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        const __m128i vLeft  = _mm_packs_epi32 ( _mm_cvtps_epi32 ( _mm_mul_ps ( vScale, _mm_loadu_ps ( &pfInLeft[i] ) ) ),
+                                                 _mm_cvtps_epi32 ( _mm_mul_ps ( vScale, _mm_loadu_ps ( &pfInLeft[i + 4] ) ) ) );
+
+        const __m128i vRight = _mm_packs_epi32 ( _mm_cvtps_epi32 ( _mm_mul_ps ( vScale, _mm_loadu_ps ( &pfInRight[i] ) ) ),
+                                                 _mm_cvtps_epi32 ( _mm_mul_ps ( vScale, _mm_loadu_ps ( &pfInRight[i + 4] ) ) ) );
+
+        // interleave left and right channel
+        _mm_storeu_si128 ( reinterpret_cast<__m128i*> ( &psOut[2 * i] ),     _mm_unpacklo_epi16 ( vLeft, vRight ) );
+        _mm_storeu_si128 ( reinterpret_cast<__m128i*> ( &psOut[2 * i + 8] ), _mm_unpackhi_epi16 ( vLeft, vRight ) );
+    }
+
+    // remaining samples
+    FloatNormToShortStereoScalar ( &pfInLeft[i], &pfInRight[i], &psOut[2 * i], iNumSamples - i );
+}
+
+MIXKERNEL_TARGET ( "sse2" )
+static void ShortToFloatNormStereoSse2 ( const int16_t* psIn,
+                                         float*         pfOutLeft,
+                                         float*         pfOutRight,
+                                         const int      iNumSamples )
+{
+    const __m128 vScale = _mm_set1_ps ( 1.0f / MIXKERNEL_NORM_SCALE );
+    int          i      = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        const __m128i vStereo = _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( &psIn[2 * i] ) );
+
+        // the left channel is in the lower and the right channel in the upper
+        // half of each 32 bit word, the arithmetic shifts do the sign extension
+        const __m128i vLeft  = _mm_srai_epi32 ( _mm_slli_epi32 ( vStereo, 16 ), 16 );
+        const __m128i vRight = _mm_srai_epi32 ( vStereo, 16 );
+
+        _mm_storeu_ps ( &pfOutLeft[i],  _mm_mul_ps ( vScale, _mm_cvtepi32_ps ( vLeft ) ) );
+        _mm_storeu_ps ( &pfOutRight[i], _mm_mul_ps ( vScale, _mm_cvtepi32_ps ( vRight ) ) );
+    }
+
+    // remaining samples
+    ShortToFloatNormStereoScalar ( &psIn[2 * i], &pfOutLeft[i], &pfOutRight[i], iNumSamples - i );
+}
+
+MIXKERNEL_TARGET ( "sse2" )
+static void AllpassSse2 ( float*      pfDelay,
+                          float*      pfInOut,
+                          const float fCoeff,
+                          const int   iNumSamples )
+{
+    const __m128 vCoeff = _mm_set1_ps ( fCoeff );
+    int          i      = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        const __m128 vDelayed = _mm_loadu_ps ( &pfDelay[i] );
+        const __m128 vNew     = _mm_add_ps ( _mm_loadu_ps ( &pfInOut[i] ), _mm_mul_ps ( vCoeff, vDelayed ) );
+
+        _mm_storeu_ps ( &pfInOut[i], _mm_sub_ps ( vDelayed, _mm_mul_ps ( vCoeff, vNew ) ) );
+        _mm_storeu_ps ( &pfDelay[i], vNew );
+    }
+
+    // remaining samples
+    AllpassScalar ( &pfDelay[i], &pfInOut[i], fCoeff, iNumSamples - i );
+}
+
+MIXKERNEL_TARGET ( "sse2" )
+static void CombFilterSse2 ( float*       pfDelay,
+                             const float* pfIn,
+                             float*       pfSum,
+                             float&       fState,
+                             const float  fFeedback,
+                             const float  fPole,
+                             const int    iNumSamples )
+{
+    // The lanes are four consecutive samples. The one-pole recursion within the
+    // lanes is resolved by a prefix computation so that the dependency on the
+    // previous filter state only remains once per four samples.
+    const __m128 vFeedback = _mm_set1_ps ( fFeedback );
+    const __m128 vPole     = _mm_set1_ps ( fPole );
+    const __m128 vPole2    = _mm_set1_ps ( fPole * fPole );
+    const __m128 vPolePow  = _mm_setr_ps ( fPole, fPole * fPole, fPole * fPole * fPole, fPole * fPole * fPole * fPole );
+    __m128       vState    = _mm_set1_ps ( fState );
+    int          i         = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        __m128 vLowpass = _mm_mul_ps ( vFeedback, _mm_loadu_ps ( &pfDelay[i] ) );
+
+        vLowpass = _mm_add_ps ( vLowpass, _mm_mul_ps ( vPole,  _mm_castsi128_ps ( _mm_slli_si128 ( _mm_castps_si128 ( vLowpass ), 4 ) ) ) );
+        vLowpass = _mm_add_ps ( vLowpass, _mm_mul_ps ( vPole2, _mm_castsi128_ps ( _mm_slli_si128 ( _mm_castps_si128 ( vLowpass ), 8 ) ) ) );
+        vLowpass = _mm_add_ps ( vLowpass, _mm_mul_ps ( vPolePow, vState ) );
+        vState   = _mm_shuffle_ps ( vLowpass, vLowpass, _MM_SHUFFLE ( 3, 3, 3, 3 ) );
+
+        const __m128 vOut = _mm_add_ps ( _mm_loadu_ps ( &pfIn[i] ), vLowpass );
+
+        _mm_storeu_ps ( &pfDelay[i], vOut );
+        _mm_storeu_ps ( &pfSum[i], _mm_add_ps ( _mm_loadu_ps ( &pfSum[i] ), vOut ) );
+    }
+
+    fState = _mm_cvtss_f32 ( vState );
+
+    // remaining samples
+    CombFilterScalar ( &pfDelay[i], &pfIn[i], &pfSum[i], fState, fFeedback, fPole, iNumSamples - i );
+}
+
+MIXKERNEL_TARGET ( "sse2" )
+static void DotProductStereoSse2 ( const float* pfIn,
+                                   const float* pfCoeff,
+                                   float&       fOutL,
+                                   float&       fOutR,
+                                   const int    iNumFrames )
+{
+    // the lanes contain two frames (L, R, L, R), two accumulators hide the
+    // latency of the additions
+    __m128 vSum0 = _mm_setzero_ps();
+    __m128 vSum1 = _mm_setzero_ps();
+    int    i     = 0;
+
+    for ( ; i + 8 <= 2 * iNumFrames; i += 8 )
+    {
+        vSum0 = _mm_add_ps ( vSum0, _mm_mul_ps ( _mm_loadu_ps ( &pfCoeff[i] ),     _mm_loadu_ps ( &pfIn[i] ) ) );
+        vSum1 = _mm_add_ps ( vSum1, _mm_mul_ps ( _mm_loadu_ps ( &pfCoeff[i + 4] ), _mm_loadu_ps ( &pfIn[i + 4] ) ) );
+    }
+
+    // add the two frames of the lanes
+    vSum0 = _mm_add_ps ( vSum0, vSum1 );
+    vSum0 = _mm_add_ps ( vSum0, _mm_movehl_ps ( vSum0, vSum0 ) );
+
+    // remaining frames
+    float fRemL, fRemR;
+    DotProductStereoScalar ( &pfIn[i], &pfCoeff[i], fRemL, fRemR, iNumFrames - i / 2 );
+
+    fOutL = _mm_cvtss_f32 ( vSum0 ) + fRemL;
+    fOutR = _mm_cvtss_f32 ( _mm_shuffle_ps ( vSum0, vSum0, _MM_SHUFFLE ( 1, 1, 1, 1 ) ) ) + fRemR;
+}
+
+// AVX2 implementation ---------------------------------------------------------
+// (the conversion to int16 is not worth the lane crossing shuffles, therefore
+// only the mixing, the peak value and the FIR filter have an AVX2 version)
+MIXKERNEL_TARGET ( "avx2" )
+static void MixAddAvx2 ( float*       pfOut,
+                         const float* pfIn,
+                         const float  fGain,
+                         const int    iNumSamples )
+{
+    const __m256 vGain = _mm256_set1_ps ( fGain );
+    int          i     = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        _mm256_storeu_ps ( &pfOut[i], _mm256_add_ps ( _mm256_loadu_ps ( &pfOut[i] ),
+                                                      _mm256_mul_ps ( vGain, _mm256_loadu_ps ( &pfIn[i] ) ) ) );
+    }
+
+    // remaining samples
+    MixAddScalar ( &pfOut[i], &pfIn[i], fGain, iNumSamples - i );
+}
+
+MIXKERNEL_TARGET ( "avx2" )
+static float MaxAbsAvx2 ( const float* pfIn,
+                          const int    iNumSamples )
+{
+    const __m256 vAbsMask = _mm256_castsi256_ps ( _mm256_set1_epi32 ( 0x7FFFFFFF ) );
+    __m256       vMax     = _mm256_setzero_ps();
+    int          i        = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        vMax = _mm256_max_ps ( vMax, _mm256_and_ps ( _mm256_loadu_ps ( &pfIn[i] ), vAbsMask ) );
+    }
+
+    // horizontal maximum of the eight lanes
+    __m128 vMax4 = _mm_max_ps ( _mm256_castps256_ps128 ( vMax ), _mm256_extractf128_ps ( vMax, 1 ) );
+    vMax4        = _mm_max_ps ( vMax4, _mm_shuffle_ps ( vMax4, vMax4, _MM_SHUFFLE ( 1, 0, 3, 2 ) ) );
+    vMax4        = _mm_max_ps ( vMax4, _mm_shuffle_ps ( vMax4, vMax4, _MM_SHUFFLE ( 2, 3, 0, 1 ) ) );
+
+    // remaining samples
+    return std::max ( _mm_cvtss_f32 ( vMax4 ), MaxAbsScalar ( &pfIn[i], iNumSamples - i ) );
+}
+
+MIXKERNEL_TARGET ( "avx2" )
+static void DotProductStereoAvx2 ( const float* pfIn,
+                                   const float* pfCoeff,
+                                   float&       fOutL,
+                                   float&       fOutR,
+                                   const int    iNumFrames )
+{
+    __m256 vSum0 = _mm256_setzero_ps();
+    __m256 vSum1 = _mm256_setzero_ps();
+    int    i     = 0;
+
+    for ( ; i + 16 <= 2 * iNumFrames; i += 16 )
+    {
+        vSum0 = _mm256_add_ps ( vSum0, _mm256_mul_ps ( _mm256_loadu_ps ( &pfCoeff[i] ),     _mm256_loadu_ps ( &pfIn[i] ) ) );
+        vSum1 = _mm256_add_ps ( vSum1, _mm256_mul_ps ( _mm256_loadu_ps ( &pfCoeff[i + 8] ), _mm256_loadu_ps ( &pfIn[i + 8] ) ) );
+    }
+
+    // add the four frames of the lanes
+    vSum0        = _mm256_add_ps ( vSum0, vSum1 );
+    __m128 vSum4 = _mm_add_ps ( _mm256_castps256_ps128 ( vSum0 ), _mm256_extractf128_ps ( vSum0, 1 ) );
+    vSum4        = _mm_add_ps ( vSum4, _mm_movehl_ps ( vSum4, vSum4 ) );
+
+    // remaining frames
+    float fRemL, fRemR;
+    DotProductStereoScalar ( &pfIn[i], &pfCoeff[i], fRemL, fRemR, iNumFrames - i / 2 );
+
+    fOutL = _mm_cvtss_f32 ( vSum4 ) + fRemL;
+    fOutR = _mm_cvtss_f32 ( _mm_shuffle_ps ( vSum4, vSum4, _MM_SHUFFLE ( 1, 1, 1, 1 ) ) ) + fRemR;
+}
+
+static bool CpuHasSse2()
+{
+# if defined ( _MSC_VER )
+    int iCpuInfo[4];
+    __cpuid ( iCpuInfo, 1 );
+    return ( iCpuInfo[3] & ( 1 << 26 ) ) != 0;
+# else
+    return __builtin_cpu_supports ( "sse2" );
+# endif
+}
+
+static bool CpuHasAvx2()
+{
+# if defined ( _MSC_VER )
+    int iCpuInfo[4];
+
+    // the OS must support saving the AVX registers (OSXSAVE + XCR0)
+    __cpuid ( iCpuInfo, 1 );
+
+    if ( ( ( iCpuInfo[2] & ( 1 << 27 ) ) == 0 ) ||
+         ( ( iCpuInfo[2] & ( 1 << 28 ) ) == 0 ) ||
+         ( ( _xgetbv ( 0 ) & 6 ) != 6 ) )
+    {
+        return false;
+    }
+
+    __cpuidex ( iCpuInfo, 7, 0 );
+    return ( iCpuInfo[1] & ( 1 << 5 ) ) != 0;
+# else
+    return __builtin_cpu_supports ( "avx2" );
+# endif
+}
+#endif
+
+
+#ifdef MIXKERNEL_NEON
+// NEON implementation ---------------------------------------------------------
+static void MixAddNeon ( float*       pfOut,
+                         const float* pfIn,
+                         const float  fGain,
+                         const int    iNumSamples )
+{
+    int i = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        vst1q_f32 ( &pfOut[i], vmlaq_n_f32 ( vld1q_f32 ( &pfOut[i] ), vld1q_f32 ( &pfIn[i] ), fGain ) );
+    }
+
+    // remaining samples
+    MixAddScalar ( &pfOut[i], &pfIn[i], fGain, iNumSamples - i );
+}
+
+static float MaxAbsNeon ( const float* pfIn,
+                          const int    iNumSamples )
+{
+    float32x4_t vMax = vdupq_n_f32 ( 0.0f );
+    int         i    = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        vMax = vmaxq_f32 ( vMax, vabsq_f32 ( vld1q_f32 ( &pfIn[i] ) ) );
+    }
+
+    // horizontal maximum of the four lanes (pairwise, also available on ARMv7)
+    float32x2_t vMax2 = vpmax_f32 ( vget_low_f32 ( vMax ), vget_high_f32 ( vMax ) );
+    vMax2             = vpmax_f32 ( vMax2, vMax2 );
+
+    // remaining samples
+    return std::max ( vget_lane_f32 ( vMax2, 0 ), MaxAbsScalar ( &pfIn[i], iNumSamples - i ) );
+}
+
+static void MaxAbsStereoNeon ( const float* pfIn,
+                               float&       fMaxL,
+                               float&       fMaxR,
+                               const int    iNumFrames )
+{
+    float32x4_t vMaxL = vdupq_n_f32 ( 0.0f );
+    float32x4_t vMaxR = vdupq_n_f32 ( 0.0f );
+    int         i     = 0;
+
+    for ( ; i + 4 <= iNumFrames; i += 4 )
+    {
+        // de-interleaving load of left and right channel
+        const float32x4x2_t vStereo = vld2q_f32 ( &pfIn[2 * i] );
+
+        vMaxL = vmaxq_f32 ( vMaxL, vabsq_f32 ( vStereo.val[0] ) );
+        vMaxR = vmaxq_f32 ( vMaxR, vabsq_f32 ( vStereo.val[1] ) );
+    }
+
+    // horizontal maximum, the result is { max left, max right }
+    float32x2_t vMax2 = vpmax_f32 ( vpmax_f32 ( vget_low_f32 ( vMaxL ), vget_high_f32 ( vMaxL ) ),
+                                    vpmax_f32 ( vget_low_f32 ( vMaxR ), vget_high_f32 ( vMaxR ) ) );
+
+    // remaining frames
+    MaxAbsStereoScalar ( &pfIn[2 * i], fMaxL, fMaxR, iNumFrames - i );
+
+    fMaxL = std::max ( fMaxL, vget_lane_f32 ( vMax2, 0 ) );
+    fMaxR = std::max ( fMaxR, vget_lane_f32 ( vMax2, 1 ) );
+}
+
+static void MaxAbsStereoShortNeon ( const int16_t* psIn,
+                                    int16_t&       sMaxL,
+                                    int16_t&       sMaxR,
+                                    const int      iNumFrames )
+{
+    int16x8_t vMaxL = vdupq_n_s16 ( 0 );
+    int16x8_t vMaxR = vdupq_n_s16 ( 0 );
+    int       i     = 0;
+
+    for ( ; i + 8 <= iNumFrames; i += 8 )
+    {
+        // de-interleaving load, the saturating absolute value maps -32768 to
+        // 32767 like the scalar code
+        const int16x8x2_t vStereo = vld2q_s16 ( &psIn[2 * i] );
+
+        vMaxL = vmaxq_s16 ( vMaxL, vqabsq_s16 ( vStereo.val[0] ) );
+        vMaxR = vmaxq_s16 ( vMaxR, vqabsq_s16 ( vStereo.val[1] ) );
+    }
+
+    // horizontal maximum (pairwise, also available on ARMv7)
+    int16x4_t vMax4 = vpmax_s16 ( vpmax_s16 ( vget_low_s16 ( vMaxL ), vget_high_s16 ( vMaxL ) ),
+                                  vpmax_s16 ( vget_low_s16 ( vMaxR ), vget_high_s16 ( vMaxR ) ) );
+    vMax4           = vpmax_s16 ( vMax4, vMax4 );
+
+    // remaining frames
+    MaxAbsStereoShortScalar ( &psIn[2 * i], sMaxL, sMaxR, iNumFrames - i );
+
+    sMaxL = std::max ( sMaxL, static_cast<int16_t> ( vget_lane_s16 ( vMax4, 0 ) ) );
+    sMaxR = std::max ( sMaxR, static_cast<int16_t> ( vget_lane_s16 ( vMax4, 1 ) ) );
+}
+
+static inline int16x8_t NeonFloatToShort ( const float* pfIn )
+{
+    // convert to int32 and narrow to int16 with signed saturation
+    return vcombine_s16 ( vqmovn_s32 ( vcvtq_s32_f32 ( vld1q_f32 ( pfIn ) ) ),
+                          vqmovn_s32 ( vcvtq_s32_f32 ( vld1q_f32 ( pfIn + 4 ) ) ) );
+}
+
+static void FloatToShortMonoNeon ( const float* pfIn,
+                                   int16_t*     psOut,
+                                   const int    iNumSamples )
+{
+    int i = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        vst1q_s16 ( &psOut[i], NeonFloatToShort ( &pfIn[i] ) );
+    }
+
+    // remaining samples
+    FloatToShortMonoScalar ( &pfIn[i], &psOut[i], iNumSamples - i );
+}
+
+static void FloatNormToShortNeon ( const float* pfIn,
+                                   int16_t*     psOut,
+                                   const int    iNumSamples )
+{
+    int i = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        const int16x8_t vOut =
+            vcombine_s16 ( vqmovn_s32 ( vcvtq_s32_f32 ( vmulq_n_f32 ( vld1q_f32 ( &pfIn[i] ), MIXKERNEL_NORM_SCALE ) ) ),
+                           vqmovn_s32 ( vcvtq_s32_f32 ( vmulq_n_f32 ( vld1q_f32 ( &pfIn[i + 4] ), MIXKERNEL_NORM_SCALE ) ) ) );
+
+        vst1q_s16 ( &psOut[i], vOut );
+    }
+
+    // remaining samples
+    FloatNormToShortScalar ( &pfIn[i], &psOut[i], iNumSamples - i );
+}
+
+static void AllpassNeon ( float*      pfDelay,
+                          float*      pfInOut,
+                          const float fCoeff,
+                          const int   iNumSamples )
+{
+    int i = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        const float32x4_t vDelayed = vld1q_f32 ( &pfDelay[i] );
+        const float32x4_t vNew     = vmlaq_n_f32 ( vld1q_f32 ( &pfInOut[i] ), vDelayed, fCoeff );
+
+        vst1q_f32 ( &pfInOut[i], vmlsq_n_f32 ( vDelayed, vNew, fCoeff ) );
+        vst1q_f32 ( &pfDelay[i], vNew );
+    }
+
+    // remaining samples
+    AllpassScalar ( &pfDelay[i], &pfInOut[i], fCoeff, iNumSamples - i );
+}
+
+static void CombFilterNeon ( float*       pfDelay,
+                             const float* pfIn,
+                             float*       pfSum,
+                             float&       fState,
+                             const float  fFeedback,
+                             const float  fPole,
+                             const int    iNumSamples )
+{
+    // same prefix computation of the one-pole recursion as for SSE2
+    const float       pfPolePow[4] = { fPole, fPole * fPole, fPole * fPole * fPole, fPole * fPole * fPole * fPole };
+    const float32x4_t vPolePow     = vld1q_f32 ( pfPolePow );
+    const float32x4_t vZero        = vdupq_n_f32 ( 0.0f );
+    float32x4_t       vState       = vdupq_n_f32 ( fState );
+    int               i            = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        float32x4_t vLowpass = vmulq_n_f32 ( vld1q_f32 ( &pfDelay[i] ), fFeedback );
+
+        vLowpass = vmlaq_n_f32 ( vLowpass, vextq_f32 ( vZero, vLowpass, 3 ), fPole );
+        vLowpass = vmlaq_n_f32 ( vLowpass, vextq_f32 ( vZero, vLowpass, 2 ), fPole * fPole );
+        vLowpass = vmlaq_f32 ( vLowpass, vPolePow, vState );
+        vState   = vdupq_lane_f32 ( vget_high_f32 ( vLowpass ), 1 );
+
+        const float32x4_t vOut = vaddq_f32 ( vld1q_f32 ( &pfIn[i] ), vLowpass );
+
+        vst1q_f32 ( &pfDelay[i], vOut );
+        vst1q_f32 ( &pfSum[i], vaddq_f32 ( vld1q_f32 ( &pfSum[i] ), vOut ) );
+    }
+
+    fState = vgetq_lane_f32 ( vState, 0 );
+
+    // remaining samples
+    CombFilterScalar ( &pfDelay[i], &pfIn[i], &pfSum[i], fState, fFeedback, fPole, iNumSamples - i );
+}
+
+static void DotProductStereoNeon ( const float* pfIn,
+                                   const float* pfCoeff,
+                                   float&       fOutL,
+                                   float&       fOutR,
+                                   const int    iNumFrames )
+{
+    float32x4_t vSum0 = vdupq_n_f32 ( 0.0f );
+    float32x4_t vSum1 = vdupq_n_f32 ( 0.0f );
+    int         i     = 0;
+
+    for ( ; i + 8 <= 2 * iNumFrames; i += 8 )
+    {
+        vSum0 = vmlaq_f32 ( vSum0, vld1q_f32 ( &pfCoeff[i] ),     vld1q_f32 ( &pfIn[i] ) );
+        vSum1 = vmlaq_f32 ( vSum1, vld1q_f32 ( &pfCoeff[i + 4] ), vld1q_f32 ( &pfIn[i + 4] ) );
+    }
+
+    // add the two frames of the lanes
+    vSum0                 = vaddq_f32 ( vSum0, vSum1 );
+    const float32x2_t vLR = vadd_f32 ( vget_low_f32 ( vSum0 ), vget_high_f32 ( vSum0 ) );
+
+    // remaining frames
+    float fRemL, fRemR;
+    DotProductStereoScalar ( &pfIn[i], &pfCoeff[i], fRemL, fRemR, iNumFrames - i / 2 );
+
+    fOutL = vget_lane_f32 ( vLR, 0 ) + fRemL;
+    fOutR = vget_lane_f32 ( vLR, 1 ) + fRemR;
+}
+
+static void FloatToShortStereoNeon ( const float* pfInLeft,
+                                     const float* pfInRight,
+                                     int16_t*     psOut,
+                                     const int    iNumSamples )
+{
+    int i = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        int16x8x2_t vStereo;
+
+        vStereo.val[0] = NeonFloatToShort ( &pfInLeft[i] );
+        vStereo.val[1] = NeonFloatToShort ( &pfInRight[i] );
+
+        // interleaved store of left and right channel
+        vst2q_s16 ( &psOut[2 * i], vStereo );
+    }
+
+    // remaining samples
+    FloatToShortStereoScalar ( &pfInLeft[i], &pfInRight[i], &psOut[2 * i], iNumSamples - i );
+}
+
+static void FloatNormToShortStereoNeon ( const float* pfInLeft,
+                                         const float* pfInRight,
+                                         int16_t*     psOut,
+                                         const int    iNumSamples )
+{
+    int i = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        int16x8x2_t vStereo;
+
+        vStereo.val[0] =
+            vcombine_s16 ( vqmovn_s32 ( vcvtq_s32_f32 ( vmulq_n_f32 ( vld1q_f32 ( &pfInLeft[i] ), MIXKERNEL_NORM_SCALE ) ) ),
+                           vqmovn_s32 ( vcvtq_s32_f32 ( vmulq_n_f32 ( vld1q_f32 ( &pfInLeft[i + 4] ), MIXKERNEL_NORM_SCALE ) ) ) );
+
+        vStereo.val[1] =
+            vcombine_s16 ( vqmovn_s32 ( vcvtq_s32_f32 ( vmulq_n_f32 ( vld1q_f32 ( &pfInRight[i] ), MIXKERNEL_NORM_SCALE ) ) ),
+                           vqmovn_s32 ( vcvtq_s32_f32 ( vmulq_n_f32 ( vld1q_f32 ( &pfInRight[i + 4] ), MIXKERNEL_NORM_SCALE ) ) ) );
+
+        // interleaved store of left and right channel
+        vst2q_s16 ( &psOut[2 * i], vStereo );
+    }
+
+    // remaining samples
+    FloatNormToShortStereoScalar ( &pfInLeft[i], &pfInRight[i], &psOut[2 * i], iNumSamples - i );
+}
+
+static void ShortToFloatNormStereoNeon ( const int16_t* psIn,
+                                         float*         pfOutLeft,
+                                         float*         pfOutRight,
+                                         const int      iNumSamples )
+{
+    const float fScale = 1.0f / MIXKERNEL_NORM_SCALE;
+    int         i      = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        // de-interleaving load of left and right channel
+        const int16x8x2_t vStereo = vld2q_s16 ( &psIn[2 * i] );
+
+        vst1q_f32 ( &pfOutLeft[i],      vmulq_n_f32 ( vcvtq_f32_s32 ( vmovl_s16 ( vget_low_s16 ( vStereo.val[0] ) ) ), fScale ) );
+        vst1q_f32 ( &pfOutLeft[i + 4],  vmulq_n_f32 ( vcvtq_f32_s32 ( vmovl_s16 ( vget_high_s16 ( vStereo.val[0] ) ) ), fScale ) );
+        vst1q_f32 ( &pfOutRight[i],     vmulq_n_f32 ( vcvtq_f32_s32 ( vmovl_s16 ( vget_low_s16 ( vStereo.val[1] ) ) ), fScale ) );
+        vst1q_f32 ( &pfOutRight[i + 4], vmulq_n_f32 ( vcvtq_f32_s32 ( vmovl_s16 ( vget_high_s16 ( vStereo.val[1] ) ) ), fScale ) );
+    }
+
+    // remaining samples
+    ShortToFloatNormStereoScalar ( &psIn[2 * i], &pfOutLeft[i], &pfOutRight[i], iNumSamples - i );
+}
+#endif
+
+
+// CMixKernel ------------------------------------------------------------------
+CMixKernel::TMixAddFct             CMixKernel::MixAddImpl                 = MixAddScalar;
+CMixKernel::TMaxAbsFct             CMixKernel::MaxAbsImpl                 = MaxAbsScalar;
+CMixKernel::TMaxAbsStereoFct       CMixKernel::MaxAbsStereoImpl           = MaxAbsStereoScalar;
+CMixKernel::TMaxAbsStereoShortFct  CMixKernel::MaxAbsStereoShortImpl      = MaxAbsStereoShortScalar;
+CMixKernel::TFloatToShortMonoFct   CMixKernel::FloatToShortMonoImpl       = FloatToShortMonoScalar;
+CMixKernel::TFloatToShortStereoFct CMixKernel::FloatToShortStereoImpl     = FloatToShortStereoScalar;
+CMixKernel::TFloatToShortMonoFct   CMixKernel::FloatNormToShortImpl       = FloatNormToShortScalar;
+CMixKernel::TFloatToShortStereoFct CMixKernel::FloatNormToShortStereoImpl = FloatNormToShortStereoScalar;
+CMixKernel::TShortToFloatStereoFct CMixKernel::ShortToFloatNormStereoImpl = ShortToFloatNormStereoScalar;
+CMixKernel::TAllpassFct            CMixKernel::AllpassImpl                = AllpassScalar;
+CMixKernel::TCombFilterFct         CMixKernel::CombFilterImpl             = CombFilterScalar;
+CMixKernel::TDotProductStereoFct   CMixKernel::DotProductStereoImpl       = DotProductStereoScalar;
+const char*                        CMixKernel::pcImplName                 = "scalar";
+
+void CMixKernel::Init()
+{
+#if defined ( MIXKERNEL_X86 )
+    if ( CpuHasSse2() )
+    {
+        MixAddImpl                 = MixAddSse2;
+        MaxAbsImpl                 = MaxAbsSse2;
+        MaxAbsStereoImpl           = MaxAbsStereoSse2;
+        MaxAbsStereoShortImpl      = MaxAbsStereoShortSse2;
+        FloatToShortMonoImpl       = FloatToShortMonoSse2;
+        FloatToShortStereoImpl     = FloatToShortStereoSse2;
+        FloatNormToShortImpl       = FloatNormToShortSse2;
+        FloatNormToShortStereoImpl = FloatNormToShortStereoSse2;
+        ShortToFloatNormStereoImpl = ShortToFloatNormStereoSse2;
+        AllpassImpl                = AllpassSse2;
+        CombFilterImpl             = CombFilterSse2;
+        DotProductStereoImpl       = DotProductStereoSse2;
+        pcImplName                 = "SSE2";
+
+        if ( CpuHasAvx2() )
+        {
+            MixAddImpl           = MixAddAvx2;
+            MaxAbsImpl           = MaxAbsAvx2;
+            DotProductStereoImpl = DotProductStereoAvx2;
+            pcImplName           = "AVX2";
+        }
+    }
+#elif defined ( MIXKERNEL_NEON )
+    MixAddImpl                 = MixAddNeon;
+    MaxAbsImpl                 = MaxAbsNeon;
+    MaxAbsStereoImpl           = MaxAbsStereoNeon;
+    MaxAbsStereoShortImpl      = MaxAbsStereoShortNeon;
+    FloatToShortMonoImpl       = FloatToShortMonoNeon;
+    FloatToShortStereoImpl     = FloatToShortStereoNeon;
+    FloatNormToShortImpl       = FloatNormToShortNeon;
+    FloatNormToShortStereoImpl = FloatNormToShortStereoNeon;
+    ShortToFloatNormStereoImpl = ShortToFloatNormStereoNeon;
+    AllpassImpl                = AllpassNeon;
+    CombFilterImpl             = CombFilterNeon;
+    DotProductStereoImpl       = DotProductStereoNeon;
+    pcImplName                 = "NEON";
+#endif
+}
+
+void CMixKernel::ShortToFloatMono ( const int16_t* psIn,
+                                    float*         pfOut,
+                                    const int      iNumSamples )
+{
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        pfOut[i] = static_cast<float> ( psIn[i] );
+    }
+}
+
+void CMixKernel::ShortToFloatStereo ( const int16_t* psIn,
+                                      float*         pfOutLeft,
+                                      float*         pfOutRight,
+                                      float*         pfOutMono,
+                                      const int      iNumSamples )
+{
+    for ( int i = 0, k = 0; i < iNumSamples; i++, k += 2 )
+    {
+        pfOutLeft[i]  = static_cast<float> ( psIn[k] );
+        pfOutRight[i] = static_cast<float> ( psIn[k + 1] );
+
+        // stereo-to-mono attenuation
+        pfOutMono[i] = ( pfOutLeft[i] + pfOutRight[i] ) / 2;
+    }
+}
+
+void CMixKernel::ShortToFloatNorm ( const int16_t* psIn,
+                                    float*         pfOut,
+                                    const int      iNumSamples )
+{
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        pfOut[i] = static_cast<float> ( psIn[i] ) * ( 1.0f / MIXKERNEL_NORM_SCALE );
+    }
+}
+
+void CMixKernel::GainStereo ( float*      pfInOut,
+                              const float fGainL,
+                              const float fGainR,
+                              const int   iNumFrames )
+{
+    for ( int i = 0, k = 0; i < iNumFrames; i++, k += 2 )
+    {
+        pfInOut[k]     *= fGainL;
+        pfInOut[k + 1] *= fGainR;
+    }
+}
+
+void CMixKernel::MixAddRamp ( float*       pfOut,
+                              const float* pfIn,
+                              const float  fGainStart,
+                              const float  fGainEnd,
+                              const int    iNumSamples )
+{
+    const float fGainStep = ( fGainEnd - fGainStart ) / iNumSamples;
+
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        pfOut[i] += ( fGainStart + fGainStep * ( i + 1 ) ) * pfIn[i];
+    }
+}
+
+void CMixKernel::GainRamp ( float*      pfInOut,
+                            const float fGainStart,
+                            const float fGainEnd,
+                            const int   iNumSamples )
+{
+    const float fGainStep = ( fGainEnd - fGainStart ) / iNumSamples;
+
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        pfInOut[i] *= fGainStart + fGainStep * ( i + 1 );
+    }
+}
+
+void CMixKernel::MixDownStereo ( const float* pfIn,
+                                 float*       pfOut,
+                                 const float  fGainL,
+                                 const float  fGainR,
+                                 const int    iNumFrames )
+{
+    // the output index never exceeds the input index, therefore the in-place
+    // operation is possible
+    for ( int i = 0, k = 0; i < iNumFrames; i++, k += 2 )
+    {
+        pfOut[i] = fGainL * pfIn[k] + fGainR * pfIn[k + 1];
+    }
+}
@@ -0,0 +1,217 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+
+/* Classes ********************************************************************/
+// Vectorized mixing kernels which work on planar float buffers. The actual
+// implementation (scalar, SSE2, AVX2 or NEON) is selected at runtime by
+// calling Init() once before the kernels are used.
+class CMixKernel
+{
+public:
+    static void Init();
+
+    // the mixing kernels do not depend on Qt (they are part of the real-time
+    // core, see Jamulus.pro)
+    static const char* GetImplementationName() { return pcImplName; }
+
+    // mix the input buffer with the given gain on the output buffer:
+    // pfOut[i] += fGain * pfIn[i]
+    static void MixAdd ( float*       pfOut,
+                         const float* pfIn,
+                         const float  fGain,
+                         const int    iNumSamples )
+        { MixAddImpl ( pfOut, pfIn, fGain, iNumSamples ); }
+
+    // peak value of the buffer: max ( |pfIn[i]| ) (used for the level meters)
+    static float MaxAbs ( const float* pfIn,
+                          const int    iNumSamples )
+        { return MaxAbsImpl ( pfIn, iNumSamples ); }
+
+    // peak values of the left and right channel of an interleaved stereo
+    // buffer with iNumFrames sample pairs (used by the level meter of the
+    // client), the int16 version saturates |-32768| to 32767
+    static void MaxAbsStereo ( const float* pfIn,
+                               float&       fMaxL,
+                               float&       fMaxR,
+                               const int    iNumFrames )
+        { MaxAbsStereoImpl ( pfIn, fMaxL, fMaxR, iNumFrames ); }
+
+    static void MaxAbsStereoShort ( const int16_t* psIn,
+                                    int16_t&       sMaxL,
+                                    int16_t&       sMaxR,
+                                    const int      iNumFrames )
+        { MaxAbsStereoShortImpl ( psIn, sMaxL, sMaxR, iNumFrames ); }
+
+    // convert the planar float buffers to (interleaved) int16 samples, this is
+    // the only place where the saturation of the mixed signal takes place
+    static void FloatToShortMono ( const float* pfIn,
+                                   int16_t*     psOut,
+                                   const int    iNumSamples )
+        { FloatToShortMonoImpl ( pfIn, psOut, iNumSamples ); }
+
+    static void FloatToShortStereo ( const float* pfInLeft,
+                                     const float* pfInRight,
+                                     int16_t*     psOut,
+                                     const int    iNumSamples )
+        { FloatToShortStereoImpl ( pfInLeft, pfInRight, psOut, iNumSamples ); }
+
+    // de-interleave int16 samples to planar float buffers (the stereo version
+    // additionally produces the mono down-mix (L + R) / 2)
+    static void ShortToFloatMono ( const int16_t* psIn,
+                                   float*         pfOut,
+                                   const int      iNumSamples );
+
+    static void ShortToFloatStereo ( const int16_t* psIn,
+                                     float*         pfOutLeft,
+                                     float*         pfOutRight,
+                                     float*         pfOutMono,
+                                     const int      iNumSamples );
+
+    // conversion between int16 samples and float samples with the scale of the
+    // OPUS float API (full scale is +-1), used by the client which works on
+    // interleaved buffers (the conversion to int16 saturates)
+    static void ShortToFloatNorm ( const int16_t* psIn,
+                                   float*         pfOut,
+                                   const int      iNumSamples );
+
+    static void FloatNormToShort ( const float* pfIn,
+                                   int16_t*     psOut,
+                                   const int    iNumSamples )
+        { FloatNormToShortImpl ( pfIn, psOut, iNumSamples ); }
+
+    // the same conversions between planar float buffers (full scale is +-1)
+    // and interleaved stereo int16 samples, used by the sound card backends
+    // which deliver separate buffers per channel
+    static void FloatNormToShortStereo ( const float* pfInLeft,
+                                         const float* pfInRight,
+                                         int16_t*     psOut,
+                                         const int    iNumSamples )
+        { FloatNormToShortStereoImpl ( pfInLeft, pfInRight, psOut, iNumSamples ); }
+
+    static void ShortToFloatNormStereo ( const int16_t* psIn,
+                                         float*         pfOutLeft,
+                                         float*         pfOutRight,
+                                         const int      iNumSamples )
+        { ShortToFloatNormStereoImpl ( psIn, pfOutLeft, pfOutRight, iNumSamples ); }
+
+    // apply separate gains on the left and right channel of an interleaved
+    // stereo buffer with iNumFrames sample pairs
+    static void GainStereo ( float*      pfInOut,
+                             const float fGainL,
+                             const float fGainR,
+                             const int   iNumFrames );
+
+    // mix with a linear gain ramp from fGainStart (exclusive) to fGainEnd
+    // (inclusive) on the output buffer, used for the smoothing of the gains:
+    // pfOut[i] += ( fGainStart + ( fGainEnd - fGainStart ) * ( i + 1 ) / N ) * pfIn[i]
+    static void MixAddRamp ( float*       pfOut,
+                             const float* pfIn,
+                             const float  fGainStart,
+                             const float  fGainEnd,
+                             const int    iNumSamples );
+
+    // apply a linear gain ramp from fGainStart (exclusive) to fGainEnd
+    // (inclusive) over the buffer, used for the fade-in without zipper noise
+    static void GainRamp ( float*      pfInOut,
+                           const float fGainStart,
+                           const float fGainEnd,
+                           const int   iNumSamples );
+
+    // weighted down-mix of an interleaved stereo buffer to mono:
+    // pfOut[i] = fGainL * pfIn[2 * i] + fGainR * pfIn[2 * i + 1]
+    // (pfOut may be equal to pfIn for an in-place down-mix)
+    static void MixDownStereo ( const float* pfIn,
+                                float*       pfOut,
+                                const float  fGainL,
+                                const float  fGainR,
+                                const int    iNumFrames );
+
+    // kernels of the reverberation, both work on a contiguous part of the
+    // delay line of the filter (pfDelay contains the delayed samples on input
+    // and the new delay line samples on output)
+    // allpass filter in place on pfInOut:
+    // w = pfInOut[i] + fCoeff * pfDelay[i]
+    // pfInOut[i] = pfDelay[i] - fCoeff * w, pfDelay[i] = w
+    static void Allpass ( float*      pfDelay,
+                          float*      pfInOut,
+                          const float fCoeff,
+                          const int   iNumSamples )
+        { AllpassImpl ( pfDelay, pfInOut, fCoeff, iNumSamples ); }
+
+    // feedback comb filter with a one-pole lowpass in the feedback path, the
+    // filter output is added on pfSum:
+    // fState = fFeedback * pfDelay[i] + fPole * fState
+    // pfDelay[i] = pfIn[i] + fState, pfSum[i] += pfDelay[i]
+    static void CombFilter ( float*       pfDelay,
+                             const float* pfIn,
+                             float*       pfSum,
+                             float&       fState,
+                             const float  fFeedback,
+                             const float  fPole,
+                             const int    iNumSamples )
+        { CombFilterImpl ( pfDelay, pfIn, pfSum, fState, fFeedback, fPole, iNumSamples ); }
+
+    // FIR filter kernel on an interleaved stereo buffer, the coefficients are
+    // given per sample, i.e. each coefficient is stored twice (used by the
+    // sample rate converter):
+    // fOutL = sum pfCoeff[2 * i] * pfIn[2 * i]
+    // fOutR = sum pfCoeff[2 * i + 1] * pfIn[2 * i + 1]
+    static void DotProductStereo ( const float* pfIn,
+                                   const float* pfCoeff,
+                                   float&       fOutL,
+                                   float&       fOutR,
+                                   const int    iNumFrames )
+        { DotProductStereoImpl ( pfIn, pfCoeff, fOutL, fOutR, iNumFrames ); }
+
+protected:
+    typedef void ( *TMixAddFct )            ( float*, const float*, const float, const int );
+    typedef float ( *TMaxAbsFct )           ( const float*, const int );
+    typedef void ( *TMaxAbsStereoFct )      ( const float*, float&, float&, const int );
+    typedef void ( *TMaxAbsStereoShortFct ) ( const int16_t*, int16_t&, int16_t&, const int );
+    typedef void ( *TFloatToShortMonoFct )  ( const float*, int16_t*, const int );
+    typedef void ( *TFloatToShortStereoFct )( const float*, const float*, int16_t*, const int );
+    typedef void ( *TShortToFloatStereoFct )( const int16_t*, float*, float*, const int );
+    typedef void ( *TAllpassFct )           ( float*, float*, const float, const int );
+    typedef void ( *TCombFilterFct )        ( float*, const float*, float*, float&, const float, const float, const int );
+    typedef void ( *TDotProductStereoFct )  ( const float*, const float*, float&, float&, const int );
+
+    static TMixAddFct             MixAddImpl;
+    static TMaxAbsFct             MaxAbsImpl;
+    static TMaxAbsStereoFct       MaxAbsStereoImpl;
+    static TMaxAbsStereoShortFct  MaxAbsStereoShortImpl;
+    static TFloatToShortMonoFct   FloatToShortMonoImpl;
+    static TFloatToShortStereoFct FloatToShortStereoImpl;
+    static TFloatToShortMonoFct   FloatNormToShortImpl;
+    static TFloatToShortStereoFct FloatNormToShortStereoImpl;
+    static TShortToFloatStereoFct ShortToFloatNormStereoImpl;
+    static TAllpassFct            AllpassImpl;
+    static TCombFilterFct         CombFilterImpl;
+    static TDotProductStereoFct   DotProductStereoImpl;
+    static const char*            pcImplName;
+};
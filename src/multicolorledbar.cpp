@@ -30,61 +30,131 @@
 
 /* Implementation *************************************************************/
 CMultiColorLEDBar::CMultiColorLEDBar ( QWidget* parent, Qt::WindowFlags f ) :
-    QWidget ( parent, f ),
-    eLevelMeterType ( MT_BAR )
+    QWidget             ( parent, f ),
+    eLevelMeterType     ( MT_BAR ),
+    iNumActiveLEDs      ( 0 ),
+    iBarLevel           ( 0 ),
+    dCurValue           ( 0 ),
+    BitmCubeRoundBlack  ( QString::fromUtf8 ( ":/png/LEDs/res/HLEDBlackSmall.png" ) ),
+    BitmCubeRoundGreen  ( QString::fromUtf8 ( ":/png/LEDs/res/HLEDGreenSmall.png" ) ),
+    BitmCubeRoundYellow ( QString::fromUtf8 ( ":/png/LEDs/res/HLEDYellowSmall.png" ) ),
+    BitmCubeRoundRed    ( QString::fromUtf8 ( ":/png/LEDs/res/HLEDRedSmall.png" ) )
+{
+    // according to QScrollArea description: "When using a scroll area to display the
+    // contents of a custom widget, it is important to ensure that the size hint of
+    // the child widget is set to a suitable value."
+    setSizePolicy ( QSizePolicy::Preferred, QSizePolicy::Expanding );
+
+    // update the meter type (using the default value of the meter type)
+    SetLevelMeterType ( eLevelMeterType );
+}
+
+QSize CMultiColorLEDBar::sizeHint() const
 {
-    // initialize LED meter
-    QWidget*     pLEDMeter  = new QWidget();
-    QVBoxLayout* pLEDLayout = new QVBoxLayout ( pLEDMeter );
-    pLEDLayout->setAlignment ( Qt::AlignHCenter );
-    pLEDLayout->setMargin    ( 0 );
-    pLEDLayout->setSpacing   ( 0 );
+    const QMargins Margins = contentsMargins();
+
+    return QSize ( GetMeterWidth() + Margins.left() + Margins.right(),
+                   NUM_STEPS_LED_BAR * BitmCubeRoundBlack.height() + Margins.top() + Margins.bottom() );
+}
 
-    // create LEDs
-    vecpLEDs.Init ( NUM_STEPS_LED_BAR );
+QSize CMultiColorLEDBar::minimumSizeHint() const
+{
+    const QMargins Margins = contentsMargins();
 
-    for ( int iLEDIdx = NUM_STEPS_LED_BAR - 1; iLEDIdx >= 0; iLEDIdx-- )
+    return QSize ( GetMeterWidth() + Margins.left() + Margins.right(), 1 );
+}
+
+int CMultiColorLEDBar::GetMeterWidth() const
+{
+    switch ( eLevelMeterType )
     {
-        // create LED object
-        vecpLEDs[iLEDIdx] = new cLED ( parent );
+    case MT_LED:
+        return BitmCubeRoundBlack.width();
 
-        // add LED to layout with spacer (do not add spacer on the bottom of the first LED)
-        if ( iLEDIdx < NUM_STEPS_LED_BAR - 1 )
-        {
-            pLEDLayout->addStretch();
-        }
+    case MT_BAR:
+        // margin, border and padding on both sides
+        return LED_BAR_WIDTH + 6;
 
-        pLEDLayout->addWidget ( vecpLEDs[iLEDIdx]->getLabelPointer() );
+    case MT_SLIM_BAR:
+        return LED_SLIM_BAR_WIDTH;
     }
 
-    // initialize bar meter
-    pProgressBar = new QProgressBar();
-    pProgressBar->setOrientation ( Qt::Vertical );
-    pProgressBar->setRange ( 0, 100 * NUM_STEPS_LED_BAR );
-    pProgressBar->setFormat ( "" ); // suppress percent numbers
+    return 0;
+}
 
-    // setup stacked layout for meter type switching mechanism
-    pStackedLayout = new QStackedLayout ( this );
-    pStackedLayout->addWidget ( pLEDMeter );
-    pStackedLayout->addWidget ( pProgressBar );
+QRect CMultiColorLEDBar::GetLEDRect ( const int iLEDIdx ) const
+{
+    // the top LED is at the top and the first LED at the bottom of the widget,
+    // the remaining space is equally distributed between the LEDs
+    const QRect ContRect       = contentsRect();
+    const int   iLEDWidth      = BitmCubeRoundBlack.width();
+    const int   iLEDHeight     = BitmCubeRoundBlack.height();
+    const int   iFreeSpace     = std::max ( 0, ContRect.height() - NUM_STEPS_LED_BAR * iLEDHeight );
+    const int   iLEDPosFromTop = NUM_STEPS_LED_BAR - 1 - iLEDIdx;
 
-    // according to QScrollArea description: "When using a scroll area to display the
-    // contents of a custom widget, it is important to ensure that the size hint of
-    // the child widget is set to a suitable value."
-    pProgressBar->setMinimumSize ( QSize ( 1, 1 ) );
-    pLEDMeter->setMinimumSize    ( QSize ( 1, 1 ) );
+    return QRect ( ContRect.left() + ( ContRect.width() - iLEDWidth ) / 2,
+                   ContRect.top() + iLEDPosFromTop * iLEDHeight +
+                       iLEDPosFromTop * iFreeSpace / ( NUM_STEPS_LED_BAR - 1 ),
+                   iLEDWidth,
+                   iLEDHeight );
+}
 
-    // update the meter type (using the default value of the meter type)
-    SetLevelMeterType ( eLevelMeterType );
+QRect CMultiColorLEDBar::GetBarRect() const
+{
+    const QRect ContRect  = contentsRect();
+    const int   iBarWidth = std::min ( GetMeterWidth(), ContRect.width() );
+
+    QRect BarRect ( ContRect.left() + ( ContRect.width() - iBarWidth ) / 2,
+                    ContRect.top(),
+                    iBarWidth,
+                    ContRect.height() );
+
+    if ( eLevelMeterType == MT_BAR )
+    {
+        // the level bar is inside the margin, the border and the padding
+        BarRect.adjust ( 3, 3, -3, -3 );
+    }
+
+    return BarRect;
+}
+
+QRect CMultiColorLEDBar::GetBarLevelRect ( const int iLevel ) const
+{
+    const QRect BarRect = GetBarRect();
+
+    return QRect ( BarRect.left(),
+                   BarRect.bottom() - iLevel + 1,
+                   BarRect.width(),
+                   iLevel );
 }
 
-CMultiColorLEDBar::~CMultiColorLEDBar()
+void CMultiColorLEDBar::UpdateBarPixmap()
 {
-    // clean up the LED objects
-    for ( int iLEDIdx = 0; iLEDIdx < NUM_STEPS_LED_BAR; iLEDIdx++ )
+    const QRect BarRect = GetBarRect();
+
+    if ( BarRect.isEmpty() )
     {
-        delete vecpLEDs[iLEDIdx];
+        BitmBar = QPixmap();
+    }
+    else
+    {
+        // render the complete level bar once, on a level change only the
+        // visible part of this pixmap is copied on the widget
+        QLinearGradient BarGradient ( 0, 0, BarRect.width(), 0 );
+        BarGradient.setColorAt ( 0,   QColor ( 0, 128, 0 ) );
+        BarGradient.setColorAt ( 0.5, QColor ( 0, 176, 0 ) );
+        BarGradient.setColorAt ( 1,   QColor ( 0, 128, 0 ) );
+
+        BitmBar = QPixmap ( BarRect.size() );
+
+        QPainter BarPainter ( &BitmBar );
+        BarPainter.fillRect ( BitmBar.rect(), BarGradient );
     }
+
+    // the height of the level bar depends on the widget size
+    iBarLevel = qBound ( 0,
+                         static_cast<int> ( dCurValue * BarRect.height() / NUM_STEPS_LED_BAR ),
+                         std::max ( 0, BarRect.height() ) );
 }
 
 void CMultiColorLEDBar::changeEvent ( QEvent* curEvent )
@@ -92,155 +162,142 @@ void CMultiColorLEDBar::changeEvent ( QEvent* curEvent )
     // act on enabled changed state
     if ( curEvent->type() == QEvent::EnabledChange )
     {
-        // reset all LEDs
-        Reset ( this->isEnabled() );
+        // reset all LEDs (a disabled control does not show any LED)
+        iNumActiveLEDs = 0;
+        update();
     }
+
+    QWidget::changeEvent ( curEvent );
 }
 
-void CMultiColorLEDBar::Reset ( const bool bEnabled )
+void CMultiColorLEDBar::resizeEvent ( QResizeEvent* )
 {
-    // update state of all LEDs
-    for ( int iLEDIdx = 0; iLEDIdx < NUM_STEPS_LED_BAR; iLEDIdx++ )
-    {
-        // different reset behavoiur for enabled and disabled control
-        if ( bEnabled )
-        {
-            vecpLEDs[iLEDIdx]->setColor ( cLED::RL_BLACK );
-        }
-        else
-        {
-            vecpLEDs[iLEDIdx]->setColor ( cLED::RL_DISABLED );
-        }
-    }
+    // the resized widget is completely repainted anyway
+    UpdateBarPixmap();
 }
 
 void CMultiColorLEDBar::SetLevelMeterType ( const ELevelMeterType eNType )
 {
     eLevelMeterType = eNType;
 
-    switch ( eNType )
-    {
-    case MT_LED:
-        pStackedLayout->setCurrentIndex ( 0 );
-        break;
-
-    case MT_BAR:
-        pStackedLayout->setCurrentIndex ( 1 );
-        pProgressBar->setStyleSheet (
-            "QProgressBar        { margin:     1px;"
-            "                      padding:    1px; "
-            "                      width:      15px; }"
-            "QProgressBar::chunk { background: green; }" );
-        break;
-
-    case MT_SLIM_BAR:
-        // set all LEDs to disabled, otherwise we would not get our desired small width
-        for ( int iLEDIdx = 0; iLEDIdx < NUM_STEPS_LED_BAR; iLEDIdx++ )
-        {
-            vecpLEDs[iLEDIdx]->setColor ( cLED::RL_DISABLED );
-        }
+    // the LEDs are reset on a meter type change
+    iNumActiveLEDs = 0;
 
-        pStackedLayout->setCurrentIndex ( 1 );
-        pProgressBar->setStyleSheet (
-            "QProgressBar        { border:     0px;"
-            "                      margin:     0px;"
-            "                      padding:    0px; "
-            "                      width:      4px; }"
-            "QProgressBar::chunk { background: green; }" );
-        break;
-    }
+    UpdateBarPixmap();
+    updateGeometry();
+    update();
 }
 
 void CMultiColorLEDBar::setValue ( const double dValue )
 {
     if ( this->isEnabled() )
     {
+        dCurValue = dValue;
+
         switch ( eLevelMeterType )
         {
         case MT_LED:
-            // update state of all LEDs for current level value
-            for ( int iLEDIdx = 0; iLEDIdx < NUM_STEPS_LED_BAR; iLEDIdx++ )
+        {
+            // a LED is active if the value is above the current LED index
+            const int iNewNumActiveLEDs =
+                qBound ( 0, static_cast<int> ( ceil ( dValue ) ), NUM_STEPS_LED_BAR );
+
+            // only repaint the LEDs which changed their color
+            for ( int iLEDIdx = std::min ( iNewNumActiveLEDs, iNumActiveLEDs );
+                  iLEDIdx < std::max ( iNewNumActiveLEDs, iNumActiveLEDs ); iLEDIdx++ )
             {
-                // set active LED color if value is above current LED index
-                if ( iLEDIdx < dValue )
-                {
-                    // check which color we should use (green, yellow or red)
-                    if ( iLEDIdx < YELLOW_BOUND_LED_BAR )
-                    {
-                        // green region
-                        vecpLEDs[iLEDIdx]->setColor ( cLED::RL_GREEN );
-                    }
-                    else
-                    {
-                        if ( iLEDIdx < RED_BOUND_LED_BAR )
-                        {
-                            // yellow region
-                            vecpLEDs[iLEDIdx]->setColor ( cLED::RL_YELLOW );
-                        }
-                        else
-                        {
-                            // red region
-                            vecpLEDs[iLEDIdx]->setColor ( cLED::RL_RED );
-                        }
-                    }
-                }
-                else
-                {
-                    // we use grey LED for inactive state
-                    vecpLEDs[iLEDIdx]->setColor ( cLED::RL_BLACK );
-                }
+                update ( GetLEDRect ( iLEDIdx ) );
             }
+
+            iNumActiveLEDs = iNewNumActiveLEDs;
             break;
+        }
 
         case MT_BAR:
         case MT_SLIM_BAR:
-            pProgressBar->setValue ( 100 * dValue );
+        {
+            const int iBarHeight   = std::max ( 0, GetBarRect().height() );
+            const int iNewBarLevel =
+                qBound ( 0, static_cast<int> ( dValue * iBarHeight / NUM_STEPS_LED_BAR ), iBarHeight );
+
+            // only repaint the part of the bar between the old and new level
+            if ( iNewBarLevel != iBarLevel )
+            {
+                const QRect MaxLevelRect = GetBarLevelRect ( std::max ( iNewBarLevel, iBarLevel ) );
+
+                update ( MaxLevelRect.left(),
+                         MaxLevelRect.top(),
+                         MaxLevelRect.width(),
+                         std::abs ( iNewBarLevel - iBarLevel ) );
+
+                iBarLevel = iNewBarLevel;
+            }
             break;
         }
+        }
     }
 }
 
-CMultiColorLEDBar::cLED::cLED ( QWidget* parent ) :
-    BitmCubeRoundBlack  ( QString::fromUtf8 ( ":/png/LEDs/res/HLEDBlackSmall.png" ) ),
-    BitmCubeRoundGreen  ( QString::fromUtf8 ( ":/png/LEDs/res/HLEDGreenSmall.png" ) ),
-    BitmCubeRoundYellow ( QString::fromUtf8 ( ":/png/LEDs/res/HLEDYellowSmall.png" ) ),
-    BitmCubeRoundRed    ( QString::fromUtf8 ( ":/png/LEDs/res/HLEDRedSmall.png" ) )
+void CMultiColorLEDBar::paintEvent ( QPaintEvent* pEvent )
 {
-    // create LED label
-    pLEDLabel = new QLabel ( "", parent );
-
-    // set initial bitmap
-    pLEDLabel->setPixmap ( BitmCubeRoundBlack );
-    eCurLightColor = RL_BLACK;
-}
+    QPainter Painter ( this );
 
-void CMultiColorLEDBar::cLED::setColor ( const ELightColor eNewColor )
-{
-    // only update LED if color has changed
-    if ( eNewColor != eCurLightColor )
+    if ( eLevelMeterType == MT_LED )
     {
-        switch ( eNewColor )
+        if ( this->isEnabled() )
         {
-        case RL_DISABLED:
-            pLEDLabel->setPixmap ( QPixmap() );
-            break;
+            for ( int iLEDIdx = 0; iLEDIdx < NUM_STEPS_LED_BAR; iLEDIdx++ )
+            {
+                const QRect LEDRect = GetLEDRect ( iLEDIdx );
 
-        case RL_BLACK:
-            pLEDLabel->setPixmap ( BitmCubeRoundBlack );
-            break;
+                if ( pEvent->rect().intersects ( LEDRect ) )
+                {
+                    // check which color we should use (green, yellow or red),
+                    // we use grey LED for inactive state
+                    if ( iLEDIdx >= iNumActiveLEDs )
+                    {
+                        Painter.drawPixmap ( LEDRect.topLeft(), BitmCubeRoundBlack );
+                    }
+                    else if ( iLEDIdx < YELLOW_BOUND_LED_BAR )
+                    {
+                        Painter.drawPixmap ( LEDRect.topLeft(), BitmCubeRoundGreen );
+                    }
+                    else if ( iLEDIdx < RED_BOUND_LED_BAR )
+                    {
+                        Painter.drawPixmap ( LEDRect.topLeft(), BitmCubeRoundYellow );
+                    }
+                    else
+                    {
+                        Painter.drawPixmap ( LEDRect.topLeft(), BitmCubeRoundRed );
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        const QRect BarRect = GetBarRect();
 
-        case RL_GREEN:
-            pLEDLabel->setPixmap ( BitmCubeRoundGreen );
-            break;
+        // background of the bar, the bar meter type has a border around the
+        // padding
+        if ( eLevelMeterType == MT_BAR )
+        {
+            Painter.setPen   ( palette().color ( QPalette::Mid ) );
+            Painter.setBrush ( palette().color ( QPalette::Base ) );
+            Painter.drawRect ( BarRect.adjusted ( -2, -2, 1, 1 ) );
+        }
+        else
+        {
+            Painter.fillRect ( BarRect, palette().color ( QPalette::Base ) );
+        }
 
-        case RL_YELLOW:
-            pLEDLabel->setPixmap ( BitmCubeRoundYellow );
-            break;
+        if ( this->isEnabled() && ( iBarLevel > 0 ) && !BitmBar.isNull() )
+        {
+            const QRect LevelRect = GetBarLevelRect ( iBarLevel );
 
-        case RL_RED:
-            pLEDLabel->setPixmap ( BitmCubeRoundRed );
-            break;
+            Painter.drawPixmap ( LevelRect.topLeft(),
+                                 BitmBar,
+                                 QRect ( 0, BitmBar.height() - iBarLevel, BitmBar.width(), iBarLevel ) );
         }
-        eCurLightColor = eNewColor;
     }
 }
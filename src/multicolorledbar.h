@@ -28,13 +28,23 @@
 #include <QPixmap>
 #include <QTimer>
 #include <QLayout>
-#include <QProgressBar>
-#include <QStackedLayout>
+#include <QPainter>
+#include <QPaintEvent>
 #include "util.h"
 #include "global.h"
 
 
+/* Definitions ****************************************************************/
+// width of the level bar for the bar and the slim bar meter types (the bar
+// meter type additionally has a margin, a border and a padding of one pixel)
+#define LED_BAR_WIDTH                    15 // pixels
+#define LED_SLIM_BAR_WIDTH               4  // pixels
+
+
 /* Classes ********************************************************************/
+// The complete meter is painted by this widget, the LED and bar pixmaps are
+// rendered once and on a level change only the LEDs or the part of the bar
+// which changed are repainted.
 class CMultiColorLEDBar : public QWidget
 {
     Q_OBJECT
@@ -48,43 +58,32 @@ public:
     };
 
     CMultiColorLEDBar ( QWidget* parent = nullptr, Qt::WindowFlags f = nullptr );
-    virtual ~CMultiColorLEDBar();
 
     void setValue ( const double dValue );
     void SetLevelMeterType ( const ELevelMeterType eNType );
 
-protected:
-    class cLED
-    {
-    public:
-        enum ELightColor
-        {
-            RL_DISABLED,
-            RL_BLACK,
-            RL_GREEN,
-            RL_YELLOW,
-            RL_RED
-        };
-
-        cLED ( QWidget* parent );
-        void    setColor ( const ELightColor eNewColor );
-        QLabel* getLabelPointer() { return pLEDLabel; }
+    virtual QSize sizeHint() const;
+    virtual QSize minimumSizeHint() const;
 
-    protected:
-        QPixmap     BitmCubeRoundBlack;
-        QPixmap     BitmCubeRoundGreen;
-        QPixmap     BitmCubeRoundYellow;
-        QPixmap     BitmCubeRoundRed;
-
-        ELightColor eCurLightColor;
-        QLabel*     pLEDLabel;
-    };
+protected:
+    int   GetMeterWidth() const;
+    QRect GetLEDRect ( const int iLEDIdx ) const;
+    QRect GetBarRect() const;
+    QRect GetBarLevelRect ( const int iLevel ) const;
+    void  UpdateBarPixmap();
 
-    void Reset ( const bool bEnabled );
     virtual void changeEvent ( QEvent* curEvent );
+    virtual void resizeEvent ( QResizeEvent* );
+    virtual void paintEvent ( QPaintEvent* pEvent );
 
-    QStackedLayout* pStackedLayout;
     ELevelMeterType eLevelMeterType;
-    CVector<cLED*>  vecpLEDs;
-    QProgressBar*   pProgressBar;
+    int             iNumActiveLEDs;
+    int             iBarLevel; // height of the level bar in pixels
+    double          dCurValue;
+
+    QPixmap         BitmCubeRoundBlack;
+    QPixmap         BitmCubeRoundGreen;
+    QPixmap         BitmCubeRoundYellow;
+    QPixmap         BitmCubeRoundRed;
+    QPixmap         BitmBar;
 };
@@ -0,0 +1,393 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "multitrack.h"
+
+
+/* Implementation *************************************************************/
+// index of the decoder of a slot for the given track descriptor
+static int GetDecoderIdx ( const int iSlot,
+                           const int iDescriptor )
+{
+    const bool bIsOpus64 = ( ( iDescriptor & 0x0F ) == CT_OPUS64 );
+    const bool bIsStereo = ( ( iDescriptor & 0x80 ) != 0 );
+
+    return 4 * iSlot + ( bIsOpus64 ? 2 : 0 ) + ( bIsStereo ? 1 : 0 );
+}
+
+
+// Multitrack frame (server) ---------------------------------------------------
+void CMultitrackFrame::Start()
+{
+    vecbyFrame[0] = MULTITRACK_FRAME_ID;
+    vecbyFrame[1] = 0;
+    iFrameLen     = MULTITRACK_HEADER_SIZE;
+}
+
+bool CMultitrackFrame::AddTrack ( const int           iChanID,
+                                  const EAudComprType eAudComprType,
+                                  const int           iNumAudioChannels,
+                                  const uint8_t*      pbyCodedData,
+                                  const int           iNumCodedBytes )
+{
+    const int iLen = ( pbyCodedData != nullptr ) ? iNumCodedBytes : 0;
+
+    if ( ( vecbyFrame[1] >= MULTITRACK_MAX_NUM_TRACKS + 1 ) ||
+         ( iFrameLen + GetTrackSize ( iLen ) > MULTITRACK_MAX_FRAME_SIZE ) )
+    {
+        return false;
+    }
+
+    vecbyFrame[iFrameLen]     = static_cast<uint8_t> ( iChanID );
+    vecbyFrame[iFrameLen + 1] = static_cast<uint8_t> ( ( eAudComprType & 0x0F ) | ( ( iNumAudioChannels == 2 ) ? 0x80 : 0 ) );
+    vecbyFrame[iFrameLen + 2] = static_cast<uint8_t> ( iLen & 0xFF );
+    vecbyFrame[iFrameLen + 3] = static_cast<uint8_t> ( iLen >> 8 );
+
+    if ( iLen > 0 )
+    {
+        std::copy ( pbyCodedData,
+                    pbyCodedData + iLen,
+                    vecbyFrame.begin() + iFrameLen + MULTITRACK_TRACK_HEADER_SIZE );
+    }
+
+    iFrameLen += GetTrackSize ( iLen );
+    vecbyFrame[1]++;
+
+    return true;
+}
+
+
+// Multitrack mixer (client) ---------------------------------------------------
+CMultitrackMixer::CMultitrackMixer() :
+    vecdGains          ( MAX_NUM_CHANNELS, 1.0 ),
+    vecdPannings       ( MAX_NUM_CHANNELS, 0.5 ),
+    veciMixGroup       ( MAX_NUM_CHANNELS, NO_MIX_GROUP ),
+    vecdMixGroupGains  ( MAX_NUM_MIX_GROUPS + 1, 1.0 ),
+    veciChanSlot       ( MAX_NUM_CHANNELS, INVALID_INDEX ),
+    veciSlotChanID     ( MULTITRACK_MAX_NUM_TRACKS, INVALID_INDEX ),
+    veciSlotLastFrame  ( MULTITRACK_MAX_NUM_TRACKS, 0 ),
+    veciSlotDescriptor ( MULTITRACK_MAX_NUM_TRACKS, 0 ),
+    vecfTrack          ( 2 * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES )
+{
+    Reset();
+}
+
+CMultitrackMixer::~CMultitrackMixer()
+{
+    for ( int i = 0; i < vecDecoders.Size(); i++ )
+    {
+        opus_custom_decoder_destroy ( vecDecoders[i] );
+    }
+}
+
+void CMultitrackMixer::Init ( OpusCustomMode* OpusMode,
+                              OpusCustomMode* Opus64Mode )
+{
+    int iOpusError;
+
+    if ( IsInitialized() )
+    {
+        return;
+    }
+
+    vecDecoders.Init ( 4 * MULTITRACK_MAX_NUM_TRACKS );
+
+    for ( int iSlot = 0; iSlot < MULTITRACK_MAX_NUM_TRACKS; iSlot++ )
+    {
+        vecDecoders[4 * iSlot]     = opus_custom_decoder_create ( OpusMode,   1, &iOpusError );
+        vecDecoders[4 * iSlot + 1] = opus_custom_decoder_create ( OpusMode,   2, &iOpusError );
+        vecDecoders[4 * iSlot + 2] = opus_custom_decoder_create ( Opus64Mode, 1, &iOpusError );
+        vecDecoders[4 * iSlot + 3] = opus_custom_decoder_create ( Opus64Mode, 2, &iOpusError );
+    }
+}
+
+void CMultitrackMixer::Reset()
+{
+    // the decoders are reset when a slot is assigned to a track
+    veciChanSlot.Reset ( INVALID_INDEX );
+    veciSlotChanID.Reset ( INVALID_INDEX );
+    veciSlotLastFrame.Reset ( 0 );
+    veciSlotDescriptor.Reset ( 0 );
+
+    iFrameCnt       = 0;
+    iLastRecvFrame  = 0;
+    bLastFrameValid = false;
+    bLastHadSubmix  = false;
+}
+
+bool CMultitrackMixer::Process ( const uint8_t*     pbyFrame,
+                                 const int          iNumBytes,
+                                 OpusCustomDecoder* SubmixDecoder,
+                                 float*             pfOut,
+                                 const int          iNumOutChannels,
+                                 const int          iFrameSizeSamples )
+{
+    if ( !IsInitialized() || ( iNumBytes < MULTITRACK_HEADER_SIZE ) || ( pbyFrame[0] != MULTITRACK_FRAME_ID ) )
+    {
+        return false;
+    }
+
+    // check the structure of the complete frame first so that a corrupt frame
+    // is concealed as a whole
+    const int iNumTracks = pbyFrame[1];
+    int       iPos       = MULTITRACK_HEADER_SIZE;
+
+    for ( int iT = 0; iT < iNumTracks; iT++ )
+    {
+        if ( iPos + MULTITRACK_TRACK_HEADER_SIZE > iNumBytes )
+        {
+            return false;
+        }
+
+        iPos += CMultitrackFrame::GetTrackSize ( pbyFrame[iPos + 2] | ( pbyFrame[iPos + 3] << 8 ) );
+
+        if ( iPos > iNumBytes )
+        {
+            return false;
+        }
+    }
+
+    iFrameCnt++;
+    bLastHadSubmix = false;
+
+    std::fill ( pfOut, pfOut + iNumOutChannels * iFrameSizeSamples, 0.0f );
+
+    iPos = MULTITRACK_HEADER_SIZE;
+
+    for ( int iT = 0; iT < iNumTracks; iT++ )
+    {
+        const int      iChanID        = pbyFrame[iPos];
+        const int      iDescriptor    = pbyFrame[iPos + 1];
+        const int      iNumCodedBytes = pbyFrame[iPos + 2] | ( pbyFrame[iPos + 3] << 8 );
+        const uint8_t* pbyCodedData   = ( iNumCodedBytes > 0 ) ? &pbyFrame[iPos + MULTITRACK_TRACK_HEADER_SIZE] : nullptr;
+        const int      iNumChannels   = ( ( iDescriptor & 0x80 ) != 0 ) ? 2 : 1;
+
+        iPos += CMultitrackFrame::GetTrackSize ( iNumCodedBytes );
+
+        // the codec frame size of a track must be our frame size
+        const EAudComprType eAudComprType = static_cast<EAudComprType> ( iDescriptor & 0x0F );
+
+        if ( ( ( eAudComprType != CT_OPUS ) && ( eAudComprType != CT_OPUS64 ) ) ||
+             ( GetCodecFrameSizeSamples ( eAudComprType ) != iFrameSizeSamples ) )
+        {
+            continue;
+        }
+
+        if ( iChanID == MULTITRACK_SUBMIX_CHAN_ID )
+        {
+            // the submix is already mixed with our gains by the server
+            if ( ( SubmixDecoder != nullptr ) && ( iNumChannels == iNumOutChannels ) )
+            {
+                opus_custom_decode_float ( SubmixDecoder,
+                                           pbyCodedData,
+                                           iNumCodedBytes,
+                                           &vecfTrack[0],
+                                           iFrameSizeSamples );
+
+                CMixKernel::MixAdd ( pfOut, &vecfTrack[0], 1.0f, iNumOutChannels * iFrameSizeSamples );
+
+                bLastHadSubmix = true;
+            }
+
+            continue;
+        }
+
+        const int iSlot = GetSlot ( iChanID );
+
+        if ( iSlot != INVALID_INDEX )
+        {
+            DecodeTrack ( iSlot, iDescriptor, pbyCodedData, iNumCodedBytes, iFrameSizeSamples );
+            MixTrack ( iChanID, iNumChannels, pfOut, iNumOutChannels, iFrameSizeSamples );
+
+            veciSlotLastFrame[iSlot] = iFrameCnt;
+        }
+    }
+
+    iLastRecvFrame  = iFrameCnt;
+    bLastFrameValid = true;
+
+    return true;
+}
+
+bool CMultitrackMixer::Conceal ( OpusCustomDecoder* SubmixDecoder,
+                                 float*             pfOut,
+                                 const int          iNumOutChannels,
+                                 const int          iFrameSizeSamples )
+{
+    if ( !bLastFrameValid || ( iFrameCnt - iLastRecvFrame >= MULTITRACK_MAX_CONCEAL_FRAMES ) )
+    {
+        return false;
+    }
+
+    iFrameCnt++;
+
+    std::fill ( pfOut, pfOut + iNumOutChannels * iFrameSizeSamples, 0.0f );
+
+    if ( bLastHadSubmix && ( SubmixDecoder != nullptr ) )
+    {
+        opus_custom_decode_float ( SubmixDecoder, nullptr, 0, &vecfTrack[0], iFrameSizeSamples );
+
+        CMixKernel::MixAdd ( pfOut, &vecfTrack[0], 1.0f, iNumOutChannels * iFrameSizeSamples );
+    }
+
+    // the tracks of the last received frame are concealed
+    for ( int iSlot = 0; iSlot < MULTITRACK_MAX_NUM_TRACKS; iSlot++ )
+    {
+        if ( ( veciSlotChanID[iSlot] != INVALID_INDEX ) && ( veciSlotLastFrame[iSlot] == iLastRecvFrame ) )
+        {
+            DecodeTrack ( iSlot, veciSlotDescriptor[iSlot], nullptr, 0, iFrameSizeSamples );
+
+            MixTrack ( veciSlotChanID[iSlot],
+                       ( ( veciSlotDescriptor[iSlot] & 0x80 ) != 0 ) ? 2 : 1,
+                       pfOut,
+                       iNumOutChannels,
+                       iFrameSizeSamples );
+        }
+    }
+
+    return true;
+}
+
+int CMultitrackMixer::GetSlot ( const int iChanID )
+{
+    if ( iChanID >= MAX_NUM_CHANNELS )
+    {
+        return INVALID_INDEX;
+    }
+
+    if ( veciChanSlot[iChanID] != INVALID_INDEX )
+    {
+        return veciChanSlot[iChanID];
+    }
+
+    // take a free slot or the slot which was not used for the longest time
+    // (a slot of the current frame is never taken)
+    int iNewSlot = INVALID_INDEX;
+
+    for ( int iSlot = 0; iSlot < MULTITRACK_MAX_NUM_TRACKS; iSlot++ )
+    {
+        if ( veciSlotChanID[iSlot] == INVALID_INDEX )
+        {
+            iNewSlot = iSlot;
+            break;
+        }
+
+        if ( ( veciSlotLastFrame[iSlot] != iFrameCnt ) &&
+             ( ( iNewSlot == INVALID_INDEX ) || ( veciSlotLastFrame[iSlot] < veciSlotLastFrame[iNewSlot] ) ) )
+        {
+            iNewSlot = iSlot;
+        }
+    }
+
+    if ( iNewSlot != INVALID_INDEX )
+    {
+        if ( veciSlotChanID[iNewSlot] != INVALID_INDEX )
+        {
+            veciChanSlot[veciSlotChanID[iNewSlot]] = INVALID_INDEX;
+        }
+
+        veciChanSlot[iChanID]        = iNewSlot;
+        veciSlotChanID[iNewSlot]     = iChanID;
+        veciSlotDescriptor[iNewSlot] = 0; // the decoder is reset on the first frame
+    }
+
+    return iNewSlot;
+}
+
+void CMultitrackMixer::DecodeTrack ( const int      iSlot,
+                                     const int      iDescriptor,
+                                     const uint8_t* pbyCodedData,
+                                     const int      iNumCodedBytes,
+                                     const int      iFrameSizeSamples )
+{
+    OpusCustomDecoder* CurDecoder = vecDecoders[GetDecoderIdx ( iSlot, iDescriptor )];
+
+    // the state of the decoder belongs to another track if the slot was
+    // reassigned or the codec of the track was changed
+    if ( veciSlotDescriptor[iSlot] != iDescriptor )
+    {
+        opus_custom_decoder_ctl ( CurDecoder, OPUS_RESET_STATE );
+        veciSlotDescriptor[iSlot] = iDescriptor;
+    }
+
+    opus_custom_decode_float ( CurDecoder,
+                               pbyCodedData,
+                               iNumCodedBytes,
+                               &vecfTrack[0],
+                               iFrameSizeSamples );
+}
+
+void CMultitrackMixer::MixTrack ( const int iChanID,
+                                  const int iNumTrackChannels,
+                                  float*    pfOut,
+                                  const int iNumOutChannels,
+                                  const int iFrameSizeSamples )
+{
+    // the gains and the pan law are the same as in the mix of the server
+    const double dGain = vecdGains[iChanID] * vecdMixGroupGains[veciMixGroup[iChanID]];
+
+    if ( dGain == 0.0 )
+    {
+        return;
+    }
+
+    if ( iNumOutChannels == 1 )
+    {
+        if ( iNumTrackChannels == 2 )
+        {
+            // mono down-mix of the stereo track
+            CMixKernel::MixDownStereo ( &vecfTrack[0],
+                                        &vecfTrack[0],
+                                        static_cast<float> ( dGain / 2 ),
+                                        static_cast<float> ( dGain / 2 ),
+                                        iFrameSizeSamples );
+
+            CMixKernel::MixAdd ( pfOut, &vecfTrack[0], 1.0f, iFrameSizeSamples );
+        }
+        else
+        {
+            CMixKernel::MixAdd ( pfOut, &vecfTrack[0], static_cast<float> ( dGain ), iFrameSizeSamples );
+        }
+    }
+    else
+    {
+        const double dPan   = vecdPannings[iChanID];
+        const float  fGainL = static_cast<float> ( MathUtils::GetLeftPan ( dPan, false ) * dGain );
+        const float  fGainR = static_cast<float> ( MathUtils::GetRightPan ( dPan, false ) * dGain );
+
+        if ( iNumTrackChannels == 2 )
+        {
+            CMixKernel::GainStereo ( &vecfTrack[0], fGainL, fGainR, iFrameSizeSamples );
+            CMixKernel::MixAdd ( pfOut, &vecfTrack[0], 1.0f, 2 * iFrameSizeSamples );
+        }
+        else
+        {
+            for ( int i = 0; i < iFrameSizeSamples; i++ )
+            {
+                pfOut[2 * i]     += fGainL * vecfTrack[i];
+                pfOut[2 * i + 1] += fGainR * vecfTrack[i];
+            }
+        }
+    }
+}
@@ -0,0 +1,176 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#ifdef USE_OPUS_SHARED_LIB
+# include "opus/opus_custom.h"
+#else
+# include "opus_custom.h"
+#endif
+#include "global.h"
+#include "util.h"
+#include "mixkernel.h"
+
+
+/* Definitions ****************************************************************/
+// A multitrack frame carries the coded frames of the clients of the server
+// (the tracks) instead of one mix, they are decoded and mixed by the client:
+// header:      [1 byte frame ID] [1 byte number of tracks]
+// each track:  [1 byte channel ID] [1 byte codec (bits 0-3) and stereo flag
+//              (bit 7)] [2 bytes length of the coded frame (little endian)]
+//              [coded frame]
+// A track with the length zero is a lost frame which is concealed by the
+// client. The submix track contains the mix of all clients which the server
+// could not forward, it is coded like an audio packet of the client.
+#define MULTITRACK_FRAME_ID              0x4D
+#define MULTITRACK_HEADER_SIZE           2
+#define MULTITRACK_TRACK_HEADER_SIZE     4
+#define MULTITRACK_SUBMIX_CHAN_ID        0xFF
+
+// the number of tracks and the size of a frame are limited, the clients which
+// do not fit are mixed in the submix (a few bytes are reserved for the padding
+// of the frame, see CChannel::PrepAndSendMultitrackFrame())
+#define MULTITRACK_MAX_NUM_TRACKS        16
+#define MULTITRACK_MAX_FRAME_SIZE        4096
+#define MULTITRACK_FRAME_SIZE_RESERVE    2
+
+// maximum number of consecutive lost frames which are concealed per track
+#define MULTITRACK_MAX_CONCEAL_FRAMES    10
+
+
+/* Classes ********************************************************************/
+// Server: assembles the multitrack frames of a client.
+class CMultitrackFrame
+{
+public:
+    CMultitrackFrame() : iFrameLen ( 0 ) {}
+
+    void Init() { vecbyFrame.Init ( MULTITRACK_MAX_FRAME_SIZE + MULTITRACK_FRAME_SIZE_RESERVE ); Start(); }
+
+    // the number of bytes a track needs in the frame
+    static int GetTrackSize ( const int iNumCodedBytes )
+        { return MULTITRACK_TRACK_HEADER_SIZE + iNumCodedBytes; }
+
+    void Start();
+
+    // returns false if the track does not fit in the frame (a null pointer
+    // or zero bytes mark a lost frame)
+    bool AddTrack ( const int           iChanID,
+                    const EAudComprType eAudComprType,
+                    const int           iNumAudioChannels,
+                    const uint8_t*      pbyCodedData,
+                    const int           iNumCodedBytes );
+
+    CVector<uint8_t>& GetData() { return vecbyFrame; }
+    int               GetSize() const { return iFrameLen; }
+
+protected:
+    CVector<uint8_t> vecbyFrame;
+    int              iFrameLen;
+};
+
+
+// Client: decodes the tracks of the multitrack frames and mixes them with the
+// gains and pannings of the faders of the mixer board. The decoders are kept
+// in a fixed number of slots which are assigned to the channel IDs of the
+// tracks (a slot is reused if its track was not received for a frame).
+class CMultitrackMixer
+{
+public:
+    CMultitrackMixer();
+    virtual ~CMultitrackMixer();
+
+    // creates the decoders (only done once, must not be called in the audio
+    // thread)
+    void Init ( OpusCustomMode* OpusMode,
+                OpusCustomMode* Opus64Mode );
+
+    bool IsInitialized() const { return vecDecoders.Size() > 0; }
+
+    void Reset();
+
+    // the gains and pannings of our mixer board (the audio thread reads them
+    // without a lock)
+    void SetGain ( const int iChanID, const double dGain ) { if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) ) vecdGains[iChanID] = dGain; }
+    void SetPan ( const int iChanID, const double dPan ) { if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) ) vecdPannings[iChanID] = dPan; }
+
+    // the mix groups of the channels and the mix group gains are applied as in
+    // the mix of the server
+    void SetMixGroup ( const int iChanID, const int iMixGroup ) { if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) ) veciMixGroup[iChanID] = iMixGroup; }
+    void SetMixGroupGain ( const int iMixGroup, const double dGain ) { if ( ( iMixGroup > NO_MIX_GROUP ) && ( iMixGroup <= MAX_NUM_MIX_GROUPS ) ) vecdMixGroupGains[iMixGroup] = dGain; }
+
+    // decodes and mixes a multitrack frame in the interleaved output buffer,
+    // the submix track is decoded with the decoder of the client, returns
+    // false if the frame is invalid
+    bool Process ( const uint8_t*     pbyFrame,
+                   const int          iNumBytes,
+                   OpusCustomDecoder* SubmixDecoder,
+                   float*             pfOut,
+                   const int          iNumOutChannels,
+                   const int          iFrameSizeSamples );
+
+    // conceals a lost frame by the packet loss concealment of the tracks of
+    // the last frame, returns false if the last frame was no multitrack frame
+    bool Conceal ( OpusCustomDecoder* SubmixDecoder,
+                   float*             pfOut,
+                   const int          iNumOutChannels,
+                   const int          iFrameSizeSamples );
+
+    // a plain audio packet ends the multitrack stream
+    void PutPlainFrame() { bLastFrameValid = false; }
+
+protected:
+    int  GetSlot ( const int iChanID );
+
+    void DecodeTrack ( const int      iSlot,
+                       const int      iDescriptor,
+                       const uint8_t* pbyCodedData,
+                       const int      iNumCodedBytes,
+                       const int      iFrameSizeSamples );
+
+    void MixTrack ( const int iChanID,
+                    const int iNumTrackChannels,
+                    float*    pfOut,
+                    const int iNumOutChannels,
+                    const int iFrameSizeSamples );
+
+    CVector<double>             vecdGains;
+    CVector<double>             vecdPannings;
+    CVector<int>                veciMixGroup;
+    CVector<double>             vecdMixGroupGains;
+
+    // decoders of the slots: mono/stereo for OPUS and OPUS64
+    CVector<OpusCustomDecoder*> vecDecoders;
+    CVector<int>                veciChanSlot;
+    CVector<int>                veciSlotChanID;
+    CVector<int>                veciSlotLastFrame;
+    CVector<int>                veciSlotDescriptor;
+
+    CVector<float>              vecfTrack;
+    int                         iFrameCnt;
+    int                         iLastRecvFrame;
+    bool                        bLastFrameValid;
+    bool                        bLastHadSubmix;
+};
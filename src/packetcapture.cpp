@@ -0,0 +1,234 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "packetcapture.h"
+#include <QtEndian>
+#include <cstring>
+
+
+/* Implementation *************************************************************/
+// CPacketCapture implementation -----------------------------------------------
+void CPacketCapture::Start ( const QString& strFileName )
+{
+    File.setFileName ( strFileName );
+
+    if ( !File.open ( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        throw CGenErr ( "Cannot create the packet capture file " + strFileName );
+    }
+
+    // file header
+    uint8_t vecbyHeader[PACKET_CAPTURE_HEADER_SIZE];
+
+    memcpy ( vecbyHeader, PACKET_CAPTURE_MAGIC, 6 );
+    qToLittleEndian<quint16> ( PACKET_CAPTURE_VERSION, &vecbyHeader[6] );
+
+    File.write ( reinterpret_cast<const char*> ( vecbyHeader ), PACKET_CAPTURE_HEADER_SIZE );
+
+    // preallocate the buffers so that the socket threads never allocate memory
+    vecbyPutBuf.reserve   ( PACKET_CAPTURE_BUFFER_SIZE );
+    vecbyWriteBuf.reserve ( PACKET_CAPTURE_BUFFER_SIZE );
+
+    ElapsedTimer.start();
+
+    QObject::connect ( &TimerFlush, &QTimer::timeout,
+        this, &CPacketCapture::OnTimerFlush );
+
+    TimerFlush.start ( PACKET_CAPTURE_FLUSH_INTERVAL_MS );
+}
+
+void CPacketCapture::Stop()
+{
+    if ( File.isOpen() )
+    {
+        TimerFlush.stop();
+        OnTimerFlush();
+        File.close();
+
+        if ( iNumDropped > 0 )
+        {
+            qWarning() << qUtf8Printable ( QString ( "Packet capture: %1 packets were not captured because the buffer was full" ).
+                arg ( iNumDropped ) );
+        }
+    }
+}
+
+void CPacketCapture::PutPacket ( const uint8_t*      pbyData,
+                                 const int           iNumBytes,
+                                 const CHostAddress& HostAddr )
+{
+    QMutexLocker locker ( &Mutex );
+
+    if ( vecbyPutBuf.Size() + PACKET_CAPTURE_RECORD_HEADER_SIZE + iNumBytes > PACKET_CAPTURE_BUFFER_SIZE )
+    {
+        iNumDropped++;
+        return;
+    }
+
+    // the time is taken in the lock so that the records are in time order
+    const qint64 iTimeUs  = ElapsedTimer.nsecsElapsed() / 1000;
+    const qint64 iDeltaUs = std::min ( iTimeUs - iLastTimeUs, static_cast<qint64> ( 0xFFFFFFFF ) );
+
+    iLastTimeUs = iTimeUs;
+
+    uint8_t vecbyRecHeader[PACKET_CAPTURE_RECORD_HEADER_SIZE];
+
+    qToLittleEndian<quint32> ( static_cast<quint32> ( iDeltaUs ), &vecbyRecHeader[0] );
+    qToLittleEndian<quint32> ( HostAddr.GetIPv4Addr(),          &vecbyRecHeader[4] );
+    qToLittleEndian<quint16> ( HostAddr.iPort,                  &vecbyRecHeader[8] );
+    qToLittleEndian<quint16> ( static_cast<quint16> ( iNumBytes ), &vecbyRecHeader[10] );
+
+    vecbyPutBuf.insert ( vecbyPutBuf.end(), vecbyRecHeader, vecbyRecHeader + PACKET_CAPTURE_RECORD_HEADER_SIZE );
+    vecbyPutBuf.insert ( vecbyPutBuf.end(), pbyData, pbyData + iNumBytes );
+}
+
+void CPacketCapture::OnTimerFlush()
+{
+    // exchange the buffers (no memory is allocated or freed by the swap) and
+    // write the captured packets outside the lock
+    {
+        QMutexLocker locker ( &Mutex );
+        vecbyPutBuf.swap ( vecbyWriteBuf );
+    }
+
+    if ( !vecbyWriteBuf.empty() )
+    {
+        File.write ( reinterpret_cast<const char*> ( &vecbyWriteBuf[0] ),
+                     vecbyWriteBuf.Size() );
+
+        vecbyWriteBuf.clear();
+    }
+}
+
+
+// CPacketReplay implementation ------------------------------------------------
+void CPacketReplay::Init ( const QString&   strFileName,
+                           const bool       bNFast,
+                           CHighPrioSocket* pNSocket )
+{
+    File.setFileName ( strFileName );
+
+    if ( !File.open ( QIODevice::ReadOnly ) )
+    {
+        throw CGenErr ( "Cannot open the packet capture file " + strFileName );
+    }
+
+    // check the file header
+    uint8_t vecbyHeader[PACKET_CAPTURE_HEADER_SIZE];
+
+    if ( ( File.read ( reinterpret_cast<char*> ( vecbyHeader ), PACKET_CAPTURE_HEADER_SIZE ) != PACKET_CAPTURE_HEADER_SIZE ) ||
+         ( memcmp ( vecbyHeader, PACKET_CAPTURE_MAGIC, 6 ) != 0 ) ||
+         ( qFromLittleEndian<quint16> ( &vecbyHeader[6] ) != PACKET_CAPTURE_VERSION ) )
+    {
+        File.close();
+        throw CGenErr ( "Invalid packet capture file " + strFileName );
+    }
+
+    vecbyData.Init ( MAX_SIZE_BYTES_NETW_BUF );
+
+    bFast   = bNFast;
+    pSocket = pNSocket;
+}
+
+void CPacketReplay::Stop()
+{
+    // give the thread some time to terminate
+    bRun = false;
+    wait ( 5000 );
+}
+
+bool CPacketReplay::ReadRecord ( qint64&       iDeltaUs,
+                                 CHostAddress& HostAddr,
+                                 int&          iNumBytes )
+{
+    uint8_t vecbyRecHeader[PACKET_CAPTURE_RECORD_HEADER_SIZE];
+
+    if ( File.read ( reinterpret_cast<char*> ( vecbyRecHeader ), PACKET_CAPTURE_RECORD_HEADER_SIZE ) !=
+         PACKET_CAPTURE_RECORD_HEADER_SIZE )
+    {
+        // end of the file
+        return false;
+    }
+
+    iDeltaUs  = qFromLittleEndian<quint32> ( &vecbyRecHeader[0] );
+    HostAddr  = CHostAddress ( qFromLittleEndian<quint32> ( &vecbyRecHeader[4] ),
+                               qFromLittleEndian<quint16> ( &vecbyRecHeader[8] ) );
+    iNumBytes = qFromLittleEndian<quint16> ( &vecbyRecHeader[10] );
+
+    // a truncated or corrupt record ends the replay
+    return ( iNumBytes <= vecbyData.Size() ) &&
+           ( File.read ( reinterpret_cast<char*> ( &vecbyData[0] ), iNumBytes ) == iNumBytes );
+}
+
+void CPacketReplay::run()
+{
+    QElapsedTimer ReplayTimer;
+    CHostAddress  HostAddr;
+    qint64        iDeltaUs;
+    int           iNumBytes;
+
+    bRun           = true;
+    iNumPackets    = 0;
+    iCaptureTimeUs = 0;
+
+    ReplayTimer.start();
+
+    while ( bRun && ReadRecord ( iDeltaUs, HostAddr, iNumBytes ) )
+    {
+        iCaptureTimeUs += iDeltaUs;
+
+        if ( !bFast )
+        {
+            // wait until the packet was received in the capture
+            const qint64 iWaitUs = iCaptureTimeUs - ReplayTimer.nsecsElapsed() / 1000;
+
+            if ( iWaitUs > 0 )
+            {
+                QThread::usleep ( static_cast<unsigned long> ( iWaitUs ) );
+            }
+        }
+
+        // this thread replaces the receive thread of the socket
+        pSocket->InjectPacket ( vecbyData, iNumBytes, HostAddr );
+        iNumPackets++;
+    }
+
+    iReplayTimeUs = ReplayTimer.nsecsElapsed() / 1000;
+
+    File.close();
+
+    emit Finished();
+}
+
+QString CPacketReplay::GetReport() const
+{
+    const double dReplayTimeS = iReplayTimeUs / 1e6;
+
+    return QString ( "Packet replay: %1 packets, capture time %2 s, replay time %3 s (%4 packets/s)" ).
+        arg ( iNumPackets ).
+        arg ( iCaptureTimeUs / 1e6, 0, 'f', 3 ).
+        arg ( dReplayTimeS, 0, 'f', 3 ).
+        arg ( dReplayTimeS > 0 ? iNumPackets / dReplayTimeS : 0, 0, 'f', 0 );
+}
@@ -0,0 +1,137 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QFile>
+#include <QMutex>
+#include <QElapsedTimer>
+#include "global.h"
+#include "util.h"
+#include "socket.h"
+
+
+/* Definitions ****************************************************************/
+// the capture file starts with the magic string and the format version, each
+// packet is stored as a record with the time since the previous packet in us,
+// the IPv4 address and port of the sender, the length and the packet data (all
+// numbers are stored in little endian byte order)
+#define PACKET_CAPTURE_MAGIC                "JAMCAP"
+#define PACKET_CAPTURE_VERSION              1
+#define PACKET_CAPTURE_HEADER_SIZE          8  // bytes
+#define PACKET_CAPTURE_RECORD_HEADER_SIZE   12 // bytes
+
+// interval in which the captured packets are written to the file
+#define PACKET_CAPTURE_FLUSH_INTERVAL_MS    200
+
+// size of the capture buffers (the socket threads never allocate memory, if
+// the buffer is full, further packets are not captured until the next flush)
+#define PACKET_CAPTURE_BUFFER_SIZE          ( 4 * 1024 * 1024 ) // bytes
+
+
+/* Classes ********************************************************************/
+// Writes all datagrams which are received by the server sockets in a capture
+// file. The socket threads only copy the packets in a preallocated buffer, the
+// file is written by a timer in the thread of this object.
+class CPacketCapture : public QObject
+{
+    Q_OBJECT
+
+public:
+    CPacketCapture() : iLastTimeUs ( 0 ), iNumDropped ( 0 ) {}
+    virtual ~CPacketCapture() { Stop(); }
+
+    // throws an error if the file cannot be created
+    void Start ( const QString& strFileName );
+    void Stop();
+
+    bool IsEnabled() const { return File.isOpen(); }
+
+    // may be called from multiple socket threads at the same time
+    void PutPacket ( const uint8_t*      pbyData,
+                     const int           iNumBytes,
+                     const CHostAddress& HostAddr );
+
+protected:
+    QFile            File;
+    QTimer           TimerFlush;
+    QMutex           Mutex;
+    QElapsedTimer    ElapsedTimer;
+    CVector<uint8_t> vecbyPutBuf;
+    CVector<uint8_t> vecbyWriteBuf;
+    qint64           iLastTimeUs;
+    int              iNumDropped;
+
+public slots:
+    void OnTimerFlush();
+};
+
+
+// Reads a capture file and feeds the packets in the receive path of the server
+// socket, either with the original timing or as fast as possible. During the
+// replay the server sockets do not receive and do not send any packets, i.e.
+// the server only processes the captured traffic.
+class CPacketReplay : public QThread
+{
+    Q_OBJECT
+
+public:
+    CPacketReplay() : pSocket ( nullptr ), bFast ( false ), bRun ( false ),
+                      iNumPackets ( 0 ), iCaptureTimeUs ( 0 ), iReplayTimeUs ( 0 ) {}
+    virtual ~CPacketReplay() { Stop(); }
+
+    // throws an error if the file is not a valid capture file
+    void Init ( const QString&   strFileName,
+                const bool       bNFast,
+                CHighPrioSocket* pNSocket );
+
+    void Stop();
+
+    bool IsEnabled() const { return pSocket != nullptr; }
+
+    QString GetReport() const;
+
+protected:
+    virtual void run();
+
+    bool ReadRecord ( qint64&       iDeltaUs,
+                      CHostAddress& HostAddr,
+                      int&          iNumBytes );
+
+    QFile            File;
+    CHighPrioSocket* pSocket;
+    bool             bFast;
+    bool             bRun;
+    CVector<uint8_t> vecbyData;
+    int              iNumPackets;
+    qint64           iCaptureTimeUs;
+    qint64           iReplayTimeUs;
+
+signals:
+    void Finished();
+};
@@ -0,0 +1,446 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "playout.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+
+/* Implementation *************************************************************/
+static double BesselI0 ( const double dX )
+{
+    // power series of the modified Bessel function of the first kind (used
+    // for the Kaiser window)
+    double dSum  = 1.0;
+    double dTerm = 1.0;
+
+    for ( int k = 1; ( k < 100 ) && ( dTerm > 1e-12 * dSum ); k++ )
+    {
+        const double dFact = dX / ( 2 * k );
+
+        dTerm *= dFact * dFact;
+        dSum  += dTerm;
+    }
+
+    return dSum;
+}
+
+void CPlayoutBuffer::Init ( const int iNewNumChannels,
+                            const int iNewFrameSize,
+                            const int iNewBlockSize )
+{
+    const double dPi = 3.14159265358979323846;
+
+    iNumChannels = iNewNumChannels;
+    iFrameSize   = iNewFrameSize;
+    iBlockSize   = iNewBlockSize;
+
+    // the resampled block may take some more samples and the interpolation
+    // filter needs half of its taps after the last sample
+    iLookahead = PLAYOUT_RESAMPLER_NUM_TAPS / 2 +
+                 static_cast<int> ( ceil ( iBlockSize * PLAYOUT_DRIFT_MAX ) ) + 1;
+
+    // the expansion searches two periods in the history, the pending part must
+    // hold one block plus two periods for the acceleration and the overshoot of
+    // the last frame or period
+    iHistorySize = 2 * PLAYOUT_MAX_PERIOD_SAMPLES;
+    iCapacity    = iHistorySize + iBlockSize + iLookahead + 3 * PLAYOUT_MAX_PERIOD_SAMPLES + 2 * iFrameSize;
+
+    vecfMemory.Init ( iCapacity * iNumChannels );
+
+    // Kaiser windowed sinc for the fractional delays 0 to 1 (the last phase
+    // is only used for the interpolation of the coefficients), each phase is
+    // normalized to unity gain at DC
+    vecfInterpTable.Init ( ( PLAYOUT_RESAMPLER_NUM_PHASES + 1 ) * PLAYOUT_RESAMPLER_NUM_TAPS );
+
+    for ( int iP = 0; iP <= PLAYOUT_RESAMPLER_NUM_PHASES; iP++ )
+    {
+        const double dFrac = static_cast<double> ( iP ) / PLAYOUT_RESAMPLER_NUM_PHASES;
+        CVector<double> vecdCoeff ( PLAYOUT_RESAMPLER_NUM_TAPS );
+        double          dSum = 0.0;
+
+        for ( int k = 0; k < PLAYOUT_RESAMPLER_NUM_TAPS; k++ )
+        {
+            // distance of the tap from the interpolated position
+            const double dX = k - ( PLAYOUT_RESAMPLER_NUM_TAPS / 2 - 1 ) - dFrac;
+            const double dW = dX / ( PLAYOUT_RESAMPLER_NUM_TAPS / 2 );
+
+            const double dSinc = ( fabs ( dX ) < 1e-9 ) ? 2 * PLAYOUT_RESAMPLER_CUTOFF :
+                                 sin ( 2 * dPi * PLAYOUT_RESAMPLER_CUTOFF * dX ) / ( dPi * dX );
+
+            vecdCoeff[k] = dSinc * BesselI0 ( PLAYOUT_RESAMPLER_KAISER_BETA * sqrt ( std::max ( 0.0, 1.0 - dW * dW ) ) );
+            dSum        += vecdCoeff[k];
+        }
+
+        for ( int k = 0; k < PLAYOUT_RESAMPLER_NUM_TAPS; k++ )
+        {
+            vecfInterpTable[iP * PLAYOUT_RESAMPLER_NUM_TAPS + k] = static_cast<float> ( vecdCoeff[k] / dSum );
+        }
+    }
+
+    iNumExpansions    = 0;
+    iNumAccelerations = 0;
+
+    Reset();
+}
+
+void CPlayoutBuffer::Reset()
+{
+    // the history starts with silence
+    vecfMemory.Reset ( 0 );
+    iPlayPos            = iHistorySize;
+    iEndPos             = iHistorySize;
+    iNumExpandedSamples = 0;
+    iMinBufferedSamples = INT_MAX;
+    iControlCnt         = 0;
+    iAccelMaxPeriod     = 0;
+
+    dDrift              = 0.0;
+    dReadFrac           = 0.0;
+    iNumInsertedSamples = 0;
+    iNumDriftIntervals  = 0;
+    dRegSum1            = 0.0;
+    dRegSumT            = 0.0;
+    dRegSumTT           = 0.0;
+    dRegSumY            = 0.0;
+    dRegSumTY           = 0.0;
+}
+
+int CPlayoutBuffer::GetNumRequired ( const int iNumBufferedSamples )
+{
+    // observe the minimum buffer level over the control interval
+    iMinBufferedSamples = std::min ( iMinBufferedSamples, iNumBufferedSamples );
+    iControlCnt        += iBlockSize;
+
+    if ( iControlCnt >= PLAYOUT_CONTROL_INTERVAL_SAMPLES )
+    {
+        UpdateDriftEstimate ( iMinBufferedSamples, iControlCnt );
+
+        // The slack is the part of the buffer level which was not needed during
+        // the whole interval. At most half of it is removed at once (the removal
+        // of one period needs two periods of decoded signal). With the drift
+        // compensation, the level slowly runs through one frame between two
+        // frames which are received in excess (or missing), this frame is kept
+        // so that the drift does not cause any underruns.
+        const int iReserve = ( iNumDriftIntervals >= PLAYOUT_DRIFT_MIN_NUM_INTERVALS ) ? iFrameSize : 0;
+        const int iSlack   = std::min ( iMinBufferedSamples, iNumBufferedSamples ) - iBlockSize - iLookahead - iReserve;
+
+        if ( iSlack >= 2 * PLAYOUT_MIN_PERIOD_SAMPLES )
+        {
+            iAccelMaxPeriod = std::min ( PLAYOUT_MAX_PERIOD_SAMPLES, iSlack / 2 );
+        }
+
+        iMinBufferedSamples = INT_MAX;
+        iControlCnt         = 0;
+    }
+
+    return iBlockSize + iLookahead + 2 * iAccelMaxPeriod;
+}
+
+void CPlayoutBuffer::UpdateDriftEstimate ( const int iLevel,
+                                           const int iIntervalSamples )
+{
+    // The level is corrected by the samples which were inserted or removed by
+    // the playout buffer itself (expansion, concealment, acceleration and the
+    // resampling), the remaining trend is the clock drift. The slope is
+    // estimated by a linear regression with exponential forgetting on the age
+    // of the observations, i.e. the sums are shifted by the interval length
+    // and the newest observation is at the time zero. Since the correction
+    // includes the resampling, the estimate does not depend on the
+    // compensation (no control loop).
+    const double dLambda = PLAYOUT_DRIFT_FORGETTING_FACTOR;
+    const double dDt     = iIntervalSamples;
+
+    dRegSumTT = dLambda * ( dRegSumTT - 2 * dDt * dRegSumT + dDt * dDt * dRegSum1 );
+    dRegSumTY = dLambda * ( dRegSumTY - dDt * dRegSumY );
+    dRegSumT  = dLambda * ( dRegSumT - dDt * dRegSum1 );
+    dRegSumY  = dLambda * dRegSumY + ( iLevel - iNumInsertedSamples );
+    dRegSum1  = dLambda * dRegSum1 + 1.0;
+
+    iNumDriftIntervals++;
+
+    const double dDet = dRegSum1 * dRegSumTT - dRegSumT * dRegSumT;
+
+    if ( ( iNumDriftIntervals >= PLAYOUT_DRIFT_MIN_NUM_INTERVALS ) && ( dDet > 0.0 ) )
+    {
+        const double dSlope = ( dRegSum1 * dRegSumTY - dRegSumT * dRegSumY ) / dDet;
+
+        dDrift = std::max ( -PLAYOUT_DRIFT_MAX, std::min ( PLAYOUT_DRIFT_MAX, dSlope ) );
+    }
+}
+
+void CPlayoutBuffer::PutFrame ( const float* pfFrame,
+                                const bool   bIsConcealment )
+{
+    if ( iEndPos + iFrameSize <= iCapacity )
+    {
+        std::copy ( pfFrame,
+                    pfFrame + iFrameSize * iNumChannels,
+                    vecfMemory.begin() + iEndPos * iNumChannels );
+
+        iEndPos += iFrameSize;
+
+        if ( bIsConcealment )
+        {
+            iNumInsertedSamples += iFrameSize;
+        }
+    }
+
+    iNumExpandedSamples = 0;
+}
+
+bool CPlayoutBuffer::Expand()
+{
+    // limit the number of consecutive repetitions
+    if ( iNumExpandedSamples >= PLAYOUT_MAX_EXPAND_SAMPLES )
+    {
+        return false;
+    }
+
+    // the last two periods of the decoded signal are compared, the repeated
+    // period ends with the last decoded sample so that the next frame continues
+    // seamlessly
+    double    dCorr;
+    const int iMaxPeriod = std::min ( std::min ( PLAYOUT_MAX_PERIOD_SAMPLES, iEndPos / 2 ),
+                                      iCapacity - iEndPos );
+
+    if ( iMaxPeriod < PLAYOUT_MIN_PERIOD_SAMPLES )
+    {
+        return false;
+    }
+
+    const int iPeriod = FindPeriod ( &vecfMemory[iEndPos * iNumChannels], true, iMaxPeriod, dCorr );
+
+    if ( dCorr < PLAYOUT_MIN_CORRELATION )
+    {
+        return false;
+    }
+
+    std::copy ( vecfMemory.begin() + ( iEndPos - iPeriod ) * iNumChannels,
+                vecfMemory.begin() + iEndPos * iNumChannels,
+                vecfMemory.begin() + iEndPos * iNumChannels );
+
+    iEndPos             += iPeriod;
+    iNumExpandedSamples += iPeriod;
+    iNumInsertedSamples += iPeriod;
+    iNumExpansions++;
+
+    return true;
+}
+
+void CPlayoutBuffer::Accelerate()
+{
+    // a period can only be removed if the block is still available afterwards
+    double    dCorr;
+    const int iMaxPeriod = std::min ( iAccelMaxPeriod, std::min ( GetNumPending() / 2,
+                                                                  GetNumPending() - iBlockSize - iLookahead ) );
+
+    iAccelMaxPeriod = 0;
+
+    if ( iMaxPeriod < PLAYOUT_MIN_PERIOD_SAMPLES )
+    {
+        return;
+    }
+
+    float*    pfPending = &vecfMemory[iPlayPos * iNumChannels];
+    const int iPeriod   = FindPeriod ( pfPending, false, iMaxPeriod, dCorr );
+
+    if ( dCorr < PLAYOUT_MIN_CORRELATION )
+    {
+        return;
+    }
+
+    // overlap-add of the first two periods with a linear cross-fade, the result
+    // starts with the first and ends with the second period
+    const int iLen = iPeriod * iNumChannels;
+
+    for ( int i = 0; i < iPeriod; i++ )
+    {
+        const float fWeight = ( static_cast<float> ( i ) + 0.5f ) / iPeriod;
+
+        for ( int c = 0; c < iNumChannels; c++ )
+        {
+            const int k = i * iNumChannels + c;
+
+            pfPending[k] = ( 1.0f - fWeight ) * pfPending[k] + fWeight * pfPending[k + iLen];
+        }
+    }
+
+    // remove the second period
+    std::copy ( vecfMemory.begin() + ( iPlayPos + 2 * iPeriod ) * iNumChannels,
+                vecfMemory.begin() + iEndPos * iNumChannels,
+                vecfMemory.begin() + ( iPlayPos + iPeriod ) * iNumChannels );
+
+    iEndPos             -= iPeriod;
+    iNumInsertedSamples -= iPeriod;
+    iNumAccelerations++;
+}
+
+void CPlayoutBuffer::Get ( float* pfOut )
+{
+    if ( iAccelMaxPeriod > 0 )
+    {
+        Accelerate();
+    }
+
+    // the block is resampled with the drift compensation ratio, the read
+    // position keeps its fractional part from block to block
+    const double dRatio   = 1.0 + dDrift;
+    const double dEndPos  = dReadFrac + iBlockSize * dRatio;
+    const int    iAdvance = static_cast<int> ( dEndPos );
+
+    if ( GetNumPending() >= iAdvance + PLAYOUT_RESAMPLER_NUM_TAPS / 2 + 1 )
+    {
+        for ( int i = 0; i < iBlockSize; i++ )
+        {
+            Interpolate ( dReadFrac + i * dRatio, &pfOut[i * iNumChannels] );
+        }
+
+        dReadFrac            = dEndPos - iAdvance;
+        iPlayPos            += iAdvance;
+        iNumInsertedSamples -= iAdvance - iBlockSize;
+    }
+    else
+    {
+        // if not enough samples are available (should not happen), the rest of
+        // the block is filled with silence
+        const int iNumAvail = std::min ( iBlockSize, GetNumPending() );
+
+        std::copy ( vecfMemory.begin() + iPlayPos * iNumChannels,
+                    vecfMemory.begin() + ( iPlayPos + iNumAvail ) * iNumChannels,
+                    pfOut );
+
+        std::fill ( pfOut + iNumAvail * iNumChannels, pfOut + iBlockSize * iNumChannels, 0.0f );
+
+        dReadFrac = 0.0;
+        iPlayPos += iNumAvail;
+    }
+
+    // only keep the history which is needed for the expansion
+    const int iShift = iPlayPos - iHistorySize;
+
+    if ( iShift > 0 )
+    {
+        std::copy ( vecfMemory.begin() + iShift * iNumChannels,
+                    vecfMemory.begin() + iEndPos * iNumChannels,
+                    vecfMemory.begin() );
+
+        iPlayPos -= iShift;
+        iEndPos  -= iShift;
+    }
+}
+
+void CPlayoutBuffer::Interpolate ( const double dPos,
+                                   float*       pfOut ) const
+{
+    // the filter taps start half a filter length before the position (the
+    // history always holds these samples)
+    const int    iPos    = static_cast<int> ( floor ( dPos ) );
+    const double dPhase  = ( dPos - iPos ) * PLAYOUT_RESAMPLER_NUM_PHASES;
+    const int    iPhase  = std::min ( static_cast<int> ( dPhase ), PLAYOUT_RESAMPLER_NUM_PHASES - 1 );
+    const float  fWeight = static_cast<float> ( dPhase - iPhase );
+
+    const float* pfCoeff0 = &vecfInterpTable[iPhase * PLAYOUT_RESAMPLER_NUM_TAPS];
+    const float* pfCoeff1 = pfCoeff0 + PLAYOUT_RESAMPLER_NUM_TAPS;
+    const float* pfIn     = &vecfMemory[( iPlayPos + iPos - PLAYOUT_RESAMPLER_NUM_TAPS / 2 + 1 ) * iNumChannels];
+
+    for ( int c = 0; c < iNumChannels; c++ )
+    {
+        float fSum0 = 0.0f;
+        float fSum1 = 0.0f;
+
+        for ( int k = 0; k < PLAYOUT_RESAMPLER_NUM_TAPS; k++ )
+        {
+            const float fIn = pfIn[k * iNumChannels + c];
+
+            fSum0 += pfCoeff0[k] * fIn;
+            fSum1 += pfCoeff1[k] * fIn;
+        }
+
+        pfOut[c] = fSum0 + fWeight * ( fSum1 - fSum0 );
+    }
+}
+
+int CPlayoutBuffer::FindPeriod ( const float* pfRef,
+                                 const bool   bBackwards,
+                                 const int    iMaxPeriod,
+                                 double&      dBestCorr ) const
+{
+    // Search the period with the best normalized correlation of two successive
+    // segments which either end at (backwards) or start at the reference
+    // position. The smallest period wins on equal correlation (e.g. silence).
+    int iBestPeriod = PLAYOUT_MIN_PERIOD_SAMPLES;
+    dBestCorr       = -1.0;
+
+    for ( int iPeriod = PLAYOUT_MIN_PERIOD_SAMPLES; iPeriod <= iMaxPeriod; iPeriod++ )
+    {
+        const int    iLen  = iPeriod * iNumChannels;
+        const float* pfA   = bBackwards ? pfRef - 2 * iLen : pfRef;
+        const double dCorr = Correlation ( pfA, pfA + iLen, iPeriod );
+
+        if ( dCorr > dBestCorr )
+        {
+            dBestCorr   = dCorr;
+            iBestPeriod = iPeriod;
+        }
+    }
+
+    return iBestPeriod;
+}
+
+double CPlayoutBuffer::Correlation ( const float* pfA,
+                                     const float* pfB,
+                                     const int    iLen ) const
+{
+    // the correlation is computed on every second sample of the channel sum
+    double dAB = 0.0;
+    double dAA = 0.0;
+    double dBB = 0.0;
+
+    for ( int i = 0; i < iLen; i += 2 )
+    {
+        float fA = 0.0f;
+        float fB = 0.0f;
+
+        for ( int c = 0; c < iNumChannels; c++ )
+        {
+            fA += pfA[i * iNumChannels + c];
+            fB += pfB[i * iNumChannels + c];
+        }
+
+        dAB += static_cast<double> ( fA ) * fB;
+        dAA += static_cast<double> ( fA ) * fA;
+        dBB += static_cast<double> ( fB ) * fB;
+    }
+
+    // silence can be modified without any artefacts
+    if ( ( dAA < 1e-12 ) && ( dBB < 1e-12 ) )
+    {
+        return 1.0;
+    }
+
+    return dAB / sqrt ( dAA * dBB + 1e-24 );
+}
@@ -0,0 +1,166 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include "global.h"
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// range of the periods which are inserted or removed by the time-scale
+// modification (0.8 ms to 5 ms at 48 kHz)
+#define PLAYOUT_MIN_PERIOD_SAMPLES       40
+#define PLAYOUT_MAX_PERIOD_SAMPLES       240
+
+// minimum normalized correlation of two successive periods, below this value a
+// time-scale modification would be audible
+#define PLAYOUT_MIN_CORRELATION          0.7
+
+// the slack of the buffer level (jitter buffer plus playout buffer) is
+// observed over this interval before it is reduced
+#define PLAYOUT_CONTROL_INTERVAL_SAMPLES ( SYSTEM_SAMPLE_RATE_HZ / 2 ) // 500 ms
+
+// maximum number of consecutive samples which are concealed by repeating
+// periods, after that the OPUS packet loss concealment takes over
+#define PLAYOUT_MAX_EXPAND_SAMPLES       ( 2 * PLAYOUT_MAX_PERIOD_SAMPLES )
+
+// clock drift compensation: forgetting factor of the regression per control
+// interval (time constant of 50 s), number of control intervals before the
+// estimate is applied and maximum compensated drift (500 ppm)
+#define PLAYOUT_DRIFT_FORGETTING_FACTOR  0.99
+#define PLAYOUT_DRIFT_MIN_NUM_INTERVALS  40
+#define PLAYOUT_DRIFT_MAX                0.0005
+
+// interpolation filter of the drift compensation (windowed sinc, the
+// coefficients between two phases are interpolated linearly)
+#define PLAYOUT_RESAMPLER_NUM_TAPS       16
+#define PLAYOUT_RESAMPLER_NUM_PHASES     256
+#define PLAYOUT_RESAMPLER_CUTOFF         0.45 // relative to the sample rate
+#define PLAYOUT_RESAMPLER_KAISER_BETA    6.0
+
+
+/* Classes ********************************************************************/
+// Jitter-aware playout buffer with time-scale modification (WSOLA-style) which
+// sits between the OPUS decoder and the sound card. On a jitter buffer
+// underrun the missing audio is concealed by repeating a period of the decoded
+// signal so that the late packet can still be played (the buffer grows by one
+// period). If the buffer level shows unused slack during the control interval,
+// one period is removed again by an overlap-add of two successive periods. The
+// latency is therefore adapted by single periods instead of whole frames and no
+// additional delay is introduced while no modification is pending.
+// The clock drift between the sender (the server timer) and the sound card is
+// estimated from the trend of the buffer level and compensated by resampling
+// the played signal with a sub-sample resolution, so that the drift neither
+// causes periodic underruns nor a growing delay.
+class CPlayoutBuffer
+{
+public:
+    CPlayoutBuffer() { Init ( 1, SYSTEM_FRAME_SIZE_SAMPLES, SYSTEM_FRAME_SIZE_SAMPLES ); }
+
+    void Init ( const int iNewNumChannels,
+                const int iNewFrameSize,
+                const int iNewBlockSize );
+
+    void Reset();
+
+    // number of decoded samples (per channel) which are not yet played
+    int GetNumPending() const { return iEndPos - iPlayPos; }
+
+    // Returns the number of pending samples which are required for the next
+    // block. The buffer level of the jitter buffer plus the playout buffer is
+    // used to decide if a period can be removed (then more samples are required).
+    int GetNumRequired ( const int iNumBufferedSamples );
+
+    // append a decoded frame (interleaved samples), a frame of the packet loss
+    // concealment is not counted as received signal by the drift estimation
+    void PutFrame ( const float* pfFrame,
+                    const bool   bIsConcealment = false );
+
+    // conceal a missing frame by repeating a period, returns false if this is
+    // not possible (the packet loss concealment of the decoder has to be used)
+    bool Expand();
+
+    // get the next block (interleaved samples)
+    void Get ( float* pfOut );
+
+    int GetNumExpansions() const { return iNumExpansions; }
+    int GetNumAccelerations() const { return iNumAccelerations; }
+
+    // estimated clock drift, positive if the sender is faster than the sound card
+    double GetDrift() const { return dDrift; }
+
+protected:
+    int    FindPeriod ( const float* pfRef,
+                        const bool   bBackwards,
+                        const int    iMaxPeriod,
+                        double&      dBestCorr ) const;
+
+    double Correlation ( const float* pfA,
+                         const float* pfB,
+                         const int    iLen ) const;
+
+    void   Accelerate();
+
+    void   UpdateDriftEstimate ( const int iLevel,
+                                 const int iIntervalSamples );
+
+    void   Interpolate ( const double dPos,
+                         float*       pfOut ) const;
+
+    CVector<float> vecfMemory;
+    int            iNumChannels;
+    int            iFrameSize;
+    int            iBlockSize;
+    int            iHistorySize;
+    int            iCapacity;
+
+    // positions in samples per channel: [history | pending), the history is
+    // the already played signal which is needed for the expansion
+    int            iPlayPos;
+    int            iEndPos;
+
+    int            iNumExpandedSamples;
+    int            iMinBufferedSamples;
+    int            iControlCnt;
+    int            iAccelMaxPeriod;
+
+    int            iNumExpansions;
+    int            iNumAccelerations;
+
+    // drift compensation: the lookahead is the number of pending samples which
+    // the interpolation needs in addition to the block
+    CVector<float> vecfInterpTable;
+    int            iLookahead;
+    double         dDrift;
+    double         dReadFrac;
+    int            iNumInsertedSamples;
+    int            iNumDriftIntervals;
+    double         dRegSum1;
+    double         dRegSumT;
+    double         dRegSumTT;
+    double         dRegSumY;
+    double         dRegSumTY;
+};
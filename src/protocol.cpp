@@ -29,6 +29,18 @@ Protocol message definition
 - All messages received need to be acknowledged by an acknowledge packet (except
   of connection less messages)
 
+- The first message of a session is PROTMESSID_PROT_VERSION. If both sides
+  support it, up to PROT_SEND_WINDOW_SIZE messages are sent without waiting for
+  the acknowledgement (otherwise only one message is in flight). The receiver
+  then only processes (and acknowledges) the message with the next counter
+  value, a message which is ahead is dropped and resent by the sender on
+  time-out.
+
+- If the other side has protocol version PROT_VERSION_MESS_CONTAINER, messages
+  which are sent at the same time (including acknowledgements) are bundled in
+  PROTMESSID_MESS_CONTAINER messages (PROTMESSID_MESS_CONTAINER_COMPACT with
+  protocol version PROT_VERSION_COMPACT_MESS).
+
 
 
 MAIN FRAME
@@ -121,6 +133,37 @@ MESSAGES (with connection)
         ... ------------------+---------------------------+
 
 
+- PROTMESSID_CONN_CLIENTS_LIST_DELTA: Changes of the connected clients list
+
+    +------------------------+--------------+-----------------+ ...
+    | 2 bytes list version v | 1 byte flags | 1 byte number l | ...
+    +------------------------+--------------+-----------------+ ...
+        ... ------------------------+----------------------------------+
+        ...  l bytes channel IDs of | entries of the joined or updated |
+        ...  the clients which left | clients (see CONN_CLIENTS_LIST)  |
+        ... ------------------------+----------------------------------+
+
+    - the list version is incremented (modulo 2^16) by the server with each
+      change of the list, the changes of this message lead from version v - 1
+      to version v
+    - flags: bit 0 is set if the message contains the complete list (the
+      receiver replaces its list, l is 0 in this case), bit 1 is set if the
+      message is a further part of the list version v (it only has joined or
+      updated clients, l is 0), bit 2 is set if more parts of the list version
+      v follow (the receiver may wait for them before it shows the list)
+
+    the server only sends this message if the client has protocol version
+    PROT_VERSION_CLIENT_LIST_DELTA, the first list of a connection is always a
+    complete list. A client which receives a version it does not expect sends
+    PROTMESSID_REQ_CONN_CLIENTS_LIST and the server answers with the complete
+    list.
+
+    to a client with protocol version PROT_VERSION_SPLIT_CLIENT_LIST, the
+    server splits a list with more than PROT_LIST_PART_MAX_BYTES bytes of
+    entries in parts (bits 1 and 2 of the flags) so that each part fits in one
+    datagram without IP fragmentation and is acknowledged on its own
+
+
 - PROTMESSID_REQ_CONN_CLIENTS_LIST: Request connected clients list
 
     note: does not have any data -> n = 0
@@ -227,6 +270,208 @@ MESSAGES (with connection)
     - tbc
 
 
+- PROTMESSID_REQ_CHANNEL_LEVEL_DELTA: Request the compact channel level list
+
+    +-----------------+
+    | 1 byte interval |
+    +-----------------+
+
+    interval 0 selects the PROTMESSID_CLM_CHANNEL_LEVEL_LIST message (default),
+    interval n > 0 selects the PROTMESSID_CLM_CHANNEL_LEVEL_DELTA message which
+    is sent at most every n-th level update (maximum value is
+    MAX_CHANNEL_LEVEL_DELTA_INTERVAL)
+
+    the levels are still only sent if PROTMESSID_REQ_CHANNEL_LEVEL_LIST was
+    used to opt in, servers which do not know this message simply ignore it
+
+
+- PROTMESSID_LISTENER_MODE: The client only listens
+
+    +--------------+
+    | 1 byte state |
+    +--------------+
+
+    state 1: the client is a listener, its audio is not decoded and not mixed
+    and the client only sends a silent keep-alive packet per second
+    state 0: the client is a musician (default on a new connection)
+
+    servers which do not know this message simply ignore it (the keep-alive
+    packets then result in a silent signal of the listener)
+
+
+- PROTMESSID_MIX_GROUP: Mix group of the client
+
+    +------------------+
+    | 1 byte mix group |
+    +------------------+
+
+    the mix group (e.g. the section of a choir) which the audio of the client
+    belongs to, 1 to MAX_NUM_MIX_GROUPS, 0: no mix group (default on a new
+    connection), the server sums each mix group once per frame
+
+
+- PROTMESSID_MIX_GROUP_GAIN: Gain of a mix group
+
+    +------------------+--------------+
+    | 1 byte mix group | 2 bytes gain |
+    +------------------+--------------+
+
+    the gain is applied on all channels of the mix group in the mix of the
+    client (in addition to the gains of the channels), the gain has the same
+    format as in PROTMESSID_CHANNEL_GAIN, all mix group gains are 1 on a new
+    connection
+
+
+- PROTMESSID_MIX_GROUP_LIST: Mix groups of the connected channels
+
+    for each channel in a mix group:
+    +-------------------+------------------+
+    | 1 byte channel ID | 1 byte mix group |
+    +-------------------+------------------+
+
+    the channels which are not listed are not in a mix group (i.e. an empty
+    message means that no channel is in a mix group), the list is sent on a
+    new connection if a channel is in a mix group and on each change
+
+
+- PROTMESSID_MULTICAST_GROUP: Multicast group of the shared stream
+
+    +---------------+----------------------------+
+    | 1 byte stream | 16 bytes IP address group  |
+    +---------------+----------------------------+
+
+    the server offers the client to receive its mix as multicast: the stream
+    (0 to MAX_NUM_MULTICAST_STREAMS - 1) is sent to the group (an IPv6 address,
+    IPv4 addresses are IPv4-mapped) and the local port of the client, the
+    stream NO_MULTICAST_STREAM (with any address) ends the offer, i.e. the
+    client leaves the group
+
+
+- PROTMESSID_MULTICAST_JOINED: The client has joined the multicast group
+
+    +---------------+
+    | 1 byte stream |
+    +---------------+
+
+    the client has joined the group of the offered stream, the server then
+    stops sending the stream to the client as unicast, NO_MULTICAST_STREAM:
+    the client could not join or has left the group (servers which do not know
+    PROTMESSID_MULTICAST_GROUP never offer a stream)
+
+
+- PROTMESSID_REQ_NET_STATS: Request the audio packet statistics
+
+    note: does not have any data -> n = 0
+
+    the receiver answers with PROTMESSID_NET_STATS (servers which do not know
+    this message simply ignore it, i.e. the client then only knows the
+    statistics of its own receive direction)
+
+
+- PROTMESSID_NET_STATS: Audio packet statistics of the receive direction
+
+    +--------------------------------+---------------------------+
+    | 4 bytes received audio packets | 4 bytes lost audio frames |
+    +--------------------------------+---------------------------+
+
+    the counters of the audio of the receiver of this message which the sender
+    has received since the connection was established (the receiver evaluates
+    the difference of two messages)
+
+
+- PROTMESSID_CHANNEL_GAIN_PAN_LIST: Gains and pans of several channels
+
+    for each changed channel:
+    +------------------------+---------------------+--------------------+
+    | 1 to 3 bytes ID, flags | (2 bytes gain)      | (2 bytes pan)      |
+    +------------------------+---------------------+--------------------+
+
+    - ID, flags: variable length integer (see PROTMESSID_MESS_CONTAINER_COMPACT)
+      of ( channel ID << 2 ) | ( pan present << 1 ) | gain present
+    - gain and pan: as in PROTMESSID_CHANNEL_GAIN and PROTMESSID_CHANNEL_PAN,
+      only present if the flag is set
+
+    only sent to a peer with protocol version PROT_VERSION_COMPACT_MESS, it
+    replaces the separate gain and pan messages of the faders which were moved
+    in the same update interval
+
+
+- PROTMESSID_PROT_VERSION: Protocol version
+
+    +----------------+---------------------+
+    | 1 byte version | 1 byte receive size |
+    +----------------+---------------------+
+
+    - version: PROT_VERSION_SEND_WINDOW (1) if the sender supports the sliding
+      window of unacknowledged messages
+    - receive size: maximum number of messages in flight the sender accepts
+
+    this message is always the first message of a session (the counter is reset
+    with the session) and is always processed, the receiver starts the in
+    order receive with the counter of this message
+
+    with version PROT_VERSION_SESSION_SETUP, the session setup may follow (a
+    client sends its network transport properties, jitter buffer size,
+    channel infos, version and the requests of the connection with it so that
+    no separate messages and requests are necessary):
+
+    +------------+------------------+----------------+-------+
+    | 2 bytes ID | 2 bytes length n | n bytes data   |  ...  |
+    +------------+------------------+----------------+-------+
+
+    each entry contains the data of a regular message (ID and data as in the
+    main frame) which is evaluated as if it was received separately, older
+    receivers ignore the appended data
+
+    a server waits PROT_SESSION_SETUP_WAIT_MS for the session setup of a new
+    client before it sends its first messages, if the client supports it,
+    these messages are sent together with the protocol version message of
+    the server in one container (so that the client has the complete session
+    after one round trip), otherwise the server requests the missing
+    properties
+
+
+- PROTMESSID_MESS_CONTAINER: Several messages in one datagram
+
+    +------------------------+------------------------+ ...
+    | complete message frame | complete message frame | ...
+    +------------------------+------------------------+ ...
+
+    each contained frame is a complete message (main frame including the CRC)
+    which is processed like a separately received message, containers are not
+    nested
+
+    the container itself uses cnt = 0 and is not acknowledged, it is only sent
+    to a receiver with protocol version PROT_VERSION_MESS_CONTAINER, the total
+    size is limited to PROT_MESS_CONTAINER_MAX_BYTES (unless a single message is
+    larger)
+
+
+- PROTMESSID_MESS_CONTAINER_COMPACT: Several messages with compact headers
+
+    for each contained message:
+    +-----------------------+---------------+-------------------------+ ...
+    | 1 to 3 bytes ID, flag | (1 byte cnt)  | 1 to 3 bytes length n   | ...
+    +-----------------------+---------------+-------------------------+ ...
+        ... --------------+
+        ...  n bytes data |
+        ... --------------+
+
+    - ID, flag: variable length integer of ( message ID << 1 ) | cnt present
+    - cnt: only present if the flag is set, otherwise the counter is the
+      counter of the previous message plus one (255 before the first message)
+    - length n: variable length integer
+    - data: as in the main frame, the data of PROTMESSID_ACKN is the
+      acknowledged message ID as variable length integer
+
+    variable length integers have 7 bits per byte starting with the least
+    significant bits, the highest bit is set if another byte follows
+
+    the messages are processed like the messages of PROTMESSID_MESS_CONTAINER,
+    they have no tag and no CRC since the container frame is checked, only
+    sent to a receiver with protocol version PROT_VERSION_COMPACT_MESS
+
+
 CONNECTION LESS MESSAGES
 ------------------------
 
@@ -385,9 +630,252 @@ CONNECTION LESS MESSAGES
     Note: the central server may send this message in response to a
           PROTMESSID_CLM_REGISTER_SERVER request.
           Where not received, the registering server may only retry up to
-          five times for one registration request at 500ms intervals.
+          five times for one registration request, the first time after
+          500ms and with a doubled interval for each further retry.
           Beyond this, it should "ping" every 15 minutes
           (standard re-registration timeout).
+
+
+- PROTMESSID_CLM_CHANNEL_LEVEL_DELTA: The changed channel levels
+
+    +-----------------+--------------+----------------+------------------------+------------------------+
+    | 1 byte sequence | 1 byte flags | 1 byte clients | ( n + 7 ) / 8 bytes    | ( m + 1 ) / 2 bytes    |
+    | number          |              | n              | changed mask           | 4 bit values           |
+    +-----------------+--------------+----------------+------------------------+------------------------+
+
+    the sequence number is incremented (modulo 256) with each message sent to a
+    client so that a lost message can be detected
+
+    flags: bit 0 is set if the message contains the full list, in this case the
+    changed mask is not present and the values of all n clients follow
+
+    the changed mask has bit ( i % 8 ) of byte ( i / 8 ) set if the level of
+    client i has changed, m is the number of set bits
+
+    the values are coded like in PROTMESSID_CLM_CHANNEL_LEVEL_LIST (earlier
+    channel in the lower half of the byte, an unused upper half contains 0xF)
+
+    a receiver which detects a lost message ignores the changes until the next
+    full list, the server sends the full list every
+    CHANNEL_LEVEL_DELTA_FULL_INTERVAL level updates and if n changes
+
+    the server only sends this message to a client which opted in with
+    PROTMESSID_REQ_CHANNEL_LEVEL_LIST and PROTMESSID_REQ_CHANNEL_LEVEL_DELTA
+
+
+- PROTMESSID_CLM_SEND_EMPTY_MES_LIST: Send "empty message" messages
+
+    for each address append following data:
+
+    +--------------------+--------------+
+    | 4 bytes IP address | 2 bytes port |
+    +--------------------+--------------+
+
+    the central server collects the clients which requested the server list for
+    a short time and sends this message instead of one
+    PROTMESSID_CLM_SEND_EMPTY_MESSAGE per client (at most
+    CLM_SEND_EMPTY_MES_LIST_MAX_NUM addresses per message), only to servers
+    which reported CLM_SERVER_FEATURE_SEND_EMPTY_MES_LIST
+
+
+- PROTMESSID_CLM_SERVER_FEATURES: Features supported by a registering server
+
+    +-----------------------+
+    | 4 bytes feature flags |
+    +-----------------------+
+
+    the server sends this message after each PROTMESSID_CLM_REGISTER_SERVER,
+    flags:
+    - CLM_SERVER_FEATURE_SEND_EMPTY_MES_LIST (bit 0): understands
+      PROTMESSID_CLM_SEND_EMPTY_MES_LIST
+
+
+- PROTMESSID_CLM_FEDERATION_UPDATE: Replicated server list entries
+
+    for each entry append following data:
+
+    +--------------+--------------------+--------------+ ...
+    | 1 byte flags | 4 bytes IP address | 2 bytes port | ...
+    +--------------+--------------------+--------------+ ...
+        ... -----------------------+-----------------------------+ ...
+        ...  4 bytes feature flags | 4 bytes internal IP address | ...
+        ... -----------------------+-----------------------------+ ...
+        ... -----------------------+-----------------+ ...
+        ...  2 bytes internal port | 2 bytes country | ...
+        ... -----------------------+-----------------+ ...
+        ... ---------------------------------+---------------------+ ...
+        ...  1 byte maximum connected clients | 1 byte is permanent | ...
+        ... ---------------------------------+---------------------+ ...
+        ... ------------------+----------------------------------+ ...
+        ...  2 bytes number n | n bytes UTF-8 string server name | ...
+        ... ------------------+----------------------------------+ ...
+        ... ------------------+---------------------------+
+        ...  2 bytes number n | n bytes UTF-8 string city |
+        ... ------------------+---------------------------+
+
+    - "flags": bit 0 is set if the server was unregistered (or has expired),
+      then only the address of the entry is relevant
+    - "IP address" and "port" are the address of the registered server
+    - "feature flags" are the flags of the PROTMESSID_CLM_SERVER_FEATURES
+      message of the server
+    - all other fields are as in the PROTMESSID_CLM_REGISTER_SERVER message
+
+    a central server sends this message to the other central servers of its
+    federation for every change of the servers which registered directly at it
+    (at most CLM_FEDERATION_UPDATE_MAX_NUM entries per message)
+
+
+- PROTMESSID_CLM_REQ_FEDERATION_SYNC: Request all server list entries
+
+    note: does not have any data -> n = 0
+
+    the receiving central server sends all servers which registered directly at
+    it with PROTMESSID_CLM_FEDERATION_UPDATE messages
+
+
+- PROTMESSID_CLM_REQ_SERVER_LIST_PAGE: Request one page of the filtered server
+                                       list
+
+    +-----------------+----------------------------------+ ...
+    | 2 bytes country | 1 byte minimum number of clients | ...
+    +-----------------+----------------------------------+ ...
+        ... -----------------------+--------------------+
+        ...  4 bytes feature flags | 2 bytes page index |
+        ... -----------------------+--------------------+
+
+    - "country" is the country of the servers, QLocale::AnyCountry (0) for all
+      countries
+    - "minimum number of clients" is the minimum of the maximum number of
+      clients of the servers
+    - "feature flags" are the CLM_SERVER_FEATURE_x flags which the servers must
+      have reported
+    - "page index" starts at 0
+
+
+- PROTMESSID_CLM_SERVER_LIST_PAGE: One page of the filtered server list
+
+    +--------------------+-------------------------+----------------------------+
+    | 2 bytes page index | 2 bytes number of pages | PROTMESSID_CLM_SERVER_LIST |
+    +--------------------+-------------------------+----------------------------+
+
+    - "PROTMESSID_CLM_SERVER_LIST" means that exactly the same message body
+      of the PROTMESSID_CLM_SERVER_LIST message is used, the first entry of the
+      first page is the central server itself
+    - a page has at most SERVLIST_PAGE_NUM_SERVERS servers (plus the central
+      server on the first page) and at most PROT_LIST_PART_MAX_BYTES bytes of
+      entries (but at least one server) so that it is not fragmented
+
+
+- PROTMESSID_CLM_RTT_PROBE: Round trip time measurement of the server
+
+    +-----------------------------+
+    | 4 bytes transmit time in ms |
+    +-----------------------------+
+
+    the server sends this message to its connected clients, a client answers
+    with PROTMESSID_CLM_RTT_PROBE_ECHO
+
+
+- PROTMESSID_CLM_RTT_PROBE_ECHO: Answer to PROTMESSID_CLM_RTT_PROBE
+
+    +-----------------------------+
+    | 4 bytes transmit time in ms |
+    +-----------------------------+
+
+    - "transmit time" is the unchanged value of the PROTMESSID_CLM_RTT_PROBE
+      message
+
+
+- PROTMESSID_CLM_REQ_SERVER_LIST_IPV6: Request the IPv6 entries of the filtered
+                                       server list
+
+    +-----------------+----------------------------------+ ...
+    | 2 bytes country | 1 byte minimum number of clients | ...
+    +-----------------+----------------------------------+ ...
+        ... -----------------------+
+        ...  4 bytes feature flags |
+        ... -----------------------+
+
+    - the filter is the same as in PROTMESSID_CLM_REQ_SERVER_LIST_PAGE
+
+    the servers which are registered with an IPv6 address are not part of the
+    PROTMESSID_CLM_SERVER_LIST and PROTMESSID_CLM_SERVER_LIST_PAGE messages
+    since their address cannot be coded there, a client with IPv6 support
+    requests them with this message after it has received the server list
+
+
+- PROTMESSID_CLM_SERVER_LIST_IPV6: The IPv6 entries of the filtered server list
+
+    for each server append following data:
+
+    +-----------------------+--------------------------------+
+    | 16 bytes IPv6 address | PROTMESSID_CLM_REGISTER_SERVER |
+    +-----------------------+--------------------------------+
+
+    - "IPv6 address" is in network byte order
+    - "PROTMESSID_CLM_REGISTER_SERVER" is the same as in the
+      PROTMESSID_CLM_SERVER_LIST message
+    - at most SERVLIST_PAGE_NUM_SERVERS servers and PROT_LIST_PART_MAX_BYTES
+      bytes of entries are sent
+
+
+- PROTMESSID_CLM_REQ_LATENCY_PROBE: Latency probe of a connected client
+
+    +-----------------------------+
+    | 4 bytes transmit time in ms |
+    +-----------------------------+
+
+    the server answers with PROTMESSID_CLM_LATENCY_PROBE if the client is
+    connected, the round trip time of the probe gives the network delay
+
+
+- PROTMESSID_CLM_LATENCY_PROBE: Server timing of the audio of the client
+
+    +-----------------------------+---------------------------+ ...
+    | 4 bytes transmit time in ms | 4 bytes queue delay in us | ...
+    +-----------------------------+---------------------------+ ...
+        ... -------------------------+
+        ...  4 bytes mix time in us  |
+        ... -------------------------+
+
+    - "transmit time" is the unchanged value of the
+      PROTMESSID_CLM_REQ_LATENCY_PROBE message
+    - "queue delay" is the measured average time an audio frame of the client
+      waits in the server before it is mixed (jitter buffer and the wait for
+      the next frame period)
+    - "mix time" is the measured average processing time of a frame
+
+
+- PROTMESSID_CLM_SERVER_LOAD: Load of a registered server of a server pool
+
+    +------------------------------------+------------------+ ...
+    | 1 byte number of connected clients | 1 byte load in % | ...
+    +------------------------------------+------------------+ ...
+        ... ------------------+--------------------------------+
+        ...  2 bytes number n | n bytes UTF-8 string pool name |
+        ... ------------------+--------------------------------+
+
+    - "load" is the measured average processing time of a frame relative to
+      the frame period
+
+    a server which is a member of a server pool sends this message after each
+    PROTMESSID_CLM_REGISTER_SERVER and every SERVLIST_POOL_LOAD_INTERVAL_S
+    seconds, the central server shows the pool as one entry in the server list
+    with the address of the pool member with the lowest load
+
+
+- PROTMESSID_CLM_REGISTER_SERVER_RETRY: Time until the next registration
+
+    +-------------------------+
+    | 2 bytes retry after [s] |
+    +-------------------------+
+
+    the central server sends this message after each
+    PROTMESSID_CLM_REGISTER_SERVER_RESP, the registering server renews its
+    registration (or retries if the server list is full) after this time
+    instead of its own registration interval, the hint is a separate message
+    since an older server discards a PROTMESSID_CLM_REGISTER_SERVER_RESP with
+    additional data (and ignores this message)
 */
 
 #include "protocol.h"
@@ -400,8 +888,13 @@ CProtocol::CProtocol()
 
 
     // Connections -------------------------------------------------------------
-    QObject::connect ( &TimerSendMess, &QTimer::timeout,
+    QObject::connect ( &TimerSendMess, &CWheelTimer::timeout,
         this, &CProtocol::OnTimerSendMess );
+
+    TimerSessionSetup.SetSingleShot ( true );
+
+    QObject::connect ( &TimerSessionSetup, &CWheelTimer::timeout,
+        this, &CProtocol::OnTimerSessionSetup );
 }
 
 void CProtocol::Reset()
@@ -409,420 +902,964 @@ void CProtocol::Reset()
     QMutexLocker locker ( &Mutex );
 
     // prepare internal variables for initial protocol transfer
-    iCounter   = 0;
-    iOldRecID  = PROTMESSID_ILLEGAL;
-    iOldRecCnt = 0;
+    iCounter        = 0;
+    iOldRecID       = PROTMESSID_ILLEGAL;
+    iOldRecCnt      = 0;
+    bCollectAckn    = false;
+    bInOrderReceive = false;
+    iNextRecCnt     = 0;
+
+    // until the other side told us its protocol version, only one message is
+    // in flight
+    bProtVersionSent = false;
+    bProtVersionAckn = false;
+    iPeerProtVersion = PROT_VERSION_SINGLE_MESS;
+    iPeerWindowSize  = 1;
 
     // delete complete "send message queue"
     SendMessQueue.clear();
+    iNumMessInFlight = 0;
+    bSendPending     = false;
+    iStartWindowSize = 0;
+
+    // a pending session setup belongs to the old session (the time-out timer
+    // is not stopped here since the reset may be called from another thread,
+    // its slot checks the flag)
+    bCollectSessionSetup = false;
+    bWaitForSessionSetup = false;
+    vecbySessionSetup.Init ( 0 );
 }
 
-void CProtocol::EnqueueMessage ( CVector<uint8_t>& vecMessage,
-                                 const int         iCnt,
-                                 const int         iID )
+void CProtocol::BeginSessionSetup()
 {
-    bool bListWasEmpty;
-
-    Mutex.lock();
-    {
-        // check if list is empty so that we have to initiate a send process
-        bListWasEmpty = SendMessQueue.empty();
-
-        // create send message object for the queue
-        CSendMessage SendMessageObj ( vecMessage, iCnt, iID );
-
-        // we want to have a FIFO: we add at the end and take from the beginning
-        SendMessQueue.push_back ( SendMessageObj );
-    }
-    Mutex.unlock();
+    QMutexLocker locker ( &Mutex );
 
-    // if list was empty, initiate send process
-    if ( bListWasEmpty )
+    // the session setup is part of the protocol version message which is the
+    // first message of a session
+    if ( !bProtVersionSent )
     {
-        SendMessage();
+        bCollectSessionSetup = true;
+        vecbySessionSetup.Init ( 0 );
     }
 }
 
-void CProtocol::SendMessage()
+void CProtocol::EndSessionSetup()
 {
-    CVector<uint8_t> vecMessage;
-    bool             bSendMess = false;
-
     Mutex.lock();
     {
-        // we have to check that list is not empty, since in another thread the
-        // last element of the list might have been erased
-        if ( !SendMessQueue.empty() )
+        if ( bCollectSessionSetup )
         {
-            vecMessage.Init ( SendMessQueue.front().vecMessage.Size() );
-            vecMessage = SendMessQueue.front().vecMessage;
+            bCollectSessionSetup = false;
 
-            bSendMess = true;
+            QueueProtVersionMes();
         }
     }
     Mutex.unlock();
 
-    if ( bSendMess )
-    {
-        // send message
-        emit MessReadyForSending ( vecMessage );
+    SendMessage ( false );
+}
 
-        // start time-out timer if not active
-        if ( !TimerSendMess.isActive() )
-        {
-            TimerSendMess.start ( SEND_MESS_TIMEOUT_MS );
-        }
-    }
-    else
+void CProtocol::WaitForSessionSetup ( const int iMaxWaitMs )
+{
+    Mutex.lock();
     {
-        // no message to send, stop timer
-        TimerSendMess.stop();
+        // only if the other side did not send its protocol version already
+        bWaitForSessionSetup = ( iPeerProtVersion == PROT_VERSION_SINGLE_MESS ) &&
+                               ( iNumMessInFlight == 0 );
     }
+    Mutex.unlock();
+
+    TimerSessionSetup.Start ( iMaxWaitMs );
 }
 
-void CProtocol::CreateAndSendMessage ( const int               iID,
-                                       const CVector<uint8_t>& vecData )
+void CProtocol::OnTimerSessionSetup()
 {
-    CVector<uint8_t> vecNewMessage;
-    int              iCurCounter;
+    bool bSessionSetupMissing = false;
 
     Mutex.lock();
     {
-        // store current counter value
-        iCurCounter = iCounter;
-
-        // increase counter (wraps around automatically)
-        iCounter++;
+        if ( bWaitForSessionSetup )
+        {
+            bWaitForSessionSetup = false;
+            bSessionSetupMissing = true;
+        }
     }
     Mutex.unlock();
 
-    // build complete message
-    GenMessageFrame ( vecNewMessage, iCurCounter, iID, vecData );
+    if ( bSessionSetupMissing )
+    {
+        // the other side does not support the session setup (or the message
+        // was lost), the session is set up by the separate messages
+        emit SessionSetupMissing();
 
-    // enqueue message
-    EnqueueMessage ( vecNewMessage, iCurCounter, iID );
+        SendMessage ( false );
+    }
 }
 
-void CProtocol::CreateAndImmSendAcknMess ( const int& iID,
-                                           const int& iCnt )
+int CProtocol::GetNumMessFittingContainer() const
 {
-    CVector<uint8_t> vecAcknMessage;
-    CVector<uint8_t> vecData ( 2 ); // 2 bytes of data
-    int              iPos = 0; // init position pointer
-
-    // build data vector
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iID ), 2 );
-
-    // build complete message
-    GenMessageFrame ( vecAcknMessage, iCnt, PROTMESSID_ACKN, vecData );
+    // note that the mutex must be locked by the caller
+    const int iMaxNum = std::min ( iPeerWindowSize, PROT_SEND_WINDOW_SIZE );
+    int       iSize   = MESS_LEN_WITHOUT_DATA_BYTE;
+    int       iNum    = 0;
 
-    // immediately send acknowledge message
-    emit MessReadyForSending ( vecAcknMessage );
-}
+    for ( std::list<CSendMessage>::const_iterator it = SendMessQueue.begin();
+          ( it != SendMessQueue.end() ) && ( iNum < iMaxNum ); ++it )
+    {
+        iSize += it->Message.Size();
 
-void CProtocol::CreateAndImmSendConLessMessage ( const int               iID,
-                                                 const CVector<uint8_t>& vecData,
-                                                 const CHostAddress&     InetAddr )
-{
-    CVector<uint8_t> vecNewMessage;
+        // at least one message is sent
+        if ( ( iNum > 0 ) && ( iSize > PROT_MESS_CONTAINER_MAX_BYTES ) )
+        {
+            break;
+        }
 
-    // build complete message (counter per definition=0 for connection less
-    // messages)
-    GenMessageFrame ( vecNewMessage, 0, iID, vecData );
+        iNum++;
+    }
 
-    // immediately send message
-    emit CLMessReadyForSending ( InetAddr, vecNewMessage );
+    return std::max ( 1, iNum );
 }
 
-bool CProtocol::ParseMessageBody ( const CVector<uint8_t>& vecbyMesBodyData,
-                                   const int               iRecCounter,
-                                   const int               iRecID )
+void CProtocol::SendMessage ( const bool bResendInFlight )
 {
-/*
-    return code: false -> ok; true -> error
-*/
-    bool bRet = false;
-    bool bSendNextMess;
+    std::list<CProtMessage> vecMessages;
+    bool                    bQueueEmpty;
+    bool                    bUseContainer;
+    bool                    bUseCompact;
 
-/*
-// TEST channel implementation: randomly delete protocol messages (50 % loss)
-if ( rand() < ( RAND_MAX / 2 ) ) return false;
-*/
-
-    // In case we received a message and returned an answer but our answer
-    // did not make it to the receiver, he will resend his message. We check
-    // here if the message is the same as the old one, and if this is the
-    // case, just resend our old answer again
-    if ( ( iOldRecID == iRecID ) && ( iOldRecCnt == iRecCounter ) )
+    Mutex.lock();
     {
-        // acknowledgments are not acknowledged
-        if ( iRecID != PROTMESSID_ACKN )
+        // the first messages of a new connection are held back until the
+        // session setup of the other side was received
+        if ( bWaitForSessionSetup )
         {
-            // resend acknowledgement
-            CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+            Mutex.unlock();
+            return;
         }
-    }
-    else
-    {
-        // special treatment for acknowledge messages
-        if ( iRecID == PROTMESSID_ACKN )
-        {
-            // check size
-            if ( vecbyMesBodyData.Size() != 2 )
-            {
-                return true; // return error code
-            }
 
-            // extract data from stream and emit signal for received value
-            int       iPos = 0;
-            const int iData =
-                static_cast<int> ( GetValFromStream ( vecbyMesBodyData, iPos, 2 ) );
+        // the send window is only opened if the other side supports it and
+        // our protocol version message was acknowledged (so that the other
+        // side is in in-order receive mode)
+        int iWindowSize = 1;
 
-            Mutex.lock();
-            {
-                // check if this is the correct acknowledgment
-                bSendNextMess = false;
-                if ( !SendMessQueue.empty() )
-                {
-                    if ( ( SendMessQueue.front().iCnt == iRecCounter ) &&
-                         ( SendMessQueue.front().iID == iData ) )
-                    {
-                        // message acknowledged, remove from queue
-                        SendMessQueue.pop_front();
+        if ( bProtVersionAckn && ( iPeerProtVersion >= PROT_VERSION_SEND_WINDOW ) )
+        {
+            iWindowSize = std::min ( iPeerWindowSize, PROT_SEND_WINDOW_SIZE );
+        }
+        else if ( iStartWindowSize > 0 )
+        {
+            iWindowSize = iStartWindowSize;
+        }
+        else if ( ( iNumMessInFlight == 0 ) && !SendMessQueue.empty() &&
+                  ( iPeerProtVersion >= PROT_VERSION_SESSION_SETUP ) )
+        {
+            // nothing of the session was sent yet and the other side processes
+            // the messages of a container in order: all messages which fit in
+            // one container are sent together with our protocol version
+            // message (it must be only one datagram since the other side
+            // starts the in-order receive with the protocol version message)
+            iStartWindowSize = GetNumMessFittingContainer();
+            iWindowSize      = iStartWindowSize;
+        }
 
-                        // send next message in queue
-                        bSendNextMess = true;
-                    }
+        // we have to check that list is not empty, since in another thread the
+        // last element of the list might have been erased
+        std::list<CSendMessage>::const_iterator it = SendMessQueue.begin();
+
+        for ( int i = 0; ( it != SendMessQueue.end() ) && ( i < iWindowSize ); i++, ++it )
+        {
+            if ( i < iNumMessInFlight )
+            {
+                // resend the messages in flight on time-out
+                if ( bResendInFlight )
+                {
+                    vecMessages.push_back ( it->Message );
                 }
             }
-            Mutex.unlock();
-
-            if ( bSendNextMess )
+            else
             {
-                SendMessage();
+                // free slot in the send window
+                vecMessages.push_back ( it->Message );
+                iNumMessInFlight++;
             }
         }
-        else
+
+        bQueueEmpty   = SendMessQueue.empty();
+        bUseContainer = ( iPeerProtVersion >= PROT_VERSION_MESS_CONTAINER );
+        bUseCompact   = ( iPeerProtVersion >= PROT_VERSION_COMPACT_MESS );
+    }
+    Mutex.unlock();
+
+    // send messages
+    EmitMessages ( vecMessages, bUseContainer, bUseCompact );
+
+    if ( !bQueueEmpty )
+    {
+        // start time-out timer if not active
+        if ( !TimerSendMess.IsActive() )
+        {
+            TimerSendMess.Start ( SEND_MESS_TIMEOUT_MS );
+        }
+    }
+    else
+    {
+        // no message to send, stop timer
+        TimerSendMess.Stop();
+    }
+}
+
+void CProtocol::EmitMessages ( const std::list<CProtMessage>& vecMessages,
+                               const bool                     bUseContainer,
+                               const bool                     bUseCompact )
+{
+    std::list<CProtMessage>::const_iterator it = vecMessages.begin();
+
+    if ( !bUseContainer || ( vecMessages.size() < 2 ) )
+    {
+        for ( ; it != vecMessages.end(); ++it )
+        {
+            emit MessReadyForSending ( *it );
+        }
+
+        return;
+    }
+
+    // bundle the messages in containers of limited size
+    while ( it != vecMessages.end() )
+    {
+        CVector<uint8_t> vecContainerData;
+        int              iNumInContainer = 0;
+        int              iPrevCnt        = 0xFF;
+        std::list<CProtMessage>::const_iterator itFirst = it;
+
+        while ( it != vecMessages.end() )
         {
-            // check which type of message we received and do action
-            switch ( iRecID )
+            const int iOldSize    = vecContainerData.Size();
+            const int iOldPrevCnt = iPrevCnt;
+
+            if ( bUseCompact )
             {
-            case PROTMESSID_JITT_BUF_SIZE:
-                bRet = EvaluateJitBufMes ( vecbyMesBodyData );
-                break;
+                PutCompactMessage ( vecContainerData, it->Data(), iPrevCnt );
+            }
+            else
+            {
+                vecContainerData.insert ( vecContainerData.end(), it->Data().begin(), it->Data().end() );
+            }
 
-            case PROTMESSID_REQ_JITT_BUF_SIZE:
-                bRet = EvaluateReqJitBufMes();
+            if ( ( iNumInContainer > 0 ) &&
+                 ( MESS_LEN_WITHOUT_DATA_BYTE + vecContainerData.Size() > PROT_MESS_CONTAINER_MAX_BYTES ) )
+            {
+                // the message goes to the next container
+                vecContainerData.resize ( iOldSize );
+                iPrevCnt = iOldPrevCnt;
                 break;
+            }
 
-            case PROTMESSID_CLIENT_ID:
-                bRet = EvaluateClientIDMes ( vecbyMesBodyData );
-                break;
+            iNumInContainer++;
+            ++it;
+        }
 
-            case PROTMESSID_CHANNEL_GAIN:
-                bRet = EvaluateChanGainMes ( vecbyMesBodyData );
-                break;
+        if ( iNumInContainer == 1 )
+        {
+            // no need for a container
+            emit MessReadyForSending ( *itFirst );
+        }
+        else
+        {
+            CVector<uint8_t> vecContainerMessage;
 
-            case PROTMESSID_CHANNEL_PAN:
-                bRet = EvaluateChanPanMes ( vecbyMesBodyData );
-                break;
+            GenMessageFrame ( vecContainerMessage,
+                              0,
+                              bUseCompact ? PROTMESSID_MESS_CONTAINER_COMPACT : PROTMESSID_MESS_CONTAINER,
+                              vecContainerData );
 
-            case PROTMESSID_MUTE_STATE_CHANGED:
-                bRet = EvaluateMuteStateHasChangedMes ( vecbyMesBodyData );
-                break;
+            emit MessReadyForSending ( CProtMessage::Adopt ( vecContainerMessage ) );
+        }
+    }
+}
 
-            case PROTMESSID_CONN_CLIENTS_LIST:
-                bRet = EvaluateConClientListMes ( vecbyMesBodyData );
-                break;
+void CProtocol::CreateAndSendMessage ( const int               iID,
+                                       const CVector<uint8_t>& vecData )
+{
+    CVector<uint8_t> vecNewMessage;
+    bool             bDeferSend;
+    bool             bTriggerSend = false;
 
-            case PROTMESSID_REQ_CONN_CLIENTS_LIST:
-                bRet = EvaluateReqConnClientsList();
-                break;
+    Mutex.lock();
+    {
+        // the messages of the session setup are collected and appended to
+        // the protocol version message by EndSessionSetup()
+        if ( bCollectSessionSetup )
+        {
+            int iPos = vecbySessionSetup.Size();
 
-            case PROTMESSID_CHANNEL_INFOS:
-                bRet = EvaluateChanInfoMes ( vecbyMesBodyData );
-                break;
+            vecbySessionSetup.resize ( iPos + 4 + vecData.Size() );
 
-            case PROTMESSID_REQ_CHANNEL_INFOS:
-                bRet = EvaluateReqChanInfoMes();
-                break;
+            // message ID (2 bytes)
+            PutValOnStream ( vecbySessionSetup, iPos, static_cast<uint32_t> ( iID ), 2 );
 
-            case PROTMESSID_CHAT_TEXT:
-                bRet = EvaluateChatTextMes ( vecbyMesBodyData );
-                break;
+            // data length (2 bytes)
+            PutValOnStream ( vecbySessionSetup, iPos, static_cast<uint32_t> ( vecData.Size() ), 2 );
 
-            case PROTMESSID_NETW_TRANSPORT_PROPS:
-                bRet = EvaluateNetwTranspPropsMes ( vecbyMesBodyData );
-                break;
+            std::copy ( vecData.begin(), vecData.end(), vecbySessionSetup.begin() + iPos );
 
-            case PROTMESSID_REQ_NETW_TRANSPORT_PROPS:
-                bRet = EvaluateReqNetwTranspPropsMes();
-                break;
+            Mutex.unlock();
+            return;
+        }
 
-            case PROTMESSID_LICENCE_REQUIRED:
-                bRet = EvaluateLicenceRequiredMes ( vecbyMesBodyData );
-                break;
+        // the first message of a session tells the other side our protocol
+        // version, the counter value of this message is the start of the in
+        // order message sequence
+        if ( !bProtVersionSent )
+        {
+            QueueProtVersionMes();
+        }
 
-            case PROTMESSID_REQ_CHANNEL_LEVEL_LIST:
-                bRet = EvaluateReqChannelLevelListMes ( vecbyMesBodyData );
-                break;
+        // build complete message
+        GenMessageFrame ( vecNewMessage, iCounter, iID, vecData );
 
-            case PROTMESSID_VERSION_AND_OS:
-                bRet = EvaluateVersionAndOSMes ( vecbyMesBodyData );
-                break;
+        // we want to have a FIFO: we add at the end and take from the beginning
+        SendMessQueue.push_back ( CSendMessage ( CProtMessage::Adopt ( vecNewMessage ), iCounter, iID ) );
 
-            case PROTMESSID_RECORDER_STATE:
-                bRet = EvaluateRecorderStateMes ( vecbyMesBodyData );
-                break;
-            }
+        // increase counter (wraps around automatically)
+        iCounter++;
 
-            // immediately send acknowledge message
-            CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+        // if the other side supports containers, the messages which are
+        // created in the same event loop pass (e.g. the lists and gains on a new
+        // connection) are sent together
+        bDeferSend = ( iPeerProtVersion >= PROT_VERSION_MESS_CONTAINER );
 
-            // save current message ID and counter to find out if message
-            // was resent
-            iOldRecID  = iRecID;
-            iOldRecCnt = iRecCounter;
+        if ( bDeferSend && !bSendPending )
+        {
+            bSendPending = true;
+            bTriggerSend = true;
         }
     }
+    Mutex.unlock();
 
-    return bRet;
+    if ( !bDeferSend )
+    {
+        // send the message if the send window is not full
+        SendMessage ( false );
+    }
+    else if ( bTriggerSend )
+    {
+        QMetaObject::invokeMethod ( this, "OnSendPendingMessages", Qt::QueuedConnection );
+    }
 }
 
-bool CProtocol::ParseConnectionLessMessageBody ( const CVector<uint8_t>& vecbyMesBodyData,
-                                                 const int               iRecID,
+void CProtocol::QueueProtVersionMes()
+{
+    // note that the mutex must be locked by the caller
+    CVector<uint8_t> vecVersionData ( 2 + vecbySessionSetup.Size() );
+    CVector<uint8_t> vecVersionMessage;
+    int              iPos = 0; // init position pointer
+
+    // protocol version (1 byte)
+    PutValOnStream ( vecVersionData, iPos, static_cast<uint32_t> ( PROT_VERSION ), 1 );
+
+    // receive window size (1 byte)
+    PutValOnStream ( vecVersionData, iPos, static_cast<uint32_t> ( PROT_SEND_WINDOW_SIZE ), 1 );
+
+    // session setup (if any)
+    std::copy ( vecbySessionSetup.begin(), vecbySessionSetup.end(), vecVersionData.begin() + iPos );
+    vecbySessionSetup.Init ( 0 );
+
+    GenMessageFrame ( vecVersionMessage, iCounter, PROTMESSID_PROT_VERSION, vecVersionData );
+    SendMessQueue.push_back ( CSendMessage ( CProtMessage::Adopt ( vecVersionMessage ), iCounter, PROTMESSID_PROT_VERSION ) );
+
+    iCounter++;
+    bProtVersionSent = true;
+}
+
+void CProtocol::CreateAndImmSendAcknMess ( const int& iID,
+                                           const int& iCnt )
+{
+    CVector<uint8_t> vecAcknMessage;
+    CVector<uint8_t> vecData ( 2 ); // 2 bytes of data
+    int              iPos = 0; // init position pointer
+
+    // build data vector
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iID ), 2 );
+
+    // build complete message
+    GenMessageFrame ( vecAcknMessage, iCnt, PROTMESSID_ACKN, vecData );
+
+    if ( bCollectAckn )
+    {
+        // the acknowledgements of a container are sent at once after the
+        // container was processed
+        vecAcknMessages.push_back ( CProtMessage::Adopt ( vecAcknMessage ) );
+        return;
+    }
+
+    // immediately send acknowledge message
+    emit MessReadyForSending ( CProtMessage::Adopt ( vecAcknMessage ) );
+}
+
+void CProtocol::CreateAndImmSendConLessMessage ( const int               iID,
+                                                 const CVector<uint8_t>& vecData,
                                                  const CHostAddress&     InetAddr )
+{
+    CVector<uint8_t> vecNewMessage;
+
+    // build complete message (counter per definition=0 for connection less
+    // messages)
+    GenMessageFrame ( vecNewMessage, 0, iID, vecData );
+
+    // immediately send message
+    emit CLMessReadyForSending ( InetAddr, CProtMessage::Adopt ( vecNewMessage ) );
+}
+
+bool CProtocol::ParseMessageBody ( const CVector<uint8_t>& vecbyMesBodyData,
+                                   const int               iRecCounter,
+                                   const int               iRecID )
 {
 /*
     return code: false -> ok; true -> error
 */
     bool bRet = false;
+    bool bSendNextMess;
 
 /*
 // TEST channel implementation: randomly delete protocol messages (50 % loss)
 if ( rand() < ( RAND_MAX / 2 ) ) return false;
 */
 
-    if ( IsConnectionLessMessageID ( iRecID ) )
+    // the messages of a container are processed one after the other (the
+    // container itself is not acknowledged)
+    if ( iRecID == PROTMESSID_MESS_CONTAINER )
     {
-        // check which type of message we received and do action
-        switch ( iRecID )
+        return ParseContainerMes ( vecbyMesBodyData, false );
+    }
+
+    if ( iRecID == PROTMESSID_MESS_CONTAINER_COMPACT )
+    {
+        return ParseContainerMes ( vecbyMesBodyData, true );
+    }
+
+    // special treatment for acknowledge messages (acknowledgments are not
+    // acknowledged)
+    if ( iRecID == PROTMESSID_ACKN )
+    {
+        // check size
+        if ( vecbyMesBodyData.Size() != 2 )
         {
-        case PROTMESSID_CLM_PING_MS:
-            bRet = EvaluateCLPingMes ( InetAddr, vecbyMesBodyData );
-            break;
+            return true; // return error code
+        }
 
-        case PROTMESSID_CLM_PING_MS_WITHNUMCLIENTS:
-            bRet = EvaluateCLPingWithNumClientsMes ( InetAddr, vecbyMesBodyData );
-            break;
+        // extract data from stream and emit signal for received value
+        int       iPos = 0;
+        const int iData =
+            static_cast<int> ( GetValFromStream ( vecbyMesBodyData, iPos, 2 ) );
 
-        case PROTMESSID_CLM_SERVER_FULL:
-            bRet = EvaluateCLServerFullMes();
-            break;
+        Mutex.lock();
+        {
+            // check if this is the acknowledgment of a message in flight
+            bSendNextMess = false;
 
-        case PROTMESSID_CLM_SERVER_LIST:
-            bRet = EvaluateCLServerListMes ( InetAddr, vecbyMesBodyData );
-            break;
+            std::list<CSendMessage>::iterator it = SendMessQueue.begin();
 
-        case PROTMESSID_CLM_REQ_SERVER_LIST:
-            bRet = EvaluateCLReqServerListMes ( InetAddr );
-            break;
+            for ( int i = 0; ( it != SendMessQueue.end() ) && ( i < iNumMessInFlight ); i++, ++it )
+            {
+                if ( ( it->iCnt == iRecCounter ) && ( it->iID == iData ) )
+                {
+                    // the other side is in in-order receive mode now
+                    if ( iData == PROTMESSID_PROT_VERSION )
+                    {
+                        bProtVersionAckn = true;
+                    }
 
-        case PROTMESSID_CLM_SEND_EMPTY_MESSAGE:
-            bRet = EvaluateCLSendEmptyMesMes ( vecbyMesBodyData );
-            break;
+                    // message acknowledged, remove from queue
+                    SendMessQueue.erase ( it );
+                    iNumMessInFlight--;
 
-        case PROTMESSID_CLM_REGISTER_SERVER:
-            bRet = EvaluateCLRegisterServerMes ( InetAddr, vecbyMesBodyData );
-            break;
+                    // send next message in queue
+                    bSendNextMess = true;
+                    break;
+                }
+            }
+        }
+        Mutex.unlock();
 
-        case PROTMESSID_CLM_UNREGISTER_SERVER:
-            bRet = EvaluateCLUnregisterServerMes ( InetAddr );
-            break;
+        if ( bSendNextMess )
+        {
+            SendMessage ( false );
+        }
 
-        case PROTMESSID_CLM_DISCONNECTION:
-            bRet = EvaluateCLDisconnectionMes ( InetAddr );
-            break;
+        return false; // no error
+    }
 
-        case PROTMESSID_CLM_VERSION_AND_OS:
-            bRet = EvaluateCLVersionAndOSMes ( InetAddr, vecbyMesBodyData );
-            break;
+    // the protocol version message starts a new in-order message sequence
+    // of the other side (e.g. after a reconnect), it is therefore always
+    // processed
+    if ( iRecID == PROTMESSID_PROT_VERSION )
+    {
+        bRet = EvaluateProtVersionMes ( vecbyMesBodyData, iRecCounter );
 
-        case PROTMESSID_CLM_REQ_VERSION_AND_OS:
-            bRet = EvaluateCLReqVersionAndOSMes ( InetAddr );
-            break;
+        // immediately send acknowledge message
+        CreateAndImmSendAcknMess ( iRecID, iRecCounter );
 
-        case PROTMESSID_CLM_CONN_CLIENTS_LIST:
-            bRet = EvaluateCLConnClientsListMes ( InetAddr, vecbyMesBodyData );
-            break;
+        return bRet;
+    }
 
-        case PROTMESSID_CLM_REQ_CONN_CLIENTS_LIST:
-            bRet = EvaluateCLReqConnClientsListMes ( InetAddr );
-            break;
+    if ( bInOrderReceive )
+    {
+        // with the sliding window, a lost message is followed by its
+        // successors which must not be processed before the lost message
+        // (the sender resends all unacknowledged messages)
+        const int iCntDiff = ( iRecCounter - iNextRecCnt ) & 0xFF;
 
-        case PROTMESSID_CLM_CHANNEL_LEVEL_LIST:
-            bRet = EvaluateCLChannelLevelListMes ( InetAddr, vecbyMesBodyData );
-            break;
+        if ( iCntDiff != 0 )
+        {
+            if ( iCntDiff >= 128 )
+            {
+                // old message, our acknowledgement was lost: resend it
+                CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+            }
 
-        case PROTMESSID_CLM_REGISTER_SERVER_RESP:
-            bRet = EvaluateCLRegisterServerResp ( InetAddr, vecbyMesBodyData );
-            break;
+            // messages which are ahead are dropped without acknowledgement
+            return false;
         }
+
+        iNextRecCnt = ( iNextRecCnt + 1 ) & 0xFF;
     }
-    else
+    else if ( ( iOldRecID == iRecID ) && ( iOldRecCnt == iRecCounter ) )
     {
-        bRet = true; // return error code
-    }
+        // In case we received a message and returned an answer but our answer
+        // did not make it to the receiver, he will resend his message. We check
+        // here if the message is the same as the old one, and if this is the
+        // case, just resend our old answer again
+        CreateAndImmSendAcknMess ( iRecID, iRecCounter );
 
-    return bRet;
-}
+        return false;
+    }
 
+    // check which type of message we received and do action
+    bRet = EvaluateMessageBody ( vecbyMesBodyData, iRecID );
 
-/******************************************************************************\
-* Access functions for creating and parsing messages                           *
-\******************************************************************************/
-void CProtocol::CreateJitBufMes ( const int iJitBufSize )
-{
-    CVector<uint8_t> vecData ( 2 ); // 2 bytes of data
-    int              iPos = 0;      // init position pointer
+    // immediately send acknowledge message
+    CreateAndImmSendAcknMess ( iRecID, iRecCounter );
 
-    // build data vector
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iJitBufSize ), 2 );
+    // save current message ID and counter to find out if message
+    // was resent
+    iOldRecID  = iRecID;
+    iOldRecCnt = iRecCounter;
 
-    CreateAndSendMessage ( PROTMESSID_JITT_BUF_SIZE, vecData );
+    return bRet;
 }
 
-bool CProtocol::EvaluateJitBufMes ( const CVector<uint8_t>& vecData )
+bool CProtocol::EvaluateMessageBody ( const CVector<uint8_t>& vecbyMesBodyData,
+                                      const int               iRecID )
 {
-    int iPos = 0; // init position pointer
+    bool bRet = false;
 
-    // check size
-    if ( vecData.Size() != 2 )
+    switch ( iRecID )
     {
-        return true; // return error code
-    }
+    case PROTMESSID_JITT_BUF_SIZE:
+        bRet = EvaluateJitBufMes ( vecbyMesBodyData );
+        break;
 
-    // extract jitter buffer size
-    const int iData = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+    case PROTMESSID_REQ_JITT_BUF_SIZE:
+        bRet = EvaluateReqJitBufMes();
+        break;
 
-    if ( ( ( iData < MIN_NET_BUF_SIZE_NUM_BL ) ||
-           ( iData > MAX_NET_BUF_SIZE_NUM_BL ) ) &&
-         ( iData != AUTO_NET_BUF_SIZE_FOR_PROTOCOL ) )
-    {
-        return true; // return error code
-    }
+    case PROTMESSID_CLIENT_ID:
+        bRet = EvaluateClientIDMes ( vecbyMesBodyData );
+        break;
 
-    // invoke message action
-    emit ChangeJittBufSize ( iData );
+    case PROTMESSID_CHANNEL_GAIN:
+        bRet = EvaluateChanGainMes ( vecbyMesBodyData );
+        break;
 
-    return false; // no error
-}
+    case PROTMESSID_CHANNEL_PAN:
+        bRet = EvaluateChanPanMes ( vecbyMesBodyData );
+        break;
 
-void CProtocol::CreateReqJitBufMes()
-{
-    CreateAndSendMessage ( PROTMESSID_REQ_JITT_BUF_SIZE,
-                           CVector<uint8_t> ( 0 ) );
-}
+    case PROTMESSID_CHANNEL_GAIN_PAN_LIST:
+        bRet = EvaluateChanGainPanListMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_MUTE_STATE_CHANGED:
+        bRet = EvaluateMuteStateHasChangedMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_CONN_CLIENTS_LIST:
+        bRet = EvaluateConClientListMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_REQ_CONN_CLIENTS_LIST:
+        bRet = EvaluateReqConnClientsList();
+        break;
+
+    case PROTMESSID_CHANNEL_INFOS:
+        bRet = EvaluateChanInfoMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_REQ_CHANNEL_INFOS:
+        bRet = EvaluateReqChanInfoMes();
+        break;
+
+    case PROTMESSID_CHAT_TEXT:
+        bRet = EvaluateChatTextMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_NETW_TRANSPORT_PROPS:
+        bRet = EvaluateNetwTranspPropsMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_REQ_NETW_TRANSPORT_PROPS:
+        bRet = EvaluateReqNetwTranspPropsMes();
+        break;
+
+    case PROTMESSID_LICENCE_REQUIRED:
+        bRet = EvaluateLicenceRequiredMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_REQ_CHANNEL_LEVEL_LIST:
+        bRet = EvaluateReqChannelLevelListMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_VERSION_AND_OS:
+        bRet = EvaluateVersionAndOSMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_RECORDER_STATE:
+        bRet = EvaluateRecorderStateMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_CONN_CLIENTS_LIST_DELTA:
+        bRet = EvaluateConClientListDeltaMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_REQ_CHANNEL_LEVEL_DELTA:
+        bRet = EvaluateReqChannelLevelDeltaMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_LISTENER_MODE:
+        bRet = EvaluateListenerModeMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_MIX_GROUP:
+        bRet = EvaluateMixGroupMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_MIX_GROUP_GAIN:
+        bRet = EvaluateMixGroupGainMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_MIX_GROUP_LIST:
+        bRet = EvaluateMixGroupListMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_MULTICAST_GROUP:
+        bRet = EvaluateMulticastGroupMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_MULTICAST_JOINED:
+        bRet = EvaluateMulticastJoinedMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_REQ_NET_STATS:
+        bRet = EvaluateReqNetStatsMes();
+        break;
+
+    case PROTMESSID_NET_STATS:
+        bRet = EvaluateNetStatsMes ( vecbyMesBodyData );
+        break;
+    }
+
+    return bRet;
+}
+
+bool CProtocol::ParseContainerMes ( const CVector<uint8_t>& vecData,
+                                    const bool              bCompact )
+{
+    // containers are not nested
+    if ( bCollectAckn )
+    {
+        return true; // return error code
+    }
+
+    const int iDataLen = vecData.Size();
+    int       iPos     = 0;
+    int       iPrevCnt = 0xFF;
+    bool      bRet     = false;
+
+    bCollectAckn = true;
+
+    while ( iPos < iDataLen )
+    {
+        int iRecCounter;
+        int iRecID;
+
+        if ( bCompact )
+        {
+            // the scratch vector keeps its capacity (no allocation per message)
+            if ( GetCompactMessage ( vecData,
+                                     iPos,
+                                     iPrevCnt,
+                                     vecbyContainerBody,
+                                     iRecCounter,
+                                     iRecID ) )
+            {
+                bRet = true; // error
+                break;
+            }
+        }
+        else
+        {
+            // read the data length from the header of the contained frame
+            if ( iPos + MESS_LEN_WITHOUT_DATA_BYTE > iDataLen )
+            {
+                bRet = true; // error
+                break;
+            }
+
+            int       iLenPos   = iPos + MESS_HEADER_LENGTH_BYTE - 2;
+            const int iFrameLen = MESS_LEN_WITHOUT_DATA_BYTE +
+                                  static_cast<int> ( GetValFromStream ( vecData, iLenPos, 2 ) );
+
+            if ( iPos + iFrameLen > iDataLen )
+            {
+                bRet = true; // error
+                break;
+            }
+
+            // the scratch vectors keep their capacity (no allocation per message)
+            vecbyContainerFrame.assign ( vecData.begin() + iPos, vecData.begin() + iPos + iFrameLen );
+            iPos += iFrameLen;
+
+            if ( ParseMessageFrame ( vecbyContainerFrame,
+                                     iFrameLen,
+                                     vecbyContainerBody,
+                                     iRecCounter,
+                                     iRecID ) )
+            {
+                bRet = true; // error
+                break;
+            }
+        }
+
+        if ( IsConnectionLessMessageID ( iRecID ) )
+        {
+            bRet = true; // error
+            break;
+        }
+
+        // an invalid message does not affect the other messages
+        if ( ParseMessageBody ( vecbyContainerBody, iRecCounter, iRecID ) )
+        {
+            bRet = true; // error
+        }
+    }
+
+    bCollectAckn = false;
+
+    // send the collected acknowledgements (the other side supports containers
+    // since it sent one and the compact format if the container was compact)
+    std::list<CProtMessage> vecCurAcknMessages;
+    vecCurAcknMessages.swap ( vecAcknMessages );
+
+    EmitMessages ( vecCurAcknMessages, true, bCompact );
+
+    return bRet;
+}
+
+bool CProtocol::ParseConnectionLessMessageBody ( const CVector<uint8_t>& vecbyMesBodyData,
+                                                 const int               iRecID,
+                                                 const CHostAddress&     InetAddr )
+{
+/*
+    return code: false -> ok; true -> error
+*/
+    bool bRet = false;
+
+/*
+// TEST channel implementation: randomly delete protocol messages (50 % loss)
+if ( rand() < ( RAND_MAX / 2 ) ) return false;
+*/
+
+    if ( IsConnectionLessMessageID ( iRecID ) )
+    {
+        // check which type of message we received and do action
+        switch ( iRecID )
+        {
+        case PROTMESSID_CLM_PING_MS:
+            bRet = EvaluateCLPingMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_PING_MS_WITHNUMCLIENTS:
+            bRet = EvaluateCLPingWithNumClientsMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_SERVER_FULL:
+            bRet = EvaluateCLServerFullMes();
+            break;
+
+        case PROTMESSID_CLM_SERVER_LIST:
+            bRet = EvaluateCLServerListMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_REQ_SERVER_LIST:
+            bRet = EvaluateCLReqServerListMes ( InetAddr );
+            break;
+
+        case PROTMESSID_CLM_SEND_EMPTY_MESSAGE:
+            bRet = EvaluateCLSendEmptyMesMes ( vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_REGISTER_SERVER:
+            bRet = EvaluateCLRegisterServerMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_UNREGISTER_SERVER:
+            bRet = EvaluateCLUnregisterServerMes ( InetAddr );
+            break;
+
+        case PROTMESSID_CLM_DISCONNECTION:
+            bRet = EvaluateCLDisconnectionMes ( InetAddr );
+            break;
+
+        case PROTMESSID_CLM_VERSION_AND_OS:
+            bRet = EvaluateCLVersionAndOSMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_REQ_VERSION_AND_OS:
+            bRet = EvaluateCLReqVersionAndOSMes ( InetAddr );
+            break;
+
+        case PROTMESSID_CLM_CONN_CLIENTS_LIST:
+            bRet = EvaluateCLConnClientsListMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_REQ_CONN_CLIENTS_LIST:
+            bRet = EvaluateCLReqConnClientsListMes ( InetAddr );
+            break;
+
+        case PROTMESSID_CLM_CHANNEL_LEVEL_LIST:
+            bRet = EvaluateCLChannelLevelListMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_REGISTER_SERVER_RESP:
+            bRet = EvaluateCLRegisterServerResp ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_CHANNEL_LEVEL_DELTA:
+            bRet = EvaluateCLChannelLevelDeltaMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_SEND_EMPTY_MES_LIST:
+            bRet = EvaluateCLSendEmptyMesListMes ( vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_SERVER_FEATURES:
+            bRet = EvaluateCLServerFeaturesMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_FEDERATION_UPDATE:
+            bRet = EvaluateCLFederationUpdateMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_REQ_FEDERATION_SYNC:
+            bRet = EvaluateCLReqFederationSyncMes ( InetAddr );
+            break;
+
+        case PROTMESSID_CLM_REQ_SERVER_LIST_PAGE:
+            bRet = EvaluateCLReqServerListPageMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_SERVER_LIST_PAGE:
+            bRet = EvaluateCLServerListPageMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_RTT_PROBE:
+            bRet = EvaluateCLRttProbeMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_RTT_PROBE_ECHO:
+            bRet = EvaluateCLRttProbeEchoMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_REQ_SERVER_LIST_IPV6:
+            bRet = EvaluateCLReqServerListIPv6Mes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_SERVER_LIST_IPV6:
+            bRet = EvaluateCLServerListIPv6Mes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_REQ_LATENCY_PROBE:
+            bRet = EvaluateCLReqLatencyProbeMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_LATENCY_PROBE:
+            bRet = EvaluateCLLatencyProbeMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_SERVER_LOAD:
+            bRet = EvaluateCLServerLoadMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_REGISTER_SERVER_RETRY:
+            bRet = EvaluateCLRegisterServerRetryMes ( InetAddr, vecbyMesBodyData );
+            break;
+        }
+    }
+    else
+    {
+        bRet = true; // return error code
+    }
+
+    return bRet;
+}
+
+
+/******************************************************************************\
+* Access functions for creating and parsing messages                           *
+\******************************************************************************/
+void CProtocol::CreateJitBufMes ( const int iJitBufSize )
+{
+    CVector<uint8_t> vecData ( 2 ); // 2 bytes of data
+    int              iPos = 0;      // init position pointer
+
+    // build data vector
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iJitBufSize ), 2 );
+
+    CreateAndSendMessage ( PROTMESSID_JITT_BUF_SIZE, vecData );
+}
+
+bool CProtocol::EvaluateJitBufMes ( const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 2 )
+    {
+        return true; // return error code
+    }
+
+    // extract jitter buffer size
+    const int iData = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    if ( ( ( iData < MIN_NET_BUF_SIZE_NUM_BL ) ||
+           ( iData > MAX_NET_BUF_SIZE_NUM_BL ) ) &&
+         ( iData != AUTO_NET_BUF_SIZE_FOR_PROTOCOL ) )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit ChangeJittBufSize ( iData );
+
+    return false; // no error
+}
+
+void CProtocol::CreateReqJitBufMes()
+{
+    CreateAndSendMessage ( PROTMESSID_REQ_JITT_BUF_SIZE,
+                           CVector<uint8_t> ( 0 ) );
+}
 
 bool CProtocol::EvaluateReqJitBufMes()
 {
@@ -947,20 +1984,138 @@ bool CProtocol::EvaluateChanPanMes ( const CVector<uint8_t> &vecData )
     return false; // no error
 }
 
-void CProtocol::CreateMuteStateHasChangedMes ( const int iChanID, const bool bIsMuted )
+void CProtocol::CreateChanGainPanListMes ( const CVector<double>& vecdGains,
+                                           const CVector<double>& vecdPans )
 {
-    CVector<uint8_t> vecData ( 2 ); // 2 bytes of data
-    int              iPos = 0;      // init position pointer
+    const int iNumChannels = std::min ( vecdGains.Size(), vecdPans.Size() );
 
-    // build data vector
-    // channel ID
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iChanID ), 1 );
+    // older peers get the separate gain and pan messages
+    if ( GetPeerProtVersion() < PROT_VERSION_COMPACT_MESS )
+    {
+        for ( int i = 0; i < iNumChannels; i++ )
+        {
+            if ( vecdGains[i] >= 0.0 )
+            {
+                CreateChanGainMes ( i, vecdGains[i] );
+            }
 
-    // mute state
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( bIsMuted ), 1 );
+            if ( vecdPans[i] >= 0.0 )
+            {
+                CreateChanPanMes ( i, vecdPans[i] );
+            }
+        }
 
-    CreateAndSendMessage ( PROTMESSID_MUTE_STATE_CHANGED, vecData );
-}
+        return;
+    }
+
+    // calculate the size of the message
+    int iSize = 0;
+
+    for ( int i = 0; i < iNumChannels; i++ )
+    {
+        if ( ( vecdGains[i] >= 0.0 ) || ( vecdPans[i] >= 0.0 ) )
+        {
+            iSize += GetVarIntSize ( static_cast<uint32_t> ( i << 2 ) ) +
+                     ( vecdGains[i] >= 0.0 ? 2 : 0 ) +
+                     ( vecdPans[i] >= 0.0 ? 2 : 0 );
+        }
+    }
+
+    if ( iSize == 0 )
+    {
+        return;
+    }
+
+    CVector<uint8_t> vecData ( iSize );
+    int              iPos = 0; // init position pointer
+
+    // build data vector
+    for ( int i = 0; i < iNumChannels; i++ )
+    {
+        const bool bHasGain = ( vecdGains[i] >= 0.0 );
+        const bool bHasPan  = ( vecdPans[i] >= 0.0 );
+
+        if ( bHasGain || bHasPan )
+        {
+            // channel ID and the flags of the values
+            PutVarIntOnStream ( vecData,
+                                iPos,
+                                static_cast<uint32_t> ( ( i << 2 ) | ( bHasPan ? 2 : 0 ) | ( bHasGain ? 1 : 0 ) ) );
+
+            // the values are converted like in the separate messages
+            if ( bHasGain )
+            {
+                PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( static_cast<int> ( vecdGains[i] * ( 1 << 15 ) ) ), 2 );
+            }
+
+            if ( bHasPan )
+            {
+                PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( static_cast<int> ( vecdPans[i] * ( 1 << 15 ) ) ), 2 );
+            }
+        }
+    }
+
+    CreateAndSendMessage ( PROTMESSID_CHANNEL_GAIN_PAN_LIST, vecData );
+}
+
+bool CProtocol::EvaluateChanGainPanListMes ( const CVector<uint8_t>& vecData )
+{
+    const int iDataLen = vecData.Size();
+    int       iPos     = 0; // init position pointer
+
+    while ( iPos < iDataLen )
+    {
+        // channel ID and the flags of the values
+        uint32_t iHeader;
+
+        if ( GetVarIntFromStream ( vecData, iPos, iHeader ) )
+        {
+            return true; // return error code
+        }
+
+        const int  iCurID   = static_cast<int> ( iHeader >> 2 );
+        const bool bHasGain = ( ( iHeader & 1 ) != 0 );
+        const bool bHasPan  = ( ( iHeader & 2 ) != 0 );
+
+        // check size
+        if ( iPos + ( bHasGain ? 2 : 0 ) + ( bHasPan ? 2 : 0 ) > iDataLen )
+        {
+            return true; // return error code
+        }
+
+        // invoke message actions
+        if ( bHasGain )
+        {
+            const int iData = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+            emit ChangeChanGain ( iCurID, static_cast<double> ( iData ) / ( 1 << 15 ) );
+        }
+
+        if ( bHasPan )
+        {
+            const int iData = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+            emit ChangeChanPan ( iCurID, static_cast<double> ( iData ) / ( 1 << 15 ) );
+        }
+    }
+
+    return false; // no error
+}
+
+void CProtocol::CreateMuteStateHasChangedMes ( const int iChanID, const bool bIsMuted )
+{
+    CVector<uint8_t> vecData ( 2 ); // 2 bytes of data
+    int              iPos = 0;      // init position pointer
+
+    // build data vector
+    // channel ID
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iChanID ), 1 );
+
+    // mute state
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( bIsMuted ), 1 );
+
+    CreateAndSendMessage ( PROTMESSID_MUTE_STATE_CHANGED, vecData );
+}
 
 bool CProtocol::EvaluateMuteStateHasChangedMes ( const CVector<uint8_t> &vecData )
 {
@@ -984,14 +2139,12 @@ bool CProtocol::EvaluateMuteStateHasChangedMes ( const CVector<uint8_t> &vecData
     return false; // no error
 }
 
-void CProtocol::CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInfo )
+void CProtocol::PutConClientListEntries ( CVector<uint8_t>&            vecData,
+                                          int&                         iPos,
+                                          const CVector<CChannelInfo>& vecChanInfo )
 {
     const int iNumClients = vecChanInfo.Size();
 
-    // build data vector
-    CVector<uint8_t> vecData ( 0 );
-    int              iPos = 0; // init position pointer
-
     for ( int i = 0; i < iNumClients; i++ )
     {
         // convert strings to utf-8
@@ -1035,15 +2188,13 @@ void CProtocol::CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInf
         // city
         PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
     }
-
-    CreateAndSendMessage ( PROTMESSID_CONN_CLIENTS_LIST, vecData );
 }
 
-bool CProtocol::EvaluateConClientListMes ( const CVector<uint8_t>& vecData )
+bool CProtocol::GetConClientListEntries ( const CVector<uint8_t>& vecData,
+                                          int&                    iPos,
+                                          CVector<CChannelInfo>&  vecChanInfo )
 {
-    int                   iPos     = 0; // init position pointer
-    const int             iDataLen = vecData.Size();
-    CVector<CChannelInfo> vecChanInfo ( 0 );
+    const int iDataLen = vecData.Size();
 
     while ( iPos < iDataLen )
     {
@@ -1109,12 +2260,219 @@ bool CProtocol::EvaluateConClientListMes ( const CVector<uint8_t>& vecData )
         return true; // return error code
     }
 
+    return false; // no error
+}
+
+void CProtocol::CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInfo )
+{
+    CProtBroadcastMes Mes;
+
+    PrepareConClientListMes ( vecChanInfo, Mes );
+    SendBroadcastMes ( Mes );
+}
+
+void CProtocol::PrepareConClientListMes ( const CVector<CChannelInfo>& vecChanInfo,
+                                          CProtBroadcastMes&           Mes )
+{
+    // build data vector
+    int iPos = 0; // init position pointer
+
+    Mes.iID = PROTMESSID_CONN_CLIENTS_LIST;
+    Mes.vecData.Init ( 0 );
+
+    PutConClientListEntries ( Mes.vecData, iPos, vecChanInfo );
+}
+
+bool CProtocol::EvaluateConClientListMes ( const CVector<uint8_t>& vecData )
+{
+    int                   iPos = 0; // init position pointer
+    CVector<CChannelInfo> vecChanInfo ( 0 );
+
+    if ( GetConClientListEntries ( vecData, iPos, vecChanInfo ) )
+    {
+        return true; // return error code
+    }
+
     // invoke message action
     emit ConClientListMesReceived ( vecChanInfo );
 
     return false; // no error
 }
 
+int CProtocol::GetConClientListEntrySize ( const CChannelInfo& ChanInfo )
+{
+    // see PutConClientListEntries()
+    return 1 /* chan ID */ + 2 /* country */ +
+           4 /* instrument */ + 1 /* skill level */ +
+           4 /* IP address */ +
+           2 /* utf-8 str. size */ + ChanInfo.strName.toUtf8().size() +
+           2 /* utf-8 str. size */ + ChanInfo.strCity.toUtf8().size();
+}
+
+void CProtocol::CreateConClientListDeltaMes ( const int                    iListVersion,
+                                              const bool                   bFullList,
+                                              const CVector<CChannelInfo>& vecChanInfo,
+                                              const CVector<int>&          veciLeftChanIDs )
+{
+    CProtBroadcastMes Mes;
+
+    PrepareConClientListDeltaMes ( iListVersion, bFullList, vecChanInfo, veciLeftChanIDs, Mes );
+    SendBroadcastMes ( Mes );
+}
+
+void CProtocol::PrepareConClientListDeltaMes ( const int                    iListVersion,
+                                               const bool                   bFullList,
+                                               const CVector<CChannelInfo>& vecChanInfo,
+                                               const CVector<int>&          veciLeftChanIDs,
+                                               CProtBroadcastMes&           Mes )
+{
+    PrepareConClientListDeltaPart ( iListVersion,
+                                    bFullList ? CONN_CLIENTS_LIST_FLAG_FULL_LIST : 0,
+                                    vecChanInfo,
+                                    veciLeftChanIDs,
+                                    Mes );
+}
+
+void CProtocol::PrepareConClientListDeltaMesParts ( const int                    iListVersion,
+                                                    const bool                   bFullList,
+                                                    const CVector<CChannelInfo>& vecChanInfo,
+                                                    const CVector<int>&          veciLeftChanIDs,
+                                                    CVector<CProtBroadcastMes>&  vecMes )
+{
+    const int iNumClients = vecChanInfo.Size();
+    int       iStart      = 0;
+
+    vecMes.Init ( 0 );
+
+    // the first part has the clients which left and the flags of the list,
+    // each part has at least one entry (the first part may have none)
+    do
+    {
+        const bool bFirstPart = ( iStart == 0 );
+        int        iPartBytes = bFirstPart ? veciLeftChanIDs.Size() : 0;
+        int        iEnd       = iStart;
+
+        while ( iEnd < iNumClients )
+        {
+            const int iEntryBytes = GetConClientListEntrySize ( vecChanInfo[iEnd] );
+
+            if ( ( iEnd > iStart ) && ( iPartBytes + iEntryBytes > PROT_LIST_PART_MAX_BYTES ) )
+            {
+                break;
+            }
+
+            iPartBytes += iEntryBytes;
+            iEnd++;
+        }
+
+        CVector<CChannelInfo> vecPartChanInfo ( 0 );
+
+        for ( int i = iStart; i < iEnd; i++ )
+        {
+            vecPartChanInfo.Add ( vecChanInfo[i] );
+        }
+
+        int iFlags = bFirstPart ? ( bFullList ? CONN_CLIENTS_LIST_FLAG_FULL_LIST : 0 )
+                                : CONN_CLIENTS_LIST_FLAG_CONTINUED;
+
+        if ( iEnd < iNumClients )
+        {
+            iFlags |= CONN_CLIENTS_LIST_FLAG_MORE_PARTS;
+        }
+
+        vecMes.Enlarge ( 1 );
+
+        PrepareConClientListDeltaPart ( iListVersion,
+                                        iFlags,
+                                        vecPartChanInfo,
+                                        bFirstPart ? veciLeftChanIDs : CVector<int> ( 0 ),
+                                        vecMes[vecMes.Size() - 1] );
+
+        iStart = iEnd;
+    }
+    while ( iStart < iNumClients );
+}
+
+void CProtocol::PrepareConClientListDeltaPart ( const int                    iListVersion,
+                                                const int                    iFlags,
+                                                const CVector<CChannelInfo>& vecChanInfo,
+                                                const CVector<int>&          veciLeftChanIDs,
+                                                CProtBroadcastMes&           Mes )
+{
+    const int iNumLeft = veciLeftChanIDs.Size();
+
+    // build data vector
+    CVector<uint8_t>& vecData = Mes.vecData;
+    int               iPos    = 0; // init position pointer
+
+    Mes.iID = PROTMESSID_CONN_CLIENTS_LIST_DELTA;
+    vecData.Init ( 2 /* version */ + 1 /* flags */ + 1 /* num left */ + iNumLeft );
+
+    // list version (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iListVersion & 0xFFFF ), 2 );
+
+    // flags (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iFlags ), 1 );
+
+    // channel IDs of the clients which left (1 byte each)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iNumLeft ), 1 );
+
+    for ( int i = 0; i < iNumLeft; i++ )
+    {
+        PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( veciLeftChanIDs[i] ), 1 );
+    }
+
+    // joined or updated clients (same format as the connected clients list)
+    PutConClientListEntries ( vecData, iPos, vecChanInfo );
+}
+
+bool CProtocol::EvaluateConClientListDeltaMes ( const CVector<uint8_t>& vecData )
+{
+    int                   iPos     = 0; // init position pointer
+    const int             iDataLen = vecData.Size();
+    CVector<CChannelInfo> vecChanInfo ( 0 );
+
+    // check size (version, flags and number of left clients)
+    if ( iDataLen < 4 )
+    {
+        return true; // return error code
+    }
+
+    // list version (2 bytes)
+    const int iListVersion =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    // flags (1 byte)
+    const int iFlags = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    // channel IDs of the clients which left
+    const int iNumLeft =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( iPos + iNumLeft > iDataLen )
+    {
+        return true; // return error code
+    }
+
+    CVector<int> veciLeftChanIDs ( iNumLeft );
+
+    for ( int i = 0; i < iNumLeft; i++ )
+    {
+        veciLeftChanIDs[i] = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+    }
+
+    // joined or updated clients
+    if ( GetConClientListEntries ( vecData, iPos, vecChanInfo ) )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit ConClientListDeltaMesReceived ( iListVersion, iFlags, vecChanInfo, veciLeftChanIDs );
+
+    return false; // no error
+}
+
 void CProtocol::CreateReqConnClientsList()
 {
     CreateAndSendMessage ( PROTMESSID_REQ_CONN_CLIENTS_LIST, CVector<uint8_t> ( 0 ) );
@@ -1182,23 +2540,1364 @@ bool CProtocol::EvaluateChanInfoMes ( const CVector<uint8_t>& vecData )
     // instrument (4 bytes)
     ChanInfo.iInstrument = static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
 
-    // skill level (1 byte)
-    ChanInfo.eSkillLevel = static_cast<ESkillLevel> ( GetValFromStream ( vecData, iPos, 1 ) );
+    // skill level (1 byte)
+    ChanInfo.eSkillLevel = static_cast<ESkillLevel> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    // name
+    if ( GetStringFromStream ( vecData,
+                               iPos,
+                               MAX_LEN_FADER_TAG,
+                               ChanInfo.strName ) )
+    {
+        return true; // return error code
+    }
+
+    // city
+    if ( GetStringFromStream ( vecData,
+                               iPos,
+                               MAX_LEN_SERVER_CITY,
+                               ChanInfo.strCity ) )
+    {
+        return true; // return error code
+    }
+
+    // check size: all data is read, the position must now be at the end
+    if ( iPos != iDataLen )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit ChangeChanInfo ( ChanInfo );
+
+    return false; // no error
+}
+
+void CProtocol::CreateReqChanInfoMes()
+{
+    CreateAndSendMessage ( PROTMESSID_REQ_CHANNEL_INFOS, CVector<uint8_t> ( 0 ) );
+}
+
+bool CProtocol::EvaluateReqChanInfoMes()
+{
+    // invoke message action
+    emit ReqChanInfo();
+
+    return false; // no error
+}
+
+void CProtocol::CreateChatTextMes ( const QString strChatText )
+{
+    CProtBroadcastMes Mes;
+
+    PrepareChatTextMes ( strChatText, Mes );
+    SendBroadcastMes ( Mes );
+}
+
+void CProtocol::PrepareChatTextMes ( const QString&     strChatText,
+                                     CProtBroadcastMes& Mes )
+{
+    int iPos = 0; // init position pointer
+
+    // convert chat text string to utf-8
+    const QByteArray strUTF8ChatText = strChatText.toUtf8();
+
+    const int iStrUTF8Len = strUTF8ChatText.size(); // get utf-8 string size
+
+    // size of message body
+    const int iEntrLen = 2 /* utf-8 string size */ + iStrUTF8Len;
+
+    // build data vector
+    Mes.iID = PROTMESSID_CHAT_TEXT;
+    Mes.vecData.Init ( iEntrLen );
+
+    // chat text
+    PutStringUTF8OnStream ( Mes.vecData, iPos, strUTF8ChatText );
+}
+
+bool CProtocol::EvaluateChatTextMes ( const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // chat text
+    QString strChatText;
+    if ( GetStringFromStream ( vecData,
+                               iPos,
+                               MAX_LEN_CHAT_TEXT_PLUS_HTML,
+                               strChatText ) )
+    {
+        return true; // return error code
+    }
+
+    // check size: all data is read, the position must now be at the end
+    if ( iPos != vecData.Size() )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit ChatTextReceived ( strChatText );
+
+    return false; // no error
+}
+
+void CProtocol::CreateNetwTranspPropsMes ( const CNetworkTransportProps& NetTrProps )
+{
+    int iPos = 0; // init position pointer
+
+    // size of current message body
+    const int iEntrLen =
+        4 /* netw size */ +
+        2 /* block size fact */ +
+        1 /* num chan */ +
+        4 /* sam rate */ +
+        2 /* audiocod type */ +
+        2 /* version */ +
+        4 /* audiocod arg */;
+
+    // build data vector
+    CVector<uint8_t> vecData ( iEntrLen );
+
+    // length of the base network packet (frame) in bytes (4 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iBaseNetworkPacketSize ), 4 );
+
+    // block size factor (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iBlockSizeFact ), 2 );
+
+    // number of channels of the audio signal, e.g. "2" is stereo (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iNumAudioChannels ), 1 );
+
+    // sample rate of the audio stream (4 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iSampleRate ), 4 );
+
+    // audio coding type (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.eAudioCodingType ), 2 );
+
+    // version (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iVersion ), 2 );
+
+    // argument for the audio coder (4 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iAudioCodingArg ), 4 );
+
+    CreateAndSendMessage ( PROTMESSID_NETW_TRANSPORT_PROPS, vecData );
+}
+
+bool CProtocol::EvaluateNetwTranspPropsMes ( const CVector<uint8_t>& vecData )
+{
+    int                    iPos = 0; // init position pointer
+    CNetworkTransportProps ReceivedNetwTranspProps;
+
+    // size of current message body
+    const int iEntrLen =
+        4 /* netw size */ +
+        2 /* block size fact */ +
+        1 /* num chan */ +
+        4 /* sam rate */ +
+        2 /* audiocod type */ +
+        2 /* version */ +
+        4 /* audiocod arg */;
+
+    // check size
+    if ( vecData.Size() != iEntrLen )
+    {
+        return true; // return error code
+    }
+
+    // length of the base network packet (frame) in bytes (4 bytes)
+    ReceivedNetwTranspProps.iBaseNetworkPacketSize =
+        static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 4 ) );
+
+    // at least CELT_MINIMUM_NUM_BYTES bytes are required for the CELC codec
+    if ( ( ReceivedNetwTranspProps.iBaseNetworkPacketSize < CELT_MINIMUM_NUM_BYTES ) ||
+         ( ReceivedNetwTranspProps.iBaseNetworkPacketSize > MAX_SIZE_BYTES_NETW_BUF ) )
+    {
+        return true; // return error code
+    }
+
+    // block size factor (2 bytes)
+    ReceivedNetwTranspProps.iBlockSizeFact =
+        static_cast<uint16_t> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    if ( ( ReceivedNetwTranspProps.iBlockSizeFact != FRAME_SIZE_FACTOR_PREFERRED ) &&
+         ( ReceivedNetwTranspProps.iBlockSizeFact != FRAME_SIZE_FACTOR_DEFAULT ) &&
+         ( ReceivedNetwTranspProps.iBlockSizeFact != FRAME_SIZE_FACTOR_SAFE ) )
+    {
+        return true; // return error code
+    }
+
+    // number of channels of the audio signal, only mono (1 channel) or
+    // stereo (2 channels) allowed (1 byte)
+    ReceivedNetwTranspProps.iNumAudioChannels =
+        static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( ( ReceivedNetwTranspProps.iNumAudioChannels != 1 ) &&
+         ( ReceivedNetwTranspProps.iNumAudioChannels != 2 ) )
+    {
+        return true; // return error code
+    }
+
+    // sample rate of the audio stream (4 bytes)
+    ReceivedNetwTranspProps.iSampleRate =
+        static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 4 ) );
+
+    // audio coding type (2 bytes) with error check
+    const int iRecCodingType =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    // note that CT_NONE is not a valid setting but only used for server
+    // initialization
+    if ( ( iRecCodingType != CT_CELT ) &&
+         ( iRecCodingType != CT_OPUS ) &&
+         ( iRecCodingType != CT_OPUS64 ) )
+    {
+        return true;
+    }
+
+    ReceivedNetwTranspProps.eAudioCodingType =
+        static_cast<EAudComprType> ( iRecCodingType );
+
+    // version (2 bytes)
+    ReceivedNetwTranspProps.iVersion =
+        static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    // argument for the audio coder (4 bytes)
+    ReceivedNetwTranspProps.iAudioCodingArg =
+        static_cast<int32_t> ( GetValFromStream ( vecData, iPos, 4 ) );
+
+    // invoke message action
+    emit NetTranspPropsReceived ( ReceivedNetwTranspProps );
+
+    return false; // no error
+}
+
+void CProtocol::CreateReqNetwTranspPropsMes()
+{
+    CreateAndSendMessage ( PROTMESSID_REQ_NETW_TRANSPORT_PROPS,
+                           CVector<uint8_t> ( 0 ) );
+}
+
+bool CProtocol::EvaluateReqNetwTranspPropsMes()
+{
+    // invoke message action
+    emit ReqNetTranspProps();
+
+    return false; // no error
+}
+
+void CProtocol::CreateLicenceRequiredMes ( const ELicenceType eLicenceType )
+{
+    CVector<uint8_t> vecData ( 1 ); // 1 bytes of data
+    int              iPos = 0;      // init position pointer
+
+    // build data vector
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( eLicenceType ), 1 );
+
+    CreateAndSendMessage ( PROTMESSID_LICENCE_REQUIRED, vecData );
+}
+
+bool CProtocol::EvaluateLicenceRequiredMes ( const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 1 )
+    {
+        return true; // return error code
+    }
+
+    // extract licence type
+    const ELicenceType eLicenceType =
+        static_cast<ELicenceType> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( ( eLicenceType != LT_CREATIVECOMMONS ) &&
+         ( eLicenceType != LT_NO_LICENCE ) )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit LicenceRequired ( eLicenceType );
+
+    return false; // no error
+}
+
+void CProtocol::CreateOpusSupportedMes()
+{
+    CreateAndSendMessage ( PROTMESSID_OPUS_SUPPORTED, CVector<uint8_t> ( 0 ) );
+}
+
+void CProtocol::CreateReqChannelLevelListMes ( const bool bRCL )
+{
+    CVector<uint8_t> vecData ( 1 ); // 1 byte of data
+    int              iPos = 0; // init position pointer
+    PutValOnStream ( vecData, iPos,
+        static_cast<uint32_t> ( bRCL ), 1 );
+
+    CreateAndSendMessage ( PROTMESSID_REQ_CHANNEL_LEVEL_LIST, vecData );
+}
+
+bool CProtocol::EvaluateReqChannelLevelListMes ( const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 1 )
+    {
+        return true; // return error code
+    }
+
+    // extract opt in / out for channel levels
+    uint32_t val = GetValFromStream ( vecData, iPos, 1 );
+
+    if ( val != 0 && val != 1 )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit ReqChannelLevelList ( static_cast<bool> ( val ) );
+
+    return false; // no error
+}
+
+void CProtocol::CreateVersionAndOSMes()
+{
+    int iPos = 0; // init position pointer
+
+    // get the version number string
+    const QString strVerion = VERSION;
+
+    // convert version string to utf-8
+    const QByteArray strUTF8Version = strVerion.toUtf8();
+
+    // size of current message body
+    const int iEntrLen =
+        1 /* operating system */ +
+        2 /* version utf-8 string size */ + strUTF8Version.size();
+
+    // build data vector
+    CVector<uint8_t> vecData ( iEntrLen );
+
+    // operating system (1 byte)
+    PutValOnStream ( vecData, iPos,
+        static_cast<uint32_t> ( COSUtil::GetOperatingSystem() ), 1 );
+
+    // version
+    PutStringUTF8OnStream ( vecData, iPos, strUTF8Version );
+
+    CreateAndSendMessage ( PROTMESSID_VERSION_AND_OS, vecData );
+}
+
+bool CProtocol::EvaluateVersionAndOSMes ( const CVector<uint8_t>& vecData )
+{
+    int       iPos = 0; // init position pointer
+    const int iDataLen = vecData.Size();
+
+    // check size (the first 1 byte)
+    if ( iDataLen < 1 )
+    {
+        return true; // return error code
+    }
+
+    // operating system (1 byte)
+    const COSUtil::EOpSystemType eOSType =
+        static_cast<COSUtil::EOpSystemType> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    // version text
+    QString strVersion;
+    if ( GetStringFromStream ( vecData,
+                               iPos,
+                               MAX_LEN_VERSION_TEXT,
+                               strVersion ) )
+    {
+        return true; // return error code
+    }
+
+    // check size: all data is read, the position must now be at the end
+    if ( iPos != iDataLen )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit VersionAndOSReceived ( eOSType, strVersion );
+
+    return false; // no error
+}
+
+void CProtocol::CreateRecorderStateMes ( const ERecorderState eRecorderState )
+{
+    CProtBroadcastMes Mes;
+
+    PrepareRecorderStateMes ( eRecorderState, Mes );
+    SendBroadcastMes ( Mes );
+}
+
+void CProtocol::PrepareRecorderStateMes ( const ERecorderState eRecorderState,
+                                          CProtBroadcastMes&   Mes )
+{
+    int iPos = 0; // init position pointer
+
+    Mes.iID = PROTMESSID_RECORDER_STATE;
+    Mes.vecData.Init ( 1 ); // 1 byte of data
+
+    // build data vector
+    // server jam recorder state (1 byte)
+    PutValOnStream ( Mes.vecData, iPos, static_cast<uint32_t> ( eRecorderState ), 1 );
+}
+
+bool CProtocol::EvaluateRecorderStateMes(const CVector<uint8_t>& vecData)
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 1 )
+    {
+        return true; // return error code
+    }
+
+    // server jam recorder state (1 byte)
+    const int iRecorderState =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    // note that RS_UNDEFINED is only internally used
+    if ( ( iRecorderState != RS_NOT_INITIALISED ) &&
+         ( iRecorderState != RS_NOT_ENABLED ) &&
+         ( iRecorderState != RS_RECORDING ) )
+    {
+        return true;
+    }
+
+    // invoke message action
+    emit RecorderStateReceived ( static_cast<ERecorderState> ( iRecorderState ) );
+
+    return false; // no error
+}
+
+bool CProtocol::EvaluateProtVersionMes ( const CVector<uint8_t>& vecData,
+                                         const int               iRecCounter )
+{
+    int iPos = 0; // init position pointer
+
+    // check size (newer versions may append data)
+    if ( vecData.Size() < 2 )
+    {
+        return true; // return error code
+    }
+
+    // protocol version (1 byte)
+    const int iVersion =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    // receive window size (1 byte)
+    const int iWindowSize =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( ( iWindowSize < 1 ) || ( iWindowSize >= 128 ) )
+    {
+        return true; // return error code
+    }
+
+    // the other side started a new session: in-order receive starts with the
+    // next counter value
+    bInOrderReceive = ( iVersion >= PROT_VERSION_SEND_WINDOW );
+    iNextRecCnt     = ( iRecCounter + 1 ) & 0xFF;
+    iOldRecID       = PROTMESSID_ILLEGAL;
+
+    const bool bHasSessionSetup     = ( iVersion >= PROT_VERSION_SESSION_SETUP ) && ( iPos < vecData.Size() );
+    bool       bSessionSetupMissing = false;
+
+    Mutex.lock();
+    {
+        iPeerProtVersion = iVersion;
+        iPeerWindowSize  = iWindowSize;
+
+        if ( bWaitForSessionSetup )
+        {
+            bWaitForSessionSetup = false;
+            bSessionSetupMissing = !bHasSessionSetup;
+        }
+    }
+    Mutex.unlock();
+
+    // the messages of the session setup are evaluated before our messages are
+    // sent so that the answers are part of our first container
+    bool bRet = false;
+
+    if ( bHasSessionSetup )
+    {
+        bRet = EvaluateSessionSetup ( vecData, iPos );
+    }
+
+    if ( bSessionSetupMissing )
+    {
+        emit SessionSetupMissing();
+    }
+
+    // the send window may be open now
+    SendMessage ( false );
+
+    return bRet;
+}
+
+bool CProtocol::EvaluateSessionSetup ( const CVector<uint8_t>& vecData,
+                                       int&                    iPos )
+{
+    const int iDataLen = vecData.Size();
+    bool      bRet     = false;
+
+    while ( iPos < iDataLen )
+    {
+        // message ID and data length (2 bytes each)
+        if ( iPos + 4 > iDataLen )
+        {
+            return true; // return error code
+        }
+
+        const int iID =
+            static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+        const int iLen =
+            static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+        if ( iPos + iLen > iDataLen )
+        {
+            return true; // return error code
+        }
+
+        // the scratch vector keeps its capacity (note that the protocol version
+        // message itself may be in the scratch vector of a container)
+        vecbySessionSetupBody.assign ( vecData.begin() + iPos, vecData.begin() + iPos + iLen );
+        iPos += iLen;
+
+        // only regular messages are allowed (acknowledgements, protocol
+        // versions and containers are not handled by EvaluateMessageBody()),
+        // an invalid message does not affect the other messages
+        if ( IsConnectionLessMessageID ( iID ) ||
+             EvaluateMessageBody ( vecbySessionSetupBody, iID ) )
+        {
+            bRet = true; // error
+        }
+    }
+
+    return bRet;
+}
+
+void CProtocol::CreateReqChannelLevelDeltaMes ( const int iInterval )
+{
+    CVector<uint8_t> vecData ( 1 ); // 1 byte of data
+    int              iPos = 0;      // init position pointer
+
+    // build data vector
+    // update interval (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iInterval ), 1 );
+
+    CreateAndSendMessage ( PROTMESSID_REQ_CHANNEL_LEVEL_DELTA, vecData );
+}
+
+bool CProtocol::EvaluateReqChannelLevelDeltaMes ( const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 1 )
+    {
+        return true; // return error code
+    }
+
+    // update interval (1 byte)
+    const int iInterval =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( iInterval > MAX_CHANNEL_LEVEL_DELTA_INTERVAL )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit ReqChannelLevelDelta ( iInterval );
+
+    return false; // no error
+}
+
+void CProtocol::CreateListenerModeMes ( const bool bIsListener )
+{
+    CVector<uint8_t> vecData ( 1 ); // 1 byte of data
+    int              iPos = 0;      // init position pointer
+
+    // build data vector
+    // state (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( bIsListener ? 1 : 0 ), 1 );
+
+    CreateAndSendMessage ( PROTMESSID_LISTENER_MODE, vecData );
+}
+
+bool CProtocol::EvaluateListenerModeMes ( const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 1 )
+    {
+        return true; // return error code
+    }
+
+    // state (1 byte)
+    const int iState =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( iState > 1 )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit ListenerModeReceived ( iState == 1 );
+
+    return false; // no error
+}
+
+void CProtocol::CreateMixGroupMes ( const int iMixGroup )
+{
+    CVector<uint8_t> vecData ( 1 ); // 1 byte of data
+    int              iPos = 0;      // init position pointer
+
+    // build data vector
+    // mix group (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iMixGroup ), 1 );
+
+    CreateAndSendMessage ( PROTMESSID_MIX_GROUP, vecData );
+}
+
+bool CProtocol::EvaluateMixGroupMes ( const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 1 )
+    {
+        return true; // return error code
+    }
+
+    // mix group (1 byte)
+    const int iMixGroup =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( iMixGroup > MAX_NUM_MIX_GROUPS )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit MixGroupReceived ( iMixGroup );
+
+    return false; // no error
+}
+
+void CProtocol::CreateMixGroupGainMes ( const int    iMixGroup,
+                                        const double dGain )
+{
+    CVector<uint8_t> vecData ( 3 ); // 3 bytes of data
+    int              iPos = 0;      // init position pointer
+
+    // build data vector
+    // mix group (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iMixGroup ), 1 );
+
+    // actual gain, we convert from double with range 0..1 to integer
+    const int iCurGain = static_cast<int> ( dGain * ( 1 << 15 ) );
+
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iCurGain ), 2 );
+
+    CreateAndSendMessage ( PROTMESSID_MIX_GROUP_GAIN, vecData );
+}
+
+bool CProtocol::EvaluateMixGroupGainMes ( const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 3 )
+    {
+        return true; // return error code
+    }
+
+    // mix group (1 byte)
+    const int iMixGroup =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( ( iMixGroup == NO_MIX_GROUP ) || ( iMixGroup > MAX_NUM_MIX_GROUPS ) )
+    {
+        return true; // return error code
+    }
+
+    // gain (read integer value)
+    const int iData = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    // we convert the gain from integer to double with range 0..1
+    const double dNewGain = static_cast<double> ( iData ) / ( 1 << 15 );
+
+    // invoke message action
+    emit ChangeMixGroupGain ( iMixGroup, dNewGain );
+
+    return false; // no error
+}
+
+void CProtocol::PrepareMixGroupListMes ( const CVector<int>& vecMixGroups,
+                                         CProtBroadcastMes&  Mes )
+{
+    int iPos        = 0; // init position pointer
+    int iNumEntries = 0;
+
+    // only the channels in a mix group are listed
+    for ( int i = 0; i < vecMixGroups.Size(); i++ )
+    {
+        if ( vecMixGroups[i] != NO_MIX_GROUP )
+        {
+            iNumEntries++;
+        }
+    }
+
+    Mes.iID = PROTMESSID_MIX_GROUP_LIST;
+    Mes.vecData.Init ( 2 * iNumEntries ); // 2 bytes of data per entry
+
+    // build data vector
+    for ( int i = 0; i < vecMixGroups.Size(); i++ )
+    {
+        if ( vecMixGroups[i] != NO_MIX_GROUP )
+        {
+            // channel ID (1 byte)
+            PutValOnStream ( Mes.vecData, iPos, static_cast<uint32_t> ( i ), 1 );
+
+            // mix group (1 byte)
+            PutValOnStream ( Mes.vecData, iPos, static_cast<uint32_t> ( vecMixGroups[i] ), 1 );
+        }
+    }
+}
+
+bool CProtocol::EvaluateMixGroupListMes ( const CVector<uint8_t>& vecData )
+{
+    int          iPos     = 0; // init position pointer
+    const int    iDataLen = vecData.Size();
+    CVector<int> vecMixGroups ( MAX_NUM_CHANNELS, NO_MIX_GROUP );
+
+    // check size (2 bytes per entry)
+    if ( ( iDataLen % 2 ) != 0 )
+    {
+        return true; // return error code
+    }
+
+    while ( iPos < iDataLen )
+    {
+        // channel ID (1 byte)
+        const int iChanID =
+            static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+        // mix group (1 byte)
+        const int iMixGroup =
+            static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+        if ( ( iChanID >= MAX_NUM_CHANNELS ) || ( iMixGroup > MAX_NUM_MIX_GROUPS ) )
+        {
+            return true; // return error code
+        }
+
+        vecMixGroups[iChanID] = iMixGroup;
+    }
+
+    // invoke message action
+    emit MixGroupListReceived ( vecMixGroups );
+
+    return false; // no error
+}
+
+void CProtocol::CreateMulticastGroupMes ( const int           iStream,
+                                          const CHostAddress& GroupAddr )
+{
+    CVector<uint8_t> vecData ( 17 ); // 17 bytes of data
+    int              iPos = 0;       // init position pointer
+
+    // build data vector
+    // stream (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iStream ), 1 );
+
+    // group address (16 bytes)
+    for ( int i = 0; i < 16; i++ )
+    {
+        PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( GroupAddr.Addr[i] ), 1 );
+    }
+
+    CreateAndSendMessage ( PROTMESSID_MULTICAST_GROUP, vecData );
+}
+
+bool CProtocol::EvaluateMulticastGroupMes ( const CVector<uint8_t>& vecData )
+{
+    int          iPos = 0; // init position pointer
+    CHostAddress GroupAddr;
+
+    // check size
+    if ( vecData.Size() != 17 )
+    {
+        return true; // return error code
+    }
+
+    // stream (1 byte)
+    const int iStream =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( ( iStream >= MAX_NUM_MULTICAST_STREAMS ) && ( iStream != NO_MULTICAST_STREAM ) )
+    {
+        return true; // return error code
+    }
+
+    // group address (16 bytes)
+    for ( int i = 0; i < 16; i++ )
+    {
+        GroupAddr.Addr[i] = static_cast<quint8> ( GetValFromStream ( vecData, iPos, 1 ) );
+    }
+
+    // invoke message action
+    emit MulticastGroupReceived ( iStream, GroupAddr );
+
+    return false; // no error
+}
+
+void CProtocol::CreateMulticastJoinedMes ( const int iStream )
+{
+    CVector<uint8_t> vecData ( 1 ); // 1 byte of data
+    int              iPos = 0;      // init position pointer
+
+    // build data vector
+    // stream (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iStream ), 1 );
+
+    CreateAndSendMessage ( PROTMESSID_MULTICAST_JOINED, vecData );
+}
+
+bool CProtocol::EvaluateMulticastJoinedMes ( const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 1 )
+    {
+        return true; // return error code
+    }
+
+    // stream (1 byte)
+    const int iStream =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( ( iStream >= MAX_NUM_MULTICAST_STREAMS ) && ( iStream != NO_MULTICAST_STREAM ) )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit MulticastJoinedReceived ( iStream );
+
+    return false; // no error
+}
+
+void CProtocol::CreateReqNetStatsMes()
+{
+    CreateAndSendMessage ( PROTMESSID_REQ_NET_STATS,
+                           CVector<uint8_t> ( 0 ) );
+}
+
+bool CProtocol::EvaluateReqNetStatsMes()
+{
+    // invoke message action
+    emit ReqNetStats();
+
+    return false; // no error
+}
+
+void CProtocol::CreateNetStatsMes ( const int iNumReceived,
+                                    const int iNumLost )
+{
+    CVector<uint8_t> vecData ( 8 ); // 8 bytes of data
+    int              iPos = 0;      // init position pointer
+
+    // build data vector
+    // received audio packets (4 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iNumReceived ), 4 );
+
+    // lost audio frames (4 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iNumLost ), 4 );
+
+    CreateAndSendMessage ( PROTMESSID_NET_STATS, vecData );
+}
+
+bool CProtocol::EvaluateNetStatsMes ( const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 8 )
+    {
+        return true; // return error code
+    }
+
+    // received audio packets (4 bytes)
+    const int iNumReceived =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
+
+    // lost audio frames (4 bytes)
+    const int iNumLost =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
+
+    // invoke message action
+    emit NetStatsReceived ( iNumReceived, iNumLost );
+
+    return false; // no error
+}
+
+
+// Connection less messages ----------------------------------------------------
+void CProtocol::CreateCLPingMes ( const CHostAddress& InetAddr, const int iMs )
+{
+    int iPos = 0; // init position pointer
+
+    // build data vector (4 bytes long)
+    CVector<uint8_t> vecData ( 4 );
+
+    // transmit time (4 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iMs ), 4 );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_PING_MS,
+                                     vecData,
+                                     InetAddr );
+}
+
+bool CProtocol::EvaluateCLPingMes ( const CHostAddress& InetAddr,
+                                    const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 4 )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit CLPingReceived ( InetAddr,
+                          static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) ) );
+
+    return false; // no error
+}
+
+void CProtocol::CreateCLPingWithNumClientsMes ( const CHostAddress& InetAddr,
+                                                const int           iMs,
+                                                const int           iNumClients )
+{
+    int iPos = 0; // init position pointer
+
+    // build data vector (5 bytes long)
+    CVector<uint8_t> vecData ( 5 );
+
+    // transmit time (4 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iMs ), 4 );
+
+    // current number of connected clients (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iNumClients ), 1 );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_PING_MS_WITHNUMCLIENTS,
+                                     vecData,
+                                     InetAddr );
+}
+
+bool CProtocol::EvaluateCLPingWithNumClientsMes ( const CHostAddress&     InetAddr,
+                                                  const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 5 )
+    {
+        return true; // return error code
+    }
+
+    // transmit time
+    const int iCurMs = static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
+
+    // current number of connected clients
+    const int iCurNumClients = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    // invoke message action
+    emit CLPingWithNumClientsReceived ( InetAddr, iCurMs, iCurNumClients );
+
+    return false; // no error
+}
+
+void CProtocol::CreateCLServerFullMes ( const CHostAddress& InetAddr )
+{
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SERVER_FULL,
+                                     CVector<uint8_t> ( 0 ),
+                                     InetAddr );
+}
+
+bool CProtocol::EvaluateCLServerFullMes()
+{
+    // invoke message action
+    emit ServerFullMesReceived();
+
+    return false; // no error
+}
+
+void CProtocol::CreateCLRegisterServerMes ( const CHostAddress&    InetAddr,
+                                            const CHostAddress&    LInetAddr,
+                                            const CServerCoreInfo& ServerInfo )
+{
+    int iPos = 0; // init position pointer
+
+    // convert server info strings to utf-8
+    const QByteArray strUTF8LInetAddr = LInetAddr.GetInetAddr().toString().toUtf8();
+    const QByteArray strUTF8Name      = ServerInfo.strName.toUtf8();
+    const QByteArray strUTF8City      = ServerInfo.strCity.toUtf8();
+
+    // size of current message body
+    const int iEntrLen =
+        2 /* server internal port number */ +
+        2 /* country */ +
+        1 /* maximum number of connected clients */ +
+        1 /* is permanent flag */ +
+        2 /* name utf-8 string size */ + strUTF8Name.size() +
+        2 /* server internal address utf-8 string size */ + strUTF8LInetAddr.size() +
+        2 /* city utf-8 string size */ + strUTF8City.size();
+
+    // build data vector
+    CVector<uint8_t> vecData ( iEntrLen );
+
+    // port number (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( LInetAddr.iPort ), 2 );
+
+    // country (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( ServerInfo.eCountry ), 2 );
+
+    // maximum number of connected clients (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( ServerInfo.iMaxNumClients ), 1 );
+
+    // "is permanent" flag (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( ServerInfo.bPermanentOnline ), 1 );
+
+    // name
+    PutStringUTF8OnStream ( vecData, iPos, strUTF8Name );
+
+    // server internal address (formerly unused topic)
+    PutStringUTF8OnStream ( vecData, iPos, strUTF8LInetAddr );
+
+    // city
+    PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REGISTER_SERVER,
+                                     vecData,
+                                     InetAddr );
+}
+
+bool CProtocol::EvaluateCLRegisterServerMes ( const CHostAddress&     InetAddr,
+                                              const CVector<uint8_t>& vecData )
+{
+    int             iPos     = 0; // init position pointer
+    const int       iDataLen = vecData.Size();
+    QString         sLocHost; // temp string for server internal address
+    CHostAddress    LInetAddr;
+    CServerCoreInfo RecServerInfo;
+
+    // check size (the first 6 bytes)
+    if ( iDataLen < 6 )
+    {
+        return true; // return error code
+    }
+
+    // port number (2 bytes)
+    LInetAddr.iPort = static_cast<quint16> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    // country (2 bytes)
+    RecServerInfo.eCountry = static_cast<QLocale::Country> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    // maximum number of connected clients (1 byte)
+    RecServerInfo.iMaxNumClients = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    // "is permanent" flag (1 byte)
+    RecServerInfo.bPermanentOnline = static_cast<bool> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    // server name
+    if ( GetStringFromStream ( vecData,
+                               iPos,
+                               MAX_LEN_SERVER_NAME,
+                               RecServerInfo.strName ) )
+    {
+        return true; // return error code
+    }
+
+    // server internal address
+    if ( GetStringFromStream ( vecData,
+                               iPos,
+                               MAX_LEN_IP_ADDRESS,
+                               sLocHost ) )
+    {
+        return true; // return error code
+    }
+
+    if ( sLocHost.isEmpty() )
+    {
+        // old server, empty "topic", register as local host
+        LInetAddr.SetInetAddr ( QHostAddress ( QHostAddress::LocalHost ) );
+    }
+    else
+    {
+        QHostAddress LocInetAddr;
+
+        if ( !LocInetAddr.setAddress ( sLocHost ) )
+        {
+            return true; // return error code
+        }
+
+        LInetAddr.SetInetAddr ( LocInetAddr );
+    }
+
+    // server city
+    if ( GetStringFromStream ( vecData,
+                               iPos,
+                               MAX_LEN_SERVER_CITY,
+                               RecServerInfo.strCity ) )
+    {
+        return true; // return error code
+    }
+
+    // check size: all data is read, the position must now be at the end
+    if ( iPos != iDataLen )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit CLRegisterServerReceived ( InetAddr, LInetAddr, RecServerInfo );
+
+    return false; // no error
+}
+
+void CProtocol::CreateCLUnregisterServerMes ( const CHostAddress& InetAddr )
+{
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_UNREGISTER_SERVER,
+                                     CVector<uint8_t> ( 0 ),
+                                     InetAddr );
+}
+
+bool CProtocol::EvaluateCLUnregisterServerMes ( const CHostAddress& InetAddr )
+{
+    // invoke message action
+    emit CLUnregisterServerReceived ( InetAddr );
+
+    return false; // no error
+}
+
+void CProtocol::CreateCLServerListMes ( const CHostAddress&        InetAddr,
+                                        const CVector<CServerInfo> vecServerInfo )
+{
+    CVector<uint8_t> vecMessage;
+
+    GenCLServerListMes ( vecServerInfo, vecMessage );
+
+    // immediately send message
+    emit CLMessReadyForSending ( InetAddr, CProtMessage::Adopt ( vecMessage ) );
+}
+
+void CProtocol::PutServerListEntries ( CVector<uint8_t>&           vecData,
+                                       int&                        iPos,
+                                       const CVector<CServerInfo>& vecServerInfo,
+                                       const bool                  bIPv6 )
+{
+    const int iAddrLen = bIPv6 ? 16 : 4;
+    const int iNumServers = vecServerInfo.Size();
+
+    for ( int i = 0; i < iNumServers; i++ )
+    {
+        // convert server list strings to utf-8
+        const QByteArray strUTF8Name  = vecServerInfo[i].strName.toUtf8();
+        const QByteArray strUTF8Empty = QString ( "" ).toUtf8();
+        const QByteArray strUTF8City  = vecServerInfo[i].strCity.toUtf8();
+
+        // size of current list entry
+        const int iCurListEntrLen =
+            iAddrLen /* IP address */ +
+            2 /* port number */ +
+            2 /* country */ +
+            1 /* maximum number of connected clients */ +
+            1 /* is permanent flag */ +
+            2 /* name utf-8 string size */ + strUTF8Name.size() +
+            2 /* empty string */ +
+            2 /* city utf-8 string size */ + strUTF8City.size();
+
+        // make space for new data
+        vecData.Enlarge ( iCurListEntrLen );
+
+        // IP address (4 or 16 bytes)
+        // note the Server List manager has put the internal details in HostAddr where required
+        if ( bIPv6 )
+        {
+            for ( int j = 0; j < 16; j++ )
+            {
+                PutValOnStream ( vecData, iPos, static_cast<uint32_t> (
+                    vecServerInfo[i].HostAddr.Addr[j] ), 1 );
+            }
+        }
+        else
+        {
+            PutValOnStream ( vecData, iPos, static_cast<uint32_t> (
+                vecServerInfo[i].HostAddr.GetIPv4Addr() ), 4 );
+        }
+
+        // port number (2 bytes)
+        // note the Server List manager has put the internal details in HostAddr where required
+        PutValOnStream ( vecData, iPos,
+            static_cast<uint32_t> ( vecServerInfo[i].HostAddr.iPort ), 2 );
+
+        // country (2 bytes)
+        PutValOnStream ( vecData, iPos,
+            static_cast<uint32_t> ( vecServerInfo[i].eCountry ), 2 );
+
+        // maximum number of connected clients (1 byte)
+        PutValOnStream ( vecData, iPos,
+            static_cast<uint32_t> ( vecServerInfo[i].iMaxNumClients ), 1 );
+
+        // "is permanent" flag (1 byte)
+        PutValOnStream ( vecData, iPos,
+            static_cast<uint32_t> ( vecServerInfo[i].bPermanentOnline ), 1 );
+
+        // name
+        PutStringUTF8OnStream ( vecData, iPos, strUTF8Name );
+
+        // empty string
+        PutStringUTF8OnStream ( vecData, iPos, strUTF8Empty );
+
+        // city
+        PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
+    }
+}
+
+int CProtocol::GetServerListEntrySize ( const CServerInfo& ServerInfo,
+                                        const bool         bIPv6 )
+{
+    // see PutServerListEntries()
+    return ( bIPv6 ? 16 : 4 ) /* IP address */ + 2 /* port number */ + 2 /* country */ +
+           1 /* maximum number of connected clients */ + 1 /* is permanent flag */ +
+           2 /* name utf-8 string size */ + ServerInfo.strName.toUtf8().size() +
+           2 /* empty string */ +
+           2 /* city utf-8 string size */ + ServerInfo.strCity.toUtf8().size();
+}
+
+void CProtocol::GenCLServerListMes ( const CVector<CServerInfo>& vecServerInfo,
+                                     CVector<uint8_t>&           vecMessage )
+{
+    // build data vector
+    CVector<uint8_t> vecData ( 0 );
+    int              iPos = 0; // init position pointer
+
+    PutServerListEntries ( vecData, iPos, vecServerInfo );
+
+    // build complete message (counter per definition=0 for connection less
+    // messages)
+    GenMessageFrame ( vecMessage, 0, PROTMESSID_CLM_SERVER_LIST, vecData );
+}
+
+bool CProtocol::GetServerListEntries ( const CVector<uint8_t>& vecData,
+                                       int&                    iPos,
+                                       CVector<CServerInfo>&   vecServerInfo,
+                                       const bool              bIPv6 )
+{
+    const int iDataLen = vecData.Size();
+    const int iAddrLen = bIPv6 ? 16 : 4;
+
+    while ( iPos < iDataLen )
+    {
+        // check size (the next 6 bytes plus the address)
+        if ( ( iDataLen - iPos ) < 6 + iAddrLen )
+        {
+            return true; // return error code
+        }
+
+        // IP address (4 or 16 bytes)
+        CHostAddress HostAddr;
+
+        if ( bIPv6 )
+        {
+            for ( int j = 0; j < 16; j++ )
+            {
+                HostAddr.Addr[j] = static_cast<quint8> ( GetValFromStream ( vecData, iPos, 1 ) );
+            }
+        }
+        else
+        {
+            HostAddr.SetIPv4Addr ( static_cast<quint32> ( GetValFromStream ( vecData, iPos, 4 ) ) );
+        }
+
+        // port number (2 bytes)
+        HostAddr.iPort = static_cast<quint16> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+        // country (2 bytes)
+        const QLocale::Country eCountry = static_cast<QLocale::Country> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+        // maximum number of connected clients (1 byte)
+        const int iMaxNumClients = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+        // "is permanent" flag (1 byte)
+        const bool bPermanentOnline = static_cast<bool> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+        // server name
+        QString strName;
+        if ( GetStringFromStream ( vecData,
+                                   iPos,
+                                   MAX_LEN_SERVER_NAME,
+                                   strName ) )
+        {
+            return true; // return error code
+        }
+
+        // empty
+        QString strEmpty;
+        if ( GetStringFromStream ( vecData,
+                                   iPos,
+                                   MAX_LEN_IP_ADDRESS,
+                                   strEmpty ) )
+        {
+            return true; // return error code
+        }
+
+        // server city
+        QString strCity;
+        if ( GetStringFromStream ( vecData,
+                                   iPos,
+                                   MAX_LEN_SERVER_CITY,
+                                   strCity ) )
+        {
+            return true; // return error code
+        }
+
+        // add server information to vector
+        vecServerInfo.Add (
+            CServerInfo ( HostAddr,
+                          HostAddr,
+                          strName,
+                          eCountry,
+                          strCity,
+                          iMaxNumClients,
+                          bPermanentOnline ) );
+    }
+
+    return false; // no error
+}
 
-    // name
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_FADER_TAG,
-                               ChanInfo.strName ) )
-    {
-        return true; // return error code
-    }
+bool CProtocol::EvaluateCLServerListMes ( const CHostAddress&     InetAddr,
+                                          const CVector<uint8_t>& vecData )
+{
+    int                  iPos     = 0; // init position pointer
+    const int            iDataLen = vecData.Size();
+    CVector<CServerInfo> vecServerInfo ( 0 );
 
-    // city
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_SERVER_CITY,
-                               ChanInfo.strCity ) )
+    if ( GetServerListEntries ( vecData, iPos, vecServerInfo ) )
     {
         return true; // return error code
     }
@@ -1210,398 +3909,358 @@ bool CProtocol::EvaluateChanInfoMes ( const CVector<uint8_t>& vecData )
     }
 
     // invoke message action
-    emit ChangeChanInfo ( ChanInfo );
+    emit CLServerListReceived ( InetAddr, vecServerInfo );
 
     return false; // no error
 }
 
-void CProtocol::CreateReqChanInfoMes()
+void CProtocol::CreateCLReqServerListMes ( const CHostAddress& InetAddr )
 {
-    CreateAndSendMessage ( PROTMESSID_REQ_CHANNEL_INFOS, CVector<uint8_t> ( 0 ) );
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REQ_SERVER_LIST,
+                                     CVector<uint8_t> ( 0 ),
+                                     InetAddr );
 }
 
-bool CProtocol::EvaluateReqChanInfoMes()
+bool CProtocol::EvaluateCLReqServerListMes ( const CHostAddress& InetAddr )
 {
     // invoke message action
-    emit ReqChanInfo();
+    emit CLReqServerList ( InetAddr );
 
     return false; // no error
 }
 
-void CProtocol::CreateChatTextMes ( const QString strChatText )
+void CProtocol::CreateCLSendEmptyMesMes ( const CHostAddress& InetAddr,
+                                          const CHostAddress& TargetInetAddr )
 {
     int iPos = 0; // init position pointer
 
-    // convert chat text string to utf-8
-    const QByteArray strUTF8ChatText = strChatText.toUtf8();
-
-    const int iStrUTF8Len = strUTF8ChatText.size(); // get utf-8 string size
-
-    // size of message body
-    const int iEntrLen = 2 /* utf-8 string size */ + iStrUTF8Len;
+    // build data vector (6 bytes long)
+    CVector<uint8_t> vecData ( 6 );
 
-    // build data vector
-    CVector<uint8_t> vecData ( iEntrLen );
+    // IP address (4 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> (
+        TargetInetAddr.GetIPv4Addr() ), 4 );
 
-    // chat text
-    PutStringUTF8OnStream ( vecData, iPos, strUTF8ChatText );
+    // port number (2 bytes)
+    PutValOnStream ( vecData, iPos,
+        static_cast<uint32_t> ( TargetInetAddr.iPort ), 2 );
 
-    CreateAndSendMessage ( PROTMESSID_CHAT_TEXT, vecData );
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SEND_EMPTY_MESSAGE,
+                                     vecData,
+                                     InetAddr );
 }
 
-bool CProtocol::EvaluateChatTextMes ( const CVector<uint8_t>& vecData )
+bool CProtocol::EvaluateCLSendEmptyMesMes ( const CVector<uint8_t>& vecData )
 {
     int iPos = 0; // init position pointer
 
-    // chat text
-    QString strChatText;
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_CHAT_TEXT_PLUS_HTML,
-                               strChatText ) )
+    // check size
+    if ( vecData.Size() != 6 )
     {
         return true; // return error code
     }
 
-    // check size: all data is read, the position must now be at the end
-    if ( iPos != vecData.Size() )
-    {
-        return true; // return error code
-    }
+    // IP address (4 bytes)
+    const quint32 iIpAddr = static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
+
+    // port number (2 bytes)
+    const quint16 iPort = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
 
     // invoke message action
-    emit ChatTextReceived ( strChatText );
+    emit CLSendEmptyMes ( CHostAddress ( QHostAddress ( iIpAddr ), iPort ) );
 
     return false; // no error
 }
 
-void CProtocol::CreateNetwTranspPropsMes ( const CNetworkTransportProps& NetTrProps )
+void CProtocol::CreateCLSendEmptyMesListMes ( const CHostAddress&          InetAddr,
+                                              const CVector<CHostAddress>& vecTargetInetAddr )
 {
-    int iPos = 0; // init position pointer
-
-    // size of current message body
-    const int iEntrLen =
-        4 /* netw size */ +
-        2 /* block size fact */ +
-        1 /* num chan */ +
-        4 /* sam rate */ +
-        2 /* audiocod type */ +
-        2 /* version */ +
-        4 /* audiocod arg */;
-
-    // build data vector
-    CVector<uint8_t> vecData ( iEntrLen );
-
-    // length of the base network packet (frame) in bytes (4 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iBaseNetworkPacketSize ), 4 );
-
-    // block size factor (2 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iBlockSizeFact ), 2 );
-
-    // number of channels of the audio signal, e.g. "2" is stereo (1 byte)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iNumAudioChannels ), 1 );
-
-    // sample rate of the audio stream (4 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iSampleRate ), 4 );
+    const int iNumAddr = vecTargetInetAddr.Size();
+    int       iPos     = 0; // init position pointer
 
-    // audio coding type (2 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.eAudioCodingType ), 2 );
+    // build data vector (6 bytes per address)
+    CVector<uint8_t> vecData ( 6 * iNumAddr );
 
-    // version (2 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iVersion ), 2 );
+    for ( int i = 0; i < iNumAddr; i++ )
+    {
+        // IP address (4 bytes)
+        PutValOnStream ( vecData, iPos, static_cast<uint32_t> (
+            vecTargetInetAddr[i].GetIPv4Addr() ), 4 );
 
-    // argument for the audio coder (4 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iAudioCodingArg ), 4 );
+        // port number (2 bytes)
+        PutValOnStream ( vecData, iPos,
+            static_cast<uint32_t> ( vecTargetInetAddr[i].iPort ), 2 );
+    }
 
-    CreateAndSendMessage ( PROTMESSID_NETW_TRANSPORT_PROPS, vecData );
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SEND_EMPTY_MES_LIST,
+                                     vecData,
+                                     InetAddr );
 }
 
-bool CProtocol::EvaluateNetwTranspPropsMes ( const CVector<uint8_t>& vecData )
+bool CProtocol::EvaluateCLSendEmptyMesListMes ( const CVector<uint8_t>& vecData )
 {
-    int                    iPos = 0; // init position pointer
-    CNetworkTransportProps ReceivedNetwTranspProps;
-
-    // size of current message body
-    const int iEntrLen =
-        4 /* netw size */ +
-        2 /* block size fact */ +
-        1 /* num chan */ +
-        4 /* sam rate */ +
-        2 /* audiocod type */ +
-        2 /* version */ +
-        4 /* audiocod arg */;
+    int       iPos     = 0; // init position pointer
+    const int iDataLen = vecData.Size();
 
     // check size
-    if ( vecData.Size() != iEntrLen )
+    if ( ( iDataLen % 6 ) != 0 )
     {
         return true; // return error code
     }
 
-    // length of the base network packet (frame) in bytes (4 bytes)
-    ReceivedNetwTranspProps.iBaseNetworkPacketSize =
-        static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 4 ) );
-
-    // at least CELT_MINIMUM_NUM_BYTES bytes are required for the CELC codec
-    if ( ( ReceivedNetwTranspProps.iBaseNetworkPacketSize < CELT_MINIMUM_NUM_BYTES ) ||
-         ( ReceivedNetwTranspProps.iBaseNetworkPacketSize > MAX_SIZE_BYTES_NETW_BUF ) )
+    while ( iPos < iDataLen )
     {
-        return true; // return error code
-    }
+        // IP address (4 bytes)
+        const quint32 iIpAddr = static_cast<quint32> ( GetValFromStream ( vecData, iPos, 4 ) );
 
-    // block size factor (2 bytes)
-    ReceivedNetwTranspProps.iBlockSizeFact =
-        static_cast<uint16_t> ( GetValFromStream ( vecData, iPos, 2 ) );
+        // port number (2 bytes)
+        const quint16 iPort = static_cast<quint16> ( GetValFromStream ( vecData, iPos, 2 ) );
 
-    if ( ( ReceivedNetwTranspProps.iBlockSizeFact != FRAME_SIZE_FACTOR_PREFERRED ) &&
-         ( ReceivedNetwTranspProps.iBlockSizeFact != FRAME_SIZE_FACTOR_DEFAULT ) &&
-         ( ReceivedNetwTranspProps.iBlockSizeFact != FRAME_SIZE_FACTOR_SAFE ) )
-    {
-        return true; // return error code
+        // invoke message action
+        emit CLSendEmptyMes ( CHostAddress ( QHostAddress ( iIpAddr ), iPort ) );
     }
 
-    // number of channels of the audio signal, only mono (1 channel) or
-    // stereo (2 channels) allowed (1 byte)
-    ReceivedNetwTranspProps.iNumAudioChannels =
-        static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 1 ) );
+    return false; // no error
+}
 
-    if ( ( ReceivedNetwTranspProps.iNumAudioChannels != 1 ) &&
-         ( ReceivedNetwTranspProps.iNumAudioChannels != 2 ) )
-    {
-        return true; // return error code
-    }
+void CProtocol::CreateCLServerFeaturesMes ( const CHostAddress& InetAddr,
+                                            const uint32_t      iFeatures )
+{
+    int iPos = 0; // init position pointer
 
-    // sample rate of the audio stream (4 bytes)
-    ReceivedNetwTranspProps.iSampleRate =
-        static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 4 ) );
+    // build data vector (4 bytes long)
+    CVector<uint8_t> vecData ( 4 );
 
-    // audio coding type (2 bytes) with error check
-    const int iRecCodingType =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+    // feature flags (4 bytes)
+    PutValOnStream ( vecData, iPos, iFeatures, 4 );
 
-    // note that CT_NONE is not a valid setting but only used for server
-    // initialization
-    if ( ( iRecCodingType != CT_CELT ) &&
-         ( iRecCodingType != CT_OPUS ) &&
-         ( iRecCodingType != CT_OPUS64 ) )
-    {
-        return true;
-    }
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SERVER_FEATURES,
+                                     vecData,
+                                     InetAddr );
+}
 
-    ReceivedNetwTranspProps.eAudioCodingType =
-        static_cast<EAudComprType> ( iRecCodingType );
+bool CProtocol::EvaluateCLServerFeaturesMes ( const CHostAddress&     InetAddr,
+                                              const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
 
-    // version (2 bytes)
-    ReceivedNetwTranspProps.iVersion =
-        static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 2 ) );
+    // check size
+    if ( vecData.Size() != 4 )
+    {
+        return true; // return error code
+    }
 
-    // argument for the audio coder (4 bytes)
-    ReceivedNetwTranspProps.iAudioCodingArg =
-        static_cast<int32_t> ( GetValFromStream ( vecData, iPos, 4 ) );
+    // feature flags (4 bytes)
+    const uint32_t iFeatures = GetValFromStream ( vecData, iPos, 4 );
 
     // invoke message action
-    emit NetTranspPropsReceived ( ReceivedNetwTranspProps );
+    emit CLServerFeaturesReceived ( InetAddr, iFeatures );
 
     return false; // no error
 }
 
-void CProtocol::CreateReqNetwTranspPropsMes()
+void CProtocol::CreateCLFederationUpdateMes ( const CHostAddress&                   InetAddr,
+                                              const CVector<CFederationServerInfo>& vecServerInfo )
 {
-    CreateAndSendMessage ( PROTMESSID_REQ_NETW_TRANSPORT_PROPS,
-                           CVector<uint8_t> ( 0 ) );
-}
+    const int iNumServers = vecServerInfo.Size();
 
-bool CProtocol::EvaluateReqNetwTranspPropsMes()
-{
-    // invoke message action
-    emit ReqNetTranspProps();
+    // build data vector
+    CVector<uint8_t> vecData ( 0 );
+    int              iPos = 0; // init position pointer
 
-    return false; // no error
-}
+    for ( int i = 0; i < iNumServers; i++ )
+    {
+        // convert server info strings to utf-8
+        const QByteArray strUTF8Name = vecServerInfo[i].strName.toUtf8();
+        const QByteArray strUTF8City = vecServerInfo[i].strCity.toUtf8();
 
-void CProtocol::CreateLicenceRequiredMes ( const ELicenceType eLicenceType )
-{
-    CVector<uint8_t> vecData ( 1 ); // 1 bytes of data
-    int              iPos = 0;      // init position pointer
+        // size of current list entry
+        const int iCurListEntrLen =
+            1 /* flags */ +
+            4 /* IP address */ +
+            2 /* port number */ +
+            4 /* feature flags */ +
+            4 /* internal IP address */ +
+            2 /* internal port number */ +
+            2 /* country */ +
+            1 /* maximum number of connected clients */ +
+            1 /* is permanent flag */ +
+            2 /* name utf-8 string size */ + strUTF8Name.size() +
+            2 /* city utf-8 string size */ + strUTF8City.size();
 
-    // build data vector
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( eLicenceType ), 1 );
+        // make space for new data
+        vecData.Enlarge ( iCurListEntrLen );
 
-    CreateAndSendMessage ( PROTMESSID_LICENCE_REQUIRED, vecData );
-}
+        // flags (1 byte)
+        PutValOnStream ( vecData, iPos,
+            static_cast<uint32_t> ( vecServerInfo[i].bRemove ), 1 );
 
-bool CProtocol::EvaluateLicenceRequiredMes ( const CVector<uint8_t>& vecData )
-{
-    int iPos = 0; // init position pointer
+        // IP address (4 bytes)
+        PutValOnStream ( vecData, iPos, static_cast<uint32_t> (
+            vecServerInfo[i].HostAddr.GetIPv4Addr() ), 4 );
+
+        // port number (2 bytes)
+        PutValOnStream ( vecData, iPos,
+            static_cast<uint32_t> ( vecServerInfo[i].HostAddr.iPort ), 2 );
 
-    // check size
-    if ( vecData.Size() != 1 )
-    {
-        return true; // return error code
-    }
+        // feature flags (4 bytes)
+        PutValOnStream ( vecData, iPos, vecServerInfo[i].iFeatures, 4 );
 
-    // extract licence type
-    const ELicenceType eLicenceType =
-        static_cast<ELicenceType> ( GetValFromStream ( vecData, iPos, 1 ) );
+        // internal IP address (4 bytes)
+        PutValOnStream ( vecData, iPos, static_cast<uint32_t> (
+            vecServerInfo[i].LHostAddr.GetIPv4Addr() ), 4 );
 
-    if ( ( eLicenceType != LT_CREATIVECOMMONS ) &&
-         ( eLicenceType != LT_NO_LICENCE ) )
-    {
-        return true; // return error code
-    }
+        // internal port number (2 bytes)
+        PutValOnStream ( vecData, iPos,
+            static_cast<uint32_t> ( vecServerInfo[i].LHostAddr.iPort ), 2 );
 
-    // invoke message action
-    emit LicenceRequired ( eLicenceType );
+        // country (2 bytes)
+        PutValOnStream ( vecData, iPos,
+            static_cast<uint32_t> ( vecServerInfo[i].eCountry ), 2 );
 
-    return false; // no error
-}
+        // maximum number of connected clients (1 byte)
+        PutValOnStream ( vecData, iPos,
+            static_cast<uint32_t> ( vecServerInfo[i].iMaxNumClients ), 1 );
 
-void CProtocol::CreateOpusSupportedMes()
-{
-    CreateAndSendMessage ( PROTMESSID_OPUS_SUPPORTED, CVector<uint8_t> ( 0 ) );
-}
+        // "is permanent" flag (1 byte)
+        PutValOnStream ( vecData, iPos,
+            static_cast<uint32_t> ( vecServerInfo[i].bPermanentOnline ), 1 );
 
-void CProtocol::CreateReqChannelLevelListMes ( const bool bRCL )
-{
-    CVector<uint8_t> vecData ( 1 ); // 1 byte of data
-    int              iPos = 0; // init position pointer
-    PutValOnStream ( vecData, iPos,
-        static_cast<uint32_t> ( bRCL ), 1 );
+        // name
+        PutStringUTF8OnStream ( vecData, iPos, strUTF8Name );
 
-    CreateAndSendMessage ( PROTMESSID_REQ_CHANNEL_LEVEL_LIST, vecData );
+        // city
+        PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
+    }
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_FEDERATION_UPDATE,
+                                     vecData,
+                                     InetAddr );
 }
 
-bool CProtocol::EvaluateReqChannelLevelListMes ( const CVector<uint8_t>& vecData )
+bool CProtocol::EvaluateCLFederationUpdateMes ( const CHostAddress&     InetAddr,
+                                                const CVector<uint8_t>& vecData )
 {
-    int iPos = 0; // init position pointer
+    int                            iPos     = 0; // init position pointer
+    const int                      iDataLen = vecData.Size();
+    CVector<CFederationServerInfo> vecServerInfo ( 0 );
 
-    // check size
-    if ( vecData.Size() != 1 )
+    while ( iPos < iDataLen )
     {
-        return true; // return error code
-    }
+        // check size (the next 21 bytes)
+        if ( iDataLen - iPos < 21 )
+        {
+            return true; // return error code
+        }
 
-    // extract opt in / out for channel levels
-    uint32_t val = GetValFromStream ( vecData, iPos, 1 );
+        CFederationServerInfo ServerInfo;
 
-    if ( val != 0 && val != 1 )
-    {
-        return true; // return error code
-    }
+        // flags (1 byte)
+        ServerInfo.bRemove = ( GetValFromStream ( vecData, iPos, 1 ) & 1 ) != 0;
 
-    // invoke message action
-    emit ReqChannelLevelList ( static_cast<bool> ( val ) );
+        // IP address (4 bytes)
+        const quint32 iIpAddr = static_cast<quint32> ( GetValFromStream ( vecData, iPos, 4 ) );
 
-    return false; // no error
-}
+        // port number (2 bytes)
+        const quint16 iPort = static_cast<quint16> ( GetValFromStream ( vecData, iPos, 2 ) );
 
-void CProtocol::CreateVersionAndOSMes()
-{
-    int iPos = 0; // init position pointer
+        ServerInfo.HostAddr = CHostAddress ( QHostAddress ( iIpAddr ), iPort );
 
-    // get the version number string
-    const QString strVerion = VERSION;
+        // feature flags (4 bytes)
+        ServerInfo.iFeatures = GetValFromStream ( vecData, iPos, 4 );
 
-    // convert version string to utf-8
-    const QByteArray strUTF8Version = strVerion.toUtf8();
+        // internal IP address (4 bytes)
+        const quint32 iLIpAddr = static_cast<quint32> ( GetValFromStream ( vecData, iPos, 4 ) );
 
-    // size of current message body
-    const int iEntrLen =
-        1 /* operating system */ +
-        2 /* version utf-8 string size */ + strUTF8Version.size();
+        // internal port number (2 bytes)
+        const quint16 iLPort = static_cast<quint16> ( GetValFromStream ( vecData, iPos, 2 ) );
 
-    // build data vector
-    CVector<uint8_t> vecData ( iEntrLen );
+        ServerInfo.LHostAddr = CHostAddress ( QHostAddress ( iLIpAddr ), iLPort );
 
-    // operating system (1 byte)
-    PutValOnStream ( vecData, iPos,
-        static_cast<uint32_t> ( COSUtil::GetOperatingSystem() ), 1 );
+        // country (2 bytes)
+        ServerInfo.eCountry = static_cast<QLocale::Country> ( GetValFromStream ( vecData, iPos, 2 ) );
 
-    // version
-    PutStringUTF8OnStream ( vecData, iPos, strUTF8Version );
+        // maximum number of connected clients (1 byte)
+        ServerInfo.iMaxNumClients = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
 
-    CreateAndSendMessage ( PROTMESSID_VERSION_AND_OS, vecData );
-}
+        // "is permanent" flag (1 byte)
+        ServerInfo.bPermanentOnline = static_cast<bool> ( GetValFromStream ( vecData, iPos, 1 ) );
 
-bool CProtocol::EvaluateVersionAndOSMes ( const CVector<uint8_t>& vecData )
-{
-    int       iPos = 0; // init position pointer
-    const int iDataLen = vecData.Size();
+        // server name
+        if ( GetStringFromStream ( vecData,
+                                   iPos,
+                                   MAX_LEN_SERVER_NAME,
+                                   ServerInfo.strName ) )
+        {
+            return true; // return error code
+        }
 
-    // check size (the first 1 byte)
-    if ( iDataLen < 1 )
-    {
-        return true; // return error code
+        // server city
+        if ( GetStringFromStream ( vecData,
+                                   iPos,
+                                   MAX_LEN_SERVER_CITY,
+                                   ServerInfo.strCity ) )
+        {
+            return true; // return error code
+        }
+
+        vecServerInfo.Add ( ServerInfo );
     }
 
-    // operating system (1 byte)
-    const COSUtil::EOpSystemType eOSType =
-        static_cast<COSUtil::EOpSystemType> ( GetValFromStream ( vecData, iPos, 1 ) );
+    // invoke message action
+    emit CLFederationUpdateReceived ( InetAddr, vecServerInfo );
 
-    // version text
-    QString strVersion;
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_VERSION_TEXT,
-                               strVersion ) )
-    {
-        return true; // return error code
-    }
+    return false; // no error
+}
 
-    // check size: all data is read, the position must now be at the end
-    if ( iPos != iDataLen )
-    {
-        return true; // return error code
-    }
+void CProtocol::CreateCLReqFederationSyncMes ( const CHostAddress& InetAddr )
+{
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REQ_FEDERATION_SYNC,
+                                     CVector<uint8_t> ( 0 ),
+                                     InetAddr );
+}
 
+bool CProtocol::EvaluateCLReqFederationSyncMes ( const CHostAddress& InetAddr )
+{
     // invoke message action
-    emit VersionAndOSReceived ( eOSType, strVersion );
+    emit CLReqFederationSync ( InetAddr );
 
     return false; // no error
 }
 
-void CProtocol::CreateRecorderStateMes ( const ERecorderState eRecorderState )
+void CProtocol::CreateCLRttProbeMes ( const CHostAddress& InetAddr, const int iMs )
 {
-    CVector<uint8_t> vecData ( 1 ); // 1 byte of data
-    int              iPos = 0;      // init position pointer
+    int iPos = 0; // init position pointer
 
-    // build data vector
-    // server jam recorder state (1 byte)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( eRecorderState ), 1 );
+    // build data vector (4 bytes long)
+    CVector<uint8_t> vecData ( 4 );
 
-    CreateAndSendMessage ( PROTMESSID_RECORDER_STATE, vecData );
+    // transmit time (4 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iMs ), 4 );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_RTT_PROBE,
+                                     vecData,
+                                     InetAddr );
 }
 
-bool CProtocol::EvaluateRecorderStateMes(const CVector<uint8_t>& vecData)
+bool CProtocol::EvaluateCLRttProbeMes ( const CHostAddress&     InetAddr,
+                                        const CVector<uint8_t>& vecData )
 {
     int iPos = 0; // init position pointer
 
     // check size
-    if ( vecData.Size() != 1 )
+    if ( vecData.Size() != 4 )
     {
         return true; // return error code
     }
 
-    // server jam recorder state (1 byte)
-    const int iRecorderState =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
-
-    // note that RS_UNDEFINED is only internally used
-    if ( ( iRecorderState != RS_NOT_INITIALISED ) &&
-         ( iRecorderState != RS_NOT_ENABLED ) &&
-         ( iRecorderState != RS_RECORDING ) )
-    {
-        return true;
-    }
-
     // invoke message action
-    emit RecorderStateReceived ( static_cast<ERecorderState> ( iRecorderState ) );
+    emit CLRttProbeReceived ( InetAddr, static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) ) );
 
     return false; // no error
 }
 
-
-// Connection less messages ----------------------------------------------------
-void CProtocol::CreateCLPingMes ( const CHostAddress& InetAddr, const int iMs )
+void CProtocol::CreateCLRttProbeEchoMes ( const CHostAddress& InetAddr, const int iMs )
 {
     int iPos = 0; // init position pointer
 
@@ -1611,13 +4270,13 @@ void CProtocol::CreateCLPingMes ( const CHostAddress& InetAddr, const int iMs )
     // transmit time (4 bytes)
     PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iMs ), 4 );
 
-    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_PING_MS,
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_RTT_PROBE_ECHO,
                                      vecData,
                                      InetAddr );
 }
 
-bool CProtocol::EvaluateCLPingMes ( const CHostAddress& InetAddr,
-                                    const CVector<uint8_t>& vecData )
+bool CProtocol::EvaluateCLRttProbeEchoMes ( const CHostAddress&     InetAddr,
+                                            const CVector<uint8_t>& vecData )
 {
     int iPos = 0; // init position pointer
 
@@ -1628,180 +4287,149 @@ bool CProtocol::EvaluateCLPingMes ( const CHostAddress& InetAddr,
     }
 
     // invoke message action
-    emit CLPingReceived ( InetAddr,
-                          static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) ) );
+    emit CLRttProbeEchoReceived ( InetAddr, static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) ) );
 
     return false; // no error
 }
 
-void CProtocol::CreateCLPingWithNumClientsMes ( const CHostAddress& InetAddr,
-                                                const int           iMs,
-                                                const int           iNumClients )
+void CProtocol::CreateCLReqLatencyProbeMes ( const CHostAddress& InetAddr, const int iMs )
 {
     int iPos = 0; // init position pointer
 
-    // build data vector (5 bytes long)
-    CVector<uint8_t> vecData ( 5 );
+    // build data vector (4 bytes long)
+    CVector<uint8_t> vecData ( 4 );
 
     // transmit time (4 bytes)
     PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iMs ), 4 );
 
-    // current number of connected clients (1 byte)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iNumClients ), 1 );
-
-    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_PING_MS_WITHNUMCLIENTS,
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REQ_LATENCY_PROBE,
                                      vecData,
                                      InetAddr );
 }
 
-bool CProtocol::EvaluateCLPingWithNumClientsMes ( const CHostAddress&     InetAddr,
-                                                  const CVector<uint8_t>& vecData )
+bool CProtocol::EvaluateCLReqLatencyProbeMes ( const CHostAddress&     InetAddr,
+                                               const CVector<uint8_t>& vecData )
 {
     int iPos = 0; // init position pointer
 
     // check size
-    if ( vecData.Size() != 5 )
+    if ( vecData.Size() != 4 )
     {
         return true; // return error code
     }
 
-    // transmit time
-    const int iCurMs = static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
-
-    // current number of connected clients
-    const int iCurNumClients = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
-
-    // invoke message action
-    emit CLPingWithNumClientsReceived ( InetAddr, iCurMs, iCurNumClients );
-
-    return false; // no error
-}
-
-void CProtocol::CreateCLServerFullMes ( const CHostAddress& InetAddr )
-{
-    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SERVER_FULL,
-                                     CVector<uint8_t> ( 0 ),
-                                     InetAddr );
-}
-
-bool CProtocol::EvaluateCLServerFullMes()
-{
     // invoke message action
-    emit ServerFullMesReceived();
+    emit CLReqLatencyProbe ( InetAddr, static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) ) );
 
     return false; // no error
 }
 
-void CProtocol::CreateCLRegisterServerMes ( const CHostAddress&    InetAddr,
-                                            const CHostAddress&    LInetAddr,
-                                            const CServerCoreInfo& ServerInfo )
+void CProtocol::CreateCLLatencyProbeMes ( const CHostAddress&       InetAddr,
+                                          const CServerLatencyInfo& LatencyInfo )
 {
     int iPos = 0; // init position pointer
 
-    // convert server info strings to utf-8
-    const QByteArray strUTF8LInetAddr = LInetAddr.InetAddr.toString().toUtf8();
-    const QByteArray strUTF8Name      = ServerInfo.strName.toUtf8();
-    const QByteArray strUTF8City      = ServerInfo.strCity.toUtf8();
-
-    // size of current message body
-    const int iEntrLen =
-        2 /* server internal port number */ +
-        2 /* country */ +
-        1 /* maximum number of connected clients */ +
-        1 /* is permanent flag */ +
-        2 /* name utf-8 string size */ + strUTF8Name.size() +
-        2 /* server internal address utf-8 string size */ + strUTF8LInetAddr.size() +
-        2 /* city utf-8 string size */ + strUTF8City.size();
-
-    // build data vector
-    CVector<uint8_t> vecData ( iEntrLen );
-
-    // port number (2 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( LInetAddr.iPort ), 2 );
-
-    // country (2 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( ServerInfo.eCountry ), 2 );
-
-    // maximum number of connected clients (1 byte)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( ServerInfo.iMaxNumClients ), 1 );
+    // build data vector (12 bytes long)
+    CVector<uint8_t> vecData ( 12 );
 
-    // "is permanent" flag (1 byte)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( ServerInfo.bPermanentOnline ), 1 );
-
-    // name
-    PutStringUTF8OnStream ( vecData, iPos, strUTF8Name );
+    // transmit time (4 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( LatencyInfo.iTransmitTimeMs ), 4 );
 
-    // server internal address (formerly unused topic)
-    PutStringUTF8OnStream ( vecData, iPos, strUTF8LInetAddr );
+    // queue delay (4 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( LatencyInfo.iQueueDelayUs ), 4 );
 
-    // city
-    PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
+    // mix time (4 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( LatencyInfo.iMixTimeUs ), 4 );
 
-    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REGISTER_SERVER,
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_LATENCY_PROBE,
                                      vecData,
                                      InetAddr );
 }
 
-bool CProtocol::EvaluateCLRegisterServerMes ( const CHostAddress&     InetAddr,
-                                              const CVector<uint8_t>& vecData )
+bool CProtocol::EvaluateCLLatencyProbeMes ( const CHostAddress&     InetAddr,
+                                            const CVector<uint8_t>& vecData )
 {
-    int             iPos     = 0; // init position pointer
-    const int       iDataLen = vecData.Size();
-    QString         sLocHost; // temp string for server internal address
-    CHostAddress    LInetAddr;
-    CServerCoreInfo RecServerInfo;
+    int                iPos = 0; // init position pointer
+    CServerLatencyInfo LatencyInfo;
 
-    // check size (the first 6 bytes)
-    if ( iDataLen < 6 )
+    // check size
+    if ( vecData.Size() != 12 )
     {
         return true; // return error code
     }
 
-    // port number (2 bytes)
-    LInetAddr.iPort = static_cast<quint16> ( GetValFromStream ( vecData, iPos, 2 ) );
+    // transmit time (4 bytes)
+    LatencyInfo.iTransmitTimeMs = static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
 
-    // country (2 bytes)
-    RecServerInfo.eCountry = static_cast<QLocale::Country> ( GetValFromStream ( vecData, iPos, 2 ) );
+    // queue delay (4 bytes)
+    LatencyInfo.iQueueDelayUs = static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
 
-    // maximum number of connected clients (1 byte)
-    RecServerInfo.iMaxNumClients = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+    // mix time (4 bytes)
+    LatencyInfo.iMixTimeUs = static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
 
-    // "is permanent" flag (1 byte)
-    RecServerInfo.bPermanentOnline = static_cast<bool> ( GetValFromStream ( vecData, iPos, 1 ) );
+    // invoke message action
+    emit CLLatencyProbeReceived ( InetAddr, LatencyInfo );
 
-    // server name
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_SERVER_NAME,
-                               RecServerInfo.strName ) )
-    {
-        return true; // return error code
-    }
+    return false; // no error
+}
 
-    // server internal address
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_IP_ADDRESS,
-                               sLocHost ) )
-    {
-        return true; // return error code
-    }
+void CProtocol::CreateCLServerLoadMes ( const CHostAddress& InetAddr,
+                                        const QString&      strPool,
+                                        const int           iNumClients,
+                                        const int           iLoadPct )
+{
+    int iPos = 0; // init position pointer
 
-    if ( sLocHost.isEmpty() )
-    {
-        // old server, empty "topic", register as local host
-        LInetAddr.InetAddr.setAddress ( QHostAddress::LocalHost );
-    }
-    else if ( !LInetAddr.InetAddr.setAddress ( sLocHost ) )
+    // convert pool name string to utf-8
+    const QByteArray strUTF8Pool = strPool.toUtf8();
+
+    // size of current message body
+    const int iEntrLen =
+        1 /* number of connected clients */ +
+        1 /* load */ +
+        2 /* pool name utf-8 string size */ + strUTF8Pool.size();
+
+    // build data vector
+    CVector<uint8_t> vecData ( iEntrLen );
+
+    // number of connected clients (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iNumClients ), 1 );
+
+    // load (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iLoadPct ), 1 );
+
+    // pool name
+    PutStringUTF8OnStream ( vecData, iPos, strUTF8Pool );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SERVER_LOAD,
+                                     vecData,
+                                     InetAddr );
+}
+
+bool CProtocol::EvaluateCLServerLoadMes ( const CHostAddress&     InetAddr,
+                                          const CVector<uint8_t>& vecData )
+{
+    int       iPos     = 0; // init position pointer
+    const int iDataLen = vecData.Size();
+
+    // check size (the first two values)
+    if ( iDataLen < 2 )
     {
         return true; // return error code
     }
 
-    // server city
+    // number of connected clients (1 byte)
+    const int iNumClients = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    // load (1 byte)
+    const int iLoadPct = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    // pool name
+    QString strPool;
     if ( GetStringFromStream ( vecData,
                                iPos,
-                               MAX_LEN_SERVER_CITY,
-                               RecServerInfo.strCity ) )
+                               MAX_LEN_SERVER_NAME,
+                               strPool ) )
     {
         return true; // return error code
     }
@@ -1813,230 +4441,196 @@ bool CProtocol::EvaluateCLRegisterServerMes ( const CHostAddress&     InetAddr,
     }
 
     // invoke message action
-    emit CLRegisterServerReceived ( InetAddr, LInetAddr, RecServerInfo );
+    emit CLServerLoadReceived ( InetAddr, strPool, iNumClients, iLoadPct );
 
     return false; // no error
 }
 
-void CProtocol::CreateCLUnregisterServerMes ( const CHostAddress& InetAddr )
+void CProtocol::CreateCLReqServerListPageMes ( const CHostAddress&      InetAddr,
+                                               const CServerListFilter& Filter,
+                                               const int                iPage )
 {
-    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_UNREGISTER_SERVER,
-                                     CVector<uint8_t> ( 0 ),
-                                     InetAddr );
-}
+    int iPos = 0; // init position pointer
 
-bool CProtocol::EvaluateCLUnregisterServerMes ( const CHostAddress& InetAddr )
-{
-    // invoke message action
-    emit CLUnregisterServerReceived ( InetAddr );
+    // build data vector (9 bytes long)
+    CVector<uint8_t> vecData ( 9 );
 
-    return false; // no error
+    // country (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( Filter.eCountry ), 2 );
+
+    // minimum number of clients (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( Filter.iMinMaxNumClients ), 1 );
+
+    // feature flags (4 bytes)
+    PutValOnStream ( vecData, iPos, Filter.iRequiredFeatures, 4 );
+
+    // page index (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iPage ), 2 );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REQ_SERVER_LIST_PAGE,
+                                     vecData,
+                                     InetAddr );
 }
 
-void CProtocol::CreateCLServerListMes ( const CHostAddress&        InetAddr,
-                                        const CVector<CServerInfo> vecServerInfo )
+bool CProtocol::EvaluateCLReqServerListPageMes ( const CHostAddress&     InetAddr,
+                                                 const CVector<uint8_t>& vecData )
 {
-    const int iNumServers = vecServerInfo.Size();
-
-    // build data vector
-    CVector<uint8_t> vecData ( 0 );
-    int              iPos = 0; // init position pointer
+    int               iPos = 0; // init position pointer
+    CServerListFilter Filter;
 
-    for ( int i = 0; i < iNumServers; i++ )
+    // check size
+    if ( vecData.Size() != 9 )
     {
-        // convert server list strings to utf-8
-        const QByteArray strUTF8Name  = vecServerInfo[i].strName.toUtf8();
-        const QByteArray strUTF8Empty = QString ( "" ).toUtf8();
-        const QByteArray strUTF8City  = vecServerInfo[i].strCity.toUtf8();
+        return true; // return error code
+    }
 
-        // size of current list entry
-        const int iCurListEntrLen =
-            4 /* IP address */ +
-            2 /* port number */ +
-            2 /* country */ +
-            1 /* maximum number of connected clients */ +
-            1 /* is permanent flag */ +
-            2 /* name utf-8 string size */ + strUTF8Name.size() +
-            2 /* empty string */ +
-            2 /* city utf-8 string size */ + strUTF8City.size();
+    // country (2 bytes)
+    Filter.eCountry = static_cast<QLocale::Country> ( GetValFromStream ( vecData, iPos, 2 ) );
 
-        // make space for new data
-        vecData.Enlarge ( iCurListEntrLen );
+    // minimum number of clients (1 byte)
+    Filter.iMinMaxNumClients = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
 
-        // IP address (4 bytes)
-        // note the Server List manager has put the internal details in HostAddr where required
-        PutValOnStream ( vecData, iPos, static_cast<uint32_t> (
-            vecServerInfo[i].HostAddr.InetAddr.toIPv4Address() ), 4 );
+    // feature flags (4 bytes)
+    Filter.iRequiredFeatures = GetValFromStream ( vecData, iPos, 4 );
 
-        // port number (2 bytes)
-        // note the Server List manager has put the internal details in HostAddr where required
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecServerInfo[i].HostAddr.iPort ), 2 );
+    // page index (2 bytes)
+    const int iPage = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
 
-        // country (2 bytes)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecServerInfo[i].eCountry ), 2 );
+    // invoke message action
+    emit CLReqServerListPage ( InetAddr, Filter, iPage );
 
-        // maximum number of connected clients (1 byte)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecServerInfo[i].iMaxNumClients ), 1 );
+    return false; // no error
+}
 
-        // "is permanent" flag (1 byte)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecServerInfo[i].bPermanentOnline ), 1 );
+void CProtocol::CreateCLServerListPageMes ( const CHostAddress&         InetAddr,
+                                            const int                   iPage,
+                                            const int                   iNumPages,
+                                            const CVector<CServerInfo>& vecServerInfo )
+{
+    int iPos = 0; // init position pointer
 
-        // name
-        PutStringUTF8OnStream ( vecData, iPos, strUTF8Name );
+    // build data vector (the entries are appended)
+    CVector<uint8_t> vecData ( 4 );
 
-        // empty string
-        PutStringUTF8OnStream ( vecData, iPos, strUTF8Empty );
+    // page index (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iPage ), 2 );
 
-        // city
-        PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
-    }
+    // number of pages (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iNumPages ), 2 );
+
+    PutServerListEntries ( vecData, iPos, vecServerInfo );
 
-    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SERVER_LIST,
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SERVER_LIST_PAGE,
                                      vecData,
                                      InetAddr );
 }
 
-bool CProtocol::EvaluateCLServerListMes ( const CHostAddress&     InetAddr,
-                                          const CVector<uint8_t>& vecData )
+bool CProtocol::EvaluateCLServerListPageMes ( const CHostAddress&     InetAddr,
+                                              const CVector<uint8_t>& vecData )
 {
     int                  iPos     = 0; // init position pointer
     const int            iDataLen = vecData.Size();
     CVector<CServerInfo> vecServerInfo ( 0 );
 
-    while ( iPos < iDataLen )
+    // check size (the first 4 bytes)
+    if ( iDataLen < 4 )
     {
-        // check size (the next 10 bytes)
-        if ( ( iDataLen - iPos ) < 10 )
-        {
-            return true; // return error code
-        }
-
-        // IP address (4 bytes)
-        const quint32 iIpAddr = static_cast<quint32> ( GetValFromStream ( vecData, iPos, 4 ) );
-
-        // port number (2 bytes)
-        const quint16 iPort = static_cast<quint16> ( GetValFromStream ( vecData, iPos, 2 ) );
-
-        // country (2 bytes)
-        const QLocale::Country eCountry = static_cast<QLocale::Country> ( GetValFromStream ( vecData, iPos, 2 ) );
-
-        // maximum number of connected clients (1 byte)
-        const int iMaxNumClients = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
-
-        // "is permanent" flag (1 byte)
-        const bool bPermanentOnline = static_cast<bool> ( GetValFromStream ( vecData, iPos, 1 ) );
-
-        // server name
-        QString strName;
-        if ( GetStringFromStream ( vecData,
-                                   iPos,
-                                   MAX_LEN_SERVER_NAME,
-                                   strName ) )
-        {
-            return true; // return error code
-        }
-
-        // empty
-        QString strEmpty;
-        if ( GetStringFromStream ( vecData,
-                                   iPos,
-                                   MAX_LEN_IP_ADDRESS,
-                                   strEmpty ) )
-        {
-            return true; // return error code
-        }
+        return true; // return error code
+    }
 
-        // server city
-        QString strCity;
-        if ( GetStringFromStream ( vecData,
-                                   iPos,
-                                   MAX_LEN_SERVER_CITY,
-                                   strCity ) )
-        {
-            return true; // return error code
-        }
+    // page index (2 bytes)
+    const int iPage = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
 
-        // add server information to vector
-        vecServerInfo.Add (
-            CServerInfo ( CHostAddress ( QHostAddress ( iIpAddr ), iPort ),
-                          CHostAddress ( QHostAddress ( iIpAddr ), iPort ),
-                          strName,
-                          eCountry,
-                          strCity,
-                          iMaxNumClients,
-                          bPermanentOnline ) );
-    }
+    // number of pages (2 bytes)
+    const int iNumPages = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
 
-    // check size: all data is read, the position must now be at the end
-    if ( iPos != iDataLen )
+    if ( ( iPage >= iNumPages ) || GetServerListEntries ( vecData, iPos, vecServerInfo ) )
     {
         return true; // return error code
     }
 
     // invoke message action
-    emit CLServerListReceived ( InetAddr, vecServerInfo );
+    emit CLServerListPageReceived ( InetAddr, iPage, iNumPages, vecServerInfo );
 
     return false; // no error
 }
 
-void CProtocol::CreateCLReqServerListMes ( const CHostAddress& InetAddr )
+void CProtocol::CreateCLReqServerListIPv6Mes ( const CHostAddress&      InetAddr,
+                                               const CServerListFilter& Filter )
 {
-    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REQ_SERVER_LIST,
-                                     CVector<uint8_t> ( 0 ),
+    int iPos = 0; // init position pointer
+
+    // build data vector (7 bytes long)
+    CVector<uint8_t> vecData ( 7 );
+
+    // country (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( Filter.eCountry ), 2 );
+
+    // minimum number of clients (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( Filter.iMinMaxNumClients ), 1 );
+
+    // feature flags (4 bytes)
+    PutValOnStream ( vecData, iPos, Filter.iRequiredFeatures, 4 );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REQ_SERVER_LIST_IPV6,
+                                     vecData,
                                      InetAddr );
 }
 
-bool CProtocol::EvaluateCLReqServerListMes ( const CHostAddress& InetAddr )
+bool CProtocol::EvaluateCLReqServerListIPv6Mes ( const CHostAddress&     InetAddr,
+                                                 const CVector<uint8_t>& vecData )
 {
+    int               iPos = 0; // init position pointer
+    CServerListFilter Filter;
+
+    // check size
+    if ( vecData.Size() != 7 )
+    {
+        return true; // return error code
+    }
+
+    // country (2 bytes)
+    Filter.eCountry = static_cast<QLocale::Country> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    // minimum number of clients (1 byte)
+    Filter.iMinMaxNumClients = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    // feature flags (4 bytes)
+    Filter.iRequiredFeatures = GetValFromStream ( vecData, iPos, 4 );
+
     // invoke message action
-    emit CLReqServerList ( InetAddr );
+    emit CLReqServerListIPv6 ( InetAddr, Filter );
 
     return false; // no error
 }
 
-void CProtocol::CreateCLSendEmptyMesMes ( const CHostAddress& InetAddr,
-                                          const CHostAddress& TargetInetAddr )
+void CProtocol::CreateCLServerListIPv6Mes ( const CHostAddress&         InetAddr,
+                                            const CVector<CServerInfo>& vecServerInfo )
 {
-    int iPos = 0; // init position pointer
-
-    // build data vector (6 bytes long)
-    CVector<uint8_t> vecData ( 6 );
-
-    // IP address (4 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> (
-        TargetInetAddr.InetAddr.toIPv4Address() ), 4 );
-
-    // port number (2 bytes)
-    PutValOnStream ( vecData, iPos,
-        static_cast<uint32_t> ( TargetInetAddr.iPort ), 2 );
+    // build data vector
+    CVector<uint8_t> vecData ( 0 );
+    int              iPos = 0; // init position pointer
 
-    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SEND_EMPTY_MESSAGE,
+    PutServerListEntries ( vecData, iPos, vecServerInfo, true );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SERVER_LIST_IPV6,
                                      vecData,
                                      InetAddr );
 }
 
-bool CProtocol::EvaluateCLSendEmptyMesMes ( const CVector<uint8_t>& vecData )
+bool CProtocol::EvaluateCLServerListIPv6Mes ( const CHostAddress&     InetAddr,
+                                              const CVector<uint8_t>& vecData )
 {
-    int iPos = 0; // init position pointer
+    int                  iPos = 0; // init position pointer
+    CVector<CServerInfo> vecServerInfo ( 0 );
 
-    // check size
-    if ( vecData.Size() != 6 )
+    if ( GetServerListEntries ( vecData, iPos, vecServerInfo, true ) )
     {
         return true; // return error code
     }
 
-    // IP address (4 bytes)
-    const quint32 iIpAddr = static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
-
-    // port number (2 bytes)
-    const quint16 iPort = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
-
     // invoke message action
-    emit CLSendEmptyMes ( CHostAddress ( QHostAddress ( iIpAddr ), iPort ) );
+    emit CLServerListIPv6Received ( InetAddr, vecServerInfo );
 
     return false; // no error
 }
@@ -2352,7 +4946,8 @@ bool CProtocol::EvaluateCLChannelLevelListMes  ( const CHostAddress&     InetAdd
 }
 
 void CProtocol::CreateCLRegisterServerResp  ( const CHostAddress& InetAddr,
-                                              const ESvrRegResult eResult )
+                                              const ESvrRegResult eResult,
+                                              const int           iRetryAfterS )
 {
     int              iPos = 0; // init position pointer
     CVector<uint8_t> vecData( 1 );
@@ -2362,6 +4957,19 @@ void CProtocol::CreateCLRegisterServerResp  ( const CHostAddress& InetAddr,
     CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REGISTER_SERVER_RESP,
                                      vecData,
                                      InetAddr );
+
+    // the retry after hint follows the response in a message of its own
+    if ( iRetryAfterS > 0 )
+    {
+        CVector<uint8_t> vecRetryData ( 2 );
+
+        iPos = 0; // init position pointer
+        PutValOnStream ( vecRetryData, iPos, static_cast<uint32_t> ( std::min ( iRetryAfterS, 0xFFFF ) ), 2 );
+
+        CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REGISTER_SERVER_RETRY,
+                                         vecRetryData,
+                                         InetAddr );
+    }
 }
 
 bool CProtocol::EvaluateCLRegisterServerResp ( const CHostAddress&     InetAddr,
@@ -2383,6 +4991,184 @@ bool CProtocol::EvaluateCLRegisterServerResp ( const CHostAddress&     InetAddr,
     return false; // no error
 }
 
+bool CProtocol::EvaluateCLRegisterServerRetryMes ( const CHostAddress&     InetAddr,
+                                                   const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 2 )
+    {
+        return true; // return error code
+    }
+
+    // retry after (2 bytes)
+    const int iRetryAfterS = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    // invoke message action
+    emit CLRegisterServerRetryReceived ( InetAddr, iRetryAfterS );
+
+    return false; // no error
+}
+
+void CProtocol::CreateCLChannelLevelDeltaMes ( const CHostAddress&      InetAddr,
+                                               const CVector<uint16_t>& vecLevelList,
+                                               const CVector<uint8_t>&  vecbyChanged,
+                                               const int                iNumClients,
+                                               const int                iSeqNum,
+                                               const bool               bFullList )
+{
+    // count the levels which are transmitted
+    int iNumLevels = 0;
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        if ( bFullList || vecbyChanged[i] )
+        {
+            iNumLevels++;
+        }
+    }
+
+    const int iNumMaskBytes = bFullList ? 0 : ( iNumClients + 7 ) / 8;
+    const int iNumEntBytes  = 3 /* seq, flags, clients */ + iNumMaskBytes + ( iNumLevels + 1 ) / 2;
+
+    CVector<uint8_t> vecData ( iNumEntBytes );
+    int              iPos = 0; // init position pointer
+
+    // sequence number (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iSeqNum & 0xFF ), 1 );
+
+    // flags (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( bFullList ? 1 : 0 ), 1 );
+
+    // number of clients (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iNumClients ), 1 );
+
+    // changed mask
+    for ( int j = 0; j < iNumMaskBytes; j++ )
+    {
+        uint32_t iMask = 0;
+
+        for ( int k = 0; ( k < 8 ) && ( j * 8 + k < iNumClients ); k++ )
+        {
+            if ( vecbyChanged[j * 8 + k] )
+            {
+                iMask |= 1 << k;
+            }
+        }
+
+        PutValOnStream ( vecData, iPos, iMask, 1 );
+    }
+
+    // levels, two per byte
+    uint32_t iByte     = 0;
+    int      iNumInByte = 0;
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        if ( bFullList || vecbyChanged[i] )
+        {
+            iByte |= static_cast<uint32_t> ( vecLevelList[i] & 0x0F ) << ( 4 * iNumInByte );
+
+            if ( ++iNumInByte == 2 )
+            {
+                PutValOnStream ( vecData, iPos, iByte, 1 );
+                iByte      = 0;
+                iNumInByte = 0;
+            }
+        }
+    }
+
+    if ( iNumInByte == 1 )
+    {
+        // unused upper half
+        PutValOnStream ( vecData, iPos, iByte | 0xF0, 1 );
+    }
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_CHANNEL_LEVEL_DELTA,
+                                     vecData,
+                                     InetAddr );
+}
+
+bool CProtocol::EvaluateCLChannelLevelDeltaMes ( const CHostAddress&     InetAddr,
+                                                 const CVector<uint8_t>& vecData )
+{
+    int       iPos     = 0; // init position pointer
+    const int iDataLen = vecData.Size();
+
+    // check size (sequence number, flags and number of clients)
+    if ( iDataLen < 3 )
+    {
+        return true; // return error code
+    }
+
+    const int  iSeqNum     = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+    const bool bFullList   = ( GetValFromStream ( vecData, iPos, 1 ) & 1 ) != 0;
+    const int  iNumClients = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( iNumClients > MAX_NUM_CHANNELS )
+    {
+        return true; // return error code
+    }
+
+    // unchanged levels are marked in the output list
+    CVector<uint16_t> vecLevelList ( iNumClients, CHANNEL_LEVEL_UNCHANGED );
+    CVector<uint8_t>  vecbyChanged ( iNumClients, 1 );
+    int               iNumLevels = iNumClients;
+
+    if ( !bFullList )
+    {
+        const int iNumMaskBytes = ( iNumClients + 7 ) / 8;
+
+        if ( iPos + iNumMaskBytes > iDataLen )
+        {
+            return true; // return error code
+        }
+
+        iNumLevels = 0;
+
+        for ( int j = 0; j < iNumMaskBytes; j++ )
+        {
+            const uint32_t iMask = GetValFromStream ( vecData, iPos, 1 );
+
+            for ( int k = 0; ( k < 8 ) && ( j * 8 + k < iNumClients ); k++ )
+            {
+                vecbyChanged[j * 8 + k] = ( iMask >> k ) & 1;
+                iNumLevels += vecbyChanged[j * 8 + k];
+            }
+        }
+    }
+
+    // check size of the level values
+    if ( iPos + ( iNumLevels + 1 ) / 2 != iDataLen )
+    {
+        return true; // return error code
+    }
+
+    uint32_t iByte      = 0;
+    int      iNumInByte = 0;
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        if ( vecbyChanged[i] )
+        {
+            if ( iNumInByte == 0 )
+            {
+                iByte = GetValFromStream ( vecData, iPos, 1 );
+            }
+
+            vecLevelList[i] = static_cast<uint16_t> ( ( iByte >> ( 4 * iNumInByte ) ) & 0x0F );
+            iNumInByte      = 1 - iNumInByte;
+        }
+    }
+
+    // invoke message action
+    emit CLChannelLevelDeltaReceived ( InetAddr, iSeqNum, bFullList, vecLevelList );
+
+    return false; // no error
+}
+
+
 /******************************************************************************\
 * Message generation and parsing                                               *
 \******************************************************************************/
@@ -2392,27 +5178,16 @@ bool CProtocol::ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
                                     int&                    iCnt,
                                     int&                    iID )
 {
-    int i;
-    int iCurPos;
-
-    // vector must be at least "MESS_LEN_WITHOUT_DATA_BYTE" bytes long
-    if ( iNumBytesIn < MESS_LEN_WITHOUT_DATA_BYTE )
+    // every received packet is checked here, the check of the tag and the
+    // length sorts out the audio packets before any CRC work is done
+    if ( !IsMessageFrameHeader ( vecbyData, iNumBytesIn ) )
     {
         return true; // return error code
     }
 
 
     // Decode header -----------------------------------------------------------
-    iCurPos = 0; // start from beginning
-
-    // 2 bytes TAG
-    const int iTag = static_cast<int> ( GetValFromStream ( vecbyData, iCurPos, 2 ) );
-
-    // check if tag is correct
-    if ( iTag != 0 )
-    {
-        return true; // return error code
-    }
+    int iCurPos = 2; // the tag was already checked
 
     // 2 bytes ID
     iID = static_cast<int> ( GetValFromStream ( vecbyData, iCurPos, 2 ) );
@@ -2420,14 +5195,8 @@ bool CProtocol::ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
     // 1 byte cnt
     iCnt = static_cast<int> ( GetValFromStream ( vecbyData, iCurPos, 1 ) );
 
-    // 2 bytes length
-    const int iLenBy = static_cast<int> ( GetValFromStream ( vecbyData, iCurPos, 2 ) );
-
-    // make sure the length is correct
-    if ( iLenBy != iNumBytesIn - MESS_LEN_WITHOUT_DATA_BYTE )
-    {
-        return true; // return error code
-    }
+    // 2 bytes length (identical to the packet size as checked above)
+    const int iLenBy = iNumBytesIn - MESS_LEN_WITHOUT_DATA_BYTE;
 
 
     // Now check CRC -----------------------------------------------------------
@@ -2435,12 +5204,9 @@ bool CProtocol::ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
 
     const int iLenCRCCalc = MESS_HEADER_LENGTH_BYTE + iLenBy;
 
-    iCurPos = 0; // start from the beginning
+    CRCObj.AddBytes ( &vecbyData[0], iLenCRCCalc );
 
-    for ( i = 0; i < iLenCRCCalc; i++ )
-    {
-        CRCObj.AddByte ( static_cast<uint8_t> ( GetValFromStream ( vecbyData, iCurPos, 1 ) ) );
-    }
+    iCurPos = iLenCRCCalc;
 
     if ( CRCObj.GetCRC () != GetValFromStream ( vecbyData, iCurPos, 2 ) )
     {
@@ -2449,18 +5215,13 @@ bool CProtocol::ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
 
 
     // Extract actual data -----------------------------------------------------
-
-// TODO this memory allocation is done in the real time thread but should be
-//      done in the low priority protocol management thread
-
+    // note that no memory is allocated here if the capacity of the given vector
+    // is large enough (the socket uses preallocated message bodies)
     vecbyMesBodyData.Init ( iLenBy );
 
-    iCurPos = MESS_HEADER_LENGTH_BYTE; // start from beginning of data
-
-    for ( i = 0; i < iLenBy; i++ )
-    {
-        vecbyMesBodyData[i] = static_cast<uint8_t> ( GetValFromStream ( vecbyData, iCurPos, 1 ) );
-    }
+    std::copy ( vecbyData.begin() + MESS_HEADER_LENGTH_BYTE,
+                vecbyData.begin() + MESS_HEADER_LENGTH_BYTE + iLenBy,
+                vecbyMesBodyData.begin() );
 
     return false; // no error
 }
@@ -2538,8 +5299,6 @@ void CProtocol::GenMessageFrame ( CVector<uint8_t>&       vecOut,
                                   const int               iID,
                                   const CVector<uint8_t>& vecData )
 {
-    int i;
-
     // query length of data vector
     const int iDataLenByte = vecData.Size();
 
@@ -2566,23 +5325,17 @@ void CProtocol::GenMessageFrame ( CVector<uint8_t>&       vecOut,
     PutValOnStream ( vecOut, iCurPos, static_cast<uint32_t> ( iDataLenByte ), 2 );
 
     // encode data -----
-    for ( i = 0; i < iDataLenByte; i++ )
-    {
-        PutValOnStream ( vecOut, iCurPos, static_cast<uint32_t> ( vecData[i] ), 1 );
-    }
+    std::copy ( vecData.begin(), vecData.end(), vecOut.begin() + iCurPos );
 
 
     // Encode CRC --------------------------------------------------------------
     CCRC CRCObj;
 
-    iCurPos = 0; // start from beginning
-
     const int iLenCRCCalc = MESS_HEADER_LENGTH_BYTE + iDataLenByte;
 
-    for ( i = 0; i < iLenCRCCalc; i++ )
-    {
-        CRCObj.AddByte ( static_cast<uint8_t> ( GetValFromStream ( vecOut, iCurPos, 1 ) ) );
-    }
+    CRCObj.AddBytes ( &vecOut[0], iLenCRCCalc );
+
+    iCurPos = iLenCRCCalc;
 
     PutValOnStream ( vecOut, iCurPos, static_cast<uint32_t> ( CRCObj.GetCRC() ), 2 );
 }
@@ -2623,3 +5376,198 @@ void CProtocol::PutStringUTF8OnStream ( CVector<uint8_t>& vecIn,
         PutValOnStream ( vecIn, iPos, static_cast<uint32_t> ( sStringUTF8[j] ), 1 );
     }
 }
+
+int CProtocol::GetVarIntSize ( const uint32_t iVal )
+{
+    int iSize = 1;
+
+    for ( uint32_t iRemaining = iVal >> 7; iRemaining != 0; iRemaining >>= 7 )
+    {
+        iSize++;
+    }
+
+    return iSize;
+}
+
+void CProtocol::PutVarIntOnStream ( CVector<uint8_t>& vecIn,
+                                    int&              iPos,
+                                    const uint32_t    iVal )
+{
+/*
+    note: iPos is automatically incremented in this function
+*/
+    Q_ASSERT ( vecIn.Size() >= iPos + GetVarIntSize ( iVal ) );
+
+    // 7 bits per byte starting with the least significant bits, the highest
+    // bit is set if another byte follows
+    uint32_t iRemaining = iVal;
+
+    while ( iRemaining >= 128 )
+    {
+        vecIn[iPos] = static_cast<uint8_t> ( ( iRemaining & 127 ) | 128 );
+        iRemaining >>= 7;
+        iPos++;
+    }
+
+    vecIn[iPos] = static_cast<uint8_t> ( iRemaining );
+    iPos++;
+}
+
+bool CProtocol::GetVarIntFromStream ( const CVector<uint8_t>& vecIn,
+                                      int&                    iPos,
+                                      uint32_t&               iVal )
+{
+/*
+    note: iPos is automatically incremented in this function
+*/
+    iVal = 0;
+
+    for ( int i = 0; i < 5; i++ )
+    {
+        if ( iPos >= vecIn.Size() )
+        {
+            return true; // return error code
+        }
+
+        const uint32_t iByte = vecIn[iPos];
+        iPos++;
+
+        // the fifth byte only has the four remaining bits of 32 bits
+        if ( ( i == 4 ) && ( iByte > 15 ) )
+        {
+            return true; // return error code
+        }
+
+        iVal |= ( iByte & 127 ) << ( i * 7 );
+
+        if ( ( iByte & 128 ) == 0 )
+        {
+            return false; // no error
+        }
+    }
+
+    return true; // return error code
+}
+
+void CProtocol::PutCompactMessage ( CVector<uint8_t>&       vecOut,
+                                    const CVector<uint8_t>& vecFrame,
+                                    int&                    iPrevCnt )
+{
+    // read the header of the message frame (after the tag)
+    int       iPos     = 2;
+    const int iID      = static_cast<int> ( GetValFromStream ( vecFrame, iPos, 2 ) );
+    const int iCnt     = static_cast<int> ( GetValFromStream ( vecFrame, iPos, 1 ) );
+    const int iDataLen = static_cast<int> ( GetValFromStream ( vecFrame, iPos, 2 ) );
+
+    // the counter is only sent if it does not follow the previous one
+    const bool bPutCnt = ( iCnt != ( ( iPrevCnt + 1 ) & 0xFF ) );
+    const int  iHeader = ( iID << 1 ) | ( bPutCnt ? 1 : 0 );
+
+    // the acknowledged message ID is a variable length integer
+    const bool bIsAckn = ( iID == PROTMESSID_ACKN );
+
+    Q_ASSERT ( !bIsAckn || ( iDataLen == 2 ) );
+
+    const uint32_t iAcknID = bIsAckn ? GetValFromStream ( vecFrame, iPos, 2 ) : 0;
+    const int      iNewLen = bIsAckn ? GetVarIntSize ( iAcknID ) : iDataLen;
+    int            iOutPos = vecOut.Size();
+
+    vecOut.resize ( iOutPos +
+                    GetVarIntSize ( static_cast<uint32_t> ( iHeader ) ) +
+                    ( bPutCnt ? 1 : 0 ) +
+                    GetVarIntSize ( static_cast<uint32_t> ( iNewLen ) ) +
+                    iNewLen );
+
+    PutVarIntOnStream ( vecOut, iOutPos, static_cast<uint32_t> ( iHeader ) );
+
+    if ( bPutCnt )
+    {
+        PutValOnStream ( vecOut, iOutPos, static_cast<uint32_t> ( iCnt ), 1 );
+    }
+
+    PutVarIntOnStream ( vecOut, iOutPos, static_cast<uint32_t> ( iNewLen ) );
+
+    if ( bIsAckn )
+    {
+        PutVarIntOnStream ( vecOut, iOutPos, iAcknID );
+    }
+    else
+    {
+        std::copy ( vecFrame.begin() + MESS_HEADER_LENGTH_BYTE,
+                    vecFrame.begin() + MESS_HEADER_LENGTH_BYTE + iDataLen,
+                    vecOut.begin() + iOutPos );
+    }
+
+    iPrevCnt = iCnt;
+}
+
+bool CProtocol::GetCompactMessage ( const CVector<uint8_t>& vecIn,
+                                    int&                    iPos,
+                                    int&                    iPrevCnt,
+                                    CVector<uint8_t>&       vecbyMesBodyData,
+                                    int&                    iRecCounter,
+                                    int&                    iRecID )
+{
+/*
+    return code: false -> ok; true -> error
+*/
+    uint32_t iHeader;
+    uint32_t iDataLen;
+
+    // message ID and the flag of the counter
+    if ( GetVarIntFromStream ( vecIn, iPos, iHeader ) || ( ( iHeader >> 1 ) > 0xFFFF ) )
+    {
+        return true; // return error code
+    }
+
+    iRecID = static_cast<int> ( iHeader >> 1 );
+
+    if ( ( iHeader & 1 ) != 0 )
+    {
+        if ( iPos >= vecIn.Size() )
+        {
+            return true; // return error code
+        }
+
+        iRecCounter = static_cast<int> ( GetValFromStream ( vecIn, iPos, 1 ) );
+    }
+    else
+    {
+        iRecCounter = ( iPrevCnt + 1 ) & 0xFF;
+    }
+
+    iPrevCnt = iRecCounter;
+
+    // data length
+    if ( GetVarIntFromStream ( vecIn, iPos, iDataLen ) ||
+         ( iDataLen > static_cast<uint32_t> ( vecIn.Size() - iPos ) ) )
+    {
+        return true; // return error code
+    }
+
+    const int iEndPos = iPos + static_cast<int> ( iDataLen );
+
+    if ( iRecID == PROTMESSID_ACKN )
+    {
+        // the acknowledged message ID is expanded to the 2 bytes of the
+        // regular message
+        uint32_t iAcknID;
+
+        if ( GetVarIntFromStream ( vecIn, iPos, iAcknID ) || ( iPos != iEndPos ) || ( iAcknID > 0xFFFF ) )
+        {
+            return true; // return error code
+        }
+
+        int iBodyPos = 0;
+
+        vecbyMesBodyData.Init ( 2 );
+        PutValOnStream ( vecbyMesBodyData, iBodyPos, iAcknID, 2 );
+    }
+    else
+    {
+        vecbyMesBodyData.assign ( vecIn.begin() + iPos, vecIn.begin() + iEndPos );
+        iPos = iEndPos;
+    }
+
+    return false; // no error
+}
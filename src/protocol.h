@@ -25,11 +25,11 @@
 #pragma once
 
 #include <QMutex>
-#include <QTimer>
 #include <QDateTime>
 #include <list>
 #include "global.h"
 #include "util.h"
+#include "timerwheel.h"
 
 
 /* Definitions ****************************************************************/
@@ -60,6 +60,20 @@
 #define PROTMESSID_MUTE_STATE_CHANGED         31 // mute state of your signal at another client has changed
 #define PROTMESSID_CLIENT_ID                  32 // current user ID and server status
 #define PROTMESSID_RECORDER_STATE             33 // contains the state of the jam recorder (ERecorderState)
+#define PROTMESSID_REQ_CHANNEL_LEVEL_DELTA    34 // request the compact channel level list
+#define PROTMESSID_PROT_VERSION               35 // protocol version (first message of a session)
+#define PROTMESSID_MESS_CONTAINER             36 // several messages in one datagram (not acknowledged)
+#define PROTMESSID_CONN_CLIENTS_LIST_DELTA    37 // changes of the connected clients list
+#define PROTMESSID_LISTENER_MODE              38 // the client only listens (its audio is not mixed)
+#define PROTMESSID_MIX_GROUP                  39 // mix group of the client (e.g. its section)
+#define PROTMESSID_MIX_GROUP_GAIN             40 // set mix group gain for mix
+#define PROTMESSID_MIX_GROUP_LIST             41 // mix groups of all connected channels
+#define PROTMESSID_MULTICAST_GROUP            42 // multicast group of the shared stream of the client
+#define PROTMESSID_MULTICAST_JOINED           43 // the client has joined the multicast group
+#define PROTMESSID_REQ_NET_STATS              44 // request the audio packet statistics
+#define PROTMESSID_NET_STATS                  45 // audio packet statistics of the receive direction
+#define PROTMESSID_MESS_CONTAINER_COMPACT     46 // several messages with compact headers (not acknowledged)
+#define PROTMESSID_CHANNEL_GAIN_PAN_LIST      47 // set gains and pans of several channels for mix
 
 // message IDs of connection less messages (CLM)
 // DEFINITION -> start at 1000, end at 1999, see IsConnectionLessMessageID
@@ -79,6 +93,43 @@
 #define PROTMESSID_CLM_REQ_CONN_CLIENTS_LIST  1014 // request the connected clients list
 #define PROTMESSID_CLM_CHANNEL_LEVEL_LIST     1015 // channel level list
 #define PROTMESSID_CLM_REGISTER_SERVER_RESP   1016 // status of server registration request
+#define PROTMESSID_CLM_CHANNEL_LEVEL_DELTA    1017 // changed channel levels
+#define PROTMESSID_CLM_SEND_EMPTY_MES_LIST    1018 // empty messages shall be send to several addresses
+#define PROTMESSID_CLM_SERVER_FEATURES        1019 // features supported by a registering server
+#define PROTMESSID_CLM_FEDERATION_UPDATE      1020 // replicated server list entries (central servers)
+#define PROTMESSID_CLM_REQ_FEDERATION_SYNC    1021 // request all server list entries (central servers)
+#define PROTMESSID_CLM_REQ_SERVER_LIST_PAGE   1022 // request one page of the filtered server list
+#define PROTMESSID_CLM_SERVER_LIST_PAGE       1023 // one page of the filtered server list
+#define PROTMESSID_CLM_RTT_PROBE              1024 // round trip time measurement of the server
+#define PROTMESSID_CLM_RTT_PROBE_ECHO         1025 // answer of the client to PROTMESSID_CLM_RTT_PROBE
+#define PROTMESSID_CLM_REQ_SERVER_LIST_IPV6   1026 // request the IPv6 entries of the filtered server list
+#define PROTMESSID_CLM_SERVER_LIST_IPV6       1027 // the IPv6 entries of the filtered server list
+#define PROTMESSID_CLM_REQ_LATENCY_PROBE      1028 // latency probe of a connected client
+#define PROTMESSID_CLM_LATENCY_PROBE          1029 // server timing, answer to PROTMESSID_CLM_REQ_LATENCY_PROBE
+#define PROTMESSID_CLM_SERVER_LOAD            1030 // load of a registered server of a server pool
+#define PROTMESSID_CLM_REGISTER_SERVER_RETRY  1031 // time until the next registration of a server
+
+// flags of the audio coding argument of the network transport properties
+// (PROTMESSID_NETW_TRANSPORT_PROPS)
+#define NETW_TRANSP_PROPS_ARG_REDUNDANCY      0x00000001 // redundant copy of the previous packet
+#define NETW_TRANSP_PROPS_ARG_SEQ_NUM         0x00000002 // sequence number and send time of the packet
+#define NETW_TRANSP_PROPS_ARG_MULTITRACK      0x00000004 // the client mixes the forwarded frames of the other clients
+#define NETW_TRANSP_PROPS_ARG_SUB_STREAMS     0x00000F00 // number of additional sub-streams of the packet
+#define NETW_TRANSP_PROPS_ARG_SUB_STREAMS_POS 8          // bit position of the number of sub-streams
+
+// features of a registering server (PROTMESSID_CLM_SERVER_FEATURES)
+#define CLM_SERVER_FEATURE_SEND_EMPTY_MES_LIST 0x00000001 // understands PROTMESSID_CLM_SEND_EMPTY_MES_LIST
+
+// maximum number of addresses in one PROTMESSID_CLM_SEND_EMPTY_MES_LIST message
+#define CLM_SEND_EMPTY_MES_LIST_MAX_NUM       200
+
+// maximum number of entries in one PROTMESSID_CLM_FEDERATION_UPDATE message
+#define CLM_FEDERATION_UPDATE_MAX_NUM         10
+
+// flags of PROTMESSID_CONN_CLIENTS_LIST_DELTA
+#define CONN_CLIENTS_LIST_FLAG_FULL_LIST      0x01 // the message contains the complete list
+#define CONN_CLIENTS_LIST_FLAG_CONTINUED      0x02 // further part of the same list version
+#define CONN_CLIENTS_LIST_FLAG_MORE_PARTS     0x04 // more parts of this list version follow
 
 // lengths of message as defined in protocol.cpp file
 #define MESS_HEADER_LENGTH_BYTE         7 // TAG (2), ID (2), cnt (1), length (2)
@@ -87,8 +138,49 @@
 // time out for message re-send if no acknowledgement was received
 #define SEND_MESS_TIMEOUT_MS            400 // ms
 
+// version of the reliable message transport
+#define PROT_VERSION_SINGLE_MESS        0 // one message in flight (old protocol)
+#define PROT_VERSION_SEND_WINDOW        1 // sliding window of unacknowledged messages
+#define PROT_VERSION_MESS_CONTAINER     2 // messages are bundled in containers
+#define PROT_VERSION_CLIENT_LIST_DELTA  3 // changes of the connected clients list
+#define PROT_VERSION_SESSION_SETUP      4 // session setup in the protocol version message
+#define PROT_VERSION_SPLIT_CLIENT_LIST  5 // the connected clients list is split in parts
+#define PROT_VERSION_COMPACT_MESS       6 // compact containers and the gain/pan list
+#define PROT_VERSION                    PROT_VERSION_COMPACT_MESS
+
+// maximum size of a container message (a datagram of this size plus the IP and
+// UDP headers must not be fragmented on typical links)
+#define PROT_MESS_CONTAINER_MAX_BYTES   1200
+
+// maximum size of the entries of one part of a split list (a part of the
+// connected clients list or a page of the server list) so that the message
+// fits in one datagram of the container size
+#define PROT_LIST_PART_MAX_BYTES        1000
+
+// maximum number of unacknowledged messages in flight (the message counter has
+// 8 bits so that this value must be smaller than 128)
+#define PROT_SEND_WINDOW_SIZE           16
+
+// time the server waits for the session setup of a new client before its
+// first messages are sent (a client sends it right after its first audio packet)
+#define PROT_SESSION_SETUP_WAIT_MS      50 // ms
+
 
 /* Classes ********************************************************************/
+// body of a message which is sent to several peers: it is created once by one
+// of the CProtocol::Prepare*Mes() functions, the message counter and the CRC
+// are added for each peer by CProtocol::SendBroadcastMes()
+class CProtBroadcastMes
+{
+public:
+    CProtBroadcastMes() : iID ( PROTMESSID_ILLEGAL ) {}
+
+    bool IsValid() const { return iID != PROTMESSID_ILLEGAL; }
+
+    int              iID;
+    CVector<uint8_t> vecData;
+};
+
 class CProtocol : public QObject
 {
     Q_OBJECT
@@ -103,8 +195,18 @@ public:
     void CreateClientIDMes ( const int iChanID );
     void CreateChanGainMes ( const int iChanID, const double dGain );
     void CreateChanPanMes ( const int iChanID, const double dPan );
+
+    // the gains and pans of all channels (index: channel ID), negative values
+    // are not sent, the values are sent in one message to a peer with
+    // PROT_VERSION_COMPACT_MESS and in separate messages otherwise
+    void CreateChanGainPanListMes ( const CVector<double>& vecdGains,
+                                    const CVector<double>& vecdPans );
     void CreateMuteStateHasChangedMes ( const int iChanID, const bool bIsMuted );
     void CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInfo );
+    void CreateConClientListDeltaMes ( const int                    iListVersion,
+                                       const bool                   bFullList,
+                                       const CVector<CChannelInfo>& vecChanInfo,
+                                       const CVector<int>&          veciLeftChanIDs );
     void CreateReqConnClientsList();
     void CreateChanInfoMes ( const CChannelCoreInfo ChanInfo );
     void CreateReqChanInfoMes();
@@ -116,6 +218,57 @@ public:
     void CreateReqChannelLevelListMes ( const bool bRCL );
     void CreateVersionAndOSMes();
     void CreateRecorderStateMes ( const ERecorderState eRecorderState );
+    void CreateReqChannelLevelDeltaMes ( const int iInterval );
+    void CreateListenerModeMes ( const bool bIsListener );
+    void CreateMixGroupMes ( const int iMixGroup );
+    void CreateMixGroupGainMes ( const int iMixGroup, const double dGain );
+    void CreateMulticastGroupMes ( const int iStream, const CHostAddress& GroupAddr );
+    void CreateMulticastJoinedMes ( const int iStream );
+    void CreateReqNetStatsMes();
+    void CreateNetStatsMes ( const int iNumReceived, const int iNumLost );
+
+    // the messages which are identical for all peers are serialised once
+    static void PrepareConClientListMes ( const CVector<CChannelInfo>& vecChanInfo,
+                                          CProtBroadcastMes&           Mes );
+    static void PrepareConClientListDeltaMes ( const int                    iListVersion,
+                                               const bool                   bFullList,
+                                               const CVector<CChannelInfo>& vecChanInfo,
+                                               const CVector<int>&          veciLeftChanIDs,
+                                               CProtBroadcastMes&           Mes );
+
+    // the list is split in messages of at most PROT_LIST_PART_MAX_BYTES bytes of entries
+    // (only for a peer with PROT_VERSION_SPLIT_CLIENT_LIST)
+    static void PrepareConClientListDeltaMesParts ( const int                    iListVersion,
+                                                    const bool                   bFullList,
+                                                    const CVector<CChannelInfo>& vecChanInfo,
+                                                    const CVector<int>&          veciLeftChanIDs,
+                                                    CVector<CProtBroadcastMes>&  vecMes );
+    static void PrepareChatTextMes ( const QString&     strChatText,
+                                     CProtBroadcastMes& Mes );
+    static void PrepareRecorderStateMes ( const ERecorderState eRecorderState,
+                                          CProtBroadcastMes&   Mes );
+    static void PrepareMixGroupListMes ( const CVector<int>& vecMixGroups,
+                                         CProtBroadcastMes&  Mes );
+
+    void SendBroadcastMes ( const CProtBroadcastMes& Mes ) { CreateAndSendMessage ( Mes.iID, Mes.vecData ); }
+
+    // size of an entry of the connected clients list and of the server list
+    // in a message
+    static int GetConClientListEntrySize ( const CChannelInfo& ChanInfo );
+    static int GetServerListEntrySize ( const CServerInfo& ServerInfo,
+                                        const bool         bIPv6 = false );
+
+    // the messages which are created between these calls are not sent
+    // separately but are appended to the protocol version message as the
+    // session setup (only possible if no message of the session was sent yet,
+    // otherwise the messages are sent as usual)
+    void BeginSessionSetup();
+    void EndSessionSetup();
+
+    // the first messages of the session are held back until the other side
+    // sent its protocol version message or the given time elapsed, if no
+    // session setup was received, SessionSetupMissing() is emitted
+    void WaitForSessionSetup ( const int iMaxWaitMs );
 
     void CreateCLPingMes               ( const CHostAddress& InetAddr, const int iMs );
     void CreateCLPingWithNumClientsMes ( const CHostAddress& InetAddr,
@@ -128,11 +281,46 @@ public:
     void CreateCLUnregisterServerMes   ( const CHostAddress& InetAddr );
     void CreateCLServerListMes         ( const CHostAddress&        InetAddr,
                                          const CVector<CServerInfo> vecServerInfo );
+    void GenCLServerListMes            ( const CVector<CServerInfo>& vecServerInfo,
+                                         CVector<uint8_t>&           vecMessage );
     void CreateCLReqServerListMes      ( const CHostAddress& InetAddr );
+    void CreateCLReqServerListPageMes  ( const CHostAddress&      InetAddr,
+                                         const CServerListFilter& Filter,
+                                         const int                iPage );
+    void CreateCLServerListPageMes     ( const CHostAddress&         InetAddr,
+                                         const int                   iPage,
+                                         const int                   iNumPages,
+                                         const CVector<CServerInfo>& vecServerInfo );
+    void CreateCLReqServerListIPv6Mes  ( const CHostAddress&      InetAddr,
+                                         const CServerListFilter& Filter );
+    void CreateCLServerListIPv6Mes     ( const CHostAddress&         InetAddr,
+                                         const CVector<CServerInfo>& vecServerInfo );
     void CreateCLSendEmptyMesMes       ( const CHostAddress& InetAddr,
                                          const CHostAddress& TargetInetAddr );
+    void CreateCLSendEmptyMesListMes   ( const CHostAddress&          InetAddr,
+                                         const CVector<CHostAddress>& vecTargetInetAddr );
+    void CreateCLServerFeaturesMes     ( const CHostAddress& InetAddr,
+                                         const uint32_t      iFeatures );
+    void CreateCLFederationUpdateMes   ( const CHostAddress&                   InetAddr,
+                                         const CVector<CFederationServerInfo>& vecServerInfo );
+    void CreateCLReqFederationSyncMes  ( const CHostAddress& InetAddr );
+    void CreateCLRttProbeMes           ( const CHostAddress& InetAddr, const int iMs );
+    void CreateCLRttProbeEchoMes       ( const CHostAddress& InetAddr, const int iMs );
+    void CreateCLReqLatencyProbeMes    ( const CHostAddress& InetAddr, const int iMs );
+    void CreateCLLatencyProbeMes       ( const CHostAddress&       InetAddr,
+                                         const CServerLatencyInfo& LatencyInfo );
+    void CreateCLServerLoadMes         ( const CHostAddress& InetAddr,
+                                         const QString&      strPool,
+                                         const int           iNumClients,
+                                         const int           iLoadPct );
     void CreateCLEmptyMes              ( const CHostAddress& InetAddr );
     void CreateCLDisconnection         ( const CHostAddress& InetAddr );
+
+    // sends a complete connection less message which was created before (e.g.
+    // a cached server list)
+    void SendCLMessage ( const CHostAddress& InetAddr,
+                         const CProtMessage& Message )
+        { emit CLMessReadyForSending ( InetAddr, Message ); }
     void CreateCLVersionAndOSMes       ( const CHostAddress& InetAddr );
     void CreateCLReqVersionAndOSMes    ( const CHostAddress& InetAddr );
     void CreateCLConnClientsListMes    ( const CHostAddress&          InetAddr,
@@ -142,7 +330,14 @@ public:
                                          const CVector<uint16_t>& vecLevelList,
                                          const int                iNumClients );
     void CreateCLRegisterServerResp    ( const CHostAddress& InetAddr,
-                                         const ESvrRegResult eResult );
+                                         const ESvrRegResult eResult,
+                                         const int           iRetryAfterS = 0 );
+    void CreateCLChannelLevelDeltaMes  ( const CHostAddress&      InetAddr,
+                                         const CVector<uint16_t>& vecLevelList,
+                                         const CVector<uint8_t>&  vecbyChanged,
+                                         const int                iNumClients,
+                                         const int                iSeqNum,
+                                         const bool               bFullList );
 
     static bool ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
                                     const int               iNumBytesIn,
@@ -158,69 +353,134 @@ public:
                                           const int               iRecID,
                                           const CHostAddress&     InetAddr );
 
+    // fast check of the header bytes without the CRC (zero tag and a length
+    // which matches the packet size), audio packets almost never pass it
+    static bool IsMessageFrameHeader ( const CVector<uint8_t>& vecbyData,
+                                       const int               iNumBytesIn )
+    {
+        return ( iNumBytesIn >= MESS_LEN_WITHOUT_DATA_BYTE ) &&
+               ( vecbyData[0] == 0 ) && ( vecbyData[1] == 0 ) &&
+               ( ( vecbyData[5] | ( vecbyData[6] << 8 ) ) == iNumBytesIn - MESS_LEN_WITHOUT_DATA_BYTE );
+    }
+
     static bool IsConnectionLessMessageID ( const int iID )
         { return ( iID >= 1000 ) && ( iID < 2000 ); }
 
+    // protocol version of the other side (PROT_VERSION_SINGLE_MESS until its
+    // protocol version message was received)
+    int GetPeerProtVersion()
+    {
+        QMutexLocker locker ( &Mutex );
+        return iPeerProtVersion;
+    }
+
     // this function is public because we need it in the test bench
     void CreateAndImmSendAcknMess ( const int& iID,
                                     const int& iCnt );
 
 protected:
+    // the message queue holds the messages in flight (prefix of
+    // iNumMessInFlight messages) followed by the messages waiting for a free
+    // slot in the send window
     class CSendMessage
     {
     public:
-        CSendMessage() : vecMessage ( 0 ), iID ( PROTMESSID_ILLEGAL ),
-            iCnt ( 0 ) {}
-        CSendMessage ( const CVector<uint8_t>& nMess, const int iNCnt,
-            const int iNID ) : vecMessage ( nMess ), iID ( iNID ),
+        CSendMessage() : iID ( PROTMESSID_ILLEGAL ), iCnt ( 0 ) {}
+        CSendMessage ( const CProtMessage& nMess, const int iNCnt,
+            const int iNID ) : Message ( nMess ), iID ( iNID ),
             iCnt ( iNCnt ) {}
 
-        CSendMessage& operator= ( const CSendMessage& NewSendMess )
-        {
-            vecMessage.Init ( NewSendMess.vecMessage.Size() );
-            vecMessage = NewSendMess.vecMessage;
-
-            iID  = NewSendMess.iID;
-            iCnt = NewSendMess.iCnt;
-            return *this; 
-        }
-
-        CVector<uint8_t> vecMessage;
-        int              iID, iCnt;
+        // the resent messages share the bytes of the queued message
+        CProtMessage Message;
+        int          iID, iCnt;
     };
 
-    void EnqueueMessage ( CVector<uint8_t>& vecMessage,
-                          const int         iCnt,
-                          const int         iID );
-
     void GenMessageFrame ( CVector<uint8_t>&       vecOut,
                            const int               iCnt,
                            const int               iID,
                            const CVector<uint8_t>& vecData );
 
-    void PutValOnStream ( CVector<uint8_t>& vecIn,
-                          int&              iPos,
-                          const uint32_t    iVal,
-                          const int         iNumOfBytes );
-
-    void PutStringUTF8OnStream ( CVector<uint8_t>& vecIn,
+    static void PutValOnStream ( CVector<uint8_t>& vecIn,
                                  int&              iPos,
-                                 const QByteArray& sStringUTF8 );
+                                 const uint32_t    iVal,
+                                 const int         iNumOfBytes );
+
+    static void PutStringUTF8OnStream ( CVector<uint8_t>& vecIn,
+                                        int&              iPos,
+                                        const QByteArray& sStringUTF8 );
 
     static uint32_t GetValFromStream ( const CVector<uint8_t>& vecIn,
                                        int&                    iPos,
                                        const int               iNumOfBytes );
 
+    // variable length integers with 7 bits per byte (1 to 5 bytes)
+    static int GetVarIntSize ( const uint32_t iVal );
+
+    static void PutVarIntOnStream ( CVector<uint8_t>& vecIn,
+                                    int&              iPos,
+                                    const uint32_t    iVal );
+
+    static bool GetVarIntFromStream ( const CVector<uint8_t>& vecIn,
+                                      int&                    iPos,
+                                      uint32_t&               iVal );
+
+    // entries of PROTMESSID_MESS_CONTAINER_COMPACT (iPrevCnt is the counter
+    // of the previous entry of the container)
+    static void PutCompactMessage ( CVector<uint8_t>&       vecOut,
+                                    const CVector<uint8_t>& vecFrame,
+                                    int&                    iPrevCnt );
+
+    static bool GetCompactMessage ( const CVector<uint8_t>& vecIn,
+                                    int&                    iPos,
+                                    int&                    iPrevCnt,
+                                    CVector<uint8_t>&       vecbyMesBodyData,
+                                    int&                    iRecCounter,
+                                    int&                    iRecID );
+
     bool GetStringFromStream ( const CVector<uint8_t>& vecIn,
                                int&                    iPos,
                                const int               iMaxStringLen,
                                QString&                strOut );
 
-    void SendMessage();
+    void SendMessage ( const bool bResendInFlight );
+
+    static void PutConClientListEntries ( CVector<uint8_t>&            vecData,
+                                          int&                         iPos,
+                                          const CVector<CChannelInfo>& vecChanInfo );
+
+    static void PrepareConClientListDeltaPart ( const int                    iListVersion,
+                                                const int                    iFlags,
+                                                const CVector<CChannelInfo>& vecChanInfo,
+                                                const CVector<int>&          veciLeftChanIDs,
+                                                CProtBroadcastMes&           Mes );
+
+    bool GetConClientListEntries ( const CVector<uint8_t>& vecData,
+                                   int&                    iPos,
+                                   CVector<CChannelInfo>&  vecChanInfo );
+
+    // the entries have 4 bytes IPv4 addresses or 16 bytes IPv6 addresses
+    void PutServerListEntries ( CVector<uint8_t>&           vecData,
+                                int&                        iPos,
+                                const CVector<CServerInfo>& vecServerInfo,
+                                const bool                  bIPv6 = false );
+
+    bool GetServerListEntries ( const CVector<uint8_t>& vecData,
+                                int&                    iPos,
+                                CVector<CServerInfo>&   vecServerInfo,
+                                const bool              bIPv6 = false );
+
+    void EmitMessages ( const std::list<CProtMessage>& vecMessages,
+                        const bool                     bUseContainer,
+                        const bool                     bUseCompact );
+
+    bool ParseContainerMes ( const CVector<uint8_t>& vecData,
+                             const bool              bCompact );
 
     void CreateAndSendMessage ( const int               iID,
                                 const CVector<uint8_t>& vecData );
 
+    void QueueProtVersionMes();
+
     void CreateAndImmSendConLessMessage ( const int               iID,
                                           const CVector<uint8_t>& vecData,
                                           const CHostAddress&     InetAddr );
@@ -230,8 +490,10 @@ protected:
     bool EvaluateClientIDMes            ( const CVector<uint8_t>& vecData );
     bool EvaluateChanGainMes            ( const CVector<uint8_t>& vecData );
     bool EvaluateChanPanMes             ( const CVector<uint8_t>& vecData );
+    bool EvaluateChanGainPanListMes     ( const CVector<uint8_t>& vecData );
     bool EvaluateMuteStateHasChangedMes ( const CVector<uint8_t>& vecData );
     bool EvaluateConClientListMes       ( const CVector<uint8_t>& vecData );
+    bool EvaluateConClientListDeltaMes  ( const CVector<uint8_t>& vecData );
     bool EvaluateReqConnClientsList();
     bool EvaluateChanInfoMes            ( const CVector<uint8_t>& vecData );
     bool EvaluateReqChanInfoMes();
@@ -242,6 +504,26 @@ protected:
     bool EvaluateReqChannelLevelListMes ( const CVector<uint8_t>& vecData );
     bool EvaluateVersionAndOSMes        ( const CVector<uint8_t>& vecData );
     bool EvaluateRecorderStateMes       ( const CVector<uint8_t>& vecData );
+    bool EvaluateReqChannelLevelDeltaMes ( const CVector<uint8_t>& vecData );
+    bool EvaluateListenerModeMes        ( const CVector<uint8_t>& vecData );
+    bool EvaluateMixGroupMes            ( const CVector<uint8_t>& vecData );
+    bool EvaluateMixGroupGainMes        ( const CVector<uint8_t>& vecData );
+    bool EvaluateMixGroupListMes        ( const CVector<uint8_t>& vecData );
+    bool EvaluateMulticastGroupMes      ( const CVector<uint8_t>& vecData );
+    bool EvaluateMulticastJoinedMes     ( const CVector<uint8_t>& vecData );
+    bool EvaluateReqNetStatsMes();
+    bool EvaluateNetStatsMes            ( const CVector<uint8_t>& vecData );
+    bool EvaluateProtVersionMes         ( const CVector<uint8_t>& vecData,
+                                          const int               iRecCounter );
+    bool EvaluateSessionSetup           ( const CVector<uint8_t>& vecData,
+                                          int&                    iPos );
+
+    // evaluates the body of a regular message (used for the received messages
+    // and the messages of the session setup)
+    bool EvaluateMessageBody ( const CVector<uint8_t>& vecbyMesBodyData,
+                               const int               iRecID );
+
+    int GetNumMessFittingContainer() const;
 
     bool EvaluateCLPingMes               ( const CHostAddress&     InetAddr,
                                            const CVector<uint8_t>& vecData );
@@ -266,25 +548,94 @@ protected:
                                            const CVector<uint8_t>& vecData );
     bool EvaluateCLRegisterServerResp    ( const CHostAddress&     InetAddr,
                                            const CVector<uint8_t>& vecData );
+    bool EvaluateCLChannelLevelDeltaMes  ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLSendEmptyMesListMes   ( const CVector<uint8_t>& vecData );
+    bool EvaluateCLServerFeaturesMes     ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLFederationUpdateMes   ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLReqFederationSyncMes  ( const CHostAddress&     InetAddr );
+    bool EvaluateCLReqServerListPageMes  ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLServerListPageMes     ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLReqServerListIPv6Mes  ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLServerListIPv6Mes     ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLRttProbeMes           ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLRttProbeEchoMes       ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLReqLatencyProbeMes    ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLLatencyProbeMes       ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLServerLoadMes         ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLRegisterServerRetryMes ( const CHostAddress&     InetAddr,
+                                            const CVector<uint8_t>& vecData );
 
     int                     iOldRecID;
     int                     iOldRecCnt;
 
-    // these two objects must be sequred by a mutex
+    // the acknowledgements of the messages of a container are collected and
+    // sent in containers, too
+    bool                         bCollectAckn;
+    std::list<CProtMessage>      vecAcknMessages;
+    CVector<uint8_t>             vecbyContainerFrame;
+    CVector<uint8_t>             vecbyContainerBody;
+
+    // receive side of the sliding window: if the other side sent its protocol
+    // version, the messages are only processed in the order of the counter
+    bool                    bInOrderReceive;
+    int                     iNextRecCnt;
+
+    // these objects must be sequred by a mutex
     uint8_t                 iCounter;
     std::list<CSendMessage> SendMessQueue;
-
-    QTimer                  TimerSendMess;
+    int                     iNumMessInFlight;
+    bool                    bProtVersionSent;
+    bool                    bProtVersionAckn;
+    int                     iPeerProtVersion;
+    int                     iPeerWindowSize;
+    bool                    bSendPending;
+
+    // number of messages which are sent together with the protocol version
+    // message in the first container of the session (zero if not used)
+    int                     iStartWindowSize;
+
+    // session setup: collected message bodies (send side) and the hold-back of
+    // the first messages (receive side, server)
+    bool                    bCollectSessionSetup;
+    CVector<uint8_t>        vecbySessionSetup;
+    CVector<uint8_t>        vecbySessionSetupBody;
+    bool                    bWaitForSessionSetup;
+
+    CWheelTimer             TimerSendMess;
+    CWheelTimer             TimerSessionSetup;
     QMutex                  Mutex;
 
 public slots:
-    void OnTimerSendMess() { SendMessage(); }
+    void OnTimerSendMess() { SendMessage ( true ); }
+    void OnTimerSessionSetup();
+
+    void OnSendPendingMessages()
+    {
+        Mutex.lock();
+        bSendPending = false;
+        Mutex.unlock();
+
+        SendMessage ( false );
+    }
 
 signals:
     // transmitting
-    void MessReadyForSending   ( CVector<uint8_t> vecMessage );
-    void CLMessReadyForSending ( CHostAddress     InetAddr,
-                                 CVector<uint8_t> vecMessage );
+    void MessReadyForSending   ( CProtMessage Message );
+    void SessionSetupMissing();
+    void CLMessReadyForSending ( CHostAddress InetAddr,
+                                 CProtMessage Message );
 
     // receiving
     void ChangeJittBufSize ( int iNewJitBufSize );
@@ -295,6 +646,10 @@ signals:
     void ChangeChanPan ( int iChanID, double dNewPan );
     void MuteStateHasChangedReceived ( int iCurID, bool bIsMuted );
     void ConClientListMesReceived ( CVector<CChannelInfo> vecChanInfo );
+    void ConClientListDeltaMesReceived ( int                   iListVersion,
+                                         int                   iFlags,
+                                         CVector<CChannelInfo> vecChanInfo,
+                                         CVector<int>          veciLeftChanIDs );
     void ServerFullMesReceived();
     void ReqConnClientsList();
     void ChangeChanInfo ( CChannelCoreInfo ChanInfo );
@@ -306,6 +661,15 @@ signals:
     void ReqChannelLevelList ( bool bOptIn );
     void VersionAndOSReceived ( COSUtil::EOpSystemType eOSType, QString strVersion );
     void RecorderStateReceived ( ERecorderState eRecorderState );
+    void ReqChannelLevelDelta ( int iInterval );
+    void ListenerModeReceived ( bool bIsListener );
+    void MixGroupReceived ( int iMixGroup );
+    void ChangeMixGroupGain ( int iMixGroup, double dNewGain );
+    void MixGroupListReceived ( CVector<int> vecMixGroups );
+    void MulticastGroupReceived ( int iStream, CHostAddress GroupAddr );
+    void MulticastJoinedReceived ( int iStream );
+    void ReqNetStats();
+    void NetStatsReceived ( int iNumReceived, int iNumLost );
 
     void CLPingReceived               ( CHostAddress           InetAddr,
                                         int                    iMs );
@@ -332,4 +696,38 @@ signals:
                                         CVector<uint16_t>      vecLevelList );
     void CLRegisterServerResp         ( CHostAddress           InetAddr,
                                         ESvrRegResult          eStatus );
+    void CLChannelLevelDeltaReceived  ( CHostAddress           InetAddr,
+                                        int                    iSeqNum,
+                                        bool                   bFullList,
+                                        CVector<uint16_t>      vecLevelList );
+    void CLServerFeaturesReceived     ( CHostAddress           InetAddr,
+                                        uint32_t               iFeatures );
+    void CLFederationUpdateReceived   ( CHostAddress                   InetAddr,
+                                        CVector<CFederationServerInfo> vecServerInfo );
+    void CLReqFederationSync          ( CHostAddress           InetAddr );
+    void CLReqServerListPage          ( CHostAddress           InetAddr,
+                                        CServerListFilter      Filter,
+                                        int                    iPage );
+    void CLServerListPageReceived     ( CHostAddress           InetAddr,
+                                        int                    iPage,
+                                        int                    iNumPages,
+                                        CVector<CServerInfo>   vecServerInfo );
+    void CLReqServerListIPv6          ( CHostAddress           InetAddr,
+                                        CServerListFilter      Filter );
+    void CLServerListIPv6Received     ( CHostAddress           InetAddr,
+                                        CVector<CServerInfo>   vecServerInfo );
+    void CLRttProbeReceived           ( CHostAddress           InetAddr,
+                                        int                    iMs );
+    void CLRttProbeEchoReceived       ( CHostAddress           InetAddr,
+                                        int                    iMs );
+    void CLReqLatencyProbe            ( CHostAddress           InetAddr,
+                                        int                    iMs );
+    void CLLatencyProbeReceived       ( CHostAddress           InetAddr,
+                                        CServerLatencyInfo     LatencyInfo );
+    void CLServerLoadReceived         ( CHostAddress           InetAddr,
+                                        QString                strPool,
+                                        int                    iNumClients,
+                                        int                    iLoadPct );
+    void CLRegisterServerRetryReceived ( CHostAddress          InetAddr,
+                                         int                   iRetryAfterS );
 };
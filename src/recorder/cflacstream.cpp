@@ -0,0 +1,539 @@
+/******************************************************************************\
+ * Copyright (c) 2020
+ *
+ * Author(s):
+ *  pljones
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "cflacstream.h"
+
+using namespace recorder;
+
+/******************************************************************************\
+* Implementations of recorder.CFlacStream methods                              *
+\******************************************************************************/
+
+/**
+ * @brief CFlacStream::CFlacStream Start a FLAC stream on the given device
+ * @param iod the device to write to, needs to be seekable for finalise()
+ * @param numChannels 1 for mono, 2 for stereo
+ */
+CFlacStream::CFlacStream(QIODevice* iod, const uint16_t numChannels) :
+    device (iod),
+    numChannels (numChannels),
+    initialPos (iod->pos()),
+    midSamples (FLAC_STREAM_BLOCK_SIZE),
+    sideSamples (FLAC_STREAM_BLOCK_SIZE),
+    residual (FLAC_STREAM_BLOCK_SIZE),
+    blockFill (0),
+    frameNumber (0),
+    totalSamples (0),
+    minFrameSize (0),
+    maxFrameSize (0),
+    bitBuffer (0),
+    bitCount (0),
+    hasWriteFailed (false)
+{
+    channelSamples[0].resize(FLAC_STREAM_BLOCK_SIZE);
+    channelSamples[1].resize(FLAC_STREAM_BLOCK_SIZE);
+
+    // worst case frame size (verbatim samples plus headers)
+    frame.reserve(FLAC_STREAM_BLOCK_SIZE * 2 * 3 + 64);
+
+    writeStreamInfo();
+}
+
+/**
+ * @brief CFlacStream::writeSamples Append PCM samples to the stream
+ * @param pcm the (interleaved) samples
+ * @param numSamples the number of samples (of all channels)
+ */
+void CFlacStream::writeSamples(const int16_t* pcm, const int numSamples)
+{
+    const int numFrameSamples = numSamples / numChannels;
+
+    for (int i = 0; i < numFrameSamples; i++)
+    {
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            channelSamples[ch][blockFill] = pcm[i * numChannels + ch];
+        }
+
+        if (++blockFill == FLAC_STREAM_BLOCK_SIZE)
+        {
+            encodeFrame();
+        }
+    }
+}
+
+/**
+ * @brief CFlacStream::finalise Write the remaining samples and update the STREAMINFO block
+ */
+void CFlacStream::finalise()
+{
+    encodeFrame();
+
+    const int64_t currentPos = device->pos();
+
+    device->seek(initialPos);
+    writeStreamInfo();
+    device->seek(currentPos);
+}
+
+/**
+ * @brief CFlacStream::writeStreamInfo Write the stream marker and the STREAMINFO metadata block
+ */
+void CFlacStream::writeStreamInfo()
+{
+    const int blockSize = (totalSamples > 0 && totalSamples < FLAC_STREAM_BLOCK_SIZE) ?
+                          static_cast<int>(totalSamples) : FLAC_STREAM_BLOCK_SIZE;
+
+    frame.clear();
+
+    writeBits(0x664C6143, 32); // "fLaC"
+    writeBits(0x80, 8);        // last metadata block, STREAMINFO
+    writeBits(34, 24);         // length of the STREAMINFO block
+
+    writeBits(blockSize, 16); // minimum block size
+    writeBits(blockSize, 16); // maximum block size
+    writeBits(minFrameSize, 24);
+    writeBits(maxFrameSize, 24);
+    writeBits(FmtSubChunk::sampleRate, 20);
+    writeBits(numChannels - 1, 3);
+    writeBits(FmtSubChunk::bitsPerSample - 1, 5);
+    writeBits(static_cast<uint32_t>(totalSamples >> 32), 4);
+    writeBits(static_cast<uint32_t>(totalSamples), 32);
+
+    for (int i = 0; i < 16; i++)
+    {
+        writeBits(0, 8); // MD5 signature not calculated
+    }
+
+    if (device->write(frame) != frame.size())
+    {
+        hasWriteFailed = true;
+    }
+}
+
+/**
+ * @brief CFlacStream::encodeFrame Encode the collected samples to one FLAC frame
+ */
+void CFlacStream::encodeFrame()
+{
+    const int blockSize = blockFill;
+
+    if (blockSize == 0)
+    {
+        return;
+    }
+
+    // select the stereo decorrelation with the lowest estimated cost
+    int channelAssignment = 0; // mono
+
+    if (numChannels == 2)
+    {
+        for (int i = 0; i < blockSize; i++)
+        {
+            midSamples[i]  = (channelSamples[0][i] + channelSamples[1][i]) >> 1;
+            sideSamples[i] = channelSamples[0][i] - channelSamples[1][i];
+        }
+
+        uint64_t costLeft, costRight, costMid, costSide;
+
+        bestFixedOrder(channelSamples[0].constData(), blockSize, costLeft);
+        bestFixedOrder(channelSamples[1].constData(), blockSize, costRight);
+        bestFixedOrder(midSamples.constData(), blockSize, costMid);
+        bestFixedOrder(sideSamples.constData(), blockSize, costSide);
+
+        uint64_t bestCost = costLeft + costRight;
+        channelAssignment = 1; // left/right
+
+        if (costLeft + costSide < bestCost)
+        {
+            bestCost = costLeft + costSide;
+            channelAssignment = 8; // left/side
+        }
+        if (costSide + costRight < bestCost)
+        {
+            bestCost = costSide + costRight;
+            channelAssignment = 9; // side/right
+        }
+        if (costMid + costSide < bestCost)
+        {
+            channelAssignment = 10; // mid/side
+        }
+    }
+
+    frame.clear();
+
+    // frame header
+    writeBits(0xFFF8, 16); // sync code, fixed block size
+    writeBits(blockSize == FLAC_STREAM_BLOCK_SIZE ? 12 : 7, 4); // 4096 or 16 bit value at the end of the header
+    writeBits(10, 4); // 48 kHz
+    writeBits(channelAssignment, 4);
+    writeBits(4, 3); // 16 bits per sample
+    writeBits(0, 1);
+    writeUtf8(frameNumber);
+
+    if (blockSize != FLAC_STREAM_BLOCK_SIZE)
+    {
+        writeBits(blockSize - 1, 16);
+    }
+
+    writeBits(crc8(frame.constData(), frame.size()), 8);
+
+    // subframes (the side channel needs one more bit)
+    switch (channelAssignment)
+    {
+    case 0:
+        encodeSubframe(channelSamples[0].constData(), blockSize, 16);
+        break;
+
+    case 1:
+        encodeSubframe(channelSamples[0].constData(), blockSize, 16);
+        encodeSubframe(channelSamples[1].constData(), blockSize, 16);
+        break;
+
+    case 8:
+        encodeSubframe(channelSamples[0].constData(), blockSize, 16);
+        encodeSubframe(sideSamples.constData(), blockSize, 17);
+        break;
+
+    case 9:
+        encodeSubframe(sideSamples.constData(), blockSize, 17);
+        encodeSubframe(channelSamples[1].constData(), blockSize, 16);
+        break;
+
+    default:
+        encodeSubframe(midSamples.constData(), blockSize, 16);
+        encodeSubframe(sideSamples.constData(), blockSize, 17);
+        break;
+    }
+
+    // frame footer
+    alignToByte();
+    writeBits(crc16(frame.constData(), frame.size()), 16);
+
+    if (device->write(frame) != frame.size())
+    {
+        hasWriteFailed = true;
+    }
+
+    if (minFrameSize == 0 || frame.size() < minFrameSize)
+    {
+        minFrameSize = frame.size();
+    }
+    if (frame.size() > maxFrameSize)
+    {
+        maxFrameSize = frame.size();
+    }
+
+    totalSamples += static_cast<uint64_t>(blockSize);
+    frameNumber++;
+    blockFill = 0;
+}
+
+/**
+ * @brief CFlacStream::encodeSubframe Encode one channel of the frame with a fixed predictor
+ * @param samples the samples of the channel
+ * @param blockSize the number of samples
+ * @param bitsPerSample the sample resolution of the subframe
+ */
+void CFlacStream::encodeSubframe(const qint32* samples, const int blockSize, const int bitsPerSample)
+{
+    uint64_t  cost;
+    const int order = bestFixedOrder(samples, blockSize, cost);
+
+    // subframe header: FIXED subframe of the given order, no wasted bits
+    writeBits(0, 1);
+    writeBits(0x08 | order, 6);
+    writeBits(0, 1);
+
+    // warm-up samples
+    for (int i = 0; i < order; i++)
+    {
+        writeBits(static_cast<uint32_t>(samples[i]), bitsPerSample);
+    }
+
+    fixedResidual(samples, blockSize, order, residual.data());
+
+    // find the partition order with the lowest number of bits, the Rice
+    // parameter of a partition is estimated from the mean of the residual
+    int      bestPartitionOrder = 0;
+    uint64_t bestBits           = 0;
+
+    for (int partitionOrder = 0; partitionOrder <= FLAC_STREAM_MAX_PARTITION_ORDER; partitionOrder++)
+    {
+        const int partitionSize = blockSize >> partitionOrder;
+
+        if ((blockSize & ((1 << partitionOrder) - 1)) != 0 || partitionSize <= order)
+        {
+            break;
+        }
+
+        uint64_t bits = 0;
+        int      idx  = 0;
+
+        for (int partition = 0; partition < (1 << partitionOrder); partition++)
+        {
+            const int count = partition == 0 ? partitionSize - order : partitionSize;
+            uint64_t  sum   = 0;
+
+            for (int i = 0; i < count; i++, idx++)
+            {
+                const uint32_t u = (static_cast<uint32_t>(residual[idx]) << 1) ^ static_cast<uint32_t>(residual[idx] >> 31);
+                sum += u;
+            }
+
+            int riceParameter = 0;
+            while (riceParameter < 14 && (static_cast<uint64_t>(count) << (riceParameter + 1)) <= sum)
+            {
+                riceParameter++;
+            }
+
+            bits += 4 + static_cast<uint64_t>(count) * (riceParameter + 1) + (sum >> riceParameter);
+        }
+
+        if (partitionOrder == 0 || bits < bestBits)
+        {
+            bestBits           = bits;
+            bestPartitionOrder = partitionOrder;
+        }
+    }
+
+    // residual coding method: Rice with 4 bit parameters
+    writeBits(0, 2);
+    writeBits(bestPartitionOrder, 4);
+
+    const int partitionSize = blockSize >> bestPartitionOrder;
+    int       idx           = 0;
+
+    for (int partition = 0; partition < (1 << bestPartitionOrder); partition++)
+    {
+        const int count = partition == 0 ? partitionSize - order : partitionSize;
+        uint64_t  sum   = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            sum += (static_cast<uint32_t>(residual[idx + i]) << 1) ^ static_cast<uint32_t>(residual[idx + i] >> 31);
+        }
+
+        int riceParameter = 0;
+        while (riceParameter < 14 && (static_cast<uint64_t>(count) << (riceParameter + 1)) <= sum)
+        {
+            riceParameter++;
+        }
+
+        writeBits(riceParameter, 4);
+
+        for (int i = 0; i < count; i++, idx++)
+        {
+            const uint32_t u = (static_cast<uint32_t>(residual[idx]) << 1) ^ static_cast<uint32_t>(residual[idx] >> 31);
+
+            writeUnary(u >> riceParameter);
+            writeBits(u, riceParameter);
+        }
+    }
+}
+
+/**
+ * @brief CFlacStream::bestFixedOrder Find the fixed predictor order with the smallest residual
+ * @param samples the samples of the channel
+ * @param blockSize the number of samples
+ * @param cost returns the sum of the absolute residual values of the selected order
+ * @return the order (0 to 4)
+ */
+int CFlacStream::bestFixedOrder(const qint32* samples, const int blockSize, uint64_t& cost)
+{
+    uint64_t sumAbs[5] = { 0, 0, 0, 0, 0 };
+
+    if (blockSize <= 4)
+    {
+        for (int i = 0; i < blockSize; i++)
+        {
+            sumAbs[0] += static_cast<uint64_t>(qAbs(samples[i]));
+        }
+
+        cost = sumAbs[0];
+        return 0;
+    }
+
+    for (int i = 4; i < blockSize; i++)
+    {
+        const qint32 e0 = samples[i];
+        const qint32 e1 = e0 - samples[i - 1];
+        const qint32 e2 = e1 - (samples[i - 1] - samples[i - 2]);
+        const qint32 e3 = e2 - (samples[i - 1] - 2 * samples[i - 2] + samples[i - 3]);
+        const qint32 e4 = e3 - (samples[i - 1] - 3 * samples[i - 2] + 3 * samples[i - 3] - samples[i - 4]);
+
+        sumAbs[0] += static_cast<uint64_t>(qAbs(e0));
+        sumAbs[1] += static_cast<uint64_t>(qAbs(e1));
+        sumAbs[2] += static_cast<uint64_t>(qAbs(e2));
+        sumAbs[3] += static_cast<uint64_t>(qAbs(e3));
+        sumAbs[4] += static_cast<uint64_t>(qAbs(e4));
+    }
+
+    int order = 0;
+
+    for (int i = 1; i < 5; i++)
+    {
+        if (sumAbs[i] < sumAbs[order])
+        {
+            order = i;
+        }
+    }
+
+    cost = sumAbs[order];
+    return order;
+}
+
+/**
+ * @brief CFlacStream::fixedResidual Calculate the residual of a fixed predictor
+ * @param samples the samples of the channel
+ * @param blockSize the number of samples
+ * @param order the predictor order
+ * @param residual returns blockSize - order residual values
+ */
+void CFlacStream::fixedResidual(const qint32* samples, const int blockSize, const int order, qint32* residual)
+{
+    const qint32* x = samples;
+
+    for (int i = order; i < blockSize; i++)
+    {
+        switch (order)
+        {
+        case 0:
+            residual[i - order] = x[i];
+            break;
+        case 1:
+            residual[i - order] = x[i] - x[i - 1];
+            break;
+        case 2:
+            residual[i - order] = x[i] - 2 * x[i - 1] + x[i - 2];
+            break;
+        case 3:
+            residual[i - order] = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];
+            break;
+        default:
+            residual[i - order] = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4];
+            break;
+        }
+    }
+}
+
+uint8_t CFlacStream::crc8(const char* data, const int size)
+{
+    uint8_t crc = 0;
+
+    for (int i = 0; i < size; i++)
+    {
+        crc ^= static_cast<uint8_t>(data[i]);
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+quint16 CFlacStream::crc16(const char* data, const int size)
+{
+    quint16 crc = 0;
+
+    for (int i = 0; i < size; i++)
+    {
+        crc ^= static_cast<quint16>(static_cast<uint8_t>(data[i]) << 8);
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? static_cast<quint16>((crc << 1) ^ 0x8005) : static_cast<quint16>(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * @brief CFlacStream::writeBits Append the lower numBits bits of value to the frame buffer (MSB first)
+ */
+void CFlacStream::writeBits(const uint32_t value, const int numBits)
+{
+    if (numBits == 0)
+    {
+        return;
+    }
+
+    const uint32_t mask = numBits == 32 ? 0xFFFFFFFF : ((1u << numBits) - 1);
+
+    bitBuffer = (bitBuffer << numBits) | (value & mask);
+    bitCount += numBits;
+
+    while (bitCount >= 8)
+    {
+        bitCount -= 8;
+        frame.append(static_cast<char>(bitBuffer >> bitCount));
+    }
+}
+
+void CFlacStream::writeUnary(uint32_t value)
+{
+    while (value >= 32)
+    {
+        writeBits(0, 32);
+        value -= 32;
+    }
+
+    writeBits(1, value + 1);
+}
+
+/**
+ * @brief CFlacStream::writeUtf8 Append a number in the "UTF-8" coding used by the FLAC frame header
+ */
+void CFlacStream::writeUtf8(uint64_t value)
+{
+    if (value < 0x80)
+    {
+        writeBits(static_cast<uint32_t>(value), 8);
+        return;
+    }
+
+    int numBytes = 2;
+    while (numBytes < 7 && value >= (static_cast<uint64_t>(1) << (5 * numBytes + 1)))
+    {
+        numBytes++;
+    }
+
+    writeBits(((0xFF << (8 - numBytes)) & 0xFF) | static_cast<uint32_t>(value >> (6 * (numBytes - 1))), 8);
+
+    for (int i = numBytes - 2; i >= 0; i--)
+    {
+        writeBits(0x80 | static_cast<uint32_t>((value >> (6 * i)) & 0x3F), 8);
+    }
+}
+
+void CFlacStream::alignToByte()
+{
+    if (bitCount > 0)
+    {
+        writeBits(0, 8 - bitCount);
+    }
+}
@@ -0,0 +1,97 @@
+/******************************************************************************\
+ * Copyright (c) 2020
+ *
+ * Author(s):
+ *  pljones
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QVector>
+
+#include "cwavestream.h"
+
+// number of samples (per channel) of a FLAC frame
+#define FLAC_STREAM_BLOCK_SIZE               4096
+
+// highest partition order tried for the Rice coded residual
+#define FLAC_STREAM_MAX_PARTITION_ORDER      8
+
+namespace recorder {
+
+/**
+ * @brief Minimal FLAC encoder for the recorder
+ *
+ * Uses the fixed predictors (order 0 to 4) with Rice coded residuals and the
+ * stereo decorrelation modes of FLAC. This gives most of the compression of the
+ * reference encoder at a fraction of the complexity and needs no external library.
+ * The STREAMINFO block is rewritten by finalise(), a file which was not finalised
+ * is still decodable (the total number of samples is unknown then).
+ */
+class CFlacStream : public CRecordingStream
+{
+public:
+    CFlacStream(QIODevice* iod, const uint16_t numChannels);
+
+    virtual void writeSamples(const int16_t* pcm, const int numSamples);
+
+    virtual void finalise();
+
+    virtual bool writeFailed() const { return hasWriteFailed; }
+
+private:
+    void writeStreamInfo();
+    void encodeFrame();
+    void encodeSubframe(const qint32* samples, const int blockSize, const int bitsPerSample);
+
+    static int     bestFixedOrder(const qint32* samples, const int blockSize, uint64_t& cost);
+    static void    fixedResidual(const qint32* samples, const int blockSize, const int order, qint32* residual);
+    static uint8_t crc8(const char* data, const int size);
+    static quint16 crc16(const char* data, const int size);
+
+    void writeBits(const uint32_t value, const int numBits);
+    void writeUnary(uint32_t value);
+    void writeUtf8(uint64_t value);
+    void alignToByte();
+
+    QIODevice* const device;
+    const uint16_t   numChannels;
+    const int64_t    initialPos;
+
+    QVector<qint32>  channelSamples[2];
+    QVector<qint32>  midSamples;
+    QVector<qint32>  sideSamples;
+    QVector<qint32>  residual;
+    int              blockFill;
+
+    uint64_t         frameNumber;
+    uint64_t         totalSamples;
+    int              minFrameSize;
+    int              maxFrameSize;
+
+    QByteArray       frame;
+    uint64_t         bitBuffer;
+    int              bitCount;
+    bool             hasWriteFailed;
+};
+
+}
@@ -72,7 +72,8 @@ CReaperItem::CReaperItem(const QString& name, const STrackItem& trackItem, const
     sOut << "      NAME " << name << endl;
     sOut << "      GUID " << guid.toString() << endl;
 
-    sOut << "      <SOURCE WAVE" << endl;
+    // Reaper identifies the source type by the section name
+    sOut << "      <SOURCE " << (wavName.endsWith(".flac", Qt::CaseInsensitive) ? "FLAC" : "WAVE") << endl;
     sOut << "        FILE " << '"' << wavName << '"' << endl;
     sOut << "      >" << endl;
 
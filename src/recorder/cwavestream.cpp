@@ -24,6 +24,14 @@
 
 #include "cwavestream.h"
 
+#include <QFileDevice>
+#include <QtEndian>
+#include <cstring>
+
+#if defined ( __linux__ )
+# include <fcntl.h>
+#endif
+
 /******************************************************************************\
 * Overrides in global namespace                                                *
 \******************************************************************************/
@@ -82,7 +90,12 @@ CWaveStream::CWaveStream(const uint16_t numChannels) :
     QDataStream(),
     numChannels (numChannels),
     initialPos (device()->pos()),
-    initialByteOrder (byteOrder())
+    initialByteOrder (byteOrder()),
+    buffer (WAVE_STREAM_BUFFER_SIZE_BYTES, 0),
+    bufferFill (0),
+    preallocatedPos (0),
+    bytesSinceHeaderSync (0),
+    headerSyncIntervalBytes (static_cast<int64_t>(WAVE_STREAM_HEADER_SYNC_INTERVAL_S) * FmtSubChunk::sampleRate * numChannels * FmtSubChunk::bitsPerSample / 8)
 {
     waveStreamHeaders();
 }
@@ -90,7 +103,12 @@ CWaveStream::CWaveStream(QIODevice *iod, const uint16_t numChannels) :
     QDataStream(iod),
     numChannels (numChannels),
     initialPos (device()->pos()),
-    initialByteOrder (byteOrder())
+    initialByteOrder (byteOrder()),
+    buffer (WAVE_STREAM_BUFFER_SIZE_BYTES, 0),
+    bufferFill (0),
+    preallocatedPos (0),
+    bytesSinceHeaderSync (0),
+    headerSyncIntervalBytes (static_cast<int64_t>(WAVE_STREAM_HEADER_SYNC_INTERVAL_S) * FmtSubChunk::sampleRate * numChannels * FmtSubChunk::bitsPerSample / 8)
 {
     waveStreamHeaders();
 }
@@ -98,7 +116,12 @@ CWaveStream::CWaveStream(QByteArray *iod, QIODevice::OpenMode flags, const uint1
     QDataStream(iod, flags),
     numChannels (numChannels),
     initialPos (device()->pos()),
-    initialByteOrder (byteOrder())
+    initialByteOrder (byteOrder()),
+    buffer (WAVE_STREAM_BUFFER_SIZE_BYTES, 0),
+    bufferFill (0),
+    preallocatedPos (0),
+    bytesSinceHeaderSync (0),
+    headerSyncIntervalBytes (static_cast<int64_t>(WAVE_STREAM_HEADER_SYNC_INTERVAL_S) * FmtSubChunk::sampleRate * numChannels * FmtSubChunk::bitsPerSample / 8)
 {
     waveStreamHeaders();
 }
@@ -106,7 +129,12 @@ CWaveStream::CWaveStream(const QByteArray &ba, const uint16_t numChannels) :
     QDataStream(ba),
     numChannels (numChannels),
     initialPos (device()->pos()),
-    initialByteOrder (byteOrder())
+    initialByteOrder (byteOrder()),
+    buffer (WAVE_STREAM_BUFFER_SIZE_BYTES, 0),
+    bufferFill (0),
+    preallocatedPos (0),
+    bytesSinceHeaderSync (0),
+    headerSyncIntervalBytes (static_cast<int64_t>(WAVE_STREAM_HEADER_SYNC_INTERVAL_S) * FmtSubChunk::sampleRate * numChannels * FmtSubChunk::bitsPerSample / 8)
 {
     waveStreamHeaders();
 }
@@ -121,7 +149,102 @@ void CWaveStream::waveStreamHeaders()
     *this << scHdrRiff << cFmtSubChunk << scDataSubChunkHdr;
 }
 
-void CWaveStream::finalise()
+/**
+ * @brief CWaveStream::writeSamples Append PCM samples to the data chunk
+ * @param pcm the (interleaved) samples
+ * @param numSamples the number of samples (of all channels)
+ *
+ * The samples are collected in the buffer which is written to the device as one
+ * block if it is full. The header is updated every WAVE_STREAM_HEADER_SYNC_INTERVAL_S.
+ */
+void CWaveStream::writeSamples(const int16_t* pcm, const int numSamples)
+{
+    const int numBytes = numSamples * static_cast<int>(sizeof(int16_t));
+
+    if (bufferFill + numBytes > buffer.size())
+    {
+        flushBuffer();
+    }
+
+    if (numBytes > buffer.size())
+    {
+        // does not fit in the buffer at all (does not happen for audio frames)
+        for (int i = 0; i < numSamples; i++)
+        {
+            *this << pcm[i];
+        }
+    }
+    else
+    {
+        char* dest = buffer.data() + bufferFill;
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        memcpy(dest, pcm, static_cast<size_t>(numBytes));
+#else
+        for (int i = 0; i < numSamples; i++)
+        {
+            qToLittleEndian<qint16>(pcm[i], dest + i * sizeof(int16_t));
+        }
+#endif
+        bufferFill += numBytes;
+    }
+
+    bytesSinceHeaderSync += numBytes;
+
+    if (bytesSinceHeaderSync >= headerSyncIntervalBytes)
+    {
+        flushBuffer();
+        updateHeaders();
+        bytesSinceHeaderSync = 0;
+    }
+}
+
+/**
+ * @brief CWaveStream::flushBuffer Write the buffered samples to the device
+ */
+void CWaveStream::flushBuffer()
+{
+    if (bufferFill == 0)
+    {
+        return;
+    }
+
+    preallocate(device()->pos() + bufferFill);
+
+    writeRawData(buffer.constData(), bufferFill);
+    bufferFill = 0;
+}
+
+/**
+ * @brief CWaveStream::preallocate Make sure the file space up to endPos is allocated
+ * @param endPos the file position which is about to be written
+ *
+ * The space is allocated in large steps without changing the file size so that
+ * the file stays valid. Errors are ignored since this is only an optimisation.
+ */
+void CWaveStream::preallocate(const int64_t endPos)
+{
+    if (endPos <= preallocatedPos)
+    {
+        return;
+    }
+
+#if defined ( __linux__ )
+    QFileDevice* fileDevice = qobject_cast<QFileDevice*>(device());
+
+    if (fileDevice != nullptr && fileDevice->handle() >= 0)
+    {
+        fallocate(fileDevice->handle(), FALLOC_FL_KEEP_SIZE, endPos, WAVE_STREAM_PREALLOC_SIZE_BYTES);
+    }
+#endif
+
+    preallocatedPos = endPos + WAVE_STREAM_PREALLOC_SIZE_BYTES;
+}
+
+/**
+ * @brief CWaveStream::updateHeaders Write the current RIFF and data chunk sizes to the header
+ */
+void CWaveStream::updateHeaders()
 {
     static const uint32_t hdrRiffChunkSize = sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint32_t);
     static const uint32_t fmtSubChunkSize = sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint16_t);
@@ -142,7 +265,15 @@ void CWaveStream::finalise()
     this->device()->seek(initialPos + dataSubChunkHdrChunkSizeOffset);
     out << static_cast<uint32_t>(fileLength - (dataSubChunkHdrChunkSizeOffset + sizeof (uint32_t)));
 
-    // and then restore the position and byte order
+    // and then restore the position
     this->device()->seek(currentPos);
+}
+
+void CWaveStream::finalise()
+{
+    flushBuffer();
+    updateHeaders();
+
+    // and then restore the byte order
     setByteOrder(initialByteOrder);
 }
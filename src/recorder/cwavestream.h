@@ -25,6 +25,17 @@
 #pragma once
 
 #include <QDataStream>
+#include <QByteArray>
+
+// the PCM data is collected in a buffer of this size and written as one block
+#define WAVE_STREAM_BUFFER_SIZE_BYTES        1048576 // 1 MiB
+
+// the file is extended in steps of this size to avoid fragmentation (Linux only)
+#define WAVE_STREAM_PREALLOC_SIZE_BYTES      16777216 // 16 MiB
+
+// the RIFF and data chunk sizes in the header are updated in this interval so
+// that the file is usable even if the server is not shut down normally
+#define WAVE_STREAM_HEADER_SYNC_INTERVAL_S   10 // s
 
 namespace recorder {
 
@@ -91,7 +102,25 @@ public:
     static const uint32_t chunkSize = 0xffffffff; // (will be overwritten) Size of data
 };
 
-class CWaveStream : public QDataStream
+/**
+ * @brief Interface of the audio file writers used by the recorder
+ */
+class CRecordingStream
+{
+public:
+    virtual ~CRecordingStream() {}
+
+    virtual void writeSamples(const int16_t* pcm, const int numSamples) = 0;
+
+    virtual void finalise() = 0;
+
+    /**
+     * @brief writeFailed True if a write to the device failed (e.g. the disk is full)
+     */
+    virtual bool writeFailed() const = 0;
+};
+
+class CWaveStream : public QDataStream, public CRecordingStream
 {
 public:
     CWaveStream(const uint16_t numChannels);
@@ -99,14 +128,27 @@ public:
     CWaveStream(QByteArray *iod, QIODevice::OpenMode flags, const uint16_t numChannels);
     CWaveStream(const QByteArray &ba, const uint16_t numChannels);
 
-    void finalise();
+    virtual void writeSamples(const int16_t* pcm, const int numSamples);
+
+    virtual void finalise();
+
+    virtual bool writeFailed() const { return status() == QDataStream::WriteFailed; }
 
 private:
     void waveStreamHeaders();
+    void flushBuffer();
+    void updateHeaders();
+    void preallocate(const int64_t endPos);
 
     const uint16_t numChannels;
     const int64_t initialPos;
     const ByteOrder initialByteOrder;
+
+    QByteArray buffer;
+    int bufferFill;
+    int64_t preallocatedPos;
+    int64_t bytesSinceHeaderSync;
+    const int64_t headerSyncIntervalBytes;
 };
 
 }
@@ -23,9 +23,169 @@
 \******************************************************************************/
 
 #include "jamrecorder.h"
+#include <QThreadPool>
+#include <QRunnable>
+#include "../tracer.h"
+
+#if defined ( __linux__ )
+# include <fcntl.h>
+#endif
 
 using namespace recorder;
 
+/* ********************************************************************************************************
+ * CJamFilePool
+ * ********************************************************************************************************/
+
+/**
+ * @brief CJamFilePool::Init Start the pool thread with a low priority and fill the pool
+ * @param _spareDir Directory of the spare files (the recording base directory)
+ *
+ * The spare files must be on the same file system as the session directories so that
+ * they can be renamed. Spare files left over by a previous run are removed.
+ */
+void CJamFilePool::Init ( const QDir& _spareDir )
+{
+    spareDir = _spareDir;
+
+    const QStringList staleFiles = spareDir.entryList ( QStringList ( QString ( RECORDER_SPARE_FILE_PREFIX ) + "*" + RECORDER_SPARE_FILE_SUFFIX ),
+                                                        QDir::Files | QDir::Hidden );
+
+    for ( int i = 0; i < staleFiles.count(); i++ )
+    {
+        spareDir.remove ( staleFiles[i] );
+    }
+
+    thisThread = new QThread();
+    moveToThread ( thisThread );
+    thisThread->start ( QThread::LowestPriority );
+
+    QMetaObject::invokeMethod ( this, "OnRefill", Qt::QueuedConnection );
+}
+
+/**
+ * @brief CJamFilePool::Take Move a spare file to the path of a new track
+ * @param strFilePath the absolute path of the track file, which must not exist
+ * @return the open, empty file positioned at the start or nullptr if no spare file is available
+ *
+ * The file is renamed while it stays open, i.e. the file name of the returned QFile is
+ * the name of the spare file. If an open file cannot be renamed (Windows), it is closed,
+ * renamed and opened again.
+ */
+QFile* CJamFilePool::Take ( const QString& strFilePath )
+{
+    QFile* file = nullptr;
+
+    Mutex.lock();
+    {
+        if ( !spareFiles.isEmpty() )
+        {
+            file = spareFiles.takeFirst();
+        }
+    }
+    Mutex.unlock();
+
+    if ( file == nullptr )
+    {
+        return nullptr;
+    }
+
+    if ( thisThread != nullptr )
+    {
+        QMetaObject::invokeMethod ( this, "OnRefill", Qt::QueuedConnection );
+    }
+
+    if ( QDir().rename ( file->fileName(), strFilePath ) )
+    {
+        return file;
+    }
+
+    file->close();
+
+    if ( file->rename ( strFilePath ) && file->open ( QFile::OpenMode ( QIODevice::OpenModeFlag::ReadWrite ) ) )
+    {
+        return file;
+    }
+
+    qWarning() << "CJamFilePool::Take():" << file->fileName() << "could not be moved to" << strFilePath;
+
+    file->remove();
+    delete file;
+
+    return nullptr;
+}
+
+/**
+ * @brief CJamFilePool::Finish Stop the pool thread and remove the spare files
+ */
+void CJamFilePool::Finish()
+{
+    if ( thisThread != nullptr )
+    {
+        thisThread->quit();
+        thisThread->wait();
+    }
+
+    RemoveSpareFiles();
+}
+
+/**
+ * @brief CJamFilePool::Refill Create spare files until the pool is full
+ *
+ * The files are preallocated without changing their size (Linux), i.e. they stay empty.
+ */
+void CJamFilePool::Refill()
+{
+    while ( true )
+    {
+        Mutex.lock();
+        const int iNumSpareFiles = spareFiles.count();
+        Mutex.unlock();
+
+        if ( iNumSpareFiles >= RECORDER_FILE_POOL_SIZE )
+        {
+            return;
+        }
+
+        QFile* file = new QFile ( spareDir.absoluteFilePath ( RECORDER_SPARE_FILE_PREFIX + QString::number ( iNextSpareNum++ ) + RECORDER_SPARE_FILE_SUFFIX ) );
+
+        if ( !file->open ( QFile::OpenMode ( QIODevice::OpenModeFlag::ReadWrite | QIODevice::OpenModeFlag::Truncate ) ) )
+        {
+            // the tracks are created by the recorder thread as long as the pool is empty
+            qWarning() << "CJamFilePool::Refill():" << file->fileName() << "could not be created.";
+            delete file;
+            return;
+        }
+
+#if defined ( __linux__ )
+        // errors are ignored since this is only an optimisation
+        fallocate ( file->handle(), FALLOC_FL_KEEP_SIZE, 0, WAVE_STREAM_PREALLOC_SIZE_BYTES );
+#endif
+
+        Mutex.lock();
+        {
+            spareFiles.append ( file );
+        }
+        Mutex.unlock();
+    }
+}
+
+/**
+ * @brief CJamFilePool::RemoveSpareFiles Close and delete all spare files
+ */
+void CJamFilePool::RemoveSpareFiles()
+{
+    QMutexLocker locker ( &Mutex );
+
+    while ( !spareFiles.isEmpty() )
+    {
+        QFile* file = spareFiles.takeFirst();
+
+        file->remove();
+        delete file;
+    }
+}
+
 /* ********************************************************************************************************
  * CJamClient
  * ********************************************************************************************************/
@@ -37,11 +197,14 @@ using namespace recorder;
  * @param name The client's current name
  * @param address IP and Port
  * @param recordBaseDir Session recording directory
+ * @param format WAV or FLAC
+ * @param filePool Pool of spare files (may be nullptr)
  *
- * Creates a file for the raw PCM data and sets up a QDataStream to which to write received frames.
- * The data is stored Little Endian.
+ * Takes a spare file (or creates a file if the pool is empty) for the PCM data and sets up a stream
+ * to which to write received frames.
+ * WAV data is stored Little Endian.
  */
-CJamClient::CJamClient(const qint64 frame, const int _numChannels, const QString name, const CHostAddress address, const QDir recordBaseDir) :
+CJamClient::CJamClient(const qint64 frame, const int _numChannels, const QString name, const CHostAddress address, const QDir recordBaseDir, const ERecordingFormat format, CJamFilePool* filePool) :
     startFrame (frame),
     numChannels (static_cast<uint16_t>(_numChannels)),
     name (name),
@@ -49,38 +212,49 @@ CJamClient::CJamClient(const qint64 frame, const int _numChannels, const QString
 {
     // At this point we may not have much of a name
     QString fileName = ClientName() + "-" + QString::number(frame) + "-" + QString::number(_numChannels);
+    const QString extension = format == RF_FLAC ? ".flac" : ".wav";
     QString affix = "";
-    while (recordBaseDir.exists(fileName + affix + ".wav"))
+    while (recordBaseDir.exists(fileName + affix + extension))
     {
         affix = affix.length() == 0 ? "_1" : "_" + QString::number(affix.remove(0, 1).toInt() + 1);
     }
-    fileName = fileName + affix + ".wav";
+    fileName = fileName + affix + extension;
+    filename = recordBaseDir.absoluteFilePath(fileName);
 
-    wavFile = new QFile(recordBaseDir.absoluteFilePath(fileName));
-    if (!wavFile->open(QFile::OpenMode(QIODevice::OpenModeFlag::ReadWrite))) // need to allow rewriting headers
+    wavFile = filePool != nullptr ? filePool->Take(filename) : nullptr;
+    if (wavFile == nullptr)
+    {
+        wavFile = new QFile(filename);
+        if (!wavFile->open(QFile::OpenMode(QIODevice::OpenModeFlag::ReadWrite))) // need to allow rewriting headers
+        {
+            throw new std::runtime_error( ("Could not write to WAV file "  + wavFile->fileName()).toStdString() );
+        }
+    }
+    if (format == RF_FLAC)
     {
-        throw new std::runtime_error( ("Could not write to WAV file "  + wavFile->fileName()).toStdString() );
+        out = new CFlacStream(wavFile, numChannels);
+    }
+    else
+    {
+        out = new CWaveStream(wavFile, numChannels);
     }
-    out = new CWaveStream(wavFile, numChannels);
-
-    filename = wavFile->fileName();
 }
 
 /**
  * @brief CJamClient::Frame Handle a frame of PCM data from a client connected to the server
  * @param _name The client's current name
  * @param pcm The PCM data
+ * @return false if the file could not be written (e.g. the disk is full)
  */
-void CJamClient::Frame(const QString _name, const CVector<int16_t>& pcm, int iServerFrameSizeSamples)
+bool CJamClient::Frame(const QString& _name, const CVector<int16_t>& pcm, int iServerFrameSizeSamples)
 {
     name = _name;
 
-    for(int i = 0; i < numChannels * iServerFrameSizeSamples; i++)
-    {
-        *out << pcm[i];
-    }
+    out->writeSamples(&pcm[0], numChannels * iServerFrameSizeSamples);
 
     frameCount++;
+
+    return !out->writeFailed();
 }
 
 /**
@@ -88,7 +262,8 @@ void CJamClient::Frame(const QString _name, const CVector<int16_t>& pcm, int iSe
  */
 void CJamClient::Disconnect()
 {
-    static_cast<CWaveStream*>(out)->finalise();
+    out->finalise();
+    delete out;
     out = nullptr;
 
     wavFile->close();
@@ -104,14 +279,18 @@ void CJamClient::Disconnect()
 /**
  * @brief CJamSession::CJamSession Construct a new jam recording session
  * @param recordBaseDir The recording base directory
+ * @param format The file format of the recorded tracks
+ * @param filePool Pool of spare files for the tracks
  *
  * Each session is stored into its own subdirectory of the recording base directory.
  */
-CJamSession::CJamSession(QDir recordBaseDir) :
+CJamSession::CJamSession(QDir recordBaseDir, const ERecordingFormat format, CJamFilePool* filePool) :
     sessionDir (QDir(recordBaseDir.absoluteFilePath("Jam-" + QDateTime().currentDateTimeUtc().toString("yyyyMMdd-HHmmsszzz")))),
+    format (format),
+    filePool (filePool),
     currentFrame (0),
     chIdDisconnected (-1),
-    vecptrJamClients (MAX_NUM_CHANNELS),
+    vecptrJamClients (MAX_NUM_CHANNELS + 1 /* mix */),
     jamClientConnections()
 {
     QFileInfo fi(sessionDir.absolutePath());
@@ -140,6 +319,12 @@ CJamSession::CJamSession(QDir recordBaseDir) :
  */
 void CJamSession::DisconnectClient(int iChID)
 {
+    if (vecptrJamClients[iChID] == nullptr)
+    {
+        // the track was already ended (e.g. a paused track of a client which left)
+        return;
+    }
+
     vecptrJamClients[iChID]->Disconnect();
 
     jamClientConnections.append(new CJamClientConnection(vecptrJamClients[iChID]->NumAudioChannels(),
@@ -148,11 +333,77 @@ void CJamSession::DisconnectClient(int iChID)
                                                          vecptrJamClients[iChID]->ClientName(),
                                                          vecptrJamClients[iChID]->FileName()));
 
+    AppendToIndex(jamClientConnections.last());
+
     delete vecptrJamClients[iChID];
     vecptrJamClients[iChID] = nullptr;
     chIdDisconnected = iChID;
 }
 
+/**
+ * @brief CJamSession::AppendToIndex Add a finished client connection to the session index file
+ * @param connection the connection details
+ *
+ * The index allows the tracks of a session to be read back without scanning the session directory.
+ * Each line holds: name, number of audio channels, start frame, length and file name, separated by tabs.
+ */
+void CJamSession::AppendToIndex(CJamClientConnection* connection)
+{
+    QFile indexFile(sessionDir.filePath(Name() + RECORDER_INDEX_FILE_SUFFIX));
+
+    if (!indexFile.open(QFile::WriteOnly | QFile::Append))
+    {
+        qWarning() << "CJamSession::AppendToIndex():" << indexFile.fileName() << "could not be written.";
+        return;
+    }
+
+    QTextStream sOut(&indexFile);
+    sOut << connection->Name() << '\t'
+         << connection->Format() << '\t'
+         << connection->StartFrame() << '\t'
+         << connection->Length() << '\t'
+         << QFileInfo(connection->FileName()).fileName() << endl;
+}
+
+/**
+ * @brief CJamSession::TracksFromIndex Read the track items of a session from its index file
+ * @param sessionDir the session directory
+ * @param tracks returns the map of client name to connection items
+ * @return false if there is no index file
+ */
+bool CJamSession::TracksFromIndex(const QDir& sessionDir, QMap<QString, QList<STrackItem>>& tracks)
+{
+    QFile indexFile(sessionDir.filePath(sessionDir.dirName() + RECORDER_INDEX_FILE_SUFFIX));
+
+    if (!indexFile.open(QFile::ReadOnly))
+    {
+        return false;
+    }
+
+    QTextStream sIn(&indexFile);
+
+    while (!sIn.atEnd())
+    {
+        const QStringList fields = sIn.readLine().split('\t');
+
+        if (fields.count() != 5)
+        {
+            continue;
+        }
+
+        STrackItem track (
+                    fields[1].toInt(),
+                    fields[2].toLongLong(),
+                    fields[3].toLongLong(),
+                    sessionDir.absoluteFilePath(fields[4])
+                    );
+
+        tracks[fields[0]].append(track);
+    }
+
+    return true;
+}
+
 /**
  * @brief CJamSession::Frame Process a frame emited for a client by the server
  * @param iChID the client channel id
@@ -160,28 +411,29 @@ void CJamSession::DisconnectClient(int iChID)
  * @param address the client IP and port number
  * @param numAudioChannels the client number of audio channels
  * @param data the frame data
+ * @return false if the frame could not be written
  *
  * Manages changes that affect how the recording is stored - i.e. if the number of audio channels changes, we need a new file.
  * Files are grouped by IP and port number, so if either of those change for a connection, we also start a new file.
  *
  * Also manages the overall current frame counter for the session.
  */
-void CJamSession::Frame(const int iChID, const QString name, const CHostAddress address, const int numAudioChannels, const CVector<int16_t> data, int iServerFrameSizeSamples)
+bool CJamSession::Frame(const int iChID, const QString& name, const CHostAddress& address, const int numAudioChannels, const CVector<int16_t>& data, int iServerFrameSizeSamples)
 {
     if ( iChID == chIdDisconnected )
     {
         // DisconnectClient has just been called for this channel - this frame is "too late"
         chIdDisconnected = -1;
-        return;
+        return true;
     }
 
     if (vecptrJamClients[iChID] == nullptr)
     {
         // then we have not seen this client this session
-        vecptrJamClients[iChID] = new CJamClient(currentFrame, numAudioChannels, name, address, sessionDir);
+        vecptrJamClients[iChID] = new CJamClient(currentFrame, numAudioChannels, name, address, sessionDir, format, filePool);
     }
     else if (numAudioChannels != vecptrJamClients[iChID]->NumAudioChannels()
-             || address.InetAddr != vecptrJamClients[iChID]->ClientAddress().InetAddr
+             || !address.IsSameInetAddr(vecptrJamClients[iChID]->ClientAddress())
              || address.iPort != vecptrJamClients[iChID]->ClientAddress().iPort)
     {
         DisconnectClient(iChID);
@@ -191,23 +443,25 @@ void CJamSession::Frame(const int iChID, const QString name, const CHostAddress
         }
         else
         {
-            vecptrJamClients[iChID] = new CJamClient(currentFrame, numAudioChannels, name, address, sessionDir);
+            vecptrJamClients[iChID] = new CJamClient(currentFrame, numAudioChannels, name, address, sessionDir, format, filePool);
         }
     }
 
     if (vecptrJamClients[iChID] == nullptr)
     {
         // Frame allegedly from iChID but unable to establish client details
-        return;
+        return true;
     }
 
-    vecptrJamClients[iChID]->Frame(name, data, iServerFrameSizeSamples);
+    const bool writeOk = vecptrJamClients[iChID]->Frame(name, data, iServerFrameSizeSamples);
 
     // If _any_ connected client frame steps past currentFrame, increase currentFrame
     if (vecptrJamClients[iChID]->StartFrame() + vecptrJamClients[iChID]->FrameCount() > currentFrame)
     {
         currentFrame++;
     }
+
+    return writeOk;
 }
 
 /**
@@ -263,6 +517,13 @@ QMap<QString, QList<STrackItem>> CJamSession::TracksFromSessionDir(const QString
     QMap<QString, QList<STrackItem>> tracks;
 
     const QDir sessionDir(sessionDirName);
+
+    // sessions recorded with an index need no directory scan
+    if (TracksFromIndex(sessionDir, tracks))
+    {
+        return tracks;
+    }
+
     foreach(auto entry, sessionDir.entryList({ "*.pcm" }))
     {
 
@@ -295,6 +556,180 @@ QMap<QString, QList<STrackItem>> CJamSession::TracksFromSessionDir(const QString
     return tracks;
 }
 
+/* ********************************************************************************************************
+ * CJamProjectWriter
+ * ********************************************************************************************************/
+
+/**
+ * @brief CJamProjectWriter::Init Start the writer thread with a low priority
+ */
+void CJamProjectWriter::Init()
+{
+    thisThread = new QThread();
+    moveToThread ( thisThread );
+    thisThread->start ( QThread::LowestPriority );
+}
+
+/**
+ * @brief CJamProjectWriter::Queue Queue the project files of a finished session
+ * @param sessionDir the session directory
+ * @param sessionName the session name (base name of the project files)
+ * @param tracks the tracks of the session, see CJamSession::Tracks()
+ * @param iServerFrameSizeSamples the server frame size
+ */
+void CJamProjectWriter::Queue ( const QDir&                             sessionDir,
+                                const QString&                          sessionName,
+                                const QMap<QString, QList<STrackItem>>& tracks,
+                                const int                               iServerFrameSizeSamples )
+{
+    SProjectJob job;
+
+    job.sessionDir              = sessionDir;
+    job.sessionName             = sessionName;
+    job.tracks                  = tracks;
+    job.iServerFrameSizeSamples = iServerFrameSizeSamples;
+
+    Mutex.lock();
+    {
+        jobs.append ( job );
+    }
+    Mutex.unlock();
+
+    if ( thisThread != nullptr )
+    {
+        QMetaObject::invokeMethod ( this, "OnJobsQueued", Qt::QueuedConnection );
+    }
+    else
+    {
+        WriteJobs();
+    }
+}
+
+/**
+ * @brief CJamProjectWriter::Finish Write the remaining project files and stop the writer thread
+ *
+ * A job which is written by the writer thread in the meantime is completed before the thread stops.
+ */
+void CJamProjectWriter::Finish()
+{
+    WriteJobs();
+
+    if ( thisThread != nullptr )
+    {
+        thisThread->quit();
+        thisThread->wait();
+    }
+}
+
+/**
+ * @brief CJamProjectWriter::WriteJobs Write the project files of all queued sessions
+ */
+void CJamProjectWriter::WriteJobs()
+{
+    while ( true )
+    {
+        SProjectJob job;
+
+        Mutex.lock();
+        {
+            if ( jobs.isEmpty() )
+            {
+                Mutex.unlock();
+                return;
+            }
+
+            job = jobs.takeFirst();
+        }
+        Mutex.unlock();
+
+        WriteReaperProject ( job );
+        WriteAudacityLof ( job );
+    }
+}
+
+/**
+ * @brief CJamProjectWriter::Write Write the project files of a session by the calling thread
+ * @param sessionDir the session directory
+ * @param sessionName the session name (base name of the project files)
+ * @param tracks the tracks of the session
+ * @param iServerFrameSizeSamples the server frame size
+ */
+void CJamProjectWriter::Write ( const QDir&                             sessionDir,
+                                const QString&                          sessionName,
+                                const QMap<QString, QList<STrackItem>>& tracks,
+                                const int                               iServerFrameSizeSamples )
+{
+    SProjectJob job;
+
+    job.sessionDir              = sessionDir;
+    job.sessionName             = sessionName;
+    job.tracks                  = tracks;
+    job.iServerFrameSizeSamples = iServerFrameSizeSamples;
+
+    WriteReaperProject ( job );
+    WriteAudacityLof ( job );
+}
+
+void CJamProjectWriter::WriteReaperProject ( const SProjectJob& job )
+{
+    QString reaperProjectFileName = job.sessionDir.filePath(QString(job.sessionName).append(".rpp"));
+    const QFileInfo fi(reaperProjectFileName);
+
+    if (fi.exists())
+    {
+        qWarning() << "CJamProjectWriter::WriteReaperProject():" << fi.absolutePath() << "exists and will not be overwritten.";
+    }
+    else
+    {
+        QFile outf (reaperProjectFileName);
+        if ( outf.open(QFile::WriteOnly) )
+        {
+            QTextStream out(&outf);
+            out << CReaperProject( job.tracks, job.iServerFrameSizeSamples ).toString() << endl;
+            qDebug() << "Session RPP:" << reaperProjectFileName;
+        }
+        else
+        {
+            qWarning() << "CJamProjectWriter::WriteReaperProject():" << fi.absolutePath() << "could not be created, no RPP written.";
+        }
+    }
+}
+
+void CJamProjectWriter::WriteAudacityLof ( const SProjectJob& job )
+{
+    QString audacityLofFileName = job.sessionDir.filePath(QString(job.sessionName).append(".lof"));
+    const QFileInfo fi(audacityLofFileName);
+
+    if (fi.exists())
+    {
+        qWarning() << "CJamProjectWriter::WriteAudacityLof():" << fi.absolutePath() << "exists and will not be overwritten.";
+    }
+    else
+    {
+        QFile outf (audacityLofFileName);
+        if ( outf.open(QFile::WriteOnly) )
+        {
+            QTextStream sOut(&outf);
+
+            foreach ( auto trackName, job.tracks.keys() )
+            {
+                foreach ( auto item, job.tracks[trackName] ) {
+                    QFileInfo fi ( item.fileName );
+                    sOut << "file " << '"' << fi.fileName() << '"';
+                    sOut << " offset " << secondsAt48K( item.startFrame, job.iServerFrameSizeSamples ) << endl;
+                }
+            }
+
+            sOut.flush();
+            qDebug() << "Session LOF:" << audacityLofFileName;
+        }
+        else
+        {
+            qWarning() << "CJamProjectWriter::WriteAudacityLof():" << fi.absolutePath() << "could not be created, no LOF written.";
+        }
+    }
+}
+
 /* ********************************************************************************************************
  * CJamRecorder
  * ********************************************************************************************************/
@@ -302,9 +737,12 @@ QMap<QString, QList<STrackItem>> CJamSession::TracksFromSessionDir(const QString
 /**
  * @brief CJamRecorder::Init Create recording directory, if necessary, and connect signal handlers
  * @param server Server object emiting signals
+ * @param _iServerFrameSizeSamples the server frame size
+ * @param iMaxNumChannels the maximum number of clients (used for sizing the frame queue)
  */
 bool CJamRecorder::Init( const CServer* server,
-                         const int      _iServerFrameSizeSamples )
+                         const int      _iServerFrameSizeSamples,
+                         const int      iMaxNumChannels )
 {
     QFileInfo fi(recordBaseDir.absolutePath());
     fi.setCaching(false);
@@ -337,13 +775,8 @@ bool CJamRecorder::Init( const CServer* server,
                       this, SLOT( OnEnd() ),
                       Qt::ConnectionType::QueuedConnection );
 
-    QObject::connect( (const QObject *)server, SIGNAL ( ClientDisconnected ( int ) ),
-                      this, SLOT( OnDisconnected ( int ) ),
-                      Qt::ConnectionType::QueuedConnection );
-
-    qRegisterMetaType<CVector<int16_t>> ( "CVector<int16_t>" );
-    QObject::connect( (const QObject *)server, SIGNAL ( AudioFrame( const int, const QString, const CHostAddress, const int, const CVector<int16_t> ) ),
-                      this, SLOT(  OnFrame (const int, const QString, const CHostAddress, const int, const CVector<int16_t> ) ),
+    QObject::connect( this, SIGNAL ( FramesAvailable() ),
+                      this, SLOT( OnFramesAvailable() ),
                       Qt::ConnectionType::QueuedConnection );
 
     QObject::connect( QCoreApplication::instance(), SIGNAL ( aboutToQuit() ),
@@ -351,10 +784,28 @@ bool CJamRecorder::Init( const CServer* server,
 
     iServerFrameSizeSamples = _iServerFrameSizeSamples;
 
+    // all the memory of the frame queue is allocated here so that the server
+    // never allocates memory for recording
+    const int iQueueLenFrames = RECORDER_QUEUE_LENGTH_MS * ( SYSTEM_SAMPLE_RATE_HZ / 1000 ) / iServerFrameSizeSamples;
+
+    vecFrameQueue.Init ( iMaxNumChannels * iQueueLenFrames );
+
+    for ( int i = 0; i < vecFrameQueue.Size(); i++ )
+    {
+        vecFrameQueue[i].vecsData.Init ( 2 /* stereo */ * iServerFrameSizeSamples );
+    }
+
+    iFrameQueueNumFree = vecFrameQueue.Size();
+
+    vecTrackPaused.Init ( MAX_NUM_CHANNELS + 1 /* mix */ );
+
     thisThread = new QThread();
     moveToThread ( thisThread );
     thisThread->start();
 
+    projectWriter.Init();
+    filePool.Init ( recordBaseDir );
+
     return true;
 }
 
@@ -363,9 +814,9 @@ bool CJamRecorder::Init( const CServer* server,
  */
 void CJamRecorder::Start() {
     // Ensure any previous cleaning up has been done.
-    OnEnd();
+    EndSession();
 
-    currentSession = new CJamSession( recordBaseDir );
+    currentSession = new CJamSession( recordBaseDir, recordingFormat, &filePool );
     isRecording = true;
 
     emit RecordingSessionStarted ( currentSession->SessionDir().path() );
@@ -373,17 +824,22 @@ void CJamRecorder::Start() {
 
 
 /**
- * @brief CJamRecorder::OnEnd Finalise the recording and write the Reaper RPP file
+ * @brief CJamRecorder::EndSession Finalise the recording and queue the project files
+ *
+ * The Reaper RPP and Audacity LOF files are written by the project writer thread so that
+ * the frames of the next session are not held up.
  */
-void CJamRecorder::OnEnd()
+void CJamRecorder::EndSession()
 {
     if ( isRecording )
     {
         isRecording = false;
         currentSession->End();
 
-        ReaperProjectFromCurrentSession();
-        AudacityLofFromCurrentSession();
+        projectWriter.Queue ( currentSession->SessionDir(),
+                              currentSession->Name(),
+                              currentSession->Tracks(),
+                              iServerFrameSizeSamples );
 
         delete currentSession;
         currentSession = nullptr;
@@ -391,11 +847,27 @@ void CJamRecorder::OnEnd()
 }
 
 
+/**
+ * @brief CJamRecorder::OnEnd Write all frames still in the queue and finalise the recording
+ */
+void CJamRecorder::OnEnd()
+{
+    ProcessFrames();
+    EndSession();
+
+    // a failed recording is finished now (the server disabled the recording)
+    isFailed = false;
+}
+
+
 /**
  * @brief CJamRecorder::OnTriggerSession End one session and start a new one
  */
 void CJamRecorder::OnTriggerSession()
 {
+    // the queued frames still belong to the current session
+    ProcessFrames();
+
     // This should magically get everything right...
     if ( isRecording )
     {
@@ -410,67 +882,11 @@ void CJamRecorder::OnAboutToQuit()
 {
     OnEnd();
 
-    thisThread->exit();
-}
-
-void CJamRecorder::ReaperProjectFromCurrentSession()
-{
-    QString reaperProjectFileName = currentSession->SessionDir().filePath(currentSession->Name().append(".rpp"));
-    const QFileInfo fi(reaperProjectFileName);
-
-    if (fi.exists())
-    {
-        qWarning() << "CJamRecorder::ReaperProjectFromCurrentSession():" << fi.absolutePath() << "exists and will not be overwritten.";
-    }
-    else
-    {
-        QFile outf (reaperProjectFileName);
-        if ( outf.open(QFile::WriteOnly) )
-        {
-            QTextStream out(&outf);
-            out << CReaperProject( currentSession->Tracks(), iServerFrameSizeSamples ).toString() << endl;
-            qDebug() << "Session RPP:" << reaperProjectFileName;
-        }
-        else
-        {
-            qWarning() << "CJamRecorder::ReaperProjectFromCurrentSession():" << fi.absolutePath() << "could not be created, no RPP written.";
-        }
-    }
-}
-
-void CJamRecorder::AudacityLofFromCurrentSession()
-{
-    QString audacityLofFileName = currentSession->SessionDir().filePath(currentSession->Name().append(".lof"));
-    const QFileInfo fi(audacityLofFileName);
+    // the project files of the last session must be complete before we exit
+    projectWriter.Finish();
+    filePool.Finish();
 
-    if (fi.exists())
-    {
-        qWarning() << "CJamRecorder::AudacityLofFromCurrentSession():" << fi.absolutePath() << "exists and will not be overwritten.";
-    }
-    else
-    {
-        QFile outf (audacityLofFileName);
-        if ( outf.open(QFile::WriteOnly) )
-        {
-            QTextStream sOut(&outf);
-
-            foreach ( auto trackName, currentSession->Tracks().keys() )
-            {
-                foreach ( auto item, currentSession->Tracks()[trackName] ) {
-                    QFileInfo fi ( item.fileName );
-                    sOut << "file " << '"' << fi.fileName() << '"';
-                    sOut << " offset " << secondsAt48K( item.startFrame, iServerFrameSizeSamples ) << endl;
-                }
-            }
-
-            sOut.flush();
-            qDebug() << "Session LOF:" << audacityLofFileName;
-        }
-        else
-        {
-            qWarning() << "CJamRecorder::AudacityLofFromCurrentSession():" << fi.absolutePath() << "could not be created, no LOF written.";
-        }
-    }
+    thisThread->exit();
 }
 
 /**
@@ -505,40 +921,443 @@ void CJamRecorder::SessionDirToReaper(QString& strSessionDirName, int serverFram
 }
 
 /**
- * @brief CJamRecorder::OnDisconnected Handle disconnection of a client
- * @param iChID the client channel id
+ * @brief One session of the batch export, run by a thread of the export thread pool
+ *
+ * The result is stored in a slot of the caller which is only read after all tasks are done.
  */
-void CJamRecorder::OnDisconnected(int iChID)
+class CJamExportTask : public QRunnable
+{
+public:
+    enum EResult
+    {
+        ER_EXPORTED,
+        ER_UNCHANGED,
+        ER_ACTIVE,
+        ER_NO_TRACKS,
+        ER_FAILED
+    };
+
+    CJamExportTask ( const QString& strNSessionDirName,
+                     const int      iNServerFrameSizeSamples,
+                     EResult*       peNResult ) :
+        strSessionDirName       ( strNSessionDirName ),
+        iServerFrameSizeSamples ( iNServerFrameSizeSamples ),
+        peResult                ( peNResult ) {}
+
+    virtual void run();
+
+private:
+    // a project file is up to date if it is not older than the session index
+    // (a session without index is only exported once)
+    static bool IsUpToDate ( const QFileInfo& fiProject, const QFileInfo& fiIndex )
+    {
+        return fiProject.exists() && ( !fiIndex.exists() || ( fiProject.lastModified() >= fiIndex.lastModified() ) );
+    }
+
+    const QString strSessionDirName;
+    const int     iServerFrameSizeSamples;
+    EResult*      peResult;
+};
+
+void CJamExportTask::run()
 {
-    if ( !isRecording )
+    const QDir      sessionDir ( strSessionDirName );
+    const QString   sessionName = sessionDir.dirName();
+    const QFileInfo fiIndex ( sessionDir.filePath ( sessionName + RECORDER_INDEX_FILE_SUFFIX ) );
+    const QFileInfo fiRPP ( sessionDir.filePath ( sessionName + ".rpp" ) );
+    const QFileInfo fiLOF ( sessionDir.filePath ( sessionName + ".lof" ) );
+
+    // the unchanged sessions are skipped without reading anything else
+    if ( IsUpToDate ( fiRPP, fiIndex ) && IsUpToDate ( fiLOF, fiIndex ) )
     {
-        qWarning() << "CJamRecorder::OnDisconnected: channel" << iChID << "disconnected but not recording";
+        *peResult = ER_UNCHANGED;
+        return;
     }
-    if ( currentSession == nullptr )
+
+    // a session which is still recorded is exported by the recorder when it ends
+    const QFileInfoList newestFiles = sessionDir.entryInfoList ( QDir::Files, QDir::Time );
+
+    if ( !newestFiles.isEmpty() &&
+         ( newestFiles.first().lastModified().secsTo ( QDateTime::currentDateTime() ) < RECORDER_EXPORT_MIN_AGE_S ) )
     {
-        qWarning() << "CJamRecorder::OnDisconnected: channel" << iChID << "disconnected but no currentSession";
+        *peResult = ER_ACTIVE;
         return;
     }
-    currentSession->DisconnectClient(iChID);
+
+    // the tracks are read from the session index (only the sessions without
+    // index need the directory scan)
+    const QMap<QString, QList<STrackItem>> tracks =
+        CJamSession::TracksFromSessionDir ( sessionDir.absolutePath(), iServerFrameSizeSamples );
+
+    if ( tracks.isEmpty() )
+    {
+        *peResult = ER_NO_TRACKS;
+        return;
+    }
+
+    // project files which are older than the index are replaced
+    if ( fiRPP.exists() && !IsUpToDate ( fiRPP, fiIndex ) )
+    {
+        QFile::remove ( fiRPP.absoluteFilePath() );
+    }
+
+    if ( fiLOF.exists() && !IsUpToDate ( fiLOF, fiIndex ) )
+    {
+        QFile::remove ( fiLOF.absoluteFilePath() );
+    }
+
+    CJamProjectWriter::Write ( sessionDir, sessionName, tracks, iServerFrameSizeSamples );
+
+    *peResult = ( QFileInfo::exists ( fiRPP.absoluteFilePath() ) &&
+                  QFileInfo::exists ( fiLOF.absoluteFilePath() ) ) ? ER_EXPORTED : ER_FAILED;
 }
 
 /**
- * @brief CJamRecorder::OnFrame Handle a frame emited for a client by the server
+ * @brief CJamRecorder::SessionDirsToProjects Batch export of the project files of all sessions of a recording directory
+ * @param strRecordingDirName the recording directory (each subdirectory is a session)
+ * @param serverFrameSizeSamples the server frame size of the sessions
+ * @param iNumThreads number of sessions which are exported in parallel (0: number of cores)
+ * @param tsConsole the result of each session is written here
+ * @return the number of sessions which could not be exported
+ *
+ * The sessions whose project files are not older than their index are skipped, i.e. the
+ * export can be run regularly on a growing recording directory.
+ */
+int CJamRecorder::SessionDirsToProjects ( const QString& strRecordingDirName,
+                                          int            serverFrameSizeSamples,
+                                          int            iNumThreads,
+                                          QTextStream&   tsConsole )
+{
+    const QDir recordingDir ( QDir::cleanPath ( strRecordingDirName ) );
+
+    if ( !recordingDir.exists() )
+    {
+        tsConsole << recordingDir.absolutePath() << " does not exist or is not a directory." << endl;
+        return 1;
+    }
+
+    const QStringList sessionNames = recordingDir.entryList ( QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name );
+
+    // the tasks write their results in their own slots (allocated before the
+    // tasks are started)
+    QVector<CJamExportTask::EResult> vecResults ( sessionNames.count(), CJamExportTask::ER_FAILED );
+
+    QThreadPool Pool;
+    Pool.setMaxThreadCount ( iNumThreads > 0 ? iNumThreads : QThread::idealThreadCount() );
+
+    for ( int i = 0; i < sessionNames.count(); i++ )
+    {
+        Pool.start ( new CJamExportTask ( recordingDir.absoluteFilePath ( sessionNames[i] ),
+                                          serverFrameSizeSamples,
+                                          &vecResults[i] ) );
+    }
+
+    Pool.waitForDone();
+
+    int iNumExported = 0;
+    int iNumFailed   = 0;
+
+    for ( int i = 0; i < sessionNames.count(); i++ )
+    {
+        switch ( vecResults[i] )
+        {
+        case CJamExportTask::ER_EXPORTED:
+            tsConsole << "- " << sessionNames[i] << ": exported" << endl;
+            iNumExported++;
+            break;
+
+        case CJamExportTask::ER_ACTIVE:
+            tsConsole << "- " << sessionNames[i] << ": skipped, still recording" << endl;
+            break;
+
+        case CJamExportTask::ER_FAILED:
+            tsConsole << "- " << sessionNames[i] << ": project files could not be written" << endl;
+            iNumFailed++;
+            break;
+
+        default:
+            // unchanged sessions and other directories are not listed
+            break;
+        }
+    }
+
+    tsConsole << iNumExported << " of " << sessionNames.count() << " directories exported, " <<
+        iNumFailed << " failed" << endl;
+
+    return iNumFailed;
+}
+
+/**
+ * @brief CJamRecorder::PutFrame Queue a frame of PCM data of a client
  * @param iChID the client channel id
  * @param name the client name
  * @param address the client IP and port number
  * @param numAudioChannels the client number of audio channels
- * @param data the frame data
+ * @param data the frame data (interleaved samples)
  *
- * Ensures recording has started.
+ * Called by the server (worker) threads, the frame is dropped if the queue is full
+ * (with ROP_PAUSE_TRACKS the track is paused, too).
  */
-void CJamRecorder::OnFrame(const int iChID, const QString name, const CHostAddress address, const int numAudioChannels, const CVector<int16_t> data)
+void CJamRecorder::PutFrame ( const int           iChID,
+                              const QString&      name,
+                              const CHostAddress& address,
+                              const int           numAudioChannels,
+                              const int16_t*      data )
 {
-    // Make sure we are ready
-    if ( !isRecording )
+    if ( ( overflowPolicy == ROP_PAUSE_TRACKS ) && ( vecTrackPaused[iChID].loadAcquire() != 0 ) )
     {
-        Start();
+        iFrameQueueNumDropped.fetchAndAddOrdered ( 1 );
+        return;
+    }
+
+    const int iIdx = iFrameQueueNumReserved.fetchAndAddOrdered ( 1 );
+
+    if ( iIdx >= iFrameQueueNumFree )
+    {
+        iFrameQueueNumDropped.fetchAndAddOrdered ( 1 );
+
+        if ( ( overflowPolicy == ROP_PAUSE_TRACKS ) && vecTrackPaused[iChID].testAndSetOrdered ( 0, 1 ) )
+        {
+            iNumPausedTracks.fetchAndAddOrdered ( 1 );
+        }
+        return;
+    }
+
+    SJamFrame& Frame = vecFrameQueue[( iFrameQueuePutPos.loadAcquire() + iIdx ) % vecFrameQueue.Size()];
+
+    Frame.iChID             = iChID;
+    Frame.bIsDisconnect     = false;
+    Frame.iNumAudioChannels = numAudioChannels;
+    Frame.strName           = name;
+    Frame.Address           = address;
+
+    std::copy ( data,
+                data + numAudioChannels * iServerFrameSizeSamples,
+                Frame.vecsData.begin() );
+}
+
+/**
+ * @brief CJamRecorder::PutDisconnect Queue the disconnection of a client
+ * @param iChID the client channel id
+ */
+void CJamRecorder::PutDisconnect ( const int iChID )
+{
+    const int iIdx = iFrameQueueNumReserved.fetchAndAddOrdered ( 1 );
+
+    if ( iIdx >= iFrameQueueNumFree )
+    {
+        iFrameQueueNumDropped.fetchAndAddOrdered ( 1 );
+        return;
+    }
+
+    SJamFrame& Frame = vecFrameQueue[( iFrameQueuePutPos.loadAcquire() + iIdx ) % vecFrameQueue.Size()];
+
+    Frame.iChID         = iChID;
+    Frame.bIsDisconnect = true;
+}
+
+/**
+ * @brief CJamRecorder::CommitFrames Publish the frames queued during the current server frame
+ *
+ * The recorder thread is only notified if it has not been notified already.
+ */
+void CJamRecorder::CommitFrames()
+{
+    const int iNumSlots = vecFrameQueue.Size();
+    const int iNumNew   = std::min ( static_cast<int> ( iFrameQueueNumReserved.fetchAndStoreOrdered ( 0 ) ),
+                                     iFrameQueueNumFree );
+
+    int iPutPos = iFrameQueuePutPos.loadAcquire();
+
+    if ( iNumNew > 0 )
+    {
+        iPutPos = ( iPutPos + iNumNew ) % ( 2 * iNumSlots );
+        iFrameQueuePutPos.storeRelease ( iPutPos );
+
+        if ( iFrameQueueNotifyPending.testAndSetOrdered ( 0, 1 ) )
+        {
+            emit FramesAvailable();
+        }
+    }
+
+    // the recorder thread can only free further slots, therefore the number of
+    // free slots for the next server frame is known here
+    const int iNumUsed = ( iPutPos - iFrameQueueGetPos.loadAcquire() + 2 * iNumSlots ) % ( 2 * iNumSlots );
+
+    iFrameQueueNumFree    = iNumSlots - iNumUsed;
+    iFrameQueueMaxNumUsed = std::max ( iFrameQueueMaxNumUsed, iNumUsed );
+
+    ResumePausedTracks();
+}
+
+/**
+ * @brief CJamRecorder::ResumePausedTracks Resume the paused tracks if the queue drained (server thread only)
+ *
+ * The file of a paused track is ended by a queued disconnection which precedes the frames of
+ * the next server frame, i.e. the resumed track is recorded in a new file at its correct position.
+ */
+void CJamRecorder::ResumePausedTracks()
+{
+    if ( ( iNumPausedTracks.loadAcquire() == 0 ) ||
+         ( iFrameQueueNumFree * 100 < vecFrameQueue.Size() * RECORDER_RESUME_FREE_PERCENT ) )
+    {
+        return;
     }
 
-    currentSession->Frame( iChID, name, address, numAudioChannels, data, iServerFrameSizeSamples );
+    for ( int iChID = 0; iChID < vecTrackPaused.Size(); iChID++ )
+    {
+        if ( vecTrackPaused[iChID].loadAcquire() != 0 )
+        {
+            PutDisconnect ( iChID );
+
+            vecTrackPaused[iChID].storeRelease ( 0 );
+            iNumPausedTracks.fetchAndSubOrdered ( 1 );
+        }
+    }
+}
+
+/**
+ * @brief CJamRecorder::GetQueueLength Number of frames published by the server but not yet written
+ */
+int CJamRecorder::GetQueueLength() const
+{
+    const int iNumSlots = vecFrameQueue.Size();
+
+    if ( iNumSlots == 0 )
+    {
+        return 0;
+    }
+
+    return ( iFrameQueuePutPos.loadAcquire() - iFrameQueueGetPos.loadAcquire() + 2 * iNumSlots ) % ( 2 * iNumSlots );
+}
+
+/**
+ * @brief CJamRecorder::GetAndResetNumWrittenKiB Amount of PCM data written since the last call
+ * @return the amount in KiB
+ */
+int CJamRecorder::GetAndResetNumWrittenKiB()
+{
+    const int iNumWrittenKiB = iNumWrittenKiBTotal.loadAcquire();
+    const int iNumNewKiB     = iNumWrittenKiB - iNumWrittenKiBReported;
+
+    iNumWrittenKiBReported = iNumWrittenKiB;
+
+    return iNumNewKiB;
+}
+
+/**
+ * @brief CJamRecorder::ProcessFrames Write all frames which are in the queue
+ *
+ * Ensures recording has started if there is a frame to write. After the recording failed,
+ * the frames are discarded until the server ended the recording.
+ */
+void CJamRecorder::ProcessFrames()
+{
+    CTracer::SetThreadName ( "recorder" );
+    TRACE_SCOPE ( TP_RECORDER_WRITE );
+
+    const int iNumSlots = vecFrameQueue.Size();
+
+    if ( iNumSlots == 0 )
+    {
+        return;
+    }
+
+    const int iNumDropped = iFrameQueueNumDropped.fetchAndStoreOrdered ( 0 );
+
+    if ( iNumDropped > 0 )
+    {
+        iFrameQueueNumDroppedTotal.fetchAndAddOrdered ( iNumDropped );
+
+        qWarning() << "CJamRecorder::ProcessFrames:" << iNumDropped << "frames dropped, the recording could not keep up";
+    }
+
+    int       iGetPos    = iFrameQueueGetPos.loadAcquire();
+    const int iPutPos    = iFrameQueuePutPos.loadAcquire();
+    int       iNumFrames = 0;
+
+    while ( iGetPos != iPutPos )
+    {
+        const SJamFrame& Frame = vecFrameQueue[iGetPos % iNumSlots];
+
+        if ( isFailed )
+        {
+            // discard the frame
+        }
+        else if ( Frame.bIsDisconnect )
+        {
+            if ( !isRecording )
+            {
+                qWarning() << "CJamRecorder::ProcessFrames: channel" << Frame.iChID << "disconnected but not recording";
+            }
+            if ( currentSession == nullptr )
+            {
+                qWarning() << "CJamRecorder::ProcessFrames: channel" << Frame.iChID << "disconnected but no currentSession";
+            }
+            else
+            {
+                currentSession->DisconnectClient ( Frame.iChID );
+            }
+        }
+        else
+        {
+            // Make sure we are ready
+            if ( !isRecording )
+            {
+                Start();
+            }
+
+            if ( currentSession->Frame ( Frame.iChID, Frame.strName, Frame.Address, Frame.iNumAudioChannels, Frame.vecsData, iServerFrameSizeSamples ) )
+            {
+                iNumWrittenBytes += Frame.iNumAudioChannels * iServerFrameSizeSamples * static_cast<int> ( sizeof ( int16_t ) );
+                iNumFrames++;
+            }
+            else
+            {
+                Fail ( "a track file could not be written (the disk may be full)" );
+            }
+        }
+
+        // free the slot for the server
+        iGetPos = ( iGetPos + 1 ) % ( 2 * iNumSlots );
+        iFrameQueueGetPos.storeRelease ( iGetPos );
+    }
+
+    iFrameQueueNumWrittenTotal.fetchAndAddOrdered ( iNumFrames );
+    iNumWrittenKiBTotal.storeRelease ( static_cast<int> ( iNumWrittenBytes / 1024 ) );
+
+    // the dropped frames are newer than the queued ones, i.e. the recording
+    // is complete up to here
+    if ( ( iNumDropped > 0 ) && ( overflowPolicy == ROP_STOP_RECORDING ) && !isFailed )
+    {
+        Fail ( "the recording could not keep up" );
+    }
+}
+
+/**
+ * @brief CJamRecorder::Fail Stop the recording after an error
+ * @param strReason the reason which is reported to the server
+ *
+ * The current session is finalised as far as possible. The recording stays stopped until
+ * the server ended it (OnEnd()), the server is notified to disable the recording.
+ */
+void CJamRecorder::Fail ( const QString& strReason )
+{
+    qWarning() << "CJamRecorder::Fail: the recording was stopped," << strReason;
+
+    EndSession();
+    isFailed = true;
+
+    emit RecordingFailed ( strReason );
+}
+
+/**
+ * @brief CJamRecorder::OnFramesAvailable Handle the notification that the server queued frames
+ */
+void CJamRecorder::OnFramesAvailable()
+{
+    // reset the notification first so that no notification gets lost
+    iFrameQueueNotifyPending.fetchAndStoreOrdered ( 0 );
+
+    ProcessFrames();
 }
@@ -27,15 +27,65 @@
 #include <QDir>
 #include <QFile>
 #include <QDateTime>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QThread>
+#include <QTextStream>
 
 #include "../util.h"
 #include "../channel.h"
 
 #include "creaperproject.h"
 #include "cwavestream.h"
+#include "cflacstream.h"
+
+
+/* Definitions ****************************************************************/
+// length of the frame queue between the server and the recorder thread, if the
+// recorder thread is blocked for longer (e.g. by a slow disk) frames are dropped
+#define RECORDER_QUEUE_LENGTH_MS         1000 // ms
+
+// the paused tracks (see ROP_PAUSE_TRACKS) are resumed when at least this part
+// of the frame queue is free again
+#define RECORDER_RESUME_FREE_PERCENT     50 // %
+
+// pseudo channel ID of the mix of all clients (if the mix is recorded instead
+// of the separate clients)
+#define RECORDER_MIX_CHAN_ID             MAX_NUM_CHANNELS
+
+// suffix of the session index file which lists all recorded tracks (one line
+// per client connection, appended when the connection ends)
+#define RECORDER_INDEX_FILE_SUFFIX       ".idx"
+
+// number of spare track files which are kept ready in the recording base
+// directory (a new track takes a spare file instead of creating a file)
+#define RECORDER_FILE_POOL_SIZE          4
+
+// name of the spare track files: prefix + number + suffix
+#define RECORDER_SPARE_FILE_PREFIX       ".jamulus_spare_"
+#define RECORDER_SPARE_FILE_SUFFIX       ".tmp"
+
+// the batch export skips a session with a file which was modified in this time
+// (the session is still being recorded)
+#define RECORDER_EXPORT_MIN_AGE_S        300 // s
 
 namespace recorder {
 
+enum ERecordingFormat
+{
+    RF_WAV  = 0, // uncompressed RIFF WAVE
+    RF_FLAC = 1  // lossless compressed FLAC
+};
+
+// what happens if the frame queue is full because the recorder thread cannot
+// keep up (a write error, e.g. a full disk, always stops the recording)
+enum ERecorderOverflowPolicy
+{
+    ROP_DROP_FRAMES    = 0, // the frames which do not fit are dropped
+    ROP_PAUSE_TRACKS   = 1, // a track which lost a frame is paused until the queue drained, then a new file is started
+    ROP_STOP_RECORDING = 2  // the recording is stopped
+};
+
 class CJamClientConnection : public QObject
 {
     Q_OBJECT
@@ -64,23 +114,68 @@ private:
     const QString fileName;
 };
 
+/**
+ * @brief Pool of spare track files which are created ahead of time
+ *
+ * Creating a file can take a long time on a slow (e.g. network) file system. The spare
+ * files are created and preallocated by a separate thread with a low priority, a new track
+ * only renames a spare file into the session directory so that the recorder thread is not
+ * held up when a client joins. The pool is refilled after each file taken.
+ */
+class CJamFilePool : public QObject
+{
+    Q_OBJECT
+
+public:
+    CJamFilePool() : thisThread ( nullptr ), iNextSpareNum ( 0 ) {}
+
+    /**
+     * @brief Init Remove stale spare files, start the pool thread and fill the pool
+     */
+    void Init ( const QDir& _spareDir );
+
+    /**
+     * @brief Take Move a spare file to the given path (called by the recorder thread)
+     * @return the open, empty file or nullptr if no spare file is available
+     */
+    QFile* Take ( const QString& strFilePath );
+
+    /**
+     * @brief Finish Stop the pool thread and remove the spare files
+     */
+    void Finish();
+
+private:
+    void Refill();
+    void RemoveSpareFiles();
+
+    QDir           spareDir;
+    QMutex         Mutex;
+    QList<QFile*>  spareFiles;
+    QThread*       thisThread;
+    int            iNextSpareNum; // only used by the pool thread
+
+private slots:
+    void OnRefill() { Refill(); }
+};
+
 class CJamClient : public QObject
 {
     Q_OBJECT
 
 public:
-    CJamClient(const qint64 frame, const int numChannels, const QString name, const CHostAddress address, const QDir recordBaseDir);
+    CJamClient(const qint64 frame, const int numChannels, const QString name, const CHostAddress address, const QDir recordBaseDir, const ERecordingFormat format, CJamFilePool* filePool);
 
-    void Frame(const QString name, const CVector<int16_t>& pcm, int iServerFrameSizeSamples);
+    bool Frame(const QString& name, const CVector<int16_t>& pcm, int iServerFrameSizeSamples);
 
     void Disconnect();
 
     qint64       StartFrame()       { return startFrame; }
     qint64       FrameCount()       { return frameCount; }
     uint16_t     NumAudioChannels() { return numChannels; }
-    QString      ClientName()       { return name.leftJustified(4, '_', false).replace(QRegExp("[-.:/\\ ]"), "_")
+    QString      ClientName()       { return name.leftJustified(4, '_', false).replace(QRegExp("[-.:/\\ \\[\\]]"), "_")
                                                 .append("-")
-                                                .append(address.toString(CHostAddress::EStringMode::SM_IP_NO_LAST_BYTE_PORT).replace(QRegExp("[-.:/\\ ]"), "_"))
+                                                .append(address.toString(CHostAddress::EStringMode::SM_IP_NO_LAST_BYTE_PORT).replace(QRegExp("[-.:/\\ \\[\\]]"), "_"))
                                              ;
                                     }
     CHostAddress ClientAddress()    { return address; }
@@ -95,7 +190,7 @@ private:
 
           QString      filename;
           QFile*       wavFile;
-          QDataStream* out;
+          CRecordingStream* out;
           qint64       frameCount = 0;
 };
 
@@ -105,9 +200,9 @@ class CJamSession : public QObject
 
 public:
 
-    CJamSession(QDir recordBaseDir);
+    CJamSession(QDir recordBaseDir, const ERecordingFormat format, CJamFilePool* filePool);
 
-    void Frame(const int iChID, const QString name, const CHostAddress address, const int numAudioChannels, const CVector<int16_t> data, int iServerFrameSizeSamples);
+    bool Frame(const int iChID, const QString& name, const CHostAddress& address, const int numAudioChannels, const CVector<int16_t>& data, int iServerFrameSizeSamples);
 
     void End();
 
@@ -126,7 +221,12 @@ public:
 private:
     CJamSession();
 
+    void AppendToIndex(CJamClientConnection* connection);
+    static bool TracksFromIndex(const QDir& sessionDir, QMap<QString, QList<STrackItem>>& tracks);
+
     const QDir sessionDir;
+    const ERecordingFormat format;
+    CJamFilePool* const filePool;
 
     qint64 currentFrame;
     int chIdDisconnected;
@@ -134,22 +234,179 @@ private:
     QList<CJamClientConnection*> jamClientConnections;
 };
 
+/**
+ * @brief One slot of the frame queue between the server and the recorder thread
+ *
+ * A slot either carries a frame of PCM data of a client or the notification that
+ * the client disconnected, so that both are processed in the order the server
+ * produced them.
+ */
+struct SJamFrame
+{
+    int              iChID;
+    bool             bIsDisconnect;
+    int              iNumAudioChannels;
+    QString          strName;
+    CHostAddress     Address;
+    CVector<int16_t> vecsData;
+};
+
+/**
+ * @brief Writes the project files (Reaper RPP and Audacity LOF) of the finished sessions
+ *
+ * The files are written by a separate thread with a low priority so that the recorder
+ * thread keeps writing the frames of the next session while the project files of the
+ * previous session are created.
+ */
+class CJamProjectWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    CJamProjectWriter() : thisThread ( nullptr ) {}
+
+    /**
+     * @brief Init Start the writer thread
+     */
+    void Init();
+
+    /**
+     * @brief Queue Queue the project files of a finished session (called by the recorder thread)
+     */
+    void Queue ( const QDir&                             sessionDir,
+                 const QString&                          sessionName,
+                 const QMap<QString, QList<STrackItem>>& tracks,
+                 const int                               iServerFrameSizeSamples );
+
+    /**
+     * @brief Finish Write the remaining project files by the calling thread and stop the writer thread
+     */
+    void Finish();
+
+    /**
+     * @brief Write Write the project files of a session by the calling thread (existing files are not overwritten)
+     */
+    static void Write ( const QDir&                             sessionDir,
+                        const QString&                          sessionName,
+                        const QMap<QString, QList<STrackItem>>& tracks,
+                        const int                               iServerFrameSizeSamples );
+
+private:
+    struct SProjectJob
+    {
+        QDir                             sessionDir;
+        QString                          sessionName;
+        QMap<QString, QList<STrackItem>> tracks;
+        int                              iServerFrameSizeSamples;
+    };
+
+    void WriteJobs();
+    static void WriteReaperProject ( const SProjectJob& job );
+    static void WriteAudacityLof ( const SProjectJob& job );
+
+    QMutex             Mutex;
+    QList<SProjectJob> jobs;
+    QThread*           thisThread;
+
+private slots:
+    void OnJobsQueued() { WriteJobs(); }
+};
+
 class CJamRecorder : public QObject
 {
     Q_OBJECT
 
 public:
-    CJamRecorder ( const QString recordingDirName ) :
-        recordBaseDir ( recordingDirName ),
-        isRecording   ( false )
+    CJamRecorder ( const QString recordingDirName, const ERecordingFormat eNRecordingFormat = RF_WAV ) :
+        recordBaseDir          ( recordingDirName ),
+        recordingFormat        ( eNRecordingFormat ),
+        overflowPolicy         ( ROP_DROP_FRAMES ),
+        isRecording            ( false ),
+        isFailed               ( false ),
+        currentSession         ( nullptr ),
+        iNumWrittenBytes       ( 0 ),
+        iFrameQueueNumFree     ( 0 ),
+        iFrameQueueMaxNumUsed  ( 0 ),
+        iNumWrittenKiBReported ( 0 )
     {
     }
 
+    /**
+     * @brief SetOverflowPolicy Set what happens if the frame queue is full (before the server is started)
+     */
+    void SetOverflowPolicy ( const ERecorderOverflowPolicy eNewOverflowPolicy ) { overflowPolicy = eNewOverflowPolicy; }
+
     /**
      * @brief Create recording directory, if necessary, and connect signal handlers
      * @param server Server object emiting signals
      */
-    bool Init( const CServer* server, const int _iServerFrameSizeSamples );
+    bool Init( const CServer* server, const int _iServerFrameSizeSamples, const int iMaxNumChannels );
+
+    /**
+     * @brief PutFrame Queue a frame of PCM data of a client (called by the server)
+     *
+     * May be called concurrently for different clients of the same server frame.
+     * The data is copied into a preallocated queue slot, nothing is allocated.
+     */
+    void PutFrame ( const int           iChID,
+                    const QString&      name,
+                    const CHostAddress& address,
+                    const int           numAudioChannels,
+                    const int16_t*      data );
+
+    /**
+     * @brief PutDisconnect Queue the disconnection of a client (called by the server)
+     */
+    void PutDisconnect ( const int iChID );
+
+    /**
+     * @brief CommitFrames Hand all frames queued during the current server frame to the recorder thread
+     *
+     * Must be called by the server thread once per frame after all PutFrame() calls are done.
+     */
+    void CommitFrames();
+
+    /**
+     * @brief GetQueueLength Number of frames waiting in the queue for the recorder thread
+     *
+     * Can be called from any thread, only atomic counters are read.
+     */
+    int GetQueueLength() const;
+
+    /**
+     * @brief GetNumDroppedFrames Total number of frames dropped because the queue was full
+     */
+    int GetNumDroppedFrames() const { return iFrameQueueNumDroppedTotal.loadAcquire(); }
+
+    /**
+     * @brief GetNumWrittenFrames Total number of frames written by the recorder thread
+     */
+    int GetNumWrittenFrames() const { return iFrameQueueNumWrittenTotal.loadAcquire(); }
+
+    /**
+     * @brief GetNumWrittenKiB Total amount of PCM data written by the recorder thread in KiB
+     */
+    int GetNumWrittenKiB() const { return iNumWrittenKiBTotal.loadAcquire(); }
+
+    /**
+     * @brief GetAndResetNumWrittenKiB Amount of PCM data written since the last call in KiB (server thread only)
+     */
+    int GetAndResetNumWrittenKiB();
+
+    /**
+     * @brief GetNumPausedTracks Number of tracks which are currently paused because the queue was full
+     */
+    int GetNumPausedTracks() const { return iNumPausedTracks.loadAcquire(); }
+
+    /**
+     * @brief GetQueueSize Number of slots of the frame queue
+     */
+    int GetQueueSize() const { return vecFrameQueue.Size(); }
+
+    /**
+     * @brief GetAndResetMaxQueueLength Maximum number of queued frames since the last call (server thread only)
+     */
+    int GetAndResetMaxQueueLength() { const int iMax = iFrameQueueMaxNumUsed; iFrameQueueMaxNumUsed = 0; return iMax; }
 
     /**
      * @brief SessionDirToReaper Method that allows an RPP file to be recreated
@@ -158,21 +415,70 @@ public:
      */
     static void SessionDirToReaper( QString& strSessionDirName, int serverFrameSizeSamples );
 
+    /**
+     * @brief SessionDirsToProjects Batch export of the project files of all sessions of a recording directory
+     * @param strRecordingDirName the recording directory (each subdirectory is a session)
+     * @param serverFrameSizeSamples What the server frame size was for the sessions
+     * @param iNumThreads number of sessions which are exported in parallel (0: number of cores)
+     * @param tsConsole the result of each session is written here
+     * @return the number of sessions which could not be exported
+     */
+    static int SessionDirsToProjects ( const QString& strRecordingDirName,
+                                       int            serverFrameSizeSamples,
+                                       int            iNumThreads,
+                                       QTextStream&   tsConsole );
+
 private:
     void Start();
-    void ReaperProjectFromCurrentSession();
-    void AudacityLofFromCurrentSession();
+    void EndSession();
+    void ProcessFrames();
+    void ResumePausedTracks();
+    void Fail ( const QString& strReason );
 
-    QDir recordBaseDir;
+    QDir                    recordBaseDir;
+    ERecordingFormat        recordingFormat;
+    ERecorderOverflowPolicy overflowPolicy;
 
     bool         isRecording;
+    bool         isFailed; // the recording stopped, the frames are discarded until OnEnd()
     CJamSession* currentSession;
     int          iServerFrameSizeSamples;
-
-    QThread* thisThread;
+    qint64       iNumWrittenBytes; // only used by the recorder thread
+
+    QThread*          thisThread;
+    CJamProjectWriter projectWriter;
+    CJamFilePool      filePool;
+
+    // frame queue: the slots are reserved by the server (worker) threads with an
+    // atomic counter, the whole batch of a server frame is published at once in
+    // CommitFrames() and the recorder thread consumes the slots in order
+    // (positions run modulo twice the number of slots to distinguish full/empty)
+    CVector<SJamFrame> vecFrameQueue;
+    int                iFrameQueueNumFree;    // only written by the server thread
+    int                iFrameQueueMaxNumUsed; // only used by the server thread
+    QAtomicInt         iFrameQueueNumReserved;
+    QAtomicInt         iFrameQueuePutPos;
+    QAtomicInt         iFrameQueueGetPos;
+    QAtomicInt         iFrameQueueNotifyPending;
+    QAtomicInt         iFrameQueueNumDropped;
+    QAtomicInt         iFrameQueueNumDroppedTotal;
+    QAtomicInt         iFrameQueueNumWrittenTotal;
+    QAtomicInt         iNumWrittenKiBTotal;
+    int                iNumWrittenKiBReported; // only used by the server thread
+
+    // tracks paused by ROP_PAUSE_TRACKS, set by the server (worker) threads and
+    // cleared by the server thread in CommitFrames()
+    CVector<QAtomicInt> vecTrackPaused;
+    QAtomicInt          iNumPausedTracks;
 
 signals:
     void RecordingSessionStarted ( QString sessionDir );
+    void FramesAvailable();
+
+    /**
+     * @brief Raised by the recorder thread when it stopped the recording (a write error or the queue overflowed)
+     */
+    void RecordingFailed ( QString reason );
 
 private slots:
     /**
@@ -191,18 +497,9 @@ private slots:
     void OnAboutToQuit();
 
     /**
-     * @brief Raised when an existing client leaves the server.
-     * @param iChID channel number of client
+     * @brief Raised when frames (or client disconnections) are available in the frame queue
      */
-    void OnDisconnected ( int iChID );
-
-    /**
-     * @brief Raised when a frame of data is available to process
-     */
-    void OnFrame ( const int iChID, const QString name, const CHostAddress address, const int numAudioChannels, const CVector<int16_t> data );
+    void OnFramesAvailable();
 };
 
 }
-
-Q_DECLARE_METATYPE(int16_t)
-Q_DECLARE_METATYPE(CVector<int16_t>)
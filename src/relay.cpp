@@ -0,0 +1,635 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "relay.h"
+#include "server.h"
+
+
+/* Implementation *************************************************************/
+// CRelayFrame implementation --------------------------------------------------
+void CRelayFrame::Init ( const int iMaxPacketSize )
+{
+    vecbyFrame.Init ( std::max ( RELAY_MAX_FRAME_SIZE,
+                                 RELAY_HEADER_SIZE + GetPacketSize ( iMaxPacketSize ) ) );
+    Start ( 0 );
+}
+
+void CRelayFrame::Start ( const int iSequenceNumber )
+{
+    vecbyFrame[0] = RELAY_FRAME_ID;
+    vecbyFrame[1] = static_cast<uint8_t> ( iSequenceNumber & 0xFF );
+    vecbyFrame[2] = static_cast<uint8_t> ( ( iSequenceNumber >> 8 ) & 0xFF );
+    vecbyFrame[3] = 0;
+    iFrameLen     = RELAY_HEADER_SIZE;
+    iNumPackets   = 0;
+}
+
+bool CRelayFrame::AddPacket ( const uint8_t*      pbyData,
+                              const int           iNumBytes,
+                              const CHostAddress& HostAddr )
+{
+    const int iPacketSize = GetPacketSize ( iNumBytes );
+
+    if ( ( iNumPackets >= RELAY_MAX_NUM_PACKETS ) ||
+         ( iFrameLen + iPacketSize > vecbyFrame.Size() ) ||
+         ( ( iNumPackets > 0 ) && ( iFrameLen + iPacketSize > RELAY_MAX_FRAME_SIZE ) ) )
+    {
+        return false;
+    }
+
+    uint8_t* pbyPacket = &vecbyFrame[iFrameLen];
+
+    std::copy ( HostAddr.Addr, HostAddr.Addr + 16, pbyPacket );
+    pbyPacket[16] = static_cast<uint8_t> ( HostAddr.iPort & 0xFF );
+    pbyPacket[17] = static_cast<uint8_t> ( ( HostAddr.iPort >> 8 ) & 0xFF );
+    pbyPacket[18] = static_cast<uint8_t> ( iNumBytes & 0xFF );
+    pbyPacket[19] = static_cast<uint8_t> ( ( iNumBytes >> 8 ) & 0xFF );
+    std::copy ( pbyData, pbyData + iNumBytes, pbyPacket + RELAY_PACKET_HEADER_SIZE );
+
+    iFrameLen += iPacketSize;
+    iNumPackets++;
+    vecbyFrame[3] = static_cast<uint8_t> ( iNumPackets );
+
+    return true;
+}
+
+bool CRelayFrame::ParseHeader ( const uint8_t* pbyFrame,
+                                const int      iNumBytes,
+                                int&           iSequenceNumber,
+                                int&           iNumPackets )
+{
+    if ( ( iNumBytes < RELAY_HEADER_SIZE ) || ( pbyFrame[0] != RELAY_FRAME_ID ) || ( pbyFrame[3] == 0 ) )
+    {
+        return false;
+    }
+
+    iSequenceNumber = pbyFrame[1] | ( pbyFrame[2] << 8 );
+    iNumPackets     = pbyFrame[3];
+
+    // the packets must fill the datagram exactly (an audio packet which starts
+    // with the frame ID is therefore not taken as a relay frame)
+    int iPos = RELAY_HEADER_SIZE;
+
+    for ( int i = 0; i < iNumPackets; i++ )
+    {
+        if ( iPos + RELAY_PACKET_HEADER_SIZE > iNumBytes )
+        {
+            return false;
+        }
+
+        iPos += GetPacketSize ( pbyFrame[iPos + 18] | ( pbyFrame[iPos + 19] << 8 ) );
+    }
+
+    return iPos == iNumBytes;
+}
+
+const uint8_t* CRelayFrame::GetPacket ( const uint8_t* pbyFrame,
+                                        int&           iPos,
+                                        CHostAddress&  HostAddr,
+                                        int&           iNumBytes )
+{
+    const uint8_t* pbyPacket = &pbyFrame[iPos];
+
+    std::copy ( pbyPacket, pbyPacket + 16, HostAddr.Addr );
+    HostAddr.iPort = static_cast<quint16> ( pbyPacket[16] | ( pbyPacket[17] << 8 ) );
+    iNumBytes      = pbyPacket[18] | ( pbyPacket[19] << 8 );
+
+    iPos += GetPacketSize ( iNumBytes );
+
+    return pbyPacket + RELAY_PACKET_HEADER_SIZE;
+}
+
+
+// CRelaySequenceCounter implementation ----------------------------------------
+void CRelaySequenceCounter::Put ( const int iSequenceNumber )
+{
+    if ( bValid )
+    {
+        // a frame which is older than the expected one was reordered and was
+        // already counted as lost
+        const int iGap = ( iSequenceNumber - iNextSeq ) & 0xFFFF;
+
+        if ( iGap >= 0x8000 )
+        {
+            return;
+        }
+
+        iNumLost += iGap;
+    }
+
+    iNextSeq = ( iSequenceNumber + 1 ) & 0xFFFF;
+    bValid   = true;
+}
+
+
+// CRelayRoutes implementation -------------------------------------------------
+CRelayRoutes::CRelayRoutes() :
+    iNumRelays     ( 0 ),
+    iNumRoutes     ( 0 ),
+    iLastCleanupMs ( 0 )
+{
+    memset ( RelaySockAddr, 0, sizeof ( RelaySockAddr ) );
+    Clock.start();
+}
+
+bool CRelayRoutes::SetAllowedRelays ( const QString& strRelays )
+{
+    const QStringList slRelays = strRelays.split ( ",", QString::SkipEmptyParts );
+
+    if ( slRelays.isEmpty() || ( slRelays.size() > MAX_NUM_RELAYS ) )
+    {
+        return false;
+    }
+
+    for ( int i = 0; i < slRelays.size(); i++ )
+    {
+        if ( !NetworkUtil::ParseNetworkAddress ( slRelays[i].trimmed(), RelayHostAddr[i] ) )
+        {
+            return false;
+        }
+
+        // until the first frame is received, the packets are sent to the port
+        // of the address (the default port if it has none)
+        CSocket::HostAddrToSockAddr ( RelayHostAddr[i], RelaySockAddr[i] );
+    }
+
+    // the frames of the send queue flush are allocated before the relays are
+    // enabled, at most every queued packet gets a frame of its own
+    vecFrames.Init         ( NUM_SOCKET_SEND_QUEUE_SLOTS );
+    vecFrameAddr.Init      ( NUM_SOCKET_SEND_QUEUE_SLOTS );
+    vecRelayedPackets.Init ( NUM_SOCKET_SEND_QUEUE_SLOTS );
+    vecRelayedIdx.Init     ( NUM_SOCKET_SEND_QUEUE_SLOTS );
+
+    for ( int i = 0; i < NUM_SOCKET_SEND_QUEUE_SLOTS; i++ )
+    {
+        vecFrames[i].Init ( MAX_SIZE_BYTES_SEND_QUEUE_SLOT );
+    }
+
+    iNumRelays.storeRelease ( slRelays.size() );
+
+    return true;
+}
+
+int CRelayRoutes::GetRelayIdx ( const CHostAddress& HostAddr ) const
+{
+    const int iNumAllowed = iNumRelays.loadAcquire();
+
+    for ( int i = 0; i < iNumAllowed; i++ )
+    {
+        if ( RelayHostAddr[i].IsSameInetAddr ( HostAddr ) )
+        {
+            return i;
+        }
+    }
+
+    return INVALID_INDEX;
+}
+
+void CRelayRoutes::PutFrame ( const int        iRelayIdx,
+                              const USockAddr& RelayAddr,
+                              const int        iSequenceNumber )
+{
+    QMutexLocker locker ( &Mutex );
+
+    RelaySockAddr[iRelayIdx] = RelayAddr;
+    RecvSeq[iRelayIdx].Put ( iSequenceNumber );
+
+    const qint64 iNowMs = Clock.elapsed();
+
+    if ( iNowMs - iLastCleanupMs >= RELAY_ROUTE_CLEANUP_INTERVAL_MS )
+    {
+        iLastCleanupMs = iNowMs;
+        RemoveExpiredRoutes ( iNowMs );
+    }
+}
+
+void CRelayRoutes::PutRoute ( const CHostAddress& ClientAddr,
+                              const int           iRelayIdx )
+{
+    QMutexLocker locker ( &Mutex );
+
+    SRoute& Route = Routes[ClientAddr];
+
+    Route.iRelayIdx   = iRelayIdx;
+    Route.iLastTimeMs = Clock.elapsed();
+
+    iNumRoutes.storeRelease ( Routes.size() );
+}
+
+void CRelayRoutes::RemoveRoute ( const CHostAddress& ClientAddr )
+{
+    QMutexLocker locker ( &Mutex );
+
+    if ( Routes.remove ( ClientAddr ) > 0 )
+    {
+        iNumRoutes.storeRelease ( Routes.size() );
+    }
+}
+
+void CRelayRoutes::RemoveExpiredRoutes ( const qint64 iNowMs )
+{
+    QHash<CHostAddress, SRoute>::iterator it = Routes.begin();
+
+    while ( it != Routes.end() )
+    {
+        if ( iNowMs - it.value().iLastTimeMs > RELAY_ROUTE_TIMEOUT_MS )
+        {
+            it = Routes.erase ( it );
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    iNumRoutes.storeRelease ( Routes.size() );
+}
+
+int CRelayRoutes::GetRoute ( const CHostAddress& ClientAddr,
+                             USockAddr&          RelayAddr )
+{
+    QMutexLocker locker ( &Mutex );
+
+    QHash<CHostAddress, SRoute>::const_iterator it = Routes.constFind ( ClientAddr );
+
+    if ( it == Routes.constEnd() )
+    {
+        return INVALID_INDEX;
+    }
+
+    RelayAddr = RelaySockAddr[it.value().iRelayIdx];
+
+    return it.value().iRelayIdx;
+}
+
+int CRelayRoutes::AggregatePackets ( STransportSendPacket* pPackets,
+                                     const int             iNumPackets )
+{
+    // the relays of all packets are looked up with one lock, the direct
+    // packets stay in the batch and the relayed packets are moved out
+    int iNumDirect  = 0;
+    int iNumRelayed = 0;
+
+    {
+        QMutexLocker locker ( &Mutex );
+
+        for ( int i = 0; i < iNumPackets; i++ )
+        {
+            QHash<CHostAddress, SRoute>::const_iterator it =
+                Routes.constFind ( CSocket::SockAddrToHostAddr ( *pPackets[i].pAddr ) );
+
+            if ( it == Routes.constEnd() )
+            {
+                pPackets[iNumDirect++] = pPackets[i];
+            }
+            else
+            {
+                vecRelayedPackets[iNumRelayed] = pPackets[i];
+                vecRelayedIdx[iNumRelayed]     = it.value().iRelayIdx;
+                iNumRelayed++;
+            }
+        }
+
+        for ( int iR = 0; iR < iNumRelays.loadAcquire(); iR++ )
+        {
+            vecFrameAddr[iR] = RelaySockAddr[iR];
+        }
+    }
+
+    // the relayed packets are put in the frames relay by relay (a relay gets
+    // another frame if its packets do not fit in one), each frame takes at
+    // least one packet, i.e. the frames always fit in the batch
+    int iNumFrames = 0;
+
+    for ( int iR = 0; ( iR < iNumRelays.loadAcquire() ) && ( iNumRelayed > 0 ); iR++ )
+    {
+        CRelayFrame* pFrame = nullptr;
+
+        for ( int i = 0; i < iNumRelayed; i++ )
+        {
+            if ( vecRelayedIdx[i] != iR )
+            {
+                continue;
+            }
+
+            const CHostAddress ClientAddr = CSocket::SockAddrToHostAddr ( *vecRelayedPackets[i].pAddr );
+
+            if ( ( pFrame == nullptr ) ||
+                 !pFrame->AddPacket ( vecRelayedPackets[i].pbyData, vecRelayedPackets[i].iNumBytes, ClientAddr ) )
+            {
+                pFrame = &vecFrames[iNumFrames];
+                pFrame->Start ( GetNextSequenceNumber ( iR ) );
+                pFrame->AddPacket ( vecRelayedPackets[i].pbyData, vecRelayedPackets[i].iNumBytes, ClientAddr );
+
+                pPackets[iNumDirect + iNumFrames].pAddr = &vecFrameAddr[iR];
+                iNumFrames++;
+            }
+        }
+    }
+
+    for ( int i = 0; i < iNumFrames; i++ )
+    {
+        pPackets[iNumDirect + i].pbyData     = vecFrames[i].GetData();
+        pPackets[iNumDirect + i].iNumBytes   = vecFrames[i].GetSize();
+        pPackets[iNumDirect + i].iTxOffsetNs = 0;
+    }
+
+    return iNumDirect + iNumFrames;
+}
+
+int CRelayRoutes::GetAndResetNumLostFrames()
+{
+    QMutexLocker locker ( &Mutex );
+
+    int iNumLost = 0;
+
+    for ( int i = 0; i < MAX_NUM_RELAYS; i++ )
+    {
+        iNumLost += RecvSeq[i].GetAndResetNumLost();
+    }
+
+    return iNumLost;
+}
+
+
+// CRelay implementation -------------------------------------------------------
+CRelay::CRelay ( const quint16  iPortNumber,
+                 const QString& strServerAddress ) :
+    iUpstreamSeq    ( 0 ),
+    iLastReportMs   ( 0 ),
+    iNumUpPackets   ( 0 ),
+    iNumUpFrames    ( 0 ),
+    iNumDownPackets ( 0 ),
+    iNumDownFrames  ( 0 ),
+    ReceiveThread   ( this ),
+    pFlushTimer     ( new CHighPrecisionTimer ( false ) ),
+    bRun            ( true )
+{
+    if ( !NetworkUtil::ParseNetworkAddress ( strServerAddress, ServerHostAddr ) )
+    {
+        throw CGenErr ( "Invalid server address of the relay: " + strServerAddress );
+    }
+
+    CSocket::HostAddrToSockAddr ( ServerHostAddr, ServerSockAddr );
+
+#ifdef _WIN32
+    WSADATA wsa;
+    WSAStartup ( MAKEWORD(1, 0), &wsa );
+#endif
+
+    // the relay socket is a dual-stack socket as the sockets of the server
+    const bool bDualStack = CSocket::IsDualStack();
+    USockAddr  UdpSocketInAddr;
+
+    memset ( &UdpSocketInAddr, 0, sizeof ( UdpSocketInAddr ) );
+
+    if ( bDualStack )
+    {
+        const int iV6Only = 0;
+
+        UdpSocket = socket ( AF_INET6, SOCK_DGRAM, 0 );
+
+        setsockopt ( UdpSocket, IPPROTO_IPV6, IPV6_V6ONLY, (const char*) &iV6Only, sizeof ( iV6Only ) );
+
+        UdpSocketInAddr.In6.sin6_family = AF_INET6;
+        UdpSocketInAddr.In6.sin6_addr   = in6addr_any;
+        UdpSocketInAddr.In6.sin6_port   = htons ( iPortNumber );
+    }
+    else
+    {
+        UdpSocket = socket ( AF_INET, SOCK_DGRAM, 0 );
+
+        UdpSocketInAddr.In4.sin_family      = AF_INET;
+        UdpSocketInAddr.In4.sin_addr.s_addr = INADDR_ANY;
+        UdpSocketInAddr.In4.sin_port        = htons ( iPortNumber );
+    }
+
+#ifdef IP_TOS
+    const int iTos = SOCKET_TOS_AUDIO;
+
+    setsockopt ( UdpSocket, IPPROTO_IP, IP_TOS, (const char*) &iTos, sizeof ( iTos ) );
+#endif
+
+    if ( ::bind ( UdpSocket, &UdpSocketInAddr.Addr, GetSockAddrLen ( UdpSocketInAddr ) ) != 0 )
+    {
+        throw CGenErr ( "Cannot bind the socket of the relay (maybe "
+            "the software is already running).", "Network Error" );
+    }
+
+    pTransport.reset ( CSocketTransport::Create ( UdpSocket ) );
+
+    UpstreamFrame.Init ( MAX_SIZE_BYTES_NETW_BUF );
+    UpstreamFrame.Start ( iUpstreamSeq );
+
+    vecDownPackets.Init ( RELAY_MAX_NUM_PACKETS );
+    vecDownAddr.Init    ( RELAY_MAX_NUM_PACKETS );
+
+    Clock.start();
+
+    // the upstream frame is sent in the timer thread
+    QObject::connect ( pFlushTimer.get(), &CHighPrecisionTimer::timeout,
+        this, &CRelay::OnFlushTimer, Qt::DirectConnection );
+
+    ReceiveThread.start();
+    pFlushTimer->Start();
+
+    qInfo() << qUtf8Printable ( QString ( "Relay on port %1 to the server %2 (%3 transport)" ).
+        arg ( iPortNumber ).
+        arg ( ServerHostAddr.toString() ).
+        arg ( pTransport->GetName() ) );
+}
+
+CRelay::~CRelay()
+{
+    pFlushTimer->Stop();
+
+    // the shutdown of the socket leaves the blocking receive
+    bRun = false;
+
+#ifdef _WIN32
+    closesocket ( UdpSocket );
+#elif defined ( __APPLE__ ) || defined ( __MACOSX )
+    close ( UdpSocket );
+#else
+    shutdown ( UdpSocket, SHUT_RDWR );
+#endif
+
+    ReceiveThread.Stop();
+
+    pTransport.reset();
+
+#ifdef _WIN32
+    WSACleanup();
+#elif !defined ( __APPLE__ ) && !defined ( __MACOSX )
+    close ( UdpSocket );
+#endif
+}
+
+void CRelay::CRelayThread::run()
+{
+    CThreadScheduling::ApplyToCurrentThread ( TR_SOCKET, 0 );
+
+    while ( bRun && pRelay->bRun )
+    {
+        pRelay->OnDataReceived();
+    }
+}
+
+void CRelay::OnDataReceived()
+{
+    STransportRecPacket vecPackets[NUM_SOCKET_RECV_BATCH_SLOTS];
+
+    const int iNumPackets = pTransport->Receive ( vecPackets, NUM_SOCKET_RECV_BATCH_SLOTS );
+
+    for ( int i = 0; i < iNumPackets; i++ )
+    {
+        const uint8_t*     pbyData    = &( *vecPackets[i].pvecbyBuf )[0];
+        const CHostAddress SenderAddr = CSocket::SockAddrToHostAddr ( vecPackets[i].Addr );
+
+        if ( SenderAddr == ServerHostAddr )
+        {
+            ForwardToClients ( pbyData, vecPackets[i].iNumBytes );
+        }
+        else
+        {
+            ForwardToServer ( pbyData, vecPackets[i].iNumBytes, SenderAddr );
+        }
+    }
+
+    const qint64 iNowMs = Clock.elapsed();
+
+    if ( iNowMs - iLastReportMs >= RELAY_REPORT_INTERVAL_S * 1000 )
+    {
+        iLastReportMs = iNowMs;
+
+        // the clients which did not send for a report interval are gone
+        QHash<CHostAddress, qint64>::iterator it = Clients.begin();
+
+        while ( it != Clients.end() )
+        {
+            if ( iNowMs - it.value() > RELAY_REPORT_INTERVAL_S * 1000 )
+            {
+                it = Clients.erase ( it );
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        QMutexLocker locker ( &Mutex );
+
+// TODO we should use the ConsoleWriterFactory() instead of qInfo()
+        qInfo() << qUtf8Printable ( QString ( "Relay: %1 clients, upstream %2 packets in %3 frames, downstream %4 packets in %5 frames, %6 downstream frames lost" ).
+            arg ( Clients.size() ).
+            arg ( iNumUpPackets ).
+            arg ( iNumUpFrames ).
+            arg ( iNumDownPackets ).
+            arg ( iNumDownFrames ).
+            arg ( DownSeq.GetAndResetNumLost() ) );
+
+        iNumUpPackets   = 0;
+        iNumUpFrames    = 0;
+        iNumDownPackets = 0;
+        iNumDownFrames  = 0;
+    }
+}
+
+void CRelay::ForwardToClients ( const uint8_t* pbyFrame,
+                                const int      iNumBytes )
+{
+    int iSequenceNumber;
+    int iNumPackets;
+
+    if ( !CRelayFrame::ParseHeader ( pbyFrame, iNumBytes, iSequenceNumber, iNumPackets ) )
+    {
+        return;
+    }
+
+    DownSeq.Put ( iSequenceNumber );
+
+    // the packets of the frame are sent as one batch (the data stays in the
+    // receive buffer of the transport until the next receive call)
+    int iPos = RELAY_HEADER_SIZE;
+
+    for ( int i = 0; i < iNumPackets; i++ )
+    {
+        CHostAddress ClientAddr;
+
+        vecDownPackets[i].pbyData     = CRelayFrame::GetPacket ( pbyFrame, iPos, ClientAddr, vecDownPackets[i].iNumBytes );
+        vecDownPackets[i].pAddr       = &vecDownAddr[i];
+        vecDownPackets[i].iTxOffsetNs = 0;
+
+        CSocket::HostAddrToSockAddr ( ClientAddr, vecDownAddr[i] );
+    }
+
+    pTransport->SendBatch ( &vecDownPackets[0], iNumPackets );
+
+    iNumDownFrames++;
+    iNumDownPackets += iNumPackets;
+}
+
+void CRelay::ForwardToServer ( const uint8_t*      pbyData,
+                               const int           iNumBytes,
+                               const CHostAddress& ClientAddr )
+{
+    if ( iNumBytes <= 0 )
+    {
+        return;
+    }
+
+    Clients[ClientAddr] = Clock.elapsed();
+
+    QMutexLocker locker ( &Mutex );
+
+    if ( !UpstreamFrame.AddPacket ( pbyData, iNumBytes, ClientAddr ) )
+    {
+        // the frame is full, it is sent before the timer fires
+        SendUpstreamFrame();
+        UpstreamFrame.AddPacket ( pbyData, iNumBytes, ClientAddr );
+    }
+
+    iNumUpPackets++;
+}
+
+void CRelay::SendUpstreamFrame()
+{
+    if ( UpstreamFrame.IsEmpty() )
+    {
+        return;
+    }
+
+    pTransport->Send ( UpstreamFrame.GetData(), UpstreamFrame.GetSize(), ServerSockAddr );
+
+    iUpstreamSeq = ( iUpstreamSeq + 1 ) & 0xFFFF;
+    UpstreamFrame.Start ( iUpstreamSeq );
+    iNumUpFrames++;
+}
+
+void CRelay::OnFlushTimer()
+{
+    QMutexLocker locker ( &Mutex );
+
+    SendUpstreamFrame();
+}
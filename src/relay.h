@@ -0,0 +1,299 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QHash>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include "global.h"
+#include "util.h"
+#include "socket.h"
+
+
+// the relay uses the frame timer of the server
+class CHighPrecisionTimer; // forward declaration of CHighPrecisionTimer
+
+
+/* Definitions ****************************************************************/
+// A relay frame carries the packets of several clients of a relay in one
+// datagram between the relay and the server (upstream the packets of the
+// clients, downstream the packets of the server to the clients):
+// header:      [1 byte frame ID] [2 bytes sequence number (little endian)]
+//              [1 byte number of packets]
+// each packet: [16 bytes IPv6 address of the client (IPv4-mapped for IPv4)]
+//              [2 bytes port of the client (little endian)]
+//              [2 bytes length of the packet (little endian)] [packet]
+#define RELAY_FRAME_ID                   0x52
+#define RELAY_HEADER_SIZE                4
+#define RELAY_PACKET_HEADER_SIZE         20
+#define RELAY_MAX_NUM_PACKETS            255
+
+// the frames are kept below the usual path MTU, a larger packet is sent in a
+// frame of its own
+#define RELAY_MAX_FRAME_SIZE             1400
+
+// maximum number of allowed relays of a server
+#define MAX_NUM_RELAYS                   16
+
+// the route of a client through a relay is removed if the client did not send
+// a packet through the relay for this time
+#define RELAY_ROUTE_TIMEOUT_MS           60000
+#define RELAY_ROUTE_CLEANUP_INTERVAL_MS  1000
+
+// interval of the statistics report of the relay
+#define RELAY_REPORT_INTERVAL_S          10
+
+
+/* Classes ********************************************************************/
+// Assembles a relay frame (the buffer is allocated once, i.e. adding the
+// packets does not allocate memory).
+class CRelayFrame
+{
+public:
+    CRelayFrame() : iFrameLen ( 0 ), iNumPackets ( 0 ) {}
+
+    // the buffer can hold a packet of the given size in a frame of its own
+    void Init ( const int iMaxPacketSize );
+
+    // the number of bytes a packet needs in the frame
+    static int GetPacketSize ( const int iNumBytes )
+        { return RELAY_PACKET_HEADER_SIZE + iNumBytes; }
+
+    void Start ( const int iSequenceNumber );
+
+    // returns false if the packet does not fit in the frame (a packet which
+    // fits in the buffer is always added to an empty frame)
+    bool AddPacket ( const uint8_t*      pbyData,
+                     const int           iNumBytes,
+                     const CHostAddress& HostAddr );
+
+    bool           IsEmpty() const { return iNumPackets == 0; }
+    const uint8_t* GetData() const { return &vecbyFrame[0]; }
+    int            GetSize() const { return iFrameLen; }
+
+    // checks the structure of a received datagram, returns false if it is no
+    // relay frame
+    static bool ParseHeader ( const uint8_t* pbyFrame,
+                              const int      iNumBytes,
+                              int&           iSequenceNumber,
+                              int&           iNumPackets );
+
+    // returns the packet at the position iPos of a checked frame and moves
+    // iPos to the next packet (the first packet is at RELAY_HEADER_SIZE)
+    static const uint8_t* GetPacket ( const uint8_t* pbyFrame,
+                                      int&           iPos,
+                                      CHostAddress&  HostAddr,
+                                      int&           iNumBytes );
+
+protected:
+    CVector<uint8_t> vecbyFrame;
+    int              iFrameLen;
+    int              iNumPackets;
+};
+
+
+// Counts the lost (or reordered) frames of a flow by their sequence numbers.
+class CRelaySequenceCounter
+{
+public:
+    CRelaySequenceCounter() : iNextSeq ( 0 ), bValid ( false ), iNumLost ( 0 ) {}
+
+    void Reset() { bValid = false; }
+    void Put ( const int iSequenceNumber );
+
+    int GetAndResetNumLost() { const int iRet = iNumLost; iNumLost = 0; return iRet; }
+
+protected:
+    int  iNextSeq;
+    bool bValid;
+    int  iNumLost;
+};
+
+
+// Server: the allowed relays and the routes of the clients through them. The
+// socket threads process the packets of a relay frame as if they were received
+// from the clients directly and store the relay of each client, the packets to
+// a relayed client are sent in a relay frame to its relay (the packets of the
+// send queue are aggregated in one frame per relay).
+class CRelayRoutes
+{
+public:
+    CRelayRoutes();
+
+    // the addresses of the allowed relays separated by comma (only the IP
+    // address is checked, not the port), returns false if an address is
+    // invalid (must only be called once)
+    bool SetAllowedRelays ( const QString& strRelays );
+
+    bool IsEnabled() const { return iNumRelays.loadAcquire() > 0; }
+    bool HasRoutes() const { return iNumRoutes.loadAcquire() > 0; }
+
+    // index of the relay with the IP address of the sender or INVALID_INDEX
+    int GetRelayIdx ( const CHostAddress& HostAddr ) const;
+
+    // called by the socket threads for each received frame of a relay (the
+    // packets to the clients are sent to the address of the last frame)
+    void PutFrame ( const int        iRelayIdx,
+                    const USockAddr& RelayAddr,
+                    const int        iSequenceNumber );
+
+    void PutRoute ( const CHostAddress& ClientAddr,
+                    const int           iRelayIdx );
+
+    // a client which sends directly is not relayed anymore
+    void RemoveRoute ( const CHostAddress& ClientAddr );
+
+    // returns the relay of a client or INVALID_INDEX
+    int GetRoute ( const CHostAddress& ClientAddr,
+                   USockAddr&          RelayAddr );
+
+    int GetNextSequenceNumber ( const int iRelayIdx )
+        { return SendSeq[iRelayIdx].fetchAndAddRelaxed ( 1 ) & 0xFFFF; }
+
+    // replaces the packets of the batch to the relayed clients by the relay
+    // frames and returns the new number of packets (the frames are valid until
+    // the next call, must not be called concurrently to itself)
+    int AggregatePackets ( STransportSendPacket* pPackets,
+                           const int             iNumPackets );
+
+    int GetNumRoutes() const { return iNumRoutes.loadAcquire(); }
+    int GetAndResetNumLostFrames();
+
+protected:
+    struct SRoute
+    {
+        int    iRelayIdx;
+        qint64 iLastTimeMs;
+    };
+
+    void RemoveExpiredRoutes ( const qint64 iNowMs );
+
+    CHostAddress          RelayHostAddr[MAX_NUM_RELAYS];
+    USockAddr             RelaySockAddr[MAX_NUM_RELAYS];
+    CRelaySequenceCounter RecvSeq[MAX_NUM_RELAYS];
+    QAtomicInt            SendSeq[MAX_NUM_RELAYS];
+    QAtomicInt            iNumRelays;
+
+    QHash<CHostAddress, SRoute> Routes;
+    QAtomicInt                  iNumRoutes;
+    QMutex                      Mutex;
+    QElapsedTimer               Clock;
+    qint64                      iLastCleanupMs;
+
+    // preallocated relay frames of the send queue flush (only used by the
+    // thread of the flush)
+    CVector<CRelayFrame>          vecFrames;
+    CVector<USockAddr>            vecFrameAddr;
+    CVector<STransportSendPacket> vecRelayedPackets;
+    CVector<int>                  vecRelayedIdx;
+};
+
+
+// Relay: forwards the packets of the clients which connect to the local port
+// in relay frames to the server, i.e. the server receives one flow per relay
+// instead of one flow per client, and forwards the packets of the relay frames
+// of the server to the clients. The clients and the protocol do not notice the
+// relay, the server must allow it (--allowrelay). The packets of the clients
+// are aggregated for one frame period of the system frame size, i.e. the relay
+// adds up to one frame period of latency upstream.
+class CRelay : public QObject
+{
+    Q_OBJECT
+
+public:
+    // throws an error if the server address is invalid or the port cannot be
+    // bound
+    CRelay ( const quint16  iPortNumber,
+             const QString& strServerAddress );
+
+    virtual ~CRelay();
+
+protected:
+    class CRelayThread : public QThread
+    {
+    public:
+        CRelayThread ( CRelay* pNRelay ) : pRelay ( pNRelay ), bRun ( true ) {}
+
+        void Stop() { bRun = false; wait ( 5000 ); }
+
+    protected:
+        virtual void run();
+
+        CRelay* pRelay;
+        bool    bRun;
+    };
+
+    // receive thread
+    void OnDataReceived();
+
+    void ForwardToClients ( const uint8_t* pbyFrame,
+                            const int      iNumBytes );
+
+    void ForwardToServer ( const uint8_t*      pbyData,
+                           const int           iNumBytes,
+                           const CHostAddress& ClientAddr );
+
+    // must be called with the mutex locked
+    void SendUpstreamFrame();
+
+    TSocketHandle                     UdpSocket;
+    std::unique_ptr<CSocketTransport> pTransport;
+    CHostAddress                      ServerHostAddr;
+    USockAddr                         ServerSockAddr;
+
+    // the upstream frame is filled by the receive thread and sent by the
+    // timer once per frame period (or if it is full)
+    QMutex                            Mutex;
+    CRelayFrame                       UpstreamFrame;
+    int                               iUpstreamSeq;
+
+    // the packets of a downstream frame are sent as one batch
+    CVector<STransportSendPacket>     vecDownPackets;
+    CVector<USockAddr>                vecDownAddr;
+    CRelaySequenceCounter             DownSeq;
+
+    // statistics (the counters of the upstream flow are protected by the
+    // mutex, the others are only used by the receive thread)
+    QHash<CHostAddress, qint64>       Clients;
+    QElapsedTimer                     Clock;
+    qint64                            iLastReportMs;
+    int                               iNumUpPackets;
+    int                               iNumUpFrames;
+    int                               iNumDownPackets;
+    int                               iNumDownFrames;
+
+    CRelayThread                         ReceiveThread;
+    std::unique_ptr<CHighPrecisionTimer> pFlushTimer;
+    bool                              bRun;
+
+protected slots:
+    void OnFlushTimer();
+};
@@ -0,0 +1,143 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "rtcheck.h"
+
+#ifdef RT_SAFETY_CHECK
+#include <QDebug>
+#include <cstdlib>
+#include <new>
+
+
+// Real-time safety checker implementation *************************************
+thread_local int CRtSafetyChecker::iRealTimeDepth    = 0;
+QAtomicInt       CRtSafetyChecker::iNumAllocations   ( 0 );
+QAtomicInt       CRtSafetyChecker::iNumBlockingLocks ( 0 );
+
+void CRtSafetyChecker::CheckLock ( QMutex& Mutex )
+{
+    if ( IsRealTimeThread() )
+    {
+        if ( Mutex.tryLock() )
+        {
+            Mutex.unlock();
+        }
+        else
+        {
+            iNumBlockingLocks.fetchAndAddRelaxed ( 1 );
+        }
+    }
+}
+
+void CRtSafetyChecker::PrintViolations()
+{
+    const int iCurNumAllocations   = iNumAllocations.fetchAndStoreRelaxed ( 0 );
+    const int iCurNumBlockingLocks = iNumBlockingLocks.fetchAndStoreRelaxed ( 0 );
+
+    if ( ( iCurNumAllocations > 0 ) || ( iCurNumBlockingLocks > 0 ) )
+    {
+        qWarning() << "real-time safety violations on the audio thread:"
+                   << iCurNumAllocations << "memory allocations,"
+                   << iCurNumBlockingLocks << "blocking locks";
+    }
+}
+
+
+// Memory allocation hooks *****************************************************
+// the global operators are replaced on all platforms
+void* operator new ( std::size_t iSize )
+{
+    CRtSafetyChecker::OnAllocation();
+
+    if ( void* pMem = std::malloc ( iSize > 0 ? iSize : 1 ) )
+    {
+        return pMem;
+    }
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] ( std::size_t iSize )
+{
+    return operator new ( iSize );
+}
+
+void operator delete ( void* pMem ) noexcept
+{
+    CRtSafetyChecker::OnAllocation();
+    std::free ( pMem );
+}
+
+void operator delete[] ( void* pMem ) noexcept
+{
+    operator delete ( pMem );
+}
+
+void operator delete ( void* pMem, std::size_t ) noexcept
+{
+    operator delete ( pMem );
+}
+
+void operator delete[] ( void* pMem, std::size_t ) noexcept
+{
+    operator delete ( pMem );
+}
+
+// Qt containers allocate with malloc directly, with the GNU C library we can
+// replace the malloc functions, too
+#ifdef __GLIBC__
+extern "C"
+{
+void* __libc_malloc  ( size_t );
+void* __libc_calloc  ( size_t, size_t );
+void* __libc_realloc ( void*, size_t );
+void  __libc_free    ( void* );
+
+void* malloc ( size_t iSize )
+{
+    CRtSafetyChecker::OnAllocation();
+    return __libc_malloc ( iSize );
+}
+
+void* calloc ( size_t iNum, size_t iSize )
+{
+    CRtSafetyChecker::OnAllocation();
+    return __libc_calloc ( iNum, iSize );
+}
+
+void* realloc ( void* pMem, size_t iSize )
+{
+    CRtSafetyChecker::OnAllocation();
+    return __libc_realloc ( pMem, iSize );
+}
+
+void free ( void* pMem )
+{
+    CRtSafetyChecker::OnAllocation();
+    __libc_free ( pMem );
+}
+}
+#endif
+#endif
@@ -0,0 +1,87 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QMutex>
+#include <QAtomicInt>
+
+
+/* Definitions ****************************************************************/
+// The real-time safety checker is a debugging aid which is only compiled in if
+// RT_SAFETY_CHECK is defined ("qmake CONFIG+=rtcheck"). The audio callback marks
+// its thread as real-time thread with RT_SAFETY_SCOPE() and all memory
+// allocations and blocking locks of this thread are counted as violations.
+#ifdef RT_SAFETY_CHECK
+# define RT_SAFETY_REPORT_INTERVAL_MS 1000 // ms
+# define RT_SAFETY_SCOPE()           CRtSafetyScope RtSafetyScope
+# define RT_SAFETY_CHECK_LOCK(mutex) CRtSafetyChecker::CheckLock ( mutex )
+#else
+# define RT_SAFETY_SCOPE()
+# define RT_SAFETY_CHECK_LOCK(mutex)
+#endif
+
+
+/* Classes ********************************************************************/
+#ifdef RT_SAFETY_CHECK
+class CRtSafetyChecker
+{
+public:
+    static bool IsRealTimeThread() { return iRealTimeDepth > 0; }
+
+    // called by the memory allocation hooks (operator new/delete and, if the
+    // C library supports it, malloc/free)
+    static void OnAllocation()
+    {
+        if ( IsRealTimeThread() )
+        {
+            iNumAllocations.fetchAndAddRelaxed ( 1 );
+        }
+    }
+
+    // a lock which cannot be taken immediately would block the real-time
+    // thread (the actual locking is done by the caller afterwards)
+    static void CheckLock ( QMutex& Mutex );
+
+    // prints the violations which occurred since the last call, must not be
+    // called on the real-time thread
+    static void PrintViolations();
+
+protected:
+    friend class CRtSafetyScope;
+
+    static thread_local int iRealTimeDepth;
+    static QAtomicInt       iNumAllocations;
+    static QAtomicInt       iNumBlockingLocks;
+};
+
+// marks the current thread as real-time thread for the lifetime of the object
+class CRtSafetyScope
+{
+public:
+    CRtSafetyScope()  { CRtSafetyChecker::iRealTimeDepth++; }
+    ~CRtSafetyScope() { CRtSafetyChecker::iRealTimeDepth--; }
+};
+#endif
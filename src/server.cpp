@@ -23,6 +23,7 @@
 \******************************************************************************/
 
 #include "server.h"
+#include "tracer.h"
 
 
 // CHighPrecisionTimer implementation ******************************************
@@ -58,9 +59,16 @@ CHighPrecisionTimer::CHighPrecisionTimer ( const bool bNewUseDoubleSystemFrameSi
     veciTimeOutIntervals[1] = 1;
     veciTimeOutIntervals[2] = 0;
 
+    // the timer must use the highest possible precision
+    Timer.setTimerType ( Qt::PreciseTimer );
+
     // connect timer timeout signal
     QObject::connect ( &Timer, &QTimer::timeout,
         this, &CHighPrecisionTimer::OnTimer );
+
+    // a wake-up of another thread starts the timer in our thread
+    QObject::connect ( this, &CHighPrecisionTimer::wakeRequested,
+        this, &CHighPrecisionTimer::Start, Qt::QueuedConnection );
 }
 
 void CHighPrecisionTimer::Start()
@@ -69,6 +77,14 @@ void CHighPrecisionTimer::Start()
     iCurPosInVector  = 0;
     iIntervalCounter = 0;
 
+    // request the 1 ms resolution of the system timer while the server is
+    // running (otherwise the Qt timer has the default resolution of about
+    // 15 ms under load)
+    if ( !Timer.isActive() )
+    {
+        timeBeginPeriod ( 1 );
+    }
+
     if ( bUseDoubleSystemFrameSize )
     {
         // start internal timer with 2 ms resolution for 128 samples frame size
@@ -84,7 +100,11 @@ void CHighPrecisionTimer::Start()
 void CHighPrecisionTimer::Stop()
 {
     // stop timer
-    Timer.stop();
+    if ( Timer.isActive() )
+    {
+        Timer.stop();
+        timeEndPeriod ( 1 );
+    }
 }
 
 void CHighPrecisionTimer::OnTimer()
@@ -115,7 +135,8 @@ void CHighPrecisionTimer::OnTimer()
 }
 #else // Mac and Linux
 CHighPrecisionTimer::CHighPrecisionTimer ( const bool bUseDoubleSystemFrameSize ) :
-    bRun ( false )
+    bRun  ( false ),
+    iIdle ( 0 )
 {
     // calculate delay in ns
     uint64_t iNsDelay;
@@ -146,45 +167,117 @@ CHighPrecisionTimer::CHighPrecisionTimer ( const bool bUseDoubleSystemFrameSize
 
 void CHighPrecisionTimer::Start()
 {
-    // only start if not already running
+    // only start if not already running, a sleeping timer is woken up
     if ( !bRun )
     {
-        // set run flag
-        bRun = true;
+        iIdle.storeRelease ( 0 );
+        StartThread();
+    }
+    else
+    {
+        Wake();
+    }
+}
 
-        // set initial end time
-#if defined ( __APPLE__ ) || defined ( __MACOSX )
-        NextEnd = mach_absolute_time() + Delay;
-#else
-        clock_gettime ( CLOCK_MONOTONIC, &NextEnd );
+void CHighPrecisionTimer::StartIdle()
+{
+    // the thread is started but waits for the first wake-up
+    if ( !bRun )
+    {
+        iIdle.storeRelease ( 1 );
+        StartThread();
+    }
+    else
+    {
+        Sleep();
+    }
+}
 
-        NextEnd.tv_nsec += Delay;
-        if ( NextEnd.tv_nsec >= 1000000000L )
-        {
-            NextEnd.tv_sec++;
-            NextEnd.tv_nsec -= 1000000000L;
-        }
-#endif
+void CHighPrecisionTimer::StartThread()
+{
+    // set run flag and discard old wake-ups
+    bRun = true;
+    WakeSem.tryAcquire ( WakeSem.available() );
 
-        // start thread
-        QThread::start ( QThread::TimeCriticalPriority );
-    }
+    // set initial end time
+    SetInitialEndTime();
+
+    // start thread
+    QThread::start ( QThread::TimeCriticalPriority );
 }
 
 void CHighPrecisionTimer::Stop()
 {
-    // set flag so that thread can leave the main loop
+    // set flag so that thread can leave the main loop (a sleeping thread is
+    // woken up for that)
     bRun = false;
+    WakeSem.release();
 
     // give thread some time to terminate
     wait ( 5000 );
 }
 
+void CHighPrecisionTimer::Wake()
+{
+    // only the first wake-up of an idle timer releases the thread
+    if ( iIdle.testAndSetOrdered ( 1, 0 ) )
+    {
+        WakeSem.release();
+    }
+}
+
+void CHighPrecisionTimer::SetInitialEndTime()
+{
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+    NextEnd = mach_absolute_time() + Delay;
+#else
+    clock_gettime ( CLOCK_MONOTONIC, &NextEnd );
+
+    NextEnd.tv_nsec += Delay;
+    if ( NextEnd.tv_nsec >= 1000000000L )
+    {
+        NextEnd.tv_sec++;
+        NextEnd.tv_nsec -= 1000000000L;
+    }
+#endif
+}
+
+bool CHighPrecisionTimer::WaitWhileIdle()
+{
+    if ( iIdle.loadAcquire() == 0 )
+    {
+        return false;
+    }
+
+    // wait for the wake-up (a wake-up which was left over from an earlier
+    // idle phase only causes another check of the idle flag)
+    while ( bRun && ( iIdle.loadAcquire() != 0 ) )
+    {
+        WakeSem.acquire();
+    }
+
+    // the timing starts again from the wake-up time
+    SetInitialEndTime();
+
+    return true;
+}
+
 void CHighPrecisionTimer::run()
 {
+    // the real-time scheduling and the CPU of the timer thread (the default
+    // is the real-time scheduling if we have the permission)
+    CThreadScheduling::ApplyToCurrentThread ( TR_TIMER, 0 );
+    CTracer::SetThreadName ( "timer" );
+
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
     // loop until the thread shall be terminated
     while ( bRun )
     {
+        if ( WaitWhileIdle() && !bRun )
+        {
+            break;
+        }
+
         // call processing routine by fireing signal
 
 // TODO by emit a signal we leave the high priority thread -> maybe use some
@@ -196,11 +289,111 @@ void CHighPrecisionTimer::run()
         // now wait until the next buffer shall be processed (we
         // use the "increment method" to make sure we do not introduce
         // a timing drift)
-#if defined ( __APPLE__ ) || defined ( __MACOSX )
         mach_wait_until ( NextEnd );
 
         NextEnd += Delay;
+    }
 #else
+    // use a timer file descriptor if available since the kernel then handles
+    // the periodic expirations, otherwise use the sleep based implementation
+    const int iTimerFd = timerfd_create ( CLOCK_MONOTONIC, 0 );
+
+    if ( iTimerFd >= 0 )
+    {
+        RunTimerFd ( iTimerFd );
+        close ( iTimerFd );
+    }
+    else
+    {
+        RunNanoSleep();
+    }
+#endif
+}
+
+#if !defined ( __APPLE__ ) && !defined ( __MACOSX )
+void CHighPrecisionTimer::RunTimerFd ( const int iTimerFd )
+{
+    // periodic timer with the first expiration at the initial end time
+    itimerspec TimerSpec;
+    TimerSpec.it_value            = NextEnd;
+    TimerSpec.it_interval.tv_sec  = 0;
+    TimerSpec.it_interval.tv_nsec = Delay;
+
+    if ( timerfd_settime ( iTimerFd, TFD_TIMER_ABSTIME, &TimerSpec, nullptr ) != 0 )
+    {
+        RunNanoSleep();
+        return;
+    }
+
+    // loop until the thread shall be terminated
+    while ( bRun )
+    {
+        // after the idle mode the periodic timer is restarted from the wake-up
+        // time (the expirations while sleeping are discarded)
+        if ( WaitWhileIdle() )
+        {
+            if ( !bRun )
+            {
+                break;
+            }
+
+            TimerSpec.it_value = NextEnd;
+
+            if ( timerfd_settime ( iTimerFd, TFD_TIMER_ABSTIME, &TimerSpec, nullptr ) != 0 )
+            {
+                RunNanoSleep();
+                return;
+            }
+        }
+
+        // call processing routine by fireing signal
+        emit timeout();
+
+        // wait for the next expiration, the read call returns the number of
+        // expirations since the last read
+        uint64_t iNumExpirations = 0;
+
+        while ( read ( iTimerFd, &iNumExpirations, sizeof ( iNumExpirations ) ) != sizeof ( iNumExpirations ) )
+        {
+            if ( errno != EINTR )
+            {
+                // the timer file descriptor cannot be used
+                RunNanoSleep();
+                return;
+            }
+        }
+
+        // if we missed expirations, the ticks are delivered immediately so that
+        // we do not introduce a timing drift (same as the "increment method"
+        // of the sleep based implementation)
+        for ( uint64_t i = 1; bRun && ( i < iNumExpirations ); i++ )
+        {
+            emit timeout();
+        }
+    }
+}
+
+void CHighPrecisionTimer::RunNanoSleep()
+{
+    // loop until the thread shall be terminated
+    while ( bRun )
+    {
+        if ( WaitWhileIdle() && !bRun )
+        {
+            break;
+        }
+
+        // call processing routine by fireing signal
+
+// TODO by emit a signal we leave the high priority thread -> maybe use some
+//      other connection type to have something like a true callback, e.g.
+//      "Qt::DirectConnection" -> Can this work?
+
+        emit timeout();
+
+        // now wait until the next buffer shall be processed (we
+        // use the "increment method" to make sure we do not introduce
+        // a timing drift)
         clock_nanosleep ( CLOCK_MONOTONIC,
                           TIMER_ABSTIME,
                           &NextEnd,
@@ -212,1115 +405,4442 @@ void CHighPrecisionTimer::run()
             NextEnd.tv_sec++;
             NextEnd.tv_nsec -= 1000000000L;
         }
-#endif
     }
 }
 #endif
+#endif
 
 
-// CServer implementation ******************************************************
-CServer::CServer ( const int          iNewMaxNumChan,
-                   const int          iMaxDaysHistory,
-                   const QString&     strLoggingFileName,
-                   const quint16      iPortNumber,
-                   const QString&     strHTMLStatusFileName,
-                   const QString&     strHistoryFileName,
-                   const QString&     strServerNameForHTMLStatusFile,
-                   const QString&     strCentralServer,
-                   const QString&     strServerInfo,
-                   const QString&     strNewWelcomeMessage,
-                   const QString&     strRecordingDirName,
-                   const bool         bNCentServPingServerInList,
-                   const bool         bNDisconnectAllClientsOnQuit,
-                   const bool         bNUseDoubleSystemFrameSize,
-                   const ELicenceType eNLicenceType ) :
-    vecWindowPosMain            (), // empty array
-    bUseDoubleSystemFrameSize   ( bNUseDoubleSystemFrameSize ),
-    iMaxNumChannels             ( iNewMaxNumChan ),
-    Socket                      ( this, iPortNumber ),
-    Logging                     ( iMaxDaysHistory ),
-    iFrameCount                 ( 0 ),
-    JamRecorder                 ( strRecordingDirName ),
-    bEnableRecording            ( false ),
-    bWriteStatusHTMLFile        ( false ),
-    HighPrecisionTimer          ( bNUseDoubleSystemFrameSize ),
-    ServerListManager           ( iPortNumber,
-                                  strCentralServer,
-                                  strServerInfo,
-                                  iNewMaxNumChan,
-                                  bNCentServPingServerInList,
-                                  &ConnLessProtocol ),
-    bAutoRunMinimized           ( false ),
-    eLicenceType                ( eNLicenceType ),
-    bDisconnectAllClientsOnQuit ( bNDisconnectAllClientsOnQuit ),
-    pSignalHandler              ( CSignalHandler::getSingletonP() )
+// CServerWorkerPool implementation ********************************************
+void CServerWorkerPool::Start ( const int iNewNumThreads )
 {
-    int iOpusError;
-    int i;
+    // make sure no old worker threads are running
+    Stop();
 
-    // create OPUS encoder/decoder for each channel (must be done before
-    // enabling the channels), create a mono and stereo encoder/decoder
-    // for each channel
-    for ( i = 0; i < iMaxNumChannels; i++ )
-    {
-        // init OPUS -----------------------------------------------------------
-        OpusMode[i] = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
-                                                DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES,
-                                                &iOpusError );
-
-        Opus64Mode[i] = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
-                                                  SYSTEM_FRAME_SIZE_SAMPLES,
-                                                  &iOpusError );
-
-        // init audio encoders and decoders
-        OpusEncoderMono[i]     = opus_custom_encoder_create ( OpusMode[i],   1, &iOpusError ); // mono encoder legacy
-        OpusDecoderMono[i]     = opus_custom_decoder_create ( OpusMode[i],   1, &iOpusError ); // mono decoder legacy
-        OpusEncoderStereo[i]   = opus_custom_encoder_create ( OpusMode[i],   2, &iOpusError ); // stereo encoder legacy
-        OpusDecoderStereo[i]   = opus_custom_decoder_create ( OpusMode[i],   2, &iOpusError ); // stereo decoder legacy
-        Opus64EncoderMono[i]   = opus_custom_encoder_create ( Opus64Mode[i], 1, &iOpusError ); // mono encoder OPUS64
-        Opus64DecoderMono[i]   = opus_custom_decoder_create ( Opus64Mode[i], 1, &iOpusError ); // mono decoder OPUS64
-        Opus64EncoderStereo[i] = opus_custom_encoder_create ( Opus64Mode[i], 2, &iOpusError ); // stereo encoder OPUS64
-        Opus64DecoderStereo[i] = opus_custom_decoder_create ( Opus64Mode[i], 2, &iOpusError ); // stereo decoder OPUS64
-
-        // we require a constant bit rate
-        opus_custom_encoder_ctl ( OpusEncoderMono[i],     OPUS_SET_VBR ( 0 ) );
-        opus_custom_encoder_ctl ( OpusEncoderStereo[i],   OPUS_SET_VBR ( 0 ) );
-        opus_custom_encoder_ctl ( Opus64EncoderMono[i],   OPUS_SET_VBR ( 0 ) );
-        opus_custom_encoder_ctl ( Opus64EncoderStereo[i], OPUS_SET_VBR ( 0 ) );
-
-        // for 64 samples frame size we have to adjust the PLC behavior to avoid loud artifacts
-        opus_custom_encoder_ctl ( Opus64EncoderMono[i],   OPUS_SET_PACKET_LOSS_PERC ( 35 ) );
-        opus_custom_encoder_ctl ( Opus64EncoderStereo[i], OPUS_SET_PACKET_LOSS_PERC ( 35 ) );
-
-        // we want as low delay as possible
-        opus_custom_encoder_ctl ( OpusEncoderMono[i],     OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
-        opus_custom_encoder_ctl ( OpusEncoderStereo[i],   OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
-        opus_custom_encoder_ctl ( Opus64EncoderMono[i],   OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
-        opus_custom_encoder_ctl ( Opus64EncoderStereo[i], OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
-
-        // set encoder low complexity for legacy 128 samples frame size
-        opus_custom_encoder_ctl ( OpusEncoderMono[i],   OPUS_SET_COMPLEXITY ( 1 ) );
-        opus_custom_encoder_ctl ( OpusEncoderStereo[i], OPUS_SET_COMPLEXITY ( 1 ) );
-
-
-        // init double-to-normal frame size conversion buffers -----------------
-        // use worst case memory initialization to avoid allocating memory in
-        // the time-critical thread
-        DoubleFrameSizeConvBufIn[i].Init  ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
-        DoubleFrameSizeConvBufOut[i].Init ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
-    }
+    // the calling thread is one of the processing threads, therefore we only
+    // have to create one thread less than requested
+    iNumWorkers = std::max ( 0, std::min ( iNewNumThreads, MAX_NUM_SERVER_THREADS ) - 1 );
 
-    // define colors for chat window identifiers
-    vstrChatColors.Init ( 6 );
-    vstrChatColors[0] = "mediumblue";
-    vstrChatColors[1] = "red";
-    vstrChatColors[2] = "darkorchid";
-    vstrChatColors[3] = "green";
-    vstrChatColors[4] = "maroon";
-    vstrChatColors[5] = "coral";
+    vecpWorkers.Init ( iNumWorkers );
 
-    // set the server frame size
-    if ( bUseDoubleSystemFrameSize )
+    for ( int i = 0; i < iNumWorkers; i++ )
     {
-        iServerFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+        vecpWorkers[i] = new CWorkerThread ( this, i );
+        vecpWorkers[i]->start ( QThread::TimeCriticalPriority );
     }
-    else
+}
+
+void CServerWorkerPool::Stop()
+{
+    for ( int i = 0; i < vecpWorkers.Size(); i++ )
     {
-        iServerFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
+        vecpWorkers[i]->Stop();
+        delete vecpWorkers[i];
     }
 
+    vecpWorkers.Init ( 0 );
+    iNumWorkers = 0;
+}
 
-    // To avoid audio clitches, in the entire realtime timer audio processing
-    // routine including the ProcessData no memory must be allocated. Since we
-    // do not know the required sizes for the vectors, we allocate memory for
-    // the worst case here:
-
-    // allocate worst case memory for the temporary vectors
-    vecChanIDsCurConChan.Init          ( iMaxNumChannels );
-    vecvecdGains.Init                  ( iMaxNumChannels );
-    vecvecdPannings.Init               ( iMaxNumChannels );
-    vecvecsData.Init                   ( iMaxNumChannels );
-    vecvecsSendData.Init               ( iMaxNumChannels );
-    vecvecbyCodedData.Init             ( iMaxNumChannels );
-    vecNumAudioChannels.Init           ( iMaxNumChannels );
-    vecNumFrameSizeConvBlocks.Init     ( iMaxNumChannels );
-    vecUseDoubleSysFraSizeConvBuf.Init ( iMaxNumChannels );
-    vecAudioComprType.Init             ( iMaxNumChannels );
-
-    for ( i = 0; i < iMaxNumChannels; i++ )
+void CServerWorkerPool::Run ( const std::function<void ( const int )>& fJob,
+                              const int                                iNewNumItems,
+                              const int*                               piNewItemThread )
+{
+    // store the job parameters (note that the semaphores make sure that the
+    // worker threads see the new values)
+    pJob         = &fJob;
+    iNumItems    = iNewNumItems;
+    piItemThread = piNewItemThread;
+    iNextItem.store ( 0 );
+
+    // wake up the worker threads
+    for ( int i = 0; i < iNumWorkers; i++ )
     {
-        // init vectors storing information of all channels
-        vecvecdGains[i].Init    ( iMaxNumChannels );
-        vecvecdPannings[i].Init ( iMaxNumChannels );
-
-        // we always use stereo audio buffers (which is the worst case)
-        vecvecsData[i].Init ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
-
-        // (note that we only allocate iMaxNumChannels buffers for the send
-        // and coded data because of the OMP implementation)
-        vecvecsSendData[i].Init ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
-
-        // allocate worst case memory for the coded data
-        vecvecbyCodedData[i].Init ( MAX_SIZE_BYTES_NETW_BUF );
+        vecpWorkers[i]->StartSem.release();
     }
 
-    // allocate worst case memory for the channel levels
-    vecChannelLevels.Init ( iMaxNumChannels );
-
-    // enable history graph (if requested)
-    if ( !strHistoryFileName.isEmpty() )
+    // the calling thread does its share of the work, too
     {
-        Logging.EnableHistory ( strHistoryFileName );
+        TRACE_SCOPE ( TP_WORKER_ITEMS );
+        ProcessItems ( 0 );
     }
 
-    // enable logging (if requested)
-    if ( !strLoggingFileName.isEmpty() )
+    // frame barrier: wait until all worker threads are done
+    DoneSem.acquire ( iNumWorkers );
+
+    pJob         = nullptr;
+    piItemThread = nullptr;
+}
+
+void CServerWorkerPool::ProcessItems ( const int iThreadIdx )
+{
+    if ( piItemThread != nullptr )
     {
-        // in case the history is enabled and a logging file name is
-        // given, parse the logging file for old entries which are then
-        // added in the history on software startup
-        if ( !strHistoryFileName.isEmpty() )
+        // fixed assignment: each thread only processes its own items (items of
+        // threads which do not exist are processed by the calling thread)
+        for ( int i = 0; i < iNumItems; i++ )
         {
-            Logging.ParseLogFile ( strLoggingFileName );
+            if ( ( piItemThread[i] == iThreadIdx ) ||
+                 ( ( iThreadIdx == 0 ) && ( piItemThread[i] > iNumWorkers ) ) )
+            {
+                ( *pJob ) ( i );
+            }
         }
 
-        Logging.Start ( strLoggingFileName );
+        return;
     }
 
-    // HTML status file writing
-    if ( !strHTMLStatusFileName.isEmpty() )
-    {
-        QString strCurServerNameForHTMLStatusFile = strServerNameForHTMLStatusFile;
+    // each thread takes the next unprocessed item until all items are done
+    // (this gives us a good load balancing in case the items have different
+    // processing times, e.g. mono/stereo or different codecs)
+    int iCurItem = iNextItem.fetchAndAddOrdered ( 1 );
 
-        // if server name is empty, substitude a default name
-        if ( strCurServerNameForHTMLStatusFile.isEmpty() )
-        {
-            strCurServerNameForHTMLStatusFile = "[server address]";
-        }
+    while ( iCurItem < iNumItems )
+    {
+        ( *pJob ) ( iCurItem );
 
-        // (the static cast to integer of the port number is required so that it
-        // works correctly under Linux)
-        StartStatusHTMLFileWriting ( strHTMLStatusFileName,
-            strCurServerNameForHTMLStatusFile + ":" +
-            QString().number( static_cast<int> ( iPortNumber ) ) );
+        iCurItem = iNextItem.fetchAndAddOrdered ( 1 );
     }
+}
 
-    // manage welcome message: if the welcome message is a valid link to a local
-    // file, the content of that file is used as the welcome message (#361)
-    strWelcomeMessage = strNewWelcomeMessage; // first copy text, may be overwritten
-    if ( QFileInfo ( strNewWelcomeMessage ).exists() )
+void CServerWorkerPool::CWorkerThread::run()
+{
+    // pin the worker thread to a fixed CPU core to avoid cache misses caused
+    // by threads moved between cores (without a configured CPU list the first
+    // core is left for the calling thread)
+    const int iNumCores = QThread::idealThreadCount();
+
+    CThreadScheduling::ApplyToCurrentThread ( TR_WORKER,
+                                              iWorkerIdx,
+                                              ( iNumCores > 1 ) ? ( iWorkerIdx + 1 ) % iNumCores : -1 );
+
+    CTracer::SetThreadName ( "worker", iWorkerIdx );
+
+    while ( true )
     {
-        QFile file ( strNewWelcomeMessage );
+        // wait for the next frame to be processed
+        StartSem.acquire();
 
-        if ( file.open ( QIODevice::ReadOnly | QIODevice::Text ) )
+        if ( !bRun )
         {
-            // use entrie file content for the welcome message
-            strWelcomeMessage = file.readAll();
+            break;
         }
+
+        {
+            TRACE_SCOPE ( TP_WORKER_ITEMS );
+            pPool->ProcessItems ( iWorkerIdx + 1 );
+        }
+
+        // signal that this thread is done with the current frame
+        pPool->DoneSem.release();
     }
+}
 
-    // restrict welcome message to maximum allowed length
-    strWelcomeMessage = strWelcomeMessage.left ( MAX_LEN_CHAT_TEXT );
 
-    // enable jam recording (if requested) - kicks off the thread
-    if ( !strRecordingDirName.isEmpty() )
+// CServerChannelAffinity implementation ***************************************
+void CServerChannelAffinity::Init ( const int iMaxNumChannels )
+{
+    FrameCostNs.Init ( iMaxNumChannels, 1 );
+
+    for ( int i = 0; i < iMaxNumChannels; i++ )
     {
-        bRecorderInitialised = JamRecorder.Init ( this, iServerFrameSizeSamples );
-        SetEnableRecording ( bRecorderInitialised );
+        FrameCostNs.ResetRow ( i );
     }
 
-    // enable all channels (for the server all channel must be enabled the
-    // entire life time of the software)
-    for ( i = 0; i < iMaxNumChannels; i++ )
+    vecdAvCostNs.Init   ( iMaxNumChannels, -1.0 );
+    vecChanThread.Init  ( iMaxNumChannels, 0 );
+    vecItemThread.Init  ( iMaxNumChannels, 0 );
+    vecLastChanIDs.Init ( iMaxNumChannels, 0 );
+    vecSortIdx.Init     ( iMaxNumChannels, 0 );
+    vecdThreadLoad.Init ( MAX_NUM_SERVER_THREADS, 0.0 );
+
+    iNumThreads     = 0;
+    iLastNumClients = 0;
+}
+
+const int* CServerChannelAffinity::Update ( const CVector<int>& vecChanIDs,
+                                            const int           iNumClients,
+                                            const int           iNewNumThreads )
+{
+    // update the average costs with the measurements of the last frame (all
+    // threads are done with the last frame, i.e. we can read the values)
+    for ( int i = 0; i < iLastNumClients; i++ )
     {
-        vecChannels[i].SetEnable ( true );
+        const int    iChanID = vecLastChanIDs[i];
+        const qint64 iCostNs = FrameCostNs[iChanID][0];
+
+        FrameCostNs[iChanID][0] = 0;
+
+        if ( vecdAvCostNs[iChanID] < 0 )
+        {
+            vecdAvCostNs[iChanID] = static_cast<double> ( iCostNs );
+        }
+        else
+        {
+            vecdAvCostNs[iChanID] = SERVER_CHAN_COST_IIR_WEIGHT * vecdAvCostNs[iChanID] +
+                ( 1.0 - SERVER_CHAN_COST_IIR_WEIGHT ) * iCostNs;
+        }
     }
 
+    // the connected channels are ordered by their IDs, i.e. a join or leave
+    // is detected by an element-wise comparison with the last frame
+    bool bChanged = ( iNumClients != iLastNumClients ) || ( iNewNumThreads != iNumThreads );
 
-    // Connections -------------------------------------------------------------
-    // connect timer timeout signal
-    QObject::connect ( &HighPrecisionTimer, &CHighPrecisionTimer::timeout,
-        this, &CServer::OnTimer );
+    for ( int i = 0; ( i < iNumClients ) && !bChanged; i++ )
+    {
+        bChanged = ( vecChanIDs[i] != vecLastChanIDs[i] );
+    }
 
-    QObject::connect ( &ConnLessProtocol, &CProtocol::CLMessReadyForSending,
-        this, &CServer::OnSendCLProtMessage );
+    if ( bChanged )
+    {
+        // the costs of a channel which was not connected in the last frame are
+        // unknown (the channel may be used by a new client)
+        int iLast = 0;
 
-    QObject::connect ( &ConnLessProtocol, &CProtocol::CLPingReceived,
-        this, &CServer::OnCLPingReceived );
+        for ( int i = 0; i < iNumClients; i++ )
+        {
+            while ( ( iLast < iLastNumClients ) && ( vecLastChanIDs[iLast] < vecChanIDs[i] ) )
+            {
+                iLast++;
+            }
 
-    QObject::connect ( &ConnLessProtocol, &CProtocol::CLPingWithNumClientsReceived,
-        this, &CServer::OnCLPingWithNumClientsReceived );
+            if ( ( iLast >= iLastNumClients ) || ( vecLastChanIDs[iLast] != vecChanIDs[i] ) )
+            {
+                vecdAvCostNs[vecChanIDs[i]] = -1.0;
+            }
+        }
 
-    QObject::connect ( &ConnLessProtocol, &CProtocol::CLRegisterServerReceived,
-        this, &CServer::OnCLRegisterServerReceived );
+        iNumThreads = std::max ( 1, std::min ( iNewNumThreads, MAX_NUM_SERVER_THREADS ) );
 
-    QObject::connect ( &ConnLessProtocol, &CProtocol::CLUnregisterServerReceived,
-        this, &CServer::OnCLUnregisterServerReceived );
+        Rebalance ( vecChanIDs, iNumClients );
 
-    QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqServerList,
-        this, &CServer::OnCLReqServerList );
+        for ( int i = 0; i < iNumClients; i++ )
+        {
+            vecLastChanIDs[i] = vecChanIDs[i];
+        }
 
-    QObject::connect ( &ConnLessProtocol, &CProtocol::CLRegisterServerResp,
-        this, &CServer::OnCLRegisterServerResp );
+        iLastNumClients = iNumClients;
+    }
 
-    QObject::connect ( &ConnLessProtocol, &CProtocol::CLSendEmptyMes,
-        this, &CServer::OnCLSendEmptyMes );
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        vecItemThread[i] = vecChanThread[vecChanIDs[i]];
+    }
 
-    QObject::connect ( &ConnLessProtocol, &CProtocol::CLDisconnection,
-        this, &CServer::OnCLDisconnection );
+    return &vecItemThread[0];
+}
 
-    QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqVersionAndOS,
-        this, &CServer::OnCLReqVersionAndOS );
+void CServerChannelAffinity::Rebalance ( const CVector<int>& vecChanIDs,
+                                         const int           iNumClients )
+{
+    // new channels get the average cost of the known channels
+    double dCostSum  = 0;
+    int    iNumKnown = 0;
 
-    QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqConnClientsList,
-        this, &CServer::OnCLReqConnClientsList );
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        if ( vecdAvCostNs[vecChanIDs[i]] >= 0 )
+        {
+            dCostSum += vecdAvCostNs[vecChanIDs[i]];
+            iNumKnown++;
+        }
+    }
 
-    QObject::connect ( &ServerListManager, &CServerListManager::SvrRegStatusChanged,
-        this, &CServer::SvrRegStatusChanged );
+    const double dDefaultCostNs = ( iNumKnown > 0 ) ? std::max ( 1.0, dCostSum / iNumKnown ) : 1.0;
 
-    QObject::connect( &JamRecorder, &recorder::CJamRecorder::RecordingSessionStarted,
-        this, &CServer::RecordingSessionStarted );
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        if ( vecdAvCostNs[vecChanIDs[i]] < 0 )
+        {
+            vecdAvCostNs[vecChanIDs[i]] = dDefaultCostNs;
+        }
 
-    QObject::connect ( QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
-        this, &CServer::OnAboutToQuit );
+        vecSortIdx[i] = i;
+    }
 
-    QObject::connect ( pSignalHandler, &CSignalHandler::HandledSignal,
-        this, &CServer::OnHandledSignal );
+    // longest processing time first: the channels are sorted by decreasing
+    // costs and each channel is assigned to the thread with the lowest load
+    std::sort ( &vecSortIdx[0], &vecSortIdx[0] + iNumClients, [&] ( const int iA, const int iB )
+        { return vecdAvCostNs[vecChanIDs[iA]] > vecdAvCostNs[vecChanIDs[iB]]; } );
 
-    connectChannelSignalsToServerSlots<MAX_NUM_CHANNELS>();
+    std::fill ( &vecdThreadLoad[0], &vecdThreadLoad[0] + iNumThreads, 0.0 );
 
-    // start the socket (it is important to start the socket after all
-    // initializations and connections)
-    Socket.Start();
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        const int iChanID    = vecChanIDs[vecSortIdx[i]];
+        int       iMinThread = 0;
+
+        for ( int iT = 1; iT < iNumThreads; iT++ )
+        {
+            if ( vecdThreadLoad[iT] < vecdThreadLoad[iMinThread] )
+            {
+                iMinThread = iT;
+            }
+        }
+
+        vecChanThread[iChanID]      = iMinThread;
+        vecdThreadLoad[iMinThread] += vecdAvCostNs[iChanID];
+    }
 }
 
-template<unsigned int slotId>
-inline void CServer::connectChannelSignalsToServerSlots()
+
+// CServerFrameSizeAdapter implementation **************************************
+void CServerFrameSizeAdapter::Init ( const int iNServerFrameSizeSamples )
 {
-    int iCurChanID = slotId - 1;
+    iServerFrameSize = iNServerFrameSizeSamples;
+
+    vecsFrameIn.Init  ( 2 /* stereo */ * MAX_CODEC_FRAME_SIZE_SAMPLES );
+    vecsFrameOut.Init ( 2 /* stereo */ * MAX_CODEC_FRAME_SIZE_SAMPLES );
 
-    void ( CServer::* pOnSendProtMessCh )( CVector<uint8_t> ) =
-        &CServerSlots<slotId>::OnSendProtMessCh;
+    // force an update of the properties on the next call
+    iCodecFrameSize = 0;
+    SetProperties ( iServerFrameSize, 1 );
+}
 
-    void ( CServer::* pOnReqConnClientsListCh )() =
-        &CServerSlots<slotId>::OnReqConnClientsListCh;
+void CServerFrameSizeAdapter::SetProperties ( const int iNCodecFrameSizeSamples,
+                                              const int iNNumAudioChannels )
+{
+    if ( ( iNCodecFrameSizeSamples == iCodecFrameSize ) &&
+         ( iNNumAudioChannels == iNumAudioChannels ) )
+    {
+        return;
+    }
 
-    void ( CServer::* pOnChatTextReceivedCh )( QString ) =
-        &CServerSlots<slotId>::OnChatTextReceivedCh;
+    iCodecFrameSize   = iNCodecFrameSizeSamples;
+    iNumAudioChannels = iNNumAudioChannels;
+    bSplitCodecFrame  = ( iCodecFrameSize > iServerFrameSize );
 
-    void ( CServer::* pOnMuteStateHasChangedCh )( int, bool ) =
-        &CServerSlots<slotId>::OnMuteStateHasChangedCh;
+    if ( bSplitCodecFrame )
+    {
+        iNumCodecBlocks  = 1;
+        iNumServerFrames = iCodecFrameSize / iServerFrameSize;
+    }
+    else
+    {
+        iNumCodecBlocks  = std::min ( iServerFrameSize / iCodecFrameSize,
+                                      MAX_NUM_FRAME_SIZE_CONV_BLOCKS );
+        iNumServerFrames = 1;
+    }
 
-    void ( CServer::* pOnServerAutoSockBufSizeChangeCh )( int ) =
-        &CServerSlots<slotId>::OnServerAutoSockBufSizeChangeCh;
+    Reset();
+}
 
-    // send message
-    QObject::connect ( &vecChannels[iCurChanID], &CChannel::MessReadyForSending,
-                       this, pOnSendProtMessCh );
+bool CServerFrameSizeAdapter::NextServerFrameIn()
+{
+    if ( bSplitCodecFrame && ( iInFrameIdx < iNumServerFrames - 1 ) )
+    {
+        iInFrameIdx++;
+        return true;
+    }
 
-    // request connected clients list
-    QObject::connect ( &vecChannels[iCurChanID], &CChannel::ReqConnClientsList,
-                       this, pOnReqConnClientsListCh );
+    return false;
+}
 
-    // channel info has changed
-    QObject::connect ( &vecChannels[iCurChanID], &CChannel::ChanInfoHasChanged,
-                       this, &CServer::CreateAndSendChanListForAllConChannels );
+int16_t* CServerFrameSizeAdapter::GetCodecFrameIn ( int16_t* psServerData )
+{
+    if ( !bSplitCodecFrame )
+    {
+        return psServerData;
+    }
 
-    // chat text received
-    QObject::connect ( &vecChannels[iCurChanID], &CChannel::ChatTextReceived,
-                       this, pOnChatTextReceivedCh );
+    iInFrameIdx = 0;
+    return &vecsFrameIn[0];
+}
 
-    // other mute state has changed
-    QObject::connect ( &vecChannels[iCurChanID], &CChannel::MuteStateHasChanged,
-                       this, pOnMuteStateHasChangedCh );
+const int16_t* CServerFrameSizeAdapter::PutServerFrameOut ( const int16_t* psServerData )
+{
+    if ( !bSplitCodecFrame )
+    {
+        return psServerData;
+    }
 
-    // auto socket buffer size change
-    QObject::connect ( &vecChannels[iCurChanID], &CChannel::ServerAutoSockBufSizeChange,
-                       this, pOnServerAutoSockBufSizeChangeCh );
+    // the server frames are mixed in place until the codec frame is complete
+    if ( ++iOutFrameIdx < iNumServerFrames )
+    {
+        return nullptr;
+    }
 
-    connectChannelSignalsToServerSlots<slotId - 1>();
+    iOutFrameIdx = 0;
+    return &vecsFrameOut[0];
 }
 
-template<>
-inline void CServer::connectChannelSignalsToServerSlots<0>() {}
 
-void CServer::CreateAndSendJitBufMessage ( const int iCurChanID,
-                                           const int iNNumFra )
+// CServerOpusCodecs implementation ********************************************
+CServerOpusCodecs::CServerOpusCodecs() :
+    pOpusMode       ( nullptr ),
+    pOpus64Mode     ( nullptr ),
+    pEncoder        ( nullptr ),
+    pDecoder        ( nullptr ),
+    iEncoderIdx           ( INVALID_INDEX ),
+    iDecoderIdx           ( INVALID_INDEX ),
+    iEncoderBitRate       ( 0 ),
+    pRedEncoder           ( nullptr ),
+    iRedEncoderIdx        ( INVALID_INDEX ),
+    iRedEncoderBitRate    ( 0 )
 {
-    vecChannels[iCurChanID].CreateJitBufMes ( iNNumFra );
+    for ( int i = 0; i < SERVER_NUM_CODEC_INDICES; i++ )
+    {
+        pSpareEncoders[i] = nullptr;
+        pSpareDecoders[i] = nullptr;
+    }
 }
 
-void CServer::SendProtMessage ( int iChID, CVector<uint8_t> vecMessage )
+void CServerOpusCodecs::Init ( OpusCustomMode* pNOpusMode,
+                               OpusCustomMode* pNOpus64Mode )
 {
-    // the protocol queries me to call the function to send the message
-    // send it through the network
-    Socket.SendPacket ( vecMessage, vecChannels[iChID].GetAddress() );
+    Release();
+
+    pOpusMode   = pNOpusMode;
+    pOpus64Mode = pNOpus64Mode;
 }
 
-void CServer::OnNewConnection ( int          iChID,
-                                CHostAddress RecHostAddr )
+void CServerOpusCodecs::Release()
 {
-    // inform the client about its own ID at the server (note that this
-    // must be the first message to be sent for a new connection)
-    vecChannels[iChID].CreateClientIDMes ( iChID );
-
-    // on a new connection we query the network transport properties for the
-    // audio packets (to use the correct network block size and audio
-    // compression properties, etc.)
-    vecChannels[iChID].CreateReqNetwTranspPropsMes();
-
-    // this is a new connection, query the jitter buffer size we shall use
-    // for this client (note that at the same time on a new connection the
-    // client sends the jitter buffer size by default but maybe we have
-    // reached a state where this did not happen because of network trouble,
-    // client or server thinks that the connection was still active, etc.)
-    vecChannels[iChID].CreateReqJitBufMes();
-
-    // A new client connected to the server, the channel list
-    // at all clients have to be updated. This is done by sending
-    // a channel name request to the client which causes a channel
-    // name message to be transmitted to the server. If the server
-    // receives this message, the channel list will be automatically
-    // updated (implicitely).
-    //
-    // Usually it is not required to send the channel list to the
-    // client currently connecting since it automatically requests
-    // the channel list on a new connection (as a result, he will
-    // usually get the list twice which has no impact on functionality
-    // but will only increase the network load a tiny little bit). But
-    // in case the client thinks he is still connected but the server
-    // was restartet, it is important that we send the channel list
-    // at this place.
-    vecChannels[iChID].CreateReqChanInfoMes();
-
-    // send welcome message (if enabled)
-    if ( !strWelcomeMessage.isEmpty() )
+    if ( pEncoder != nullptr )
     {
-        // create formated server welcome message and send it just to
-        // the client which just connected to the server
-        const QString strWelcomeMessageFormated =
-            "<b>Server Welcome Message:</b> " + strWelcomeMessage;
+        opus_custom_encoder_destroy ( pEncoder );
+        pEncoder = nullptr;
+    }
 
-        vecChannels[iChID].CreateChatTextMes ( strWelcomeMessageFormated );
+    if ( pRedEncoder != nullptr )
+    {
+        opus_custom_encoder_destroy ( pRedEncoder );
+        pRedEncoder = nullptr;
     }
 
-    // send licence request message (if enabled)
-    if ( eLicenceType != LT_NO_LICENCE )
+    if ( pDecoder != nullptr )
     {
-        vecChannels[iChID].CreateLicReqMes ( eLicenceType );
+        opus_custom_decoder_destroy ( pDecoder );
+        pDecoder = nullptr;
     }
 
-    // send version info (for, e.g., feature activation in the client)
-    vecChannels[iChID].CreateVersionAndOSMes();
+    for ( int i = 0; i < SERVER_NUM_CODEC_INDICES; i++ )
+    {
+        if ( pSpareEncoders[i] != nullptr )
+        {
+            opus_custom_encoder_destroy ( pSpareEncoders[i] );
+            pSpareEncoders[i] = nullptr;
+        }
 
-    // send recording state message on connection
-    vecChannels[iChID].CreateRecorderStateMes ( GetRecorderState() );
+        if ( pSpareDecoders[i] != nullptr )
+        {
+            opus_custom_decoder_destroy ( pSpareDecoders[i] );
+            pSpareDecoders[i] = nullptr;
+        }
+    }
 
-    // reset the conversion buffers
-    DoubleFrameSizeConvBufIn[iChID].Reset();
-    DoubleFrameSizeConvBufOut[iChID].Reset();
+    iEncoderIdx    = INVALID_INDEX;
+    iRedEncoderIdx = INVALID_INDEX;
+    iDecoderIdx    = INVALID_INDEX;
 
-    // logging of new connected channel
-    Logging.AddNewConnection ( RecHostAddr.InetAddr );
+    // the codecs are released if the channel is disconnected
+    EncoderProfile.Reset();
 }
 
-void CServer::OnServerFull ( CHostAddress RecHostAddr )
+OpusCustomMode* CServerOpusCodecs::GetMode ( const EAudComprType eAudComprType )
 {
-    // inform the calling client that no channel is free
-    ConnLessProtocol.CreateCLServerFullMes ( RecHostAddr );
+    return ( eAudComprType == CT_OPUS64 ) ? pOpus64Mode : pOpusMode;
 }
 
-void CServer::OnSendCLProtMessage ( CHostAddress     InetAddr,
-                                    CVector<uint8_t> vecMessage )
+int CServerOpusCodecs::GetCodecIndex ( const EAudComprType eAudComprType,
+                                       const int           iNumAudioChannels )
 {
-    // the protocol queries me to call the function to send the message
-    // send it through the network
-    Socket.SendPacket ( vecMessage, InetAddr );
-}
+    const int iStereoOffs = ( iNumAudioChannels == 1 ) ? 0 : 1;
 
-void CServer::OnProtcolCLMessageReceived ( int              iRecID,
-                                           CVector<uint8_t> vecbyMesBodyData,
-                                           CHostAddress     RecHostAddr )
-{
-    // connection less messages are always processed
-    ConnLessProtocol.ParseConnectionLessMessageBody ( vecbyMesBodyData,
-                                                      iRecID,
-                                                      RecHostAddr );
+    if ( eAudComprType == CT_OPUS )
+    {
+        return iStereoOffs;
+    }
+
+    if ( eAudComprType == CT_OPUS64 )
+    {
+        return 2 + iStereoOffs;
+    }
+
+    return INVALID_INDEX;
 }
 
-void CServer::OnCLDisconnection ( CHostAddress InetAddr )
+OpusCustomEncoder* CServerOpusCodecs::GetEncoder ( const EAudComprType     eAudComprType,
+                                                   const int               iNumAudioChannels,
+                                                   const int               iCeltNumCodedBytes,
+                                                   const EEncoderCpuLoad   eCpuLoad,
+                                                   const CChannelNetStats& NetStats )
 {
-    // check if the given address is actually a client which is connected to
-    // this server, if yes, disconnect it
-    const int iCurChanID = FindChannel ( InetAddr );
+    int       iOpusError;
+    const int iIdx = GetCodecIndex ( eAudComprType, iNumAudioChannels );
 
-    if ( iCurChanID != INVALID_CHANNEL_ID )
+    if ( iIdx == INVALID_INDEX )
     {
-        vecChannels[iCurChanID].Disconnect();
+        return nullptr;
     }
-}
 
-void CServer::OnAboutToQuit()
-{
-    // if enabled, disconnect all clients on quit
-    if ( bDisconnectAllClientsOnQuit )
+    // switch the encoder if the audio stream properties were changed (the
+    // encoder of the previous properties is kept for a switch back)
+    if ( iIdx != iEncoderIdx )
     {
-        Mutex.lock();
+        if ( pEncoder != nullptr )
         {
-            for ( int i = 0; i < iMaxNumChannels; i++ )
+            pSpareEncoders[iEncoderIdx] = pEncoder;
+        }
+
+        pEncoder             = pSpareEncoders[iIdx];
+        pSpareEncoders[iIdx] = nullptr;
+        iEncoderIdx          = iIdx;
+        iEncoderBitRate      = 0; // the bit rate is set below
+
+        if ( pEncoder != nullptr )
+        {
+            // a kept encoder starts from silence like a new one (the
+            // configuration is not changed by the reset)
+            opus_custom_encoder_ctl ( pEncoder, OPUS_RESET_STATE );
+        }
+        else
+        {
+            pEncoder = opus_custom_encoder_create ( GetMode ( eAudComprType ), iNumAudioChannels == 1 ? 1 : 2, &iOpusError );
+
+            if ( pEncoder == nullptr )
             {
-                if ( vecChannels[i].IsConnected() )
-                {
-                    ConnLessProtocol.CreateCLDisconnection ( vecChannels[i].GetAddress() );
-                }
+                iEncoderIdx = INVALID_INDEX;
+                return nullptr;
             }
+
+            // we require a constant bit rate
+            opus_custom_encoder_ctl ( pEncoder, OPUS_SET_VBR ( 0 ) );
+
+            // we want as low delay as possible
+            opus_custom_encoder_ctl ( pEncoder, OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
         }
-        Mutex.unlock(); // release mutex
+
+        // the complexity and the expected packet loss are set by the profile
+        EncoderProfile.ResetApplied();
     }
 
-    Stop();
+    // the bit rate only changes if the network frame size was changed, only
+    // in that case the encoder has to be re-configured
+    const int iBitRate = CalcBitRateBitsPerSecFromCodedBytes ( iCeltNumCodedBytes,
+                                                               GetCodecFrameSizeSamples ( eAudComprType ) );
 
-    // if server was registered at the central server, unregister on shutdown
-    if ( GetServerListEnabled() )
+    if ( iBitRate != iEncoderBitRate )
     {
-        UnregisterSlaveServer();
+        opus_custom_encoder_ctl ( pEncoder, OPUS_SET_BITRATE ( iBitRate ) );
+        iEncoderBitRate = iBitRate;
     }
+
+    // the profile only re-configures the encoder if the CPU load class or the
+    // network quality of the channel was changed
+    EncoderProfile.UpdateNetStats ( NetStats.iNumReceived, NetStats.iNumLost );
+
+    EncoderProfile.Apply ( pEncoder,
+                           eAudComprType,
+                           iNumAudioChannels,
+                           iBitRate,
+                           eCpuLoad );
+
+    return pEncoder;
 }
 
-void CServer::OnHandledSignal ( int sigNum )
+OpusCustomEncoder* CServerOpusCodecs::GetRedEncoder ( const EAudComprType eAudComprType,
+                                                      const int           iNumAudioChannels,
+                                                      const int           iRedNumCodedBytes )
 {
-    // show the signal number on the command line (note that this does not work for the Windows command line)
-// TODO we should use the ConsoleWriterFactory() instead of qDebug()
-    qDebug() << "OnHandledSignal: " << sigNum;
+    int       iOpusError;
+    const int iIdx = GetCodecIndex ( eAudComprType, iNumAudioChannels );
 
-#ifdef _WIN32
-    // Windows does not actually get OnHandledSignal triggered
-    QCoreApplication::instance()->exit();
-    Q_UNUSED ( sigNum )
-#else
-    switch ( sigNum )
+    if ( iIdx == INVALID_INDEX )
     {
+        return nullptr;
+    }
 
-    case SIGUSR1:
-        RequestNewRecording();
-        break;
-
-    case SIGUSR2:
-        SetEnableRecording ( !bEnableRecording );
-        break;
+    // (re-)create the encoder if the audio stream properties were changed
+    if ( iIdx != iRedEncoderIdx )
+    {
+        if ( pRedEncoder != nullptr )
+        {
+            opus_custom_encoder_destroy ( pRedEncoder );
+        }
 
-    case SIGINT:
-    case SIGTERM:
-        // This should trigger OnAboutToQuit
-        QCoreApplication::instance()->exit();
-        break;
+        pRedEncoder        = opus_custom_encoder_create ( GetMode ( eAudComprType ), iNumAudioChannels == 1 ? 1 : 2, &iOpusError );
+        iRedEncoderIdx     = iIdx;
+        iRedEncoderBitRate = 0; // the bit rate is set below
+
+        if ( pRedEncoder == nullptr )
+        {
+            iRedEncoderIdx = INVALID_INDEX;
+            return nullptr;
+        }
+
+        // same configuration as the encoder of the regular frames, the
+        // redundant frames always use a low complexity and are decoded after
+        // a packet loss only (reduces the inter frame prediction)
+        opus_custom_encoder_ctl ( pRedEncoder, OPUS_SET_VBR ( 0 ) );
+        opus_custom_encoder_ctl ( pRedEncoder, OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+        opus_custom_encoder_ctl ( pRedEncoder, OPUS_SET_PACKET_LOSS_PERC ( 35 ) );
+        opus_custom_encoder_ctl ( pRedEncoder, OPUS_SET_COMPLEXITY ( 1 ) );
+    }
+
+    const int iBitRate = CalcBitRateBitsPerSecFromCodedBytes ( iRedNumCodedBytes,
+                                                               GetCodecFrameSizeSamples ( eAudComprType ) );
+
+    if ( iBitRate != iRedEncoderBitRate )
+    {
+        opus_custom_encoder_ctl ( pRedEncoder, OPUS_SET_BITRATE ( iBitRate ) );
+        iRedEncoderBitRate = iBitRate;
+    }
+
+    return pRedEncoder;
+}
+
+OpusCustomDecoder* CServerOpusCodecs::GetDecoder ( const EAudComprType eAudComprType,
+                                                   const int           iNumAudioChannels )
+{
+    int       iOpusError;
+    const int iIdx = GetCodecIndex ( eAudComprType, iNumAudioChannels );
+
+    if ( iIdx == INVALID_INDEX )
+    {
+        return nullptr;
+    }
+
+    // switch the decoder if the audio stream properties were changed (the
+    // decoder of the previous properties is kept for a switch back)
+    if ( iIdx != iDecoderIdx )
+    {
+        if ( pDecoder != nullptr )
+        {
+            pSpareDecoders[iDecoderIdx] = pDecoder;
+        }
+
+        pDecoder             = pSpareDecoders[iIdx];
+        pSpareDecoders[iIdx] = nullptr;
+
+        if ( pDecoder != nullptr )
+        {
+            opus_custom_decoder_ctl ( pDecoder, OPUS_RESET_STATE );
+        }
+        else
+        {
+            pDecoder = opus_custom_decoder_create ( GetMode ( eAudComprType ), iNumAudioChannels == 1 ? 1 : 2, &iOpusError );
+        }
+
+        iDecoderIdx = ( pDecoder != nullptr ) ? iIdx : INVALID_INDEX;
+    }
+
+    return pDecoder;
+}
+
+
+// CServerSilentMix implementation *********************************************
+bool CServerSilentMix::Update ( const bool          bIsSilent,
+                                const EAudComprType eNAudComprType,
+                                const int           iNNumAudioChannels,
+                                const int           iNCeltNumCodedBytes )
+{
+    if ( !bIsSilent ||
+         ( eAudComprType != eNAudComprType ) ||
+         ( iNumAudioChannels != iNNumAudioChannels ) ||
+         ( iCeltNumCodedBytes != iNCeltNumCodedBytes ) )
+    {
+        eAudComprType      = eNAudComprType;
+        iNumAudioChannels  = iNNumAudioChannels;
+        iCeltNumCodedBytes = iNCeltNumCodedBytes;
+        iNumSilentFrames   = 0;
+        return false;
+    }
+
+    if ( iNumSilentFrames < SERVER_SILENT_MIX_NUM_ENCODED )
+    {
+        iNumSilentFrames++;
+        return false;
+    }
+
+    return true;
+}
+
+
+// CServerSharedStream implementation ******************************************
+void CServerSharedStream::Init ( OpusCustomMode* pNOpusMode,
+                                 OpusCustomMode* pNOpus64Mode,
+                                 const int       iNServerFrameSizeSamples )
+{
+    iServerFrameSize = iNServerFrameSizeSamples;
+
+    OpusCodecs.Init ( pNOpusMode, pNOpus64Mode );
+    FrameSizeAdapter.Init ( iServerFrameSize );
+
+    // allocate worst case memory (no allocation in the timer processing)
+    vecfMixData.Init ( 2 /* stereo */ * iServerFrameSize );
+    vecsSendData.Init ( 2 /* stereo */ * MAX_CODEC_FRAME_SIZE_SAMPLES );
+    vecvecbyCodedData.Init ( MAX_NUM_FRAME_SIZE_CONV_BLOCKS );
+
+    for ( int iB = 0; iB < MAX_NUM_FRAME_SIZE_CONV_BLOCKS; iB++ )
+    {
+        vecvecbyCodedData[iB].Init ( MAX_SIZE_BYTES_NETW_BUF );
+    }
+
+    vecbyPacket.Init       ( MAX_SIZE_BYTES_NETW_BUF );
+    vecMulticastPorts.Init ( MAX_NUM_CHANNELS );
+}
+
+void CServerSharedStream::SetKey ( const EAudComprType eNAudComprType,
+                                   const int           iNNumAudioChannels,
+                                   const int           iNCeltNumCodedBytes,
+                                   const quint64       iNMixSignature,
+                                   const int           iNRefClientIdx )
+{
+    if ( ( eAudComprType != eNAudComprType ) ||
+         ( iNumAudioChannels != iNNumAudioChannels ) )
+    {
+        // a partly collected codec frame cannot be used anymore
+        bFrameReady = false;
+        FrameSizeAdapter.SetProperties ( GetCodecFrameSizeSamples ( eNAudComprType ),
+                                         iNNumAudioChannels );
+    }
+
+    eAudComprType      = eNAudComprType;
+    iNumAudioChannels  = iNNumAudioChannels;
+    iCeltNumCodedBytes = iNCeltNumCodedBytes;
+    iMixSignature      = iNMixSignature;
+    iRefClientIdx      = iNRefClientIdx;
+}
+
+void CServerSharedStream::ReleaseIfUnused()
+{
+    if ( IsFree() && ( eAudComprType != CT_NONE ) )
+    {
+        // the stream can be taken by any group now
+        OpusCodecs.Release();
+        FrameSizeAdapter.Reset();
+        SilentMix.Reset();
+        eAudComprType = CT_NONE;
+        bFrameReady   = false;
+    }
+}
+
+void CServerSharedStream::AddMulticastPort ( const quint16 iPort )
+{
+    for ( int i = 0; i < iNumMulticastPorts; i++ )
+    {
+        if ( vecMulticastPorts[i] == iPort )
+        {
+            return;
+        }
+    }
+
+    if ( iNumMulticastPorts < vecMulticastPorts.Size() )
+    {
+        vecMulticastPorts[iNumMulticastPorts++] = iPort;
+    }
+}
+
+const CVector<uint8_t>& CServerSharedStream::GetPacket ( int& iNumBytes )
+{
+    const int iNumBlocks = FrameSizeAdapter.GetNumCodecBlocks();
+
+    for ( int iB = 0; iB < iNumBlocks; iB++ )
+    {
+        std::copy ( vecvecbyCodedData[iB].begin(),
+                    vecvecbyCodedData[iB].begin() + iCeltNumCodedBytes,
+                    vecbyPacket.begin() + iB * iCeltNumCodedBytes );
+    }
+
+    iNumBytes = iNumBlocks * iCeltNumCodedBytes;
+    return vecbyPacket;
+}
+
+void CServerSharedStream::Encode ( const EEncoderCpuLoad eCpuLoad,
+                                   const bool            bIsSilentMix )
+{
+    int iUnused;
+
+    const bool bSkipEncoding = SilentMix.Update ( bIsSilentMix,
+                                                  eAudComprType,
+                                                  iNumAudioChannels,
+                                                  iCeltNumCodedBytes );
+
+    const int16_t* psCodecFrame = FrameSizeAdapter.PutServerFrameOut ( &vecsSendData[0] );
+
+    bFrameReady = ( psCodecFrame != nullptr );
+
+    // the last coded blocks are sent again
+    if ( !bFrameReady || bSkipEncoding )
+    {
+        return;
+    }
+
+    // the stream is not related to the network conditions of one client,
+    // therefore no network statistics are used for the encoder profile
+    OpusCustomEncoder* CurOpusEncoder = OpusCodecs.GetEncoder ( eAudComprType,
+                                                                iNumAudioChannels,
+                                                                iCeltNumCodedBytes,
+                                                                eCpuLoad,
+                                                                CChannelNetStats() );
+
+    for ( int iB = 0; iB < FrameSizeAdapter.GetNumCodecBlocks(); iB++ )
+    {
+        if ( CurOpusEncoder != nullptr )
+        {
+            iUnused = opus_custom_encode ( CurOpusEncoder,
+                                           &psCodecFrame[FrameSizeAdapter.GetCodecBlockOffset ( iB )],
+                                           FrameSizeAdapter.GetCodecFrameSizeSamples(),
+                                           &vecvecbyCodedData[iB][0],
+                                           iCeltNumCodedBytes );
+        }
+    }
+
+    Q_UNUSED ( iUnused )
+}
+
+
+// CChannelAddressIndex implementation *****************************************
+void CChannelAddressIndex::Reset()
+{
+    for ( int i = 0; i < CHAN_ADDR_INDEX_SIZE; i++ )
+    {
+        ChanIDs[i] = INVALID_CHANNEL_ID;
+    }
+
+    for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+    {
+        bChanHasKey[i] = false;
+    }
+}
+
+CChannelAddressIndex::CKey CChannelAddressIndex::GetKey ( const CHostAddress& Addr )
+{
+    CKey Key;
+
+    for ( int i = 0; i < 8; i++ )
+    {
+        Key.iAddrHi = ( Key.iAddrHi << 8 ) | Addr.Addr[i];
+        Key.iAddrLo = ( Key.iAddrLo << 8 ) | Addr.Addr[i + 8];
+    }
+
+    Key.iPort = Addr.iPort;
+
+    return Key;
+}
+
+int CChannelAddressIndex::GetHashIndex ( const CKey& Key )
+{
+    // mix all bits of the key (64 bit multiplicative hashing)
+    quint64 iHash = Key.iAddrHi ^ ( Key.iAddrLo * Q_UINT64_C ( 0x9E3779B97F4A7C15 ) ) ^
+        ( static_cast<quint64> ( Key.iPort ) << 17 );
+
+    iHash ^= iHash >> 29;
+    iHash *= Q_UINT64_C ( 0xBF58476D1CE4E5B9 );
+    iHash ^= iHash >> 32;
+
+    return static_cast<int> ( iHash & ( CHAN_ADDR_INDEX_SIZE - 1 ) );
+}
+
+int CChannelAddressIndex::Find ( const CHostAddress& Addr ) const
+{
+    const CKey Key = GetKey ( Addr );
+
+    for ( int iIdx = GetHashIndex ( Key ); ChanIDs[iIdx] != INVALID_CHANNEL_ID;
+          iIdx = ( iIdx + 1 ) & ( CHAN_ADDR_INDEX_SIZE - 1 ) )
+    {
+        if ( Keys[iIdx] == Key )
+        {
+            return ChanIDs[iIdx];
+        }
+    }
+
+    return INVALID_CHANNEL_ID;
+}
+
+void CChannelAddressIndex::Insert ( const CHostAddress& Addr,
+                                    const int           iChanID )
+{
+    if ( ( iChanID < 0 ) || ( iChanID >= MAX_NUM_CHANNELS ) )
+    {
+        return;
+    }
+
+    // remove the previous address of this channel and a stale entry of
+    // another channel with the same address
+    Erase ( iChanID );
+
+    const CKey Key        = GetKey ( Addr );
+    const int  iOldChanID = Find ( Addr );
+
+    if ( iOldChanID != INVALID_CHANNEL_ID )
+    {
+        Erase ( iOldChanID );
+    }
+
+    int iIdx = GetHashIndex ( Key );
+
+    while ( ChanIDs[iIdx] != INVALID_CHANNEL_ID )
+    {
+        iIdx = ( iIdx + 1 ) & ( CHAN_ADDR_INDEX_SIZE - 1 );
+    }
+
+    Keys[iIdx]           = Key;
+    ChanIDs[iIdx]        = iChanID;
+    ChanKeys[iChanID]    = Key;
+    bChanHasKey[iChanID] = true;
+}
+
+void CChannelAddressIndex::Erase ( const int iChanID )
+{
+    if ( !bChanHasKey[iChanID] )
+    {
+        return;
+    }
+
+    bChanHasKey[iChanID] = false;
+
+    // find the slot of the channel
+    int iIdx = GetHashIndex ( ChanKeys[iChanID] );
+
+    while ( ChanIDs[iIdx] != iChanID )
+    {
+        if ( ChanIDs[iIdx] == INVALID_CHANNEL_ID )
+        {
+            return; // should never happen
+        }
+
+        iIdx = ( iIdx + 1 ) & ( CHAN_ADDR_INDEX_SIZE - 1 );
+    }
+
+    // backward shift deletion: move up the following entries of the probe
+    // sequence so that no tombstones are required
+    ChanIDs[iIdx] = INVALID_CHANNEL_ID;
+
+    for ( int iNext = ( iIdx + 1 ) & ( CHAN_ADDR_INDEX_SIZE - 1 ); ChanIDs[iNext] != INVALID_CHANNEL_ID;
+          iNext = ( iNext + 1 ) & ( CHAN_ADDR_INDEX_SIZE - 1 ) )
+    {
+        const int iHome = GetHashIndex ( Keys[iNext] );
+
+        // the entry can be moved to the free slot if its home slot is not
+        // located cyclically in ( iIdx, iNext ]
+        if ( ( ( iNext - iHome ) & ( CHAN_ADDR_INDEX_SIZE - 1 ) ) >=
+             ( ( iNext - iIdx ) & ( CHAN_ADDR_INDEX_SIZE - 1 ) ) )
+        {
+            Keys[iIdx]     = Keys[iNext];
+            ChanIDs[iIdx]  = ChanIDs[iNext];
+            ChanIDs[iNext] = INVALID_CHANNEL_ID;
+            iIdx           = iNext;
+        }
+    }
+}
+
+
+// CServerFrameProfiler implementation *****************************************
+void CServerFrameProfiler::Reset()
+{
+    iClientsSum = 0;
+    iNumFrames  = 0;
+
+    for ( int iS = 0; iS < NUM_SERVER_FRAME_STAGES; iS++ )
+    {
+        iNumValues[iS] = 0;
+        iMaxNs[iS]     = 0;
+
+        for ( int iB = 0; iB < PROFILER_NUM_BINS; iB++ )
+        {
+            iBins[iS][iB] = 0;
+        }
+    }
+}
+
+void CServerFrameProfiler::AddValue ( const EServerFrameStage eStage,
+                                      const qint64            iDurationNs )
+{
+    // get the bin index from the position of the most significant bit and
+    // the following bits of the duration
+    int iBin = 0;
+
+    if ( iDurationNs >= PROFILER_NUM_BINS_PER_OCTAVE )
+    {
+        int iMsb = 0;
+
+        while ( ( iDurationNs >> ( iMsb + 1 ) ) != 0 )
+        {
+            iMsb++;
+        }
+
+        iBin = iMsb * PROFILER_NUM_BINS_PER_OCTAVE +
+            static_cast<int> ( ( iDurationNs >> ( iMsb - 2 ) ) & ( PROFILER_NUM_BINS_PER_OCTAVE - 1 ) );
+
+        iBin = std::min ( iBin, PROFILER_NUM_BINS - 1 );
+    }
+
+    iBins[eStage][iBin]++;
+    iNumValues[eStage]++;
+    iMaxNs[eStage] = std::max ( iMaxNs[eStage], iDurationNs );
+}
+
+void CServerFrameProfiler::GetStageDurationsUs ( const EServerFrameStage eStage,
+                                                 double&                 dP50Us,
+                                                 double&                 dP99Us,
+                                                 double&                 dMaxUs ) const
+{
+    dP50Us = GetPercentileUs ( eStage, 0.5 );
+    dP99Us = GetPercentileUs ( eStage, 0.99 );
+    dMaxUs = static_cast<double> ( iMaxNs[eStage] ) / 1000;
+}
+
+double CServerFrameProfiler::GetPercentileUs ( const EServerFrameStage eStage,
+                                               const double            dPercentile ) const
+{
+    const int iTargetCnt = static_cast<int> ( dPercentile * iNumValues[eStage] );
+    int       iCnt       = 0;
+
+    for ( int iB = 0; iB < PROFILER_NUM_BINS; iB++ )
+    {
+        iCnt += iBins[eStage][iB];
+
+        if ( iCnt > iTargetCnt )
+        {
+            // use the lower bound of the bin as the value
+            const int    iMsb     = iB / PROFILER_NUM_BINS_PER_OCTAVE;
+            const int    iFrac    = iB % PROFILER_NUM_BINS_PER_OCTAVE;
+            const double dLowerNs = ( iMsb < 2 ) ? iB : std::ldexp ( 1.0 + static_cast<double> ( iFrac ) / PROFILER_NUM_BINS_PER_OCTAVE, iMsb );
+
+            return dLowerNs / 1000;
+        }
+    }
+
+    return static_cast<double> ( iMaxNs[eStage] ) / 1000;
+}
+
+QString CServerFrameProfiler::GetReport() const
+{
+    static const char* strStageNames[NUM_SERVER_FRAME_STAGES] =
+        { "collect", "decode", "common mix", "levels", "mix/encode", "send" };
+
+    if ( iNumFrames == 0 )
+    {
+        return "";
+    }
+
+    QString strReport = QString ( "Frame stages p50/p99/max in us (average %1 clients):" ).
+        arg ( static_cast<double> ( iClientsSum ) / iNumFrames, 0, 'f', 1 );
+
+    for ( int iS = 0; iS < NUM_SERVER_FRAME_STAGES; iS++ )
+    {
+        const EServerFrameStage eStage = static_cast<EServerFrameStage> ( iS );
+
+        strReport += QString ( " %1 %2/%3/%4%5" ).
+            arg ( strStageNames[iS] ).
+            arg ( GetPercentileUs ( eStage, 0.5 ), 0, 'f', 0 ).
+            arg ( GetPercentileUs ( eStage, 0.99 ), 0, 'f', 0 ).
+            arg ( static_cast<double> ( iMaxNs[iS] ) / 1000, 0, 'f', 0 ).
+            arg ( ( iS < NUM_SERVER_FRAME_STAGES - 1 ) ? "," : "" );
+    }
+
+    return strReport;
+}
+
+
+// CServerOverloadControl implementation ***************************************
+void CServerOverloadControl::Update ( const double dUsage )
+{
+    // count the actions which were applied in the current frame
+    if ( SkipLevels() )
+    {
+        iNumSkipLevelsFrames++;
+    }
+
+    if ( LowEncoderComplexity() )
+    {
+        iNumLowComplexityFrames++;
+    }
+
+    if ( SkipRecording() )
+    {
+        iNumSkipRecordingFrames++;
+    }
+
+    // get the level for the next frame: go up one level immediately if the
+    // deadline was exceeded and go down one level if the usage was low for the
+    // complete recovery time (hysteresis)
+    if ( dUsage > SERVER_OVERLOAD_USAGE_HIGH )
+    {
+        if ( eLevel < OL_SKIP_RECORDING )
+        {
+            eLevel = static_cast<EServerOverloadLevel> ( eLevel + 1 );
+        }
+
+        iNumLowUsageFrames = 0;
+    }
+    else if ( ( dUsage < SERVER_OVERLOAD_USAGE_LOW ) && ( eLevel > OL_NONE ) )
+    {
+        iNumLowUsageFrames++;
+
+        if ( iNumLowUsageFrames >= iRecoveryFrames )
+        {
+            eLevel             = static_cast<EServerOverloadLevel> ( eLevel - 1 );
+            iNumLowUsageFrames = 0;
+        }
+    }
+    else
+    {
+        iNumLowUsageFrames = 0;
+    }
+}
+
+
+// CServerAdmissionControl implementation **************************************
+void CServerAdmissionControl::Update ( const double dUsage,
+                                       const int    iNumClients )
+{
+    if ( !bEnabled || ( iNumClients == 0 ) )
+    {
+        return;
+    }
+
+    // the processing time which does not depend on the clients is included in
+    // the usage per client, i.e. the estimation is on the safe side
+    const double dCurUsagePerClient = dUsage / iNumClients;
+
+    if ( dUsagePerClient == 0 )
+    {
+        dUsagePerClient = dCurUsagePerClient;
+    }
+    else
+    {
+        dUsagePerClient += dAvFactor * ( dCurUsagePerClient - dUsagePerClient );
+    }
+
+    iUsagePerClientPpm.storeRelease ( static_cast<int> ( std::min ( dUsagePerClient, 1.0 ) * 1000000 ) );
+}
+
+EServerAdmission CServerAdmissionControl::GetAdmission ( const int iNumConnectedChannels ) const
+{
+    const double dCurUsagePerClient = static_cast<double> ( iUsagePerClientPpm.loadAcquire() ) / 1000000;
+
+    // without a measurement (e.g. the first client) the client is accepted
+    if ( !bEnabled || ( dCurUsagePerClient == 0 ) )
+    {
+        return SA_ACCEPT;
+    }
+
+    if ( dCurUsagePerClient * ( iNumConnectedChannels + 1 ) <= SERVER_ADMISSION_USAGE_MAX )
+    {
+        return SA_ACCEPT;
+    }
+
+    if ( dCurUsagePerClient * ( iNumConnectedChannels + SERVER_ADMISSION_LISTENER_COST ) <= SERVER_ADMISSION_USAGE_MAX )
+    {
+        return SA_LISTENER;
+    }
+
+    return SA_REJECT;
+}
+
+
+// CServer implementation ******************************************************
+CServer::CServer ( const int          iNewMaxNumChan,
+                   const int          iMaxDaysHistory,
+                   const QString&     strLoggingFileName,
+                   const quint16      iPortNumber,
+                   const QString&     strHTMLStatusFileName,
+                   const QString&     strHistoryFileName,
+                   const QString&     strServerNameForHTMLStatusFile,
+                   const QString&     strCentralServer,
+                   const QString&     strServerInfo,
+                   const QString&     strFederationPeers,
+                   const QString&     strNewWelcomeMessage,
+                   const QString&     strRecordingDirName,
+                   const bool         bNCentServPingServerInList,
+                   const bool         bNDisconnectAllClientsOnQuit,
+                   const bool         bNUseDoubleSystemFrameSize,
+                   const ELicenceType eNLicenceType,
+                   const int          iNNumThreads,
+                   const int          iNNumRecvThreads,
+                   const bool         bNEnableProfiling,
+                   const bool         bNRecordFlac,
+                   const bool         bNRecordMix,
+                   const QString&     strMetricsBindAddress,
+                   const QString&     strServerFx,
+                   const QString&     strCaptureFileName,
+                   const QString&     strReplayFileName,
+                   const bool         bNReplayFast,
+                   const int          iLogFlushIntervalMs,
+                   const int          iLogMaxFileSizeMB,
+                   const QString&     strCascadeAddress,
+                   const bool         bNConnectedSockets ) :
+    vecWindowPosMain            (), // empty array
+    bUseDoubleSystemFrameSize   ( bNUseDoubleSystemFrameSize ),
+    vecChannels                 ( new CChannel[iNewMaxNumChan] ),
+    iMaxNumChannels             ( iNewMaxNumChan ),
+    Socket                      ( this, iPortNumber, iNNumRecvThreads, bNConnectedSockets ),
+    Cascade                     ( &Socket ),
+    Logging                     ( iMaxDaysHistory ),
+    iFrameCount                 ( 0 ),
+    JamRecorder                 ( strRecordingDirName, bNRecordFlac ? recorder::RF_FLAC : recorder::RF_WAV ),
+    bEnableRecording            ( false ),
+    bRecordMix                  ( bNRecordMix ),
+    strRecordMixName            ( "Mix" ),
+    bFxEnabled                  ( false ),
+    bWriteStatusHTMLFile        ( false ),
+    MetricsExporter             ( this ),
+    bMetricsEnabled             ( false ),
+    iMetricsFrameCnt            ( 0 ),
+    iMetricsSnapshotIdx         ( 0 ),
+    HighPrecisionTimer          ( bNUseDoubleSystemFrameSize ),
+    bIsRunning                  ( false ),
+    pTimerServer                ( this ),
+    iNumThreads                 ( iNNumThreads ),
+    pWorkerPool                 ( &WorkerPool ),
+    FlightRecorder              ( QString ( "server%1" ).arg ( iPortNumber ), FLIGHT_REC_SERVER_NUM_RECORDS ),
+    ServerListManager           ( iPortNumber,
+                                  strCentralServer,
+                                  strServerInfo,
+                                  strFederationPeers,
+                                  iNewMaxNumChan,
+                                  bNCentServPingServerInList,
+                                  &ConnLessProtocol ),
+    ConnLessReqLimiter          ( CONNLESS_REQ_SOURCE_RATE, CONNLESS_REQ_SOURCE_BURST,
+                                  CONNLESS_REQ_GLOBAL_RATE, CONNLESS_REQ_GLOBAL_BURST ),
+    iConnLessNumClientsCache    ( 0 ),
+    iConnLessChanInfoTimeMs     ( -CONNLESS_RESPONSE_CACHE_TIME_MS ),
+    iConnLessNumClientsTimeMs   ( -CONNLESS_RESPONSE_CACHE_TIME_MS ),
+    bAutoRunMinimized           ( false ),
+    eLicenceType                ( eNLicenceType ),
+    bDisconnectAllClientsOnQuit ( bNDisconnectAllClientsOnQuit ),
+    pSignalHandler              ( CSignalHandler::getSingletonP() )
+{
+    int iOpusError;
+    int i;
+
+    // the per-channel objects are allocated for the number of channels of
+    // this server
+    OpusCodecs.reset       ( new CServerOpusCodecs[iMaxNumChannels] );
+    FrameSizeAdapter.reset ( new CServerFrameSizeAdapter[iMaxNumChannels] );
+    ChannelFx.reset        ( new CServerChannelFx[iMaxNumChannels] );
+    SharedStreams.reset    ( new CServerSharedStream[iMaxNumChannels] );
+
+    // the socket buffers must hold the packets of all channels
+    Socket.SetBufferSizes ( iMaxNumChannels );
+
+    // create the OPUS modes which are shared by all channels
+    OpusMode = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                         DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES,
+                                         &iOpusError );
+
+    Opus64Mode = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                           SYSTEM_FRAME_SIZE_SAMPLES,
+                                           &iOpusError );
+
+    for ( i = 0; i < iMaxNumChannels; i++ )
+    {
+        // init OPUS (the encoders/decoders are created on demand) -------------
+        OpusCodecs[i].Init ( OpusMode, Opus64Mode );
+    }
+
+    // define colors for chat window identifiers
+    vstrChatColors.Init ( 6 );
+    vstrChatColors[0] = "mediumblue";
+    vstrChatColors[1] = "red";
+    vstrChatColors[2] = "darkorchid";
+    vstrChatColors[3] = "green";
+    vstrChatColors[4] = "maroon";
+    vstrChatColors[5] = "coral";
+
+    // set the server frame size
+    if ( bUseDoubleSystemFrameSize )
+    {
+        iServerFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+    }
+    else
+    {
+        iServerFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
+    }
+
+    // the gain smoothing is calculated once per frame
+    fGainSmoothingCoeff = static_cast<float> ( exp ( -1000.0 * iServerFrameSizeSamples /
+                                                     ( SERVER_GAIN_SMOOTHING_TIME_MS * SYSTEM_SAMPLE_RATE_HZ ) ) );
+
+    // init the codec to server frame size adapters
+    for ( i = 0; i < iMaxNumChannels; i++ )
+    {
+        FrameSizeAdapter[i].Init ( iServerFrameSizeSamples );
+    }
+
+
+    // To avoid audio clitches, in the entire realtime timer audio processing
+    // routine including the ProcessData no memory must be allocated. Since we
+    // do not know the required sizes for the vectors, we allocate memory for
+    // the worst case here:
+
+    // allocate worst case memory for the temporary vectors
+    vecChanIDsCurConChan.Init          ( iMaxNumChannels );
+    ChannelAffinity.Init               ( iMaxNumChannels );
+    vecTickEvents.Init                 ( iMaxNumChannels );
+    iNumTickEvents = 0;
+    vecdFadeInGains.Init               ( iMaxNumChannels );
+    vecfLastFadeInGain.Init            ( iMaxNumChannels, 0.0f );
+
+    // the per client working sets of the frame are stored in frame arenas
+    // (one contiguous block per working set with one aligned row per client):
+    // the gains and stereo gains of all channels, the stereo audio buffers (which
+    // is the worst case), the planar float buffers for the mixing (left, right
+    // and mono down-mix) and the mix (note that we only allocate
+    // iMaxNumChannels rows for the send data because of the OMP implementation)
+    vecvecdGains.Init    ( iMaxNumChannels, iMaxNumChannels );
+    vecvecfGainsL.Init   ( iMaxNumChannels, iMaxNumChannels );
+    vecvecfGainsR.Init   ( iMaxNumChannels, iMaxNumChannels );
+    vecvecfGainsStart.Init  ( iMaxNumChannels, iMaxNumChannels );
+    vecvecfGainsLStart.Init ( iMaxNumChannels, iMaxNumChannels );
+    vecvecfGainsRStart.Init ( iMaxNumChannels, iMaxNumChannels );
+    vecvecfMixGroupGains.Init      ( iMaxNumChannels, MAX_NUM_MIX_GROUPS + 1 );
+    vecvecfMixGroupGainsStart.Init ( iMaxNumChannels, MAX_NUM_MIX_GROUPS + 1 );
+    vecvecfGainOffs.Init           ( iMaxNumChannels, iMaxNumChannels );
+    vecvecfGainOffsStart.Init      ( iMaxNumChannels, iMaxNumChannels );
+    vecvecActiveClientIdx.Init     ( iMaxNumChannels, 2 * iMaxNumChannels );
+    vecvecsData.Init     ( iMaxNumChannels, 2 /* stereo */ * MAX_CODEC_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
+    vecvecfData.Init     ( iMaxNumChannels, 3 * MAX_CODEC_FRAME_SIZE_SAMPLES );
+    vecvecfMixData.Init  ( iMaxNumChannels, 2 /* stereo */ * iServerFrameSizeSamples );
+    vecvecsSendData.Init ( iMaxNumChannels, 2 /* stereo */ * MAX_CODEC_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
+
+    vecvecbyCodedData.Init             ( iMaxNumChannels );
+    vecvecbyRedCodedData.Init          ( iMaxNumChannels );
+    vecNumAudioChannels.Init           ( iMaxNumChannels );
+    vecAudioComprType.Init             ( iMaxNumChannels );
+    vecDecodeRequired.Init             ( iMaxNumChannels );
+    vecNumCodedBytesIn.Init            ( iMaxNumChannels );
+    vecCodedDataInOK.Init              ( iMaxNumChannels * MAX_NUM_FRAME_SIZE_CONV_BLOCKS );
+    vecCodedDataInLen.Init             ( iMaxNumChannels * MAX_NUM_FRAME_SIZE_CONV_BLOCKS );
+    vecvecbyCodedDataIn.Init           ( iMaxNumChannels * MAX_NUM_FRAME_SIZE_CONV_BLOCKS );
+    vecIsListener.Init                 ( iMaxNumChannels, 0 );
+    vecIsSilent.Init                   ( iMaxNumChannels, 0 );
+    vecSilenceCnt.Init                 ( iMaxNumChannels, 0 );
+    vecIsAudible.Init                  ( iMaxNumChannels, 1 );
+    vecDecodeSkipped.Init              ( iMaxNumChannels, 0 );
+    vecSilentMix.Init                  ( iMaxNumChannels );
+    vecSharedStreamIdx.Init            ( iMaxNumChannels, INVALID_INDEX );
+    vecMixHoldCnt.Init                 ( iMaxNumChannels, 0 );
+    vecMixSignature.Init               ( iMaxNumChannels, 0 );
+    vecActiveStreams.Init              ( iMaxNumChannels );
+    vecvecMultitrackIdx.Init           ( iMaxNumChannels );
+    vecNumMultitrackIdx.Init           ( iMaxNumChannels, 0 );
+    vecMultitrackFrames.Init           ( iMaxNumChannels );
+
+    for ( i = 0; i < iMaxNumChannels; i++ )
+    {
+        vecvecMultitrackIdx[i].Init ( MULTITRACK_MAX_NUM_TRACKS );
+        vecMultitrackFrames[i].Init();
+
+        // allocate worst case memory for the coded data (it is indexed by the
+        // channel ID since the last coded frame is sent again for a silent mix)
+        vecvecbyCodedData[i].Init    ( MAX_SIZE_BYTES_NETW_BUF );
+        vecvecbyRedCodedData[i].Init ( MAX_SIZE_BYTES_NETW_BUF );
+    }
+
+    // the received coded data is stored per frame size conversion block since
+    // the decoding is done after the coded data of all channels was taken
+    for ( i = 0; i < iMaxNumChannels * MAX_NUM_FRAME_SIZE_CONV_BLOCKS; i++ )
+    {
+        vecvecbyCodedDataIn[i].Init ( MAX_SIZE_BYTES_NETW_BUF );
+    }
+
+    // the cached gain/pan matrix is indexed by the channel IDs (the initial
+    // values are taken from the channels on the first timer call)
+    vecvecdGainMatrix.Init  ( iMaxNumChannels );
+    vecvecdPanMatrix.Init   ( iMaxNumChannels );
+    vecvecfGainLMatrix.Init ( iMaxNumChannels );
+    vecvecfGainRMatrix.Init ( iMaxNumChannels );
+    vecvecfMixGainMatrix.Init  ( iMaxNumChannels );
+    vecvecfMixGainLMatrix.Init ( iMaxNumChannels );
+    vecvecfMixGainRMatrix.Init ( iMaxNumChannels );
+    vecvecdMixGroupGainMatrix.Init ( iMaxNumChannels );
+    vecvecfMixGroupGainMatrix.Init ( iMaxNumChannels );
+    vecMixGainsValid.Init      ( iMaxNumChannels, 0 );
+
+    for ( i = 0; i < iMaxNumChannels; i++ )
+    {
+        vecvecdGainMatrix[i].Init     ( iMaxNumChannels, 1.0 );
+        vecvecdPanMatrix[i].Init      ( iMaxNumChannels, 0.5 );
+        vecvecfGainLMatrix[i].Init    ( iMaxNumChannels, 1.0f );
+        vecvecfGainRMatrix[i].Init    ( iMaxNumChannels, 1.0f );
+        vecvecfMixGainMatrix[i].Init  ( iMaxNumChannels, 1.0f );
+        vecvecfMixGainLMatrix[i].Init ( iMaxNumChannels, 1.0f );
+        vecvecfMixGainRMatrix[i].Init ( iMaxNumChannels, 1.0f );
+        vecvecdMixGroupGainMatrix[i].Init ( MAX_NUM_MIX_GROUPS + 1, 1.0 );
+        vecvecfMixGroupGainMatrix[i].Init ( MAX_NUM_MIX_GROUPS + 1, 1.0f );
+    }
+
+    // common mix of all clients and the mix group buses (left, right and mono
+    // down-mix, the bus of NO_MIX_GROUP is not used)
+    vecfCommonMixData.Init ( 3 * iServerFrameSizeSamples );
+    vecvecfMixGroupData.Init ( MAX_NUM_MIX_GROUPS + 1, 3 * iServerFrameSizeSamples );
+    vecMixGroupUsed.Init ( MAX_NUM_MIX_GROUPS + 1, 0 );
+    vecMixGroup.Init ( iMaxNumChannels, NO_MIX_GROUP );
+
+    // shared streams of identical mixes (in the worst case each client has
+    // its own stream)
+    iNumMixClients     = 0;
+    iNumMonoMixClients = 0;
+    iNumActiveStreams  = 0;
+    vecMixClientIdx.Init ( iMaxNumChannels );
+
+    for ( i = 0; i < iMaxNumChannels; i++ )
+    {
+        SharedStreams[i].Init ( OpusMode, Opus64Mode, iServerFrameSizeSamples );
+    }
+
+    // the multicast of the shared streams is disabled until a group is set
+    bMulticastEnabled = false;
+    vecMulticastGroupAddr.Init ( MAX_NUM_MULTICAST_STREAMS );
+    vecMulticastOffer.Init     ( iMaxNumChannels, NO_MULTICAST_STREAM );
+    vecMulticastActive.Init    ( iMaxNumChannels, 0 );
+
+    // insert chain of the channels and reverb bus (throws an error if the
+    // settings are invalid)
+    if ( !FxSettings.Parse ( strServerFx ) )
+    {
+        throw CGenErr ( "Invalid server effects settings: " + strServerFx );
+    }
+
+    bFxEnabled = FxSettings.IsEnabled();
+
+    for ( i = 0; i < iMaxNumChannels; i++ )
+    {
+        ChannelFx[i].Init ( FxSettings, iServerFrameSizeSamples );
+    }
+
+    ReverbBus.Init ( iServerFrameSizeSamples );
+
+    // peak values for the channel levels and the silence detection
+    vecfChannelPeaks.Init ( iMaxNumChannels );
+    iSilenceHoldNumFrames = SERVER_SILENCE_HOLD_TIME_MS * SYSTEM_SAMPLE_RATE_HZ / 1000 / iServerFrameSizeSamples;
+
+    // stereo common mix for the recording
+    vecsRecordMixData.Init ( 2 * iServerFrameSizeSamples );
+
+    // allocate worst case memory for the channel levels
+    vecChannelLevels.Init ( iMaxNumChannels );
+
+    // connected clients list changes
+    iChanListVersion = 0;
+    vecLastChanListInfo.Init ( iMaxNumChannels );
+    vecbyLastChanListPresent.Init ( iMaxNumChannels, 0 );
+    vecbyChanListSynced.Init ( iMaxNumChannels, 0 );
+
+    // the streams of a multi-stream packet are split in the socket thread
+    vecbySubStreamPacket.Init ( MAX_SIZE_BYTES_NETW_BUF );
+
+    // start the worker threads for the multithreaded audio processing (if
+    // requested) and init the timing statistics
+    if ( iNumThreads > 0 )
+    {
+        WorkerPool.Start ( iNumThreads );
+    }
+
+    TimingStats.Init ( iServerFrameSizeSamples );
+    OverloadControl.Init ( iServerFrameSizeSamples );
+    AdmissionControl.Init ( iServerFrameSizeSamples );
+    EncoderCpuLoad.Init ( iServerFrameSizeSamples );
+    FrameProfiler.SetEnabled ( bNEnableProfiling );
+    TickClock.start();
+    dFrameProcTimeAvUs = 0;
+
+    // round trip time measurement to the connected clients
+    RttClock.start();
+    TimerRttProbe.start ( SERVER_RTT_PROBE_INTERVAL_MS );
+
+    ConnLessClock.start();
+
+    // select the mixing kernel implementation supported by the CPU
+    CMixKernel::Init();
+
+    // enable history graph (if requested)
+    if ( !strHistoryFileName.isEmpty() )
+    {
+        Logging.EnableHistory ( strHistoryFileName );
+    }
+
+    // enable logging (if requested)
+    if ( !strLoggingFileName.isEmpty() )
+    {
+        // in case the history is enabled and a logging file name is
+        // given, parse the logging file for old entries which are then
+        // added in the history on software startup
+        if ( !strHistoryFileName.isEmpty() )
+        {
+            Logging.ParseLogFile ( strLoggingFileName );
+        }
+
+        Logging.Start ( strLoggingFileName, iLogFlushIntervalMs, iLogMaxFileSizeMB );
+    }
+
+    // HTML status file writing
+    if ( !strHTMLStatusFileName.isEmpty() )
+    {
+        QString strCurServerNameForHTMLStatusFile = strServerNameForHTMLStatusFile;
+
+        // if server name is empty, substitude a default name
+        if ( strCurServerNameForHTMLStatusFile.isEmpty() )
+        {
+            strCurServerNameForHTMLStatusFile = "[server address]";
+        }
+
+        // (the static cast to integer of the port number is required so that it
+        // works correctly under Linux)
+        StartStatusHTMLFileWriting ( strHTMLStatusFileName,
+            strCurServerNameForHTMLStatusFile + ":" +
+            QString().number( static_cast<int> ( iPortNumber ) ) );
+    }
+
+    // metrics exporter (throws an error if the port cannot be used)
+    if ( !strMetricsBindAddress.isEmpty() )
+    {
+        MetricsExporter.Start ( strMetricsBindAddress );
+        bMetricsEnabled = true;
+    }
+
+    // link to the parent server (throws an error if the address is invalid)
+    if ( !strCascadeAddress.isEmpty() )
+    {
+        Cascade.Start ( strCascadeAddress,
+                        GetServerName(),
+                        iServerFrameSizeSamples,
+                        OpusMode,
+                        Opus64Mode );
+    }
+
+    // the relays are allowed later, the routes are always used by the socket
+    Socket.SetRelayRoutes ( &RelayRoutes );
+
+    // packet capture and replay (throw an error if the file cannot be used)
+    if ( !strCaptureFileName.isEmpty() )
+    {
+        PacketCapture.Start ( strCaptureFileName );
+        Socket.SetPacketCapture ( &PacketCapture );
+    }
+
+    if ( !strReplayFileName.isEmpty() )
+    {
+        PacketReplay.Init ( strReplayFileName, bNReplayFast, &Socket );
+        Socket.SetReplayMode();
+    }
+
+    // manage welcome message: if the welcome message is a valid link to a local
+    // file, the content of that file is used as the welcome message (#361)
+    strWelcomeMessage = strNewWelcomeMessage; // first copy text, may be overwritten
+    if ( QFileInfo ( strNewWelcomeMessage ).exists() )
+    {
+        QFile file ( strNewWelcomeMessage );
+
+        if ( file.open ( QIODevice::ReadOnly | QIODevice::Text ) )
+        {
+            // use entrie file content for the welcome message
+            strWelcomeMessage = file.readAll();
+        }
+    }
+
+    // restrict welcome message to maximum allowed length
+    strWelcomeMessage = strWelcomeMessage.left ( MAX_LEN_CHAT_TEXT );
+
+    // enable jam recording (if requested) - kicks off the thread
+    if ( !strRecordingDirName.isEmpty() )
+    {
+        bRecorderInitialised = JamRecorder.Init ( this, iServerFrameSizeSamples, iMaxNumChannels );
+        SetEnableRecording ( bRecorderInitialised );
+    }
+
+    // enable all channels (for the server all channel must be enabled the
+    // entire life time of the software)
+    for ( i = 0; i < iMaxNumChannels; i++ )
+    {
+        vecChannels[i].SetEnable ( true );
+    }
+
+
+    // Connections -------------------------------------------------------------
+    // connect timer timeout signal
+    QObject::connect ( &HighPrecisionTimer, &CHighPrecisionTimer::timeout,
+        this, &CServer::OnTimerTick );
+
+    // the timer waits in the idle mode for the first client
+    HighPrecisionTimer.StartIdle();
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLMessReadyForSending,
+        this, &CServer::OnSendCLProtMessage );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLPingReceived,
+        this, &CServer::OnCLPingReceived );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLPingWithNumClientsReceived,
+        this, &CServer::OnCLPingWithNumClientsReceived );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLRegisterServerReceived,
+        this, &CServer::OnCLRegisterServerReceived );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLUnregisterServerReceived,
+        this, &CServer::OnCLUnregisterServerReceived );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLServerFeaturesReceived,
+        this, &CServer::OnCLServerFeaturesReceived );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLServerLoadReceived,
+        this, &CServer::OnCLServerLoadReceived );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqServerList,
+        this, &CServer::OnCLReqServerList );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqServerListPage,
+        this, &CServer::OnCLReqServerListPage );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqServerListIPv6,
+        this, &CServer::OnCLReqServerListIPv6 );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLRttProbeEchoReceived,
+        this, &CServer::OnCLRttProbeEchoReceived );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqLatencyProbe,
+        this, &CServer::OnCLReqLatencyProbe );
+
+    QObject::connect ( &TimerRttProbe, &QTimer::timeout,
+        this, &CServer::OnTimerRttProbe );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLFederationUpdateReceived,
+        this, &CServer::OnCLFederationUpdateReceived );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqFederationSync,
+        this, &CServer::OnCLReqFederationSync );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLRegisterServerResp,
+        this, &CServer::OnCLRegisterServerResp );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLRegisterServerRetryReceived,
+        this, &CServer::OnCLRegisterServerRetryReceived );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLSendEmptyMes,
+        this, &CServer::OnCLSendEmptyMes );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLDisconnection,
+        this, &CServer::OnCLDisconnection );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqVersionAndOS,
+        this, &CServer::OnCLReqVersionAndOS );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqConnClientsList,
+        this, &CServer::OnCLReqConnClientsList );
+
+    QObject::connect ( &ServerListManager, &CServerListManager::SvrRegStatusChanged,
+        this, &CServer::SvrRegStatusChanged );
+
+    QObject::connect ( &ServerListManager, &CServerListManager::ServerLoadRequested,
+        this, &CServer::OnServerLoadRequested );
+
+    QObject::connect( &JamRecorder, &recorder::CJamRecorder::RecordingSessionStarted,
+        this, &CServer::RecordingSessionStarted );
+
+    QObject::connect( &JamRecorder, &recorder::CJamRecorder::RecordingFailed,
+        this, &CServer::OnRecordingFailed );
+
+    QObject::connect ( QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+        this, &CServer::OnAboutToQuit );
+
+    QObject::connect ( pSignalHandler, &CSignalHandler::HandledSignal,
+        this, &CServer::OnHandledSignal );
+
+    QObject::connect ( &PacketReplay, &CPacketReplay::Finished,
+        this, &CServer::OnReplayFinished );
+
+    ChanEventQueue.SetReceiver ( this );
+
+    for ( i = 0; i < iMaxNumChannels; i++ )
+    {
+        ConnectChannelSignals ( i );
+    }
+
+    // start the socket (it is important to start the socket after all
+    // initializations and connections), on a replay the replay thread
+    // delivers the packets instead of the socket threads
+    if ( PacketReplay.IsEnabled() )
+    {
+        PacketReplay.start ( QThread::TimeCriticalPriority );
+    }
+    else
+    {
+        Socket.Start();
+    }
+}
+
+void CServer::ConnectChannelSignals ( const int iChanID )
+{
+    // the channel ID is bound into the handlers of the channel signals, the
+    // events without arguments are posted in the event queue (see
+    // OnChannelEvents())
+    CChannel* pChannel = &vecChannels[iChanID];
+
+    pChannel->SetEventQueue ( &ChanEventQueue, iChanID );
+    pChannel->SetFlightRecorder ( &FlightRecorder, iChanID );
+
+    // send message
+    QObject::connect ( pChannel, &CChannel::MessReadyForSending,
+        this, [this, iChanID] ( CProtMessage Message ) { SendProtMessage ( iChanID, Message ); } );
+
+    // chat text received
+    QObject::connect ( pChannel, &CChannel::ChatTextReceived,
+        this, [this, iChanID] ( QString strChatText ) { CreateAndSendChatTextForAllConChannels ( iChanID, strChatText ); } );
+
+    // other mute state has changed
+    QObject::connect ( pChannel, &CChannel::MuteStateHasChanged,
+        this, [this, iChanID] ( int iOtherChanID, bool bIsMuted ) { CreateOtherMuteStateChanged ( iChanID, iOtherChanID, bIsMuted ); } );
+}
+
+void CServer::OnChannelEvents()
+{
+    int  iChanID;
+    int  iEvents;
+    bool bMixGroupsChanged = false;
+
+    ChanEventQueue.BeginDrain();
+
+    while ( ChanEventQueue.GetNext ( iChanID, iEvents ) )
+    {
+        for ( int iEvent = 0; iEvent < NUM_CHAN_EVENTS; iEvent++ )
+        {
+            if ( ( iEvents & ( 1 << iEvent ) ) == 0 )
+            {
+                continue;
+            }
+
+            switch ( static_cast<EChanEvent> ( iEvent ) )
+            {
+            case CE_REQ_CONN_CLIENTS_LIST:
+                CreateAndSendChanListForThisChan ( iChanID );
+                break;
+
+            case CE_CHAN_INFO_CHANGED:
+                RequestChanListForAllConChannels();
+                break;
+
+            case CE_AUTO_SOCK_BUF_SIZE:
+                // only the last size is of interest (the auto size may exceed the
+                // range of the protocol message)
+                CreateAndSendJitBufMessage ( iChanID, std::min ( ChanEventQueue.GetValue ( iChanID, CE_AUTO_SOCK_BUF_SIZE ),
+                                                                 MAX_NET_BUF_SIZE_NUM_BL ) );
+                break;
+
+            case CE_SOCK_BUF_CAPACITY:
+                vecChannels[iChanID].UpdateSockBufCapacity();
+                break;
+
+            case CE_SESSION_SETUP_MISSING:
+                OnSessionSetupMissing ( iChanID );
+                break;
+
+            case CE_MIX_GROUP_CHANGED:
+                // the list is sent once for all changes of this drain
+                bMixGroupsChanged = true;
+                break;
+
+            case CE_MULTICAST_OFFER:
+            {
+                // only the last offer is of interest (the group address of
+                // NO_MULTICAST_STREAM is not used by the client)
+                const int iStream = ChanEventQueue.GetValue ( iChanID, CE_MULTICAST_OFFER );
+
+                vecChannels[iChanID].CreateMulticastGroupMes ( iStream,
+                    iStream == NO_MULTICAST_STREAM ? vecMulticastGroupAddr[0] : vecMulticastGroupAddr[iStream] );
+                break;
+            }
+
+            default:
+                break;
+            }
+        }
+    }
+
+    if ( bMixGroupsChanged )
+    {
+        CreateAndSendMixGroupListForAllConChannels();
+    }
+}
+
+void CServer::CreateAndSendJitBufMessage ( const int iCurChanID,
+                                           const int iNNumFra )
+{
+    vecChannels[iCurChanID].CreateJitBufMes ( iNNumFra );
+}
+
+void CServer::SendProtMessage ( int iChID, CProtMessage Message )
+{
+    // the protocol queries me to call the function to send the message
+    // send it through the network (the channel has the converted socket
+    // address of the client)
+    if ( Message.Size() > 0 )
+    {
+        Socket.SendProtPacket ( Message.Data().data(), Message.Size(), vecChannels[iChID].GetSockAddr() );
+    }
+}
+
+void CServer::OnNewConnection ( int          iChID,
+                                CHostAddress RecHostAddr )
+{
+    // a current client sends the properties of the connection in its session
+    // setup right after its first audio packet, our messages are held back
+    // until it arrives so that they can be sent together in one container
+    vecChannels[iChID].WaitForSessionSetup();
+
+    // inform the client about its own ID at the server (note that this
+    // must be the first message to be sent for a new connection)
+    vecChannels[iChID].CreateClientIDMes ( iChID );
+
+    // send welcome message (if enabled)
+    if ( !strWelcomeMessage.isEmpty() )
+    {
+        // create formated server welcome message and send it just to
+        // the client which just connected to the server
+        const QString strWelcomeMessageFormated =
+            "<b>Server Welcome Message:</b> " + strWelcomeMessage;
+
+        vecChannels[iChID].CreateChatTextMes ( strWelcomeMessageFormated );
+    }
+
+    // inform the client if it was only accepted as a listener
+    if ( vecChannels[iChID].IsForcedListener() )
+    {
+        vecChannels[iChID].CreateChatTextMes (
+            "<b>Server:</b> The server is close to its processing limit, you are "
+            "connected as a listener (your audio is not mixed)." );
+    }
+
+    // send licence request message (if enabled)
+    if ( eLicenceType != LT_NO_LICENCE )
+    {
+        vecChannels[iChID].CreateLicReqMes ( eLicenceType );
+    }
+
+    // send version info (for, e.g., feature activation in the client)
+    vecChannels[iChID].CreateVersionAndOSMes();
+
+    // send recording state message on connection
+    vecChannels[iChID].CreateRecorderStateMes ( GetRecorderState() );
+
+    // send the mix groups (only if a channel is in a mix group)
+    CVector<int> vecMixGroups;
+
+    if ( CreateMixGroupList ( vecMixGroups ) )
+    {
+        CProtBroadcastMes MixGroupListMes;
+
+        CProtocol::PrepareMixGroupListMes ( vecMixGroups, MixGroupListMes );
+        vecChannels[iChID].SendBroadcastMes ( MixGroupListMes );
+    }
+
+    // reset the frame size adapter and the insert chain
+    FrameSizeAdapter[iChID].Reset();
+    ChannelFx[iChID].Reset();
+
+    // logging of new connected channel
+    Logging.AddNewConnection ( RecHostAddr.GetInetAddr() );
+}
+
+void CServer::OnSessionSetupMissing ( const int iChID )
+{
+    // on a new connection we query the network transport properties for the
+    // audio packets (to use the correct network block size and audio
+    // compression properties, etc.)
+    vecChannels[iChID].CreateReqNetwTranspPropsMes();
+
+    // this is a new connection, query the jitter buffer size we shall use
+    // for this client (note that at the same time on a new connection the
+    // client sends the jitter buffer size by default but maybe we have
+    // reached a state where this did not happen because of network trouble,
+    // client or server thinks that the connection was still active, etc.)
+    vecChannels[iChID].CreateReqJitBufMes();
+
+    // A new client connected to the server, the channel list
+    // at all clients have to be updated. This is done by sending
+    // a channel name request to the client which causes a channel
+    // name message to be transmitted to the server. If the server
+    // receives this message, the channel list will be automatically
+    // updated (implicitely).
+    //
+    // Usually it is not required to send the channel list to the
+    // client currently connecting since it automatically requests
+    // the channel list on a new connection (as a result, he will
+    // usually get the list twice which has no impact on functionality
+    // but will only increase the network load a tiny little bit). But
+    // in case the client thinks he is still connected but the server
+    // was restartet, it is important that we send the channel list
+    // at this place.
+    vecChannels[iChID].CreateReqChanInfoMes();
+}
+
+void CServer::OnServerFull ( CHostAddress RecHostAddr )
+{
+    // inform the calling client that no channel is free
+    ConnLessProtocol.CreateCLServerFullMes ( RecHostAddr );
+}
+
+void CServer::OnSendCLProtMessage ( CHostAddress InetAddr,
+                                    CProtMessage Message )
+{
+    // the protocol queries me to call the function to send the message
+    // send it through the network
+    Socket.SendProtPacket ( Message, InetAddr );
+}
+
+void CServer::OnProtcolCLMessageReceived ( int          iRecID,
+                                           CProtMessage MesBody,
+                                           CHostAddress RecHostAddr )
+{
+    // the requests which are answered by the server are rate limited since
+    // the sender address of a connection less message cannot be verified
+    // (the other connection less messages are always processed)
+    if ( IsRateLimitedConnLessMes ( iRecID ) &&
+         !ConnLessReqLimiter.Allow ( RecHostAddr, ConnLessClock.elapsed() ) )
+    {
+        return;
+    }
+
+    ConnLessProtocol.ParseConnectionLessMessageBody ( MesBody,
+                                                      iRecID,
+                                                      RecHostAddr );
+}
+
+bool CServer::IsRateLimitedConnLessMes ( const int iRecID ) const
+{
+    switch ( iRecID )
+    {
+    case PROTMESSID_CLM_PING_MS:
+    case PROTMESSID_CLM_PING_MS_WITHNUMCLIENTS:
+    case PROTMESSID_CLM_REQ_SERVER_LIST:
+    case PROTMESSID_CLM_REQ_SERVER_LIST_PAGE:
+    case PROTMESSID_CLM_REQ_SERVER_LIST_IPV6:
+    case PROTMESSID_CLM_REQ_VERSION_AND_OS:
+    case PROTMESSID_CLM_REQ_CONN_CLIENTS_LIST:
+    case PROTMESSID_CLM_REQ_FEDERATION_SYNC:
+    case PROTMESSID_CLM_REQ_LATENCY_PROBE:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+const CVector<CChannelInfo>& CServer::GetConnLessChanInfo()
+{
+    const qint64 iCurTimeMs = ConnLessClock.elapsed();
+
+    if ( iCurTimeMs - iConnLessChanInfoTimeMs >= CONNLESS_RESPONSE_CACHE_TIME_MS )
+    {
+        vecConnLessChanInfoCache = CreateChannelList();
+        iConnLessChanInfoTimeMs  = iCurTimeMs;
+    }
+
+    return vecConnLessChanInfoCache;
+}
+
+int CServer::GetConnLessNumClients()
+{
+    const qint64 iCurTimeMs = ConnLessClock.elapsed();
+
+    if ( iCurTimeMs - iConnLessNumClientsTimeMs >= CONNLESS_RESPONSE_CACHE_TIME_MS )
+    {
+        iConnLessNumClientsCache  = GetNumberOfConnectedClients();
+        iConnLessNumClientsTimeMs = iCurTimeMs;
+    }
+
+    return iConnLessNumClientsCache;
+}
+
+void CServer::OnCLDisconnection ( CHostAddress InetAddr )
+{
+    // check if the given address is actually a client which is connected to
+    // this server, if yes, disconnect it (the address index is protected by
+    // the channel table mutex)
+    MutexChanTable.lock();
+    {
+        const int iCurChanID = FindChannel ( InetAddr );
+
+        if ( iCurChanID != INVALID_CHANNEL_ID )
+        {
+            vecChannels[iCurChanID].Disconnect();
+        }
+    }
+    MutexChanTable.unlock();
+}
+
+void CServer::OnServerLoadRequested()
+{
+    // the load is the measured average processing time of a frame relative to
+    // the frame period
+    const double dFramePeriodUs = 1000000.0 * iServerFrameSizeSamples / SYSTEM_SAMPLE_RATE_HZ;
+
+    ServerListManager.SlaveServerSendLoad (
+        GetNumberOfConnectedClients(),
+        static_cast<int> ( 100 * iFrameProcTimeAvUs.loadAcquire() / dFramePeriodUs ) );
+}
+
+void CServer::OnTimerRttProbe()
+{
+    // send the time stamp to all connected clients, the clients send it back
+    // (old clients do not know the message and do not answer)
+    const int iCurTimeMs = static_cast<int> ( RttClock.elapsed() );
+
+    for ( int i = 0; i < iMaxNumChannels; i++ )
+    {
+        if ( vecChannels[i].IsConnected() && !vecChannels[i].IsSubStreamChannel() )
+        {
+            ConnLessProtocol.CreateCLRttProbeMes ( vecChannels[i].GetAddress(), iCurTimeMs );
+        }
+    }
+
+    // the HTML status file shows the round trip times
+    if ( bWriteStatusHTMLFile )
+    {
+        WriteStatusFile();
+    }
+}
+
+void CServer::OnCLRttProbeEchoReceived ( CHostAddress InetAddr,
+                                         int          iMs )
+{
+    const int iRttMs = static_cast<int> ( RttClock.elapsed() ) - iMs;
+
+    // ignore invalid time stamps (only the last probes can be answered)
+    if ( ( iRttMs < 0 ) || ( iRttMs > 10 * SERVER_RTT_PROBE_INTERVAL_MS ) )
+    {
+        return;
+    }
+
+    // the address index is protected by the channel table mutex
+    MutexChanTable.lock();
+    {
+        const int iCurChanID = FindChannel ( InetAddr );
+
+        if ( iCurChanID != INVALID_CHANNEL_ID )
+        {
+            vecChannels[iCurChanID].UpdateRtt ( iRttMs );
+        }
+    }
+    MutexChanTable.unlock();
+}
+
+void CServer::OnCLReqLatencyProbe ( CHostAddress InetAddr,
+                                    int          iMs )
+{
+    CServerLatencyInfo LatencyInfo;
+    bool               bIsConnected = false;
+
+    LatencyInfo.iTransmitTimeMs = iMs;
+
+    MutexChanTable.lock();
+    {
+        const int iCurChanID = FindChannel ( InetAddr );
+
+        if ( iCurChanID != INVALID_CHANNEL_ID )
+        {
+            // a frame arrives at a random time of the frame period, i.e. on
+            // average it waits half a period for the next timer tick
+            LatencyInfo.iQueueDelayUs = vecChannels[iCurChanID].GetJitBufDelayUs() +
+                iServerFrameSizeSamples * 500000 / SYSTEM_SAMPLE_RATE_HZ;
+
+            bIsConnected = true;
+        }
+    }
+    MutexChanTable.unlock();
+
+    // only connected clients get the timing of their audio
+    if ( bIsConnected )
+    {
+        LatencyInfo.iMixTimeUs = iFrameProcTimeAvUs.loadAcquire();
+
+        ConnLessProtocol.CreateCLLatencyProbeMes ( InetAddr, LatencyInfo );
+    }
+}
+
+void CServer::OnReplayFinished()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+    qInfo() << qUtf8Printable ( PacketReplay.GetReport() );
+
+    if ( FrameProfiler.IsEnabled() )
+    {
+        qInfo() << qUtf8Printable ( FrameProfiler.GetReport() );
+    }
+#endif
+
+    // the replay is a measurement run, i.e. the server quits after it
+    QCoreApplication::quit();
+}
+
+void CServer::OnAboutToQuit()
+{
+    // if enabled, disconnect all clients on quit
+    if ( bDisconnectAllClientsOnQuit )
+    {
+        Mutex.lock();
+        {
+            for ( int i = 0; i < iMaxNumChannels; i++ )
+            {
+                if ( vecChannels[i].IsConnected() && !vecChannels[i].IsSubStreamChannel() )
+                {
+                    ConnLessProtocol.CreateCLDisconnection ( vecChannels[i].GetAddress() );
+                }
+            }
+        }
+        Mutex.unlock(); // release mutex
+    }
+
+    // leave the parent server immediately instead of waiting for the time-out
+    if ( Cascade.IsEnabled() )
+    {
+        ConnLessProtocol.CreateCLDisconnection ( Cascade.GetParentAddress() );
+    }
+
+    Stop();
+
+    // if server was registered at the central server, unregister on shutdown
+    if ( GetServerListEnabled() )
+    {
+        UnregisterSlaveServer();
+    }
+}
+
+void CServer::OnHandledSignal ( int sigNum )
+{
+    // show the signal number on the command line (note that this does not work for the Windows command line)
+// TODO we should use the ConsoleWriterFactory() instead of qDebug()
+    qDebug() << "OnHandledSignal: " << sigNum;
+
+#ifdef _WIN32
+    // Windows does not actually get OnHandledSignal triggered
+    QCoreApplication::instance()->exit();
+    Q_UNUSED ( sigNum )
+#else
+    switch ( sigNum )
+    {
+
+    case SIGUSR1:
+        RequestNewRecording();
+        break;
+
+    case SIGUSR2:
+        SetEnableRecording ( !bEnableRecording );
+        break;
+
+    case SIGQUIT:
+        // like the thread dump of other runtimes, the quit signal writes the
+        // flight recorder
+        FlightRecorder.Dump ( "requested" );
+        break;
+
+    case SIGHUP:
+        // with a trace file the hangup signal starts/stops the tracing,
+        // otherwise it quits as before
+        if ( CTracer::IsInitialized() )
+        {
+            CTracer::Toggle();
+        }
+        else
+        {
+            QCoreApplication::instance()->exit();
+        }
+        break;
+
+    case SIGINT:
+    case SIGTERM:
+        // This should trigger OnAboutToQuit
+        QCoreApplication::instance()->exit();
+        break;
 
     default:
         break;
     }
-#endif
-}
+#endif
+}
+
+void CServer::OnRecordingFailed ( QString strReason )
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+// TODO we should use the ConsoleWriterFactory() instead of qInfo()
+    qInfo() << qUtf8Printable ( QString ( "Recording stopped: %1" ).arg ( strReason ) );
+#endif
+
+    // the recorder has stopped, the recording is disabled so that the clients
+    // are informed that they are not recorded anymore
+    SetEnableRecording ( false );
+}
+
+void CServer::RequestNewRecording()
+{
+    if ( bRecorderInitialised && bEnableRecording )
+    {
+        emit RestartRecorder();
+    }
+
+    // send recording state message - doesn't hurt
+    CreateAndSendRecorderStateForAllConChannels();
+}
+
+bool CServer::SetEnablePacing()
+{
+    // the departure times are set by the transport, i.e. the timer thread is
+    // not delayed by the pacing
+    const qint64 iFrameIntervalNs =
+        static_cast<qint64> ( iServerFrameSizeSamples ) * 1000000000 / SYSTEM_SAMPLE_RATE_HZ;
+
+    return Socket.EnablePacing ( static_cast<int> ( iFrameIntervalNs * SERVER_PACING_WINDOW_PERCENT / 100 ) );
+}
+
+void CServer::StartStreamOutput ( const QString& strBindAddress,
+                                  const int      iBitRateKbps )
+{
+    StreamOutput.Start ( strBindAddress, iServerFrameSizeSamples, iBitRateKbps );
+}
+
+bool CServer::SetMulticastGroup ( const QString& strGroupAddr )
+{
+    QHostAddress InetAddr;
+
+    if ( !InetAddr.setAddress ( strGroupAddr.trimmed() ) )
+    {
+        return false;
+    }
+
+    // stream n uses the group address + n (added to the last bytes of the
+    // address), all streams must be in the multicast range
+    const CHostAddress BaseAddr ( InetAddr, 0 );
+
+    for ( int iStream = 0; iStream < MAX_NUM_MULTICAST_STREAMS; iStream++ )
+    {
+        CHostAddress GroupAddr = BaseAddr;
+        int          iCarry    = iStream;
+
+        for ( int i = 15; ( i >= 0 ) && ( iCarry > 0 ); i-- )
+        {
+            iCarry           += GroupAddr.Addr[i];
+            GroupAddr.Addr[i] = static_cast<quint8> ( iCarry & 0xFF );
+            iCarry          >>= 8;
+        }
+
+        if ( !GroupAddr.IsMulticast() || ( GroupAddr.IsIPv4() != BaseAddr.IsIPv4() ) ||
+             ( !GroupAddr.IsIPv4() && !CSocket::IsDualStack() ) )
+        {
+            return false;
+        }
+
+        vecMulticastGroupAddr[iStream] = GroupAddr;
+    }
+
+    bMulticastEnabled = true;
+    return true;
+}
+
+void CServer::SetEnableRecording ( bool bNewEnableRecording )
+{
+    if ( bRecorderInitialised )
+    {
+        // note that this block executes regardless of whether
+        // what appears to be a change is being applied, to ensure
+        // the requested state is the result
+        bEnableRecording = bNewEnableRecording;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+// TODO we should use the ConsoleWriterFactory() instead of qInfo()
+        qInfo() << "Recording state" << ( bEnableRecording ? "enabled" : "disabled" );
+#endif
+
+        if ( !bEnableRecording )
+        {
+            emit StopRecorder();
+        }
+        else if ( !IsRunning() )
+        {
+            // This dirty hack is for the GUI.  It doesn't care.
+            emit StopRecorder();
+        }
+    }
+
+    // send recording state message
+    CreateAndSendRecorderStateForAllConChannels();
+}
+
+void CServer::Start()
+{
+    // only start if not already running
+    if ( !IsRunning() )
+    {
+        // the first tick after the start must not be evaluated for the timer
+        // jitter statistic
+        TimingStats.ResetTick();
+
+        // start timer (in the multi-room mode the timer of the main room is
+        // used, it may already run for another room)
+        bIsRunning = true;
+        pTimerServer->HighPrecisionTimer.Start();
+
+        // emit start signal
+        emit Started();
+    }
+}
+
+void CServer::Stop()
+{
+    // Under Mac we have the problem that the timer shutdown might
+    // take some time and therefore we get a lot of "server stopped"
+    // entries in the log. The following condition shall prevent this.
+    // For the other OSs this should not hurt either.
+    if ( IsRunning() )
+    {
+        // stop timer (in the multi-room mode only if no other room of the
+        // timer is running)
+        bIsRunning = false;
+
+        if ( !pTimerServer->IsTimerRequired() )
+        {
+            pTimerServer->HighPrecisionTimer.Sleep();
+
+            // a wake-up which was requested while we went to sleep must not
+            // be lost
+            if ( iWakeRequested.loadAcquire() != 0 )
+            {
+                pTimerServer->HighPrecisionTimer.Wake();
+            }
+        }
+
+        // logging (add "server stopped" logging entry)
+        Logging.AddServerStopped();
+
+        // emit stopped signal
+        emit Stopped();
+    }
+}
+
+void CServer::WakeUp()
+{
+    // the flag is evaluated by the next tick of the timer (which may already
+    // run for another room)
+    iWakeRequested.storeRelease ( 1 );
+    pTimerServer->HighPrecisionTimer.Wake();
+}
+
+void CServer::StartIfWakeRequested()
+{
+    // if the server is still running, the call to Start() will have no effect
+    if ( iWakeRequested.testAndSetOrdered ( 1, 0 ) )
+    {
+        Start();
+    }
+}
+
+void CServer::WarmUpCodecs()
+{
+    // The codecs of the channel which the next client will get are created
+    // with the audio properties of the last client before the server goes to
+    // sleep. A client which reconnects with the same properties then does not
+    // have to wait for the codec allocation in the first frames of its session.
+    const int iChanID = GetFreeChan();
+
+    if ( iChanID != INVALID_CHANNEL_ID )
+    {
+        OpusCodecs[iChanID].GetDecoder ( vecAudioComprType[0],
+                                         vecNumAudioChannels[0] );
+
+        OpusCodecs[iChanID].GetEncoder ( vecAudioComprType[0],
+                                         vecNumAudioChannels[0],
+                                         vecNumCodedBytesIn[0],
+                                         GetEncoderCpuLoad(),
+                                         CChannelNetStats() );
+    }
+}
+
+bool CServer::IsTimerRequired()
+{
+    bool bTimerRequired = IsRunning();
+
+    for ( int i = 0; i < vecpRooms.Size(); i++ )
+    {
+        bTimerRequired = bTimerRequired || vecpRooms[i]->IsRunning();
+    }
+
+    return bTimerRequired;
+}
+
+void CServer::AddRoom ( CServer* pRoom )
+{
+    // the room uses our timer and worker pool from now on (its own timer and
+    // worker pool are never started)
+    pRoom->pTimerServer = this;
+    pRoom->pWorkerPool  = &WorkerPool;
+    pRoom->iNumThreads  = iNumThreads;
+
+    pRoom->HighPrecisionTimer.Stop();
+
+    vecpRooms.Add ( pRoom );
+}
+
+void CServer::OnTimerTick()
+{
+    // the frames of this server and of the rooms which share the timer are
+    // processed one after another (since all rooms are processed in the same
+    // thread, they can also share the worker pool)
+    StartIfWakeRequested();
+
+    if ( IsRunning() )
+    {
+        OnTimer();
+    }
+
+    for ( int i = 0; i < vecpRooms.Size(); i++ )
+    {
+        vecpRooms[i]->StartIfWakeRequested();
+
+        if ( vecpRooms[i]->IsRunning() )
+        {
+            vecpRooms[i]->OnTimer();
+        }
+    }
+}
+
+void CServer::OnTimer()
+{
+    // timer jitter measurement and start measurement of the processing time
+    // of the current frame
+    TimingStats.UpdateTick ( TickClock.nsecsElapsed() );
+    FrameProcTimer.start();
+
+    TRACE_SCOPE ( TP_SERVER_FRAME );
+    CFlightRecScope FlightRecScope ( FlightRecorder, FR_TICK );
+    CTracer::Begin ( TP_SERVER_COLLECT );
+
+    // Get data from all connected clients -------------------------------------
+    // some inits
+    int  iNumClients          = 0; // init connected client counter
+    bool bUpdateChannelLevels = false;
+    bool bSendChannelLevels   = false;
+
+    // number of frames with an unchanged mix before a client joins a group
+    const int iMixGroupHoldNumFrames = SERVER_MIX_GROUP_HOLD_TIME_MS * SYSTEM_SAMPLE_RATE_HZ / 1000 / iServerFrameSizeSamples;
+
+    // The mutex only serializes the get calls with the few other users of the
+    // channel table (the protocol and the audio put calls of the socket thread
+    // do not use this mutex). Do not forget to unlock mutex afterwards!
+    Mutex.lock();
+    {
+        // first, get number and IDs of connected channels
+        for ( int i = 0; i < iMaxNumChannels; i++ )
+        {
+            if ( vecChannels[i].IsConnected() )
+            {
+                // add ID and increment counter (note that the vector length is
+                // according to the worst case scenario, if the number of
+                // connected clients is less, only a subset of elements of this
+                // vector are actually used and the others are dummy elements)
+                vecChanIDsCurConChan[iNumClients] = i;
+                iNumClients++;
+            }
+            else
+            {
+                // a new client on this channel starts with its own encoder
+                vecSharedStreamIdx[i] = INVALID_INDEX;
+                vecMulticastOffer[i]  = NO_MULTICAST_STREAM;
+                vecMulticastActive[i] = 0;
+                vecMixHoldCnt[i]      = 0;
+                vecSilenceCnt[i]      = 0;
+                vecDecodeSkipped[i]   = 0;
+                vecfLastFadeInGain[i] = 0.0f;
+                vecMixGainsValid[i]   = 0;
+                vecSilentMix[i].Reset();
+
+                // free the codecs of disconnected channels (this is safe here
+                // since the codecs are only used by the timer processing)
+                if ( OpusCodecs[i].IsAllocated() )
+                {
+                    OpusCodecs[i].Release();
+                }
+            }
+        }
+
+        // get the fade-in gains, the listener state and the mix group of all
+        // connected channels (a sub-stream is in the mix group of its parent)
+        for ( int i = 0; i < iNumClients; i++ )
+        {
+            const CChannel& CurChannel = vecChannels[vecChanIDsCurConChan[i]];
+
+            vecdFadeInGains[i] = CurChannel.GetFadeInGain();
+            vecIsListener[i]   = CurChannel.IsListener() ? 1 : 0;
+            vecMixGroup[i]     = CurChannel.IsSubStreamChannel() ?
+                vecChannels[CurChannel.GetSubStreamParent()].GetMixGroup() : CurChannel.GetMixGroup();
+        }
+
+        for ( int iS = 0; iS < iMaxNumChannels; iS++ )
+        {
+            SharedStreams[iS].StartFrame();
+        }
+
+        iNumActiveStreams = 0;
+
+        // process connected channels
+        for ( int i = 0; i < iNumClients; i++ )
+        {
+            // get actual ID of current channel
+            const int iCurChanID = vecChanIDsCurConChan[i];
+
+            // a sub-stream channel is disconnected together with its parent
+            // channel or if the client does no longer send the sub-stream
+            if ( vecChannels[iCurChanID].IsSubStreamChannel() )
+            {
+                const CChannel& ParentChannel = vecChannels[vecChannels[iCurChanID].GetSubStreamParent()];
+                const int       iSubStreamIdx = vecChannels[iCurChanID].GetSubStreamIdx();
+
+                if ( !ParentChannel.IsConnected() ||
+                     ( iSubStreamIdx >= ParentChannel.GetNumSubStreams() ) ||
+                     ( ParentChannel.GetSubStreamChanID ( iSubStreamIdx ) != iCurChanID ) )
+                {
+                    vecChannels[iCurChanID].Disconnect();
+                }
+            }
+
+            // get and store number of audio channels, compression type and
+            // the number of coded bytes (the protocol may change them at any
+            // time, therefore they are read together)
+            int iNetwFrameSize;
+
+            vecChannels[iCurChanID].GetAudioStreamProps ( vecAudioComprType[i],
+                                                          vecNumAudioChannels[i],
+                                                          iNetwFrameSize );
+
+            // update the frame size conversion properties (nothing will
+            // happen if the properties stay the same)
+            FrameSizeAdapter[iCurChanID].SetProperties ( GetCodecFrameSizeSamples ( vecAudioComprType[i] ),
+                                                         vecNumAudioChannels[i] );
+
+            // update the cached gain/pan matrix row of this channel and its
+            // stereo gains (this is only done if a gain or pan was changed by
+            // the protocol), a changed mix restarts the hold time of the mix
+            // groups
+            if ( vecChannels[iCurChanID].GetGainsAndPanningsIfChanged ( vecvecdGainMatrix[iCurChanID],
+                                                                        vecvecdPanMatrix[iCurChanID],
+                                                                        vecvecdMixGroupGainMatrix[iCurChanID] ) )
+            {
+                UpdateStereoGainRow ( iCurChanID );
+
+                vecMixHoldCnt[iCurChanID] = 0;
+            }
+            else if ( vecMixHoldCnt[iCurChanID] < iMixGroupHoldNumFrames )
+            {
+                vecMixHoldCnt[iCurChanID]++;
+            }
+
+            const CVector<double>& vecdGainRow     = vecvecdGainMatrix[iCurChanID];
+            const CVector<float>&  vecfGainLRow    = vecvecfGainLMatrix[iCurChanID];
+            const CVector<float>&  vecfGainRRow    = vecvecfGainRMatrix[iCurChanID];
+            CVector<float>&        vecfMixGainRow  = vecvecfMixGainMatrix[iCurChanID];
+            CVector<float>&        vecfMixGainLRow = vecvecfMixGainLMatrix[iCurChanID];
+            CVector<float>&        vecfMixGainRRow = vecvecfMixGainRMatrix[iCurChanID];
+            const bool             bMixGainsValid  = ( vecMixGainsValid[iCurChanID] != 0 );
+
+            // the mix group gains are smoothed like the gains of the channels,
+            // the target gain of a channel in a mix group includes the target
+            // gain of its group (i.e. a channel follows its group bus exactly
+            // if the channel itself has unity gain and center panning)
+            const CVector<double>& vecdMixGroupGainRow = vecvecdMixGroupGainMatrix[iCurChanID];
+            CVector<float>&        vecfMixGroupGainRow = vecvecfMixGroupGainMatrix[iCurChanID];
+
+            for ( int iG = 0; iG <= MAX_NUM_MIX_GROUPS; iG++ )
+            {
+                const float fTargetGain = static_cast<float> ( vecdMixGroupGainRow[iG] );
+
+                if ( !bMixGainsValid )
+                {
+                    vecfMixGroupGainRow[iG] = fTargetGain;
+                }
+
+                vecvecfMixGroupGainsStart[i][iG] = vecfMixGroupGainRow[iG];
+
+                if ( vecfMixGroupGainRow[iG] != fTargetGain )
+                {
+                    vecfMixGroupGainRow[iG] = SmoothGain ( vecfMixGroupGainRow[iG], fTargetGain );
+                }
+
+                vecvecfMixGroupGains[i][iG] = vecfMixGroupGainRow[iG];
+            }
+
+            // get gains of all connected channels and the signature of the
+            // resulting mix (the listeners and, for a mono client, the
+            // pannings do not change the mix)
+            quint64 iMixSignature = Q_UINT64_C ( 14695981039346656037 );
+
+            for ( int j = 0; j < iNumClients; j++ )
+            {
+                // The second index of "vecvecdGains" does not represent
+                // the channel ID! Therefore we have to use
+                // "vecChanIDsCurConChan" to query the IDs of the currently
+                // connected channels (the audio fade-in is applied on the
+                // audio data of the channel)
+                const int   iSrcChanID   = vecChanIDsCurConChan[j];
+                const float fGroupGain   = static_cast<float> ( vecdMixGroupGainRow[vecMixGroup[j]] );
+                const float fTargetGain  = static_cast<float> ( vecdGainRow[iSrcChanID] ) * fGroupGain;
+                const float fTargetGainL = vecfGainLRow[iSrcChanID] * fGroupGain;
+                const float fTargetGainR = vecfGainRRow[iSrcChanID] * fGroupGain;
+
+                // the mix follows the gain changes smoothly, the gains are
+                // ramped from the start to the end of the frame (a source on
+                // a reused channel is faded in anyway)
+                if ( !bMixGainsValid )
+                {
+                    vecfMixGainRow[iSrcChanID]  = fTargetGain;
+                    vecfMixGainLRow[iSrcChanID] = fTargetGainL;
+                    vecfMixGainRRow[iSrcChanID] = fTargetGainR;
+                }
+
+                vecvecfGainsStart[i][j]  = vecfMixGainRow[iSrcChanID];
+                vecvecfGainsLStart[i][j] = vecfMixGainLRow[iSrcChanID];
+                vecvecfGainsRStart[i][j] = vecfMixGainRRow[iSrcChanID];
+
+                if ( vecfMixGainRow[iSrcChanID] != fTargetGain )
+                {
+                    vecfMixGainRow[iSrcChanID] = SmoothGain ( vecfMixGainRow[iSrcChanID], fTargetGain );
+                }
+
+                if ( vecfMixGainLRow[iSrcChanID] != fTargetGainL )
+                {
+                    vecfMixGainLRow[iSrcChanID] = SmoothGain ( vecfMixGainLRow[iSrcChanID], fTargetGainL );
+                }
+
+                if ( vecfMixGainRRow[iSrcChanID] != fTargetGainR )
+                {
+                    vecfMixGainRRow[iSrcChanID] = SmoothGain ( vecfMixGainRRow[iSrcChanID], fTargetGainR );
+                }
+
+                vecvecdGains[i][j]  = vecfMixGainRow[iSrcChanID];
+                vecvecfGainsL[i][j] = vecfMixGainLRow[iSrcChanID];
+                vecvecfGainsR[i][j] = vecfMixGainRRow[iSrcChanID];
+
+                if ( vecIsListener[j] == 0 )
+                {
+                    iMixSignature = AddToMixSignature ( iMixSignature, vecvecdGains[i][j] );
+
+                    if ( vecNumAudioChannels[i] != 1 )
+                    {
+                        iMixSignature = AddToMixSignature ( iMixSignature, vecvecfGainsL[i][j] );
+                        iMixSignature = AddToMixSignature ( iMixSignature, vecvecfGainsR[i][j] );
+                    }
+                }
+            }
+
+            vecMixSignature[i]           = iMixSignature;
+            vecMixGainsValid[iCurChanID] = 1;
+
+            // flag for updating channel levels (if at least one clients wants it)
+            if ( vecChannels[iCurChanID].ChannelLevelsRequired() )
+            {
+                bUpdateChannelLevels = true;
+            }
+
+            // the mix of a client is encoded by a shared stream which is
+            // also used by the other clients with an identical mix (a client
+            // which requested the redundant copy of the frames or the
+            // multitrack mode keeps its own encoder and a sub-stream channel
+            // has no mix)
+            if ( ( vecChannels[iCurChanID].GetRedFrameSize() == 0 ) &&
+                 !vecChannels[iCurChanID].IsMultitrackMode() &&
+                 !vecChannels[iCurChanID].IsSubStreamChannel() )
+            {
+                vecSharedStreamIdx[iCurChanID] =
+                    GetSharedStream ( i,
+                                      iNumClients,
+                                      vecMixHoldCnt[iCurChanID] >= iMixGroupHoldNumFrames );
+            }
+            else
+            {
+                vecSharedStreamIdx[iCurChanID] = INVALID_INDEX;
+            }
+
+            // If the server frame size is smaller than the received OPUS frame size, the frame size
+            // adapter stores the large frame and a new frame is only decoded if the stored frame
+            // was completely used (otherwise a new frame is always decoded).
+            if ( !FrameSizeAdapter[iCurChanID].NextServerFrameIn() )
+            {
+                // get current number of OPUS coded bytes
+                vecDecodeRequired[i]  = 1;
+                vecNumCodedBytesIn[i] = iNetwFrameSize;
+
+                for ( int iB = 0; iB < FrameSizeAdapter[iCurChanID].GetNumCodecBlocks(); iB++ )
+                {
+                    const int iBlockIdx = i * MAX_NUM_FRAME_SIZE_CONV_BLOCKS + iB;
+
+                    // get data (only the coded data is taken out of the channel
+                    // here, the decoding is done after the mutex is released)
+                    const EGetDataStat eGetStat = vecChannels[iCurChanID].GetData ( vecvecbyCodedDataIn[iBlockIdx],
+                                                                                    vecNumCodedBytesIn[i],
+                                                                                    vecCodedDataInLen[iBlockIdx] );
+
+                    // if channel was just disconnected, the recorder and the
+                    // other clients are informed after the frame was sent
+                    if ( eGetStat == GS_CHAN_NOW_DISCONNECTED )
+                    {
+                        QueueTickEvent ( TE_CHAN_DISCONNECTED, iCurChanID );
+                    }
+
+                    // for lost packets the decoder uses a null pointer as coded input data
+                    vecCodedDataInOK[iBlockIdx] = ( eGetStat == GS_BUFFER_OK );
+                }
+            }
+            else
+            {
+                // the next server frame of the stored frame is used, nothing to decode
+                vecDecodeRequired[i] = 0;
+            }
+        }
+
+        if ( bMulticastEnabled )
+        {
+            UpdateMulticastStreams ( iNumClients );
+        }
+
+        for ( int iS = 0; iS < iMaxNumChannels; iS++ )
+        {
+            SharedStreams[iS].ReleaseIfUnused();
+        }
+    }
+    Mutex.unlock(); // release mutex
+
+    CTracer::End ( TP_SERVER_COLLECT );
+
+
+    // Process data ------------------------------------------------------------
+    // Check if at least one client is connected. If not, stop server until
+    // one client is connected.
+    if ( iNumClients > 0 )
+    {
+        FrameProfiler.StartFrame ( iNumClients );
+        FrameProfiler.EndStage ( FS_COLLECT, FrameProcTimer.nsecsElapsed() );
+
+        CTracer::Begin ( TP_SERVER_DECODE );
+
+        // only the clients which are part of at least one mix are decoded
+        UpdateAudibleClients ( iNumClients );
+
+        // decode the received coded audio data (this is done without holding
+        // the mutex so that the socket thread is not blocked while decoding)
+        // each client is decoded, mixed and encoded by its own worker thread
+        // (the assignment is only changed if a client joins or leaves) and
+        // the processing time of each client is measured for the assignment
+        const int* piClientThread = nullptr;
+
+        if ( iNumThreads > 0 )
+        {
+            piClientThread = ChannelAffinity.Update ( vecChanIDsCurConChan,
+                                                      iNumClients,
+                                                      pWorkerPool->GetNumThreads() );
+
+            pWorkerPool->Run ( [this] ( const int iClientIdx )
+                {
+                    const qint64 iStartNs = FrameProcTimer.nsecsElapsed();
+
+                    DecodeReceiveData ( iClientIdx );
+
+                    ChannelAffinity.AddCost ( vecChanIDsCurConChan[iClientIdx],
+                                              FrameProcTimer.nsecsElapsed() - iStartNs );
+                },
+                iNumClients,
+                piClientThread );
+        }
+        else
+        {
+            for ( int i = 0; i < iNumClients; i++ )
+            {
+                DecodeReceiveData ( i );
+            }
+        }
+
+        CTracer::End ( TP_SERVER_DECODE );
+        FrameProfiler.EndStage ( FS_DECODE, FrameProcTimer.nsecsElapsed() );
+        CTracer::Begin ( TP_SERVER_COMMON_MIX );
+
+        // the listeners and the silent channels do not count for the mix, the
+        // mixed clients are grouped by their number of audio channels once per
+        // frame (mono clients first)
+        iNumMixClients = 0;
+
+        for ( int i = 0; i < iNumClients; i++ )
+        {
+            if ( ( vecIsSilent[i] == 0 ) && ( vecNumAudioChannels[i] == 1 ) )
+            {
+                vecMixClientIdx[iNumMixClients++] = i;
+            }
+        }
+
+        iNumMonoMixClients = iNumMixClients;
+
+        for ( int i = 0; i < iNumClients; i++ )
+        {
+            if ( ( vecIsSilent[i] == 0 ) && ( vecNumAudioChannels[i] != 1 ) )
+            {
+                vecMixClientIdx[iNumMixClients++] = i;
+            }
+        }
+
+        // calculate the common mix which is the basis of all listener mixes
+        CreateCommonMix();
+
+
+        // if requested, only the common mix is recorded (one stream instead of
+        // one per client, not done if the server is overloaded), the live
+        // stream gets the same mix (it is encoded by the thread of the stream)
+        const bool bRecordMixFrame = bEnableRecording && bRecordMix && !OverloadControl.SkipRecording();
+        const bool bStreamFrame    = StreamOutput.HasListeners();
+
+        if ( bRecordMixFrame || bStreamFrame )
+        {
+            CMixKernel::FloatToShortStereo ( &vecfCommonMixData[0],
+                                             &vecfCommonMixData[iServerFrameSizeSamples],
+                                             &vecsRecordMixData[0],
+                                             iServerFrameSizeSamples );
+        }
+
+        if ( bRecordMixFrame )
+        {
+            JamRecorder.PutFrame ( RECORDER_MIX_CHAN_ID,
+                                   strRecordMixName,
+                                   CHostAddress(),
+                                   2 /* stereo */,
+                                   &vecsRecordMixData[0] );
+        }
+
+        if ( bStreamFrame )
+        {
+            StreamOutput.PutFrame ( &vecsRecordMixData[0] );
+        }
+
+        CTracer::End ( TP_SERVER_COMMON_MIX );
+        FrameProfiler.EndStage ( FS_COMMON_MIX, FrameProcTimer.nsecsElapsed() );
+        CTracer::Begin ( TP_SERVER_LEVELS );
+
+        // calculate levels for all connected clients (this is the first thing
+        // which is skipped if the server is overloaded)
+        if ( bUpdateChannelLevels && !OverloadControl.SkipLevels() )
+        {
+            bSendChannelLevels = CreateLevelsForAllConChannels ( iNumClients,
+                                                                 vecfChannelPeaks,
+                                                                 vecChannelLevels );
+        }
+
+        CTracer::End ( TP_SERVER_LEVELS );
+        FrameProfiler.EndStage ( FS_LEVELS, FrameProcTimer.nsecsElapsed() );
+        CTracer::Begin ( TP_SERVER_MIX_ENCODE );
+
+        // the mixes of the shared streams are calculated and encoded once for
+        // all clients of the stream
+        if ( iNumThreads > 0 )
+        {
+            pWorkerPool->Run ( [this, iNumClients] ( const int iActiveStreamIdx )
+                { EncodeSharedStream ( iActiveStreamIdx, iNumClients ); },
+                iNumActiveStreams );
+        }
+        else
+        {
+            for ( int iS = 0; iS < iNumActiveStreams; iS++ )
+            {
+                EncodeSharedStream ( iS, iNumClients );
+            }
+        }
+
+        if ( iNumThreads > 0 )
+        {
+            // use the persistent worker threads to process the clients in
+            // parallel (the call returns when all clients are processed)
+            pWorkerPool->Run ( [this, iNumClients, bSendChannelLevels] ( const int iClientIdx )
+                {
+                    const qint64 iStartNs = FrameProcTimer.nsecsElapsed();
+
+                    MixEncodeTransmitData ( iClientIdx, iNumClients, bSendChannelLevels );
+
+                    ChannelAffinity.AddCost ( vecChanIDsCurConChan[iClientIdx],
+                                              FrameProcTimer.nsecsElapsed() - iStartNs );
+                },
+                iNumClients,
+                piClientThread );
+        }
+        else
+        {
+#ifdef USE_OMP
+// TODO This does not work as expected, the CPU is at high levels even if not much work is to be done. So we
+// have an issue using OMP in the OnTimer() function. Even if #pragma omp parallel for is used on a trivial
+// for loop for testing, still the CPU usage goes to very high values -> What is the cause of this issue?
+// NOTE Most probably it is the overhead of threads creation/destruction which causes this effect.
+# pragma omp parallel for
+#endif
+            for ( int i = 0; i < iNumClients; i++ )
+            {
+                MixEncodeTransmitData ( i, iNumClients, bSendChannelLevels );
+            }
+        }
+
+        CTracer::End ( TP_SERVER_MIX_ENCODE );
+        FrameProfiler.EndStage ( FS_MIX_ENCODE, FrameProcTimer.nsecsElapsed() );
+
+        // send all audio packets of this frame
+        CTracer::Begin ( TP_SERVER_SEND );
+        Socket.FlushSendQueue();
+        CTracer::End ( TP_SERVER_SEND );
+
+        FrameProfiler.EndStage ( FS_SEND, FrameProcTimer.nsecsElapsed() );
+
+        // the audio of this frame is on its way, now the events of the frame
+        // can be handled (before the recorder data is committed so that the
+        // recorder gets the disconnections of this frame)
+        CTracer::Begin ( TP_SERVER_TICK_EVENTS );
+        DispatchTickEvents();
+        CTracer::End ( TP_SERVER_TICK_EVENTS );
+
+        // hand the recording data of this frame to the recorder thread
+        if ( bEnableRecording )
+        {
+            JamRecorder.CommitFrames();
+        }
+
+        // update the timing statistics and the overload control with the
+        // processing time of this frame
+        const qint64 iFrameProcTimeNs = FrameProcTimer.nsecsElapsed();
+
+        TimingStats.Update ( iFrameProcTimeNs );
+
+        dFrameProcTimeAvUs = SERVER_PROC_TIME_IIR_WEIGHT * dFrameProcTimeAvUs +
+            ( 1.0 - SERVER_PROC_TIME_IIR_WEIGHT ) * iFrameProcTimeNs / 1000;
+
+        iFrameProcTimeAvUs.storeRelease ( static_cast<int> ( dFrameProcTimeAvUs ) );
+        OverloadControl.Update ( TimingStats.GetUsage ( iFrameProcTimeNs ) );
+        AdmissionControl.Update ( TimingStats.GetUsage ( iFrameProcTimeNs ), iNumClients );
+        EncoderCpuLoad.Update ( TimingStats.GetUsage ( iFrameProcTimeNs ) );
+
+        if ( bMetricsEnabled &&
+             ( ++iMetricsFrameCnt >= SERVER_METRICS_SNAPSHOT_INTERVAL_MS * SYSTEM_SAMPLE_RATE_HZ / 1000 / iServerFrameSizeSamples ) )
+        {
+            iMetricsFrameCnt = 0;
+            PublishMetricsSnapshot();
+        }
+
+        ReportTimingStats();
+    }
+    else
+    {
+        // Disable server if no clients are connected. In this case the server
+        // does not consume any significant CPU when no client is connected.
+        WarmUpCodecs();
+        Stop();
+    }
+}
+
+void CServer::QueueTickEvent ( const EServerTickEvent eEvent,
+                               const int              iChanID )
+{
+    // there is at most one event per channel and frame, the vector is never
+    // resized in the timer
+    if ( iNumTickEvents < vecTickEvents.Size() )
+    {
+        vecTickEvents[iNumTickEvents].eEvent  = eEvent;
+        vecTickEvents[iNumTickEvents].iChanID = iChanID;
+        iNumTickEvents++;
+    }
+}
+
+void CServer::DispatchTickEvents()
+{
+    bool bChanListChanged    = false;
+    bool bReleaseChanBuffers = false;
+
+    for ( int i = 0; i < iNumTickEvents; i++ )
+    {
+        switch ( vecTickEvents[i].eEvent )
+        {
+        case TE_CHAN_DISCONNECTED:
+            // tell the recorder about the disconnection (the recorder only
+            // queues it for its own thread)
+            if ( bEnableRecording && !bRecordMix )
+            {
+                JamRecorder.PutDisconnect ( vecTickEvents[i].iChanID );
+            }
+
+            // the frame was sent, the timer does not use the buffers of the
+            // channel anymore
+            vecChannels[vecTickEvents[i].iChanID].MarkBuffersReleasable();
+
+            bChanListChanged    = true;
+            bReleaseChanBuffers = true;
+            break;
+        }
+    }
+
+    iNumTickEvents = 0;
+
+    // the channel list for all currently connected clients is created and
+    // sent by the main thread and not in the timer
+    if ( bChanListChanged )
+    {
+        RequestChanListForAllConChannels();
+    }
+
+    // the memory is released by the main thread
+    if ( bReleaseChanBuffers )
+    {
+        QMetaObject::invokeMethod ( this, "OnReleaseChanBuffers", Qt::QueuedConnection );
+    }
+}
+
+void CServer::OnReleaseChanBuffers()
+{
+    // a new client cannot connect while the channel table is locked
+    QMutexLocker locker ( &MutexChanTable );
+
+    for ( int i = 0; i < iMaxNumChannels; i++ )
+    {
+        vecChannels[i].ReleaseBuffersIfIdle();
+    }
+}
+
+void CServer::UpdateAudibleClients ( const int iNumClients )
+{
+    // the recording, the reverb send and the mix of the parent server take
+    // all clients with unity gain
+    if ( bEnableRecording || FxSettings.IsReverbEnabled() || Cascade.IsEnabled() )
+    {
+        vecIsAudible.Reset ( 1 );
+        return;
+    }
+
+    vecIsAudible.Reset ( 0 );
+
+    // a client is audible if its gain in the mix of any client which receives
+    // a mix is not zero at the start or at the end of the frame (a sub-stream
+    // channel does not receive a mix)
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        if ( vecChannels[vecChanIDsCurConChan[i]].IsSubStreamChannel() )
+        {
+            continue;
+        }
+
+        const double* pdGains       = vecvecdGains[i];
+        const float*  pfGainsL      = vecvecfGainsL[i];
+        const float*  pfGainsR      = vecvecfGainsR[i];
+        const float*  pfGainsStart  = vecvecfGainsStart[i];
+        const float*  pfGainsLStart = vecvecfGainsLStart[i];
+        const float*  pfGainsRStart = vecvecfGainsRStart[i];
+
+        for ( int j = 0; j < iNumClients; j++ )
+        {
+            if ( ( pdGains[j] != static_cast<double> ( 0.0 ) ) || ( pfGainsStart[j] != 0.0f ) ||
+                 ( pfGainsL[j] != 0.0f ) || ( pfGainsLStart[j] != 0.0f ) ||
+                 ( pfGainsR[j] != 0.0f ) || ( pfGainsRStart[j] != 0.0f ) )
+            {
+                vecIsAudible[j] = 1;
+            }
+        }
+    }
+}
+
+void CServer::DecodeReceiveData ( const int iClientIdx )
+{
+    int            iUnused;
+    unsigned char* pCurCodedData;
+
+    // get actual ID of current channel
+    const int iCurChanID = vecChanIDsCurConChan[iClientIdx];
+
+    CServerFrameSizeAdapter& CurFrameSizeAdapter = FrameSizeAdapter[iCurChanID];
+
+    // the audio of a listener is not used (its packets only keep the channel
+    // connected), it is not decoded and shows no level
+    if ( vecIsListener[iClientIdx] != 0 )
+    {
+        vecfChannelPeaks[iClientIdx] = 0.0f;
+        vecIsSilent[iClientIdx]      = 1;
+        return;
+    }
+
+    // a client which nobody hears is treated like a silent client, its coded
+    // data is dropped (the stored frame of the frame size adapter stays used
+    // up so that the next frame is decoded again) and its fade-in continues
+    if ( vecIsAudible[iClientIdx] == 0 )
+    {
+        vecfChannelPeaks[iClientIdx]   = 0.0f;
+        vecIsSilent[iClientIdx]        = 1;
+        vecSilenceCnt[iCurChanID]      = iSilenceHoldNumFrames;
+        vecDecodeSkipped[iCurChanID]   = 1;
+        vecfLastFadeInGain[iCurChanID] = static_cast<float> ( vecdFadeInGains[iClientIdx] );
+        return;
+    }
+
+    // decode the coded data (if the next server frame of the stored frame is
+    // used, nothing has to be decoded)
+    if ( vecDecodeRequired[iClientIdx] != 0 )
+    {
+        // a large frame is decoded directly to the frame memory of the frame
+        // size adapter
+        int16_t* psCodecFrame = CurFrameSizeAdapter.GetCodecFrameIn ( vecvecsData[iClientIdx] );
+
+        // select the opus decoder and raw audio frame length
+        const int iClientFrameSizeSamples = CurFrameSizeAdapter.GetCodecFrameSizeSamples();
+
+        OpusCustomDecoder* CurOpusDecoder = OpusCodecs[iCurChanID].GetDecoder ( vecAudioComprType[iClientIdx],
+                                                                                vecNumAudioChannels[iClientIdx] );
+
+        // the decoder state of a skipped client does not fit the new frames
+        // (the concealment would continue the audio before the skip)
+        if ( ( vecDecodeSkipped[iCurChanID] != 0 ) && ( CurOpusDecoder != nullptr ) )
+        {
+            opus_custom_decoder_ctl ( CurOpusDecoder, OPUS_RESET_STATE );
+        }
+
+        vecDecodeSkipped[iCurChanID] = 0;
+
+        for ( int iB = 0; iB < CurFrameSizeAdapter.GetNumCodecBlocks(); iB++ )
+        {
+            const int iBlockIdx = iClientIdx * MAX_NUM_FRAME_SIZE_CONV_BLOCKS + iB;
+
+            // get pointer to coded data
+            if ( vecCodedDataInOK[iBlockIdx] != 0 )
+            {
+                pCurCodedData = &vecvecbyCodedDataIn[iBlockIdx][0];
+            }
+            else
+            {
+                // for lost packets use null pointer as coded input data
+                pCurCodedData = nullptr;
+            }
+
+            // OPUS decode received data stream
+            if ( CurOpusDecoder != nullptr )
+            {
+                iUnused = opus_custom_decode ( CurOpusDecoder,
+                                               pCurCodedData,
+                                               vecCodedDataInLen[iBlockIdx],
+                                               &psCodecFrame[CurFrameSizeAdapter.GetCodecBlockOffset ( iB )],
+                                               iClientFrameSizeSamples );
+            }
+        }
+    }
 
-void CServer::RequestNewRecording()
-{
-    if ( bRecorderInitialised && bEnableRecording )
+    // convert the audio data to planar float buffers for the mixing (the
+    // server frame of a large frame is taken in place from the stored frame)
+    const int16_t* psServerFrame = CurFrameSizeAdapter.GetServerFrameIn ( vecvecsData[iClientIdx] );
+
+    if ( vecNumAudioChannels[iClientIdx] == 1 )
     {
-        emit RestartRecorder();
+        CMixKernel::ShortToFloatMono ( psServerFrame,
+                                       &vecvecfData[iClientIdx][0],
+                                       iServerFrameSizeSamples );
+    }
+    else
+    {
+        CMixKernel::ShortToFloatStereo ( psServerFrame,
+                                         &vecvecfData[iClientIdx][0],
+                                         &vecvecfData[iClientIdx][iServerFrameSizeSamples],
+                                         &vecvecfData[iClientIdx][2 * iServerFrameSizeSamples],
+                                         iServerFrameSizeSamples );
     }
 
-    // send recording state message - doesn't hurt
-    CreateAndSendRecorderStateForAllConChannels();
+    // the insert chain is processed here so that it runs in parallel for all
+    // clients if the worker pool is used
+    if ( bFxEnabled )
+    {
+        ChannelFx[iCurChanID].Process ( &vecvecfData[iClientIdx][0],
+                                        vecNumAudioChannels[iClientIdx] != 1 );
+    }
+
+    // peak value of the (mono down-mixed) signal for the level meters and the
+    // silence detection (a channel is only silent after the hold time so that
+    // a quiet signal is not switched on and off)
+    const int iMonoOffs = ( vecNumAudioChannels[iClientIdx] == 1 ) ? 0 : 2 * iServerFrameSizeSamples;
+
+    vecfChannelPeaks[iClientIdx] = CMixKernel::MaxAbs ( &vecvecfData[iClientIdx][iMonoOffs],
+                                                        iServerFrameSizeSamples );
+
+    if ( vecfChannelPeaks[iClientIdx] >= SERVER_SILENCE_THRESHOLD )
+    {
+        vecSilenceCnt[iCurChanID] = 0;
+    }
+    else if ( vecSilenceCnt[iCurChanID] < iSilenceHoldNumFrames )
+    {
+        vecSilenceCnt[iCurChanID]++;
+    }
+
+    vecIsSilent[iClientIdx] = ( vecSilenceCnt[iCurChanID] >= iSilenceHoldNumFrames ) ? 1 : 0;
+
+    // the fade-in of a new client is applied once on its audio data (and not
+    // on each gain of the mixes), the gain ramp from the last to the current
+    // fade-in gain avoids the steps of a per frame gain
+    const float fFadeInGain     = static_cast<float> ( vecdFadeInGains[iClientIdx] );
+    const float fLastFadeInGain = vecfLastFadeInGain[iCurChanID];
+
+    if ( ( fFadeInGain < 1.0f ) || ( fLastFadeInGain < 1.0f ) )
+    {
+        const int iNumPlanes = ( vecNumAudioChannels[iClientIdx] == 1 ) ? 1 : 3;
+
+        for ( int iP = 0; iP < iNumPlanes; iP++ )
+        {
+            CMixKernel::GainRamp ( &vecvecfData[iClientIdx][iP * iServerFrameSizeSamples],
+                                   fLastFadeInGain,
+                                   fFadeInGain,
+                                   iServerFrameSizeSamples );
+        }
+    }
+
+    vecfLastFadeInGain[iCurChanID] = fFadeInGain;
+
+    Q_UNUSED ( iUnused )
 }
 
-void CServer::SetEnableRecording ( bool bNewEnableRecording )
+void CServer::MixEncodeTransmitData ( const int  iClientIdx,
+                                      const int  iNumClients,
+                                      const bool bSendChannelLevels )
 {
-    if ( bRecorderInitialised )
+    int iUnused;
+
+    // get actual ID of current channel
+    const int iCurChanID = vecChanIDsCurConChan[iClientIdx];
+
+    CServerFrameSizeAdapter& CurFrameSizeAdapter = FrameSizeAdapter[iCurChanID];
+
+    // get number of audio channels of current channel
+    const int iCurNumAudChan = vecNumAudioChannels[iClientIdx];
+
+    // export the audio data for recording purpose (not done if the server is
+    // overloaded), the frame is only copied in the recorder queue here, it is
+    // handed to the recorder thread in OnTimer() after all clients are done
+    if ( bEnableRecording && !bRecordMix && !OverloadControl.SkipRecording() &&
+         ( vecIsListener[iClientIdx] == 0 ) )
     {
-        // note that this block executes regardless of whether
-        // what appears to be a change is being applied, to ensure
-        // the requested state is the result
-        bEnableRecording = bNewEnableRecording;
+        JamRecorder.PutFrame ( iCurChanID,
+                               GetChannelName ( iCurChanID ),
+                               vecChannels[iCurChanID].GetAddress(),
+                               iCurNumAudChan,
+                               CurFrameSizeAdapter.GetServerFrameIn ( vecvecsData[iClientIdx] ) );
+    }
 
-#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
-// TODO we should use the ConsoleWriterFactory() instead of qInfo()
-        qInfo() << "Recording state" << ( bEnableRecording ? "enabled" : "disabled" );
-#endif
+    // a sub-stream channel only contributes to the mix, the client receives
+    // its mix on the parent channel
+    if ( vecChannels[iCurChanID].IsSubStreamChannel() )
+    {
+        return;
+    }
 
-        if ( !bEnableRecording )
+    // a client of a shared stream gets the coded blocks of the stream, no
+    // own mix and no own encoding is required
+    const int iSharedStreamIdx = vecSharedStreamIdx[iCurChanID];
+
+    if ( iSharedStreamIdx != INVALID_INDEX )
+    {
+        const CServerSharedStream& SharedStream = SharedStreams[iSharedStreamIdx];
+
+        if ( SharedStream.IsFrameReady() )
         {
-            emit StopRecorder();
+            // a client of the multicast group of the stream gets the frame
+            // with the multicast packet of the stream
+            if ( vecMulticastActive[iCurChanID] == 0 )
+            {
+                for ( int iB = 0; iB < SharedStream.GetNumCodecBlocks(); iB++ )
+                {
+                    vecChannels[iCurChanID].PrepAndSendPacket ( &Socket,
+                                                                SharedStream.GetCodedData ( iB ),
+                                                                SharedStream.GetNumCodedBytes(),
+                                                                vecvecbyRedCodedData[iCurChanID],
+                                                                0,
+                                                                true );
+                }
+            }
+
+            SendChannelLevels ( iCurChanID, iNumClients, bSendChannelLevels );
         }
-        else if ( !IsRunning() )
+
+        return;
+    }
+
+    // in the multitrack mode the coded frames of the other clients are
+    // forwarded and only the clients which cannot be forwarded are mixed in a
+    // submix (not possible if the frames are changed by the insert chain or
+    // if our codec frames are larger than the server frames)
+    const bool bMultitrack = vecChannels[iCurChanID].IsMultitrackMode() &&
+                             !bFxEnabled && !CurFrameSizeAdapter.SplitsCodecFrame();
+
+    if ( bMultitrack )
+    {
+        SelectMultitrackSources ( iClientIdx, iNumClients );
+    }
+
+    // generate a sparate mix for each channel (a silent mix needs no mixing),
+    // the mix of a large codec frame is written in place to the frame memory of
+    // the frame size adapter
+    const bool bIsSilentMix = IsSilentMix ( iClientIdx, iNumClients );
+    int16_t*   psServerFrame = CurFrameSizeAdapter.GetServerFrameOut ( vecvecsSendData[iClientIdx] );
+
+    if ( bIsSilentMix )
+    {
+        std::fill ( psServerFrame, psServerFrame + iCurNumAudChan * iServerFrameSizeSamples, 0 );
+    }
+    else
+    {
+        // actual processing of audio data -> mix
+        ProcessData ( vecvecfData,
+                      vecfCommonMixData,
+                      iClientIdx,
+                      vecvecfMixData[iClientIdx],
+                      psServerFrame,
+                      iCurNumAudChan );
+    }
+
+    // get current number of CELT coded bytes
+    const int iCeltNumCodedBytes = vecChannels[iCurChanID].GetNetwFrameSize();
+
+    // select the opus encoder and raw audio frame length (the encoder bit
+    // rate is only changed if the number of coded bytes was changed)
+    const int iClientFrameSizeSamples = CurFrameSizeAdapter.GetCodecFrameSizeSamples();
+
+    CChannelNetStats NetStats;
+    vecChannels[iCurChanID].GetNetStats ( NetStats );
+
+    OpusCustomEncoder* CurOpusEncoder = OpusCodecs[iCurChanID].GetEncoder ( vecAudioComprType[iClientIdx],
+                                                                            vecNumAudioChannels[iClientIdx],
+                                                                            iCeltNumCodedBytes,
+                                                                            GetEncoderCpuLoad(),
+                                                                            NetStats );
+
+    // the redundant copy is only encoded if the client requested it
+    const int          iRedNumCodedBytes = vecChannels[iCurChanID].GetRedFrameSize();
+    OpusCustomEncoder* CurOpusRedEncoder = nullptr;
+
+    if ( iRedNumCodedBytes > 0 )
+    {
+        CurOpusRedEncoder = OpusCodecs[iCurChanID].GetRedEncoder ( vecAudioComprType[iClientIdx],
+                                                                   vecNumAudioChannels[iClientIdx],
+                                                                   iRedNumCodedBytes );
+    }
+
+    // the encoding of a silent mix is skipped after some frames, the coded
+    // data is stored per channel so that the last coded frame is sent again
+    // (not done if the redundant copy is encoded which uses its own encoder)
+    const bool bSkipEncoding = vecSilentMix[iCurChanID].Update ( bIsSilentMix && ( CurOpusRedEncoder == nullptr ),
+                                                                 vecAudioComprType[iClientIdx],
+                                                                 vecNumAudioChannels[iClientIdx],
+                                                                 iCeltNumCodedBytes );
+
+    // If the server frame size is smaller than the OPUS frame size of the client, the frame size
+    // adapter collects the small frames and only a complete large frame is encoded (otherwise
+    // each frame is encoded directly).
+    const int16_t* psCodecFrame = CurFrameSizeAdapter.PutServerFrameOut ( psServerFrame );
+
+    if ( psCodecFrame != nullptr )
+    {
+        for ( int iB = 0; iB < CurFrameSizeAdapter.GetNumCodecBlocks(); iB++ )
         {
-            // This dirty hack is for the GUI.  It doesn't care.
-            emit StopRecorder();
+            // OPUS encoding
+            if ( ( CurOpusEncoder != nullptr ) && !bSkipEncoding )
+            {
+                iUnused = opus_custom_encode ( CurOpusEncoder,
+                                               &psCodecFrame[CurFrameSizeAdapter.GetCodecBlockOffset ( iB )],
+                                               iClientFrameSizeSamples,
+                                               &vecvecbyCodedData[iCurChanID][0],
+                                               iCeltNumCodedBytes );
+            }
+
+            if ( CurOpusRedEncoder != nullptr )
+            {
+                iUnused = opus_custom_encode ( CurOpusRedEncoder,
+                                               &psCodecFrame[CurFrameSizeAdapter.GetCodecBlockOffset ( iB )],
+                                               iClientFrameSizeSamples,
+                                               &vecvecbyRedCodedData[iCurChanID][0],
+                                               iRedNumCodedBytes );
+            }
+
+            // send separate mix to current clients (the packets of all clients
+            // are queued and sent at once at the end of the timer processing),
+            // a silent submix is not sent
+            if ( bMultitrack )
+            {
+                SendMultitrackFrame ( iClientIdx, iB, bIsSilentMix ? 0 : iCeltNumCodedBytes );
+            }
+            else
+            {
+                vecChannels[iCurChanID].PrepAndSendPacket ( &Socket,
+                                                            vecvecbyCodedData[iCurChanID],
+                                                            iCeltNumCodedBytes,
+                                                            vecvecbyRedCodedData[iCurChanID],
+                                                            ( CurOpusRedEncoder != nullptr ) ? iRedNumCodedBytes : 0,
+                                                            true );
+            }
         }
+
+        SendChannelLevels ( iCurChanID, iNumClients, bSendChannelLevels );
     }
 
-    // send recording state message
-    CreateAndSendRecorderStateForAllConChannels();
+    Q_UNUSED ( iUnused )
 }
 
-void CServer::Start()
+void CServer::SendChannelLevels ( const int  iCurChanID,
+                                  const int  iNumClients,
+                                  const bool bSendChannelLevels )
 {
-    // only start if not already running
-    if ( !IsRunning() )
+    // the socket buffer size is adjusted by the channel itself
+    if ( bSendChannelLevels && vecChannels[iCurChanID].ChannelLevelsRequired() )
     {
-        // start timer
-        HighPrecisionTimer.Start();
+        if ( vecChannels[iCurChanID].GetChannelLevelDeltaInterval() > 0 )
+        {
+            // compact message with the changed levels only (rate limited)
+            bool bFullList;
+            int  iSeqNum;
+
+            if ( vecChannels[iCurChanID].UpdateChannelLevelDelta ( vecChannelLevels,
+                                                                   iNumClients,
+                                                                   bFullList,
+                                                                   iSeqNum ) )
+            {
+                ConnLessProtocol.CreateCLChannelLevelDeltaMes ( vecChannels[iCurChanID].GetAddress(),
+                                                                vecChannelLevels,
+                                                                vecChannels[iCurChanID].GetChannelLevelChanged(),
+                                                                iNumClients,
+                                                                iSeqNum,
+                                                                bFullList );
+            }
+        }
+        else
+        {
+            ConnLessProtocol.CreateCLChannelLevelListMes ( vecChannels[iCurChanID].GetAddress(),
+                                                           vecChannelLevels,
+                                                           iNumClients );
+        }
+    }
+}
 
-        // emit start signal
-        emit Started();
+void CServer::SelectMultitrackSources ( const int iClientIdx,
+                                        const int iNumClients )
+{
+    const int iCurChanID      = vecChanIDsCurConChan[iClientIdx];
+    const int iCodecFrameSize = FrameSizeAdapter[iCurChanID].GetCodecFrameSizeSamples();
+    double*   pdGains         = vecvecdGains[iClientIdx];
+    int       iNumTracks      = 0;
+
+    // the frame always has room for the submix
+    int iFrameSize = MULTITRACK_HEADER_SIZE +
+        CMultitrackFrame::GetTrackSize ( vecChannels[iCurChanID].GetNetwFrameSize() );
+
+    for ( int j = 0; ( j < iNumClients ) && ( iNumTracks < MULTITRACK_MAX_NUM_TRACKS ); j++ )
+    {
+        const int iTrackSize = CMultitrackFrame::GetTrackSize ( vecNumCodedBytesIn[j] );
+
+        // a client is forwarded if it is part of our mix, its fade-in is
+        // finished (the client applies its own gains) and a frame of it is
+        // decoded for each of our codec blocks
+        if ( ( vecIsListener[j] == 0 ) &&
+             ( vecIsSilent[j] == 0 ) &&
+             ( pdGains[j] != static_cast<double> ( 0.0 ) ) &&
+             ( vecdFadeInGains[j] >= static_cast<double> ( 1.0 ) ) &&
+             ( vecDecodeRequired[j] != 0 ) &&
+             ( FrameSizeAdapter[vecChanIDsCurConChan[j]].GetCodecFrameSizeSamples() == iCodecFrameSize ) &&
+             ( iFrameSize + iTrackSize <= MULTITRACK_MAX_FRAME_SIZE ) )
+        {
+            vecvecMultitrackIdx[iClientIdx][iNumTracks++] = j;
+            iFrameSize += iTrackSize;
+
+            // the forwarded client is removed from the submix (the gains are
+            // calculated again in the next frame)
+            pdGains[j]                        = 0.0;
+            vecvecfGainsL[iClientIdx][j]      = 0.0f;
+            vecvecfGainsR[iClientIdx][j]      = 0.0f;
+            vecvecfGainsStart[iClientIdx][j]  = 0.0f;
+            vecvecfGainsLStart[iClientIdx][j] = 0.0f;
+            vecvecfGainsRStart[iClientIdx][j] = 0.0f;
+        }
     }
+
+    vecNumMultitrackIdx[iClientIdx] = iNumTracks;
 }
 
-void CServer::Stop()
+void CServer::SendMultitrackFrame ( const int iClientIdx,
+                                    const int iBlock,
+                                    const int iSubmixNumBytes )
 {
-    // Under Mac we have the problem that the timer shutdown might
-    // take some time and therefore we get a lot of "server stopped"
-    // entries in the log. The following condition shall prevent this.
-    // For the other OSs this should not hurt either.
-    if ( IsRunning() )
+    const int         iCurChanID = vecChanIDsCurConChan[iClientIdx];
+    CMultitrackFrame& Frame      = vecMultitrackFrames[iClientIdx];
+
+    Frame.Start();
+
+    if ( iSubmixNumBytes > 0 )
     {
-        // stop timer
-        HighPrecisionTimer.Stop();
+        Frame.AddTrack ( MULTITRACK_SUBMIX_CHAN_ID,
+                         vecAudioComprType[iClientIdx],
+                         vecNumAudioChannels[iClientIdx],
+                         &vecvecbyCodedData[iCurChanID][0],
+                         iSubmixNumBytes );
+    }
 
-        // logging (add "server stopped" logging entry)
-        Logging.AddServerStopped();
+    for ( int k = 0; k < vecNumMultitrackIdx[iClientIdx]; k++ )
+    {
+        const int j         = vecvecMultitrackIdx[iClientIdx][k];
+        const int iBlockIdx = j * MAX_NUM_FRAME_SIZE_CONV_BLOCKS + iBlock;
+
+        // a lost frame is forwarded as an empty track which is concealed by
+        // the client
+        Frame.AddTrack ( vecChanIDsCurConChan[j],
+                         vecAudioComprType[j],
+                         vecNumAudioChannels[j],
+                         ( vecCodedDataInOK[iBlockIdx] != 0 ) ? &vecvecbyCodedDataIn[iBlockIdx][0] : nullptr,
+                         vecCodedDataInLen[iBlockIdx] );
+    }
 
-        // emit stopped signal
-        emit Stopped();
+    vecChannels[iCurChanID].PrepAndSendMultitrackFrame ( &Socket, Frame.GetData(), Frame.GetSize(), true );
+}
+
+void CServer::UpdateStereoGainRow ( const int iChanID )
+{
+    // combined gain/pan for each stereo channel where we define the panning
+    // that center equals full gain for both channels
+    const CVector<double>& vecdGainRow = vecvecdGainMatrix[iChanID];
+    const CVector<double>& vecdPanRow  = vecvecdPanMatrix[iChanID];
+
+    for ( int j = 0; j < iMaxNumChannels; j++ )
+    {
+        vecvecfGainLMatrix[iChanID][j] = static_cast<float> ( MathUtils::GetLeftPan ( vecdPanRow[j], false ) * vecdGainRow[j] );
+        vecvecfGainRMatrix[iChanID][j] = static_cast<float> ( MathUtils::GetRightPan ( vecdPanRow[j], false ) * vecdGainRow[j] );
     }
 }
 
-void CServer::OnTimer()
+bool CServer::IsSameMix ( const int iClientIdx,
+                          const int iRefClientIdx,
+                          const int iNumClients )
 {
-/*
-static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TEST do a timer jitter measurement
-*/
-    // Get data from all connected clients -------------------------------------
-    // some inits
-    int  iUnused;
-    int  iNumClients               = 0; // init connected client counter
-    bool bChannelIsNowDisconnected = false;
-    bool bUpdateChannelLevels      = false;
-    bool bSendChannelLevels        = false;
-
-    // Make put and get calls thread safe. Do not forget to unlock mutex
-    // afterwards!
-    Mutex.lock();
+    // the signatures of the mixes are equal, make sure that the mixes are
+    // identical (the stereo gains are only used for a stereo client)
+    const bool bIsStereo = ( vecNumAudioChannels[iClientIdx] != 1 );
+
+    for ( int j = 0; j < iNumClients; j++ )
     {
-        // first, get number and IDs of connected channels
-        for ( int i = 0; i < iMaxNumChannels; i++ )
+        if ( ( vecIsListener[j] == 0 ) &&
+             ( ( vecvecdGains[iClientIdx][j] != vecvecdGains[iRefClientIdx][j] ) ||
+               ( bIsStereo && ( ( vecvecfGainsL[iClientIdx][j] != vecvecfGainsL[iRefClientIdx][j] ) ||
+                                ( vecvecfGainsR[iClientIdx][j] != vecvecfGainsR[iRefClientIdx][j] ) ) ) ) )
         {
-            if ( vecChannels[i].IsConnected() )
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int CServer::GetSharedStream ( const int  iClientIdx,
+                               const int  iNumClients,
+                               const bool bMixIsStable )
+{
+    const int     iCurChanID         = vecChanIDsCurConChan[iClientIdx];
+    const int     iCeltNumCodedBytes = vecChannels[iCurChanID].GetNetwFrameSize();
+    const quint64 iMixSignature      = vecMixSignature[iClientIdx];
+
+    // a client with a stable mix joins the group of a client with an identical
+    // mix (only the streams which are already used in this frame are checked)
+    if ( bMixIsStable )
+    {
+        for ( int i = 0; i < iNumActiveStreams; i++ )
+        {
+            const int iS = vecActiveStreams[i];
+
+            if ( SharedStreams[iS].HasKey ( vecAudioComprType[iClientIdx],
+                                            vecNumAudioChannels[iClientIdx],
+                                            iCeltNumCodedBytes,
+                                            iMixSignature ) &&
+                 IsSameMix ( iClientIdx, SharedStreams[iS].GetRefClientIdx(), iNumClients ) )
             {
-                // add ID and increment counter (note that the vector length is
-                // according to the worst case scenario, if the number of
-                // connected clients is less, only a subset of elements of this
-                // vector are actually used and the others are dummy elements)
-                vecChanIDsCurConChan[iNumClients] = i;
-                iNumClients++;
+                SharedStreams[iS].AddUser();
+                return iS;
             }
         }
+    }
 
-        // process connected channels
-        for ( int i = 0; i < iNumClients; i++ )
+    // otherwise the client keeps the stream of the last frame so that the
+    // encoder state does not change (a client which has just changed its mix
+    // leaves the group, it only keeps a stream which it did not share)
+    const int iPrevStreamIdx = vecSharedStreamIdx[iCurChanID];
+
+    if ( ( iPrevStreamIdx != INVALID_INDEX ) &&
+         !SharedStreams[iPrevStreamIdx].IsUsed() &&
+         ( bMixIsStable || ( SharedStreams[iPrevStreamIdx].GetNumUsersPrev() <= 1 ) ) )
+    {
+        ClaimSharedStream ( iPrevStreamIdx, iClientIdx );
+        return iPrevStreamIdx;
+    }
+
+    // a new group starts with a free stream
+    for ( int iS = 0; iS < iMaxNumChannels; iS++ )
+    {
+        if ( SharedStreams[iS].IsFree() )
         {
-            int                iClientFrameSizeSamples = 0; // initialize to avoid a compiler warning
-            OpusCustomDecoder* CurOpusDecoder;
-            unsigned char*     pCurCodedData;
+            ClaimSharedStream ( iS, iClientIdx );
+            return iS;
+        }
+    }
 
-            // get actual ID of current channel
-            const int iCurChanID = vecChanIDsCurConChan[i];
+    // no stream is available in this frame, the client uses its own encoder
+    return INVALID_INDEX;
+}
+
+void CServer::ClaimSharedStream ( const int iStreamIdx,
+                                  const int iClientIdx )
+{
+    const int iCurChanID = vecChanIDsCurConChan[iClientIdx];
+
+    SharedStreams[iStreamIdx].SetKey ( vecAudioComprType[iClientIdx],
+                                       vecNumAudioChannels[iClientIdx],
+                                       vecChannels[iCurChanID].GetNetwFrameSize(),
+                                       vecMixSignature[iClientIdx],
+                                       iClientIdx );
+
+    SharedStreams[iStreamIdx].AddUser();
+
+    vecActiveStreams[iNumActiveStreams] = iStreamIdx;
+    iNumActiveStreams++;
+}
+
+void CServer::EncodeSharedStream ( const int iActiveStreamIdx,
+                                   const int iNumClients )
+{
+    CServerSharedStream& SharedStream  = SharedStreams[vecActiveStreams[iActiveStreamIdx]];
+    const int            iRefClientIdx = SharedStream.GetRefClientIdx();
+
+    // the mix of the group is the mix of its first client (a silent mix needs
+    // no mixing)
+    const bool bIsSilentMix = IsSilentMix ( iRefClientIdx, iNumClients );
+
+    if ( bIsSilentMix )
+    {
+        std::fill ( SharedStream.GetSendData(),
+                    SharedStream.GetSendData() + SharedStream.GetNumAudioChannels() * iServerFrameSizeSamples,
+                    0 );
+    }
+    else
+    {
+        ProcessData ( vecvecfData,
+                      vecfCommonMixData,
+                      iRefClientIdx,
+                      &SharedStream.GetMixData()[0],
+                      SharedStream.GetSendData(),
+                      SharedStream.GetNumAudioChannels() );
+    }
+
+    SharedStream.Encode ( GetEncoderCpuLoad(), bIsSilentMix );
+
+    // the frame is sent once to the multicast group for each port of the
+    // clients which have joined the group
+    if ( SharedStream.IsFrameReady() && ( SharedStream.GetNumMulticastPorts() > 0 ) )
+    {
+        int                     iNumBytes;
+        const CVector<uint8_t>& vecbyPacket = SharedStream.GetPacket ( iNumBytes );
+        CHostAddress            GroupAddr   = vecMulticastGroupAddr[vecActiveStreams[iActiveStreamIdx]];
+        USockAddr               GroupSockAddr;
+
+        for ( int i = 0; i < SharedStream.GetNumMulticastPorts(); i++ )
+        {
+            GroupAddr.iPort = SharedStream.GetMulticastPort ( i );
+            CSocket::HostAddrToSockAddr ( GroupAddr, GroupSockAddr );
+
+            Socket.QueuePacket ( &vecbyPacket[0], iNumBytes, GroupSockAddr );
+        }
+    }
+}
+
+void CServer::UpdateMulticastStreams ( const int iNumClients )
+{
+    // a client in the local network whose shared stream has a multicast group
+    // and whose packets are the plain packets of the stream is offered the
+    // group, the stream is sent to the group for the client as soon as it has
+    // confirmed the offered stream (until then it gets the stream by unicast)
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        const int iCurChanID = vecChanIDsCurConChan[i];
+        const int iStreamIdx = vecSharedStreamIdx[iCurChanID];
+        CChannel& CurChannel = vecChannels[iCurChanID];
+        int       iOffer     = NO_MULTICAST_STREAM;
+
+        if ( ( iStreamIdx != INVALID_INDEX ) &&
+             ( iStreamIdx < MAX_NUM_MULTICAST_STREAMS ) &&
+             CurChannel.GetAddress().IsPrivate() &&
+             CurChannel.SendsPlainPackets ( SharedStreams[iStreamIdx].GetNumCodecBlocks() ) )
+        {
+            iOffer = iStreamIdx;
+        }
+
+        if ( iOffer != vecMulticastOffer[iCurChanID] )
+        {
+            vecMulticastOffer[iCurChanID] = iOffer;
+            CurChannel.PostEvent ( CE_MULTICAST_OFFER, iOffer );
+        }
+
+        vecMulticastActive[iCurChanID] =
+            ( ( iOffer != NO_MULTICAST_STREAM ) && ( CurChannel.GetMulticastStream() == iOffer ) ) ? 1 : 0;
+
+        if ( vecMulticastActive[iCurChanID] != 0 )
+        {
+            SharedStreams[iStreamIdx].AddMulticastPort ( CurChannel.GetAddress().iPort );
+        }
+    }
+}
+
+bool CServer::IsSilentMix ( const int iGainIdx,
+                            const int iNumClients )
+{
+    const double* pdGains      = vecvecdGains[iGainIdx];
+    const float*  pfGainsStart = vecvecfGainsStart[iGainIdx];
+
+    // the reverb return and the mix of the parent server are part of each mix
+    if ( FxSettings.IsReverbEnabled() || Cascade.IsEnabled() )
+    {
+        return false;
+    }
+
+    // the mix is silent if no channel which is not silent is mixed (a channel
+    // which is faded out by the gain smoothing is still mixed)
+    for ( int j = 0; j < iNumClients; j++ )
+    {
+        if ( ( vecIsSilent[j] == 0 ) &&
+             ( ( pdGains[j] != static_cast<double> ( 0.0 ) ) || ( pfGainsStart[j] != 0.0f ) ) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void CServer::ReportTimingStats()
+{
+    // report the statistics in a low frequency interval
+    if ( TimingStats.GetNumFrames() >=
+         SERVER_TIMING_STATS_INTERVAL_S * SYSTEM_SAMPLE_RATE_HZ / iServerFrameSizeSamples )
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+// TODO we should use the ConsoleWriterFactory() instead of qInfo()
+        qInfo() << qUtf8Printable ( QString ( "Frame deadline usage (%1 threads): average %2 %, maximum %3 %, %4 overruns" ).
+            arg ( pWorkerPool->GetNumThreads() ).
+            arg ( TimingStats.GetUsageAv() * 100, 0, 'f', 1 ).
+            arg ( TimingStats.GetUsageMax() * 100, 0, 'f', 1 ).
+            arg ( TimingStats.GetNumOverruns() ) );
+
+        qInfo() << qUtf8Printable ( QString ( "Timer tick jitter: average %1 us, maximum %2 us, %3 missed ticks" ).
+            arg ( TimingStats.GetTickJitterAvUs(), 0, 'f', 1 ).
+            arg ( TimingStats.GetTickJitterMaxUs(), 0, 'f', 1 ).
+            arg ( TimingStats.GetNumMissedTicks() ) );
+
+        qInfo() << qUtf8Printable ( QString ( "Received packets per receive call: %1" ).
+            arg ( Socket.GetAndResetRecPacketsPerCall(), 0, 'f', 2 ) );
+
+        if ( OverloadControl.GetNumSkipLevelsFrames() > 0 )
+        {
+            qInfo() << qUtf8Printable ( QString ( "Server overloaded: %1 frames without levels, %2 frames with low encoder complexity, %3 frames without recording" ).
+                arg ( OverloadControl.GetNumSkipLevelsFrames() ).
+                arg ( OverloadControl.GetNumLowComplexityFrames() ).
+                arg ( OverloadControl.GetNumSkipRecordingFrames() ) );
+        }
+
+        const int iNumReqDropped  = ConnLessReqLimiter.GetAndResetNumDropped();
+        const int iNumFullDropped = Socket.GetAndResetNumServerFullDropped();
+
+        if ( ( iNumReqDropped > 0 ) || ( iNumFullDropped > 0 ) )
+        {
+            qInfo() << qUtf8Printable ( QString ( "Connection less rate limit: %1 requests and %2 server full messages dropped" ).
+                arg ( iNumReqDropped ).
+                arg ( iNumFullDropped ) );
+        }
+
+        if ( RelayRoutes.IsEnabled() )
+        {
+            qInfo() << qUtf8Printable ( QString ( "Relays: %1 relayed clients, %2 relay frames lost" ).
+                arg ( RelayRoutes.GetNumRoutes() ).
+                arg ( RelayRoutes.GetAndResetNumLostFrames() ) );
+        }
+
+        // the queue of the recorder shows if the recording keeps up
+        if ( bRecorderInitialised && bEnableRecording )
+        {
+            qInfo() << qUtf8Printable ( QString ( "Recording: %1 frames written (%2 MB/s), queue maximum %3 of %4 frames, %5 frames dropped, %6 tracks paused" ).
+                arg ( JamRecorder.GetNumWrittenFrames() ).
+                arg ( static_cast<double> ( JamRecorder.GetAndResetNumWrittenKiB() ) / 1024 / SERVER_TIMING_STATS_INTERVAL_S, 0, 'f', 2 ).
+                arg ( JamRecorder.GetAndResetMaxQueueLength() ).
+                arg ( JamRecorder.GetQueueSize() ).
+                arg ( JamRecorder.GetNumDroppedFrames() ).
+                arg ( JamRecorder.GetNumPausedTracks() ) );
+        }
 
-            // get and store number of audio channels and compression type
-            vecNumAudioChannels[i] = vecChannels[iCurChanID].GetNumAudioChannels();
-            vecAudioComprType[i]   = vecChannels[iCurChanID].GetAudioCompressionType();
+        if ( ( AdmissionControl.GetNumListenerAdmissions() > 0 ) || ( AdmissionControl.GetNumRejections() > 0 ) )
+        {
+            qInfo() << qUtf8Printable ( QString ( "Admission control: %1 clients accepted as listeners, %2 connection attempts rejected" ).
+                arg ( AdmissionControl.GetNumListenerAdmissions() ).
+                arg ( AdmissionControl.GetNumRejections() ) );
+        }
 
-            // get info about required frame size conversion properties
-            vecUseDoubleSysFraSizeConvBuf[i] = ( !bUseDoubleSystemFrameSize && ( vecAudioComprType[i] == CT_OPUS ) );
+        // the buffers of the idle channels are released
+        qint64 iConMemUsage  = 0;
+        qint64 iIdleMemUsage = 0;
+        int    iNumCon       = 0;
 
-            if ( bUseDoubleSystemFrameSize && ( vecAudioComprType[i] == CT_OPUS64 ) )
+        for ( int i = 0; i < iMaxNumChannels; i++ )
+        {
+            if ( vecChannels[i].IsConnected() )
             {
-                vecNumFrameSizeConvBlocks[i] = 2;
+                iConMemUsage += vecChannels[i].GetMemUsage();
+                iNumCon++;
             }
             else
             {
-                vecNumFrameSizeConvBlocks[i] = 1;
+                iIdleMemUsage += vecChannels[i].GetMemUsage();
             }
+        }
+
+        qInfo() << qUtf8Printable ( QString ( "Channel memory: %1 kB for %2 connected channels, %3 kB for %4 idle channels" ).
+            arg ( iConMemUsage / 1024 ).
+            arg ( iNumCon ).
+            arg ( iIdleMemUsage / 1024 ).
+            arg ( iMaxNumChannels - iNumCon ) );
+#endif
+
+        // the profile is also shown in the server dialog
+        if ( FrameProfiler.IsEnabled() )
+        {
+            strFrameProfileReport = FrameProfiler.GetReport();
 
-            // update conversion buffer size (nothing will happen if the size stays the same)
-            if ( vecUseDoubleSysFraSizeConvBuf[i] )
+            // keep the stage durations for the metrics snapshots of the next
+            // statistics interval
+            for ( int iS = 0; iS < NUM_SERVER_FRAME_STAGES; iS++ )
             {
-                DoubleFrameSizeConvBufIn[iCurChanID].SetBufferSize  ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES  * vecNumAudioChannels[i] );
-                DoubleFrameSizeConvBufOut[iCurChanID].SetBufferSize ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES  * vecNumAudioChannels[i] );
+                FrameProfiler.GetStageDurationsUs ( static_cast<EServerFrameStage> ( iS ),
+                                                    MetricsProfile.dStageP50Us[iS],
+                                                    MetricsProfile.dStageP99Us[iS],
+                                                    MetricsProfile.dStageMaxUs[iS] );
             }
 
-            // select the opus decoder and raw audio frame length
-            if ( vecAudioComprType[i] == CT_OPUS )
-            {
-                iClientFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+            MetricsProfile.bProfileValid = true;
 
-                if ( vecNumAudioChannels[i] == 1 )
-                {
-                    CurOpusDecoder = OpusDecoderMono[iCurChanID];
-                }
-                else
-                {
-                    CurOpusDecoder = OpusDecoderStereo[iCurChanID];
-                }
-            }
-            else if ( vecAudioComprType[i] == CT_OPUS64 )
-            {
-                iClientFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+// TODO we should use the ConsoleWriterFactory() instead of qInfo()
+            qInfo() << qUtf8Printable ( strFrameProfileReport );
+#endif
+        }
 
-                if ( vecNumAudioChannels[i] == 1 )
-                {
-                    CurOpusDecoder = Opus64DecoderMono[iCurChanID];
-                }
-                else
-                {
-                    CurOpusDecoder = Opus64DecoderStereo[iCurChanID];
-                }
-            }
-            else
-            {
-                CurOpusDecoder = nullptr;
-            }
+        TimingStats.Reset();
+        OverloadControl.Reset();
+        AdmissionControl.Reset();
+        FrameProfiler.Reset();
+    }
+}
 
-            // get gains of all connected channels
-            for ( int j = 0; j < iNumClients; j++ )
-            {
-                // The second index of "vecvecdGains" does not represent
-                // the channel ID! Therefore we have to use
-                // "vecChanIDsCurConChan" to query the IDs of the currently
-                // connected channels
-                vecvecdGains[i][j] = vecChannels[iCurChanID].GetGain ( vecChanIDsCurConChan[j] );
+void CServer::PublishMetricsSnapshot()
+{
+    // write the snapshot which is currently not read by the exporter
+    const int               iIdx     = 1 - iMetricsSnapshotIdx.loadAcquire();
+    CServerMetricsSnapshot& Snapshot = MetricsSnapshots[iIdx];
+
+    Snapshot                  = MetricsProfile; // copies the stage durations
+    Snapshot.iNumFrames       = TimingStats.GetTotalNumFrames();
+    Snapshot.iNumOverruns     = TimingStats.GetTotalNumOverruns();
+    Snapshot.iNumMissedTicks  = TimingStats.GetTotalNumMissedTicks();
+    Snapshot.dUsageSum        = TimingStats.GetTotalUsageSum();
+    Snapshot.dUsageMax        = TimingStats.GetUsageMax();
+    Snapshot.dTickJitterMaxUs = TimingStats.GetTickJitterMaxUs();
+    Snapshot.iOverloadLevel   = OverloadControl.GetLevel();
+
+    iMetricsSnapshotIdx.storeRelease ( iIdx );
+}
 
-                // consider audio fade-in
-                vecvecdGains[i][j] *= vecChannels[vecChanIDsCurConChan[j]].GetFadeInGain();
+void CServer::CreateCommonMix()
+{
+    // The common ("everyone") mix is the sum of all clients with unity gain
+    // and center panning. It is calculated once per frame and each listener
+    // mix is then derived from it by only correcting the channels with a
+    // different gain/pan (e.g. the own channel, muted or faded channels).
+    // The planes are the same as for the input data: left, right and mono
+    // down-mix.
+    vecfCommonMixData.Reset ( 0 );
+
+    // the listeners and the silent channels are not part of any mix, for mono
+    // input data all planes are identical
+    for ( int k = 0; k < iNumMonoMixClients; k++ )
+    {
+        const float* pfIn = vecvecfData[vecMixClientIdx[k]];
 
-                // panning
-                vecvecdPannings[i][j] = vecChannels[iCurChanID].GetPan ( vecChanIDsCurConChan[j] );
-            }
+        CMixKernel::MixAdd ( &vecfCommonMixData[0],                           pfIn, 1.0f, iServerFrameSizeSamples );
+        CMixKernel::MixAdd ( &vecfCommonMixData[iServerFrameSizeSamples],     pfIn, 1.0f, iServerFrameSizeSamples );
+        CMixKernel::MixAdd ( &vecfCommonMixData[2 * iServerFrameSizeSamples], pfIn, 1.0f, iServerFrameSizeSamples );
+    }
 
-            // flag for updating channel levels (if at least one clients wants it)
-            if ( vecChannels[iCurChanID].ChannelLevelsRequired() )
+    for ( int k = iNumMonoMixClients; k < iNumMixClients; k++ )
+    {
+        // the three planes are contiguous
+        CMixKernel::MixAdd ( &vecfCommonMixData[0], vecvecfData[vecMixClientIdx[k]], 1.0f, 3 * iServerFrameSizeSamples );
+    }
+
+    // the mix group buses are summed in the same way (a bus is only cleared
+    // and used if at least one of the mixed clients is in its group)
+    vecMixGroupUsed.Reset ( 0 );
+
+    for ( int k = 0; k < iNumMixClients; k++ )
+    {
+        const int iMixGroup = vecMixGroup[vecMixClientIdx[k]];
+
+        if ( iMixGroup != NO_MIX_GROUP )
+        {
+            float*       pfBus = vecvecfMixGroupData[iMixGroup];
+            const float* pfIn  = vecvecfData[vecMixClientIdx[k]];
+
+            if ( vecMixGroupUsed[iMixGroup] == 0 )
             {
-                bUpdateChannelLevels = true;
+                vecvecfMixGroupData.ResetRow ( iMixGroup );
+                vecMixGroupUsed[iMixGroup] = 1;
             }
 
-            // If the server frame size is smaller than the received OPUS frame size, we need a conversion
-            // buffer which stores the large buffer.
-            // Note that we have a shortcut here. If the conversion buffer is not needed, the boolean flag
-            // is false and the Get() function is not called at all. Therefore if the buffer is not needed
-            // we do not spend any time in the function but go directly inside the if condition.
-            if ( ( vecUseDoubleSysFraSizeConvBuf[i] == 0 ) ||
-                 !DoubleFrameSizeConvBufIn[iCurChanID].Get ( vecvecsData[i], SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[i] ) )
+            if ( k < iNumMonoMixClients )
             {
-                // get current number of OPUS coded bytes
-                const int iCeltNumCodedBytes = vecChannels[iCurChanID].GetNetwFrameSize();
+                CMixKernel::MixAdd ( pfBus,                               pfIn, 1.0f, iServerFrameSizeSamples );
+                CMixKernel::MixAdd ( pfBus + iServerFrameSizeSamples,     pfIn, 1.0f, iServerFrameSizeSamples );
+                CMixKernel::MixAdd ( pfBus + 2 * iServerFrameSizeSamples, pfIn, 1.0f, iServerFrameSizeSamples );
+            }
+            else
+            {
+                CMixKernel::MixAdd ( pfBus, pfIn, 1.0f, 3 * iServerFrameSizeSamples );
+            }
+        }
+    }
 
-                for ( int iB = 0; iB < vecNumFrameSizeConvBlocks[i]; iB++ )
-                {
-                    // get data
-                    const EGetDataStat eGetStat = vecChannels[iCurChanID].GetData ( vecvecbyCodedData[i], iCeltNumCodedBytes );
+    // the shared reverb bus is processed once per frame for all clients and
+    // its return is added to the common mix, i.e. it is not affected by the
+    // gains of the listener mixes
+    if ( FxSettings.IsReverbEnabled() )
+    {
+        const float fSendGain = static_cast<float> ( FxSettings.dReverbSend );
 
-                    // if channel was just disconnected, set flag that connected
-                    // client list is sent to all other clients
-                    // and emit the client disconnected signal
-                    if ( eGetStat == GS_CHAN_NOW_DISCONNECTED )
-                    {
-                        if ( bEnableRecording )
-                        {
-                            emit ClientDisconnected ( iCurChanID ); // TODO do this outside the mutex lock?
-                        }
+        ReverbBus.ClearSend();
 
-                        bChannelIsNowDisconnected = true;
-                    }
+        for ( int k = 0; k < iNumMixClients; k++ )
+        {
+            ReverbBus.AddSend ( vecvecfData[vecMixClientIdx[k]] + ( ( k < iNumMonoMixClients ) ? 0 : 2 * iServerFrameSizeSamples ),
+                                fSendGain );
+        }
 
-                    // get pointer to coded data
-                    if ( eGetStat == GS_BUFFER_OK )
-                    {
-                        pCurCodedData = &vecvecbyCodedData[i][0];
-                    }
-                    else
-                    {
-                        // for lost packets use null pointer as coded input data
-                        pCurCodedData = nullptr;
-                    }
+        ReverbBus.Process();
 
-                    // OPUS decode received data stream
-                    if ( CurOpusDecoder != nullptr )
-                    {
-                        iUnused = opus_custom_decode ( CurOpusDecoder,
-                                                       pCurCodedData,
-                                                       iCeltNumCodedBytes,
-                                                       &vecvecsData[i][iB * SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[i]],
-                                                       iClientFrameSizeSamples );
-                    }
-                }
+        CMixKernel::MixAdd ( &vecfCommonMixData[0], &ReverbBus.GetReturnData()[0], 1.0f, 3 * iServerFrameSizeSamples );
+    }
 
-                // a new large frame is ready, if the conversion buffer is required, put it in the buffer
-                // and read out the small frame size immediately for further processing
-                if ( vecUseDoubleSysFraSizeConvBuf[i] != 0 )
-                {
-                    DoubleFrameSizeConvBufIn[iCurChanID].PutAll ( vecvecsData[i] );
-                    DoubleFrameSizeConvBufIn[iCurChanID].Get ( vecvecsData[i], SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[i] );
-                }
-            }
-        }
+    // in the cascade mode the local mix is sent to the parent server and the
+    // mix of the parent server is added like the reverb return
+    if ( Cascade.IsEnabled() )
+    {
+        Cascade.Process ( &vecfCommonMixData[0], &vecfCommonMixData[iServerFrameSizeSamples] );
+
+        CMixKernel::MixAdd ( &vecfCommonMixData[0], &Cascade.GetReturnData()[0], 1.0f, 3 * iServerFrameSizeSamples );
+    }
+}
 
-        // a channel is now disconnected, take action on it
-        if ( bChannelIsNowDisconnected )
+template<int iInCh, int iOutCh>
+void CServer::MixClientGroup ( const CServerFrameArena<float>& vecvecfData,
+                               const int*                      piClientIdx,
+                               const int                       iNumGroupClients,
+                               const int                       iGainIdx,
+                               float*                          pfMixData )
+{
+    const double* pdGains         = vecvecdGains[iGainIdx];
+    const float*  pfGainsL        = vecvecfGainsL[iGainIdx];
+    const float*  pfGainsR        = vecvecfGainsR[iGainIdx];
+    const float*  pfGainsStart    = vecvecfGainsStart[iGainIdx];
+    const float*  pfGainsLStart   = vecvecfGainsLStart[iGainIdx];
+    const float*  pfGainsRStart   = vecvecfGainsRStart[iGainIdx];
+    const float*  pfGainOffs      = vecvecfGainOffs[iGainIdx];
+    const float*  pfGainOffsStart = vecvecfGainOffsStart[iGainIdx];
+
+    // a mono mix uses the mono down-mix plane of stereo input data, a stereo
+    // mix uses the same plane for both channels of mono input data (the
+    // conditions are resolved at compile time)
+    const int iMonoOffs  = ( iInCh == 1 ) ? 0 : 2 * iServerFrameSizeSamples;
+    const int iRightOffs = ( iInCh == 1 ) ? 0 : iServerFrameSizeSamples;
+
+    for ( int k = 0; k < iNumGroupClients; k++ )
+    {
+        const int    j    = piClientIdx[k];
+        const float* pfIn = vecvecfData[j];
+
+        if ( iOutCh == 1 )
+        {
+            MixAddSmoothed ( pfMixData,
+                             pfIn + iMonoOffs,
+                             pfGainsStart[j] - pfGainOffsStart[j],
+                             static_cast<float> ( pdGains[j] ) - pfGainOffs[j] );
+        }
+        else
         {
-            // update channel list for all currently connected clients
-            CreateAndSendChanListForAllConChannels();
+            // the combined gain/pan of each stereo channel is precomputed
+            // (center equals full gain for both channels)
+            MixAddSmoothed ( pfMixData,
+                             pfIn,
+                             pfGainsLStart[j] - pfGainOffsStart[j],
+                             pfGainsL[j] - pfGainOffs[j] );
+
+            MixAddSmoothed ( pfMixData + iServerFrameSizeSamples,
+                             pfIn + iRightOffs,
+                             pfGainsRStart[j] - pfGainOffsStart[j],
+                             pfGainsR[j] - pfGainOffs[j] );
         }
     }
-    Mutex.unlock(); // release mutex
+}
 
+/// @brief Mix all audio data from all clients together.
+void CServer::ProcessData ( const CServerFrameArena<float>& vecvecfData,
+                            const CVector<float>&           vecfCommonMixData,
+                            const int                       iGainIdx,
+                            float*                          pfMixData,
+                            int16_t*                        psOutData,
+                            const int                       iCurNumAudChan )
+{
+    // The mixing is done on planar float buffers with the vectorized mixing
+    // kernel. The planes of the input data are: left, right and mono down-mix
+    // (for mono clients all planes are identical and only the first one is
+    // filled). The saturation is only applied on the final int16 conversion.
+    // The mixed clients are grouped by their number of audio channels, each
+    // group is mixed by its specialised kernel.
+    float*     pfMixLeft         = pfMixData;
+    float*     pfMixRight        = pfMixData + iServerFrameSizeSamples;
+    const bool bMonoMix          = ( iCurNumAudChan == 1 );
+    int        iNumDiffGroups    = 0;
+
+    // a gain which is smoothed differs from the common mix
+    const double* pdGains              = vecvecdGains[iGainIdx];
+    const float*  pfGainsL             = vecvecfGainsL[iGainIdx];
+    const float*  pfGainsR             = vecvecfGainsR[iGainIdx];
+    const float*  pfGainsStart         = vecvecfGainsStart[iGainIdx];
+    const float*  pfGainsLStart        = vecvecfGainsLStart[iGainIdx];
+    const float*  pfGainsRStart        = vecvecfGainsRStart[iGainIdx];
+    const float*  pfMixGroupGains      = vecvecfMixGroupGains[iGainIdx];
+    const float*  pfMixGroupGainsStart = vecvecfMixGroupGainsStart[iGainIdx];
+    float*        pfGainOffs           = vecvecfGainOffs[iGainIdx];
+    float*        pfGainOffsStart      = vecvecfGainOffsStart[iGainIdx];
+
+    // The common mix contains all clients with unity gain. The mix group buses
+    // are added with their group gain minus one, i.e. the reference gain of a
+    // client in a mix group is the gain of its group (the group gain of
+    // NO_MIX_GROUP is always unity). Only the clients which differ from their
+    // reference gain are mixed individually, the cost of a mix therefore
+    // scales with the number of groups plus the individual overrides.
+    for ( int iG = NO_MIX_GROUP + 1; iG <= MAX_NUM_MIX_GROUPS; iG++ )
+    {
+        if ( ( vecMixGroupUsed[iG] != 0 ) &&
+             ( ( pfMixGroupGains[iG] != 1.0f ) || ( pfMixGroupGainsStart[iG] != 1.0f ) ) )
+        {
+            iNumDiffGroups++;
+        }
+    }
 
-    // Process data ------------------------------------------------------------
-    // Check if at least one client is connected. If not, stop server until
-    // one client is connected.
-    if ( iNumClients > 0 )
+    // The active clients of this mix are collected once: the clients which
+    // differ from their reference gain (mixed on top of the common mix) and
+    // the clients with a non-zero gain (mixed in a full mix). The lists keep
+    // the order of the mixed clients, i.e. the mono clients come first. For a
+    // stereo mix the mix group buses have center panning.
+    int* piDiffIdx      = vecvecActiveClientIdx[iGainIdx];
+    int* piActiveIdx    = piDiffIdx + iMaxNumChannels;
+    int  iNumDiff       = 0;
+    int  iNumMonoDiff   = 0;
+    int  iNumActive     = 0;
+    int  iNumMonoActive = 0;
+
+    for ( int k = 0; k < iNumMixClients; k++ )
     {
-        // calculate levels for all connected clients
-        if ( bUpdateChannelLevels )
+        const int j = vecMixClientIdx[k];
+
+        pfGainOffs[j]      = pfMixGroupGains[vecMixGroup[j]];
+        pfGainOffsStart[j] = pfMixGroupGainsStart[vecMixGroup[j]];
+
+        bool bDiffers;
+        bool bActive;
+
+        if ( bMonoMix )
         {
-            bSendChannelLevels = CreateLevelsForAllConChannels ( iNumClients,
-                                                                 vecNumAudioChannels,
-                                                                 vecvecsData,
-                                                                 vecChannelLevels );
+            const float fGain = static_cast<float> ( pdGains[j] );
+
+            bDiffers = ( fGain != pfGainOffs[j] ) || ( pfGainsStart[j] != pfGainOffsStart[j] );
+            bActive  = ( fGain != 0.0f ) || ( pfGainsStart[j] != 0.0f );
+        }
+        else
+        {
+            bDiffers = ( pfGainsL[j] != pfGainOffs[j] ) || ( pfGainsR[j] != pfGainOffs[j] ) ||
+                       ( pfGainsLStart[j] != pfGainOffsStart[j] ) || ( pfGainsRStart[j] != pfGainOffsStart[j] );
+            bActive  = ( pfGainsL[j] != 0.0f ) || ( pfGainsR[j] != 0.0f ) ||
+                       ( pfGainsLStart[j] != 0.0f ) || ( pfGainsRStart[j] != 0.0f );
         }
 
-#ifdef USE_OMP
-// TODO This does not work as expected, the CPU is at high levels even if not much work is to be done. So we
-// have an issue using OMP in the OnTimer() function. Even if #pragma omp parallel for is used on a trivial
-// for loop for testing, still the CPU usage goes to very high values -> What is the cause of this issue?
-// NOTE Most probably it is the overhead of threads creation/destruction which causes this effect.
-# pragma omp parallel for
-#endif
-        for ( int i = 0; i < iNumClients; i++ )
+        if ( bDiffers )
         {
-            int                iClientFrameSizeSamples = 0; // initialize to avoid a compiler warning
-            OpusCustomEncoder* CurOpusEncoder;
+            piDiffIdx[iNumDiff++] = j;
+        }
 
-            // get actual ID of current channel
-            const int iCurChanID = vecChanIDsCurConChan[i];
+        if ( bActive )
+        {
+            piActiveIdx[iNumActive++] = j;
+        }
 
-            // get number of audio channels of current channel
-            const int iCurNumAudChan = vecNumAudioChannels[i];
+        if ( k < iNumMonoMixClients )
+        {
+            iNumMonoDiff   = iNumDiff;
+            iNumMonoActive = iNumActive;
+        }
+    }
 
-            // export the audio data for recording purpose
-            if ( bEnableRecording )
-            {
-                emit AudioFrame ( iCurChanID,
-                                  vecChannels[iCurChanID].GetName(),
-                                  vecChannels[iCurChanID].GetAddress(),
-                                  iCurNumAudChan,
-                                  vecvecsData[i] );
-            }
+    // start with the common mix and only apply the gain differences if this
+    // is cheaper than a full mix of the active clients (the copy of the common
+    // mix is counted as one client)
+    const bool bUseCommonMix = ( iNumDiffGroups + iNumDiff + 1 < iNumActive );
+    const int* piMixIdx      = bUseCommonMix ? piDiffIdx    : piActiveIdx;
+    const int  iNumMix       = bUseCommonMix ? iNumDiff     : iNumActive;
+    const int  iNumMonoMix   = bUseCommonMix ? iNumMonoDiff : iNumMonoActive;
 
-            // generate a sparate mix for each channel
-            // actual processing of audio data -> mix
-            ProcessData ( vecvecsData,
-                          vecvecdGains[i],
-                          vecvecdPannings[i],
-                          vecNumAudioChannels,
-                          vecvecsSendData[i],
-                          iCurNumAudChan,
-                          iNumClients );
+    if ( !bUseCommonMix )
+    {
+        std::fill ( pfMixData, pfMixData + 2 * iServerFrameSizeSamples, 0.0f );
+        std::fill ( pfGainOffs, pfGainOffs + iMaxNumChannels, 0.0f );
+        std::fill ( pfGainOffsStart, pfGainOffsStart + iMaxNumChannels, 0.0f );
+    }
 
-            // get current number of CELT coded bytes
-            const int iCeltNumCodedBytes = vecChannels[iCurChanID].GetNetwFrameSize();
+    // distinguish between stereo and mono mode
+    if ( bMonoMix )
+    {
+        // Mono target channel -------------------------------------------------
+        if ( bUseCommonMix )
+        {
+            std::copy ( &vecfCommonMixData[2 * iServerFrameSizeSamples],
+                        &vecfCommonMixData[2 * iServerFrameSizeSamples] + iServerFrameSizeSamples,
+                        pfMixLeft );
 
-            // select the opus encoder and raw audio frame length
-            if ( vecAudioComprType[i] == CT_OPUS )
+            for ( int iG = NO_MIX_GROUP + 1; iG <= MAX_NUM_MIX_GROUPS; iG++ )
             {
-                iClientFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
-
-                if ( vecNumAudioChannels[i] == 1 )
+                if ( vecMixGroupUsed[iG] != 0 )
                 {
-                    CurOpusEncoder = OpusEncoderMono[iCurChanID];
-                }
-                else
-                {
-                    CurOpusEncoder = OpusEncoderStereo[iCurChanID];
+                    MixAddSmoothed ( pfMixLeft,
+                                     vecvecfMixGroupData[iG] + 2 * iServerFrameSizeSamples,
+                                     pfMixGroupGainsStart[iG] - 1.0f,
+                                     pfMixGroupGains[iG] - 1.0f );
                 }
             }
-            else if ( vecAudioComprType[i] == CT_OPUS64 )
+        }
+        else
+        {
+            // the reverb return and the mix of the parent server are part of
+            // the common mix
+            if ( FxSettings.IsReverbEnabled() )
+            {
+                CMixKernel::MixAdd ( pfMixLeft, &ReverbBus.GetReturnData()[2 * iServerFrameSizeSamples], 1.0f, iServerFrameSizeSamples );
+            }
+
+            if ( Cascade.IsEnabled() )
             {
-                iClientFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
+                CMixKernel::MixAdd ( pfMixLeft, &Cascade.GetReturnData()[2 * iServerFrameSizeSamples], 1.0f, iServerFrameSizeSamples );
+            }
+        }
 
-                if ( vecNumAudioChannels[i] == 1 )
-                {
-                    CurOpusEncoder = Opus64EncoderMono[iCurChanID];
-                }
-                else
+        MixClientGroup<1, 1> ( vecvecfData, piMixIdx,               iNumMonoMix,           iGainIdx, pfMixData );
+        MixClientGroup<2, 1> ( vecvecfData, piMixIdx + iNumMonoMix, iNumMix - iNumMonoMix, iGainIdx, pfMixData );
+
+        CMixKernel::FloatToShortMono ( pfMixLeft, psOutData, iServerFrameSizeSamples );
+    }
+    else
+    {
+        // Stereo target channel -----------------------------------------------
+        if ( bUseCommonMix )
+        {
+            std::copy ( &vecfCommonMixData[0],
+                        &vecfCommonMixData[0] + 2 * iServerFrameSizeSamples,
+                        pfMixLeft );
+
+            for ( int iG = NO_MIX_GROUP + 1; iG <= MAX_NUM_MIX_GROUPS; iG++ )
+            {
+                if ( vecMixGroupUsed[iG] != 0 )
                 {
-                    CurOpusEncoder = Opus64EncoderStereo[iCurChanID];
+                    MixAddSmoothed ( pfMixLeft,
+                                     vecvecfMixGroupData[iG],
+                                     pfMixGroupGainsStart[iG] - 1.0f,
+                                     pfMixGroupGains[iG] - 1.0f );
+
+                    MixAddSmoothed ( pfMixRight,
+                                     vecvecfMixGroupData[iG] + iServerFrameSizeSamples,
+                                     pfMixGroupGainsStart[iG] - 1.0f,
+                                     pfMixGroupGains[iG] - 1.0f );
                 }
             }
-            else
+        }
+        else
+        {
+            // the reverb return and the mix of the parent server are part of
+            // the common mix
+            if ( FxSettings.IsReverbEnabled() )
             {
-                CurOpusEncoder = nullptr;
+                CMixKernel::MixAdd ( pfMixLeft, &ReverbBus.GetReturnData()[0], 1.0f, 2 * iServerFrameSizeSamples );
             }
 
-            // If the server frame size is smaller than the received OPUS frame size, we need a conversion
-            // buffer which stores the large buffer.
-            // Note that we have a shortcut here. If the conversion buffer is not needed, the boolean flag
-            // is false and the Get() function is not called at all. Therefore if the buffer is not needed
-            // we do not spend any time in the function but go directly inside the if condition.
-            if ( ( vecUseDoubleSysFraSizeConvBuf[i] == 0 ) ||
-                 DoubleFrameSizeConvBufOut[iCurChanID].Put ( vecvecsSendData[i], SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[i] ) )
+            if ( Cascade.IsEnabled() )
             {
-                if ( vecUseDoubleSysFraSizeConvBuf[i] != 0 )
-                {
-                    // get the large frame from the conversion buffer
-                    DoubleFrameSizeConvBufOut[iCurChanID].GetAll ( vecvecsSendData[i], DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[i] );
-                }
+                CMixKernel::MixAdd ( pfMixLeft, &Cascade.GetReturnData()[0], 1.0f, 2 * iServerFrameSizeSamples );
+            }
+        }
 
-                for ( int iB = 0; iB < vecNumFrameSizeConvBlocks[i]; iB++ )
-                {
-                    // OPUS encoding
-                    if ( CurOpusEncoder != nullptr )
-                    {
-// TODO find a better place than this: the setting does not change all the time
-//      so for speed optimization it would be better to set it only if the network
-//      frame size is changed
-opus_custom_encoder_ctl ( CurOpusEncoder,
-                          OPUS_SET_BITRATE ( CalcBitRateBitsPerSecFromCodedBytes ( iCeltNumCodedBytes, iClientFrameSizeSamples ) ) );
-
-                        iUnused = opus_custom_encode ( CurOpusEncoder,
-                                                       &vecvecsSendData[i][iB * SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[i]],
-                                                       iClientFrameSizeSamples,
-                                                       &vecvecbyCodedData[i][0],
-                                                       iCeltNumCodedBytes );
-                    }
+        MixClientGroup<1, 2> ( vecvecfData, piMixIdx,               iNumMonoMix,           iGainIdx, pfMixData );
+        MixClientGroup<2, 2> ( vecvecfData, piMixIdx + iNumMonoMix, iNumMix - iNumMonoMix, iGainIdx, pfMixData );
 
-                    // send separate mix to current clients
-                    vecChannels[iCurChanID].PrepAndSendPacket ( &Socket,
-                                                                vecvecbyCodedData[i],
-                                                                iCeltNumCodedBytes );
-                }
+        CMixKernel::FloatToShortStereo ( pfMixLeft, pfMixRight, psOutData, iServerFrameSizeSamples );
+    }
+}
 
-                // update socket buffer size
-                vecChannels[iCurChanID].UpdateSocketBufferSize();
+CVector<CChannelInfo> CServer::CreateChannelList()
+{
+    CVector<CChannelInfo> vecChanInfo ( 0 );
 
-                // send channel levels
-                if ( bSendChannelLevels && vecChannels[iCurChanID].ChannelLevelsRequired() )
-                {
-                    ConnLessProtocol.CreateCLChannelLevelListMes ( vecChannels[iCurChanID].GetAddress(),
-                                                                   vecChannelLevels,
-                                                                   iNumClients );
-                }
-            }
+    // look for free channels
+    for ( int i = 0; i < iMaxNumChannels; i++ )
+    {
+        if ( vecChannels[i].IsConnected() )
+        {
+            // a sub-stream channel shows the info of its parent channel
+            CChannelCoreInfo ChanInfo = vecChannels[i].IsSubStreamChannel() ?
+                vecChannels[vecChannels[i].GetSubStreamParent()].GetChanInfo() :
+                vecChannels[i].GetChanInfo();
+
+            ChanInfo.strName = GetChannelName ( i );
+
+            // append channel ID, IP address and channel name to storing vectors
+            vecChanInfo.Add ( CChannelInfo (
+                i, // ID
+                QHostAddress ( QHostAddress::Null ).toIPv4Address(), // use invalid IP address (for privacy reason, #316)
+                ChanInfo ) );
         }
     }
-    else
+
+    return vecChanInfo;
+}
+
+QString CServer::GetChannelName ( const int iChanID )
+{
+    if ( !vecChannels[iChanID].IsSubStreamChannel() )
     {
-        // Disable server if no clients are connected. In this case the server
-        // does not consume any significant CPU when no client is connected.
-        Stop();
+        return vecChannels[iChanID].GetName();
     }
 
-    Q_UNUSED ( iUnused )
+    // the sub-streams are numbered after the stream of the parent channel,
+    // the name is shortened so that the number is always visible
+    const QString strNumber = QString ( " (%1)" ).arg ( vecChannels[iChanID].GetSubStreamIdx() + 2 );
+
+    return vecChannels[vecChannels[iChanID].GetSubStreamParent()].GetName().
+        left ( MAX_LEN_FADER_TAG - strNumber.length() ) + strNumber;
 }
 
-/// @brief Mix all audio data from all clients together.
-void CServer::ProcessData ( const CVector<CVector<int16_t> >& vecvecsData,
-                            const CVector<double>&            vecdGains,
-                            const CVector<double>&            vecdPannings,
-                            const CVector<int>&               vecNumAudioChannels,
-                            CVector<int16_t>&                 vecsOutData,
-                            const int                         iCurNumAudChan,
-                            const int                         iNumClients )
+void CServer::RequestChanListForAllConChannels()
+{
+    // the list is sent after the protocol message was parsed, several changes
+    // which arrive in the meantime are combined in one update
+    if ( iChanListUpdatePending.testAndSetOrdered ( 0, 1 ) )
+    {
+        QMetaObject::invokeMethod ( this, "OnChanListUpdateRequested", Qt::QueuedConnection );
+    }
+}
+
+void CServer::OnChanListUpdateRequested()
 {
-    int i, j, k;
+    // reset the flag first, a change during the list creation requests a new
+    // update
+    iChanListUpdatePending.storeRelease ( 0 );
 
-    // init return vector with zeros since we mix all channels on that vector
-    vecsOutData.Reset ( 0 );
+    CreateAndSendChanListForAllConChannels();
+}
 
-    // distinguish between stereo and mono mode
-    if ( iCurNumAudChan == 1 )
+void CServer::CreateAndSendChanListForAllConChannels()
+{
+    // create channel list
+    CVector<CChannelInfo> vecChanInfo ( CreateChannelList() );
+
+    MutexChanList.lock();
     {
-        // Mono target channel -------------------------------------------------
-        for ( j = 0; j < iNumClients; j++ )
+        // find the changes compared to the last sent list
+        CVector<CChannelInfo> vecChangedChanInfo ( 0 );
+        CVector<int>          veciLeftChanIDs ( 0 );
+        CVector<uint8_t>      vecbyCurPresent ( iMaxNumChannels, 0 );
+
+        for ( int i = 0; i < vecChanInfo.Size(); i++ )
         {
-            // get a reference to the audio data and gain of the current client
-            const CVector<int16_t>& vecsData = vecvecsData[j];
-            const double            dGain    = vecdGains[j];
+            const int iChanID = vecChanInfo[i].iChanID;
+
+            vecbyCurPresent[iChanID] = 1;
 
-            // if channel gain is 1, avoid multiplication for speed optimization
-            if ( dGain == static_cast<double> ( 1.0 ) )
+            if ( !vecbyLastChanListPresent[iChanID] ||
+                 ( vecLastChanListInfo[iChanID] != vecChanInfo[i] ) )
             {
-                if ( vecNumAudioChannels[j] == 1 )
-                {
-                    // mono
-                    for ( i = 0; i < iServerFrameSizeSamples; i++ )
-                    {
-                        vecsOutData[i] = Double2Short (
-                            static_cast<double> ( vecsOutData[i] ) + vecsData[i] );
-                    }
-                }
-                else
-                {
-                    // stereo: apply stereo-to-mono attenuation
-                    for ( i = 0, k = 0; i < iServerFrameSizeSamples; i++, k += 2 )
-                    {
-                        vecsOutData[i] =
-                            Double2Short ( vecsOutData[i] +
-                            ( static_cast<double> ( vecsData[k] ) + vecsData[k + 1] ) / 2 );
-                    }
-                }
+                vecChangedChanInfo.Add ( vecChanInfo[i] );
+                vecLastChanListInfo[iChanID] = vecChanInfo[i];
             }
-            else
+        }
+
+        for ( int i = 0; i < iMaxNumChannels; i++ )
+        {
+            if ( vecbyLastChanListPresent[i] && !vecbyCurPresent[i] )
             {
-                if ( vecNumAudioChannels[j] == 1 )
-                {
-                    // mono
-                    for ( i = 0; i < iServerFrameSizeSamples; i++ )
-                    {
-                        vecsOutData[i] = Double2Short (
-                            vecsOutData[i] + vecsData[i] * dGain );
-                    }
-                }
-                else
-                {
-                    // stereo: apply stereo-to-mono attenuation
-                    for ( i = 0, k = 0; i < iServerFrameSizeSamples; i++, k += 2 )
-                    {
-                        vecsOutData[i] =
-                            Double2Short ( vecsOutData[i] + dGain *
-                            ( static_cast<double> ( vecsData[k] ) + vecsData[k + 1] ) / 2 );
-                    }
-                }
+                veciLeftChanIDs.Add ( i );
             }
         }
-    }
-    else
-    {
-        // Stereo target channel -----------------------------------------------
-        for ( j = 0; j < iNumClients; j++ )
+
+        vecbyLastChanListPresent = vecbyCurPresent;
+
+        const bool bListChanged = ( vecChangedChanInfo.Size() > 0 ) || ( veciLeftChanIDs.Size() > 0 );
+
+        if ( bListChanged )
         {
-            // get a reference to the audio data and gain/pan of the current client
-            const CVector<int16_t>& vecsData = vecvecsData[j];
-            const double            dGain    = vecdGains[j];
-            const double            dPan     = vecdPannings[j];
+            iChanListVersion = ( iChanListVersion + 1 ) & 0xFFFF;
+        }
 
-            // calculate combined gain/pan for each stereo channel where we define
-            // the panning that center equals full gain for both channels
-            const double dGainL = MathUtils::GetLeftPan ( dPan, false ) * dGain;
-            const double dGainR = MathUtils::GetRightPan ( dPan, false ) * dGain;
+        // now send connected channels list to all connected clients (the
+        // messages are identical for all clients, each kind of message is
+        // only created once when it is needed the first time)
+        CProtBroadcastMes          FullListMes;
+        CProtBroadcastMes          DeltaListMes;
+        CProtBroadcastMes          LegacyListMes;
+        CVector<CProtBroadcastMes> vecFullListParts ( 0 );
+        CVector<CProtBroadcastMes> vecDeltaListParts ( 0 );
 
-            // if channel gain is 1, avoid multiplication for speed optimization
-            if ( ( dGainL == static_cast<double> ( 1.0 ) ) && ( dGainR == static_cast<double> ( 1.0 ) ) )
+        for ( int i = 0; i < iMaxNumChannels; i++ )
+        {
+            if ( vecChannels[i].IsConnected() )
             {
-                if ( vecNumAudioChannels[j] == 1 )
+                if ( vecChannels[i].GetPeerProtVersion() >= PROT_VERSION_SPLIT_CLIENT_LIST )
                 {
-                    // mono: copy same mono data in both out stereo audio channels
-                    for ( i = 0, k = 0; i < iServerFrameSizeSamples; i++, k += 2 )
+                    // the list is sent in parts which are not fragmented
+                    if ( !vecbyChanListSynced[i] )
                     {
-                        // left channel
-                        vecsOutData[k] = Double2Short (
-                            static_cast<double> ( vecsOutData[k] ) + vecsData[i] );
+                        if ( vecFullListParts.Size() == 0 )
+                        {
+                            CProtocol::PrepareConClientListDeltaMesParts ( iChanListVersion,
+                                                                           true,
+                                                                           vecChanInfo,
+                                                                           CVector<int> ( 0 ),
+                                                                           vecFullListParts );
+                        }
+
+                        for ( int j = 0; j < vecFullListParts.Size(); j++ )
+                        {
+                            vecChannels[i].SendBroadcastMes ( vecFullListParts[j] );
+                        }
 
-                        // right channel
-                        vecsOutData[k + 1] = Double2Short (
-                            static_cast<double> ( vecsOutData[k + 1] ) + vecsData[i] );
+                        vecbyChanListSynced[i] = 1;
                     }
-                }
-                else
-                {
-                    // stereo
-                    for ( i = 0; i < ( 2 * iServerFrameSizeSamples ); i++ )
+                    else if ( bListChanged )
                     {
-                        vecsOutData[i] = Double2Short (
-                            static_cast<double> ( vecsOutData[i] ) + vecsData[i] );
+                        if ( vecDeltaListParts.Size() == 0 )
+                        {
+                            CProtocol::PrepareConClientListDeltaMesParts ( iChanListVersion,
+                                                                           false,
+                                                                           vecChangedChanInfo,
+                                                                           veciLeftChanIDs,
+                                                                           vecDeltaListParts );
+                        }
+
+                        for ( int j = 0; j < vecDeltaListParts.Size(); j++ )
+                        {
+                            vecChannels[i].SendBroadcastMes ( vecDeltaListParts[j] );
+                        }
                     }
                 }
-            }
-            else
-            {
-                if ( vecNumAudioChannels[j] == 1 )
+                else if ( vecChannels[i].GetPeerProtVersion() >= PROT_VERSION_CLIENT_LIST_DELTA )
                 {
-                    // mono: copy same mono data in both out stereo audio channels
-                    for ( i = 0, k = 0; i < iServerFrameSizeSamples; i++, k += 2 )
+                    if ( !vecbyChanListSynced[i] )
+                    {
+                        // the client does not have the list yet
+                        if ( !FullListMes.IsValid() )
+                        {
+                            CProtocol::PrepareConClientListDeltaMes ( iChanListVersion,
+                                                                      true,
+                                                                      vecChanInfo,
+                                                                      CVector<int> ( 0 ),
+                                                                      FullListMes );
+                        }
+
+                        vecChannels[i].SendBroadcastMes ( FullListMes );
+
+                        vecbyChanListSynced[i] = 1;
+                    }
+                    else if ( bListChanged )
                     {
-                        // left/right channel
-                        vecsOutData[k]     = Double2Short ( vecsOutData[k] +     vecsData[i] * dGainL );
-                        vecsOutData[k + 1] = Double2Short ( vecsOutData[k + 1] + vecsData[i] * dGainR );
+                        // only send the changes
+                        if ( !DeltaListMes.IsValid() )
+                        {
+                            CProtocol::PrepareConClientListDeltaMes ( iChanListVersion,
+                                                                      false,
+                                                                      vecChangedChanInfo,
+                                                                      veciLeftChanIDs,
+                                                                      DeltaListMes );
+                        }
+
+                        vecChannels[i].SendBroadcastMes ( DeltaListMes );
                     }
                 }
                 else
                 {
-                    // stereo
-                    for ( i = 0; i < ( 2 * iServerFrameSizeSamples ); i += 2 )
+                    // send message
+                    if ( !LegacyListMes.IsValid() )
                     {
-                        // left/right channel
-                        vecsOutData[i]     = Double2Short ( vecsOutData[i] +     vecsData[i] *     dGainL );
-                        vecsOutData[i + 1] = Double2Short ( vecsOutData[i + 1] + vecsData[i + 1] * dGainR );
+                        CProtocol::PrepareConClientListMes ( vecChanInfo, LegacyListMes );
                     }
+
+                    vecChannels[i].SendBroadcastMes ( LegacyListMes );
                 }
             }
         }
     }
-}
-
-CVector<CChannelInfo> CServer::CreateChannelList()
-{
-    CVector<CChannelInfo> vecChanInfo ( 0 );
+    MutexChanList.unlock();
 
-    // look for free channels
-    for ( int i = 0; i < iMaxNumChannels; i++ )
+    // create status HTML file if enabled
+    if ( bWriteStatusHTMLFile )
     {
-        if ( vecChannels[i].IsConnected() )
-        {
-            // append channel ID, IP address and channel name to storing vectors
-            vecChanInfo.Add ( CChannelInfo (
-                i, // ID
-                QHostAddress ( QHostAddress::Null ).toIPv4Address(), // use invalid IP address (for privacy reason, #316)
-                vecChannels[i].GetChanInfo() ) );
-        }
+        WriteStatusFile();
     }
-
-    return vecChanInfo;
 }
 
-void CServer::CreateAndSendChanListForAllConChannels()
+void CServer::CreateAndSendChanListForThisChan ( const int iCurChanID )
 {
     // create channel list
     CVector<CChannelInfo> vecChanInfo ( CreateChannelList() );
 
-    // now send connected channels list to all connected clients
-    for ( int i = 0; i < iMaxNumChannels; i++ )
+    // now send connected channels list to the channel with the ID "iCurChanID"
+    if ( vecChannels[iCurChanID].GetPeerProtVersion() >= PROT_VERSION_CLIENT_LIST_DELTA )
     {
-        if ( vecChannels[i].IsConnected() )
+        MutexChanList.lock();
         {
-            // send message
-            vecChannels[i].CreateConClientListMes ( vecChanInfo );
+            // the list may contain changes which were not yet sent, this is
+            // no problem since the changes of the next version are applied on
+            // top of it
+            if ( vecChannels[iCurChanID].GetPeerProtVersion() >= PROT_VERSION_SPLIT_CLIENT_LIST )
+            {
+                CVector<CProtBroadcastMes> vecListParts;
+
+                CProtocol::PrepareConClientListDeltaMesParts ( iChanListVersion,
+                                                               true,
+                                                               vecChanInfo,
+                                                               CVector<int> ( 0 ),
+                                                               vecListParts );
+
+                for ( int i = 0; i < vecListParts.Size(); i++ )
+                {
+                    vecChannels[iCurChanID].SendBroadcastMes ( vecListParts[i] );
+                }
+            }
+            else
+            {
+                vecChannels[iCurChanID].CreateConClientListDeltaMes ( iChanListVersion,
+                                                                      true,
+                                                                      vecChanInfo,
+                                                                      CVector<int> ( 0 ) );
+            }
+
+            vecbyChanListSynced[iCurChanID] = 1;
         }
+        MutexChanList.unlock();
     }
-
-    // create status HTML file if enabled
-    if ( bWriteStatusHTMLFile )
+    else
     {
-        WriteHTMLChannelList();
+        vecChannels[iCurChanID].CreateConClientListMes ( vecChanInfo );
     }
 }
 
-void CServer::CreateAndSendChanListForThisChan ( const int iCurChanID )
-{
-    // create channel list
-    CVector<CChannelInfo> vecChanInfo ( CreateChannelList() );
-
-    // now send connected channels list to the channel with the ID "iCurChanID"
-    vecChannels[iCurChanID].CreateConClientListMes ( vecChanInfo );
-}
-
 void CServer::CreateAndSendChatTextForAllConChannels ( const int      iCurChanID,
                                                        const QString& strChatText )
 {
@@ -1339,12 +4859,16 @@ void CServer::CreateAndSendChatTextForAllConChannels ( const int      iCurChanID
 
 
     // Send chat text to all connected clients ---------------------------------
+    CProtBroadcastMes ChatTextMes;
+
+    CProtocol::PrepareChatTextMes ( strActualMessageText, ChatTextMes );
+
     for ( int i = 0; i < iMaxNumChannels; i++ )
     {
         if ( vecChannels[i].IsConnected() )
         {
             // send message
-            vecChannels[i].CreateChatTextMes ( strActualMessageText );
+            vecChannels[i].SendBroadcastMes ( ChatTextMes );
         }
     }
 }
@@ -1352,7 +4876,9 @@ void CServer::CreateAndSendChatTextForAllConChannels ( const int      iCurChanID
 void CServer::CreateAndSendRecorderStateForAllConChannels()
 {
     // get recorder state
-    ERecorderState eRecorderState = GetRecorderState();
+    CProtBroadcastMes RecorderStateMes;
+
+    CProtocol::PrepareRecorderStateMes ( GetRecorderState(), RecorderStateMes );
 
     // now send recorder state to all connected clients
     for ( int i = 0; i < iMaxNumChannels; i++ )
@@ -1360,7 +4886,49 @@ void CServer::CreateAndSendRecorderStateForAllConChannels()
         if ( vecChannels[i].IsConnected() )
         {
             // send message
-            vecChannels[i].CreateRecorderStateMes ( eRecorderState );
+            vecChannels[i].SendBroadcastMes ( RecorderStateMes );
+        }
+    }
+}
+
+bool CServer::CreateMixGroupList ( CVector<int>& vecMixGroups )
+{
+    bool bMixGroupUsed = false;
+
+    vecMixGroups.Init ( iMaxNumChannels, NO_MIX_GROUP );
+
+    for ( int i = 0; i < iMaxNumChannels; i++ )
+    {
+        if ( vecChannels[i].IsConnected() )
+        {
+            vecMixGroups[i] = vecChannels[i].IsSubStreamChannel() ?
+                vecChannels[vecChannels[i].GetSubStreamParent()].GetMixGroup() : vecChannels[i].GetMixGroup();
+
+            if ( vecMixGroups[i] != NO_MIX_GROUP )
+            {
+                bMixGroupUsed = true;
+            }
+        }
+    }
+
+    return bMixGroupUsed;
+}
+
+void CServer::CreateAndSendMixGroupListForAllConChannels()
+{
+    // the list is also sent if no channel is in a mix group anymore
+    CVector<int>      vecMixGroups;
+    CProtBroadcastMes MixGroupListMes;
+
+    CreateMixGroupList ( vecMixGroups );
+    CProtocol::PrepareMixGroupListMes ( vecMixGroups, MixGroupListMes );
+
+    for ( int i = 0; i < iMaxNumChannels; i++ )
+    {
+        if ( vecChannels[i].IsConnected() )
+        {
+            // send message
+            vecChannels[i].SendBroadcastMes ( MixGroupListMes );
         }
     }
 }
@@ -1430,76 +4998,148 @@ int CServer::GetNumberOfConnectedClients()
 
 int CServer::FindChannel ( const CHostAddress& CheckAddr )
 {
-    CHostAddress InetAddr;
-
-    // check for all possible channels if IP is already in use
-    for ( int i = 0; i < iMaxNumChannels; i++ )
+    // look up the channel in the address index (note that the index may still
+    // contain the address of a channel which is no longer connected or which
+    // is now used as a sub-stream channel)
+    const int iChanID = ChanAddrIndex.Find ( CheckAddr );
+
+    if ( ( iChanID != INVALID_CHANNEL_ID ) &&
+         vecChannels[iChanID].IsConnected() &&
+         !vecChannels[iChanID].IsSubStreamChannel() )
     {
-        // the "GetAddress" gives a valid address and returns true if the
-        // channel is connected
-        if ( vecChannels[i].GetAddress ( InetAddr ) )
-        {
-            // IP found, return channel number
-            if ( InetAddr == CheckAddr )
-            {
-                return i;
-            }
-        }
+        return iChanID;
     }
 
     // IP not found, return invalid ID
     return INVALID_CHANNEL_ID;
 }
 
-void CServer::OnProtcolMessageReceived ( int              iRecCounter,
-                                         int              iRecID,
-                                         CVector<uint8_t> vecbyMesBodyData,
-                                         CHostAddress     RecHostAddr )
+bool CServer::IsChannelAddress ( const int           iChanID,
+                                 const CHostAddress& Addr )
 {
-    Mutex.lock();
+    QMutexLocker locker ( &MutexChanTable );
+
+    return ( iChanID < iMaxNumChannels ) &&
+           vecChannels[iChanID].IsConnected() &&
+           ( vecChannels[iChanID].GetAddress() == Addr );
+}
+
+void CServer::OnProtcolMessageReceived ( int          iRecCounter,
+                                         int          iRecID,
+                                         CProtMessage MesBody,
+                                         CHostAddress RecHostAddr )
+{
+    // the protocol messages of the parent server belong to the cascade link
+    if ( Cascade.IsParentAddress ( RecHostAddr ) )
     {
-        // find the channel with the received address
-        const int iCurChanID = FindChannel ( RecHostAddr );
+        Cascade.PutProtcolData ( iRecCounter, iRecID, MesBody, RecHostAddr );
+        return;
+    }
 
-        // if the channel exists, apply the protocol message to the channel
-        if ( iCurChanID != INVALID_CHANNEL_ID )
-        {
-            vecChannels[iCurChanID].PutProtcolData ( iRecCounter,
-                                                     iRecID,
-                                                     vecbyMesBodyData,
-                                                     RecHostAddr );
-        }
+    // find the channel with the received address (only the look-up needs a
+    // lock, the server mutex is not taken so that the protocol never blocks
+    // the timer, the channel protects its state by its own mutexes and
+    // publishes the audio stream properties atomically)
+    MutexChanTable.lock();
+    const int iCurChanID = FindChannel ( RecHostAddr );
+    MutexChanTable.unlock();
+
+    // if the channel exists, apply the protocol message to the channel
+    if ( iCurChanID != INVALID_CHANNEL_ID )
+    {
+        vecChannels[iCurChanID].PutProtcolData ( iRecCounter,
+                                                 iRecID,
+                                                 MesBody,
+                                                 RecHostAddr );
     }
-    Mutex.unlock();
 }
 
 bool CServer::PutAudioData ( const CVector<uint8_t>& vecbyRecBuf,
                              const int               iNumBytesRead,
                              const CHostAddress&     HostAdr,
-                             int&                    iCurChanID )
+                             int&                    iCurChanID,
+                             const int               iChanIDHint,
+                             const int               iRecDelayNs )
 {
     bool bNewConnection = false; // init return value
     bool bChanOK        = true;  // init with ok, might be overwritten
 
-    Mutex.lock();
+    // the audio packets of the parent server belong to the cascade link and
+    // not to a channel of this server (note that INVALID_CHANNEL_ID would
+    // mean that the server is full)
+    if ( Cascade.IsParentAddress ( HostAdr ) )
+    {
+        Cascade.PutAudioData ( vecbyRecBuf, iNumBytesRead, HostAdr );
+        iCurChanID = INVALID_INDEX;
+        return false;
+    }
+
+    // Only the channel table mutex is used here and not the server mutex, i.e.
+    // the receive thread is never blocked by the timer processing. The jitter
+    // buffer and the connection state are protected by the channel itself.
+    MutexChanTable.lock();
     {
         // Get channel ID ------------------------------------------------------
-        // check address
-        iCurChanID = FindChannel ( HostAdr );
+        // a packet of a connected channel socket already gives the channel, the
+        // address is still checked since the socket may have received packets
+        // of other clients before it was connected
+        if ( ( iChanIDHint >= 0 ) &&
+             ( iChanIDHint < iMaxNumChannels ) &&
+             vecChannels[iChanIDHint].IsConnected() &&
+             !vecChannels[iChanIDHint].IsSubStreamChannel() &&
+             ( vecChannels[iChanIDHint].GetAddress() == HostAdr ) )
+        {
+            iCurChanID = iChanIDHint;
+        }
+        else
+        {
+            // check address
+            iCurChanID = FindChannel ( HostAdr );
+        }
 
         if ( iCurChanID == INVALID_CHANNEL_ID )
         {
-            // a new client is calling, look for free channel
-            iCurChanID = GetFreeChan();
+            // a new client is calling, look for free channel (the admission
+            // control may accept the client only as a listener or not at all
+            // if the processing of the server is close to its deadline)
+            const EServerAdmission eAdmission =
+                AdmissionControl.IsEnabled() ? AdmissionControl.GetAdmission ( GetNumberOfConnectedClients() ) : SA_ACCEPT;
+
+            AdmissionControl.CountAdmission ( eAdmission );
+
+            iCurChanID = ( eAdmission != SA_REJECT ) ? GetFreeChan() : INVALID_CHANNEL_ID;
 
             if ( iCurChanID != INVALID_CHANNEL_ID )
             {
+                // the buffers of an idle channel are released, they must exist
+                // before the first audio packet is put
+                vecChannels[iCurChanID].AllocateBuffers();
+
                 // initialize current channel by storing the calling host
-                // address
+                // address (and keep the address index in sync)
                 vecChannels[iCurChanID].SetAddress ( HostAdr );
+                ChanAddrIndex.Insert ( HostAdr, iCurChanID );
 
                 // reset channel info
                 vecChannels[iCurChanID].ResetInfo();
+                vecChannels[iCurChanID].ResetChannelLevelDelta();
+                vecChannels[iCurChanID].ResetRtt();
+                vecChannels[iCurChanID].ResetSubStreams();
+                vecChannels[iCurChanID].ResetListenerMode();
+                vecChannels[iCurChanID].ResetMixGroup();
+                vecChannels[iCurChanID].ResetMulticastStream();
+
+                if ( eAdmission == SA_LISTENER )
+                {
+                    vecChannels[iCurChanID].SetForcedListenerMode();
+                }
+
+                // the new client gets the complete clients list first
+                MutexChanList.lock();
+                {
+                    vecbyChanListSynced[iCurChanID] = 0;
+                }
+                MutexChanList.unlock();
 
                 // reset the channel gains of current channel, at the same
                 // time reset gains of this channel ID for all other channels
@@ -1523,26 +5163,160 @@ bool CServer::PutAudioData ( const CVector<uint8_t>& vecbyRecBuf,
         // Put received audio data in jitter buffer ----------------------------
         if ( bChanOK )
         {
-            // put packet in socket buffer
-            if ( vecChannels[iCurChanID].PutAudioData ( vecbyRecBuf,
-                                                        iNumBytesRead,
-                                                        HostAdr ) == PS_NEW_CONNECTION )
+            const int iNumSubStreams = vecChannels[iCurChanID].GetNumSubStreams();
+
+            if ( ( iNumSubStreams > 0 ) &&
+                 ( iNumBytesRead == ( iNumSubStreams + 1 ) * vecChannels[iCurChanID].GetNetwFrameSize() *
+                                    vecChannels[iCurChanID].GetNetwFrameSizeFact() ) )
             {
-                // in case we have a new connection return this information
-                bNewConnection = true;
+                // the packet contains the streams of the sub-stream channels
+                PutSubStreamAudioData ( iCurChanID, vecbyRecBuf, HostAdr, iRecDelayNs, bNewConnection );
+            }
+            else
+            {
+                // put packet in socket buffer
+                if ( vecChannels[iCurChanID].PutAudioData ( vecbyRecBuf,
+                                                            iNumBytesRead,
+                                                            HostAdr,
+                                                            iRecDelayNs ) == PS_NEW_CONNECTION )
+                {
+                    // in case we have a new connection return this information
+                    bNewConnection = true;
+                }
             }
         }
     }
-    Mutex.unlock();
+    MutexChanTable.unlock();
 
     // return the state if a new connection was happening
     return bNewConnection;
 }
 
+void CServer::PutSubStreamAudioData ( const int               iChanID,
+                                      const CVector<uint8_t>& vecbyRecBuf,
+                                      const CHostAddress&     HostAdr,
+                                      const int               iRecDelayNs,
+                                      bool&                   bNewConnection )
+{
+    CChannel& ParentChannel = vecChannels[iChanID];
+
+    const int iNumStreams    = ParentChannel.GetNumSubStreams() + 1;
+    const int iFrameSize     = ParentChannel.GetNetwFrameSize();
+    const int iNumFrames     = ParentChannel.GetNetwFrameSizeFact();
+    const int iStreamNumByte = iFrameSize * iNumFrames;
+
+    for ( int iStream = 0; iStream < iNumStreams; iStream++ )
+    {
+        // the first stream belongs to the parent channel
+        const int iStreamChanID = ( iStream == 0 ) ? iChanID : GetSubStreamChannel ( iChanID, iStream - 1 );
+
+        if ( iStreamChanID == INVALID_CHANNEL_ID )
+        {
+            // no free channel available for this sub-stream
+            continue;
+        }
+
+        // each frame of the packet contains the frames of all streams
+        for ( int iFrame = 0; iFrame < iNumFrames; iFrame++ )
+        {
+            const int iSrcPos = ( iFrame * iNumStreams + iStream ) * iFrameSize;
+
+            std::copy ( vecbyRecBuf.begin() + iSrcPos,
+                        vecbyRecBuf.begin() + iSrcPos + iFrameSize,
+                        vecbySubStreamPacket.begin() + iFrame * iFrameSize );
+        }
+
+        const EPutDataStat eStat = vecChannels[iStreamChanID].PutAudioData ( vecbySubStreamPacket,
+                                                                             iStreamNumByte,
+                                                                             HostAdr,
+                                                                             iRecDelayNs );
+
+        if ( eStat == PS_NEW_CONNECTION )
+        {
+            if ( iStream == 0 )
+            {
+                bNewConnection = true;
+            }
+            else
+            {
+                // the new sub-stream channel must be shown in the connected
+                // clients list (the event is handled by the main thread)
+                vecChannels[iStreamChanID].PostEvent ( CE_CHAN_INFO_CHANGED );
+            }
+        }
+    }
+}
+
+int CServer::GetSubStreamChannel ( const int iChanID,
+                                   const int iSubStreamIdx )
+{
+    CChannel& ParentChannel = vecChannels[iChanID];
+    int       iSubChanID    = ParentChannel.GetSubStreamChanID ( iSubStreamIdx );
+
+    // check if the sub-stream channel is still assigned to this sub-stream
+    if ( ( iSubChanID == INVALID_INDEX ) ||
+         !vecChannels[iSubChanID].IsConnected() ||
+         ( vecChannels[iSubChanID].GetSubStreamParent() != iChanID ) ||
+         ( vecChannels[iSubChanID].GetSubStreamIdx() != iSubStreamIdx ) )
+    {
+        // a sub-stream is a regular client for the admission control, a
+        // listener gets no sub-streams
+        const bool bAdmitted =
+            !ParentChannel.IsForcedListener() &&
+            ( !AdmissionControl.IsEnabled() ||
+              ( AdmissionControl.GetAdmission ( GetNumberOfConnectedClients() ) == SA_ACCEPT ) );
+
+        iSubChanID = bAdmitted ? GetFreeChan() : INVALID_CHANNEL_ID;
+
+        if ( iSubChanID == INVALID_CHANNEL_ID )
+        {
+            ParentChannel.SetSubStreamChanID ( iSubStreamIdx, INVALID_INDEX );
+            return INVALID_CHANNEL_ID;
+        }
+
+        // the sub-stream channel is not in the address index, all protocol
+        // messages of the client belong to the parent channel
+        vecChannels[iSubChanID].AllocateBuffers();
+        vecChannels[iSubChanID].SetAddress ( ParentChannel.GetAddress() );
+        vecChannels[iSubChanID].ResetInfo();
+        vecChannels[iSubChanID].ResetChannelLevelDelta();
+        vecChannels[iSubChanID].ResetRtt();
+        vecChannels[iSubChanID].ResetListenerMode();
+        vecChannels[iSubChanID].ResetMixGroup();
+        vecChannels[iSubChanID].ResetSubStreams();
+        vecChannels[iSubChanID].SetSubStreamParent ( iChanID, iSubStreamIdx );
+
+        // the sub-stream channel is listed in the mix group of its parent
+        if ( ParentChannel.GetMixGroup() != NO_MIX_GROUP )
+        {
+            vecChannels[iSubChanID].PostEvent ( CE_MIX_GROUP_CHANGED );
+        }
+
+        // reset the gains as for a new client
+        for ( int i = 0; i < iMaxNumChannels; i++ )
+        {
+            vecChannels[iSubChanID].SetGain ( i, 1.0 );
+            vecChannels[i].SetGain ( iSubChanID, 1.0 );
+        }
+
+        ParentChannel.SetSubStreamChanID ( iSubStreamIdx, iSubChanID );
+    }
+
+    // the sub-stream follows the codec settings of the client
+    if ( !vecChannels[iSubChanID].HasSubStreamProperties ( ParentChannel ) )
+    {
+        vecChannels[iSubChanID].SetSubStreamProperties ( ParentChannel );
+    }
+
+    return iSubChanID;
+}
+
 void CServer::GetConCliParam ( CVector<CHostAddress>& vecHostAddresses,
                                CVector<QString>&      vecsName,
                                CVector<int>&          veciJitBufNumFrames,
-                               CVector<int>&          veciNetwFrameSizeFact )
+                               CVector<int>&          veciNetwFrameSizeFact,
+                               CVector<int>&          veciRttMs,
+                               CVector<int>&          veciRttJitterMs )
 {
     CHostAddress InetAddr;
 
@@ -1551,6 +5325,8 @@ void CServer::GetConCliParam ( CVector<CHostAddress>& vecHostAddresses,
     vecsName.Init              ( iMaxNumChannels );
     veciJitBufNumFrames.Init   ( iMaxNumChannels );
     veciNetwFrameSizeFact.Init ( iMaxNumChannels );
+    veciRttMs.Init             ( iMaxNumChannels, -1 );
+    veciRttJitterMs.Init       ( iMaxNumChannels, -1 );
 
     // check all possible channels
     for ( int i = 0; i < iMaxNumChannels; i++ )
@@ -1559,13 +5335,49 @@ void CServer::GetConCliParam ( CVector<CHostAddress>& vecHostAddresses,
         {
             // get requested data
             vecHostAddresses[i]      = InetAddr;
-            vecsName[i]              = vecChannels[i].GetName();
+            vecsName[i]              = GetChannelName ( i );
             veciJitBufNumFrames[i]   = vecChannels[i].GetSockBufNumFrames();
             veciNetwFrameSizeFact[i] = vecChannels[i].GetNetwFrameSizeFact();
+            veciRttMs[i]             = vecChannels[i].GetRttMs();
+            veciRttJitterMs[i]       = vecChannels[i].GetRttJitterMs();
+        }
+    }
+}
+
+void CServer::GetConCliNetStats ( CVector<CChannelNetStats>& vecNetStats )
+{
+    vecNetStats.Init ( iMaxNumChannels );
+
+    for ( int i = 0; i < iMaxNumChannels; i++ )
+    {
+        if ( vecChannels[i].IsConnected() )
+        {
+            vecChannels[i].GetNetStats ( vecNetStats[i] );
         }
     }
 }
 
+bool CServer::GetChannelMetrics ( const int         iChanID,
+                                  CChannelNetStats& NetStats,
+                                  int&              iRttMs,
+                                  int&              iRttJitterMs,
+                                  int&              iJitBufNumFrames ) const
+{
+    if ( !vecChannels[iChanID].IsConnected() )
+    {
+        return false;
+    }
+
+    // all values are read from atomic counters or single integers
+    vecChannels[iChanID].GetNetStats ( NetStats );
+
+    iRttMs           = vecChannels[iChanID].GetRttMs();
+    iRttJitterMs     = vecChannels[iChanID].GetRttJitterMs();
+    iJitBufNumFrames = vecChannels[iChanID].GetSockBufNumFrames();
+
+    return true;
+}
+
 void CServer::StartStatusHTMLFileWriting ( const QString& strNewFileName,
                                            const QString& strNewServerNameWithPort )
 {
@@ -1576,21 +5388,31 @@ void CServer::StartStatusHTMLFileWriting ( const QString& strNewFileName,
     // set flag
     bWriteStatusHTMLFile = true;
 
+    // the file is written by the status writer thread
+    StatusWriter.Start ( strServerHTMLFileListName );
+
     // write initial file
-    WriteHTMLChannelList();
+    WriteStatusFile();
 }
 
-void CServer::WriteHTMLChannelList()
+void CServer::WriteStatusFile()
 {
-    // prepare file and stream
-    QFile serverFileListFile ( strServerHTMLFileListName );
-
-    if ( !serverFileListFile.open ( QIODevice::WriteOnly | QIODevice::Text ) )
+    // the writer only writes the file if the status has changed
+    if ( StatusWriter.IsJson() )
     {
-        return;
+        StatusWriter.Put ( CreateJsonChannelList() );
+    }
+    else
+    {
+        StatusWriter.Put ( CreateHTMLChannelList() );
     }
+}
 
-    QTextStream streamFileOut ( &serverFileListFile );
+QByteArray CServer::CreateHTMLChannelList()
+{
+    // prepare stream
+    QString     strFileOut;
+    QTextStream streamFileOut ( &strFileOut );
     streamFileOut << strServerNameWithPort.toHtmlEscaped() << endl << "<ul>" << endl;
 
     // depending on number of connected clients write list
@@ -1606,40 +5428,89 @@ void CServer::WriteHTMLChannelList()
         {
             if ( vecChannels[i].IsConnected() )
             {
-                streamFileOut << "  <li>" << vecChannels[i].GetName().toHtmlEscaped() << "</li>" << endl;
+                streamFileOut << "  <li>" << GetChannelName ( i ).toHtmlEscaped();
+
+                // the round trip time is only known for clients which answer
+                // the round trip time measurement
+                const int iRttMs = vecChannels[i].GetRttMs();
+
+                if ( iRttMs >= 0 )
+                {
+                    streamFileOut << " (" << iRttMs << " &plusmn; " <<
+                        vecChannels[i].GetRttJitterMs() << " ms)";
+                }
+
+                // lost frames relative to all frames taken out of the jitter buffer
+                CChannelNetStats NetStats;
+                vecChannels[i].GetNetStats ( NetStats );
+
+                if ( NetStats.iNumReceived > 0 )
+                {
+                    streamFileOut << " [" << QString::number ( 100.0 * NetStats.iNumLost /
+                        ( NetStats.iNumReceived + NetStats.iNumLost ), 'f', 1 ) << " % lost]";
+                }
+
+                streamFileOut << "</li>" << endl;
             }
         }
     }
 
     // finish list
     streamFileOut << "</ul>" << endl;
+
+    return strFileOut.toUtf8();
 }
 
-void CServer::customEvent ( QEvent* pEvent )
+QByteArray CServer::CreateJsonChannelList()
 {
-    if ( pEvent->type() == QEvent::User + 11 )
-    {
-        const int iMessType = ( (CCustomEvent*) pEvent )->iMessType;
+    QJsonArray ClientArray;
 
-        switch ( iMessType )
+    // same contents as in the HTML status file
+    for ( int i = 0; i < iMaxNumChannels; i++ )
+    {
+        if ( vecChannels[i].IsConnected() )
         {
-        case MS_PACKET_RECEIVED:
-            // wake up the server if a packet was received
-            // if the server is still running, the call to Start() will have
-            // no effect
-            Start();
-            break;
+            QJsonObject Client;
+            Client["name"] = GetChannelName ( i );
+
+            // the round trip time is only known for clients which answer
+            // the round trip time measurement
+            const int iRttMs = vecChannels[i].GetRttMs();
+
+            if ( iRttMs >= 0 )
+            {
+                Client["rttMs"]       = iRttMs;
+                Client["rttJitterMs"] = vecChannels[i].GetRttJitterMs();
+            }
+
+            // lost frames relative to all frames taken out of the jitter buffer
+            CChannelNetStats NetStats;
+            vecChannels[i].GetNetStats ( NetStats );
+
+            if ( NetStats.iNumReceived > 0 )
+            {
+                Client["lostPercent"] = qRound ( 1000.0 * NetStats.iNumLost /
+                    ( NetStats.iNumReceived + NetStats.iNumLost ) ) / 10.0;
+            }
+
+            ClientArray.append ( Client );
         }
     }
+
+    QJsonObject Status;
+    Status["server"]     = strServerNameWithPort;
+    Status["numClients"] = ClientArray.size();
+    Status["clients"]    = ClientArray;
+
+    return QJsonDocument ( Status ).toJson();
 }
 
 /// @brief Compute frame peak level for each client
-bool CServer::CreateLevelsForAllConChannels ( const int                        iNumClients,
-                                              const CVector<int>&              vecNumAudioChannels,
-                                              const CVector<CVector<int16_t> > vecvecsData,
-                                              CVector<uint16_t>&               vecLevelsOut )
+bool CServer::CreateLevelsForAllConChannels ( const int             iNumClients,
+                                              const CVector<float>& vecfPeaks,
+                                              CVector<uint16_t>&    vecLevelsOut )
 {
-    int  i, j, k;
+    int  j;
     bool bLevelsWereUpdated = false;
 
     // low frequency updates
@@ -1653,28 +5524,8 @@ bool CServer::CreateLevelsForAllConChannels ( const int                        i
 
         for ( j = 0; j < iNumClients; j++ )
         {
-            // get a reference to the audio data
-            const CVector<int16_t>& vecsData = vecvecsData[j];
-
-            double dCurLevel = 0.0;
-
-            if ( vecNumAudioChannels[j] == 1 )
-            {
-                // mono
-                for ( i = 0; i < iServerFrameSizeSamples; i += 3 )
-                {
-                    dCurLevel = std::max ( dCurLevel, fabs ( static_cast<double> ( vecsData[i] ) ) );
-                }
-            }
-            else
-            {
-                // stereo: apply stereo-to-mono attenuation
-                for ( i = 0, k = 0; i < iServerFrameSizeSamples; i += 3, k += 6 )
-                {
-                    double sMix = ( static_cast<double> ( vecsData[k] ) + vecsData[k + 1] ) / 2;
-                    dCurLevel   = std::max ( dCurLevel, fabs ( sMix ) );
-                }
-            }
+            // peak value of the mono down-mix (measured in the decode stage)
+            double dCurLevel = static_cast<double> ( vecfPeaks[j] );
 
             // smoothing
             const int iChId = vecChanIDsCurConChan[j];
@@ -29,7 +29,19 @@
 #include <QDateTime>
 #include <QHostAddress>
 #include <QFileInfo>
+#include <QThread>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <algorithm>
+#include <functional>
+#include <memory>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
 #ifdef USE_OPUS_SHARED_LIB
 # include "opus/opus_custom.h"
 #else
@@ -37,12 +49,21 @@
 #endif
 #include "global.h"
 #include "buffer.h"
+#include "mixkernel.h"
 #include "signalhandler.h"
 #include "socket.h"
 #include "channel.h"
+#include "encoderprofile.h"
 #include "util.h"
 #include "serverlogging.h"
 #include "serverlist.h"
+#include "serverfx.h"
+#include "servermetrics.h"
+#include "streamoutput.h"
+#include "servercascade.h"
+#include "serverstatus.h"
+#include "packetcapture.h"
+#include "relay.h"
 #include "recorder/jamrecorder.h"
 
 
@@ -50,9 +71,89 @@
 // no valid channel number
 #define INVALID_CHANNEL_ID                  ( MAX_NUM_CHANNELS + 1 )
 
+// maximum number of threads which can be used for the server audio processing
+#define MAX_NUM_SERVER_THREADS              64
+
+// maximum number of additional rooms of the multi-room mode (each room is a
+// server on its own port)
+#define MAX_NUM_SERVER_ROOMS                64
+
+// largest frame size of the audio codecs and maximum number of coded blocks
+// per channel and server frame (i.e. the largest ratio of the server frame size
+// and the codec frame size, two OPUS64 blocks are needed if the double system
+// frame size is used)
+#define MAX_CODEC_FRAME_SIZE_SAMPLES        DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES
+#define MAX_NUM_FRAME_SIZE_CONV_BLOCKS      2
+
+// a client whose mix was changed does not join a group of clients with an
+// identical mix before its mix was unchanged for this time
+#define SERVER_MIX_GROUP_HOLD_TIME_MS       1000 // ms
+
+// the gains of the mixes follow the gains set by the clients with a first
+// order smoothing (time constant), the gain is set to its target value if
+// the difference is below the threshold (about -80 dB)
+#define SERVER_GAIN_SMOOTHING_TIME_MS       10 // ms
+#define SERVER_GAIN_SMOOTHING_THRESHOLD     0.0001f
+
+// a channel whose peak value (int16 scale, about -72 dBFS) was below the
+// threshold for the hold time is silent and is not mixed
+#define SERVER_SILENCE_THRESHOLD            8.0f
+#define SERVER_SILENCE_HOLD_TIME_MS         200 // ms
+
+// number of frames of a silent mix which are still encoded (they contain the
+// tail of the previous signal and bring the encoder in its silence state)
+#define SERVER_SILENT_MIX_NUM_ENCODED       4
+
+// size of the address to channel hash table (must be a power of two and
+// should be much larger than the maximum number of channels)
+#define CHAN_ADDR_INDEX_SIZE                1024
+
+// interval for reporting the frame timing statistics on the console
+#define SERVER_TIMING_STATS_INTERVAL_S      60 // seconds
+
+// the overload level is increased if a frame used more than its deadline and it
+// is decreased if the usage stayed below the lower bound for the recovery time
+#define SERVER_OVERLOAD_USAGE_HIGH          1.0
+#define SERVER_OVERLOAD_USAGE_LOW           0.75
+#define SERVER_OVERLOAD_RECOVERY_TIME_S     1 // seconds
+
+// admission control: a new client is accepted if the estimated usage of the
+// frame deadline with the new client stays below the limit, a listener is
+// assumed to need this fraction of the processing of a regular client (the
+// processing time per client is averaged with the given time constant)
+#define SERVER_ADMISSION_USAGE_MAX          0.7
+#define SERVER_ADMISSION_LISTENER_COST      0.5
+#define SERVER_ADMISSION_TIME_CONST_S       5 // seconds
+
+// with pacing, the audio packets of a frame are spread over this part of the
+// frame interval (the last packet leaves well before the next frame)
+#define SERVER_PACING_WINDOW_PERCENT        50
+
+// weight of the IIR filter of the average frame processing time which is
+// reported to the latency probes of the clients (time constant of 1000 frames)
+#define SERVER_PROC_TIME_IIR_WEIGHT         0.999
+
+// weight of the IIR filter of the measured processing time of a channel which
+// is used for the assignment of the channels to the worker threads
+#define SERVER_CHAN_COST_IIR_WEIGHT         0.99
+
+// number of histogram bins per octave (i.e. per doubling of the time) and the
+// total number of bins of the frame stage profiler (covers up to 2^32 ns)
+#define PROFILER_NUM_BINS_PER_OCTAVE        4
+#define PROFILER_NUM_BINS                   ( 32 * PROFILER_NUM_BINS_PER_OCTAVE )
+
+// interval in which the server timer publishes the metrics snapshot for the
+// metrics exporter
+#define SERVER_METRICS_SNAPSHOT_INTERVAL_MS 1000 // ms
+
+// alignment of the rows of the frame arena (cache line size, also sufficient
+// for the widest vector registers which are used by the mixing kernels)
+#define SERVER_FRAME_ARENA_ALIGNMENT        64 // bytes
+
 
 /* Classes ********************************************************************/
 #if ( defined ( WIN32 ) || defined ( _WIN32 ) )
+# include <mmsystem.h>
 // using QTimer for Windows
 class CHighPrecisionTimer : public QObject
 {
@@ -65,6 +166,13 @@ public:
     void Stop();
     bool isActive() const { return Timer.isActive(); }
 
+    // the Qt timer must be controlled by its own thread, therefore the idle
+    // mode stops the timer and a wake-up (which may be requested by any
+    // thread) is queued
+    void StartIdle() {}
+    void Sleep() { Stop(); }
+    void Wake() { emit wakeRequested(); }
+
 protected:
     QTimer       Timer;
     CVector<int> veciTimeOutIntervals;
@@ -77,6 +185,7 @@ public slots:
 
 signals:
     void timeout();
+    void wakeRequested();
 };
 #else
 // using mach timers for Mac and nanosleep for Linux
@@ -86,6 +195,11 @@ signals:
 #  include <mach/mach_time.h>
 # else
 #  include <sys/time.h>
+#  include <sys/timerfd.h>
+#  include <unistd.h>
+#  include <cerrno>
+#  include <pthread.h>
+#  include <sched.h>
 # endif
 
 class CHighPrecisionTimer : public QThread
@@ -94,15 +208,36 @@ class CHighPrecisionTimer : public QThread
 
 public:
     CHighPrecisionTimer ( const bool bUseDoubleSystemFrameSize );
+    virtual ~CHighPrecisionTimer() { Stop(); }
 
     void Start();
     void Stop();
-    bool isActive() { return bRun; }
+    bool isActive() { return bRun && ( iIdle.loadAcquire() == 0 ); }
+
+    // In the idle mode the timer thread stays alive but waits without using
+    // CPU until it is woken up. Wake() may be called by any thread (e.g. by
+    // the socket thread if a packet was received), the first tick is then
+    // fired immediately by the timer thread (no thread start and no event of
+    // the main event loop is required).
+    void StartIdle();
+    void Sleep() { iIdle.storeRelease ( 1 ); }
+    void Wake();
 
 protected:
     virtual void run();
 
-    bool bRun;
+    void StartThread();
+    void SetInitialEndTime();
+    bool WaitWhileIdle();
+
+# if !defined ( __APPLE__ ) && !defined ( __MACOSX )
+    void RunTimerFd ( const int iTimerFd );
+    void RunNanoSleep();
+# endif
+
+    bool       bRun;
+    QAtomicInt iIdle;
+    QSemaphore WakeSem;
 
 # if defined ( __APPLE__ ) || defined ( __MACOSX )
     uint64_t Delay;
@@ -118,51 +253,874 @@ signals:
 #endif
 
 
-template<unsigned int slotId>
-class CServerSlots : public CServerSlots<slotId - 1>
+// Worker thread pool for the server audio processing ------------------------
+// The worker threads are created once on server startup and live for the
+// entire life time of the server so that we do not have any thread
+// creation/destruction overhead in the time-critical timer routine (this
+// overhead was the problem with the OMP implementation). The calling thread
+// always takes part in the processing and the Run() function returns only if
+// all items of the current frame are processed (frame barrier). The items are
+// either handed out dynamically or each item is processed by a fixed thread
+// (thread 0 is the calling thread, the workers are the threads 1 to N).
+class CServerWorkerPool
 {
 public:
-    void OnSendProtMessCh ( CVector<uint8_t> mess ) { SendProtMessage ( slotId - 1,  mess ); }
-    void OnReqConnClientsListCh()  { CreateAndSendChanListForThisChan ( slotId - 1 ); }
+    CServerWorkerPool() : iNumWorkers ( 0 ), pJob ( nullptr ), iNumItems ( 0 ), piItemThread ( nullptr ) {}
+    virtual ~CServerWorkerPool() { Stop(); }
+
+    void Start ( const int iNewNumThreads );
+    void Stop();
+
+    // number of threads including the calling thread
+    int GetNumThreads() const { return iNumWorkers + 1; }
+
+    // if piNewItemThread is given, it contains the thread of each item
+    void Run ( const std::function<void ( const int )>& fJob,
+               const int                                iNewNumItems,
+               const int*                               piNewItemThread = nullptr );
 
-    void OnChatTextReceivedCh ( QString strChatText )
+protected:
+    class CWorkerThread : public QThread
     {
-        CreateAndSendChatTextForAllConChannels ( slotId - 1, strChatText );
+    public:
+        CWorkerThread ( CServerWorkerPool* pNPool, const int iNWorkerIdx ) :
+            pPool ( pNPool ), iWorkerIdx ( iNWorkerIdx ), bRun ( true ) {}
+
+        void Stop()
+        {
+            // leave the main loop and wake up the thread
+            bRun = false;
+            StartSem.release();
+
+            // give thread some time to terminate
+            wait ( 5000 );
+        }
+
+        QSemaphore StartSem;
+
+    protected:
+        virtual void run();
+
+        CServerWorkerPool* pPool;
+        int                iWorkerIdx;
+        volatile bool      bRun;
+    };
+
+    void ProcessItems ( const int iThreadIdx );
+
+    CVector<CWorkerThread*>                  vecpWorkers;
+    int                                      iNumWorkers;
+    QSemaphore                               DoneSem;
+    QAtomicInt                               iNextItem;
+    const std::function<void ( const int )>* pJob;
+    int                                      iNumItems;
+    const int*                               piItemThread;
+};
+
+
+// Server timing statistics ----------------------------------------------------
+// measures how much of the real-time deadline (i.e. the duration of one server
+// frame) is used by the processing of the timer routine
+class CServerTimingStats
+{
+public:
+    CServerTimingStats() :
+        dFrameDurationNs     ( 1 ),
+        iTotalNumFrames      ( 0 ),
+        iTotalNumOverruns    ( 0 ),
+        iTotalNumMissedTicks ( 0 ),
+        dTotalUsageSum       ( 0 ),
+        iLastTickNs          ( -1 ) { Reset(); }
+
+    void Init ( const int iFrameSizeSamples )
+    {
+        dFrameDurationNs = static_cast<double> ( iFrameSizeSamples ) * 1000000000 /
+            SYSTEM_SAMPLE_RATE_HZ;
+
+        Reset();
     }
 
-    void OnMuteStateHasChangedCh ( int iChanID, bool bIsMuted )
+    void Reset()
     {
-        CreateOtherMuteStateChanged ( slotId - 1, iChanID, bIsMuted );
+        dUsageSum       = 0;
+        dUsageMax       = 0;
+        iNumFrames      = 0;
+        iNumOverruns    = 0;
+        dTickJitterSum  = 0;
+        dTickJitterMax  = 0;
+        iNumTicks       = 0;
+        iNumMissedTicks = 0;
     }
 
-    void OnServerAutoSockBufSizeChangeCh ( int iNNumFra )
+    // the tick time is the start time of the timer routine on a continuously
+    // running clock, the jitter is the deviation of the tick interval from
+    // the frame duration (note that the tick reference is not reset)
+    void UpdateTick ( const qint64 iTickNs )
     {
-        CreateAndSendJitBufMessage ( slotId - 1, iNNumFra );
+        if ( iLastTickNs >= 0 )
+        {
+            const double dIntervalNs = static_cast<double> ( iTickNs - iLastTickNs );
+            const double dJitterNs   = std::abs ( dIntervalNs - dFrameDurationNs );
+
+            dTickJitterSum += dJitterNs;
+            dTickJitterMax  = std::max ( dTickJitterMax, dJitterNs );
+            iNumTicks++;
+
+            // if the interval is longer than one and a half frames, at least
+            // one deadline was missed (the timer delivers the missed ticks
+            // afterwards)
+            if ( dIntervalNs > 1.5 * dFrameDurationNs )
+            {
+                const int iNumMissed = static_cast<int> ( dIntervalNs / dFrameDurationNs + 0.5 ) - 1;
+
+                iNumMissedTicks      += iNumMissed;
+                iTotalNumMissedTicks += iNumMissed;
+            }
+        }
+
+        iLastTickNs = iTickNs;
+    }
+
+    // must be called if the timer was stopped in between
+    void ResetTick() { iLastTickNs = -1; }
+
+    // usage of the deadline as a ratio (1.0 means the entire frame duration
+    // was required for processing)
+    double GetUsage ( const qint64 iProcTimeNs ) const
+    {
+        return static_cast<double> ( iProcTimeNs ) / dFrameDurationNs;
+    }
+
+    void Update ( const qint64 iProcTimeNs )
+    {
+        const double dUsage = GetUsage ( iProcTimeNs );
+
+        dUsageSum      += dUsage;
+        dUsageMax       = std::max ( dUsageMax, dUsage );
+        dTotalUsageSum += dUsage;
+        iNumFrames++;
+        iTotalNumFrames++;
+
+        if ( dUsage > 1.0 )
+        {
+            iNumOverruns++;
+            iTotalNumOverruns++;
+        }
     }
 
+    int    GetNumFrames() const   { return iNumFrames; }
+    int    GetNumOverruns() const { return iNumOverruns; }
+    double GetUsageMax() const    { return dUsageMax; }
+    double GetUsageAv() const     { return iNumFrames > 0 ? dUsageSum / iNumFrames : 0; }
+
+    int    GetNumMissedTicks() const { return iNumMissedTicks; }
+    double GetTickJitterMaxUs() const { return dTickJitterMax / 1000; }
+    double GetTickJitterAvUs() const  { return iNumTicks > 0 ? dTickJitterSum / iNumTicks / 1000 : 0; }
+
+    // totals since the server was started (not affected by Reset())
+    qint64 GetTotalNumFrames() const      { return iTotalNumFrames; }
+    qint64 GetTotalNumOverruns() const    { return iTotalNumOverruns; }
+    qint64 GetTotalNumMissedTicks() const { return iTotalNumMissedTicks; }
+    double GetTotalUsageSum() const       { return dTotalUsageSum; }
+
 protected:
-    virtual void SendProtMessage ( int              iChID,
-                                   CVector<uint8_t> vecMessage ) = 0;
+    double dFrameDurationNs;
+    double dUsageSum;
+    double dUsageMax;
+    int    iNumFrames;
+    int    iNumOverruns;
+    double dTickJitterSum;
+    double dTickJitterMax;
+    int    iNumTicks;
+    int    iNumMissedTicks;
+    qint64 iTotalNumFrames;
+    qint64 iTotalNumOverruns;
+    qint64 iTotalNumMissedTicks;
+    double dTotalUsageSum;
+    qint64 iLastTickNs;
+};
 
-    virtual void CreateAndSendChanListForThisChan ( const int iCurChanID ) = 0;
 
-    virtual void CreateAndSendChatTextForAllConChannels ( const int      iCurChanID,
-                                                          const QString& strChatText ) = 0;
+// Frame stage profiler --------------------------------------------------------
+// measures the durations of the processing stages of the server timer routine
+// and stores them in histograms with logarithmic bins (about 19 % resolution)
+// so that the percentiles can be evaluated without storing all measurements
+enum EServerFrameStage
+{
+    FS_COLLECT,    // locked collection of the channel properties and data
+    FS_DECODE,     // decoding of all clients
+    FS_COMMON_MIX, // calculation of the common mix
+    FS_LEVELS,     // level meter calculation
+    FS_MIX_ENCODE, // mix, encode and queue the packets of all clients
+    FS_SEND,       // send all queued packets
+    NUM_SERVER_FRAME_STAGES
+};
 
-    virtual void CreateOtherMuteStateChanged ( const int  iCurChanID,
-                                               const int  iOtherChanID,
-                                               const bool bIsMuted ) = 0;
+class CServerFrameProfiler
+{
+public:
+    CServerFrameProfiler() : bEnabled ( false ), iLastMarkNs ( 0 ) { Reset(); }
 
-    virtual void CreateAndSendJitBufMessage ( const int iCurChanID,
-                                              const int iNNumFra ) = 0;
+    void SetEnabled ( const bool bNEnabled ) { bEnabled = bNEnabled; }
+    bool IsEnabled() const { return bEnabled; }
+
+    void Reset();
+
+    // the times are relative to the start of the frame processing
+    void StartFrame ( const int iNumClients )
+    {
+        if ( bEnabled )
+        {
+            iLastMarkNs = 0;
+            iClientsSum += iNumClients;
+            iNumFrames++;
+        }
+    }
+
+    // marks the end of the given stage (the stage starts at the previous mark)
+    void EndStage ( const EServerFrameStage eStage,
+                    const qint64            iCurTimeNs )
+    {
+        if ( bEnabled )
+        {
+            AddValue ( eStage, iCurTimeNs - iLastMarkNs );
+            iLastMarkNs = iCurTimeNs;
+        }
+    }
+
+    QString GetReport() const;
+
+    void GetStageDurationsUs ( const EServerFrameStage eStage,
+                               double&                 dP50Us,
+                               double&                 dP99Us,
+                               double&                 dMaxUs ) const;
+
+protected:
+    void   AddValue ( const EServerFrameStage eStage, const qint64 iDurationNs );
+    double GetPercentileUs ( const EServerFrameStage eStage, const double dPercentile ) const;
+
+    bool   bEnabled;
+    qint64 iLastMarkNs;
+    qint64 iClientsSum;
+    int    iNumFrames;
+    int    iNumValues[NUM_SERVER_FRAME_STAGES];
+    qint64 iMaxNs[NUM_SERVER_FRAME_STAGES];
+    int    iBins[NUM_SERVER_FRAME_STAGES][PROFILER_NUM_BINS];
 };
 
-template<>
-class CServerSlots<0> {};
 
-class CServer :
-        public QObject,
-        public CServerSlots<MAX_NUM_CHANNELS>
+// Server overload control -----------------------------------------------------
+// Events which occur while the timer collects the channel data. They are queued
+// and only dispatched after the audio packets of the frame were sent so that
+// the real-time part of the frame never waits for them.
+enum EServerTickEvent
+{
+    TE_CHAN_DISCONNECTED // the channel is now disconnected (recorder, channel list)
+};
+
+struct SServerTickEvent
+{
+    EServerTickEvent eEvent;
+    int              iChanID;
+};
+
+// If the processing of the frames does not fit in the deadline anymore, the
+// server reduces its work in a defined order (each level includes the actions
+// of the previous levels). The number of frames in which the actions were
+// applied is counted for the statistics.
+enum EServerOverloadLevel
+{
+    OL_NONE           = 0, // normal processing
+    OL_SKIP_LEVELS    = 1, // no level meter calculation
+    OL_LOW_COMPLEXITY = 2, // lowest OPUS encoder complexity
+    OL_SKIP_RECORDING = 3  // the audio is not exported for recording
+};
+
+class CServerOverloadControl
+{
+public:
+    CServerOverloadControl() : iRecoveryFrames ( 1 ) { Init ( SYSTEM_FRAME_SIZE_SAMPLES ); }
+
+    void Init ( const int iFrameSizeSamples )
+    {
+        iRecoveryFrames    = SERVER_OVERLOAD_RECOVERY_TIME_S * SYSTEM_SAMPLE_RATE_HZ / iFrameSizeSamples;
+        eLevel             = OL_NONE;
+        iNumLowUsageFrames = 0;
+
+        Reset();
+    }
+
+    // resets the statistics only
+    void Reset()
+    {
+        iNumSkipLevelsFrames    = 0;
+        iNumLowComplexityFrames = 0;
+        iNumSkipRecordingFrames = 0;
+    }
+
+    // must be called after the processing of each frame with the used ratio
+    // of the frame deadline
+    void Update ( const double dUsage );
+
+    bool SkipLevels() const        { return eLevel >= OL_SKIP_LEVELS; }
+    bool LowEncoderComplexity() const { return eLevel >= OL_LOW_COMPLEXITY; }
+    bool SkipRecording() const     { return eLevel >= OL_SKIP_RECORDING; }
+
+    int GetNumSkipLevelsFrames() const    { return iNumSkipLevelsFrames; }
+    int GetNumLowComplexityFrames() const { return iNumLowComplexityFrames; }
+    int GetNumSkipRecordingFrames() const { return iNumSkipRecordingFrames; }
+
+    EServerOverloadLevel GetLevel() const { return eLevel; }
+
+protected:
+    EServerOverloadLevel eLevel;
+    int                  iRecoveryFrames;
+    int                  iNumLowUsageFrames;
+    int                  iNumSkipLevelsFrames;
+    int                  iNumLowComplexityFrames;
+    int                  iNumSkipRecordingFrames;
+};
+
+
+// Server admission control ----------------------------------------------------
+// Decides if a new client can be accepted with the measured processing time per
+// client instead of only the fixed maximum number of channels. If there is no
+// headroom for a regular client, the client may still be accepted as a
+// listener (its audio is not decoded and not mixed). The processing time is
+// updated by the timer, the decision is taken by the receive thread.
+enum EServerAdmission
+{
+    SA_ACCEPT   = 0, // regular client
+    SA_LISTENER = 1, // the client is only accepted as a listener
+    SA_REJECT   = 2  // no headroom, the server is full
+};
+
+class CServerAdmissionControl
+{
+public:
+    CServerAdmissionControl() : bEnabled ( false ) { Init ( SYSTEM_FRAME_SIZE_SAMPLES ); }
+
+    void Init ( const int iFrameSizeSamples )
+    {
+        dAvFactor = static_cast<double> ( iFrameSizeSamples ) /
+            ( SERVER_ADMISSION_TIME_CONST_S * SYSTEM_SAMPLE_RATE_HZ );
+
+        dUsagePerClient = 0;
+        iUsagePerClientPpm.storeRelease ( 0 );
+
+        Reset();
+    }
+
+    void SetEnabled ( const bool bNEnabled ) { bEnabled = bNEnabled; }
+    bool IsEnabled() const { return bEnabled; }
+
+    // resets the statistics only
+    void Reset()
+    {
+        iNumListenerAdmissions.storeRelease ( 0 );
+        iNumRejections.storeRelease ( 0 );
+    }
+
+    // must be called by the timer after the processing of each frame with the
+    // used ratio of the frame deadline and the number of processed clients
+    void Update ( const double dUsage,
+                  const int    iNumClients );
+
+    // decision for a new client if the given number of channels (including the
+    // sub-stream channels) is connected
+    EServerAdmission GetAdmission ( const int iNumConnectedChannels ) const;
+
+    // counts the decisions for the statistics
+    void CountAdmission ( const EServerAdmission eAdmission )
+    {
+        if ( eAdmission == SA_LISTENER )
+        {
+            iNumListenerAdmissions.ref();
+        }
+        else if ( eAdmission == SA_REJECT )
+        {
+            iNumRejections.ref();
+        }
+    }
+
+    int GetNumListenerAdmissions() const { return iNumListenerAdmissions.loadAcquire(); }
+    int GetNumRejections() const         { return iNumRejections.loadAcquire(); }
+
+protected:
+    bool       bEnabled;
+    double     dAvFactor;
+    double     dUsagePerClient;
+
+    // the averaged usage per client in millionths of the deadline (published
+    // for the receive thread)
+    QAtomicInt iUsagePerClientPpm;
+
+    QAtomicInt iNumListenerAdmissions;
+    QAtomicInt iNumRejections;
+};
+
+
+// Metrics snapshot ------------------------------------------------------------
+// state of the audio processing for the metrics exporter, it is published by
+// the server timer so that the exporter never reads the timing statistics
+// while they are updated
+class CServerMetricsSnapshot
+{
+public:
+    CServerMetricsSnapshot() :
+        iNumFrames       ( 0 ),
+        iNumOverruns     ( 0 ),
+        iNumMissedTicks  ( 0 ),
+        dUsageSum        ( 0 ),
+        dUsageMax        ( 0 ),
+        dTickJitterMaxUs ( 0 ),
+        iOverloadLevel   ( OL_NONE ),
+        bProfileValid    ( false )
+    {
+        for ( int iS = 0; iS < NUM_SERVER_FRAME_STAGES; iS++ )
+        {
+            dStageP50Us[iS] = 0;
+            dStageP99Us[iS] = 0;
+            dStageMaxUs[iS] = 0;
+        }
+    }
+
+    // totals since the server was started
+    qint64 iNumFrames;
+    qint64 iNumOverruns;
+    qint64 iNumMissedTicks;
+    double dUsageSum;
+
+    // values of the current statistics interval
+    double dUsageMax;
+    double dTickJitterMaxUs;
+    int    iOverloadLevel;
+
+    // stage durations of the last profiler report (if profiling is enabled)
+    bool   bProfileValid;
+    double dStageP50Us[NUM_SERVER_FRAME_STAGES];
+    double dStageP99Us[NUM_SERVER_FRAME_STAGES];
+    double dStageMaxUs[NUM_SERVER_FRAME_STAGES];
+};
+
+
+// OPUS codecs of a server channel ---------------------------------------------
+// only the encoder/decoder for the currently used compression type and number
+// of audio channels is allocated, this is done on demand on the first use and
+// the codecs are released if the channel is disconnected (the OPUS modes are
+// shared by all channels), the applied encoder bit rate is tracked so that the
+// encoder is only re-configured if the network frame size was changed, the
+// other encoder settings are selected by the encoder profile of the channel,
+// if the client switches its audio stream properties (e.g. mono/stereo), the
+// codecs of the previous properties are kept and reused with a reset state on
+// a switch back (no allocation in the timer)
+#define SERVER_NUM_CODEC_INDICES            4
+
+class CServerOpusCodecs
+{
+public:
+    CServerOpusCodecs();
+    virtual ~CServerOpusCodecs() { Release(); }
+
+    void Init ( OpusCustomMode* pNOpusMode,
+                OpusCustomMode* pNOpus64Mode );
+
+    void Release();
+    bool IsAllocated() const { return ( pEncoder != nullptr ) || ( pRedEncoder != nullptr ) || ( pDecoder != nullptr ); }
+
+    OpusCustomEncoder* GetEncoder ( const EAudComprType     eAudComprType,
+                                    const int               iNumAudioChannels,
+                                    const int               iCeltNumCodedBytes,
+                                    const EEncoderCpuLoad   eCpuLoad,
+                                    const CChannelNetStats& NetStats );
+
+    const CEncoderProfile& GetEncoderProfile() const { return EncoderProfile; }
+
+    // low bit rate encoder for the redundant copy of the frames
+    OpusCustomEncoder* GetRedEncoder ( const EAudComprType eAudComprType,
+                                       const int           iNumAudioChannels,
+                                       const int           iRedNumCodedBytes );
+
+    OpusCustomDecoder* GetDecoder ( const EAudComprType eAudComprType,
+                                    const int           iNumAudioChannels );
+
+protected:
+    OpusCustomMode* GetMode ( const EAudComprType eAudComprType );
+
+    static int GetCodecIndex ( const EAudComprType eAudComprType,
+                               const int           iNumAudioChannels );
+
+    OpusCustomMode*    pOpusMode;
+    OpusCustomMode*    pOpus64Mode;
+    OpusCustomEncoder* pEncoder;
+    OpusCustomDecoder* pDecoder;
+    OpusCustomEncoder* pSpareEncoders[SERVER_NUM_CODEC_INDICES];
+    OpusCustomDecoder* pSpareDecoders[SERVER_NUM_CODEC_INDICES];
+    int                iEncoderIdx;
+    int                iDecoderIdx;
+    int                iEncoderBitRate;
+    CEncoderProfile    EncoderProfile;
+    OpusCustomEncoder* pRedEncoder;
+    int                iRedEncoderIdx;
+    int                iRedEncoderBitRate;
+};
+
+
+// Frame arena -----------------------------------------------------------------
+// Working set of the timer processing with one row per client (the index of
+// the connected clients of the frame). All rows are in one contiguous memory
+// block, each row starts on a cache line boundary and the row size is padded to
+// a multiple of the cache line size, i.e. the vectorized kernels always work on
+// aligned memory and two worker threads never write in the same cache line.
+template<class TData> class CServerFrameArena
+{
+public:
+    CServerFrameArena() : iNumRows ( 0 ), iRowSize ( 0 ), iRowStride ( 0 ), pRows ( nullptr ) {}
+
+    // allocates the memory (must not be called in the time-critical thread)
+    void Init ( const int iNNumRows,
+                const int iNRowSize )
+    {
+        const int iAlignSize = SERVER_FRAME_ARENA_ALIGNMENT / static_cast<int> ( sizeof ( TData ) );
+
+        iNumRows   = iNNumRows;
+        iRowSize   = iNRowSize;
+        iRowStride = ( ( iRowSize + iAlignSize - 1 ) / iAlignSize ) * iAlignSize;
+
+        // one additional alignment block for aligning the start of the memory
+        vecMemory.Init ( iNumRows * iRowStride + iAlignSize, 0 );
+
+        const std::uintptr_t iAddr = reinterpret_cast<std::uintptr_t> ( &vecMemory[0] );
+
+        pRows = &vecMemory[0] + ( ( SERVER_FRAME_ARENA_ALIGNMENT - iAddr % SERVER_FRAME_ARENA_ALIGNMENT ) %
+                                  SERVER_FRAME_ARENA_ALIGNMENT ) / sizeof ( TData );
+    }
+
+    TData*       operator[] ( const int iRow ) { return pRows + iRow * iRowStride; }
+    const TData* operator[] ( const int iRow ) const { return pRows + iRow * iRowStride; }
+
+    void ResetRow ( const int iRow, const TData tResetVal = 0 )
+        { std::fill ( ( *this )[iRow], ( *this )[iRow] + iRowSize, tResetVal ); }
+
+    int GetNumRows() const { return iNumRows; }
+    int GetRowSize() const { return iRowSize; }
+
+protected:
+    int            iNumRows;
+    int            iRowSize;
+    int            iRowStride;
+    CVector<TData> vecMemory;
+    TData*         pRows;
+};
+
+
+// Channel to worker thread assignment -----------------------------------------
+// Each connected channel is always processed by the same thread of the worker
+// pool so that its codec state, jitter buffer and mix buffers stay in the
+// caches of the core of this thread. The channels are distributed by their
+// measured processing time (the most expensive channel first to the thread
+// with the lowest load) and the assignment is only changed if a channel
+// connects or disconnects, i.e. the channels do not move between the threads
+// during a session.
+class CServerChannelAffinity
+{
+public:
+    CServerChannelAffinity() : iNumThreads ( 0 ), iLastNumClients ( 0 ) {}
+
+    // allocates the memory (must not be called in the time-critical thread)
+    void Init ( const int iMaxNumChannels );
+
+    // called once per frame before the parallel processing with the IDs of
+    // the connected channels, returns the thread of each client index
+    const int* Update ( const CVector<int>& vecChanIDs,
+                        const int           iNumClients,
+                        const int           iNewNumThreads );
+
+    // processing time of a channel in the current frame (only called by the
+    // thread of the channel, each channel has its own cache line)
+    void AddCost ( const int    iChanID,
+                   const qint64 iCostNs ) { FrameCostNs[iChanID][0] += iCostNs; }
+
+protected:
+    void Rebalance ( const CVector<int>& vecChanIDs,
+                     const int           iNumClients );
+
+    CServerFrameArena<qint64> FrameCostNs;
+    CVector<double>           vecdAvCostNs;   // per channel ID, < 0 if unknown
+    CVector<int>              vecChanThread;  // per channel ID
+    CVector<int>              vecItemThread;  // per client index
+    CVector<int>              vecLastChanIDs;
+    CVector<int>              vecSortIdx;
+    CVector<double>           vecdThreadLoad;
+    int                       iNumThreads;
+    int                       iLastNumClients;
+};
+
+
+// Frame size adapter of a server channel --------------------------------------
+// Adapts the frame size of the audio codec of a channel to the server frame
+// size (one of the sizes must be an integer multiple of the other one). A codec
+// frame which is larger than the server frame is kept in the frame memory of
+// the adapter and its server frames are used in place (the decoder writes to
+// and the encoder reads from this memory directly, i.e. the client is served
+// in its own frame domain without any copying), a codec frame which is smaller
+// than the server frame is processed as several codec blocks per server frame.
+class CServerFrameSizeAdapter
+{
+public:
+    CServerFrameSizeAdapter() :
+        iServerFrameSize  ( SYSTEM_FRAME_SIZE_SAMPLES ),
+        iCodecFrameSize   ( SYSTEM_FRAME_SIZE_SAMPLES ),
+        iNumAudioChannels ( 1 ),
+        iNumCodecBlocks   ( 1 ),
+        iNumServerFrames  ( 1 ),
+        iInFrameIdx       ( 0 ),
+        iOutFrameIdx      ( 0 ),
+        bSplitCodecFrame  ( false ) {}
+
+    // allocates the worst case memory (to avoid allocating memory in the
+    // time-critical thread)
+    void Init ( const int iNServerFrameSizeSamples );
+
+    // must be called for each frame, the buffers are only reset if the codec
+    // frame size or the number of audio channels was changed
+    void SetProperties ( const int iNCodecFrameSizeSamples,
+                         const int iNNumAudioChannels );
+
+    // the stored input frame is used up and the output frame starts again
+    void Reset() { iInFrameIdx = iNumServerFrames - 1; iOutFrameIdx = 0; }
+
+    int  GetNumCodecBlocks() const { return iNumCodecBlocks; }
+    int  GetCodecFrameSizeSamples() const { return iCodecFrameSize; }
+    bool SplitsCodecFrame() const { return bSplitCodecFrame; }
+
+    // position of a codec block in the (interleaved) server frame
+    int GetCodecBlockOffset ( const int iBlock ) const { return iBlock * iCodecFrameSize * iNumAudioChannels; }
+
+    // input: moves to the next server frame of the stored codec frame, returns
+    // false if no server frame is left, i.e. a new codec frame must be decoded
+    // to the buffer of GetCodecFrameIn()
+    bool NextServerFrameIn();
+
+    // the decoder writes a large codec frame directly to the frame memory (its
+    // first server frame is the current one), otherwise to the given buffer
+    int16_t* GetCodecFrameIn ( int16_t* psServerData );
+
+    const int16_t* GetServerFrameIn ( const int16_t* psServerData ) const
+        { return bSplitCodecFrame ? &vecsFrameIn[GetServerFrameOffset ( iInFrameIdx )] : psServerData; }
+
+    // output: the mix of the current server frame is written to the returned
+    // buffer (in place in the codec frame for a large codec frame)
+    int16_t* GetServerFrameOut ( int16_t* psServerData )
+        { return bSplitCodecFrame ? &vecsFrameOut[GetServerFrameOffset ( iOutFrameIdx )] : psServerData; }
+
+    // returns the complete codec frame which is then encoded or nullptr if
+    // more server frames are required
+    const int16_t* PutServerFrameOut ( const int16_t* psServerData );
+
+protected:
+    int GetServerFrameOffset ( const int iFrameIdx ) const { return iFrameIdx * iServerFrameSize * iNumAudioChannels; }
+
+    int              iServerFrameSize;
+    int              iCodecFrameSize;
+    int              iNumAudioChannels;
+    int              iNumCodecBlocks;
+    int              iNumServerFrames;
+    int              iInFrameIdx;
+    int              iOutFrameIdx;
+    bool             bSplitCodecFrame;
+    CVector<int16_t> vecsFrameIn;
+    CVector<int16_t> vecsFrameOut;
+};
+
+
+// Silent mix detection of an encoder -----------------------------------------
+// After the first frames of a silent mix were encoded, the encoding is skipped
+// and the last coded frame (which then is a silence frame) is sent again. Opus
+// custom has no DTX in the constant bit rate mode and the packet size is fixed
+// by the network frame size, therefore only the encoding is saved.
+class CServerSilentMix
+{
+public:
+    CServerSilentMix() :
+        iNumSilentFrames   ( 0 ),
+        eAudComprType      ( CT_NONE ),
+        iNumAudioChannels  ( 0 ),
+        iCeltNumCodedBytes ( 0 ) {}
+
+    void Reset() { iNumSilentFrames = 0; }
+
+    // must be called for each frame, returns true if the encoding of the
+    // frame can be skipped (the coded frame must not change if the properties
+    // of the encoder were changed)
+    bool Update ( const bool          bIsSilent,
+                  const EAudComprType eNAudComprType,
+                  const int           iNNumAudioChannels,
+                  const int           iNCeltNumCodedBytes );
+
+protected:
+    int           iNumSilentFrames;
+    EAudComprType eAudComprType;
+    int           iNumAudioChannels;
+    int           iCeltNumCodedBytes;
+};
+
+
+// Shared stream of identical mixes -------------------------------------------
+// All clients which get an identical mix with the same codec properties
+// receive identical coded data. The mix of such a group is calculated and
+// encoded once per frame and the coded blocks are sent to all clients of the
+// group. The encoder state belongs to the stream, i.e. a group keeps its
+// stream (and its encoder state) over the frames even if the signature of its
+// mix changes (e.g. while a new client fades in). A stream is released one
+// frame after its last client has left.
+class CServerSharedStream
+{
+public:
+    CServerSharedStream() :
+        eAudComprType      ( CT_NONE ),
+        iNumAudioChannels  ( 0 ),
+        iCeltNumCodedBytes ( 0 ),
+        iMixSignature      ( 0 ),
+        iRefClientIdx      ( INVALID_INDEX ),
+        iNumUsers          ( 0 ),
+        iNumUsersPrev      ( 0 ),
+        iNumMulticastPorts ( 0 ),
+        bFrameReady        ( false ) {}
+
+    void Init ( OpusCustomMode* pNOpusMode,
+                OpusCustomMode* pNOpus64Mode,
+                const int       iNServerFrameSizeSamples );
+
+    bool HasKey ( const EAudComprType eNAudComprType,
+                  const int           iNNumAudioChannels,
+                  const int           iNCeltNumCodedBytes,
+                  const quint64       iNMixSignature ) const
+    {
+        return ( eAudComprType == eNAudComprType ) &&
+               ( iNumAudioChannels == iNNumAudioChannels ) &&
+               ( iCeltNumCodedBytes == iNCeltNumCodedBytes ) &&
+               ( iMixSignature == iNMixSignature );
+    }
+
+    // assigns the stream to a group for the current frame, the mix of the
+    // group is the mix of the given (first) client of the group (the codecs
+    // are only reset if the codec properties were changed)
+    void SetKey ( const EAudComprType eNAudComprType,
+                  const int           iNNumAudioChannels,
+                  const int           iNCeltNumCodedBytes,
+                  const quint64       iNMixSignature,
+                  const int           iNRefClientIdx );
+
+    // the users are counted again in each frame, a stream which had no users
+    // in the last frame and has none in the current frame is free
+    void StartFrame() { iNumUsersPrev = iNumUsers; iNumUsers = 0; iNumMulticastPorts = 0; }
+    void AddUser() { iNumUsers++; }
+    bool IsUsed() const { return iNumUsers > 0; }
+    int  GetNumUsersPrev() const { return iNumUsersPrev; }
+    bool IsFree() const { return ( iNumUsersPrev == 0 ) && ( iNumUsers == 0 ); }
+    void ReleaseIfUnused();
+
+    int GetRefClientIdx() const { return iRefClientIdx; }
+    int GetNumAudioChannels() const { return iNumAudioChannels; }
+
+    // buffers for the mix of the group (planar float and the int16 samples
+    // of the server frame which are encoded)
+    CVector<float>& GetMixData() { return vecfMixData; }
+    int16_t*        GetSendData() { return FrameSizeAdapter.GetServerFrameOut ( &vecsSendData[0] ); }
+
+    // encodes the send data, the coded blocks are only valid if
+    // IsFrameReady() returns true (for a silent mix the encoding is skipped
+    // after some frames)
+    void Encode ( const EEncoderCpuLoad eCpuLoad,
+                  const bool            bIsSilentMix );
+
+    bool                    IsFrameReady() const { return bFrameReady; }
+    int                     GetNumCodecBlocks() const { return FrameSizeAdapter.GetNumCodecBlocks(); }
+    int                     GetNumCodedBytes() const { return iCeltNumCodedBytes; }
+    const CVector<uint8_t>& GetCodedData ( const int iBlock ) const { return vecvecbyCodedData[iBlock]; }
+
+    // the ports of the clients which receive the stream from its multicast
+    // group, they are collected again in each frame (a port is only stored
+    // once, the clients on different hosts may use the same port)
+    void    AddMulticastPort ( const quint16 iPort );
+    int     GetNumMulticastPorts() const { return iNumMulticastPorts; }
+    quint16 GetMulticastPort ( const int iIdx ) const { return vecMulticastPorts[iIdx]; }
+
+    // the coded blocks of the frame in one packet as a channel without
+    // sequence numbers and redundancy sends them
+    const CVector<uint8_t>& GetPacket ( int& iNumBytes );
+
+protected:
+    CServerOpusCodecs          OpusCodecs;
+    CServerFrameSizeAdapter    FrameSizeAdapter;
+    int                        iServerFrameSize;
+    EAudComprType              eAudComprType;
+    int                        iNumAudioChannels;
+    int                        iCeltNumCodedBytes;
+    quint64                    iMixSignature;
+    int                        iRefClientIdx;
+    int                        iNumUsers;
+    int                        iNumUsersPrev;
+    CVector<quint16>           vecMulticastPorts;
+    int                        iNumMulticastPorts;
+    bool                       bFrameReady;
+    CServerSilentMix           SilentMix;
+    CVector<float>             vecfMixData;
+    CVector<int16_t>           vecsSendData;
+    CVector<CVector<uint8_t> > vecvecbyCodedData;
+    CVector<uint8_t>           vecbyPacket;
+};
+
+
+// Address to channel index ----------------------------------------------------
+// open addressing hash table (linear probing) which maps the packed host address
+// of a client to its channel ID so that finding the channel of a received packet
+// is a single probe in the typical case (note that the connection state is not
+// handled here, the caller has to check that the found channel is connected)
+class CChannelAddressIndex
+{
+public:
+    CChannelAddressIndex() { Reset(); }
+
+    void Reset();
+    int  Find ( const CHostAddress& Addr ) const;
+
+    // sets the address of the channel (a previous address of the channel is
+    // removed from the index)
+    void Insert ( const CHostAddress& Addr,
+                  const int           iChanID );
+
+protected:
+    class CKey
+    {
+    public:
+        CKey() : iAddrHi ( 0 ), iAddrLo ( 0 ), iPort ( 0 ) {}
+
+        bool operator== ( const CKey& Other ) const
+        {
+            return ( iAddrHi == Other.iAddrHi ) &&
+                   ( iAddrLo == Other.iAddrLo ) &&
+                   ( iPort   == Other.iPort );
+        }
+
+        quint64 iAddrHi; // IPv6 address (IPv4 addresses are IPv4-mapped)
+        quint64 iAddrLo;
+        quint16 iPort;
+    };
+
+    static CKey GetKey ( const CHostAddress& Addr );
+    static int  GetHashIndex ( const CKey& Key );
+
+    void Erase ( const int iChanID );
+
+    CKey Keys[CHAN_ADDR_INDEX_SIZE];
+    int  ChanIDs[CHAN_ADDR_INDEX_SIZE]; // INVALID_CHANNEL_ID for empty slots
+    CKey ChanKeys[MAX_NUM_CHANNELS];
+    bool bChanHasKey[MAX_NUM_CHANNELS];
+};
+
+class CServer : public QObject
 {
     Q_OBJECT
 
@@ -176,26 +1134,121 @@ public:
               const QString&     strServerNameForHTMLStatusFile,
               const QString&     strCentralServer,
               const QString&     strServerInfo,
+              const QString&     strFederationPeers,
               const QString&     strNewWelcomeMessage,
               const QString&     strRecordingDirName,
               const bool         bNCentServPingServerInList,
               const bool         bNDisconnectAllClientsOnQuit,
               const bool         bNUseDoubleSystemFrameSize,
-              const ELicenceType eNLicenceType );
+              const ELicenceType eNLicenceType,
+              const int          iNNumThreads = 0,
+              const int          iNNumRecvThreads = 1,
+              const bool         bNEnableProfiling = false,
+              const bool         bNRecordFlac = false,
+              const bool         bNRecordMix = false,
+              const QString&     strMetricsBindAddress = "",
+              const QString&     strServerFx = "",
+              const QString&     strCaptureFileName = "",
+              const QString&     strReplayFileName = "",
+              const bool         bNReplayFast = false,
+              const int          iLogFlushIntervalMs = LOG_DEFAULT_FLUSH_INTERVAL_MS,
+              const int          iLogMaxFileSizeMB = 0,
+              const QString&     strCascadeAddress = "",
+              const bool         bNConnectedSockets = false );
 
     void Start();
     void Stop();
-    bool IsRunning() { return HighPrecisionTimer.isActive(); }
+    bool IsRunning() { return bIsRunning; }
 
+    // wakes up a stopped server, may be called by any thread (the server is
+    // started by the next tick of the timer which is woken up directly)
+    void WakeUp();
+
+    // multi-room mode: the room (a server on another port of the same process)
+    // is processed in the timer of this server and uses its worker pool
+    void AddRoom ( CServer* pRoom );
+
+    // the report of the frame stage profiler of the last statistics interval
+    // (empty if the profiling is not enabled)
+    QString GetFrameProfileReport() const { return strFrameProfileReport; }
+
+    // the channel ID hint is the channel of the connected socket which
+    // received the packet (INVALID_INDEX for the shared socket), the receive
+    // delay is the time since the kernel has received the packet (zero if
+    // unknown)
     bool PutAudioData ( const CVector<uint8_t>& vecbyRecBuf,
                         const int               iNumBytesRead,
                         const CHostAddress&     HostAdr,
-                        int&                    iCurChanID );
+                        int&                    iCurChanID,
+                        const int               iChanIDHint = INVALID_INDEX,
+                        const int               iRecDelayNs = 0 );
+
+    // checks if the channel is connected to the given address (may be called
+    // by any thread)
+    bool IsChannelAddress ( const int           iChanID,
+                            const CHostAddress& Addr );
 
     void GetConCliParam ( CVector<CHostAddress>& vecHostAddresses,
                           CVector<QString>&      vecsName,
                           CVector<int>&          veciJitBufNumFrames,
-                          CVector<int>&          veciNetwFrameSizeFact );
+                          CVector<int>&          veciNetwFrameSizeFact,
+                          CVector<int>&          veciRttMs,
+                          CVector<int>&          veciRttJitterMs );
+
+    // audio packet counters of all channels (same indices as GetConCliParam)
+    void GetConCliNetStats ( CVector<CChannelNetStats>& vecNetStats );
+
+    // interface for the metrics exporter, nothing of the audio processing is
+    // locked by these functions
+    void GetMetricsSnapshot ( CServerMetricsSnapshot& Snapshot ) const
+        { Snapshot = MetricsSnapshots[iMetricsSnapshotIdx.loadAcquire()]; }
+
+    bool GetChannelMetrics ( const int         iChanID,
+                             CChannelNetStats& NetStats,
+                             int&              iRttMs,
+                             int&              iRttJitterMs,
+                             int&              iJitBufNumFrames ) const;
+
+    // allocated memory of a channel in bytes (the buffers of an idle channel
+    // are released)
+    int GetChannelMemUsage ( const int iChanID ) const { return vecChannels[iChanID].GetMemUsage(); }
+
+    int GetMaxNumChannels() const { return iMaxNumChannels; }
+
+    // accept new clients depending on the measured processing time (the
+    // maximum number of channels is still the upper limit)
+    void SetEnableAdmissionControl ( const bool bEnable ) { AdmissionControl.SetEnabled ( bEnable ); }
+
+    // spread the audio packets of a frame instead of sending them in one
+    // burst, returns false if this is not supported
+    bool SetEnablePacing();
+
+    // the relays with the given addresses (separated by comma) may forward
+    // the packets of their clients, returns false if an address is invalid
+    bool SetAllowedRelays ( const QString& strRelays ) { return RelayRoutes.SetAllowedRelays ( strRelays ); }
+
+    // the shared streams are sent to the clients in the local network by
+    // multicast, stream n uses the given group address + n (an IPv4 or IPv6
+    // multicast address), returns false if the address is invalid
+    bool SetMulticastGroup ( const QString& strGroupAddr );
+
+    // live stream of the common mix as Ogg/OPUS on http://[address:]port/
+    // (throws an error if the port cannot be used, must be called before the
+    // server is started)
+    void StartStreamOutput ( const QString& strBindAddress,
+                             const int      iBitRateKbps );
+
+    int GetNumStreamListeners() const { return StreamOutput.GetNumListeners(); }
+
+    int GetRecorderQueueLength() const { return JamRecorder.GetQueueLength(); }
+    int GetRecorderNumDroppedFrames() const { return JamRecorder.GetNumDroppedFrames(); }
+    int GetRecorderNumWrittenKiB() const { return JamRecorder.GetNumWrittenKiB(); }
+    int GetRecorderNumPausedTracks() const { return JamRecorder.GetNumPausedTracks(); }
+
+    // what the recorder does if it cannot keep up (must be set before the
+    // server is started)
+    void SetRecorderOverflowPolicy ( const recorder::ERecorderOverflowPolicy eNewPolicy )
+        { JamRecorder.SetOverflowPolicy ( eNewPolicy ); }
 
     bool GetRecorderInitialised() { return bRecorderInitialised; }
     bool GetRecordingEnabled() { return bEnableRecording; }
@@ -212,6 +1265,12 @@ public:
 
     bool GetServerListEnabled() { return ServerListManager.GetEnabled(); }
 
+    bool GetServerListIsCentralServer() const { return ServerListManager.GetIsCentralServer(); }
+
+    // the server is a member of a server pool which the central server shows
+    // as one entry (the member with the lowest load)
+    void SetServerListPool ( const QString& strPool ) { ServerListManager.SetServerPool ( strPool ); }
+
     void SetServerListCentralServerAddress ( const QString& sNCentServAddr )
         { ServerListManager.SetCentralServerAddress ( sNCentServAddr ); }
 
@@ -261,12 +1320,44 @@ protected:
     void StartStatusHTMLFileWriting ( const QString& strNewFileName,
                                       const QString& strNewServerNameWithPort );
 
+    // true if this server or one of its rooms is running
+    bool IsTimerRequired();
+
+    void StartIfWakeRequested();
+    void WarmUpCodecs();
+
     int GetFreeChan();
     int FindChannel ( const CHostAddress& CheckAddr );
     int GetNumberOfConnectedClients();
     CVector<CChannelInfo> CreateChannelList();
 
+    // cached answers of the connection less requests
+    const CVector<CChannelInfo>& GetConnLessChanInfo();
+    int                          GetConnLessNumClients();
+
+    bool IsRateLimitedConnLessMes ( const int iRecID ) const;
+
+    // the name of a sub-stream channel is derived from its parent channel
+    QString GetChannelName ( const int iChanID );
+
+    // sub-streams of the multi-stream mode of a client (the channel table
+    // mutex must be locked)
+    void PutSubStreamAudioData ( const int               iChanID,
+                                 const CVector<uint8_t>& vecbyRecBuf,
+                                 const CHostAddress&     HostAdr,
+                                 const int               iRecDelayNs,
+                                 bool&                   bNewConnection );
+
+    int GetSubStreamChannel ( const int iChanID,
+                              const int iSubStreamIdx );
+
     virtual void CreateAndSendChanListForAllConChannels();
+    void RequestChanListForAllConChannels();
+
+    void QueueTickEvent ( const EServerTickEvent eEvent,
+                          const int              iChanID );
+
+    void DispatchTickEvents();
     virtual void CreateAndSendChanListForThisChan ( const int iCurChanID );
 
     virtual void CreateAndSendChatTextForAllConChannels ( const int      iCurChanID,
@@ -274,6 +1365,12 @@ protected:
 
     virtual void CreateAndSendRecorderStateForAllConChannels();
 
+    // the mix groups of all channels indexed by the channel ID (a sub-stream
+    // channel is in the mix group of its parent channel), returns false if no
+    // channel is in a mix group
+    bool CreateMixGroupList ( CVector<int>& vecMixGroups );
+    void CreateAndSendMixGroupListForAllConChannels();
+
     ERecorderState GetRecorderState();
 
     virtual void CreateOtherMuteStateChanged ( const int  iCurChanID,
@@ -283,73 +1380,313 @@ protected:
     virtual void CreateAndSendJitBufMessage ( const int iCurChanID,
                                               const int iNNumFra );
 
-    virtual void SendProtMessage ( int              iChID,
-                                   CVector<uint8_t> vecMessage );
+    // the properties of a client which did not send a session setup are
+    // requested by separate messages
+    void OnSessionSetupMissing ( const int iChID );
+
+    virtual void SendProtMessage ( int          iChID,
+                                   CProtMessage Message );
+
+    void ConnectChannelSignals ( const int iChanID );
+
+    void       WriteStatusFile();
+    QByteArray CreateHTMLChannelList();
+    QByteArray CreateJsonChannelList();
+
+    // marks the clients which are part of at least one mix (a client with
+    // zero gains in all mixes does not have to be decoded)
+    void UpdateAudibleClients ( const int iNumClients );
+
+    void DecodeReceiveData ( const int iClientIdx );
 
-    template<unsigned int slotId>
-    inline void connectChannelSignalsToServerSlots();
+    void MixEncodeTransmitData ( const int  iClientIdx,
+                                 const int  iNumClients,
+                                 const bool bSendChannelLevels );
+
+    void SendChannelLevels ( const int  iCurChanID,
+                             const int  iNumClients,
+                             const bool bSendChannelLevels );
+
+    void SelectMultitrackSources ( const int iClientIdx,
+                                   const int iNumClients );
+
+    void SendMultitrackFrame ( const int iClientIdx,
+                               const int iBlock,
+                               const int iSubmixNumBytes );
+
+    // FNV-1a hash of the gains and pannings of a mix (the bit patterns of the
+    // values are used, equal mixes have equal signatures)
+    static quint64 AddToMixSignature ( const quint64 iSignature,
+                                       const double  dValue )
+    {
+        quint64 iBits;
+        memcpy ( &iBits, &dValue, sizeof ( iBits ) );
+        return ( iSignature ^ iBits ) * Q_UINT64_C ( 1099511628211 );
+    }
+
+    bool IsSilentMix ( const int iGainIdx,
+                       const int iNumClients );
+
+    void UpdateStereoGainRow ( const int iChanID );
+
+    float SmoothGain ( const float fGain,
+                       const float fTargetGain ) const
+    {
+        const float fNewGain = fTargetGain + ( fGain - fTargetGain ) * fGainSmoothingCoeff;
+
+        return ( std::abs ( fNewGain - fTargetGain ) < SERVER_GAIN_SMOOTHING_THRESHOLD ) ? fTargetGain : fNewGain;
+    }
+
+    void MixAddSmoothed ( float*       pfOut,
+                          const float* pfIn,
+                          const float  fGainStart,
+                          const float  fGain ) const
+    {
+        if ( fGainStart != fGain )
+        {
+            CMixKernel::MixAddRamp ( pfOut, pfIn, fGainStart, fGain, iServerFrameSizeSamples );
+        }
+        else if ( fGain != 0.0f )
+        {
+            CMixKernel::MixAdd ( pfOut, pfIn, fGain, iServerFrameSizeSamples );
+        }
+    }
 
-    void WriteHTMLChannelList();
+    bool IsSameMix ( const int iClientIdx,
+                     const int iRefClientIdx,
+                     const int iNumClients );
 
-    void ProcessData ( const CVector<CVector<int16_t> >& vecvecsData,
-                       const CVector<double>&            vecdGains,
-                       const CVector<double>&            vecdPannings,
-                       const CVector<int>&               vecNumAudioChannels,
-                       CVector<int16_t>&                 vecsOutData,
-                       const int                         iCurNumAudChan,
-                       const int                         iNumClients );
+    int GetSharedStream ( const int  iClientIdx,
+                          const int  iNumClients,
+                          const bool bMixIsStable );
 
-    virtual void customEvent ( QEvent* pEvent );
+    void ClaimSharedStream ( const int iStreamIdx,
+                             const int iClientIdx );
+
+    void EncodeSharedStream ( const int iActiveStreamIdx,
+                              const int iNumClients );
+
+    void UpdateMulticastStreams ( const int iNumClients );
+
+    void ReportTimingStats();
+    void PublishMetricsSnapshot();
+
+    // the overload control has priority since it reacts on a single frame
+    EEncoderCpuLoad GetEncoderCpuLoad() const
+        { return OverloadControl.LowEncoderComplexity() ? EL_OVERLOAD : EncoderCpuLoad.GetLoad(); }
+
+    void CreateCommonMix();
+
+    // mixes a group of clients with the same number of audio channels on the
+    // mix buffer, the kernel is specialised for the number of input and output
+    // channels so that the loop over the group has no branches
+    // (the gain offsets of the clients are subtracted from their gains, see
+    // ProcessData())
+    template<int iInCh, int iOutCh>
+    void MixClientGroup ( const CServerFrameArena<float>& vecvecfData,
+                          const int*                      piClientIdx,
+                          const int                       iNumGroupClients,
+                          const int                       iGainIdx,
+                          float*                          pfMixData );
+
+    // the gains of the mix are taken from the gain rows of the given client
+    // index (the gains at the start and at the end of the frame)
+    void ProcessData ( const CServerFrameArena<float>& vecvecfData,
+                       const CVector<float>&           vecfCommonMixData,
+                       const int                       iGainIdx,
+                       float*                          pfMixData,
+                       int16_t*                        psOutData,
+                       const int                       iCurNumAudChan );
 
     // if server mode is normal or double system frame size
     bool                       bUseDoubleSystemFrameSize;
     int                        iServerFrameSizeSamples;
 
-    bool CreateLevelsForAllConChannels  ( const int                        iNumClients,
-                                          const CVector<int>&              vecNumAudioChannels,
-                                          const CVector<CVector<int16_t> > vecvecsData,
-                                          CVector<uint16_t>&               vecLevelsOut );
+    bool CreateLevelsForAllConChannels  ( const int             iNumClients,
+                                          const CVector<float>& vecfPeaks,
+                                          CVector<uint16_t>&    vecLevelsOut );
 
-    // do not use the vector class since CChannel does not have appropriate
-    // copy constructor/operator
-    CChannel                   vecChannels[MAX_NUM_CHANNELS];
+    // the channel table is allocated for the number of channels of the server
+    // (do not use the vector class since CChannel does not have appropriate
+    // copy constructor/operator)
+    std::unique_ptr<CChannel[]> vecChannels;
     int                        iMaxNumChannels;
     CProtocol                  ConnLessProtocol;
+
+    // the server mutex serializes the per-frame channel property collection
+    // of the timer, the protocol does not lock it (the channels protect their
+    // state themselves), the channel table mutex only protects the channel
+    // address index and the channel allocation (lock order: Mutex first)
     QMutex                     Mutex;
+    QMutex                     MutexChanTable;
+
+    // a channel list update was requested by the protocol but not yet sent
+    QAtomicInt                 iChanListUpdatePending;
+
+    // state of the connected clients list changes (the last sent list, its
+    // version and which channels have the complete list), the mutex is always
+    // locked last
+    QMutex                     MutexChanList;
+    int                        iChanListVersion;
+    CVector<CChannelInfo>      vecLastChanListInfo;
+    CVector<uint8_t>           vecbyLastChanListPresent;
+    CVector<uint8_t>           vecbyChanListSynced;
+
+    // one stream of a received multi-stream packet (protected by the channel
+    // table mutex)
+    CVector<uint8_t>           vecbySubStreamPacket;
 
     // audio encoder/decoder
-    OpusCustomMode*            Opus64Mode[MAX_NUM_CHANNELS];
-    OpusCustomEncoder*         Opus64EncoderMono[MAX_NUM_CHANNELS];
-    OpusCustomDecoder*         Opus64DecoderMono[MAX_NUM_CHANNELS];
-    OpusCustomEncoder*         Opus64EncoderStereo[MAX_NUM_CHANNELS];
-    OpusCustomDecoder*         Opus64DecoderStereo[MAX_NUM_CHANNELS];
-    OpusCustomMode*            OpusMode[MAX_NUM_CHANNELS];
-    OpusCustomEncoder*         OpusEncoderMono[MAX_NUM_CHANNELS];
-    OpusCustomDecoder*         OpusDecoderMono[MAX_NUM_CHANNELS];
-    OpusCustomEncoder*         OpusEncoderStereo[MAX_NUM_CHANNELS];
-    OpusCustomDecoder*         OpusDecoderStereo[MAX_NUM_CHANNELS];
-    CConvBuf<int16_t>          DoubleFrameSizeConvBufIn[MAX_NUM_CHANNELS];
-    CConvBuf<int16_t>          DoubleFrameSizeConvBufOut[MAX_NUM_CHANNELS];
+    OpusCustomMode*            OpusMode;
+    OpusCustomMode*            Opus64Mode;
+    std::unique_ptr<CServerOpusCodecs[]> OpusCodecs;
+    CChannelAddressIndex       ChanAddrIndex;
+    std::unique_ptr<CServerFrameSizeAdapter[]> FrameSizeAdapter;
 
     CVector<QString>           vstrChatColors;
     CVector<int>               vecChanIDsCurConChan;
 
-    CVector<CVector<double> >  vecvecdGains;
-    CVector<CVector<double> >  vecvecdPannings;
-    CVector<CVector<int16_t> > vecvecsData;
+    // events of the current frame (see EServerTickEvent)
+    CVector<SServerTickEvent>  vecTickEvents;
+    int                        iNumTickEvents;
+
+    // events of the channels which are handled by the main thread
+    CChannelEventQueue         ChanEventQueue;
+
+    // the cached gain/pan matrix rows and the stereo gains with the pan law
+    // already applied (only updated if the protocol changed a gain or pan)
+    CVector<CVector<double> >  vecvecdGainMatrix;
+    CVector<CVector<double> >  vecvecdPanMatrix;
+    CVector<CVector<float> >   vecvecfGainLMatrix;
+    CVector<CVector<float> >   vecvecfGainRMatrix;
+
+    // the smoothed gains of the mixes (indexed by the channel IDs, a new
+    // listener starts with the target gains) and the gains at the start of
+    // the frame (indexed by the client indices)
+    CVector<CVector<float> >   vecvecfMixGainMatrix;
+    CVector<CVector<float> >   vecvecfMixGainLMatrix;
+    CVector<CVector<float> >   vecvecfMixGainRMatrix;
+    CVector<int>               vecMixGainsValid;
+    float                      fGainSmoothingCoeff;
+    CServerFrameArena<float>   vecvecfGainsStart;
+    CServerFrameArena<float>   vecvecfGainsLStart;
+    CServerFrameArena<float>   vecvecfGainsRStart;
+
+    // mix group buses: each mix group is summed once per frame (with unity
+    // gain and center panning, the planes are the same as for the common
+    // mix), the mix group gains are applied on the buses and the channels of a
+    // mix group are only mixed individually if their gain differs from the
+    // gain of their group (the gain matrices are indexed by the channel IDs,
+    // the smoothed gains of the frame by the client indices, the gain offsets
+    // of the mix are the reference gains of the clients in the mix)
+    CVector<int>               vecMixGroup;
+    CVector<int>               vecMixGroupUsed;
+    CServerFrameArena<float>   vecvecfMixGroupData;
+    CVector<CVector<double> >  vecvecdMixGroupGainMatrix;
+    CVector<CVector<float> >   vecvecfMixGroupGainMatrix;
+    CServerFrameArena<float>   vecvecfMixGroupGains;
+    CServerFrameArena<float>   vecvecfMixGroupGainsStart;
+    CServerFrameArena<float>   vecvecfGainOffs;
+    CServerFrameArena<float>   vecvecfGainOffsStart;
+
+    // the active clients of a mix (indexed by the gain index of the mix): the
+    // clients which differ from the common mix and the clients with a
+    // non-zero gain, each list has iMaxNumChannels entries
+    CServerFrameArena<int>     vecvecActiveClientIdx;
+
+    // the fade-in is applied as a gain ramp on the audio data of a new client
+    // (the last gain is indexed by the channel ID)
+    CVector<double>            vecdFadeInGains;
+    CVector<float>             vecfLastFadeInGain;
+    CServerFrameArena<double>  vecvecdGains;
+    CServerFrameArena<float>   vecvecfGainsL;
+    CServerFrameArena<float>   vecvecfGainsR;
+    CServerFrameArena<int16_t> vecvecsData;
+    CServerFrameArena<float>   vecvecfData;
+    CServerFrameArena<float>   vecvecfMixData;
+    CVector<float>             vecfCommonMixData;
+
+    // optional insert chain of the channels and the shared reverb bus (the
+    // reverb return is part of the common mix)
+    CServerFxSettings          FxSettings;
+    bool                       bFxEnabled;
+    std::unique_ptr<CServerChannelFx[]> ChannelFx;
+    CServerReverbBus           ReverbBus;
+
+    // peak values of the clients of the current frame (measured in the decode
+    // stage), they are used for the level meters and the silence detection
+    CVector<float>             vecfChannelPeaks;
     CVector<int>               vecNumAudioChannels;
-    CVector<int>               vecNumFrameSizeConvBlocks;
-    CVector<int>               vecUseDoubleSysFraSizeConvBuf;
     CVector<EAudComprType>     vecAudioComprType;
-    CVector<CVector<int16_t> > vecvecsSendData;
+    CVector<int>               vecDecodeRequired;
+    CVector<int>               vecNumCodedBytesIn;
+    CVector<int>               vecCodedDataInOK;
+    CVector<int>               vecCodedDataInLen;
+    CVector<CVector<uint8_t> > vecvecbyCodedDataIn;
+    CServerFrameArena<int16_t> vecvecsSendData;
     CVector<CVector<uint8_t> > vecvecbyCodedData;
+    CVector<CVector<uint8_t> > vecvecbyRedCodedData;
+
+    // the listeners are not decoded and not mixed, the silent channels are
+    // not mixed (the silence counter is indexed by the channel ID)
+    CVector<int>               vecIsListener;
+    CVector<int>               vecIsSilent;
+    CVector<int>               vecSilenceCnt;
+    int                        iSilenceHoldNumFrames;
+
+    // the clients which nobody hears are not decoded either, only their
+    // jitter buffer is read, the decoder of a skipped client is reset when it
+    // is decoded again (the skip state is indexed by the channel ID)
+    CVector<int>               vecIsAudible;
+    CVector<int>               vecDecodeSkipped;
+    int                        iNumMixClients;
+    CVector<CServerSilentMix>  vecSilentMix;
+
+    // the client indices of the mixed clients of the frame, grouped by the
+    // number of audio channels: the first iNumMonoMixClients are mono clients,
+    // the other ones are stereo clients
+    CVector<int>               vecMixClientIdx;
+    int                        iNumMonoMixClients;
+
+    // the clients with identical mixes share a stream which is encoded once,
+    // the stream index and the hold counter are indexed by the channel ID
+    // (the stream index is INVALID_INDEX for a client with an own encoder)
+    std::unique_ptr<CServerSharedStream[]> SharedStreams;
+    CVector<int>               vecSharedStreamIdx;
+    CVector<int>               vecMixHoldCnt;
+    CVector<quint64>           vecMixSignature;
+    CVector<int>               vecActiveStreams;
+    int                        iNumActiveStreams;
+
+    // multicast of the shared streams: the group address of each stream and
+    // the offered stream and the multicast state of each client (indexed by
+    // the channel ID, the offer is NO_MULTICAST_STREAM if the client receives
+    // its mix by unicast)
+    bool                       bMulticastEnabled;
+    CVector<CHostAddress>      vecMulticastGroupAddr;
+    CVector<int>               vecMulticastOffer;
+    CVector<int>               vecMulticastActive;
+
+    // multitrack mode: the client indices of the forwarded clients and the
+    // multitrack frame of each client (indexed by the client index)
+    CVector<CVector<int> >     vecvecMultitrackIdx;
+    CVector<int>               vecNumMultitrackIdx;
+    CVector<CMultitrackFrame>  vecMultitrackFrames;
 
     // Channel levels
     CVector<uint16_t>          vecChannelLevels;
 
+    // routes of the clients through the allowed relays (declared before the
+    // socket since the socket threads use it)
+    CRelayRoutes               RelayRoutes;
+
     // actual working objects
     CHighPrioSocket            Socket;
 
+    // optional link to a parent server (the mix of the parent server is part
+    // of the common mix)
+    CServerCascade             Cascade;
+
     // logging
     CServerLogging             Logging;
 
@@ -360,17 +1697,83 @@ protected:
     recorder::CJamRecorder     JamRecorder;
     bool                       bRecorderInitialised;
     bool                       bEnableRecording;
+    bool                       bRecordMix;
+    QString                    strRecordMixName;
+    CVector<int16_t>           vecsRecordMixData; // also used by the live stream
 
-    // HTML file server status
+    // live stream output (the mix is only converted if a listener is connected)
+    CStreamOutput              StreamOutput;
+
+    // HTML (or JSON) file server status
     bool                       bWriteStatusHTMLFile;
     QString                    strServerHTMLFileListName;
     QString                    strServerNameWithPort;
+    CServerStatusWriter        StatusWriter;
+
+    // metrics exporter: the server timer writes the snapshot which is not
+    // published, the index is switched afterwards (since the snapshot is
+    // only published once per interval, a snapshot is never rewritten while
+    // the exporter copies it)
+    CServerMetricsExporter     MetricsExporter;
+    bool                       bMetricsEnabled;
+    int                        iMetricsFrameCnt;
+    CServerMetricsSnapshot     MetricsProfile;
+    CServerMetricsSnapshot     MetricsSnapshots[2];
+    QAtomicInt                 iMetricsSnapshotIdx;
+
+    // capture of the received packets and replay of a capture (the replay is
+    // declared after the socket so that it is stopped first)
+    CPacketCapture             PacketCapture;
+    CPacketReplay              PacketReplay;
 
     CHighPrecisionTimer        HighPrecisionTimer;
+    bool                       bIsRunning;
+    QAtomicInt                 iWakeRequested;
+
+    // in the multi-room mode, the timer and the worker pool of the main room
+    // are used by all rooms (pTimerServer is the main room, this otherwise)
+    CServer*                   pTimerServer;
+    CVector<CServer*>          vecpRooms;
+
+    // multithreaded audio processing (if the number of threads is zero, the
+    // worker pool is not used at all)
+    int                        iNumThreads;
+    CServerWorkerPool          WorkerPool;
+    CServerWorkerPool*         pWorkerPool;
+    CServerChannelAffinity     ChannelAffinity;
+    CServerTimingStats         TimingStats;
+    CServerOverloadControl     OverloadControl;
+    CServerAdmissionControl    AdmissionControl;
+    CEncoderCpuLoadMeter       EncoderCpuLoad;
+    CServerFrameProfiler       FrameProfiler;
+    QString                    strFrameProfileReport;
+    QElapsedTimer              FrameProcTimer;
+    QElapsedTimer              TickClock;
+
+    // timing records of the last seconds for the analysis of underruns
+    CFlightRecorder            FlightRecorder;
+
+    // average processing time of a frame for the latency probes (written by
+    // the timer thread)
+    double                     dFrameProcTimeAvUs;
+    QAtomicInt                 iFrameProcTimeAvUs;
+
+    // round trip time measurement to the connected clients
+    QTimer                     TimerRttProbe;
+    QElapsedTimer              RttClock;
 
     // server list
     CServerListManager         ServerListManager;
 
+    // protection against floods of connection less requests (the answers of
+    // the cached requests are refreshed after CONNLESS_RESPONSE_CACHE_TIME_MS)
+    CConnLessRateLimiter       ConnLessReqLimiter;
+    QElapsedTimer              ConnLessClock;
+    CVector<CChannelInfo>      vecConnLessChanInfoCache;
+    int                        iConnLessNumClientsCache;
+    qint64                     iConnLessChanInfoTimeMs;
+    qint64                     iConnLessNumClientsTimeMs;
+
     // GUI settings
     bool                       bAutoRunMinimized;
 
@@ -384,36 +1787,34 @@ protected:
 signals:
     void Started();
     void Stopped();
-    void ClientDisconnected ( const int iChID );
     void SvrRegStatusChanged();
-    void AudioFrame ( const int              iChID,
-                      const QString          stChName,
-                      const CHostAddress     RecHostAddr,
-                      const int              iNumAudChan,
-                      const CVector<int16_t> vecsData );
     void RestartRecorder();
     void StopRecorder();
     void RecordingSessionStarted ( QString sessionDir );
 
 public slots:
+    void OnTimerTick();
     void OnTimer();
+    void OnChanListUpdateRequested();
+    void OnReleaseChanBuffers();
+    void OnChannelEvents();
 
     void OnNewConnection ( int          iChID,
                            CHostAddress RecHostAddr );
 
     void OnServerFull ( CHostAddress RecHostAddr );
 
-    void OnSendCLProtMessage ( CHostAddress     InetAddr,
-                               CVector<uint8_t> vecMessage );
+    void OnSendCLProtMessage ( CHostAddress InetAddr,
+                               CProtMessage Message );
 
-    void OnProtcolCLMessageReceived ( int              iRecID,
-                                      CVector<uint8_t> vecbyMesBodyData,
-                                      CHostAddress     RecHostAddr );
+    void OnProtcolCLMessageReceived ( int          iRecID,
+                                      CProtMessage MesBody,
+                                      CHostAddress RecHostAddr );
 
-    void OnProtcolMessageReceived ( int              iRecCounter,
-                                    int              iRecID,
-                                    CVector<uint8_t> vecbyMesBodyData,
-                                    CHostAddress     RecHostAddr );
+    void OnProtcolMessageReceived ( int          iRecCounter,
+                                    int          iRecID,
+                                    CProtMessage MesBody,
+                                    CHostAddress RecHostAddr );
 
     void OnCLPingReceived ( CHostAddress InetAddr, int iMs )
         { ConnLessProtocol.CreateCLPingMes ( InetAddr, iMs ); }
@@ -424,9 +1825,19 @@ public slots:
     {
         ConnLessProtocol.CreateCLPingWithNumClientsMes ( InetAddr,
                                                          iMs,
-                                                         GetNumberOfConnectedClients() );
+                                                         GetConnLessNumClients() );
     }
 
+    void OnTimerRttProbe();
+
+    void OnServerLoadRequested();
+
+    void OnCLRttProbeEchoReceived ( CHostAddress InetAddr,
+                                    int          iMs );
+
+    void OnCLReqLatencyProbe ( CHostAddress InetAddr,
+                               int          iMs );
+
     void OnCLSendEmptyMes ( CHostAddress TargetInetAddr )
     {
         // only send empty message if server list is enabled and this is not
@@ -441,11 +1852,20 @@ public slots:
     void OnCLReqServerList ( CHostAddress InetAddr )
         { ServerListManager.CentralServerQueryServerList ( InetAddr ); }
 
+    void OnCLReqServerListPage ( CHostAddress      InetAddr,
+                                 CServerListFilter Filter,
+                                 int               iPage )
+        { ServerListManager.CentralServerQueryServerListPage ( InetAddr, Filter, iPage ); }
+
+    void OnCLReqServerListIPv6 ( CHostAddress      InetAddr,
+                                 CServerListFilter Filter )
+        { ServerListManager.CentralServerQueryServerListIPv6 ( InetAddr, Filter ); }
+
     void OnCLReqVersionAndOS ( CHostAddress InetAddr )
         { ConnLessProtocol.CreateCLVersionAndOSMes ( InetAddr ); }
 
     void OnCLReqConnClientsList ( CHostAddress InetAddr )
-        { ConnLessProtocol.CreateCLConnClientsListMes ( InetAddr, CreateChannelList() ); }
+        { ConnLessProtocol.CreateCLConnClientsListMes ( InetAddr, GetConnLessChanInfo() ); }
 
     void OnCLRegisterServerReceived ( CHostAddress    InetAddr,
                                       CHostAddress    LInetAddr,
@@ -460,14 +1880,49 @@ public slots:
         ServerListManager.StoreRegistrationResult ( eResult );
     }
 
+    void OnCLRegisterServerRetryReceived ( CHostAddress InetAddr,
+                                           int          iRetryAfterS )
+    {
+        ServerListManager.StoreRegistrationRetryAfter ( InetAddr, iRetryAfterS );
+    }
+
     void OnCLUnregisterServerReceived ( CHostAddress InetAddr )
     {
         ServerListManager.CentralServerUnregisterServer ( InetAddr );
     }
 
+    void OnCLServerFeaturesReceived ( CHostAddress InetAddr,
+                                      uint32_t     iFeatures )
+    {
+        ServerListManager.CentralServerSetServerFeatures ( InetAddr, iFeatures );
+    }
+
+    void OnCLServerLoadReceived ( CHostAddress InetAddr,
+                                  QString      strPool,
+                                  int          iNumClients,
+                                  int          iLoadPct )
+    {
+        ServerListManager.CentralServerSetServerLoad ( InetAddr, strPool, iNumClients, iLoadPct );
+    }
+
+    void OnCLFederationUpdateReceived ( CHostAddress                   InetAddr,
+                                        CVector<CFederationServerInfo> vecServerInfo )
+    {
+        ServerListManager.CentralServerFederationUpdate ( InetAddr, vecServerInfo );
+    }
+
+    void OnCLReqFederationSync ( CHostAddress InetAddr )
+    {
+        ServerListManager.CentralServerFederationSync ( InetAddr );
+    }
+
     void OnCLDisconnection ( CHostAddress InetAddr );
 
     void OnAboutToQuit();
 
     void OnHandledSignal ( int sigNum );
+
+    void OnRecordingFailed ( QString strReason );
+
+    void OnReplayFinished();
 };
@@ -0,0 +1,380 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "serverbenchmark.h"
+#include <QJsonObject>
+
+
+/* Implementation *************************************************************/
+QString CServerBenchmark::CConfig::GetName() const
+{
+    return QString ( "%1, %2, %3 samples server frame" ).
+        arg ( eAudComprType == CT_OPUS64 ? "OPUS64" : "OPUS" ).
+        arg ( iNumAudioChannels == 1 ? "mono" : "stereo" ).
+        arg ( bUseDoubleSystemFrameSize ? DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES : SYSTEM_FRAME_SIZE_SAMPLES );
+}
+
+CServerBenchmark::CServerBenchmark ( const int iNNumThreads ) :
+    iNumThreads ( iNNumThreads ),
+    iNumChannels ( 0 ),
+    iFrameCnt ( 0 )
+{
+    int iOpusError;
+
+    CMixKernel::Init();
+
+    // the same OPUS modes as in the server
+    OpusMode = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                         DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES,
+                                         &iOpusError );
+
+    Opus64Mode = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                           SYSTEM_FRAME_SIZE_SAMPLES,
+                                           &iOpusError );
+
+    for ( int i = 0; i < BENCHMARK_MAX_NUM_CHANNELS; i++ )
+    {
+        OpusCodecs[i].Init ( OpusMode, Opus64Mode );
+    }
+
+    if ( iNumThreads > 0 )
+    {
+        WorkerPool.Start ( iNumThreads );
+    }
+
+    // allocate worst case memory (double frame size, stereo), the audio
+    // buffers use the same frame arenas as the server
+    vecvecbyCodedFrames.Init ( BENCHMARK_NUM_CODED_FRAMES );
+    vecvecsData.Init         ( BENCHMARK_MAX_NUM_CHANNELS, 2 * MAX_CODEC_FRAME_SIZE_SAMPLES );
+    vecvecfData.Init         ( BENCHMARK_MAX_NUM_CHANNELS, 3 * MAX_CODEC_FRAME_SIZE_SAMPLES );
+    vecvecfMixData.Init      ( BENCHMARK_MAX_NUM_CHANNELS, 2 * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES );
+    vecvecsSendData.Init     ( BENCHMARK_MAX_NUM_CHANNELS, 2 * MAX_CODEC_FRAME_SIZE_SAMPLES );
+    vecvecbyCodedData.Init   ( BENCHMARK_MAX_NUM_CHANNELS );
+    vecfCommonMixData.Init   ( 3 * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES );
+
+    for ( int i = 0; i < BENCHMARK_NUM_CODED_FRAMES; i++ )
+    {
+        vecvecbyCodedFrames[i].Init ( MAX_SIZE_BYTES_NETW_BUF );
+    }
+
+    for ( int i = 0; i < BENCHMARK_MAX_NUM_CHANNELS; i++ )
+    {
+        vecvecbyCodedData[i].Init ( MAX_SIZE_BYTES_NETW_BUF );
+    }
+}
+
+CServerBenchmark::~CServerBenchmark()
+{
+    WorkerPool.Stop();
+
+    for ( int i = 0; i < BENCHMARK_MAX_NUM_CHANNELS; i++ )
+    {
+        OpusCodecs[i].Release();
+    }
+
+    opus_custom_mode_destroy ( OpusMode );
+    opus_custom_mode_destroy ( Opus64Mode );
+}
+
+void CServerBenchmark::Run ( QTextStream& tsConsole )
+{
+    tsConsole << "Server benchmark (" << GetNumThreads() <<
+        " threads, mixing kernel " << CMixKernel::GetImplementationName() << ")" << endl;
+
+    for ( int iFrameSize = 0; iFrameSize < 2; iFrameSize++ )
+    {
+        for ( int iCodec = 0; iCodec < 2; iCodec++ )
+        {
+            for ( int iAudChan = 1; iAudChan <= 2; iAudChan++ )
+            {
+                const CConfig Config ( iCodec == 0 ? CT_OPUS : CT_OPUS64,
+                                       iAudChan,
+                                       iFrameSize == 1 );
+
+                const int iMaxNumChannels = FindMaxNumChannels ( Config );
+
+                const bool bAtLeast = ( iMaxNumChannels >= BENCHMARK_MAX_NUM_CHANNELS );
+
+                tsConsole << "- " << Config.GetName() << ": " <<
+                    ( bAtLeast ? "at least " : "" ) << iMaxNumChannels << " channels" << endl;
+
+                QJsonObject jsonConfig;
+                jsonConfig["name"]     = Config.GetName();
+                jsonConfig["channels"] = iMaxNumChannels;
+                jsonConfig["at_least"] = bAtLeast;
+                jsonResults.append ( jsonConfig );
+            }
+        }
+    }
+}
+
+int CServerBenchmark::FindMaxNumChannels ( const CConfig& Config )
+{
+    // double the number of channels until the frame deadline is missed, then
+    // do a binary search between the last good and the first bad count
+    int iGood = 0;
+    int iBad  = 1;
+
+    while ( ( iBad <= BENCHMARK_MAX_NUM_CHANNELS ) && ( MeasureUsage ( Config, iBad ) < 1.0 ) )
+    {
+        iGood = iBad;
+        iBad  = 2 * iBad;
+    }
+
+    iBad = std::min ( iBad, BENCHMARK_MAX_NUM_CHANNELS + 1 );
+
+    while ( iBad - iGood > 1 )
+    {
+        const int iMid = ( iGood + iBad ) / 2;
+
+        if ( MeasureUsage ( Config, iMid ) < 1.0 )
+        {
+            iGood = iMid;
+        }
+        else
+        {
+            iBad = iMid;
+        }
+    }
+
+    return iGood;
+}
+
+void CServerBenchmark::Init ( const CConfig& Config,
+                              const int      iNNumChannels )
+{
+    int iOpusError;
+
+    eAudComprType           = Config.eAudComprType;
+    iNumAudioChannels       = Config.iNumAudioChannels;
+    iNumChannels            = iNNumChannels;
+    iServerFrameSizeSamples = Config.bUseDoubleSystemFrameSize ? DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES : SYSTEM_FRAME_SIZE_SAMPLES;
+    iFrameCnt               = 0;
+
+    // the clients use the normal audio quality
+    const bool bMono = ( iNumAudioChannels == 1 );
+
+    if ( eAudComprType == CT_OPUS64 )
+    {
+        iCodecFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
+        iCeltNumCodedBytes     = bMono ? OPUS_NUM_BYTES_MONO_NORMAL_QUALITY : OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY;
+    }
+    else
+    {
+        iCodecFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+        iCeltNumCodedBytes     = bMono ? OPUS_NUM_BYTES_MONO_NORMAL_QUALITY_DBLE_FRAMESIZE :
+                                         OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY_DBLE_FRAMESIZE;
+    }
+
+    // like the frame size adapter of the server: either several codec blocks
+    // per server frame or one codec block for several server frames
+    iNumCodecBlocks    = std::max ( 1, iServerFrameSizeSamples / iCodecFrameSizeSamples );
+    iNumFramesPerBlock = std::max ( 1, iCodecFrameSizeSamples / iServerFrameSizeSamples );
+
+    // the coded test signal (a tone with noise) which is sent by all channels
+    OpusCustomEncoder* pEncoder = opus_custom_encoder_create ( eAudComprType == CT_OPUS64 ? Opus64Mode : OpusMode,
+                                                               iNumAudioChannels,
+                                                               &iOpusError );
+
+    opus_custom_encoder_ctl ( pEncoder, OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( pEncoder,
+                              OPUS_SET_BITRATE ( CalcBitRateBitsPerSecFromCodedBytes ( iCeltNumCodedBytes, iCodecFrameSizeSamples ) ) );
+
+    CVector<int16_t> vecsSignal ( iNumAudioChannels * iCodecFrameSizeSamples );
+
+    for ( int iF = 0; iF < BENCHMARK_NUM_CODED_FRAMES; iF++ )
+    {
+        for ( int i = 0; i < vecsSignal.Size(); i++ )
+        {
+            const int iSample = iF * iCodecFrameSizeSamples + i / iNumAudioChannels;
+
+            vecsSignal[i] = static_cast<int16_t> ( 3000 * sin ( 0.05 * iSample ) + ( rand() % 1000 ) - 500 );
+        }
+
+        opus_custom_encode ( pEncoder,
+                             &vecsSignal[0],
+                             iCodecFrameSizeSamples,
+                             &vecvecbyCodedFrames[iF][0],
+                             iCeltNumCodedBytes );
+    }
+
+    opus_custom_encoder_destroy ( pEncoder );
+}
+
+double CServerBenchmark::MeasureUsage ( const CConfig& Config,
+                                        const int      iNNumChannels )
+{
+    QElapsedTimer Timer;
+
+    Init ( Config, iNNumChannels );
+
+    // one frame without measurement (the codecs are allocated on demand)
+    ProcessFrame();
+
+    Timer.start();
+
+    qint64 iNumFrames = 0;
+
+    while ( Timer.elapsed() < BENCHMARK_MEASURE_TIME_MS )
+    {
+        ProcessFrame();
+        iNumFrames++;
+    }
+
+    const double dFrameDurNs = 1e9 * iServerFrameSizeSamples / SYSTEM_SAMPLE_RATE_HZ;
+
+    return static_cast<double> ( Timer.nsecsElapsed() ) / iNumFrames / dFrameDurNs;
+}
+
+void CServerBenchmark::ProcessFrame()
+{
+    // decode the received data
+    if ( iNumThreads > 0 )
+    {
+        WorkerPool.Run ( [this] ( const int iChanIdx ) { DecodeChannel ( iChanIdx ); }, iNumChannels );
+    }
+    else
+    {
+        for ( int i = 0; i < iNumChannels; i++ )
+        {
+            DecodeChannel ( i );
+        }
+    }
+
+    // common mix of all channels
+    vecfCommonMixData.Reset ( 0 );
+
+    for ( int j = 0; j < iNumChannels; j++ )
+    {
+        const int iRightOffs = ( iNumAudioChannels == 1 ) ? 0 : iServerFrameSizeSamples;
+        const int iMonoOffs  = ( iNumAudioChannels == 1 ) ? 0 : 2 * iServerFrameSizeSamples;
+
+        CMixKernel::MixAdd ( &vecfCommonMixData[0],                           &vecvecfData[j][0],          1.0f, iServerFrameSizeSamples );
+        CMixKernel::MixAdd ( &vecfCommonMixData[iServerFrameSizeSamples],     &vecvecfData[j][iRightOffs], 1.0f, iServerFrameSizeSamples );
+        CMixKernel::MixAdd ( &vecfCommonMixData[2 * iServerFrameSizeSamples], &vecvecfData[j][iMonoOffs],  1.0f, iServerFrameSizeSamples );
+    }
+
+    // mix and encode the data for each listener
+    if ( iNumThreads > 0 )
+    {
+        WorkerPool.Run ( [this] ( const int iChanIdx ) { MixEncodeChannel ( iChanIdx ); }, iNumChannels );
+    }
+    else
+    {
+        for ( int i = 0; i < iNumChannels; i++ )
+        {
+            MixEncodeChannel ( i );
+        }
+    }
+
+    iFrameCnt++;
+}
+
+void CServerBenchmark::DecodeChannel ( const int iChanIdx )
+{
+    const int iFrameInBlock = static_cast<int> ( iFrameCnt % iNumFramesPerBlock );
+
+    // a new codec block is needed on the first server frame of the block
+    if ( iFrameInBlock == 0 )
+    {
+        OpusCustomDecoder* pDecoder = OpusCodecs[iChanIdx].GetDecoder ( eAudComprType, iNumAudioChannels );
+
+        for ( int iB = 0; iB < iNumCodecBlocks; iB++ )
+        {
+            const int iCodedFrame = static_cast<int> ( ( iFrameCnt + iB + iChanIdx ) % BENCHMARK_NUM_CODED_FRAMES );
+
+            opus_custom_decode ( pDecoder,
+                                 &vecvecbyCodedFrames[iCodedFrame][0],
+                                 iCeltNumCodedBytes,
+                                 &vecvecsData[iChanIdx][iB * iNumAudioChannels * iCodecFrameSizeSamples],
+                                 iCodecFrameSizeSamples );
+        }
+    }
+
+    // planar float buffers of the current server frame
+    const int16_t* psData = &vecvecsData[iChanIdx][iFrameInBlock * iNumAudioChannels * iServerFrameSizeSamples];
+
+    if ( iNumAudioChannels == 1 )
+    {
+        CMixKernel::ShortToFloatMono ( psData, &vecvecfData[iChanIdx][0], iServerFrameSizeSamples );
+    }
+    else
+    {
+        CMixKernel::ShortToFloatStereo ( psData,
+                                         &vecvecfData[iChanIdx][0],
+                                         &vecvecfData[iChanIdx][iServerFrameSizeSamples],
+                                         &vecvecfData[iChanIdx][2 * iServerFrameSizeSamples],
+                                         iServerFrameSizeSamples );
+    }
+}
+
+void CServerBenchmark::MixEncodeChannel ( const int iChanIdx )
+{
+    const int   iFrameInBlock = static_cast<int> ( iFrameCnt % iNumFramesPerBlock );
+    float*      pfMixLeft     = &vecvecfMixData[iChanIdx][0];
+    float*      pfMixRight    = &vecvecfMixData[iChanIdx][iServerFrameSizeSamples];
+    int16_t*    psOut         = &vecvecsSendData[iChanIdx][iFrameInBlock * iNumAudioChannels * iServerFrameSizeSamples];
+    const float fOwnGainDiff  = -0.5f; // the own channel is attenuated (typical listener mix)
+
+    // the listener mix is the common mix with one gain correction
+    if ( iNumAudioChannels == 1 )
+    {
+        std::copy ( &vecfCommonMixData[2 * iServerFrameSizeSamples],
+                    &vecfCommonMixData[2 * iServerFrameSizeSamples] + iServerFrameSizeSamples,
+                    pfMixLeft );
+
+        CMixKernel::MixAdd ( pfMixLeft, &vecvecfData[iChanIdx][0], fOwnGainDiff, iServerFrameSizeSamples );
+        CMixKernel::FloatToShortMono ( pfMixLeft, psOut, iServerFrameSizeSamples );
+    }
+    else
+    {
+        std::copy ( &vecfCommonMixData[0],
+                    &vecfCommonMixData[0] + 2 * iServerFrameSizeSamples,
+                    pfMixLeft );
+
+        CMixKernel::MixAdd ( pfMixLeft,  &vecvecfData[iChanIdx][0],                       fOwnGainDiff, iServerFrameSizeSamples );
+        CMixKernel::MixAdd ( pfMixRight, &vecvecfData[iChanIdx][iServerFrameSizeSamples], fOwnGainDiff, iServerFrameSizeSamples );
+        CMixKernel::FloatToShortStereo ( pfMixLeft, pfMixRight, psOut, iServerFrameSizeSamples );
+    }
+
+    // a codec block is encoded when it is complete
+    if ( iFrameInBlock == iNumFramesPerBlock - 1 )
+    {
+        OpusCustomEncoder* pEncoder = OpusCodecs[iChanIdx].GetEncoder ( eAudComprType,
+                                                                        iNumAudioChannels,
+                                                                        iCeltNumCodedBytes,
+                                                                        EL_NORMAL,
+                                                                        CChannelNetStats() );
+
+        for ( int iB = 0; iB < iNumCodecBlocks; iB++ )
+        {
+            opus_custom_encode ( pEncoder,
+                                 &vecvecsSendData[iChanIdx][iB * iNumAudioChannels * iCodecFrameSizeSamples],
+                                 iCodecFrameSizeSamples,
+                                 &vecvecbyCodedData[iChanIdx][0],
+                                 iCeltNumCodedBytes );
+        }
+    }
+}
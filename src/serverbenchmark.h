@@ -0,0 +1,128 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QString>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QJsonArray>
+#include "global.h"
+#include "util.h"
+#include "mixkernel.h"
+#include "client.h"
+#include "server.h"
+
+
+/* Definitions ****************************************************************/
+// the measurement of one channel count runs at least this time
+#define BENCHMARK_MEASURE_TIME_MS        200
+
+// upper limit of the channel count search (the result may be larger than the
+// number of channels of one server instance)
+#define BENCHMARK_MAX_NUM_CHANNELS       ( 2 * MAX_NUM_CHANNELS )
+
+// number of different coded frames of the test signal of each channel
+#define BENCHMARK_NUM_CODED_FRAMES       16
+
+
+/* Classes ********************************************************************/
+// Offline benchmark of the server audio processing. It runs the same stages
+// as the server timer (decode, common mix, listener mixes and encode) with
+// the server codecs and the worker pool on fake channels, without socket and
+// timer, as fast as possible. The result is the maximum number of channels
+// for which a frame is processed within its duration.
+class CServerBenchmark
+{
+public:
+    CServerBenchmark ( const int iNNumThreads );
+    virtual ~CServerBenchmark();
+
+    // runs all configurations and writes the results
+    void Run ( QTextStream& tsConsole );
+
+    // the results of the configurations, each entry has the name and the
+    // maximum number of channels (at_least is set if the search limit was
+    // reached)
+    const QJsonArray& GetResults() const { return jsonResults; }
+
+    int GetNumThreads() const { return iNumThreads > 0 ? WorkerPool.GetNumThreads() : 1; }
+
+protected:
+    class CConfig
+    {
+    public:
+        CConfig ( const EAudComprType eNAudComprType,
+                  const int           iNNumAudioChannels,
+                  const bool          bNUseDoubleSystemFrameSize ) :
+            eAudComprType ( eNAudComprType ),
+            iNumAudioChannels ( iNNumAudioChannels ),
+            bUseDoubleSystemFrameSize ( bNUseDoubleSystemFrameSize ) {}
+
+        QString GetName() const;
+
+        EAudComprType eAudComprType;
+        int           iNumAudioChannels;
+        bool          bUseDoubleSystemFrameSize;
+    };
+
+    void   Init ( const CConfig& Config, const int iNNumChannels );
+    int    FindMaxNumChannels ( const CConfig& Config );
+
+    // returns the average processing time of a frame relative to the frame
+    // duration
+    double MeasureUsage ( const CConfig& Config, const int iNNumChannels );
+
+    void   ProcessFrame();
+    void   DecodeChannel ( const int iChanIdx );
+    void   MixEncodeChannel ( const int iChanIdx );
+
+    int                        iNumThreads;
+    CServerWorkerPool          WorkerPool;
+    OpusCustomMode*            OpusMode;
+    OpusCustomMode*            Opus64Mode;
+    CServerOpusCodecs          OpusCodecs[BENCHMARK_MAX_NUM_CHANNELS];
+
+    // state of the current measurement
+    EAudComprType              eAudComprType;
+    int                        iNumChannels;
+    int                        iNumAudioChannels;
+    int                        iServerFrameSizeSamples;
+    int                        iCodecFrameSizeSamples;
+    int                        iCeltNumCodedBytes;
+    int                        iNumCodecBlocks;    // codec blocks per server frame
+    int                        iNumFramesPerBlock; // server frames per codec block
+    qint64                     iFrameCnt;
+
+    CVector<CVector<uint8_t> > vecvecbyCodedFrames;
+    CServerFrameArena<int16_t> vecvecsData;
+    CServerFrameArena<float>   vecvecfData;
+    CVector<float>             vecfCommonMixData;
+    CServerFrameArena<float>   vecvecfMixData;
+    CServerFrameArena<int16_t> vecvecsSendData;
+    CVector<CVector<uint8_t> > vecvecbyCodedData;
+
+    QJsonArray                 jsonResults;
+};
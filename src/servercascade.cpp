@@ -0,0 +1,212 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "servercascade.h"
+#include "mixkernel.h"
+
+
+/* Implementation *************************************************************/
+CServerCascade::CServerCascade ( CHighPrioSocket* pNSocket ) :
+    pSocket            ( pNSocket ),
+    Channel            ( false ), // the link behaves like a client
+    bIsEnabled         ( false ),
+    pEncoder           ( nullptr ),
+    pDecoder           ( nullptr ),
+    iFrameSizeSamples  ( 0 ),
+    iCeltNumCodedBytes ( 0 )
+{
+    // connections for the protocol mechanism
+    QObject::connect ( &Channel, &CChannel::MessReadyForSending,
+        this, &CServerCascade::OnSendProtMessage );
+
+    QObject::connect ( &Channel, &CChannel::ReqJittBufSize,
+        this, &CServerCascade::OnReqJittBufSize );
+
+    QObject::connect ( &Channel, &CChannel::ReqChanInfo,
+        this, &CServerCascade::OnReqChanInfo );
+
+    QObject::connect ( &Channel, &CChannel::ClientIDReceived,
+        this, &CServerCascade::OnClientIDReceived );
+
+    // the new connection is detected in the socket thread, the protocol
+    // messages are created in the main thread (queued connection)
+    QObject::connect ( this, &CServerCascade::NewConnection,
+        this, &CServerCascade::OnNewConnection, Qt::QueuedConnection );
+}
+
+CServerCascade::~CServerCascade()
+{
+    if ( pEncoder != nullptr )
+    {
+        opus_custom_encoder_destroy ( pEncoder );
+    }
+
+    if ( pDecoder != nullptr )
+    {
+        opus_custom_decoder_destroy ( pDecoder );
+    }
+}
+
+void CServerCascade::Start ( const QString&  strParentAddress,
+                             const QString&  strChannelName,
+                             const int       iNServerFrameSizeSamples,
+                             OpusCustomMode* pOpusMode,
+                             OpusCustomMode* pOpus64Mode )
+{
+    int          iOpusError;
+    CHostAddress ParentAddr;
+
+    if ( !NetworkUtil().ParseNetworkAddress ( strParentAddress, ParentAddr ) )
+    {
+        throw CGenErr ( "Invalid address of the parent server: " + strParentAddress );
+    }
+
+    // the stream to the parent server uses the frame size of this server so
+    // that one frame is sent and received per server timer tick
+    iFrameSizeSamples = iNServerFrameSizeSamples;
+
+    const EAudComprType eAudComprType = ( iFrameSizeSamples == SYSTEM_FRAME_SIZE_SAMPLES ) ? CT_OPUS64 : CT_OPUS;
+
+    if ( eAudComprType == CT_OPUS64 )
+    {
+        iCeltNumCodedBytes = CASCADE_NUM_CODED_BYTES;
+        pEncoder           = opus_custom_encoder_create ( pOpus64Mode, 2, &iOpusError );
+        pDecoder           = opus_custom_decoder_create ( pOpus64Mode, 2, &iOpusError );
+    }
+    else
+    {
+        iCeltNumCodedBytes = CASCADE_NUM_CODED_BYTES_DBLE_FRAMESIZE;
+        pEncoder           = opus_custom_encoder_create ( pOpusMode, 2, &iOpusError );
+        pDecoder           = opus_custom_decoder_create ( pOpusMode, 2, &iOpusError );
+    }
+
+    opus_custom_encoder_ctl ( pEncoder, OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( pEncoder,
+                              OPUS_SET_BITRATE ( CalcBitRateBitsPerSecFromCodedBytes ( iCeltNumCodedBytes, iFrameSizeSamples ) ) );
+
+    vecsSendData.Init    ( 2 /* stereo */ * iFrameSizeSamples );
+    vecsReceiveData.Init ( 2 /* stereo */ * iFrameSizeSamples );
+    vecbyCodedData.Init  ( iCeltNumCodedBytes );
+    vecbyNetwData.Init   ( iCeltNumCodedBytes );
+    vecfReturnData.Init  ( 3 * iFrameSizeSamples, 0.0f );
+
+    // the name of the channel at the parent server
+    ChannelInfo.strName = strChannelName.isEmpty() ? QString ( CASCADE_DEFAULT_CHANNEL_NAME ) :
+                                                     strChannelName.left ( MAX_LEN_FADER_TAG );
+
+    // the link always uses the auto jitter buffer
+    Channel.SetDoAutoSockBufSize ( true );
+    Channel.SetAudioStreamProperties ( eAudComprType,
+                                       iCeltNumCodedBytes,
+                                       1, // frame size factor
+                                       2, // stereo
+                                       false ); // no redundancy
+
+    Channel.SetAddress ( ParentAddr );
+    Channel.SetEnable ( true );
+
+    bIsEnabled = true;
+}
+
+void CServerCascade::PutAudioData ( const CVector<uint8_t>& vecbyData,
+                                    const int               iNumBytes,
+                                    const CHostAddress&     HostAddr )
+{
+    if ( Channel.PutAudioData ( vecbyData, iNumBytes, HostAddr ) == PS_NEW_CONNECTION )
+    {
+        emit NewConnection();
+    }
+}
+
+void CServerCascade::OnNewConnection()
+{
+    // as for a client, the infos are sent on a new connection without waiting
+    // for the requests of the parent server
+    OnReqChanInfo();
+    OnReqJittBufSize();
+}
+
+void CServerCascade::OnClientIDReceived ( int iChanID )
+{
+    // the parent server shall not send our own stream back to us since the
+    // local mix is already contained in the mixes of the local clients
+    Channel.SetRemoteChanGain ( iChanID, 0.0 );
+}
+
+void CServerCascade::Process ( const float* pfLocalMixLeft,
+                               const float* pfLocalMixRight )
+{
+    unsigned char* pCurCodedData = nullptr;
+    int            iNumCodedBytes;
+
+    // send the local mix to the parent server (the packet is put in the send
+    // queue of the socket which is flushed by the server timer)
+    CMixKernel::FloatToShortStereo ( pfLocalMixLeft,
+                                     pfLocalMixRight,
+                                     &vecsSendData[0],
+                                     iFrameSizeSamples );
+
+    opus_custom_encode ( pEncoder,
+                         &vecsSendData[0],
+                         iFrameSizeSamples,
+                         &vecbyCodedData[0],
+                         iCeltNumCodedBytes );
+
+    Channel.PrepAndSendPacket ( pSocket,
+                                vecbyCodedData,
+                                iCeltNumCodedBytes,
+                                vecbyCodedData,
+                                0, // no redundancy
+                                true ); // use send queue
+
+    // get the mix of the parent server
+    const EGetDataStat eGetStat = Channel.GetData ( vecbyNetwData, iCeltNumCodedBytes, iNumCodedBytes );
+
+    if ( eGetStat == GS_BUFFER_OK )
+    {
+        pCurCodedData = &vecbyNetwData[0];
+    }
+
+    if ( ( eGetStat == GS_BUFFER_OK ) || ( eGetStat == GS_BUFFER_UNDERRUN ) )
+    {
+        // for lost packets the null pointer invokes the packet loss concealment
+        opus_custom_decode ( pDecoder,
+                             pCurCodedData,
+                             iNumCodedBytes,
+                             &vecsReceiveData[0],
+                             iFrameSizeSamples );
+
+        CMixKernel::ShortToFloatStereo ( &vecsReceiveData[0],
+                                         &vecfReturnData[0],
+                                         &vecfReturnData[iFrameSizeSamples],
+                                         &vecfReturnData[2 * iFrameSizeSamples],
+                                         iFrameSizeSamples );
+    }
+    else
+    {
+        // the link is not connected
+        vecfReturnData.Reset ( 0.0f );
+    }
+}
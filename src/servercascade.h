@@ -0,0 +1,134 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#ifdef USE_OPUS_SHARED_LIB
+# include "opus/opus_custom.h"
+#else
+# include "opus_custom.h"
+#endif
+#include "global.h"
+#include "util.h"
+#include "socket.h"
+#include "channel.h"
+
+
+/* Definitions ****************************************************************/
+// number of coded bytes of the stereo stream to the parent server (the same as
+// the high quality stereo setting of the client)
+#define CASCADE_NUM_CODED_BYTES                   73
+#define CASCADE_NUM_CODED_BYTES_DBLE_FRAMESIZE    142
+
+// default name of the cascade channel at the parent server if the server has
+// no name
+#define CASCADE_DEFAULT_CHANNEL_NAME              "Cascade"
+
+
+/* Classes ********************************************************************/
+// Link of a child server to its parent server. The child server connects to
+// the parent server like a regular client: it sends the common mix of its local
+// clients as one stereo stream and receives the mix of the parent server which
+// is then added to the mixes of the local clients. The own stream is muted in
+// the mix which the parent server sends to us, i.e. there is no echo of the
+// local clients and the cascade can be nested.
+// The audio is processed in the server timer, the protocol of the link is
+// processed in the main thread (as for the server channels).
+class CServerCascade : public QObject
+{
+    Q_OBJECT
+
+public:
+    CServerCascade ( CHighPrioSocket* pNSocket );
+    virtual ~CServerCascade();
+
+    // the address of the parent server has the format address[:port], throws
+    // an error if the address is invalid
+    void Start ( const QString&  strParentAddress,
+                 const QString&  strChannelName,
+                 const int       iNServerFrameSizeSamples,
+                 OpusCustomMode* pOpusMode,
+                 OpusCustomMode* pOpus64Mode );
+
+    bool IsEnabled() const { return bIsEnabled; }
+    bool IsConnected() const { return Channel.IsConnected(); }
+    const CHostAddress& GetParentAddress() const { return Channel.GetAddress(); }
+
+    bool IsParentAddress ( const CHostAddress& HostAddr ) const
+        { return bIsEnabled && ( HostAddr == Channel.GetAddress() ); }
+
+    // called by the socket thread for the packets of the parent server
+    void PutAudioData ( const CVector<uint8_t>& vecbyData,
+                        const int               iNumBytes,
+                        const CHostAddress&     HostAddr );
+
+    // called in the main thread for the protocol messages of the parent server
+    void PutProtcolData ( const int               iRecCounter,
+                          const int               iRecID,
+                          const CVector<uint8_t>& vecbyMesBodyData,
+                          const CHostAddress&     HostAddr )
+        { Channel.PutProtcolData ( iRecCounter, iRecID, vecbyMesBodyData, HostAddr ); }
+
+    // called by the server timer: sends the local mix (planar float buffers
+    // with the server frame size) to the parent server and decodes the mix of
+    // the parent server (the packets are sent on the flush of the send queue)
+    void Process ( const float* pfLocalMixLeft,
+                   const float* pfLocalMixRight );
+
+    // mix of the parent server of the last Process() call (planes: left,
+    // right and mono down-mix), silence if the link is not connected
+    const CVector<float>& GetReturnData() const { return vecfReturnData; }
+
+protected:
+    CHighPrioSocket*   pSocket;
+    CChannel           Channel;
+    CChannelCoreInfo   ChannelInfo;
+    bool               bIsEnabled;
+
+    OpusCustomEncoder* pEncoder;
+    OpusCustomDecoder* pDecoder;
+    int                iFrameSizeSamples;
+    int                iCeltNumCodedBytes;
+
+    CVector<int16_t>   vecsSendData;
+    CVector<int16_t>   vecsReceiveData;
+    CVector<uint8_t>   vecbyCodedData;
+    CVector<uint8_t>   vecbyNetwData;
+    CVector<float>     vecfReturnData;
+
+signals:
+    void NewConnection();
+
+public slots:
+    void OnSendProtMessage ( CProtMessage Message )
+        { pSocket->SendPacket ( Message, Channel.GetAddress() ); }
+
+    void OnNewConnection();
+    void OnReqJittBufSize() { Channel.CreateJitBufMes ( AUTO_NET_BUF_SIZE_FOR_PROTOCOL ); }
+    void OnReqChanInfo() { Channel.SetRemoteInfo ( ChannelInfo ); }
+    void OnClientIDReceived ( int iChanID );
+};
@@ -189,11 +189,12 @@ CServerDlg::CServerDlg ( CServer*        pNServP,
     // set up list view for connected clients
     lvwClients->setColumnWidth ( 0, 170 );
     lvwClients->setColumnWidth ( 1, 200 );
+    lvwClients->setColumnWidth ( 2, 130 );
     lvwClients->clear();
 
 
 // TEST workaround for resize problem of window after iconize in task bar
-lvwClients->setMinimumWidth ( 170 + 130 + 60 + 205 );
+lvwClients->setMinimumWidth ( 170 + 130 + 60 + 205 + 100 );
 lvwClients->setMinimumHeight ( 140 );
 
 
@@ -554,13 +555,17 @@ void CServerDlg::OnTimer()
     CVector<QString>      vecsName;
     CVector<int>          veciJitBufNumFrames;
     CVector<int>          veciNetwFrameSizeFact;
+    CVector<int>          veciRttMs;
+    CVector<int>          veciRttJitterMs;
 
     ListViewMutex.lock();
     {
         pServer->GetConCliParam ( vecHostAddresses,
                                   vecsName,
                                   veciJitBufNumFrames,
-                                  veciNetwFrameSizeFact );
+                                  veciNetwFrameSizeFact,
+                                  veciRttMs,
+                                  veciRttJitterMs );
 
         // we assume that all vectors have the same length
         const int iNumChannels = vecHostAddresses.Size();
@@ -568,7 +573,7 @@ void CServerDlg::OnTimer()
         // fill list with connected clients
         for ( int i = 0; i < iNumChannels; i++ )
         {
-            if ( !( vecHostAddresses[i].InetAddr == QHostAddress ( static_cast<quint32> ( 0 ) ) ) )
+            if ( !vecHostAddresses[i].IsSameInetAddr ( CHostAddress() ) )
             {
                 // IP, port number
                 vecpListViewItems[i]->setText ( 0,
@@ -581,6 +586,18 @@ void CServerDlg::OnTimer()
                 vecpListViewItems[i]->setText ( 2,
                     QString().setNum ( veciJitBufNumFrames[i] ) );
 
+                // round trip time and its jitter (old clients do not answer
+                // the measurement)
+                if ( veciRttMs[i] >= 0 )
+                {
+                    vecpListViewItems[i]->setText ( 3,
+                        QString ( "%1 ms (%2 ms)" ).arg ( veciRttMs[i] ).arg ( veciRttJitterMs[i] ) );
+                }
+                else
+                {
+                    vecpListViewItems[i]->setText ( 3, "" );
+                }
+
                 vecpListViewItems[i]->setHidden ( false );
             }
             else
@@ -590,6 +607,10 @@ void CServerDlg::OnTimer()
         }
     }
     ListViewMutex.unlock();
+
+    // show the frame stage profile of the server (if enabled) as the tool tip
+    // of the client list
+    lvwClients->setToolTip ( pServer->GetFrameProfileReport() );
 }
 
 void CServerDlg::UpdateGUIDependencies()
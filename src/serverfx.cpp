@@ -0,0 +1,212 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "serverfx.h"
+
+
+/* Implementation *************************************************************/
+// CServerFxSettings implementation --------------------------------------------
+bool CServerFxSettings::Parse ( const QString& strSettings )
+{
+    const QStringList slItems = strSettings.split ( ",", QString::SkipEmptyParts );
+
+    *this = CServerFxSettings();
+
+    for ( int i = 0; i < slItems.size(); i++ )
+    {
+        const QStringList slKeyValue = slItems[i].trimmed().split ( "=" );
+        const QString     strKey     = slKeyValue[0].trimmed().toLower();
+        bool              bOK        = true;
+        double            dValue     = 0.0;
+
+        if ( slKeyValue.size() > 2 )
+        {
+            return false;
+        }
+
+        if ( slKeyValue.size() == 2 )
+        {
+            dValue = slKeyValue[1].trimmed().toDouble ( &bOK );
+        }
+
+        if ( !bOK )
+        {
+            return false;
+        }
+
+        if ( ( strKey == "gain" ) && ( slKeyValue.size() == 2 ) &&
+             ( fabs ( dValue ) <= SERVER_FX_MAX_GAIN_DB ) )
+        {
+            dGainDB = dValue;
+        }
+        else if ( ( strKey == "comp" ) && ( slKeyValue.size() == 1 ) )
+        {
+            bCompressor = true;
+        }
+        else if ( ( strKey == "reverb" ) && ( slKeyValue.size() == 2 ) &&
+                  ( dValue >= 0.0 ) && ( dValue <= 100.0 ) )
+        {
+            dReverbSend = dValue / 100;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QString CServerFxSettings::ToString() const
+{
+    QStringList slItems;
+
+    if ( dGainDB != 0.0 )
+    {
+        slItems << QString ( "gain %1 dB" ).arg ( dGainDB );
+    }
+
+    if ( bCompressor )
+    {
+        slItems << "compressor";
+    }
+
+    if ( IsReverbEnabled() )
+    {
+        slItems << QString ( "reverb send %1 %" ).arg ( 100 * dReverbSend );
+    }
+
+    return slItems.join ( ", " );
+}
+
+
+// CServerChannelFx implementation ---------------------------------------------
+void CServerChannelFx::Init ( const CServerFxSettings& Settings,
+                              const int                iNFrameSizeSamples )
+{
+    iFrameSizeSamples = iNFrameSizeSamples;
+    fGain             = static_cast<float> ( pow ( 10.0, Settings.dGainDB / 20 ) );
+    bCompressor       = Settings.bCompressor;
+
+    // the compressor works on the peak value of each frame, the envelope
+    // time constants are therefore given in frames
+    const double dFrameDurMs = 1000.0 * iFrameSizeSamples / SYSTEM_SAMPLE_RATE_HZ;
+
+    fThreshold    = static_cast<float> ( _MAXSHORT * pow ( 10.0, SERVER_FX_COMP_THRESHOLD_DB / 20 ) );
+    fSlope        = static_cast<float> ( 1.0 - 1.0 / SERVER_FX_COMP_RATIO );
+    fAttackCoeff  = static_cast<float> ( exp ( -dFrameDurMs / SERVER_FX_COMP_ATTACK_MS ) );
+    fReleaseCoeff = static_cast<float> ( exp ( -dFrameDurMs / SERVER_FX_COMP_RELEASE_MS ) );
+
+    Reset();
+}
+
+void CServerChannelFx::Process ( float*     pfData,
+                                 const bool bStereo )
+{
+    // for mono data only the first plane is used
+    const int iNumPlanes = bStereo ? 3 : 1;
+    float     fNewGain   = fGain;
+
+    if ( bCompressor )
+    {
+        // the peak value of the left and right channel is used for both
+        // channels so that the stereo image is not changed
+        float fPeak = fGain * CMixKernel::MaxAbs ( pfData, iFrameSizeSamples );
+
+        if ( bStereo )
+        {
+            fPeak = std::max ( fPeak, fGain * CMixKernel::MaxAbs ( &pfData[iFrameSizeSamples], iFrameSizeSamples ) );
+        }
+
+        const float fCoeff = ( fPeak > fEnvelope ) ? fAttackCoeff : fReleaseCoeff;
+
+        fEnvelope = fCoeff * fEnvelope + ( 1.0f - fCoeff ) * fPeak;
+
+        // above the threshold the level is reduced by the ratio:
+        // gain = ( threshold / envelope ) ^ ( 1 - 1 / ratio )
+        if ( fEnvelope > fThreshold )
+        {
+            fNewGain *= powf ( fThreshold / fEnvelope, fSlope );
+        }
+    }
+
+    if ( ( fNewGain == 1.0f ) && ( fLastGain == 1.0f ) )
+    {
+        return;
+    }
+
+    // linear gain ramp from the gain of the last frame to the new gain
+    const float fGainStep = ( fNewGain - fLastGain ) / iFrameSizeSamples;
+
+    for ( int iP = 0; iP < iNumPlanes; iP++ )
+    {
+        float* pfPlane = &pfData[iP * iFrameSizeSamples];
+
+        for ( int i = 0; i < iFrameSizeSamples; i++ )
+        {
+            pfPlane[i] *= fLastGain + fGainStep * ( i + 1 );
+        }
+    }
+
+    fLastGain = fNewGain;
+}
+
+
+// CServerReverbBus implementation ---------------------------------------------
+void CServerReverbBus::Init ( const int iNFrameSizeSamples )
+{
+    iFrameSizeSamples = iNFrameSizeSamples;
+
+    // the reverb works on interleaved stereo data, the mono send signal is
+    // used on both channels
+    Reverb.Init ( CC_STEREO, 2 * iFrameSizeSamples, SYSTEM_SAMPLE_RATE_HZ, SERVER_FX_REVERB_T60_S );
+
+    vecfSendData.Init   ( iFrameSizeSamples, 0 );
+    vecfStereoData.Init ( 2 * iFrameSizeSamples );
+    vecfReturnData.Init ( 3 * iFrameSizeSamples, 0 );
+}
+
+void CServerReverbBus::Process()
+{
+    for ( int i = 0; i < iFrameSizeSamples; i++ )
+    {
+        vecfStereoData[2 * i]     = vecfSendData[i];
+        vecfStereoData[2 * i + 1] = vecfSendData[i];
+    }
+
+    // only the wet signal is used for the return
+    Reverb.Process ( vecfStereoData, false, 1.0 );
+
+    float* pfLeft  = &vecfReturnData[0];
+    float* pfRight = &vecfReturnData[iFrameSizeSamples];
+    float* pfMono  = &vecfReturnData[2 * iFrameSizeSamples];
+
+    for ( int i = 0; i < iFrameSizeSamples; i++ )
+    {
+        pfLeft[i]  = vecfStereoData[2 * i];
+        pfRight[i] = vecfStereoData[2 * i + 1];
+        pfMono[i]  = 0.5f * ( pfLeft[i] + pfRight[i] );
+    }
+}
@@ -0,0 +1,134 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <cmath>
+#include "global.h"
+#include "util.h"
+#include "mixkernel.h"
+
+
+/* Definitions ****************************************************************/
+// compressor of the channel insert chain (the level is relative to the full
+// scale of the int16 samples)
+#define SERVER_FX_COMP_THRESHOLD_DB      -18.0
+#define SERVER_FX_COMP_RATIO             4.0
+#define SERVER_FX_COMP_ATTACK_MS         5
+#define SERVER_FX_COMP_RELEASE_MS        150
+
+// reverberation time of the shared reverb bus
+#define SERVER_FX_REVERB_T60_S           1.6
+
+// limits of the insert chain settings
+#define SERVER_FX_MAX_GAIN_DB            12.0
+
+
+/* Classes ********************************************************************/
+// Settings of the optional insert chain which is applied on each client
+// channel at the server. The settings are given as a comma separated list,
+// e.g. "gain=-3,comp,reverb=20" (gain is in dB, the reverb send in percent).
+class CServerFxSettings
+{
+public:
+    CServerFxSettings() : dGainDB ( 0.0 ), bCompressor ( false ), dReverbSend ( 0.0 ) {}
+
+    // returns false if the settings string is invalid
+    bool Parse ( const QString& strSettings );
+
+    bool IsEnabled() const { return ( dGainDB != 0.0 ) || bCompressor || IsReverbEnabled(); }
+    bool IsReverbEnabled() const { return dReverbSend > 0.0; }
+
+    QString ToString() const;
+
+    double dGainDB;
+    bool   bCompressor;
+    double dReverbSend; // 0..1
+};
+
+
+// State of the insert chain of one channel (gain and compressor). The gain
+// is applied on all planes of the decoded data (left, right and mono
+// down-mix) so that the planes stay consistent. The compressor gain is
+// calculated once per frame from the peak value and is ramped over the frame
+// to avoid zipper noise.
+class CServerChannelFx
+{
+public:
+    CServerChannelFx() : iFrameSizeSamples ( 0 ), fGain ( 1.0f ), bCompressor ( false ) { Reset(); }
+
+    void Init ( const CServerFxSettings& Settings,
+                const int                iNFrameSizeSamples );
+
+    // reset the compressor state (e.g. on a new connection)
+    void Reset() { fEnvelope = 0.0f; fLastGain = fGain; }
+
+    void Process ( float*     pfData,
+                   const bool bStereo );
+
+protected:
+    int   iFrameSizeSamples;
+    float fGain;
+    bool  bCompressor;
+    float fThreshold;
+    float fSlope;
+    float fAttackCoeff;
+    float fReleaseCoeff;
+    float fEnvelope;
+    float fLastGain;
+};
+
+
+// Shared reverb bus of the server. All clients send their mono down-mix with
+// the send gain to the bus, the reverb is then processed once per frame
+// (instead of once per client) and the stereo return is added to all mixes.
+class CServerReverbBus
+{
+public:
+    CServerReverbBus() : iFrameSizeSamples ( 0 ) {}
+
+    void Init ( const int iNFrameSizeSamples );
+
+    void ClearSend() { vecfSendData.Reset ( 0 ); }
+
+    void AddSend ( const float* pfMono,
+                   const float  fSendGain )
+        { CMixKernel::MixAdd ( &vecfSendData[0], pfMono, fSendGain, iFrameSizeSamples ); }
+
+    void Process();
+
+    // the return has the same planes as the decoded data: left, right and
+    // mono down-mix
+    const CVector<float>& GetReturnData() const { return vecfReturnData; }
+
+protected:
+    int            iFrameSizeSamples;
+    CAudioReverb   Reverb;
+    CVector<float> vecfSendData;
+    CVector<float> vecfStereoData;
+    CVector<float> vecfReturnData;
+};
@@ -28,6 +28,7 @@
 CServerListManager::CServerListManager ( const quint16  iNPortNum,
                                          const QString& sNCentServAddr,
                                          const QString& strServerInfo,
+                                         const QString& strFederationPeers,
                                          const int      iNumChannels,
                                          const bool     bNCentServPingServerInList,
                                          CProtocol*     pNConLProt )
@@ -36,14 +37,41 @@ CServerListManager::CServerListManager ( const quint16  iNPortNum,
       eCentralServerAddressType ( AT_CUSTOM ), // must be AT_CUSTOM for the "no GUI" case
       bCentServPingServerInList ( bNCentServPingServerInList ),
       pConnLessProtocol         ( pNConLProt ),
+      bServerListMesValid       ( false ),
+      bCountryBucketsValid      ( false ),
+      iPoolNumClients           ( 0 ),
+      iPoolLoadPct              ( 0 ),
       eSvrRegStatus             ( SRS_UNREGISTERED ),
-      iSvrRegRetries            ( 0 )
+      iSvrRegRetries            ( 0 ),
+      iSvrRegNumTimeOuts        ( 0 ),
+      iPingServerSlice          ( 0 ),
+      RandomGenerator           ( std::random_device()() ),
+      bSvrRegAddrPending        ( false )
 {
     // set the central server address
     SetCentralServerAddress ( sNCentServAddr );
 
+    // parse the addresses of the other central servers of the federation
+    // according to definition: [address1];[address2];...
+    if ( !strFederationPeers.isEmpty() )
+    {
+        foreach ( const QString strPeer, strFederationPeers.split ( ";", QString::SkipEmptyParts ) )
+        {
+            CHostAddress PeerAddr;
+
+            if ( NetworkUtil().ParseNetworkAddress ( strPeer, PeerAddr ) )
+            {
+                vecFederationPeers.Add ( PeerAddr );
+            }
+            else
+            {
+                tsConsoleStream << "Invalid federation central server address: " << strPeer << endl;
+            }
+        }
+    }
+
     // set the server internal address, including internal port number
-    SlaveCurLocalHostAddress = CHostAddress( NetworkUtil::GetLocalAddress().InetAddr, iNPortNum );
+    SlaveCurLocalHostAddress = CHostAddress( NetworkUtil::GetLocalAddress().GetInetAddr(), iNPortNum );
 
     // prepare the server info information
     QStringList slServInfoSeparateParams;
@@ -149,7 +177,13 @@ CServerListManager::CServerListManager ( const quint16  iNPortNum,
                 iCountry );
         }
 
-        // add the new server to the server list
+        // add the new server to the server list (the predefined servers never
+        // expire)
+        if ( !ServerListIndex.contains ( NewServerListEntry.HostAddr ) )
+        {
+            ServerListIndex.insert ( NewServerListEntry.HostAddr, ServerList.size() );
+        }
+
         ServerList.append ( NewServerListEntry );
 
         // we have used four items and have created one predefined server
@@ -163,30 +197,50 @@ CServerListManager::CServerListManager ( const quint16  iNPortNum,
     if ( !GetIsCentralServer() )
     {
         // 1 minute = 60 * 1000 ms
-        QTimer::singleShot ( SERVLIST_TIME_PERMSERV_MINUTES * 60000,
-            this, SLOT ( OnTimerIsPermanent() ) );
+        TimerIsPermanent.SetSingleShot ( true );
+        TimerIsPermanent.Start ( SERVLIST_TIME_PERMSERV_MINUTES * 60000 );
     }
 
-    // prepare the register server response timer (single shot timer)
-    TimerCLRegisterServerResp.setSingleShot ( true );
-    TimerCLRegisterServerResp.setInterval ( REGISTER_SERVER_TIME_OUT_MS );
+    // time base for the expiry of the registered servers
+    ExpiryTimer.start();
+
+    // prepare the register server response timer (single shot timer, the
+    // interval is set on each start)
+    TimerCLRegisterServerResp.SetSingleShot ( true );
+
+    // prepare the timer for the collected "send empty message" requests
+    // (single shot timer)
+    TimerSendEmptyMesList.SetSingleShot ( true );
+    TimerSendEmptyMesList.SetInterval ( SERVLIST_SEND_EMPTY_MES_FLUSH_MS );
 
 
     // Connections -------------------------------------------------------------
-    QObject::connect ( &TimerPollList, &QTimer::timeout,
+    QObject::connect ( &TimerPollList, &CWheelTimer::timeout,
         this, &CServerListManager::OnTimerPollList );
 
-    QObject::connect ( &TimerPingServerInList, &QTimer::timeout,
+    QObject::connect ( &TimerPingServerInList, &CWheelTimer::timeout,
         this, &CServerListManager::OnTimerPingServerInList );
 
-    QObject::connect ( &TimerPingCentralServer, &QTimer::timeout,
+    QObject::connect ( &TimerPingCentralServer, &CWheelTimer::timeout,
         this, &CServerListManager::OnTimerPingCentralServer );
 
-    QObject::connect ( &TimerRegistering, &QTimer::timeout,
+    QObject::connect ( &TimerRegistering, &CWheelTimer::timeout,
         this, &CServerListManager::OnTimerRegistering );
 
-    QObject::connect ( &TimerCLRegisterServerResp, &QTimer::timeout,
+    QObject::connect ( &CHostNameResolver::Instance(), &CHostNameResolver::HostNameResolved,
+        this, &CServerListManager::OnHostNameResolved );
+
+    QObject::connect ( &TimerCLRegisterServerResp, &CWheelTimer::timeout,
         this, &CServerListManager::OnTimerCLRegisterServerResp );
+
+    QObject::connect ( &TimerSendEmptyMesList, &CWheelTimer::timeout,
+        this, &CServerListManager::OnTimerSendEmptyMesList );
+
+    QObject::connect ( &TimerIsPermanent, &CWheelTimer::timeout,
+        this, &CServerListManager::OnTimerIsPermanent );
+
+    QObject::connect ( &TimerPoolLoad, &CWheelTimer::timeout,
+        this, &CServerListManager::OnTimerPoolLoad );
 }
 
 void CServerListManager::SetCentralServerAddress ( const QString sNCentServAddr )
@@ -228,16 +282,33 @@ void CServerListManager::Update()
         {
             // start timer for polling the server list if enabled
             // 1 minute = 60 * 1000 ms
-            TimerPollList.start ( SERVLIST_POLL_TIME_MINUTES * 60000 );
+            TimerPollList.Start ( SERVLIST_POLL_TIME_MINUTES * 60000 );
 
             if ( bCentServPingServerInList )
             {
-                // start timer for sending ping messages to servers in the list
-                TimerPingServerInList.start ( SERVLIST_UPDATE_PING_SERVERS_MS );
+                // start timer for sending ping messages to servers in the list,
+                // one group of the servers is pinged per time out
+                TimerPingServerInList.Start ( SERVLIST_UPDATE_PING_SERVERS_MS / SERVLIST_PING_SERVERS_NUM_SLICES );
+            }
+
+            // get the servers which registered at the other central servers
+            // of the federation (the changes are sent by them afterwards)
+            for ( int iPeer = 0; iPeer < vecFederationPeers.Size(); iPeer++ )
+            {
+                pConnLessProtocol->CreateCLReqFederationSyncMes ( vecFederationPeers[iPeer] );
             }
         }
         else
         {
+            // reset the time out counter to zero because update was called
+            iSvrRegNumTimeOuts = 0;
+
+            // start timer for registering this server at the central server,
+            // the timer is restarted with a new jitter after each response
+            // (therefore it is started before the first registration)
+            // 1 minute = 60 * 1000 ms
+            TimerRegistering.Start ( GetJitteredIntervalMs ( SERVLIST_REGIST_INTERV_MINUTES * 60000 ) );
+
             // initiate registration right away so that we do not have to wait
             // for the first time out of the timer until the slave server gets
             // registered at the central server, note that we have to unlock
@@ -249,23 +320,19 @@ void CServerListManager::Update()
             }
             locker.relock();
 
-            // reset the retry counter to zero because update was called
-            iSvrRegRetries = 0;
-
-            // start timer for registration timeout
-            TimerCLRegisterServerResp.start();
-
-            // start timer for registering this server at the central server
-            // 1 minute = 60 * 1000 ms
-            TimerRegistering.start ( SERVLIST_REGIST_INTERV_MINUTES * 60000 );
-
             // Start timer for ping the central server in short intervals to
             // keep the port open at the NAT router.
             // If no NAT is used, we send the messages anyway since they do
             // not hurt (very low traffic). We also reuse the same update
             // time as used in the central server for pinging the slave
-            // servers.
-            TimerPingCentralServer.start ( SERVLIST_UPDATE_PING_SERVERS_MS );
+            // servers (with a new jitter on each time out).
+            TimerPingCentralServer.Start ( GetJitteredIntervalMs ( SERVLIST_UPDATE_PING_SERVERS_MS ) );
+
+            // a member of a server pool reports its load periodically
+            if ( !strServerPool.isEmpty() )
+            {
+                TimerPoolLoad.Start ( SERVLIST_POOL_LOAD_INTERVAL_S * 1000 );
+            }
         }
     }
     else
@@ -273,18 +340,19 @@ void CServerListManager::Update()
         // disable service -> stop timer
         if ( bIsCentralServer )
         {
-            TimerPollList.stop();
+            TimerPollList.Stop();
 
             if ( bCentServPingServerInList )
             {
-                TimerPingServerInList.stop();
+                TimerPingServerInList.Stop();
             }
         }
         else
         {
-            TimerCLRegisterServerResp.stop();
-            TimerRegistering.stop();
-            TimerPingCentralServer.stop();
+            TimerCLRegisterServerResp.Stop();
+            TimerRegistering.Stop();
+            TimerPingCentralServer.Stop();
+            TimerPoolLoad.Stop();
         }
     }
 }
@@ -297,12 +365,22 @@ void CServerListManager::OnTimerPingServerInList()
 
     const int iCurServerListSize = ServerList.size();
 
+    // the servers are pinged in groups (by the hash of their address which
+    // does not change if other entries are removed) so that each server is
+    // pinged every SERVLIST_UPDATE_PING_SERVERS_MS without a burst of pings
+    iPingServerSlice = ( iPingServerSlice + 1 ) % SERVLIST_PING_SERVERS_NUM_SLICES;
+
     // send ping to list entries except of the very first one (which is the central
-    // server entry) and the predefined servers
+    // server entry) and the predefined servers, the replicated entries are
+    // pinged by their own central server
     for ( int iIdx = 1 + iNumPredefinedServers; iIdx < iCurServerListSize; iIdx++ )
     {
-        // send empty message to keep NAT port open at slave server
-        pConnLessProtocol->CreateCLEmptyMes ( ServerList[iIdx].HostAddr );
+        if ( ( ServerList[iIdx].OriginAddr == CHostAddress() ) &&
+             ( static_cast<int> ( qHash ( ServerList[iIdx].HostAddr ) % SERVLIST_PING_SERVERS_NUM_SLICES ) == iPingServerSlice ) )
+        {
+            // send empty message to keep NAT port open at slave server
+            pConnLessProtocol->CreateCLEmptyMes ( ServerList[iIdx].HostAddr );
+        }
     }
 }
 
@@ -312,23 +390,28 @@ void CServerListManager::OnTimerPollList()
 
     QMutexLocker locker ( &Mutex );
 
-    // Check all list entries except of the very first one (which is the central
-    // server entry) and the predefined servers if they are still valid.
-    // Note that we have to use "ServerList.size()" function in the for loop
-    // since we may remove elements from the server list inside the for loop.
-    for ( int iIdx = 1 + iNumPredefinedServers; iIdx < ServerList.size(); )
+    // Check the registered servers (the very first entry which is the central
+    // server entry and the predefined servers are never in the expiry queue)
+    // in the order of their expiry time, we can stop at the first entry which
+    // is not yet expired.
+    const qint64 iCurTimeMs = ExpiryTimer.elapsed();
+
+    while ( !ExpiryQueue.empty() && ( ExpiryQueue.top().iExpiryTimeMs <= iCurTimeMs ) )
     {
+        const CHostAddress HostAddr = ExpiryQueue.top().HostAddr;
+        ExpiryQueue.pop();
+
+        const int iIdx = ServerListIndex.value ( HostAddr, INVALID_INDEX );
+
+        // the entry may have been unregistered or renewed in the meantime
         // 1 minute = 60 * 1000 ms
-        if ( ServerList[iIdx].RegisterTime.elapsed() > ( SERVLIST_TIME_OUT_MINUTES * 60000 ) )
+        if ( ( iIdx > iNumPredefinedServers ) &&
+             ( ServerList[iIdx].RegisterTime.elapsed() > ( SERVLIST_TIME_OUT_MINUTES * 60000 ) ) )
         {
             // remove this list entry
-            vecRemovedHostAddr.Add ( ServerList[iIdx].HostAddr );
-            ServerList.removeAt ( iIdx );
-        }
-        else
-        {
-            // move to the next entry (only on else)
-            iIdx++;
+            SendFederationUpdate ( iIdx, true );
+            vecRemovedHostAddr.Add ( HostAddr );
+            RemoveRegisteredServer ( iIdx );
         }
     }
 
@@ -355,30 +438,24 @@ void CServerListManager::CentralServerRegisterServer ( const CHostAddress&    In
         const int iCurServerListSize = ServerList.size();
 
         // Check if server is already registered.
-        // The very first list entry must not be checked since
+        // The very first list entry is not in the index since
         // this is per definition the central server (i.e., this server)
-        int iSelIdx = INVALID_INDEX; // initialize with an illegal value
-        for ( int iIdx = 1; iIdx < iCurServerListSize; iIdx++ )
-        {
-            if ( ServerList[iIdx].HostAddr == InetAddr )
-            {
-                // store entry index
-                iSelIdx = iIdx;
-
-                // entry found, leave for-loop
-                continue;
-            }
-        }
+        int iSelIdx = ServerListIndex.value ( InetAddr, INVALID_INDEX );
 
         // if server is not yet registered, we have to create a new entry
         if ( iSelIdx == INVALID_INDEX )
         {
             // check for maximum allowed number of servers in the server list
-            if ( iCurServerListSize < MAX_NUM_SERVERS_IN_SERVER_LIST )
+            if ( iCurServerListSize < GetMaxNumServers() )
             {
                 // create a new server list entry and init with received data
                 ServerList.append ( CServerListEntry ( InetAddr, LInetAddr, ServerInfo ) );
                 iSelIdx = iCurServerListSize;
+
+                ServerListIndex.insert ( InetAddr, iSelIdx );
+                AddToExpiryQueue ( InetAddr );
+
+                InvalidateServerListCache();
             }
         }
         else
@@ -386,6 +463,19 @@ void CServerListManager::CentralServerRegisterServer ( const CHostAddress&    In
             // do not update the information in the predefined servers
             if ( iSelIdx > iNumPredefinedServers )
             {
+                // the cached server list message is only invalid if the
+                // information has actually changed (usually the registration
+                // is just renewed)
+                if ( ( ServerList[iSelIdx].LHostAddr        != LInetAddr ) ||
+                     ( ServerList[iSelIdx].strName          != ServerInfo.strName ) ||
+                     ( ServerList[iSelIdx].eCountry         != ServerInfo.eCountry ) ||
+                     ( ServerList[iSelIdx].strCity          != ServerInfo.strCity ) ||
+                     ( ServerList[iSelIdx].iMaxNumClients   != ServerInfo.iMaxNumClients ) ||
+                     ( ServerList[iSelIdx].bPermanentOnline != ServerInfo.bPermanentOnline ) )
+                {
+                    InvalidateServerListCache();
+                }
+
                 // update all data and call update registration function
                 ServerList[iSelIdx].LHostAddr        = LInetAddr;
                 ServerList[iSelIdx].strName          = ServerInfo.strName;
@@ -395,12 +485,32 @@ void CServerListManager::CentralServerRegisterServer ( const CHostAddress&    In
                 ServerList[iSelIdx].bPermanentOnline = ServerInfo.bPermanentOnline;
 
                 ServerList[iSelIdx].UpdateRegistration();
+                AddToExpiryQueue ( InetAddr );
+
+                // the server may have registered at another central server of
+                // the federation before, now we are responsible for it
+                ServerList[iSelIdx].OriginAddr = CHostAddress();
             }
         }
 
+        if ( ( iSelIdx != INVALID_INDEX ) && ( iSelIdx > iNumPredefinedServers ) )
+        {
+            SendFederationUpdate ( iSelIdx, false );
+        }
+
+        // the retry after hint spreads the next registrations of the servers
+        // (which may have registered in sync, e.g. after a restart of this
+        // central server) over the registration interval, a server which
+        // does not fit in the full list retries after the whole interval
+        // 1 minute = 60 * 1000 ms
+        const int iRetryAfterS = ( iSelIdx == INVALID_INDEX )
+            ? SERVLIST_REGIST_INTERV_MINUTES * 60
+            : GetJitteredIntervalMs ( SERVLIST_REGIST_INTERV_MINUTES * 60000 ) / 1000;
+
         pConnLessProtocol->CreateCLRegisterServerResp ( InetAddr, iSelIdx == INVALID_INDEX
                                                             ? ESvrRegResult::SRR_CENTRAL_SVR_FULL
-                                                            : ESvrRegResult::SRR_REGISTERED );
+                                                            : ESvrRegResult::SRR_REGISTERED,
+                                                        iRetryAfterS );
     }
 }
 
@@ -413,28 +523,53 @@ void CServerListManager::CentralServerUnregisterServer ( const CHostAddress& Ine
 
         QMutexLocker locker ( &Mutex );
 
-        const int iCurServerListSize = ServerList.size();
-
         // Find the server to unregister in the list. The very first list entry
-        // must not be checked since this is per definition the central server
-        // (i.e., this server), also the predefined servers must not be checked.
-        for ( int iIdx = 1 + iNumPredefinedServers; iIdx < iCurServerListSize; iIdx++ )
+        // is not in the index since this is per definition the central server
+        // (i.e., this server), also the predefined servers must not be removed.
+        // Note that the entry in the expiry queue becomes stale.
+        const int iIdx = ServerListIndex.value ( InetAddr, INVALID_INDEX );
+
+        if ( iIdx > iNumPredefinedServers )
         {
-            if ( ServerList[iIdx].HostAddr == InetAddr )
-            {
-                // remove this list entry
-                ServerList.removeAt ( iIdx );
-
-                // entry found, leave for-loop (it is important to exit the
-                // for loop since when we remove an item from the server list,
-                // "iCurServerListSize" is not correct anymore and we could get
-                // a segmentation fault)
-                break;
-            }
+            SendFederationUpdate ( iIdx, true );
+            RemoveRegisteredServer ( iIdx );
         }
     }
 }
 
+void CServerListManager::AddToExpiryQueue ( const CHostAddress& HostAddr )
+{
+    // 1 minute = 60 * 1000 ms
+    ExpiryQueue.push ( CExpiryEntry ( ExpiryTimer.elapsed() + SERVLIST_TIME_OUT_MINUTES * 60000 + 1,
+                                      HostAddr ) );
+}
+
+void CServerListManager::RemoveRegisteredServer ( const int iIdx )
+{
+    // the order of the registered servers is not relevant, we move the last
+    // entry to the free position instead of shifting all following entries
+    const int     iLastIdx = ServerList.size() - 1;
+    const QString strPool  = ServerList[iIdx].strPool;
+
+    ServerListIndex.remove ( ServerList[iIdx].HostAddr );
+
+    if ( iIdx != iLastIdx )
+    {
+        ServerList[iIdx] = ServerList[iLastIdx];
+        ServerListIndex.insert ( ServerList[iIdx].HostAddr, iIdx );
+    }
+
+    ServerList.removeLast();
+
+    InvalidateServerListCache();
+
+    // another member of the pool may have to be chosen
+    if ( !strPool.isEmpty() )
+    {
+        UpdatePoolChoice ( strPool );
+    }
+}
+
 void CServerListManager::CentralServerQueryServerList ( const CHostAddress& InetAddr )
 {
     QMutexLocker locker ( &Mutex );
@@ -442,51 +577,589 @@ void CServerListManager::CentralServerQueryServerList ( const CHostAddress& Inet
     if ( bIsCentralServer && bEnabled )
     {
         const int iCurServerListSize = ServerList.size();
+        bool      bIsBehindServerNAT = false;
+
+        for ( int iIdx = 1; iIdx < iCurServerListSize; iIdx++ )
+        {
+            // check if the address of the client which is requesting the
+            // list is the same address as one server in the list -> in this
+            // case he has to connect to the local host address and port
+            // to allow for NAT (and the cached list cannot be used)
+            if ( ServerList[iIdx].HostAddr.IsSameInetAddr ( InetAddr ) )
+            {
+                bIsBehindServerNAT = true;
+            }
+            else
+            {
+                // "send empty message" for all registered servers (except of
+                // the very first list entry since this is this server (central
+                // server) per definition) and also it is not required to send
+                // this message, if the server is on the same computer
+                RequestEmptyMes ( iIdx, InetAddr );
+            }
+        }
+
+        if ( !bIsBehindServerNAT && bServerListMesValid )
+        {
+            // send the cached server list to the client
+            pConnLessProtocol->SendCLMessage ( InetAddr, ServerListMes );
+            return;
+        }
 
         // allocate memory for the entire list
-        CVector<CServerInfo> vecServerInfo ( iCurServerListSize );
+        CVector<CServerInfo> vecServerInfo ( 0 );
+        vecServerInfo.reserve ( iCurServerListSize );
 
         // copy the list (we have to copy it since the message requires
         // a vector but the list is actually stored in a QList object and
-        // not in a vector object
+        // not in a vector object, the IPv6 servers cannot be coded in the
+        // message, they are queried separately)
         for ( int iIdx = 0; iIdx < iCurServerListSize; iIdx++ )
         {
-            // copy list item
-            vecServerInfo[iIdx] = ServerList[iIdx];
+            if ( ServerList[iIdx].HostAddr.IsIPv4() && !IsHiddenPoolMember ( iIdx ) )
+            {
+                vecServerInfo.Add ( GetServerInfoForClient ( iIdx, InetAddr ) );
+            }
+        }
+
+        if ( bIsBehindServerNAT )
+        {
+            // send the server list for this client
+            pConnLessProtocol->CreateCLServerListMes ( InetAddr, vecServerInfo );
+        }
+        else
+        {
+            // encode the server list once and send it to the client (all
+            // clients share the bytes of the cached message)
+            CVector<uint8_t> vecbyServerListMes;
+
+            pConnLessProtocol->GenCLServerListMes ( vecServerInfo, vecbyServerListMes );
+            ServerListMes       = CProtMessage::Adopt ( vecbyServerListMes );
+            bServerListMesValid = true;
+
+            pConnLessProtocol->SendCLMessage ( InetAddr, ServerListMes );
+        }
+    }
+}
+
+
+void CServerListManager::CentralServerQueryServerListPage ( const CHostAddress&      InetAddr,
+                                                           const CServerListFilter& Filter,
+                                                           const int                iPage )
+{
+    QMutexLocker locker ( &Mutex );
+
+    if ( bIsCentralServer && bEnabled )
+    {
+        const int iCurServerListSize = ServerList.size();
+
+        if ( !bCountryBucketsValid )
+        {
+            CountryBuckets.clear();
+
+            for ( int iIdx = 1; iIdx < iCurServerListSize; iIdx++ )
+            {
+                CountryBuckets[static_cast<int> ( ServerList[iIdx].eCountry )].Add ( iIdx );
+            }
+
+            bCountryBucketsValid = true;
+        }
+
+        // get the servers which pass the filter (only the bucket of the
+        // requested country has to be checked)
+        const bool         bAllCountries  = ( Filter.eCountry == QLocale::AnyCountry );
+        const CVector<int> veciBucketIdx  = bAllCountries ? CVector<int> ( 0 )
+                                                          : CountryBuckets.value ( static_cast<int> ( Filter.eCountry ) );
+        const int          iNumCandidates = bAllCountries ? iCurServerListSize - 1 : veciBucketIdx.Size();
+        CVector<int>       veciMatchIdx ( 0 );
+
+        for ( int i = 0; i < iNumCandidates; i++ )
+        {
+            const int               iIdx  = bAllCountries ? 1 + i : veciBucketIdx[i];
+            const CServerListEntry& Entry = ServerList[iIdx];
+
+            // the IPv6 servers are queried separately
+            if ( Entry.HostAddr.IsIPv4() && IsFilterMatch ( Entry, Filter ) && !IsHiddenPoolMember ( iIdx ) )
+            {
+                veciMatchIdx.Add ( iIdx );
+            }
+        }
+
+        // a page has at most SERVLIST_PAGE_NUM_SERVERS servers and at most
+        // PROT_LIST_PART_MAX_BYTES bytes of entries so that the message is not
+        // fragmented, there is always at least one page (which has the central
+        // server)
+        const int    iNumMatches     = veciMatchIdx.Size();
+        CVector<int> veciPageStart   ( 1, 0 );
+        int          iPageNumServers = 0;
+        int          iPageBytes      = CProtocol::GetServerListEntrySize ( ServerList[0] );
+
+        for ( int i = 0; i < iNumMatches; i++ )
+        {
+            const int iEntryBytes = CProtocol::GetServerListEntrySize ( GetServerInfoForClient ( veciMatchIdx[i], InetAddr ) );
 
-            if ( iIdx > 0 )
+            if ( ( iPageNumServers > 0 ) &&
+                 ( ( iPageNumServers == SERVLIST_PAGE_NUM_SERVERS ) ||
+                   ( iPageBytes + iEntryBytes > PROT_LIST_PART_MAX_BYTES ) ) )
             {
-                // check if the address of the client which is requesting the
-                // list is the same address as one server in the list -> in this
-                // case he has to connect to the local host address and port
-                // to allow for NAT.
-                if ( vecServerInfo[iIdx].HostAddr.InetAddr == InetAddr.InetAddr )
+                veciPageStart.Add ( i );
+                iPageNumServers = 0;
+                iPageBytes      = 0;
+            }
+
+            iPageNumServers++;
+            iPageBytes += iEntryBytes;
+        }
+
+        const int iNumPages = veciPageStart.Size();
+
+        if ( iPage >= iNumPages )
+        {
+            return;
+        }
+
+        const int iStart = veciPageStart[iPage];
+        const int iEnd   = ( iPage + 1 < iNumPages ) ? veciPageStart[iPage + 1] : iNumMatches;
+
+        CVector<CServerInfo> vecServerInfo ( 0 );
+
+        // per definition, the first entry of the first page is the central
+        // server itself
+        if ( iPage == 0 )
+        {
+            vecServerInfo.Add ( GetServerInfoForClient ( 0, InetAddr ) );
+        }
+
+        for ( int i = iStart; i < iEnd; i++ )
+        {
+            const int iIdx = veciMatchIdx[i];
+
+            vecServerInfo.Add ( GetServerInfoForClient ( iIdx, InetAddr ) );
+
+            // only the servers of this page will be pinged by the client
+            if ( !ServerList[iIdx].HostAddr.IsSameInetAddr ( InetAddr ) )
+            {
+                RequestEmptyMes ( iIdx, InetAddr );
+            }
+        }
+
+        pConnLessProtocol->CreateCLServerListPageMes ( InetAddr, iPage, iNumPages, vecServerInfo );
+    }
+}
+
+void CServerListManager::CentralServerQueryServerListIPv6 ( const CHostAddress&      InetAddr,
+                                                           const CServerListFilter& Filter )
+{
+    QMutexLocker locker ( &Mutex );
+
+    if ( bIsCentralServer && bEnabled )
+    {
+        const int            iCurServerListSize = ServerList.size();
+        CVector<CServerInfo> vecServerInfo ( 0 );
+        int                  iNumBytes          = 0;
+
+        // the IPv6 servers are not pinged through the firewall with an "empty
+        // message" since the request message only carries IPv4 addresses (the
+        // answer is limited like a page of the server list)
+        for ( int iIdx = 1; ( iIdx < iCurServerListSize ) &&
+                            ( vecServerInfo.Size() < SERVLIST_PAGE_NUM_SERVERS ); iIdx++ )
+        {
+            const CServerListEntry& Entry = ServerList[iIdx];
+
+            if ( !Entry.HostAddr.IsIPv4() && IsFilterMatch ( Entry, Filter ) && !IsHiddenPoolMember ( iIdx ) )
+            {
+                const int iEntryBytes = CProtocol::GetServerListEntrySize ( GetServerInfoForClient ( iIdx, InetAddr ), true );
+
+                if ( ( vecServerInfo.Size() > 0 ) && ( iNumBytes + iEntryBytes > PROT_LIST_PART_MAX_BYTES ) )
                 {
-                    // for a predefined server:
-                    // - LHostAddr and HostAddr are the same
-                    // - no local port number is supplied
-                    // otherwise, use the supplied details
-                    if ( iIdx > iNumPredefinedServers )
-                    {
-                        vecServerInfo[iIdx].HostAddr = ServerList[iIdx].LHostAddr;
-                    }
+                    break;
                 }
-                else
+
+                vecServerInfo.Add ( GetServerInfoForClient ( iIdx, InetAddr ) );
+                iNumBytes += iEntryBytes;
+            }
+        }
+
+        pConnLessProtocol->CreateCLServerListIPv6Mes ( InetAddr, vecServerInfo );
+    }
+}
+
+bool CServerListManager::IsFilterMatch ( const CServerListEntry&  Entry,
+                                         const CServerListFilter& Filter )
+{
+    return ( ( Filter.eCountry == QLocale::AnyCountry ) || ( Entry.eCountry == Filter.eCountry ) ) &&
+           ( Entry.iMaxNumClients >= Filter.iMinMaxNumClients ) &&
+           ( ( Entry.iFeatures & Filter.iRequiredFeatures ) == Filter.iRequiredFeatures );
+}
+
+CServerInfo CServerListManager::GetServerInfoForClient ( const int           iIdx,
+                                                         const CHostAddress& InetAddr )
+{
+    CServerInfo ServerInfo = ServerList[iIdx];
+
+    // for a predefined server:
+    // - LHostAddr and HostAddr are the same
+    // - no local port number is supplied
+    // otherwise, use the supplied details (if the client is behind the same
+    // NAT as the server, it has to connect to the local host address and port)
+    if ( ( iIdx > iNumPredefinedServers ) &&
+         ServerInfo.HostAddr.IsSameInetAddr ( InetAddr ) )
+    {
+        ServerInfo.HostAddr = ServerList[iIdx].LHostAddr;
+    }
+
+    // a server pool is shown with its name
+    if ( ( iIdx > iNumPredefinedServers ) && !ServerList[iIdx].strPool.isEmpty() )
+    {
+        ServerInfo.strName = ServerList[iIdx].strPool;
+    }
+
+    return ServerInfo;
+}
+
+bool CServerListManager::IsHiddenPoolMember ( const int iIdx ) const
+{
+    const CServerListEntry& Entry = ServerList[iIdx];
+
+    return ( iIdx > iNumPredefinedServers ) &&
+           !Entry.strPool.isEmpty() &&
+           ( PoolChoice.value ( Entry.strPool ) != Entry.HostAddr );
+}
+
+void CServerListManager::UpdatePoolChoice ( const QString& strPool )
+{
+    // The load of a member is the higher one of the processing load and the
+    // ratio of the connected clients. A member is available if it is not full,
+    // not overloaded and has reported its load recently, an unavailable member
+    // is only chosen if no member is available (the pool stays in the list as
+    // long as it has members). The central server does not know the round
+    // trip times of the client, the members of a pool are expected to be in
+    // the same region and the client measures the ping time of the chosen
+    // member like for any other server.
+    const qint64       iCurTimeMs    = ExpiryTimer.elapsed();
+    const CHostAddress CurChoiceAddr = PoolChoice.value ( strPool );
+    const int          iNumServers   = ServerList.size();
+    int                iBestIdx      = INVALID_INDEX;
+    bool               bBestAvail    = false;
+    int                iBestLoadPct  = 0;
+    int                iCurIdx       = INVALID_INDEX;
+    bool               bCurAvail     = false;
+    int                iCurLoadPct   = 0;
+
+    for ( int iIdx = 1 + iNumPredefinedServers; iIdx < iNumServers; iIdx++ )
+    {
+        const CServerListEntry& Entry = ServerList[iIdx];
+
+        if ( Entry.strPool != strPool )
+        {
+            continue;
+        }
+
+        const int iClientsPct = ( Entry.iMaxNumClients > 0 ) ?
+            100 * Entry.iNumClients / Entry.iMaxNumClients : 100;
+
+        const int iLoadPct = std::max ( Entry.iLoadPct, iClientsPct );
+
+        const bool bAvail = ( Entry.iLoadTimeMs >= 0 ) &&
+                            ( iCurTimeMs - Entry.iLoadTimeMs <= SERVLIST_POOL_LOAD_TIME_OUT_S * 1000 ) &&
+                            ( Entry.iNumClients < Entry.iMaxNumClients ) &&
+                            ( Entry.iLoadPct < SERVLIST_POOL_MAX_LOAD_PCT );
+
+        if ( ( iBestIdx == INVALID_INDEX ) ||
+             ( bAvail && !bBestAvail ) ||
+             ( ( bAvail == bBestAvail ) && ( iLoadPct < iBestLoadPct ) ) )
+        {
+            iBestIdx     = iIdx;
+            bBestAvail   = bAvail;
+            iBestLoadPct = iLoadPct;
+        }
+
+        if ( Entry.HostAddr == CurChoiceAddr )
+        {
+            iCurIdx     = iIdx;
+            bCurAvail   = bAvail;
+            iCurLoadPct = iLoadPct;
+        }
+    }
+
+    if ( iBestIdx == INVALID_INDEX )
+    {
+        // the pool has no members anymore
+        PoolChoice.remove ( strPool );
+        return;
+    }
+
+    // the chosen member is kept if the other member is not clearly better
+    if ( ( iCurIdx != INVALID_INDEX ) &&
+         ( bCurAvail == bBestAvail ) &&
+         ( iCurLoadPct - iBestLoadPct < SERVLIST_POOL_HYSTERESIS_PCT ) )
+    {
+        return;
+    }
+
+    if ( ServerList[iBestIdx].HostAddr != CurChoiceAddr )
+    {
+        PoolChoice.insert ( strPool, ServerList[iBestIdx].HostAddr );
+        InvalidateServerListCache();
+    }
+}
+
+void CServerListManager::RequestEmptyMes ( const int           iIdx,
+                                           const CHostAddress& InetAddr )
+{
+    // the request messages can only carry the IPv4 address of a client
+    if ( !InetAddr.IsIPv4() )
+    {
+        return;
+    }
+
+    if ( ServerList[iIdx].iFeatures & CLM_SERVER_FEATURE_SEND_EMPTY_MES_LIST )
+    {
+        // the server understands the list message, the requests of all
+        // clients are collected for a short time
+        ServerList[iIdx].vecPendingEmptyMesAddr.Add ( InetAddr );
+
+        if ( !TimerSendEmptyMesList.IsActive() )
+        {
+            TimerSendEmptyMesList.Start();
+        }
+    }
+    else
+    {
+        pConnLessProtocol->CreateCLSendEmptyMesMes ( ServerList[iIdx].HostAddr,
+                                                     InetAddr );
+    }
+}
+
+void CServerListManager::CentralServerSetServerFeatures ( const CHostAddress& InetAddr,
+                                                         const uint32_t      iFeatures )
+{
+    if ( bIsCentralServer && bEnabled )
+    {
+        QMutexLocker locker ( &Mutex );
+
+        // the message is sent after the registration, the predefined servers
+        // do not register
+        const int iIdx = ServerListIndex.value ( InetAddr, INVALID_INDEX );
+
+        if ( ( iIdx > iNumPredefinedServers ) && ( ServerList[iIdx].iFeatures != iFeatures ) )
+        {
+            ServerList[iIdx].iFeatures = iFeatures;
+            SendFederationUpdate ( iIdx, false );
+        }
+    }
+}
+
+void CServerListManager::CentralServerSetServerLoad ( const CHostAddress& InetAddr,
+                                                     const QString&      strPool,
+                                                     const int           iNumClients,
+                                                     const int           iLoadPct )
+{
+    if ( bIsCentralServer && bEnabled )
+    {
+        QMutexLocker locker ( &Mutex );
+
+        // the message is sent after the registration, the predefined servers
+        // do not register
+        const int iIdx = ServerListIndex.value ( InetAddr, INVALID_INDEX );
+
+        if ( iIdx <= iNumPredefinedServers )
+        {
+            return;
+        }
+
+        CServerListEntry& Entry   = ServerList[iIdx];
+        const QString     strPrev = Entry.strPool;
+
+        Entry.strPool     = strPool;
+        Entry.iNumClients = iNumClients;
+        Entry.iLoadPct    = iLoadPct;
+        Entry.iLoadTimeMs = ExpiryTimer.elapsed();
+
+        if ( strPrev != strPool )
+        {
+            // the entry is shown with the pool name now (or is no pool member
+            // anymore)
+            InvalidateServerListCache();
+
+            if ( !strPrev.isEmpty() )
+            {
+                UpdatePoolChoice ( strPrev );
+            }
+        }
+
+        if ( !strPool.isEmpty() )
+        {
+            UpdatePoolChoice ( strPool );
+        }
+    }
+}
+
+bool CServerListManager::IsFederationPeer ( const CHostAddress& InetAddr ) const
+{
+    for ( int iPeer = 0; iPeer < vecFederationPeers.Size(); iPeer++ )
+    {
+        if ( vecFederationPeers[iPeer] == InetAddr )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void CServerListManager::SendFederationUpdate ( const int  iIdx,
+                                                const bool bRemove )
+{
+    // only the changes of the servers which registered at this central server
+    // are replicated (the other central servers replicate their own servers)
+    // (the federation messages only carry IPv4 addresses)
+    if ( vecFederationPeers.Size() == 0 || !( ServerList[iIdx].OriginAddr == CHostAddress() ) ||
+         !ServerList[iIdx].HostAddr.IsIPv4() )
+    {
+        return;
+    }
+
+    CVector<CFederationServerInfo> vecServerInfo ( 1 );
+    vecServerInfo[0] = CFederationServerInfo ( ServerList[iIdx], bRemove, ServerList[iIdx].iFeatures );
+
+    for ( int iPeer = 0; iPeer < vecFederationPeers.Size(); iPeer++ )
+    {
+        pConnLessProtocol->CreateCLFederationUpdateMes ( vecFederationPeers[iPeer], vecServerInfo );
+    }
+}
+
+void CServerListManager::CentralServerFederationUpdate ( const CHostAddress&                   InetAddr,
+                                                         const CVector<CFederationServerInfo>& vecServerInfo )
+{
+    QMutexLocker locker ( &Mutex );
+
+    // only the configured central servers may change our list
+    if ( !bIsCentralServer || !bEnabled || !IsFederationPeer ( InetAddr ) )
+    {
+        return;
+    }
+
+    for ( int i = 0; i < vecServerInfo.Size(); i++ )
+    {
+        const CFederationServerInfo& ServerInfo = vecServerInfo[i];
+        int                          iSelIdx    = ServerListIndex.value ( ServerInfo.HostAddr, INVALID_INDEX );
+
+        // the predefined servers are never changed and the servers which
+        // registered at this central server are only changed by themselves
+        if ( ( iSelIdx != INVALID_INDEX ) &&
+             ( ( iSelIdx <= iNumPredefinedServers ) ||
+               ( ServerList[iSelIdx].OriginAddr == CHostAddress() ) ) )
+        {
+            continue;
+        }
+
+        if ( ServerInfo.bRemove )
+        {
+            // the server may have moved to another central server in the
+            // meantime which then is the origin
+            if ( ( iSelIdx != INVALID_INDEX ) && ( ServerList[iSelIdx].OriginAddr == InetAddr ) )
+            {
+                RemoveRegisteredServer ( iSelIdx );
+            }
+        }
+        else
+        {
+            if ( iSelIdx == INVALID_INDEX )
+            {
+                if ( ServerList.size() >= GetMaxNumServers() )
                 {
-                    // create "send empty message" for all registered servers
-                    // (except of the very first list entry since this is this
-                    // server (central server) per definition) and also it is
-                    // not required to send this message, if the server is on
-                    // the same computer
-                    pConnLessProtocol->CreateCLSendEmptyMesMes ( 
-                        vecServerInfo[iIdx].HostAddr,
-                        InetAddr );
+                    continue;
                 }
+
+                ServerList.append ( CServerListEntry ( ServerInfo.HostAddr,
+                                                       ServerInfo.LHostAddr,
+                                                       ServerInfo ) );
+                iSelIdx = ServerList.size() - 1;
+
+                ServerListIndex.insert ( ServerInfo.HostAddr, iSelIdx );
             }
+            else
+            {
+                ServerList[iSelIdx].LHostAddr        = ServerInfo.LHostAddr;
+                ServerList[iSelIdx].strName          = ServerInfo.strName;
+                ServerList[iSelIdx].eCountry         = ServerInfo.eCountry;
+                ServerList[iSelIdx].strCity          = ServerInfo.strCity;
+                ServerList[iSelIdx].iMaxNumClients   = ServerInfo.iMaxNumClients;
+                ServerList[iSelIdx].bPermanentOnline = ServerInfo.bPermanentOnline;
+                ServerList[iSelIdx].UpdateRegistration();
+            }
+
+            // the replicated entries expire like our own entries if the other
+            // central server stops sending the renewed registrations
+            ServerList[iSelIdx].iFeatures  = ServerInfo.iFeatures;
+            ServerList[iSelIdx].OriginAddr = InetAddr;
+            AddToExpiryQueue ( ServerInfo.HostAddr );
+
+            InvalidateServerListCache();
         }
+    }
+}
 
-        // send the server list to the client
-        pConnLessProtocol->CreateCLServerListMes ( InetAddr, vecServerInfo );
+void CServerListManager::CentralServerFederationSync ( const CHostAddress& InetAddr )
+{
+    QMutexLocker locker ( &Mutex );
+
+    if ( !bIsCentralServer || !bEnabled || !IsFederationPeer ( InetAddr ) )
+    {
+        return;
+    }
+
+    // send all servers which registered at this central server
+    const int                      iCurServerListSize = ServerList.size();
+    CVector<CFederationServerInfo> vecServerInfo ( 0 );
+
+    for ( int iIdx = 1 + iNumPredefinedServers; iIdx < iCurServerListSize; iIdx++ )
+    {
+        if ( ( ServerList[iIdx].OriginAddr == CHostAddress() ) && ServerList[iIdx].HostAddr.IsIPv4() )
+        {
+            vecServerInfo.Add ( CFederationServerInfo ( ServerList[iIdx], false, ServerList[iIdx].iFeatures ) );
+
+            if ( vecServerInfo.Size() == CLM_FEDERATION_UPDATE_MAX_NUM )
+            {
+                pConnLessProtocol->CreateCLFederationUpdateMes ( InetAddr, vecServerInfo );
+                vecServerInfo.clear();
+            }
+        }
+    }
+
+    if ( vecServerInfo.Size() > 0 )
+    {
+        pConnLessProtocol->CreateCLFederationUpdateMes ( InetAddr, vecServerInfo );
+    }
+}
+
+void CServerListManager::OnTimerSendEmptyMesList()
+{
+    QMutexLocker locker ( &Mutex );
+
+    const int iCurServerListSize = ServerList.size();
+
+    for ( int iIdx = 1 + iNumPredefinedServers; iIdx < iCurServerListSize; iIdx++ )
+    {
+        CVector<CHostAddress>& vecPendingAddr = ServerList[iIdx].vecPendingEmptyMesAddr;
+        const int              iNumPending    = vecPendingAddr.Size();
+
+        // one message per server for all clients (split if too long)
+        for ( int iStart = 0; iStart < iNumPending; iStart += CLM_SEND_EMPTY_MES_LIST_MAX_NUM )
+        {
+            const int iNumAddr = std::min ( iNumPending - iStart, CLM_SEND_EMPTY_MES_LIST_MAX_NUM );
+
+            CVector<CHostAddress> vecTargetAddr ( iNumAddr );
+            std::copy ( vecPendingAddr.begin() + iStart,
+                        vecPendingAddr.begin() + iStart + iNumAddr,
+                        vecTargetAddr.begin() );
+
+            pConnLessProtocol->CreateCLSendEmptyMesListMes ( ServerList[iIdx].HostAddr,
+                                                             vecTargetAddr );
+        }
+
+        vecPendingAddr.clear();
     }
 }
 
@@ -499,7 +1172,12 @@ void CServerListManager::StoreRegistrationResult ( ESvrRegResult eResult )
     QMutexLocker locker ( &Mutex );
 
     // we got some response, so stop the retry timer
-    TimerCLRegisterServerResp.stop();
+    TimerCLRegisterServerResp.Stop();
+
+    // the next registration is scheduled with a new jitter (a retry after
+    // hint of the central server which follows the response replaces it)
+    iSvrRegNumTimeOuts = 0;
+    TimerRegistering.Start ( GetJitteredIntervalMs ( SERVLIST_REGIST_INTERV_MINUTES * 60000 ) );
 
     switch ( eResult )
     {
@@ -517,10 +1195,39 @@ void CServerListManager::StoreRegistrationResult ( ESvrRegResult eResult )
     }
 }
 
+void CServerListManager::StoreRegistrationRetryAfter ( const CHostAddress& InetAddr,
+                                                       const int           iRetryAfterS )
+{
+    QMutexLocker locker ( &Mutex );
+
+    // the hint is only accepted from our central server after its response
+    // (a hint which overtook the response is ignored), it is limited so that
+    // the registration does not time out in the server list
+    // 1 minute = 60 * 1000 ms
+    if ( !bIsCentralServer && bEnabled && ( InetAddr == SlaveCurCentServerHostAddress ) &&
+         ( ( eSvrRegStatus == SRS_REGISTERED ) || ( eSvrRegStatus == SRS_CENTRAL_SVR_FULL ) ) )
+    {
+        const int iRetryAfterMs = std::min ( std::max ( iRetryAfterS, SERVLIST_REGIST_RETRY_MIN_S ),
+                                             SERVLIST_REGIST_INTERV_MINUTES * 60 ) * 1000;
+
+        TimerRegistering.Start ( iRetryAfterMs );
+    }
+}
+
+int CServerListManager::GetJitteredIntervalMs ( const int iIntervalMs )
+{
+    std::uniform_int_distribution<int> Jitter ( 0, iIntervalMs * SERVLIST_TIMER_JITTER_PCT / 100 );
+
+    return iIntervalMs - Jitter ( RandomGenerator );
+}
+
 void CServerListManager::OnTimerPingCentralServer()
 {
     QMutexLocker locker ( &Mutex );
 
+    // the next ping is sent with a new jitter
+    TimerPingCentralServer.Start ( GetJitteredIntervalMs ( SERVLIST_UPDATE_PING_SERVERS_MS ) );
+
     // first check if central server address is valid
     if ( !( SlaveCurCentServerHostAddress == CHostAddress() ) )
     {
@@ -541,21 +1248,42 @@ void CServerListManager::OnTimerCLRegisterServerResp()
         if ( iSvrRegRetries >= REGISTER_SERVER_RETRY_LIMIT )
         {
             SetSvrRegStatus ( SRS_TIME_OUT );
+
+            // the next registration is tried after an exponentially growing
+            // time (the central server may only be restarting), at most after
+            // the regular registration interval
+            // 1 minute = 60 * 1000 ms
+            const int iBackoffS = std::min ( SERVLIST_REGIST_RETRY_MIN_S << std::min ( iSvrRegNumTimeOuts, 10 ),
+                                             SERVLIST_REGIST_INTERV_MINUTES * 60 );
+
+            iSvrRegNumTimeOuts++;
+            TimerRegistering.Start ( GetJitteredIntervalMs ( iBackoffS * 1000 ) );
         }
         else
         {
             locker.unlock();
             {
-                OnTimerRegistering();
+                SlaveServerRegisterServer ( true );
             }
             locker.relock();
 
-            // re-start timer for registration timeout
-            TimerCLRegisterServerResp.start();
+            // re-start timer for registration timeout with a doubled interval
+            TimerCLRegisterServerResp.Start ( GetJitteredIntervalMs ( REGISTER_SERVER_TIME_OUT_MS << iSvrRegRetries ) );
         }
     }
 }
 
+void CServerListManager::OnTimerRegistering()
+{
+    SlaveServerRegisterServer ( true );
+
+    // each registration is retried if there is no response
+    QMutexLocker locker ( &Mutex );
+
+    iSvrRegRetries = 0;
+    TimerCLRegisterServerResp.Start ( REGISTER_SERVER_TIME_OUT_MS );
+}
+
 void CServerListManager::SlaveServerRegisterServer ( const bool bIsRegister )
 {
     // we need the lock since the user might change the server properties at
@@ -573,8 +1301,23 @@ void CServerListManager::SlaveServerRegisterServer ( const bool bIsRegister )
     // Note that we always have to parse the server address again since if
     // it is an URL of a dynamic IP address, the IP address might have
     // changed in the meanwhile.
-    if ( NetworkUtil().ParseNetworkAddress ( strCurCentrServAddr,
-                                             SlaveCurCentServerHostAddress ) )
+    // The server registers with IPv4 if possible since only the IPv4 entries
+    // are shown by all clients (an IPv6 entry needs an IPv6 capable client).
+    // The host name is looked up asynchronously for the registration, the
+    // registration is done when the address is known (the unregistration on
+    // shutdown cannot wait, it usually finds the address in the cache).
+    const ENetwAddrStat eAddrStat = bIsRegister ?
+        NetworkUtil::ParseNetworkAddressNonBlocking ( strCurCentrServAddr, SlaveCurCentServerHostAddress, true ) :
+        ( NetworkUtil::ParseNetworkAddress ( strCurCentrServAddr, SlaveCurCentServerHostAddress, true ) ? NA_OK : NA_INVALID );
+
+    bSvrRegAddrPending = ( eAddrStat == NA_PENDING );
+
+    if ( bSvrRegAddrPending )
+    {
+        return;
+    }
+
+    if ( eAddrStat == NA_OK )
     {
         if ( bIsRegister )
         {
@@ -584,6 +1327,21 @@ void CServerListManager::SlaveServerRegisterServer ( const bool bIsRegister )
             pConnLessProtocol->CreateCLRegisterServerMes ( SlaveCurCentServerHostAddress,
                                                            SlaveCurLocalHostAddress,
                                                            ServerList[0] );
+
+            // tell the central server which newer messages we understand (an
+            // old central server ignores this message)
+            pConnLessProtocol->CreateCLServerFeaturesMes ( SlaveCurCentServerHostAddress,
+                                                           CLM_SERVER_FEATURE_SEND_EMPTY_MES_LIST );
+
+            // a member of a server pool reports its last load (an old central
+            // server ignores this message)
+            if ( !strServerPool.isEmpty() )
+            {
+                pConnLessProtocol->CreateCLServerLoadMes ( SlaveCurCentServerHostAddress,
+                                                           strServerPool,
+                                                           iPoolNumClients,
+                                                           iPoolLoadPct );
+            }
         }
         else
         {
@@ -599,6 +1357,55 @@ void CServerListManager::SlaveServerRegisterServer ( const bool bIsRegister )
     }
 }
 
+void CServerListManager::SetServerPool ( const QString& strNewPool )
+{
+    QMutexLocker locker ( &Mutex );
+
+    // the pool is shown with its name in the server list
+    strServerPool = strNewPool.left ( MAX_LEN_SERVER_NAME );
+
+    if ( bEnabled && !bIsCentralServer && !strServerPool.isEmpty() )
+    {
+        TimerPoolLoad.Start ( SERVLIST_POOL_LOAD_INTERVAL_S * 1000 );
+    }
+    else
+    {
+        TimerPoolLoad.Stop();
+    }
+}
+
+void CServerListManager::SlaveServerSendLoad ( const int iNumClients,
+                                               const int iLoadPct )
+{
+    QMutexLocker locker ( &Mutex );
+
+    // the last load is also sent with the next registration
+    iPoolNumClients = iNumClients;
+    iPoolLoadPct    = std::min ( std::max ( iLoadPct, 0 ), 100 );
+
+    if ( !strServerPool.isEmpty() && ( eSvrRegStatus == SRS_REGISTERED ) )
+    {
+        pConnLessProtocol->CreateCLServerLoadMes ( SlaveCurCentServerHostAddress,
+                                                   strServerPool,
+                                                   iPoolNumClients,
+                                                   iPoolLoadPct );
+    }
+}
+
+void CServerListManager::OnHostNameResolved ( QString )
+{
+    QMutexLocker locker ( &Mutex );
+
+    // the registration waits for the address of the central server
+    if ( bSvrRegAddrPending && bEnabled && !bIsCentralServer )
+    {
+        locker.unlock();
+        {
+            SlaveServerRegisterServer ( true );
+        }
+    }
+}
+
 void CServerListManager::SetSvrRegStatus ( ESvrRegStatus eNSvrRegStatus )
 {
     // output regirstation result/update on the console
@@ -62,8 +62,13 @@ private network.
 #include <QObject>
 #include <QLocale>
 #include <QList>
+#include <QHash>
 #include <QElapsedTimer>
 #include <QMutex>
+#include <queue>
+#include <vector>
+#include <functional>
+#include <random>
 #include "global.h"
 #include "util.h"
 #include "protocol.h"
@@ -80,7 +85,11 @@ public:
                       QLocale::AnyCountry,
                       "",
                       0,
-                      false ) { UpdateRegistration(); }
+                      false ),
+        iFeatures ( 0 ),
+        iNumClients ( 0 ),
+        iLoadPct ( 0 ),
+        iLoadTimeMs ( -1 ) { UpdateRegistration(); }
 
     CServerListEntry ( const CHostAddress&     NHAddr,
                        const CHostAddress&     NLHAddr,
@@ -95,7 +104,11 @@ public:
                         NeCountry,
                         NsCity,
                         NiMaxNumClients,
-                        NbPermOnline ) { UpdateRegistration(); }
+                        NbPermOnline ),
+          iFeatures ( 0 ),
+          iNumClients ( 0 ),
+          iLoadPct ( 0 ),
+          iLoadTimeMs ( -1 ) { UpdateRegistration(); }
 
     CServerListEntry ( const CHostAddress&    NHAddr,
                        const CHostAddress&    NLHAddr,
@@ -106,7 +119,11 @@ public:
                         NewCoreServerInfo.eCountry,
                         NewCoreServerInfo.strCity,
                         NewCoreServerInfo.iMaxNumClients,
-                        NewCoreServerInfo.bPermanentOnline )
+                        NewCoreServerInfo.bPermanentOnline ),
+          iFeatures ( 0 ),
+          iNumClients ( 0 ),
+          iLoadPct ( 0 ),
+          iLoadTimeMs ( -1 )
         { UpdateRegistration(); }
 
     void UpdateRegistration() { RegisterTime.start(); }
@@ -114,6 +131,24 @@ public:
 public:
     // time on which the entry was registered
     QElapsedTimer RegisterTime;
+
+    // features reported by the server (CLM_SERVER_FEATURE_x flags)
+    uint32_t      iFeatures;
+
+    // server pool of the server (empty if it is no pool member) and its last
+    // load report (the time is -1 if no report was received)
+    QString       strPool;
+    int           iNumClients;
+    int           iLoadPct;
+    qint64        iLoadTimeMs;
+
+    // central server of the federation at which the server has registered,
+    // empty if the server has registered at this central server
+    CHostAddress  OriginAddr;
+
+    // clients which requested the server list since the last "send empty
+    // message list" message to this server
+    CVector<CHostAddress> vecPendingEmptyMesAddr;
 };
 
 class CServerListManager : public QObject
@@ -124,6 +159,7 @@ public:
     CServerListManager ( const quint16  iNPortNum,
                          const QString& sNCentServAddr,
                          const QString& strServerInfo,
+                         const QString& strFederationPeers,
                          const int      iNumChannels,
                          const bool     bNCentServPingServerInList,
                          CProtocol*     pNConLProt );
@@ -151,23 +187,54 @@ public:
 
     void CentralServerQueryServerList ( const CHostAddress& InetAddr );
 
+    void CentralServerQueryServerListPage ( const CHostAddress&      InetAddr,
+                                            const CServerListFilter& Filter,
+                                            const int                iPage );
+
+    // the servers with an IPv6 address (they are not part of the list pages)
+    void CentralServerQueryServerListIPv6 ( const CHostAddress&      InetAddr,
+                                            const CServerListFilter& Filter );
+
+    void CentralServerSetServerFeatures ( const CHostAddress& InetAddr,
+                                          const uint32_t      iFeatures );
+
+    void CentralServerSetServerLoad ( const CHostAddress& InetAddr,
+                                      const QString&      strPool,
+                                      const int           iNumClients,
+                                      const int           iLoadPct );
+
+    void CentralServerFederationUpdate ( const CHostAddress&                   InetAddr,
+                                         const CVector<CFederationServerInfo>& vecServerInfo );
+
+    void CentralServerFederationSync ( const CHostAddress& InetAddr );
+
     void SlaveServerUnregister() { SlaveServerRegisterServer ( false ); }
 
+    // server pool (slave server): the central server shows the servers of a
+    // pool as one entry with the address of the member with the lowest load,
+    // the load is reported with each registration and every
+    // SERVLIST_POOL_LOAD_INTERVAL_S seconds (ServerLoadRequested())
+    void    SetServerPool ( const QString& strNewPool );
+    QString GetServerPool() { QMutexLocker locker ( &Mutex ); return strServerPool; }
+
+    void SlaveServerSendLoad ( const int iNumClients,
+                               const int iLoadPct );
+
     // set server infos -> per definition the server info of this server is
     // stored in the first entry of the list, we assume here that the first
     // entry is correctly created in the constructor of the class
     void SetServerName ( const QString& strNewName )
-        { ServerList[0].strName = strNewName; }
+        { ServerList[0].strName = strNewName; bServerListMesValid = false; }
 
     QString GetServerName() { return ServerList[0].strName; }
 
     void SetServerCity ( const QString& strNewCity )
-        { ServerList[0].strCity = strNewCity; }
+        { ServerList[0].strCity = strNewCity; bServerListMesValid = false; }
 
     QString GetServerCity() { return ServerList[0].strCity; }
 
     void SetServerCountry ( const QLocale::Country eNewCountry )
-        { ServerList[0].eCountry = eNewCountry; }
+        { ServerList[0].eCountry = eNewCountry; bServerListMesValid = false; }
 
     QLocale::Country GetServerCountry() { return ServerList[0].eCountry; }
 
@@ -175,21 +242,106 @@ public:
 
     void StoreRegistrationResult ( ESvrRegResult eStatus );
 
+    // the central server requests the next registration after this time
+    void StoreRegistrationRetryAfter ( const CHostAddress& InetAddr,
+                                       const int           iRetryAfterS );
+
 protected:
     void SlaveServerRegisterServer ( const bool bIsRegister );
     void SetSvrRegStatus ( ESvrRegStatus eNSvrRegStatus );
 
-    QTimer                  TimerPollList;
-    QTimer                  TimerRegistering;
-    QTimer                  TimerPingServerInList;
-    QTimer                  TimerPingCentralServer;
-    QTimer                  TimerCLRegisterServerResp;
+    // the interval shortened by a random amount of up to
+    // SERVLIST_TIMER_JITTER_PCT (the intervals must not become longer since the
+    // registration must be renewed before the entry times out and the NAT port
+    // must be kept open)
+    int GetJitteredIntervalMs ( const int iIntervalMs );
+
+    // registered servers (central server): the address index and the expiry
+    // queue must be updated with every change of the server list
+    void AddToExpiryQueue ( const CHostAddress& HostAddr );
+    void RemoveRegisteredServer ( const int iIdx );
+
+    // the registered servers have changed (not only renewed their registration)
+    void InvalidateServerListCache() { bServerListMesValid = false; bCountryBucketsValid = false; }
+
+    // the server shall send an empty message to the client which requested
+    // the server list (NAT hole punching)
+    void RequestEmptyMes ( const int iIdx, const CHostAddress& InetAddr );
+
+    // the server list entry as it is sent to the client
+    CServerInfo GetServerInfoForClient ( const int iIdx, const CHostAddress& InetAddr );
+
+    // server pools (central server): only the chosen member of a pool is in
+    // the server list, the choice is updated with the load reports
+    bool IsHiddenPoolMember ( const int iIdx ) const;
+    void UpdatePoolChoice ( const QString& strPool );
+
+    static bool IsFilterMatch ( const CServerListEntry&  Entry,
+                                const CServerListFilter& Filter );
+
+    // federation of central servers: the servers which registered at this
+    // central server are replicated to the other central servers
+    int  GetMaxNumServers() const { return MAX_NUM_SERVERS_IN_SERVER_LIST * ( 1 + vecFederationPeers.Size() ); }
+    bool IsFederationPeer ( const CHostAddress& InetAddr ) const;
+    void SendFederationUpdate ( const int iIdx, const bool bRemove );
+
+    // entry of the expiry queue, an entry is stale if the server has renewed
+    // its registration in the meantime (then a later entry exists)
+    class CExpiryEntry
+    {
+    public:
+        CExpiryEntry ( const qint64 iNTimeMs, const CHostAddress& NHostAddr ) :
+            iExpiryTimeMs ( iNTimeMs ), HostAddr ( NHostAddr ) {}
+
+        bool operator> ( const CExpiryEntry& Other ) const { return iExpiryTimeMs > Other.iExpiryTimeMs; }
+
+        qint64       iExpiryTimeMs;
+        CHostAddress HostAddr;
+    };
+
+    CWheelTimer             TimerPollList;
+    CWheelTimer             TimerRegistering;
+    CWheelTimer             TimerPingServerInList;
+    CWheelTimer             TimerPingCentralServer;
+    CWheelTimer             TimerCLRegisterServerResp;
+    CWheelTimer             TimerSendEmptyMesList;
+    CWheelTimer             TimerIsPermanent;
+    CWheelTimer             TimerPoolLoad;
 
     QMutex                  Mutex;
     QTextStream&            tsConsoleStream;
 
     QList<CServerListEntry> ServerList;
 
+    // index of the list entries by host address (except of the very first
+    // entry which is this server) and a min-heap of the expiry times
+    QHash<CHostAddress, int> ServerListIndex;
+    std::priority_queue<CExpiryEntry,
+                        std::vector<CExpiryEntry>,
+                        std::greater<CExpiryEntry> > ExpiryQueue;
+    QElapsedTimer           ExpiryTimer;
+
+    // the encoded server list message (central server) is cached until the
+    // server list changes
+    bool                    bServerListMesValid;
+    CProtMessage            ServerListMes;
+
+    // indices of the registered servers per country for the paged queries
+    // (rebuilt on the first query after a change of the server list)
+    bool                    bCountryBucketsValid;
+    QHash<int, CVector<int> > CountryBuckets;
+
+    // the other central servers of the federation (if any)
+    CVector<CHostAddress>   vecFederationPeers;
+
+    // the chosen member of each server pool (central server)
+    QHash<QString, CHostAddress> PoolChoice;
+
+    // server pool of this server and its last load (slave server)
+    QString                 strServerPool;
+    int                     iPoolNumClients;
+    int                     iPoolLoadPct;
+
     QString                 strCentralServerAddress;
     int                     iNumPredefinedServers;
     bool                    bEnabled;
@@ -208,14 +360,31 @@ protected:
     // count of registration retries
     int                     iSvrRegRetries;
 
+    // count of consecutive registration time outs (the next registration is
+    // delayed exponentially)
+    int                     iSvrRegNumTimeOuts;
+
+    // the group of the servers in the list which is pinged next
+    int                     iPingServerSlice;
+
+    // random numbers for the jitter of the timers
+    std::mt19937            RandomGenerator;
+
+    // the host name of the central server is looked up
+    bool                    bSvrRegAddrPending;
+
 public slots:
     void OnTimerPollList();
     void OnTimerPingServerInList();
     void OnTimerPingCentralServer();
     void OnTimerCLRegisterServerResp();
-    void OnTimerRegistering() { SlaveServerRegisterServer ( true ); }
-    void OnTimerIsPermanent() { ServerList[0].bPermanentOnline = true; }
+    void OnTimerSendEmptyMesList();
+    void OnTimerRegistering();
+    void OnTimerIsPermanent() { ServerList[0].bPermanentOnline = true; bServerListMesValid = false; }
+    void OnTimerPoolLoad() { emit ServerLoadRequested(); }
+    void OnHostNameResolved ( QString );
 
 signals:
     void SvrRegStatusChanged();
+    void ServerLoadRequested();
 };
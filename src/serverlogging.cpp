@@ -23,28 +23,156 @@
 \******************************************************************************/
 
 #include "serverlogging.h"
+#include <QtEndian>
+#include <climits>
+#include <cstring>
 
-// Server logging --------------------------------------------------------------
-CServerLogging::~CServerLogging()
+// Server log writer -----------------------------------------------------------
+bool CServerLogWriter::Start ( const QString& strFileName,
+                              const int      iNFlushIntervalMs,
+                              const qint64   iNMaxFileSize )
 {
-    // close logging file of open
-    if ( File.isOpen() )
+    // open file
+    File.setFileName ( strFileName );
+
+    if ( !File.open ( QIODevice::Append | QIODevice::Text ) )
     {
-        File.close();
+        return false;
     }
+
+    iFlushIntervalMs = iNFlushIntervalMs;
+    iMaxFileSize     = iNMaxFileSize;
+    bRun             = true;
+
+    start ( QThread::LowPriority );
+
+    return true;
 }
 
-void CServerLogging::Start ( const QString& strLoggingFileName )
+void CServerLogWriter::Stop()
 {
-    // open file
-    File.setFileName ( strLoggingFileName );
+    if ( isRunning() )
+    {
+        // the thread writes the remaining queued lines before it quits
+        Mutex.lock();
+        {
+            bRun = false;
+            WaitCondition.wakeOne();
+        }
+        Mutex.unlock();
+
+        wait();
+    }
+}
+
+void CServerLogWriter::Put ( const QString& strLine )
+{
+    QMutexLocker locker ( &Mutex );
+
+    strQueuedLines.append ( strLine );
+
+    // do not wait for the flush interval if a batch is complete
+    if ( ( iFlushIntervalMs <= 0 ) || ( strQueuedLines.size() >= LOG_WRITER_BATCH_SIZE ) )
+    {
+        WaitCondition.wakeOne();
+    }
+}
+
+void CServerLogWriter::run()
+{
+    QStringList strLines;
+
+    Mutex.lock();
+
+    while ( bRun )
+    {
+        if ( strQueuedLines.isEmpty() ||
+             ( ( iFlushIntervalMs > 0 ) && ( strQueuedLines.size() < LOG_WRITER_BATCH_SIZE ) ) )
+        {
+            WaitCondition.wait ( &Mutex, iFlushIntervalMs > 0 ?
+                                 static_cast<unsigned long> ( iFlushIntervalMs ) : ULONG_MAX );
+        }
+
+        // take the queued lines and write them without holding the mutex
+        strLines.swap ( strQueuedLines );
+
+        Mutex.unlock();
+        WriteLines ( strLines );
+        strLines.clear();
+        Mutex.lock();
+    }
+
+    // write the lines which were queued before the stop
+    strLines.swap ( strQueuedLines );
+
+    Mutex.unlock();
+    WriteLines ( strLines );
+
+    File.close();
+}
+
+void CServerLogWriter::WriteLines ( const QStringList& strLines )
+{
+    if ( strLines.isEmpty() || !File.isOpen() )
+    {
+        return;
+    }
+
+    // append new lines in logging file
+    QTextStream out ( &File );
+
+    for ( int i = 0; i < strLines.size(); i++ )
+    {
+        out << strLines[i] << "\n";
+    }
+
+    out.flush();
+    File.flush();
 
-    if ( File.open ( QIODevice::Append | QIODevice::Text ) )
+    if ( ( iMaxFileSize > 0 ) && ( File.size() >= iMaxFileSize ) )
     {
-        bDoLogging = true;
+        RotateFiles();
     }
 }
 
+void CServerLogWriter::RotateFiles()
+{
+    const QString strFileName = File.fileName();
+
+    File.close();
+
+    // shift the rotated files, the oldest file is removed
+    QFile::remove ( strFileName + "." + QString::number ( LOG_NUM_ROTATED_FILES ) );
+
+    for ( int i = LOG_NUM_ROTATED_FILES - 1; i >= 1; i-- )
+    {
+        QFile::rename ( strFileName + "." + QString::number ( i ),
+                        strFileName + "." + QString::number ( i + 1 ) );
+    }
+
+    QFile::rename ( strFileName, strFileName + ".1" );
+
+    // continue with an empty log file
+    File.open ( QIODevice::Append | QIODevice::Text );
+}
+
+
+// Server logging --------------------------------------------------------------
+CServerLogging::~CServerLogging()
+{
+    // write the queued lines and close logging file
+    LogWriter.Stop();
+}
+
+void CServerLogging::Start ( const QString& strLoggingFileName,
+                             const int      iFlushIntervalMs,
+                             const int      iMaxFileSizeMB )
+{
+    bDoLogging = LogWriter.Start ( strLoggingFileName,
+                                   iFlushIntervalMs,
+                                   static_cast<qint64> ( iMaxFileSizeMB ) * 1024 * 1024 );
+}
+
 void CServerLogging::EnableHistory ( const QString& strHistoryFileName )
 {
 #ifndef HEADLESS
@@ -101,69 +229,50 @@ void CServerLogging::operator<< ( const QString& sNewStr )
 {
     if ( bDoLogging )
     {
-        // append new line in logging file
-        QTextStream out ( &File );
-        out << sNewStr << endl;
-        File.flush();
+        // the line is written in the log file by the writer thread
+        LogWriter.Put ( sNewStr );
     }
 }
 
 void CServerLogging::ParseLogFile ( const QString& strFileName )
 {
-    // open file for reading
-    QFile LogFile ( strFileName );
-    LogFile.open ( QIODevice::ReadOnly | QIODevice::Text );
+    CServerHistoryIndex                        HistoryIndex;
+    CVector<CServerHistoryIndex::SHistoryItem> vecHistoryItems;
 
-    QTextStream inStream ( &LogFile );
-
-    // read all content from file
-    while ( !inStream.atEnd() )
+    if ( HistoryIndex.Update ( strFileName + HISTORY_INDEX_FILE_SUFFIX, strFileName ) )
     {
-        // get a new line from log file
-        QString strCurLine = inStream.readLine();
-
-        // parse log file line
-        QStringList strlistCurLine = strCurLine.split ( "," );
+        // only the items of the history window are read from the index
+        HistoryIndex.GetItems ( QDate::currentDate().addDays ( -iHistMaxDays ), vecHistoryItems );
+    }
+    else
+    {
+        // the index file cannot be used, parse the complete log file
+        QFile LogFile ( strFileName );
 
-        // check number of separated strings condition
-        if ( strlistCurLine.size() == 3 )
+        if ( LogFile.open ( QIODevice::ReadOnly | QIODevice::Text ) )
         {
-            // first entry
-            QDateTime curDateTime =
-                QDateTime::fromString ( strlistCurLine.at ( 0 ).trimmed(),
-                "yyyy-MM-dd HH:mm:ss" );
+            QTextStream                       inStream ( &LogFile );
+            CServerHistoryIndex::SHistoryItem HistoryItem;
 
-            if ( curDateTime.isValid() )
+            // read all content from file
+            while ( !inStream.atEnd() )
             {
-                // check if server stop or new client connection
-                QString strAddress = strlistCurLine.at ( 1 ).trimmed();
-
-                if ( strAddress.isEmpty() )
+                if ( CServerHistoryIndex::ParseLogLine ( inStream.readLine(), HistoryItem ) )
                 {
-                    // server stop
-#ifndef HEADLESS
-                    JpegHistoryGraph.Add ( curDateTime, AHistoryGraph::HIT_SERVER_STOP );
-#endif
-                    SvgHistoryGraph.Add ( curDateTime, CSvgHistoryGraph::HIT_SERVER_STOP );
-                }
-                else
-                {
-                    QHostAddress curAddress;
-                    
-                    // second entry is IP address
-                    if ( curAddress.setAddress ( strlistCurLine.at ( 1 ).trimmed() ) )
-                    {
-                        // new client connection
-#ifndef HEADLESS
-                        JpegHistoryGraph.Add ( curDateTime, curAddress );
-#endif
-                        SvgHistoryGraph.Add ( curDateTime, curAddress );
-                    }
+                    vecHistoryItems.Add ( HistoryItem );
                 }
             }
         }
     }
 
+    for ( int i = 0; i < vecHistoryItems.Size(); i++ )
+    {
+#ifndef HEADLESS
+        JpegHistoryGraph.Add ( vecHistoryItems[i].DateTime, vecHistoryItems[i].Type );
+#endif
+        SvgHistoryGraph.Add ( vecHistoryItems[i].DateTime, vecHistoryItems[i].Type );
+    }
+
 #ifndef HEADLESS
     JpegHistoryGraph.Update();
 #endif
@@ -178,3 +287,208 @@ QString CServerLogging::CurTimeDatetoLogString()
     // format date and time output according to "2006-09-30 11:38:08"
     return curDateTime.toString("yyyy-MM-dd HH:mm:ss");
 }
+
+
+// Server history index --------------------------------------------------------
+bool CServerHistoryIndex::Update ( const QString& strIndexFileName,
+                                   const QString& strLogFileName )
+{
+    File.setFileName ( strIndexFileName );
+
+    if ( !File.open ( QIODevice::ReadWrite ) )
+    {
+        return false;
+    }
+
+    // check the header, an invalid index file is created again
+    const QByteArray baHeader    = File.read ( HISTORY_INDEX_HEADER_SIZE );
+    const uchar*     pbyHeader   = reinterpret_cast<const uchar*> ( baHeader.constData() );
+    quint64          iLogFilePos = 0;
+
+    if ( ( baHeader.size() == HISTORY_INDEX_HEADER_SIZE ) &&
+         baHeader.startsWith ( HISTORY_INDEX_MAGIC ) &&
+         ( qFromLittleEndian<quint16> ( pbyHeader + 6 ) == HISTORY_INDEX_VERSION ) )
+    {
+        iLogFilePos = qFromLittleEndian<quint64> ( pbyHeader + 8 );
+
+        // remove an incomplete record at the end of the file
+        File.resize ( HISTORY_INDEX_HEADER_SIZE +
+                      static_cast<qint64> ( GetNumRecords() ) * HISTORY_INDEX_RECORD_SIZE );
+    }
+    else
+    {
+        File.resize ( 0 );
+        WriteHeader ( 0 );
+    }
+
+    // parse the part of the log file which is not yet in the index
+    QFile LogFile ( strLogFileName );
+
+    if ( LogFile.open ( QIODevice::ReadOnly ) )
+    {
+        if ( static_cast<quint64> ( LogFile.size() ) < iLogFilePos )
+        {
+            // the log file was rotated, the records of the new log file are
+            // appended to the existing records
+            iLogFilePos = 0;
+        }
+
+        LogFile.seek ( static_cast<qint64> ( iLogFilePos ) );
+
+        QByteArray   baRecords;
+        uchar        vecbyRecord[HISTORY_INDEX_RECORD_SIZE];
+        SHistoryItem HistoryItem;
+
+        while ( !LogFile.atEnd() )
+        {
+            const QByteArray baLine = LogFile.readLine();
+
+            // an incomplete last line is parsed on the next update
+            if ( !baLine.endsWith ( '\n' ) )
+            {
+                break;
+            }
+
+            iLogFilePos = static_cast<quint64> ( LogFile.pos() );
+
+            if ( ParseLogLine ( QString::fromUtf8 ( baLine ), HistoryItem ) )
+            {
+                qToLittleEndian<quint32> ( static_cast<quint32> ( HistoryItem.DateTime.toMSecsSinceEpoch() / 1000 ),
+                                           vecbyRecord );
+
+                vecbyRecord[4] = static_cast<uchar> ( HistoryItem.Type );
+
+                baRecords.append ( reinterpret_cast<const char*> ( vecbyRecord ), HISTORY_INDEX_RECORD_SIZE );
+            }
+        }
+
+        // the records are appended before the new log file position is stored
+        File.seek ( File.size() );
+        File.write ( baRecords );
+        WriteHeader ( iLogFilePos );
+        File.flush();
+    }
+
+    return true;
+}
+
+void CServerHistoryIndex::GetItems ( const QDate&           MinDate,
+                                     CVector<SHistoryItem>& vecItems )
+{
+    const quint32 iMinTime = static_cast<quint32> ( std::max<qint64> ( 0,
+        QDateTime ( MinDate, QTime ( 0, 0 ) ).toMSecsSinceEpoch() / 1000 ) );
+
+    // binary search for the first record of the history window
+    const int iNumRecords = GetNumRecords();
+    int       iFirstIdx   = 0;
+    int       iEndIdx     = iNumRecords;
+
+    while ( iFirstIdx < iEndIdx )
+    {
+        const int iMidIdx = ( iFirstIdx + iEndIdx ) / 2;
+
+        if ( GetRecordTime ( iMidIdx ) < iMinTime )
+        {
+            iFirstIdx = iMidIdx + 1;
+        }
+        else
+        {
+            iEndIdx = iMidIdx;
+        }
+    }
+
+    // read all records of the history window at once
+    File.seek ( HISTORY_INDEX_HEADER_SIZE + static_cast<qint64> ( iFirstIdx ) * HISTORY_INDEX_RECORD_SIZE );
+
+    const QByteArray baRecords  = File.read ( static_cast<qint64> ( iNumRecords - iFirstIdx ) * HISTORY_INDEX_RECORD_SIZE );
+    const uchar*     pbyRecords = reinterpret_cast<const uchar*> ( baRecords.constData() );
+    const int        iNumItems  = baRecords.size() / HISTORY_INDEX_RECORD_SIZE;
+
+    vecItems.Init ( iNumItems );
+
+    for ( int i = 0; i < iNumItems; i++ )
+    {
+        const uchar* pbyCurRecord = pbyRecords + i * HISTORY_INDEX_RECORD_SIZE;
+
+        vecItems[i].DateTime = QDateTime::fromMSecsSinceEpoch (
+            static_cast<qint64> ( qFromLittleEndian<quint32> ( pbyCurRecord ) ) * 1000 );
+
+        vecItems[i].Type = static_cast<AHistoryGraph::EHistoryItemType> ( pbyCurRecord[4] );
+    }
+}
+
+bool CServerHistoryIndex::ParseLogLine ( const QString& strLine,
+                                         SHistoryItem&  HistoryItem )
+{
+    // parse log file line
+    const QStringList strlistCurLine = strLine.split ( "," );
+
+    // check number of separated strings condition
+    if ( strlistCurLine.size() != 3 )
+    {
+        return false;
+    }
+
+    // first entry
+    HistoryItem.DateTime = QDateTime::fromString ( strlistCurLine.at ( 0 ).trimmed(),
+                                                   "yyyy-MM-dd HH:mm:ss" );
+
+    if ( !HistoryItem.DateTime.isValid() )
+    {
+        return false;
+    }
+
+    // check if server stop or new client connection
+    const QString strAddress = strlistCurLine.at ( 1 ).trimmed();
+
+    if ( strAddress.isEmpty() )
+    {
+        // server stop
+        HistoryItem.Type = AHistoryGraph::HIT_SERVER_STOP;
+        return true;
+    }
+
+    QHostAddress curAddress;
+
+    // second entry is IP address
+    if ( curAddress.setAddress ( strAddress ) )
+    {
+        // new client connection
+        HistoryItem.Type = AHistoryGraph::GetConnectionType ( curAddress );
+        return true;
+    }
+
+    return false;
+}
+
+int CServerHistoryIndex::GetNumRecords() const
+{
+    return static_cast<int> ( std::max<qint64> ( 0, File.size() - HISTORY_INDEX_HEADER_SIZE ) /
+                              HISTORY_INDEX_RECORD_SIZE );
+}
+
+quint32 CServerHistoryIndex::GetRecordTime ( const int iRecordIdx )
+{
+    uchar vecbyTime[4];
+
+    File.seek ( HISTORY_INDEX_HEADER_SIZE + static_cast<qint64> ( iRecordIdx ) * HISTORY_INDEX_RECORD_SIZE );
+
+    if ( File.read ( reinterpret_cast<char*> ( vecbyTime ), 4 ) != 4 )
+    {
+        return 0;
+    }
+
+    return qFromLittleEndian<quint32> ( vecbyTime );
+}
+
+void CServerHistoryIndex::WriteHeader ( const quint64 iLogFilePos )
+{
+    uchar vecbyHeader[HISTORY_INDEX_HEADER_SIZE];
+
+    memcpy ( vecbyHeader, HISTORY_INDEX_MAGIC, 6 );
+    qToLittleEndian<quint16> ( HISTORY_INDEX_VERSION, &vecbyHeader[6] );
+    qToLittleEndian<quint64> ( iLogFilePos,           &vecbyHeader[8] );
+
+    File.seek ( 0 );
+    File.write ( reinterpret_cast<const char*> ( vecbyHeader ), HISTORY_INDEX_HEADER_SIZE );
+}
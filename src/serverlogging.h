@@ -28,13 +28,108 @@
 #include <QHostAddress>
 #include <QFile>
 #include <QString>
+#include <QStringList>
 #include <QTimer>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 #include "global.h"
 #include "util.h"
 
 #include "historygraph.h"
 
+
+/* Definitions ****************************************************************/
+// default interval in which the queued lines are written in the log file
+#define LOG_DEFAULT_FLUSH_INTERVAL_MS    1000 // ms
+
+// number of queued lines which are written before the flush interval is over
+#define LOG_WRITER_BATCH_SIZE            256
+
+// number of rotated log files which are kept (file.1 is the newest)
+#define LOG_NUM_ROTATED_FILES            5
+
+// the history index file is stored next to the log file, it starts with the
+// magic string, the format version and the position in the log file up to
+// which the log was parsed, each record holds the time in seconds since epoch
+// (4 bytes) and the history item type (1 byte), all values are little endian
+#define HISTORY_INDEX_FILE_SUFFIX        ".hidx"
+#define HISTORY_INDEX_MAGIC              "JAMHIX"
+#define HISTORY_INDEX_VERSION            1
+#define HISTORY_INDEX_HEADER_SIZE        16 // bytes
+#define HISTORY_INDEX_RECORD_SIZE        5  // bytes
+
+
 /* Classes ********************************************************************/
+// Writes the log lines in a background thread. The lines are queued in memory
+// and written in batches so that the server never waits on the file system.
+class CServerLogWriter : public QThread
+{
+public:
+    CServerLogWriter() :
+        File             ( DEFAULT_LOG_FILE_NAME ),
+        iFlushIntervalMs ( LOG_DEFAULT_FLUSH_INTERVAL_MS ),
+        iMaxFileSize     ( 0 ),
+        bRun             ( false ) {}
+
+    virtual ~CServerLogWriter() { Stop(); }
+
+    // a flush interval of zero writes each line as soon as possible, a
+    // maximum file size of zero disables the log rotation
+    bool Start ( const QString& strFileName,
+                 const int      iNFlushIntervalMs,
+                 const qint64   iNMaxFileSize );
+
+    void Stop();
+    void Put ( const QString& strLine );
+
+protected:
+    virtual void run();
+    void WriteLines ( const QStringList& strLines );
+    void RotateFiles();
+
+    QFile          File;
+    int            iFlushIntervalMs;
+    qint64         iMaxFileSize;
+
+    QMutex         Mutex;
+    QWaitCondition WaitCondition;
+    QStringList    strQueuedLines;
+    bool           bRun;
+};
+
+// Binary index of the history items of the log file. The records are stored
+// in time order, the items of the history window are found by a binary search
+// and only the part of the log file which was written since the last update
+// of the index is parsed.
+class CServerHistoryIndex
+{
+public:
+    struct SHistoryItem
+    {
+        QDateTime                       DateTime;
+        AHistoryGraph::EHistoryItemType Type;
+    };
+
+    // appends the new items of the log file, if the log file is shorter than
+    // the parsed position (i.e., it was rotated), it is parsed from the start
+    bool Update ( const QString& strIndexFileName,
+                  const QString& strLogFileName );
+
+    void GetItems ( const QDate&            MinDate,
+                    CVector<SHistoryItem>& vecItems );
+
+    static bool ParseLogLine ( const QString& strLine,
+                               SHistoryItem&  HistoryItem );
+
+protected:
+    int     GetNumRecords() const;
+    quint32 GetRecordTime ( const int iRecordIdx );
+    void    WriteHeader ( const quint64 iLogFilePos );
+
+    QFile File;
+};
+
 class CServerLogging
 {
 public:
@@ -43,12 +138,14 @@ public:
         JpegHistoryGraph ( iMaxDaysHistory ),
 #endif
         SvgHistoryGraph ( iMaxDaysHistory ),
-        bDoLogging ( false ),
-        File ( DEFAULT_LOG_FILE_NAME ) {}
+        iHistMaxDays ( iMaxDaysHistory ),
+        bDoLogging ( false ) {}
 
     virtual ~CServerLogging();
 
-    void Start ( const QString& strLoggingFileName );
+    void Start ( const QString& strLoggingFileName,
+                 const int      iFlushIntervalMs = LOG_DEFAULT_FLUSH_INTERVAL_MS,
+                 const int      iMaxFileSizeMB = 0 );
     void EnableHistory ( const QString& strHistoryFileName );
     void AddNewConnection ( const QHostAddress& ClientInetAddr );
     void AddServerStopped();
@@ -62,6 +159,7 @@ protected:
     CJpegHistoryGraph JpegHistoryGraph;
 #endif
     CSvgHistoryGraph  SvgHistoryGraph;
+    int               iHistMaxDays;
     bool              bDoLogging;
-    QFile             File;
+    CServerLogWriter  LogWriter;
 };
@@ -0,0 +1,397 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "servermetrics.h"
+#include "server.h"
+
+
+// Server metrics exporter implementation **************************************
+void CServerMetricsExporter::Start ( const QString& strBindAddress )
+{
+    QHostAddress BindAddress = QHostAddress ( QHostAddress::LocalHost );
+    QString      strPort     = strBindAddress;
+    bool         bPortOK     = false;
+
+    // an address may precede the port number, separated by the last colon
+    const int iColonPos = strBindAddress.lastIndexOf ( ':' );
+
+    if ( iColonPos >= 0 )
+    {
+        QString strAddress = strBindAddress.left ( iColonPos );
+
+        // remove the brackets of an IPv6 address
+        if ( strAddress.startsWith ( '[' ) && strAddress.endsWith ( ']' ) )
+        {
+            strAddress = strAddress.mid ( 1, strAddress.length() - 2 );
+        }
+
+        strPort = strBindAddress.mid ( iColonPos + 1 );
+
+        if ( !BindAddress.setAddress ( strAddress ) )
+        {
+            throw CGenErr ( "Invalid address of the metrics exporter: " +
+                strBindAddress, "Network Error" );
+        }
+    }
+
+    const quint16 iPort = strPort.toUShort ( &bPortOK );
+
+    if ( !bPortOK || !TcpServer.listen ( BindAddress, iPort ) )
+    {
+        throw CGenErr ( "Cannot start the metrics exporter on " +
+            strBindAddress + " (maybe the port is already in use).", "Network Error" );
+    }
+
+    QObject::connect ( &TcpServer, &QTcpServer::newConnection,
+        this, &CServerMetricsExporter::OnNewConnection );
+}
+
+void CServerMetricsExporter::OnNewConnection()
+{
+    while ( TcpServer.hasPendingConnections() )
+    {
+        QTcpSocket* pSocket = TcpServer.nextPendingConnection();
+
+        QObject::connect ( pSocket, &QTcpSocket::readyRead,
+            this, &CServerMetricsExporter::OnReadyRead );
+
+        QObject::connect ( pSocket, &QTcpSocket::disconnected,
+            pSocket, &QTcpSocket::deleteLater );
+    }
+}
+
+void CServerMetricsExporter::OnReadyRead()
+{
+    QTcpSocket* pSocket = qobject_cast<QTcpSocket*> ( sender() );
+
+    if ( pSocket == nullptr )
+    {
+        return;
+    }
+
+    // only the request line is evaluated, the header fields are ignored
+    if ( !pSocket->canReadLine() )
+    {
+        if ( pSocket->bytesAvailable() > METRICS_MAX_REQUEST_SIZE )
+        {
+            pSocket->abort();
+        }
+
+        return;
+    }
+
+    const QList<QByteArray> vecRequest = pSocket->readLine ( METRICS_MAX_REQUEST_SIZE ).trimmed().split ( ' ' );
+
+    // we answer exactly one request per connection
+    QObject::disconnect ( pSocket, &QTcpSocket::readyRead,
+        this, &CServerMetricsExporter::OnReadyRead );
+
+    if ( ( vecRequest.size() >= 2 ) &&
+         ( vecRequest[0] == "GET" ) &&
+         ( ( vecRequest[1] == "/metrics" ) || vecRequest[1].startsWith ( "/metrics?" ) ) )
+    {
+        SendResponse ( pSocket,
+                       "200 OK",
+                       "text/plain; version=0.0.4; charset=utf-8",
+                       GetMetrics().toUtf8() );
+    }
+    else
+    {
+        SendResponse ( pSocket,
+                       "404 Not Found",
+                       "text/plain; charset=utf-8",
+                       "Not Found\n" );
+    }
+}
+
+void CServerMetricsExporter::SendResponse ( QTcpSocket*       pSocket,
+                                            const QByteArray& strStatus,
+                                            const QByteArray& strContentType,
+                                            const QByteArray& strBody )
+{
+    pSocket->write ( "HTTP/1.0 " + strStatus + "\r\n"
+                     "Content-Type: " + strContentType + "\r\n"
+                     "Content-Length: " + QByteArray::number ( strBody.size() ) + "\r\n"
+                     "Connection: close\r\n"
+                     "\r\n" );
+
+    pSocket->write ( strBody );
+
+    // the socket is closed after all data is written
+    pSocket->disconnectFromHost();
+}
+
+void CServerMetricsExporter::AddHeader ( QTextStream&  Stream,
+                                         const QString strName,
+                                         const QString strType,
+                                         const QString strHelp )
+{
+    Stream << "# HELP " << strName << " " << strHelp << "\n";
+    Stream << "# TYPE " << strName << " " << strType << "\n";
+}
+
+QString CServerMetricsExporter::GetMetrics()
+{
+    static const char* strStageNames[NUM_SERVER_FRAME_STAGES] =
+        { "collect", "decode", "common_mix", "levels", "mix_encode", "send" };
+
+    CServerMetricsSnapshot Snapshot;
+    QString                strMetrics;
+    QTextStream            Stream ( &strMetrics );
+
+    pServer->GetMetricsSnapshot ( Snapshot );
+
+    // frame timing ------------------------------------------------------------
+    AddHeader ( Stream, "jamulus_server_frames_total", "counter",
+        "Number of processed server frames." );
+    Stream << "jamulus_server_frames_total " << Snapshot.iNumFrames << "\n";
+
+    AddHeader ( Stream, "jamulus_server_frame_deadline_usage_sum", "counter",
+        "Sum of the used ratios of the frame deadline (divided by the number of frames it is the average usage)." );
+    Stream << "jamulus_server_frame_deadline_usage_sum " << Snapshot.dUsageSum << "\n";
+
+    AddHeader ( Stream, "jamulus_server_frame_deadline_usage_max", "gauge",
+        "Maximum used ratio of the frame deadline in the current statistics interval." );
+    Stream << "jamulus_server_frame_deadline_usage_max " << Snapshot.dUsageMax << "\n";
+
+    AddHeader ( Stream, "jamulus_server_frame_deadline_overruns_total", "counter",
+        "Number of frames which needed longer than the frame deadline." );
+    Stream << "jamulus_server_frame_deadline_overruns_total " << Snapshot.iNumOverruns << "\n";
+
+    AddHeader ( Stream, "jamulus_server_timer_missed_ticks_total", "counter",
+        "Number of missed timer ticks." );
+    Stream << "jamulus_server_timer_missed_ticks_total " << Snapshot.iNumMissedTicks << "\n";
+
+    AddHeader ( Stream, "jamulus_server_timer_tick_jitter_max_seconds", "gauge",
+        "Maximum timer tick jitter in the current statistics interval." );
+    Stream << "jamulus_server_timer_tick_jitter_max_seconds " << Snapshot.dTickJitterMaxUs / 1000000 << "\n";
+
+    AddHeader ( Stream, "jamulus_server_overload_level", "gauge",
+        "Current overload level (0: normal processing)." );
+    Stream << "jamulus_server_overload_level " << Snapshot.iOverloadLevel << "\n";
+
+    // the stage durations are only available if the profiling is enabled
+    if ( Snapshot.bProfileValid )
+    {
+        AddHeader ( Stream, "jamulus_server_stage_duration_seconds", "gauge",
+            "Duration of the frame processing stages in the last profiling interval (quantile 1 is the maximum)." );
+
+        for ( int iS = 0; iS < NUM_SERVER_FRAME_STAGES; iS++ )
+        {
+            const QString strLabel = QString ( "jamulus_server_stage_duration_seconds{stage=\"%1\",quantile=" ).
+                arg ( strStageNames[iS] );
+
+            Stream << strLabel << "\"0.5\"} " << Snapshot.dStageP50Us[iS] / 1000000 << "\n";
+            Stream << strLabel << "\"0.99\"} " << Snapshot.dStageP99Us[iS] / 1000000 << "\n";
+            Stream << strLabel << "\"1\"} " << Snapshot.dStageMaxUs[iS] / 1000000 << "\n";
+        }
+    }
+
+    // clients -----------------------------------------------------------------
+    const int iMaxNumChannels = pServer->GetMaxNumChannels();
+
+    CVector<int>              veciChanIDs;
+    CVector<CChannelNetStats> vecNetStats;
+    CVector<int>              veciRttMs;
+    CVector<int>              veciRttJitterMs;
+    CVector<int>              veciJitBufNumFrames;
+    CVector<int>              veciMemUsage;
+    qint64                    iTotalMemUsage = 0;
+
+    for ( int i = 0; i < iMaxNumChannels; i++ )
+    {
+        CChannelNetStats NetStats;
+        int              iRttMs;
+        int              iRttJitterMs;
+        int              iJitBufNumFrames;
+
+        if ( pServer->GetChannelMetrics ( i, NetStats, iRttMs, iRttJitterMs, iJitBufNumFrames ) )
+        {
+            veciChanIDs.Add ( i );
+            vecNetStats.Add ( NetStats );
+            veciRttMs.Add ( iRttMs );
+            veciRttJitterMs.Add ( iRttJitterMs );
+            veciJitBufNumFrames.Add ( iJitBufNumFrames );
+            veciMemUsage.Add ( pServer->GetChannelMemUsage ( i ) );
+        }
+
+        // the idle channels are part of the total memory
+        iTotalMemUsage += pServer->GetChannelMemUsage ( i );
+    }
+
+    const int iNumClients = veciChanIDs.Size();
+
+    AddHeader ( Stream, "jamulus_server_connected_clients", "gauge",
+        "Number of connected clients." );
+    Stream << "jamulus_server_connected_clients " << iNumClients << "\n";
+
+    AddHeader ( Stream, "jamulus_server_max_clients", "gauge",
+        "Maximum number of clients." );
+    Stream << "jamulus_server_max_clients " << iMaxNumChannels << "\n";
+
+    AddHeader ( Stream, "jamulus_server_channel_memory_bytes", "gauge",
+        "Allocated memory of all channels (including the idle channels)." );
+    Stream << "jamulus_server_channel_memory_bytes " << iTotalMemUsage << "\n";
+
+    // per channel values (the counters start at zero on each new connection)
+    AddHeader ( Stream, "jamulus_channel_received_packets_total", "counter",
+        "Number of received audio packets." );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        Stream << "jamulus_channel_received_packets_total{channel=\"" << veciChanIDs[i] << "\"} " <<
+            vecNetStats[i].iNumReceived << "\n";
+    }
+
+    AddHeader ( Stream, "jamulus_channel_received_bytes_total", "counter",
+        "Number of received audio bytes." );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        Stream << "jamulus_channel_received_bytes_total{channel=\"" << veciChanIDs[i] << "\"} " <<
+            vecNetStats[i].iNumBytes << "\n";
+    }
+
+    AddHeader ( Stream, "jamulus_channel_lost_packets_total", "counter",
+        "Number of frames without data which were concealed by the decoder." );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        Stream << "jamulus_channel_lost_packets_total{channel=\"" << veciChanIDs[i] << "\"} " <<
+            vecNetStats[i].iNumLost << "\n";
+    }
+
+    AddHeader ( Stream, "jamulus_channel_jitter_buffer_overruns_total", "counter",
+        "Number of audio packets dropped because the jitter buffer was full." );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        Stream << "jamulus_channel_jitter_buffer_overruns_total{channel=\"" << veciChanIDs[i] << "\"} " <<
+            vecNetStats[i].iNumOverruns << "\n";
+    }
+
+    AddHeader ( Stream, "jamulus_channel_jitter_buffer_underruns_total", "counter",
+        "Number of times the jitter buffer ran empty." );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        Stream << "jamulus_channel_jitter_buffer_underruns_total{channel=\"" << veciChanIDs[i] << "\"} " <<
+            vecNetStats[i].iNumUnderruns << "\n";
+    }
+
+    AddHeader ( Stream, "jamulus_channel_late_frames_total", "counter",
+        "Number of frames received after they were concealed (sequence mode only)." );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        Stream << "jamulus_channel_late_frames_total{channel=\"" << veciChanIDs[i] << "\"} " <<
+            vecNetStats[i].iNumLate << "\n";
+    }
+
+    AddHeader ( Stream, "jamulus_channel_packet_jitter_seconds", "gauge",
+        "Arrival jitter of the audio packets (sequence mode only)." );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        Stream << "jamulus_channel_packet_jitter_seconds{channel=\"" << veciChanIDs[i] << "\"} " <<
+            vecNetStats[i].iJitterUs / 1e6 << "\n";
+    }
+
+    AddHeader ( Stream, "jamulus_channel_jitter_buffer_frames", "gauge",
+        "Size of the jitter buffer in frames." );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        Stream << "jamulus_channel_jitter_buffer_frames{channel=\"" << veciChanIDs[i] << "\"} " <<
+            veciJitBufNumFrames[i] << "\n";
+    }
+
+    AddHeader ( Stream, "jamulus_channel_jitter_buffer_delay_seconds", "gauge",
+        "Measured average time a frame waits in the jitter buffer." );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        Stream << "jamulus_channel_jitter_buffer_delay_seconds{channel=\"" << veciChanIDs[i] << "\"} " <<
+            vecNetStats[i].iQueueDelayUs / 1e6 << "\n";
+    }
+
+    AddHeader ( Stream, "jamulus_channel_memory_bytes", "gauge",
+        "Allocated memory of the channel." );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        Stream << "jamulus_channel_memory_bytes{channel=\"" << veciChanIDs[i] << "\"} " <<
+            veciMemUsage[i] << "\n";
+    }
+
+    // the round trip time is only known for clients which answer the probes
+    AddHeader ( Stream, "jamulus_channel_rtt_seconds", "gauge",
+        "Smoothed round trip time to the client." );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        if ( veciRttMs[i] >= 0 )
+        {
+            Stream << "jamulus_channel_rtt_seconds{channel=\"" << veciChanIDs[i] << "\"} " <<
+                static_cast<double> ( veciRttMs[i] ) / 1000 << "\n";
+        }
+    }
+
+    AddHeader ( Stream, "jamulus_channel_rtt_jitter_seconds", "gauge",
+        "Mean deviation of the round trip time to the client." );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        if ( veciRttJitterMs[i] >= 0 )
+        {
+            Stream << "jamulus_channel_rtt_jitter_seconds{channel=\"" << veciChanIDs[i] << "\"} " <<
+                static_cast<double> ( veciRttJitterMs[i] ) / 1000 << "\n";
+        }
+    }
+
+    // recorder ----------------------------------------------------------------
+    AddHeader ( Stream, "jamulus_recorder_enabled", "gauge",
+        "1 if the jam recording is enabled." );
+    Stream << "jamulus_recorder_enabled " << ( pServer->GetRecordingEnabled() ? 1 : 0 ) << "\n";
+
+    AddHeader ( Stream, "jamulus_recorder_queue_frames", "gauge",
+        "Number of frames waiting to be written by the recorder." );
+    Stream << "jamulus_recorder_queue_frames " << pServer->GetRecorderQueueLength() << "\n";
+
+    AddHeader ( Stream, "jamulus_recorder_dropped_frames_total", "counter",
+        "Number of frames dropped because the recorder could not keep up." );
+    Stream << "jamulus_recorder_dropped_frames_total " << pServer->GetRecorderNumDroppedFrames() << "\n";
+
+    AddHeader ( Stream, "jamulus_recorder_written_bytes_total", "counter",
+        "Amount of PCM data written by the recorder (KiB resolution)." );
+    Stream << "jamulus_recorder_written_bytes_total " << static_cast<qint64> ( pServer->GetRecorderNumWrittenKiB() ) * 1024 << "\n";
+
+    AddHeader ( Stream, "jamulus_recorder_paused_tracks", "gauge",
+        "Number of tracks paused because the recorder could not keep up." );
+    Stream << "jamulus_recorder_paused_tracks " << pServer->GetRecorderNumPausedTracks() << "\n";
+
+    Stream.flush();
+
+    return strMetrics;
+}
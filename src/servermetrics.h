@@ -0,0 +1,80 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QTextStream>
+#include "global.h"
+
+
+/* Definitions ****************************************************************/
+// maximum length of the HTTP request line of the metrics exporter, longer
+// requests are not accepted
+#define METRICS_MAX_REQUEST_SIZE            4096 // bytes
+
+
+/* Classes ********************************************************************/
+class CServer; // forward declaration
+
+// Exports the server state in the Prometheus text format on a small embedded
+// HTTP server ("GET /metrics"). The exporter only reads the metrics snapshot
+// which is published by the server timer and atomic counters, the audio
+// processing is never locked by a request.
+class CServerMetricsExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    CServerMetricsExporter ( CServer* pNServP ) : pServer ( pNServP ) {}
+
+    // the address has the format [address:]port, if no address is given only
+    // requests from the local host are accepted
+    void Start ( const QString& strBindAddress );
+
+    bool IsEnabled() const { return TcpServer.isListening(); }
+
+    QString GetMetrics();
+
+protected:
+    void SendResponse ( QTcpSocket*       pSocket,
+                        const QByteArray& strStatus,
+                        const QByteArray& strContentType,
+                        const QByteArray& strBody );
+
+    static void AddHeader ( QTextStream&  Stream,
+                            const QString strName,
+                            const QString strType,
+                            const QString strHelp );
+
+    CServer*   pServer;
+    QTcpServer TcpServer;
+
+public slots:
+    void OnNewConnection();
+    void OnReadyRead();
+};
@@ -0,0 +1,107 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "serverstatus.h"
+#include <QSaveFile>
+
+
+/* Implementation *************************************************************/
+void CServerStatusWriter::Start ( const QString& strNewFileName )
+{
+    strFileName = strNewFileName;
+    bIsJson     = strFileName.endsWith ( ".json", Qt::CaseInsensitive );
+    bRun        = true;
+
+    start ( QThread::LowPriority );
+}
+
+void CServerStatusWriter::Stop()
+{
+    if ( isRunning() )
+    {
+        // the thread writes a pending status before it quits
+        Mutex.lock();
+        {
+            bRun = false;
+            WaitCondition.wakeOne();
+        }
+        Mutex.unlock();
+
+        wait();
+    }
+}
+
+void CServerStatusWriter::Put ( const QByteArray& baNewStatus )
+{
+    QMutexLocker locker ( &Mutex );
+
+    // only a changed status is written
+    if ( baNewStatus != baCurStatus )
+    {
+        baCurStatus = baNewStatus;
+        bNewStatus  = true;
+
+        WaitCondition.wakeOne();
+    }
+}
+
+void CServerStatusWriter::run()
+{
+    Mutex.lock();
+
+    while ( bRun || bNewStatus )
+    {
+        if ( !bNewStatus )
+        {
+            WaitCondition.wait ( &Mutex );
+        }
+
+        if ( bNewStatus )
+        {
+            // the file is written without holding the mutex (the byte array
+            // is implicitly shared, the copy is cheap)
+            const QByteArray baStatus = baCurStatus;
+            bNewStatus                = false;
+
+            Mutex.unlock();
+            WriteFile ( baStatus );
+            Mutex.lock();
+        }
+    }
+
+    Mutex.unlock();
+}
+
+void CServerStatusWriter::WriteFile ( const QByteArray& baStatus )
+{
+    // the temporary file replaces the status file on commit
+    QSaveFile StatusFile ( strFileName );
+
+    if ( StatusFile.open ( QIODevice::WriteOnly | QIODevice::Text ) )
+    {
+        StatusFile.write ( baStatus );
+        StatusFile.commit();
+    }
+}
@@ -0,0 +1,72 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QString>
+#include "global.h"
+
+
+/* Classes ********************************************************************/
+// Writes the server status file in a background thread. A new status is only
+// written if its content has changed. The content is first written into a
+// temporary file which then replaces the status file, so that a reader never
+// sees a half-written file.
+class CServerStatusWriter : public QThread
+{
+public:
+    CServerStatusWriter() :
+        bIsJson    ( false ),
+        bRun       ( false ),
+        bNewStatus ( false ) {}
+
+    virtual ~CServerStatusWriter() { Stop(); }
+
+    // the JSON format is used if the file name has the extension ".json",
+    // otherwise the HTML format is used
+    void Start ( const QString& strNewFileName );
+    void Stop();
+
+    bool IsJson() const { return bIsJson; }
+
+    void Put ( const QByteArray& baNewStatus );
+
+protected:
+    virtual void run();
+    void WriteFile ( const QByteArray& baStatus );
+
+    QString        strFileName;
+    bool           bIsJson;
+
+    QMutex         Mutex;
+    QWaitCondition WaitCondition;
+    QByteArray     baCurStatus;
+    bool           bRun;
+    bool           bNewStatus;
+};
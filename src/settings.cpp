@@ -31,7 +31,7 @@ void CSettings::Load()
     int          iIdx;
     int          iValue;
     bool         bValue;
-    QDomDocument IniXMLDocument;
+    CIniDocument IniXMLDocument;
 
     // prepare file name for loading initialization data from XML file and read
     // data from file if possible
@@ -39,7 +39,7 @@ void CSettings::Load()
     if ( file.open ( QIODevice::ReadOnly ) )
     {
         QTextStream in ( &file );
-        IniXMLDocument.setContent ( in.readAll(), false );
+        IniXMLDocument.FromString ( in.readAll() );
 
         file.close();
     }
@@ -50,6 +50,9 @@ void CSettings::Load()
     {
         // client:
 
+        // the client is initialized once after all settings are applied
+        pClient->BeginInitBatch();
+
         // IP addresses
         for ( iIdx = 0; iIdx < MAX_NUM_SERVER_ADDR_ITEMS; iIdx++ )
         {
@@ -58,56 +61,69 @@ void CSettings::Load()
                                 QString ( "ipaddress%1" ).arg ( iIdx ), "" );
         }
 
-        // stored fader tags
-        for ( iIdx = 0; iIdx < MAX_NUM_STORED_FADER_SETTINGS; iIdx++ )
+        // stored fader settings (the first entry is the most recently stored
+        // one, therefore we store the entries in reverse order)
+        for ( iIdx = MAX_NUM_STORED_FADER_SETTINGS - 1; iIdx >= 0; iIdx-- )
         {
-            pClient->vecStoredFaderTags[iIdx] = FromBase64ToString (
+            CStoredFaderSettings::CEntry StoredEntry;
+
+            StoredEntry.strTag = FromBase64ToString (
                 GetIniSetting ( IniXMLDocument, "client",
                                 QString ( "storedfadertag%1_base64" ).arg ( iIdx ), "" ) );
-        }
 
-        // stored fader levels
-        for ( iIdx = 0; iIdx < MAX_NUM_STORED_FADER_SETTINGS; iIdx++ )
-        {
+            if ( StoredEntry.strTag.isEmpty() )
+            {
+                continue;
+            }
+
             if ( GetNumericIniSet ( IniXMLDocument, "client",
                                     QString ( "storedfaderlevel%1" ).arg ( iIdx ),
                                     0, AUD_MIX_FADER_MAX, iValue ) )
             {
-                pClient->vecStoredFaderLevels[iIdx] = iValue;
+                StoredEntry.iLevel = iValue;
             }
-        }
 
-        // stored pan values
-        for ( iIdx = 0; iIdx < MAX_NUM_STORED_FADER_SETTINGS; iIdx++ )
-        {
             if ( GetNumericIniSet ( IniXMLDocument, "client",
                                     QString ( "storedpanvalue%1" ).arg ( iIdx ),
                                     0, AUD_MIX_PAN_MAX, iValue ) )
             {
-                pClient->vecStoredPanValues[iIdx] = iValue;
+                StoredEntry.iPan = iValue;
             }
-        }
 
-        // stored fader solo state
-        for ( iIdx = 0; iIdx < MAX_NUM_STORED_FADER_SETTINGS; iIdx++ )
-        {
             if ( GetFlagIniSet ( IniXMLDocument, "client",
                                  QString ( "storedfaderissolo%1" ).arg ( iIdx ),
                                  bValue ) )
             {
-                pClient->vecStoredFaderIsSolo[iIdx] = bValue;
+                StoredEntry.bIsSolo = bValue;
             }
-        }
 
-        // stored fader muted state
-        for ( iIdx = 0; iIdx < MAX_NUM_STORED_FADER_SETTINGS; iIdx++ )
-        {
             if ( GetFlagIniSet ( IniXMLDocument, "client",
                                  QString ( "storedfaderismute%1" ).arg ( iIdx ),
                                  bValue ) )
             {
-                pClient->vecStoredFaderIsMute[iIdx] = bValue;
+                StoredEntry.bIsMute = bValue;
+            }
+
+            pClient->StoredFaderSettings.Store ( StoredEntry );
+        }
+
+        // last good jitter buffer delays of the recently used servers
+        {
+            QStringList slJitBufDelays;
+
+            for ( iIdx = 0; iIdx < MAX_NUM_STORED_JIT_BUF_DELAYS; iIdx++ )
+            {
+                const QString strEntry =
+                    GetIniSetting ( IniXMLDocument, "client",
+                                    QString ( "jitbufdelay%1" ).arg ( iIdx ), "" );
+
+                if ( !strEntry.isEmpty() )
+                {
+                    slJitBufDelays.append ( strEntry );
+                }
             }
+
+            pClient->StoredJitBufDelays.SetEntries ( slJitBufDelays );
         }
 
         // new client level
@@ -267,6 +283,60 @@ void CSettings::Load()
             pClient->SetEnableOPUS64 ( bValue );
         }
 
+        // time stretching of the playout
+        if ( GetFlagIniSet ( IniXMLDocument, "client", "timestretch", bValue ) )
+        {
+            pClient->SetEnableTimeStretch ( bValue );
+        }
+
+        // redundant copy of the previous packet
+        if ( GetFlagIniSet ( IniXMLDocument, "client", "redundancy", bValue ) )
+        {
+            pClient->SetEnableRedundancy ( bValue );
+        }
+
+        // sequence numbers in the audio packets
+        if ( GetFlagIniSet ( IniXMLDocument, "client", "seqnum", bValue ) )
+        {
+            pClient->SetEnableSeqNum ( bValue );
+        }
+
+        // direct monitoring of our own signal
+        if ( GetFlagIniSet ( IniXMLDocument, "client", "directmonitor", bValue ) )
+        {
+            pClient->SetEnableDirectMonitor ( bValue );
+        }
+
+        // adaptive encoder settings
+        if ( GetFlagIniSet ( IniXMLDocument, "client", "adaptiveencoder", bValue ) )
+        {
+            pClient->SetEnableAdaptiveEncoder ( bValue );
+        }
+
+        // adaptive network packet size
+        if ( GetFlagIniSet ( IniXMLDocument, "client", "adaptiveaggregation", bValue ) )
+        {
+            pClient->SetEnableAdaptiveAggregation ( bValue );
+        }
+
+        // adaptive audio quality
+        if ( GetFlagIniSet ( IniXMLDocument, "client", "adaptivequality", bValue ) )
+        {
+            pClient->SetEnableAdaptiveQuality ( bValue );
+        }
+
+        // separate streams for the sound card inputs
+        if ( GetFlagIniSet ( IniXMLDocument, "client", "multistream", bValue ) )
+        {
+            pClient->SetEnableMultiStream ( bValue );
+        }
+
+        // local mixing of the forwarded frames of the other clients
+        if ( GetFlagIniSet ( IniXMLDocument, "client", "multitrack", bValue ) )
+        {
+            pClient->SetEnableMultitrack ( bValue );
+        }
+
         // GUI design
         if ( GetNumericIniSet ( IniXMLDocument, "client", "guidesign",
              0, 2 /* GD_SLIMFADER */, iValue ) )
@@ -363,6 +433,8 @@ if ( GetFlagIniSet ( IniXMLDocument, "client", "defcentservaddr", bValue ) )
         {
             pClient->bWindowWasShownConnect = bValue;
         }
+
+        pClient->EndInitBatch();
     }
     else
     {
@@ -439,7 +511,7 @@ void CSettings::Save()
     int iIdx;
 
     // create XML document for storing initialization parameters
-    QDomDocument IniXMLDocument;
+    CIniDocument IniXMLDocument;
 
 
     // Actual settings data ---------------------------------------------------
@@ -455,44 +527,42 @@ void CSettings::Save()
                             pClient->vstrIPAddress[iIdx] );
         }
 
-        // stored fader tags
-        for ( iIdx = 0; iIdx < MAX_NUM_STORED_FADER_SETTINGS; iIdx++ )
+        // stored fader settings (only the used entries are written, a missing
+        // entry is read as an empty entry)
+        const QVector<CStoredFaderSettings::CEntry> vecStoredFaderEntries =
+            pClient->StoredFaderSettings.GetEntries();
+
+        for ( iIdx = 0; iIdx < vecStoredFaderEntries.size(); iIdx++ )
         {
             PutIniSetting ( IniXMLDocument, "client",
                             QString ( "storedfadertag%1_base64" ).arg ( iIdx ),
-                            ToBase64 ( pClient->vecStoredFaderTags[iIdx] ) );
-        }
+                            ToBase64 ( vecStoredFaderEntries[iIdx].strTag ) );
 
-        // stored fader levels
-        for ( iIdx = 0; iIdx < MAX_NUM_STORED_FADER_SETTINGS; iIdx++ )
-        {
             SetNumericIniSet ( IniXMLDocument, "client",
                                QString ( "storedfaderlevel%1" ).arg ( iIdx ),
-                               pClient->vecStoredFaderLevels[iIdx] );
-        }
+                               vecStoredFaderEntries[iIdx].iLevel );
 
-        // stored pan values
-        for ( iIdx = 0; iIdx < MAX_NUM_STORED_FADER_SETTINGS; iIdx++ )
-        {
             SetNumericIniSet ( IniXMLDocument, "client",
                                QString ( "storedpanvalue%1" ).arg ( iIdx ),
-                               pClient->vecStoredPanValues[iIdx] );
-        }
+                               vecStoredFaderEntries[iIdx].iPan );
 
-        // stored fader solo states
-        for ( iIdx = 0; iIdx < MAX_NUM_STORED_FADER_SETTINGS; iIdx++ )
-        {
             SetFlagIniSet ( IniXMLDocument, "client",
                             QString ( "storedfaderissolo%1" ).arg ( iIdx ),
-                            pClient->vecStoredFaderIsSolo[iIdx] != 0 );
-        }
+                            vecStoredFaderEntries[iIdx].bIsSolo );
 
-        // stored fader muted states
-        for ( iIdx = 0; iIdx < MAX_NUM_STORED_FADER_SETTINGS; iIdx++ )
-        {
             SetFlagIniSet ( IniXMLDocument, "client",
                             QString ( "storedfaderismute%1" ).arg ( iIdx ),
-                            pClient->vecStoredFaderIsMute[iIdx] != 0 );
+                            vecStoredFaderEntries[iIdx].bIsMute );
+        }
+
+        // last good jitter buffer delays of the recently used servers
+        const QStringList slJitBufDelays = pClient->StoredJitBufDelays.GetEntries();
+
+        for ( iIdx = 0; iIdx < slJitBufDelays.size(); iIdx++ )
+        {
+            PutIniSetting ( IniXMLDocument, "client",
+                            QString ( "jitbufdelay%1" ).arg ( iIdx ),
+                            slJitBufDelays[iIdx] );
         }
 
         // new client level
@@ -575,6 +645,42 @@ void CSettings::Save()
         SetFlagIniSet ( IniXMLDocument, "client", "enableopussmall",
             pClient->GetEnableOPUS64() );
 
+        // time stretching of the playout
+        SetFlagIniSet ( IniXMLDocument, "client", "timestretch",
+            pClient->GetEnableTimeStretch() );
+
+        // redundant copy of the previous packet
+        SetFlagIniSet ( IniXMLDocument, "client", "redundancy",
+            pClient->GetEnableRedundancy() );
+
+        // sequence numbers in the audio packets
+        SetFlagIniSet ( IniXMLDocument, "client", "seqnum",
+            pClient->GetEnableSeqNum() );
+
+        // direct monitoring of our own signal
+        SetFlagIniSet ( IniXMLDocument, "client", "directmonitor",
+            pClient->GetEnableDirectMonitor() );
+
+        // adaptive encoder settings
+        SetFlagIniSet ( IniXMLDocument, "client", "adaptiveencoder",
+            pClient->GetEnableAdaptiveEncoder() );
+
+        // adaptive network packet size
+        SetFlagIniSet ( IniXMLDocument, "client", "adaptiveaggregation",
+            pClient->GetEnableAdaptiveAggregation() );
+
+        // adaptive audio quality
+        SetFlagIniSet ( IniXMLDocument, "client", "adaptivequality",
+            pClient->GetEnableAdaptiveQuality() );
+
+        // separate streams for the sound card inputs
+        SetFlagIniSet ( IniXMLDocument, "client", "multistream",
+            pClient->GetEnableMultiStream() );
+
+        // local mixing of the forwarded frames of the other clients
+        SetFlagIniSet ( IniXMLDocument, "client", "multitrack",
+            pClient->GetEnableMultitrack() );
+
         // GUI design
         SetNumericIniSet ( IniXMLDocument, "client", "guidesign",
             static_cast<int> ( pClient->GetGUIDesign() ) );
@@ -682,7 +788,7 @@ void CSettings::Save()
     if ( file.open ( QIODevice::WriteOnly ) )
     {
         QTextStream out ( &file );
-        out << IniXMLDocument.toString();
+        out << IniXMLDocument.ToString();
 
         file.close();
     }
@@ -724,7 +830,7 @@ void CSettings::SetFileName ( const QString& sNFiName )
     }
 }
 
-void CSettings::SetNumericIniSet ( QDomDocument&  xmlFile,
+void CSettings::SetNumericIniSet ( CIniDocument&  xmlFile,
                                    const QString& strSection,
                                    const QString& strKey,
                                    const int      iValue )
@@ -733,7 +839,7 @@ void CSettings::SetNumericIniSet ( QDomDocument&  xmlFile,
     PutIniSetting ( xmlFile, strSection, strKey, QString("%1").arg(iValue) );
 }
 
-bool CSettings::GetNumericIniSet ( const QDomDocument& xmlFile,
+bool CSettings::GetNumericIniSet ( const CIniDocument& xmlFile,
                                    const QString&      strSection,
                                    const QString&      strKey,
                                    const int           iRangeStart,
@@ -761,7 +867,7 @@ bool CSettings::GetNumericIniSet ( const QDomDocument& xmlFile,
     return bReturn;
 }
 
-void CSettings::SetFlagIniSet ( QDomDocument&  xmlFile,
+void CSettings::SetFlagIniSet ( CIniDocument&  xmlFile,
                                 const QString& strSection,
                                 const QString& strKey,
                                 const bool     bValue )
@@ -777,7 +883,7 @@ void CSettings::SetFlagIniSet ( QDomDocument&  xmlFile,
     }
 }
 
-bool CSettings::GetFlagIniSet ( const QDomDocument& xmlFile,
+bool CSettings::GetFlagIniSet ( const CIniDocument& xmlFile,
                                 const QString&      strSection,
                                 const QString&      strKey,
                                 bool&               bValue )
@@ -806,7 +912,7 @@ bool CSettings::GetFlagIniSet ( const QDomDocument& xmlFile,
 
 
 // Init-file routines using XML ***********************************************
-QString CSettings::GetIniSetting ( const QDomDocument& xmlFile,
+QString CSettings::GetIniSetting ( const CIniDocument& xmlFile,
                                    const QString&      sSection,
                                    const QString&      sKey,
                                    const QString&      sDefaultVal )
@@ -814,45 +920,127 @@ QString CSettings::GetIniSetting ( const QDomDocument& xmlFile,
     // init return parameter with default value
     QString sResult ( sDefaultVal );
 
-    // get section
-    QDomElement xmlSection = xmlFile.firstChildElement ( sSection );
-    if ( !xmlSection.isNull() )
-    {
-        // get key
-        QDomElement xmlKey = xmlSection.firstChildElement ( sKey );
-        if ( !xmlKey.isNull() )
-        {
-            // get value
-            sResult = xmlKey.text();
-        }
-    }
+    xmlFile.GetValue ( sSection, sKey, sResult );
 
     return sResult;
 }
 
-void CSettings::PutIniSetting ( QDomDocument&  xmlFile,
+void CSettings::PutIniSetting ( CIniDocument&  xmlFile,
                                 const QString& sSection,
                                 const QString& sKey,
                                 const QString& sValue )
+{
+    xmlFile.SetValue ( sSection, sKey, sValue );
+}
+
+void CIniDocument::FromString ( const QString& strXML )
+{
+    QXmlStreamReader xmlReader ( strXML );
+
+    vecSections.clear();
+
+    // each top level element is a section, each of its child elements is a
+    // key (on a parse error, the values which were read so far are kept)
+    while ( xmlReader.readNextStartElement() )
+    {
+        const QString strSection = xmlReader.name().toString();
+
+        while ( xmlReader.readNextStartElement() )
+        {
+            const QString strKey = xmlReader.name().toString();
+
+            SetValue ( strSection, strKey,
+                       xmlReader.readElementText ( QXmlStreamReader::IncludeChildElements ) );
+        }
+    }
+}
+
+QString CIniDocument::ToString() const
+{
+    QString          strXML;
+    QXmlStreamWriter xmlWriter ( &strXML );
+
+    // same layout as the former DOM based init-file
+    xmlWriter.setAutoFormatting ( true );
+    xmlWriter.setAutoFormattingIndent ( 1 );
+
+    for ( int iSec = 0; iSec < vecSections.size(); iSec++ )
+    {
+        xmlWriter.writeStartElement ( vecSections[iSec].strName );
+
+        for ( int iKey = 0; iKey < vecSections[iSec].vecKeyValues.size(); iKey++ )
+        {
+            xmlWriter.writeTextElement ( vecSections[iSec].vecKeyValues[iKey].first,
+                                         vecSections[iSec].vecKeyValues[iKey].second );
+        }
+
+        xmlWriter.writeEndElement();
+    }
+
+    return strXML;
+}
+
+bool CIniDocument::GetValue ( const QString& strSection,
+                              const QString& strKey,
+                              QString&       strValue ) const
+{
+    const int iSec = FindSection ( strSection );
+
+    if ( iSec >= 0 )
+    {
+        const CSection&                     Section = vecSections[iSec];
+        QHash<QString, int>::const_iterator it      = Section.KeyIndex.constFind ( strKey );
+
+        if ( it != Section.KeyIndex.constEnd() )
+        {
+            strValue = Section.vecKeyValues[it.value()].second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void CIniDocument::SetValue ( const QString& strSection,
+                              const QString& strKey,
+                              const QString& strValue )
 {
     // check if section is already there, if not then create it
-    QDomElement xmlSection = xmlFile.firstChildElement ( sSection );
-    if ( xmlSection.isNull() )
+    int iSec = FindSection ( strSection );
+
+    if ( iSec < 0 )
     {
-        // create new root element and add to document
-        xmlSection = xmlFile.createElement ( sSection );
-        xmlFile.appendChild ( xmlSection );
+        iSec = vecSections.size();
+        vecSections.append ( CSection() );
+        vecSections[iSec].strName = strSection;
     }
 
+    CSection& Section = vecSections[iSec];
+
     // check if key is already there, if not then create it
-    QDomElement xmlKey = xmlSection.firstChildElement ( sKey );
-    if ( xmlKey.isNull() )
+    QHash<QString, int>::const_iterator it = Section.KeyIndex.constFind ( strKey );
+
+    if ( it != Section.KeyIndex.constEnd() )
+    {
+        Section.vecKeyValues[it.value()].second = strValue;
+    }
+    else
     {
-        xmlKey = xmlFile.createElement ( sKey );
-        xmlSection.appendChild ( xmlKey );
+        Section.KeyIndex.insert ( strKey, Section.vecKeyValues.size() );
+        Section.vecKeyValues.append ( qMakePair ( strKey, strValue ) );
+    }
+}
+
+int CIniDocument::FindSection ( const QString& strSection ) const
+{
+    // there are only very few sections (usually only one)
+    for ( int iSec = 0; iSec < vecSections.size(); iSec++ )
+    {
+        if ( vecSections[iSec].strName == strSection )
+        {
+            return iSec;
+        }
     }
 
-    // add actual data to the key
-    QDomText currentValue = xmlFile.createTextNode ( sValue );
-    xmlKey.appendChild ( currentValue );
+    return -1;
 }
@@ -24,7 +24,11 @@
 
 #pragma once
 
-#include <QDomDocument>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QVector>
+#include <QHash>
+#include <QPair>
 #include <QFile>
 #include <QSettings>
 #include <QDir>
@@ -36,6 +40,39 @@
 
 
 /* Classes ********************************************************************/
+// In-memory representation of the XML init-file. The file is parsed and written
+// in one pass with the Qt XML stream classes and the keys are accessed by a hash
+// (a DOM tree needs a linear search for each of the thousands of keys of the
+// client settings). The file format is unchanged: one element per section which
+// contains one element per key.
+class CIniDocument
+{
+public:
+    void FromString ( const QString& strXML );
+    QString ToString() const;
+
+    bool GetValue ( const QString& strSection,
+                    const QString& strKey,
+                    QString&       strValue ) const;
+
+    void SetValue ( const QString& strSection,
+                    const QString& strKey,
+                    const QString& strValue );
+
+protected:
+    class CSection
+    {
+    public:
+        QString                           strName;
+        QVector<QPair<QString, QString> > vecKeyValues; // in file order
+        QHash<QString, int>               KeyIndex;
+    };
+
+    int FindSection ( const QString& strSection ) const;
+
+    QVector<CSection> vecSections;
+};
+
 class CSettings
 {
 public:
@@ -50,6 +87,8 @@ public:
     void Load();
     void Save();
 
+    QString GetFileName() const { return strFileName; }
+
 protected:
     void SetFileName ( const QString& sNFiName );
 
@@ -72,35 +111,35 @@ protected:
         { return QString::fromUtf8 ( FromBase64ToByteArray ( strIn ) ); }
 
     // init file access function for read/write
-    void SetNumericIniSet ( QDomDocument&  xmlFile,
+    void SetNumericIniSet ( CIniDocument&  xmlFile,
                             const QString& strSection,
                             const QString& strKey,
                             const int      iValue = 0 );
 
-    bool GetNumericIniSet ( const QDomDocument& xmlFile,
+    bool GetNumericIniSet ( const CIniDocument& xmlFile,
                             const QString&      strSection,
                             const QString&      strKey,
                             const int           iRangeStart,
                             const int           iRangeStop,
                             int&                iValue );
 
-    void SetFlagIniSet ( QDomDocument&  xmlFile,
+    void SetFlagIniSet ( CIniDocument&  xmlFile,
                          const QString& strSection,
                          const QString& strKey,
                          const bool     bValue = false );
 
-    bool GetFlagIniSet ( const QDomDocument& xmlFile,
+    bool GetFlagIniSet ( const CIniDocument& xmlFile,
                          const QString&      strSection,
                          const QString&      strKey,
                          bool&               bValue );
 
     // actual working function for init-file access
-    QString GetIniSetting( const QDomDocument& xmlFile,
+    QString GetIniSetting( const CIniDocument& xmlFile,
                            const QString&      sSection,
                            const QString&      sKey,
                            const QString&      sDefaultVal = "" );
 
-    void PutIniSetting ( QDomDocument&  xmlFile,
+    void PutIniSetting ( CIniDocument&  xmlFile,
                          const QString& sSection,
                          const QString& sKey,
                          const QString& sValue = "" );
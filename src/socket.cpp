@@ -24,6 +24,8 @@
 
 #include "socket.h"
 #include "server.h"
+#include "packetcapture.h"
+#include "relay.h"
 
 
 /* Implementation *************************************************************/
@@ -38,16 +40,102 @@ void CSocket::Init ( const quint16 iPortNumber )
     WSAStartup ( MAKEWORD(1, 0), &wsa );
 #endif
 
-    // create the UDP socket
-    UdpSocket = socket ( AF_INET, SOCK_DGRAM, 0 );
+    // create the UDP socket, if possible a dual-stack IPv6 socket which also
+    // sends and receives IPv4 packets (with IPv4-mapped addresses)
+    const bool bDualStack = IsDualStack();
 
-    // allocate memory for network receive and send buffer in samples
-    vecbyRecBuf.Init ( MAX_SIZE_BYTES_NETW_BUF );
+    if ( bDualStack )
+    {
+        const int iV6Only = 0;
+
+        UdpSocket = socket ( AF_INET6, SOCK_DGRAM, 0 );
+
+        setsockopt ( UdpSocket, IPPROTO_IPV6, IPV6_V6ONLY, (const char*) &iV6Only, sizeof ( iV6Only ) );
+    }
+    else
+    {
+        UdpSocket = socket ( AF_INET, SOCK_DGRAM, 0 );
+    }
+
+    // mark the packets for the QoS of the network (the audio packets use the
+    // TOS of the socket, the protocol messages set their own TOS), for the
+    // IPv6 packets the traffic class has the same meaning
+#ifdef IP_TOS
+    const int iTos = SOCKET_TOS_AUDIO;
+
+    setsockopt ( UdpSocket, IPPROTO_IP, IP_TOS, (const char*) &iTos, sizeof ( iTos ) );
+
+# ifdef IPV6_TCLASS
+    if ( bDualStack )
+    {
+        setsockopt ( UdpSocket, IPPROTO_IPV6, IPV6_TCLASS, (const char*) &iTos, sizeof ( iTos ) );
+    }
+# endif
+#endif
+
+#ifdef SO_PRIORITY
+    const int iPriority = SOCKET_PRIORITY;
+
+    setsockopt ( UdpSocket, SOL_SOCKET, SO_PRIORITY, &iPriority, sizeof ( iPriority ) );
+#endif
+
+    pCapture         = nullptr;
+    pRelayRoutes     = nullptr;
+    bInRelayFrame    = false;
+    bSendEnabled     = true;
+    bMulticastJoined = false;
+    iPacingWindowNs  = 0;
+
+    // allocate the protocol message queue (the message bodies get the maximum
+    // size so that parsing a message never allocates memory)
+    vecvecbyProtMessBody.Init  ( NUM_SOCKET_PROT_MESS_SLOTS );
+    vecProtMessRecCounter.Init ( NUM_SOCKET_PROT_MESS_SLOTS );
+    vecProtMessRecID.Init      ( NUM_SOCKET_PROT_MESS_SLOTS );
+    vecProtMessHostAddr.Init   ( NUM_SOCKET_PROT_MESS_SLOTS );
+    vecbyProtMessDropBody.Init ( MAX_SIZE_BYTES_NETW_BUF );
+
+    for ( int i = 0; i < NUM_SOCKET_PROT_MESS_SLOTS; i++ )
+    {
+        vecvecbyProtMessBody[i].Init ( MAX_SIZE_BYTES_NETW_BUF );
+    }
+
+    iProtMessPutPos.storeRelease        ( 0 );
+    iProtMessGetPos.storeRelease        ( 0 );
+    iProtMessNotifyPending.storeRelease ( 0 );
+
+    // allocate the send queue for the server
+    if ( !bIsClient )
+    {
+        vecvecbySendQueueBuf.Init ( NUM_SOCKET_SEND_QUEUE_SLOTS );
+        vecSendQueueLen.Init      ( NUM_SOCKET_SEND_QUEUE_SLOTS );
+        vecSendQueueAddr.Init     ( NUM_SOCKET_SEND_QUEUE_SLOTS );
+
+        for ( int i = 0; i < NUM_SOCKET_SEND_QUEUE_SLOTS; i++ )
+        {
+            vecvecbySendQueueBuf[i].Init ( MAX_SIZE_BYTES_SEND_QUEUE_SLOT );
+        }
+
+        vecbyRelayPacketBuf.Init ( MAX_SIZE_BYTES_NETW_BUF );
+    }
 
     // preinitialize socket in address (only the port number is missing)
-    sockaddr_in UdpSocketInAddr;
-    UdpSocketInAddr.sin_family      = AF_INET;
-    UdpSocketInAddr.sin_addr.s_addr = INADDR_ANY;
+    USockAddr UdpSocketInAddr;
+    memset ( &UdpSocketInAddr, 0, sizeof ( UdpSocketInAddr ) );
+
+    if ( bDualStack )
+    {
+        UdpSocketInAddr.In6.sin6_family = AF_INET6;
+        UdpSocketInAddr.In6.sin6_addr   = in6addr_any;
+    }
+    else
+    {
+        UdpSocketInAddr.In4.sin_family      = AF_INET;
+        UdpSocketInAddr.In4.sin_addr.s_addr = INADDR_ANY;
+    }
+
+    // port number of the address (in network byte order)
+    uint16_t& iSockAddrPort = bDualStack ? UdpSocketInAddr.In6.sin6_port
+                                         : UdpSocketInAddr.In4.sin_port;
 
     // initialize the listening socket
     bool bSuccess;
@@ -57,11 +145,11 @@ void CSocket::Init ( const quint16 iPortNumber )
         if ( iPortNumber == 0 )
         {
             // if port number is 0, bind the client to a random available port
-            UdpSocketInAddr.sin_port = htons ( 0 );
+            iSockAddrPort = htons ( 0 );
 
             bSuccess = ( ::bind ( UdpSocket ,
-                                (sockaddr*) &UdpSocketInAddr,
-                                sizeof ( sockaddr_in ) ) == 0 );
+                                &UdpSocketInAddr.Addr,
+                                GetSockAddrLen ( UdpSocketInAddr ) ) == 0 );
         }
         else
         {
@@ -72,11 +160,11 @@ void CSocket::Init ( const quint16 iPortNumber )
 
             while ( !bSuccess && ( iClientPortIncrement <= NUM_SOCKET_PORTS_TO_TRY ) )
             {
-                UdpSocketInAddr.sin_port = htons ( iPortNumber + iClientPortIncrement );
+                iSockAddrPort = htons ( iPortNumber + iClientPortIncrement );
 
                 bSuccess = ( ::bind ( UdpSocket ,
-                                    (sockaddr*) &UdpSocketInAddr,
-                                    sizeof ( sockaddr_in ) ) == 0 );
+                                    &UdpSocketInAddr.Addr,
+                                    GetSockAddrLen ( UdpSocketInAddr ) ) == 0 );
 
                 iClientPortIncrement++;
             }
@@ -87,11 +175,23 @@ void CSocket::Init ( const quint16 iPortNumber )
         // for the server, only try the given port number and do not try out
         // other port numbers to bind since it is important that the server
         // gets the desired port number
-        UdpSocketInAddr.sin_port = htons ( iPortNumber );
+        iSockAddrPort = htons ( iPortNumber );
+
+#ifdef USE_SO_REUSEPORT_SHARDS
+        // multiple receive sockets of this server share the same port (this is
+        // only enabled if requested since otherwise a second server instance
+        // could bind to the same port without an error)
+        if ( bReusePort )
+        {
+            const int iReusePort = 1;
+
+            setsockopt ( UdpSocket, SOL_SOCKET, SO_REUSEPORT, &iReusePort, sizeof ( iReusePort ) );
+        }
+#endif
 
         bSuccess = ( ::bind ( UdpSocket ,
-                              (sockaddr*) &UdpSocketInAddr,
-                              sizeof ( sockaddr_in ) ) == 0 );
+                              &UdpSocketInAddr.Addr,
+                              GetSockAddrLen ( UdpSocketInAddr ) ) == 0 );
     }
 
     if ( !bSuccess )
@@ -101,6 +201,26 @@ void CSocket::Init ( const quint16 iPortNumber )
             "the software is already running).", "Network Error" );
     }
 
+    // the packet I/O on the bound socket is done by the selected transport
+    pTransport.reset ( CSocketTransport::Create ( UdpSocket ) );
+
+    // the arrival times of the packets for the jitter statistics are taken
+    // from the kernel if possible (otherwise at the processing of the packet)
+    pTransport->EnableRecvTimestamps();
+    iRecDelayNs = 0;
+
+    // the connected channel sockets are an optional feature of the transport
+    if ( bConnectedSockets )
+    {
+        bConnectedSockets = pTransport->EnableChannelSockets ( iPortNumber );
+
+        vecbConnSockOpen.Init    ( MAX_NUM_CHANNELS, false );
+        vecConnSockHostAddr.Init ( MAX_NUM_CHANNELS );
+        ConnSockCleanupTimer.start();
+    }
+
+    ServerFullClock.start();
+
 
     // Connections -------------------------------------------------------------
     // it is important to do the following connections in this class since we
@@ -155,6 +275,9 @@ void CSocket::Close()
 
 CSocket::~CSocket()
 {
+    // the transport is deleted before the socket is closed
+    pTransport.reset();
+
     // cleanup the socket (on Windows the WSA cleanup must also be called)
 #ifdef _WIN32
     closesocket ( UdpSocket );
@@ -164,49 +287,369 @@ CSocket::~CSocket()
 #endif
 }
 
+bool CSocket::IsDualStack()
+{
+    static const bool bDualStack = CheckDualStack();
+
+    return bDualStack;
+}
+
+bool CSocket::CheckDualStack()
+{
+    // IPv6 may not be available (e.g., disabled in the kernel) or the IPv4
+    // traffic may not be allowed on an IPv6 socket, this is checked with a
+    // test socket (on Windows this may be called before any socket is
+    // created, therefore the WSA is started here, too)
+#ifdef _WIN32
+    WSADATA wsa;
+    WSAStartup ( MAKEWORD(1, 0), &wsa );
+#endif
+
+    bool          bDualStack = false;
+    const int     iV6Only    = 0;
+    TSocketHandle TestSocket = socket ( AF_INET6, SOCK_DGRAM, 0 );
+
+#ifdef _WIN32
+    if ( TestSocket != INVALID_SOCKET )
+#else
+    if ( TestSocket >= 0 )
+#endif
+    {
+        bDualStack = ( setsockopt ( TestSocket, IPPROTO_IPV6, IPV6_V6ONLY, (const char*) &iV6Only, sizeof ( iV6Only ) ) == 0 );
+
+#ifdef _WIN32
+        closesocket ( TestSocket );
+#else
+        close ( TestSocket );
+#endif
+    }
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+
+    return bDualStack;
+}
+
+void CSocket::HostAddrToSockAddr ( const CHostAddress& HostAddr,
+                                   USockAddr&          SockAddr )
+{
+    memset ( &SockAddr, 0, sizeof ( SockAddr ) );
+
+    if ( HostAddr.IsIPv4() && !IsDualStack() )
+    {
+        SockAddr.In4.sin_family      = AF_INET;
+        SockAddr.In4.sin_port        = htons ( HostAddr.iPort );
+        SockAddr.In4.sin_addr.s_addr = htonl ( HostAddr.GetIPv4Addr() );
+    }
+    else
+    {
+        // the IPv4 addresses are already stored IPv4-mapped (note that an IPv6
+        // address cannot be used on an IPv4 socket, the send fails then)
+        SockAddr.In6.sin6_family = AF_INET6;
+        SockAddr.In6.sin6_port   = htons ( HostAddr.iPort );
+        memcpy ( &SockAddr.In6.sin6_addr, HostAddr.Addr, sizeof ( HostAddr.Addr ) );
+    }
+}
+
+CHostAddress CSocket::SockAddrToHostAddr ( const USockAddr& SockAddr )
+{
+    if ( SockAddr.Addr.sa_family == AF_INET6 )
+    {
+        CHostAddress HostAddr;
+
+        memcpy ( HostAddr.Addr, &SockAddr.In6.sin6_addr, sizeof ( HostAddr.Addr ) );
+        HostAddr.iPort = ntohs ( SockAddr.In6.sin6_port );
+
+        return HostAddr;
+    }
+
+    return CHostAddress ( ntohl ( SockAddr.In4.sin_addr.s_addr ),
+                          ntohs ( SockAddr.In4.sin_port ) );
+}
+
 void CSocket::SendPacket ( const CVector<uint8_t>& vecbySendBuf,
                            const CHostAddress&     HostAddr )
 {
-    QMutexLocker locker ( &Mutex );
+    const int iVecSizeOut = vecbySendBuf.Size();
+
+    if ( iVecSizeOut > 0 )
+    {
+        USockAddr UdpSocketOutAddr;
+
+        HostAddrToSockAddr ( HostAddr, UdpSocketOutAddr );
+
+        SendPacket ( &vecbySendBuf[0], iVecSizeOut, UdpSocketOutAddr );
+    }
+}
 
+void CSocket::SendProtPacket ( const CVector<uint8_t>& vecbySendBuf,
+                               const CHostAddress&     HostAddr )
+{
     const int iVecSizeOut = vecbySendBuf.Size();
 
     if ( iVecSizeOut > 0 )
     {
-        // send packet through network (we have to convert the constant unsigned
-        // char vector in "const char*", for this we first convert the const
-        // uint8_t vector in a read/write uint8_t vector and then do the cast to
-        // const char*)
-        sockaddr_in UdpSocketOutAddr;
+        USockAddr UdpSocketOutAddr;
 
-        UdpSocketOutAddr.sin_family      = AF_INET;
-        UdpSocketOutAddr.sin_port        = htons ( HostAddr.iPort );
-        UdpSocketOutAddr.sin_addr.s_addr = htonl ( HostAddr.InetAddr.toIPv4Address() );
+        HostAddrToSockAddr ( HostAddr, UdpSocketOutAddr );
 
-        sendto ( UdpSocket,
-                 (const char*) &( (CVector<uint8_t>) vecbySendBuf )[0],
-                 iVecSizeOut,
-                 0,
-                 (sockaddr*) &UdpSocketOutAddr,
-                 sizeof ( sockaddr_in ) );
+        SendProtPacket ( &vecbySendBuf[0], iVecSizeOut, UdpSocketOutAddr );
     }
 }
 
-bool CSocket::GetAndResetbJitterBufferOKFlag()
+void CSocket::SendProtPacket ( const uint8_t*     pbySendBuf,
+                               const int          iNumBytes,
+                               const USockAddr&   SockAddr )
 {
-    // check jitter buffer status
-    if ( !bJitterBufferOK )
+    if ( ( iNumBytes > 0 ) && bSendEnabled &&
+         !SendRelayed ( pbySendBuf, iNumBytes, SockAddr, true ) )
+    {
+        pTransport->SendWithTos ( pbySendBuf, iNumBytes, SockAddr, SOCKET_TOS_PROTOCOL );
+    }
+}
+
+void CSocket::SetBufferSizes ( const int iNumChannels )
+{
+    const int iSize = std::max ( SOCKET_MIN_BUF_SIZE, iNumChannels * SOCKET_BUF_SIZE_PER_CHANNEL );
+
+    SetBufferSize ( SO_RCVBUF, iSize, "receive" );
+    SetBufferSize ( SO_SNDBUF, iSize, "send" );
+}
+
+void CSocket::SetBufferSize ( const int      iOption,
+                              const int      iSize,
+                              const QString& strName )
+{
+    setsockopt ( UdpSocket, SOL_SOCKET, iOption, (const char*) &iSize, sizeof ( iSize ) );
+
+    // check the size which is actually used (note that Linux reports the
+    // doubled size which includes the kernel overhead)
+    int iActSize = 0;
+#ifdef _WIN32
+    int iLen = sizeof ( iActSize );
+#else
+    socklen_t iLen = sizeof ( iActSize );
+#endif
+
+    if ( getsockopt ( UdpSocket, SOL_SOCKET, iOption, (char*) &iActSize, &iLen ) == 0 )
+    {
+#ifdef __linux__
+        iActSize /= 2;
+#endif
+
+        if ( iActSize < iSize )
+        {
+            qWarning() << qUtf8Printable ( QString ( "The socket %1 buffer is limited to %2 bytes by the system "
+                                                     "(%3 bytes requested, see net.core.%4mem_max on Linux)" ).
+                                           arg ( strName ).arg ( iActSize ).arg ( iSize ).
+                                           arg ( iOption == SO_RCVBUF ? "r" : "w" ) );
+        }
+    }
+}
+
+void CSocket::SendPacket ( const uint8_t*     pbySendBuf,
+                           const int          iNumBytes,
+                           const USockAddr&   SockAddr )
+{
+    // the transport send is thread safe, therefore no mutex is required here
+    if ( ( iNumBytes > 0 ) && bSendEnabled &&
+         !SendRelayed ( pbySendBuf, iNumBytes, SockAddr, false ) )
+    {
+        pTransport->Send ( pbySendBuf, iNumBytes, SockAddr );
+    }
+}
+
+bool CSocket::SendRelayed ( const uint8_t*     pbySendBuf,
+                            const int          iNumBytes,
+                            const USockAddr&   SockAddr,
+                            const bool         bIsProtMess )
+{
+    if ( ( pRelayRoutes == nullptr ) || !pRelayRoutes->HasRoutes() )
+    {
+        return false;
+    }
+
+    const CHostAddress ClientAddr = SockAddrToHostAddr ( SockAddr );
+    USockAddr          RelayAddr;
+    const int          iRelayIdx  = pRelayRoutes->GetRoute ( ClientAddr, RelayAddr );
+
+    if ( iRelayIdx == INVALID_INDEX )
+    {
+        return false;
+    }
+
+    // these are the protocol messages and the packets which do not fit in the
+    // send queue, i.e. the frame of the single packet is allocated here
+    CRelayFrame Frame;
+
+    Frame.Init ( iNumBytes );
+    Frame.Start ( pRelayRoutes->GetNextSequenceNumber ( iRelayIdx ) );
+    Frame.AddPacket ( pbySendBuf, iNumBytes, ClientAddr );
+
+    if ( bIsProtMess )
+    {
+        pTransport->SendWithTos ( Frame.GetData(), Frame.GetSize(), RelayAddr, SOCKET_TOS_PROTOCOL );
+    }
+    else
+    {
+        pTransport->Send ( Frame.GetData(), Frame.GetSize(), RelayAddr );
+    }
+
+    return true;
+}
+
+void CSocket::QueuePacket ( const uint8_t*     pbySendBuf,
+                            const int          iNumBytes,
+                            const USockAddr&   SockAddr )
+{
+    if ( iNumBytes <= 0 )
+    {
+        return;
+    }
+
+    // get a free slot (the slots are reserved lock-free)
+    const int iSlot = iSendQueueNumPackets.fetchAndAddOrdered ( 1 );
+
+    if ( ( iSlot >= vecvecbySendQueueBuf.Size() ) ||
+         ( iNumBytes > MAX_SIZE_BYTES_SEND_QUEUE_SLOT ) )
+    {
+        // the queue is full or the packet does not fit in a slot (or the
+        // queue is not available), send the packet directly
+        if ( iSlot < vecvecbySendQueueBuf.Size() )
+        {
+            // mark the reserved slot as unused
+            vecSendQueueLen[iSlot] = 0;
+        }
+
+        SendPacket ( pbySendBuf, iNumBytes, SockAddr );
+        return;
+    }
+
+    std::copy ( pbySendBuf, pbySendBuf + iNumBytes, vecvecbySendQueueBuf[iSlot].begin() );
+    vecSendQueueLen[iSlot]  = iNumBytes;
+    vecSendQueueAddr[iSlot] = SockAddr;
+}
+
+void CSocket::FlushSendQueue()
+{
+    const int iNumPackets = std::min ( static_cast<int> ( iSendQueueNumPackets.fetchAndStoreOrdered ( 0 ) ),
+                                       vecvecbySendQueueBuf.Size() );
+
+    if ( ( iNumPackets <= 0 ) || !bSendEnabled )
+    {
+        return;
+    }
+
+    // all queued packets are handed over to the transport as one batch
+    STransportSendPacket vecPackets[NUM_SOCKET_SEND_QUEUE_SLOTS];
+    int                  iNumBatchPackets = 0;
+
+    for ( int i = 0; i < iNumPackets; i++ )
+    {
+        if ( vecSendQueueLen[i] > 0 )
+        {
+            vecPackets[iNumBatchPackets].pbyData   = &vecvecbySendQueueBuf[i][0];
+            vecPackets[iNumBatchPackets].iNumBytes = vecSendQueueLen[i];
+            vecPackets[iNumBatchPackets].pAddr       = &vecSendQueueAddr[i];
+            vecPackets[iNumBatchPackets].iTxOffsetNs = 0;
+            iNumBatchPackets++;
+        }
+    }
+
+    // the packets to the relayed clients are replaced by one frame per relay
+    if ( ( pRelayRoutes != nullptr ) && pRelayRoutes->HasRoutes() )
+    {
+        iNumBatchPackets = pRelayRoutes->AggregatePackets ( vecPackets, iNumBatchPackets );
+    }
+
+    if ( ( iPacingWindowNs > 0 ) && ( iNumBatchPackets > 1 ) )
+    {
+        // the slots are filled by the worker threads in a random order, the
+        // packets are sorted by their addresses so that the departure time of
+        // a client does not change from frame to frame
+        std::sort ( vecPackets, vecPackets + iNumBatchPackets,
+                    [] ( const STransportSendPacket& First, const STransportSendPacket& Second )
+                    { return memcmp ( First.pAddr, Second.pAddr, sizeof ( USockAddr ) ) < 0; } );
+
+        for ( int i = 0; i < iNumBatchPackets; i++ )
+        {
+            vecPackets[i].iTxOffsetNs = static_cast<int> ( static_cast<qint64> ( iPacingWindowNs ) * i / iNumBatchPackets );
+        }
+    }
+
+    pTransport->SendBatch ( vecPackets, iNumBatchPackets );
+}
+
+bool CSocket::EnablePacing ( const int iNPacingWindowNs )
+{
+    if ( !pTransport->EnablePacing() )
     {
-        // reset flag and return "not OK" status
-        bJitterBufferOK = true;
         return false;
     }
 
-    // the buffer was OK, we do not have to reset anything and just return the
-    // OK status
+    iPacingWindowNs = iNPacingWindowNs;
     return true;
 }
 
+void CSocket::GetAndResetRecCounters ( int& iNumCalls,
+                                       int& iNumPackets )
+{
+    iNumCalls   = iNumRecCalls.fetchAndStoreRelaxed ( 0 );
+    iNumPackets = iNumRecPackets.fetchAndStoreRelaxed ( 0 );
+}
+
+double CSocket::GetAndResetRecPacketsPerCall()
+{
+    int iNumCalls;
+    int iNumPackets;
+
+    GetAndResetRecCounters ( iNumCalls, iNumPackets );
+
+    if ( iNumCalls == 0 )
+    {
+        return 0;
+    }
+
+    return static_cast<double> ( iNumPackets ) / iNumCalls;
+}
+
+void CSocket::DeliverProtcolMessages()
+{
+    TRACE_SCOPE ( TP_PROTOCOL );
+
+    // reset the notification flag before reading the queue, i.e. a message
+    // which is put after this point triggers a new notification
+    iProtMessNotifyPending.fetchAndStoreOrdered ( 0 );
+
+    int iGetPos = iProtMessGetPos.loadAcquire();
+
+    while ( iGetPos != iProtMessPutPos.loadAcquire() )
+    {
+        const int iSlot = iGetPos % NUM_SOCKET_PROT_MESS_SLOTS;
+
+        // we are in the protocol thread, i.e. the connected slots are called
+        // directly
+        if ( CProtocol::IsConnectionLessMessageID ( vecProtMessRecID[iSlot] ) )
+        {
+            emit ProtcolCLMessageReceived ( vecProtMessRecID[iSlot],
+                                            vecvecbyProtMessBody[iSlot],
+                                            vecProtMessHostAddr[iSlot] );
+        }
+        else
+        {
+            emit ProtcolMessageReceived ( vecProtMessRecCounter[iSlot],
+                                          vecProtMessRecID[iSlot],
+                                          vecvecbyProtMessBody[iSlot],
+                                          vecProtMessHostAddr[iSlot] );
+        }
+
+        // release the slot to the socket thread
+        iGetPos = ( iGetPos + 1 ) % ( 2 * NUM_SOCKET_PROT_MESS_SLOTS );
+        iProtMessGetPos.storeRelease ( iGetPos );
+    }
+}
+
 void CSocket::OnDataReceived()
 {
 /*
@@ -217,71 +660,235 @@ void CSocket::OnDataReceived()
     use the signal/slot mechanism (i.e. we use messages for that).
 */
 
-    // read block from network interface and query address of sender
-    sockaddr_in SenderAddr;
-#ifdef _WIN32
-    int SenderAddrSize = sizeof ( sockaddr_in );
-#else
-    socklen_t SenderAddrSize = sizeof ( sockaddr_in );
-#endif
+    // wait for the packets (the transport reads as many packets as available
+    // with as few system calls as possible)
+    STransportRecPacket vecPackets[NUM_SOCKET_RECV_BATCH_SLOTS];
 
-    const long iNumBytesRead = recvfrom ( UdpSocket,
-                                          (char*) &vecbyRecBuf[0],
-                                          MAX_SIZE_BYTES_NETW_BUF,
-                                          0,
-                                          (sockaddr*) &SenderAddr,
-                                          &SenderAddrSize );
+    const int iNumPackets = pTransport->Receive ( vecPackets, NUM_SOCKET_RECV_BATCH_SLOTS );
 
-    // check if an error occurred or no data could be read
-    if ( iNumBytesRead <= 0 )
+    if ( iNumPackets > 0 )
+    {
+        TRACE_SCOPE ( TP_SOCKET_RECEIVE );
+
+        iNumRecCalls.fetchAndAddRelaxed ( 1 );
+        iNumRecPackets.fetchAndAddRelaxed ( iNumPackets );
+
+        for ( int i = 0; i < iNumPackets; i++ )
+        {
+            iRecDelayNs = CSocketTransport::GetRecvDelayNs ( vecPackets[i].iRecTimeNs );
+
+            ProcessReceivedPacket ( *vecPackets[i].pvecbyBuf,
+                                    vecPackets[i].iNumBytes,
+                                    vecPackets[i].Addr,
+                                    vecPackets[i].iChanIDHint );
+        }
+    }
+
+    // the receive call returns at least once per cleanup interval if the
+    // connected channel sockets are used
+    if ( bConnectedSockets &&
+         ( ConnSockCleanupTimer.elapsed() >= CONN_SOCKET_CLEANUP_INTERVAL_MS ) )
+    {
+        ConnSockCleanupTimer.start();
+        CloseUnusedChannelSockets();
+    }
+}
+
+void CSocket::OpenChannelSocket ( const int        iChanID,
+                                  const USockAddr& ClientAddr )
+{
+    if ( ( iChanID < 0 ) || ( iChanID >= vecbConnSockOpen.Size() ) )
     {
         return;
     }
 
-    // convert address of client
-    RecHostAddr.InetAddr.setAddress ( ntohl ( SenderAddr.sin_addr.s_addr ) );
-    RecHostAddr.iPort = ntohs ( SenderAddr.sin_port );
+    const CHostAddress ClientHostAddr = SockAddrToHostAddr ( ClientAddr );
+
+    // a socket of the same client on another channel ID (after a reconnect)
+    // is not used anymore (the previous socket of the channel ID is replaced
+    // by the transport)
+    for ( int i = 0; i < vecbConnSockOpen.Size(); i++ )
+    {
+        if ( ( i != iChanID ) && vecbConnSockOpen[i] && ( vecConnSockHostAddr[i] == ClientHostAddr ) )
+        {
+            pTransport->CloseChannelSocket ( i );
+            vecbConnSockOpen[i] = false;
+        }
+    }
+
+    // if the socket cannot be opened, the client is still received by the
+    // shared socket
+    vecbConnSockOpen[iChanID]    = pTransport->OpenChannelSocket ( iChanID, ClientAddr );
+    vecConnSockHostAddr[iChanID] = ClientHostAddr;
+}
+
+bool CSocket::JoinMulticastGroup ( const CHostAddress& GroupAddr )
+{
+    LeaveMulticastGroup();
+
+    if ( !GroupAddr.IsMulticast() || !SetMulticastMembership ( GroupAddr, true ) )
+    {
+        return false;
+    }
+
+#ifdef IP_MULTICAST_ALL
+    // only the packets of the joined group are received (by default Linux
+    // delivers the packets of all groups joined on the host to the port)
+    const int iMulticastAll = 0;
+
+    setsockopt ( UdpSocket, IPPROTO_IP, IP_MULTICAST_ALL, &iMulticastAll, sizeof ( iMulticastAll ) );
+#endif
+
+    MulticastGroupAddr = GroupAddr;
+    bMulticastJoined   = true;
+    return true;
+}
+
+void CSocket::LeaveMulticastGroup()
+{
+    if ( bMulticastJoined )
+    {
+        SetMulticastMembership ( MulticastGroupAddr, false );
+        bMulticastJoined = false;
+    }
+}
+
+bool CSocket::SetMulticastMembership ( const CHostAddress& GroupAddr,
+                                       const bool          bJoin )
+{
+    if ( GroupAddr.IsIPv4() )
+    {
+        // an IPv4 group is also joined with the IPv4 option on a dual-stack
+        // socket (the packets arrive with IPv4-mapped addresses)
+        struct ip_mreq Mreq;
+        memset ( &Mreq, 0, sizeof ( Mreq ) );
 
+        Mreq.imr_multiaddr.s_addr = htonl ( GroupAddr.GetIPv4Addr() );
+        Mreq.imr_interface.s_addr = htonl ( INADDR_ANY );
 
-    // check if this is a protocol message
-    int              iRecCounter;
-    int              iRecID;
-    CVector<uint8_t> vecbyMesBodyData;
+        return setsockopt ( UdpSocket, IPPROTO_IP, bJoin ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP,
+                            (const char*) &Mreq, sizeof ( Mreq ) ) == 0;
+    }
+
+    if ( !IsDualStack() )
+    {
+        return false;
+    }
+
+    struct ipv6_mreq Mreq6;
+    memset ( &Mreq6, 0, sizeof ( Mreq6 ) );
+
+    memcpy ( &Mreq6.ipv6mr_multiaddr, GroupAddr.Addr, sizeof ( GroupAddr.Addr ) );
+    Mreq6.ipv6mr_interface = 0;
+
+    return setsockopt ( UdpSocket, IPPROTO_IPV6, bJoin ? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP,
+                        (const char*) &Mreq6, sizeof ( Mreq6 ) ) == 0;
+}
 
-    if ( !CProtocol::ParseMessageFrame ( vecbyRecBuf,
-                                         iNumBytesRead,
-                                         vecbyMesBodyData,
-                                         iRecCounter,
-                                         iRecID ) )
+void CSocket::CloseUnusedChannelSockets()
+{
+    for ( int i = 0; i < vecbConnSockOpen.Size(); i++ )
     {
-        // this is a protocol message, check the type of the message
-        if ( CProtocol::IsConnectionLessMessageID ( iRecID ) )
+        if ( vecbConnSockOpen[i] &&
+             !pServer->IsChannelAddress ( i, vecConnSockHostAddr[i] ) )
         {
+            pTransport->CloseChannelSocket ( i );
+            vecbConnSockOpen[i] = false;
+        }
+    }
+}
 
-// TODO a copy of the vector is used -> avoid malloc in real-time routine
+void CSocket::ProcessReceivedPacket ( CVector<uint8_t>&  vecbyBuf,
+                                      const int          iNumBytesRead,
+                                      const USockAddr&   SenderAddr,
+                                      const int          iChanIDHint )
+{
+    // convert address of client
+    RecHostAddr = SockAddrToHostAddr ( SenderAddr );
 
-            emit ProtcolCLMessageReceived ( iRecID, vecbyMesBodyData, RecHostAddr );
+    // the packets of a frame of an allowed relay are processed as if they were
+    // received from the clients directly (a relay cannot use a connected
+    // channel socket and cannot relay another relay)
+    if ( ( pRelayRoutes != nullptr ) && !bInRelayFrame && ( iChanIDHint == INVALID_INDEX ) &&
+         pRelayRoutes->IsEnabled() )
+    {
+        const int iRelayIdx = pRelayRoutes->GetRelayIdx ( RecHostAddr );
+
+        if ( iRelayIdx != INVALID_INDEX )
+        {
+            if ( ProcessRelayFrame ( vecbyBuf, iNumBytesRead, SenderAddr, iRelayIdx ) )
+            {
+                return;
+            }
         }
-        else
+        else if ( pRelayRoutes->HasRoutes() )
         {
+            // a client which sends directly again is not relayed anymore
+            pRelayRoutes->RemoveRoute ( RecHostAddr );
+        }
+    }
+
+    if ( pCapture != nullptr )
+    {
+        pCapture->PutPacket ( &vecbyBuf[0], iNumBytesRead, RecHostAddr );
+    }
+
+    // most of the packets are audio packets: only packets with a valid
+    // protocol header (zero tag and matching length) are parsed as a protocol
+    // message, all other packets go directly to the audio processing
+    bool bIsProtMess = false;
+
+    if ( CProtocol::IsMessageFrameHeader ( vecbyBuf, iNumBytesRead ) )
+    {
+        // the message is parsed directly in the next free slot of the protocol
+        // message queue (only the socket thread writes the put position)
+        const int  iPutPos   = iProtMessPutPos.loadAcquire();
+        const int  iNumUsed  = ( iPutPos - iProtMessGetPos.loadAcquire() + 2 * NUM_SOCKET_PROT_MESS_SLOTS ) %
+                               ( 2 * NUM_SOCKET_PROT_MESS_SLOTS );
+        const bool bSlotFree = ( iNumUsed < NUM_SOCKET_PROT_MESS_SLOTS );
+        const int  iSlot     = iPutPos % NUM_SOCKET_PROT_MESS_SLOTS;
 
-// TODO a copy of the vector is used -> avoid malloc in real-time routine
+        int iRecCounter;
+        int iRecID;
 
-            emit ProtcolMessageReceived ( iRecCounter, iRecID, vecbyMesBodyData, RecHostAddr );
+        bIsProtMess = !CProtocol::ParseMessageFrame ( vecbyBuf,
+                                                      iNumBytesRead,
+                                                      bSlotFree ? vecvecbyProtMessBody[iSlot] : vecbyProtMessDropBody,
+                                                      iRecCounter,
+                                                      iRecID );
+
+        // hand the protocol message over to the protocol thread (if the queue
+        // is full, the message is dropped which is handled by the protocol
+        // like a lost packet)
+        if ( bIsProtMess && bSlotFree )
+        {
+            vecProtMessRecCounter[iSlot] = iRecCounter;
+            vecProtMessRecID[iSlot]      = iRecID;
+            vecProtMessHostAddr[iSlot]   = RecHostAddr;
+
+            iProtMessPutPos.storeRelease ( ( iPutPos + 1 ) % ( 2 * NUM_SOCKET_PROT_MESS_SLOTS ) );
+
+            // only notify the protocol thread if it does not already have a
+            // pending notification (so we only get one event per burst)
+            if ( iProtMessNotifyPending.testAndSetOrdered ( 0, 1 ) )
+            {
+                emit ProtcolMessagesAvailable();
+            }
         }
     }
-    else
+
+    if ( !bIsProtMess )
     {
         // this is most probably a regular audio packet
         if ( bIsClient )
         {
             // client:
 
-            switch ( pChannel->PutAudioData ( vecbyRecBuf, iNumBytesRead, RecHostAddr ) )
+            switch ( pChannel->PutAudioData ( vecbyBuf, iNumBytesRead, RecHostAddr, iRecDelayNs ) )
             {
             case PS_AUDIO_ERR:
             case PS_GEN_ERROR:
-                bJitterBufferOK = false;
+                iNumJitBufPutErrors.fetchAndAddRelease ( 1 );
                 break;
 
             case PS_NEW_CONNECTION:
@@ -305,17 +912,24 @@ void CSocket::OnDataReceived()
 
             int iCurChanID;
 
-            if ( pServer->PutAudioData ( vecbyRecBuf, iNumBytesRead, RecHostAddr, iCurChanID ) )
+            if ( pServer->PutAudioData ( vecbyBuf, iNumBytesRead, RecHostAddr, iCurChanID, iChanIDHint, iRecDelayNs ) )
             {
                 // we have a new connection, emit a signal
                 emit NewConnection ( iCurChanID, RecHostAddr );
 
+                // the further packets of the client are received by its own
+                // socket (not on replaying a capture)
+                if ( bConnectedSockets && bSendEnabled && !bInRelayFrame )
+                {
+                    OpenChannelSocket ( iCurChanID, SenderAddr );
+                }
+
                 // this was an audio packet, start server if it is in sleep mode
+                // (the timer thread is woken up directly, no event of the main
+                // event loop and no allocation is required)
                 if ( !pServer->IsRunning() )
                 {
-                    // (note that Qt will delete the event object when done)
-                    QCoreApplication::postEvent ( pServer,
-                        new CCustomEvent ( MS_PACKET_RECEIVED, 0, 0 ) );
+                    pServer->WakeUp();
                 }
             }
 
@@ -323,8 +937,225 @@ void CSocket::OnDataReceived()
             if ( iCurChanID == INVALID_CHANNEL_ID )
             {
                 // fire message for the state that no free channel is available
-                emit ServerFull ( RecHostAddr );
+                // (a client which is rejected sends hundreds of audio packets per
+                // second, it does not need an answer on each of them)
+                if ( ServerFullLimiter.Allow ( RecHostAddr, ServerFullClock.elapsed() ) )
+                {
+                    emit ServerFull ( RecHostAddr );
+                }
             }
         }
     }
 }
+
+bool CSocket::ProcessRelayFrame ( const CVector<uint8_t>& vecbyBuf,
+                                  const int               iNumBytesRead,
+                                  const USockAddr&        SenderAddr,
+                                  const int               iRelayIdx )
+{
+    int iSequenceNumber;
+    int iNumPackets;
+
+    if ( !CRelayFrame::ParseHeader ( &vecbyBuf[0], iNumBytesRead, iSequenceNumber, iNumPackets ) )
+    {
+        return false;
+    }
+
+    pRelayRoutes->PutFrame ( iRelayIdx, SenderAddr, iSequenceNumber );
+
+    int iPos      = RELAY_HEADER_SIZE;
+    bInRelayFrame = true;
+
+    for ( int i = 0; i < iNumPackets; i++ )
+    {
+        CHostAddress ClientAddr;
+        int          iNumBytes;
+
+        const uint8_t* pbyPacket = CRelayFrame::GetPacket ( &vecbyBuf[0], iPos, ClientAddr, iNumBytes );
+
+        if ( ( iNumBytes > 0 ) && ( pRelayRoutes->GetRelayIdx ( ClientAddr ) == INVALID_INDEX ) )
+        {
+            USockAddr ClientSockAddr;
+
+            HostAddrToSockAddr ( ClientAddr, ClientSockAddr );
+            pRelayRoutes->PutRoute ( ClientAddr, iRelayIdx );
+
+            std::copy ( pbyPacket, pbyPacket + iNumBytes, vecbyRelayPacketBuf.begin() );
+            ProcessReceivedPacket ( vecbyRelayPacketBuf, iNumBytes, ClientSockAddr );
+        }
+    }
+
+    bInRelayFrame = false;
+
+    return true;
+}
+
+void CSocket::InjectPacket ( CVector<uint8_t>&   vecbyBuf,
+                             const int           iNumBytes,
+                             const CHostAddress& HostAddr )
+{
+    USockAddr SenderAddr;
+
+    HostAddrToSockAddr ( HostAddr, SenderAddr );
+
+    iRecDelayNs = 0;
+    ProcessReceivedPacket ( vecbyBuf, iNumBytes, SenderAddr );
+}
+
+
+/* High priority socket implementation ****************************************/
+CHighPrioSocket::CHighPrioSocket ( CServer*      pNewServer,
+                                   const quint16 iPortNumber,
+                                   const int     iNumRecvShards,
+                                   const bool    bConnectedSockets ) :
+#ifdef USE_SO_REUSEPORT_SHARDS
+    Socket ( pNewServer, iPortNumber, iNumRecvShards > 1, bConnectedSockets )
+#else
+    Socket ( pNewServer, iPortNumber, false, bConnectedSockets )
+#endif
+{
+    Init();
+
+#ifdef USE_SO_REUSEPORT_SHARDS
+    // create the additional receive sockets, each with its own receive thread
+    const int iNumShards = std::min ( iNumRecvShards, MAX_NUM_SERVER_RECV_SHARDS );
+    const int iNumCores  = QThread::idealThreadCount();
+
+    if ( iNumShards > 1 )
+    {
+        // pin the receive threads starting from the last core (the audio
+        // worker threads are pinned starting from the first cores)
+        if ( iNumCores > 1 )
+        {
+            NetworkWorkerThread.SetCpuCore ( iNumCores - 1 );
+        }
+
+        for ( int i = 1; i < iNumShards; i++ )
+        {
+            CSocket*       pShardSocket = new CSocket ( pNewServer, iPortNumber, true, bConnectedSockets );
+            CSocketThread* pShardThread = new CSocketThread ( pShardSocket );
+
+            pShardSocket->moveToThread ( pShardThread );
+            pShardThread->SetThreadIdx ( i );
+
+            if ( iNumCores > 1 )
+            {
+                pShardThread->SetCpuCore ( ( iNumCores - 1 - i % iNumCores + iNumCores ) % iNumCores );
+            }
+
+            QObject::connect ( pShardSocket, &CSocket::ProtcolMessagesAvailable,
+                this, &CHighPrioSocket::OnProtcolMessagesAvailable );
+
+            vecpShardSockets.Add ( pShardSocket );
+            vecpShardThreads.Add ( pShardThread );
+        }
+    }
+#else
+    Q_UNUSED ( iNumRecvShards )
+#endif
+}
+
+CHighPrioSocket::~CHighPrioSocket()
+{
+    NetworkWorkerThread.Stop();
+
+    for ( int i = 0; i < vecpShardThreads.Size(); i++ )
+    {
+        vecpShardThreads[i]->Stop();
+
+        delete vecpShardThreads[i];
+        delete vecpShardSockets[i];
+    }
+}
+
+void CHighPrioSocket::Start()
+{
+    // starts the high priority socket receive threads (with using blocking
+    // socket request call)
+    NetworkWorkerThread.start ( QThread::TimeCriticalPriority );
+
+    for ( int i = 0; i < vecpShardThreads.Size(); i++ )
+    {
+        vecpShardThreads[i]->start ( QThread::TimeCriticalPriority );
+    }
+}
+
+int CHighPrioSocket::GetAndResetNumServerFullDropped()
+{
+    int iNumDropped = Socket.GetAndResetNumServerFullDropped();
+
+    for ( int i = 0; i < vecpShardSockets.Size(); i++ )
+    {
+        iNumDropped += vecpShardSockets[i]->GetAndResetNumServerFullDropped();
+    }
+
+    return iNumDropped;
+}
+
+double CHighPrioSocket::GetAndResetRecPacketsPerCall()
+{
+    int iNumCalls;
+    int iNumPackets;
+
+    Socket.GetAndResetRecCounters ( iNumCalls, iNumPackets );
+
+    for ( int i = 0; i < vecpShardSockets.Size(); i++ )
+    {
+        int iNumShardCalls;
+        int iNumShardPackets;
+
+        vecpShardSockets[i]->GetAndResetRecCounters ( iNumShardCalls, iNumShardPackets );
+
+        iNumCalls   += iNumShardCalls;
+        iNumPackets += iNumShardPackets;
+    }
+
+    if ( iNumCalls == 0 )
+    {
+        return 0;
+    }
+
+    return static_cast<double> ( iNumPackets ) / iNumCalls;
+}
+
+void CHighPrioSocket::SetBufferSizes ( const int iNumChannels )
+{
+    Socket.SetBufferSizes ( iNumChannels );
+
+    for ( int i = 0; i < vecpShardSockets.Size(); i++ )
+    {
+        vecpShardSockets[i]->SetBufferSizes ( iNumChannels );
+    }
+}
+
+void CHighPrioSocket::SetPacketCapture ( CPacketCapture* pNCapture )
+{
+    Socket.SetPacketCapture ( pNCapture );
+
+    for ( int i = 0; i < vecpShardSockets.Size(); i++ )
+    {
+        vecpShardSockets[i]->SetPacketCapture ( pNCapture );
+    }
+}
+
+void CHighPrioSocket::SetRelayRoutes ( CRelayRoutes* pNRelayRoutes )
+{
+    Socket.SetRelayRoutes ( pNRelayRoutes );
+
+    for ( int i = 0; i < vecpShardSockets.Size(); i++ )
+    {
+        vecpShardSockets[i]->SetRelayRoutes ( pNRelayRoutes );
+    }
+}
+
+void CHighPrioSocket::OnProtcolMessagesAvailable()
+{
+    // we do not know which of the sockets has sent the notification, an empty
+    // queue is cheap to check
+    Socket.DeliverProtcolMessages();
+
+    for ( int i = 0; i < vecpShardSockets.Size(); i++ )
+    {
+        vecpShardSockets[i]->DeliverProtcolMessages();
+    }
+}
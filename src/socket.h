@@ -26,15 +26,24 @@
 
 #include <QObject>
 #include <QThread>
-#include <QMutex>
+#include <QAtomicInt>
+#include <QElapsedTimer>
 #include <vector>
+#include <memory>
 #include "global.h"
 #include "protocol.h"
 #include "util.h"
+#include "sockettransport.h"
+#include "threadsched.h"
+#include "tracer.h"
 #ifndef _WIN32
 # include <netinet/in.h>
 # include <sys/socket.h>
 #endif
+#if defined ( __linux__ ) && !defined ( ANDROID )
+# include <pthread.h>
+# include <sched.h>
+#endif
 
 
 // The header files channel.h and server.h require to include this header file
@@ -42,12 +51,47 @@
 // channel class and server class is defined here.
 class CServer;  // forward declaration of CServer
 class CChannel; // forward declaration of CChannel
+class CPacketCapture; // forward declaration of CPacketCapture
+class CRelayRoutes;   // forward declaration of CRelayRoutes
 
 
 /* Definitions ****************************************************************/
 // number of ports we try to bind until we give up
 #define NUM_SOCKET_PORTS_TO_TRY         50
 
+// the send queue of the server can store two packets per channel and frame,
+// larger packets than the slot size are sent directly
+#define NUM_SOCKET_SEND_QUEUE_SLOTS     ( 2 * MAX_NUM_CHANNELS )
+#define MAX_SIZE_BYTES_SEND_QUEUE_SLOT  1500
+
+// number of received protocol messages which can be queued for the protocol
+// thread (if the queue is full, further messages are dropped)
+#define NUM_SOCKET_PROT_MESS_SLOTS      32
+
+// on Linux the server can receive with multiple sockets on the same port, the
+// kernel distributes the clients on the sockets by a hash of the address
+#if defined ( __linux__ ) && !defined ( ANDROID )
+# define USE_SO_REUSEPORT_SHARDS
+#endif
+
+// maximum number of server receive sockets/threads
+#define MAX_NUM_SERVER_RECV_SHARDS      16
+
+// DSCP marks of the packets in the IP TOS byte: expedited forwarding (EF) for
+// the audio packets (the TOS of the socket) and low-latency data (AF21) for
+// the protocol messages
+#define SOCKET_TOS_AUDIO                0xB8 // DSCP 46
+#define SOCKET_TOS_PROTOCOL             0x48 // DSCP 18
+
+// queueing priority of the socket on Linux (the highest priority which does
+// not require the CAP_NET_ADMIN capability)
+#define SOCKET_PRIORITY                 6
+
+// socket buffer sizes of the server: about 40 ms of packets of a channel
+// including the kernel overhead per packet
+#define SOCKET_BUF_SIZE_PER_CHANNEL     32768 // bytes
+#define SOCKET_MIN_BUF_SIZE             262144 // bytes
+
 
 /* Classes ********************************************************************/
 /* Base socket class -------------------------------------------------------- */
@@ -60,44 +104,214 @@ public:
               const quint16 iPortNumber )
         : pChannel ( pNewChannel ),
           bIsClient ( true ),
-          bJitterBufferOK ( true ) { Init ( iPortNumber ); }
+          iNumJitBufPutErrors ( 0 ),
+          bReusePort ( false ),
+          bConnectedSockets ( false ),
+          ServerFullLimiter ( CONNLESS_FULL_SOURCE_RATE, CONNLESS_FULL_SOURCE_BURST,
+                              CONNLESS_FULL_GLOBAL_RATE, CONNLESS_FULL_GLOBAL_BURST ) { Init ( iPortNumber ); }
 
     CSocket ( CServer*      pNServP,
-              const quint16 iPortNumber )
+              const quint16 iPortNumber,
+              const bool    bNReusePort = false,
+              const bool    bNConnectedSockets = false )
         : pServer ( pNServP ),
           bIsClient ( false ),
-          bJitterBufferOK ( true ) { Init ( iPortNumber ); }
+          iNumJitBufPutErrors ( 0 ),
+          bReusePort ( bNReusePort || bNConnectedSockets ),
+          bConnectedSockets ( bNConnectedSockets ),
+          ServerFullLimiter ( CONNLESS_FULL_SOURCE_RATE, CONNLESS_FULL_SOURCE_BURST,
+                              CONNLESS_FULL_GLOBAL_RATE, CONNLESS_FULL_GLOBAL_BURST ) { Init ( iPortNumber ); }
 
     virtual ~CSocket();
 
     void SendPacket ( const CVector<uint8_t>& vecbySendBuf,
                       const CHostAddress&     HostAddr );
 
-    bool GetAndResetbJitterBufferOKFlag();
+    // the protocol messages are sent with their own DSCP mark
+    void SendProtPacket ( const CVector<uint8_t>& vecbySendBuf,
+                          const CHostAddress&     HostAddr );
+
+    void SendProtPacket ( const uint8_t*     pbySendBuf,
+                          const int          iNumBytes,
+                          const USockAddr&   SockAddr );
+
+    // sizes the socket buffers for the given number of channels (a warning is
+    // printed if the system limits the size)
+    void SetBufferSizes ( const int iNumChannels );
+
+    // zero-copy send of a buffer to an already converted socket address (this
+    // function may be called from multiple threads at the same time)
+    void SendPacket ( const uint8_t*     pbySendBuf,
+                      const int          iNumBytes,
+                      const USockAddr&   SockAddr );
+
+    // the queued packets are only sent on calling FlushSendQueue() (which
+    // must not be called concurrently to QueuePacket()), QueuePacket() may be
+    // called from multiple threads at the same time
+    void QueuePacket ( const uint8_t*     pbySendBuf,
+                       const int          iNumBytes,
+                       const USockAddr&   SockAddr );
+
+    void FlushSendQueue();
+
+    // the packets of a flush of the send queue are spread over the given
+    // time in the order of their addresses (i.e. each client keeps its
+    // position in the frame), returns false if pacing is not supported
+    bool EnablePacing ( const int iNPacingWindowNs );
+
+    static void HostAddrToSockAddr ( const CHostAddress& HostAddr,
+                                     USockAddr&          SockAddr );
+
+    static CHostAddress SockAddrToHostAddr ( const USockAddr& SockAddr );
+
+    // the sockets are dual-stack IPv6 sockets if the system supports IPv6
+    // (checked once), otherwise only IPv4 can be used
+    static bool IsDualStack();
+
+    // number of the received audio packets which could not be put in the
+    // jitter buffer (the reader compares it with its last value)
+    int  GetNumJitBufPutErrors() const { return iNumJitBufPutErrors.loadAcquire(); }
     void Close();
 
+    // average number of received packets per receive system call since the
+    // last call of this function
+    double GetAndResetRecPacketsPerCall();
+
+    void GetAndResetRecCounters ( int& iNumCalls,
+                                  int& iNumPackets );
+
+    int GetAndResetNumServerFullDropped() { return ServerFullLimiter.GetAndResetNumDropped(); }
+
+    // emits the queued protocol messages (must be called by the protocol
+    // thread after the ProtcolMessagesAvailable signal)
+    void DeliverProtcolMessages();
+
+    // all received packets are passed to the capture (must be set before the
+    // socket thread is started)
+    void SetPacketCapture ( CPacketCapture* pNCapture ) { pCapture = pNCapture; }
+
+    // the frames of the allowed relays are demultiplexed and the packets to
+    // the relayed clients are sent through their relays (must be set before
+    // the socket thread is started, the relays may be allowed later)
+    void SetRelayRoutes ( CRelayRoutes* pNRelayRoutes ) { pRelayRoutes = pNRelayRoutes; }
+
+    // the client receives the packets to its port which are sent to the
+    // multicast group (the system selects the interface), a joined group is
+    // left before a new one is joined, returns false if joining failed
+    bool JoinMulticastGroup ( const CHostAddress& GroupAddr );
+    void LeaveMulticastGroup();
+
+    // on disabled sending, all packets are discarded (used for the replay)
+    void SetSendEnabled ( const bool bNSendEnabled ) { bSendEnabled = bNSendEnabled; }
+
+    // processes a packet as if it was received by the socket (must not be
+    // called while the socket thread is running)
+    void InjectPacket ( CVector<uint8_t>&   vecbyBuf,
+                        const int           iNumBytes,
+                        const CHostAddress& HostAddr );
+
 protected:
     void Init ( const quint16 iPortNumber );
 
-#ifdef _WIN32
-    SOCKET           UdpSocket;
-#else
-    int              UdpSocket;
-#endif
+    void SetBufferSize ( const int      iOption,
+                         const int      iSize,
+                         const QString& strName );
+
+    // the channel ID hint is given for packets of a connected channel socket
+    void ProcessReceivedPacket ( CVector<uint8_t>&  vecbyBuf,
+                                 const int          iNumBytesRead,
+                                 const USockAddr&   SenderAddr,
+                                 const int          iChanIDHint = INVALID_INDEX );
+
+    // returns false if the packet is no valid frame of the relay
+    bool ProcessRelayFrame ( const CVector<uint8_t>& vecbyBuf,
+                             const int               iNumBytesRead,
+                             const USockAddr&        SenderAddr,
+                             const int               iRelayIdx );
+
+    // sends a packet in a relay frame if the receiver is a relayed client,
+    // returns false if the packet must be sent directly
+    bool SendRelayed ( const uint8_t*     pbySendBuf,
+                       const int          iNumBytes,
+                       const USockAddr&   SockAddr,
+                       const bool         bIsProtMess );
+
+    void OpenChannelSocket ( const int          iChanID,
+                             const USockAddr&   ClientAddr );
+
+    void CloseUnusedChannelSockets();
+
+    static bool CheckDualStack();
 
-    QMutex           Mutex;
+    bool SetMulticastMembership ( const CHostAddress& GroupAddr,
+                                  const bool          bJoin );
 
-    CVector<uint8_t> vecbyRecBuf;
+    TSocketHandle    UdpSocket;
     CHostAddress     RecHostAddr;
+
+    // time since the kernel has received the currently processed packet (zero
+    // if unknown, the packets of a relay frame have the time of the frame)
+    int              iRecDelayNs;
+
+    // the receive and send calls on the socket are done by the transport
+    std::unique_ptr<CSocketTransport> pTransport;
+
+    // client addresses of the connected channel sockets of the transport
+    // (only used by the receive thread of this socket)
+    CVector<bool>         vecbConnSockOpen;
+    CVector<CHostAddress> vecConnSockHostAddr;
+    QElapsedTimer         ConnSockCleanupTimer;
+
+    // send queue (only used by the server)
+    CVector<CVector<uint8_t> > vecvecbySendQueueBuf;
+    CVector<int>               vecSendQueueLen;
+    CVector<USockAddr>         vecSendQueueAddr;
+    QAtomicInt                 iSendQueueNumPackets;
+    int                        iPacingWindowNs; // zero: no pacing
+
+    // queue of the received protocol messages with preallocated message
+    // bodies, written by the socket thread and read by the protocol thread
+    // (the positions run from 0 to 2 * NUM_SOCKET_PROT_MESS_SLOTS - 1)
+    CVector<CVector<uint8_t> > vecvecbyProtMessBody;
+    CVector<int>               vecProtMessRecCounter;
+    CVector<int>               vecProtMessRecID;
+    CVector<CHostAddress>      vecProtMessHostAddr;
+    CVector<uint8_t>           vecbyProtMessDropBody;
+    QAtomicInt                 iProtMessPutPos;
+    QAtomicInt                 iProtMessGetPos;
+    QAtomicInt                 iProtMessNotifyPending;
+
+    // receive statistics
+    QAtomicInt       iNumRecCalls;
+    QAtomicInt       iNumRecPackets;
     QHostAddress     SenderAddress;
     quint16          SenderPort;
 
     CChannel*        pChannel; // for client
     CServer*         pServer;  // for server
+    CPacketCapture*  pCapture;
+    CRelayRoutes*    pRelayRoutes;
+
+    // the packets of a relay frame are copied in this buffer for the
+    // processing (only used by the socket thread)
+    CVector<uint8_t> vecbyRelayPacketBuf;
+    bool             bInRelayFrame;
 
     bool             bIsClient;
+    bool             bSendEnabled;
+
+    // joined multicast group of the client
+    CHostAddress     MulticastGroupAddr;
+    bool             bMulticastJoined;
 
-    bool             bJitterBufferOK;
+    QAtomicInt       iNumJitBufPutErrors;
+    bool             bReusePort;
+    bool             bConnectedSockets;
+
+    // the server full messages are answers on audio packets, i.e. they are
+    // sent with a rate limit (only used by the socket thread of the server)
+    CConnLessRateLimiter ServerFullLimiter;
+    QElapsedTimer        ServerFullClock;
 
 public slots:
     void OnDataReceived();
@@ -112,14 +326,16 @@ signals:
 
     void InvalidPacketReceived ( CHostAddress RecHostAddr );
 
-    void ProtcolMessageReceived ( int              iRecCounter,
-                                  int              iRecID,
-                                  CVector<uint8_t> vecbyMesBodyData,
-                                  CHostAddress     HostAdr );
+    void ProtcolMessageReceived ( int          iRecCounter,
+                                  int          iRecID,
+                                  CProtMessage MesBody,
+                                  CHostAddress HostAdr );
+
+    void ProtcolCLMessageReceived ( int          iRecID,
+                                    CProtMessage MesBody,
+                                    CHostAddress HostAdr );
 
-    void ProtcolCLMessageReceived ( int              iRecID,
-                                    CVector<uint8_t> vecbyMesBodyData,
-                                    CHostAddress     HostAdr );
+    void ProtcolMessagesAvailable();
 };
 
 
@@ -138,30 +354,75 @@ public:
         : Socket ( pNewChannel, iPortNumber ) { Init(); }
 
     CHighPrioSocket ( CServer*      pNewServer,
-                      const quint16 iPortNumber )
-        : Socket ( pNewServer, iPortNumber ) { Init(); }
+                      const quint16 iPortNumber,
+                      const int     iNumRecvShards = 1,
+                      const bool    bConnectedSockets = false );
+
+    virtual ~CHighPrioSocket();
+
+    void Start();
+
+    void SendPacket ( const CVector<uint8_t>& vecbySendBuf,
+                      const CHostAddress&     HostAddr )
+    {
+        Socket.SendPacket ( vecbySendBuf, HostAddr );
+    }
 
-    virtual ~CHighPrioSocket()
+    void SendPacket ( const uint8_t*     pbySendBuf,
+                      const int          iNumBytes,
+                      const USockAddr&   SockAddr )
     {
-        NetworkWorkerThread.Stop();
+        Socket.SendPacket ( pbySendBuf, iNumBytes, SockAddr );
     }
 
-    void Start()
+    void QueuePacket ( const uint8_t*     pbySendBuf,
+                       const int          iNumBytes,
+                       const USockAddr&   SockAddr )
     {
-        // starts the high priority socket receive thread (with using blocking
-        // socket request call)
-        NetworkWorkerThread.start ( QThread::TimeCriticalPriority );
+        Socket.QueuePacket ( pbySendBuf, iNumBytes, SockAddr );
     }
 
-    void SendPacket ( const CVector<uint8_t>& vecbySendBuf,
-                      const CHostAddress&     HostAddr )
+    void SendProtPacket ( const CVector<uint8_t>& vecbySendBuf,
+                          const CHostAddress&     HostAddr )
     {
-        Socket.SendPacket ( vecbySendBuf, HostAddr );
+        Socket.SendProtPacket ( vecbySendBuf, HostAddr );
+    }
+
+    void SendProtPacket ( const uint8_t*     pbySendBuf,
+                          const int          iNumBytes,
+                          const USockAddr&   SockAddr )
+    {
+        Socket.SendProtPacket ( pbySendBuf, iNumBytes, SockAddr );
     }
 
-    bool GetAndResetbJitterBufferOKFlag()
+    void SetBufferSizes ( const int iNumChannels );
+
+    void FlushSendQueue() { Socket.FlushSendQueue(); }
+
+    // only the main socket sends the queued packets
+    bool EnablePacing ( const int iNPacingWindowNs ) { return Socket.EnablePacing ( iNPacingWindowNs ); }
+
+    int GetNumJitBufPutErrors() const { return Socket.GetNumJitBufPutErrors(); }
+
+    double GetAndResetRecPacketsPerCall();
+
+    int GetAndResetNumServerFullDropped();
+
+    void SetPacketCapture ( CPacketCapture* pNCapture );
+
+    void SetRelayRoutes ( CRelayRoutes* pNRelayRoutes );
+
+    bool JoinMulticastGroup ( const CHostAddress& GroupAddr ) { return Socket.JoinMulticastGroup ( GroupAddr ); }
+    void LeaveMulticastGroup() { Socket.LeaveMulticastGroup(); }
+
+    // the replay replaces the receive threads, i.e. Start() must not be called
+    void SetReplayMode() { Socket.SetSendEnabled ( false ); }
+
+    void InjectPacket ( CVector<uint8_t>&   vecbyBuf,
+                        const int           iNumBytes,
+                        const CHostAddress& HostAddr )
     {
-        return Socket.GetAndResetbJitterBufferOKFlag();
+        Socket.InjectPacket ( vecbyBuf, iNumBytes, HostAddr );
     }
 
 protected:
@@ -169,7 +430,7 @@ protected:
     {
     public:
         CSocketThread ( CSocket* pNewSocket = nullptr, QObject* parent = nullptr ) :
-          QThread ( parent ), pSocket ( pNewSocket ), bRun ( true ) {}
+          QThread ( parent ), pSocket ( pNewSocket ), iCpuCore ( -1 ), iThreadIdx ( 0 ), bRun ( true ) {}
 
         void Stop()
         {
@@ -185,8 +446,18 @@ protected:
 
         void SetSocket ( CSocket* pNewSocket ) { pSocket = pNewSocket; }
 
+        // pin the thread to the given CPU core if no CPU list is configured
+        // for the socket threads (-1: no pinning)
+        void SetCpuCore ( const int iNCpuCore ) { iCpuCore = iNCpuCore; }
+
+        // index of the thread in the CPU list of the socket threads
+        void SetThreadIdx ( const int iNThreadIdx ) { iThreadIdx = iNThreadIdx; }
+
     protected:
         void run() {
+            CThreadScheduling::ApplyToCurrentThread ( TR_SOCKET, iThreadIdx, iCpuCore );
+            CTracer::SetThreadName ( "socket", iThreadIdx );
+
             // make sure the socket pointer is initialized (should be always the
             // case)
             if ( pSocket != nullptr )
@@ -201,6 +472,8 @@ protected:
         }
 
         CSocket* pSocket;
+        int      iCpuCore;
+        int      iThreadIdx;
         bool     bRun;
     };
 
@@ -218,11 +491,24 @@ protected:
         // connect the "InvalidPacketReceived" signal
         QObject::connect ( &Socket, &CSocket::InvalidPacketReceived,
             this, &CHighPrioSocket::InvalidPacketReceived );
+
+        // the received protocol messages are delivered in the thread of this
+        // object (the socket object lives in the socket thread)
+        QObject::connect ( &Socket, &CSocket::ProtcolMessagesAvailable,
+            this, &CHighPrioSocket::OnProtcolMessagesAvailable );
     }
 
     CSocketThread NetworkWorkerThread;
     CSocket       Socket;
 
+    // additional receive sockets on the same port for the server (the main
+    // socket is used for sending)
+    CVector<CSocket*>       vecpShardSockets;
+    CVector<CSocketThread*> vecpShardThreads;
+
+protected slots:
+    void OnProtcolMessagesAvailable();
+
 signals:
     void InvalidPacketReceived ( CHostAddress RecHostAddr );
 };
@@ -0,0 +1,1068 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "sockettransport.h"
+#include <string.h>
+#ifdef USE_IO_URING
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <linux/time_types.h>
+# include <signal.h>
+# include <errno.h>
+#endif
+
+
+/* Implementation *************************************************************/
+ETransportBackend CSocketTransport::eBackend = TB_BSD_SOCKETS;
+
+CSocketTransport* CSocketTransport::Create ( const TSocketHandle Socket )
+{
+#ifdef USE_IO_URING
+    if ( eBackend == TB_IO_URING )
+    {
+        CIoUringSocketTransport* pTransport = new CIoUringSocketTransport ( Socket );
+
+        if ( pTransport->Init() )
+        {
+            return pTransport;
+        }
+
+        // the kernel does not support the required io_uring features
+        qWarning() << "io_uring is not available, the BSD socket transport is used";
+        delete pTransport;
+    }
+#endif
+
+    return new CBsdSocketTransport ( Socket );
+}
+
+void CSocketTransport::SendWithTos ( const uint8_t*   pbyData,
+                                    const int        iNumBytes,
+                                    const USockAddr& Addr,
+                                    const int        iTos )
+{
+#ifdef __linux__
+    // the TOS byte of the packet is given as ancillary data
+    iovec Iov;
+    Iov.iov_base = const_cast<uint8_t*> ( pbyData );
+    Iov.iov_len  = static_cast<size_t> ( iNumBytes );
+
+    uint8_t vecbyControl[CMSG_SPACE ( sizeof ( int ) )];
+    memset ( vecbyControl, 0, sizeof ( vecbyControl ) );
+
+    msghdr Msg;
+    memset ( &Msg, 0, sizeof ( Msg ) );
+    Msg.msg_name       = const_cast<USockAddr*> ( &Addr );
+    Msg.msg_namelen    = static_cast<socklen_t> ( GetSockAddrLen ( Addr ) );
+    Msg.msg_iov        = &Iov;
+    Msg.msg_iovlen     = 1;
+    Msg.msg_control    = vecbyControl;
+    Msg.msg_controllen = sizeof ( vecbyControl );
+
+    // an IPv6 packet has the traffic class instead (IPv4-mapped addresses of
+    // a dual-stack socket are sent as IPv4 packets)
+    const bool bIsIPv6 = ( Addr.Addr.sa_family == AF_INET6 ) &&
+                         !IN6_IS_ADDR_V4MAPPED ( &Addr.In6.sin6_addr );
+
+    cmsghdr* pCmsg    = CMSG_FIRSTHDR ( &Msg );
+    pCmsg->cmsg_level = bIsIPv6 ? IPPROTO_IPV6 : IPPROTO_IP;
+    pCmsg->cmsg_type  = bIsIPv6 ? IPV6_TCLASS : IP_TOS;
+    pCmsg->cmsg_len   = CMSG_LEN ( sizeof ( int ) );
+    memcpy ( CMSG_DATA ( pCmsg ), &iTos, sizeof ( int ) );
+
+    sendmsg ( Socket, &Msg, 0 );
+#else
+    Q_UNUSED ( iTos )
+    Send ( pbyData, iNumBytes, Addr );
+#endif
+}
+
+bool CSocketTransport::EnablePacing()
+{
+#ifdef USE_SO_TXTIME
+    // the departure times are given in the clock of the fq qdisc
+    sock_txtime TxTimeConfig;
+    memset ( &TxTimeConfig, 0, sizeof ( TxTimeConfig ) );
+    TxTimeConfig.clockid = CLOCK_MONOTONIC;
+    TxTimeConfig.flags   = 0;
+
+    bPacing = ( setsockopt ( Socket, SOL_SOCKET, SO_TXTIME, &TxTimeConfig, sizeof ( TxTimeConfig ) ) == 0 );
+#endif
+
+    return bPacing;
+}
+
+bool CSocketTransport::EnableRecvTimestamps()
+{
+#ifdef USE_SO_TIMESTAMPNS
+    const int iEnable = 1;
+
+    bRecvTimestamps = ( setsockopt ( Socket, SOL_SOCKET, SO_TIMESTAMPNS, &iEnable, sizeof ( iEnable ) ) == 0 );
+#endif
+
+    return bRecvTimestamps;
+}
+
+int CSocketTransport::GetRecvDelayNs ( const qint64 iRecTimeNs )
+{
+#ifdef USE_SO_TIMESTAMPNS
+    if ( iRecTimeNs == 0 )
+    {
+        return 0;
+    }
+
+    // the kernel time stamps are taken from the system clock
+    timespec CurTime;
+    clock_gettime ( CLOCK_REALTIME, &CurTime );
+
+    const qint64 iDelayNs = static_cast<qint64> ( CurTime.tv_sec ) * 1000000000 + CurTime.tv_nsec - iRecTimeNs;
+
+    if ( ( iDelayNs < 0 ) || ( iDelayNs > MAX_RECV_TIMESTAMP_DELAY_NS ) )
+    {
+        return 0;
+    }
+
+    return static_cast<int> ( iDelayNs );
+#else
+    Q_UNUSED ( iRecTimeNs )
+    return 0;
+#endif
+}
+
+#ifdef USE_SO_TIMESTAMPNS
+qint64 CSocketTransport::GetRecvTimestamp ( msghdr& Msg )
+{
+    for ( cmsghdr* pCmsg = CMSG_FIRSTHDR ( &Msg ); pCmsg != nullptr; pCmsg = CMSG_NXTHDR ( &Msg, pCmsg ) )
+    {
+        if ( ( pCmsg->cmsg_level == SOL_SOCKET ) && ( pCmsg->cmsg_type == SCM_TIMESTAMPNS ) )
+        {
+            timespec RecTime;
+            memcpy ( &RecTime, CMSG_DATA ( pCmsg ), sizeof ( RecTime ) );
+
+            return static_cast<qint64> ( RecTime.tv_sec ) * 1000000000 + RecTime.tv_nsec;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+#ifdef USE_SO_TXTIME
+void CSocketTransport::SetTxTime ( msghdr&        Msg,
+                                   uint8_t*       pbyControl,
+                                   const uint64_t iTxTimeNs )
+{
+    memset ( pbyControl, 0, TXTIME_CONTROL_SIZE );
+
+    Msg.msg_control    = pbyControl;
+    Msg.msg_controllen = TXTIME_CONTROL_SIZE;
+
+    cmsghdr* pCmsg    = CMSG_FIRSTHDR ( &Msg );
+    pCmsg->cmsg_level = SOL_SOCKET;
+    pCmsg->cmsg_type  = SCM_TXTIME;
+    pCmsg->cmsg_len   = CMSG_LEN ( sizeof ( uint64_t ) );
+    memcpy ( CMSG_DATA ( pCmsg ), &iTxTimeNs, sizeof ( uint64_t ) );
+}
+
+uint64_t CSocketTransport::GetTxTimeNow()
+{
+    timespec CurTime;
+    clock_gettime ( CLOCK_MONOTONIC, &CurTime );
+
+    return static_cast<uint64_t> ( CurTime.tv_sec ) * 1000000000 + static_cast<uint64_t> ( CurTime.tv_nsec );
+}
+#endif
+
+CBsdSocketTransport::CBsdSocketTransport ( const TSocketHandle NSocket ) :
+    CSocketTransport ( NSocket )
+{
+    vecvecbyRecBuf.Init ( NUM_SOCKET_RECV_BATCH_SLOTS );
+
+    for ( int i = 0; i < NUM_SOCKET_RECV_BATCH_SLOTS; i++ )
+    {
+        vecvecbyRecBuf[i].Init ( MAX_SIZE_BYTES_NETW_BUF );
+    }
+
+#ifdef USE_RECVMMSG
+    // prepare the message headers for the batched receive (note that the
+    // message headers are zero initialized by the vector)
+    vecRecMsgs.Init ( NUM_SOCKET_RECV_BATCH_SLOTS );
+    vecRecIov.Init  ( NUM_SOCKET_RECV_BATCH_SLOTS );
+    vecRecAddr.Init ( NUM_SOCKET_RECV_BATCH_SLOTS );
+# ifdef USE_SO_TIMESTAMPNS
+    vecbyRecControl.Init ( NUM_SOCKET_RECV_BATCH_SLOTS * RECV_TIMESTAMP_CONTROL_SIZE );
+# endif
+
+    for ( int i = 0; i < NUM_SOCKET_RECV_BATCH_SLOTS; i++ )
+    {
+        vecRecIov[i].iov_base = &vecvecbyRecBuf[i][0];
+        vecRecIov[i].iov_len  = MAX_SIZE_BYTES_NETW_BUF;
+
+        vecRecMsgs[i].msg_hdr.msg_name    = &vecRecAddr[i];
+        vecRecMsgs[i].msg_hdr.msg_namelen = sizeof ( USockAddr );
+        vecRecMsgs[i].msg_hdr.msg_iov     = &vecRecIov[i];
+        vecRecMsgs[i].msg_hdr.msg_iovlen  = 1;
+    }
+#endif
+
+#ifdef USE_CONNECTED_CHANNEL_SOCKETS
+    iEpollFd = -1;
+    iPort    = 0;
+#endif
+}
+
+CBsdSocketTransport::~CBsdSocketTransport()
+{
+#ifdef USE_CONNECTED_CHANNEL_SOCKETS
+    if ( iEpollFd >= 0 )
+    {
+        for ( int i = 0; i < vecChanSockets.Size(); i++ )
+        {
+            CloseChannelSocket ( i );
+        }
+
+        close ( iEpollFd );
+    }
+#endif
+}
+
+int CBsdSocketTransport::Receive ( STransportRecPacket* pPackets,
+                                   const int            iMaxNumPackets )
+{
+    const int iMaxNumSlots = std::min ( iMaxNumPackets, NUM_SOCKET_RECV_BATCH_SLOTS );
+
+#ifdef USE_CONNECTED_CHANNEL_SOCKETS
+    if ( iEpollFd >= 0 )
+    {
+        // the timeout is only required for closing the sockets of disconnected
+        // clients (the wait is left on closing the shared socket)
+        epoll_event vecEvents[NUM_SOCKET_RECV_BATCH_SLOTS];
+
+        const int iNumEvents = epoll_wait ( iEpollFd,
+                                            vecEvents,
+                                            iMaxNumSlots,
+                                            CONN_SOCKET_CLEANUP_INTERVAL_MS );
+
+        // the sockets are level triggered, i.e. the packets which do not fit
+        // in the slots are read by the next call
+        int iNumPackets = 0;
+
+        for ( int i = 0; ( i < iNumEvents ) && ( iNumPackets < iMaxNumSlots ); i++ )
+        {
+            const int iChanID = static_cast<int> ( vecEvents[i].data.u32 ) - 1;
+            const int iSocket = ( iChanID < 0 ) ? Socket : vecChanSockets[iChanID];
+
+            if ( iSocket >= 0 )
+            {
+                iNumPackets += ReceiveBatch ( iSocket,
+                                              MSG_DONTWAIT,
+                                              ( iChanID < 0 ) ? INVALID_INDEX : iChanID,
+                                              iNumPackets,
+                                              iMaxNumSlots,
+                                              pPackets );
+            }
+        }
+
+        return iNumPackets;
+    }
+#endif
+
+#ifdef USE_RECVMMSG
+    // read as many packets as available with one call (the call blocks until
+    // at least one packet is received)
+    return ReceiveBatch ( Socket, MSG_WAITFORONE, INVALID_INDEX, 0, iMaxNumSlots, pPackets );
+#else
+    // read block from network interface and query address of sender
+    if ( iMaxNumSlots < 1 )
+    {
+        return 0;
+    }
+
+# ifdef _WIN32
+    int SenderAddrSize = sizeof ( USockAddr );
+# else
+    socklen_t SenderAddrSize = sizeof ( USockAddr );
+# endif
+
+    const long iNumBytesRead = recvfrom ( Socket,
+                                          (char*) &vecvecbyRecBuf[0][0],
+                                          MAX_SIZE_BYTES_NETW_BUF,
+                                          0,
+                                          (sockaddr*) &pPackets[0].Addr,
+                                          &SenderAddrSize );
+
+    // check if an error occurred or no data could be read
+    if ( iNumBytesRead <= 0 )
+    {
+        return 0;
+    }
+
+    pPackets[0].pvecbyBuf   = &vecvecbyRecBuf[0];
+    pPackets[0].iNumBytes   = static_cast<int> ( iNumBytesRead );
+    pPackets[0].iChanIDHint = INVALID_INDEX;
+    pPackets[0].iRecTimeNs  = 0;
+
+    return 1;
+#endif
+}
+
+#ifdef USE_RECVMMSG
+int CBsdSocketTransport::ReceiveBatch ( const int            iSocket,
+                                        const int            iFlags,
+                                        const int            iChanIDHint,
+                                        const int            iFirstSlot,
+                                        const int            iMaxNumSlots,
+                                        STransportRecPacket* pPackets )
+{
+    for ( int i = iFirstSlot; i < iMaxNumSlots; i++ )
+    {
+        // the address length is modified by the call, therefore reset it
+        vecRecMsgs[i].msg_hdr.msg_namelen = sizeof ( USockAddr );
+
+# ifdef USE_SO_TIMESTAMPNS
+        // the control data length is modified, too
+        if ( bRecvTimestamps )
+        {
+            vecRecMsgs[i].msg_hdr.msg_control    = &vecbyRecControl[i * RECV_TIMESTAMP_CONTROL_SIZE];
+            vecRecMsgs[i].msg_hdr.msg_controllen = RECV_TIMESTAMP_CONTROL_SIZE;
+        }
+# endif
+    }
+
+    const int iNumRead = recvmmsg ( iSocket,
+                                    &vecRecMsgs[iFirstSlot],
+                                    static_cast<unsigned int> ( iMaxNumSlots - iFirstSlot ),
+                                    iFlags,
+                                    nullptr );
+
+    // check if an error occurred or no data could be read
+    if ( iNumRead <= 0 )
+    {
+        return 0;
+    }
+
+    // empty packets are skipped
+    int iNumPackets = 0;
+
+    for ( int i = iFirstSlot; i < iFirstSlot + iNumRead; i++ )
+    {
+        if ( vecRecMsgs[i].msg_len > 0 )
+        {
+            STransportRecPacket& Packet = pPackets[iFirstSlot + iNumPackets];
+
+            Packet.pvecbyBuf   = &vecvecbyRecBuf[i];
+            Packet.iNumBytes   = static_cast<int> ( vecRecMsgs[i].msg_len );
+            Packet.Addr        = vecRecAddr[i];
+            Packet.iChanIDHint = iChanIDHint;
+# ifdef USE_SO_TIMESTAMPNS
+            Packet.iRecTimeNs  = bRecvTimestamps ? GetRecvTimestamp ( vecRecMsgs[i].msg_hdr ) : 0;
+# else
+            Packet.iRecTimeNs  = 0;
+# endif
+
+            iNumPackets++;
+        }
+    }
+
+    return iNumPackets;
+}
+#endif
+
+void CBsdSocketTransport::Send ( const uint8_t*   pbyData,
+                                 const int        iNumBytes,
+                                 const USockAddr& Addr )
+{
+    // note that sending on an UDP socket is thread safe, therefore no mutex
+    // is required here
+    sendto ( Socket,
+             (const char*) pbyData,
+             iNumBytes,
+             0,
+             &Addr.Addr,
+             GetSockAddrLen ( Addr ) );
+}
+
+void CBsdSocketTransport::SendBatch ( const STransportSendPacket* pPackets,
+                                      const int                   iNumPackets )
+{
+#ifdef USE_SENDMMSG
+    // send all packets with as few system calls as possible (the message
+    // headers are prepared in chunks on the stack)
+    const int iChunkSize = 256;
+    mmsghdr   vecMsgs[iChunkSize];
+    iovec     vecIov[iChunkSize];
+
+# ifdef USE_SO_TXTIME
+    // the departure times of the batch are relative to this call
+    uint8_t        vecbyControl[iChunkSize][TXTIME_CONTROL_SIZE];
+    const uint64_t iStartTimeNs = bPacing ? GetTxTimeNow() : 0;
+# endif
+
+    for ( int iChunkStart = 0; iChunkStart < iNumPackets; iChunkStart += iChunkSize )
+    {
+        const int iNumMsgs = std::min ( iChunkSize, iNumPackets - iChunkStart );
+
+        for ( int i = 0; i < iNumMsgs; i++ )
+        {
+            const STransportSendPacket& Packet = pPackets[iChunkStart + i];
+
+            vecIov[i].iov_base = const_cast<uint8_t*> ( Packet.pbyData );
+            vecIov[i].iov_len  = static_cast<size_t> ( Packet.iNumBytes );
+
+            vecMsgs[i]                     = mmsghdr();
+            vecMsgs[i].msg_hdr.msg_name    = const_cast<USockAddr*> ( Packet.pAddr );
+            vecMsgs[i].msg_hdr.msg_namelen = static_cast<socklen_t> ( GetSockAddrLen ( *Packet.pAddr ) );
+            vecMsgs[i].msg_hdr.msg_iov     = &vecIov[i];
+            vecMsgs[i].msg_hdr.msg_iovlen  = 1;
+
+# ifdef USE_SO_TXTIME
+            if ( bPacing )
+            {
+                SetTxTime ( vecMsgs[i].msg_hdr, vecbyControl[i], iStartTimeNs + Packet.iTxOffsetNs );
+            }
+# endif
+        }
+
+        int iNumSent = 0;
+
+        while ( iNumSent < iNumMsgs )
+        {
+            const int iRet = sendmmsg ( Socket, &vecMsgs[iNumSent], iNumMsgs - iNumSent, 0 );
+
+            if ( iRet <= 0 )
+            {
+                // on an error we skip the packet which could not be sent
+                iNumSent++;
+            }
+            else
+            {
+                iNumSent += iRet;
+            }
+        }
+    }
+#else
+    for ( int i = 0; i < iNumPackets; i++ )
+    {
+        Send ( pPackets[i].pbyData, pPackets[i].iNumBytes, *pPackets[i].pAddr );
+    }
+#endif
+}
+
+#ifdef USE_CONNECTED_CHANNEL_SOCKETS
+bool CBsdSocketTransport::EnableChannelSockets ( const quint16 iNPort )
+{
+    iPort = iNPort;
+    vecChanSockets.Init ( MAX_NUM_CHANNELS, -1 );
+
+    iEpollFd = epoll_create1 ( EPOLL_CLOEXEC );
+
+    epoll_event Event = epoll_event();
+    Event.events      = EPOLLIN;
+    Event.data.u32    = 0;
+
+    if ( ( iEpollFd < 0 ) || ( epoll_ctl ( iEpollFd, EPOLL_CTL_ADD, Socket, &Event ) != 0 ) )
+    {
+        // without epoll we only use the shared socket
+        if ( iEpollFd >= 0 )
+        {
+            close ( iEpollFd );
+            iEpollFd = -1;
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+bool CBsdSocketTransport::OpenChannelSocket ( const int        iChanID,
+                                              const USockAddr& ClientAddr )
+{
+    if ( ( iEpollFd < 0 ) || ( iChanID < 0 ) || ( iChanID >= vecChanSockets.Size() ) )
+    {
+        return false;
+    }
+
+    CloseChannelSocket ( iChanID );
+
+    // the connected socket shares the port with the other sockets of the
+    // server, the kernel prefers the socket with the matching client address
+    // (the socket has the address family of the shared socket)
+    const int iSocket = socket ( ClientAddr.Addr.sa_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+
+    if ( iSocket < 0 )
+    {
+        return false;
+    }
+
+    const int iReusePort = 1;
+    const int iV6Only    = 0;
+
+    USockAddr LocalAddr;
+    memset ( &LocalAddr, 0, sizeof ( LocalAddr ) );
+
+    if ( ClientAddr.Addr.sa_family == AF_INET6 )
+    {
+        LocalAddr.In6.sin6_family = AF_INET6;
+        LocalAddr.In6.sin6_addr   = in6addr_any;
+        LocalAddr.In6.sin6_port   = htons ( iPort );
+
+        setsockopt ( iSocket, IPPROTO_IPV6, IPV6_V6ONLY, &iV6Only, sizeof ( iV6Only ) );
+    }
+    else
+    {
+        LocalAddr.In4.sin_family      = AF_INET;
+        LocalAddr.In4.sin_addr.s_addr = INADDR_ANY;
+        LocalAddr.In4.sin_port        = htons ( iPort );
+    }
+
+# ifdef USE_SO_TIMESTAMPNS
+    if ( bRecvTimestamps )
+    {
+        const int iEnable = 1;
+
+        setsockopt ( iSocket, SOL_SOCKET, SO_TIMESTAMPNS, &iEnable, sizeof ( iEnable ) );
+    }
+# endif
+
+    epoll_event Event = epoll_event();
+    Event.events      = EPOLLIN;
+    Event.data.u32    = static_cast<uint32_t> ( iChanID + 1 );
+
+    if ( ( setsockopt ( iSocket, SOL_SOCKET, SO_REUSEPORT, &iReusePort, sizeof ( iReusePort ) ) != 0 ) ||
+         ( ::bind ( iSocket, &LocalAddr.Addr, GetSockAddrLen ( LocalAddr ) ) != 0 ) ||
+         ( ::connect ( iSocket, &ClientAddr.Addr, GetSockAddrLen ( ClientAddr ) ) != 0 ) ||
+         ( epoll_ctl ( iEpollFd, EPOLL_CTL_ADD, iSocket, &Event ) != 0 ) )
+    {
+        // the client is still received by the shared socket
+        close ( iSocket );
+        return false;
+    }
+
+    vecChanSockets[iChanID] = iSocket;
+    return true;
+}
+
+void CBsdSocketTransport::CloseChannelSocket ( const int iChanID )
+{
+    if ( ( iChanID >= 0 ) && ( iChanID < vecChanSockets.Size() ) && ( vecChanSockets[iChanID] >= 0 ) )
+    {
+        // closing the socket also removes it from the epoll instance
+        close ( vecChanSockets[iChanID] );
+        vecChanSockets[iChanID] = -1;
+    }
+}
+#endif
+
+#ifdef USE_IO_URING
+/* io_uring implementation ****************************************************/
+CIoUring::CIoUring() :
+    iFd          ( -1 ),
+    pRing        ( MAP_FAILED ),
+    iRingSize    ( 0 ),
+    pCqRing      ( MAP_FAILED ),
+    iCqRingSize  ( 0 ),
+    pSqes        ( static_cast<io_uring_sqe*> ( MAP_FAILED ) ),
+    iSqesSize    ( 0 ),
+    iNumToSubmit ( 0 )
+{
+}
+
+CIoUring::~CIoUring()
+{
+    if ( pSqes != MAP_FAILED )
+    {
+        munmap ( pSqes, iSqesSize );
+    }
+
+    if ( ( pCqRing != MAP_FAILED ) && ( pCqRing != pRing ) )
+    {
+        munmap ( pCqRing, iCqRingSize );
+    }
+
+    if ( pRing != MAP_FAILED )
+    {
+        munmap ( pRing, iRingSize );
+    }
+
+    if ( iFd >= 0 )
+    {
+        close ( iFd );
+    }
+}
+
+bool CIoUring::Init ( const unsigned int iNumEntries )
+{
+    io_uring_params Params;
+    memset ( &Params, 0, sizeof ( Params ) );
+
+    // the completions are only processed in the wait of the ring thread
+    // (note that the ring is created by another thread than it is used,
+    // therefore it cannot be marked as single issuer)
+    Params.flags = IORING_SETUP_COOP_TASKRUN;
+
+    iFd = static_cast<int> ( syscall ( __NR_io_uring_setup, iNumEntries, &Params ) );
+
+    if ( iFd < 0 )
+    {
+        // older kernels do not know the flags
+        memset ( &Params, 0, sizeof ( Params ) );
+        iFd = static_cast<int> ( syscall ( __NR_io_uring_setup, iNumEntries, &Params ) );
+    }
+
+    // the timeout of the completion wait requires the extended arguments
+    if ( ( iFd < 0 ) || !( Params.features & IORING_FEAT_EXT_ARG ) )
+    {
+        return false;
+    }
+
+    // map the submission and completion rings (with a single mapping on
+    // recent kernels) and the submission entries
+    iRingSize   = Params.sq_off.array + Params.sq_entries * sizeof ( unsigned int );
+    iCqRingSize = Params.cq_off.cqes + Params.cq_entries * sizeof ( io_uring_cqe );
+
+    if ( Params.features & IORING_FEAT_SINGLE_MMAP )
+    {
+        iRingSize = std::max ( iRingSize, iCqRingSize );
+    }
+
+    pRing = mmap ( nullptr, iRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, iFd, IORING_OFF_SQ_RING );
+
+    if ( pRing == MAP_FAILED )
+    {
+        return false;
+    }
+
+    if ( Params.features & IORING_FEAT_SINGLE_MMAP )
+    {
+        pCqRing = pRing;
+    }
+    else
+    {
+        pCqRing = mmap ( nullptr, iCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, iFd, IORING_OFF_CQ_RING );
+
+        if ( pCqRing == MAP_FAILED )
+        {
+            return false;
+        }
+    }
+
+    iSqesSize = Params.sq_entries * sizeof ( io_uring_sqe );
+    pSqes     = static_cast<io_uring_sqe*> ( mmap ( nullptr, iSqesSize, PROT_READ | PROT_WRITE,
+                                                    MAP_SHARED | MAP_POPULATE, iFd, IORING_OFF_SQES ) );
+
+    if ( pSqes == MAP_FAILED )
+    {
+        return false;
+    }
+
+    uint8_t* pbySq = static_cast<uint8_t*> ( pRing );
+    uint8_t* pbyCq = static_cast<uint8_t*> ( pCqRing );
+
+    piSqHead      = reinterpret_cast<unsigned int*> ( pbySq + Params.sq_off.head );
+    piSqTail      = reinterpret_cast<unsigned int*> ( pbySq + Params.sq_off.tail );
+    iSqMask       = *reinterpret_cast<unsigned int*> ( pbySq + Params.sq_off.ring_mask );
+    iSqNumEntries = Params.sq_entries;
+    piCqHead      = reinterpret_cast<unsigned int*> ( pbyCq + Params.cq_off.head );
+    piCqTail      = reinterpret_cast<unsigned int*> ( pbyCq + Params.cq_off.tail );
+    iCqMask       = *reinterpret_cast<unsigned int*> ( pbyCq + Params.cq_off.ring_mask );
+    pCqes         = reinterpret_cast<io_uring_cqe*> ( pbyCq + Params.cq_off.cqes );
+
+    // the submission entries are used in the order of the ring
+    unsigned int* piSqArray = reinterpret_cast<unsigned int*> ( pbySq + Params.sq_off.array );
+
+    for ( unsigned int i = 0; i < iSqNumEntries; i++ )
+    {
+        piSqArray[i] = i;
+    }
+
+    return true;
+}
+
+io_uring_sqe* CIoUring::GetSqe()
+{
+    const unsigned int iTail = *piSqTail;
+
+    if ( iTail - __atomic_load_n ( piSqHead, __ATOMIC_ACQUIRE ) >= iSqNumEntries )
+    {
+        return nullptr;
+    }
+
+    io_uring_sqe* pSqe = &pSqes[iTail & iSqMask];
+    memset ( pSqe, 0, sizeof ( io_uring_sqe ) );
+
+    // the entry is published to the kernel with the tail
+    __atomic_store_n ( piSqTail, iTail + 1, __ATOMIC_RELEASE );
+    iNumToSubmit++;
+
+    return pSqe;
+}
+
+bool CIoUring::Submit ( const unsigned int iMinComplete,
+                        const int          iTimeoutMs )
+{
+    if ( ( iNumToSubmit == 0 ) && ( iMinComplete == 0 ) )
+    {
+        return true;
+    }
+
+    __kernel_timespec      Timeout;
+    io_uring_getevents_arg Arg;
+    memset ( &Arg, 0, sizeof ( Arg ) );
+
+    unsigned int iFlags = ( iMinComplete > 0 ) ? IORING_ENTER_GETEVENTS : 0;
+
+    if ( iTimeoutMs >= 0 )
+    {
+        Timeout.tv_sec  = iTimeoutMs / 1000;
+        Timeout.tv_nsec = static_cast<long long> ( iTimeoutMs % 1000 ) * 1000000;
+        Arg.sigmask_sz  = _NSIG / 8;
+        Arg.ts          = reinterpret_cast<uint64_t> ( &Timeout );
+        iFlags         |= IORING_ENTER_EXT_ARG;
+    }
+
+    const int iRet = static_cast<int> ( syscall ( __NR_io_uring_enter,
+                                                  iFd,
+                                                  iNumToSubmit,
+                                                  iMinComplete,
+                                                  iFlags,
+                                                  ( iTimeoutMs >= 0 ) ? static_cast<void*> ( &Arg ) : nullptr,
+                                                  ( iTimeoutMs >= 0 ) ? sizeof ( Arg ) : 0 ) );
+
+    if ( iRet >= 0 )
+    {
+        // the kernel consumes the entries in order
+        iNumToSubmit -= std::min ( static_cast<unsigned int> ( iRet ), iNumToSubmit );
+    }
+
+    return ( iRet >= 0 );
+}
+
+io_uring_cqe* CIoUring::PeekCqe()
+{
+    const unsigned int iHead = *piCqHead;
+
+    if ( iHead == __atomic_load_n ( piCqTail, __ATOMIC_ACQUIRE ) )
+    {
+        return nullptr;
+    }
+
+    return &pCqes[iHead & iCqMask];
+}
+
+void CIoUring::CqeSeen()
+{
+    __atomic_store_n ( piCqHead, *piCqHead + 1, __ATOMIC_RELEASE );
+}
+
+
+/* io_uring socket transport **************************************************/
+// user data of the completions
+#define IO_URING_RECV_TAG               1
+
+CIoUringSocketTransport::CIoUringSocketTransport ( const TSocketHandle NSocket ) :
+    CSocketTransport ( NSocket ),
+    pRecvBufRing     ( nullptr ),
+    iRecvBufRingSize ( 0 ),
+    iRecvBufSize     ( static_cast<int> ( sizeof ( io_uring_recvmsg_out ) + sizeof ( USockAddr ) ) +
+                       RECV_TIMESTAMP_CONTROL_SIZE + MAX_SIZE_BYTES_NETW_BUF ),
+    bRecvArmed       ( false )
+{
+    vecvecbyRecBuf.Init ( NUM_SOCKET_RECV_BATCH_SLOTS );
+
+    for ( int i = 0; i < NUM_SOCKET_RECV_BATCH_SLOTS; i++ )
+    {
+        vecvecbyRecBuf[i].Init ( MAX_SIZE_BYTES_NETW_BUF );
+    }
+
+    vecSendMsgs.Init ( NUM_IO_URING_SEND_ENTRIES );
+    vecSendIov.Init  ( NUM_IO_URING_SEND_ENTRIES );
+#ifdef USE_SO_TXTIME
+    vecbySendControl.Init ( NUM_IO_URING_SEND_ENTRIES * TXTIME_CONTROL_SIZE );
+#endif
+
+    // the multishot recvmsg only uses the address and control data lengths of
+    // the header (the space for the receive time is always reserved)
+    memset ( &RecvMsgHdr, 0, sizeof ( RecvMsgHdr ) );
+    RecvMsgHdr.msg_namelen    = sizeof ( USockAddr );
+    RecvMsgHdr.msg_controllen = RECV_TIMESTAMP_CONTROL_SIZE;
+}
+
+CIoUringSocketTransport::~CIoUringSocketTransport()
+{
+    // the buffer ring is unregistered by closing the ring
+    if ( pRecvBufRing != nullptr )
+    {
+        munmap ( pRecvBufRing, iRecvBufRingSize );
+    }
+}
+
+bool CIoUringSocketTransport::Init()
+{
+    // there can be a completion for each provided buffer
+    if ( !RecvRing.Init ( NUM_IO_URING_RECV_BUFFERS / 2 ) ||
+         !SendRing.Init ( NUM_IO_URING_SEND_ENTRIES ) )
+    {
+        return false;
+    }
+
+    // register the ring of the provided receive buffers (page aligned memory)
+    iRecvBufRingSize = NUM_IO_URING_RECV_BUFFERS * sizeof ( io_uring_buf );
+
+    void* pMem = mmap ( nullptr, iRecvBufRingSize, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0 );
+
+    if ( pMem == MAP_FAILED )
+    {
+        return false;
+    }
+
+    pRecvBufRing = static_cast<io_uring_buf*> ( pMem );
+    vecbyRecvBufPool.Init ( NUM_IO_URING_RECV_BUFFERS * iRecvBufSize );
+
+    io_uring_buf_reg Reg;
+    memset ( &Reg, 0, sizeof ( Reg ) );
+    Reg.ring_addr    = reinterpret_cast<uint64_t> ( pRecvBufRing );
+    Reg.ring_entries = NUM_IO_URING_RECV_BUFFERS;
+    Reg.bgid         = 0;
+
+    if ( syscall ( __NR_io_uring_register, RecvRing.GetFd(), IORING_REGISTER_PBUF_RING, &Reg, 1 ) != 0 )
+    {
+        return false;
+    }
+
+    pRecvBufRing[0].resv = 0;
+
+    for ( int i = 0; i < NUM_IO_URING_RECV_BUFFERS; i++ )
+    {
+        ProvideRecvBuffer ( i );
+    }
+
+    return ArmReceive();
+}
+
+void CIoUringSocketTransport::ProvideRecvBuffer ( const int iBufID )
+{
+    const uint16_t iTail = pRecvBufRing[0].resv;
+    io_uring_buf&  Buf   = pRecvBufRing[iTail & ( NUM_IO_URING_RECV_BUFFERS - 1 )];
+
+    // note that the reserved field (i.e. the tail for the first entry) is not
+    // written here
+    Buf.addr = reinterpret_cast<uint64_t> ( &vecbyRecvBufPool[iBufID * iRecvBufSize] );
+    Buf.len  = static_cast<uint32_t> ( iRecvBufSize );
+    Buf.bid  = static_cast<uint16_t> ( iBufID );
+
+    __atomic_store_n ( &pRecvBufRing[0].resv, static_cast<uint16_t> ( iTail + 1 ), __ATOMIC_RELEASE );
+}
+
+bool CIoUringSocketTransport::ArmReceive()
+{
+    io_uring_sqe* pSqe = RecvRing.GetSqe();
+
+    if ( pSqe == nullptr )
+    {
+        return false;
+    }
+
+    // one request delivers all packets until it is terminated by the kernel
+    // (e.g. if no provided buffer is left)
+    pSqe->opcode     = IORING_OP_RECVMSG;
+    pSqe->fd         = Socket;
+    pSqe->addr       = reinterpret_cast<uint64_t> ( &RecvMsgHdr );
+    pSqe->ioprio     = IORING_RECV_MULTISHOT;
+    pSqe->flags      = IOSQE_BUFFER_SELECT;
+    pSqe->buf_group  = 0;
+    pSqe->user_data  = IO_URING_RECV_TAG;
+
+    bRecvArmed = true;
+    return true;
+}
+
+int CIoUringSocketTransport::Receive ( STransportRecPacket* pPackets,
+                                       const int            iMaxNumPackets )
+{
+    const int iMaxNumSlots = std::min ( iMaxNumPackets, NUM_SOCKET_RECV_BATCH_SLOTS );
+
+    if ( !bRecvArmed )
+    {
+        ArmReceive();
+    }
+
+    // only wait if no completion is pending (the timeout lets the receive
+    // thread check its run flag)
+    if ( !RecvRing.Submit ( ( RecvRing.PeekCqe() == nullptr ) ? 1 : 0, IO_URING_RECV_TIMEOUT_MS ) )
+    {
+        return 0;
+    }
+
+    int           iNumPackets = 0;
+    io_uring_cqe* pCqe;
+
+    while ( ( iNumPackets < iMaxNumSlots ) && ( ( pCqe = RecvRing.PeekCqe() ) != nullptr ) )
+    {
+        if ( !( pCqe->flags & IORING_CQE_F_MORE ) )
+        {
+            // the multishot request is terminated and is armed again by the
+            // next call
+            bRecvArmed = false;
+        }
+
+        if ( pCqe->flags & IORING_CQE_F_BUFFER )
+        {
+            const int      iBufID = static_cast<int> ( pCqe->flags >> IORING_CQE_BUFFER_SHIFT );
+            const uint8_t* pbyBuf = &vecbyRecvBufPool[iBufID * iRecvBufSize];
+
+            const io_uring_recvmsg_out* pOut = reinterpret_cast<const io_uring_recvmsg_out*> ( pbyBuf );
+
+            const int iPayloadOffset = static_cast<int> ( sizeof ( io_uring_recvmsg_out ) +
+                                                          RecvMsgHdr.msg_namelen +
+                                                          RecvMsgHdr.msg_controllen );
+
+            // the payload is copied in the packet slot so that the buffer can
+            // be provided to the kernel again immediately
+            if ( ( pCqe->res > 0 ) &&
+                 ( pOut->namelen >= sizeof ( sockaddr_in ) ) &&
+                 ( pOut->namelen <= sizeof ( USockAddr ) ) &&
+                 !( pOut->flags & MSG_TRUNC ) &&
+                 ( pOut->payloadlen > 0 ) &&
+                 ( static_cast<int> ( pOut->payloadlen ) <= MAX_SIZE_BYTES_NETW_BUF ) )
+            {
+                STransportRecPacket& Packet = pPackets[iNumPackets];
+
+                memcpy ( &Packet.Addr, pbyBuf + sizeof ( io_uring_recvmsg_out ), pOut->namelen );
+                memcpy ( &vecvecbyRecBuf[iNumPackets][0], pbyBuf + iPayloadOffset, pOut->payloadlen );
+
+                Packet.pvecbyBuf   = &vecvecbyRecBuf[iNumPackets];
+                Packet.iNumBytes   = static_cast<int> ( pOut->payloadlen );
+                Packet.iChanIDHint = INVALID_INDEX;
+                Packet.iRecTimeNs  = 0;
+
+#ifdef USE_SO_TIMESTAMPNS
+                if ( bRecvTimestamps && ( pOut->controllen > 0 ) )
+                {
+                    // the control data follows the address in the buffer
+                    msghdr ControlMsg;
+                    memset ( &ControlMsg, 0, sizeof ( ControlMsg ) );
+                    ControlMsg.msg_control    = const_cast<uint8_t*> ( pbyBuf + sizeof ( io_uring_recvmsg_out ) + RecvMsgHdr.msg_namelen );
+                    ControlMsg.msg_controllen = pOut->controllen;
+
+                    Packet.iRecTimeNs = GetRecvTimestamp ( ControlMsg );
+                }
+#endif
+
+                iNumPackets++;
+            }
+
+            ProvideRecvBuffer ( iBufID );
+        }
+
+        RecvRing.CqeSeen();
+    }
+
+    return iNumPackets;
+}
+
+void CIoUringSocketTransport::Send ( const uint8_t*   pbyData,
+                                     const int        iNumBytes,
+                                     const USockAddr& Addr )
+{
+    // the send ring is only used by the batch send, a single packet which may
+    // be sent by any thread uses the thread safe system call
+    sendto ( Socket,
+             (const char*) pbyData,
+             iNumBytes,
+             0,
+             &Addr.Addr,
+             GetSockAddrLen ( Addr ) );
+}
+
+void CIoUringSocketTransport::SendBatch ( const STransportSendPacket* pPackets,
+                                          const int                   iNumPackets )
+{
+#ifdef USE_SO_TXTIME
+    // the departure times of the batch are relative to this call
+    const uint64_t iStartTimeNs = bPacing ? GetTxTimeNow() : 0;
+#endif
+
+    for ( int iChunkStart = 0; iChunkStart < iNumPackets; iChunkStart += NUM_IO_URING_SEND_ENTRIES )
+    {
+        const int iNumMsgs = std::min ( NUM_IO_URING_SEND_ENTRIES, iNumPackets - iChunkStart );
+        int       iNumSqes = 0;
+
+        for ( int i = 0; i < iNumMsgs; i++ )
+        {
+            io_uring_sqe* pSqe = SendRing.GetSqe();
+
+            if ( pSqe == nullptr )
+            {
+                break;
+            }
+
+            const STransportSendPacket& Packet = pPackets[iChunkStart + i];
+
+            vecSendIov[i].iov_base = const_cast<uint8_t*> ( Packet.pbyData );
+            vecSendIov[i].iov_len  = static_cast<size_t> ( Packet.iNumBytes );
+
+            memset ( &vecSendMsgs[i], 0, sizeof ( msghdr ) );
+            vecSendMsgs[i].msg_name    = const_cast<USockAddr*> ( Packet.pAddr );
+            vecSendMsgs[i].msg_namelen = static_cast<socklen_t> ( GetSockAddrLen ( *Packet.pAddr ) );
+            vecSendMsgs[i].msg_iov     = &vecSendIov[i];
+            vecSendMsgs[i].msg_iovlen  = 1;
+
+#ifdef USE_SO_TXTIME
+            if ( bPacing )
+            {
+                SetTxTime ( vecSendMsgs[i], &vecbySendControl[i * TXTIME_CONTROL_SIZE], iStartTimeNs + Packet.iTxOffsetNs );
+            }
+#endif
+
+            pSqe->opcode = IORING_OP_SENDMSG;
+            pSqe->fd     = Socket;
+            pSqe->addr   = reinterpret_cast<uint64_t> ( &vecSendMsgs[i] );
+            pSqe->len    = 1;
+
+            iNumSqes++;
+        }
+
+        // one system call submits all packets, the call returns after all
+        // sends are completed since the packet buffers are reused by the
+        // caller (failed sends are dropped like lost packets)
+        int iNumCompleted = 0;
+
+        while ( iNumCompleted < iNumSqes )
+        {
+            if ( !SendRing.Submit ( static_cast<unsigned int> ( iNumSqes - iNumCompleted ) ) &&
+                 ( errno != EINTR ) )
+            {
+                break;
+            }
+
+            while ( SendRing.PeekCqe() != nullptr )
+            {
+                SendRing.CqeSeen();
+                iNumCompleted++;
+            }
+        }
+    }
+}
+#endif
@@ -0,0 +1,413 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <algorithm>
+#include "global.h"
+#include "util.h"
+#ifdef _WIN32
+# include <ws2tcpip.h>
+#else
+# include <netinet/in.h>
+# include <netinet/ip.h>
+# include <sys/socket.h>
+#endif
+#if defined ( __linux__ ) && !defined ( ANDROID )
+# include <sys/epoll.h>
+# include <time.h>
+# if defined ( __has_include )
+#  if __has_include ( <linux/io_uring.h> )
+#   include <linux/io_uring.h>
+#  endif
+#  if __has_include ( <linux/net_tstamp.h> )
+#   include <linux/net_tstamp.h>
+#  endif
+# endif
+#endif
+
+
+/* Definitions ****************************************************************/
+// on Linux we receive multiple packets with one system call
+#if defined ( __linux__ ) && !defined ( ANDROID )
+# define USE_RECVMMSG
+#endif
+
+// number of packets which can be received with one system call
+#define NUM_SOCKET_RECV_BATCH_SLOTS     16
+
+// on Linux we send the queued packets with one system call
+#if defined ( __linux__ ) && !defined ( ANDROID )
+# define USE_SENDMMSG
+#endif
+
+// on Linux the server can open a connected socket per client on the server
+// port, the kernel then delivers the packets of the client directly to this
+// socket and the receive thread waits on all of its sockets with epoll
+#if defined ( __linux__ ) && !defined ( ANDROID )
+# define USE_CONNECTED_CHANNEL_SOCKETS
+#endif
+
+// interval in which the connected sockets of disconnected clients are closed
+// (a receive call returns at least once per interval if they are used)
+#define CONN_SOCKET_CLEANUP_INTERVAL_MS 1000
+
+// on Linux the io_uring transport can be used if the kernel headers support
+// the multishot receive (the system calls are used directly, i.e. no library
+// is required, and on an older kernel the BSD transport is used instead)
+#if defined ( __linux__ ) && !defined ( ANDROID ) && defined ( IORING_RECV_MULTISHOT )
+# define USE_IO_URING
+#endif
+
+// on Linux the packets of a send batch can get departure times (SO_TXTIME)
+// which are kept by the fq qdisc of the network interface, i.e. the packets
+// of a frame are paced by the kernel instead of leaving in one burst
+#if defined ( __linux__ ) && !defined ( ANDROID ) && defined ( SO_TXTIME )
+# define USE_SO_TXTIME
+
+// size of the control data of a message with a departure time
+# define TXTIME_CONTROL_SIZE            CMSG_SPACE ( sizeof ( uint64_t ) )
+#endif
+
+// on Linux the kernel stores the receive time of each packet (SO_TIMESTAMPNS),
+// i.e. the arrival time does not include the wake-up of the receive thread
+#if defined ( __linux__ ) && !defined ( ANDROID ) && defined ( SO_TIMESTAMPNS )
+# define USE_SO_TIMESTAMPNS
+
+// size of the control data of a received message with the receive time
+# define RECV_TIMESTAMP_CONTROL_SIZE    CMSG_SPACE ( sizeof ( timespec ) )
+#else
+# define RECV_TIMESTAMP_CONTROL_SIZE    0
+#endif
+
+// a receive time which is older than this is not used (e.g. after a step of
+// the system clock)
+#define MAX_RECV_TIMESTAMP_DELAY_NS     1000000000
+
+// number of provided receive buffers and maximum number of packets per send
+// submission of the io_uring transport
+#define NUM_IO_URING_RECV_BUFFERS       256
+#define NUM_IO_URING_SEND_ENTRIES       512
+
+// the receive wait of the io_uring transport returns after this time so that
+// the receive thread can be stopped
+#define IO_URING_RECV_TIMEOUT_MS        200
+
+
+/* Classes ********************************************************************/
+#ifdef _WIN32
+typedef SOCKET TSocketHandle;
+#else
+typedef int    TSocketHandle;
+#endif
+
+enum ETransportBackend
+{
+    TB_BSD_SOCKETS = 0, // default
+    TB_IO_URING    = 1
+};
+
+// socket address of an IPv4 or IPv6 socket (the sockets are dual-stack IPv6
+// sockets if the system supports IPv6, then the IPv4 addresses are IPv4-mapped
+// IPv6 addresses)
+union USockAddr
+{
+    sockaddr     Addr;
+    sockaddr_in  In4;
+    sockaddr_in6 In6;
+};
+
+inline int GetSockAddrLen ( const USockAddr& SockAddr )
+{
+    return SockAddr.Addr.sa_family == AF_INET6 ? static_cast<int> ( sizeof ( sockaddr_in6 ) )
+                                               : static_cast<int> ( sizeof ( sockaddr_in ) );
+}
+
+// a received packet, the buffer belongs to the transport and is valid until
+// the next receive call
+struct STransportRecPacket
+{
+    CVector<uint8_t>* pvecbyBuf;
+    int               iNumBytes;
+    USockAddr         Addr;
+    int               iChanIDHint; // channel of a connected socket or INVALID_INDEX
+    qint64            iRecTimeNs;  // kernel receive time (system clock) or zero
+};
+
+// a packet of a send batch (the data is owned by the caller)
+struct STransportSendPacket
+{
+    const uint8_t*   pbyData;
+    int              iNumBytes;
+    const USockAddr* pAddr;
+    int              iTxOffsetNs; // departure time after the batch send call (pacing only)
+};
+
+// Interface of the packet I/O underneath CSocket. The socket creates and binds
+// the UDP socket and the transport does the receive and send calls on it, so a
+// backend with another kernel interface can be used without changing the
+// packet processing.
+class CSocketTransport
+{
+public:
+    CSocketTransport ( const TSocketHandle NSocket ) : Socket ( NSocket ), bPacing ( false ), bRecvTimestamps ( false ) {}
+    virtual ~CSocketTransport() {}
+
+    // the backend which is used for the sockets created after this call (if
+    // the backend is not available, the BSD transport is used)
+    static void SetBackend ( const ETransportBackend eNBackend ) { eBackend = eNBackend; }
+
+    static CSocketTransport* Create ( const TSocketHandle Socket );
+
+    virtual QString GetName() const = 0;
+
+    // blocks until at least one packet is received, returns the number of
+    // packets (zero or negative on a timeout, an error or a closed socket),
+    // only called by the receive thread
+    virtual int Receive ( STransportRecPacket* pPackets,
+                          const int            iMaxNumPackets ) = 0;
+
+    // sends a single packet, may be called from multiple threads at the same
+    // time
+    virtual void Send ( const uint8_t*     pbyData,
+                        const int          iNumBytes,
+                        const USockAddr&   Addr ) = 0;
+
+    // sends a single packet with another IP TOS byte than the one of the
+    // socket (if this is not supported, the packet gets the TOS of the socket)
+    virtual void SendWithTos ( const uint8_t*     pbyData,
+                               const int          iNumBytes,
+                               const USockAddr&   Addr,
+                               const int          iTos );
+
+    // sends the packets of a batch (not called concurrently to itself)
+    virtual void SendBatch ( const STransportSendPacket* pPackets,
+                             const int                   iNumPackets ) = 0;
+
+    // the packets of the send batches are sent at their departure times
+    // (needs the fq qdisc on the network interface, otherwise the times are
+    // ignored), returns false if this is not supported
+    bool EnablePacing();
+    bool IsPacingEnabled() const { return bPacing; }
+
+    // the received packets get the receive time of the kernel, returns false
+    // if this is not supported (the receive time of the packets is zero then)
+    bool EnableRecvTimestamps();
+
+    // time since the kernel has received a packet with the given receive
+    // time, zero if the receive time is unknown
+    static int GetRecvDelayNs ( const qint64 iRecTimeNs );
+
+    // optional connected sockets per channel on the given server port (the
+    // functions are only called by the receive thread)
+    virtual bool EnableChannelSockets ( const quint16 ) { return false; }
+
+    virtual bool OpenChannelSocket ( const int,
+                                     const USockAddr& ) { return false; }
+
+    virtual void CloseChannelSocket ( const int ) {}
+
+protected:
+#ifdef USE_SO_TXTIME
+    // sets the departure time of the message in the given control buffer
+    static void SetTxTime ( msghdr&        Msg,
+                            uint8_t*       pbyControl,
+                            const uint64_t iTxTimeNs );
+
+    static uint64_t GetTxTimeNow();
+#endif
+
+#ifdef USE_SO_TIMESTAMPNS
+    // the receive time of the control data of a received message (zero if the
+    // message has no receive time)
+    static qint64 GetRecvTimestamp ( msghdr& Msg );
+#endif
+
+    TSocketHandle Socket;
+    bool          bPacing;
+    bool          bRecvTimestamps;
+
+    static ETransportBackend eBackend;
+};
+
+// the default transport with the BSD socket calls (recvmmsg/sendmmsg on Linux)
+class CBsdSocketTransport : public CSocketTransport
+{
+public:
+    CBsdSocketTransport ( const TSocketHandle NSocket );
+    virtual ~CBsdSocketTransport();
+
+    virtual QString GetName() const { return "bsd"; }
+
+    virtual int Receive ( STransportRecPacket* pPackets,
+                          const int            iMaxNumPackets );
+
+    virtual void Send ( const uint8_t*     pbyData,
+                        const int          iNumBytes,
+                        const USockAddr&   Addr );
+
+    virtual void SendBatch ( const STransportSendPacket* pPackets,
+                             const int                   iNumPackets );
+
+#ifdef USE_CONNECTED_CHANNEL_SOCKETS
+    virtual bool EnableChannelSockets ( const quint16 iNPort );
+
+    virtual bool OpenChannelSocket ( const int          iChanID,
+                                     const USockAddr&   ClientAddr );
+
+    virtual void CloseChannelSocket ( const int iChanID );
+#endif
+
+protected:
+#ifdef USE_RECVMMSG
+    // reads the available packets of the socket in the slots starting at
+    // iFirstSlot and returns the number of packets
+    int ReceiveBatch ( const int            iSocket,
+                       const int            iFlags,
+                       const int            iChanIDHint,
+                       const int            iFirstSlot,
+                       const int            iMaxNumSlots,
+                       STransportRecPacket* pPackets );
+#endif
+
+    // preallocated packet slots for the receive
+    CVector<CVector<uint8_t> > vecvecbyRecBuf;
+
+#ifdef USE_RECVMMSG
+    CVector<mmsghdr>           vecRecMsgs;
+    CVector<iovec>             vecRecIov;
+    CVector<USockAddr>         vecRecAddr;
+# ifdef USE_SO_TIMESTAMPNS
+    CVector<uint8_t>           vecbyRecControl;
+# endif
+#endif
+
+#ifdef USE_CONNECTED_CHANNEL_SOCKETS
+    // the shared socket and the connected sockets of the channels (-1: no
+    // socket) are registered in the epoll instance, the event data is the
+    // channel ID plus one (i.e. zero is the shared socket)
+    int                        iEpollFd;
+    quint16                    iPort;
+    CVector<int>               vecChanSockets;
+#endif
+};
+
+#ifdef USE_IO_URING
+// minimal io_uring instance which is only used by a single thread
+class CIoUring
+{
+public:
+    CIoUring();
+    virtual ~CIoUring();
+
+    bool Init ( const unsigned int iNumEntries );
+
+    int GetFd() const { return iFd; }
+
+    // returns nullptr if the submission queue is full
+    io_uring_sqe* GetSqe();
+
+    // submits the prepared entries and waits for the given number of
+    // completions (with an optional timeout), returns false on an error
+    bool Submit ( const unsigned int iMinComplete,
+                  const int          iTimeoutMs = -1 );
+
+    // returns nullptr if no completion is available, each completion must be
+    // released with CqeSeen()
+    io_uring_cqe* PeekCqe();
+    void          CqeSeen();
+
+protected:
+    int           iFd;
+    void*         pRing;
+    size_t        iRingSize;
+    void*         pCqRing;
+    size_t        iCqRingSize;
+    io_uring_sqe* pSqes;
+    size_t        iSqesSize;
+
+    unsigned int* piSqHead;
+    unsigned int* piSqTail;
+    unsigned int  iSqMask;
+    unsigned int  iSqNumEntries;
+    unsigned int  iNumToSubmit;
+    unsigned int* piCqHead;
+    unsigned int* piCqTail;
+    unsigned int  iCqMask;
+    io_uring_cqe* pCqes;
+};
+
+// transport with io_uring: a multishot recvmsg with a ring of provided buffers
+// for the receive and all packets of a send batch with one submission
+class CIoUringSocketTransport : public CSocketTransport
+{
+public:
+    CIoUringSocketTransport ( const TSocketHandle NSocket );
+    virtual ~CIoUringSocketTransport();
+
+    // returns false if io_uring is not supported by the kernel
+    bool Init();
+
+    virtual QString GetName() const { return "io_uring"; }
+
+    virtual int Receive ( STransportRecPacket* pPackets,
+                          const int            iMaxNumPackets );
+
+    virtual void Send ( const uint8_t*     pbyData,
+                        const int          iNumBytes,
+                        const USockAddr&   Addr );
+
+    virtual void SendBatch ( const STransportSendPacket* pPackets,
+                             const int                   iNumPackets );
+
+protected:
+    bool ArmReceive();
+    void ProvideRecvBuffer ( const int iBufID );
+
+    // receive ring (receive thread) and send ring (thread of the batch send)
+    CIoUring                   RecvRing;
+    CIoUring                   SendRing;
+
+    // the provided receive buffers contain the recvmsg header, the sender
+    // address and the payload which is copied in the packet slots
+    // (the ring is accessed as an array of the buffer entries since the flex
+    // array of the kernel header has another offset in C++, the ring tail
+    // overlays the reserved field of the first entry)
+    io_uring_buf*              pRecvBufRing;
+    size_t                     iRecvBufRingSize;
+    int                        iRecvBufSize;
+    CVector<uint8_t>           vecbyRecvBufPool;
+    msghdr                     RecvMsgHdr;
+    bool                       bRecvArmed;
+    CVector<CVector<uint8_t> > vecvecbyRecBuf;
+
+    // message headers of the send batch
+    CVector<msghdr>            vecSendMsgs;
+    CVector<iovec>             vecSendIov;
+#ifdef USE_SO_TXTIME
+    CVector<uint8_t>           vecbySendControl;
+#endif
+};
+#endif
@@ -23,6 +23,11 @@
 \******************************************************************************/
 
 #include "soundbase.h"
+#include "mixkernel.h"
+#include <cstring>
+#include <climits>
+#include <cmath>
+#include <algorithm>
 
 
 /* Implementation *************************************************************/
@@ -32,7 +37,8 @@ CSoundBase::CSoundBase ( const QString& strNewSystemDriverTechniqueName,
                          void*          pParg,
                          const int      iNewCtrlMIDIChannel ) :
     fpProcessCallback            ( fpNewProcessCallback ),
-    pProcessCallbackArg          ( pParg ), bRun ( false ),
+    pProcessCallbackArg          ( pParg ),
+    fpProcessCallbackFloat       ( nullptr ), bRun ( false ),
     bIsCallbackAudioInterface    ( bNewIsCallbackAudioInterface ),
     strSystemDriverTechniqueName ( strNewSystemDriverTechniqueName ),
     iCtrlMIDIChannel             ( iNewCtrlMIDIChannel )
@@ -41,8 +47,23 @@ CSoundBase::CSoundBase ( const QString& strNewSystemDriverTechniqueName,
     lNumDevs          = 1;
     strDriverNames[0] = strSystemDriverTechniqueName;
 
+    // the timer is only used for time differences, it is never restarted
+    TimingTimer.start();
+    ResetTimingStats();
+
     // set current device
     lCurDev = 0; // default device
+
+    // the MIDI messages are evaluated in the main thread
+    if ( iCtrlMIDIChannel != INVALID_MIDI_CH )
+    {
+        MIDIEventFifo.Init ( MIDI_EVENT_FIFO_NUM_EVENTS * MIDI_EVENT_SIZE_BYTES );
+
+        QObject::connect ( &TimerMIDIEvents, &QTimer::timeout,
+            this, &CSoundBase::OnTimerMIDIEvents );
+
+        TimerMIDIEvents.start ( MIDI_EVENT_INTERVAL_MS );
+    }
 }
 
 int CSoundBase::Init ( const int iNewPrefMonoBufferSize )
@@ -58,6 +79,14 @@ int CSoundBase::Init ( const int iNewPrefMonoBufferSize )
 
 void CSoundBase::Start()
 {
+    // the statistics are reset before the callback is enabled
+    ResetTimingStats();
+
+    if ( RateConv.IsEnabled() )
+    {
+        RateConv.Reset();
+    }
+
     bRun = true;
 
 // TODO start audio interface
@@ -82,6 +111,470 @@ void CSoundBase::Stop()
     }
 }
 
+// Sound card bridge ------------------------------------------------------------
+void CSndCrdBridge::Start ( const int iNewMonoBlockSize )
+{
+    if ( isRunning() || ( iNewMonoBlockSize <= 0 ) )
+    {
+        return;
+    }
+
+    iMonoBlockSize = iNewMonoBlockSize;
+    vecfSilence.Init ( 2 * iMonoBlockSize /* stereo */ );
+
+    bRun.storeRelease ( 1 );
+    start ( QThread::TimeCriticalPriority );
+}
+
+void CSndCrdBridge::Stop()
+{
+    bRun.storeRelease ( 0 );
+    wait();
+}
+
+void CSndCrdBridge::run()
+{
+    QElapsedTimer Timer;
+    Timer.start();
+
+    const qint64 iBlockDurNs = static_cast<qint64> ( iMonoBlockSize ) * 1000000000 / SYSTEM_SAMPLE_RATE_HZ;
+
+    // the first block is due after one block duration, in the meantime a last
+    // callback of the stopped sound card is finished
+    qint64 iNextBlockNs = iBlockDurNs;
+
+    while ( bRun.loadAcquire() )
+    {
+        if ( Timer.nsecsElapsed() - iNextBlockNs > SND_CRD_BRIDGE_MAX_LATE_BLOCKS * iBlockDurNs )
+        {
+            iNextBlockNs = Timer.nsecsElapsed();
+        }
+
+        while ( bRun.loadAcquire() && ( Timer.nsecsElapsed() >= iNextBlockNs ) )
+        {
+            // the processing writes the output in the buffer
+            vecfSilence.Reset ( 0 );
+            (*fpProcessCallback) ( vecfSilence, pProcessCallbackArg );
+
+            iNextBlockNs += iBlockDurNs;
+        }
+
+        msleep ( SND_CRD_BRIDGE_SLEEP_TIME_MS );
+    }
+}
+
+
+// Sample rate conversion -------------------------------------------------------
+static double BesselI0 ( const double dX )
+{
+    // power series of the modified Bessel function of the first kind (used
+    // for the Kaiser window)
+    double dSum  = 1.0;
+    double dTerm = 1.0;
+
+    for ( int k = 1; ( k < 100 ) && ( dTerm > 1e-12 * dSum ); k++ )
+    {
+        const double dFact = dX / ( 2 * k );
+
+        dTerm *= dFact * dFact;
+        dSum  += dTerm;
+    }
+
+    return dSum;
+}
+
+bool CSndCrdResampler::Init ( const int iNewInRate,
+                              const int iNewOutRate,
+                              const int iNewMaxInFrames )
+{
+    const double dPi = 3.14159265358979323846;
+
+    // reduce the rate ratio to get the number of filter phases
+    int iGcd = iNewInRate;
+    int iRem = iNewOutRate;
+
+    while ( iRem != 0 )
+    {
+        const int iTmp = iGcd % iRem;
+
+        iGcd = iRem;
+        iRem = iTmp;
+    }
+
+    if ( ( iNewInRate <= 0 ) || ( iNewOutRate <= 0 ) ||
+         ( iNewOutRate / iGcd > SND_CRD_RESAMPLER_MAX_NUM_PHASES ) )
+    {
+        return false;
+    }
+
+    iInterpol    = iNewOutRate / iGcd;
+    iDecim       = iNewInRate / iGcd;
+    iInRate      = iNewInRate;
+    iMaxInFrames = iNewMaxInFrames;
+
+    // Kaiser windowed sinc lowpass at the interpolated rate, the cutoff is
+    // given by the lower of both rates (anti-imaging and anti-aliasing)
+    const int    iLen    = iInterpol * SND_CRD_RESAMPLER_NUM_TAPS;
+    const double dCenter = ( iLen - 1 ) / 2.0;
+    const double dCutoff = SND_CRD_RESAMPLER_CUTOFF * std::min ( iNewInRate, iNewOutRate ) /
+                           ( static_cast<double> ( iNewInRate ) * iInterpol );
+
+    CVector<double> vecdProto ( iLen );
+
+    for ( int i = 0; i < iLen; i++ )
+    {
+        const double dT = i - dCenter;
+        const double dX = 2.0 * i / ( iLen - 1 ) - 1.0;
+
+        const double dSinc = ( std::fabs ( dT ) < 1e-9 ) ? 2 * dCutoff :
+                             std::sin ( 2 * dPi * dCutoff * dT ) / ( dPi * dT );
+
+        vecdProto[i] = dSinc * BesselI0 ( SND_CRD_RESAMPLER_KAISER_BETA * std::sqrt ( std::max ( 0.0, 1.0 - dX * dX ) ) );
+    }
+
+    // split the prototype in the phases, each phase is normalized to unity
+    // gain at DC so that there is no modulation of the output level, the
+    // coefficients are reversed to run over the history in forward direction
+    // and duplicated for the two channels of the interleaved buffer
+    vecfCoeff.Init ( 2 * iLen );
+
+    for ( int iP = 0; iP < iInterpol; iP++ )
+    {
+        double dSum = 0.0;
+
+        for ( int k = 0; k < SND_CRD_RESAMPLER_NUM_TAPS; k++ )
+        {
+            dSum += vecdProto[k * iInterpol + iP];
+        }
+
+        for ( int k = 0; k < SND_CRD_RESAMPLER_NUM_TAPS; k++ )
+        {
+            const int   iIdx   = 2 * ( iP * SND_CRD_RESAMPLER_NUM_TAPS + SND_CRD_RESAMPLER_NUM_TAPS - 1 - k );
+            const float fCoeff = static_cast<float> ( vecdProto[k * iInterpol + iP] / dSum );
+
+            vecfCoeff[iIdx]     = fCoeff;
+            vecfCoeff[iIdx + 1] = fCoeff;
+        }
+    }
+
+    vecfHist.Init ( 2 * ( SND_CRD_RESAMPLER_NUM_TAPS + iMaxInFrames ) );
+    Reset();
+
+    return true;
+}
+
+void CSndCrdResampler::Reset()
+{
+    // the history starts with silence so that the first output frame only
+    // requires one input frame
+    vecfHist.Reset ( 0 );
+
+    iPhase         = 0;
+    iPos           = 0;
+    iNumHistFrames = SND_CRD_RESAMPLER_NUM_TAPS - 1;
+}
+
+int CSndCrdResampler::Process ( const float* pfIn,
+                                const int    iNumInFrames,
+                                float*       pfOut,
+                                const int    iMaxNumOutFrames )
+{
+    const int iNumFrames = std::min ( iNumInFrames, vecfHist.Size() / 2 - iNumHistFrames );
+
+    if ( iNumFrames > 0 )
+    {
+        memcpy ( &vecfHist[2 * iNumHistFrames], pfIn, sizeof ( float ) * 2 * iNumFrames );
+        iNumHistFrames += iNumFrames;
+    }
+
+    // output frame j takes the input frames up to floor ( j * M / L ) with
+    // the filter phase ( j * M ) mod L
+    int iNumOutFrames = 0;
+
+    while ( ( iPos + SND_CRD_RESAMPLER_NUM_TAPS <= iNumHistFrames ) && ( iNumOutFrames < iMaxNumOutFrames ) )
+    {
+        CMixKernel::DotProductStereo ( &vecfHist[2 * iPos],
+                                       &vecfCoeff[2 * iPhase * SND_CRD_RESAMPLER_NUM_TAPS],
+                                       pfOut[2 * iNumOutFrames],
+                                       pfOut[2 * iNumOutFrames + 1],
+                                       SND_CRD_RESAMPLER_NUM_TAPS );
+
+        iNumOutFrames++;
+        iPhase += iDecim;
+        iPos   += iPhase / iInterpol;
+        iPhase %= iInterpol;
+    }
+
+    // only keep the frames which are required for the next output frames
+    const int iShift = std::min ( iPos, iNumHistFrames );
+
+    if ( iShift > 0 )
+    {
+        memmove ( &vecfHist[0], &vecfHist[2 * iShift], sizeof ( float ) * 2 * ( iNumHistFrames - iShift ) );
+        iNumHistFrames -= iShift;
+        iPos           -= iShift;
+    }
+
+    return iNumOutFrames;
+}
+
+int CSndCrdResampler::GetNumInFramesRequired ( const int iNumOutFrames ) const
+{
+    if ( iNumOutFrames <= 0 )
+    {
+        return 0;
+    }
+
+    // the last output frame must have all filter taps in the history
+    const int iLastPos = iPos + ( iPhase + ( iNumOutFrames - 1 ) * iDecim ) / iInterpol;
+
+    return std::max ( 0, iLastPos + SND_CRD_RESAMPLER_NUM_TAPS - iNumHistFrames );
+}
+
+double CSndCrdResampler::GetDelayMs() const
+{
+    // group delay of the linear phase prototype filter at the interpolated rate
+    return ( iInterpol * SND_CRD_RESAMPLER_NUM_TAPS - 1 ) * 1000.0 /
+           ( 2.0 * iInterpol * iInRate );
+}
+
+bool CSndCrdRateConv::Init ( const int iNewSndCrdSampleRate,
+                             const int iNewSndCrdMaxFrames,
+                             const int iNewMonoBlockSize )
+{
+    bIsEnabled = false;
+
+    if ( ( iNewMonoBlockSize <= 0 ) ||
+         !InResampler.Init ( iNewSndCrdSampleRate, SYSTEM_SAMPLE_RATE_HZ, iNewSndCrdMaxFrames ) )
+    {
+        return false;
+    }
+
+    // the output resampler is used in pull mode, it never requires more than
+    // the converted frames of one sound card block plus a filter length
+    const int iMaxConvFrames = InResampler.GetMaxNumOutFrames ( iNewSndCrdMaxFrames ) + SND_CRD_RESAMPLER_NUM_TAPS;
+
+    if ( !OutResampler.Init ( SYSTEM_SAMPLE_RATE_HZ, iNewSndCrdSampleRate, iMaxConvFrames ) )
+    {
+        return false;
+    }
+
+    iMonoBlockSize = iNewMonoBlockSize;
+
+    vecfInFifo.Init  ( 2 * ( iMonoBlockSize + iMaxConvFrames ) );
+    vecfOutFifo.Init ( 2 * ( 3 * iMonoBlockSize + iMaxConvFrames ) );
+
+    Reset();
+    bIsEnabled = true;
+
+    return true;
+}
+
+void CSndCrdRateConv::Reset()
+{
+    InResampler.Reset();
+    OutResampler.Reset();
+
+    // The converted input frames are processed as soon as a block is complete,
+    // i.e. up to one block minus one frame waits in the input buffer. The
+    // output buffer starts with one block of silence (plus the rounding of the
+    // resamplers) so that it never runs empty, the sum of both fill levels is
+    // constant.
+    iNumInFifoFrames  = 0;
+    iNumOutFifoFrames = iMonoBlockSize + SND_CRD_RESAMPLER_FIFO_MARGIN;
+    vecfOutFifo.Reset ( 0 );
+}
+
+double CSndCrdRateConv::GetDelayMs() const
+{
+    return InResampler.GetDelayMs() + OutResampler.GetDelayMs() +
+           ( iMonoBlockSize + SND_CRD_RESAMPLER_FIFO_MARGIN ) * 1000.0 / SYSTEM_SAMPLE_RATE_HZ;
+}
+
+void CSndCrdRateConv::PutInput ( const float* pfIn,
+                                 const int    iNumFrames )
+{
+    iNumInFifoFrames += InResampler.Process ( pfIn,
+                                              iNumFrames,
+                                              &vecfInFifo[2 * iNumInFifoFrames],
+                                              vecfInFifo.Size() / 2 - iNumInFifoFrames );
+}
+
+bool CSndCrdRateConv::GetInputBlock ( CVector<float>& vecfBlock )
+{
+    if ( iNumInFifoFrames < iMonoBlockSize )
+    {
+        return false;
+    }
+
+    memcpy ( &vecfBlock[0], &vecfInFifo[0], sizeof ( float ) * 2 * iMonoBlockSize );
+
+    iNumInFifoFrames -= iMonoBlockSize;
+    memmove ( &vecfInFifo[0], &vecfInFifo[2 * iMonoBlockSize], sizeof ( float ) * 2 * iNumInFifoFrames );
+
+    return true;
+}
+
+void CSndCrdRateConv::PutOutputBlock ( const CVector<float>& vecfBlock )
+{
+    const int iNumFrames = std::min ( iMonoBlockSize, vecfOutFifo.Size() / 2 - iNumOutFifoFrames );
+
+    memcpy ( &vecfOutFifo[2 * iNumOutFifoFrames], &vecfBlock[0], sizeof ( float ) * 2 * iNumFrames );
+    iNumOutFifoFrames += iNumFrames;
+}
+
+void CSndCrdRateConv::GetOutput ( float*    pfOut,
+                                  const int iNumFrames )
+{
+    const int iNumRequired = std::min ( OutResampler.GetNumInFramesRequired ( iNumFrames ),
+                                        vecfOutFifo.Size() / 2 );
+
+    // this should not happen since both directions are clocked by the sound
+    // card, the missing frames are replaced by silence
+    if ( iNumOutFifoFrames < iNumRequired )
+    {
+        memset ( &vecfOutFifo[2 * iNumOutFifoFrames], 0, sizeof ( float ) * 2 * ( iNumRequired - iNumOutFifoFrames ) );
+        iNumOutFifoFrames = iNumRequired;
+    }
+
+    const int iNumOutFrames = OutResampler.Process ( &vecfOutFifo[0], iNumRequired, pfOut, iNumFrames );
+
+    if ( iNumOutFrames < iNumFrames )
+    {
+        memset ( &pfOut[2 * iNumOutFrames], 0, sizeof ( float ) * 2 * ( iNumFrames - iNumOutFrames ) );
+    }
+
+    iNumOutFifoFrames -= iNumRequired;
+    memmove ( &vecfOutFifo[0], &vecfOutFifo[2 * iNumRequired], sizeof ( float ) * 2 * iNumOutFifoFrames );
+}
+
+bool CSoundBase::InitRateConv ( const int iSndCrdSampleRate,
+                                const int iSndCrdMaxFrames,
+                                const int iMonoBlockSize )
+{
+    if ( !RateConv.Init ( iSndCrdSampleRate, iSndCrdMaxFrames, iMonoBlockSize ) )
+    {
+        return false;
+    }
+
+    vecfRateConvBlock.Init ( 2 * iMonoBlockSize /* stereo */ );
+    vecsRateConvBlock.Init ( 2 * iMonoBlockSize /* stereo */ );
+
+    return true;
+}
+
+void CSoundBase::ProcessCallbackRateConv ( float*    pfData,
+                                           const int iNumFrames )
+{
+    RateConv.PutInput ( pfData, iNumFrames );
+
+    // depending on the rate ratio, zero, one or more processing blocks are
+    // complete in this sound card block
+    while ( RateConv.GetInputBlock ( vecfRateConvBlock ) )
+    {
+        if ( HasProcessCallbackFloat() )
+        {
+            ProcessCallbackFloat ( vecfRateConvBlock );
+        }
+        else
+        {
+            CMixKernel::FloatNormToShort ( &vecfRateConvBlock[0], &vecsRateConvBlock[0], vecfRateConvBlock.Size() );
+            ProcessCallback ( vecsRateConvBlock );
+            CMixKernel::ShortToFloatNorm ( &vecsRateConvBlock[0], &vecfRateConvBlock[0], vecsRateConvBlock.Size() );
+        }
+
+        RateConv.PutOutputBlock ( vecfRateConvBlock );
+    }
+
+    RateConv.GetOutput ( pfData, iNumFrames );
+}
+
+
+void CSoundBase::ResetTimingStats()
+{
+    iLastCallbackStartNs = -1; // no callback yet
+    dAvProcTimeUs        = 0;
+
+    iTimingNumCallbacks.storeRelease  ( 0 );
+    iTimingNumOverruns.storeRelease   ( 0 );
+    iTimingPeriodUs.storeRelease      ( 0 );
+    iTimingAvProcTimeUs.storeRelease  ( 0 );
+    iTimingMaxProcTimeUs.storeRelease ( 0 );
+    iTimingMaxIntervalUs.storeRelease ( 0 );
+
+    for ( int i = 0; i < SND_CRD_TIMING_NUM_HIST_BINS; i++ )
+    {
+        iTimingIntervalHist[i].storeRelease ( 0 );
+    }
+}
+
+void CSoundBase::UpdateTimingStats ( const qint64 iStartNs,
+                                     const int    iNumFrames )
+{
+    const int iProcTimeUs = static_cast<int> ( ( TimingTimer.nsecsElapsed() - iStartNs ) / 1000 );
+    const int iPeriodUs   = static_cast<int> ( static_cast<qint64> ( iNumFrames ) * 1000000 / SYSTEM_SAMPLE_RATE_HZ );
+
+    // the processing must be finished within the period of the sound card
+    // block, otherwise the driver has to wait for us (or drops the block)
+    if ( iProcTimeUs > iPeriodUs )
+    {
+        iTimingNumOverruns.fetchAndAddRelaxed ( 1 );
+    }
+
+    if ( iTimingNumCallbacks.loadAcquire() == 0 )
+    {
+        dAvProcTimeUs = iProcTimeUs;
+    }
+    else
+    {
+        dAvProcTimeUs = SND_CRD_TIMING_AV_WEIGHT * dAvProcTimeUs +
+            ( 1.0 - SND_CRD_TIMING_AV_WEIGHT ) * iProcTimeUs;
+    }
+
+    iTimingPeriodUs.storeRelease     ( iPeriodUs );
+    iTimingAvProcTimeUs.storeRelease ( static_cast<int> ( dAvProcTimeUs ) );
+
+    if ( iProcTimeUs > iTimingMaxProcTimeUs.loadAcquire() )
+    {
+        iTimingMaxProcTimeUs.storeRelease ( iProcTimeUs );
+    }
+
+    // interval between the starts of two callbacks which should be one period
+    if ( ( iLastCallbackStartNs >= 0 ) && ( iPeriodUs > 0 ) )
+    {
+        const qint64 iIntervalUs = ( iStartNs - iLastCallbackStartNs ) / 1000;
+
+        // the bin is the interval in half periods, rounded to the next integer
+        const int iBin = static_cast<int> ( std::min<qint64> ( ( 4 * iIntervalUs + iPeriodUs ) / ( 2 * iPeriodUs ),
+                                                               SND_CRD_TIMING_NUM_HIST_BINS - 1 ) );
+
+        iTimingIntervalHist[iBin].fetchAndAddRelaxed ( 1 );
+
+        if ( iIntervalUs > iTimingMaxIntervalUs.loadAcquire() )
+        {
+            iTimingMaxIntervalUs.storeRelease ( static_cast<int> ( std::min<qint64> ( iIntervalUs, INT_MAX ) ) );
+        }
+    }
+
+    iLastCallbackStartNs = iStartNs;
+    iTimingNumCallbacks.fetchAndAddRelaxed ( 1 );
+}
+
+void CSoundBase::GetTimingStats ( CSndCrdTimingStats& TimingStats ) const
+{
+    TimingStats.iNumCallbacks  = iTimingNumCallbacks.loadAcquire();
+    TimingStats.iNumOverruns   = iTimingNumOverruns.loadAcquire();
+    TimingStats.iPeriodUs      = iTimingPeriodUs.loadAcquire();
+    TimingStats.iAvProcTimeUs  = iTimingAvProcTimeUs.loadAcquire();
+    TimingStats.iMaxProcTimeUs = iTimingMaxProcTimeUs.loadAcquire();
+    TimingStats.iMaxIntervalUs = iTimingMaxIntervalUs.loadAcquire();
+
+    for ( int i = 0; i < SND_CRD_TIMING_NUM_HIST_BINS; i++ )
+    {
+        TimingStats.veciIntervalHist[i] = iTimingIntervalHist[i].loadAcquire();
+    }
+}
+
 void CSoundBase::run()
 {
     // main loop of working thread
@@ -91,7 +584,7 @@ void CSoundBase::run()
         Read ( vecsAudioSndCrdStereo );
 
         // process audio data
-        (*fpProcessCallback) ( vecsAudioSndCrdStereo, pProcessCallbackArg );
+        ProcessCallback ( vecsAudioSndCrdStereo );
 
         // play the new block
         Write ( vecsAudioSndCrdStereo );
@@ -262,11 +755,54 @@ QVector<QString> CSoundBase::LoadAndInitializeFirstValidDriver ( const bool bOpe
 /******************************************************************************\
 * MIDI handling                                                                *
 \******************************************************************************/
-void CSoundBase::ParseMIDIMessage ( const CVector<uint8_t>& vMIDIPaketBytes )
+void CSoundBase::PutMIDIMessage ( const uint8_t* pbyMIDIPaketBytes,
+                                  const int      iNumBytes )
+{
+    // only channel messages are evaluated, these have up to three bytes
+    if ( ( iNumBytes > 0 ) && ( MIDIEventFifo.GetSize() > 0 ) )
+    {
+        uint8_t vbyEvent[MIDI_EVENT_SIZE_BYTES] = { 0, 0, 0, 0 };
+        const int iNumEventBytes = std::min ( iNumBytes, MIDI_EVENT_SIZE_BYTES - 1 );
+
+        vbyEvent[0] = static_cast<uint8_t> ( iNumEventBytes );
+        std::copy ( pbyMIDIPaketBytes, pbyMIDIPaketBytes + iNumEventBytes, &vbyEvent[1] );
+
+        MIDIEventFifo.Put ( vbyEvent, MIDI_EVENT_SIZE_BYTES );
+    }
+}
+
+void CSoundBase::OnTimerMIDIEvents()
+{
+    uint8_t vbyEvent[MIDI_EVENT_SIZE_BYTES];
+
+    for ( int i = 0; i < MIDI_NUM_CONTROLLERS; i++ )
+    {
+        viMIDIFaderLevel[i] = INVALID_INDEX;
+    }
+
+    // a fast fader movement produces many messages of the same controller,
+    // only the last level of each controller is signalled
+    while ( MIDIEventFifo.Get ( vbyEvent, MIDI_EVENT_SIZE_BYTES ) )
+    {
+        ParseMIDIMessage ( &vbyEvent[1], vbyEvent[0] );
+    }
+
+    for ( int i = 0; i < MIDI_NUM_CONTROLLERS; i++ )
+    {
+        if ( viMIDIFaderLevel[i] != INVALID_INDEX )
+        {
+            // Behringer X-TOUCH: offset of 0x46
+            emit ControllerInFaderLevel ( i - 70, viMIDIFaderLevel[i] );
+        }
+    }
+}
+
+void CSoundBase::ParseMIDIMessage ( const uint8_t* pbyMIDIPaketBytes,
+                                    const int      iNumBytes )
 {
-    if ( vMIDIPaketBytes.Size() > 0 )
+    if ( iNumBytes > 0 )
     {
-        const uint8_t iStatusByte = vMIDIPaketBytes[0];
+        const uint8_t iStatusByte = pbyMIDIPaketBytes[0];
 
         // check if status byte is correct
         if ( ( iStatusByte >= 0x80 ) && ( iStatusByte < 0xF0 ) )
@@ -277,9 +813,9 @@ void CSoundBase::ParseMIDIMessage ( const CVector<uint8_t>& vMIDIPaketBytes )
 /*
 // debugging
 printf ( "%02X: ", iMIDIChannelZB );
-for ( int i = 0; i < vMIDIPaketBytes.Size(); i++ )
+for ( int i = 0; i < iNumBytes; i++ )
 {
-    printf ( "%02X ", vMIDIPaketBytes[i] );
+    printf ( "%02X ", pbyMIDIPaketBytes[i] );
 }
 printf ( "\n" );
 */
@@ -292,20 +828,349 @@ printf ( "\n" );
                 if ( ( iStatusByte >= 0xB0 ) && ( iStatusByte < 0xC0 ) )
                 {
                     // make sure paket is long enough
-                    if ( vMIDIPaketBytes.Size() > 2 )
+                    if ( iNumBytes > 2 )
                     {
                         // we are assuming that the controller number is the same
                         // as the audio fader index and the range is 0-127
                         const int iFaderLevel = static_cast<int> ( static_cast<double> (
-                            qMin ( vMIDIPaketBytes[2], uint8_t ( 127 ) ) ) / 127 * AUD_MIX_FADER_MAX );
+                            qMin ( pbyMIDIPaketBytes[2], uint8_t ( 127 ) ) ) / 127 * AUD_MIX_FADER_MAX );
 
-                        // Behringer X-TOUCH: offset of 0x46
-                        const int iChID = vMIDIPaketBytes[1] - 70;
-
-                        EmitControllerInFaderLevel ( iChID, iFaderLevel );
+                        viMIDIFaderLevel[pbyMIDIPaketBytes[1] & 0x7F] = iFaderLevel;
                     }
                 }
             }
         }
     }
 }
+
+
+
+/******************************************************************************\
+* Sample format converters                                                     *
+\******************************************************************************/
+// full scale of the float sample formats with respect to int16
+#define SND_SAMPLE_CONV_FLOAT_SCALE      32768.0
+
+// the number of bits the int16 sample is shifted in a 32 bit word
+static inline int GetInt32Shift ( const ESndSampleFormat eFormat )
+{
+    switch ( eFormat )
+    {
+    case SF_INT18_IN_32: return 2;
+    case SF_INT20_IN_32: return 4;
+    case SF_INT24_IN_32: return 8;
+    case SF_INT32:       return 16;
+    default:             return 0;
+    }
+}
+
+// the memcpy calls are used since the sound card buffers are not necessarily
+// aligned for the sample type (e.g., strided 24 bit samples), they are
+// resolved to plain loads and stores by the compiler
+template<ESndSampleFormat eFormat>
+static inline int16_t ReadSample ( const uint8_t* pbyIn,
+                                   const bool     bSwapBytes )
+{
+    switch ( eFormat )
+    {
+    case SF_INT16:
+    {
+        uint16_t iSam;
+        memcpy ( &iSam, pbyIn, sizeof ( iSam ) );
+
+        return static_cast<int16_t> ( bSwapBytes ? CSndSampleConv::SwapBytes16 ( iSam ) : iSam );
+    }
+
+    case SF_INT24:
+        // use the two most significant bytes of the 24 bit sample
+        if ( bSwapBytes )
+        {
+            return static_cast<int16_t> ( ( pbyIn[0] << 8 ) | pbyIn[1] );
+        }
+        return static_cast<int16_t> ( ( pbyIn[2] << 8 ) | pbyIn[1] );
+
+    case SF_FLOAT32:
+    {
+        uint32_t iSam;
+        float    fSam;
+        memcpy ( &iSam, pbyIn, sizeof ( iSam ) );
+
+        if ( bSwapBytes )
+        {
+            iSam = CSndSampleConv::SwapBytes32 ( iSam );
+        }
+
+        memcpy ( &fSam, &iSam, sizeof ( fSam ) );
+
+        return Double2Short ( SND_SAMPLE_CONV_FLOAT_SCALE * fSam );
+    }
+
+    case SF_FLOAT64:
+    {
+        uint64_t iSam;
+        double   dSam;
+        memcpy ( &iSam, pbyIn, sizeof ( iSam ) );
+
+        if ( bSwapBytes )
+        {
+            iSam = CSndSampleConv::SwapBytes64 ( iSam );
+        }
+
+        memcpy ( &dSam, &iSam, sizeof ( dSam ) );
+
+        return Double2Short ( SND_SAMPLE_CONV_FLOAT_SCALE * dSam );
+    }
+
+    default: // 32 bit integer formats
+    {
+        uint32_t iSam;
+        memcpy ( &iSam, pbyIn, sizeof ( iSam ) );
+
+        if ( bSwapBytes )
+        {
+            iSam = CSndSampleConv::SwapBytes32 ( iSam );
+        }
+
+        return static_cast<int16_t> ( static_cast<int32_t> ( iSam ) >> GetInt32Shift ( eFormat ) );
+    }
+    }
+}
+
+template<ESndSampleFormat eFormat>
+static inline void WriteSample ( uint8_t*      pbyOut,
+                                 const bool    bSwapBytes,
+                                 const int16_t iIn )
+{
+    switch ( eFormat )
+    {
+    case SF_INT16:
+    {
+        const uint16_t iSam = static_cast<uint16_t> ( iIn );
+        const uint16_t iOut = bSwapBytes ? CSndSampleConv::SwapBytes16 ( iSam ) : iSam;
+        memcpy ( pbyOut, &iOut, sizeof ( iOut ) );
+        break;
+    }
+
+    case SF_INT24:
+    {
+        // the least significant byte of the 24 bit sample is zero
+        const uint16_t iSam = static_cast<uint16_t> ( iIn );
+
+        if ( bSwapBytes )
+        {
+            pbyOut[0] = static_cast<uint8_t> ( iSam >> 8 );
+            pbyOut[1] = static_cast<uint8_t> ( iSam );
+            pbyOut[2] = 0;
+        }
+        else
+        {
+            pbyOut[0] = 0;
+            pbyOut[1] = static_cast<uint8_t> ( iSam );
+            pbyOut[2] = static_cast<uint8_t> ( iSam >> 8 );
+        }
+        break;
+    }
+
+    case SF_FLOAT32:
+    {
+        const float fSam = static_cast<float> ( iIn / SND_SAMPLE_CONV_FLOAT_SCALE );
+        uint32_t    iOut;
+        memcpy ( &iOut, &fSam, sizeof ( iOut ) );
+
+        if ( bSwapBytes )
+        {
+            iOut = CSndSampleConv::SwapBytes32 ( iOut );
+        }
+
+        memcpy ( pbyOut, &iOut, sizeof ( iOut ) );
+        break;
+    }
+
+    case SF_FLOAT64:
+    {
+        const double dSam = iIn / SND_SAMPLE_CONV_FLOAT_SCALE;
+        uint64_t     iOut;
+        memcpy ( &iOut, &dSam, sizeof ( iOut ) );
+
+        if ( bSwapBytes )
+        {
+            iOut = CSndSampleConv::SwapBytes64 ( iOut );
+        }
+
+        memcpy ( pbyOut, &iOut, sizeof ( iOut ) );
+        break;
+    }
+
+    default: // 32 bit integer formats
+    {
+        // multiply instead of shift since a left shift of a negative value is
+        // undefined behaviour
+        uint32_t iOut = static_cast<uint32_t> ( static_cast<int32_t> ( iIn ) * ( 1 << GetInt32Shift ( eFormat ) ) );
+
+        if ( bSwapBytes )
+        {
+            iOut = CSndSampleConv::SwapBytes32 ( iOut );
+        }
+
+        memcpy ( pbyOut, &iOut, sizeof ( iOut ) );
+        break;
+    }
+    }
+}
+
+template<ESndSampleFormat eFormat>
+static void ConvToShortTempl ( const bool     bSwapBytes,
+                               const bool     bMix,
+                               const uint8_t* pbyIn,
+                               const int      iInStrideBytes,
+                               int16_t*       psOut,
+                               const int      iOutStride,
+                               const int      iNumFrames )
+{
+    if ( bMix )
+    {
+        for ( int i = 0; i < iNumFrames; i++ )
+        {
+            const int32_t iSum = static_cast<int32_t> ( psOut[i * iOutStride] ) +
+                ReadSample<eFormat> ( &pbyIn[i * iInStrideBytes], bSwapBytes );
+
+            psOut[i * iOutStride] = static_cast<int16_t> ( qBound ( _MINSHORT, iSum, _MAXSHORT ) );
+        }
+    }
+    else
+    {
+        for ( int i = 0; i < iNumFrames; i++ )
+        {
+            psOut[i * iOutStride] = ReadSample<eFormat> ( &pbyIn[i * iInStrideBytes], bSwapBytes );
+        }
+    }
+}
+
+template<ESndSampleFormat eFormat>
+static void FromShortTempl ( const bool     bSwapBytes,
+                             const int16_t* psIn,
+                             const int      iInStride,
+                             uint8_t*       pbyOut,
+                             const int      iOutStrideBytes,
+                             const int      iNumFrames )
+{
+    for ( int i = 0; i < iNumFrames; i++ )
+    {
+        WriteSample<eFormat> ( &pbyOut[i * iOutStrideBytes], bSwapBytes, psIn[i * iInStride] );
+    }
+}
+
+int CSndSampleConv::GetSampleSize ( const ESndSampleFormat eFormat )
+{
+    switch ( eFormat )
+    {
+    case SF_INT16:   return 2;
+    case SF_INT24:   return 3;
+    case SF_FLOAT64: return 8;
+    default:         return 4;
+    }
+}
+
+void CSndSampleConv::ConvToShort ( const ESndSampleFormat eFormat,
+                                   const bool             bSwapBytes,
+                                   const bool             bMix,
+                                   const void*            pIn,
+                                   const int              iInStride,
+                                   int16_t*               psOut,
+                                   const int              iOutStride,
+                                   const int              iNumFrames )
+{
+    const uint8_t* pbyIn          = static_cast<const uint8_t*> ( pIn );
+    const int      iInStrideBytes = iInStride * GetSampleSize ( eFormat );
+
+    // the most common case of contiguous float samples uses the vectorized kernel
+    if ( ( eFormat == SF_FLOAT32 ) && !bSwapBytes && !bMix && ( iInStride == 1 ) && ( iOutStride == 1 ) )
+    {
+        CMixKernel::FloatNormToShort ( static_cast<const float*> ( pIn ), psOut, iNumFrames );
+        return;
+    }
+
+    switch ( eFormat )
+    {
+    case SF_INT16:       ConvToShortTempl<SF_INT16>       ( bSwapBytes, bMix, pbyIn, iInStrideBytes, psOut, iOutStride, iNumFrames ); break;
+    case SF_INT24:       ConvToShortTempl<SF_INT24>       ( bSwapBytes, bMix, pbyIn, iInStrideBytes, psOut, iOutStride, iNumFrames ); break;
+    case SF_INT32:       ConvToShortTempl<SF_INT32>       ( bSwapBytes, bMix, pbyIn, iInStrideBytes, psOut, iOutStride, iNumFrames ); break;
+    case SF_INT16_IN_32: ConvToShortTempl<SF_INT16_IN_32> ( bSwapBytes, bMix, pbyIn, iInStrideBytes, psOut, iOutStride, iNumFrames ); break;
+    case SF_INT18_IN_32: ConvToShortTempl<SF_INT18_IN_32> ( bSwapBytes, bMix, pbyIn, iInStrideBytes, psOut, iOutStride, iNumFrames ); break;
+    case SF_INT20_IN_32: ConvToShortTempl<SF_INT20_IN_32> ( bSwapBytes, bMix, pbyIn, iInStrideBytes, psOut, iOutStride, iNumFrames ); break;
+    case SF_INT24_IN_32: ConvToShortTempl<SF_INT24_IN_32> ( bSwapBytes, bMix, pbyIn, iInStrideBytes, psOut, iOutStride, iNumFrames ); break;
+    case SF_FLOAT32:     ConvToShortTempl<SF_FLOAT32>     ( bSwapBytes, bMix, pbyIn, iInStrideBytes, psOut, iOutStride, iNumFrames ); break;
+    case SF_FLOAT64:     ConvToShortTempl<SF_FLOAT64>     ( bSwapBytes, bMix, pbyIn, iInStrideBytes, psOut, iOutStride, iNumFrames ); break;
+    }
+}
+
+void CSndSampleConv::FromShort ( const ESndSampleFormat eFormat,
+                                 const bool             bSwapBytes,
+                                 const int16_t*         psIn,
+                                 const int              iInStride,
+                                 void*                  pOut,
+                                 const int              iOutStride,
+                                 const int              iNumFrames )
+{
+    uint8_t*  pbyOut          = static_cast<uint8_t*> ( pOut );
+    const int iOutStrideBytes = iOutStride * GetSampleSize ( eFormat );
+
+    if ( ( eFormat == SF_FLOAT32 ) && !bSwapBytes && ( iInStride == 1 ) && ( iOutStride == 1 ) )
+    {
+        CMixKernel::ShortToFloatNorm ( psIn, static_cast<float*> ( pOut ), iNumFrames );
+        return;
+    }
+
+    switch ( eFormat )
+    {
+    case SF_INT16:       FromShortTempl<SF_INT16>       ( bSwapBytes, psIn, iInStride, pbyOut, iOutStrideBytes, iNumFrames ); break;
+    case SF_INT24:       FromShortTempl<SF_INT24>       ( bSwapBytes, psIn, iInStride, pbyOut, iOutStrideBytes, iNumFrames ); break;
+    case SF_INT32:       FromShortTempl<SF_INT32>       ( bSwapBytes, psIn, iInStride, pbyOut, iOutStrideBytes, iNumFrames ); break;
+    case SF_INT16_IN_32: FromShortTempl<SF_INT16_IN_32> ( bSwapBytes, psIn, iInStride, pbyOut, iOutStrideBytes, iNumFrames ); break;
+    case SF_INT18_IN_32: FromShortTempl<SF_INT18_IN_32> ( bSwapBytes, psIn, iInStride, pbyOut, iOutStrideBytes, iNumFrames ); break;
+    case SF_INT20_IN_32: FromShortTempl<SF_INT20_IN_32> ( bSwapBytes, psIn, iInStride, pbyOut, iOutStrideBytes, iNumFrames ); break;
+    case SF_INT24_IN_32: FromShortTempl<SF_INT24_IN_32> ( bSwapBytes, psIn, iInStride, pbyOut, iOutStrideBytes, iNumFrames ); break;
+    case SF_FLOAT32:     FromShortTempl<SF_FLOAT32>     ( bSwapBytes, psIn, iInStride, pbyOut, iOutStrideBytes, iNumFrames ); break;
+    case SF_FLOAT64:     FromShortTempl<SF_FLOAT64>     ( bSwapBytes, psIn, iInStride, pbyOut, iOutStrideBytes, iNumFrames ); break;
+    }
+}
+
+void CSndSampleConv::FloatStereoToShort ( const float* pfInLeft,
+                                          const float* pfInRight,
+                                          int16_t*     psOut,
+                                          const int    iNumFrames )
+{
+    CMixKernel::FloatNormToShortStereo ( pfInLeft, pfInRight, psOut, iNumFrames );
+}
+
+void CSndSampleConv::ShortToFloatStereo ( const int16_t* psIn,
+                                          float*         pfOutLeft,
+                                          float*         pfOutRight,
+                                          const int      iNumFrames )
+{
+    CMixKernel::ShortToFloatNormStereo ( psIn, pfOutLeft, pfOutRight, iNumFrames );
+}
+
+void CSndSampleConv::InterleaveFloatStereo ( const float* pfInLeft,
+                                             const float* pfInRight,
+                                             float*       pfOut,
+                                             const int    iNumFrames )
+{
+    for ( int i = 0; i < iNumFrames; i++ )
+    {
+        pfOut[2 * i]     = pfInLeft[i];
+        pfOut[2 * i + 1] = pfInRight[i];
+    }
+}
+
+void CSndSampleConv::DeinterleaveFloatStereo ( const float* pfIn,
+                                               float*       pfOutLeft,
+                                               float*       pfOutRight,
+                                               const int    iNumFrames )
+{
+    for ( int i = 0; i < iNumFrames; i++ )
+    {
+        pfOutLeft[i]  = pfIn[2 * i];
+        pfOutRight[i] = pfIn[2 * i + 1];
+    }
+}
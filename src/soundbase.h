@@ -26,11 +26,55 @@
 
 #include <QThread>
 #include <QString>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <climits>
 #ifndef HEADLESS
 # include <QMessageBox>
 #endif
 #include "global.h"
 #include "util.h"
+#include "buffer.h"
+
+
+/* Definitions ****************************************************************/
+// number of bins of the histogram of the sound card callback intervals, the
+// bins are half a period wide and centred at multiples of half a period, i.e.
+// the nominal interval is in bin 2 and the last bin takes all longer intervals
+#define SND_CRD_TIMING_NUM_HIST_BINS     8
+
+// weight of the IIR averaging of the processing time per callback
+#define SND_CRD_TIMING_AV_WEIGHT         0.99
+
+// sleep time of the sound card bridge thread between the checks for due blocks
+#define SND_CRD_BRIDGE_SLEEP_TIME_MS     2
+
+// if the bridge thread is late by more blocks (e.g. the system was suspended),
+// these blocks are skipped instead of being sent as a burst
+#define SND_CRD_BRIDGE_MAX_LATE_BLOCKS   16
+
+// the MIDI callback puts the messages in a FIFO (one byte length and up to
+// three message bytes per event), the main thread takes them in the given
+// interval and only signals the last value of each controller
+#define MIDI_EVENT_SIZE_BYTES            4
+#define MIDI_EVENT_FIFO_NUM_EVENTS       512
+#define MIDI_EVENT_INTERVAL_MS           20
+#define MIDI_NUM_CONTROLLERS             128
+
+// polyphase FIR filter of the sample rate converter for sound cards which do
+// not support the system sample rate: number of taps per phase, maximum number
+// of phases (i.e. of the interpolation factor after reducing the rate ratio),
+// cutoff frequency relative to the lower of both sample rates and the
+// parameter of the Kaiser window (about 70 dB stop band attenuation)
+#define SND_CRD_RESAMPLER_NUM_TAPS       48
+#define SND_CRD_RESAMPLER_MAX_NUM_PHASES 1024
+#define SND_CRD_RESAMPLER_CUTOFF         0.455
+#define SND_CRD_RESAMPLER_KAISER_BETA    7.0
+
+// additional frames in the output buffer of the sample rate conversion which
+// cover the rounding of the number of converted frames per sound card block
+#define SND_CRD_RESAMPLER_FIFO_MARGIN    2
 
 
 // TODO better solution with enum definition
@@ -39,11 +83,262 @@ enum ESndCrdResetType
 {
     RS_ONLY_RESTART = 1,
     RS_ONLY_RESTART_AND_INIT,
-    RS_RELOAD_RESTART_AND_INIT
+    RS_RELOAD_RESTART_AND_INIT,
+    RS_ONLY_BUFFER_SIZE_CHANGED // the driver changed the buffer size by itself
+};
+
+// sample formats of the sound card buffers which are supported by the sample
+// format converters (the "in 32" formats are right aligned in a 32 bit word,
+// the float formats have a full scale of +-1)
+enum ESndSampleFormat
+{
+    SF_INT16,       // 16 bit integer
+    SF_INT24,       // 24 bit integer packed in three bytes
+    SF_INT32,       // 32 bit integer
+    SF_INT16_IN_32, // 16 bit integer in a 32 bit word
+    SF_INT18_IN_32, // 18 bit integer in a 32 bit word
+    SF_INT20_IN_32, // 20 bit integer in a 32 bit word
+    SF_INT24_IN_32, // 24 bit integer in a 32 bit word
+    SF_FLOAT32,     // IEEE 754 32 bit float
+    SF_FLOAT64      // IEEE 754 64 bit float
 };
 
 
 /* Classes ********************************************************************/
+// Sample format converters which are shared by all sound card backends. They
+// convert between the native sound card buffers and the interleaved stereo
+// int16 buffer of the processing callback. The strides are given in samples
+// so that one channel of an interleaved buffer can be addressed directly, the
+// big-endian sample formats are supported by the bSwapBytes flag. The common
+// float cases use the vectorized kernels of CMixKernel.
+class CSndSampleConv
+{
+public:
+    // sound card buffer -> int16 buffer, the "mix" version adds the converted
+    // samples on the int16 buffer with saturation (used for mixing an
+    // additional input channel)
+    static void ToShort ( const ESndSampleFormat eFormat,
+                          const bool             bSwapBytes,
+                          const void*            pIn,
+                          const int              iInStride,
+                          int16_t*               psOut,
+                          const int              iOutStride,
+                          const int              iNumFrames )
+        { ConvToShort ( eFormat, bSwapBytes, false, pIn, iInStride, psOut, iOutStride, iNumFrames ); }
+
+    static void MixToShort ( const ESndSampleFormat eFormat,
+                             const bool             bSwapBytes,
+                             const void*            pIn,
+                             const int              iInStride,
+                             int16_t*               psOut,
+                             const int              iOutStride,
+                             const int              iNumFrames )
+        { ConvToShort ( eFormat, bSwapBytes, true, pIn, iInStride, psOut, iOutStride, iNumFrames ); }
+
+    // int16 buffer -> sound card buffer
+    static void FromShort ( const ESndSampleFormat eFormat,
+                            const bool             bSwapBytes,
+                            const int16_t*         psIn,
+                            const int              iInStride,
+                            void*                  pOut,
+                            const int              iOutStride,
+                            const int              iNumFrames );
+
+    // planar stereo float buffers <-> interleaved stereo int16 buffer
+    static void FloatStereoToShort ( const float* pfInLeft,
+                                     const float* pfInRight,
+                                     int16_t*     psOut,
+                                     const int    iNumFrames );
+
+    static void ShortToFloatStereo ( const int16_t* psIn,
+                                     float*         pfOutLeft,
+                                     float*         pfOutRight,
+                                     const int      iNumFrames );
+
+    // planar stereo float buffers <-> interleaved stereo float buffer of the
+    // float processing callback (no conversion of the samples)
+    static void InterleaveFloatStereo ( const float* pfInLeft,
+                                        const float* pfInRight,
+                                        float*       pfOut,
+                                        const int    iNumFrames );
+
+    static void DeinterleaveFloatStereo ( const float* pfIn,
+                                          float*       pfOutLeft,
+                                          float*       pfOutRight,
+                                          const int    iNumFrames );
+
+    static int GetSampleSize ( const ESndSampleFormat eFormat );
+
+    static uint16_t SwapBytes16 ( const uint16_t iIn )
+        { return static_cast<uint16_t> ( ( iIn << 8 ) | ( iIn >> 8 ) ); }
+
+    static uint32_t SwapBytes32 ( const uint32_t iIn )
+        { return ( static_cast<uint32_t> ( SwapBytes16 ( static_cast<uint16_t> ( iIn ) ) ) << 16 ) |
+                 SwapBytes16 ( static_cast<uint16_t> ( iIn >> 16 ) ); }
+
+    static uint64_t SwapBytes64 ( const uint64_t iIn )
+        { return ( static_cast<uint64_t> ( SwapBytes32 ( static_cast<uint32_t> ( iIn ) ) ) << 32 ) |
+                 SwapBytes32 ( static_cast<uint32_t> ( iIn >> 32 ) ); }
+
+protected:
+    static void ConvToShort ( const ESndSampleFormat eFormat,
+                              const bool             bSwapBytes,
+                              const bool             bMix,
+                              const void*            pIn,
+                              const int              iInStride,
+                              int16_t*               psOut,
+                              const int              iOutStride,
+                              const int              iNumFrames );
+};
+
+// Timing statistics of the processing callback since the sound card was
+// started (all times in microseconds), used to tell sound card and driver
+// problems apart from network problems.
+class CSndCrdTimingStats
+{
+public:
+    CSndCrdTimingStats() :
+        iNumCallbacks   ( 0 ),
+        iNumOverruns    ( 0 ),
+        iPeriodUs       ( 0 ),
+        iAvProcTimeUs   ( 0 ),
+        iMaxProcTimeUs  ( 0 ),
+        iMaxIntervalUs  ( 0 ),
+        veciIntervalHist ( SND_CRD_TIMING_NUM_HIST_BINS, 0 ) {}
+
+    int          iNumCallbacks;    // number of processing callbacks
+    int          iNumOverruns;     // processing took longer than the period
+    int          iPeriodUs;        // duration of the current sound card block
+    int          iAvProcTimeUs;    // averaged processing time
+    int          iMaxProcTimeUs;   // maximum processing time
+    int          iMaxIntervalUs;   // maximum interval between two callbacks
+    CVector<int> veciIntervalHist; // histogram of the callback intervals
+};
+
+// Calls the float processing callback with silence in the timing of the sound
+// card blocks while no sound card is running (e.g. while a new driver is
+// loaded), so that the audio stream to the server is not interrupted. The due
+// blocks are processed in bursts after each sleep time, the output is
+// discarded. The processing callback must not be called by the sound card at
+// the same time.
+class CSndCrdBridge : public QThread
+{
+public:
+    CSndCrdBridge ( void (*fpNewProcessCallback) ( CVector<float>& vecfData, void* pParg ),
+                    void* pParg ) :
+        fpProcessCallback ( fpNewProcessCallback ),
+        pProcessCallbackArg ( pParg ),
+        iMonoBlockSize ( 0 ),
+        bRun ( 0 ) {}
+
+    void Start ( const int iNewMonoBlockSize );
+    void Stop();
+
+protected:
+    virtual void run();
+
+    void           (*fpProcessCallback) ( CVector<float>& vecfData, void* arg );
+    void*          pProcessCallbackArg;
+    CVector<float> vecfSilence;
+    int            iMonoBlockSize;
+    QAtomicInt     bRun;
+};
+
+// Polyphase FIR sample rate converter on interleaved stereo float samples with
+// a fixed rational rate ratio. The converter can be used in push mode (all
+// input frames are consumed, the number of output frames varies) or in pull
+// mode (the caller gets the number of input frames which are required for a
+// given number of output frames). The filter is linear phase, its group delay
+// is constant.
+class CSndCrdResampler
+{
+public:
+    CSndCrdResampler() : iInterpol ( 1 ), iDecim ( 1 ), iInRate ( 0 ), iMaxInFrames ( 0 ),
+        iPhase ( 0 ), iPos ( 0 ), iNumHistFrames ( 0 ) {}
+
+    // returns false if the rate ratio needs too many filter phases
+    bool Init ( const int iNewInRate,
+                const int iNewOutRate,
+                const int iNewMaxInFrames );
+
+    void Reset();
+
+    // consumes all input frames (at most the maximum number given in Init())
+    // and returns the number of output frames, in pull mode the number of
+    // output frames is limited to the requested number
+    int Process ( const float* pfIn,
+                  const int    iNumInFrames,
+                  float*       pfOut,
+                  const int    iMaxNumOutFrames = INT_MAX );
+
+    // upper bound of the number of output frames for the given input frames
+    int GetMaxNumOutFrames ( const int iNumInFrames ) const
+        { return ( iNumInFrames * iInterpol ) / iDecim + 2; }
+
+    // number of input frames for which Process() returns exactly the given
+    // number of output frames (pull mode)
+    int GetNumInFramesRequired ( const int iNumOutFrames ) const;
+
+    double GetDelayMs() const;
+
+protected:
+    int            iInterpol;      // L: interpolation factor (number of phases)
+    int            iDecim;         // M: decimation factor
+    int            iInRate;
+    int            iMaxInFrames;
+    CVector<float> vecfCoeff;      // per phase, reversed, each coefficient twice
+    CVector<float> vecfHist;       // interleaved stereo input history
+    int            iPhase;         // phase of the next output frame
+    int            iPos;           // first history frame of the next output frame
+    int            iNumHistFrames;
+};
+
+// Sample rate conversion stage between a sound card which does not run at the
+// system sample rate and the processing. The processing is called with blocks
+// of a fixed size at the system sample rate whenever enough input frames are
+// converted, the output is buffered until the sound card requests it. Since
+// both directions are clocked by the sound card, the fill levels of the two
+// buffers are bounded and the total delay is constant.
+class CSndCrdRateConv
+{
+public:
+    CSndCrdRateConv() : bIsEnabled ( false ), iMonoBlockSize ( 0 ), iNumInFifoFrames ( 0 ),
+        iNumOutFifoFrames ( 0 ) {}
+
+    // returns false if the sample rate of the sound card is not supported
+    bool Init ( const int iNewSndCrdSampleRate,
+                const int iNewSndCrdMaxFrames,
+                const int iNewMonoBlockSize );
+
+    void Disable() { bIsEnabled = false; }
+    void Reset();
+
+    bool IsEnabled() const { return bIsEnabled; }
+
+    // delay of both filters and of the block buffering in ms
+    double GetDelayMs() const;
+
+    // sound card input -> processing blocks -> sound card output
+    void PutInput ( const float* pfIn,
+                    const int    iNumFrames );
+
+    bool GetInputBlock ( CVector<float>& vecfBlock );
+    void PutOutputBlock ( const CVector<float>& vecfBlock );
+
+    void GetOutput ( float*    pfOut,
+                     const int iNumFrames );
+
+protected:
+    bool             bIsEnabled;
+    int              iMonoBlockSize;
+    CSndCrdResampler InResampler;
+    CSndCrdResampler OutResampler;
+    CVector<float>   vecfInFifo;
+    CVector<float>   vecfOutFifo;
+    int              iNumInFifoFrames;
+    int              iNumOutFifoFrames;
+};
+
 class CSoundBase : public QThread
 {
     Q_OBJECT
@@ -81,17 +376,33 @@ public:
 
     virtual double  GetInOutLatencyMs() { return 0.0; } // "0.0" means no latency is available
 
+    // additional delay if the sound card does not run at the system sample rate
+    double          GetSampleRateConvDelayMs() const
+        { return RateConv.IsEnabled() ? RateConv.GetDelayMs() : 0.0; }
+
     virtual void    OpenDriverSetup() {}
 
     bool IsRunning() const { return bRun; }
 
+    // the statistics are updated by the audio thread without any lock, i.e.
+    // the values of a snapshot may belong to different callbacks
+    void GetTimingStats ( CSndCrdTimingStats& TimingStats ) const;
+
+    // optional processing callback on interleaved stereo float samples (full
+    // scale is +-1), backends with native float buffers use it instead of the
+    // int16 callback if it is set (must be set before the sound is started)
+    void SetProcessCallbackFloat ( void (*fpNewProcessCallbackFloat) ( CVector<float>& vecfData, void* pParg ) )
+        { fpProcessCallbackFloat = fpNewProcessCallbackFloat; }
+
     // TODO this should be protected but since it is used
     // in a callback function it has to be public -> better solution
     void EmitReinitRequestSignal ( const ESndCrdResetType eSndCrdResetType )
         { emit ReinitRequest ( eSndCrdResetType ); }
 
-    void EmitControllerInFaderLevel ( const int iChannelIdx,
-                                      const int iValue ) { emit ControllerInFaderLevel ( iChannelIdx, iValue ); }
+    // real-time safe, called by the MIDI callback (a full FIFO drops the
+    // message)
+    void PutMIDIMessage ( const uint8_t* pbyMIDIPaketBytes,
+                          const int      iNumBytes );
 
 protected:
     // driver handling
@@ -127,9 +438,56 @@ protected:
     // callback function call for derived classes
     void ProcessCallback ( CVector<int16_t>& psData )
     {
+        const qint64 iStartNs = TimingTimer.nsecsElapsed();
         (*fpProcessCallback) ( psData, pProcessCallbackArg );
+        UpdateTimingStats ( iStartNs, psData.Size() / 2 );
+    }
+
+    // float callback (uses the same argument as the int16 callback)
+    void (*fpProcessCallbackFloat) ( CVector<float>& vecfData, void* arg );
+
+    bool HasProcessCallbackFloat() const { return fpProcessCallbackFloat != nullptr; }
+
+    void ProcessCallbackFloat ( CVector<float>& vecfData )
+    {
+        const qint64 iStartNs = TimingTimer.nsecsElapsed();
+        (*fpProcessCallbackFloat) ( vecfData, pProcessCallbackArg );
+        UpdateTimingStats ( iStartNs, vecfData.Size() / 2 );
     }
 
+    // enables the sample rate conversion, the processing block size is given
+    // at the system sample rate
+    bool InitRateConv ( const int iSndCrdSampleRate,
+                        const int iSndCrdMaxFrames,
+                        const int iMonoBlockSize );
+
+    // processing of a sound card block at a sample rate which differs from
+    // the system sample rate (interleaved stereo float samples, in place), the
+    // processing callbacks are called with blocks at the system sample rate
+    void ProcessCallbackRateConv ( float*    pfData,
+                                   const int iNumFrames );
+
+    CSndCrdRateConv  RateConv;
+    CVector<float>   vecfRateConvBlock;
+    CVector<int16_t> vecsRateConvBlock;
+
+    // callback timing instrumentation (only called by the audio thread)
+    void UpdateTimingStats ( const qint64 iStartNs,
+                             const int    iNumFrames );
+
+    void ResetTimingStats();
+
+    QElapsedTimer  TimingTimer;
+    qint64         iLastCallbackStartNs;
+    double         dAvProcTimeUs;
+    QAtomicInt     iTimingNumCallbacks;
+    QAtomicInt     iTimingNumOverruns;
+    QAtomicInt     iTimingPeriodUs;
+    QAtomicInt     iTimingAvProcTimeUs;
+    QAtomicInt     iTimingMaxProcTimeUs;
+    QAtomicInt     iTimingMaxIntervalUs;
+    QAtomicInt     iTimingIntervalHist[SND_CRD_TIMING_NUM_HIST_BINS];
+
     // these functions should be overwritten by derived class for
     // non callback based audio interfaces
     virtual bool Read  ( CVector<int16_t>& ) { printf ( "no sound!" ); return false; }
@@ -138,7 +496,13 @@ protected:
     void run();
     bool bRun;
 
-    void             ParseMIDIMessage ( const CVector<uint8_t>& vMIDIPaketBytes );
+    // main thread
+    void             ParseMIDIMessage ( const uint8_t* pbyMIDIPaketBytes,
+                                        const int      iNumBytes );
+
+    CSampleFifoSPSC<uint8_t> MIDIEventFifo;
+    QTimer                   TimerMIDIEvents;
+    int                      viMIDIFaderLevel[MIDI_NUM_CONTROLLERS];
 
     bool             bIsCallbackAudioInterface;
     QString          strSystemDriverTechniqueName;
@@ -150,6 +514,9 @@ protected:
     long             lCurDev;
     QString          strDriverNames[MAX_NUMBER_SOUND_CARDS];
 
+protected slots:
+    void OnTimerMIDIEvents();
+
 signals:
     void ReinitRequest ( int iSndCrdResetType );
     void ControllerInFaderLevel ( int iChannelIdx, int iValue );
@@ -0,0 +1,481 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "streamoutput.h"
+
+
+/* Implementation *************************************************************/
+// Ogg/OPUS pager --------------------------------------------------------------
+static void AppendLE ( QByteArray& vecbyData, const quint64 iValue, const int iNumBytes )
+{
+    for ( int i = 0; i < iNumBytes; i++ )
+    {
+        vecbyData.append ( static_cast<char> ( ( iValue >> ( 8 * i ) ) & 0xFF ) );
+    }
+}
+
+quint32 COggOpusPager::Crc32 ( const QByteArray& vecbyData )
+{
+    // CRC of the Ogg pages: polynomial 0x04C11DB7, initial value zero, no
+    // reflection and no final XOR
+    static quint32 vecCrcTable[256];
+    static bool    bTableInitialized = false;
+
+    if ( !bTableInitialized )
+    {
+        for ( quint32 i = 0; i < 256; i++ )
+        {
+            quint32 iReg = i << 24;
+
+            for ( int j = 0; j < 8; j++ )
+            {
+                iReg = ( iReg & 0x80000000 ) ? ( ( iReg << 1 ) ^ 0x04C11DB7 ) : ( iReg << 1 );
+            }
+
+            vecCrcTable[i] = iReg;
+        }
+
+        bTableInitialized = true;
+    }
+
+    quint32 iCrc = 0;
+
+    for ( int i = 0; i < vecbyData.size(); i++ )
+    {
+        iCrc = ( iCrc << 8 ) ^ vecCrcTable[( ( iCrc >> 24 ) ^ static_cast<quint8> ( vecbyData[i] ) ) & 0xFF];
+    }
+
+    return iCrc;
+}
+
+QByteArray COggOpusPager::CreateHeaderPages ( const int iNumChannels,
+                                              const int iPreSkip )
+{
+    // identification header
+    QByteArray vecbyOpusHead ( "OpusHead" );
+    vecbyOpusHead.append ( static_cast<char> ( 1 ) ); // version
+    vecbyOpusHead.append ( static_cast<char> ( iNumChannels ) );
+    AppendLE ( vecbyOpusHead, static_cast<quint64> ( iPreSkip ), 2 );
+    AppendLE ( vecbyOpusHead, SYSTEM_SAMPLE_RATE_HZ, 4 );
+    AppendLE ( vecbyOpusHead, 0, 2 ); // output gain
+    vecbyOpusHead.append ( static_cast<char> ( 0 ) ); // channel mapping family
+
+    // comment header (without user comments)
+    const QByteArray strVendor = QByteArray ( APP_NAME ) + " " + opus_get_version_string();
+
+    QByteArray vecbyOpusTags ( "OpusTags" );
+    AppendLE ( vecbyOpusTags, static_cast<quint64> ( strVendor.size() ), 4 );
+    vecbyOpusTags.append ( strVendor );
+    AppendLE ( vecbyOpusTags, 0, 4 );
+
+    // each header has a page of its own, the first page starts the stream
+    return CreatePage ( QList<QByteArray>() << vecbyOpusHead, 0, 0x02 /* beginning of stream */ ) +
+           CreatePage ( QList<QByteArray>() << vecbyOpusTags, 0 );
+}
+
+QByteArray COggOpusPager::CreatePage ( const QList<QByteArray>& vecPackets,
+                                       const qint64             iGranulePos,
+                                       const quint8             iHeaderType )
+{
+    // segment table: a packet is split in segments of 255 bytes, a segment
+    // shorter than 255 bytes (also of zero length) terminates the packet
+    QByteArray vecbySegments;
+    QByteArray vecbyBody;
+
+    for ( const QByteArray& vecbyPacket : vecPackets )
+    {
+        int iRemaining = vecbyPacket.size();
+
+        while ( iRemaining >= 255 )
+        {
+            vecbySegments.append ( static_cast<char> ( 255 ) );
+            iRemaining -= 255;
+        }
+
+        vecbySegments.append ( static_cast<char> ( iRemaining ) );
+        vecbyBody.append ( vecbyPacket );
+    }
+
+    QByteArray vecbyPage ( "OggS" );
+    vecbyPage.append ( static_cast<char> ( 0 ) ); // version
+    vecbyPage.append ( static_cast<char> ( iHeaderType ) );
+    AppendLE ( vecbyPage, static_cast<quint64> ( iGranulePos ), 8 );
+    AppendLE ( vecbyPage, iSerial, 4 );
+    AppendLE ( vecbyPage, iPageSeq++, 4 );
+    AppendLE ( vecbyPage, 0, 4 ); // CRC, calculated with this field zeroed
+    vecbyPage.append ( static_cast<char> ( vecbySegments.size() ) );
+    vecbyPage.append ( vecbySegments );
+    vecbyPage.append ( vecbyBody );
+
+    const quint32 iCrc = Crc32 ( vecbyPage );
+
+    for ( int i = 0; i < 4; i++ )
+    {
+        vecbyPage[22 + i] = static_cast<char> ( ( iCrc >> ( 8 * i ) ) & 0xFF );
+    }
+
+    return vecbyPage;
+}
+
+
+// Stream encoder --------------------------------------------------------------
+CStreamEncoder::CStreamEncoder() :
+    pEncoder                ( nullptr ),
+    iServerFrameSizeSamples ( 0 ),
+    iQueueNumFrames         ( 0 ),
+    iQueuePutPos            ( 0 ),
+    iQueueGetPos            ( 0 ),
+    iNotifyPending          ( 0 ),
+    iNumDroppedFrames       ( 0 ),
+    iPcmFill                ( 0 ),
+    iGranulePos             ( 0 )
+{
+    QObject::connect ( this, &CStreamEncoder::FramesAvailable,
+        this, &CStreamEncoder::OnFramesAvailable, Qt::QueuedConnection );
+}
+
+CStreamEncoder::~CStreamEncoder()
+{
+    if ( pEncoder != nullptr )
+    {
+        opus_encoder_destroy ( pEncoder );
+    }
+}
+
+void CStreamEncoder::Init ( const int iNServerFrameSizeSamples,
+                            const int iBitRateKbps )
+{
+    int iOpusError;
+
+    iServerFrameSizeSamples = iNServerFrameSizeSamples;
+
+    pEncoder = opus_encoder_create ( SYSTEM_SAMPLE_RATE_HZ, 2, OPUS_APPLICATION_AUDIO, &iOpusError );
+
+    if ( ( pEncoder == nullptr ) || ( iOpusError != OPUS_OK ) )
+    {
+        throw CGenErr ( "The OPUS encoder of the live stream cannot be created." );
+    }
+
+    opus_encoder_ctl ( pEncoder, OPUS_SET_BITRATE ( 1000 * iBitRateKbps ) );
+
+    int iPreSkip = 0;
+    opus_encoder_ctl ( pEncoder, OPUS_GET_LOOKAHEAD ( &iPreSkip ) );
+
+    // the granule positions of a stream count the pre-skip samples
+    iGranulePos = 0;
+    Pager.Init ( static_cast<quint32> ( QDateTime::currentMSecsSinceEpoch() ) );
+    vecbyHeaderPages = Pager.CreateHeaderPages ( 2, iPreSkip );
+
+    // all the memory of the queue is allocated here, the server timer never
+    // allocates memory for the stream
+    iQueueNumFrames = std::max ( 2, STREAM_QUEUE_LENGTH_MS * ( SYSTEM_SAMPLE_RATE_HZ / 1000 ) / iServerFrameSizeSamples );
+
+    vecsQueue.Init ( iQueueNumFrames * 2 /* stereo */ * iServerFrameSizeSamples );
+    vecsPcm.Init ( 2 /* stereo */ * STREAM_OPUS_FRAME_SIZE_SAMPLES );
+    vecbyPacket.Init ( 4000 ); // maximum packet size recommended by the OPUS API
+}
+
+void CStreamEncoder::PutFrame ( const int16_t* psData )
+{
+    const int iPutPos = iQueuePutPos.loadAcquire();
+    const int iNumUsed = ( iPutPos - iQueueGetPos.loadAcquire() + 2 * iQueueNumFrames ) % ( 2 * iQueueNumFrames );
+
+    if ( iNumUsed >= iQueueNumFrames )
+    {
+        iNumDroppedFrames.fetchAndAddOrdered ( 1 );
+        return;
+    }
+
+    std::copy ( psData,
+                psData + 2 * iServerFrameSizeSamples,
+                &vecsQueue[( iPutPos % iQueueNumFrames ) * 2 * iServerFrameSizeSamples] );
+
+    iQueuePutPos.storeRelease ( ( iPutPos + 1 ) % ( 2 * iQueueNumFrames ) );
+
+    if ( iNotifyPending.testAndSetOrdered ( 0, 1 ) )
+    {
+        emit FramesAvailable();
+    }
+}
+
+void CStreamEncoder::OnFramesAvailable()
+{
+    // reset the notification first so that no notification gets lost
+    iNotifyPending.fetchAndStoreOrdered ( 0 );
+
+    ProcessFrames();
+}
+
+void CStreamEncoder::ProcessFrames()
+{
+    int iGetPos = iQueueGetPos.loadAcquire();
+
+    while ( iGetPos != iQueuePutPos.loadAcquire() )
+    {
+        // the server frames are collected in the frames of the stream
+        const int16_t* psFrame = &vecsQueue[( iGetPos % iQueueNumFrames ) * 2 * iServerFrameSizeSamples];
+        int            iPos    = 0;
+
+        while ( iPos < iServerFrameSizeSamples )
+        {
+            const int iNumCopy = std::min ( iServerFrameSizeSamples - iPos,
+                                            STREAM_OPUS_FRAME_SIZE_SAMPLES - iPcmFill );
+
+            std::copy ( psFrame + 2 * iPos,
+                        psFrame + 2 * ( iPos + iNumCopy ),
+                        &vecsPcm[2 * iPcmFill] );
+
+            iPos     += iNumCopy;
+            iPcmFill += iNumCopy;
+
+            if ( iPcmFill == STREAM_OPUS_FRAME_SIZE_SAMPLES )
+            {
+                EncodePacket();
+                iPcmFill = 0;
+            }
+        }
+
+        iGetPos = ( iGetPos + 1 ) % ( 2 * iQueueNumFrames );
+        iQueueGetPos.storeRelease ( iGetPos );
+    }
+
+    // report the dropped frames (the stream has a gap then)
+    const int iNumDropped = iNumDroppedFrames.fetchAndStoreOrdered ( 0 );
+
+    if ( iNumDropped > 0 )
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+// TODO we should use the ConsoleWriterFactory() instead of qInfo()
+        qInfo() << qUtf8Printable ( QString ( "Live stream: %1 frames dropped (the encoder cannot keep up)" ).
+            arg ( iNumDropped ) );
+#endif
+    }
+}
+
+void CStreamEncoder::EncodePacket()
+{
+    const int iNumBytes = opus_encode ( pEncoder,
+                                        &vecsPcm[0],
+                                        STREAM_OPUS_FRAME_SIZE_SAMPLES,
+                                        &vecbyPacket[0],
+                                        vecbyPacket.Size() );
+
+    if ( iNumBytes < 0 )
+    {
+        return;
+    }
+
+    iGranulePos += STREAM_OPUS_FRAME_SIZE_SAMPLES;
+    vecPackets.append ( QByteArray ( reinterpret_cast<const char*> ( &vecbyPacket[0] ), iNumBytes ) );
+
+    if ( vecPackets.size() >= STREAM_NUM_PACKETS_PER_PAGE )
+    {
+        emit PageReady ( Pager.CreatePage ( vecPackets, iGranulePos ) );
+        vecPackets.clear();
+    }
+}
+
+
+// Stream output ---------------------------------------------------------------
+CStreamOutput::CStreamOutput() :
+    iNumListeners ( 0 )
+{
+}
+
+CStreamOutput::~CStreamOutput()
+{
+    if ( EncoderThread.isRunning() )
+    {
+        EncoderThread.quit();
+        EncoderThread.wait();
+    }
+}
+
+void CStreamOutput::Start ( const QString& strBindAddress,
+                            const int      iServerFrameSizeSamples,
+                            const int      iBitRateKbps )
+{
+    QHostAddress BindAddress = QHostAddress ( QHostAddress::Any );
+    QString      strPort     = strBindAddress;
+    bool         bPortOK     = false;
+
+    // an address may precede the port number, separated by the last colon
+    const int iColonPos = strBindAddress.lastIndexOf ( ':' );
+
+    if ( iColonPos >= 0 )
+    {
+        QString strAddress = strBindAddress.left ( iColonPos );
+
+        // remove the brackets of an IPv6 address
+        if ( strAddress.startsWith ( '[' ) && strAddress.endsWith ( ']' ) )
+        {
+            strAddress = strAddress.mid ( 1, strAddress.length() - 2 );
+        }
+
+        strPort = strBindAddress.mid ( iColonPos + 1 );
+
+        if ( !BindAddress.setAddress ( strAddress ) )
+        {
+            throw CGenErr ( "Invalid address of the live stream: " +
+                strBindAddress, "Network Error" );
+        }
+    }
+
+    const quint16 iPort = strPort.toUShort ( &bPortOK );
+
+    if ( !bPortOK || !TcpServer.listen ( BindAddress, iPort ) )
+    {
+        throw CGenErr ( "Cannot start the live stream on " +
+            strBindAddress + " (maybe the port is already in use).", "Network Error" );
+    }
+
+    Encoder.Init ( iServerFrameSizeSamples, iBitRateKbps );
+
+    QObject::connect ( &TcpServer, &QTcpServer::newConnection,
+        this, &CStreamOutput::OnNewConnection );
+
+    QObject::connect ( &Encoder, &CStreamEncoder::PageReady,
+        this, &CStreamOutput::OnPageReady, Qt::QueuedConnection );
+
+    // the encoding must not compete with the audio processing
+    Encoder.moveToThread ( &EncoderThread );
+    EncoderThread.start ( QThread::LowPriority );
+}
+
+void CStreamOutput::OnNewConnection()
+{
+    while ( TcpServer.hasPendingConnections() )
+    {
+        QTcpSocket* pSocket = TcpServer.nextPendingConnection();
+
+        QObject::connect ( pSocket, &QTcpSocket::readyRead,
+            this, &CStreamOutput::OnReadyRead );
+
+        QObject::connect ( pSocket, &QTcpSocket::disconnected,
+            this, &CStreamOutput::OnDisconnected );
+    }
+}
+
+void CStreamOutput::OnReadyRead()
+{
+    QTcpSocket* pSocket = qobject_cast<QTcpSocket*> ( sender() );
+
+    if ( pSocket == nullptr )
+    {
+        return;
+    }
+
+    // only the request line is evaluated, the header fields are ignored
+    if ( !pSocket->canReadLine() )
+    {
+        if ( pSocket->bytesAvailable() > STREAM_MAX_REQUEST_SIZE )
+        {
+            pSocket->abort();
+        }
+        return;
+    }
+
+    const QList<QByteArray> vecRequest = pSocket->readLine ( STREAM_MAX_REQUEST_SIZE ).trimmed().split ( ' ' );
+
+    // further data of the listener is ignored
+    QObject::disconnect ( pSocket, &QTcpSocket::readyRead,
+        this, &CStreamOutput::OnReadyRead );
+
+    if ( ( vecRequest.size() < 2 ) ||
+         ( vecRequest[0] != "GET" ) ||
+         ( ( vecRequest[1] != "/" ) && ( vecRequest[1] != "/stream.opus" ) ) )
+    {
+        pSocket->write ( "HTTP/1.0 404 Not Found\r\n"
+                         "Content-Type: text/plain; charset=utf-8\r\n"
+                         "Connection: close\r\n"
+                         "\r\n"
+                         "Not Found\n" );
+        pSocket->disconnectFromHost();
+        return;
+    }
+
+    if ( vecpListeners.size() >= STREAM_MAX_NUM_LISTENERS )
+    {
+        pSocket->write ( "HTTP/1.0 503 Service Unavailable\r\n"
+                         "Content-Type: text/plain; charset=utf-8\r\n"
+                         "Connection: close\r\n"
+                         "\r\n"
+                         "Too many listeners\n" );
+        pSocket->disconnectFromHost();
+        return;
+    }
+
+    // the stream has no length, it ends when the connection is closed, a new
+    // listener gets the header pages and then the current audio pages
+    pSocket->write ( "HTTP/1.0 200 OK\r\n"
+                     "Content-Type: audio/ogg\r\n"
+                     "Cache-Control: no-cache, no-store\r\n"
+                     "Connection: close\r\n"
+                     "\r\n" );
+    pSocket->write ( Encoder.GetHeaderPages() );
+
+    vecpListeners.append ( pSocket );
+    iNumListeners.storeRelease ( vecpListeners.size() );
+}
+
+void CStreamOutput::OnDisconnected()
+{
+    QTcpSocket* pSocket = qobject_cast<QTcpSocket*> ( sender() );
+
+    if ( pSocket != nullptr )
+    {
+        RemoveListener ( pSocket );
+    }
+}
+
+void CStreamOutput::RemoveListener ( QTcpSocket* pSocket )
+{
+    QObject::disconnect ( pSocket, nullptr, this, nullptr );
+
+    vecpListeners.removeAll ( pSocket );
+    iNumListeners.storeRelease ( vecpListeners.size() );
+
+    pSocket->deleteLater();
+}
+
+void CStreamOutput::OnPageReady ( QByteArray vecbyPage )
+{
+    // the page data is shared by all listeners (no copy per listener)
+    for ( int i = vecpListeners.size() - 1; i >= 0; i-- )
+    {
+        QTcpSocket* pSocket = vecpListeners[i];
+
+        if ( pSocket->bytesToWrite() > STREAM_MAX_LISTENER_BACKLOG )
+        {
+            // the listener cannot keep up with the stream
+            RemoveListener ( pSocket );
+            pSocket->abort();
+        }
+        else
+        {
+            pSocket->write ( vecbyPage );
+        }
+    }
+}
@@ -0,0 +1,194 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QAtomicInt>
+#ifdef USE_OPUS_SHARED_LIB
+# include "opus/opus.h"
+#else
+# include "opus.h"
+#endif
+#include "global.h"
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// the stream is coded with the standard OPUS API in frames of 20 ms
+#define STREAM_OPUS_FRAME_SIZE_SAMPLES   960
+#define STREAM_DEFAULT_BITRATE_KBPS      128
+#define STREAM_MIN_BITRATE_KBPS          32
+#define STREAM_MAX_BITRATE_KBPS          320
+
+// number of OPUS packets in one Ogg page (a page is sent to the listeners at
+// once, i.e. this adds to the delay of the stream which is not relevant for
+// an audience)
+#define STREAM_NUM_PACKETS_PER_PAGE      5
+
+// length of the queue of the server frames for the stream thread
+#define STREAM_QUEUE_LENGTH_MS           1000
+
+// a listener which cannot keep up with the stream is disconnected if this
+// amount of data is waiting in the socket buffer
+#define STREAM_MAX_LISTENER_BACKLOG      262144 // bytes
+
+#define STREAM_MAX_NUM_LISTENERS         500
+#define STREAM_MAX_REQUEST_SIZE          4096 // bytes
+
+
+/* Classes ********************************************************************/
+// Ogg encapsulation of an OPUS stream (RFC 7845), the pages are assembled
+// from complete packets only.
+class COggOpusPager
+{
+public:
+    COggOpusPager() : iSerial ( 0 ), iPageSeq ( 0 ) {}
+
+    void Init ( const quint32 iNSerial ) { iSerial = iNSerial; iPageSeq = 0; }
+
+    // the identification and comment header pages (the first two pages of
+    // the stream which each listener needs before the audio pages)
+    QByteArray CreateHeaderPages ( const int iNumChannels,
+                                   const int iPreSkip );
+
+    // one page with the given packets, the granule position is the number of
+    // samples (at 48 kHz) at the end of the last packet of the page
+    QByteArray CreatePage ( const QList<QByteArray>& vecPackets,
+                            const qint64             iGranulePos,
+                            const quint8             iHeaderType = 0 );
+
+protected:
+    static quint32 Crc32 ( const QByteArray& vecbyData );
+
+    quint32 iSerial;
+    quint32 iPageSeq;
+};
+
+
+// Encodes the master mix of the server in its own thread (the server timer
+// only copies the mix into a preallocated queue) and emits the Ogg pages.
+class CStreamEncoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    CStreamEncoder();
+    virtual ~CStreamEncoder();
+
+    // throws an error if the encoder cannot be created
+    void Init ( const int iNServerFrameSizeSamples,
+                const int iBitRateKbps );
+
+    const QByteArray& GetHeaderPages() const { return vecbyHeaderPages; }
+
+    // called by the server timer thread, the frame is dropped if the queue is
+    // full (interleaved stereo samples of the server frame size)
+    void PutFrame ( const int16_t* psData );
+
+protected:
+    void ProcessFrames();
+    void EncodePacket();
+
+    OpusEncoder*      pEncoder;
+    COggOpusPager     Pager;
+    QByteArray        vecbyHeaderPages;
+    int               iServerFrameSizeSamples;
+
+    // frame queue: single producer (server timer) and single consumer (stream
+    // thread), the positions run modulo twice the number of frames to
+    // distinguish full/empty
+    CVector<int16_t>  vecsQueue;
+    int               iQueueNumFrames;
+    QAtomicInt        iQueuePutPos;
+    QAtomicInt        iQueueGetPos;
+    QAtomicInt        iNotifyPending;
+    QAtomicInt        iNumDroppedFrames;
+
+    // only used by the stream thread
+    CVector<int16_t>  vecsPcm;
+    int               iPcmFill;
+    CVector<uint8_t>  vecbyPacket;
+    QList<QByteArray> vecPackets;
+    qint64            iGranulePos;
+
+signals:
+    void FramesAvailable();
+    void PageReady ( QByteArray vecbyPage );
+
+protected slots:
+    void OnFramesAvailable();
+};
+
+
+// Live stream of the master mix as Ogg/OPUS on a small embedded HTTP server
+// ("GET /stream.opus"). The mix is encoded once for all listeners, a page is
+// shared by all listener sockets (implicitly shared QByteArray).
+class CStreamOutput : public QObject
+{
+    Q_OBJECT
+
+public:
+    CStreamOutput();
+    virtual ~CStreamOutput();
+
+    // the address has the format [address:]port, if no address is given all
+    // interfaces are used (throws an error if the port cannot be used)
+    void Start ( const QString& strBindAddress,
+                 const int      iServerFrameSizeSamples,
+                 const int      iBitRateKbps );
+
+    bool IsEnabled() const { return TcpServer.isListening(); }
+
+    // can be called from any thread, the server only provides the mix if at
+    // least one listener is connected
+    bool HasListeners() const { return iNumListeners.loadAcquire() > 0; }
+    int  GetNumListeners() const { return iNumListeners.loadAcquire(); }
+
+    // called by the server timer thread
+    void PutFrame ( const int16_t* psData ) { Encoder.PutFrame ( psData ); }
+
+protected:
+    void RemoveListener ( QTcpSocket* pSocket );
+
+    QTcpServer         TcpServer;
+    QThread            EncoderThread;
+    CStreamEncoder     Encoder;
+    QList<QTcpSocket*> vecpListeners;
+    QAtomicInt         iNumListeners;
+
+public slots:
+    void OnNewConnection();
+    void OnReadyRead();
+    void OnDisconnected();
+    void OnPageReady ( QByteArray vecbyPage );
+};
@@ -0,0 +1,111 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QAtomicInt>
+#include <cstring>
+#include <type_traits>
+
+
+/* Classes ********************************************************************/
+// Telemetry snapshot: a small state of a real-time thread (e.g. the signal
+// levels of the last block) which is published once per block and read by the
+// GUI, logging and metrics on other threads. The snapshot is protected by a
+// sequence lock, i.e. the writer never waits: it makes the sequence number odd,
+// stores the data and makes it even again. A reader retries if the sequence
+// number was odd or has changed while it copied the data, so it always gets
+// the complete state of one block. The data is stored in atomic words with
+// release/acquire semantics which makes the concurrent copy well defined.
+// There must only be one writer at a time (e.g. the writers hold the same
+// mutex or the audio is stopped while another thread publishes).
+template<class TData>
+class CTelemetrySnapshot
+{
+    static_assert ( std::is_trivially_copyable<TData>::value,
+                    "the telemetry data must be trivially copyable" );
+
+public:
+    CTelemetrySnapshot() : iSequence ( 0 ) { Publish ( TData() ); }
+
+    // writer (real-time thread)
+    void Publish ( const TData& Data )
+    {
+        int viWords[NUM_WORDS] = {};
+
+        memcpy ( viWords, &Data, sizeof ( TData ) );
+
+        const int iSeq = iSequence.loadAcquire();
+
+        iSequence.storeRelease ( iSeq + 1 );
+
+        for ( int i = 0; i < NUM_WORDS; i++ )
+        {
+            viData[i].storeRelease ( viWords[i] );
+        }
+
+        iSequence.storeRelease ( iSeq + 2 );
+    }
+
+    // reader (any thread), the writer only holds the sequence number odd for
+    // the few stores of the data, i.e. the retries are very rare
+    TData Read() const
+    {
+        int viWords[NUM_WORDS];
+        int iSeqBegin;
+
+        do
+        {
+            iSeqBegin = iSequence.loadAcquire();
+
+            for ( int i = 0; i < NUM_WORDS; i++ )
+            {
+                viWords[i] = viData[i].loadAcquire();
+            }
+        } while ( ( iSeqBegin & 1 ) || ( iSequence.loadAcquire() != iSeqBegin ) );
+
+        TData Data;
+        memcpy ( &Data, viWords, sizeof ( TData ) );
+        return Data;
+    }
+
+protected:
+    enum { NUM_WORDS = ( sizeof ( TData ) + sizeof ( int ) - 1 ) / sizeof ( int ) };
+
+    QAtomicInt iSequence;
+    QAtomicInt viData[NUM_WORDS];
+};
+
+
+// The state of the audio processing of the client which is shown in the GUI.
+// The errors are counted (and not flagged) since the writer must not reset a
+// flag of the reader, the reader compares the counter with its last value.
+struct SClientTelemetry
+{
+    SClientTelemetry() : dMicLeveldBLeft ( 0.0 ), dMicLeveldBRight ( 0.0 ), iNumJitBufGetErrors ( 0 ) {}
+
+    double dMicLeveldBLeft;
+    double dMicLeveldBRight;
+    int    iNumJitBufGetErrors;
+};
@@ -334,19 +334,19 @@ public slots:
         }
     }
 
-    void OnSendProtMessage ( CVector<uint8_t> vecMessage )
+    void OnSendProtMessage ( CProtMessage Message )
     {
         UdpSocket.writeDatagram (
-            (const char*) &( (CVector<uint8_t>) vecMessage )[0],
-            vecMessage.Size(), QHostAddress ( sAddress ), iPort );
+            (const char*) Message.Data().data(),
+            Message.Size(), QHostAddress ( sAddress ), iPort );
 
         // reset protocol so that we do not have to wait for an acknowledge to
         // send the next message
         Protocol.Reset();
     }
 
-    void OnSendCLMessage ( CHostAddress, CVector<uint8_t> vecMessage )
+    void OnSendCLMessage ( CHostAddress, CProtMessage Message )
     {
-        OnSendProtMessage ( vecMessage );
+        OnSendProtMessage ( Message );
     }
 };
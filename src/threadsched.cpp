@@ -0,0 +1,307 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "threadsched.h"
+#include <QStringList>
+#include <QDebug>
+#include <algorithm>
+#if defined ( __linux__ ) && !defined ( ANDROID )
+# include <pthread.h>
+# include <sched.h>
+# include <string.h>
+# include <errno.h>
+# include <sys/mman.h>
+#endif
+#ifdef _WIN32
+# include <windows.h>
+# include <avrt.h>
+#endif
+
+
+/* Implementation *************************************************************/
+CThreadScheduling::SRoleConfig CThreadScheduling::Config[NUM_THREAD_ROLES];
+QAtomicInt                     CThreadScheduling::iReported[NUM_THREAD_ROLES];
+
+bool CThreadScheduling::SetConfig ( const EThreadRole eRole,
+                                    const QString&    strConfig )
+{
+    SRoleConfig NewConfig;
+
+    // split the CPU list
+    const int     iCpuSep     = strConfig.indexOf ( '@' );
+    const QString strSchedule = ( iCpuSep >= 0 ) ? strConfig.left ( iCpuSep ) : strConfig;
+
+    if ( ( iCpuSep >= 0 ) && !ParseCpuList ( strConfig.mid ( iCpuSep + 1 ), NewConfig.veciCpus ) )
+    {
+        return false;
+    }
+
+    // policy and priority
+    const QStringList slSchedule = strSchedule.split ( ':' );
+    const QString     strPolicy  = slSchedule[0].trimmed().toLower();
+
+    if ( slSchedule.size() > 2 )
+    {
+        return false;
+    }
+
+    if ( strPolicy.isEmpty() )
+    {
+        NewConfig.ePolicy = SP_DEFAULT;
+    }
+    else if ( strPolicy == "other" )
+    {
+        NewConfig.ePolicy = SP_OTHER;
+    }
+    else if ( strPolicy == "fifo" )
+    {
+        NewConfig.ePolicy = SP_FIFO;
+    }
+    else if ( strPolicy == "rr" )
+    {
+        NewConfig.ePolicy = SP_RR;
+    }
+    else
+    {
+        return false;
+    }
+
+    if ( slSchedule.size() == 2 )
+    {
+        bool bOk;
+        NewConfig.iPriority = slSchedule[1].toInt ( &bOk );
+
+        if ( !bOk || ( NewConfig.iPriority < 1 ) || ( NewConfig.iPriority > 99 ) ||
+             ( ( NewConfig.ePolicy != SP_FIFO ) && ( NewConfig.ePolicy != SP_RR ) ) )
+        {
+            return false;
+        }
+    }
+
+    NewConfig.bConfigured = true;
+    Config[eRole]         = NewConfig;
+
+    return true;
+}
+
+bool CThreadScheduling::ParseCpuList ( const QString& strCpuList,
+                                       CVector<int>&  veciCpus )
+{
+    const QStringList slItems = strCpuList.split ( ',' );
+
+    veciCpus.Init ( 0 );
+
+    for ( int i = 0; i < slItems.size(); i++ )
+    {
+        const QStringList slRange = slItems[i].split ( '-' );
+        bool              bFirstOk, bLastOk;
+
+        const int iFirst = slRange[0].trimmed().toInt ( &bFirstOk );
+        const int iLast  = ( slRange.size() == 2 ) ? slRange[1].trimmed().toInt ( &bLastOk ) : iFirst;
+
+        if ( slRange.size() == 1 )
+        {
+            bLastOk = bFirstOk;
+        }
+
+        if ( ( slRange.size() > 2 ) || !bFirstOk || !bLastOk ||
+             ( iFirst < 0 ) || ( iLast < iFirst ) || ( iLast >= MAX_NUM_THREAD_SCHED_CPUS ) )
+        {
+            return false;
+        }
+
+        for ( int iCpu = iFirst; iCpu <= iLast; iCpu++ )
+        {
+            veciCpus.Add ( iCpu );
+        }
+    }
+
+    return veciCpus.Size() > 0;
+}
+
+QString CThreadScheduling::GetConfigDescription ( const EThreadRole eRole )
+{
+    const SRoleConfig& CurConfig = Config[eRole];
+    QString            strDesc   = GetRoleName ( eRole ) + " threads: " + GetPolicyName ( CurConfig.ePolicy );
+
+    if ( CurConfig.iPriority > 0 )
+    {
+        strDesc += QString ( " priority %1" ).arg ( CurConfig.iPriority );
+    }
+
+    if ( CurConfig.veciCpus.Size() > 0 )
+    {
+        QStringList slCpus;
+
+        for ( int i = 0; i < CurConfig.veciCpus.Size(); i++ )
+        {
+            slCpus << QString::number ( CurConfig.veciCpus[i] );
+        }
+
+        strDesc += ", CPUs " + slCpus.join ( "," );
+    }
+
+    return strDesc;
+}
+
+QString CThreadScheduling::LockMemory()
+{
+#if defined ( __linux__ ) && !defined ( ANDROID )
+    // avoids page faults in the real-time threads (this needs the permission to
+    // lock memory, e.g. a sufficient RLIMIT_MEMLOCK)
+    if ( mlockall ( MCL_CURRENT | MCL_FUTURE ) == 0 )
+    {
+        return "memory locked";
+    }
+
+    return QString ( "memory lock not granted (%1)" ).arg ( strerror ( errno ) );
+#else
+    return "memory lock not supported on this platform";
+#endif
+}
+
+void CThreadScheduling::ApplyToCurrentThread ( const EThreadRole eRole,
+                                               const int         iThreadIdx,
+                                               const int         iDefaultCpu )
+{
+    const SRoleConfig& CurConfig = Config[eRole];
+
+    // the timer thread tries to get the real-time scheduling even if nothing
+    // was configured (if we do not have the permission, the thread priority
+    // set by Qt is kept)
+    const EThreadSchedPolicy ePolicy =
+        ( !CurConfig.bConfigured && ( eRole == TR_TIMER ) ) ? SP_FIFO : CurConfig.ePolicy;
+
+    const int iCpu = ( CurConfig.veciCpus.Size() > 0 ) ?
+        CurConfig.veciCpus[std::max ( 0, iThreadIdx ) % CurConfig.veciCpus.Size()] : iDefaultCpu;
+
+    QString strResult;
+
+#if defined ( __linux__ ) && !defined ( ANDROID )
+    if ( ePolicy != SP_DEFAULT )
+    {
+        const int iPolicy = ( ePolicy == SP_FIFO ) ? SCHED_FIFO : ( ( ePolicy == SP_RR ) ? SCHED_RR : SCHED_OTHER );
+
+        sched_param SchedParam;
+        SchedParam.sched_priority = ( ePolicy == SP_OTHER ) ? 0 :
+            ( ( CurConfig.iPriority > 0 ) ? CurConfig.iPriority : sched_get_priority_max ( iPolicy ) );
+
+        const int iRet = pthread_setschedparam ( pthread_self(), iPolicy, &SchedParam );
+
+        strResult += QString ( "%1 priority %2 %3" ).
+            arg ( GetPolicyName ( ePolicy ) ).
+            arg ( SchedParam.sched_priority ).
+            arg ( ( iRet == 0 ) ? QString ( "granted" ) : QString ( "not granted (%1)" ).arg ( strerror ( iRet ) ) );
+    }
+
+    if ( iCpu >= 0 )
+    {
+        cpu_set_t CpuSet;
+        CPU_ZERO ( &CpuSet );
+        CPU_SET ( iCpu, &CpuSet );
+
+        const int iRet = pthread_setaffinity_np ( pthread_self(), sizeof ( cpu_set_t ), &CpuSet );
+
+        strResult += QString ( "%1CPU %2 %3" ).
+            arg ( strResult.isEmpty() ? "" : ", " ).
+            arg ( iCpu ).
+            arg ( ( iRet == 0 ) ? QString ( "granted" ) : QString ( "not granted (%1)" ).arg ( strerror ( iRet ) ) );
+    }
+#elif defined ( _WIN32 )
+    if ( ( ePolicy == SP_FIFO ) || ( ePolicy == SP_RR ) )
+    {
+        // the MMCSS boosts the thread as long as it is registered, i.e. for the
+        // lifetime of the thread
+        DWORD        dwTaskIndex = 0;
+        const HANDLE hTask       = AvSetMmThreadCharacteristicsW ( L"Pro Audio", &dwTaskIndex );
+
+        if ( hTask != nullptr )
+        {
+            AvSetMmThreadPriority ( hTask, AVRT_PRIORITY_CRITICAL );
+        }
+
+        strResult += QString ( "MMCSS Pro Audio %1" ).arg ( ( hTask != nullptr ) ? "granted" : "not granted" );
+    }
+
+    // the affinity mask covers the CPUs of one processor group
+    if ( ( iCpu >= 0 ) && ( iCpu < 64 ) )
+    {
+        const bool bOk = SetThreadAffinityMask ( GetCurrentThread(), static_cast<DWORD_PTR> ( 1 ) << iCpu ) != 0;
+
+        strResult += QString ( "%1CPU %2 %3" ).
+            arg ( strResult.isEmpty() ? "" : ", " ).
+            arg ( iCpu ).
+            arg ( bOk ? "granted" : "not granted" );
+    }
+#else
+    Q_UNUSED ( ePolicy )
+    Q_UNUSED ( iCpu )
+
+    strResult = "not supported on this platform";
+#endif
+
+    // only the configured roles are reported, once per role
+    if ( CurConfig.bConfigured && !strResult.isEmpty() && iReported[eRole].testAndSetOrdered ( 0, 1 ) )
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+// TODO we should use the ConsoleWriterFactory() instead of qInfo()
+        qInfo() << qUtf8Printable ( QString ( "Scheduling of the %1 thread: %2" ).
+            arg ( GetRoleName ( eRole ).toLower() ).
+            arg ( strResult ) );
+#endif
+    }
+}
+
+QString CThreadScheduling::GetRoleName ( const EThreadRole eRole )
+{
+    switch ( eRole )
+    {
+    case TR_TIMER:
+        return "Timer";
+
+    case TR_SOCKET:
+        return "Socket";
+
+    default:
+        return "Worker";
+    }
+}
+
+QString CThreadScheduling::GetPolicyName ( const EThreadSchedPolicy ePolicy )
+{
+    switch ( ePolicy )
+    {
+    case SP_OTHER:
+        return "SCHED_OTHER";
+
+    case SP_FIFO:
+        return "SCHED_FIFO";
+
+    case SP_RR:
+        return "SCHED_RR";
+
+    default:
+        return "default";
+    }
+}
@@ -0,0 +1,105 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QAtomicInt>
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// highest CPU number of the CPU lists
+#define MAX_NUM_THREAD_SCHED_CPUS 1024
+
+// the threads with real-time requirements which can be configured
+enum EThreadRole
+{
+    TR_TIMER  = 0, // high precision timer (also runs the part of the worker pool)
+    TR_SOCKET = 1, // network receive threads
+    TR_WORKER = 2, // audio processing worker threads
+    NUM_THREAD_ROLES
+};
+
+enum EThreadSchedPolicy
+{
+    SP_DEFAULT = 0, // the priority set by Qt is kept
+    SP_OTHER   = 1, // normal scheduling
+    SP_FIFO    = 2, // real-time first in, first out
+    SP_RR      = 3  // real-time round robin
+};
+
+
+/* Classes ********************************************************************/
+// Scheduling configuration of the real-time threads. The configuration is set
+// once at startup (before any of the threads is started) and each thread
+// applies it to itself when it starts. The result of the first thread of each
+// configured role is reported on the console.
+// On Linux the policies are mapped to the POSIX scheduling policies and the
+// threads are pinned with their affinity mask, on Windows a real-time policy
+// registers the thread at the MMCSS with the "Pro Audio" task.
+class CThreadScheduling
+{
+public:
+    // the configuration of a role has the format [policy][:priority][@cpus],
+    // e.g. "fifo:80@2" or "@4-7,10" (policy: other, fifo or rr, without
+    // priority the maximum priority of the policy is used, the CPU list may
+    // contain ranges), returns false if the format is invalid
+    static bool SetConfig ( const EThreadRole eRole,
+                            const QString&    strConfig );
+
+    static QString GetConfigDescription ( const EThreadRole eRole );
+
+    // locks the current and the future memory pages of the process in the RAM
+    // (Linux only), returns a description of the result
+    static QString LockMemory();
+
+    // must be called by the thread itself, the threads of a role with several
+    // threads are pinned to one CPU of the list each (round robin with the
+    // thread index), without a configured CPU list the thread is pinned to the
+    // default CPU (-1: no pinning)
+    static void ApplyToCurrentThread ( const EThreadRole eRole,
+                                       const int         iThreadIdx,
+                                       const int         iDefaultCpu = -1 );
+
+protected:
+    struct SRoleConfig
+    {
+        SRoleConfig() : ePolicy ( SP_DEFAULT ), iPriority ( -1 ), bConfigured ( false ) {}
+
+        EThreadSchedPolicy ePolicy;
+        int                iPriority; // -1: maximum priority of the policy
+        CVector<int>       veciCpus;
+        bool               bConfigured;
+    };
+
+    static bool    ParseCpuList ( const QString& strCpuList,
+                                  CVector<int>&  veciCpus );
+
+    static QString GetRoleName ( const EThreadRole eRole );
+    static QString GetPolicyName ( const EThreadSchedPolicy ePolicy );
+
+    static SRoleConfig Config[NUM_THREAD_ROLES];
+    static QAtomicInt  iReported[NUM_THREAD_ROLES];
+};
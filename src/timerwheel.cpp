@@ -0,0 +1,279 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "timerwheel.h"
+#include <QCoreApplication>
+#include <algorithm>
+#include <limits>
+
+
+/* Implementation *************************************************************/
+// the OS timer wakes up at least once an hour (the interval of a QTimer is
+// limited), an early wake-up only advances the wheel
+#define TIMER_WHEEL_MAX_OS_TIMER_MS      3600000 // ms
+
+static const qint64 NO_TICK = std::numeric_limits<qint64>::max();
+
+CTimerWheel& CTimerWheel::Instance()
+{
+    static CTimerWheel TimerWheel;
+
+    return TimerWheel;
+}
+
+CTimerWheel::CTimerWheel() :
+    iNumTimers     ( 0 ),
+    iCurTick       ( 0 ),
+    iScheduledTick ( NO_TICK ),
+    OSTimer        ( this )
+{
+    ElapsedTimer.start();
+
+    OSTimer.setSingleShot ( true );
+    OSTimer.setTimerType ( Qt::PreciseTimer );
+
+    // the timers expire in the main thread (the wheel may be created by any
+    // thread), the OS timer is a child and is moved, too
+    if ( QCoreApplication::instance() != nullptr )
+    {
+        moveToThread ( QCoreApplication::instance()->thread() );
+    }
+
+
+    // Connections -------------------------------------------------------------
+    QObject::connect ( &OSTimer, &QTimer::timeout,
+        this, &CTimerWheel::OnTimer );
+}
+
+void CTimerWheel::Start ( CWheelTimer* pTimer,
+                          const int    iIntervalMs )
+{
+    bool bReschedule = false;
+
+    Mutex.lock();
+    {
+        if ( pTimer->bActive )
+        {
+            Remove ( pTimer );
+        }
+
+        // the expiry tick is the first tick at or after the expiry time, i.e.
+        // a timer never expires too early (the current tick of the wheel may
+        // lag behind the time if the OS timer sleeps)
+        const qint64 iIntervalTicks = std::max ( 1, ( iIntervalMs + TIMER_WHEEL_TICK_MS - 1 ) / TIMER_WHEEL_TICK_MS );
+        const qint64 iExpiryTickNow = ( ElapsedTimer.elapsed() + iIntervalMs + TIMER_WHEEL_TICK_MS - 1 ) / TIMER_WHEEL_TICK_MS;
+
+        pTimer->iExpiryTick  = std::max ( iExpiryTickNow, iCurTick + 1 );
+        pTimer->iPeriodTicks = pTimer->bSingleShot ? 0 : iIntervalTicks;
+
+        Insert ( pTimer );
+
+        if ( pTimer->iExpiryTick < iScheduledTick )
+        {
+            iScheduledTick = pTimer->iExpiryTick;
+            bReschedule    = true;
+        }
+    }
+    Mutex.unlock();
+
+    // the OS timer can only be started by the thread of the wheel (this is a
+    // direct call if we are in this thread)
+    if ( bReschedule )
+    {
+        QMetaObject::invokeMethod ( this, "OnReschedule", Qt::AutoConnection );
+    }
+}
+
+void CTimerWheel::Stop ( CWheelTimer* pTimer )
+{
+    QMutexLocker locker ( &Mutex );
+
+    // the OS timer is not stopped since an early wake-up does not hurt
+    if ( pTimer->bActive )
+    {
+        Remove ( pTimer );
+    }
+}
+
+bool CTimerWheel::IsActive ( const CWheelTimer* pTimer )
+{
+    QMutexLocker locker ( &Mutex );
+
+    return pTimer->bActive;
+}
+
+void CTimerWheel::Insert ( CWheelTimer* pTimer )
+{
+    qint64 iExpiryTick = pTimer->iExpiryTick;
+
+    // a timer beyond the range of the wheel is clamped to the last tick of the
+    // range (it expires early, but only after more than 100 days)
+    const int iRangeBits = TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_NUM_LEVELS;
+
+    if ( ( ( iExpiryTick ^ iCurTick ) >> iRangeBits ) != 0 )
+    {
+        iExpiryTick         = iCurTick | ( ( static_cast<qint64> ( 1 ) << iRangeBits ) - 1 );
+        pTimer->iExpiryTick = iExpiryTick;
+    }
+
+    // the level is given by the highest slot index in which the expiry tick
+    // differs from the current tick
+    int iLevel = 0;
+
+    while ( ( iLevel < TIMER_WHEEL_NUM_LEVELS - 1 ) &&
+            ( ( ( iExpiryTick ^ iCurTick ) >> ( TIMER_WHEEL_SLOT_BITS * ( iLevel + 1 ) ) ) != 0 ) )
+    {
+        iLevel++;
+    }
+
+    pTimer->iSlot = iLevel * TIMER_WHEEL_NUM_SLOTS +
+        static_cast<int> ( ( iExpiryTick >> ( TIMER_WHEEL_SLOT_BITS * iLevel ) ) & ( TIMER_WHEEL_NUM_SLOTS - 1 ) );
+
+    pTimer->itSlotEntry = Slots[pTimer->iSlot].insert ( Slots[pTimer->iSlot].end(), pTimer );
+    pTimer->bActive     = true;
+    iNumTimers++;
+}
+
+void CTimerWheel::Remove ( CWheelTimer* pTimer )
+{
+    Slots[pTimer->iSlot].erase ( pTimer->itSlotEntry );
+    pTimer->bActive = false;
+    iNumTimers--;
+}
+
+void CTimerWheel::Cascade ( const int iLevel )
+{
+    // the timers of the current slot of this level expire within the slot of
+    // the level below, they are distributed on the lower levels
+    TSlot Timers;
+
+    Timers.swap ( Slots[iLevel * TIMER_WHEEL_NUM_SLOTS +
+        static_cast<int> ( ( iCurTick >> ( TIMER_WHEEL_SLOT_BITS * iLevel ) ) & ( TIMER_WHEEL_NUM_SLOTS - 1 ) )] );
+
+    for ( TSlot::iterator it = Timers.begin(); it != Timers.end(); ++it )
+    {
+        iNumTimers--;
+        Insert ( *it );
+    }
+}
+
+qint64 CTimerWheel::GetNextEventTick() const
+{
+    qint64 iNextTick = NO_TICK;
+
+    if ( iNumTimers == 0 )
+    {
+        return iNextTick;
+    }
+
+    // the slots of a level only hold timers of the current slot of the level
+    // above, i.e. only the slots up to the end of the level have to be checked
+    for ( int iLevel = 0; iLevel < TIMER_WHEEL_NUM_LEVELS; iLevel++ )
+    {
+        const int    iShift  = TIMER_WHEEL_SLOT_BITS * iLevel;
+        const qint64 iCurIdx = iCurTick >> iShift;
+
+        for ( qint64 iIdx = iCurIdx + 1; ( iIdx & ( TIMER_WHEEL_NUM_SLOTS - 1 ) ) != 0; iIdx++ )
+        {
+            if ( !Slots[iLevel * TIMER_WHEEL_NUM_SLOTS + static_cast<int> ( iIdx & ( TIMER_WHEEL_NUM_SLOTS - 1 ) )].empty() )
+            {
+                // the slot of a higher level is processed at its first tick
+                iNextTick = std::min ( iNextTick, iIdx << iShift );
+                break;
+            }
+        }
+    }
+
+    return iNextTick;
+}
+
+void CTimerWheel::OnTimer()
+{
+    Mutex.lock();
+    {
+        const qint64 iNowTick = GetNowTick();
+
+        while ( iCurTick < iNowTick )
+        {
+            // skip the ticks at which nothing happens
+            iCurTick = std::max ( iCurTick, std::min ( iNowTick, GetNextEventTick() ) - 1 ) + 1;
+
+            // distribute the slots of the higher levels which begin at this tick
+            for ( int iLevel = TIMER_WHEEL_NUM_LEVELS - 1; iLevel > 0; iLevel-- )
+            {
+                if ( ( iCurTick & ( ( static_cast<qint64> ( 1 ) << ( TIMER_WHEEL_SLOT_BITS * iLevel ) ) - 1 ) ) == 0 )
+                {
+                    Cascade ( iLevel );
+                }
+            }
+
+            // all timers of the current slot of the lowest level expire now (a
+            // timeout slot may start or stop any timer, a restarted timer is
+            // never inserted in the current slot)
+            TSlot& CurSlot = Slots[static_cast<int> ( iCurTick & ( TIMER_WHEEL_NUM_SLOTS - 1 ) )];
+
+            while ( !CurSlot.empty() )
+            {
+                CWheelTimer* pTimer = CurSlot.front();
+
+                Remove ( pTimer );
+
+                // a periodic timer which expired late does not catch up
+                if ( pTimer->iPeriodTicks > 0 )
+                {
+                    pTimer->iExpiryTick = iNowTick + pTimer->iPeriodTicks;
+                    Insert ( pTimer );
+                }
+
+                Mutex.unlock();
+                {
+                    pTimer->EmitTimeout();
+                }
+                Mutex.lock();
+            }
+        }
+    }
+    Mutex.unlock();
+
+    OnReschedule();
+}
+
+void CTimerWheel::OnReschedule()
+{
+    QMutexLocker locker ( &Mutex );
+
+    iScheduledTick = GetNextEventTick();
+
+    if ( iScheduledTick == NO_TICK )
+    {
+        OSTimer.stop();
+    }
+    else
+    {
+        const qint64 iWaitMs = iScheduledTick * TIMER_WHEEL_TICK_MS - ElapsedTimer.elapsed();
+
+        OSTimer.start ( static_cast<int> ( std::max ( static_cast<qint64> ( 0 ),
+            std::min ( iWaitMs, static_cast<qint64> ( TIMER_WHEEL_MAX_OS_TIMER_MS ) ) ) ) );
+    }
+}
@@ -0,0 +1,140 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <list>
+
+
+/* Definitions ****************************************************************/
+// resolution of the timer wheel
+#define TIMER_WHEEL_TICK_MS              10 // ms
+
+// each level of the wheel has 2^TIMER_WHEEL_SLOT_BITS slots, a slot of a level
+// covers all slots of the level below, i.e. the 5 levels cover 64^5 ticks
+// (about 124 days with 10 ms ticks)
+#define TIMER_WHEEL_SLOT_BITS            6
+#define TIMER_WHEEL_NUM_SLOTS            ( 1 << TIMER_WHEEL_SLOT_BITS )
+#define TIMER_WHEEL_NUM_LEVELS           5
+
+
+/* Classes ********************************************************************/
+class CWheelTimer;
+
+// Hierarchical timer wheel which drives all the timers of the protocol and of
+// the server list with a single OS timer. The OS timer only fires for the
+// ticks at which a timer expires or a slot of a higher level is redistributed
+// on the levels below, i.e. there are no periodic wake-ups if only the long
+// timers (e.g. the registration refresh) are pending.
+// The timers may be started and stopped by any thread, they expire in the
+// main thread (where the wheel lives).
+class CTimerWheel : public QObject
+{
+    Q_OBJECT
+
+public:
+    static CTimerWheel& Instance();
+
+    void Start ( CWheelTimer* pTimer,
+                 const int    iIntervalMs );
+
+    void Stop ( CWheelTimer* pTimer );
+
+    bool IsActive ( const CWheelTimer* pTimer );
+
+protected:
+    CTimerWheel();
+
+    typedef std::list<CWheelTimer*> TSlot;
+
+    qint64 GetNowTick() const { return ElapsedTimer.elapsed() / TIMER_WHEEL_TICK_MS; }
+
+    // the mutex must be locked by the caller for the following functions
+    void   Insert ( CWheelTimer* pTimer );
+    void   Remove ( CWheelTimer* pTimer );
+    void   Cascade ( const int iLevel );
+    qint64 GetNextEventTick() const;
+
+    // the slots of all levels: [level * TIMER_WHEEL_NUM_SLOTS + slot]
+    TSlot         Slots[TIMER_WHEEL_NUM_LEVELS * TIMER_WHEEL_NUM_SLOTS];
+    int           iNumTimers;
+    qint64        iCurTick;
+    qint64        iScheduledTick;
+
+    QTimer        OSTimer;
+    QElapsedTimer ElapsedTimer;
+    QMutex        Mutex;
+
+protected slots:
+    void OnTimer();
+    void OnReschedule();
+};
+
+
+// A timer which is driven by the timer wheel, it has the same semantics as a
+// QTimer (a restart of an active timer reschedules it) with a resolution of
+// TIMER_WHEEL_TICK_MS.
+class CWheelTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    CWheelTimer() : iIntervalMs ( 0 ), bSingleShot ( false ), bActive ( false ),
+        iExpiryTick ( 0 ), iPeriodTicks ( 0 ), iSlot ( 0 ) {}
+
+    virtual ~CWheelTimer() { Stop(); }
+
+    void SetInterval ( const int iNewIntervalMs ) { iIntervalMs = iNewIntervalMs; }
+    int  GetInterval() const { return iIntervalMs; }
+
+    void SetSingleShot ( const bool bNewSingleShot ) { bSingleShot = bNewSingleShot; }
+
+    void Start() { CTimerWheel::Instance().Start ( this, iIntervalMs ); }
+    void Start ( const int iNewIntervalMs ) { iIntervalMs = iNewIntervalMs; Start(); }
+    void Stop() { CTimerWheel::Instance().Stop ( this ); }
+
+    bool IsActive() const { return CTimerWheel::Instance().IsActive ( this ); }
+
+protected:
+    friend class CTimerWheel;
+
+    void EmitTimeout() { emit timeout(); }
+
+    int                               iIntervalMs;
+    bool                              bSingleShot;
+
+    // state in the wheel (protected by the mutex of the wheel)
+    bool                              bActive;
+    qint64                            iExpiryTick;
+    qint64                            iPeriodTicks;
+    int                               iSlot;
+    std::list<CWheelTimer*>::iterator itSlotEntry;
+
+signals:
+    void timeout();
+};
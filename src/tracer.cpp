@@ -0,0 +1,299 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "tracer.h"
+#include <QFile>
+#include <QTextStream>
+#include <QCoreApplication>
+#include <QDebug>
+#include <algorithm>
+#if defined ( __linux__ ) && !defined ( ANDROID )
+# include <unistd.h>
+# include <sys/syscall.h>
+#endif
+
+
+// Tracer implementation *******************************************************
+bool                   CTracer::bInitialized = false;
+QString                CTracer::strFileName;
+QElapsedTimer          CTracer::Clock;
+QAtomicInt             CTracer::iRunning ( 0 );
+CTracer::SThreadBuffer CTracer::ThreadBuffers[TRACE_MAX_NUM_THREADS];
+QAtomicInt             CTracer::iNumThreadBuffers ( 0 );
+QAtomicInt             CTracer::iNumUntracedThreads ( 0 );
+thread_local int       CTracer::iThreadBufferIdx = -1;
+
+// the event names in the trace (same order as ETracePoint)
+static const char* pcTracePointNames[NUM_TRACE_POINTS] = {
+    "frame",
+    "collect",
+    "decode",
+    "common mix",
+    "levels",
+    "mix encode",
+    "send",
+    "tick events",
+    "worker items",
+    "receive",
+    "protocol",
+    "recorder write",
+    "sound callback" };
+
+void CTracer::Init ( const QString& strNFileName )
+{
+    // check that the file can be written before the tracing starts
+    QFile File ( strNFileName );
+
+    if ( !File.open ( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        throw CGenErr ( "Cannot create the trace file " + strNFileName );
+    }
+
+    File.close();
+
+    strFileName = strNFileName;
+
+    for ( int i = 0; i < TRACE_MAX_NUM_THREADS; i++ )
+    {
+        ThreadBuffers[i].veciEvents.Init ( TRACE_BUFFER_NUM_EVENTS );
+    }
+
+    Clock.start();
+    bInitialized = true;
+
+    SetThreadName ( "main" );
+    Start();
+
+    // the trace of a running tracing is written on quit
+    QObject::connect ( QCoreApplication::instance(), &QCoreApplication::aboutToQuit, [] ()
+        {
+            if ( IsRunning() )
+            {
+                Stop();
+            }
+        } );
+}
+
+void CTracer::Start()
+{
+    if ( !bInitialized || IsRunning() )
+    {
+        return;
+    }
+
+    // the events of the previous trace are discarded
+    for ( int i = 0; i < TRACE_MAX_NUM_THREADS; i++ )
+    {
+        ThreadBuffers[i].iNextPos.storeRelease ( 0 );
+        ThreadBuffers[i].iWrapped.storeRelease ( 0 );
+    }
+
+    iRunning.storeRelease ( 1 );
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+// TODO we should use the ConsoleWriterFactory() instead of qInfo()
+    qInfo() << "Tracing started";
+#endif
+}
+
+void CTracer::Stop()
+{
+    if ( !IsRunning() )
+    {
+        return;
+    }
+
+    // a thread which is just recording an event may still write it after this
+    // point, this only affects the last event of this thread in the trace
+    iRunning.storeRelease ( 0 );
+
+    WriteFile();
+}
+
+void CTracer::SetThreadName ( const char* pcName,
+                              const int   iThreadIdx )
+{
+    if ( !bInitialized )
+    {
+        return;
+    }
+
+    const int iIdx = GetThreadBufferIdx();
+
+    if ( iIdx >= 0 )
+    {
+        ThreadBuffers[iIdx].pcName   = pcName;
+        ThreadBuffers[iIdx].iNameIdx = iThreadIdx;
+    }
+}
+
+int CTracer::GetThreadBufferIdx()
+{
+    if ( iThreadBufferIdx == -1 )
+    {
+        // the buffers are taken once per thread and never given back (the
+        // number of threads of the application is limited)
+        const int iIdx = iNumThreadBuffers.fetchAndAddOrdered ( 1 );
+
+        if ( iIdx < TRACE_MAX_NUM_THREADS )
+        {
+#if defined ( __linux__ ) && !defined ( ANDROID )
+            // the kernel thread ID allows to combine the trace with a system
+            // trace of the scheduler
+            ThreadBuffers[iIdx].iThreadId = static_cast<qint64> ( syscall ( SYS_gettid ) );
+#else
+            ThreadBuffers[iIdx].iThreadId = iIdx + 1;
+#endif
+            iThreadBufferIdx = iIdx;
+        }
+        else
+        {
+            iNumUntracedThreads.fetchAndAddOrdered ( 1 );
+            iThreadBufferIdx = -2;
+        }
+    }
+
+    return ( iThreadBufferIdx >= 0 ) ? iThreadBufferIdx : -1;
+}
+
+void CTracer::AddEvent ( const ETracePoint ePoint,
+                         const bool        bBegin )
+{
+    const int iIdx = GetThreadBufferIdx();
+
+    if ( iIdx < 0 )
+    {
+        return;
+    }
+
+    SThreadBuffer& Buffer = ThreadBuffers[iIdx];
+    int            iPos   = Buffer.iNextPos.loadAcquire();
+
+    Buffer.veciEvents[iPos] = ( static_cast<quint64> ( Clock.nsecsElapsed() ) << 8 ) |
+                              ( static_cast<quint64> ( ePoint ) << 1 ) |
+                              ( bBegin ? 1 : 0 );
+
+    if ( ++iPos == TRACE_BUFFER_NUM_EVENTS )
+    {
+        iPos = 0;
+        Buffer.iWrapped.storeRelease ( 1 );
+    }
+
+    Buffer.iNextPos.storeRelease ( iPos );
+}
+
+void CTracer::WriteFile()
+{
+    QFile File ( strFileName );
+
+    if ( !File.open ( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) )
+    {
+        qWarning() << qUtf8Printable ( QString ( "Cannot write the trace file %1" ).arg ( strFileName ) );
+        return;
+    }
+
+    QTextStream Stream ( &File );
+    const qint64 iPid       = QCoreApplication::applicationPid();
+    const int    iNumBuffers = std::min ( iNumThreadBuffers.loadAcquire(), TRACE_MAX_NUM_THREADS );
+    int          iNumEvents  = 0;
+    bool         bFirst      = true;
+
+    Stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+    for ( int i = 0; i < iNumBuffers; i++ )
+    {
+        const SThreadBuffer& Buffer = ThreadBuffers[i];
+        const int            iPos   = Buffer.iNextPos.loadAcquire();
+        const bool           bWrap  = Buffer.iWrapped.loadAcquire() != 0;
+        const int            iStart = bWrap ? iPos : 0;
+        const int            iNum   = bWrap ? TRACE_BUFFER_NUM_EVENTS : iPos;
+
+        if ( iNum == 0 )
+        {
+            continue;
+        }
+
+        // the thread name is given as metadata event
+        const QString strName = ( Buffer.pcName != nullptr ) ?
+            QString ( "%1 %2" ).arg ( Buffer.pcName ).arg ( Buffer.iNameIdx ) :
+            QString ( "thread %1" ).arg ( i );
+
+        Stream << ( bFirst ? "" : ",\n" ) <<
+            QString ( "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%1,\"tid\":%2,\"args\":{\"name\":\"%3\"}}" ).
+            arg ( iPid ).arg ( Buffer.iThreadId ).arg ( strName );
+
+        bFirst = false;
+
+        // the end events at the start of a wrapped buffer have no begin event
+        // and are skipped
+        int iDepth = 0;
+
+        for ( int j = 0; j < iNum; j++ )
+        {
+            const quint64 iEvent = Buffer.veciEvents[( iStart + j ) % TRACE_BUFFER_NUM_EVENTS];
+            const bool    bBegin = ( iEvent & 1 ) != 0;
+            const int     iPoint = static_cast<int> ( ( iEvent >> 1 ) & 0x7F );
+
+            if ( bBegin )
+            {
+                iDepth++;
+            }
+            else if ( iDepth > 0 )
+            {
+                iDepth--;
+            }
+            else
+            {
+                continue;
+            }
+
+            if ( iPoint >= NUM_TRACE_POINTS )
+            {
+                continue;
+            }
+
+            // the time stamps are given in us
+            Stream << QString ( ",\n{\"name\":\"%1\",\"ph\":\"%2\",\"ts\":%3,\"pid\":%4,\"tid\":%5}" ).
+                arg ( pcTracePointNames[iPoint] ).arg ( bBegin ? "B" : "E" ).
+                arg ( static_cast<double> ( iEvent >> 8 ) / 1000, 0, 'f', 3 ).arg ( iPid ).arg ( Buffer.iThreadId );
+
+            iNumEvents++;
+        }
+    }
+
+    Stream << "\n]}\n";
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+// TODO we should use the ConsoleWriterFactory() instead of qInfo()
+    qInfo() << qUtf8Printable ( QString ( "Tracing stopped: %1 events of %2 threads written to %3" ).
+        arg ( iNumEvents ).arg ( iNumBuffers ).arg ( strFileName ) );
+#endif
+
+    if ( iNumUntracedThreads.loadAcquire() > 0 )
+    {
+        qWarning() << qUtf8Printable ( QString ( "Tracing: %1 threads were not traced (more than %2 threads)" ).
+            arg ( iNumUntracedThreads.loadAcquire() ).arg ( TRACE_MAX_NUM_THREADS ) );
+    }
+}
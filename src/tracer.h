@@ -0,0 +1,152 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QString>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// The tracer records the begin and end of the processing steps of the real-time
+// threads ("--trace") and writes them as Chrome JSON trace file which can be
+// displayed by Perfetto (ui.perfetto.dev) or chrome://tracing. Each thread
+// writes in its own preallocated ring buffer, i.e. recording an event does not
+// lock or allocate and the last events before the stop are kept.
+#define TRACE_MAX_NUM_THREADS    32
+#define TRACE_BUFFER_NUM_EVENTS  131072 // per thread (8 bytes per event)
+
+// the traced processing steps
+enum ETracePoint
+{
+    TP_SERVER_FRAME       = 0,  // complete frame of the server timer
+    TP_SERVER_COLLECT     = 1,  // locked collection of the channel data
+    TP_SERVER_DECODE      = 2,  // decoding of all clients
+    TP_SERVER_COMMON_MIX  = 3,  // common mix (and recording of the mix)
+    TP_SERVER_LEVELS      = 4,  // level meter calculation
+    TP_SERVER_MIX_ENCODE  = 5,  // mix, encode and queue the packets
+    TP_SERVER_SEND        = 6,  // send all queued packets
+    TP_SERVER_TICK_EVENTS = 7,  // events of the frame after the send
+    TP_WORKER_ITEMS       = 8,  // share of a thread of a parallel stage
+    TP_SOCKET_RECEIVE     = 9,  // processing of a batch of received packets
+    TP_PROTOCOL           = 10, // delivery of the received protocol messages
+    TP_RECORDER_WRITE     = 11, // writing the recorded frames to the files
+    TP_SOUND_CALLBACK     = 12, // processing of a sound card block
+    NUM_TRACE_POINTS
+};
+
+// the step of the enclosing scope is traced
+#define TRACE_SCOPE(point) CTraceScope TraceScope ( point )
+
+
+/* Classes ********************************************************************/
+class CTracer
+{
+public:
+    // allocates the buffers and starts the tracing, must be called by the main
+    // thread before the traced threads are started (throws an error if the
+    // trace file cannot be created)
+    static void Init ( const QString& strNFileName );
+
+    static bool IsInitialized() { return bInitialized; }
+    static bool IsRunning() { return iRunning.loadAcquire() != 0; }
+
+    // the tracing can be started and stopped at runtime (main thread only),
+    // the stop writes the trace file (a new start overwrites the file of the
+    // previous trace on the next stop)
+    static void Start();
+    static void Stop();
+    static void Toggle() { IsRunning() ? Stop() : Start(); }
+
+    // the name is shown for the thread in the trace, the name must be a string
+    // literal (not copied)
+    static void SetThreadName ( const char* pcName,
+                                const int   iThreadIdx = 0 );
+
+    static void Begin ( const ETracePoint ePoint )
+    {
+        if ( IsRunning() )
+        {
+            AddEvent ( ePoint, true );
+        }
+    }
+
+    static void End ( const ETracePoint ePoint )
+    {
+        if ( IsRunning() )
+        {
+            AddEvent ( ePoint, false );
+        }
+    }
+
+protected:
+    // an event is stored as one 64 bit value: [time in ns since the init]
+    // [7 bits trace point] [1 bit begin flag]
+    struct SThreadBuffer
+    {
+        SThreadBuffer() : iNextPos ( 0 ), iWrapped ( 0 ), iThreadId ( 0 ),
+            pcName ( nullptr ), iNameIdx ( 0 ) {}
+
+        CVector<quint64> veciEvents;
+        QAtomicInt       iNextPos;
+        QAtomicInt       iWrapped;
+        qint64           iThreadId;
+        const char*      pcName;
+        int              iNameIdx;
+    };
+
+    static void AddEvent ( const ETracePoint ePoint,
+                           const bool        bBegin );
+
+    // returns the buffer index of the current thread, -1 if all buffers are
+    // taken
+    static int GetThreadBufferIdx();
+
+    static void WriteFile();
+
+    static bool          bInitialized;
+    static QString       strFileName;
+    static QElapsedTimer Clock;
+    static QAtomicInt    iRunning;
+    static SThreadBuffer ThreadBuffers[TRACE_MAX_NUM_THREADS];
+    static QAtomicInt    iNumThreadBuffers;
+    static QAtomicInt    iNumUntracedThreads;
+
+    // buffer index of the thread (-1: not yet assigned, -2: no buffer left)
+    static thread_local int iThreadBufferIdx;
+};
+
+// traces the enclosing scope
+class CTraceScope
+{
+public:
+    CTraceScope ( const ETracePoint eNPoint ) : ePoint ( eNPoint ) { CTracer::Begin ( ePoint ); }
+    ~CTraceScope() { CTracer::End ( ePoint ); }
+
+protected:
+    const ETracePoint ePoint;
+};
@@ -24,42 +24,38 @@
 
 #include "util.h"
 #include "client.h"
+#include "mixkernel.h"
 
 
 /* Implementation *************************************************************/
 // Input level meter implementation --------------------------------------------
-void CStereoSignalLevelMeter::Update ( const CVector<short>& vecsAudio )
+void CStereoSignalLevelMeter::Update ( const short* psAudio,
+                                      const int    iStereoVecSize )
 {
-    // get the stereo vector size
-    const int iStereoVecSize = vecsAudio.Size();
+    // get the maximum of the current block (the vectorized kernel evaluates
+    // all samples of both polarities)
+    int16_t sMaxL;
+    int16_t sMaxR;
 
-    // Get maximum of current block
-    //
-    // Speed optimization:
-    // - we only make use of the positive values and ignore the negative ones
-    //   -> we do not need to call the fabs() function
-    // - we only evaluate every third sample
-    //
-    // With these speed optimizations we might loose some information in
-    // special cases but for the average music signals the following code
-    // should give good results.
-    //
-    short sMaxL = 0;
-    short sMaxR = 0;
-
-    for ( int i = 0; i < iStereoVecSize; i += 6 ) // 2 * 3 = 6 -> stereo
-    {
-        // left channel
-        sMaxL = std::max ( sMaxL, vecsAudio[i] );
-
-        // right channel
-        sMaxR = std::max ( sMaxR, vecsAudio[i + 1] );
-    }
+    CMixKernel::MaxAbsStereoShort ( psAudio, sMaxL, sMaxR, iStereoVecSize / 2 );
 
     dCurLevelL = UpdateCurLevel ( dCurLevelL, sMaxL );
     dCurLevelR = UpdateCurLevel ( dCurLevelR, sMaxR );
 }
 
+void CStereoSignalLevelMeter::Update ( const float* pfAudio,
+                                      const int    iStereoVecSize )
+{
+    // same as the int16 version for float samples with a full scale of +-1
+    float fMaxL;
+    float fMaxR;
+
+    CMixKernel::MaxAbsStereo ( pfAudio, fMaxL, fMaxR, iStereoVecSize / 2 );
+
+    dCurLevelL = UpdateCurLevel ( dCurLevelL, static_cast<short> ( std::min ( fMaxL, 1.0f ) * _MAXSHORT ) );
+    dCurLevelR = UpdateCurLevel ( dCurLevelR, static_cast<short> ( std::min ( fMaxR, 1.0f ) * _MAXSHORT ) );
+}
+
 double CStereoSignalLevelMeter::UpdateCurLevel ( double       dCurLevel,
                                                  const short& sMax )
 {
@@ -104,49 +100,56 @@ double CStereoSignalLevelMeter::CalcLogResult ( const double& dLinearLevel )
 
 
 // CRC -------------------------------------------------------------------------
-void CCRC::Reset()
+// table entry i is the shift register after shifting in eight zero bits
+// starting with the register value i << 8
+const uint16_t CCRC::vecCRCTable[256] =
 {
-    // init state shift-register with ones. Set all registers to "1" with
-    // bit-wise not operation
-    iStateShiftReg = ~uint32_t ( 0 );
-}
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
 
-void CCRC::AddByte ( const uint8_t byNewInput )
+void CCRC::Reset()
 {
-    for ( int i = 0; i < 8; i++ )
-    {
-        // shift bits in shift-register for transistion
-        iStateShiftReg <<= 1;
-
-        // take bit, which was shifted out of the register-size and place it
-        // at the beginning (LSB)
-        // (If condition is not satisfied, implicitely a "0" is added)
-        if ( ( iStateShiftReg & iBitOutMask) > 0 )
-        {
-            iStateShiftReg |= 1;
-        }
-
-        // add new data bit to the LSB
-        if ( ( byNewInput & ( 1 << ( 8 - i - 1 ) ) ) > 0 )
-        {
-            iStateShiftReg ^= 1;
-        }
-
-        // add mask to shift-register if first bit is true
-        if ( iStateShiftReg & 1 )
-        {
-            iStateShiftReg ^= iPoly;
-        }
-    }
+    // init state shift-register with ones
+    iStateShiftReg = 0xFFFF;
 }
 
 uint32_t CCRC::GetCRC()
 {
     // return inverted shift-register (1's complement)
-    iStateShiftReg = ~iStateShiftReg;
+    iStateShiftReg = ~iStateShiftReg & 0xFFFF;
 
-    // remove bit which where shifted out of the shift-register frame
-    return iStateShiftReg & ( iBitOutMask - 1 );
+    return iStateShiftReg;
 }
 
 
@@ -206,13 +209,20 @@ void CAudioReverb::Init ( const EAudChanConf eNAudioChannelConf,
     for ( int i = 0; i < 4; i++ )
     {
         combDelays[i].Init ( lengths[i] );
-        combFilters[i].setPole ( 0.2 );
     }
 
+    // the lowpass in the comb filter feedback has the pole 0.2 (unity DC gain)
+    combPole = 0.2f;
     setT60 ( rT60, iSampleRate );
     outLeftDelay.Init ( lengths[7] );
     outRightDelay.Init ( lengths[8] );
-    allpassCoefficient = 0.7;
+    allpassCoefficient = 0.7f;
+
+    // the processing buffers are allocated here and not in the audio callback
+    vecfBlock.Init    ( REVERB_BLOCK_SIZE_SAMPLES );
+    vecfCombSum.Init  ( REVERB_BLOCK_SIZE_SAMPLES );
+    vecfOutLeft.Init  ( REVERB_BLOCK_SIZE_SAMPLES );
+    vecfOutRight.Init ( REVERB_BLOCK_SIZE_SAMPLES );
     Clear();
 }
 
@@ -248,120 +258,152 @@ bool CAudioReverb::isPrime ( const int number )
 void CAudioReverb::Clear()
 {
     // reset and clear all internal state
-    allpassDelays[0].Reset ( 0 );
-    allpassDelays[1].Reset ( 0 );
-    allpassDelays[2].Reset ( 0 );
-    combDelays[0].Reset ( 0 );
-    combDelays[1].Reset ( 0 );
-    combDelays[2].Reset ( 0 );
-    combDelays[3].Reset ( 0 );
-    combFilters[0].Reset();
-    combFilters[1].Reset();
-    combFilters[2].Reset();
-    combFilters[3].Reset();
-    outRightDelay.Reset ( 0 );
-    outLeftDelay.Reset ( 0 );
+    allpassDelays[0].Reset();
+    allpassDelays[1].Reset();
+    allpassDelays[2].Reset();
+    combDelays[0].Reset();
+    combDelays[1].Reset();
+    combDelays[2].Reset();
+    combDelays[3].Reset();
+    outRightDelay.Reset();
+    outLeftDelay.Reset();
+
+    for ( int i = 0; i < 4; i++ )
+    {
+        combState[i] = 0.0f;
+    }
 }
 
 void CAudioReverb::setT60 ( const double rT60,
                             const int    iSampleRate )
 {
-    // set the reverberation T60 decay time
+    // set the reverberation T60 decay time (the gain of the feedback lowpass
+    // is included in the comb filter feedback)
     for ( int i = 0; i < 4; i++ )
     {
-        combCoefficient[i] = pow ( 10.0, static_cast<double> ( -3.0 *
-            combDelays[i].Size() / ( rT60 * iSampleRate ) ) );
+        combFeedback[i] = static_cast<float> ( ( 1.0 - combPole ) * pow ( 10.0, static_cast<double> ( -3.0 *
+            combDelays[i].Size() / ( rT60 * iSampleRate ) ) ) );
     }
 }
 
-void CAudioReverb::COnePole::setPole ( const double dPole )
+void CAudioReverb::CDelayLine::Allpass ( float*      pfInOut,
+                                         const int   iNumSamples,
+                                         const float fCoeff )
 {
-    // calculate IIR filter coefficients based on the pole value
-    dA = -dPole;
-    dB = 1.0 - dPole;
+    // process the block in at most two contiguous parts (wrap around)
+    for ( int i = 0; i < iNumSamples; )
+    {
+        const int iLen = std::min ( iNumSamples - i, Size() - iPos );
+
+        CMixKernel::Allpass ( &vecfMemory[iPos], &pfInOut[i], fCoeff, iLen );
+
+        i    += iLen;
+        iPos  = ( iPos + iLen ) % Size();
+    }
 }
 
-double CAudioReverb::COnePole::Calc ( const double dIn )
+void CAudioReverb::CDelayLine::CombFilter ( const float* pfIn,
+                                            float*       pfSum,
+                                            const int    iNumSamples,
+                                            const float  fFeedback,
+                                            const float  fPole,
+                                            float&       fState )
 {
-    // calculate IIR filter
-    dLastSample = dB * dIn - dA * dLastSample;
+    // process the block in at most two contiguous parts (wrap around)
+    for ( int i = 0; i < iNumSamples; )
+    {
+        const int iLen = std::min ( iNumSamples - i, Size() - iPos );
+
+        CMixKernel::CombFilter ( &vecfMemory[iPos], &pfIn[i], &pfSum[i], fState, fFeedback, fPole, iLen );
 
-    return dLastSample;
+        i    += iLen;
+        iPos  = ( iPos + iLen ) % Size();
+    }
 }
 
-void CAudioReverb::Process ( CVector<int16_t>& vecsStereoInOut,
-                             const bool        bReverbOnLeftChan,
-                             const double      dAttenuation )
+void CAudioReverb::CDelayLine::Delay ( const float* pfIn,
+                                       float*       pfOut,
+                                       const int    iNumSamples )
 {
-    double dMixedInput, temp, temp0, temp1, temp2;
+    // since the block is shorter than the delay line, all delayed samples can
+    // be read before the new samples are written
+    const int iReadPos  = ( iPos + 1 ) % Size();
+    const int iReadLen  = std::min ( iNumSamples, Size() - iReadPos );
+    const int iWriteLen = std::min ( iNumSamples, Size() - iPos );
+
+    std::copy ( vecfMemory.begin() + iReadPos, vecfMemory.begin() + iReadPos + iReadLen, pfOut );
+    std::copy ( vecfMemory.begin(), vecfMemory.begin() + iNumSamples - iReadLen, pfOut + iReadLen );
 
-    for ( int i = 0; i < iStereoBlockSizeSam; i += 2 )
+    std::copy ( pfIn, pfIn + iWriteLen, vecfMemory.begin() + iPos );
+    std::copy ( pfIn + iWriteLen, pfIn + iNumSamples, vecfMemory.begin() );
+
+    iPos = ( iPos + iNumSamples ) % Size();
+}
+
+void CAudioReverb::Process ( CVector<float>& vecfStereoInOut,
+                             const bool      bReverbOnLeftChan,
+                             const double    dAttenuation )
+{
+    const float fDryGain       = static_cast<float> ( 1.0 - dAttenuation );
+    const float fWetGain       = static_cast<float> ( 0.5 * dAttenuation );
+    const bool  bApplyOnLeft   = ( eAudioChannelConf == CC_STEREO ) || bReverbOnLeftChan;
+    const bool  bApplyOnRight  = ( eAudioChannelConf == CC_STEREO ) || !bReverbOnLeftChan;
+    const int   iMonoBlockSize = iStereoBlockSizeSam / 2;
+
+    // The processing is done stage by stage on blocks which are shorter than
+    // all delay lines so that each filter stage works on contiguous parts of
+    // its delay line with vectorized kernels.
+    for ( int iStart = 0; iStart < iMonoBlockSize; iStart += REVERB_BLOCK_SIZE_SAMPLES )
     {
+        const int iNumSamples = std::min ( REVERB_BLOCK_SIZE_SAMPLES, iMonoBlockSize - iStart );
+        float*    pfStereo    = &vecfStereoInOut[2 * iStart];
+        float*    pfBlock     = &vecfBlock[0];
+
         // we sum up the stereo input channels (in case mono input is used, a zero
         // shall be input for the right channel)
-        if ( eAudioChannelConf == CC_STEREO )
-        {
-            dMixedInput = 0.5 * ( vecsStereoInOut[i] + vecsStereoInOut[i + 1] );
-        }
-        else
+        for ( int i = 0; i < iNumSamples; i++ )
         {
-            if ( bReverbOnLeftChan )
+            if ( eAudioChannelConf == CC_STEREO )
             {
-                dMixedInput = vecsStereoInOut[i];
+                pfBlock[i] = 0.5f * ( pfStereo[2 * i] + pfStereo[2 * i + 1] );
             }
             else
             {
-                dMixedInput = vecsStereoInOut[i + 1];
+                pfBlock[i] = bReverbOnLeftChan ? pfStereo[2 * i] : pfStereo[2 * i + 1];
             }
         }
 
-        temp = allpassDelays[0].Get();
-        temp0 = allpassCoefficient * temp;
-        temp0 += dMixedInput;
-        allpassDelays[0].Add ( temp0 );
-        temp0 = - ( allpassCoefficient * temp0 ) + temp;
+        // three series allpass filters
+        allpassDelays[0].Allpass ( pfBlock, iNumSamples, allpassCoefficient );
+        allpassDelays[1].Allpass ( pfBlock, iNumSamples, allpassCoefficient );
+        allpassDelays[2].Allpass ( pfBlock, iNumSamples, allpassCoefficient );
 
-        temp = allpassDelays[1].Get();
-        temp1 = allpassCoefficient * temp;
-        temp1 += temp0;
-        allpassDelays[1].Add ( temp1 );
-        temp1 = - ( allpassCoefficient * temp1 ) + temp;
+        // four parallel comb filters, the outputs are summed up
+        std::fill ( vecfCombSum.begin(), vecfCombSum.begin() + iNumSamples, 0.0f );
 
-        temp = allpassDelays[2].Get();
-        temp2 = allpassCoefficient * temp;
-        temp2 += temp1;
-        allpassDelays[2].Add ( temp2 );
-        temp2 = - ( allpassCoefficient * temp2 ) + temp;
-
-        const double temp3 = temp2 + combFilters[0].Calc ( combCoefficient[0] * combDelays[0].Get() );
-        const double temp4 = temp2 + combFilters[1].Calc ( combCoefficient[1] * combDelays[1].Get() );
-        const double temp5 = temp2 + combFilters[2].Calc ( combCoefficient[2] * combDelays[2].Get() );
-        const double temp6 = temp2 + combFilters[3].Calc ( combCoefficient[3] * combDelays[3].Get() );
-
-        combDelays[0].Add ( temp3 );
-        combDelays[1].Add ( temp4 );
-        combDelays[2].Add ( temp5 );
-        combDelays[3].Add ( temp6 );
-
-        const double filtout = temp3 + temp4 + temp5 + temp6;
+        for ( int c = 0; c < 4; c++ )
+        {
+            combDelays[c].CombFilter ( pfBlock, &vecfCombSum[0], iNumSamples, combFeedback[c], combPole, combState[c] );
+        }
 
-        outLeftDelay.Add  ( filtout );
-        outRightDelay.Add ( filtout );
+        // decorrelation delays at the output
+        outLeftDelay.Delay  ( &vecfCombSum[0], &vecfOutLeft[0], iNumSamples );
+        outRightDelay.Delay ( &vecfCombSum[0], &vecfOutRight[0], iNumSamples );
 
         // inplace apply the attenuated reverb signal (for stereo always apply
-        // reverberation effect on both channels)
-        if ( ( eAudioChannelConf == CC_STEREO ) || bReverbOnLeftChan )
+        // reverberation effect on both channels, no saturation is required
+        // since the float samples have enough headroom)
+        for ( int i = 0; i < iNumSamples; i++ )
         {
-            vecsStereoInOut[i] = Double2Short (
-                ( 1.0 - dAttenuation ) * vecsStereoInOut[i] +
-                0.5 * dAttenuation * outLeftDelay.Get() );
-        }
+            if ( bApplyOnLeft )
+            {
+                pfStereo[2 * i] = fDryGain * pfStereo[2 * i] + fWetGain * vecfOutLeft[i];
+            }
 
-        if ( ( eAudioChannelConf == CC_STEREO ) || !bReverbOnLeftChan )
-        {
-            vecsStereoInOut[i + 1] = Double2Short (
-                ( 1.0 - dAttenuation ) * vecsStereoInOut[i + 1] +
-                0.5 * dAttenuation * outRightDelay.Get() );
+            if ( bApplyOnRight )
+            {
+                pfStereo[2 * i + 1] = fDryGain * pfStereo[2 * i + 1] + fWetGain * vecfOutRight[i];
+            }
         }
     }
 }
@@ -851,14 +893,317 @@ CHelpMenu::CHelpMenu ( const bool bIsClient, QWidget* parent ) : QMenu ( tr ( "&
     addAction ( tr ( "&About..." ), this, SLOT ( OnHelpAbout() ) );
 }
 
+
+// Pixmap cache ----------------------------------------------------------------
+QPixmap CPixmapCache::GetInstrumentPixmap ( const int iInstrument,
+                                            const int iDevicePixelRatio )
+{
+    if ( CInstPictures::IsNotUsedInstrument ( iInstrument ) )
+    {
+        return QPixmap();
+    }
+
+    return GetPixmap ( CInstPictures::GetResourceReference ( iInstrument ), iDevicePixelRatio );
+}
+
+QPixmap CPixmapCache::GetCountryFlagPixmap ( const QLocale::Country eCountry,
+                                             const int              iDevicePixelRatio )
+{
+    if ( eCountry == QLocale::AnyCountry )
+    {
+        return QPixmap();
+    }
+
+    return GetPixmap ( CLocale::GetCountryFlagIconsResourceReference ( eCountry ), iDevicePixelRatio );
+}
+
+int CPixmapCache::GetDevicePixelRatio ( const QWidget* pWidget )
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 1, 0)
+    return std::max ( 1, pWidget->devicePixelRatio() );
+#else
+    Q_UNUSED ( pWidget )
+    return 1;
+#endif
+}
+
+QPixmap CPixmapCache::GetPixmap ( const QString& strResourceRef,
+                                  const int      iDevicePixelRatio )
+{
+    // the decoded pictures with the scaled versions (key: resource reference
+    // and device pixel ratio), an invalid resource reference is stored as a
+    // null pixmap, too
+    static QHash<QString, QPixmap> Cache;
+
+    if ( strResourceRef.isEmpty() )
+    {
+        return QPixmap();
+    }
+
+    const int     iRatio = std::max ( 1, iDevicePixelRatio );
+    const QString strKey = strResourceRef + QString ( "@%1" ).arg ( iRatio );
+
+    QHash<QString, QPixmap>::const_iterator it = Cache.constFind ( strKey );
+
+    if ( it != Cache.constEnd() )
+    {
+        return it.value();
+    }
+
+    QPixmap Pixmap;
+
+    if ( iRatio == 1 )
+    {
+        Pixmap = QPixmap ( strResourceRef );
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 1, 0)
+    else
+    {
+        // the pictures only exist in one resolution, on a high DPI screen they
+        // are scaled once and keep their logical size
+        const QPixmap Original = GetPixmap ( strResourceRef, 1 );
+
+        if ( !Original.isNull() )
+        {
+            Pixmap = Original.scaled ( Original.size() * iRatio,
+                                       Qt::KeepAspectRatio,
+                                       Qt::SmoothTransformation );
+            Pixmap.setDevicePixelRatio ( iRatio );
+        }
+    }
+#endif
+
+    Cache.insert ( strKey, Pixmap );
+
+    return Pixmap;
+}
+
 #endif
 
 /******************************************************************************\
 * Other Classes                                                                *
 \******************************************************************************/
+// Stored fader settings -------------------------------------------------------
+void CStoredFaderSettings::Store ( const CEntry& NewEntry )
+{
+    // a fader without a name cannot be identified
+    if ( NewEntry.strTag.isEmpty() )
+    {
+        return;
+    }
+
+    QHash<QString, CItem>::iterator it = Items.find ( NewEntry.strTag );
+
+    if ( it != Items.end() )
+    {
+        StoreOrder.remove ( it->iStoreIdx );
+    }
+    else
+    {
+        it = Items.insert ( NewEntry.strTag, CItem() );
+    }
+
+    it->Entry     = NewEntry;
+    it->iStoreIdx = iNextStoreIdx++;
+    StoreOrder.insert ( it->iStoreIdx, NewEntry.strTag );
+
+    // drop the least recently stored entry if the storage is full
+    while ( Items.size() > MAX_NUM_STORED_FADER_SETTINGS )
+    {
+        Items.remove ( StoreOrder.begin().value() );
+        StoreOrder.erase ( StoreOrder.begin() );
+    }
+}
+
+bool CStoredFaderSettings::Get ( const QString& strTag,
+                                 CEntry&        Entry ) const
+{
+    QHash<QString, CItem>::const_iterator it = Items.constFind ( strTag );
+
+    if ( strTag.isEmpty() || ( it == Items.constEnd() ) )
+    {
+        return false;
+    }
+
+    Entry = it->Entry;
+    return true;
+}
+
+QVector<CStoredFaderSettings::CEntry> CStoredFaderSettings::GetEntries() const
+{
+    QVector<CEntry> vecEntries;
+    vecEntries.reserve ( Items.size() );
+
+    QMap<qint64, QString>::const_iterator it = StoreOrder.constEnd();
+
+    while ( it != StoreOrder.constBegin() )
+    {
+        --it;
+        vecEntries.append ( Items.value ( it.value() ).Entry );
+    }
+
+    return vecEntries;
+}
+
+
+// Stored jitter buffer delays ------------------------------------------------
+void CStoredJitBufDelays::Store ( const QString& strAddress,
+                                  const int      iDelayMs )
+{
+    if ( strAddress.isEmpty() || ( iDelayMs <= 0 ) )
+    {
+        return;
+    }
+
+    for ( int i = 0; i < Entries.size(); i++ )
+    {
+        if ( Entries[i].first == strAddress )
+        {
+            Entries.removeAt ( i );
+            break;
+        }
+    }
+
+    Entries.prepend ( qMakePair ( strAddress, iDelayMs ) );
+
+    // drop the least recently stored entry if the storage is full
+    while ( Entries.size() > MAX_NUM_STORED_JIT_BUF_DELAYS )
+    {
+        Entries.removeLast();
+    }
+}
+
+int CStoredJitBufDelays::Get ( const QString& strAddress ) const
+{
+    for ( int i = 0; i < Entries.size(); i++ )
+    {
+        if ( Entries[i].first == strAddress )
+        {
+            return Entries[i].second;
+        }
+    }
+
+    return -1;
+}
+
+QStringList CStoredJitBufDelays::GetEntries() const
+{
+    QStringList slEntries;
+
+    for ( int i = 0; i < Entries.size(); i++ )
+    {
+        slEntries.append ( Entries[i].first + ";" + QString::number ( Entries[i].second ) );
+    }
+
+    return slEntries;
+}
+
+void CStoredJitBufDelays::SetEntries ( const QStringList& slEntries )
+{
+    Entries.clear();
+
+    // the entries are stored in reverse order so that the first entry is the
+    // most recently stored one
+    for ( int i = slEntries.size() - 1; i >= 0; i-- )
+    {
+        // the address may contain colons (port, IPv6) but no semicolon
+        const int iSepPos = slEntries[i].lastIndexOf ( ';' );
+
+        if ( iSepPos > 0 )
+        {
+            Store ( slEntries[i].left ( iSepPos ), slEntries[i].mid ( iSepPos + 1 ).toInt() );
+        }
+    }
+}
+
+
+// Network utility functions ---------------------------------------------------
+// Host name resolver ----------------------------------------------------------
+CHostNameResolver& CHostNameResolver::Instance()
+{
+    static CHostNameResolver HostNameResolver;
+
+    return HostNameResolver;
+}
+
+CHostNameResolver::CHostNameResolver()
+{
+    CacheTimer.start();
+
+    // the results of the asynchronous lookups are delivered in the main thread
+    // (the resolver may be created by any thread)
+    if ( QCoreApplication::instance() != nullptr )
+    {
+        moveToThread ( QCoreApplication::instance()->thread() );
+    }
+}
+
+bool CHostNameResolver::GetCachedAddresses ( const QString&       strHostName,
+                                             QList<QHostAddress>& Addresses )
+{
+    QMutexLocker locker ( &Mutex );
+
+    QHash<QString, SCacheEntry>::const_iterator it = Cache.constFind ( strHostName.toLower() );
+
+    if ( ( it == Cache.constEnd() ) || ( it->iExpiryTimeMs < CacheTimer.elapsed() ) )
+    {
+        return false;
+    }
+
+    Addresses = it->Addresses;
+
+    return true;
+}
+
+void CHostNameResolver::StoreAddresses ( const QString&             strHostName,
+                                         const QList<QHostAddress>& Addresses )
+{
+    QMutexLocker locker ( &Mutex );
+
+    SCacheEntry NewEntry;
+    NewEntry.Addresses     = Addresses;
+    NewEntry.iExpiryTimeMs = CacheTimer.elapsed() + 1000 *
+        ( Addresses.isEmpty() ? HOST_NAME_CACHE_FAILED_TIME_S : HOST_NAME_CACHE_TIME_S );
+
+    Cache.insert ( strHostName.toLower(), NewEntry );
+}
+
+void CHostNameResolver::LookupAsync ( const QString& strHostName )
+{
+    {
+        QMutexLocker locker ( &Mutex );
+
+        if ( PendingNames.contains ( strHostName ) )
+        {
+            return;
+        }
+
+        PendingNames.insert ( strHostName );
+    }
+
+    QHostInfo::lookupHost ( strHostName, this, SLOT ( OnLookupFinished ( QHostInfo ) ) );
+}
+
+void CHostNameResolver::OnLookupFinished ( QHostInfo HostInfo )
+{
+    {
+        QMutexLocker locker ( &Mutex );
+
+        PendingNames.remove ( HostInfo.hostName() );
+    }
+
+    StoreAddresses ( HostInfo.hostName(),
+                     ( HostInfo.error() == QHostInfo::NoError ) ? HostInfo.addresses() : QList<QHostAddress>() );
+
+    emit HostNameResolved ( HostInfo.hostName() );
+}
+
+
 // Network utility functions ---------------------------------------------------
-bool NetworkUtil::ParseNetworkAddress ( QString       strAddress,
-                                        CHostAddress& HostAddress )
+ENetwAddrStat NetworkUtil::ParseNetworkAddressIntern ( QString       strAddress,
+                                                       CHostAddress& HostAddress,
+                                                       const bool    bPreferIPv4,
+                                                       const bool    bBlocking )
 {
     QHostAddress InetAddr;
     quint16      iNetPort = DEFAULT_PORT_NUMBER;
@@ -895,32 +1240,63 @@ bool NetworkUtil::ParseNetworkAddress ( QString       strAddress,
             strAddress.remove ( 0, 1 );
         }
     }
+    else if ( bIsIP6 && strAddress.startsWith ( "[" ) && strAddress.endsWith ( "]" ) )
+    {
+        // "[IP6 address]" without a port number
+        strAddress = strAddress.mid ( 1, strAddress.length() - 2 );
+    }
 
     // first try if this is an IP number an can directly applied to QHostAddress
     if ( !InetAddr.setAddress ( strAddress ) )
     {
         // it was no vaild IP address, try to get host by name, assuming
-        // that the string contains a valid host name string
-        const QHostInfo HostInfo = QHostInfo::fromName ( strAddress );
+        // that the string contains a valid host name string (the cache is
+        // checked first)
+        CHostNameResolver&  Resolver = CHostNameResolver::Instance();
+        QList<QHostAddress> Addresses;
 
-        if ( HostInfo.error() == QHostInfo::NoError )
+        if ( !Resolver.GetCachedAddresses ( strAddress, Addresses ) )
         {
-            // apply IP address to QT object
-             if ( !HostInfo.addresses().isEmpty() )
-             {
-                 // use the first IP address
-                 InetAddr = HostInfo.addresses().first();
-             }
+            if ( !bBlocking )
+            {
+                Resolver.LookupAsync ( strAddress );
+                return NA_PENDING;
+            }
+
+            const QHostInfo HostInfo = QHostInfo::fromName ( strAddress );
+
+            if ( HostInfo.error() == QHostInfo::NoError )
+            {
+                Addresses = HostInfo.addresses();
+            }
+
+            Resolver.StoreAddresses ( strAddress, Addresses );
         }
-        else
+
+        if ( Addresses.isEmpty() )
+        {
+            return NA_INVALID; // invalid address
+        }
+
+        // use the first IP address
+        InetAddr = Addresses.first();
+
+        if ( bPreferIPv4 )
         {
-            return false; // invalid address
+            foreach ( const QHostAddress& CurAddr, Addresses )
+            {
+                if ( CurAddr.protocol() == QAbstractSocket::IPv4Protocol )
+                {
+                    InetAddr = CurAddr;
+                    break;
+                }
+            }
         }
     }
 
     HostAddress = CHostAddress ( InetAddr, iNetPort );
 
-    return true;
+    return NA_OK;
 }
 
 CHostAddress NetworkUtil::GetLocalAddress()
@@ -938,7 +1314,7 @@ CHostAddress NetworkUtil::GetLocalAddress()
                    << socket.errorString()
                    << "- using localhost";
 
-        return CHostAddress(  QHostAddress::LocalHost, 0 );
+        return CHostAddress(  QHostAddress ( QHostAddress::LocalHost ), 0 );
     }
 }
 
@@ -957,6 +1333,52 @@ QString NetworkUtil::GetCentralServerAddress ( const ECSAddType eCentralServerAd
 }
 
 
+// Connection less message rate limiter ----------------------------------------
+CConnLessRateLimiter::CConnLessRateLimiter ( const double dNSourceRate,
+                                             const double dNSourceBurst,
+                                             const double dNGlobalRate,
+                                             const double dNGlobalBurst ) :
+    dSourceRate  ( dNSourceRate ),
+    dSourceBurst ( dNSourceBurst ),
+    dGlobalRate  ( dNGlobalRate ),
+    dGlobalBurst ( dNGlobalBurst ),
+    vecBuckets   ( CONNLESS_RATE_LIMIT_TABLE_SIZE ),
+    iNumDropped  ( 0 )
+{
+    GlobalBucket.dTokens = dGlobalBurst;
+    GlobalBucket.bUsed   = true;
+}
+
+bool CConnLessRateLimiter::Allow ( const CHostAddress& Addr,
+                                   const qint64        iCurTimeMs )
+{
+    CBucket& Bucket = vecBuckets[qHash ( Addr ) % CONNLESS_RATE_LIMIT_TABLE_SIZE];
+
+    // a new source starts with a full bucket
+    if ( !Bucket.bUsed || ( Bucket.Addr != Addr ) )
+    {
+        Bucket.Addr        = Addr;
+        Bucket.dTokens     = dSourceBurst;
+        Bucket.iLastTimeMs = iCurTimeMs;
+        Bucket.bUsed       = true;
+    }
+
+    Bucket.Refill ( iCurTimeMs, dSourceRate, dSourceBurst );
+    GlobalBucket.Refill ( iCurTimeMs, dGlobalRate, dGlobalBurst );
+
+    if ( ( Bucket.dTokens < 1 ) || ( GlobalBucket.dTokens < 1 ) )
+    {
+        iNumDropped.fetchAndAddRelaxed ( 1 );
+        return false;
+    }
+
+    Bucket.dTokens       -= 1;
+    GlobalBucket.dTokens -= 1;
+
+    return true;
+}
+
+
 // Instrument picture data base ------------------------------------------------
 CVector<CInstPictures::CInstPictProps>& CInstPictures::GetTable()
 {
@@ -38,12 +38,23 @@
 # include <QLineEdit>
 # include <QDateTime>
 # include <QDesktopServices>
+# include <QPixmap>
 # include "ui_aboutdlgbase.h"
 #endif
 #include <QFile>
 #include <QUrl>
 #include <QLocale>
 #include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QMutex>
+#include <QHash>
+#include <QSet>
+#include <QMap>
+#include <QVector>
+#include <QList>
+#include <QPair>
+#include <QStringList>
 #include <vector>
 #include <algorithm>
 #include "global.h"
@@ -69,6 +80,14 @@ class CClient;  // forward declaration of CClient
 #define METER_FLY_BACK              2
 #define INVALID_MIDI_CH            -1 // invalid MIDI channel definition
 
+// block size of the reverberation processing (must be shorter than all delay lines)
+#define REVERB_BLOCK_SIZE_SAMPLES   64
+
+// time the resolved host names are cached (the system resolver does not give
+// us the TTL of the records), a failed lookup is cached for a shorter time
+#define HOST_NAME_CACHE_TIME_S          300 // s
+#define HOST_NAME_CACHE_FAILED_TIME_S   10  // s
+
 
 /* Global functions ***********************************************************/
 // converting double to short
@@ -131,6 +150,13 @@ public:
         std::fill ( this->begin(), this->end(), tResetVal );
     }
 
+    // releases the memory of the vector (the vector is empty afterwards, in
+    // contrast to Init ( 0 ) which keeps the allocated memory)
+    void Free() { CVector<TData>().swap ( *this ); }
+
+    // allocated memory in bytes
+    int GetMemUsage() const { return static_cast<int> ( std::vector<TData>::capacity() * sizeof ( TData ) ); }
+
     void Enlarge ( const int iAddedSize )
     {
         std::vector<TData>::resize ( std::vector<TData>::size() + iAddedSize );
@@ -258,6 +284,49 @@ template<class TData> int CVector<TData>::StringFiFoWithCompare ( const QString
 
 
 
+/******************************************************************************\
+* CProtMessage Class (shared protocol message)                                 *
+\******************************************************************************/
+// Immutable protocol message with reference counting. The messages are passed
+// through the (queued) signals and slots of the protocol, the socket and the
+// channels by value, all copies of a message share the same bytes which are
+// allocated once.
+class CProtMessage
+{
+public:
+    CProtMessage() {}
+
+    // copies the bytes of the given vector
+    CProtMessage ( const CVector<uint8_t>& vecbyNData ) :
+        pvecbyData ( new CVector<uint8_t> ( vecbyNData ) ) {}
+
+    // takes over the bytes of the given vector without a copy, the vector is
+    // empty afterwards
+    static CProtMessage Adopt ( CVector<uint8_t>& vecbyNData )
+    {
+        CProtMessage NewMessage;
+        NewMessage.pvecbyData.reset ( new CVector<uint8_t> );
+        NewMessage.pvecbyData->swap ( vecbyNData );
+        return NewMessage;
+    }
+
+    const CVector<uint8_t>& Data() const
+    {
+        static const CVector<uint8_t> vecbyEmpty;
+        return pvecbyData.isNull() ? vecbyEmpty : *pvecbyData;
+    }
+
+    // the message can be used wherever the bytes are read
+    operator const CVector<uint8_t>&() const { return Data(); }
+
+    int Size() const { return Data().Size(); }
+
+protected:
+    QSharedPointer<CVector<uint8_t> > pvecbyData;
+};
+
+
+
 /******************************************************************************\
 * CFIFO Class (First In, First Out)                                            *
 \******************************************************************************/
@@ -488,6 +557,29 @@ public slots:
     void OnHelpSoftwareMan()      { QDesktopServices::openUrl ( QUrl ( SOFTWARE_MANUAL_URL ) ); }
 };
 
+
+// Pixmap cache ----------------------------------------------------------------
+// The pictures of the instruments and the country flags are decoded once per
+// process and device pixel ratio (they are shown by each fader and each entry
+// of the server list), a null pixmap is returned if no picture exists. The
+// cache must only be used by the GUI thread.
+class CPixmapCache
+{
+public:
+    static QPixmap GetInstrumentPixmap ( const int iInstrument,
+                                         const int iDevicePixelRatio = 1 );
+
+    static QPixmap GetCountryFlagPixmap ( const QLocale::Country eCountry,
+                                          const int              iDevicePixelRatio = 1 );
+
+    // device pixel ratio of the screen of the widget (1 if not supported)
+    static int GetDevicePixelRatio ( const QWidget* pWidget );
+
+protected:
+    static QPixmap GetPixmap ( const QString& strResourceRef,
+                               const int      iDevicePixelRatio );
+};
+
 #endif
 
 // Console writer factory ------------------------------------------------------
@@ -526,6 +618,12 @@ enum EAudComprType
     CT_OPUS64 = 3 // using OPUS with 64 samples frame size
 };
 
+// number of samples of one frame of the audio codec
+inline int GetCodecFrameSizeSamples ( const EAudComprType eAudComprType )
+{
+    return ( eAudComprType == CT_OPUS64 ) ? SYSTEM_FRAME_SIZE_SAMPLES : DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+}
+
 
 // Audio quality enum ----------------------------------------------------------
 enum EAudioQuality
@@ -703,7 +801,9 @@ class CStereoSignalLevelMeter
 public:
     CStereoSignalLevelMeter() { Reset(); }
 
-    void          Update ( const CVector<short>& vecsAudio );
+    void          Update ( const CVector<short>& vecsAudio ) { Update ( &vecsAudio[0], vecsAudio.Size() ); }
+    void          Update ( const short* psAudio, const int iStereoVecSize );
+    void          Update ( const float* pfAudio, const int iStereoVecSize );
     double        MicLeveldBLeft()  { return CalcLogResult ( dCurLevelL ); }
     double        MicLeveldBRight() { return CalcLogResult ( dCurLevelR ); }
     static double CalcLogResult ( const double& dLinearLevel );
@@ -724,6 +824,11 @@ protected:
 
 
 // Host address ----------------------------------------------------------------
+// This is a trivially copyable type (no shared data with atomic reference
+// counting like QHostAddress) since it is copied a lot on the real-time packet
+// path. The address is stored as an IPv6 address where IPv4 addresses are
+// stored as IPv4-mapped IPv6 addresses. A QHostAddress is only created if it
+// is requested, e.g. for the GUI or logging.
 class CHostAddress
 {
 public:
@@ -734,59 +839,236 @@ public:
         SM_IP_NO_LAST_BYTE_PORT
     };
 
-    CHostAddress() :
-        InetAddr ( static_cast<quint32> ( 0 ) ),
-        iPort ( 0 ) {}
+    CHostAddress() { SetIPv4Addr ( 0 ); iPort = 0; }
 
     CHostAddress ( const QHostAddress NInetAddr,
-                   const quint16      iNPort ) :
-        InetAddr ( NInetAddr ),
-        iPort    ( iNPort ) {}
-
-    CHostAddress ( const CHostAddress& NHAddr ) :
-        InetAddr ( NHAddr.InetAddr ),
-        iPort    ( NHAddr.iPort ) {}
+                   const quint16      iNPort )
+    {
+        SetInetAddr ( NInetAddr );
+        iPort = iNPort;
+    }
 
-    // copy operator
-    CHostAddress& operator= ( const CHostAddress& NHAddr )
+    // IPv4 address in host byte order
+    CHostAddress ( const quint32 iNIPv4Addr,
+                   const quint16 iNPort )
     {
-        InetAddr = NHAddr.InetAddr;
-        iPort    = NHAddr.iPort;
-        return *this;
+        SetIPv4Addr ( iNIPv4Addr );
+        iPort = iNPort;
     }
 
-    // compare operator
+    // compare operators
     bool operator== ( const CHostAddress& CompAddr ) const
     {
-        return ( ( CompAddr.InetAddr == InetAddr ) &&
-                 ( CompAddr.iPort    == iPort ) );
+        return ( CompAddr.iPort == iPort ) && IsSameInetAddr ( CompAddr );
+    }
+
+    bool operator!= ( const CHostAddress& CompAddr ) const
+    {
+        return !( *this == CompAddr );
+    }
+
+    bool IsSameInetAddr ( const CHostAddress& CompAddr ) const
+    {
+        return std::equal ( Addr, Addr + 16, CompAddr.Addr );
+    }
+
+    bool IsIPv4() const
+    {
+        // check for the IPv4-mapped prefix ::ffff:0:0/96
+        for ( int i = 0; i < 10; i++ )
+        {
+            if ( Addr[i] != 0 )
+            {
+                return false;
+            }
+        }
+
+        return ( Addr[10] == 0xFF ) && ( Addr[11] == 0xFF );
+    }
+
+    // IPv4 224.0.0.0/4 or IPv6 ff00::/8
+    bool IsMulticast() const
+    {
+        if ( IsIPv4() )
+        {
+            return ( Addr[12] & 0xF0 ) == 0xE0;
+        }
+
+        return Addr[0] == 0xFF;
+    }
+
+    // private, link-local or loopback address, i.e. the host is in the local
+    // network (the IPv6 unique local addresses fc00::/7 count as private)
+    bool IsPrivate() const
+    {
+        if ( IsIPv4() )
+        {
+            return ( Addr[12] == 10 ) ||
+                   ( Addr[12] == 127 ) ||
+                   ( ( Addr[12] == 172 ) && ( ( Addr[13] & 0xF0 ) == 16 ) ) ||
+                   ( ( Addr[12] == 192 ) && ( Addr[13] == 168 ) ) ||
+                   ( ( Addr[12] == 169 ) && ( Addr[13] == 254 ) );
+        }
+
+        static const quint8 Loopback[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+
+        return ( ( Addr[0] & 0xFE ) == 0xFC ) ||
+               ( ( Addr[0] == 0xFE ) && ( ( Addr[1] & 0xC0 ) == 0x80 ) ) ||
+               std::equal ( Addr, Addr + 16, Loopback );
+    }
+
+    // IPv4 address in host byte order (zero for IPv6 addresses)
+    quint32 GetIPv4Addr() const
+    {
+        if ( !IsIPv4() )
+        {
+            return 0;
+        }
+
+        return ( static_cast<quint32> ( Addr[12] ) << 24 ) |
+               ( static_cast<quint32> ( Addr[13] ) << 16 ) |
+               ( static_cast<quint32> ( Addr[14] ) << 8 ) |
+                 static_cast<quint32> ( Addr[15] );
+    }
+
+    void SetIPv4Addr ( const quint32 iNIPv4Addr )
+    {
+        std::fill ( Addr, Addr + 10, 0 );
+        Addr[10] = 0xFF;
+        Addr[11] = 0xFF;
+        Addr[12] = static_cast<quint8> ( iNIPv4Addr >> 24 );
+        Addr[13] = static_cast<quint8> ( iNIPv4Addr >> 16 );
+        Addr[14] = static_cast<quint8> ( iNIPv4Addr >> 8 );
+        Addr[15] = static_cast<quint8> ( iNIPv4Addr );
+    }
+
+    QHostAddress GetInetAddr() const
+    {
+        if ( IsIPv4() )
+        {
+            return QHostAddress ( GetIPv4Addr() );
+        }
+
+        Q_IPV6ADDR IPv6Addr;
+        std::copy ( Addr, Addr + 16, IPv6Addr.c );
+
+        return QHostAddress ( IPv6Addr );
+    }
+
+    void SetInetAddr ( const QHostAddress& NInetAddr )
+    {
+        if ( NInetAddr.protocol() == QAbstractSocket::IPv6Protocol )
+        {
+            const Q_IPV6ADDR IPv6Addr = NInetAddr.toIPv6Address();
+            std::copy ( IPv6Addr.c, IPv6Addr.c + 16, Addr );
+        }
+        else
+        {
+            // note that an invalid address results in 0.0.0.0
+            SetIPv4Addr ( NInetAddr.toIPv4Address() );
+        }
     }
 
     QString toString ( const EStringMode eStringMode = SM_IP_PORT ) const
     {
-        QString strReturn = InetAddr.toString();
+        const bool bIsIPv4   = IsIPv4();
+        QString    strReturn = GetInetAddr().toString();
 
         // special case: for local host address, we do not replace the last byte
         if ( ( ( eStringMode == SM_IP_NO_LAST_BYTE ) ||
                ( eStringMode == SM_IP_NO_LAST_BYTE_PORT ) ) && 
-             ( InetAddr != QHostAddress ( QHostAddress::LocalHost ) ) )
+             ( GetIPv4Addr() != QHostAddress ( QHostAddress::LocalHost ).toIPv4Address() ) &&
+             ( bIsIPv4 || ( GetInetAddr() != QHostAddress ( QHostAddress::LocalHostIPv6 ) ) ) )
         {
-            // replace last byte by an "x"
-            strReturn = strReturn.section ( ".", 0, 2 ) + ".x";
+            // replace last byte by an "x" (for IPv6 the last group which
+            // is the end of the interface identifier)
+            if ( bIsIPv4 )
+            {
+                strReturn = strReturn.section ( ".", 0, 2 ) + ".x";
+            }
+            else
+            {
+                strReturn = strReturn.section ( ":", 0, -2 ) + ":x";
+            }
         }
 
         if ( ( eStringMode == SM_IP_PORT ) ||
              ( eStringMode == SM_IP_NO_LAST_BYTE_PORT ) )
         {
-            // add port number after a semicolon
+            // add port number after a semicolon (an IPv6 address is put in
+            // brackets so that the port can be separated)
+            if ( !bIsIPv4 )
+            {
+                strReturn = "[" + strReturn + "]";
+            }
+
             strReturn += ":" + QString().setNum ( iPort );
         }
 
         return strReturn;
     }
 
-    QHostAddress InetAddr;
-    quint16      iPort;
+    quint8  Addr[16]; // IPv6 address (IPv4 addresses are IPv4-mapped)
+    quint16 iPort;
+};
+
+// hash function so that the host address can be used as a QHash key
+inline uint qHash ( const CHostAddress& HostAddr, uint uSeed = 0 )
+{
+    return qHashBits ( HostAddr.Addr, sizeof ( HostAddr.Addr ), uSeed ) ^ HostAddr.iPort;
+}
+
+
+// Connection less message rate limiter ----------------------------------------
+// token buckets per source address and one bucket for all sources (which also
+// limits sources with changing addresses), the buckets of the sources are kept
+// in a fixed size hash table without collision handling, i.e. a colliding
+// source takes over the entry (no memory is allocated per source)
+class CConnLessRateLimiter
+{
+public:
+    // the rates are given in messages per second, the bursts are the maximum
+    // numbers of messages which may arrive at once
+    CConnLessRateLimiter ( const double dNSourceRate,
+                           const double dNSourceBurst,
+                           const double dNGlobalRate,
+                           const double dNGlobalBurst );
+
+    // returns true if a message of the source may be processed at the given
+    // time (the time must be monotonic)
+    bool Allow ( const CHostAddress& Addr,
+                 const qint64        iCurTimeMs );
+
+    // may be called by another thread
+    int GetAndResetNumDropped() { return iNumDropped.fetchAndStoreRelaxed ( 0 ); }
+
+protected:
+    class CBucket
+    {
+    public:
+        CBucket() : dTokens ( 0 ), iLastTimeMs ( 0 ), bUsed ( false ) {}
+
+        void Refill ( const qint64 iCurTimeMs,
+                      const double dRate,
+                      const double dBurst )
+        {
+            dTokens     = std::min ( dBurst, dTokens + ( iCurTimeMs - iLastTimeMs ) * dRate / 1000 );
+            iLastTimeMs = iCurTimeMs;
+        }
+
+        CHostAddress Addr;
+        double       dTokens;
+        qint64       iLastTimeMs;
+        bool         bUsed;
+    };
+
+    double           dSourceRate;
+    double           dSourceBurst;
+    double           dGlobalRate;
+    double           dGlobalBurst;
+    CVector<CBucket> vecBuckets;
+    CBucket          GlobalBucket;
+    QAtomicInt       iNumDropped;
 };
 
 
@@ -947,6 +1229,85 @@ public:
 };
 
 
+// Stored fader settings -------------------------------------------------------
+// The fader settings of the channels which were seen before are stored by the
+// fader tag (the received name of the channel). The entries are indexed by a
+// hash, if the maximum number of entries is reached, the least recently stored
+// entry is dropped.
+class CStoredFaderSettings
+{
+public:
+    class CEntry
+    {
+    public:
+        CEntry() :
+            strTag  ( "" ),
+            iLevel  ( AUD_MIX_FADER_MAX ),
+            iPan    ( AUD_MIX_PAN_MAX / 2 ),
+            bIsSolo ( false ),
+            bIsMute ( false ) {}
+
+        QString strTag;
+        int     iLevel;
+        int     iPan;
+        bool    bIsSolo;
+        bool    bIsMute;
+    };
+
+    CStoredFaderSettings() : iNextStoreIdx ( 0 ) {}
+
+    // the entry becomes the most recently stored entry
+    void Store ( const CEntry& NewEntry );
+
+    bool Get ( const QString& strTag,
+               CEntry&        Entry ) const;
+
+    // all entries, the most recently stored entry first
+    QVector<CEntry> GetEntries() const;
+
+    int Size() const { return Items.size(); }
+
+protected:
+    class CItem
+    {
+    public:
+        CItem() : iStoreIdx ( 0 ) {}
+
+        CEntry Entry;
+        qint64 iStoreIdx;
+    };
+
+    QHash<QString, CItem>  Items;
+    QMap<qint64, QString>  StoreOrder; // store index -> fader tag
+    qint64                 iNextStoreIdx;
+};
+
+
+// Stored jitter buffer delays ------------------------------------------------
+// The last good auto jitter buffer delay of the recently used servers (by the
+// server address as it was entered or chosen), a new connection to the server
+// starts with this delay. The delay is stored in ms since the number of blocks
+// depends on the frame size of the codec.
+class CStoredJitBufDelays
+{
+public:
+    // the entry becomes the most recently stored entry
+    void Store ( const QString& strAddress,
+                 const int      iDelayMs );
+
+    // returns -1 if no delay is stored for the server
+    int Get ( const QString& strAddress ) const;
+
+    // all entries in the form "[address];[delay]", the most recently stored
+    // entry first (used for the settings file)
+    QStringList GetEntries() const;
+    void        SetEntries ( const QStringList& slEntries );
+
+protected:
+    QList<QPair<QString, int> > Entries; // most recently stored entry first
+};
+
+
 // Server info -----------------------------------------------------------------
 class CServerCoreInfo
 {
@@ -1018,6 +1379,72 @@ public:
     CHostAddress LHostAddr;
 };
 
+// server list entry which is replicated between the central servers of a
+// federation
+class CFederationServerInfo : public CServerInfo
+{
+public:
+    CFederationServerInfo() :
+        bRemove   ( false ),
+        iFeatures ( 0 )
+    {}
+
+    CFederationServerInfo ( const CServerInfo& NServerInfo,
+                            const bool         NbRemove,
+                            const uint32_t     NiFeatures ) :
+        CServerInfo ( NServerInfo ),
+        bRemove     ( NbRemove ),
+        iFeatures   ( NiFeatures ) {}
+
+    // the server was unregistered (or has expired) at its central server
+    bool     bRemove;
+
+    // features reported by the server (CLM_SERVER_FEATURE_x flags)
+    uint32_t iFeatures;
+};
+
+// filter of a server list query (the default filter matches all servers)
+class CServerListFilter
+{
+public:
+    CServerListFilter() :
+        eCountry          ( QLocale::AnyCountry ),
+        iMinMaxNumClients ( 0 ),
+        iRequiredFeatures ( 0 )
+    {}
+
+    // only servers of this country (all countries: QLocale::AnyCountry)
+    QLocale::Country eCountry;
+
+    // only servers which allow at least this number of clients
+    int              iMinMaxNumClients;
+
+    // only servers which reported all of these features
+    // (CLM_SERVER_FEATURE_x flags)
+    uint32_t         iRequiredFeatures;
+};
+
+// server side timing of the audio of a client (answer to a latency probe)
+class CServerLatencyInfo
+{
+public:
+    CServerLatencyInfo() :
+        iTransmitTimeMs ( 0 ),
+        iQueueDelayUs   ( 0 ),
+        iMixTimeUs      ( 0 )
+    {}
+
+    // unchanged time stamp of the probe of the client
+    int iTransmitTimeMs;
+
+    // average time a frame of the client waits in the server until it is
+    // mixed (jitter buffer and the wait for the next frame period)
+    int iQueueDelayUs;
+
+    // average processing time of a frame (mix, encoding and sending)
+    int iMixTimeUs;
+};
+
 
 // Network transport properties ------------------------------------------------
 class CNetworkTransportProps
@@ -1056,16 +1483,87 @@ public:
 };
 
 
+// Host name resolver ----------------------------------------------------------
+// Process wide cache of the resolved host names. The asynchronous lookups are
+// done by QHostInfo, the result is delivered in the main thread and
+// HostNameResolved() is emitted when it is stored in the cache.
+class CHostNameResolver : public QObject
+{
+    Q_OBJECT
+
+public:
+    static CHostNameResolver& Instance();
+
+    // returns false if the host name is not in the cache or the entry is
+    // expired (an empty address list is a failed lookup)
+    bool GetCachedAddresses ( const QString&       strHostName,
+                              QList<QHostAddress>& Addresses );
+
+    void StoreAddresses ( const QString&             strHostName,
+                          const QList<QHostAddress>& Addresses );
+
+    // nothing is done if a lookup of this host name is already pending
+    void LookupAsync ( const QString& strHostName );
+
+protected:
+    CHostNameResolver();
+
+    struct SCacheEntry
+    {
+        QList<QHostAddress> Addresses;
+        qint64              iExpiryTimeMs;
+    };
+
+    QMutex                      Mutex;
+    QElapsedTimer               CacheTimer;
+    QHash<QString, SCacheEntry> Cache;
+    QSet<QString>               PendingNames;
+
+protected slots:
+    void OnLookupFinished ( QHostInfo HostInfo );
+
+signals:
+    void HostNameResolved ( QString strHostName );
+};
+
+
 // Network utility functions ---------------------------------------------------
+enum ENetwAddrStat
+{
+    NA_OK,
+    NA_PENDING, // the host name is looked up asynchronously
+    NA_INVALID
+};
+
 class NetworkUtil
 {
 public:
+    // a host name is resolved to the first address of the system order (which
+    // prefers IPv6 if it is available), optionally an IPv4 address is preferred
+    // (the resolved host names are cached, the lookup of a host name which is
+    // not in the cache blocks the calling thread)
     static bool ParseNetworkAddress ( QString       strAddress,
-                                      CHostAddress& HostAddress );
+                                      CHostAddress& HostAddress,
+                                      const bool    bPreferIPv4 = false )
+        { return ParseNetworkAddressIntern ( strAddress, HostAddress, bPreferIPv4, true ) == NA_OK; }
+
+    // never blocks: a host name which is not in the cache is looked up
+    // asynchronously and NA_PENDING is returned, the caller tries again if
+    // CHostNameResolver::HostNameResolved() is emitted
+    static ENetwAddrStat ParseNetworkAddressNonBlocking ( QString       strAddress,
+                                                          CHostAddress& HostAddress,
+                                                          const bool    bPreferIPv4 = false )
+        { return ParseNetworkAddressIntern ( strAddress, HostAddress, bPreferIPv4, false ); }
 
     static CHostAddress GetLocalAddress();
     static QString      GetCentralServerAddress ( const ECSAddType eCentralServerAddressType,
                                                   const QString&   strCentralServerAddress );
+
+protected:
+    static ENetwAddrStat ParseNetworkAddressIntern ( QString       strAddress,
+                                                     CHostAddress& HostAddress,
+                                                     const bool    bPreferIPv4,
+                                                     const bool    bBlocking );
 };
 
 
@@ -1125,55 +1623,102 @@ public:
                 const double       rT60 = 1.1 );
 
     void Clear();
-    void Process ( CVector<int16_t>& vecsStereoInOut,
-                   const bool        bReverbOnLeftChan,
-                   const double      dAttenuation );
+    void Process ( CVector<float>& vecfStereoInOut,
+                   const bool      bReverbOnLeftChan,
+                   const double    dAttenuation );
 
 protected:
     void setT60 ( const double rT60, const int iSampleRate );
     bool isPrime ( const int number );
 
-    class COnePole
+    // Delay line which is processed block-wise. The blocks must not be longer
+    // than the delay line, the delayed samples of a block are then contiguous
+    // (up to one wrap around) and do not depend on the samples of the block.
+    class CDelayLine
     {
     public:
-        COnePole() : dA ( 0 ), dB ( 0 ) { Reset(); }
-        void setPole ( const double dPole );
-        double Calc ( const double dIn );
-        void Reset() { dLastSample = 0; }
+        CDelayLine() : iPos ( 0 ) {}
+        void Init ( const int iNewSize ) { vecfMemory.Init ( iNewSize ); Reset(); }
+        void Reset() { vecfMemory.Reset ( 0 ); iPos = 0; }
+        int  Size() const { return vecfMemory.Size(); }
+
+        // allpass filter in place
+        void Allpass ( float*      pfInOut,
+                       const int   iNumSamples,
+                       const float fCoeff );
+
+        // feedback comb filter with lowpass, the output is added on pfSum
+        void CombFilter ( const float* pfIn,
+                          float*       pfSum,
+                          const int    iNumSamples,
+                          const float  fFeedback,
+                          const float  fPole,
+                          float&       fState );
+
+        // plain delay, the new sample is added before the delayed one is taken
+        // (i.e. the delay is one sample shorter than the delay line)
+        void Delay ( const float* pfIn,
+                     float*       pfOut,
+                     const int    iNumSamples );
 
     protected:
-        double dA;
-        double dB;
-        double dLastSample;
+        CVector<float> vecfMemory;
+        int            iPos;
     };
 
-    EAudChanConf  eAudioChannelConf;
-    int           iStereoBlockSizeSam;
-    CFIFO<double> allpassDelays[3];
-    CFIFO<double> combDelays[4];
-    COnePole      combFilters[4];
-    CFIFO<double> outLeftDelay;
-    CFIFO<double> outRightDelay;
-    double        allpassCoefficient;
-    double        combCoefficient[4];
+    EAudChanConf   eAudioChannelConf;
+    int            iStereoBlockSizeSam;
+    CDelayLine     allpassDelays[3];
+    CDelayLine     combDelays[4];
+    CDelayLine     outLeftDelay;
+    CDelayLine     outRightDelay;
+    float          allpassCoefficient;
+    float          combFeedback[4]; // comb coefficient times the lowpass gain
+    float          combPole;
+    float          combState[4];    // lowpass filter states
+
+    // block-wise processing buffers
+    CVector<float> vecfBlock;
+    CVector<float> vecfCombSum;
+    CVector<float> vecfOutLeft;
+    CVector<float> vecfOutRight;
 };
 
 
 // CRC -------------------------------------------------------------------------
+// 16 bit CRC with the generator polynomial x^16 + x^12 + x^5 + 1 (CCITT) which
+// is calculated byte-wise with a precomputed table (the result is identical to
+// the bit-wise shift register implementation which was used before)
 class CCRC
 {
 public:
-    CCRC() : iPoly ( ( 1 << 5 ) | ( 1 << 12 ) ), iBitOutMask ( 1 << 16 )
-        { Reset(); }
+    CCRC() { Reset(); }
 
     void Reset();
-    void AddByte ( const uint8_t byNewInput );
+
+    void AddByte ( const uint8_t byNewInput )
+    {
+        // the upper byte of the shift register and the new byte select the
+        // table entry which contains the register update of the eight shifts
+        iStateShiftReg = ( ( iStateShiftReg << 8 ) ^
+            vecCRCTable[( ( iStateShiftReg >> 8 ) ^ byNewInput ) & 0xFF] ) & 0xFFFF;
+    }
+
+    void AddBytes ( const uint8_t* pbyNewInput,
+                    const int      iNumBytes )
+    {
+        for ( int i = 0; i < iNumBytes; i++ )
+        {
+            AddByte ( pbyNewInput[i] );
+        }
+    }
+
     bool CheckCRC ( const uint32_t iCRC ) { return iCRC == GetCRC(); }
     uint32_t GetCRC();
 
 protected:
-    uint32_t iPoly;
-    uint32_t iBitOutMask;
+    static const uint16_t vecCRCTable[256];
+
     uint32_t iStateShiftReg;
 };
 
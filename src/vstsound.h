@@ -1,62 +1,144 @@
-/******************************************************************************\
- * Copyright (c) 2004-2019
- *
- * Author(s):
- *  Volker Fischer
- *
- ******************************************************************************
- *
- * This program is free software; you can redistribute it and/or modify it under
- * the terms of the GNU General Public License as published by the Free Software
- * Foundation; either version 2 of the License, or (at your option) any later
- * version.
- *
- * This program is distributed in the hope that it will be useful, but WITHOUT
- * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
- * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
- * details.
- *
- * You should have received a copy of the GNU General Public License along with
- * this program; if not, write to the Free Software Foundation, Inc.,
- * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
- *
-\******************************************************************************/
-
-#if !defined ( _VSTSOUND_H__9518A346345768_11D3_8C0D_EEBF182CF549__INCLUDED_ )
-#define _VSTSOUND_H__9518A346345768_11D3_8C0D_EEBF182CF549__INCLUDED_
-
-#include "../src/util.h"
-#include "../src/global.h"
-#include "../src/soundbase.h"
-
-
-/* Classes ********************************************************************/
-class CSound : public CSoundBase
-{
-public:
-    CSound ( void (*fpNewCallback) ( CVector<int16_t>& psData, void* arg ), void* arg ) :
-        CSoundBase ( true, fpNewCallback, arg ), iVSTMonoBufferSize ( 0 ) {}
-
-    // special VST functions
-    void SetMonoBufferSize ( const int iNVBS ) { iVSTMonoBufferSize = iNVBS; }
-    void VSTProcessCallback()
-    {
-        CSoundBase::ProcessCallback ( vecsTmpAudioSndCrdStereo );
-    }
-
-    virtual int Init ( const int )
-    {
-        // init base class
-        CSoundBase::Init ( iVSTMonoBufferSize );
-        vecsTmpAudioSndCrdStereo.Init ( 2 * iVSTMonoBufferSize /* stereo */);
-        return iVSTMonoBufferSize;
-    }
-
-    // this vector must be accessible from the outside (quick hack solution)
-    CVector<int16_t> vecsTmpAudioSndCrdStereo;
-
-protected:
-    int iVSTMonoBufferSize;
-};
-
-#endif // !defined ( _VSTSOUND_H__9518A346345768_11D3_8C0D_EEBF182CF549__INCLUDED_ )
+/******************************************************************************\
+ * Copyright (c) 2004-2019
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#if !defined ( _VSTSOUND_H__9518A346345768_11D3_8C0D_EEBF182CF549__INCLUDED_ )
+#define _VSTSOUND_H__9518A346345768_11D3_8C0D_EEBF182CF549__INCLUDED_
+
+#include "../src/util.h"
+#include "../src/global.h"
+#include "../src/buffer.h"
+#include "../src/soundbase.h"
+
+
+/* Classes ********************************************************************/
+// The VST host calls processReplacing() with planar float buffers of at most
+// the block size given on resume (some hosts use smaller blocks, e.g. at the
+// loop end). The client processes fixed size blocks, therefore the host
+// buffers are adapted by sample FIFOs. All buffers are allocated in Init() so
+// that nothing is allocated and no lock is taken in the host callback.
+class CSound : public CSoundBase
+{
+public:
+    CSound ( void           (*fpNewProcessCallback) ( CVector<short>& psData, void* pParg ),
+             void*          pParg,
+             const int      iCtrlMIDIChannel,
+             const bool     ,
+             const QString& ) :
+        CSoundBase ( "VST", true, fpNewProcessCallback, pParg, iCtrlMIDIChannel ),
+        iVSTMonoBufferSize ( 0 ), bOutputPrimed ( false ) {}
+
+    // special VST functions
+    void SetMonoBufferSize ( const int iNVBS ) { iVSTMonoBufferSize = iNVBS; }
+
+    void VSTProcessCallback ( float**   ppfIn,
+                              float**   ppfOut,
+                              const int iNumFrames )
+    {
+        const int iNumSamples = 2 * iNumFrames;
+
+        if ( !IsRunning() || ( iNumFrames > iVSTMonoBufferSize ) )
+        {
+            std::fill ( ppfOut[0], ppfOut[0] + iNumFrames, 0.0f );
+            std::fill ( ppfOut[1], ppfOut[1] + iNumFrames, 0.0f );
+            return;
+        }
+
+        CSndSampleConv::InterleaveFloatStereo ( ppfIn[0], ppfIn[1], &vecfTmpAudioHostStereo[0], iNumFrames );
+        InputFifo.Put ( &vecfTmpAudioHostStereo[0], iNumSamples );
+
+        // process all complete blocks of the input
+        while ( InputFifo.Get ( &vecfTmpAudioSndCrdStereo[0], 2 * iVSTMonoBufferSize ) )
+        {
+            if ( HasProcessCallbackFloat() )
+            {
+                ProcessCallbackFloat ( vecfTmpAudioSndCrdStereo );
+            }
+            else
+            {
+                CSndSampleConv::ToShort ( SF_FLOAT32, false,
+                                          &vecfTmpAudioSndCrdStereo[0], 1,
+                                          &vecsTmpAudioSndCrdStereo[0], 1,
+                                          2 * iVSTMonoBufferSize );
+
+                ProcessCallback ( vecsTmpAudioSndCrdStereo );
+
+                CSndSampleConv::FromShort ( SF_FLOAT32, false,
+                                            &vecsTmpAudioSndCrdStereo[0], 1,
+                                            &vecfTmpAudioSndCrdStereo[0], 1,
+                                            2 * iVSTMonoBufferSize );
+            }
+
+            OutputFifo.Put ( &vecfTmpAudioSndCrdStereo[0], 2 * iVSTMonoBufferSize );
+        }
+
+        // if the host uses smaller blocks than the block size, the output is
+        // delayed by one block of silence on the first underrun (if the host
+        // always uses the full block size, no additional delay is introduced)
+        if ( OutputFifo.GetAvailData() < iNumSamples )
+        {
+            if ( !bOutputPrimed )
+            {
+                bOutputPrimed = true;
+                vecfTmpAudioHostStereo.Reset ( 0 );
+                OutputFifo.Put ( &vecfTmpAudioHostStereo[0], 2 * iVSTMonoBufferSize - OutputFifo.GetAvailData() );
+            }
+        }
+
+        const int iNumAvail = std::min ( OutputFifo.GetAvailData(), iNumSamples );
+
+        OutputFifo.Get ( &vecfTmpAudioHostStereo[0], iNumAvail );
+        std::fill ( vecfTmpAudioHostStereo.begin() + iNumAvail, vecfTmpAudioHostStereo.begin() + iNumSamples, 0.0f );
+
+        CSndSampleConv::DeinterleaveFloatStereo ( &vecfTmpAudioHostStereo[0], ppfOut[0], ppfOut[1], iNumFrames );
+    }
+
+    virtual int Init ( const int )
+    {
+        // init base class
+        CSoundBase::Init ( iVSTMonoBufferSize );
+
+        vecfTmpAudioHostStereo.Init   ( 2 * iVSTMonoBufferSize /* stereo */ );
+        vecfTmpAudioSndCrdStereo.Init ( 2 * iVSTMonoBufferSize /* stereo */ );
+        vecsTmpAudioSndCrdStereo.Init ( 2 * iVSTMonoBufferSize /* stereo */ );
+
+        // the input FIFO holds less than a block plus one host buffer, the
+        // output FIFO additionally the silence block
+        InputFifo.Init  ( 2 * 2 * iVSTMonoBufferSize );
+        OutputFifo.Init ( 3 * 2 * iVSTMonoBufferSize );
+        bOutputPrimed = false;
+
+        return iVSTMonoBufferSize;
+    }
+
+protected:
+    int                    iVSTMonoBufferSize;
+    bool                   bOutputPrimed;
+    CVector<float>         vecfTmpAudioHostStereo;
+    CVector<float>         vecfTmpAudioSndCrdStereo;
+    CVector<int16_t>       vecsTmpAudioSndCrdStereo;
+    CSampleFifoSPSC<float> InputFifo;
+    CSampleFifoSPSC<float> OutputFifo;
+};
+
+#endif // !defined ( _VSTSOUND_H__9518A346345768_11D3_8C0D_EEBF182CF549__INCLUDED_ )
@@ -24,7 +24,9 @@
 
 #pragma once
 
-#include <QMutex>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QThread>
 #include <QMessageBox>
 #include "../src/util.h"
 #include "../src/global.h"
@@ -41,6 +43,15 @@
 // stereo for input and output
 #define NUM_IN_OUT_CHANNELS         2
 
+// maximum time we wait for a running ASIO callback to finish on a driver
+// reset or stop
+#define ASIO_CALLBACK_QUIESCENCE_TIMEOUT_MS 5000
+
+// the selected channels are packed in one atomic integer (8 bits per channel
+// index, MAX_NUM_IN_OUT_CHANNELS fits in it) so that the ASIO callback gets a
+// consistent snapshot of the channel mapping
+#define ASIO_SEL_CH_NUM_BITS        8
+
 
 /* Classes ********************************************************************/
 class CSound : public CSoundBase
@@ -84,8 +95,14 @@ protected:
     int              GetActualBufferSize ( const int iDesiredBufferSizeMono );
     QString          CheckDeviceCapabilities();
     bool             CheckSampleTypeSupported ( const ASIOSampleType SamType );
+    static bool      GetSampleFormat ( const ASIOSampleType SamType,
+                                       ESndSampleFormat&    eFormat,
+                                       bool&                bSwapBytes );
     bool             CheckSampleTypeSupportedForCHMixing ( const ASIOSampleType SamType );
     void             ResetChannelMapping();
+    void             PublishChannelMapping();
+    bool             DisableCallback();
+    void             EnableCallback() { bCallbackEnabled.storeRelease ( 1 ); }
 
     int              iASIOBufferSizeMono;
     int              iASIOBufferSizeStereo;
@@ -99,12 +116,12 @@ protected:
 
     CVector<int16_t> vecsMultChanAudioSndCrd;
 
-    QMutex           ASIOMutex;
-
-    // utility functions
-    static int16_t   Flip16Bits ( const int16_t iIn );
-    static int32_t   Flip32Bits ( const int32_t iIn );
-    static int64_t   Flip64Bits ( const int64_t iIn );
+    // the ASIO callback never takes a lock: it reads the channel mapping
+    // snapshot and registers itself in the active callback counter, driver
+    // resets disable the callback processing and wait for quiescence
+    QAtomicInt       iSelChannelsSnapshot;
+    QAtomicInt       bCallbackEnabled;
+    QAtomicInt       iNumActiveCallbacks;
 
     // audio hardware buffer info
     struct sHWBufferInfo